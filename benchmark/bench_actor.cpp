@@ -6,14 +6,18 @@
 //
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
+#include "td/actor/MultiTimeout.h"
 #include "td/actor/PromiseFuture.h"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/Heap.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/TimerWheel.h"
 
 #if TD_MSVC
 #pragma comment(linker, "/STACK:16777216")
@@ -324,9 +328,170 @@ class QueryBench final : public td::Benchmark {
   td::ActorOwn<ServerActor> server_;
 };
 
-int main() {
+template <bool use_timer_wheel>
+class TimerQueueBench final : public td::Benchmark {
+  static constexpr int TIMER_COUNT = 1000000;
+
+  struct Node final
+      : public td::HeapNode
+      , public td::TimerWheelNode {};
+
+  td::vector<Node> nodes_;
+  td::KHeap<double> heap_;
+  td::TimerWheel wheel_;
+  double now_ = 0.0;
+
+  double random_timeout() {
+    return now_ + td::Random::fast(1, 100000) * 1e-3;
+  }
+
+  bool in_queue(Node *node) const {
+    return use_timer_wheel ? static_cast<td::TimerWheelNode *>(node)->in_timer_wheel()
+                           : static_cast<td::HeapNode *>(node)->in_heap();
+  }
+
+  void set_timeout(Node *node, double timeout) {
+    if (use_timer_wheel) {
+      if (in_queue(node)) {
+        wheel_.fix(timeout, node);
+      } else {
+        wheel_.insert(timeout, node);
+      }
+    } else {
+      if (in_queue(node)) {
+        heap_.fix(timeout, node);
+      } else {
+        heap_.insert(timeout, node);
+      }
+    }
+  }
+
+  void cancel_timeout(Node *node) {
+    if (in_queue(node)) {
+      if (use_timer_wheel) {
+        wheel_.erase(node);
+      } else {
+        heap_.erase(node);
+      }
+    }
+  }
+
+  int run_timeouts() {
+    int result = 0;
+    if (use_timer_wheel) {
+      wheel_.advance(now_);
+      while (wheel_.pop_expired() != nullptr) {
+        result++;
+      }
+    } else {
+      while (!heap_.empty() && heap_.top_key() < now_) {
+        heap_.pop();
+        result++;
+      }
+    }
+    return result;
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << (use_timer_wheel ? "TimerWheel" : "KHeap") << " with 1000000 timers";
+  }
+
+  void start_up() final {
+    nodes_ = td::vector<Node>(TIMER_COUNT);
+    for (auto &node : nodes_) {
+      set_timeout(&node, random_timeout());
+    }
+  }
+
+  void tear_down() final {
+    for (auto &node : nodes_) {
+      cancel_timeout(&node);
+    }
+    nodes_.clear();
+  }
+
+  void run(int n) final {
+    int expired_count = 0;
+    for (int i = 0; i < n; i++) {
+      auto &node = nodes_[td::Random::fast(0, TIMER_COUNT - 1)];
+      if ((i & 7) == 0) {
+        cancel_timeout(&node);
+      } else {
+        set_timeout(&node, random_timeout());
+      }
+      if ((i & 1023) == 0) {
+        now_ += 1e-3;
+        expired_count += run_timeouts();
+      }
+    }
+    td::do_not_optimize_away(expired_count);
+  }
+};
+
+class MultiTimeoutBench final : public td::Benchmark {
+  static constexpr int KEY_COUNT = 1000000;
+
+  class TimeoutActor final : public td::Actor {
+   public:
+    explicit TimeoutActor(int n) : n_(n) {
+    }
+
+   private:
+    int n_;
+    td::MultiTimeout timeout_{"MultiTimeoutBench"};
+
+    void start_up() final {
+      timeout_.set_callback([](void *, td::int64) {});
+      for (int i = 0; i < n_; i++) {
+        timeout_.set_timeout_in(i % KEY_COUNT + 1, td::Random::fast(1, 100000) * 1e-3);
+      }
+      for (int i = 0; i < n_; i++) {
+        timeout_.cancel_timeout(i % KEY_COUNT + 1);
+      }
+      stop();
+    }
+
+    void tear_down() final {
+      td::Scheduler::instance()->finish();
+    }
+  };
+
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(0, 0);
+    scheduler_->start();
+  }
+
+  void tear_down() final {
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+
+ public:
+  td::string get_description() const final {
+    return "MultiTimeout with 1000000 keys";
+  }
+
+  void run(int n) final {
+    scheduler_->create_actor_unsafe<TimeoutActor>(0, "TimeoutActor", n).release();
+    while (scheduler_->run_main(10)) {
+      // empty
+    }
+  }
+};
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   td::init_openssl_threads();
 
+  bench(TimerQueueBench<false>());
+  bench(TimerQueueBench<true>());
+  bench(MultiTimeoutBench());
   bench(CreateActorBench());
   bench(RingBench<4>(504, 0));
   bench(RingBench<3>(504, 0));
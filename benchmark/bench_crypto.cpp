@@ -17,6 +17,10 @@
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 
+#if TD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 #include <algorithm>
 #include <array>
 #include <atomic>
@@ -92,6 +96,33 @@ class SHA256ShortBench final : public td::Benchmark {
   }
 };
 
+template <bool reuse_state>
+class SHA256StateShortBench final : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[SHORT_DATA_SIZE];
+
+  std::string get_description() const final {
+    return PSTRING() << "SHA256 state " << (reuse_state ? "reused" : "new   ") << " [" << SHORT_DATA_SIZE << "B]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+  }
+
+  void run(int n) final {
+    unsigned char md[32];
+    td::Sha256State reused_state;
+    for (int i = 0; i < n; i++) {
+      td::Sha256State new_state;
+      auto &state = reuse_state ? reused_state : new_state;
+      state.init();
+      state.feed(td::Slice(data, 32));
+      state.feed(td::Slice(data + 32, SHORT_DATA_SIZE - 32));
+      state.extract(td::MutableSlice(md, 32));
+    }
+  }
+};
+
 class SHA512ShortBench final : public td::Benchmark {
  public:
   alignas(64) unsigned char data[SHORT_DATA_SIZE];
@@ -439,6 +470,25 @@ BENCH(SslRandBuf, "ssl_rand_bytes") {
   td::do_not_optimize_away(res);
 }
 
+BENCH(SecureInt64, "secure_int64") {
+  td::int64 res = 0;
+  for (int i = 0; i < n; i++) {
+    res ^= td::Random::secure_int64();
+  }
+  td::do_not_optimize_away(res);
+}
+
+BENCH(SecurePadding, "secure_bytes [16-31B]") {
+  // the size of random padding of an MTProto packet
+  unsigned char buf[32];
+  td::uint32 res = 0;
+  for (int i = 0; i < n; i++) {
+    td::Random::secure_bytes(buf, 16 + (i & 15));
+    res ^= buf[0];
+  }
+  td::do_not_optimize_away(res);
+}
+
 BENCH(Pbkdf2, "pbkdf2") {
   std::string password = "cucumber";
   std::string salt = "abcdefghijklmnopqrstuvw";
@@ -451,7 +501,7 @@ class Crc32Bench final : public td::Benchmark {
   alignas(64) unsigned char data[DATA_SIZE];
 
   std::string get_description() const final {
-    return PSTRING() << "CRC32 zlib [" << (DATA_SIZE >> 10) << "KB]";
+    return PSTRING() << "CRC32 [" << (DATA_SIZE >> 10) << "KB]";
   }
 
   void start_up() final {
@@ -467,6 +517,52 @@ class Crc32Bench final : public td::Benchmark {
   }
 };
 
+#if TD_HAVE_ZLIB
+class Crc32ZlibBench final : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[DATA_SIZE];
+
+  std::string get_description() const final {
+    return PSTRING() << "CRC32 zlib [" << (DATA_SIZE >> 10) << "KB]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+  }
+
+  void run(int n) final {
+    td::uint64 res = 0;
+    for (int i = 0; i < n; i++) {
+      res += ::crc32(0, data, DATA_SIZE);
+    }
+    td::do_not_optimize_away(res);
+  }
+};
+#endif
+
+#if TD_HAVE_CRC32C
+class Crc32cBench final : public td::Benchmark {
+ public:
+  alignas(64) unsigned char data[DATA_SIZE];
+
+  std::string get_description() const final {
+    return PSTRING() << "CRC32C [" << (DATA_SIZE >> 10) << "KB]";
+  }
+
+  void start_up() final {
+    std::fill(std::begin(data), std::end(data), static_cast<unsigned char>(123));
+  }
+
+  void run(int n) final {
+    td::uint64 res = 0;
+    for (int i = 0; i < n; i++) {
+      res += td::crc32c(td::Slice(data, DATA_SIZE));
+    }
+    td::do_not_optimize_away(res);
+  }
+};
+#endif
+
 class Crc64Bench final : public td::Benchmark {
  public:
   alignas(64) unsigned char data[DATA_SIZE];
@@ -488,7 +584,10 @@ class Crc64Bench final : public td::Benchmark {
   }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   td::init_openssl_threads();
   td::bench(AesCtrBench());
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
@@ -512,14 +611,24 @@ int main() {
   td::bench(SslRandBench());
 #endif
   td::bench(SslRandBufBench());
+  td::bench(SecureInt64Bench());
+  td::bench(SecurePaddingBench());
 #if OPENSSL_VERSION_NUMBER <= 0x10100000L
   td::bench(SHA1Bench());
 #endif
   td::bench(SHA1ShortBench());
   td::bench(SHA256ShortBench());
+  td::bench(SHA256StateShortBench<false>());
+  td::bench(SHA256StateShortBench<true>());
   td::bench(SHA512ShortBench());
   td::bench(HmacSha256ShortBench());
   td::bench(HmacSha512ShortBench());
   td::bench(Crc32Bench());
+#if TD_HAVE_ZLIB
+  td::bench(Crc32ZlibBench());
+#endif
+#if TD_HAVE_CRC32C
+  td::bench(Crc32cBench());
+#endif
   td::bench(Crc64Bench());
 }
@@ -230,8 +230,11 @@ class BinlogKeyValueBench final : public td::Benchmark {
   }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   bench(TdKvBench<td::BinlogKeyValue<td::Binlog>>("BinlogKeyValue<Binlog>"));
   bench(TdKvBench<td::BinlogKeyValue<td::ConcurrentBinlog>>("BinlogKeyValue<ConcurrentBinlog>"));
 
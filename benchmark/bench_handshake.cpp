@@ -4,15 +4,28 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/mtproto/AuthKey.h"
+#include "td/mtproto/CryptoWorkerPool.h"
 #include "td/mtproto/DhCallback.h"
 #include "td/mtproto/DhHandshake.h"
+#include "td/mtproto/KDF.h"
+#include "td/mtproto/PacketInfo.h"
+#include "td/mtproto/Transport.h"
 
+#include "td/utils/as.h"
 #include "td/utils/base64.h"
 #include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/crypto.h"
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/UInt.h"
 
 #include <map>
+#include <utility>
 
 #if TD_LINUX || TD_ANDROID || TD_TIZEN
 #include <semaphore.h>
@@ -67,6 +80,78 @@ class HandshakeBench final : public td::Benchmark {
   }
 };
 
-int main() {
+class DecryptBench final : public td::Benchmark {
+  static constexpr size_t PACKET_COUNT = 8;
+  static constexpr size_t PACKET_SIZE = 1 << 19;
+
+  td::int32 thread_count_;
+  td::mtproto::AuthKey auth_key_;
+  td::vector<td::BufferSlice> packets_;
+
+ public:
+  explicit DecryptBench(td::int32 thread_count) : thread_count_(thread_count) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Decrypt " << PACKET_COUNT << " packets of " << (PACKET_SIZE >> 10) << " KB using "
+                     << thread_count_ << " additional threads";
+  }
+
+  void start_up() final {
+    td::mtproto::CryptoWorkerPool::set_thread_count(thread_count_);
+    td::string auth_key(256, '\0');
+    td::Random::secure_bytes(auth_key);
+    auth_key_ = td::mtproto::AuthKey(td::Random::secure_uint64(), std::move(auth_key));
+
+    // packets are encrypted as if they were sent by the server
+    for (size_t i = 0; i < PACKET_COUNT; i++) {
+      constexpr size_t HEADER_SIZE = 24;
+      constexpr size_t PREFIX_SIZE = 32;
+      constexpr size_t PADDING_SIZE = 16;
+      td::BufferSlice packet(HEADER_SIZE + PREFIX_SIZE + PACKET_SIZE + PADDING_SIZE);
+      auto data = packet.as_mutable_slice();
+      td::Random::secure_bytes(data);
+      td::as<td::uint64>(data.begin()) = auth_key_.id();
+      td::as<td::uint32>(data.begin() + HEADER_SIZE + PREFIX_SIZE - 4) = static_cast<td::uint32>(PACKET_SIZE);
+
+      auto to_encrypt = data.substr(HEADER_SIZE);
+      auto message_key = td::mtproto::Transport::calc_message_key2(auth_key_, 8, to_encrypt).second;
+      data.substr(8).copy_from(td::as_slice(message_key));
+      td::UInt256 aes_key;
+      td::UInt256 aes_iv;
+      td::mtproto::KDF2(auth_key_.key(), message_key, 8, &aes_key, &aes_iv);
+      td::aes_ige_encrypt(td::as_slice(aes_key), td::as_mutable_slice(aes_iv), to_encrypt, to_encrypt);
+      packets_.push_back(std::move(packet));
+    }
+  }
+
+  void tear_down() final {
+    packets_.clear();
+    td::mtproto::CryptoWorkerPool::set_thread_count(0);
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      td::vector<td::BufferSlice> packets;
+      for (auto &packet : packets_) {
+        packets.push_back(packet.copy());
+      }
+      td::mtproto::CryptoWorkerPool::run(packets.size(), [&](size_t j) {
+        td::mtproto::PacketInfo packet_info;
+        packet_info.version = 2;
+        auto r_read_result = td::mtproto::Transport::read(packets[j].as_mutable_slice(), auth_key_, &packet_info);
+        LOG_CHECK(r_read_result.is_ok()) << r_read_result.error();
+        CHECK(r_read_result.ok().packet().size() >= PACKET_SIZE);
+      });
+    }
+  }
+};
+
+int main(int argc, char *argv[]) {
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   td::bench(HandshakeBench());
+  td::bench(DecryptBench(0));
+  td::bench(DecryptBench(3));
 }
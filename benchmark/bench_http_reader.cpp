@@ -13,7 +13,19 @@
 #include "td/utils/find_boundary.h"
 #include "td/utils/logging.h"
 
-static std::string http_query = "GET / HTTP/1.1\r\nConnection:keep-alive\r\nhost:127.0.0.1:8080\r\n\r\n";
+static std::string http_query =
+    "GET /bot123456:AAHdqTcvCH1vGWJxfSeofSAs0K5PALDsaw/getUpdates?offset=123456789&timeout=0 HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cache-Control: no-cache\r\n"
+    "X-Forwarded-For: 203.0.113.195, 70.41.3.18, 150.172.238.178\r\n"
+    "X-Real-IP: 203.0.113.195\r\n"
+    "Cookie: session=8f14e45fceea167a5a36dedd4bea2543; theme=dark; lang=en\r\n"
+    "\r\n";
 static const size_t block_size = 2500;
 
 class HttpReaderBench final : public td::Benchmark {
@@ -111,9 +123,43 @@ class FindBoundaryBench final : public td::Benchmark {
   }
 };
 
-int main() {
+class FindHttpHeadersEndBench final : public td::Benchmark {
+  std::string get_description() const final {
+    return "FindHttpHeadersEndBench";
+  }
+
+  void run(int n) final {
+    auto cnt = static_cast<int>(block_size / http_query.size());
+    for (int i = 0; i < n; i += cnt) {
+      for (int j = 0; j < cnt; j++) {
+        writer_.append(http_query);
+      }
+      reader_.sync_with_writer();
+      for (int j = 0; j < cnt; j++) {
+        size_t len = 0;
+        find_http_headers_end(reader_.clone(), len);
+        CHECK(size_t(len) + 4 == http_query.size());
+        auto result = reader_.cut_head(len + 2);
+        reader_.advance(2);
+      }
+    }
+  }
+  td::ChainBufferWriter writer_;
+  td::ChainBufferReader reader_;
+
+  void start_up() final {
+    writer_ = {};
+    reader_ = writer_.extract_reader();
+  }
+};
+
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   td::bench(BufferBench());
   td::bench(FindBoundaryBench());
+  td::bench(FindHttpHeadersEndBench());
   td::bench(HttpReaderBench());
 }
@@ -15,15 +15,21 @@
 #include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/Poll.h"
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
 
 static int cnt = 0;
+static std::atomic<td::uint64> query_count{0};
 
 class HelloWorld final : public td::HttpInboundConnection::Callback {
  public:
   void handle(td::unique_ptr<td::HttpQuery> query, td::ActorOwn<td::HttpInboundConnection> connection) final {
     // LOG(ERROR) << *query;
+    query_count++;
     td::HttpHeaderCreator hc;
     td::Slice content = "hello world";
     //auto content = td::BufferSlice("hello world");
@@ -72,13 +78,28 @@ class Server final : public td::TcpListener::Callback {
   int pos_{0};
 };
 
-int main() {
+// run with --io-uring to use io_uring instead of epoll; the number of system calls can be compared with "strace -c -f"
+int main(int argc, char **argv) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  for (int i = 1; i < argc; i++) {
+    if (td::Slice(argv[i]) == "--io-uring") {
+#if TD_POLL_IO_URING
+      td::detail::IoUringOrEpoll::set_use_io_uring(true);
+#else
+      LOG(ERROR) << "io_uring isn't supported";
+#endif
+    }
+  }
+
   auto scheduler = td::make_unique<td::ConcurrentScheduler>(N, 0);
   scheduler->create_actor_unsafe<Server>(0, "Server").release();
   scheduler->start();
+  auto next_report_time = td::Timestamp::in(10.0);
   while (scheduler->run_main(10)) {
-    // empty
+    if (next_report_time.is_in_past()) {
+      LOG(ERROR) << "Handled " << query_count.exchange(0) / 10 << " queries per second";
+      next_report_time = td::Timestamp::in(10.0);
+    }
   }
   scheduler->finish();
 }
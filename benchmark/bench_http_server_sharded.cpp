@@ -0,0 +1,99 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/net/HttpHeaderCreator.h"
+#include "td/net/HttpInboundConnection.h"
+#include "td/net/HttpQuery.h"
+#include "td/net/TcpListener.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedFd.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/SocketFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+
+static std::atomic<td::uint64> connection_count{0};
+static std::atomic<td::uint64> query_count{0};
+
+class HelloWorld final : public td::HttpInboundConnection::Callback {
+ public:
+  void handle(td::unique_ptr<td::HttpQuery> query, td::ActorOwn<td::HttpInboundConnection> connection) final {
+    query_count++;
+    td::HttpHeaderCreator hc;
+    td::Slice content = "hello world";
+    hc.init_ok();
+    hc.set_keep_alive();
+    hc.set_content_size(content.size());
+    hc.add_header("Server", "TDLib/test");
+    hc.add_header("Date", "Thu Dec 14 01:41:50 2017");
+    hc.add_header("Content-Type:", "text/html");
+
+    auto res = hc.finish(content);
+    LOG_IF(FATAL, res.is_error()) << res.error();
+    send_closure(connection, &td::HttpInboundConnection::write_next, td::BufferSlice(res.ok()));
+    send_closure(connection.release(), &td::HttpInboundConnection::write_ok);
+  }
+  void hangup() final {
+    stop();
+  }
+};
+
+// handles connections accepted on its scheduler on the same scheduler
+class Server final : public td::TcpListener::Callback {
+ public:
+  void accept(td::SocketFd fd) final {
+    connection_count++;
+    td::create_actor<td::HttpInboundConnection>("HttpInboundConnection", td::BufferedFd<td::SocketFd>(std::move(fd)),
+                                                1024 * 1024, 0, 0, td::create_actor<HelloWorld>("HelloWorld"))
+        .release();
+  }
+  void hangup() final {
+    stop();
+  }
+};
+
+// run with --threads=<N> to accept and handle connections on N threads
+int main(int argc, char **argv) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  int thread_count = 1;
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (td::begins_with(arg, "--threads=")) {
+      thread_count = td::max(td::to_integer<int>(arg.substr(10)), 1);
+    }
+  }
+
+  td::vector<td::int32> scheduler_ids;
+  for (int i = 0; i < thread_count; i++) {
+    scheduler_ids.push_back(i);
+  }
+  auto create_server = [](td::int32 scheduler_id) {
+    return td::ActorOwn<td::TcpListener::Callback>(td::create_actor_on_scheduler<Server>("Server", scheduler_id));
+  };
+  auto scheduler = td::make_unique<td::ConcurrentScheduler>(thread_count - 1, 0);
+  scheduler
+      ->create_actor_unsafe<td::ShardedTcpListener>(0, "ShardedTcpListener", 8082, std::move(scheduler_ids),
+                                                    std::move(create_server))
+      .release();
+  scheduler->start();
+  auto next_report_time = td::Timestamp::in(10.0);
+  while (scheduler->run_main(10)) {
+    if (next_report_time.is_in_past()) {
+      LOG(ERROR) << "Accepted " << connection_count.exchange(0) / 10 << " connections and handled "
+                 << query_count.exchange(0) / 10 << " queries per second on " << thread_count << " threads";
+      next_report_time = td::Timestamp::in(10.0);
+    }
+  }
+  scheduler->finish();
+}
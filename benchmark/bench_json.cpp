@@ -0,0 +1,107 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_api.h"
+#include "td/telegram/td_api_json.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/common.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+
+static td::string get_send_message_request(int entity_count) {
+  td::string text;
+  td::string entities;
+  for (int i = 0; i < entity_count; i++) {
+    text += "Some \\\"formatted\\\" text, \\u0442\\u0435\\u043a\\u0441\\u0442. ";
+    if (i != 0) {
+      entities += ',';
+    }
+    entities += PSTRING() << "{\"@type\":\"textEntity\",\"offset\":" << i * 30 << ",\"length\":10,\"type\":{\"@type\":\""
+                          << (i % 2 == 0 ? "textEntityTypeBold" : "textEntityTypeItalic") << "\"}}";
+  }
+  return PSTRING() << "{\"@type\":\"sendMessage\",\"chat_id\":123456789012,\"message_thread_id\":0,"
+                      "\"input_message_content\":{\"@type\":\"inputMessageText\",\"text\":{\"@type\":\"formattedText\","
+                      "\"text\":\""
+                   << text << "\",\"entities\":[" << entities
+                   << "]},\"clear_draft\":true},\"@extra\":{\"request\":12345}}";
+}
+
+static td::string get_set_option_request() {
+  return "{\"@type\":\"setOption\",\"name\":\"online\",\"value\":{\"@type\":\"optionValueBoolean\",\"value\":true},"
+         "\"@extra\":\"abacaba\"}";
+}
+
+static td::Status parse_through_json_value(td::MutableSlice json, td::td_api::object_ptr<td::td_api::Function> &func,
+                                           td::string &extra) {
+  TRY_RESULT(json_value, td::json_decode(json));
+  if (json_value.get_object().has_field("@extra")) {
+    extra = td::json_encode<td::string>(json_value.get_object().extract_field("@extra"));
+  }
+  return from_json(func, std::move(json_value));
+}
+
+template <bool use_json_value>
+class JsonRequestBench final : public td::Benchmark {
+ public:
+  JsonRequestBench(td::string name, td::string request) : name_(std::move(name)), request_(std::move(request)) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Parse " << name_ << (use_json_value ? " through JsonValue" : " directly");
+  }
+
+  void start_up() final {
+    // both methods must return the same result
+    td::td_api::object_ptr<td::td_api::Function> func;
+    td::string extra;
+    auto json = request_;
+    parse_through_json_value(json, func, extra).ensure();
+    td::td_api::object_ptr<td::td_api::Function> direct_func;
+    td::string direct_extra;
+    json = request_;
+    td::td_api::from_json(direct_func, json, &direct_extra).ensure();
+    CHECK(to_string(func) == to_string(direct_func));
+    CHECK(extra == direct_extra);
+  }
+
+  void run(int n) final {
+    size_t result = 0;
+    for (int i = 0; i < n; i++) {
+      auto json = request_;
+      td::td_api::object_ptr<td::td_api::Function> func;
+      td::string extra;
+      if (use_json_value) {
+        parse_through_json_value(json, func, extra).ensure();
+      } else {
+        td::td_api::from_json(func, json, &extra).ensure();
+      }
+      result += extra.size() + static_cast<size_t>(func->get_id());
+    }
+    td::do_not_optimize_away(result);
+  }
+
+ private:
+  td::string name_;
+  td::string request_;
+};
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
+
+  td::bench(JsonRequestBench<true>("setOption", get_set_option_request()));
+  td::bench(JsonRequestBench<false>("setOption", get_set_option_request()));
+  td::bench(JsonRequestBench<true>("sendMessage", get_send_message_request(10)));
+  td::bench(JsonRequestBench<false>("sendMessage", get_send_message_request(10)));
+  td::bench(JsonRequestBench<true>("big sendMessage", get_send_message_request(1000)));
+  td::bench(JsonRequestBench<false>("big sendMessage", get_send_message_request(1000)));
+}
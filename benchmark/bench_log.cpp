@@ -150,7 +150,10 @@ class LogWriteBench final : public td::Benchmark {
   }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   td::bench(LogWriteBench());
 #if TD_ANDROID
   td::bench(ALogWriteBench());
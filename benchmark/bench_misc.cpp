@@ -4,6 +4,12 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/telegram/LinkManager.h"
+#include "td/telegram/MessageEntity.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/misc.h"
+#include "td/telegram/OrderedMessage.h"
+#include "td/telegram/ServerMessageId.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/telegram_api.hpp"
@@ -11,6 +17,10 @@
 #include "td/utils/algorithm.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
+#include "td/utils/Gzip.h"
+#include "td/utils/Hints.h"
+#include "td/utils/HttpUrl.h"
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/EventFd.h"
@@ -26,6 +36,7 @@
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/utf8.h"
 
 #if !TD_WINDOWS
 #include <unistd.h>
@@ -126,6 +137,170 @@ BENCH(TlToStringMessage, "TL to_string message") {
   td::do_not_optimize_away(res);
 }
 
+static td::string get_message_text(bool is_ascii) {
+  td::string result;
+  while (result.size() < 4000) {
+    result += is_ascii ? "Hello, this is a rather long message to check how fast JSON strings are built. "
+                       : "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, this is a message with "
+                         "\xd1\x81\xd0\xbb\xd0\xbe\xd0\xb2\xd0\xb0 in Cyrillic. ";
+    result += "It has \"quotes\" and\tcontrol characters\n";
+  }
+  return result;
+}
+
+template <bool is_raw>
+class JsonStringBench final : public td::Benchmark {
+ public:
+  explicit JsonStringBench(bool is_ascii) : is_ascii_(is_ascii) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << (is_raw ? "JsonRawString" : "JsonString") << (is_ascii_ ? " ASCII" : " UTF-8");
+  }
+
+  void start_up() final {
+    text_ = get_message_text(is_ascii_);
+  }
+
+  void run(int n) final {
+    auto buf = td::StackAllocator::alloc(1 << 16);
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      td::StringBuilder sb(buf.as_slice());
+      if (is_raw) {
+        sb << td::JsonRawString(text_);
+      } else {
+        sb << td::JsonString(text_);
+      }
+      res += sb.as_cslice().size();
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  bool is_ascii_;
+  td::string text_;
+};
+
+#if TD_HAVE_ZLIB
+template <bool is_encode>
+class GzipBench final : public td::Benchmark {
+ public:
+  explicit GzipBench(std::size_t size) : size_(size) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << (is_encode ? "gzencode " : "gzdecode ") << size_;
+  }
+
+  void start_up() final {
+    text_ = get_message_text(true);
+    while (text_.size() < size_) {
+      text_ += text_;
+    }
+    text_.resize(size_);
+    encoded_ = td::gzencode(text_, 1.0).as_slice().str();
+    CHECK(!encoded_.empty());
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      if (is_encode) {
+        res += td::gzencode(text_, 1.0).size();
+      } else {
+        res += td::gzdecode(encoded_).size();
+      }
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  std::size_t size_;
+  td::string text_;
+  td::string encoded_;
+};
+#endif
+
+class CheckUtf8Bench final : public td::Benchmark {
+ public:
+  explicit CheckUtf8Bench(bool is_ascii) : is_ascii_(is_ascii) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "check_utf8 and utf8_length" << (is_ascii_ ? " ASCII" : " UTF-8");
+  }
+
+  void start_up() final {
+    text_ = get_message_text(is_ascii_);
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      res += td::check_utf8(text_) + td::utf8_length(text_);
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  bool is_ascii_;
+  td::string text_;
+};
+
+class Utf8Utf16LengthBench final : public td::Benchmark {
+ public:
+  explicit Utf8Utf16LengthBench(bool is_ascii) : is_ascii_(is_ascii) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "utf8_utf16_length and utf8_truncate" << (is_ascii_ ? " ASCII" : " UTF-8");
+  }
+
+  void start_up() final {
+    text_ = get_message_text(is_ascii_);
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      res += td::utf8_utf16_length(text_) + td::utf8_truncate(td::Slice(text_), 3000).size();
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  bool is_ascii_;
+  td::string text_;
+};
+
+class CleanInputStringBench final : public td::Benchmark {
+ public:
+  explicit CleanInputStringBench(bool is_ascii) : is_ascii_(is_ascii) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "clean_input_string" << (is_ascii_ ? " ASCII" : " UTF-8");
+  }
+
+  void start_up() final {
+    text_ = get_message_text(is_ascii_);
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    for (int i = 0; i < n; i++) {
+      auto text = text_;
+      res += td::clean_input_string(text) + text.size();
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  bool is_ascii_;
+  td::string text_;
+};
+
 #if !TD_EVENTFD_UNSUPPORTED
 BENCH(EventFd, "EventFd") {
   td::EventFd fd;
@@ -752,8 +927,285 @@ BENCH(AnyOfTd, "any_of td") {
   td::do_not_optimize_away(res);
 }
 
-int main() {
+static td::MessageId get_bench_message_id(int server_message_id) {
+  return td::MessageId(td::ServerMessageId(server_message_id));
+}
+
+template <bool is_backward>
+class OrderedMessagesInsertBench final : public td::Benchmark {
+  int old_verbosity_level_ = 0;
+
+  td::string get_description() const final {
+    return PSTRING() << "OrderedMessages insert " << (is_backward ? "backward" : "forward");
+  }
+
+  void start_up() final {
+    // don't log attachment of each message
+    old_verbosity_level_ = GET_VERBOSITY_LEVEL();
+    SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  }
+
+  void tear_down() final {
+    SET_VERBOSITY_LEVEL(old_verbosity_level_);
+  }
+
+  void run(int n) final {
+    td::OrderedMessages ordered_messages;
+    for (int i = 1; i <= n; i++) {
+      if (is_backward) {
+        auto message_id = get_bench_message_id(n + 1 - i);
+        ordered_messages.insert(message_id, false, td::MessageId(), "bench");
+        if (i > 1) {
+          ordered_messages.attach_message_to_next(message_id, "bench");
+        }
+      } else {
+        ordered_messages.insert(get_bench_message_id(i), true, get_bench_message_id(i - 1), "bench");
+      }
+    }
+    td::do_not_optimize_away(ordered_messages.empty());
+  }
+};
+
+class OrderedMessagesTraverseBench final : public td::Benchmark {
+  static constexpr int MESSAGE_COUNT = 1000000;
+
+  td::OrderedMessages ordered_messages_;
+  int old_verbosity_level_ = 0;
+
+  td::string get_description() const final {
+    return PSTRING() << "OrderedMessages traverse history of " << MESSAGE_COUNT << " messages";
+  }
+
+  void start_up() final {
+    old_verbosity_level_ = GET_VERBOSITY_LEVEL();
+    SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+    ordered_messages_ = td::OrderedMessages();
+    for (int i = 1; i <= MESSAGE_COUNT; i++) {
+      ordered_messages_.insert(get_bench_message_id(i), true, get_bench_message_id(i - 1), "bench");
+    }
+  }
+
+  void tear_down() final {
+    SET_VERBOSITY_LEVEL(old_verbosity_level_);
+  }
+
+  void run(int n) final {
+    td::int64 sum = 0;
+    auto it = ordered_messages_.get_const_iterator(td::MessageId::max());
+    for (int i = 0; i < n; i++) {
+      if (*it == nullptr) {
+        it = ordered_messages_.get_const_iterator(td::MessageId::max());
+      }
+      sum += (*it)->get_message_id().get();
+      --it;
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
+static td::string get_bench_hints_name() {
+  td::string result;
+  auto word_count = td::Random::fast(1, 3);
+  for (int i = 0; i < word_count; i++) {
+    if (i > 0) {
+      result += ' ';
+    }
+    auto length = td::Random::fast(3, 10);
+    for (int j = 0; j < length; j++) {
+      result += static_cast<char>('a' + td::Random::fast(0, 25));
+    }
+  }
+  return result;
+}
+
+class HintsAddBench final : public td::Benchmark {
+  td::vector<td::string> names_;
+
+  td::string get_description() const final {
+    return "Hints add";
+  }
+
+  void start_up() final {
+    for (int i = 0; i < 100000; i++) {
+      names_.push_back(get_bench_hints_name());
+    }
+  }
+
+  void run(int n) final {
+    td::Hints hints;
+    for (int i = 0; i < n; i++) {
+      hints.add(i + 1, names_[i % names_.size()]);
+    }
+    td::do_not_optimize_away(hints.size());
+  }
+};
+
+class HintsSearchBench final : public td::Benchmark {
+  int old_verbosity_level_ = 0;
+  td::Hints hints_;
+  td::vector<td::string> queries_;
+
+  td::string get_description() const final {
+    return "Hints search";
+  }
+
+  void start_up() final {
+    // don't log each searched word
+    old_verbosity_level_ = GET_VERBOSITY_LEVEL();
+    SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+
+    for (int i = 1; i <= 100000; i++) {
+      hints_.add(i, get_bench_hints_name());
+      hints_.set_rating(i, td::Random::fast(0, 1000000));
+    }
+    for (int i = 0; i < 1000; i++) {
+      auto name = get_bench_hints_name();
+      queries_.push_back(name.substr(0, td::Random::fast(1, 3)));
+    }
+  }
+
+  void tear_down() final {
+    SET_VERBOSITY_LEVEL(old_verbosity_level_);
+  }
+
+  void run(int n) final {
+    size_t total_count = 0;
+    for (int i = 0; i < n; i++) {
+      total_count += hints_.search(queries_[i % queries_.size()], 10).first;
+    }
+    td::do_not_optimize_away(total_count);
+  }
+};
+
+template <bool has_entities>
+class FindEntitiesBench final : public td::Benchmark {
+  td::string text_;
+
+  td::string get_description() const final {
+    return PSTRING() << "find_entities in a long text " << (has_entities ? "with" : "without") << " entities";
+  }
+
+  void start_up() final {
+    for (int i = 0; i < 100; i++) {
+      text_ += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore ";
+      if (has_entities) {
+        text_ += "@mention #hashtag example.com ";
+      }
+    }
+  }
+
+  void run(int n) final {
+    size_t entity_count = 0;
+    for (int i = 0; i < n; i++) {
+      entity_count += td::find_entities(text_, false, false).size();
+    }
+    td::do_not_optimize_away(entity_count);
+  }
+};
+
+class GetLinkInfoBench final : public td::Benchmark {
+  td::vector<td::string> links_;
+
+  td::string get_description() const final {
+    return "check whether links are internal";
+  }
+
+  void start_up() final {
+    for (int i = 0; i < 100; i++) {
+      links_.push_back(PSTRING() << "https://t.me/username" << i << "?start=" << i);
+      links_.push_back(PSTRING() << "tg://resolve?domain=username" << i);
+      links_.push_back(PSTRING() << "HTTPS://WWW.Telegram.Me/joinchat/abcdef" << i);
+      links_.push_back(PSTRING() << "username" << i << ".t.me/path");
+      links_.push_back(PSTRING() << "https://telegra.ph/Article-" << i);
+      links_.push_back(PSTRING() << "https://example.com/page" << i << "?query=" << i);
+      links_.push_back(PSTRING() << "http://www.example.org:8080/some/path/" << i);
+    }
+  }
+
+  void run(int n) final {
+    size_t internal_link_count = 0;
+    for (int i = 0; i < n; i++) {
+      internal_link_count += td::LinkManager::is_internal_link(links_[i % links_.size()]);
+    }
+    td::do_not_optimize_away(internal_link_count);
+  }
+};
+
+template <bool is_url_parts>
+class ParseUrlBench final : public td::Benchmark {
+  td::string get_description() const final {
+    return is_url_parts ? "parse_url_parts" : "parse_url";
+  }
+
+  void run(int n) final {
+    size_t query_size = 0;
+    for (int i = 0; i < n; i++) {
+      td::Slice url = i % 2 == 0 ? td::Slice("HTTPS://Example.COM/some/path?query=value")
+                                 : td::Slice("https://t.me/username?start=parameter");
+      if (is_url_parts) {
+        query_size += td::parse_url_parts(url).ok().query_.size();
+      } else {
+        query_size += td::parse_url(url).ok().query_.size();
+      }
+    }
+    td::do_not_optimize_away(query_size);
+  }
+};
+
+template <bool is_static>
+class StatusErrorBench final : public td::Benchmark {
+  td::string get_description() const final {
+    return PSTRING() << "propagate " << (is_static ? "static" : "allocated") << " errors";
+  }
+
+  static td::Result<td::int32> get_value(int i) {
+    if (i % 16 != 0) {
+      if (is_static) {
+        static const td::Status error = td::Status::StaticError(500, "Request aborted");
+        return error.clone();
+      }
+      return td::Status::Error(500, "Request aborted");
+    }
+    return i;
+  }
+
+  static td::Result<td::int32> get_sum(int i) {
+    TRY_RESULT(value, get_value(i));
+    return value + 1;
+  }
+
+  void run(int n) final {
+    td::int64 result = 0;
+    for (int i = 0; i < n; i++) {
+      auto r_sum = get_sum(i);
+      result += r_sum.is_ok() ? r_sum.ok() : r_sum.error().code();
+    }
+    td::do_not_optimize_away(result);
+  }
+};
+
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(DEBUG));
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
+
+  td::bench(OrderedMessagesInsertBench<false>());
+  td::bench(OrderedMessagesInsertBench<true>());
+  td::bench(OrderedMessagesTraverseBench());
+
+  td::bench(HintsAddBench());
+  td::bench(HintsSearchBench());
+
+  td::bench(FindEntitiesBench<false>());
+  td::bench(FindEntitiesBench<true>());
+
+  td::bench(GetLinkInfoBench());
+  td::bench(ParseUrlBench<false>());
+  td::bench(ParseUrlBench<true>());
+
+  td::bench(StatusErrorBench<false>());
+  td::bench(StatusErrorBench<true>());
 
   td::bench(AnyOfStdBench());
   td::bench(AnyOfTdBench());
@@ -767,6 +1219,24 @@ int main() {
   td::bench(TlToStringUpdateFileBench());
   td::bench(TlToStringMessageBench());
 
+  td::bench(JsonStringBench<false>(true));
+  td::bench(JsonStringBench<false>(false));
+  td::bench(JsonStringBench<true>(true));
+  td::bench(JsonStringBench<true>(false));
+  td::bench(CheckUtf8Bench(true));
+  td::bench(CheckUtf8Bench(false));
+  td::bench(Utf8Utf16LengthBench(true));
+  td::bench(Utf8Utf16LengthBench(false));
+  td::bench(CleanInputStringBench(true));
+  td::bench(CleanInputStringBench(false));
+
+#if TD_HAVE_ZLIB
+  for (std::size_t size : {256, 4096, 65536}) {
+    td::bench(GzipBench<true>(size));
+    td::bench(GzipBench<false>(size));
+  }
+#endif
+
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<1000>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<300>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerArray<1000>>());
@@ -7,6 +7,7 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/MpscPollableLinkQueue.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/thread.h"
@@ -847,6 +848,59 @@ class RingBenchmark final : public td::Benchmark {
 };
 #endif
 
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+template <class QueueT>
+class MpscQueueBenchmark final : public td::Benchmark {
+  QueueT queue;
+  int producers_n;
+  td::string name;
+
+ public:
+  MpscQueueBenchmark(int producers_n, td::string name) : producers_n(producers_n), name(std::move(name)) {
+  }
+
+  td::string get_description() const final {
+    return name;
+  }
+
+  void start_up() final {
+    queue.init();
+  }
+
+  void tear_down() final {
+    queue.destroy();
+  }
+
+  void run(int n) final {
+    int queries_n = td::max(n / producers_n, 1);
+    td::vector<td::thread> producers;
+    for (int i = 0; i < producers_n; i++) {
+      producers.emplace_back([&] {
+        for (int j = 0; j < queries_n; j++) {
+          queue.writer_put(j);
+          queue.writer_flush();
+        }
+      });
+    }
+
+    int left = queries_n * producers_n;
+    while (left > 0) {
+      int cnt = queue.reader_wait();
+      CHECK(cnt != 0);
+      left -= cnt;
+      while (cnt-- > 0) {
+        td::do_not_optimize_away(queue.reader_get_unsafe());
+      }
+      queue.reader_flush();
+    }
+
+    for (auto &producer : producers) {
+      producer.join();
+    }
+  }
+};
+#endif
+
 /*
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
 static void test_queue() {
@@ -882,7 +936,10 @@ static void test_queue() {
 #endif
 */
 
-int main() {
+int main(int argc, char *argv[]) {
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   // test_queue();
 #endif
@@ -893,7 +950,16 @@ int main() {
 
 #define BENCH_Q2(Q, N) td::bench(QueueBenchmark2<Q<qvalue_t>>(N, #Q "(" #N ")"))
 
+#define BENCH_MPSC(Q, N) td::bench(MpscQueueBenchmark<Q<qvalue_t>>(N, #Q "(" #N " producers)"))
+
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  BENCH_MPSC(td::MpscPollableQueue, 1);
+  BENCH_MPSC(td::MpscPollableLinkQueue, 1);
+  BENCH_MPSC(td::MpscPollableQueue, 4);
+  BENCH_MPSC(td::MpscPollableLinkQueue, 4);
+  BENCH_MPSC(td::MpscPollableQueue, 16);
+  BENCH_MPSC(td::MpscPollableLinkQueue, 16);
+
   BENCH_Q2(td::InfBackoffQueue, 1);
   BENCH_Q2(td::MpscPollableQueue, 1);
   BENCH_Q2(td::PollQueue, 1);
@@ -0,0 +1,375 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/DialogDb.h"
+#include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileData.h"
+#include "td/telegram/files/FileData.hpp"
+#include "td/telegram/files/FileDb.h"
+#include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FileType.h"
+#include "td/telegram/FolderId.h"
+#include "td/telegram/MessageDb.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/NotificationId.h"
+#include "td/telegram/ServerMessageId.h"
+#include "td/telegram/td_json_client.h"
+#include "td/telegram/UserId.h"
+
+#include "td/db/binlog/Binlog.h"
+#include "td/db/BinlogKeyValue.h"
+#include "td/db/DbKey.h"
+#include "td/db/SqliteConnectionSafe.h"
+#include "td/db/SqliteDb.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/ConcurrentScheduler.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/OptionParser.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+// End-to-end benchmark of a synthetic account database and of the JSON client interface.
+// Each result is printed as a separate JSON object on its own line to simplify regression tracking.
+
+namespace {
+
+struct BenchOptions {
+  int dialog_count = 1000;
+  int message_count = 100;  // per chat
+  int file_count = 1000;
+  int request_count = 10000;
+  int api_id = 1;
+  td::string api_hash = "0123456789abcdef0123456789abcdef";
+  td::string directory = "bench_tdclient/";
+};
+
+void report(td::Slice metric, double value, td::Slice unit) {
+  auto result = td::json_encode<td::string>(td::json_object([&](auto &o) {
+    o("benchmark", "bench_tdclient");
+    o("metric", metric);
+    o("value", td::JsonFloat(value));
+    o("unit", unit);
+  }));
+  std::printf("%s\n", result.c_str());
+  std::fflush(stdout);
+}
+
+void report_memory(td::Slice metric) {
+  auto r_mem_stat = td::mem_stat();
+  if (r_mem_stat.is_ok()) {
+    report(metric, static_cast<double>(r_mem_stat.ok().resident_size_), "bytes");
+  }
+}
+
+class LatencyStats {
+ public:
+  void add(double duration) {
+    samples_.push_back(duration);
+  }
+
+  void report(td::Slice metric) {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    ::report(PSLICE() << metric << "_p50", get_percentile(50) * 1e6, "us");
+    ::report(PSLICE() << metric << "_p90", get_percentile(90) * 1e6, "us");
+    ::report(PSLICE() << metric << "_p99", get_percentile(99) * 1e6, "us");
+    ::report(PSLICE() << metric << "_max", samples_.back() * 1e6, "us");
+  }
+
+ private:
+  td::vector<double> samples_;
+
+  double get_percentile(size_t percent) const {
+    return samples_[(samples_.size() - 1) * percent / 100];
+  }
+};
+
+td::DialogId get_dialog_id(int id) {
+  return td::DialogId(td::UserId(static_cast<td::int64>(id)));
+}
+
+td::FullLocalFileLocation get_file_location(int id) {
+  return td::FullLocalFileLocation(td::FileType::Photo, PSTRING() << "photos/file_" << id << ".jpg",
+                                   static_cast<td::uint64>(id));
+}
+
+td::Status init_databases(td::SqliteDb &db, const td::string &binlog_path) {
+  TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
+  TRY_STATUS(db.exec("BEGIN TRANSACTION"));
+  td::BinlogKeyValue<td::Binlog> binlog_pmc;
+  TRY_STATUS(binlog_pmc.init(binlog_path));
+  SCOPE_EXIT {
+    binlog_pmc.close();
+    td::Binlog::destroy(binlog_path).ignore();
+  };
+  bool was_dialog_db_created = false;
+  TRY_STATUS(td::init_dialog_db(db, 0, binlog_pmc, was_dialog_db_created));
+  TRY_STATUS(td::init_message_db(db, 0));
+  TRY_STATUS(td::init_file_db(db, 0));
+  return db.exec("COMMIT TRANSACTION");
+}
+
+// creates a database with the given number of chats, messages in each chat and files
+void build_database(const BenchOptions &options, const td::string &db_path) {
+  td::SqliteDb::destroy(db_path).ignore();
+
+  auto scheduler = td::make_unique<td::ConcurrentScheduler>(0, 0);
+  scheduler->start();
+  auto start_time = td::Time::now();
+  bool is_file_db_closed = false;
+  {
+    auto guard = scheduler->get_main_guard();
+    auto sql_connection = std::make_shared<td::SqliteConnectionSafe>(db_path, td::DbKey::empty());
+    init_databases(sql_connection->get(), options.directory + "pmc.binlog").ensure();
+
+    auto dialog_db_sync_safe = td::create_dialog_db_sync(sql_connection);
+    auto &dialog_db = dialog_db_sync_safe->get();
+    dialog_db.begin_write_transaction().ensure();
+    for (int i = 1; i <= options.dialog_count; i++) {
+      dialog_db.add_dialog(get_dialog_id(i), td::FolderId::main(), static_cast<td::int64>(i) << 32,
+                           td::BufferSlice(td::Random::fast(200, 799)), {});
+    }
+    dialog_db.commit_transaction().ensure();
+
+    auto message_db_sync_safe = td::create_message_db_sync(sql_connection);
+    auto &message_db = message_db_sync_safe->get();
+    message_db.begin_write_transaction().ensure();
+    for (int i = 1; i <= options.dialog_count; i++) {
+      for (int j = 1; j <= options.message_count; j++) {
+        auto message_id = td::MessageId{td::ServerMessageId{j}};
+        message_db.add_message({get_dialog_id(i), message_id}, td::ServerMessageId(), td::DialogId(), 0, 0, 0, 0, "",
+                               td::NotificationId(), td::MessageId(), td::BufferSlice(td::Random::fast(100, 499)));
+      }
+    }
+    message_db.commit_transaction().ensure();
+
+    auto file_db = td::create_file_db(sql_connection);
+    for (int i = 1; i <= options.file_count; i++) {
+      td::FileData file_data;
+      file_data.local_ = td::LocalFileLocation(get_file_location(i));
+      file_data.size_ = td::Random::fast(1000, 1000000);
+      file_db->set_file_data(file_db->get_next_file_db_id(), file_data, false, true, false);
+    }
+    file_db->close(td::PromiseCreator::lambda([&is_file_db_closed](td::Unit) { is_file_db_closed = true; }));
+  }
+  while (!is_file_db_closed) {
+    scheduler->run_main(0.1);
+  }
+  scheduler->finish();
+  scheduler.reset();
+
+  report("database_build_time", td::Time::now() - start_time, "s");
+  auto r_stat = td::stat(db_path);
+  if (r_stat.is_ok()) {
+    report("database_size", static_cast<double>(r_stat.ok().size_), "bytes");
+  }
+}
+
+// measures latency of the database queries, which are used by loadChats, getChatHistory and file lookups
+void bench_database(const BenchOptions &options, const td::string &db_path) {
+  auto scheduler = td::make_unique<td::ConcurrentScheduler>(0, 0);
+  scheduler->start();
+  {
+    auto guard = scheduler->get_main_guard();
+    report_memory("database_resident_memory_before_load");
+    auto start_time = td::Time::now();
+    auto sql_connection = std::make_shared<td::SqliteConnectionSafe>(db_path, td::DbKey::empty());
+    auto dialog_db_sync_safe = td::create_dialog_db_sync(sql_connection);
+    auto message_db_sync_safe = td::create_message_db_sync(sql_connection);
+    auto file_db = td::create_file_db(sql_connection);
+    report("database_open_time", td::Time::now() - start_time, "s");
+
+    LatencyStats get_dialogs_stats;
+    auto order = std::numeric_limits<td::int64>::max();
+    td::DialogId dialog_id;
+    size_t loaded_dialog_count = 0;
+    start_time = td::Time::now();
+    while (true) {
+      auto query_start_time = td::Time::now();
+      auto result = dialog_db_sync_safe->get().get_dialogs(td::FolderId::main(), order, dialog_id, 100);
+      get_dialogs_stats.add(td::Time::now() - query_start_time);
+      loaded_dialog_count += result.dialogs.size();
+      if (result.dialogs.size() < 100u) {
+        break;
+      }
+      order = result.next_order;
+      dialog_id = result.next_dialog_id;
+    }
+    CHECK(loaded_dialog_count == static_cast<size_t>(options.dialog_count));
+    report("chat_list_load_time", td::Time::now() - start_time, "s");
+    get_dialogs_stats.report("get_chats_page_latency");
+
+    LatencyStats get_messages_stats;
+    for (int i = 0; i < options.request_count && options.message_count > 0; i++) {
+      td::MessageDbMessagesQuery query;
+      query.dialog_id = get_dialog_id(td::Random::fast(1, options.dialog_count));
+      query.from_message_id = td::MessageId{td::ServerMessageId{td::Random::fast(1, options.message_count)}};
+      query.offset = -10;
+      query.limit = 50;
+      auto query_start_time = td::Time::now();
+      auto messages = message_db_sync_safe->get().get_messages(std::move(query));
+      get_messages_stats.add(td::Time::now() - query_start_time);
+      CHECK(!messages.empty());
+    }
+    get_messages_stats.report("get_chat_history_latency");
+
+    LatencyStats get_file_stats;
+    for (int i = 0; i < options.request_count && options.file_count > 0; i++) {
+      auto location = get_file_location(td::Random::fast(1, options.file_count));
+      auto query_start_time = td::Time::now();
+      auto r_file_data = file_db->get_file_data_sync(location);
+      get_file_stats.add(td::Time::now() - query_start_time);
+      r_file_data.ensure();
+    }
+    get_file_stats.report("get_file_latency");
+
+    report_memory("database_resident_memory_after_load");
+
+    bool is_file_db_closed = false;
+    file_db->close(td::PromiseCreator::lambda([&is_file_db_closed](td::Unit) { is_file_db_closed = true; }));
+    while (!is_file_db_closed) {
+      scheduler->run_main(0.1);
+    }
+    dialog_db_sync_safe.reset();
+    message_db_sync_safe.reset();
+    sql_connection->close();
+  }
+  scheduler->finish();
+  scheduler.reset();
+}
+
+const char *receive_until(td::CSlice expected, double timeout) {
+  auto deadline = td::Time::now() + timeout;
+  while (td::Time::now() < deadline) {
+    const char *result = td_receive(deadline - td::Time::now());
+    if (result != nullptr && std::strstr(result, expected.c_str()) != nullptr) {
+      return result;
+    }
+  }
+  LOG(FATAL) << "Failed to receive " << expected;
+  return nullptr;
+}
+
+// measures client startup and round-trip time of requests, which are answered locally
+void bench_json_client(const BenchOptions &options) {
+  const double TIMEOUT = 60.0;
+  td_execute("{\"@type\":\"setLogVerbosityLevel\",\"new_verbosity_level\":0}");
+
+  auto start_time = td::Time::now();
+  auto client_id = td_create_client_id();
+  td_send(client_id, "{\"@type\":\"getOption\",\"name\":\"version\"}");
+  receive_until("\"authorizationStateWaitTdlibParameters\"", TIMEOUT);
+  report("client_start_time", td::Time::now() - start_time, "s");
+
+  auto database_directory = options.directory + "client";
+  td::rmrf(database_directory).ignore();
+  auto set_parameters = td::json_encode<td::string>(td::json_object([&](auto &o) {
+    o("@type", "setTdlibParameters");
+    o("use_test_dc", td::JsonTrue());
+    o("database_directory", database_directory);
+    o("use_file_database", td::JsonTrue());
+    o("use_chat_info_database", td::JsonTrue());
+    o("use_message_database", td::JsonTrue());
+    o("api_id", options.api_id);
+    o("api_hash", options.api_hash);
+    o("system_language_code", "en");
+    o("device_model", "bench_tdclient");
+    o("application_version", "1.0");
+  }));
+  start_time = td::Time::now();
+  td_send(client_id, set_parameters.c_str());
+  receive_until("\"authorizationStateWaitPhoneNumber\"", TIMEOUT);
+  report("client_time_to_ready", td::Time::now() - start_time, "s");
+  report_memory("client_resident_memory_after_start");
+
+  td::string request = "{\"@type\":\"testSquareInt\",\"x\":3}";
+  start_time = td::Time::now();
+  for (int i = 0; i < options.request_count; i++) {
+    td_send(client_id, request.c_str());
+  }
+  for (int i = 0; i < options.request_count; i++) {
+    receive_until("\"testInt\"", TIMEOUT);
+  }
+  auto duration = td::Time::now() - start_time;
+  report("json_client_throughput", options.request_count / duration, "requests/s");
+
+  LatencyStats round_trip_stats;
+  for (int i = 0; i < options.request_count / 10; i++) {
+    auto query_start_time = td::Time::now();
+    td_send(client_id, request.c_str());
+    receive_until("\"testInt\"", TIMEOUT);
+    round_trip_stats.add(td::Time::now() - query_start_time);
+  }
+  round_trip_stats.report("json_client_round_trip_latency");
+
+  td_send(client_id, "{\"@type\":\"close\"}");
+  receive_until("\"authorizationStateClosed\"", TIMEOUT);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+
+  BenchOptions options;
+  td::OptionParser option_parser;
+  option_parser.set_description("TDLib end-to-end benchmark");
+  option_parser.add_checked_option('d', "dialogs", "Number of chats in the synthetic database",
+                                   td::OptionParser::parse_integer(options.dialog_count));
+  option_parser.add_checked_option('m', "messages", "Number of messages in each chat",
+                                   td::OptionParser::parse_integer(options.message_count));
+  option_parser.add_checked_option('f', "files", "Number of files in the synthetic database",
+                                   td::OptionParser::parse_integer(options.file_count));
+  option_parser.add_checked_option('r', "requests", "Number of requests to measure",
+                                   td::OptionParser::parse_integer(options.request_count));
+  option_parser.add_checked_option('\0', "api-id", "Set Telegram API ID",
+                                   td::OptionParser::parse_integer(options.api_id));
+  option_parser.add_option('\0', "api-hash", "Set Telegram API hash",
+                           td::OptionParser::parse_string(options.api_hash));
+  option_parser.add_check([&] {
+    if (options.dialog_count <= 0 || options.message_count < 0 || options.file_count < 0 ||
+        options.request_count <= 0) {
+      return td::Status::Error("Invalid benchmark parameters");
+    }
+    return td::Status::OK();
+  });
+  auto r_non_options = option_parser.run(argc, argv, 0);
+  if (r_non_options.is_error()) {
+    LOG(PLAIN) << argv[0] << ": " << r_non_options.error().message();
+    LOG(PLAIN) << option_parser;
+    return 1;
+  }
+
+  td::mkdir(options.directory).ignore();
+  auto db_path = options.directory + "db.sqlite";
+  build_database(options, db_path);
+  bench_database(options, db_path);
+  td::SqliteDb::destroy(db_path).ignore();
+
+  bench_json_client(options);
+  td::rmrf(options.directory).ignore();
+  return 0;
+}
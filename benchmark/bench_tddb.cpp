@@ -21,11 +21,15 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/optional.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
 
 #include <memory>
+#include <utility>
 
 static td::Status init_db(td::SqliteDb &db) {
   TRY_STATUS(db.exec("PRAGMA encoding=\"UTF-8\""));
@@ -107,7 +111,115 @@ class MessageDbBench final : public td::Benchmark {
   }
 };
 
-int main() {
+// measures latency of MessageDb::get_messages with the given SQLite settings
+class MessageDbGetMessagesBench final : public td::Benchmark {
+ public:
+  MessageDbGetMessagesBench(td::string profile_name, td::SqliteDbSettings settings)
+      : profile_name_(std::move(profile_name)), settings_(std::move(settings)) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "MessageDb::get_messages " << profile_name_;
+  }
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(0, 0);
+    auto guard = scheduler_->get_main_guard();
+    td::SqliteDb::destroy(db_name_).ignore();
+    {
+      auto sql_connection = std::make_shared<td::SqliteConnectionSafe>(db_name_, td::DbKey::empty());
+      auto &db = sql_connection->get();
+      init_db(db).ensure();
+      db.exec("BEGIN TRANSACTION").ensure();
+      init_message_db(db, 0).ensure();
+      db.exec("COMMIT TRANSACTION").ensure();
+
+      auto message_db_sync_safe = td::create_message_db_sync(sql_connection);
+      auto &message_db = message_db_sync_safe->get();
+      message_db.begin_write_transaction().ensure();
+      for (int dialog_id = 1; dialog_id <= DIALOG_COUNT; dialog_id++) {
+        for (int i = 1; i <= MESSAGE_COUNT; i++) {
+          auto message_id = td::MessageId{td::ServerMessageId{i}};
+          message_db.add_message({get_dialog_id(dialog_id), message_id}, td::ServerMessageId(), td::DialogId(), 0, 0,
+                                 0, 0, "", td::NotificationId(), td::MessageId(),
+                                 td::BufferSlice(td::Random::fast(100, 499)));
+        }
+      }
+      message_db.commit_transaction().ensure();
+      message_db_sync_safe.reset();
+      sql_connection->close();
+    }
+
+    // reopen the database to start with an empty page cache
+    sql_connection_ =
+        std::make_shared<td::SqliteConnectionSafe>(db_name_, td::DbKey::empty(), td::optional<td::int32>(), settings_);
+    message_db_sync_safe_ = td::create_message_db_sync(sql_connection_);
+  }
+
+  void run(int n) final {
+    auto guard = scheduler_->get_main_guard();
+    auto &message_db = message_db_sync_safe_->get();
+    for (int i = 0; i < n; i++) {
+      td::MessageDbMessagesQuery query;
+      query.dialog_id = get_dialog_id(td::Random::fast(1, DIALOG_COUNT));
+      query.from_message_id = td::MessageId{td::ServerMessageId{td::Random::fast(1, MESSAGE_COUNT)}};
+      query.offset = -10;
+      query.limit = 50;
+      auto messages = message_db.get_messages(std::move(query));
+      CHECK(!messages.empty());
+    }
+  }
+
+  void tear_down() final {
+    {
+      auto guard = scheduler_->get_main_guard();
+      message_db_sync_safe_.reset();
+      sql_connection_->close_and_destroy();
+      sql_connection_.reset();
+    }
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+
+ private:
+  static constexpr int DIALOG_COUNT = 100;
+  static constexpr int MESSAGE_COUNT = 2000;
+
+  td::string profile_name_;
+  td::SqliteDbSettings settings_;
+  td::string db_name_ = "testdb.sqlite";
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  std::shared_ptr<td::SqliteConnectionSafe> sql_connection_;
+  std::shared_ptr<td::MessageDbSyncSafeInterface> message_db_sync_safe_;
+
+  static td::DialogId get_dialog_id(int id) {
+    return td::DialogId(td::UserId(static_cast<td::int64>(id)));
+  }
+};
+
+int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  if (!td::init_benchmarks(argc, argv)) {
+    return 1;
+  }
   td::bench(MessageDbBench());
+
+  td::SqliteDbSettings large_cache;
+  large_cache.cache_size_kb = 64 << 10;
+  large_cache.temp_store = "MEMORY";
+
+  td::SqliteDbSettings mmap;
+  mmap.mmap_size = static_cast<td::int64>(256) << 20;
+
+  td::SqliteDbSettings tuned;
+  tuned.cache_size_kb = 64 << 10;
+  tuned.mmap_size = static_cast<td::int64>(256) << 20;
+  tuned.synchronous = "NORMAL";
+  tuned.temp_store = "MEMORY";
+  tuned.wal_autocheckpoint = 10000;
+
+  td::bench(MessageDbGetMessagesBench("default", td::SqliteDbSettings()));
+  td::bench(MessageDbGetMessagesBench("large_cache", large_cache));
+  td::bench(MessageDbGetMessagesBench("mmap", mmap));
+  td::bench(MessageDbGetMessagesBench("tuned", tuned));
 }
@@ -11,6 +11,7 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashMapChunks.h"
+#include "td/utils/FlatHashMapSwiss.h"
 #include "td/utils/FlatHashTable.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
@@ -170,11 +171,12 @@ void print_memory_stats(td::Slice name) {
 template <class KeyT, class ValueT, class HashT = td::Hash<KeyT>, class EqT = std::equal_to<KeyT>>
 using FlatHashMapImpl = td::FlatHashTable<td::MapNode<KeyT, ValueT>, HashT, EqT>;
 
-#define FOR_EACH_TABLE(F) \
-  F(FlatHashMapImpl)      \
-  F(folly::F14FastMap)    \
-  F(absl::flat_hash_map)  \
-  F(std::unordered_map)   \
+#define FOR_EACH_TABLE(F)  \
+  F(FlatHashMapImpl)       \
+  F(td::FlatHashMapSwiss)  \
+  F(folly::F14FastMap)     \
+  F(absl::flat_hash_map)   \
+  F(std::unordered_map)    \
   F(std::map)
 #define BENCHMARK_MEMORY(T) print_memory_stats<T>(#T);
 
@@ -0,0 +1,80 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+package org.drinkless.tdlib.example;
+
+import org.drinkless.tdlib.Client;
+import org.drinkless.tdlib.TdApi;
+
+/**
+ * Measures speed of conversion of big TDLib objects between Java and native code.
+ */
+public final class Benchmark {
+    private static final int WARMUP_ITERATIONS = 100;
+    private static final int ITERATIONS = 1000;
+
+    private interface Query {
+        TdApi.Function<?> create();
+    }
+
+    private static String createText() {
+        StringBuilder text = new StringBuilder();
+        for (int i = 0; i < 500; i++) {
+            text.append("Mention @username").append(i).append(", visit https://example.com/page").append(i);
+            text.append(" and use #hashtag").append(i).append(" or /command").append(i).append(" ❤️\n");
+        }
+        return text.toString();
+    }
+
+    private static String createMarkdownText() {
+        StringBuilder text = new StringBuilder();
+        for (int i = 0; i < 500; i++) {
+            text.append("*bold ").append(i).append("* _italic_ `code` [link](https://example.com/").append(i).append(")\n");
+        }
+        return text.toString();
+    }
+
+    private static void run(String name, Query query) {
+        try {
+            for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+                Client.execute(query.create());
+            }
+            long start = System.nanoTime();
+            for (int i = 0; i < ITERATIONS; i++) {
+                Client.execute(query.create());
+            }
+            double seconds = (System.nanoTime() - start) / 1e9;
+            System.out.printf("%s: %.1f queries per second%n", name, ITERATIONS / seconds);
+        } catch (Client.ExecutionException e) {
+            System.err.println(name + " failed: " + e.error.message);
+        }
+    }
+
+    public static void main(String[] args) {
+        // disable TDLib logging
+        try {
+            Client.execute(new TdApi.SetLogVerbosityLevel(0));
+        } catch (Client.ExecutionException e) {
+            throw new RuntimeException("Can't set log verbosity level: " + e.error.message);
+        }
+
+        final String text = createText();
+        run("GetTextEntities", new Query() {
+            @Override
+            public TdApi.Function<?> create() {
+                return new TdApi.GetTextEntities(text);
+            }
+        });
+
+        final String markdownText = createMarkdownText();
+        run("ParseTextEntities", new Query() {
+            @Override
+            public TdApi.Function<?> create() {
+                return new TdApi.ParseTextEntities(markdownText, new TdApi.TextParseModeMarkdown(2));
+            }
+        });
+    }
+}
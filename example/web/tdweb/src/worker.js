@@ -830,6 +830,8 @@ class TdClient {
       query['@type'] === 'getLogVerbosityLevel' ||
       query['@type'] === 'setLogTagVerbosityLevel' ||
       query['@type'] === 'getLogTagVerbosityLevel' ||
+      query['@type'] === 'setLogTagRateLimit' ||
+      query['@type'] === 'getLogTagRateLimit' ||
       query['@type'] === 'getLogTags'
     ) {
       this.execute(query);
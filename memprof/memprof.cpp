@@ -9,6 +9,10 @@
 #include "td/utils/port/platform.h"
 
 #if (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF)
+#if USE_MEMPROF_TAGS
+#include "td/utils/AllocationTags.h"
+#endif
+
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
@@ -126,9 +130,48 @@ static constexpr std::int32_t MALLOC_INFO_MAGIC = 0x27138373;
 struct malloc_info {
   std::int32_t magic;
   std::int32_t size;
-  std::int32_t ht_pos;
+  std::int32_t ht_pos;  // -1 if the backtrace wasn't sampled
+  std::int32_t tag_id;
 };
 
+#if USE_MEMPROF_TAGS
+static constexpr std::uint32_t DEFAULT_BACKTRACE_SAMPLE_RATE = 1000;
+
+static struct AllocationTagsInitializer {
+  AllocationTagsInitializer() {
+    td::AllocationTags::set_backtrace_sample_rate(DEFAULT_BACKTRACE_SAMPLE_RATE);
+    td::AllocationTags::set_enabled(true);
+  }
+} allocation_tags_initializer;
+
+static std::int32_t get_current_tag_id() {
+  return td::AllocationTags::get_current_tag_id();
+}
+
+// backtraces are collected only for each sample_rate-th allocation in the thread
+static bool need_backtrace() {
+  static __thread std::uint32_t allocations_until_sample;  // static zero-initialized
+  auto sample_rate = td::AllocationTags::get_backtrace_sample_rate();
+  if (sample_rate == 0) {
+    return false;
+  }
+  if (allocations_until_sample > 0) {
+    allocations_until_sample--;
+    return false;
+  }
+  allocations_until_sample = sample_rate - 1;
+  return true;
+}
+#else
+static std::int32_t get_current_tag_id() {
+  return 0;
+}
+
+static bool need_backtrace() {
+  return true;
+}
+#endif
+
 static std::uint64_t get_hash(const Backtrace &bt) {
   std::uint64_t h = 7;
   for (std::size_t i = 0; i < bt.size() && i < BACKTRACE_HASHED_LENGTH; i++) {
@@ -140,6 +183,7 @@ static std::uint64_t get_hash(const Backtrace &bt) {
 struct HashtableNode {
   std::atomic<std::uint64_t> hash;
   Backtrace backtrace;
+  std::int32_t tag_id;
   std::atomic<std::size_t> size;
 };
 
@@ -151,8 +195,8 @@ std::size_t get_ht_size() {
   return ht_size.load();
 }
 
-std::int32_t get_ht_pos(const Backtrace &bt, bool force = false) {
-  auto hash = get_hash(bt);
+std::int32_t get_ht_pos(const Backtrace &bt, std::int32_t tag_id, bool force = false) {
+  auto hash = get_hash(bt) * 0x5bd1e995 + static_cast<std::uint32_t>(tag_id);
   auto pos = static_cast<std::int32_t>(hash % ht.size());
   bool was_overflow = false;
   while (true) {
@@ -164,13 +208,14 @@ std::int32_t get_ht_pos(const Backtrace &bt, bool force = false) {
         } else {
           Backtrace unknown_bt{{nullptr}};
           unknown_bt[0] = reinterpret_cast<void *>(1);
-          return get_ht_pos(unknown_bt, true);
+          return get_ht_pos(unknown_bt, 0, true);
         }
       }
 
       std::uint64_t expected = 0;
       if (ht[pos].hash.compare_exchange_strong(expected, hash)) {
         ht[pos].backtrace = bt;
+        ht[pos].tag_id = tag_id;
         ++ht_size;
         return pos;
       }
@@ -196,12 +241,22 @@ void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
     if (size == 0) {
       continue;
     }
-    func(AllocInfo{node.backtrace, size});
+    func(AllocInfo{node.backtrace, size, node.tag_id});
   }
 }
 
 void register_xalloc(malloc_info *info, std::int32_t diff) {
   my_assert(info->size >= 0);
+#if USE_MEMPROF_TAGS
+  if (diff > 0) {
+    td::AllocationTags::on_allocation(info->tag_id, info->size);
+  } else {
+    td::AllocationTags::on_deallocation(info->tag_id, info->size);
+  }
+#endif
+  if (info->ht_pos < 0) {
+    return;
+  }
   if (diff > 0) {
     ht[info->ht_pos].size.fetch_add(info->size, std::memory_order_relaxed);
   } else {
@@ -227,7 +282,12 @@ static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
 
   info->magic = MALLOC_INFO_MAGIC;
   info->size = static_cast<std::int32_t>(size);
-  info->ht_pos = get_ht_pos(frame);
+  info->tag_id = get_current_tag_id();
+#if USE_MEMPROF_TAGS
+  info->ht_pos = frame[0] == nullptr ? -1 : get_ht_pos(frame, info->tag_id);
+#else
+  info->ht_pos = get_ht_pos(frame, info->tag_id);
+#endif
 
   register_xalloc(info, +1);
 
@@ -246,7 +306,7 @@ static malloc_info *get_info(void *data_void) {
 }
 
 void *malloc(std::size_t size) {
-  return malloc_with_frame(size, get_backtrace());
+  return malloc_with_frame(size, need_backtrace() ? get_backtrace() : Backtrace{{nullptr}});
 }
 
 void free(void *data_void) {
@@ -268,17 +328,17 @@ void free(void *data_void) {
 
 void *calloc(std::size_t size_a, std::size_t size_b) {
   auto size = size_a * size_b;
-  void *res = malloc_with_frame(size, get_backtrace());
+  void *res = malloc_with_frame(size, need_backtrace() ? get_backtrace() : Backtrace{{nullptr}});
   std::memset(res, 0, size);
   return res;
 }
 
 void *realloc(void *ptr, std::size_t size) {
   if (ptr == nullptr) {
-    return malloc_with_frame(size, get_backtrace());
+    return malloc_with_frame(size, need_backtrace() ? get_backtrace() : Backtrace{{nullptr}});
   }
   auto *info = get_info(ptr);
-  auto *new_ptr = malloc_with_frame(size, get_backtrace());
+  auto *new_ptr = malloc_with_frame(size, need_backtrace() ? get_backtrace() : Backtrace{{nullptr}});
   auto to_copy = std::min(static_cast<std::int32_t>(size), info->size);
   std::memcpy(new_ptr, ptr, to_copy);
   free(ptr);
@@ -293,7 +353,7 @@ void *memalign(std::size_t aligment, std::size_t size) {
 
 // c++14 guarantees that it is enough to override these two operators.
 void *operator new(std::size_t count) {
-  return malloc_with_frame(count, get_backtrace());
+  return malloc_with_frame(count, need_backtrace() ? get_backtrace() : Backtrace{{nullptr}});
 }
 void operator delete(void *ptr) noexcept(true) {
   free(ptr);
@@ -8,6 +8,7 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 
 constexpr std::size_t BACKTRACE_SHIFT = 1;
@@ -18,6 +19,7 @@ using Backtrace = std::array<void *, BACKTRACE_LENGTH>;
 struct AllocInfo {
   Backtrace backtrace;
   std::size_t size;
+  std::int32_t tag_id;  // identifier of an allocation tag in MEMPROF=TAGS mode, or 0
 };
 
 bool is_memprof_on();
@@ -130,6 +130,7 @@ class DoxygenTlDocumentationGenerator extends TlDocumentationGenerator
             strpos($tline, 'result += ') === 0 || strpos($tline, 'result = ') || strpos($tline, ' : values') ||
             strpos($line, 'JNIEnv') || strpos($line, 'jfieldID') || $tline === 'virtual ~Object() {' ||
             $tline === 'virtual void store(TlStorerToString &s, const char *field_name) const = 0;' ||
+            $tline === 'virtual std::size_t approximate_memory_usage() const = 0;' ||
             $tline === 'const char *&get_package_name_ref();';
     }
 
@@ -330,6 +331,14 @@ EOT
    * \\param[in] field_name Object field_name if applicable.
    */
 EOT
+);
+
+        $this->addDocumentation('  std::size_t approximate_memory_usage() const final;', <<<EOT
+  /**
+   * Returns approximate size of the memory used by the object, including all its fields and owned subobjects.
+   * \\return Approximate size of the used memory, in bytes.
+   */
+EOT
 );
 
         $this->addDocumentation('class Object', <<<EOT
@@ -11,18 +11,66 @@
 #include "tl_writer_jni_h.h"
 
 #include "td/tl/tl_config.h"
+#include "td/tl/tl_core.h"
 #include "td/tl/tl_generate.h"
 
+#include <cassert>
 #include <string>
 #include <vector>
 
+// changes type of the given fields of constructors from the type old_type_name to a synthetic type new_type_name
+static void replace_field_types(td::tl::tl_config &config, const std::vector<std::string> &fields,
+                                const std::string &old_type_name, const std::string &new_type_name) {
+  td::tl::tl_type *new_type = nullptr;
+  for (auto &full_field_name : fields) {
+    auto dot_pos = full_field_name.rfind('.');
+    assert(dot_pos != std::string::npos);
+    auto constructor_name = full_field_name.substr(0, dot_pos);
+    auto field_name = full_field_name.substr(dot_pos + 1);
+
+    bool is_found = false;
+    for (std::size_t type_num = 0; type_num < config.get_type_count(); type_num++) {
+      td::tl::tl_type *t = config.get_type_by_num(type_num);
+      for (auto *constructor : t->constructors) {
+        if (constructor->name != constructor_name) {
+          continue;
+        }
+        for (auto &a : constructor->args) {
+          if (a.name != field_name) {
+            continue;
+          }
+          assert(a.type->get_type() == td::tl::NODE_TYPE_TYPE);
+          auto *tree_type = static_cast<td::tl::tl_tree_type *>(a.type);
+          assert(tree_type->type->name == old_type_name);
+          if (new_type == nullptr) {
+            new_type = new td::tl::tl_type(*tree_type->type);
+            new_type->name = new_type_name;
+          }
+          auto *new_tree_type =
+              new td::tl::tl_tree_type(tree_type->flags, new_type, static_cast<int>(tree_type->children.size()));
+          new_tree_type->children = tree_type->children;
+          a.type = new_tree_type;
+          is_found = true;
+        }
+      }
+    }
+    assert(is_found);
+  }
+}
+
 template <bool generate_multiple_headers = false, class WriterCpp = td::TD_TL_writer_cpp,
           class WriterH = td::TD_TL_writer_h, class WriterHpp = td::TD_TL_writer_hpp>
 static void generate_cpp(const std::string &directory, const std::string &tl_name, const std::string &string_type,
                          const std::string &bytes_type, const std::vector<std::string> &ext_cpp_includes,
-                         const std::vector<std::string> &ext_h_includes) {
+                         const std::vector<std::string> &ext_h_includes,
+                         const std::vector<std::string> &string_view_fields = {},
+                         const std::vector<std::string> &lazy_vector_fields = {}) {
   std::string path = directory + "/" + tl_name;
   td::tl::tl_config config = td::tl::read_tl_config_from_file("tlo/" + tl_name + ".tlo");
+  // string views are parsed without copying
+  replace_field_types(config, string_view_fields, "String", "StringView");
+  // lazy vectors keep serialized elements and parse them on access
+  replace_field_types(config, lazy_vector_fields, "Vector", "LazyVector");
   td::tl::write_tl_to_file(config, path + ".cpp", WriterCpp(tl_name, string_type, bytes_type, ext_cpp_includes));
   if (generate_multiple_headers) {
     td::tl::write_tl_to_multiple_files(config, path, ".h", WriterH(tl_name, string_type, bytes_type, ext_h_includes));
@@ -34,19 +82,27 @@ static void generate_cpp(const std::string &directory, const std::string &tl_nam
 
 int main() {
   generate_cpp<>("td/telegram", "telegram_api", "std::string", "BufferSlice",
-                 {"\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""}, {"\"td/utils/buffer.h\""});
+                 {"\"td/tl/tl_object_memory_usage.h\"", "\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""},
+                 {"\"td/tl/TlLazyVector.h\"", "\"td/utils/buffer.h\""},
+                 {"message.message", "updateShortChatMessage.message", "updateShortMessage.message"},
+                 {"updates.difference.new_messages", "updates.difference.users", "updates.differenceSlice.new_messages",
+                  "updates.differenceSlice.users"});
 
   generate_cpp<>("td/telegram", "secret_api", "std::string", "BufferSlice",
-                 {"\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""}, {"\"td/utils/buffer.h\""});
+                 {"\"td/tl/tl_object_memory_usage.h\"", "\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""},
+                 {"\"td/utils/buffer.h\""});
 
   generate_cpp<>("td/mtproto", "mtproto_api", "Slice", "Slice",
-                 {"\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""},
+                 {"\"td/tl/tl_object_memory_usage.h\"", "\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""},
                  {"\"td/utils/Slice.h\"", "\"td/utils/UInt.h\""});
 
 #ifdef TD_ENABLE_JNI
   generate_cpp<false, td::TD_TL_writer_jni_cpp, td::TD_TL_writer_jni_h>(
-      "td/telegram", "td_api", "std::string", "std::string", {"\"td/tl/tl_jni_object.h\""}, {"<string>"});
+      "td/telegram", "td_api", "std::string", "std::string",
+      {"\"td/tl/tl_jni_object.h\"", "\"td/tl/tl_object_memory_usage.h\""}, {"<string>"});
 #else
-  generate_cpp<>("td/telegram", "td_api", "std::string", "std::string", {}, {"<string>"});
+  generate_cpp<>("td/telegram", "td_api", "std::string", "std::string",
+                 {"\"td/tl/tl_object_memory_usage.h\"", "\"td/tl/tl_object_parse.h\"", "\"td/tl/tl_object_store.h\""},
+                 {"<string>"});
 #endif
 }
@@ -230,8 +230,9 @@ class TlWriterCCommon final : public tl::TL_writer {
              "#endif\n";
     }
     if (is_header_ == -1) {
-      return "#pragma once\n\n" + gen_import_declaration("td/telegram/td_tdc_api.h", false) +
-             gen_import_declaration("td/telegram/td_api.h", false) + "\n" + additional_imports;
+      return "#pragma once\n\n" + gen_import_declaration("td/telegram/td_api.h", false) +
+             gen_import_declaration("td/telegram/td_c_client_arena.h", false) +
+             gen_import_declaration("td/telegram/td_tdc_api.h", false) + "\n" + additional_imports;
     }
     return gen_import_declaration("td/telegram/td_tdc_api_inner.h", false) + "\n" +
            gen_import_declaration("td/utils/format.h", false) + gen_import_declaration("td/utils/logging.h", false) +
@@ -474,11 +475,12 @@ class TlWriterCCommon final : public tl::TL_writer {
       auto class_name = gen_class_name(t->name);
       auto native_class_name = gen_native_class_name(t->name);
       ss << "struct Td" << class_name << " *TdConvertFromInternal (const td::td_api::" << native_class_name
-         << " &from)";
+         << " &from, TdCArena *arena";
       if (is_header_ == -1) {
-        ss << ";\n";
+        ss << " = nullptr);\n";
         return ss.str();
       }
+      ss << ")";
       file_fetch_methods_from_td M(this);
       gen_object_fetch(ss, t, M);
       return ss.str();
@@ -752,6 +754,12 @@ class TlWriterCCommon final : public tl::TL_writer {
 
     virtual ~file_fetch_methods() = default;
 
+    virtual std::string new_object(const std::string &type_name) const {
+      return "new " + type_name + " ()";
+    }
+    virtual std::string new_array(const std::string &type_name, const std::string &size) const {
+      return "new " + type_name + " [" + size + "]";
+    }
     virtual std::string fetch_field_start(std::stringstream &ss, std::string offset, int depth,
                                           const tl::tl_tree_type *tree_type) const {
       assert(false);
@@ -790,6 +798,12 @@ class TlWriterCCommon final : public tl::TL_writer {
   struct file_fetch_methods_from_td final : public file_fetch_methods {
     explicit file_fetch_methods_from_td(const class TlWriterCCommon *cl) : cl(cl) {
     }
+    std::string new_object(const std::string &type_name) const final {
+      return "TdCArena::create_object<" + type_name + "> (arena)";
+    }
+    std::string new_array(const std::string &type_name, const std::string &size) const final {
+      return "TdCArena::create_array<" + type_name + "> (arena, " + size + ")";
+    }
     std::string fetch_field_start(std::stringstream &ss, std::string offset, int depth,
                                   const tl::tl_tree_type *tree_type) const final {
       return "";
@@ -797,15 +811,10 @@ class TlWriterCCommon final : public tl::TL_writer {
     void fetch_simple_type(std::stringstream &ss, std::string offset, std::string res_var, std::string var,
                            std::string type_name) const final {
       if (type_name == "String") {
-        ss << offset << res_var << " = (" << var << ".length ()) ? td::str_dup (" << var << ") : nullptr;\n";
+        ss << offset << res_var << " = TdCArena::dup_string (arena, " << var << ");\n";
       } else if (type_name == "Bytes") {
         ss << offset << res_var << ".len = (int)" << var << ".length ();\n";
-        ss << offset << "if (" << res_var << ".len) {\n";
-        ss << offset << "  " << res_var << ".data = new unsigned char[" << res_var << ".len];\n";
-        ss << offset << "  memcpy (" << res_var << ".data, " << var << ".c_str (), " << res_var << ".len);\n";
-        ss << offset << "} else {\n";
-        ss << offset << "  " << res_var << ".data = nullptr;\n";
-        ss << offset << "}\n";
+        ss << offset << res_var << ".data = TdCArena::dup_bytes (arena, " << var << ");\n";
       } else {
         ss << offset << res_var << " = " << var << ";\n";
       }
@@ -817,7 +826,7 @@ class TlWriterCCommon final : public tl::TL_writer {
          << offset << "  " << res_var << " = nullptr;\n"
          << offset << "} else {\n"
          << offset << "  " << res_var << " = TdConvertFromInternal (static_cast<const " << native_type_name << " &>(*"
-         << var << "));\n"
+         << var << "), arena);\n"
          << offset << "}\n";
     }
     void fetch_array_size(std::stringstream &ss, std::string offset, std::string res_var, std::string var,
@@ -940,9 +949,9 @@ class TlWriterCCommon final : public tl::TL_writer {
     } else {
       const tl::tl_tree_type *child = static_cast<const tl::tl_tree_type *>(tree_type->children[0]);
 
-      ss << offset << res_var << " = new Td" << gen_type_name(tree_type, true) << " ();\n";
+      ss << offset << res_var << " = " << M.new_object("Td" + gen_type_name(tree_type, true)) << ";\n";
       M.fetch_array_size(ss, offset, res_var + "->len", var, tree_type);
-      ss << offset << res_var << "->data = new " << gen_type_name(child) << " [" << res_var << "->len];\n";
+      ss << offset << res_var << "->data = " << M.new_array(gen_type_name(child), res_var + "->len") << ";\n";
 
       std::string it = "i" + int_to_string(depth);
       ss << offset << "for (int " << it << " = 0; " << it << " < " << res_var << "->len; " << it << "++) {\n";
@@ -955,7 +964,7 @@ class TlWriterCCommon final : public tl::TL_writer {
   void gen_object_fetch(std::stringstream &ss, const tl::tl_combinator *t, const file_fetch_methods &M) const {
     auto type_name = gen_class_name(t->name);
     ss << " {\n"
-       << "  auto res = new Td" << type_name << " ();\n"
+       << "  auto res = " << M.new_object("Td" + type_name) << ";\n"
        << "  res->ID = CODE_" << type_name << ";\n"
        << "  res->refcnt = 1;\n";
     int d = 0;
@@ -1158,11 +1167,12 @@ class TlWriterCCommon final : public tl::TL_writer {
     }
     if (function_name == "TdConvertFromInternal" && is_header_ != 1) {
       ss << "struct Td" << class_name << " *TdConvertFromInternal (const td::td_api::" << native_class_name
-         << " &from)";
+         << " &from, TdCArena *arena";
       if (is_header_ == -1) {
-        ss << ";\n";
+        ss << " = nullptr);\n";
         return ss.str();
       }
+      ss << ")";
     }
     if (function_name == "TdStackStorer") {
       if (is_header_ == 1) {
@@ -1245,7 +1255,7 @@ class TlWriterCCommon final : public tl::TL_writer {
       std::string native_class_name = class_name;
       native_class_name[0] = to_lower(native_class_name[0]);
       return "    case CODE_" + class_name + ": return (struct TdNullaryObject *)" + function_name +
-             "(static_cast<const td::td_api::" + native_class_name + " &>(from));\n";
+             "(static_cast<const td::td_api::" + native_class_name + " &>(from), arena);\n";
     } else if (function_name == "TdStackFetcher") {
       return "if (constructor == \"" + class_name +
              "\") {\n"
@@ -1289,7 +1299,7 @@ class TlWriterCCommon final : public tl::TL_writer {
         }
       }
       return "    case CODE_" + gen_class_name(t->name) + ": return (struct Td" + class_name + " *)" + function_name +
-             "(static_cast<const td::td_api::" + native_class_name + " &>(from));\n";
+             "(static_cast<const td::td_api::" + native_class_name + " &>(from), arena);\n";
     } else if (function_name == "enum") {
       const tl::tl_tree_type *tree_type = static_cast<const tl::tl_tree_type *>(t->result);
 
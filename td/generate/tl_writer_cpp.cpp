@@ -137,6 +137,16 @@ std::string TD_TL_writer_cpp::gen_constructor_id_store(std::int32_t id, int stor
   return "  " + gen_constructor_id_store_raw(int_to_string(id)) + "\n";
 }
 
+std::int32_t TD_TL_writer_cpp::get_object_constructor_id(const tl::tl_type *t) const {
+  for (std::size_t i = 0; i < t->constructors_num; i++) {
+    if (is_combinator_supported(t->constructors[i])) {
+      return t->constructors[i]->id;
+    }
+  }
+  assert(false);
+  return 0;
+}
+
 std::string TD_TL_writer_cpp::gen_fetch_class_name(const tl::tl_tree_type *tree_type) const {
   const tl::tl_type *t = tree_type->type;
   const std::string &name = t->name;
@@ -157,6 +167,9 @@ std::string TD_TL_writer_cpp::gen_fetch_class_name(const tl::tl_tree_type *tree_
   if (name == "Bytes") {
     return "TlFetchBytes<bytes>";
   }
+  if (name == "StringView") {
+    return "TlFetchStringView<bytes>";
+  }
 
   if (name == "Vector") {
     assert(t->arity == 1);
@@ -166,6 +179,14 @@ std::string TD_TL_writer_cpp::gen_fetch_class_name(const tl::tl_tree_type *tree_
 
     return "TlFetchVector<" + gen_full_fetch_class_name(child) + ">";
   }
+  if (name == "LazyVector") {
+    assert(t->arity == 1);
+    assert(tree_type->children.size() == 1);
+    assert(tree_type->children[0]->get_type() == tl::NODE_TYPE_TYPE);
+    const tl::tl_tree_type *child = static_cast<const tl::tl_tree_type *>(tree_type->children[0]);
+
+    return "TlFetchLazyVector<" + gen_full_fetch_class_name(child) + ">";
+  }
 
   assert(!is_built_in_simple_type(name) && !is_built_in_complex_type(name));
   for (std::size_t i = 0; i < tree_type->children.size(); i++) {
@@ -182,6 +203,15 @@ std::string TD_TL_writer_cpp::gen_full_fetch_class_name(const tl::tl_tree_type *
 
   assert(!(t->flags & tl::FLAG_DEFAULT_CONSTRUCTOR));  // Not supported yet
 
+  if (tl_name == "td_api" && !is_built_in_simple_type(name) && !is_built_in_complex_type(name)) {
+    // objects can be null, so they are always boxed
+    if (is_type_bare(t)) {
+      return "TlFetchNullable<TlFetchBoxed<" + gen_fetch_class_name(tree_type) + ", " +
+             int_to_string(get_object_constructor_id(t)) + ">>";
+    }
+    return "TlFetchNullable<" + gen_fetch_class_name(tree_type) + ">";
+  }
+
   std::int32_t expected_constructor_id = 0;
   if (tree_type->flags & tl::FLAG_BARE) {
     assert(is_type_bare(t));
@@ -348,7 +378,7 @@ std::string TD_TL_writer_cpp::gen_store_class_name(const tl::tl_tree_type *tree_
     assert(false);
     return "";
   }
-  if (name == "String" || name == "Bytes") {
+  if (name == "String" || name == "Bytes" || name == "StringView") {
     return "TlStoreString";
   }
 
@@ -360,6 +390,9 @@ std::string TD_TL_writer_cpp::gen_store_class_name(const tl::tl_tree_type *tree_
 
     return "TlStoreVector<" + gen_full_store_class_name(child) + ">";
   }
+  if (name == "LazyVector") {
+    return "TlStoreLazyVector";
+  }
 
   assert(!is_built_in_simple_type(name) && !is_built_in_complex_type(name));
   for (std::size_t i = 0; i < tree_type->children.size(); i++) {
@@ -375,6 +408,15 @@ std::string TD_TL_writer_cpp::gen_full_store_class_name(const tl::tl_tree_type *
 
   assert(!(t->flags & tl::FLAG_DEFAULT_CONSTRUCTOR));  // Not supported yet
 
+  if (tl_name == "td_api" && !is_built_in_simple_type(t->name) && !is_built_in_complex_type(t->name)) {
+    // objects can be null, so they are always boxed
+    if (is_type_bare(t)) {
+      return "TlStoreNullable<TlStoreBoxed<" + gen_store_class_name(tree_type) + ", " +
+             int_to_string(get_object_constructor_id(t)) + ">>";
+    }
+    return "TlStoreNullable<TlStoreBoxedUnknown<" + gen_store_class_name(tree_type) + ">>";
+  }
+
   if ((tree_type->flags & tl::FLAG_BARE) != 0 || t->name == "#" || t->name == "Bool") {
     return gen_store_class_name(tree_type);
   }
@@ -416,7 +458,9 @@ std::string TD_TL_writer_cpp::gen_type_store(const std::string &field_name, cons
     return "";
   } else if (name == "Bytes") {
     return "s.store_bytes_field(\"" + get_pretty_field_name(field_name) + "\", " + field_name + ");";
-  } else if (name == "Vector") {
+  } else if (name == "StringView") {
+    return "s.store_string_field(\"" + get_pretty_field_name(field_name) + "\", " + field_name + ".as_slice());";
+  } else if (name == "Vector" || name == "LazyVector") {
     const tl::tl_tree_type *child = static_cast<const tl::tl_tree_type *>(tree_type->children[0]);
     return gen_vector_store(field_name, child, vars, storer_type);
   } else {
@@ -692,7 +736,7 @@ std::string TD_TL_writer_cpp::gen_constructor_field_init(int field_num, const st
   std::string move_begin;
   std::string move_end;
   if ((field_type == "bytes" || field_type.compare(0, 5, "array") == 0 ||
-       field_type.compare(0, 10, "object_ptr") == 0) &&
+       field_type.compare(0, 10, "object_ptr") == 0 || field_type.compare(0, 12, "TlLazyVector") == 0) &&
       !is_default) {
     move_begin = "std::move(";
     move_end = ")";
@@ -710,4 +754,51 @@ std::string TD_TL_writer_cpp::gen_constructor_end(const tl::tl_combinator *t, in
   return "{}\n";
 }
 
+std::string TD_TL_writer_cpp::gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
+                                                      bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  std::string res = "\nstd::size_t " + gen_class_name(t->name) +
+                    "::approximate_memory_usage() const {\n"
+                    "  std::size_t result = sizeof(*this);\n";
+  for (std::size_t i = 0; i < t->args.size(); i++) {
+    std::string field_type = gen_field_type(t->args[i]);
+    if (field_type.empty() || field_type == "bool" || field_type == "int32" || field_type == "int53" ||
+        field_type == "int64" || field_type == "double" || field_type == "UInt128" || field_type == "UInt256") {
+      continue;
+    }
+    res += "  result += tl_extra_memory_usage(" + gen_field_name(t->args[i].name) + ");\n";
+  }
+  return res +
+         "  return result;\n"
+         "}\n";
+}
+
+std::string TD_TL_writer_cpp::gen_additional_proxy_function_begin(const std::string &function_name,
+                                                                  const tl::tl_type *type,
+                                                                  const std::string &class_name, int arity,
+                                                                  bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
+std::string TD_TL_writer_cpp::gen_additional_proxy_function_case(const std::string &function_name,
+                                                                 const tl::tl_type *type, const std::string &class_name,
+                                                                 int arity) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
+std::string TD_TL_writer_cpp::gen_additional_proxy_function_case(const std::string &function_name,
+                                                                 const tl::tl_type *type, const tl::tl_combinator *t,
+                                                                 int arity, bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
+std::string TD_TL_writer_cpp::gen_additional_proxy_function_end(const std::string &function_name,
+                                                                const tl::tl_type *type, bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
 }  // namespace td
@@ -17,6 +17,8 @@ namespace td {
 class TD_TL_writer_cpp : public TD_TL_writer {
   std::string gen_constructor_id_store_raw(const std::string &id) const;
 
+  std::int32_t get_object_constructor_id(const tl::tl_type *t) const;
+
   std::string gen_fetch_class_name(const tl::tl_tree_type *tree_type) const;
 
   std::string gen_full_fetch_class_name(const tl::tl_tree_type *tree_type) const;
@@ -102,6 +104,19 @@ class TD_TL_writer_cpp : public TD_TL_writer {
   std::string gen_constructor_field_init(int field_num, const std::string &class_name, const tl::arg &a,
                                          bool is_default) const override;
   std::string gen_constructor_end(const tl::tl_combinator *t, int field_count, bool is_default) const override;
+
+  std::string gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
+                                      bool is_function) const override;
+  std::string gen_additional_proxy_function_begin(const std::string &function_name, const tl::tl_type *type,
+                                                  const std::string &class_name, int arity,
+                                                  bool is_function) const override;
+  std::string gen_additional_proxy_function_case(const std::string &function_name, const tl::tl_type *type,
+                                                 const std::string &class_name, int arity) const override;
+  std::string gen_additional_proxy_function_case(const std::string &function_name, const tl::tl_type *type,
+                                                 const tl::tl_combinator *t, int arity,
+                                                 bool is_function) const override;
+  std::string gen_additional_proxy_function_end(const std::string &function_name, const tl::tl_type *type,
+                                                bool is_function) const override;
 };
 
 }  // namespace td
@@ -411,4 +411,38 @@ std::string TD_TL_writer_h::gen_constructor_end(const tl::tl_combinator *t, int
   return ");\n";
 }
 
+std::string TD_TL_writer_h::gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
+                                                    bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "\n"
+         "  std::size_t approximate_memory_usage() const final;\n";
+}
+
+std::string TD_TL_writer_h::gen_additional_proxy_function_begin(const std::string &function_name,
+                                                                const tl::tl_type *type, const std::string &class_name,
+                                                                int arity, bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
+std::string TD_TL_writer_h::gen_additional_proxy_function_case(const std::string &function_name,
+                                                               const tl::tl_type *type, const std::string &class_name,
+                                                               int arity) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
+std::string TD_TL_writer_h::gen_additional_proxy_function_case(const std::string &function_name,
+                                                               const tl::tl_type *type, const tl::tl_combinator *t,
+                                                               int arity, bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
+std::string TD_TL_writer_h::gen_additional_proxy_function_end(const std::string &function_name,
+                                                              const tl::tl_type *type, bool is_function) const {
+  assert(function_name == "approximate_memory_usage");
+  return "";
+}
+
 }  // namespace td
@@ -33,7 +33,10 @@ int TD_TL_writer_jni_cpp::get_parser_type(const tl::tl_combinator *t, const std:
 }
 
 int TD_TL_writer_jni_cpp::get_additional_function_type(const std::string &additional_function_name) const {
-  return 1;
+  if (additional_function_name == "init_jni_vars") {
+    return 1;
+  }
+  return TD_TL_writer_cpp::get_additional_function_type(additional_function_name);
 }
 
 std::vector<std::string> TD_TL_writer_jni_cpp::get_parsers() const {
@@ -50,7 +53,7 @@ std::vector<std::string> TD_TL_writer_jni_cpp::get_storers() const {
 }
 
 std::vector<std::string> TD_TL_writer_jni_cpp::get_additional_functions() const {
-  std::vector<std::string> additional_functions;
+  std::vector<std::string> additional_functions = TD_TL_writer_cpp::get_additional_functions();
   additional_functions.push_back("init_jni_vars");
   return additional_functions;
 }
@@ -303,17 +306,16 @@ std::string TD_TL_writer_jni_cpp::gen_type_store(const std::string &field_name,
     if (storer_type == 1) {
       res = "s.store_field(\"" + get_pretty_field_name(field_name) + "\", " + field_name + ");";
     } else if (name == "Bool") {
-      res = "env->SetBooleanField(s, " + field_name + "fieldID, " + field_name + ");";
+      // fields of an object created by AllocObject are zero-initialized, so zero values don't need to be stored
+      res = "if (" + field_name + ") { env->SetBooleanField(s, " + field_name + "fieldID, JNI_TRUE); }";
     } else if (name == "Int32") {
-      res = "env->SetIntField(s, " + field_name + "fieldID, " + field_name + ");";
+      res = "if (" + field_name + " != 0) { env->SetIntField(s, " + field_name + "fieldID, " + field_name + "); }";
     } else if (name == "Int53" || name == "Int64") {
-      res = "env->SetLongField(s, " + field_name + "fieldID, " + field_name + ");";
+      res = "if (" + field_name + " != 0) { env->SetLongField(s, " + field_name + "fieldID, " + field_name + "); }";
     } else if (name == "Double") {
       res = "env->SetDoubleField(s, " + field_name + "fieldID, " + field_name + ");";
     } else if (name == "String") {
-      res = "{ jstring nextString = jni::to_jstring(env, " + field_name +
-            "); if (nextString) { env->SetObjectField(s, " + field_name +
-            "fieldID, nextString); env->DeleteLocalRef(nextString); } }";
+      res = "jni::store_string(env, s, " + field_name + "fieldID, " + field_name + ");";
     } else {
       assert(false);
     }
@@ -321,9 +323,7 @@ std::string TD_TL_writer_jni_cpp::gen_type_store(const std::string &field_name,
     if (storer_type == 1) {
       res = "s.store_bytes_field(\"" + get_pretty_field_name(field_name) + "\", " + field_name + ");";
     } else {
-      res = "{ jbyteArray nextBytes = jni::to_bytes(env, " + field_name +
-            "); if (nextBytes) { env->SetObjectField(s, " + field_name +
-            "fieldID, nextBytes); env->DeleteLocalRef(nextBytes); } }";
+      res = "jni::store_bytes(env, s, " + field_name + "fieldID, " + field_name + ");";
     }
   } else if (name == "Vector") {
     const tl::tl_tree_type *child = static_cast<const tl::tl_tree_type *>(tree_type->children[0]);
@@ -571,7 +571,10 @@ std::string TD_TL_writer_jni_cpp::gen_type_signature(const tl::tl_tree_type *tre
 
 std::string TD_TL_writer_jni_cpp::gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
                                                           bool is_function) const {
-  assert(function_name == "init_jni_vars");
+  if (function_name != "init_jni_vars") {
+    return TD_TL_writer_cpp::gen_additional_function(function_name, t, is_function);
+  }
+
   std::string class_name = gen_class_name(t->name);
   std::string class_name_class = "Class";
   std::string res =
@@ -625,7 +628,10 @@ std::string TD_TL_writer_jni_cpp::gen_additional_proxy_function_begin(const std:
                                                                       const tl::tl_type *type,
                                                                       const std::string &class_name, int arity,
                                                                       bool is_function) const {
-  assert(function_name == "init_jni_vars");
+  if (function_name != "init_jni_vars") {
+    return TD_TL_writer_cpp::gen_additional_proxy_function_begin(function_name, type, class_name, arity, is_function);
+  }
+
   assert(arity == 0);
   return "\n"
          "void " +
@@ -643,7 +649,10 @@ std::string TD_TL_writer_jni_cpp::gen_additional_proxy_function_begin(const std:
 std::string TD_TL_writer_jni_cpp::gen_additional_proxy_function_case(const std::string &function_name,
                                                                      const tl::tl_type *type,
                                                                      const std::string &class_name, int arity) const {
-  assert(function_name == "init_jni_vars");
+  if (function_name != "init_jni_vars") {
+    return TD_TL_writer_cpp::gen_additional_proxy_function_case(function_name, type, class_name, arity);
+  }
+
   assert(arity == 0);
   return "";
 }
@@ -652,14 +661,20 @@ std::string TD_TL_writer_jni_cpp::gen_additional_proxy_function_case(const std::
                                                                      const tl::tl_type *type,
                                                                      const tl::tl_combinator *t, int arity,
                                                                      bool is_function) const {
-  assert(function_name == "init_jni_vars");
+  if (function_name != "init_jni_vars") {
+    return TD_TL_writer_cpp::gen_additional_proxy_function_case(function_name, type, t, arity, is_function);
+  }
+
   assert(arity == 0);
   return "";
 }
 
 std::string TD_TL_writer_jni_cpp::gen_additional_proxy_function_end(const std::string &function_name,
                                                                     const tl::tl_type *type, bool is_function) const {
-  assert(function_name == "init_jni_vars");
+  if (function_name != "init_jni_vars") {
+    return TD_TL_writer_cpp::gen_additional_proxy_function_end(function_name, type, is_function);
+  }
+
   return "}\n";
 }
 
@@ -103,6 +103,7 @@ std::string TD_TL_writer_jni_h::gen_class_begin(const std::string &class_name, c
            "  virtual void store(JNIEnv *env, jobject &s) const {\n"
            "  }\n\n"
            "  virtual void store(TlStorerToString &s, const char *field_name) const = 0;\n\n"
+           "  virtual std::size_t approximate_memory_usage() const = 0;\n\n"
            "  static jclass Class;\n";
   }
   return TD_TL_writer_h::gen_class_begin(class_name, base_class_name, is_proxy, result) + "  static jclass Class;\n";
@@ -23,11 +23,11 @@ int TD_TL_writer::get_max_arity() const {
 bool TD_TL_writer::is_built_in_simple_type(const std::string &name) const {
   return name == "True" || name == "Bool" || name == "Int" || name == "Long" || name == "Double" || name == "String" ||
          name == "Int32" || name == "Int53" || name == "Int64" || name == "Int128" || name == "Int256" ||
-         name == "Bytes";
+         name == "Bytes" || name == "StringView";
 }
 
 bool TD_TL_writer::is_built_in_complex_type(const std::string &name) const {
-  return name == "Vector";
+  return name == "Vector" || name == "LazyVector";
 }
 
 bool TD_TL_writer::is_type_bare(const tl::tl_type *t) const {
@@ -71,6 +71,11 @@ int TD_TL_writer::get_storer_type(const tl::tl_combinator *t, const std::string
   return storer_name == "TlStorerToString";
 }
 
+int TD_TL_writer::get_additional_function_type(const std::string &additional_function_name) const {
+  assert(additional_function_name == "approximate_memory_usage");
+  return 0;
+}
+
 tl::TL_writer::Mode TD_TL_writer::get_parser_mode(int type) const {
   if (tl_name == "td_api") {
 #ifndef TD_ENABLE_JNI  // we need to parse all types in order to implement toString
@@ -101,7 +106,7 @@ std::vector<std::string> TD_TL_writer::get_parsers() const {
   std::vector<std::string> parsers;
   if (tl_name == "telegram_api") {
     parsers.push_back("TlBufferParser");
-  } else if (tl_name == "mtproto_api" || tl_name == "secret_api") {
+  } else if (tl_name == "mtproto_api" || tl_name == "secret_api" || tl_name == "td_api") {
     parsers.push_back("TlParser");
   }
   return parsers;
@@ -109,7 +114,8 @@ std::vector<std::string> TD_TL_writer::get_parsers() const {
 
 std::vector<std::string> TD_TL_writer::get_storers() const {
   std::vector<std::string> storers;
-  if (tl_name == "telegram_api" || tl_name == "mtproto_api" || tl_name == "secret_api") {
+  if (tl_name == "telegram_api" || tl_name == "mtproto_api" || tl_name == "secret_api" || tl_name == "td_api") {
+    storers.push_back("TlStorerBuffer");
     storers.push_back("TlStorerCalcLength");
     storers.push_back("TlStorerUnsafe");
   }
@@ -117,6 +123,12 @@ std::vector<std::string> TD_TL_writer::get_storers() const {
   return storers;
 }
 
+std::vector<std::string> TD_TL_writer::get_additional_functions() const {
+  std::vector<std::string> additional_functions;
+  additional_functions.push_back("approximate_memory_usage");
+  return additional_functions;
+}
+
 std::string TD_TL_writer::gen_import_declaration(const std::string &name, bool is_system) const {
   if (is_system) {
     return "#include <" + name + ">\n";
@@ -216,7 +228,7 @@ std::string TD_TL_writer::gen_type_name(const tl::tl_tree_type *tree_type) const
   if (name == "Int256") {
     return "UInt256";
   }
-  if (name == "Bytes") {
+  if (name == "Bytes" || name == "StringView") {
     return "bytes";
   }
 
@@ -228,6 +240,14 @@ std::string TD_TL_writer::gen_type_name(const tl::tl_tree_type *tree_type) const
 
     return "array<" + gen_type_name(child) + ">";
   }
+  if (name == "LazyVector") {
+    assert(t->arity == 1);
+    assert(tree_type->children.size() == 1);
+    assert(tree_type->children[0]->get_type() == tl::NODE_TYPE_TYPE);
+    const tl::tl_tree_type *child = static_cast<const tl::tl_tree_type *>(tree_type->children[0]);
+
+    return "TlLazyVector<" + gen_type_name(child) + ">";
+  }
 
   assert(!is_built_in_simple_type(name) && !is_built_in_complex_type(name));
 
@@ -275,7 +295,7 @@ std::string TD_TL_writer::gen_constructor_parameter(int field_num, const std::st
              (string_type == bytes_type && field_type == "bytes ")) {
     res += field_type + "const &";
   } else if (field_type.compare(0, 5, "array") == 0 || field_type == "bytes " ||
-             field_type.compare(0, 10, "object_ptr") == 0) {
+             field_type.compare(0, 10, "object_ptr") == 0 || field_type.compare(0, 12, "TlLazyVector") == 0) {
     res += field_type + "&&";
   } else {
     assert(false && "unreachable");
@@ -40,10 +40,12 @@ class TD_TL_writer : public tl::TL_writer {
   bool is_full_constructor_generated(const tl::tl_combinator *t, bool can_be_parsed, bool can_be_stored) const override;
 
   int get_storer_type(const tl::tl_combinator *t, const std::string &storer_name) const override;
+  int get_additional_function_type(const std::string &additional_function_name) const override;
   Mode get_parser_mode(int type) const override;
   Mode get_storer_mode(int type) const override;
   std::vector<std::string> get_parsers() const override;
   std::vector<std::string> get_storers() const override;
+  std::vector<std::string> get_additional_functions() const override;
 
   std::string gen_import_declaration(const std::string &package_name, bool is_system) const override;
   std::string gen_package_suffix() const override;
@@ -0,0 +1,158 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/mtproto/CryptoWorkerPool.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+namespace td {
+namespace mtproto {
+
+namespace {
+
+#if !TD_THREAD_UNSUPPORTED
+class CryptoWorkerPoolImpl {
+ public:
+  void set_thread_count(int32 thread_count) {
+    std::lock_guard<std::mutex> set_thread_count_guard(set_thread_count_mutex_);
+    vector<td::thread> stopped_threads;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      thread_count_ = thread_count;
+      auto new_thread_count = static_cast<size_t>(thread_count);
+      while (threads_.size() < new_thread_count) {
+        auto thread_id = threads_.size();
+        threads_.push_back(td::thread([this, thread_id] { loop(thread_id); }));
+      }
+      while (threads_.size() > new_thread_count) {
+        stopped_threads.push_back(std::move(threads_.back()));
+        threads_.pop_back();
+      }
+      have_job_cond_.notify_all();
+    }
+    for (auto &thread : stopped_threads) {
+      thread.join();
+    }
+  }
+
+  int32 get_thread_count() const {
+    return thread_count_.load(std::memory_order_relaxed);
+  }
+
+  void run(size_t task_count, const std::function<void(size_t)> &func) {
+    Job job;
+    job.func_ = &func;
+    job.task_count_ = task_count;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.push_back(&job);
+    have_job_cond_.notify_all();
+
+    while (job.next_task_ < job.task_count_) {
+      run_task(lock, &job);
+    }
+    job_finished_cond_.wait(lock, [&job] { return job.finished_task_count_ == job.task_count_; });
+  }
+
+ private:
+  struct Job {
+    const std::function<void(size_t)> *func_ = nullptr;
+    size_t task_count_ = 0;
+    size_t next_task_ = 0;
+    size_t finished_task_count_ = 0;
+  };
+
+  std::mutex set_thread_count_mutex_;
+  std::mutex mutex_;
+  std::condition_variable have_job_cond_;
+  std::condition_variable job_finished_cond_;
+  vector<Job *> jobs_;
+  vector<td::thread> threads_;
+  std::atomic<int32> thread_count_{0};
+
+  void loop(size_t thread_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (thread_id < static_cast<size_t>(thread_count_.load(std::memory_order_relaxed))) {
+      if (jobs_.empty()) {
+        have_job_cond_.wait(lock);
+        continue;
+      }
+      run_task(lock, jobs_[0]);
+    }
+  }
+
+  // must be called with the mutex locked; the job must have unstarted tasks
+  void run_task(std::unique_lock<std::mutex> &lock, Job *job) {
+    auto task = job->next_task_++;
+    if (job->next_task_ == job->task_count_) {
+      td::remove(jobs_, job);
+    }
+
+    lock.unlock();
+    (*job->func_)(task);
+    lock.lock();
+
+    if (++job->finished_task_count_ == job->task_count_) {
+      job_finished_cond_.notify_all();
+    }
+  }
+};
+
+CryptoWorkerPoolImpl &get_crypto_worker_pool() {
+  // the pool is never destroyed, so its threads can be used until the process exits
+  static auto *pool = new CryptoWorkerPoolImpl();
+  return *pool;
+}
+#endif
+
+}  // namespace
+
+void CryptoWorkerPool::set_thread_count(int32 thread_count) {
+  thread_count = clamp(thread_count, static_cast<int32>(0), MAX_THREAD_COUNT);
+#if !TD_THREAD_UNSUPPORTED
+  if (thread_count == get_thread_count()) {
+    return;
+  }
+  LOG(INFO) << "Use " << thread_count << " threads for MTProto packet decryption";
+  get_crypto_worker_pool().set_thread_count(thread_count);
+#endif
+}
+
+int32 CryptoWorkerPool::get_thread_count() {
+#if TD_THREAD_UNSUPPORTED
+  return 0;
+#else
+  return get_crypto_worker_pool().get_thread_count();
+#endif
+}
+
+bool CryptoWorkerPool::need_parallel_decryption(size_t packet_count, size_t total_size) {
+  // handing a packet over to another thread costs about as much as decryption of a few kilobytes
+  constexpr size_t MIN_TOTAL_SIZE = 1 << 15;
+  return packet_count >= 2 && total_size >= MIN_TOTAL_SIZE && get_thread_count() > 0;
+}
+
+void CryptoWorkerPool::run(size_t task_count, const std::function<void(size_t)> &func) {
+#if !TD_THREAD_UNSUPPORTED
+  if (task_count >= 2 && get_thread_count() > 0) {
+    return get_crypto_worker_pool().run(task_count, func);
+  }
+#endif
+  for (size_t i = 0; i < task_count; i++) {
+    func(i);
+  }
+}
+
+}  // namespace mtproto
+}  // namespace td
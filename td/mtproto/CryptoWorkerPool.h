@@ -0,0 +1,35 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <functional>
+
+namespace td {
+namespace mtproto {
+
+// process-wide pool of threads, which decrypt received MTProto packets in parallel
+class CryptoWorkerPool {
+ public:
+  static constexpr int32 MAX_THREAD_COUNT = 16;
+
+  // sets number of additional threads used for decryption; 0 disables the pool
+  static void set_thread_count(int32 thread_count);
+
+  static int32 get_thread_count();
+
+  // returns whether the packets are big enough to be decrypted in parallel
+  static bool need_parallel_decryption(size_t packet_count, size_t total_size);
+
+  // calls func for all numbers in [0, task_count) in the pool threads and in the current thread in unspecified order
+  // returns after all calls are finished
+  static void run(size_t task_count, const std::function<void(size_t)> &func);
+};
+
+}  // namespace mtproto
+}  // namespace td
@@ -15,9 +15,95 @@
 #include "td/utils/Status.h"
 #include "td/utils/UInt.h"
 
+#include <mutex>
+#include <utility>
+
 namespace td {
 namespace mtproto {
 
+namespace {
+
+// random exponents b and g^b, computed in advance for the last used config; each exponent is used only once
+class PrecomputedExponents {
+ public:
+  static constexpr size_t MAX_EXPONENT_COUNT = 8;
+
+  bool take(int32 g_int, Slice prime_str, BigNum &b, BigNum &g_b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (g_int != g_int_ || prime_str != prime_str_) {
+      g_int_ = g_int;
+      prime_str_ = prime_str.str();
+      exponents_.clear();
+      return false;
+    }
+    if (exponents_.empty()) {
+      return false;
+    }
+    b = BigNum::from_binary(exponents_.back().first);
+    g_b = BigNum::from_binary(exponents_.back().second);
+    exponents_.pop_back();
+    return true;
+  }
+
+  bool get_config(int32 &g_int, string &prime_str) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (g_int_ == 0 || exponents_.size() >= MAX_EXPONENT_COUNT) {
+      return false;
+    }
+    g_int = g_int_;
+    prime_str = prime_str_;
+    return true;
+  }
+
+  void add(int32 g_int, Slice prime_str, string b, string g_b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (g_int != g_int_ || prime_str != prime_str_ || exponents_.size() >= MAX_EXPONENT_COUNT) {
+      return;
+    }
+    exponents_.emplace_back(std::move(b), std::move(g_b));
+  }
+
+ private:
+  std::mutex mutex_;
+  int32 g_int_ = 0;
+  string prime_str_;
+  vector<std::pair<string, string>> exponents_;
+};
+
+PrecomputedExponents &get_precomputed_exponents() {
+  static PrecomputedExponents precomputed_exponents;
+  return precomputed_exponents;
+}
+
+// Montgomery contexts for the last used primes; there is usually only one prime, which is returned by the server
+class ModContextCache {
+ public:
+  static constexpr size_t MAX_CONTEXT_COUNT = 4;
+
+  std::shared_ptr<const BigNumModContext> get(Slice prime_str, const BigNum &prime) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < contexts_.size(); i++) {
+      if (contexts_[i].first == prime_str) {
+        if (i != 0) {
+          std::swap(contexts_[i], contexts_[0]);
+        }
+        return contexts_[0].second;
+      }
+    }
+    if (contexts_.size() >= MAX_CONTEXT_COUNT) {
+      contexts_.pop_back();
+    }
+    contexts_.emplace(contexts_.begin(), prime_str.str(), std::make_shared<const BigNumModContext>(prime));
+    return contexts_[0].second;
+  }
+
+ private:
+  std::mutex mutex_;
+  vector<std::pair<string, std::shared_ptr<const BigNumModContext>>> contexts_;
+};
+
+}  // namespace
+
 Status DhHandshake::check_config(Slice prime_str, const BigNum &prime, int32 g_int, BigNumContext &ctx,
                                  DhCallback *callback) {
   // check that 2^2047 <= p < 2^2048
@@ -129,17 +215,43 @@ void DhHandshake::set_config(int32 g_int, Slice prime_str) {
   has_config_ = true;
   prime_ = BigNum::from_binary(prime_str);
   prime_str_ = prime_str.str();
+  mod_context_ = get_mod_context(prime_str_, prime_);
 
   b_ = BigNum();
   g_b_ = BigNum();
 
+  g_int_ = g_int;
+  g_.set_value(g_int_);
+
+  if (get_precomputed_exponents().take(g_int, prime_str, b_, g_b_)) {
+    return;
+  }
+
   BigNum::random(b_, 2048, -1, 0);
 
   // g^b
-  g_int_ = g_int;
-  g_.set_value(g_int_);
+  mod_context_->mod_exp(g_b_, g_, b_);
+}
+
+void DhHandshake::precompute_exponent() {
+  int32 g_int;
+  string prime_str;
+  if (!get_precomputed_exponents().get_config(g_int, prime_str)) {
+    return;
+  }
+
+  BigNum b;
+  BigNum::random(b, 2048, -1, 0);
+  BigNum g;
+  g.set_value(g_int);
+  BigNum g_b;
+  get_mod_context(prime_str, BigNum::from_binary(prime_str))->mod_exp(g_b, g, b);
+  get_precomputed_exponents().add(g_int, prime_str, b.to_binary(), g_b.to_binary());
+}
 
-  BigNum::mod_exp(g_b_, g_, b_, prime_, ctx_);
+std::shared_ptr<const BigNumModContext> DhHandshake::get_mod_context(Slice prime_str, const BigNum &prime) {
+  static ModContextCache mod_context_cache;
+  return mod_context_cache.get(prime_str, prime);
 }
 
 Status DhHandshake::check_config(int32 g_int, Slice prime_str, DhCallback *callback) {
@@ -212,7 +324,7 @@ BigNum DhHandshake::get_b() const {
 BigNum DhHandshake::get_g_ab() {
   CHECK(has_g_a_ && has_config_);
   BigNum g_ab;
-  BigNum::mod_exp(g_ab, g_a_, b_, prime_, ctx_);
+  mod_context_->mod_exp(g_ab, g_a_, b_);
   return g_ab;
 }
 
@@ -11,6 +11,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <memory>
 #include <utility>
 
 namespace td {
@@ -22,6 +23,10 @@ class DhHandshake {
  public:
   void set_config(int32 g_int, Slice prime_str);
 
+  // computes a random exponent for the last used config in advance, if there are not enough of them already
+  // the exponent will be used by a subsequent set_config call with the same config to avoid one exponentiation
+  static void precompute_exponent();
+
   static Status check_config(int32 g_int, Slice prime_str, DhCallback *callback);
 
   bool has_config() const {
@@ -83,6 +88,7 @@ class DhHandshake {
       // prime_, prime_str_, b_, g_, g_int_, g_b_
       prime_str_ = parser.template fetch_string<std::string>();
       prime_ = BigNum::from_binary(prime_str_);
+      mod_context_ = get_mod_context(prime_str_, prime_);
 
       b_ = BigNum::from_binary(parser.template fetch_string<string>());
 
@@ -102,8 +108,12 @@ class DhHandshake {
 
   static Status dh_check(const BigNum &prime, const BigNum &g_a, const BigNum &g_b) TD_WARN_UNUSED_RESULT;
 
+  // returns a shared context with precomputed Montgomery data for the prime
+  static std::shared_ptr<const BigNumModContext> get_mod_context(Slice prime_str, const BigNum &prime);
+
   string prime_str_;
   BigNum prime_;
+  std::shared_ptr<const BigNumModContext> mod_context_;
   BigNum g_;
   int32 g_int_ = 0;
   BigNum b_;
@@ -6,6 +6,7 @@
 //
 #include "td/mtproto/HandshakeActor.h"
 
+#include "td/mtproto/DhHandshake.h"
 #include "td/mtproto/HandshakeConnection.h"
 
 #include "td/utils/common.h"
@@ -46,7 +47,11 @@ void HandshakeActor::loop() {
   }
   if (handshake_->is_ready_for_finish()) {
     finish(Status::OK());
-    return stop();
+    stop();
+
+    // the result is already returned, so the exponent for the next handshake can be computed now
+    DhHandshake::precompute_exponent();
+    return;
   }
 }
 
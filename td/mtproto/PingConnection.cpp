@@ -134,6 +134,9 @@ class PingConnectionPingPong final
   void on_container_sent(MessageId container_message_id, vector<MessageId> message_ids) final {
   }
 
+  void on_queries_sent(size_t query_count, size_t query_size, double fill_ratio) final {
+  }
+
   Status on_pong() final {
     pong_cnt_++;
     if (pong_cnt_ == 1) {
@@ -7,6 +7,7 @@
 #include "td/mtproto/RawConnection.h"
 
 #include "td/mtproto/AuthKey.h"
+#include "td/mtproto/CryptoWorkerPool.h"
 #include "td/mtproto/IStreamTransport.h"
 #include "td/mtproto/ProxySecret.h"
 #include "td/mtproto/Transport.h"
@@ -15,6 +16,7 @@
 #include "td/net/DarwinHttp.h"
 #endif
 
+#include "td/utils/buffer.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -61,6 +63,7 @@ class RawConnectionDefault final : public RawConnection {
 
   size_t send_crypto(const Storer &storer, uint64 session_id, int64 salt, const AuthKey &auth_key,
                      uint64 quick_ack_token) final {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Transport);
     PacketInfo packet_info;
     packet_info.version = 2;
     packet_info.no_crypto_flag = false;
@@ -87,6 +90,7 @@ class RawConnectionDefault final : public RawConnection {
   }
 
   void send_no_crypto(const Storer &storer) final {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Transport);
     PacketInfo packet_info;
     packet_info.no_crypto_flag = true;
     auto packet = Transport::write(storer, AuthKey(), &packet_info, transport_->max_prepend_size(),
@@ -144,6 +148,8 @@ class RawConnectionDefault final : public RawConnection {
 
   ConnectionManager::ConnectionToken connection_token_;
 
+  vector<BufferSlice> pending_packets_;
+
   void on_read(size_t size, Callback &callback) {
     if (size <= 0) {
       return;
@@ -156,10 +162,20 @@ class RawConnectionDefault final : public RawConnection {
   }
 
   Status flush_read(const AuthKey &auth_key, Callback &callback) {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Transport);
     auto r = socket_fd_.flush_read();
     if (r.is_ok()) {
       on_read(r.ok(), callback);
     }
+    auto status = read_packets(auth_key, callback);
+    // packets received before the error must be processed first
+    TRY_STATUS(process_pending_packets(auth_key, callback));
+    TRY_STATUS(std::move(status));
+    TRY_STATUS(std::move(r));
+    return Status::OK();
+  }
+
+  Status read_packets(const AuthKey &auth_key, Callback &callback) {
     while (transport_->can_read()) {
       BufferSlice packet;
       uint32 quick_ack = 0;
@@ -172,6 +188,7 @@ class RawConnectionDefault final : public RawConnection {
         break;
       }
       if (quick_ack != 0) {
+        TRY_STATUS(process_pending_packets(auth_key, callback));
         TRY_STATUS(on_quick_ack(quick_ack, callback));
         continue;
       }
@@ -186,10 +203,39 @@ class RawConnectionDefault final : public RawConnection {
           << old_pointer << ' ' << packet.as_slice().ubegin() << ' ' << BufferSlice(0).as_slice().ubegin() << ' '
           << packet.size() << ' ' << wait_size << ' ' << quick_ack;
 
-      PacketInfo packet_info;
-      packet_info.version = 2;
+      pending_packets_.push_back(std::move(packet));
+    }
+    return Status::OK();
+  }
 
-      TRY_RESULT(read_result, Transport::read(packet.as_mutable_slice(), auth_key, &packet_info));
+  // decrypts all received packets, in parallel if possible, and processes them in the order of receiving
+  Status process_pending_packets(const AuthKey &auth_key, Callback &callback) {
+    if (pending_packets_.empty()) {
+      return Status::OK();
+    }
+    auto packets = std::move(pending_packets_);
+    pending_packets_.clear();
+
+    size_t total_size = 0;
+    for (auto &packet : packets) {
+      total_size += packet.size();
+    }
+    vector<PacketInfo> packet_infos(packets.size());
+    vector<Result<Transport::ReadResult>> read_results(packets.size());
+    auto read_packet = [&](size_t i) {
+      packet_infos[i].version = 2;
+      read_results[i] = Transport::read(packets[i].as_mutable_slice(), auth_key, &packet_infos[i]);
+    };
+    bool is_parallel = !auth_key.empty() && CryptoWorkerPool::need_parallel_decryption(packets.size(), total_size);
+    if (is_parallel) {
+      CryptoWorkerPool::run(packets.size(), read_packet);
+    }
+
+    for (size_t i = 0; i < packets.size(); i++) {
+      if (!is_parallel) {
+        read_packet(i);
+      }
+      TRY_RESULT(read_result, std::move(read_results[i]));
       switch (read_result.type()) {
         case Transport::ReadResult::Quickack:
           TRY_STATUS(on_quick_ack(read_result.quick_ack(), callback));
@@ -205,7 +251,7 @@ class RawConnectionDefault final : public RawConnection {
             }
           }
 
-          TRY_STATUS(callback.on_raw_packet(packet_info, packet.from_slice(read_result.packet())));
+          TRY_STATUS(callback.on_raw_packet(packet_infos[i], packets[i].from_slice(read_result.packet())));
           break;
         case Transport::ReadResult::Nop:
           break;
@@ -213,8 +259,6 @@ class RawConnectionDefault final : public RawConnection {
           UNREACHABLE();
       }
     }
-
-    TRY_STATUS(std::move(r));
     return Status::OK();
   }
 
@@ -249,6 +293,7 @@ class RawConnectionDefault final : public RawConnection {
   }
 
   Status flush_write() {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Transport);
     TRY_RESULT(size, socket_fd_.flush_write());
     if (size > 0 && stats_callback_) {
       stats_callback_->on_write(size);
@@ -301,6 +346,7 @@ class RawConnectionHttp final : public RawConnection {
 
   size_t send_crypto(const Storer &storer, uint64 session_id, int64 salt, const AuthKey &auth_key,
                      uint64 quick_ack_token) final {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Transport);
     PacketInfo packet_info;
     packet_info.version = 2;
     packet_info.no_crypto_flag = false;
@@ -315,6 +361,7 @@ class RawConnectionHttp final : public RawConnection {
   }
 
   void send_no_crypto(const Storer &storer) final {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Transport);
     PacketInfo packet_info;
     packet_info.no_crypto_flag = true;
     auto packet = Transport::write(storer, AuthKey(), &packet_info);
@@ -30,6 +30,7 @@
 #include "td/utils/TlDowncastHelper.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <type_traits>
 
@@ -351,6 +352,7 @@ Status SessionConnection::on_packet(const MsgInfo &info,
       LOG(WARNING) << bad_info << ": MessageId is too high. Session will be closed";
       // All this queries will be re-sent by parent
       to_send_.clear();
+      to_send_size_ = 0;
       reset_server_time_difference(info.message_id);
       callback_->on_session_failed(Status::Error("MessageId is too high"));
       return Status::Error("MessageId is too high");
@@ -813,13 +815,18 @@ Result<MessageId> SessionConnection::send_query(BufferSlice buffer, bool gzip_fl
   }
   auto seq_no = auth_data_->next_seq_no(true);
   if (to_send_.empty()) {
-    send_before(Time::now_cached() + QUERY_DELAY);
+    send_before(Time::now_cached() + query_delay_);
   }
   to_send_.push_back(MtprotoQuery{message_id, seq_no, std::move(buffer), gzip_flag, std::move(invoke_after_message_ids),
                                   use_quick_ack});
+  to_send_size_ += to_send_.back().packet.size();
   VLOG(mtproto) << "Invoke query with " << message_id << " and seq_no " << seq_no << " of size "
                 << to_send_.back().packet.size() << " after " << invoke_after_message_ids
                 << (use_quick_ack ? " with quick ack" : "");
+  if (to_send_.size() >= get_max_container_query_count() || to_send_size_ >= get_max_container_size()) {
+    // the container is full; there is no reason to wait for more queries
+    send_before(Time::now_cached());
+  }
 
   return message_id;
 }
@@ -905,6 +912,33 @@ bool SessionConnection::must_ping() const {
   return last_ping_at_ == 0 || (mode_ != Mode::HttpLongPoll && last_ping_at_ + ping_must_delay() < Time::now_cached());
 }
 
+namespace {
+std::atomic<double> max_query_delay{SessionConnection::DEFAULT_MAX_QUERY_DELAY_MS * 1e-3};
+}  // namespace
+
+void SessionConnection::set_max_query_delay(double new_max_query_delay) {
+  max_query_delay = clamp(new_max_query_delay, 0.0, 1.0);
+}
+
+size_t SessionConnection::get_max_container_query_count() const {
+  return 1000;
+}
+
+size_t SessionConnection::get_max_container_size() const {
+  // each HTTP request has much bigger overhead than a TCP packet, so send more data at once
+  return mode_ == Mode::Tcp ? (1 << 15) : (1 << 17);
+}
+
+void SessionConnection::update_query_delay(size_t sent_query_count) {
+  if (sent_query_count > 1) {
+    // queries are sent in bursts; wait longer to send more of them in one container
+    query_delay_ *= 2;
+  } else {
+    query_delay_ = max(query_delay_ * 0.5, QUERY_DELAY);
+  }
+  query_delay_ = min(query_delay_, max_query_delay.load(std::memory_order_relaxed));
+}
+
 void SessionConnection::flush_packet() {
   bool has_salt = auth_data_->has_salt(Time::now_cached());
   // ping
@@ -941,12 +975,13 @@ void SessionConnection::flush_packet() {
     }
   }
 
-  static constexpr size_t MAX_QUERY_COUNT = 1000;
+  const size_t max_query_count = get_max_container_query_count();
+  const size_t max_container_size = get_max_container_size();
   size_t send_till = 0;
   size_t send_size = 0;
   if (has_salt) {
-    // send at most MAX_QUERY_COUNT queries, of total size up to 2^15
-    while (send_till < to_send_.size() && send_till < MAX_QUERY_COUNT && send_size < (1 << 15)) {
+    // send at most max_query_count queries, of total size up to max_container_size
+    while (send_till < to_send_.size() && send_till < max_query_count && send_size < max_container_size) {
       send_size += to_send_[send_till].packet.size();
       send_till++;
     }
@@ -954,11 +989,16 @@ void SessionConnection::flush_packet() {
   vector<MtprotoQuery> queries;
   if (send_till == to_send_.size()) {
     queries = std::move(to_send_);
+    to_send_.clear();
   } else if (send_till != 0) {
     queries.reserve(send_till);
     std::move(to_send_.begin(), to_send_.begin() + send_till, std::back_inserter(queries));
     to_send_.erase(to_send_.begin(), to_send_.begin() + send_till);
   }
+  to_send_size_ -= send_size;
+  if (!queries.empty()) {
+    update_query_delay(queries.size());
+  }
 
   bool destroy_auth_key = need_destroy_auth_key_ && !sent_destroy_auth_key_;
 
@@ -1001,8 +1041,8 @@ void SessionConnection::flush_packet() {
   // no more than 8192 message identifiers per container..
   auto to_resend_answer = cut_tail(to_resend_answer_message_ids_, 8192, "resend_answer");
   MessageId resend_answer_message_id;
-  CHECK(queries.size() <= MAX_QUERY_COUNT);
-  auto to_cancel_answer = cut_tail(to_cancel_answer_message_ids_, MAX_QUERY_COUNT - queries.size(), "cancel_answer");
+  CHECK(queries.size() <= max_query_count);
+  auto to_cancel_answer = cut_tail(to_cancel_answer_message_ids_, max_query_count - queries.size(), "cancel_answer");
   auto to_get_state_info = cut_tail(to_get_state_info_message_ids_, 8192, "get_state_info");
   MessageId get_state_info_message_id;
   auto to_ack = cut_tail(to_ack_message_ids_, 8192, "ack");
@@ -1036,6 +1076,12 @@ void SessionConnection::flush_packet() {
     last_ping_message_id_ = ping_message_id;
   }
 
+  if (!queries.empty()) {
+    auto fill_ratio = max(static_cast<double>(queries.size()) / static_cast<double>(max_query_count),
+                          static_cast<double>(send_size) / static_cast<double>(max_container_size));
+    callback_->on_queries_sent(queries.size(), send_size, min(fill_ratio, 1.0));
+  }
+
   if (container_message_id != MessageId()) {
     auto message_ids = transform(queries, [](const MtprotoQuery &x) { return x.message_id; });
 
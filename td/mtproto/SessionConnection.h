@@ -81,6 +81,11 @@ class SessionConnection final
   void set_online(bool online_flag, bool is_main);
   void force_ack();
 
+  static constexpr int32 DEFAULT_MAX_QUERY_DELAY_MS = 4;
+
+  // sets maximum time for which queries can be delayed to be sent in one container, if they are sent in bursts
+  static void set_max_query_delay(double max_query_delay);
+
   class Callback {
    public:
     Callback() = default;
@@ -98,6 +103,7 @@ class SessionConnection final
     virtual void on_session_failed(Status status) = 0;
 
     virtual void on_container_sent(MessageId container_message_id, vector<MessageId> message_ids) = 0;
+    virtual void on_queries_sent(size_t query_count, size_t query_size, double fill_ratio) = 0;
     virtual Status on_pong() = 0;
 
     virtual Status on_update(BufferSlice packet) = 0;
@@ -161,6 +167,8 @@ class SessionConnection final
   static constexpr int HTTP_MAX_DELAY = 30;  // 0.03s
 
   vector<MtprotoQuery> to_send_;
+  size_t to_send_size_ = 0;
+  double query_delay_ = QUERY_DELAY;
   vector<MessageId> to_ack_message_ids_;
   double force_send_at_ = 0;
 
@@ -266,6 +274,9 @@ class SessionConnection final
   bool may_ping() const;
   bool must_ping() const;
   bool must_flush_packet();
+  size_t get_max_container_query_count() const;
+  size_t get_max_container_size() const;
+  void update_query_delay(size_t sent_query_count);
   void flush_packet();
 
   Status init() TD_WARN_UNUSED_RESULT;
@@ -167,7 +167,7 @@ void ObfuscatedTransport::do_write_main(BufferWriter &&message) {
     builder.prepend(header_);
     header_ = {};
   }
-  do_write(builder.extract());
+  do_write(std::move(builder));
 }
 
 void ObfuscatedTransport::do_write_tls(BufferWriter &&message) {
@@ -209,11 +209,20 @@ void ObfuscatedTransport::do_write_tls(BufferBuilder &&builder) {
     builder.prepend(first_prefix);
   }
 
-  do_write(builder.extract());
+  do_write(std::move(builder));
 }
 
-void ObfuscatedTransport::do_write(BufferSlice &&message) {
-  output_->append(std::move(message));
+void ObfuscatedTransport::do_write(BufferBuilder &&builder) {
+  size_t part_count = 0;
+  builder.for_each([&part_count](Slice) { part_count++; });
+  if (part_count == 1) {
+    // the header and the padding were written in place
+    output_->append(builder.extract());
+    return;
+  }
+
+  // the parts are linked to the output stream separately and are sent by a single writev without concatenation
+  std::move(builder).for_each([&](BufferSlice &&slice) { output_->append_without_copy(std::move(slice)); });
 }
 
 }  // namespace tcp
@@ -14,6 +14,7 @@
 #include "td/utils/crypto.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
@@ -147,14 +148,16 @@ size_t Transport::calc_crypto_size(size_t data_size) {
 // MTProto v2.0
 std::pair<uint32, UInt128> Transport::calc_message_key2(const AuthKey &auth_key, int X, Slice to_encrypt) {
   // msg_key_large = SHA256 (substr (auth_key, 88+x, 32) + plaintext + random_padding);
-  Sha256State state;
-  state.init();
-  state.feed(Slice(auth_key.key()).substr(88 + X, 32));
-  state.feed(to_encrypt);
+  // the auth key part is shorter than a SHA-256 block, so there is nothing to precompute, but the context is reused
+  static TD_THREAD_LOCAL Sha256State *state;  // static zero-initialized
+  init_thread_local<Sha256State>(state);
+  state->init();
+  state->feed(Slice(auth_key.key()).substr(88 + X, 32));
+  state->feed(to_encrypt);
 
   uint8 msg_key_large_raw[32];
   MutableSlice msg_key_large(msg_key_large_raw, sizeof(msg_key_large_raw));
-  state.extract(msg_key_large, true);
+  state->extract(msg_key_large);
 
   // msg_key = substr (msg_key_large, 8, 16);
   UInt128 res;
@@ -303,7 +306,7 @@ Status Transport::read_crypto(MutableSlice message, const AuthKey &auth_key, Pac
                               MutableSlice *data) {
   CryptoHeader *header = nullptr;
   CryptoPrefix *prefix = nullptr;
-  TRY_STATUS(read_crypto_impl(8, message, auth_key, &header, &prefix, data, packet_info));
+  TRY_STATUS(read_crypto_impl(packet_info->is_server ? 0 : 8, message, auth_key, &header, &prefix, data, packet_info));
   CHECK(header != nullptr);
   CHECK(prefix != nullptr);
   CHECK(packet_info != nullptr);
@@ -382,7 +385,7 @@ BufferWriter Transport::write_crypto(const Storer &storer, const AuthKey &auth_k
   header.salt = packet_info->salt;
   header.session_id = packet_info->session_id;
 
-  write_crypto_impl(0, storer, auth_key, packet_info, &header, data_size, padded_size);
+  write_crypto_impl(packet_info->is_server ? 8 : 0, storer, auth_key, packet_info, &header, data_size, padded_size);
 
   return packet;
 }
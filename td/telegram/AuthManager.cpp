@@ -1078,19 +1078,34 @@ void AuthManager::on_get_password_result(NetQueryPtr &&net_query) {
       return;
     }
     LOG(INFO) << "Have SRP ID " << wait_password_state_.srp_id_;
-    auto hash = PasswordManager::get_input_check_password(password_, wait_password_state_.current_client_salt_,
-                                                          wait_password_state_.current_server_salt_,
-                                                          wait_password_state_.srp_g_, wait_password_state_.srp_p_,
-                                                          wait_password_state_.srp_B_, wait_password_state_.srp_id_);
-
-    start_net_query(NetQueryType::CheckPassword,
-                    G()->net_query_creator().create_unauth(telegram_api::auth_checkPassword(std::move(hash))));
+    PasswordManager::get_input_check_password_async(
+        actor_id(this), password_, wait_password_state_.current_client_salt_,
+        wait_password_state_.current_server_salt_, wait_password_state_.srp_g_, wait_password_state_.srp_p_,
+        wait_password_state_.srp_B_, wait_password_state_.srp_id_,
+        PromiseCreator::lambda([actor_id = actor_id(this), query_id = query_id_](
+                                   Result<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> r_hash) mutable {
+          send_closure(actor_id, &AuthManager::on_get_check_password_hash, query_id, std::move(r_hash));
+        }));
   } else {
     update_state(State::WaitPassword);
     on_current_query_ok();
   }
 }
 
+void AuthManager::on_get_check_password_hash(uint64 query_id,
+                                             Result<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> r_hash) {
+  if (query_id != query_id_ || state_ != State::WaitPassword || !checking_password_) {
+    // the query has already been finished or replaced by another query
+    return;
+  }
+  if (r_hash.is_error()) {
+    return on_current_query_error(r_hash.move_as_error());
+  }
+
+  start_net_query(NetQueryType::CheckPassword,
+                  G()->net_query_creator().create_unauth(telegram_api::auth_checkPassword(r_hash.move_as_ok())));
+}
+
 void AuthManager::on_request_password_recovery_result(NetQueryPtr &&net_query) {
   auto r_email_address_pattern = fetch_result<telegram_api::auth_requestPasswordRecovery>(std::move(net_query));
   if (r_email_address_pattern.is_error()) {
@@ -21,6 +21,7 @@
 #include "td/telegram/Global.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/PhotoFormat.h"
+#include "td/telegram/QueryResultCache.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/TdDb.h"
 #include "td/telegram/telegram_api.h"
@@ -79,6 +80,8 @@ class GetBackgroundQuery final : public Td::ResultHandler {
 
 class GetBackgroundsQuery final : public Td::ResultHandler {
   Promise<telegram_api::object_ptr<telegram_api::account_WallPapers>> promise_;
+  string cache_key_;
+  int64 hash_ = 0;
 
  public:
   explicit GetBackgroundsQuery(Promise<telegram_api::object_ptr<telegram_api::account_WallPapers>> &&promise)
@@ -86,7 +89,9 @@ class GetBackgroundsQuery final : public Td::ResultHandler {
   }
 
   void send() {
-    send_query(G()->net_query_creator().create(telegram_api::account_getWallPapers(0)));
+    cache_key_ = QueryResultCache::get_key<telegram_api::account_getWallPapers>();
+    hash_ = QueryResultCache::get_hash(cache_key_);
+    send_query(G()->net_query_creator().create(telegram_api::account_getWallPapers(hash_)));
   }
 
   void on_result(BufferSlice packet) final {
@@ -95,7 +100,24 @@ class GetBackgroundsQuery final : public Td::ResultHandler {
       return on_error(result_ptr.move_as_error());
     }
 
-    promise_.set_value(result_ptr.move_as_ok());
+    auto wallpapers_ptr = result_ptr.move_as_ok();
+    if (wallpapers_ptr->get_id() == telegram_api::account_wallPapersNotModified::ID) {
+      if (hash_ == 0) {
+        return on_error(Status::Error(500, "Receive unexpected wallPapersNotModified"));
+      }
+      auto r_wallpapers = QueryResultCache::load_result<telegram_api::account_getWallPapers>(cache_key_, hash_);
+      if (r_wallpapers.is_error() || r_wallpapers.ok()->get_id() == telegram_api::account_wallPapersNotModified::ID) {
+        LOG(INFO) << "Failed to load cached backgrounds; reload them";
+        QueryResultCache::drop_result(cache_key_);
+        return td_->create_handler<GetBackgroundsQuery>(std::move(promise_))->send();
+      }
+      wallpapers_ptr = r_wallpapers.move_as_ok();
+    } else {
+      auto hash = static_cast<const telegram_api::account_wallPapers *>(wallpapers_ptr.get())->hash_;
+      QueryResultCache::save_result(cache_key_, hash, packet);
+    }
+
+    promise_.set_value(std::move(wallpapers_ptr));
   }
 
   void on_error(Status status) final {
@@ -494,6 +516,12 @@ void BackgroundManager::tear_down() {
   parent_.reset();
 }
 
+void BackgroundManager::store_background(BackgroundId background_id, LogEventStorerBuffer &storer) {
+  const auto *background = get_background(background_id);
+  CHECK(background != nullptr);
+  store(*background, storer);
+}
+
 void BackgroundManager::store_background(BackgroundId background_id, LogEventStorerCalcLength &storer) {
   const auto *background = get_background(background_id);
   CHECK(background != nullptr);
@@ -72,6 +72,8 @@ class BackgroundManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void store_background(BackgroundId background_id, LogEventStorerBuffer &storer);
+
   void store_background(BackgroundId background_id, LogEventStorerCalcLength &storer);
 
   void store_background(BackgroundId background_id, LogEventStorerUnsafe &storer);
@@ -81,7 +81,7 @@ td_api::object_ptr<td_api::businessOpeningHours> BusinessWorkHours::get_local_bu
   }
 
   auto offset = (td->time_zone_manager_->get_time_zone_offset(time_zone_id_) -
-                 narrow_cast<int32>(td->option_manager_->get_option_integer("utc_time_offset"))) /
+                 narrow_cast<int32>(td->option_manager_->get_option_integer(CachedOption::UtcTimeOffset))) /
                 60;
   if (offset == 0) {
     return get_business_opening_hours_object();
@@ -149,7 +149,7 @@ bool ChannelRecommendationManager::are_suitable_recommended_dialogs(
       return false;
     }
   }
-  auto is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  auto is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
   auto have_all = recommended_dialogs.dialog_ids_.size() == static_cast<size_t>(recommended_dialogs.total_count_);
   if (!have_all && is_premium) {
     return false;
@@ -8922,4 +8922,22 @@ void ChatManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &
   });
 }
 
+void ChatManager::memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const {
+  output.push_back(PSTRING() << "ChatManager: " << chats_.calc_size() << " basic groups, " << chats_full_.calc_size()
+                             << " full basic groups, " << channels_.calc_size() << " supergroups and "
+                             << channels_full_.calc_size() << " full supergroups");
+  auto chats_usage = chats_.memory_usage();
+  output.push_back(PSTRING() << "ChatManager::chats_: " << chats_usage);
+  hash_table_usage += chats_usage;
+  auto chats_full_usage = chats_full_.memory_usage();
+  output.push_back(PSTRING() << "ChatManager::chats_full_: " << chats_full_usage);
+  hash_table_usage += chats_full_usage;
+  auto channels_usage = channels_.memory_usage();
+  output.push_back(PSTRING() << "ChatManager::channels_: " << channels_usage);
+  hash_table_usage += channels_usage;
+  auto channels_full_usage = channels_full_.memory_usage();
+  output.push_back(PSTRING() << "ChatManager::channels_full_: " << channels_full_usage);
+  hash_table_usage += channels_full_usage;
+}
+
 }  // namespace td
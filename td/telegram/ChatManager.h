@@ -42,6 +42,7 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashSet.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
@@ -383,6 +384,8 @@ class ChatManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const;
+
  private:
   struct Chat {
     string title;
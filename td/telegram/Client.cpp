@@ -6,6 +6,7 @@
 //
 #include "td/telegram/Client.h"
 
+#include "td/telegram/ReadOnlyRequestExecutor.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/TdCallback.h"
 
@@ -26,6 +27,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/utf8.h"
 
 #include <algorithm>
@@ -92,7 +94,8 @@ class ClientManager::Impl final {
     return client_id;
   }
 
-  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
+  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+            double deadline) {
     if (pending_clients_.erase(client_id) != 0) {
       if (tds_.empty()) {
         CHECK(concurrent_scheduler_ == nullptr);
@@ -104,7 +107,7 @@ class ClientManager::Impl final {
       tds_[client_id] =
           concurrent_scheduler_->create_actor_unsafe<Td>(0, "Td", receiver_.create_callback(client_id), options_);
     }
-    requests_.push_back({client_id, request_id, std::move(request)});
+    requests_.push_back({client_id, request_id, std::move(request), deadline});
   }
 
   Response receive(double timeout) {
@@ -125,7 +128,7 @@ class ClientManager::Impl final {
 
         CHECK(concurrent_scheduler_ != nullptr);
         auto guard = concurrent_scheduler_->get_main_guard();
-        send_closure_later(it->second, &Td::request, request.id, std::move(request.request));
+        send_closure_later(it->second, &Td::request, request.id, std::move(request.request), request.deadline);
       }
       requests_.clear();
     }
@@ -171,6 +174,34 @@ class ClientManager::Impl final {
     return response;
   }
 
+  bool set_client_group(ClientId client_id, int32 group_id) {
+    return false;
+  }
+
+  td_api::object_ptr<td_api::Object> execute_cached(ClientId client_id,
+                                                    const td_api::object_ptr<td_api::Function> &request) {
+    return nullptr;
+  }
+
+  Response receive(int32 group_id, double timeout) {
+    if (group_id != 0) {
+      return {0, 0, nullptr};
+    }
+    return receive(timeout);
+  }
+
+  vector<Response> receive_many(int32 group_id, size_t max_count, double timeout) {
+    vector<Response> responses;
+    while (group_id == 0 && responses.size() < max_count) {
+      auto response = receive(responses.empty() ? timeout : 0.0);
+      if (response.object == nullptr) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    return responses;
+  }
+
   Impl() = default;
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
@@ -201,6 +232,7 @@ class ClientManager::Impl final {
     ClientId client_id;
     RequestId id;
     td_api::object_ptr<td_api::Function> request;
+    double deadline;
   };
   vector<Request> requests_;
   unique_ptr<ConcurrentScheduler> concurrent_scheduler_;
@@ -216,7 +248,7 @@ class Client::Impl final {
   }
 
   void send(Request request) {
-    impl_.send(client_id_, request.id, std::move(request.function));
+    impl_.send(client_id_, request.id, std::move(request.function), 0.0);
   }
 
   Response receive(double timeout) {
@@ -240,35 +272,213 @@ class MultiTd final : public Actor {
   explicit MultiTd(Td::Options options) : options_(std::move(options)) {
   }
   void create(int32 td_id, unique_ptr<TdCallback> callback) {
-    auto &td = tds_[td_id];
-    CHECK(td.empty());
+    auto &client = clients_[td_id];
+    CHECK(client.state_ == nullptr);
+    client.state_ = std::make_shared<ClientState>();
+    client.state_->callback_ = std::move(callback);
+    create_td(td_id, client);
+  }
+
+  void send(ClientManager::ClientId client_id, ClientManager::RequestId request_id,
+            td_api::object_ptr<td_api::Function> &&request, double deadline) {
+    auto it = clients_.find(client_id);
+    CHECK(it != clients_.end());
+    auto &client = it->second;
+    if (request != nullptr) {
+      switch (request->get_id()) {
+        case td_api::hibernate::ID:
+          return hibernate(client_id, client, request_id);
+        case td_api::setTdlibParameters::ID:
+          client.parameters_ = copy_tdlib_parameters(static_cast<const td_api::setTdlibParameters &>(*request));
+          break;
+        default:
+          break;
+      }
+    }
+    if (client.state_->is_hibernating_) {
+      client.pending_requests_.push_back({request_id, std::move(request), deadline});
+      return;
+    }
+    if (client.td_.empty()) {
+      resume(client_id, client);
+    }
+    send_closure(client.td_, &Td::request, request_id, std::move(request), deadline);
+  }
+
+  void close(int32 td_id) {
+    auto it = clients_.find(td_id);
+    CHECK(it != clients_.end());
+    auto &client = it->second;
+    auto &callback = client.state_->callback_;
+    if (client.hibernate_request_id_ != 0) {
+      callback->on_error(client.hibernate_request_id_, td_api::make_object<td_api::error>(500, "Request aborted"));
+    }
+    for (auto &request : client.pending_requests_) {
+      callback->on_error(request.id_, td_api::make_object<td_api::error>(500, "Request aborted"));
+    }
+    // the client's callback is destroyed after the last Td instance using it
+    clients_.erase(it);
+  }
 
-    string name = "Td";
+ private:
+  // request identifier of setTdlibParameters, which is sent to restore a hibernated client
+  static constexpr uint64 RESUME_REQUEST_ID = std::numeric_limits<uint64>::max();
+
+  // state of a client, which is shared between the client and callbacks of its Td instances
+  struct ClientState {
+    unique_ptr<TdCallback> callback_;
+    int32 authorization_state_id_ = 0;
+    bool is_hibernating_ = false;
+    bool is_resuming_ = false;
+  };
+
+  struct PendingRequest {
+    ClientManager::RequestId id_;
+    td_api::object_ptr<td_api::Function> function_;
+    double deadline_;
+  };
+
+  struct Client {
+    ActorOwn<Td> td_;  // empty if the client is hibernated
+    std::shared_ptr<ClientState> state_;
+    td_api::object_ptr<td_api::setTdlibParameters> parameters_;
+    uint64 hibernate_request_id_ = 0;
+    vector<PendingRequest> pending_requests_;  // requests received during hibernation
+  };
+
+  class Callback final : public TdCallback {
+   public:
+    Callback(ActorId<MultiTd> multi_td, int32 td_id, std::shared_ptr<ClientState> state)
+        : multi_td_(std::move(multi_td)), td_id_(td_id), state_(std::move(state)) {
+    }
+    void on_result(uint64 id, td_api::object_ptr<td_api::Object> result) final {
+      if (id == RESUME_REQUEST_ID) {
+        return;
+      }
+      if (id == 0) {
+        if (result != nullptr && result->get_id() == td_api::updateAuthorizationState::ID) {
+          auto authorization_state_id =
+              static_cast<const td_api::updateAuthorizationState *>(result.get())->authorization_state_->get_id();
+          state_->authorization_state_id_ = authorization_state_id;
+          if (state_->is_resuming_) {
+            if (authorization_state_id == td_api::authorizationStateWaitTdlibParameters::ID) {
+              return;
+            }
+            state_->is_resuming_ = false;
+            if (authorization_state_id == td_api::authorizationStateReady::ID) {
+              return;
+            }
+          }
+        }
+        if (state_->is_hibernating_) {
+          // updates about closing of the Td instance must not be sent
+          return;
+        }
+      }
+      state_->callback_->on_result(id, std::move(result));
+    }
+    void on_error(uint64 id, td_api::object_ptr<td_api::error> error) final {
+      if (id == RESUME_REQUEST_ID) {
+        LOG(ERROR) << "Failed to restore hibernated client " << td_id_ << ": " << to_string(error);
+        return;
+      }
+      state_->callback_->on_error(id, std::move(error));
+    }
+    void on_read_only_request_executor(std::shared_ptr<ReadOnlyRequestExecutor> executor) final {
+      state_->callback_->on_read_only_request_executor(std::move(executor));
+    }
+    Callback(const Callback &) = delete;
+    Callback &operator=(const Callback &) = delete;
+    Callback(Callback &&) = delete;
+    Callback &operator=(Callback &&) = delete;
+    ~Callback() final {
+      if (state_->is_hibernating_) {
+        send_closure(multi_td_, &MultiTd::on_hibernated, td_id_);
+      }
+    }
+
+   private:
+    ActorId<MultiTd> multi_td_;
+    int32 td_id_;
+    std::shared_ptr<ClientState> state_;
+  };
+
+  Td::Options options_;
+  FlatHashMap<int32, Client> clients_;
+
+  static td_api::object_ptr<td_api::setTdlibParameters> copy_tdlib_parameters(
+      const td_api::setTdlibParameters &parameters) {
+    return td_api::make_object<td_api::setTdlibParameters>(
+        parameters.use_test_dc_, parameters.database_directory_, parameters.files_directory_,
+        parameters.database_encryption_key_, parameters.use_file_database_, parameters.use_chat_info_database_,
+        parameters.use_message_database_, parameters.use_secret_chats_, parameters.api_id_, parameters.api_hash_,
+        parameters.system_language_code_, parameters.device_model_, parameters.system_version_,
+        parameters.application_version_);
+  }
+
+  void create_td(int32 td_id, Client &client) {
     auto context = std::make_shared<ActorContext>();
     auto old_context = set_context(context);
     auto old_tag = set_tag(to_string(td_id));
-    td = create_actor<Td>("Td", std::move(callback), options_);
+    client.td_ = create_actor<Td>("Td", td::make_unique<Callback>(actor_id(this), td_id, client.state_), options_);
     set_context(std::move(old_context));
     set_tag(std::move(old_tag));
   }
 
-  void send(ClientManager::ClientId client_id, ClientManager::RequestId request_id,
-            td_api::object_ptr<td_api::Function> &&request) {
-    auto &td = tds_[client_id];
-    CHECK(!td.empty());
-    send_closure(td, &Td::request, request_id, std::move(request));
+  void hibernate(int32 td_id, Client &client, uint64 request_id) {
+    auto &state = *client.state_;
+    if (state.is_hibernating_) {
+      return state.callback_->on_error(request_id,
+                                       td_api::make_object<td_api::error>(400, "The client is already hibernating"));
+    }
+    if (client.td_.empty()) {
+      return state.callback_->on_result(request_id, td_api::make_object<td_api::ok>());
+    }
+    if (client.parameters_ == nullptr || state.authorization_state_id_ != td_api::authorizationStateReady::ID) {
+      return state.callback_->on_error(
+          request_id, td_api::make_object<td_api::error>(400, "Hibernation is allowed only for authorized clients"));
+    }
+
+    LOG(INFO) << "Hibernate client " << td_id;
+    state.is_hibernating_ = true;
+    client.hibernate_request_id_ = request_id;
+    // Td flushes its databases and closes network connections before destroying its callback
+    client.td_.reset();
   }
 
-  void close(int32 td_id) {
-    size_t erased_count = tds_.erase(td_id);
-    CHECK(erased_count > 0);
+  void on_hibernated(int32 td_id) {
+    auto it = clients_.find(td_id);
+    if (it == clients_.end()) {
+      // the client was closed during hibernation
+      return;
+    }
+    auto &client = it->second;
+    CHECK(client.state_->is_hibernating_);
+    LOG(INFO) << "Client " << td_id << " was hibernated";
+    client.state_->is_hibernating_ = false;
+    client.state_->callback_->on_result(client.hibernate_request_id_, td_api::make_object<td_api::ok>());
+    client.hibernate_request_id_ = 0;
+
+    if (!client.pending_requests_.empty()) {
+      resume(td_id, client);
+      auto requests = std::move(client.pending_requests_);
+      for (auto &request : requests) {
+        send_closure(client.td_, &Td::request, request.id_, std::move(request.function_), request.deadline_);
+      }
+    }
   }
 
- private:
-  Td::Options options_;
-  FlatHashMap<int32, ActorOwn<Td>> tds_;
+  void resume(int32 td_id, Client &client) {
+    CHECK(client.parameters_ != nullptr);
+    LOG(INFO) << "Resume hibernated client " << td_id;
+    client.state_->is_resuming_ = true;
+    create_td(td_id, client);
+    send_closure(client.td_, &Td::request, RESUME_REQUEST_ID, copy_tdlib_parameters(*client.parameters_), 0.0);
+  }
 };
 
+constexpr uint64 MultiTd::RESUME_REQUEST_ID;
+
 class TdReceiver {
  public:
   TdReceiver() {
@@ -278,67 +488,184 @@ class TdReceiver {
 
   ClientManager::Response receive(double timeout, bool from_manager) {
     VLOG(td_requests) << "Begin to wait for updates with timeout " << timeout;
-    auto is_locked = receive_lock_.exchange(true);
-    if (is_locked) {
-      if (from_manager) {
-        LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
-                      "happened. Call it from a fixed thread, dedicated for updates and response processing.";
-      } else {
-        LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
-      }
-    }
+    lock_receive(from_manager);
     auto response = receive_unlocked(clamp(timeout, 0.0, 1000000.0));
-    is_locked = receive_lock_.exchange(false);
-    CHECK(is_locked);
+    unlock_receive();
     VLOG(td_requests) << "End to wait for updates, returning object " << response.request_id << ' '
                       << response.object.get();
     return response;
   }
 
+  vector<ClientManager::Response> receive_many(size_t max_count, double timeout, bool from_manager) {
+    VLOG(td_requests) << "Begin to wait for at most " << max_count << " updates with timeout " << timeout;
+    lock_receive(from_manager);
+    vector<ClientManager::Response> responses;
+    if (max_count > 0) {
+      if (output_queue_ready_cnt_ == 0) {
+        output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
+        if (output_queue_ready_cnt_ == 0 && timeout > 0) {
+          output_queue_->reader_get_event_fd().wait(static_cast<int>(min(timeout, 1000000.0) * 1000));
+          output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
+        }
+      }
+      // the queue returns all ready responses at once, so it is refilled only once per batch
+      for (int i = 0; output_queue_ready_cnt_ > 0; i++) {
+        while (output_queue_ready_cnt_ > 0 && responses.size() < max_count) {
+          output_queue_ready_cnt_--;
+          responses.push_back(on_response_received(output_queue_->reader_get_unsafe()));
+        }
+        if (i == 1 || responses.size() == max_count) {
+          break;
+        }
+        output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
+      }
+    }
+    unlock_receive();
+    VLOG(td_requests) << "End to wait for updates, returning " << responses.size() << " objects";
+    return responses;
+  }
+
   unique_ptr<TdCallback> create_callback(ClientManager::ClientId client_id) {
     class Callback final : public TdCallback {
      public:
-      explicit Callback(ClientManager::ClientId client_id, std::shared_ptr<OutputQueue> output_queue)
-          : client_id_(client_id), output_queue_(std::move(output_queue)) {
+      Callback(ClientManager::ClientId client_id, std::shared_ptr<OutputQueue> output_queue,
+               std::shared_ptr<ReadOnlyRequestExecutors> read_only_request_executors,
+               std::shared_ptr<PendingResponseCounts> pending_response_counts,
+               std::shared_ptr<std::atomic<size_t>> pending_response_count)
+          : client_id_(client_id)
+          , output_queue_(std::move(output_queue))
+          , read_only_request_executors_(std::move(read_only_request_executors))
+          , pending_response_counts_(std::move(pending_response_counts))
+          , pending_response_count_(std::move(pending_response_count)) {
       }
       void on_result(uint64 id, td_api::object_ptr<td_api::Object> result) final {
+        pending_response_count_->fetch_add(1, std::memory_order_relaxed);
         output_queue_->writer_put({client_id_, id, std::move(result)});
       }
       void on_error(uint64 id, td_api::object_ptr<td_api::error> error) final {
+        pending_response_count_->fetch_add(1, std::memory_order_relaxed);
         output_queue_->writer_put({client_id_, id, std::move(error)});
       }
+      void on_read_only_request_executor(std::shared_ptr<ReadOnlyRequestExecutor> executor) final {
+        std::lock_guard<std::mutex> guard(read_only_request_executors_->mutex_);
+        read_only_request_executors_->executors_[client_id_] = std::move(executor);
+      }
+      size_t get_pending_update_count() const final {
+        return pending_response_count_->load(std::memory_order_relaxed);
+      }
       Callback(const Callback &) = delete;
       Callback &operator=(const Callback &) = delete;
       Callback(Callback &&) = delete;
       Callback &operator=(Callback &&) = delete;
       ~Callback() final {
+        {
+          std::lock_guard<std::mutex> guard(read_only_request_executors_->mutex_);
+          read_only_request_executors_->executors_.erase(client_id_);
+        }
+        {
+          std::lock_guard<std::mutex> guard(pending_response_counts_->mutex_);
+          pending_response_counts_->counts_.erase(client_id_);
+        }
         output_queue_->writer_put({client_id_, 0, nullptr});
       }
 
      private:
       ClientManager::ClientId client_id_;
       std::shared_ptr<OutputQueue> output_queue_;
+      std::shared_ptr<ReadOnlyRequestExecutors> read_only_request_executors_;
+      std::shared_ptr<PendingResponseCounts> pending_response_counts_;
+      std::shared_ptr<std::atomic<size_t>> pending_response_count_;
     };
-    return td::make_unique<Callback>(client_id, output_queue_);
+    auto pending_response_count = std::make_shared<std::atomic<size_t>>(0);
+    {
+      std::lock_guard<std::mutex> guard(pending_response_counts_->mutex_);
+      pending_response_counts_->counts_[client_id] = pending_response_count;
+    }
+    return td::make_unique<Callback>(client_id, output_queue_, read_only_request_executors_, pending_response_counts_,
+                                     std::move(pending_response_count));
+  }
+
+  std::shared_ptr<ReadOnlyRequestExecutor> get_read_only_request_executor(ClientManager::ClientId client_id) const {
+    std::lock_guard<std::mutex> guard(read_only_request_executors_->mutex_);
+    auto it = read_only_request_executors_->executors_.find(client_id);
+    if (it == read_only_request_executors_->executors_.end()) {
+      return nullptr;
+    }
+    return it->second;
   }
 
   void add_response(ClientManager::ClientId client_id, uint64 id, td_api::object_ptr<td_api::Object> result) {
+    auto pending_response_count = get_pending_response_count(client_id);
+    if (pending_response_count != nullptr) {
+      pending_response_count->fetch_add(1, std::memory_order_relaxed);
+    }
     output_queue_->writer_put({client_id, id, std::move(result)});
   }
 
  private:
   using OutputQueue = MpscPollableQueue<ClientManager::Response>;
   std::shared_ptr<OutputQueue> output_queue_;
+  struct ReadOnlyRequestExecutors {
+    std::mutex mutex_;
+    FlatHashMap<ClientManager::ClientId, std::shared_ptr<ReadOnlyRequestExecutor>> executors_;
+  };
+  std::shared_ptr<ReadOnlyRequestExecutors> read_only_request_executors_ = std::make_shared<ReadOnlyRequestExecutors>();
+  // numbers of responses, which were put in the output queue, but weren't received yet, by client
+  struct PendingResponseCounts {
+    std::mutex mutex_;
+    FlatHashMap<ClientManager::ClientId, std::shared_ptr<std::atomic<size_t>>> counts_;
+  };
+  std::shared_ptr<PendingResponseCounts> pending_response_counts_ = std::make_shared<PendingResponseCounts>();
+  ClientManager::ClientId last_received_client_id_{0};
+  std::shared_ptr<std::atomic<size_t>> last_received_client_pending_response_count_;
   int output_queue_ready_cnt_{0};
   std::atomic<bool> receive_lock_{false};
 
+  void lock_receive(bool from_manager) {
+    auto is_locked = receive_lock_.exchange(true);
+    if (is_locked) {
+      if (from_manager) {
+        LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
+                      "happened. Call it from a fixed thread, dedicated for updates and response processing.";
+      } else {
+        LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
+      }
+    }
+  }
+
+  void unlock_receive() {
+    auto is_locked = receive_lock_.exchange(false);
+    CHECK(is_locked);
+  }
+
+  std::shared_ptr<std::atomic<size_t>> get_pending_response_count(ClientManager::ClientId client_id) const {
+    std::lock_guard<std::mutex> guard(pending_response_counts_->mutex_);
+    auto it = pending_response_counts_->counts_.find(client_id);
+    if (it == pending_response_counts_->counts_.end()) {
+      return nullptr;
+    }
+    return it->second;
+  }
+
+  ClientManager::Response on_response_received(ClientManager::Response &&response) {
+    // consecutive responses usually belong to the same client, so the mutex is rarely locked
+    if (response.client_id != last_received_client_id_ || last_received_client_pending_response_count_ == nullptr) {
+      last_received_client_id_ = response.client_id;
+      last_received_client_pending_response_count_ = get_pending_response_count(response.client_id);
+    }
+    if (last_received_client_pending_response_count_ != nullptr && response.object != nullptr) {
+      last_received_client_pending_response_count_->fetch_sub(1, std::memory_order_relaxed);
+    }
+    return std::move(response);
+  }
+
   ClientManager::Response receive_unlocked(double timeout) {
     if (output_queue_ready_cnt_ == 0) {
       output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
     }
     if (output_queue_ready_cnt_ > 0) {
       output_queue_ready_cnt_--;
-      return output_queue_->reader_get_unsafe();
+      return on_response_received(output_queue_->reader_get_unsafe());
     }
     if (timeout != 0) {
       output_queue_->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
@@ -350,10 +677,11 @@ class TdReceiver {
 
 class MultiImpl {
  public:
-  static constexpr int32 ADDITIONAL_THREAD_COUNT = 3;
+  static constexpr int32 DEFAULT_ADDITIONAL_THREAD_COUNT = 3;
 
-  explicit MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats) {
-    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(ADDITIONAL_THREAD_COUNT, 0);
+  MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats, int32 additional_thread_count,
+            uint64 thread_affinity_mask) {
+    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(additional_thread_count, thread_affinity_mask);
     concurrent_scheduler_->start();
 
     {
@@ -363,7 +691,14 @@ class MultiImpl {
       multi_td_ = create_actor<MultiTd>("MultiTd", std::move(options));
     }
 
-    scheduler_thread_ = thread([concurrent_scheduler = concurrent_scheduler_] {
+    scheduler_thread_ = thread([concurrent_scheduler = concurrent_scheduler_, thread_affinity_mask] {
+#if TD_HAVE_THREAD_AFFINITY
+      if (thread_affinity_mask != 0) {
+        thread::set_affinity_mask(this_thread::get_id(), thread_affinity_mask).ignore();
+      }
+#else
+      (void)thread_affinity_mask;
+#endif
       while (concurrent_scheduler->run_main(10)) {
       }
     });
@@ -390,9 +725,9 @@ class MultiImpl {
   }
 
   void send(ClientManager::ClientId client_id, ClientManager::RequestId request_id,
-            td_api::object_ptr<td_api::Function> &&request) {
+            td_api::object_ptr<td_api::Function> &&request, double deadline) {
     auto guard = concurrent_scheduler_->get_send_guard();
-    send_closure(multi_td_, &MultiTd::send, client_id, request_id, std::move(request));
+    send_closure(multi_td_, &MultiTd::send, client_id, request_id, std::move(request), deadline);
   }
 
   void close(ClientManager::ClientId client_id) {
@@ -401,6 +736,10 @@ class MultiImpl {
     send_closure(multi_td_, &MultiTd::close, client_id);
   }
 
+  double get_busy_time() const {
+    return concurrent_scheduler_->get_busy_time();
+  }
+
   ~MultiImpl() {
     {
       auto guard = concurrent_scheduler_->get_send_guard();
@@ -423,31 +762,74 @@ class MultiImpl {
   static std::atomic<uint32> current_id_;
 };
 
-constexpr int32 MultiImpl::ADDITIONAL_THREAD_COUNT;
+constexpr int32 MultiImpl::DEFAULT_ADDITIONAL_THREAD_COUNT;
 std::atomic<uint32> MultiImpl::current_id_{1};
 
 class MultiImplPool {
  public:
+  static bool set_thread_options(int32 instance_count, int32 additional_thread_count, bool pin_threads) {
+    if (instance_count < 0 || additional_thread_count < -1) {
+      return false;
+    }
+    if (additional_thread_count == -1) {
+      additional_thread_count = MultiImpl::DEFAULT_ADDITIONAL_THREAD_COUNT;
+    }
+    if (instance_count * get_thread_count(additional_thread_count) >= MAX_THREAD_COUNT) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(thread_options_mutex_);
+    if (are_thread_options_used_) {
+      return false;
+    }
+    global_thread_options_.instance_count = instance_count;
+    global_thread_options_.additional_thread_count = additional_thread_count;
+    global_thread_options_.pin_threads = pin_threads;
+    return true;
+  }
+
   std::shared_ptr<MultiImpl> get() {
     std::unique_lock<std::mutex> lock(mutex_);
     if (impls_.empty()) {
       init_openssl_threads();
 
-      auto max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
+      thread_options_ = get_thread_options();
+      auto instance_count = static_cast<size_t>(thread_options_.instance_count);
+      if (instance_count == 0) {
+        instance_count = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
 #if TD_OPENBSD
-      max_client_threads = td::min(max_client_threads, 4u);
+        instance_count = td::min(instance_count, static_cast<size_t>(4));
 #endif
-      impls_.resize(max_client_threads);
-      CHECK(impls_.size() * (1 + MultiImpl::ADDITIONAL_THREAD_COUNT + 1 /* IOCP */) < 128);
+        instance_count = td::min(
+            instance_count,
+            static_cast<size_t>((MAX_THREAD_COUNT - 1) / get_thread_count(thread_options_.additional_thread_count)));
+      }
+      impls_.resize(instance_count);
+      impl_loads_.resize(instance_count);
+      CHECK(impls_.size() * get_thread_count(thread_options_.additional_thread_count) < MAX_THREAD_COUNT);
 
       net_query_stats_ = std::make_shared<NetQueryStats>();
     }
-    auto &impl = *std::min_element(impls_.begin(), impls_.end(),
-                                   [](auto &a, auto &b) { return a.lock().use_count() < b.lock().use_count(); });
-    auto result = impl.lock();
+    // choose the instance with the least measured load; not yet started instances have no load at all
+    auto now = Time::now();
+    size_t best_pos = 0;
+    double best_load = 0.0;
+    std::shared_ptr<MultiImpl> result;
+    for (size_t i = 0; i < impls_.size(); i++) {
+      auto impl = impls_[i].lock();
+      auto load = impl == nullptr ? 0.0 : get_load(impl.get(), impl_loads_[i], impl.use_count(), now);
+      if (i == 0 || load < best_load) {
+        best_pos = i;
+        best_load = load;
+        result = std::move(impl);
+      }
+    }
     if (!result) {
-      result = std::make_shared<MultiImpl>(net_query_stats_);
-      impl = result;
+      auto thread_affinity_mask = get_thread_affinity_mask(best_pos, thread_options_.additional_thread_count);
+      result = std::make_shared<MultiImpl>(net_query_stats_, thread_options_.additional_thread_count,
+                                           thread_affinity_mask);
+      impls_[best_pos] = result;
+      impl_loads_[best_pos] = ImplLoad();
     }
     return result;
   }
@@ -464,6 +846,7 @@ class MultiImplPool {
       }
     }
     reset_to_empty(impls_);
+    reset_to_empty(impl_loads_);
 
     CHECK(net_query_stats_.use_count() == 1);
     CHECK(net_query_stats_->get_count() == 0);
@@ -471,11 +854,82 @@ class MultiImplPool {
   }
 
  private:
+  // the total number of threads is limited by ThreadLocalStorage
+  static constexpr size_t MAX_THREAD_COUNT = 128;
+
+  struct ThreadOptions {
+    int32 instance_count = 0;
+    int32 additional_thread_count = MultiImpl::DEFAULT_ADDITIONAL_THREAD_COUNT;
+    bool pin_threads = false;
+  };
+
+  static std::mutex thread_options_mutex_;
+  static ThreadOptions global_thread_options_;
+  static bool are_thread_options_used_;
+
+  // fraction of scheduler time, which is expected to be used by a newly added client before its load can be measured
+  static constexpr double CLIENT_LOAD = 0.01;
+  static constexpr double LOAD_UPDATE_PERIOD = 1.0;
+
+  struct ImplLoad {
+    double busy_time = 0.0;
+    double update_time = 0.0;
+    double load = 0.0;
+  };
+
   std::mutex mutex_;
   std::vector<std::weak_ptr<MultiImpl>> impls_;
+  std::vector<ImplLoad> impl_loads_;
   std::shared_ptr<NetQueryStats> net_query_stats_;
+  ThreadOptions thread_options_;
+
+  static double get_load(const MultiImpl *impl, ImplLoad &impl_load, long client_count, double now) {
+    if (now - impl_load.update_time >= LOAD_UPDATE_PERIOD) {
+      auto busy_time = impl->get_busy_time();
+      if (impl_load.update_time > 0) {
+        impl_load.load = (busy_time - impl_load.busy_time) / (now - impl_load.update_time);
+      }
+      impl_load.busy_time = busy_time;
+      impl_load.update_time = now;
+    }
+    return impl_load.load + CLIENT_LOAD * static_cast<double>(client_count);
+  }
+
+  static size_t get_thread_count(int32 additional_thread_count) {
+    return 1 + static_cast<size_t>(additional_thread_count) + 1 /* IOCP */;
+  }
+
+  static ThreadOptions get_thread_options() {
+    std::lock_guard<std::mutex> lock(thread_options_mutex_);
+    are_thread_options_used_ = true;
+    return global_thread_options_;
+  }
+
+  // each instance is bound to its own consecutive range of CPUs, so that its threads share caches
+  uint64 get_thread_affinity_mask(size_t instance_id, int32 additional_thread_count) const {
+    if (!thread_options_.pin_threads) {
+      return 0;
+    }
+    auto cpu_count = td::min(thread::hardware_concurrency(), 64u);
+    auto instance_cpu_count = static_cast<size_t>(additional_thread_count) + 1;
+    if (cpu_count <= instance_cpu_count) {
+      return 0;
+    }
+    uint64 mask = 0;
+    for (size_t i = 0; i < instance_cpu_count; i++) {
+      mask |= static_cast<uint64>(1) << ((instance_id * instance_cpu_count + i) % cpu_count);
+    }
+    return mask;
+  }
 };
 
+std::mutex MultiImplPool::thread_options_mutex_;
+MultiImplPool::ThreadOptions MultiImplPool::global_thread_options_;
+bool MultiImplPool::are_thread_options_used_ = false;
+constexpr size_t MultiImplPool::MAX_THREAD_COUNT;
+constexpr double MultiImplPool::CLIENT_LOAD;
+constexpr double MultiImplPool::LOAD_UPDATE_PERIOD;
+
 class ClientManager::Impl final {
  public:
   ClientId create_client_id() {
@@ -483,12 +937,24 @@ class ClientManager::Impl final {
     LOG(INFO) << "Created managed client " << client_id;
     {
       auto lock = impls_mutex_.lock_write().move_as_ok();
-      impls_[client_id];  // create empty MultiImplInfo
+      impls_[client_id].receiver = &receiver_;
     }
     return client_id;
   }
 
-  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
+  bool set_client_group(ClientId client_id, int32 group_id) {
+    auto receiver = get_group_receiver(group_id);
+    auto lock = impls_mutex_.lock_write().move_as_ok();
+    auto it = impls_.find(client_id);
+    if (it == impls_.end() || it->second.impl != nullptr || it->second.is_closed) {
+      return false;
+    }
+    it->second.receiver = receiver;
+    return true;
+  }
+
+  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+            double deadline) {
     auto lock = impls_mutex_.lock_read().move_as_ok();
     if (!MultiImpl::is_valid_client_id(client_id)) {
       receiver_.add_response(client_id, request_id,
@@ -504,7 +970,7 @@ class ClientManager::Impl final {
       it = impls_.find(client_id);
       if (it != impls_.end() && it->second.impl == nullptr) {
         it->second.impl = pool_.get();
-        it->second.impl->create(client_id, receiver_.create_callback(client_id));
+        it->second.impl->create(client_id, it->second.receiver->create_callback(client_id));
       }
       write_lock.reset();
 
@@ -512,14 +978,50 @@ class ClientManager::Impl final {
       it = impls_.find(client_id);
     }
     if (it == impls_.end() || it->second.is_closed) {
-      receiver_.add_response(client_id, request_id, td_api::make_object<td_api::error>(500, "Request aborted"));
+      auto receiver = it == impls_.end() ? &receiver_ : it->second.receiver;
+      receiver->add_response(client_id, request_id, td_api::make_object<td_api::error>(500, "Request aborted"));
       return;
     }
-    it->second.impl->send(client_id, request_id, std::move(request));
+    it->second.impl->send(client_id, request_id, std::move(request), deadline);
   }
 
-  Response receive(double timeout) {
-    auto response = receiver_.receive(timeout, true);
+  td_api::object_ptr<td_api::Object> execute_cached(ClientId client_id,
+                                                    const td_api::object_ptr<td_api::Function> &request) {
+    if (request == nullptr) {
+      return nullptr;
+    }
+    std::shared_ptr<ReadOnlyRequestExecutor> executor;
+    {
+      auto lock = impls_mutex_.lock_read().move_as_ok();
+      auto it = impls_.find(client_id);
+      if (it == impls_.end() || it->second.is_closed) {
+        return nullptr;
+      }
+      executor = it->second.receiver->get_read_only_request_executor(client_id);
+    }
+    if (executor == nullptr) {
+      return nullptr;
+    }
+    return executor->execute(*request);
+  }
+
+  Response receive(int32 group_id, double timeout) {
+    auto response = get_group_receiver(group_id)->receive(timeout, true);
+    process_response(response);
+    return response;
+  }
+
+  vector<Response> receive_many(int32 group_id, size_t max_count, double timeout) {
+    auto responses = get_group_receiver(group_id)->receive_many(max_count, timeout, true);
+    for (auto &response : responses) {
+      process_response(response);
+    }
+    // responses about released clients must not be returned
+    td::remove_if(responses, [](const Response &response) { return response.object == nullptr; });
+    return responses;
+  }
+
+  void process_response(Response &response) {
     if (response.request_id == 0 && response.object != nullptr &&
         response.object->get_id() == td_api::updateAuthorizationState::ID &&
         static_cast<const td_api::updateAuthorizationState *>(response.object.get())->authorization_state_->get_id() ==
@@ -546,7 +1048,6 @@ class ClientManager::Impl final {
         pool_.try_clear();
       }
     }
-    return response;
   }
 
   void close_impl(ClientId client_id) {
@@ -555,7 +1056,7 @@ class ClientManager::Impl final {
     if (!it->second.is_closed) {
       it->second.is_closed = true;
       if (it->second.impl == nullptr) {
-        receiver_.add_response(client_id, 0, nullptr);
+        it->second.receiver->add_response(client_id, 0, nullptr);
       } else {
         it->second.impl->close(client_id);
       }
@@ -575,8 +1076,15 @@ class ClientManager::Impl final {
     for (auto &it : impls_) {
       close_impl(it.first);
     }
+    vector<int32> group_ids;
+    for (auto &it : group_receivers_) {
+      group_ids.push_back(it.first);
+    }
     while (!impls_.empty() && !ExitGuard::is_exited()) {
-      receive(0.1);
+      for (auto group_id : group_ids) {
+        receive(group_id, 0.0);
+      }
+      receive(0, 0.1);
     }
   }
 
@@ -585,10 +1093,31 @@ class ClientManager::Impl final {
   RwMutex impls_mutex_;
   struct MultiImplInfo {
     std::shared_ptr<MultiImpl> impl;
+    TdReceiver *receiver = nullptr;
     bool is_closed = false;
   };
   FlatHashMap<ClientId, MultiImplInfo> impls_;
-  TdReceiver receiver_;
+  TdReceiver receiver_;  // for the group 0
+  FlatHashMap<int32, unique_ptr<TdReceiver>> group_receivers_;  // receivers are never destroyed before the manager
+
+  TdReceiver *get_group_receiver(int32 group_id) {
+    if (group_id == 0) {
+      return &receiver_;
+    }
+    {
+      auto lock = impls_mutex_.lock_read().move_as_ok();
+      auto it = group_receivers_.find(group_id);
+      if (it != group_receivers_.end()) {
+        return it->second.get();
+      }
+    }
+    auto lock = impls_mutex_.lock_write().move_as_ok();
+    auto &receiver = group_receivers_[group_id];
+    if (receiver == nullptr) {
+      receiver = make_unique<TdReceiver>();
+    }
+    return receiver.get();
+  }
 };
 
 class Client::Impl final {
@@ -607,7 +1136,7 @@ class Client::Impl final {
       return;
     }
 
-    multi_impl_->send(td_id_, request.id, std::move(request.function));
+    multi_impl_->send(td_id_, request.id, std::move(request.function), 0.0);
   }
 
   Response receive(double timeout) {
@@ -672,17 +1201,44 @@ ClientManager::ClientId ClientManager::create_client_id() {
 }
 
 void ClientManager::send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
-  impl_->send(client_id, request_id, std::move(request));
+  impl_->send(client_id, request_id, std::move(request), 0.0);
+}
+
+void ClientManager::send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request,
+                         double timeout) {
+  impl_->send(client_id, request_id, std::move(request), timeout > 0 ? Time::now() + timeout : 0.0);
 }
 
 ClientManager::Response ClientManager::receive(double timeout) {
-  return impl_->receive(timeout);
+  return impl_->receive(0, timeout);
+}
+
+std::vector<ClientManager::Response> ClientManager::receive_many(std::size_t max_count, double timeout) {
+  return impl_->receive_many(0, max_count, timeout);
+}
+
+bool ClientManager::set_client_group(ClientId client_id, std::int32_t group_id) {
+  return impl_->set_client_group(client_id, group_id);
+}
+
+ClientManager::Response ClientManager::receive(std::int32_t group_id, double timeout) {
+  return impl_->receive(group_id, timeout);
+}
+
+std::vector<ClientManager::Response> ClientManager::receive_many(std::int32_t group_id, std::size_t max_count,
+                                                                 double timeout) {
+  return impl_->receive_many(group_id, max_count, timeout);
 }
 
 td_api::object_ptr<td_api::Object> ClientManager::execute(td_api::object_ptr<td_api::Function> &&request) {
   return Td::static_request(std::move(request));
 }
 
+td_api::object_ptr<td_api::Object> ClientManager::execute_cached(
+    ClientId client_id, const td_api::object_ptr<td_api::Function> &request) {
+  return impl_->execute_cached(client_id, request);
+}
+
 static std::atomic<ClientManager::LogMessageCallbackPtr> log_message_callback;
 
 static void log_message_callback_wrapper(int verbosity_level, CSlice message) {
@@ -703,6 +1259,14 @@ static void log_message_callback_wrapper(int verbosity_level, CSlice message) {
   }
 }
 
+bool ClientManager::set_thread_options(int instance_count, int additional_thread_count, bool pin_threads) {
+#if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
+  return false;
+#else
+  return MultiImplPool::set_thread_options(instance_count, additional_thread_count, pin_threads);
+#endif
+}
+
 void ClientManager::set_log_message_callback(int max_verbosity_level, LogMessageCallbackPtr callback) {
   if (callback == nullptr) {
     ::td::set_log_message_callback(max_verbosity_level, nullptr);
@@ -11,8 +11,10 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace td {
 
@@ -86,6 +88,18 @@ class ClientManager final {
    */
   void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request);
 
+  /**
+   * Sends request to TDLib, which must be answered within the specified timeout. May be called from any thread.
+   * If TDLib doesn't start to process the request before the timeout expires, or network queries sent for the request
+   * can't be sent before the timeout expires, then the request fails with the error 408 "Request timeout expired".
+   * \param[in] client_id TDLib client instance identifier.
+   * \param[in] request_id Request identifier. Must be non-zero.
+   * \param[in] request Request to TDLib.
+   * \param[in] timeout The maximum number of seconds allowed for the request to wait in queues; pass 0 to disable the
+   *                    timeout.
+   */
+  void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request, double timeout);
+
   /**
    * A response to a request, or an incoming update from TDLib.
    */
@@ -115,6 +129,53 @@ class ClientManager final {
    */
   Response receive(double timeout);
 
+  /**
+   * Receives up to max_count incoming updates and responses to requests from TDLib at once. Waits for new data only if
+   * there are no pending updates and responses. May be called from any thread, but must not be called simultaneously
+   * from two different threads, or simultaneously with ClientManager::receive.
+   * \param[in] max_count The maximum number of returned responses.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \return Incoming updates and responses to requests in the order they were received. The objects in the responses
+   *         are never nullptr. The vector is empty if the timeout expires.
+   */
+  std::vector<Response> receive_many(std::size_t max_count, double timeout);
+
+  /**
+   * Assigns a TDLib instance to a group of instances with a separate queue of incoming updates and responses.
+   * Updates and responses of instances from the group are returned only by the receive variants with the same group_id.
+   * Queues of different groups can be processed simultaneously from different threads.
+   * The group can be changed only before the first request is sent to the instance.
+   * By default, all instances belong to the group 0, whose updates are returned by ClientManager::receive.
+   * Responses to requests sent to invalid or already destroyed instances are always returned in the group 0.
+   * \param[in] client_id TDLib client instance identifier.
+   * \param[in] group_id Identifier of the group, to which the instance will belong. Pass the client_id to use
+   *                     a separate queue for the instance.
+   * \return True, if the group was changed. The group can't be changed if separate queues aren't supported.
+   */
+  bool set_client_group(ClientId client_id, std::int32_t group_id);
+
+  /**
+   * Receives incoming updates and responses to requests for TDLib instances from the specified group. May be called
+   * from any thread, but must not be called simultaneously for the same group from two different threads.
+   * \param[in] group_id Identifier of the group.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \return An incoming update or response to a request. The object returned in the response may be a nullptr
+   *         if the timeout expires.
+   */
+  Response receive(std::int32_t group_id, double timeout);
+
+  /**
+   * Receives up to max_count incoming updates and responses to requests for TDLib instances from the specified group.
+   * May be called from any thread, but must not be called simultaneously for the same group from two different
+   * threads.
+   * \param[in] group_id Identifier of the group.
+   * \param[in] max_count The maximum number of returned responses.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \return Incoming updates and responses to requests in the order they were received. The objects in the responses
+   *         are never nullptr. The vector is empty if the timeout expires.
+   */
+  std::vector<Response> receive_many(std::int32_t group_id, std::size_t max_count, double timeout);
+
   /**
    * Synchronously executes a TDLib request.
    * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
@@ -123,6 +184,34 @@ class ClientManager final {
    */
   static td_api::object_ptr<td_api::Object> execute(td_api::object_ptr<td_api::Function> &&request);
 
+  /**
+   * Synchronously executes a read-only TDLib request for a TDLib client using its cached state.
+   * The request is executed from the calling thread without waiting for the client instance, therefore the result
+   * may not reflect changes made by requests sent before. Currently, only getOption is supported for options,
+   * which values are stored by the client instance and aren't computed upon request.
+   * \param[in] client_id TDLib client identifier.
+   * \param[in] request Request to the TDLib.
+   * \return The request response or nullptr if the request can't be executed synchronously. In the latter case
+   *         the request must be sent using ClientManager::send.
+   */
+  td_api::object_ptr<td_api::Object> execute_cached(ClientId client_id,
+                                                    const td_api::object_ptr<td_api::Function> &request);
+
+  /**
+   * Changes the number of threads, which are used to run TDLib instances, and their CPU affinity.
+   * The options can be changed only before the first TDLib instance is created.
+   * The total number of threads must be less than 128.
+   *
+   * \param[in] instance_count The number of thread groups between which TDLib instances are distributed.
+   *                           Pass 0 to choose the number automatically based on the number of CPUs.
+   * \param[in] additional_thread_count The number of additional threads in each group, which are used for database and
+   *                                    network operations. Pass -1 to use the default number.
+   * \param[in] pin_threads Pass true to bind threads of each group to a separate range of CPUs.
+   *                        Only the first 64 CPUs are used.
+   * \return True, if the options were changed.
+   */
+  static bool set_thread_options(int instance_count, int additional_thread_count, bool pin_threads);
+
   /**
    * A type of callback function that will be called when a message is added to the internal TDLib log.
    *
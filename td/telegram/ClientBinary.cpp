@@ -0,0 +1,98 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/ClientBinary.h"
+
+#include "td/telegram/Client.h"
+#include "td/telegram/td_api.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+#include <utility>
+
+namespace td {
+
+static td_api::object_ptr<td_api::Function> get_return_error_function(Slice error_message) {
+  auto error = td_api::make_object<td_api::error>(400, error_message.str());
+  return td_api::make_object<td_api::testReturnError>(std::move(error));
+}
+
+static td_api::object_ptr<td_api::Function> to_request(Slice request) {
+  BufferSlice aligned_request;
+  if (!is_aligned_pointer<4>(request.begin())) {
+    aligned_request = BufferSlice(request);
+    request = aligned_request.as_slice();
+  }
+
+  TlParser parser(request);
+  auto function = td_api::Function::fetch(parser);
+  parser.fetch_end();
+  auto status = parser.get_status();
+  if (status.is_error()) {
+    return get_return_error_function(PSLICE() << "Failed to parse TL-serialized request: " << status.message());
+  }
+  CHECK(function != nullptr);
+  return function;
+}
+
+static string from_response(const td_api::Object &object) {
+  TlStorerCalcLength storer_calc_length;
+  storer_calc_length.store_binary(object.get_id());
+  object.store(storer_calc_length);
+
+  string result(storer_calc_length.get_length(), '\0');
+  TlStorerUnsafe storer_unsafe(MutableSlice(result).ubegin());
+  storer_unsafe.store_binary(object.get_id());
+  object.store(storer_unsafe);
+  CHECK(storer_unsafe.get_buf() == MutableSlice(result).uend());
+  return result;
+}
+
+static TD_THREAD_LOCAL string *current_output;
+
+static Slice store_string(string str) {
+  init_thread_local<string>(current_output);
+  *current_output = std::move(str);
+  return *current_output;
+}
+
+static ClientManager *get_manager() {
+  return ClientManager::get_manager_singleton();
+}
+
+int binary_create_client_id() {
+  return static_cast<int>(get_manager()->create_client_id());
+}
+
+void binary_send(int client_id, uint64 request_id, Slice request) {
+  get_manager()->send(client_id, request_id, to_request(request));
+}
+
+Slice binary_receive(double timeout, int &client_id, uint64 &request_id) {
+  auto response = get_manager()->receive(timeout);
+  if (!response.object) {
+    client_id = 0;
+    request_id = 0;
+    return Slice();
+  }
+
+  client_id = response.client_id;
+  request_id = response.request_id;
+  return store_string(from_response(*response.object));
+}
+
+Slice binary_execute(Slice request) {
+  return store_string(from_response(*ClientManager::execute(to_request(request))));
+}
+
+}  // namespace td
@@ -9,6 +9,8 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api_json.h"
 
+#include "td/tl/tl_json.h"
+
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/JsonBuilder.h"
@@ -26,8 +28,25 @@ static td_api::object_ptr<td_api::Function> get_return_error_function(Slice erro
   return td_api::make_object<td_api::testReturnError>(std::move(error));
 }
 
-static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice request) {
+struct JsonRequest {
+  td_api::object_ptr<td_api::Function> function;
+  string extra;
+  double timeout = 0.0;
+};
+
+static JsonRequest to_request(Slice request) {
   auto request_str = request.str();
+  {
+    td_api::object_ptr<td_api::Function> func;
+    string extra;
+    double timeout = 0.0;
+    if (td_api::from_json(func, request_str, &extra, &timeout).is_ok()) {
+      return {std::move(func), std::move(extra), timeout};
+    }
+  }
+
+  // the request is invalid; parse it once more through JsonValue to return a precise error
+  request_str = request.str();
   auto r_json_value = json_decode(request_str);
   if (r_json_value.is_error()) {
     return {get_return_error_function(PSLICE()
@@ -44,13 +63,23 @@ static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice
     extra = json_encode<string>(json_value.get_object().extract_field("@extra"));
   }
 
+  double timeout = 0.0;
+  if (json_value.get_object().has_field("@timeout")) {
+    auto r_timeout = get_json_request_timeout(json_value.get_object().extract_field("@timeout"));
+    if (r_timeout.is_error()) {
+      return {get_return_error_function(PSLICE() << "Failed to parse request: " << r_timeout.error().message()),
+              std::move(extra)};
+    }
+    timeout = r_timeout.ok();
+  }
+
   td_api::object_ptr<td_api::Function> func;
   auto status = from_json(func, std::move(json_value));
   if (status.is_error()) {
     return {get_return_error_function(PSLICE() << "Failed to parse JSON object as TDLib request: " << status.message()),
             std::move(extra)};
   }
-  return std::make_pair(std::move(func), std::move(extra));
+  return {std::move(func), std::move(extra), timeout};
 }
 
 static string from_response(const td_api::Object &object, const string &extra, int client_id) {
@@ -82,11 +111,11 @@ static const char *store_string(string str) {
 void ClientJson::send(Slice request) {
   auto parsed_request = to_request(request);
   std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
-  if (!parsed_request.second.empty()) {
+  if (!parsed_request.extra.empty()) {
     std::lock_guard<std::mutex> guard(mutex_);
-    extra_[extra_id] = std::move(parsed_request.second);
+    extra_[extra_id] = std::move(parsed_request.extra);
   }
-  client_.send(Client::Request{extra_id, std::move(parsed_request.first)});
+  client_.send(Client::Request{extra_id, std::move(parsed_request.function)});
 }
 
 const char *ClientJson::receive(double timeout) {
@@ -109,8 +138,8 @@ const char *ClientJson::receive(double timeout) {
 
 const char *ClientJson::execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(from_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object,
-                                    parsed_request.second, 0));
+  return store_string(from_response(*Client::execute(Client::Request{0, std::move(parsed_request.function)}).object,
+                                    parsed_request.extra, 0));
 }
 
 static ClientManager *get_manager() {
@@ -128,11 +157,24 @@ int json_create_client_id() {
 void json_send(int client_id, Slice request) {
   auto parsed_request = to_request(request);
   auto request_id = extra_id.fetch_add(1, std::memory_order_relaxed);
-  if (!parsed_request.second.empty()) {
+  if (!parsed_request.extra.empty()) {
     std::lock_guard<std::mutex> guard(extra_mutex);
-    extra[request_id] = std::move(parsed_request.second);
+    extra[request_id] = std::move(parsed_request.extra);
+  }
+  get_manager()->send(client_id, request_id, std::move(parsed_request.function), parsed_request.timeout);
+}
+
+static string extract_extra(ClientManager::RequestId request_id) {
+  string extra_str;
+  if (request_id != 0) {
+    std::lock_guard<std::mutex> guard(extra_mutex);
+    auto it = extra.find(request_id);
+    if (it != extra.end()) {
+      extra_str = std::move(it->second);
+      extra.erase(it);
+    }
   }
-  get_manager()->send(client_id, request_id, std::move(parsed_request.first));
+  return extra_str;
 }
 
 const char *json_receive(double timeout) {
@@ -141,22 +183,33 @@ const char *json_receive(double timeout) {
     return nullptr;
   }
 
-  string extra_str;
-  if (response.request_id != 0) {
-    std::lock_guard<std::mutex> guard(extra_mutex);
-    auto it = extra.find(response.request_id);
-    if (it != extra.end()) {
-      extra_str = std::move(it->second);
-      extra.erase(it);
+  return store_string(from_response(*response.object, extract_extra(response.request_id), response.client_id));
+}
+
+const char *json_receive_batch(int max_count, double timeout) {
+  if (max_count <= 0) {
+    return nullptr;
+  }
+  auto responses = get_manager()->receive_many(static_cast<size_t>(max_count), timeout);
+  if (responses.empty()) {
+    return nullptr;
+  }
+
+  string result = "[";
+  for (auto &response : responses) {
+    if (result.size() > 1) {
+      result += ',';
     }
+    result += from_response(*response.object, extract_extra(response.request_id), response.client_id);
   }
-  return store_string(from_response(*response.object, extra_str, response.client_id));
+  result += ']';
+  return store_string(std::move(result));
 }
 
 const char *json_execute(Slice request) {
   auto parsed_request = to_request(request);
   return store_string(
-      from_response(*ClientManager::execute(std::move(parsed_request.first)), parsed_request.second, 0));
+      from_response(*ClientManager::execute(std::move(parsed_request.function)), parsed_request.extra, 0));
 }
 
 }  // namespace td
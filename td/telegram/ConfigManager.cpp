@@ -787,7 +787,7 @@ class ConfigRecoverer final : public Actor {
     }
     if (Session::is_high_loaded()) {
       VLOG(config_recoverer) << "Skip config recoverer under high load";
-      set_timeout_in(Random::fast(200, 300));
+      set_lazy_timeout_in(Random::fast(200, 300));
       return;
     }
 
@@ -846,7 +846,7 @@ class ConfigRecoverer final : public Actor {
             return get_simple_config_mozilla_dns;
         }
       }();
-      simple_config_query_ = get_simple_config(std::move(promise), G()->get_option_boolean("prefer_ipv6"),
+      simple_config_query_ = get_simple_config(std::move(promise), G()->get_option_boolean(CachedOption::PreferIpv6),
                                                G()->get_option_string("dc_txt_domain_name"), G()->is_test_dc(),
                                                G()->get_gc_scheduler_id());
       simple_config_turn_++;
@@ -949,7 +949,7 @@ void ConfigManager::start_up() {
     request_config(false);
   } else {
     expire_time_ = expire_time;
-    set_timeout_in(expire_time_.in());
+    set_lazy_timeout_in(expire_time_.in());
   }
 
   auto log_event_string = G()->td_db()->get_binlog_pmc()->get(get_suggested_actions_database_key());
@@ -1265,7 +1265,7 @@ void ConfigManager::on_result(NetQueryPtr net_query) {
     if (!G()->close_flag()) {
       LOG(WARNING) << "Failed to get config: " << r_config.error();
       expire_time_ = Timestamp::in(60.0);  // try again in a minute
-      set_timeout_in(expire_time_.in());
+      set_lazy_timeout_in(expire_time_.in());
     }
     fail_promises(reget_config_queries_, r_config.move_as_error());
   } else {
@@ -9,10 +9,29 @@
 #include "td/telegram/Global.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 
+#include "td/utils/logging.h"
+
+#include <mutex>
+
 namespace td {
 
+namespace {
+
+struct AdaptiveDelays {
+  std::mutex mutex;
+  FlatHashMap<int32, double> delays;  // tl_constructor -> delay
+};
+
+AdaptiveDelays &get_adaptive_delays() {
+  static AdaptiveDelays adaptive_delays;
+  return adaptive_delays;
+}
+
+}  // namespace
+
 void DelayDispatcher::send_with_callback(NetQueryPtr query, ActorShared<NetQueryCallback> callback) {
-  send_with_callback_and_delay(std::move(query), std::move(callback), default_delay_);
+  auto delay = is_adaptive_ ? get_adaptive_delay(query->tl_constructor()) : default_delay_;
+  send_with_callback_and_delay(std::move(query), std::move(callback), delay);
 }
 
 void DelayDispatcher::send_with_callback_and_delay(NetQueryPtr query, ActorShared<NetQueryCallback> callback,
@@ -33,7 +52,13 @@ void DelayDispatcher::loop() {
 
   auto query = std::move(queue_.front());
   queue_.pop();
-  G()->net_query_dispatcher().dispatch_with_callback(std::move(query.net_query), std::move(query.callback));
+  if (is_adaptive_) {
+    auto sent_query_id = ++last_sent_query_id_;
+    sent_queries_[sent_query_id] = {std::move(query.callback), query.net_query->tl_constructor()};
+    G()->net_query_dispatcher().dispatch_with_callback(std::move(query.net_query), actor_shared(this, sent_query_id));
+  } else {
+    G()->net_query_dispatcher().dispatch_with_callback(std::move(query.net_query), std::move(query.callback));
+  }
 
   wakeup_at_ = Timestamp::in(query.delay);
 
@@ -44,6 +69,44 @@ void DelayDispatcher::loop() {
   set_timeout_at(wakeup_at_.at());
 }
 
+double DelayDispatcher::get_adaptive_delay(int32 tl_constructor) const {
+  auto &adaptive_delays = get_adaptive_delays();
+  std::lock_guard<std::mutex> guard(adaptive_delays.mutex);
+  auto it = adaptive_delays.delays.find(tl_constructor);
+  if (it == adaptive_delays.delays.end()) {
+    return default_delay_;
+  }
+  return clamp(it->second, min_delay_, max_delay_);
+}
+
+void DelayDispatcher::update_adaptive_delay(int32 tl_constructor, bool is_flood_wait) const {
+  auto &adaptive_delays = get_adaptive_delays();
+  std::lock_guard<std::mutex> guard(adaptive_delays.mutex);
+  auto &delay = adaptive_delays.delays[tl_constructor];
+  if (delay == 0.0) {
+    delay = default_delay_;
+  }
+  if (is_flood_wait) {
+    delay = min(delay * 2, max_delay_);
+    LOG(INFO) << "Increase delay for queries " << tl_constructor << " to " << delay;
+  } else {
+    delay = max(delay - min_delay_, min_delay_);
+  }
+}
+
+void DelayDispatcher::on_result(NetQueryPtr query) {
+  auto it = sent_queries_.find(get_link_token());
+  CHECK(it != sent_queries_.end());
+  auto sent_query = std::move(it->second);
+  sent_queries_.erase(it);
+
+  bool is_flood_wait = query->total_timeout_ > 0 || (query->is_error() && query->error().code() == 429);
+  if (is_flood_wait || query->is_ok()) {
+    update_adaptive_delay(sent_query.tl_constructor, is_flood_wait);
+  }
+  send_closure(std::move(sent_query.callback), &NetQueryCallback::on_result, std::move(query));
+}
+
 void DelayDispatcher::close_silent() {
   while (!queue_.empty()) {
     auto query = std::move(queue_.front());
@@ -60,6 +123,7 @@ void DelayDispatcher::tear_down() {
     query.net_query->set_error(Global::request_aborted_error());
     send_closure(std::move(query.callback), &NetQueryCallback::on_result, std::move(query.net_query));
   }
+  sent_queries_.clear();
   parent_.reset();
 }
 
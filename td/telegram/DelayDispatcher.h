@@ -10,18 +10,31 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Time.h"
 
 #include <queue>
 
 namespace td {
 
-class DelayDispatcher final : public Actor {
+class DelayDispatcher final : public NetQueryCallback {
  public:
   DelayDispatcher(double default_delay, ActorShared<> parent)
       : default_delay_(default_delay), parent_(std::move(parent)) {
   }
 
+  // the delay after queries sent by send_with_callback is adjusted using their results: it is decreased by min_delay
+  // after each successful query and is doubled up to max_delay after each query, which was delayed because of
+  // FLOOD_WAIT; the learned delay is shared by all adaptive dispatchers and is reused for next queries of the method
+  DelayDispatcher(double min_delay, double initial_delay, double max_delay, ActorShared<> parent)
+      : default_delay_(initial_delay)
+      , min_delay_(min_delay)
+      , max_delay_(max_delay)
+      , is_adaptive_(true)
+      , parent_(std::move(parent)) {
+  }
+
   void send_with_callback(NetQueryPtr query, ActorShared<NetQueryCallback> callback);
   void send_with_callback_and_delay(NetQueryPtr query, ActorShared<NetQueryCallback> callback, double delay);
 
@@ -36,8 +49,24 @@ class DelayDispatcher final : public Actor {
   std::queue<Query> queue_;
   Timestamp wakeup_at_;
   double default_delay_;
+  double min_delay_ = 0.0;
+  double max_delay_ = 0.0;
+  bool is_adaptive_ = false;
   ActorShared<> parent_;
 
+  struct SentQuery {
+    ActorShared<NetQueryCallback> callback;
+    int32 tl_constructor;
+  };
+  FlatHashMap<uint64, SentQuery> sent_queries_;
+  uint64 last_sent_query_id_ = 0;
+
+  double get_adaptive_delay(int32 tl_constructor) const;
+
+  void update_adaptive_delay(int32 tl_constructor, bool is_flood_wait) const;
+
+  void on_result(NetQueryPtr query) final;
+
   void loop() final;
   void tear_down() final;
 };
@@ -33,11 +33,21 @@ int DhCache::is_good_prime(Slice prime_str) const {
     return 1;
   }
 
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = checked_primes_.find(prime_str.str());
+    if (it != checked_primes_.end()) {
+      return it->second ? 1 : 0;
+    }
+  }
+
   string value = G()->td_db()->get_binlog_pmc()->get(good_prime_key(prime_str));
   if (value == "good") {
+    add_checked_prime(prime_str, true);
     return 1;
   }
   if (value == "bad") {
+    add_checked_prime(prime_str, false);
     return 0;
   }
   CHECK(value.empty());
@@ -45,11 +55,18 @@ int DhCache::is_good_prime(Slice prime_str) const {
 }
 
 void DhCache::add_good_prime(Slice prime_str) const {
+  add_checked_prime(prime_str, true);
   G()->td_db()->get_binlog_pmc()->set(good_prime_key(prime_str), "good");
 }
 
 void DhCache::add_bad_prime(Slice prime_str) const {
+  add_checked_prime(prime_str, false);
   G()->td_db()->get_binlog_pmc()->set(good_prime_key(prime_str), "bad");
 }
 
+void DhCache::add_checked_prime(Slice prime_str, bool is_good) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  checked_primes_[prime_str.str()] = is_good;
+}
+
 }  // namespace td
@@ -8,10 +8,16 @@
 
 #include "td/mtproto/DhCallback.h"
 
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Slice.h"
 
+#include <mutex>
+
 namespace td {
 
+// results of prime checks are stored in the binlog of the current client and in memory, where they are shared
+// by all clients in the process
 class DhCache final : public mtproto::DhCallback {
  public:
   int is_good_prime(Slice prime_str) const final;
@@ -22,5 +28,11 @@ class DhCache final : public mtproto::DhCallback {
     static DhCache res;
     return &res;
   }
+
+ private:
+  mutable std::mutex mutex_;
+  mutable FlatHashMap<string, bool> checked_primes_;
+
+  void add_checked_prime(Slice prime_str, bool is_good) const;
 };
 }  // namespace td
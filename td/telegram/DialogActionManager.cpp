@@ -14,6 +14,7 @@
 #include "td/telegram/MessageSender.h"
 #include "td/telegram/MessagesManager.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/OptionManager.h"
 #include "td/telegram/SecretChatsManager.h"
 #include "td/telegram/ServerMessageId.h"
 #include "td/telegram/StickersManager.h"
@@ -235,6 +236,7 @@ void DialogActionManager::on_dialog_action(DialogId dialog_id, MessageId top_thr
     active_actions.erase(it);
     if (active_actions.empty()) {
       active_dialog_actions_.erase(dialog_id);
+      added_dialog_action_counts_.erase(dialog_id);
       LOG(DEBUG) << "Cancel action timeout in " << dialog_id;
       active_dialog_action_timeout_.cancel_timeout(dialog_id.get());
     }
@@ -254,6 +256,13 @@ void DialogActionManager::on_dialog_action(DialogId dialog_id, MessageId top_thr
       prev_top_thread_message_id = it->top_thread_message_id;
       prev_action = it->action;
       active_actions.erase(it);
+    } else if (is_dialog_action_flood(dialog_id, active_actions.size())) {
+      LOG(DEBUG) << "Ignore action of " << typing_dialog_id << " in " << dialog_id << " because of flood";
+      if (active_actions.empty()) {
+        active_dialog_actions_.erase(dialog_id);
+        added_dialog_action_counts_.erase(dialog_id);
+      }
+      return;
     } else {
       LOG(DEBUG) << "Add action of " << typing_dialog_id << " in " << dialog_id;
     }
@@ -277,9 +286,31 @@ void DialogActionManager::on_dialog_action(DialogId dialog_id, MessageId top_thr
   send_update_chat_action(dialog_id, top_thread_message_id, typing_dialog_id, action);
 }
 
+bool DialogActionManager::is_dialog_action_flood(DialogId dialog_id, size_t active_action_count) {
+  if (active_action_count >= MAX_ACTIVE_DIALOG_ACTIONS) {
+    return true;
+  }
+
+  auto max_count = td_->option_manager_->get_option_integer("chat_action_update_count_max");
+  if (max_count <= 0) {
+    return false;
+  }
+  auto &added_count = added_dialog_action_counts_[dialog_id];
+  auto now = Time::now();
+  if (added_count.period_start_time + 1.0 <= now) {
+    added_count.period_start_time = now;
+    added_count.count = 0;
+  }
+  if (added_count.count >= max_count) {
+    return true;
+  }
+  added_count.count++;
+  return false;
+}
+
 void DialogActionManager::send_update_chat_action(DialogId dialog_id, MessageId top_thread_message_id,
                                                   DialogId typing_dialog_id, const DialogAction &action) {
-  if (td_->auth_manager_->is_bot()) {
+  if (td_->auth_manager_->is_bot() || td_->is_update_ignored(td_api::updateChatAction::ID)) {
     return;
   }
 
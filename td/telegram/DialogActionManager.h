@@ -43,6 +43,7 @@ class DialogActionManager final : public Actor {
 
  private:
   static constexpr double DIALOG_ACTION_TIMEOUT = 5.5;
+  static constexpr size_t MAX_ACTIVE_DIALOG_ACTIONS = 100;  // per dialog; further typing users are ignored
 
   void tear_down() final;
 
@@ -53,6 +54,8 @@ class DialogActionManager final : public Actor {
 
   void on_active_dialog_action_timeout(DialogId dialog_id);
 
+  bool is_dialog_action_flood(DialogId dialog_id, size_t active_action_count);
+
   struct ActiveDialogAction {
     MessageId top_thread_message_id;
     DialogId typing_dialog_id;
@@ -69,6 +72,12 @@ class DialogActionManager final : public Actor {
   };
   FlatHashMap<DialogId, std::vector<ActiveDialogAction>, DialogIdHash> active_dialog_actions_;
 
+  struct AddedDialogActionCount {
+    double period_start_time = 0.0;
+    int64 count = 0;
+  };
+  FlatHashMap<DialogId, AddedDialogActionCount, DialogIdHash> added_dialog_action_counts_;
+
   MultiTimeout active_dialog_action_timeout_{"ActiveDialogActionTimeout"};
 
   FlatHashMap<DialogId, NetQueryRef, DialogIdHash> set_typing_query_;
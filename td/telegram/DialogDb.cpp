@@ -11,10 +11,12 @@
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteStatement.h"
+#include "td/db/WriteBatchPolicy.h"
 
 #include "td/actor/actor.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
+#include "td/utils/algorithm.h"
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -24,6 +26,11 @@
 #include "td/utils/Time.h"
 
 namespace td {
+
+static Status get_not_found_error() {
+  static const Status error = Status::StaticError(0, "Not found");
+  return error.clone();
+}
 // NB: must happen inside a transaction
 Status init_dialog_db(SqliteDb &db, int32 version, KeyValueSyncInterface &binlog_pmc, bool &was_created) {
   LOG(INFO) << "Init dialog database " << tag("version", version);
@@ -200,8 +207,9 @@ class DialogDbImpl final : public DialogDbSyncInterface {
     get_dialog_stmt_.bind_int64(1, dialog_id.get()).ensure();
     TRY_STATUS(get_dialog_stmt_.step());
     if (!get_dialog_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Database);
     return BufferSlice(get_dialog_stmt_.view_blob(0));
   }
 
@@ -212,7 +220,7 @@ class DialogDbImpl final : public DialogDbSyncInterface {
     get_notification_group_stmt_.bind_int32(1, notification_group_id.get()).ensure();
     TRY_STATUS(get_notification_group_stmt_.step());
     if (!get_notification_group_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
     return NotificationGroupKey(notification_group_id, DialogId(get_notification_group_stmt_.view_int64(0)),
                                 get_last_notification_date(get_notification_group_stmt_, 1));
@@ -377,6 +385,7 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
 
     void add_dialog(DialogId dialog_id, FolderId folder_id, int64 order, BufferSlice data,
                     vector<NotificationGroupKey> notification_groups, Promise<Unit> promise) {
+      prefetched_dialogs_ = {};
       add_write_query([this, dialog_id, folder_id, order, promise = std::move(promise), data = std::move(data),
                        notification_groups = std::move(notification_groups)](Unit) mutable {
         sync_db_->add_dialog(dialog_id, folder_id, order, std::move(data), std::move(notification_groups));
@@ -413,7 +422,30 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
     void get_dialogs(FolderId folder_id, int64 order, DialogId dialog_id, int32 limit,
                      Promise<DialogDbGetDialogsResult> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_dialogs(folder_id, order, dialog_id, limit));
+      auto result = get_prefetched_dialogs(folder_id, order, dialog_id, limit);
+      bool need_prefetch = static_cast<int32>(result.dialogs.size()) == limit;
+      if (need_prefetch) {
+        // the next page is likely to be requested immediately after the current page is processed
+        prefetched_dialogs_.folder_id = folder_id;
+        prefetched_dialogs_.order = result.next_order;
+        prefetched_dialogs_.dialog_id = result.next_dialog_id;
+        prefetched_dialogs_.limit = limit;
+        prefetched_dialogs_.is_pending = true;
+        send_closure_later(actor_id(this), &Impl::prefetch_dialogs);
+      }
+      promise.set_value(std::move(result));
+    }
+
+    void prefetch_dialogs() {
+      if (!prefetched_dialogs_.is_pending || sync_db_ == nullptr) {
+        return;
+      }
+      add_read_query();
+      prefetched_dialogs_.is_pending = false;
+      prefetched_dialogs_.result =
+          sync_db_->get_dialogs(prefetched_dialogs_.folder_id, prefetched_dialogs_.order, prefetched_dialogs_.dialog_id,
+                                prefetched_dialogs_.limit);
+      prefetched_dialogs_.is_ready = true;
     }
 
     void close(Promise<Unit> promise) {
@@ -426,31 +458,26 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
 
     void force_flush() {
       do_flush();
-      LOG(INFO) << "DialogDb flushed";
+      LOG(INFO) << "DialogDb flushed with " << write_batch_policy_.get_stats();
     }
 
    private:
     std::shared_ptr<DialogDbSyncSafeInterface> sync_db_safe_;
     DialogDbSyncInterface *sync_db_ = nullptr;
 
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
-    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
-
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
     double wakeup_at_ = 0;
+    WriteBatchPolicy write_batch_policy_;
 
     template <class F>
     void add_write_query(F &&f) {
       pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
-      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
-        do_flush();
-        wakeup_at_ = 0;
+      if (write_batch_policy_.need_flush(pending_writes_.size())) {
+        do_flush(true);
       } else if (wakeup_at_ == 0) {
-        wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
-      }
-      if (wakeup_at_ != 0) {
+        wakeup_at_ = Time::now_cached() + write_batch_policy_.get_flush_delay();
         set_timeout_at(wakeup_at_);
       }
     }
@@ -459,15 +486,51 @@ class DialogDbAsync final : public DialogDbAsyncInterface {
       do_flush();
     }
 
-    void do_flush() {
+    struct PrefetchedDialogs {
+      FolderId folder_id;
+      int64 order = 0;
+      DialogId dialog_id;
+      int32 limit = 0;
+      bool is_pending = false;
+      bool is_ready = false;
+      DialogDbGetDialogsResult result;
+    };
+    PrefetchedDialogs prefetched_dialogs_;
+
+    DialogDbGetDialogsResult get_prefetched_dialogs(FolderId folder_id, int64 order, DialogId dialog_id, int32 limit) {
+      auto prefetched_dialogs = std::move(prefetched_dialogs_);
+      prefetched_dialogs_ = {};
+      if (!prefetched_dialogs.is_ready || prefetched_dialogs.folder_id != folder_id ||
+          prefetched_dialogs.order != order || prefetched_dialogs.dialog_id != dialog_id ||
+          prefetched_dialogs.limit > limit) {
+        return sync_db_->get_dialogs(folder_id, order, dialog_id, limit);
+      }
+
+      auto result = std::move(prefetched_dialogs.result);
+      auto received_count = static_cast<int32>(result.dialogs.size());
+      if (received_count == prefetched_dialogs.limit && received_count < limit) {
+        auto other_result = sync_db_->get_dialogs(folder_id, result.next_order, result.next_dialog_id,
+                                                  limit - received_count);
+        append(result.dialogs, std::move(other_result.dialogs));
+        result.next_order = other_result.next_order;
+        result.next_dialog_id = other_result.next_dialog_id;
+      }
+      return result;
+    }
+
+    void do_flush(bool is_full = false) {
       if (pending_writes_.empty()) {
         return;
       }
+      auto query_count = pending_writes_.size();
       sync_db_->begin_write_transaction().ensure();
       set_promises(pending_writes_);
+      auto commit_start_time = Time::now();
       sync_db_->commit_transaction().ensure();
+      write_batch_policy_.on_transaction_committed(query_count, Time::now() - commit_start_time, is_full);
       set_promises(finished_writes_);
       cancel_timeout();
+      wakeup_at_ = 0;
     }
 
     void timeout_expired() final {
@@ -763,66 +763,96 @@ vector<FolderId> DialogFilter::get_folder_ids() const {
   return {FolderId::main(), FolderId::archive()};
 }
 
-bool DialogFilter::need_dialog(const Td *td, const DialogFilterDialogInfo &dialog_info) const {
-  auto dialog_id = dialog_info.dialog_id_;
-  if (is_dialog_included(dialog_id)) {
-    return true;
-  }
-  if (InputDialogId::contains(excluded_dialog_ids_, dialog_id)) {
-    return false;
-  }
-  if (dialog_id.get_type() == DialogType::SecretChat) {
-    auto user_id = td->user_manager_->get_secret_chat_user_id(dialog_id.get_secret_chat_id());
-    if (user_id.is_valid()) {
-      auto user_dialog_id = DialogId(user_id);
-      if (is_dialog_included(user_dialog_id)) {
-        return true;
-      }
-      if (InputDialogId::contains(excluded_dialog_ids_, user_dialog_id)) {
-        return false;
-      }
-    }
-  }
-  if (!dialog_info.has_unread_mentions_) {
-    if (exclude_muted_ && dialog_info.is_muted_) {
-      return false;
-    }
-    if (exclude_read_ && !dialog_info.has_unread_messages_) {
-      return false;
-    }
-  }
-  if (exclude_archived_ && dialog_info.folder_id_ == FolderId::archive()) {
-    return false;
-  }
+DialogFilterDialogInfo::Feature DialogFilter::get_dialog_type_feature(const Td *td, DialogId dialog_id) {
   switch (dialog_id.get_type()) {
     case DialogType::User: {
       auto user_id = dialog_id.get_user_id();
       if (td->user_manager_->is_user_bot(user_id)) {
-        return include_bots_;
+        return DialogFilterDialogInfo::IsBot;
       }
       if (user_id == td->user_manager_->get_my_id() || td->user_manager_->is_user_contact(user_id)) {
-        return include_contacts_;
+        return DialogFilterDialogInfo::IsContact;
       }
-      return include_non_contacts_;
+      return DialogFilterDialogInfo::IsNonContact;
     }
     case DialogType::Chat:
-      return include_groups_;
+      return DialogFilterDialogInfo::IsGroup;
     case DialogType::Channel:
-      return td->chat_manager_->is_broadcast_channel(dialog_id.get_channel_id()) ? include_channels_ : include_groups_;
+      return td->chat_manager_->is_broadcast_channel(dialog_id.get_channel_id()) ? DialogFilterDialogInfo::IsChannel
+                                                                                 : DialogFilterDialogInfo::IsGroup;
     case DialogType::SecretChat: {
       auto user_id = td->user_manager_->get_secret_chat_user_id(dialog_id.get_secret_chat_id());
       if (td->user_manager_->is_user_bot(user_id)) {
-        return include_bots_;
+        return DialogFilterDialogInfo::IsBot;
       }
       if (td->user_manager_->is_user_contact(user_id)) {
-        return include_contacts_;
+        return DialogFilterDialogInfo::IsContact;
       }
-      return include_non_contacts_;
+      return DialogFilterDialogInfo::IsNonContact;
     }
     default:
       UNREACHABLE();
+      return DialogFilterDialogInfo::IsNonContact;
+  }
+}
+
+int32 DialogFilter::get_included_features() const {
+  int32 features = 0;
+  if (include_contacts_) {
+    features |= DialogFilterDialogInfo::IsContact;
+  }
+  if (include_non_contacts_) {
+    features |= DialogFilterDialogInfo::IsNonContact;
+  }
+  if (include_bots_) {
+    features |= DialogFilterDialogInfo::IsBot;
+  }
+  if (include_groups_) {
+    features |= DialogFilterDialogInfo::IsGroup;
+  }
+  if (include_channels_) {
+    features |= DialogFilterDialogInfo::IsChannel;
+  }
+  return features;
+}
+
+int32 DialogFilter::get_excluded_features(bool has_unread_mentions) const {
+  int32 features = 0;
+  if (!has_unread_mentions) {
+    // dialogs with unread mentions are never excluded as muted or read
+    if (exclude_muted_) {
+      features |= DialogFilterDialogInfo::IsMuted;
+    }
+    if (exclude_read_) {
+      features |= DialogFilterDialogInfo::IsRead;
+    }
+  }
+  if (exclude_archived_) {
+    features |= DialogFilterDialogInfo::IsArchived;
+  }
+  return features;
+}
+
+bool DialogFilter::need_dialog(const DialogFilterDialogInfo &dialog_info) const {
+  auto dialog_id = dialog_info.dialog_id_;
+  if (is_dialog_included(dialog_id)) {
+    return true;
+  }
+  if (InputDialogId::contains(excluded_dialog_ids_, dialog_id)) {
+    return false;
+  }
+  auto user_dialog_id = dialog_info.user_dialog_id_;
+  if (user_dialog_id.is_valid()) {
+    if (is_dialog_included(user_dialog_id)) {
+      return true;
+    }
+    if (InputDialogId::contains(excluded_dialog_ids_, user_dialog_id)) {
       return false;
+    }
   }
+  auto features = dialog_info.features_;
+  bool has_unread_mentions = (features & DialogFilterDialogInfo::HasUnreadMentions) != 0;
+  return (features & get_included_features()) != 0 && (features & get_excluded_features(has_unread_mentions)) == 0;
 }
 
 vector<DialogFilterId> DialogFilter::get_dialog_filter_ids(const vector<unique_ptr<DialogFilter>> &dialog_filters,
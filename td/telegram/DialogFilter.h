@@ -100,7 +100,9 @@ class DialogFilter {
 
   vector<FolderId> get_folder_ids() const;
 
-  bool need_dialog(const Td *td, const DialogFilterDialogInfo &dialog_info) const;
+  static DialogFilterDialogInfo::Feature get_dialog_type_feature(const Td *td, DialogId dialog_id);
+
+  bool need_dialog(const DialogFilterDialogInfo &dialog_info) const;
 
   static vector<DialogFilterId> get_dialog_filter_ids(const vector<unique_ptr<DialogFilter>> &dialog_filters,
                                                       int32 main_dialog_list_position);
@@ -144,6 +146,12 @@ class DialogFilter {
 
   static bool are_flags_equal(const DialogFilter &lhs, const DialogFilter &rhs);
 
+  // returns dialog features, at least one of which must be present in dialogs in the filter
+  int32 get_included_features() const;
+
+  // returns dialog features, which must be absent in dialogs in the filter
+  int32 get_excluded_features(bool has_unread_mentions) const;
+
   static void init_icon_names();
 
   string get_chosen_or_default_icon_name() const;
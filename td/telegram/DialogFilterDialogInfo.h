@@ -7,18 +7,29 @@
 #pragma once
 
 #include "td/telegram/DialogId.h"
-#include "td/telegram/FolderId.h"
 
 #include "td/utils/common.h"
 
 namespace td {
 
+// properties of a dialog, which are checked by chat folders
+// they are computed once per dialog change and then are matched against every folder using a few bit operations
 struct DialogFilterDialogInfo {
+  enum Feature : int32 {
+    HasUnreadMentions = 1 << 0,
+    IsMuted = 1 << 1,
+    IsRead = 1 << 2,
+    IsArchived = 1 << 3,
+    IsBot = 1 << 4,
+    IsContact = 1 << 5,
+    IsNonContact = 1 << 6,
+    IsGroup = 1 << 7,
+    IsChannel = 1 << 8
+  };
+
   DialogId dialog_id_;
-  FolderId folder_id_;
-  bool has_unread_mentions_ = false;
-  bool is_muted_ = false;
-  bool has_unread_messages_ = false;
+  DialogId user_dialog_id_;  // user of a secret chat
+  int32 features_ = 0;
 };
 
 }  // namespace td
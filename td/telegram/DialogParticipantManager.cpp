@@ -379,7 +379,7 @@ class GetChannelParticipantsQuery final : public Td::ResultHandler {
       : promise_(std::move(promise)) {
   }
 
-  void send(ChannelId channel_id, const ChannelParticipantFilter &filter, int32 offset, int32 limit) {
+  void send(ChannelId channel_id, const ChannelParticipantFilter &filter, int32 offset, int32 limit, int64 hash) {
     auto input_channel = td_->chat_manager_->get_input_channel(channel_id);
     if (input_channel == nullptr) {
       return promise_.set_error(Status::Error(400, "Supergroup not found"));
@@ -387,7 +387,7 @@ class GetChannelParticipantsQuery final : public Td::ResultHandler {
 
     channel_id_ = channel_id;
     send_query(G()->net_query_creator().create(telegram_api::channels_getParticipants(
-        std::move(input_channel), filter.get_input_channel_participants_filter(), offset, limit, 0)));
+        std::move(input_channel), filter.get_input_channel_participants_filter(), offset, limit, hash)));
   }
 
   void on_result(BufferSlice packet) final {
@@ -404,8 +404,9 @@ class GetChannelParticipantsQuery final : public Td::ResultHandler {
         break;
       }
       case telegram_api::channels_channelParticipantsNotModified::ID:
-        LOG(ERROR) << "Receive channelParticipantsNotModified";
-        return on_error(Status::Error(500, "Receive channelParticipantsNotModified"));
+        // the cached page is still actual
+        promise_.set_value(nullptr);
+        break;
       default:
         UNREACHABLE();
     }
@@ -1302,6 +1303,7 @@ void DialogParticipantManager::reload_dialog_administrators(
       !td_->chat_manager_->get_chat_permissions(dialog_id.get_chat_id()).is_member()) {
     return promise.set_value(td_api::make_object<td_api::chatAdministrators>());
   }
+  bool need_result = static_cast<bool>(promise);
   auto query_promise = PromiseCreator::lambda(
       [actor_id = actor_id(this), dialog_id, promise = std::move(promise)](Result<Unit> &&result) mutable {
         if (promise) {
@@ -1327,7 +1329,15 @@ void DialogParticipantManager::reload_dialog_administrators(
       auto hash = get_vector_hash(transform(dialog_administrators, [](const DialogAdministrator &administrator) {
         return static_cast<uint64>(administrator.get_user_id().get());
       }));
-      td_->create_handler<GetChannelAdministratorsQuery>(std::move(query_promise))->send(channel_id, hash);
+      auto send_query = PromiseCreator::lambda([td = td_, channel_id, hash](Result<Promise<Unit>> &&promise) {
+        if (promise.is_ok() && !G()->close_flag()) {
+          td->create_handler<GetChannelAdministratorsQuery>(promise.move_as_ok())->send(channel_id, hash);
+        }
+      });
+      // concurrent requests for administrators of the same channel are combined into one query;
+      // background cache updates without a waiting promise are additionally delayed to avoid flood limits
+      get_channel_administrators_queries_.add_query(dialog_id.get(), std::move(send_query),
+                                                    need_result ? std::move(query_promise) : Promise<Unit>());
       break;
     }
     default:
@@ -1486,8 +1496,11 @@ void DialogParticipantManager::on_update_channel_participant(
   if (old_dialog_participant.dialog_id_ == td_->dialog_manager_->get_my_dialog_id() &&
       old_dialog_participant.status_.is_administrator() && !new_dialog_participant.status_.is_administrator()) {
     drop_channel_participant_cache(channel_id);
-  } else if (have_channel_participant_cache(channel_id)) {
-    add_channel_participant_to_cache(channel_id, new_dialog_participant, true);
+  } else {
+    drop_channel_participants_pages(channel_id);
+    if (have_channel_participant_cache(channel_id)) {
+      add_channel_participant_to_cache(channel_id, new_dialog_participant, true);
+    }
   }
 
   auto channel_status = td_->chat_manager_->get_channel_status(channel_id);
@@ -1770,9 +1783,34 @@ void DialogParticipantManager::get_channel_participants(ChannelId channel_id,
   }
 
   ChannelParticipantFilter participant_filter(filter);
+  int64 hash = 0;
+  const auto *page =
+      channel_participants_pages_.get(get_channel_participants_page_key(channel_id, participant_filter, offset, limit));
+  if (page != nullptr) {
+    if (have_channel_participant_cache(channel_id) &&
+        page->validated_at_ > Time::now() - CHANNEL_PARTICIPANTS_PAGE_CACHE_TIME) {
+      // all changes of the member list are received through updates, so the page can be returned without a request
+      LOG(INFO) << "Return cached " << participant_filter << " members in " << channel_id << " with offset " << offset
+                << " and limit " << limit;
+      auto participants = page->participants_.participants_;
+      return finish_get_channel_participants(page->participants_.total_count_, std::move(participants),
+                                             additional_query, additional_limit, std::move(promise));
+    }
+    hash = page->hash_;
+  }
+
+  send_get_channel_participants_query(channel_id, std::move(participant_filter), std::move(additional_query), offset,
+                                      limit, additional_limit, hash, std::move(promise));
+}
+
+void DialogParticipantManager::send_get_channel_participants_query(ChannelId channel_id,
+                                                                   ChannelParticipantFilter &&filter,
+                                                                   string additional_query, int32 offset, int32 limit,
+                                                                   int32 additional_limit, int64 hash,
+                                                                   Promise<DialogParticipants> &&promise) {
   auto get_channel_participants_promise = PromiseCreator::lambda(
-      [actor_id = actor_id(this), channel_id, filter = participant_filter,
-       additional_query = std::move(additional_query), offset, limit, additional_limit, promise = std::move(promise)](
+      [actor_id = actor_id(this), channel_id, filter, additional_query = std::move(additional_query), offset, limit,
+       additional_limit, promise = std::move(promise)](
           Result<telegram_api::object_ptr<telegram_api::channels_channelParticipants>> &&result) mutable {
         if (result.is_error()) {
           promise.set_error(result.move_as_error());
@@ -1783,7 +1821,7 @@ void DialogParticipantManager::get_channel_participants(ChannelId channel_id,
         }
       });
   td_->create_handler<GetChannelParticipantsQuery>(std::move(get_channel_participants_promise))
-      ->send(channel_id, participant_filter, offset, limit);
+      ->send(channel_id, filter, offset, limit, hash);
 }
 
 void DialogParticipantManager::on_get_channel_participants(
@@ -1792,6 +1830,23 @@ void DialogParticipantManager::on_get_channel_participants(
     Promise<DialogParticipants> &&promise) {
   TRY_STATUS_PROMISE(promise, G()->close_status());
 
+  auto page_key = get_channel_participants_page_key(channel_id, filter, offset, limit);
+  if (channel_participants == nullptr) {
+    auto *page = channel_participants_pages_.get(page_key);
+    if (page == nullptr) {
+      // the page was evicted or the member list has changed after the request was sent
+      LOG(INFO) << "Reload " << filter << " members in " << channel_id << " with offset " << offset << " and limit "
+                << limit;
+      return send_get_channel_participants_query(channel_id, std::move(filter), std::move(additional_query), offset,
+                                                 limit, additional_limit, 0, std::move(promise));
+    }
+    LOG(INFO) << "Cached " << filter << " members in " << channel_id << " are still actual";
+    page->validated_at_ = Time::now();
+    auto participants = page->participants_.participants_;
+    return finish_get_channel_participants(page->participants_.total_count_, std::move(participants),
+                                           additional_query, additional_limit, std::move(promise));
+  }
+
   td_->user_manager_->on_get_users(std::move(channel_participants->users_), "on_get_channel_participants");
   td_->chat_manager_->on_get_chats(std::move(channel_participants->chats_), "on_get_channel_participants");
   int32 total_count = channel_participants->count_;
@@ -1805,6 +1860,7 @@ void DialogParticipantManager::on_get_channel_participants(
 
   auto channel_type = td_->chat_manager_->get_channel_type(channel_id);
   vector<DialogParticipant> result;
+  vector<uint64> participant_user_ids;
   for (auto &participant_ptr : participants) {
     auto debug_participant = to_string(participant_ptr);
     result.emplace_back(std::move(participant_ptr), channel_type);
@@ -1812,6 +1868,7 @@ void DialogParticipantManager::on_get_channel_participants(
     UserId participant_user_id;
     if (participant.dialog_id_.get_type() == DialogType::User) {
       participant_user_id = participant.dialog_id_.get_user_id();
+      participant_user_ids.push_back(static_cast<uint64>(participant_user_id.get()));
     }
     if (!participant.is_valid() || (filter.is_bots() && !td_->user_manager_->is_user_bot(participant_user_id)) ||
         (filter.is_administrators() && !participant.status_.is_administrator()) ||
@@ -1907,6 +1964,19 @@ void DialogParticipantManager::on_get_channel_participants(
     td_->chat_manager_->on_update_channel_administrator_count(channel_id, administrator_count);
   }
 
+  ChannelParticipantsPage page;
+  page.hash_ = get_vector_hash(participant_user_ids);
+  page.validated_at_ = Time::now();
+  page.participants_ = DialogParticipants{total_count, vector<DialogParticipant>(result)};
+  channel_participants_pages_.put(std::move(page_key), std::move(page), result.size() + 1);
+
+  finish_get_channel_participants(total_count, std::move(result), additional_query, additional_limit,
+                                  std::move(promise));
+}
+
+void DialogParticipantManager::finish_get_channel_participants(int32 total_count, vector<DialogParticipant> result,
+                                                               const string &additional_query, int32 additional_limit,
+                                                               Promise<DialogParticipants> &&promise) {
   if (!additional_query.empty()) {
     auto dialog_ids = transform(result, [](const DialogParticipant &participant) { return participant.dialog_id_; });
     std::pair<int32, vector<DialogId>> result_dialog_ids =
@@ -2763,6 +2833,7 @@ void DialogParticipantManager::update_channel_participant_status_cache(
     ChannelId channel_id, DialogId participant_dialog_id, DialogParticipantStatus &&dialog_participant_status) {
   CHECK(channel_id.is_valid());
   CHECK(participant_dialog_id.is_valid());
+  drop_channel_participants_pages(channel_id);
   auto channel_participants_it = channel_participants_.find(channel_id);
   if (channel_participants_it == channel_participants_.end()) {
     return;
@@ -2781,6 +2852,20 @@ void DialogParticipantManager::update_channel_participant_status_cache(
 
 void DialogParticipantManager::drop_channel_participant_cache(ChannelId channel_id) {
   channel_participants_.erase(channel_id);
+  drop_channel_participants_pages(channel_id);
+}
+
+string DialogParticipantManager::get_channel_participants_page_key(ChannelId channel_id,
+                                                                   const ChannelParticipantFilter &filter, int32 offset,
+                                                                   int32 limit) const {
+  auto it = channel_participants_page_generations_.find(channel_id);
+  auto generation = it == channel_participants_page_generations_.end() ? 0 : it->second;
+  return PSTRING() << channel_id.get() << ' ' << generation << ' ' << offset << ' ' << limit << ' ' << filter;
+}
+
+void DialogParticipantManager::drop_channel_participants_pages(ChannelId channel_id) {
+  // pages with the previous generation will never be returned and will be evicted from the cache eventually
+  channel_participants_page_generations_[channel_id]++;
 }
 
 const DialogParticipant *DialogParticipantManager::get_channel_participant_from_cache(ChannelId channel_id,
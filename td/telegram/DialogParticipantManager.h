@@ -13,6 +13,7 @@
 #include "td/telegram/DialogInviteLink.h"
 #include "td/telegram/DialogParticipant.h"
 #include "td/telegram/DialogParticipantFilter.h"
+#include "td/telegram/QueryCombiner.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/UserId.h"
@@ -22,6 +23,7 @@
 
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/LruCache.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Status.h"
 
@@ -161,6 +163,11 @@ class DialogParticipantManager final : public Actor {
 
   static constexpr int32 MAX_GET_CHANNEL_PARTICIPANTS = 200;  // server side limit
 
+  // cached pages of bot-administrators can be returned without revalidation during this time
+  static constexpr double CHANNEL_PARTICIPANTS_PAGE_CACHE_TIME = 60.0;
+
+  static constexpr size_t MAX_CACHED_CHANNEL_PARTICIPANTS = 100000;
+
   void tear_down() final;
 
   static void on_update_dialog_online_member_count_timeout_callback(void *dialog_participant_manager_ptr,
@@ -216,12 +223,25 @@ class DialogParticipantManager final : public Actor {
   void do_search_chat_participants(ChatId chat_id, const string &query, int32 limit, DialogParticipantFilter filter,
                                    Promise<DialogParticipants> &&promise);
 
+  void send_get_channel_participants_query(ChannelId channel_id, ChannelParticipantFilter &&filter,
+                                           string additional_query, int32 offset, int32 limit, int32 additional_limit,
+                                           int64 hash, Promise<DialogParticipants> &&promise);
+
   void on_get_channel_participants(
       ChannelId channel_id, ChannelParticipantFilter &&filter, int32 offset, int32 limit, string additional_query,
       int32 additional_limit,
       telegram_api::object_ptr<telegram_api::channels_channelParticipants> &&channel_participants,
       Promise<DialogParticipants> &&promise);
 
+  void finish_get_channel_participants(int32 total_count, vector<DialogParticipant> result,
+                                       const string &additional_query, int32 additional_limit,
+                                       Promise<DialogParticipants> &&promise);
+
+  string get_channel_participants_page_key(ChannelId channel_id, const ChannelParticipantFilter &filter, int32 offset,
+                                           int32 limit) const;
+
+  void drop_channel_participants_pages(ChannelId channel_id);
+
   void set_chat_participant_status(ChatId chat_id, UserId user_id, DialogParticipantStatus status, bool is_recursive,
                                    Promise<Unit> &&promise);
 
@@ -293,6 +313,8 @@ class DialogParticipantManager final : public Actor {
 
   FlatHashMap<DialogId, vector<DialogAdministrator>, DialogIdHash> dialog_administrators_;
 
+  QueryCombiner get_channel_administrators_queries_{"GetChannelAdministratorsCombiner", 2.0};
+
   // bot-administrators only
   struct ChannelParticipantInfo {
     DialogParticipant participant_;
@@ -306,6 +328,17 @@ class DialogParticipantManager final : public Actor {
 
   FlatHashMap<ChannelId, vector<DialogParticipant>, ChannelIdHash> cached_channel_participants_;
 
+  // received results of channels.getParticipants, which are revalidated using hash
+  struct ChannelParticipantsPage {
+    int64 hash_ = 0;
+    double validated_at_ = 0.0;
+    DialogParticipants participants_;
+  };
+  // the cost of a page is the number of participants in it plus one
+  LruCache<string, ChannelParticipantsPage> channel_participants_pages_{MAX_CACHED_CHANNEL_PARTICIPANTS};
+  // generation is a part of page keys, so pages of a channel can be dropped by changing it
+  FlatHashMap<ChannelId, int32, ChannelIdHash> channel_participants_page_generations_;
+
   FlatHashMap<ChannelId, vector<Promise<td_api::object_ptr<td_api::failedToAddMembers>>>, ChannelIdHash>
       join_channel_queries_;
 
@@ -329,6 +329,10 @@ static void store(const DraftMessageContent *content, StorerT &storer) {
   }
 }
 
+void store_draft_message_content(const DraftMessageContent *content, LogEventStorerBuffer &storer) {
+  store(content, storer);
+}
+
 void store_draft_message_content(const DraftMessageContent *content, LogEventStorerCalcLength &storer) {
   store(content, storer);
 }
@@ -84,6 +84,8 @@ class DraftMessage {
   void parse(ParserT &parser);
 };
 
+void store_draft_message_content(const DraftMessageContent *content, LogEventStorerBuffer &storer);
+
 void store_draft_message_content(const DraftMessageContent *content, LogEventStorerCalcLength &storer);
 
 void store_draft_message_content(const DraftMessageContent *content, LogEventStorerUnsafe &storer);
@@ -294,8 +294,12 @@ void FileReferenceManager::run_node(NodeId node_id) {
     node.query = {};
     return;
   }
-  auto file_source_id = node.file_source_ids.next();
-  send_query(Destination(node_id, node.query->generation), file_source_id);
+  // the sources are tried in parallel; the next sources are tried only after all the queries have failed
+  auto generation = node.query->generation;
+  do {
+    auto file_source_id = node.file_source_ids.next();
+    send_query(Destination(node_id, generation), file_source_id);
+  } while (node.query->active_queries < MAX_NODE_ACTIVE_QUERIES && node.file_source_ids.has_next());
 }
 
 void FileReferenceManager::send_query(Destination dest, FileSourceId file_source_id) {
@@ -304,18 +308,24 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
   auto &node = add_node(dest.node_id);
   node.query->active_queries++;
 
-  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), file_manager_actor_id = G()->file_manager(), dest,
-                                         file_source_id](Result<Unit> result) {
-    auto new_promise = PromiseCreator::lambda([actor_id, dest, file_source_id](Result<Unit> result) {
-      Status status;
-      if (result.is_error()) {
-        status = result.move_as_error();
-      }
-      send_closure(actor_id, &FileReferenceManager::on_query_result, dest, file_source_id, std::move(status), 0);
-    });
+  auto &destinations = source_queries_[file_source_id];
+  destinations.push_back(dest);
+  if (destinations.size() > 1) {
+    VLOG(file_references) << "Wait for the already sent reload query of " << file_source_id;
+    return;
+  }
+  if (active_source_query_count_ >= MAX_ACTIVE_SOURCE_QUERIES) {
+    VLOG(file_references) << "Delay reload query of " << file_source_id;
+    pending_source_ids_.push(file_source_id);
+    return;
+  }
+  send_source_query(file_source_id);
+}
 
-    send_closure(file_manager_actor_id, &FileManager::on_file_reference_repaired, dest.node_id, file_source_id,
-                 std::move(result), std::move(new_promise));
+void FileReferenceManager::send_source_query(FileSourceId file_source_id) {
+  active_source_query_count_++;
+  auto promise = PromiseCreator::lambda([actor_id = actor_id(this), file_source_id](Result<Unit> result) {
+    send_closure(actor_id, &FileReferenceManager::on_source_query_result, file_source_id, std::move(result));
   });
   auto index = static_cast<size_t>(file_source_id.get()) - 1;
   CHECK(index < file_sources_.size());
@@ -399,6 +409,38 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
       }));
 }
 
+void FileReferenceManager::on_source_query_result(FileSourceId file_source_id, Result<Unit> result) {
+  active_source_query_count_--;
+  CHECK(active_source_query_count_ >= 0);
+
+  auto it = source_queries_.find(file_source_id);
+  CHECK(it != source_queries_.end());
+  auto destinations = std::move(it->second);
+  source_queries_.erase(it);
+
+  VLOG(file_references) << "Receive result of reload query of " << file_source_id << " for " << destinations.size()
+                        << " files";
+  for (auto dest : destinations) {
+    auto promise = PromiseCreator::lambda([actor_id = actor_id(this), dest, file_source_id](Result<Unit> result) {
+      Status status;
+      if (result.is_error()) {
+        status = result.move_as_error();
+      }
+      send_closure(actor_id, &FileReferenceManager::on_query_result, dest, file_source_id, std::move(status), 0);
+    });
+    Result<Unit> dest_result = Unit();
+    if (result.is_error()) {
+      dest_result = result.error().clone();
+    }
+    send_closure(G()->file_manager(), &FileManager::on_file_reference_repaired, dest.node_id, file_source_id,
+                 std::move(dest_result), std::move(promise));
+  }
+
+  while (active_source_query_count_ < MAX_ACTIVE_SOURCE_QUERIES && !pending_source_ids_.empty()) {
+    send_source_query(pending_source_ids_.pop());
+  }
+}
+
 FileReferenceManager::Destination FileReferenceManager::on_query_result(Destination dest, FileSourceId file_source_id,
                                                                         Status status, int32 sub) {
   if (G()->close_flag()) {
@@ -22,11 +22,13 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 #include "td/utils/Variant.h"
+#include "td/utils/VectorQueue.h"
 #include "td/utils/WaitFreeHashMap.h"
 #include "td/utils/WaitFreeVector.h"
 
@@ -95,6 +97,9 @@ class FileReferenceManager final : public Actor {
   FileSourceId parse_file_source(Td *td, ParserT &parser);
 
  private:
+  static constexpr int32 MAX_NODE_ACTIVE_QUERIES = 3;      // maximum number of sources queried for a file at once
+  static constexpr int32 MAX_ACTIVE_SOURCE_QUERIES = 20;  // maximum number of simultaneously reloaded sources
+
   struct Destination {
     NodeId node_id;
     int64 generation{0};
@@ -193,12 +198,19 @@ class FileReferenceManager final : public Actor {
 
   WaitFreeHashMap<NodeId, unique_ptr<Node>, FileIdHash> nodes_;
 
+  // files waiting for reload of the source; the source is reloaded once for all of them
+  FlatHashMap<FileSourceId, vector<Destination>, FileSourceIdHash> source_queries_;
+  VectorQueue<FileSourceId> pending_source_ids_;  // sources waiting for a free slot to be reloaded
+  int32 active_source_query_count_ = 0;
+
   ActorShared<> parent_;
 
   Node &add_node(NodeId node_id);
 
   void run_node(NodeId node);
   void send_query(Destination dest, FileSourceId file_source_id);
+  void send_source_query(FileSourceId file_source_id);
+  void on_source_query_result(FileSourceId file_source_id, Result<Unit> result);
   Destination on_query_result(Destination dest, FileSourceId file_source_id, Status status, int32 sub = 0);
 
   template <class T>
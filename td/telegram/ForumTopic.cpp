@@ -42,6 +42,14 @@ ForumTopic::ForumTopic(Td *td, tl_object_ptr<telegram_api::ForumTopic> &&forum_t
   unread_reaction_count_ = forum_topic->unread_reactions_count_;
 }
 
+bool ForumTopic::update_last_message_id(MessageId last_message_id) {
+  if (!last_message_id.is_server() || last_message_id <= last_message_id_) {
+    return false;
+  }
+  last_message_id_ = last_message_id;
+  return true;
+}
+
 bool ForumTopic::update_last_read_outbox_message_id(MessageId last_read_outbox_message_id) {
   if (last_read_outbox_message_id <= last_read_outbox_message_id_) {
     return false;
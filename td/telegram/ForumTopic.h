@@ -42,6 +42,12 @@ class ForumTopic {
     return is_short_;
   }
 
+  MessageId get_last_message_id() const {
+    return last_message_id_;
+  }
+
+  bool update_last_message_id(MessageId last_message_id);
+
   bool update_last_read_outbox_message_id(MessageId last_read_outbox_message_id);
 
   bool update_last_read_inbox_message_id(MessageId last_read_inbox_message_id, int32 unread_count);
@@ -10,6 +10,7 @@
 #include "td/telegram/AuthManager.h"
 #include "td/telegram/ChannelId.h"
 #include "td/telegram/ChatManager.h"
+#include "td/telegram/ConnectionState.h"
 #include "td/telegram/CustomEmojiId.h"
 #include "td/telegram/DialogManager.h"
 #include "td/telegram/ForumTopic.h"
@@ -38,6 +39,8 @@
 #include "td/utils/Slice.h"
 #include "td/utils/tl_helpers.h"
 
+#include <limits>
+
 namespace td {
 
 class CreateForumTopicQuery final : public Td::ResultHandler {
@@ -813,10 +816,89 @@ void ForumTopicManager::get_forum_topics(DialogId dialog_id, string query, int32
   if (limit <= 0) {
     return promise.set_error(Status::Error(400, "Invalid limit specified"));
   }
+  if (query.empty() && td_->get_connection_state() != ConnectionState::Ready &&
+      G()->td_db()->get_message_thread_db_async() != nullptr) {
+    // the server is unreachable now, so return topics ordered by the last message from the local index
+    return get_forum_topics_from_database(dialog_id, offset_message_id, offset_top_thread_message_id, limit,
+                                          std::move(promise));
+  }
   td_->create_handler<GetForumTopicsQuery>(std::move(promise))
       ->send(channel_id, query, offset_date, offset_message_id, offset_top_thread_message_id, limit);
 }
 
+void ForumTopicManager::get_forum_topics_from_database(DialogId dialog_id, MessageId offset_message_id,
+                                                       MessageId offset_top_thread_message_id, int32 limit,
+                                                       Promise<td_api::object_ptr<td_api::forumTopics>> &&promise) {
+  int64 offset_order = std::numeric_limits<int64>::max();
+  if (offset_message_id.is_valid()) {
+    offset_order = offset_message_id.get();
+  } else if (offset_top_thread_message_id.is_valid()) {
+    offset_order = offset_top_thread_message_id.get();
+  }
+  LOG(INFO) << "Load topics in " << dialog_id << " from database with offset " << offset_order;
+  G()->td_db()->get_message_thread_db_async()->get_message_threads(
+      dialog_id, offset_order, limit,
+      PromiseCreator::lambda([actor_id = actor_id(this), dialog_id,
+                              promise = std::move(promise)](MessageThreadDbMessageThreads message_threads) mutable {
+        send_closure(actor_id, &ForumTopicManager::on_get_forum_topics_from_database, dialog_id,
+                     std::move(message_threads), std::move(promise));
+      }));
+}
+
+void ForumTopicManager::on_get_forum_topics_from_database(DialogId dialog_id,
+                                                          MessageThreadDbMessageThreads message_threads,
+                                                          Promise<td_api::object_ptr<td_api::forumTopics>> &&promise) {
+  TRY_STATUS_PROMISE(promise, G()->close_status());
+  TRY_STATUS_PROMISE(promise, is_forum(dialog_id));
+
+  auto dialog_topics = add_dialog_topics(dialog_id);
+  vector<td_api::object_ptr<td_api::forumTopic>> forum_topics;
+  int32 next_offset_date = 0;
+  MessageId next_offset_message_id;
+  MessageId next_offset_top_thread_message_id;
+  for (auto &message_thread : message_threads.message_threads) {
+    auto topic = make_unique<Topic>();
+    topic->info_ = make_unique<ForumTopicInfo>();
+    if (log_event_parse(*topic, message_thread.as_slice()).is_error() || topic->topic_ == nullptr) {
+      LOG(ERROR) << "Failed to load a topic in " << dialog_id << " from database";
+      continue;
+    }
+    auto top_thread_message_id = topic->info_->get_top_thread_message_id();
+    auto current_topic = add_topic(dialog_topics, top_thread_message_id);
+    if (current_topic == nullptr) {
+      continue;
+    }
+    if (current_topic->info_ == nullptr) {
+      current_topic->info_ = std::move(topic->info_);
+    }
+    if (current_topic->topic_ == nullptr) {
+      current_topic->topic_ = std::move(topic->topic_);
+      current_topic->need_save_to_database_ = false;
+    }
+
+    auto forum_topic_object = get_forum_topic_object(dialog_id, top_thread_message_id);
+    if (forum_topic_object == nullptr) {
+      continue;
+    }
+    if (forum_topic_object->last_message_ == nullptr) {
+      next_offset_date = forum_topic_object->info_->creation_date_;
+    } else {
+      next_offset_date = forum_topic_object->last_message_->date_;
+    }
+    next_offset_message_id = current_topic->topic_->get_last_message_id();
+    next_offset_top_thread_message_id = top_thread_message_id;
+    forum_topics.push_back(std::move(forum_topic_object));
+  }
+
+  auto total_count = static_cast<int32>(forum_topics.size());
+  if (message_threads.next_order != 0) {
+    total_count = max(total_count + 1, static_cast<int32>(dialog_topics->topics_.calc_size()));
+  }
+  promise.set_value(td_api::make_object<td_api::forumTopics>(total_count, std::move(forum_topics), next_offset_date,
+                                                             next_offset_message_id.get(),
+                                                             next_offset_top_thread_message_id.get()));
+}
+
 void ForumTopicManager::on_get_forum_topics(ChannelId channel_id, bool order_by_creation_date, MessagesInfo &&info,
                                             vector<telegram_api::object_ptr<telegram_api::ForumTopic>> &&topics,
                                             Promise<td_api::object_ptr<td_api::forumTopics>> &&promise) {
@@ -1179,6 +1261,14 @@ void ForumTopicManager::send_update_forum_topic_info(DialogId dialog_id, const F
   send_closure(G()->td(), &Td::send_update, get_update_forum_topic_info(dialog_id, topic_info));
 }
 
+int64 ForumTopicManager::get_topic_order(const Topic *topic) {
+  CHECK(topic->info_ != nullptr);
+  if (topic->topic_ != nullptr && topic->topic_->get_last_message_id().is_valid()) {
+    return topic->topic_->get_last_message_id().get();
+  }
+  return topic->info_->get_top_thread_message_id().get();
+}
+
 void ForumTopicManager::save_topic_to_database(DialogId dialog_id, const Topic *topic) {
   CHECK(topic != nullptr);
   if (topic->info_ == nullptr || !topic->need_save_to_database_) {
@@ -1193,7 +1283,8 @@ void ForumTopicManager::save_topic_to_database(DialogId dialog_id, const Topic *
 
   auto top_thread_message_id = topic->info_->get_top_thread_message_id();
   LOG(INFO) << "Save topic of " << top_thread_message_id << " in " << dialog_id << " to database";
-  message_thread_db->add_message_thread(dialog_id, top_thread_message_id, 0, log_event_store(*topic), Auto());
+  message_thread_db->add_message_thread(dialog_id, top_thread_message_id, get_topic_order(topic),
+                                        log_event_store(*topic), Auto());
 }
 
 void ForumTopicManager::delete_topic_from_database(DialogId dialog_id, MessageId top_thread_message_id,
@@ -1229,4 +1320,18 @@ void ForumTopicManager::on_topic_message_count_changed(DialogId dialog_id, Messa
   }
 }
 
+void ForumTopicManager::on_topic_message_added(DialogId dialog_id, MessageId top_thread_message_id,
+                                               MessageId message_id) {
+  if (td_->auth_manager_->is_bot()) {
+    return;
+  }
+  auto topic = get_topic(dialog_id, top_thread_message_id);
+  if (topic == nullptr || topic->topic_ == nullptr || !topic->topic_->update_last_message_id(message_id)) {
+    return;
+  }
+  // the topic has moved to a new position in the list ordered by the last message
+  topic->need_save_to_database_ = true;
+  save_topic_to_database(dialog_id, topic);
+}
+
 }  // namespace td
@@ -28,6 +28,8 @@
 
 namespace td {
 
+struct MessageThreadDbMessageThreads;
+
 class Td;
 
 class ForumTopicManager final : public Actor {
@@ -115,6 +117,8 @@ class ForumTopicManager final : public Actor {
 
   void on_topic_message_count_changed(DialogId dialog_id, MessageId top_thread_message_id, int diff);
 
+  void on_topic_message_added(DialogId dialog_id, MessageId top_thread_message_id, MessageId message_id);
+
  private:
   static constexpr size_t MAX_FORUM_TOPIC_TITLE_LENGTH = 128;  // server side limit for forum topic title
 
@@ -182,8 +186,17 @@ class ForumTopicManager final : public Actor {
 
   void send_update_forum_topic_info(DialogId dialog_id, const ForumTopicInfo *topic_info) const;
 
+  static int64 get_topic_order(const Topic *topic);
+
   void save_topic_to_database(DialogId dialog_id, const Topic *topic);
 
+  void get_forum_topics_from_database(DialogId dialog_id, MessageId offset_message_id,
+                                      MessageId offset_top_thread_message_id, int32 limit,
+                                      Promise<td_api::object_ptr<td_api::forumTopics>> &&promise);
+
+  void on_get_forum_topics_from_database(DialogId dialog_id, MessageThreadDbMessageThreads message_threads,
+                                         Promise<td_api::object_ptr<td_api::forumTopics>> &&promise);
+
   void delete_topic_from_database(DialogId dialog_id, MessageId top_thread_message_id, Promise<Unit> &&promise);
 
   Td *td_;
@@ -308,6 +308,14 @@ string Global::get_option_string(Slice name, string default_value) const {
   return get_option_manager()->get_option_string(name, std::move(default_value));
 }
 
+bool Global::get_option_boolean(CachedOption option, bool default_value) const {
+  return get_option_manager()->get_option_boolean(option, default_value);
+}
+
+int64 Global::get_option_integer(CachedOption option, int64 default_value) const {
+  return get_option_manager()->get_option_integer(option, default_value);
+}
+
 int64 Global::get_location_key(double latitude, double longitude) {
   const double PI = 3.14159265358979323846;
   latitude *= PI / 180;
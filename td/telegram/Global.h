@@ -84,6 +84,9 @@ class UpdatesManager;
 class UserManager;
 class WebPagesManager;
 
+// frequently used options, values of which are cached and can be read from any thread without locks and parsing
+enum class CachedOption : int32 { IsPremium, MyId, PreferIpv6, SessionCount, UseQuickAck, UtcTimeOffset, Count };
+
 class Global final : public ActorContext {
  public:
   Global();
@@ -156,6 +159,10 @@ class Global final : public ActorContext {
 
   string get_option_string(Slice name, string default_value = "") const;
 
+  bool get_option_boolean(CachedOption option, bool default_value = false) const;
+
+  int64 get_option_integer(CachedOption option, int64 default_value = 0) const;
+
   bool is_server_time_reliable() const {
     return server_time_difference_was_updated_.load(std::memory_order_relaxed);
   }
@@ -571,7 +578,13 @@ class Global final : public ActorContext {
   }
 
   static Status request_aborted_error() {
-    return Status::Error(500, "Request aborted");
+    static const Status error = Status::StaticError(500, "Request aborted");
+    return error.clone();
+  }
+
+  static Status request_timeout_expired_error() {
+    static const Status error = Status::StaticError(408, "Request timeout expired");
+    return error.clone();
   }
 
   template <class T>
@@ -628,6 +641,14 @@ class Global final : public ActorContext {
 
   void notify_speed_limited(bool is_upload);
 
+  void on_network_query_shed() {
+    shed_network_query_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  int64 get_shed_network_query_count() const {
+    return shed_network_query_count_.load(std::memory_order_relaxed);
+  }
+
  private:
   std::shared_ptr<DhConfig> dh_config_;
 
@@ -699,6 +720,7 @@ class Global final : public ActorContext {
   std::atomic<bool> dns_time_difference_was_updated_{false};
   std::atomic<bool> close_flag_{false};
   std::atomic<double> system_time_saved_at_{-1e10};
+  std::atomic<int64> shed_network_query_count_{0};
   double saved_diff_ = 0.0;
   double saved_system_time_ = 0.0;
 
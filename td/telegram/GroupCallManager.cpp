@@ -952,7 +952,10 @@ struct GroupCallManager::GroupCall {
 };
 
 struct GroupCallManager::GroupCallParticipants {
-  vector<GroupCallParticipant> participants;
+  vector<GroupCallParticipant> participants;  // in an arbitrary order
+  // positions of the participants in the vector to avoid linear search in big group calls
+  FlatHashMap<DialogId, size_t, DialogIdHash> dialog_id_positions;
+  FlatHashMap<int32, size_t> audio_source_positions;
   string next_offset;
   GroupCallParticipantOrder min_order = GroupCallParticipantOrder::max();
   bool joined_date_asc = false;
@@ -966,6 +969,81 @@ struct GroupCallManager::GroupCallParticipants {
   };
   std::map<int32, PendingUpdates> pending_version_updates_;
   std::map<int32, PendingUpdates> pending_mute_updates_;
+
+  // returns participants.size() if the participant isn't found
+  size_t find_participant(DialogId dialog_id, bool is_self) const {
+    auto it = dialog_id_positions.find(dialog_id);
+    if (it != dialog_id_positions.end()) {
+      return it->second;
+    }
+    if (is_self) {
+      for (size_t i = 0; i < participants.size(); i++) {
+        if (participants[i].is_self) {
+          return i;
+        }
+      }
+    }
+    return participants.size();
+  }
+
+  GroupCallParticipant *get_participant_by_audio_source(int32 audio_source) {
+    auto it = audio_source_positions.find(audio_source);
+    if (it == audio_source_positions.end()) {
+      return nullptr;
+    }
+    return &participants[it->second];
+  }
+
+  void add_participant(GroupCallParticipant &&participant) {
+    participants.push_back(std::move(participant));
+    add_participant_position(participants.size() - 1);
+  }
+
+  void replace_participant(size_t pos, GroupCallParticipant &&participant) {
+    remove_participant_position(pos);
+    participants[pos] = std::move(participant);
+    add_participant_position(pos);
+  }
+
+  // moves the last participant to the position of the removed one
+  void remove_participant(size_t pos) {
+    CHECK(pos < participants.size());
+    remove_participant_position(pos);
+    auto last_pos = participants.size() - 1;
+    if (pos != last_pos) {
+      remove_participant_position(last_pos);
+      participants[pos] = std::move(participants[last_pos]);
+      add_participant_position(pos);
+    }
+    participants.pop_back();
+  }
+
+ private:
+  void add_participant_position(size_t pos) {
+    const auto &participant = participants[pos];
+    dialog_id_positions[participant.dialog_id] = pos;
+    for (auto audio_source : {participant.audio_source, participant.presentation_audio_source}) {
+      if (audio_source != 0) {
+        audio_source_positions[audio_source] = pos;
+      }
+    }
+  }
+
+  void remove_participant_position(size_t pos) {
+    const auto &participant = participants[pos];
+    auto it = dialog_id_positions.find(participant.dialog_id);
+    if (it != dialog_id_positions.end() && it->second == pos) {
+      dialog_id_positions.erase(it);
+    }
+    for (auto audio_source : {participant.audio_source, participant.presentation_audio_source}) {
+      if (audio_source != 0) {
+        auto source_it = audio_source_positions.find(audio_source);
+        if (source_it != audio_source_positions.end() && source_it->second == pos) {
+          audio_source_positions.erase(source_it);
+        }
+      }
+    }
+  }
 };
 
 struct GroupCallManager::GroupCallRecentSpeakers {
@@ -1709,10 +1787,9 @@ GroupCallParticipant *GroupCallManager::get_group_call_participant(GroupCallPart
       }
     }
   } else {
-    for (auto &group_call_participant : group_call_participants->participants) {
-      if (group_call_participant.dialog_id == dialog_id) {
-        return &group_call_participant;
-      }
+    auto pos = group_call_participants->find_participant(dialog_id, false);
+    if (pos != group_call_participants->participants.size()) {
+      return &group_call_participants->participants[pos];
     }
   }
   return nullptr;
@@ -2128,11 +2205,11 @@ void GroupCallManager::process_group_call_participants(
   if (is_sync) {
     auto *group_call_participants = add_group_call_participants(input_group_call_id);
     auto &group_participants = group_call_participants->participants;
-    for (auto participant_it = group_participants.begin(); participant_it != group_participants.end();) {
-      auto &participant = *participant_it;
+    for (size_t i = 0; i < group_participants.size();) {
+      auto &participant = group_participants[i];
       if (old_participant_dialog_ids.count(participant.dialog_id) == 0) {
         // successfully synced old user
-        ++participant_it;
+        i++;
         continue;
       }
 
@@ -2141,7 +2218,7 @@ void GroupCallManager::process_group_call_participants(
           participant.order = min_order;
           send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participants self");
         }
-        ++participant_it;
+        i++;
         continue;
       }
 
@@ -2153,7 +2230,7 @@ void GroupCallManager::process_group_call_participants(
       }
       on_remove_group_call_participant(input_group_call_id, participant.dialog_id);
       group_call_participants->local_unmuted_video_count -= participant.get_has_video();
-      participant_it = group_participants.erase(participant_it);
+      group_call_participants->remove_participant(i);
     }
     if (group_call_participants->min_order < min_order) {
       // if previously known more users, adjust min_order
@@ -2255,54 +2332,53 @@ std::pair<int32, int32> GroupCallManager::process_group_call_participant(InputGr
   bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
   bool can_manage = can_manage_group_call(input_group_call_id);
   auto *participants = add_group_call_participants(input_group_call_id);
-  for (size_t i = 0; i < participants->participants.size(); i++) {
-    auto &old_participant = participants->participants[i];
-    if (old_participant.dialog_id == participant.dialog_id || (old_participant.is_self && participant.is_self)) {
-      if (participant.joined_date == 0) {
-        LOG(INFO) << "Remove " << old_participant;
-        if (old_participant.order.is_valid()) {
-          send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant remove");
-        }
-        on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
-        remove_recent_group_call_speaker(input_group_call_id, old_participant.dialog_id);
-        int32 unmuted_video_diff = -old_participant.get_has_video();
-        participants->local_unmuted_video_count += unmuted_video_diff;
-        participants->participants.erase(participants->participants.begin() + i);
-        return {-1, unmuted_video_diff};
+  auto old_participant_pos = participants->find_participant(participant.dialog_id, participant.is_self);
+  if (old_participant_pos != participants->participants.size()) {
+    auto &old_participant = participants->participants[old_participant_pos];
+    if (participant.joined_date == 0) {
+      LOG(INFO) << "Remove " << old_participant;
+      if (old_participant.order.is_valid()) {
+        send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant remove");
       }
+      on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
+      remove_recent_group_call_speaker(input_group_call_id, old_participant.dialog_id);
+      int32 unmuted_video_diff = -old_participant.get_has_video();
+      participants->local_unmuted_video_count += unmuted_video_diff;
+      participants->remove_participant(old_participant_pos);
+      return {-1, unmuted_video_diff};
+    }
 
-      if (old_participant.version > participant.version) {
-        LOG(INFO) << "Ignore outdated update of " << old_participant.dialog_id;
-        return {0, 0};
-      }
+    if (old_participant.version > participant.version) {
+      LOG(INFO) << "Ignore outdated update of " << old_participant.dialog_id;
+      return {0, 0};
+    }
 
-      if (old_participant.dialog_id != participant.dialog_id) {
-        on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
-        on_add_group_call_participant(input_group_call_id, participant.dialog_id);
-      }
+    if (old_participant.dialog_id != participant.dialog_id) {
+      on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
+      on_add_group_call_participant(input_group_call_id, participant.dialog_id);
+    }
 
-      participant.update_from(old_participant);
+    participant.update_from(old_participant);
 
-      participant.is_just_joined = false;
-      participant.order = get_real_participant_order(can_self_unmute, participant, participants);
-      update_group_call_participant_can_be_muted(can_manage, participants, participant);
+    participant.is_just_joined = false;
+    participant.order = get_real_participant_order(can_self_unmute, participant, participants);
+    update_group_call_participant_can_be_muted(can_manage, participants, participant);
 
-      LOG(INFO) << "Edit " << old_participant << " to " << participant;
-      if (old_participant != participant && (old_participant.order.is_valid() || participant.order.is_valid())) {
-        send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant edit");
-        if (old_participant.dialog_id != participant.dialog_id) {
-          // delete old self-participant; shouldn't affect correct apps
-          old_participant.order = GroupCallParticipantOrder();
-          send_update_group_call_participant(input_group_call_id, old_participant,
-                                             "process_group_call_participant edit self");
-        }
+    LOG(INFO) << "Edit " << old_participant << " to " << participant;
+    if (old_participant != participant && (old_participant.order.is_valid() || participant.order.is_valid())) {
+      send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant edit");
+      if (old_participant.dialog_id != participant.dialog_id) {
+        // delete old self-participant; shouldn't affect correct apps
+        old_participant.order = GroupCallParticipantOrder();
+        send_update_group_call_participant(input_group_call_id, old_participant,
+                                           "process_group_call_participant edit self");
       }
-      on_participant_speaking_in_group_call(input_group_call_id, participant);
-      int32 unmuted_video_diff = participant.get_has_video() - old_participant.get_has_video();
-      participants->local_unmuted_video_count += unmuted_video_diff;
-      old_participant = std::move(participant);
-      return {0, unmuted_video_diff};
     }
+    on_participant_speaking_in_group_call(input_group_call_id, participant);
+    int32 unmuted_video_diff = participant.get_has_video() - old_participant.get_has_video();
+    participants->local_unmuted_video_count += unmuted_video_diff;
+    participants->replace_participant(old_participant_pos, std::move(participant));
+    return {0, unmuted_video_diff};
   }
 
   if (participant.joined_date == 0) {
@@ -2322,7 +2398,7 @@ std::pair<int32, int32> GroupCallManager::process_group_call_participant(InputGr
   participant.is_just_joined = false;
   participants->local_unmuted_video_count += participant.get_has_video();
   update_group_call_participant_can_be_muted(can_manage, participants, participant);
-  participants->participants.push_back(std::move(participant));
+  participants->add_participant(std::move(participant));
   if (participants->participants.back().order.is_valid()) {
     send_update_group_call_participant(input_group_call_id, participants->participants.back(),
                                        "process_group_call_participant add");
@@ -4633,30 +4709,30 @@ DialogId GroupCallManager::set_group_call_participant_is_speaking_by_source(Inpu
     return DialogId();
   }
 
-  for (auto &participant : participants_it->second->participants) {
-    if (participant.audio_source == audio_source || participant.presentation_audio_source == audio_source) {
-      if (is_speaking && participant.get_is_muted_by_admin()) {
-        // don't allow to show as speaking muted by admin participants
-        return DialogId();
-      }
-      if (participant.is_speaking != is_speaking) {
-        participant.is_speaking = is_speaking;
-        if (is_speaking) {
-          participant.local_active_date = max(participant.local_active_date, date);
-        }
-        bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
-        auto old_order = participant.order;
-        participant.order = get_real_participant_order(can_self_unmute, participant, participants_it->second.get());
-        if (participant.order.is_valid() || old_order.is_valid()) {
-          send_update_group_call_participant(input_group_call_id, participant,
-                                             "set_group_call_participant_is_speaking_by_source");
-        }
-      }
-
-      return participant.dialog_id;
+  auto *participant_ptr = participants_it->second->get_participant_by_audio_source(audio_source);
+  if (participant_ptr == nullptr) {
+    return DialogId();
+  }
+  auto &participant = *participant_ptr;
+  if (is_speaking && participant.get_is_muted_by_admin()) {
+    // don't allow to show as speaking muted by admin participants
+    return DialogId();
+  }
+  if (participant.is_speaking != is_speaking) {
+    participant.is_speaking = is_speaking;
+    if (is_speaking) {
+      participant.local_active_date = max(participant.local_active_date, date);
+    }
+    bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
+    auto old_order = participant.order;
+    participant.order = get_real_participant_order(can_self_unmute, participant, participants_it->second.get());
+    if (participant.order.is_valid() || old_order.is_valid()) {
+      send_update_group_call_participant(input_group_call_id, participant,
+                                         "set_group_call_participant_is_speaking_by_source");
     }
   }
-  return DialogId();
+
+  return participant.dialog_id;
 }
 
 bool GroupCallManager::set_group_call_participant_count(GroupCall *group_call, int32 count, const char *source,
@@ -35,8 +35,7 @@ void HashtagHints::hashtag_used(const string &hashtag) {
     return;
   }
   hashtag_used_impl(hashtag);
-  G()->td_db()->get_sqlite_pmc()->set(get_key(), serialize(keys_to_strings(hints_.search_empty(101).second)),
-                                      Promise<>());
+  schedule_save();
 }
 
 void HashtagHints::remove_hashtag(string hashtag, Promise<> promise) {
@@ -50,12 +49,35 @@ void HashtagHints::remove_hashtag(string hashtag, Promise<> promise) {
   auto key = Hash<string>()(hashtag);
   if (hints_.has_key(key)) {
     hints_.remove(key);
-    G()->td_db()->get_sqlite_pmc()->set(get_key(), serialize(keys_to_strings(hints_.search_empty(101).second)),
-                                        Promise<>());
-    promise.set_value(Unit());  // set promise explicitly, because sqlite_pmc waits for too long before setting promise
-  } else {
-    promise.set_value(Unit());
+    schedule_save();
+  }
+  promise.set_value(Unit());
+}
+
+void HashtagHints::timeout_expired() {
+  save();
+}
+
+void HashtagHints::hangup() {
+  save();
+  stop();
+}
+
+// hashtags can be used many times per second, so the hints are saved to the database at most once per SAVE_DELAY
+void HashtagHints::schedule_save() {
+  if (!need_save_) {
+    need_save_ = true;
+    set_lazy_timeout_in(SAVE_DELAY);
+  }
+}
+
+void HashtagHints::save() {
+  if (!need_save_) {
+    return;
   }
+  need_save_ = false;
+  G()->td_db()->get_sqlite_pmc()->set(get_key(), serialize(keys_to_strings(hints_.search_empty(101).second)),
+                                      Promise<>());
 }
 
 void HashtagHints::query(const string &prefix, int32 limit, Promise<std::vector<string>> promise) {
@@ -26,9 +26,12 @@ class HashtagHints final : public Actor {
   void query(const string &prefix, int32 limit, Promise<std::vector<string>> promise);
 
  private:
+  static constexpr double SAVE_DELAY = 5.0;
+
   string mode_;
   Hints hints_;
   bool sync_with_db_ = false;
+  bool need_save_ = false;
   int64 counter_ = 0;
 
   ActorShared<> parent_;
@@ -37,6 +40,14 @@ class HashtagHints final : public Actor {
 
   void start_up() final;
 
+  void timeout_expired() final;
+
+  void hangup() final;
+
+  void schedule_save();
+
+  void save();
+
   void hashtag_used_impl(const string &hashtag);
   void from_db(Result<string> data, bool dummy);
   std::vector<string> keys_to_strings(const std::vector<int64> &keys);
@@ -21,12 +21,14 @@
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 
 #include <atomic>
 #include <limits>
 #include <map>
+#include <memory>
 #include <utility>
 
 namespace td {
@@ -50,19 +52,63 @@ struct LanguagePackManager::PluralizedString {
   }
 };
 
+// immutable snapshot of strings of a language; changes are applied to a copy, which then replaces the snapshot
+struct LanguagePackManager::LanguageStrings {
+  bool is_full_ = false;
+  FlatHashMap<string, string> ordinary_strings_;
+  FlatHashMap<string, std::shared_ptr<const PluralizedString>> pluralized_strings_;
+  FlatHashSet<string> deleted_strings_;
+
+  std::shared_ptr<LanguageStrings> clone() const {
+    auto result = std::make_shared<LanguageStrings>();
+    result->is_full_ = is_full_;
+    for (auto &it : ordinary_strings_) {
+      result->ordinary_strings_.emplace(it.first, it.second);
+    }
+    for (auto &it : pluralized_strings_) {
+      result->pluralized_strings_.emplace(it.first, it.second);
+    }
+    for (auto &key : deleted_strings_) {
+      result->deleted_strings_.insert(key);
+    }
+    return result;
+  }
+};
+
 struct LanguagePackManager::Language {
-  std::mutex mutex_;
+  std::mutex mutex_;  // must be held to change strings_, but isn't needed to read them
   std::atomic<int32> version_{-1};
   std::atomic<int32> key_count_{0};
   std::string base_language_code_;
-  bool is_full_ = false;
   bool was_loaded_full_ = false;
   bool has_get_difference_query_ = false;
   vector<Promise<Unit>> get_difference_queries_;
-  FlatHashMap<string, string> ordinary_strings_;
-  FlatHashMap<string, unique_ptr<PluralizedString>> pluralized_strings_;
-  FlatHashSet<string> deleted_strings_;
   SqliteKeyValue kv_;  // usages must be guarded by database_->mutex_
+
+  std::shared_ptr<const LanguageStrings> get_strings() const {
+#if !TD_HAVE_ATOMIC_SHARED_PTR
+    std::lock_guard<std::mutex> guard(strings_mutex_);
+    auto res = strings_;
+    return res;
+#else
+    return atomic_load(&strings_);
+#endif
+  }
+
+  void set_strings(std::shared_ptr<const LanguageStrings> new_strings) {
+#if !TD_HAVE_ATOMIC_SHARED_PTR
+    std::lock_guard<std::mutex> guard(strings_mutex_);
+    strings_ = std::move(new_strings);
+#else
+    atomic_store(&strings_, std::move(new_strings));
+#endif
+  }
+
+ private:
+#if !TD_HAVE_ATOMIC_SHARED_PTR
+  mutable std::mutex strings_mutex_;  // guards only the pointer, so it is never held for long
+#endif
+  std::shared_ptr<const LanguageStrings> strings_ = std::make_shared<const LanguageStrings>();
 };
 
 struct LanguagePackManager::LanguageInfo {
@@ -539,6 +585,26 @@ void LanguagePackManager::inc_generation() {
   LOG(INFO) << "Finished to apply new language pack";
 }
 
+std::pair<LanguagePackManager::LanguageDatabase *, LanguagePackManager::Language *>
+LanguagePackManager::get_cached_language(const string &database_path, const string &language_pack,
+                                         const string &language_code) {
+  // databases and languages are never deleted, so pointers to them can be cached without synchronization
+  static TD_THREAD_LOCAL FlatHashMap<string, std::pair<LanguageDatabase *, Language *>> *languages;
+  init_thread_local<FlatHashMap<string, std::pair<LanguageDatabase *, Language *>>>(languages);
+
+  auto &result = (*languages)[PSTRING() << database_path << '\0' << language_pack << '\0' << language_code];
+  if (result.second == nullptr) {
+    std::unique_lock<std::mutex> language_databases_lock(language_database_mutex_);
+    result.first = add_language_database(database_path);
+    CHECK(result.first != nullptr);
+    language_databases_lock.unlock();
+
+    result.second = add_language(result.first, language_pack, language_code);
+    CHECK(result.second != nullptr);
+  }
+  return result;
+}
+
 LanguagePackManager::Language *LanguagePackManager::get_language(LanguageDatabase *database,
                                                                  const string &language_pack,
                                                                  const string &language_code) {
@@ -673,51 +739,46 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
   return code_it->second.get();
 }
 
-bool LanguagePackManager::language_has_string_unsafe(const Language *language, const string &key) {
-  return language->ordinary_strings_.count(key) != 0 || language->pluralized_strings_.count(key) != 0 ||
-         language->deleted_strings_.count(key) != 0;
+bool LanguagePackManager::language_has_string(const LanguageStrings &strings, const string &key) {
+  return strings.ordinary_strings_.count(key) != 0 || strings.pluralized_strings_.count(key) != 0 ||
+         strings.deleted_strings_.count(key) != 0;
 }
 
-bool LanguagePackManager::language_has_strings(Language *language, const vector<string> &keys) {
-  if (language == nullptr) {
-    return false;
-  }
-
-  std::lock_guard<std::mutex> lock(language->mutex_);
-  if (language->is_full_) {
+bool LanguagePackManager::language_has_strings(const LanguageStrings &strings, const vector<string> &keys) {
+  if (strings.is_full_) {
     return true;
   }
   if (keys.empty()) {
     return false;  // language is already checked to be not full
   }
   for (auto &key : keys) {
-    if (!language_has_string_unsafe(language, key)) {
+    if (!language_has_string(strings, key)) {
       return false;
     }
   }
   return true;
 }
 
-void LanguagePackManager::load_language_string_unsafe(Language *language, const string &key, const string &value) {
+void LanguagePackManager::load_language_string(LanguageStrings &strings, const string &key, const string &value) {
   CHECK(is_valid_key(key));
   if (value[0] == '1') {
-    language->ordinary_strings_.emplace(key, value.substr(1));
+    strings.ordinary_strings_.emplace(key, value.substr(1));
     return;
   }
 
   if (value[0] == '2') {
     auto all = full_split(Slice(value).substr(1), '\x00');
     if (all.size() == 6) {
-      language->pluralized_strings_.emplace(
-          key, td::make_unique<PluralizedString>(all[0].str(), all[1].str(), all[2].str(), all[3].str(), all[4].str(),
-                                                 all[5].str()));
+      strings.pluralized_strings_.emplace(
+          key, std::make_shared<const PluralizedString>(all[0].str(), all[1].str(), all[2].str(), all[3].str(),
+                                                        all[4].str(), all[5].str()));
       return;
     }
   }
 
   LOG_IF(ERROR, !value.empty() && value != "3") << "Have invalid value \"" << value << '"';
-  if (!language->is_full_) {
-    language->deleted_strings_.insert(key);
+  if (!strings.is_full_) {
+    strings.deleted_strings_.insert(key);
   }
 }
 
@@ -729,7 +790,8 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
 
   std::lock_guard<std::mutex> database_lock(database->mutex_);
   std::lock_guard<std::mutex> language_lock(language->mutex_);
-  if (language->is_full_) {
+  auto old_strings = language->get_strings();
+  if (old_strings->is_full_) {
     LOG(DEBUG) << "The language pack is already full in memory";
     return true;
   }
@@ -744,31 +806,35 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
       return false;
     }
 
+    auto new_strings = old_strings->clone();
     auto all_strings = language->kv_.get_all();
     for (auto &str : all_strings) {
       if (str.first[0] == '!') {
         continue;
       }
 
-      if (!language_has_string_unsafe(language, str.first)) {
+      if (!language_has_string(*new_strings, str.first)) {
         LOG(DEBUG) << "Load string with key " << str.first << " from database";
-        load_language_string_unsafe(language, str.first, str.second);
+        load_language_string(*new_strings, str.first, str.second);
       }
     }
     language->was_loaded_full_ = true;
 
     if (language->version_ == -1) {
+      language->set_strings(std::move(new_strings));
       return false;
     }
 
-    language->is_full_ = true;
-    language->deleted_strings_.clear();
+    new_strings->is_full_ = true;
+    new_strings->deleted_strings_.clear();
+    language->set_strings(std::move(new_strings));
     return true;
   }
 
+  std::shared_ptr<LanguageStrings> new_strings;  // created only if there are strings to load
   bool have_all = true;
   for (auto &key : keys) {
-    if (!language_has_string_unsafe(language, key)) {
+    if (!language_has_string(new_strings == nullptr ? *old_strings : *new_strings, key)) {
       auto value = language->kv_.get(key);
       if (value.empty()) {
         if (language->version_ == -1) {
@@ -780,9 +846,15 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
         // have full language in the database, so this string is just deleted
       }
       LOG(DEBUG) << "Load string with key " << key << " from database";
-      load_language_string_unsafe(language, key, value);
+      if (new_strings == nullptr) {
+        new_strings = old_strings->clone();
+      }
+      load_language_string(*new_strings, key, value);
     }
   }
+  if (new_strings != nullptr) {
+    language->set_strings(std::move(new_strings));
+  }
   return have_all;
 }
 
@@ -816,41 +888,37 @@ td_api::object_ptr<td_api::languagePackString> LanguagePackManager::get_language
 }
 
 td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_language_pack_string_value_object(
-    const Language *language, const string &key) {
-  CHECK(language != nullptr);
-  auto ordinary_it = language->ordinary_strings_.find(key);
-  if (ordinary_it != language->ordinary_strings_.end()) {
+    const LanguageStrings &strings, const string &key) {
+  auto ordinary_it = strings.ordinary_strings_.find(key);
+  if (ordinary_it != strings.ordinary_strings_.end()) {
     return get_language_pack_string_value_object(ordinary_it->second);
   }
-  auto pluralized_it = language->pluralized_strings_.find(key);
-  if (pluralized_it != language->pluralized_strings_.end()) {
+  auto pluralized_it = strings.pluralized_strings_.find(key);
+  if (pluralized_it != strings.pluralized_strings_.end()) {
     return get_language_pack_string_value_object(*pluralized_it->second);
   }
-  LOG_IF(ERROR, !language->is_full_ && language->deleted_strings_.count(key) == 0) << "Have no string for key " << key;
+  LOG_IF(ERROR, !strings.is_full_ && strings.deleted_strings_.count(key) == 0) << "Have no string for key " << key;
   return get_language_pack_string_value_object();
 }
 
 td_api::object_ptr<td_api::languagePackString> LanguagePackManager::get_language_pack_string_object(
-    const Language *language, const string &key) {
-  return td_api::make_object<td_api::languagePackString>(key, get_language_pack_string_value_object(language, key));
+    const LanguageStrings &strings, const string &key) {
+  return td_api::make_object<td_api::languagePackString>(key, get_language_pack_string_value_object(strings, key));
 }
 
 td_api::object_ptr<td_api::languagePackStrings> LanguagePackManager::get_language_pack_strings_object(
-    Language *language, const vector<string> &keys) {
-  CHECK(language != nullptr);
-
-  std::lock_guard<std::mutex> lock(language->mutex_);
+    const LanguageStrings &language_strings, const vector<string> &keys) {
   vector<td_api::object_ptr<td_api::languagePackString>> strings;
   if (keys.empty()) {
-    for (auto &str : language->ordinary_strings_) {
+    for (auto &str : language_strings.ordinary_strings_) {
       strings.push_back(get_language_pack_string_object(str.first, str.second));
     }
-    for (auto &str : language->pluralized_strings_) {
+    for (auto &str : language_strings.pluralized_strings_) {
       strings.push_back(get_language_pack_string_object(str.first, *str.second));
     }
   } else {
     for (auto &key : keys) {
-      strings.push_back(get_language_pack_string_object(language, key));
+      strings.push_back(get_language_pack_string_object(language_strings, key));
     }
   }
 
@@ -1106,11 +1174,11 @@ void LanguagePackManager::get_language_pack_strings(string language_code, vector
   }
 
   Language *language = add_language(database_, language_pack_, language_code);
-  if (language_has_strings(language, keys)) {
-    return promise.set_value(get_language_pack_strings_object(language, keys));
+  if (language_has_strings(*language->get_strings(), keys)) {
+    return promise.set_value(get_language_pack_strings_object(*language->get_strings(), keys));
   }
   if (load_language_strings(database_, language, keys)) {
-    return promise.set_value(get_language_pack_strings_object(language, keys));
+    return promise.set_value(get_language_pack_strings_object(*language->get_strings(), keys));
   }
 
   if (is_custom_language_code(language_code)) {
@@ -1272,20 +1340,16 @@ td_api::object_ptr<td_api::Object> LanguagePackManager::get_language_pack_string
     return td_api::make_object<td_api::error>(400, "Key is invalid");
   }
 
-  std::unique_lock<std::mutex> language_databases_lock(language_database_mutex_);
-  LanguageDatabase *database = add_language_database(database_path);
-  CHECK(database != nullptr);
-  language_databases_lock.unlock();
-
-  Language *language = add_language(database, language_pack, language_code);
+  auto database_language = get_cached_language(database_path, language_pack, language_code);
+  LanguageDatabase *database = database_language.first;
+  Language *language = database_language.second;
   vector<string> keys{key};
-  if (language_has_strings(language, keys)) {
-    std::lock_guard<std::mutex> lock(language->mutex_);
-    return get_language_pack_string_value_object(language, key);
+  auto strings = language->get_strings();
+  if (language_has_strings(*strings, keys)) {
+    return get_language_pack_string_value_object(*strings, key);
   }
   if (load_language_strings(database, language, keys)) {
-    std::lock_guard<std::mutex> lock(language->mutex_);
-    return get_language_pack_string_value_object(language, key);
+    return get_language_pack_string_value_object(*language->get_strings(), key);
   }
   return td_api::make_object<td_api::error>(404, "Not Found");
 }
@@ -1365,6 +1429,7 @@ void LanguagePackManager::on_get_language_pack_strings(
     int32 key_count_delta = 0;
     if (language->version_ < version || !keys.empty()) {
       auto is_first = language->version_ == -1;
+      auto new_strings = language->get_strings()->clone();
       vector<td_api::object_ptr<td_api::languagePackString>> strings;
       if (language->version_ < version) {
         LOG(INFO) << "Set language pack " << language_code << " version to " << version;
@@ -1382,15 +1447,15 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
-            auto it = language->ordinary_strings_.find(str->key_);
-            if (it == language->ordinary_strings_.end()) {
+            auto it = new_strings->ordinary_strings_.find(str->key_);
+            if (it == new_strings->ordinary_strings_.end()) {
               key_count_delta++;
-              it = language->ordinary_strings_.emplace(str->key_, std::move(str->value_)).first;
+              it = new_strings->ordinary_strings_.emplace(str->key_, std::move(str->value_)).first;
             } else {
               it->second = std::move(str->value_);
             }
-            key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
-            language->deleted_strings_.erase(str->key_);
+            key_count_delta -= static_cast<int32>(new_strings->pluralized_strings_.erase(str->key_));
+            new_strings->deleted_strings_.erase(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(it->first, it->second));
             }
@@ -1403,18 +1468,18 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
-            auto value = td::make_unique<PluralizedString>(std::move(str->zero_value_), std::move(str->one_value_),
-                                                           std::move(str->two_value_), std::move(str->few_value_),
-                                                           std::move(str->many_value_), std::move(str->other_value_));
-            auto it = language->pluralized_strings_.find(str->key_);
-            if (it == language->pluralized_strings_.end()) {
+            auto value = std::make_shared<const PluralizedString>(
+                std::move(str->zero_value_), std::move(str->one_value_), std::move(str->two_value_),
+                std::move(str->few_value_), std::move(str->many_value_), std::move(str->other_value_));
+            auto it = new_strings->pluralized_strings_.find(str->key_);
+            if (it == new_strings->pluralized_strings_.end()) {
               key_count_delta++;
-              it = language->pluralized_strings_.emplace(str->key_, std::move(value)).first;
+              it = new_strings->pluralized_strings_.emplace(str->key_, std::move(value)).first;
             } else {
               it->second = std::move(value);
             }
-            key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
-            language->deleted_strings_.erase(str->key_);
+            key_count_delta -= static_cast<int32>(new_strings->ordinary_strings_.erase(str->key_));
+            new_strings->deleted_strings_.erase(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(it->first, *it->second));
             }
@@ -1431,9 +1496,9 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
-            key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
-            key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
-            language->deleted_strings_.insert(str->key_);
+            key_count_delta -= static_cast<int32>(new_strings->ordinary_strings_.erase(str->key_));
+            key_count_delta -= static_cast<int32>(new_strings->pluralized_strings_.erase(str->key_));
+            new_strings->deleted_strings_.insert(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(str->key_));
             }
@@ -1445,11 +1510,11 @@ void LanguagePackManager::on_get_language_pack_strings(
             break;
         }
       }
-      if (!language->is_full_) {
+      if (!new_strings->is_full_) {
         for (const auto &key : keys) {
-          if (!language_has_string_unsafe(language, key)) {
+          if (!language_has_string(*new_strings, key)) {
             LOG(ERROR) << "Doesn't receive key " << key << " from server";
-            language->deleted_strings_.insert(key);
+            new_strings->deleted_strings_.insert(key);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(key));
             }
@@ -1465,10 +1530,11 @@ void LanguagePackManager::on_get_language_pack_strings(
 
       if (keys.empty() && !is_diff) {
         CHECK(new_database_version >= 0);
-        language->is_full_ = true;
-        language->deleted_strings_.clear();
+        new_strings->is_full_ = true;
+        new_strings->deleted_strings_.clear();
       }
-      new_is_full = language->is_full_;
+      new_is_full = new_strings->is_full_;
+      language->set_strings(std::move(new_strings));
 
       if (is_diff || (new_is_full && is_first)) {
         send_closure(
@@ -1507,7 +1573,7 @@ void LanguagePackManager::on_get_language_pack_strings(
   }
 
   if (promise) {
-    promise.set_value(get_language_pack_strings_object(language, keys));
+    promise.set_value(get_language_pack_strings_object(*language->get_strings(), keys));
   }
 }
 
@@ -1852,10 +1918,7 @@ Status LanguagePackManager::do_delete_language(const string &language_code) {
   std::lock_guard<std::mutex> language_lock(language->mutex_);
   language->version_ = -1;
   language->key_count_ = load_database_language_key_count(&language->kv_);
-  language->is_full_ = false;
-  language->ordinary_strings_.clear();
-  language->pluralized_strings_.clear();
-  language->deleted_strings_.clear();
+  language->set_strings(std::make_shared<const LanguageStrings>());
 
   if (!pack->pack_kv_.empty()) {
     pack->pack_kv_.erase(language_code);
@@ -85,6 +85,7 @@ class LanguagePackManager final : public NetQueryCallback {
 
  private:
   struct PluralizedString;
+  struct LanguageStrings;
   struct Language;
   struct LanguageInfo;
   struct LanguagePack;
@@ -115,10 +116,14 @@ class LanguagePackManager final : public NetQueryCallback {
 
   static Language *add_language(LanguageDatabase *database, const string &language_pack, const string &language_code);
 
-  static bool language_has_string_unsafe(const Language *language, const string &key);
-  static bool language_has_strings(Language *language, const vector<string> &keys);
+  static std::pair<LanguageDatabase *, Language *> get_cached_language(const string &database_path,
+                                                                       const string &language_pack,
+                                                                       const string &language_code);
 
-  static void load_language_string_unsafe(Language *language, const string &key, const string &value);
+  static bool language_has_string(const LanguageStrings &strings, const string &key);
+  static bool language_has_strings(const LanguageStrings &strings, const vector<string> &keys);
+
+  static void load_language_string(LanguageStrings &strings, const string &key, const string &value);
   static bool load_language_strings(LanguageDatabase *database, Language *language, const vector<string> &keys);
 
   static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object(const string &value);
@@ -133,13 +138,13 @@ class LanguagePackManager final : public NetQueryCallback {
   static td_api::object_ptr<td_api::languagePackString> get_language_pack_string_object(const string &key);
 
   static td_api::object_ptr<td_api::LanguagePackStringValue> get_language_pack_string_value_object(
-      const Language *language, const string &key);
+      const LanguageStrings &strings, const string &key);
 
-  static td_api::object_ptr<td_api::languagePackString> get_language_pack_string_object(const Language *language,
+  static td_api::object_ptr<td_api::languagePackString> get_language_pack_string_object(const LanguageStrings &strings,
                                                                                         const string &key);
 
-  static td_api::object_ptr<td_api::languagePackStrings> get_language_pack_strings_object(Language *language,
-                                                                                          const vector<string> &keys);
+  static td_api::object_ptr<td_api::languagePackStrings> get_language_pack_strings_object(
+      const LanguageStrings &strings, const vector<string> &keys);
 
   static td_api::object_ptr<td_api::languagePackInfo> get_language_pack_info_object(const string &language_code,
                                                                                     const LanguageInfo &info);
@@ -1011,18 +1011,6 @@ void LinkManager::tear_down() {
   parent_.reset();
 }
 
-static bool tolower_begins_with(Slice str, Slice prefix) {
-  if (prefix.size() > str.size()) {
-    return false;
-  }
-  for (size_t i = 0; i < prefix.size(); i++) {
-    if (to_lower(str[i]) != prefix[i]) {
-      return false;
-    }
-  }
-  return true;
-}
-
 Result<string> LinkManager::check_link(CSlice link, bool http_only, bool https_only) {
   auto result = check_link_impl(link, http_only, https_only);
   if (result.is_ok()) {
@@ -1105,7 +1093,7 @@ LinkManager::LinkInfo LinkManager::get_link_info(Slice link) {
     is_tg = true;
   }
 
-  auto r_http_url = parse_url(link);
+  auto r_http_url = parse_url_parts(link);
   if (r_http_url.is_error()) {
     return result;
   }
@@ -1129,69 +1117,77 @@ LinkManager::LinkInfo LinkManager::get_link_info(Slice link) {
       return result;
     }
 
-    auto host = url_decode(http_url.host_, false);
-    to_lower_inplace(host);
-    if (ends_with(host, ".t.me") && host.size() >= 9 && host.find('.') == host.size() - 5) {
-      Slice subdomain(&host[0], host.size() - 5);
+    // the host is compared case-insensitively and needs to be copied only if it has percent-encoded symbols
+    Slice host = http_url.host_;
+    string decoded_host;
+    if (host.find('%') != Slice::npos) {
+      decoded_host = url_decode(host, false);
+      host = decoded_host;
+    }
+    if (tolower_ends_with(host, ".t.me") && host.size() >= 9 && host.find('.') == host.size() - 5) {
+      auto subdomain = to_lower(host.substr(0, host.size() - 5));
       static const FlatHashSet<Slice, SliceHash> disallowed_subdomains(
           {"addemoji",    "addlist",  "addstickers", "addtheme", "auth",  "boost", "confirmphone",
            "contact",     "giftcode", "invoice",     "joinchat", "login", "m",     "proxy",
            "setlanguage", "share",    "socks",       "web",      "a",     "k",     "z"});
       if (is_valid_username(subdomain) && disallowed_subdomains.count(subdomain) == 0) {
         result.type_ = LinkType::TMe;
-        result.query_ = PSTRING() << '/' << subdomain << http_url.query_;
+        result.query_ = PSTRING() << '/' << subdomain << http_url.get_normalized_query();
         return result;
       }
     }
-    if (begins_with(host, "www.")) {
-      host = host.substr(4);
+    if (tolower_begins_with(host, "www.")) {
+      host.remove_prefix(4);
     }
 
-    string cur_t_me_url;
-    vector<Slice> t_me_urls{Slice("t.me"), Slice("telegram.me"), Slice("telegram.dog")};
+    static const Slice T_ME_HOSTS[] = {
+      "t.me", "telegram.me", "telegram.dog",
 #if TD_EMSCRIPTEN
-    t_me_urls.push_back(Slice("web.t.me"));
-    t_me_urls.push_back(Slice("a.t.me"));
-    t_me_urls.push_back(Slice("k.t.me"));
-    t_me_urls.push_back(Slice("z.t.me"));
+      "web.t.me", "a.t.me", "k.t.me", "z.t.me",
 #endif
-    if (Scheduler::context() != nullptr) {  // for tests only
-      cur_t_me_url = G()->get_option_string("t_me_url");
+    };
+    bool is_t_me_host = false;
+    for (auto t_me_host : T_ME_HOSTS) {
+      if (tolower_equals(host, t_me_host)) {
+        is_t_me_host = true;
+        break;
+      }
+    }
+    if (!is_t_me_host && Scheduler::context() != nullptr) {  // for tests only
+      auto cur_t_me_url = G()->get_option_string("t_me_url");
       if (tolower_begins_with(cur_t_me_url, "http://") || tolower_begins_with(cur_t_me_url, "https://")) {
-        Slice t_me_url = cur_t_me_url;
-        t_me_url = t_me_url.substr(t_me_url[4] == 's' ? 8 : 7);
-        if (!td::contains(t_me_urls, t_me_url)) {
-          t_me_urls.push_back(t_me_url);
-        }
+        Slice t_me_host = cur_t_me_url;
+        t_me_host = t_me_host.substr(t_me_host[4] == 's' ? 8 : 7);
+        is_t_me_host = tolower_equals(host, t_me_host);
       }
     }
 
-    for (auto t_me_url : t_me_urls) {
-      if (host == t_me_url) {
-        result.type_ = LinkType::TMe;
+    if (is_t_me_host) {
+      result.type_ = LinkType::TMe;
 
-        Slice query = http_url.query_;
-        while (true) {
-          if (begins_with(query, "/s/")) {
-            query.remove_prefix(2);
-            continue;
-          }
-          if (begins_with(query, "/%73/")) {
-            query.remove_prefix(4);
-            continue;
-          }
-          break;
+      auto query_str = http_url.get_normalized_query();
+      Slice query = query_str;
+      while (true) {
+        if (begins_with(query, "/s/")) {
+          query.remove_prefix(2);
+          continue;
         }
-        result.query_ = query.str();
-        return result;
+        if (begins_with(query, "/%73/")) {
+          query.remove_prefix(4);
+          continue;
+        }
+        break;
       }
+      result.query_ = query.str();
+      return result;
     }
 
-    if (http_url.query_.size() > 1) {
-      for (auto telegraph_url : {Slice("telegra.ph"), Slice("te.legra.ph"), Slice("graph.org")}) {
-        if (host == telegraph_url) {
+    // the normalized query must be longer than "/"
+    if (http_url.query_.size() > 1 || (http_url.query_.size() == 1 && http_url.query_[0] != '/')) {
+      for (auto telegraph_host : {Slice("telegra.ph"), Slice("te.legra.ph"), Slice("graph.org")}) {
+        if (tolower_equals(host, telegraph_host)) {
           result.type_ = LinkType::Telegraph;
-          result.query_ = std::move(http_url.query_);
+          result.query_ = http_url.get_normalized_query();
           return result;
         }
       }
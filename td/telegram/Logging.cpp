@@ -15,6 +15,7 @@
 #include "td/telegram/net/DcAuthManager.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/NotificationManager.h"
+#include "td/telegram/StartupTrace.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/UpdatesManager.h"
 
@@ -30,6 +31,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/BinaryFileLog.h"
 #include "td/utils/ExitGuard.h"
 #include "td/utils/FileLog.h"
 #include "td/utils/logging.h"
@@ -48,6 +50,9 @@ static std::mutex logging_mutex;
 static FileLog file_log;
 static TsLog ts_log(&file_log);
 static NullLog null_log;
+#if !TD_THREAD_UNSUPPORTED
+static BinaryFileLog binary_file_log;
+#endif
 static ExitGuard exit_guard;
 
 #define ADD_TAG(tag) \
@@ -57,7 +62,8 @@ static const std::map<Slice, int *> log_tags{
     ADD_TAG(proxy),       ADD_TAG(net_query),        ADD_TAG(td_requests),   ADD_TAG(dc),
     ADD_TAG(file_loader), ADD_TAG(mtproto),          ADD_TAG(raw_mtproto),   ADD_TAG(fd),
     ADD_TAG(actor),       ADD_TAG(sqlite),           ADD_TAG(notifications), ADD_TAG(get_difference),
-    ADD_TAG(file_gc),     ADD_TAG(config_recoverer), ADD_TAG(dns_resolver),  ADD_TAG(file_references)};
+    ADD_TAG(file_gc),     ADD_TAG(config_recoverer), ADD_TAG(dns_resolver),  ADD_TAG(file_references),
+    ADD_TAG(startup)};
 #undef ADD_TAG
 
 Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream) {
@@ -83,6 +89,22 @@ Status Logging::set_current_stream(td_api::object_ptr<td_api::LogStream> stream)
       log_interface = &ts_log;
       return Status::OK();
     }
+    case td_api::logStreamBinaryFile::ID: {
+#if TD_THREAD_UNSUPPORTED
+      return Status::Error("Binary log isn't supported");
+#else
+      auto file_stream = td_api::move_object_as<td_api::logStreamBinaryFile>(stream);
+      auto max_log_file_size = file_stream->max_file_size_;
+      if (max_log_file_size <= 0) {
+        return Status::Error("Max log file size must be positive");
+      }
+
+      TRY_STATUS(binary_file_log.init(file_stream->path_, max_log_file_size));
+      std::atomic_thread_fence(std::memory_order_release);  // better than nothing
+      log_interface = &binary_file_log;
+      return Status::OK();
+#endif
+    }
     case td_api::logStreamEmpty::ID:
       log_interface = &null_log;
       return Status::OK();
@@ -104,6 +126,12 @@ Result<td_api::object_ptr<td_api::LogStream>> Logging::get_current_stream() {
     return td_api::make_object<td_api::logStreamFile>(file_log.get_path().str(), file_log.get_rotate_threshold(),
                                                       file_log.get_redirect_stderr());
   }
+#if !TD_THREAD_UNSUPPORTED
+  if (log_interface == &binary_file_log) {
+    return td_api::make_object<td_api::logStreamBinaryFile>(binary_file_log.get_path().str(),
+                                                            binary_file_log.get_rotate_threshold());
+  }
+#endif
   return Status::Error("Log stream is unrecognized");
 }
 
@@ -147,6 +175,32 @@ Result<int> Logging::get_tag_verbosity_level(Slice tag) {
   return *it->second;
 }
 
+Status Logging::set_tag_rate_limit(Slice tag, int32 max_message_count_per_second, int32 sampling_rate) {
+  if (!tag.empty() && log_tags.count(tag) == 0) {
+    return Status::Error("Log tag is not found");
+  }
+  constexpr int32 MAX_RATE_LIMIT_VALUE = 1000000;
+  if (max_message_count_per_second < 0 || max_message_count_per_second > MAX_RATE_LIMIT_VALUE) {
+    return Status::Error("Wrong maximum number of messages per second specified");
+  }
+  if (sampling_rate < 0 || sampling_rate > MAX_RATE_LIMIT_VALUE) {
+    return Status::Error("Wrong sampling rate specified");
+  }
+
+  LogRateLimiter::Limit limit;
+  limit.max_count_per_second = max_message_count_per_second;
+  limit.sampling_rate = sampling_rate;
+  LogRateLimiter::set_limit(tag, limit);
+  return Status::OK();
+}
+
+Result<LogRateLimiter::Limit> Logging::get_tag_rate_limit(Slice tag) {
+  if (!tag.empty() && log_tags.count(tag) == 0) {
+    return Status::Error("Log tag is not found");
+  }
+  return LogRateLimiter::get_limit(tag);
+}
+
 void Logging::add_message(int log_verbosity_level, Slice message) {
   int VERBOSITY_NAME(client) = clamp(log_verbosity_level, 0, VERBOSITY_NAME(NEVER));
   VLOG(client) << message;
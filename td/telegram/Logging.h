@@ -9,6 +9,7 @@
 #include "td/telegram/td_api.h"
 
 #include "td/utils/common.h"
+#include "td/utils/logging.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
@@ -30,6 +31,10 @@ class Logging {
 
   static Result<int> get_tag_verbosity_level(Slice tag);
 
+  static Status set_tag_rate_limit(Slice tag, int32 max_message_count_per_second, int32 sampling_rate);
+
+  static Result<LogRateLimiter::Limit> get_tag_rate_limit(Slice tag);
+
   static void add_message(int log_verbosity_level, Slice message);
 };
 
@@ -2442,6 +2442,10 @@ static void parse(unique_ptr<MessageContent> &content, ParserT &parser) {
   }
 }
 
+void store_message_content(const MessageContent *content, LogEventStorerBuffer &storer) {
+  store(content, storer);
+}
+
 void store_message_content(const MessageContent *content, LogEventStorerCalcLength &storer) {
   store(content, storer);
 }
@@ -4457,7 +4461,7 @@ void merge_message_contents(Td *td, const MessageContent *old_content, MessageCo
         if (need_message_changed_warning && need_message_text_changed_warning(old_, new_) &&
             old_->text.entities.size() <= MAX_CUSTOM_ENTITIES_COUNT &&
             need_message_entities_changed_warning(old_->text.entities, new_->text.entities) &&
-            td->option_manager_->get_option_integer("session_count") <= 1) {
+            td->option_manager_->get_option_integer(CachedOption::SessionCount) <= 1) {
           LOG(WARNING) << "Entities have changed for a message in " << dialog_id << " from "
                        << get_content_object(old_content) << " to " << get_content_object(new_content);
         }
@@ -6365,7 +6369,7 @@ unique_ptr<MessageContent> dup_message_content(Td *td, DialogId dialog_id, const
       }
     case MessageContentType::Sticker: {
       auto result = make_unique<MessageSticker>(*static_cast<const MessageSticker *>(content));
-      result->is_premium = td->option_manager_->get_option_boolean("is_premium");
+      result->is_premium = td->option_manager_->get_option_boolean(CachedOption::IsPremium);
       if (td->stickers_manager_->has_input_media(result->file_id, to_secret)) {
         return std::move(result);
       }
@@ -89,6 +89,8 @@ struct InlineMessageContent {
   bool invert_media;
 };
 
+void store_message_content(const MessageContent *content, LogEventStorerBuffer &storer);
+
 void store_message_content(const MessageContent *content, LogEventStorerCalcLength &storer);
 
 void store_message_content(const MessageContent *content, LogEventStorerUnsafe &storer);
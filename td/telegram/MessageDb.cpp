@@ -13,19 +13,29 @@
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteStatement.h"
+#include "td/db/WriteBatchPolicy.h"
 
 #include "td/actor/actor.h"
+#include "td/actor/MultiPromise.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
+#include "td/utils/algorithm.h"
+#include "td/utils/buffer.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
 #include "td/utils/format.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Span.h"
 #include "td/utils/StackAllocator.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 #include "td/utils/unicode.h"
 #include "td/utils/utf8.h"
 
@@ -41,6 +51,11 @@ namespace td {
 static constexpr int32 MESSAGE_DB_INDEX_COUNT = 30;
 static constexpr int32 MESSAGE_DB_INDEX_COUNT_OLD = 9;
 
+static Status get_not_found_error() {
+  static const Status error = Status::StaticError(0, "Not found");
+  return error.clone();
+}
+
 // NB: must happen inside a transaction
 Status init_message_db(SqliteDb &db, int32 version) {
   LOG(INFO) << "Init message database " << tag("version", version);
@@ -100,6 +115,9 @@ Status init_message_db(SqliteDb &db, int32 version) {
         "CREATE INDEX IF NOT EXISTS message_by_notification_id ON messages (dialog_id, notification_id) WHERE "
         "notification_id IS NOT NULL");
   };
+  auto add_data_dictionaries_table = [&db] {
+    return db.exec("CREATE TABLE IF NOT EXISTS message_data_dictionaries (id INT4 PRIMARY KEY, data BLOB)");
+  };
   auto add_scheduled_messages_table = [&db] {
     TRY_STATUS(
         db.exec("CREATE TABLE IF NOT EXISTS scheduled_messages (dialog_id INT8, message_id INT8, "
@@ -140,6 +158,8 @@ Status init_message_db(SqliteDb &db, int32 version) {
 
     TRY_STATUS(add_scheduled_messages_table());
 
+    TRY_STATUS(add_data_dictionaries_table());
+
     version = current_db_version();
   }
   if (version < static_cast<int32>(DbVersion::AddMessageDbMediaIndex)) {
@@ -167,6 +187,9 @@ Status init_message_db(SqliteDb &db, int32 version) {
   if (version < static_cast<int32>(DbVersion::AddMessageThreadSupport)) {
     TRY_STATUS(db.exec("ALTER TABLE messages ADD COLUMN top_thread_message_id INT8"));
   }
+  if (version < static_cast<int32>(DbVersion::AddMessageDataDictionaries)) {
+    TRY_STATUS(add_data_dictionaries_table());
+  }
   return Status::OK();
 }
 
@@ -179,7 +202,8 @@ Status drop_message_db(SqliteDb &db, int32 version) {
 
 class MessageDbImpl final : public MessageDbSyncInterface {
  public:
-  explicit MessageDbImpl(SqliteDb db) : db_(std::move(db)) {
+  MessageDbImpl(SqliteDb db, bool use_data_compression)
+      : db_(std::move(db)), use_data_compression_(use_data_compression) {
     init().ensure();
   }
 
@@ -197,6 +221,13 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     TRY_RESULT_ASSIGN(
         get_message_stmt_,
         db_.get_statement("SELECT message_id, data FROM messages WHERE dialog_id = ?1 AND message_id = ?2"));
+    TRY_RESULT_ASSIGN(get_messages_by_ids_stmt_,
+                      db_.get_statement(PSLICE() << "SELECT data, message_id FROM messages WHERE dialog_id = ?1 AND "
+                                                    "message_id IN ("
+                                                 << get_message_ids_placeholders() << ')'));
+    TRY_RESULT_ASSIGN(delete_messages_stmt_,
+                      db_.get_statement(PSLICE() << "DELETE FROM messages WHERE dialog_id = ?1 AND message_id IN ("
+                                                 << get_message_ids_placeholders() << ')'));
     TRY_RESULT_ASSIGN(
         get_message_by_random_id_stmt_,
         db_.get_statement("SELECT message_id, data FROM messages WHERE dialog_id = ?1 AND random_id = ?2"));
@@ -275,6 +306,12 @@ class MessageDbImpl final : public MessageDbSyncInterface {
         delete_scheduled_server_message_stmt_,
         db_.get_statement("DELETE FROM scheduled_messages WHERE dialog_id = ?1 AND server_message_id = ?2"));
 
+    TRY_RESULT_ASSIGN(get_data_dictionary_stmt_,
+                      db_.get_statement("SELECT data FROM message_data_dictionaries WHERE id = ?1"));
+    if (use_data_compression_) {
+      TRY_STATUS(load_last_data_dictionary());
+    }
+
     // LOG(ERROR) << get_message_stmt_.explain().ok();
     // LOG(ERROR) << get_messages_from_notification_id_stmt.explain().ok();
     // LOG(ERROR) << get_message_by_random_id_stmt_.explain().ok();
@@ -319,6 +356,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       add_message_stmt_.bind_null(5).ensure();
     }
 
+    data = pack_data(std::move(data));
     add_message_stmt_.bind_blob(6, data.as_slice()).ensure();
 
     if (ttl_expires_at != 0) {
@@ -384,6 +422,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       add_scheduled_message_stmt_.bind_null(3).ensure();
     }
 
+    data = pack_data(std::move(data));
     add_scheduled_message_stmt_.bind_blob(4, data.as_slice()).ensure();
 
     add_scheduled_message_stmt_.step().ensure();
@@ -412,6 +451,19 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     stmt.step().ensure();
   }
 
+  void delete_messages(DialogId dialog_id, vector<MessageId> message_ids) final {
+    LOG(INFO) << "Delete " << message_ids.size() << " messages in " << dialog_id << " from database";
+    CHECK(dialog_id.is_valid());
+    for (size_t pos = 0; pos < message_ids.size(); pos += MAX_BATCH_MESSAGE_COUNT) {
+      auto batch = Span<MessageId>(message_ids).substr(pos, min(message_ids.size() - pos, MAX_BATCH_MESSAGE_COUNT));
+      SCOPE_EXIT {
+        delete_messages_stmt_.reset();
+      };
+      bind_message_ids(delete_messages_stmt_, dialog_id, batch);
+      delete_messages_stmt_.step().ensure();
+    }
+  }
+
   void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id) final {
     LOG(INFO) << "Delete all messages in " << dialog_id << " up to " << from_message_id << " from database";
     CHECK(dialog_id.is_valid());
@@ -460,19 +512,41 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     }
     stmt.step().ensure();
     if (!stmt.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
     MessageId received_message_id(stmt.view_int64(0));
-    Slice data = stmt.view_blob(1);
+    auto data = unpack_data(stmt.view_blob(1));
     if (is_scheduled_server) {
       CHECK(received_message_id.is_scheduled());
       CHECK(received_message_id.is_scheduled_server());
       CHECK(received_message_id.get_scheduled_server_message_id() == message_id.get_scheduled_server_message_id());
     } else {
       LOG_CHECK(received_message_id == message_id)
-          << received_message_id << ' ' << message_id << ' ' << get_message_info(received_message_id, data, true).first;
+          << received_message_id << ' ' << message_id << ' '
+          << get_message_info(received_message_id, data.as_slice(), true).first;
     }
-    return MessageDbDialogMessage{received_message_id, BufferSlice(data)};
+    return MessageDbDialogMessage{received_message_id, std::move(data)};
+  }
+
+  vector<MessageDbDialogMessage> get_messages_by_ids(DialogId dialog_id, vector<MessageId> message_ids) final {
+    CHECK(dialog_id.is_valid());
+    vector<MessageDbDialogMessage> result;
+    for (size_t pos = 0; pos < message_ids.size(); pos += MAX_BATCH_MESSAGE_COUNT) {
+      auto batch = Span<MessageId>(message_ids).substr(pos, min(message_ids.size() - pos, MAX_BATCH_MESSAGE_COUNT));
+      SCOPE_EXIT {
+        get_messages_by_ids_stmt_.reset();
+      };
+      bind_message_ids(get_messages_by_ids_stmt_, dialog_id, batch);
+      get_messages_by_ids_stmt_.step().ensure();
+      while (get_messages_by_ids_stmt_.has_row()) {
+        MessageId message_id(get_messages_by_ids_stmt_.view_int64(1));
+        result.push_back(MessageDbDialogMessage{message_id, unpack_data(get_messages_by_ids_stmt_.view_blob(0))});
+        get_messages_by_ids_stmt_.step().ensure();
+      }
+    }
+    LOG(INFO) << "Load " << result.size() << " out of " << message_ids.size() << " messages in " << dialog_id
+              << " from database";
+    return result;
   }
 
   Result<MessageDbMessage> get_message_by_unique_message_id(ServerMessageId unique_message_id) final {
@@ -485,11 +559,11 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     get_message_by_unique_message_id_stmt_.bind_int32(1, unique_message_id.get()).ensure();
     get_message_by_unique_message_id_stmt_.step().ensure();
     if (!get_message_by_unique_message_id_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
     DialogId dialog_id(get_message_by_unique_message_id_stmt_.view_int64(0));
     MessageId message_id(get_message_by_unique_message_id_stmt_.view_int64(1));
-    return MessageDbMessage{dialog_id, message_id, BufferSlice(get_message_by_unique_message_id_stmt_.view_blob(2))};
+    return MessageDbMessage{dialog_id, message_id, unpack_data(get_message_by_unique_message_id_stmt_.view_blob(2))};
   }
 
   Result<MessageDbDialogMessage> get_message_by_random_id(DialogId dialog_id, int64 random_id) final {
@@ -500,10 +574,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     get_message_by_random_id_stmt_.bind_int64(2, random_id).ensure();
     get_message_by_random_id_stmt_.step().ensure();
     if (!get_message_by_random_id_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
     MessageId message_id(get_message_by_random_id_stmt_.view_int64(0));
-    return MessageDbDialogMessage{message_id, BufferSlice(get_message_by_random_id_stmt_.view_blob(1))};
+    return MessageDbDialogMessage{message_id, unpack_data(get_message_by_random_id_stmt_.view_blob(1))};
   }
 
   Result<MessageDbDialogMessage> get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id,
@@ -565,7 +639,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       }
     }
 
-    return Status::Error("Not found");
+    return get_not_found_error();
   }
 
   vector<MessageDbMessage> get_expiring_messages(int32 expires_till, int32 limit) final {
@@ -581,7 +655,7 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (get_expiring_messages_stmt_.has_row()) {
       DialogId dialog_id(get_expiring_messages_stmt_.view_int64(0));
       MessageId message_id(get_expiring_messages_stmt_.view_int64(1));
-      BufferSlice data(get_expiring_messages_stmt_.view_blob(2));
+      auto data = unpack_data(get_expiring_messages_stmt_.view_blob(2));
       messages.push_back(MessageDbMessage{dialog_id, message_id, std::move(data)});
       get_expiring_messages_stmt_.step().ensure();
     }
@@ -604,16 +678,16 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     stmt.step().ensure();
     int32 current_day = std::numeric_limits<int32>::max();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
+      auto data = unpack_data(stmt.view_blob(0));
       MessageId message_id(stmt.view_int64(1));
-      auto info = get_message_info(message_id, data_slice, false);
+      auto info = get_message_info(message_id, data.as_slice(), false);
       auto day = (query.tz_offset + info.second) / 86400;
       if (day >= current_day) {
         CHECK(!total_counts.empty());
         total_counts.back()++;
       } else {
         current_day = day;
-        messages.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+        messages.push_back(MessageDbDialogMessage{message_id, std::move(data)});
         total_counts.push_back(1);
       }
       stmt.step().ensure();
@@ -679,9 +753,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     vector<MessageDbDialogMessage> result;
     stmt.step().ensure();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
       MessageId message_id(stmt.view_int64(1));
-      result.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+      result.push_back(MessageDbDialogMessage{message_id, unpack_data(stmt.view_blob(0))});
       LOG(INFO) << "Load " << message_id << " in " << dialog_id << " from database";
       stmt.step().ensure();
     }
@@ -771,10 +844,9 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (stmt.has_row()) {
       DialogId dialog_id(stmt.view_int64(0));
       MessageId message_id(stmt.view_int64(1));
-      auto data_slice = stmt.view_blob(2);
       auto search_id = stmt.view_int64(3);
       result.next_search_id = search_id;
-      result.messages.push_back(MessageDbMessage{dialog_id, message_id, BufferSlice(data_slice)});
+      result.messages.push_back(MessageDbMessage{dialog_id, message_id, unpack_data(stmt.view_blob(2))});
       stmt.step().ensure();
     }
     return result;
@@ -809,13 +881,28 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (stmt.has_row()) {
       DialogId dialog_id(stmt.view_int64(0));
       MessageId message_id(stmt.view_int64(1));
-      auto data_slice = stmt.view_blob(2);
-      result.messages.push_back(MessageDbMessage{dialog_id, message_id, BufferSlice(data_slice)});
+      result.messages.push_back(MessageDbMessage{dialog_id, message_id, unpack_data(stmt.view_blob(2))});
       stmt.step().ensure();
     }
     return result;
   }
 
+  Result<bool> merge_fts_index(int32 page_count) final {
+    CHECK(page_count > 0);
+    auto total_changes = db_.get_total_changes();
+    TRY_STATUS(db_.exec(PSLICE() << "INSERT INTO messages_fts(messages_fts, rank) VALUES('merge', " << page_count
+                                 << ")"));
+    // if less than 2 rows were changed, then there was nothing to merge
+    return db_.get_total_changes() - total_changes >= 2;
+  }
+
+  Status set_fts_merge_parameters(int32 automerge, int32 crisismerge) final {
+    TRY_STATUS(db_.exec(PSLICE() << "INSERT INTO messages_fts(messages_fts, rank) VALUES('automerge', " << automerge
+                                 << ")"));
+    return db_.exec(PSLICE() << "INSERT INTO messages_fts(messages_fts, rank) VALUES('crisismerge', " << crisismerge
+                             << ")");
+  }
+
   Status begin_write_transaction() final {
     return db_.begin_write_transaction();
   }
@@ -829,10 +916,12 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   SqliteStatement add_message_stmt_;
 
   SqliteStatement delete_message_stmt_;
+  SqliteStatement delete_messages_stmt_;
   SqliteStatement delete_all_dialog_messages_stmt_;
   SqliteStatement delete_dialog_messages_by_sender_stmt_;
 
   SqliteStatement get_message_stmt_;
+  SqliteStatement get_messages_by_ids_stmt_;
   SqliteStatement get_message_by_random_id_stmt_;
   SqliteStatement get_message_by_unique_message_id_stmt_;
   SqliteStatement get_expiring_messages_stmt_;
@@ -857,8 +946,184 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   SqliteStatement delete_scheduled_message_stmt_;
   SqliteStatement delete_scheduled_server_message_stmt_;
 
-  static vector<MessageDbDialogMessage> get_messages_impl(GetMessagesStmt &stmt, DialogId dialog_id,
-                                                          MessageId from_message_id, int32 offset, int32 limit) {
+  // batched queries use a single prepared statement with a fixed number of message identifiers;
+  // unused parameters are filled with the last identifier, which doesn't change the result
+  static constexpr size_t MAX_BATCH_MESSAGE_COUNT = 100;
+
+  static string get_message_ids_placeholders() {
+    string result;
+    for (size_t i = 0; i < MAX_BATCH_MESSAGE_COUNT; i++) {
+      if (i != 0) {
+        result += ", ";
+      }
+      result += PSTRING() << '?' << i + 2;
+    }
+    return result;
+  }
+
+  static void bind_message_ids(SqliteStatement &stmt, DialogId dialog_id, Span<MessageId> message_ids) {
+    CHECK(!message_ids.empty());
+    CHECK(message_ids.size() <= MAX_BATCH_MESSAGE_COUNT);
+    stmt.bind_int64(1, dialog_id.get()).ensure();
+    for (size_t i = 0; i < MAX_BATCH_MESSAGE_COUNT; i++) {
+      auto message_id = message_ids[min(i, message_ids.size() - 1)];
+      CHECK(message_id.is_valid());
+      stmt.bind_int64(static_cast<int>(i + 2), message_id.get()).ensure();
+    }
+  }
+
+  // message data can be compressed with a dictionary, trained on first added messages and stored in the database;
+  // compressed data begins with COMPRESSED_DATA_MAGIC and identifier of the dictionary, which is never negative,
+  // while serialized messages begin with a positive version
+  static constexpr int32 COMPRESSED_DATA_MAGIC = -0x2f3ac1b5;
+  static constexpr size_t COMPRESSED_DATA_HEADER_SIZE = 2 * sizeof(int32);
+  static constexpr size_t MIN_COMPRESSED_DATA_SIZE = 64;
+  static constexpr size_t DATA_DICTIONARY_SAMPLE_COUNT = 1000;
+  static constexpr size_t DATA_DICTIONARY_FRAGMENT_SIZE = 16;
+  static constexpr size_t MAX_DATA_DICTIONARY_SIZE = 1 << 15;  // zlib uses only last 32 KB of a dictionary
+
+  bool use_data_compression_ = false;
+  int32 data_dictionary_id_ = 0;
+  string data_dictionary_;
+  vector<string> data_dictionary_samples_;
+  FlatHashMap<int32, string> data_dictionaries_;
+  SqliteStatement get_data_dictionary_stmt_;
+
+  Status load_last_data_dictionary() {
+    TRY_RESULT(stmt, db_.get_statement("SELECT id, data FROM message_data_dictionaries ORDER BY id DESC LIMIT 1"));
+    TRY_STATUS(stmt.step());
+    if (stmt.has_row()) {
+      data_dictionary_id_ = stmt.view_int32(0);
+      data_dictionary_ = stmt.view_blob(1).str();
+      LOG(INFO) << "Use message data dictionary " << data_dictionary_id_ << " of size " << data_dictionary_.size();
+    }
+    return Status::OK();
+  }
+
+  // concatenates fragments, which are the most common among the samples; the most common fragments are placed at
+  // the end of the dictionary, because zlib can encode shorter distances to them
+  static string train_data_dictionary(const vector<string> &samples) {
+    FlatHashMap<Slice, int32, SliceHash> fragment_counts;
+    for (auto &sample : samples) {
+      FlatHashSet<Slice, SliceHash> sample_fragments;
+      // serialized messages consist of 4-byte aligned fields
+      for (size_t pos = 0; pos + DATA_DICTIONARY_FRAGMENT_SIZE <= sample.size(); pos += 4) {
+        Slice fragment(sample.data() + pos, DATA_DICTIONARY_FRAGMENT_SIZE);
+        if (sample_fragments.insert(fragment).second) {
+          fragment_counts[fragment]++;
+        }
+      }
+    }
+
+    vector<std::pair<int32, Slice>> fragments;
+    for (auto &it : fragment_counts) {
+      if (it.second >= 2) {
+        fragments.emplace_back(it.second, it.first);
+      }
+    }
+    std::sort(fragments.begin(), fragments.end(),
+              [](const std::pair<int32, Slice> &lhs, const std::pair<int32, Slice> &rhs) {
+                return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+              });
+    auto fragment_count = min(fragments.size(), MAX_DATA_DICTIONARY_SIZE / DATA_DICTIONARY_FRAGMENT_SIZE);
+
+    string dictionary;
+    dictionary.reserve(fragment_count * DATA_DICTIONARY_FRAGMENT_SIZE);
+    for (size_t i = fragment_count; i > 0; i--) {
+      dictionary.append(fragments[i - 1].second.data(), fragments[i - 1].second.size());
+    }
+    return dictionary;
+  }
+
+  Status add_data_dictionary(string dictionary) {
+    TRY_RESULT(get_max_id_stmt, db_.get_statement("SELECT MAX(id) FROM message_data_dictionaries"));
+    TRY_STATUS(get_max_id_stmt.step());
+    CHECK(get_max_id_stmt.has_row());
+    auto dictionary_id = get_max_id_stmt.view_int32(0) + 1;
+
+    TRY_RESULT(add_stmt, db_.get_statement("INSERT INTO message_data_dictionaries VALUES(?1, ?2)"));
+    TRY_STATUS(add_stmt.bind_int32(1, dictionary_id));
+    TRY_STATUS(add_stmt.bind_blob(2, dictionary));
+    TRY_STATUS(add_stmt.step());
+
+    LOG(INFO) << "Add message data dictionary " << dictionary_id << " of size " << dictionary.size();
+    data_dictionary_id_ = dictionary_id;
+    data_dictionary_ = std::move(dictionary);
+    return Status::OK();
+  }
+
+  BufferSlice pack_data(BufferSlice data) {
+    if (!use_data_compression_ || data.size() < MIN_COMPRESSED_DATA_SIZE) {
+      return data;
+    }
+    if (data_dictionary_id_ == 0) {
+      data_dictionary_samples_.push_back(data.as_slice().str());
+      if (data_dictionary_samples_.size() < DATA_DICTIONARY_SAMPLE_COUNT) {
+        return data;
+      }
+      auto status = add_data_dictionary(train_data_dictionary(data_dictionary_samples_));
+      reset_to_empty(data_dictionary_samples_);
+      if (status.is_error()) {
+        LOG(ERROR) << "Failed to add message data dictionary: " << status;
+        use_data_compression_ = false;
+        return data;
+      }
+    }
+
+    auto compressed_data = gzencode(data.as_slice(), 0.9, data_dictionary_);
+    if (compressed_data.empty()) {
+      return data;
+    }
+    BufferSlice result(COMPRESSED_DATA_HEADER_SIZE + compressed_data.size());
+    TlStorerUnsafe storer(result.as_mutable_slice().ubegin());
+    storer.store_int(COMPRESSED_DATA_MAGIC);
+    storer.store_int(data_dictionary_id_);
+    storer.store_slice(compressed_data.as_slice());
+    return result;
+  }
+
+  Slice get_data_dictionary(int32 dictionary_id) {
+    if (dictionary_id == data_dictionary_id_) {
+      return data_dictionary_;
+    }
+    auto it = data_dictionaries_.find(dictionary_id);
+    if (it != data_dictionaries_.end()) {
+      return it->second;
+    }
+
+    SCOPE_EXIT {
+      get_data_dictionary_stmt_.reset();
+    };
+    get_data_dictionary_stmt_.bind_int32(1, dictionary_id).ensure();
+    get_data_dictionary_stmt_.step().ensure();
+    if (!get_data_dictionary_stmt_.has_row()) {
+      return Slice();
+    }
+    return data_dictionaries_[dictionary_id] = get_data_dictionary_stmt_.view_blob(0).str();
+  }
+
+  BufferSlice unpack_data(Slice data) {
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Database);
+    if (data.size() < COMPRESSED_DATA_HEADER_SIZE) {
+      return BufferSlice(data);
+    }
+    TlParser parser(data);
+    if (parser.fetch_int() != COMPRESSED_DATA_MAGIC) {
+      return BufferSlice(data);
+    }
+    auto dictionary_id = parser.fetch_int();
+    auto dictionary = get_data_dictionary(dictionary_id);
+    if (dictionary.empty()) {
+      LOG(ERROR) << "Can't find message data dictionary " << dictionary_id;
+      return BufferSlice();
+    }
+    auto result = gzdecode(data.substr(COMPRESSED_DATA_HEADER_SIZE), dictionary);
+    LOG_IF(ERROR, result.empty()) << "Failed to decompress message data of size " << data.size();
+    return result;
+  }
+
+  vector<MessageDbDialogMessage> get_messages_impl(GetMessagesStmt &stmt, DialogId dialog_id, MessageId from_message_id,
+                                                   int32 offset, int32 limit) {
     LOG_CHECK(dialog_id.is_valid()) << dialog_id;
     CHECK(from_message_id.is_valid());
 
@@ -909,8 +1174,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     return right;
   }
 
-  static vector<MessageDbDialogMessage> get_messages_inner(SqliteStatement &stmt, DialogId dialog_id,
-                                                           int64 from_message_id, int32 limit) {
+  vector<MessageDbDialogMessage> get_messages_inner(SqliteStatement &stmt, DialogId dialog_id, int64 from_message_id,
+                                                    int32 limit) {
     SCOPE_EXIT {
       stmt.reset();
     };
@@ -923,9 +1188,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     vector<MessageDbDialogMessage> result;
     stmt.step().ensure();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
       MessageId message_id(stmt.view_int64(1));
-      result.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+      result.push_back(MessageDbDialogMessage{message_id, unpack_data(stmt.view_blob(0))});
       LOG(INFO) << "Loaded " << message_id << " in " << dialog_id << " from database";
       stmt.step().ensure();
     }
@@ -964,12 +1228,12 @@ class MessageDbImpl final : public MessageDbSyncInterface {
 };
 
 std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
-    std::shared_ptr<SqliteConnectionSafe> sqlite_connection) {
+    std::shared_ptr<SqliteConnectionSafe> sqlite_connection, bool use_data_compression) {
   class MessageDbSyncSafe final : public MessageDbSyncSafeInterface {
    public:
-    explicit MessageDbSyncSafe(std::shared_ptr<SqliteConnectionSafe> sqlite_connection)
-        : lsls_db_([safe_connection = std::move(sqlite_connection)] {
-          return make_unique<MessageDbImpl>(safe_connection->get().clone());
+    MessageDbSyncSafe(std::shared_ptr<SqliteConnectionSafe> sqlite_connection, bool use_data_compression)
+        : lsls_db_([safe_connection = std::move(sqlite_connection), use_data_compression] {
+          return make_unique<MessageDbImpl>(safe_connection->get().clone(), use_data_compression);
         }) {
     }
     MessageDbSyncInterface &get() final {
@@ -979,13 +1243,23 @@ std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
    private:
     LazySchedulerLocalStorage<unique_ptr<MessageDbSyncInterface>> lsls_db_;
   };
-  return std::make_shared<MessageDbSyncSafe>(std::move(sqlite_connection));
+  return std::make_shared<MessageDbSyncSafe>(std::move(sqlite_connection), use_data_compression);
 }
 
 class MessageDbAsync final : public MessageDbAsyncInterface {
  public:
-  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id) {
-    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db));
+  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id,
+                 vector<int32> reader_scheduler_ids) {
+    if (scheduler_id == -1) {
+      scheduler_id = Scheduler::instance()->sched_id();
+    }
+    td::unique(reader_scheduler_ids);
+    td::remove(reader_scheduler_ids, scheduler_id);
+    vector<ActorOwn<Reader>> readers;
+    for (auto reader_scheduler_id : reader_scheduler_ids) {
+      readers.push_back(create_actor_on_scheduler<Reader>("MessageDbReaderActor", reader_scheduler_id, sync_db));
+    }
+    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db), std::move(readers));
   }
 
   void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
@@ -1003,6 +1277,9 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
   void delete_message(MessageFullId message_full_id, Promise<> promise) final {
     send_closure_later(impl_, &Impl::delete_message, message_full_id, std::move(promise));
   }
+  void delete_messages(DialogId dialog_id, vector<MessageId> message_ids, Promise<> promise) final {
+    send_closure_later(impl_, &Impl::delete_messages, dialog_id, std::move(message_ids), std::move(promise));
+  }
   void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id, Promise<> promise) final {
     send_closure_later(impl_, &Impl::delete_all_dialog_messages, dialog_id, from_message_id, std::move(promise));
   }
@@ -1013,6 +1290,10 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
   void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) final {
     send_closure_later(impl_, &Impl::get_message, message_full_id, std::move(promise));
   }
+  void get_messages_by_ids(DialogId dialog_id, vector<MessageId> message_ids,
+                           Promise<vector<MessageDbDialogMessage>> promise) final {
+    send_closure_later(impl_, &Impl::get_messages_by_ids, dialog_id, std::move(message_ids), std::move(promise));
+  }
   void get_message_by_unique_message_id(ServerMessageId unique_message_id, Promise<MessageDbMessage> promise) final {
     send_closure_later(impl_, &Impl::get_message_by_unique_message_id, unique_message_id, std::move(promise));
   }
@@ -1055,6 +1336,10 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     send_closure_later(impl_, &Impl::get_expiring_messages, expires_till, limit, std::move(promise));
   }
 
+  void set_fts_merge_parameters(int32 automerge, int32 crisismerge, Promise<> promise) final {
+    send_closure_later(impl_, &Impl::set_fts_merge_parameters, automerge, crisismerge, std::move(promise));
+  }
+
   void close(Promise<> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -1064,9 +1349,62 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
   }
 
  private:
+  // executes read-only queries using its own connection to the database
+  class Reader final : public Actor {
+   public:
+    explicit Reader(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    }
+
+    void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) {
+      promise.set_result(sync_db_->get_message(message_full_id));
+    }
+
+    void get_messages_by_ids(DialogId dialog_id, vector<MessageId> message_ids,
+                             Promise<vector<MessageDbDialogMessage>> promise) {
+      promise.set_value(sync_db_->get_messages_by_ids(dialog_id, std::move(message_ids)));
+    }
+
+    void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
+      promise.set_value(sync_db_->get_dialog_message_calendar(std::move(query)));
+    }
+
+    void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
+                                             Promise<MessageDbMessagePositions> promise) {
+      promise.set_result(sync_db_->get_dialog_sparse_message_positions(std::move(query)));
+    }
+
+    void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
+      promise.set_value(sync_db_->get_messages(std::move(query)));
+    }
+
+    void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
+      promise.set_value(sync_db_->get_calls(std::move(query)));
+    }
+
+    void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
+      promise.set_value(sync_db_->get_messages_fts(std::move(query)));
+    }
+
+    void close(Promise<> promise) {
+      sync_db_safe_.reset();
+      sync_db_ = nullptr;
+      promise.set_value(Unit());
+      stop();
+    }
+
+   private:
+    std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
+    MessageDbSyncInterface *sync_db_ = nullptr;
+
+    void start_up() final {
+      sync_db_ = &sync_db_safe_->get();
+    }
+  };
+
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe, vector<ActorOwn<Reader>> readers)
+        : sync_db_safe_(std::move(sync_db_safe)), readers_(std::move(readers)) {
     }
     void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
                      int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
@@ -1095,6 +1433,14 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
       });
     }
 
+    void delete_messages(DialogId dialog_id, vector<MessageId> message_ids, Promise<> promise) {
+      add_write_query([this, dialog_id, message_ids = std::move(message_ids), promise = std::move(promise)](
+                          Unit) mutable {
+        sync_db_->delete_messages(dialog_id, std::move(message_ids));
+        on_write_result(std::move(promise));
+      });
+    }
+
     void on_write_result(Promise<Unit> &&promise) {
       // We are inside a transaction and don't know how to handle errors
       finished_writes_.push_back(std::move(promise));
@@ -1103,19 +1449,33 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id, Promise<> promise) {
       add_read_query();
       sync_db_->delete_all_dialog_messages(dialog_id, from_message_id);
+      schedule_fts_merge();
       promise.set_value(Unit());
     }
 
     void delete_dialog_messages_by_sender(DialogId dialog_id, DialogId sender_dialog_id, Promise<> promise) {
       add_read_query();
       sync_db_->delete_dialog_messages_by_sender(dialog_id, sender_dialog_id);
+      schedule_fts_merge();
       promise.set_value(Unit());
     }
 
     void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) {
       add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_message, message_full_id, std::move(promise));
+      }
       promise.set_result(sync_db_->get_message(message_full_id));
     }
+    void get_messages_by_ids(DialogId dialog_id, vector<MessageId> message_ids,
+                             Promise<vector<MessageDbDialogMessage>> promise) {
+      add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_messages_by_ids, dialog_id, std::move(message_ids),
+                            std::move(promise));
+      }
+      promise.set_value(sync_db_->get_messages_by_ids(dialog_id, std::move(message_ids)));
+    }
     void get_message_by_unique_message_id(ServerMessageId unique_message_id, Promise<MessageDbMessage> promise) {
       add_read_query();
       promise.set_result(sync_db_->get_message_by_unique_message_id(unique_message_id));
@@ -1132,17 +1492,27 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
 
     void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
       add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_dialog_message_calendar, std::move(query), std::move(promise));
+      }
       promise.set_value(sync_db_->get_dialog_message_calendar(std::move(query)));
     }
 
     void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
                                              Promise<MessageDbMessagePositions> promise) {
       add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_dialog_sparse_message_positions, std::move(query),
+                            std::move(promise));
+      }
       promise.set_result(sync_db_->get_dialog_sparse_message_positions(std::move(query)));
     }
 
     void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_messages, std::move(query), std::move(promise));
+      }
       promise.set_value(sync_db_->get_messages(std::move(query)));
     }
     void get_scheduled_messages(DialogId dialog_id, int32 limit, Promise<vector<MessageDbDialogMessage>> promise) {
@@ -1156,10 +1526,16 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     }
     void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
       add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_calls, std::move(query), std::move(promise));
+      }
       promise.set_value(sync_db_->get_calls(std::move(query)));
     }
     void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
       add_read_query();
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_messages_fts, std::move(query), std::move(promise));
+      }
       promise.set_value(sync_db_->get_messages_fts(std::move(query)));
     }
     void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) {
@@ -1167,71 +1543,147 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
       promise.set_value(sync_db_->get_expiring_messages(expires_till, limit));
     }
 
+    void set_fts_merge_parameters(int32 automerge, int32 crisismerge, Promise<> promise) {
+      add_read_query();
+      TRY_STATUS_PROMISE(promise, sync_db_->set_fts_merge_parameters(automerge, crisismerge));
+      promise.set_value(Unit());
+    }
+
     void close(Promise<> promise) {
       do_flush();
       sync_db_safe_.reset();
       sync_db_ = nullptr;
-      promise.set_value(Unit());
+      MultiPromiseActorSafe mpas{"MessageDbCloseMultiPromiseActor"};
+      mpas.add_promise(std::move(promise));
+      auto lock = mpas.get_promise();
+      for (auto &reader : readers_) {
+        send_closure(reader.release(), &Reader::close, mpas.get_promise());
+      }
+      readers_.clear();
+      lock.set_value(Unit());
       stop();
     }
 
     void force_flush() {
       do_flush();
-      LOG(INFO) << "MessageDb flushed";
+      LOG(INFO) << "MessageDb flushed with " << write_batch_policy_.get_stats();
     }
 
    private:
     std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
     MessageDbSyncInterface *sync_db_ = nullptr;
 
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
-    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
+    // all pending writes are committed before a query is sent to a reader, so readers see results of all previous
+    // writes, but they can also see results of writes, which are done after the query was sent
+    vector<ActorOwn<Reader>> readers_;
+    size_t next_reader_ = 0;
 
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
     double wakeup_at_ = 0;
+    WriteBatchPolicy write_batch_policy_;
+
+    // the full-text search index is merged by small steps only after there were no queries for some time
+    static constexpr double FTS_MERGE_IDLE_DELAY = 5.0;
+    static constexpr double FTS_MERGE_STEP_DELAY = 0.1;
+    static constexpr int32 FTS_MERGE_PAGE_COUNT = 256;
+    double fts_merge_at_ = 0;  // 0 if the index doesn't need to be merged
 
     template <class F>
     void add_write_query(F &&f) {
       pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
-      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
-        do_flush();
-        wakeup_at_ = 0;
+      if (write_batch_policy_.need_flush(pending_writes_.size())) {
+        do_flush(true);
       } else if (wakeup_at_ == 0) {
-        wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
-      }
-      if (wakeup_at_ != 0) {
-        set_timeout_at(wakeup_at_);
+        wakeup_at_ = Time::now_cached() + write_batch_policy_.get_flush_delay();
+        update_timeout();
       }
+      postpone_fts_merge();
     }
     void add_read_query() {
       do_flush();
+      postpone_fts_merge();
+    }
+    ActorId<Reader> get_reader() {
+      CHECK(!readers_.empty());
+      if (next_reader_ >= readers_.size()) {
+        next_reader_ = 0;
+      }
+      return readers_[next_reader_++].get();
     }
-    void do_flush() {
+    void do_flush(bool is_full = false) {
       if (pending_writes_.empty()) {
         return;
       }
+      auto query_count = pending_writes_.size();
       sync_db_->begin_write_transaction().ensure();
       set_promises(pending_writes_);
+      auto commit_start_time = Time::now();
       sync_db_->commit_transaction().ensure();
+      write_batch_policy_.on_transaction_committed(query_count, Time::now() - commit_start_time, is_full);
       set_promises(finished_writes_);
-      cancel_timeout();
+      wakeup_at_ = 0;
+      schedule_fts_merge();
+    }
+
+    void schedule_fts_merge() {
+      fts_merge_at_ = Time::now_cached() + FTS_MERGE_IDLE_DELAY;
+      update_timeout();
+    }
+    void postpone_fts_merge() {
+      // the timeout isn't changed; it will be updated when it expires
+      if (fts_merge_at_ != 0) {
+        fts_merge_at_ = Time::now_cached() + FTS_MERGE_IDLE_DELAY;
+      }
+    }
+    void run_fts_merge_step() {
+      auto r_need_merge = sync_db_->merge_fts_index(FTS_MERGE_PAGE_COUNT);
+      if (r_need_merge.is_error()) {
+        LOG(ERROR) << "Failed to merge full-text search index: " << r_need_merge.error();
+        fts_merge_at_ = 0;
+      } else if (r_need_merge.ok()) {
+        fts_merge_at_ = Time::now() + FTS_MERGE_STEP_DELAY;
+      } else {
+        LOG(INFO) << "Full-text search index is merged";
+        fts_merge_at_ = 0;
+      }
+    }
+
+    void update_timeout() {
+      auto timeout_at = wakeup_at_;
+      if (fts_merge_at_ != 0 && (timeout_at == 0 || fts_merge_at_ < timeout_at)) {
+        timeout_at = fts_merge_at_;
+      }
+      if (timeout_at == 0) {
+        cancel_timeout();
+      } else {
+        set_timeout_at(timeout_at);
+      }
     }
+
     void timeout_expired() final {
       do_flush();
+      if (fts_merge_at_ != 0 && fts_merge_at_ <= Time::now()) {
+        run_fts_merge_step();
+      }
+      update_timeout();
     }
 
     void start_up() final {
       sync_db_ = &sync_db_safe_->get();
+
+      // the index could be left fragmented after the previous run
+      schedule_fts_merge();
     }
   };
   ActorOwn<Impl> impl_;
 };
 
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id) {
-  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id);
+                                                                 int32 scheduler_id,
+                                                                 vector<int32> reader_scheduler_ids) {
+  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id, std::move(reader_scheduler_ids));
 }
 
 }  // namespace td
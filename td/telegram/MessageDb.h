@@ -110,10 +110,14 @@ class MessageDbSyncInterface {
   virtual void add_scheduled_message(MessageFullId message_full_id, BufferSlice data) = 0;
 
   virtual void delete_message(MessageFullId message_full_id) = 0;
+  // message_ids must be valid identifiers of ordinary messages
+  virtual void delete_messages(DialogId dialog_id, vector<MessageId> message_ids) = 0;
   virtual void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id) = 0;
   virtual void delete_dialog_messages_by_sender(DialogId dialog_id, DialogId sender_dialog_id) = 0;
 
   virtual Result<MessageDbDialogMessage> get_message(MessageFullId message_full_id) = 0;
+  // returns found messages in an arbitrary order; message_ids must be valid identifiers of ordinary messages
+  virtual vector<MessageDbDialogMessage> get_messages_by_ids(DialogId dialog_id, vector<MessageId> message_ids) = 0;
   virtual Result<MessageDbMessage> get_message_by_unique_message_id(ServerMessageId unique_message_id) = 0;
   virtual Result<MessageDbDialogMessage> get_message_by_random_id(DialogId dialog_id, int64 random_id) = 0;
   virtual Result<MessageDbDialogMessage> get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id,
@@ -134,6 +138,11 @@ class MessageDbSyncInterface {
   virtual MessageDbCallsResult get_calls(MessageDbCallsQuery query) = 0;
   virtual MessageDbFtsResult get_messages_fts(MessageDbFtsQuery query) = 0;
 
+  // merges segments of the full-text search index, writing at most page_count pages;
+  // returns whether the index may need more merging
+  virtual Result<bool> merge_fts_index(int32 page_count) = 0;
+  virtual Status set_fts_merge_parameters(int32 automerge, int32 crisismerge) = 0;
+
   virtual Status begin_write_transaction() = 0;
   virtual Status commit_transaction() = 0;
 };
@@ -162,10 +171,13 @@ class MessageDbAsyncInterface {
   virtual void add_scheduled_message(MessageFullId message_full_id, BufferSlice data, Promise<> promise) = 0;
 
   virtual void delete_message(MessageFullId message_full_id, Promise<> promise) = 0;
+  virtual void delete_messages(DialogId dialog_id, vector<MessageId> message_ids, Promise<> promise) = 0;
   virtual void delete_all_dialog_messages(DialogId dialog_id, MessageId from_message_id, Promise<> promise) = 0;
   virtual void delete_dialog_messages_by_sender(DialogId dialog_id, DialogId sender_dialog_id, Promise<> promise) = 0;
 
   virtual void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) = 0;
+  virtual void get_messages_by_ids(DialogId dialog_id, vector<MessageId> message_ids,
+                                   Promise<vector<MessageDbDialogMessage>> promise) = 0;
   virtual void get_message_by_unique_message_id(ServerMessageId unique_message_id,
                                                 Promise<MessageDbMessage> promise) = 0;
   virtual void get_message_by_random_id(DialogId dialog_id, int64 random_id,
@@ -189,6 +201,9 @@ class MessageDbAsyncInterface {
 
   virtual void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) = 0;
 
+  // the full-text search index is also merged in background, when the database is idle
+  virtual void set_fts_merge_parameters(int32 automerge, int32 crisismerge, Promise<> promise) = 0;
+
   virtual void close(Promise<> promise) = 0;
   virtual void force_flush() = 0;
 };
@@ -196,10 +211,15 @@ class MessageDbAsyncInterface {
 Status init_message_db(SqliteDb &db, int version) TD_WARN_UNUSED_RESULT;
 Status drop_message_db(SqliteDb &db, int version) TD_WARN_UNUSED_RESULT;
 
+// if use_data_compression, then data of new messages is compressed with a dictionary stored in the database;
+// compressed data is decompressed transparently regardless of the flag
 std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
-    std::shared_ptr<SqliteConnectionSafe> sqlite_connection);
+    std::shared_ptr<SqliteConnectionSafe> sqlite_connection, bool use_data_compression = false);
 
+// heavy read queries are executed in parallel on the schedulers from reader_scheduler_ids using separate connections,
+// while writes and all other queries are executed sequentially on the scheduler scheduler_id
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id = -1);
+                                                                 int32 scheduler_id = -1,
+                                                                 vector<int32> reader_scheduler_ids = {});
 
 }  // namespace td
@@ -19,6 +19,7 @@
 #include "td/actor/MultiPromise.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/Arena.h"
 #include "td/utils/format.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
@@ -1519,7 +1520,9 @@ static bool are_entities_valid(const vector<MessageEntity> &entities) {
 
   int32 end_pos[SPLITTABLE_ENTITY_TYPE_COUNT];
   std::fill_n(end_pos, SPLITTABLE_ENTITY_TYPE_COUNT, -1);
-  vector<const MessageEntity *> nested_entities_stack;
+  auto &arena = get_event_arena();
+  Arena::Scope arena_scope(arena);
+  ArenaVector<const MessageEntity *> nested_entities_stack{ArenaAllocator<const MessageEntity *>(arena)};
   int32 nested_entity_type_mask = 0;
   for (auto &entity : entities) {
     while (!nested_entities_stack.empty() &&
@@ -1670,9 +1673,56 @@ static void fix_entity_offsets(Slice text, vector<MessageEntity> &entities) {
   }
 }
 
+namespace {
+// characters, presence of which is required to find an entity of the corresponding type
+struct EntityTriggers {
+  bool has_at = false;
+  bool has_slash = false;
+  bool has_hash = false;
+  bool has_dollar = false;
+  bool has_dot = false;
+  bool has_colon = false;
+  size_t digit_count = 0;
+};
+}  // namespace
+
+// the loop is branchless to allow its auto-vectorization
+static EntityTriggers get_entity_triggers(Slice text) {
+  uint8 has_at = 0;
+  uint8 has_slash = 0;
+  uint8 has_hash = 0;
+  uint8 has_dollar = 0;
+  uint8 has_dot = 0;
+  uint8 has_colon = 0;
+  size_t digit_count = 0;
+  for (auto c : text) {
+    auto uc = static_cast<unsigned char>(c);
+    has_at |= static_cast<uint8>(uc == '@');
+    has_slash |= static_cast<uint8>(uc == '/');
+    has_hash |= static_cast<uint8>(uc == '#');
+    has_dollar |= static_cast<uint8>(uc == '$');
+    has_dot |= static_cast<uint8>(uc == '.');
+    has_colon |= static_cast<uint8>(uc == ':');
+    digit_count += static_cast<size_t>(static_cast<unsigned char>(uc - '0') < 10);
+  }
+
+  EntityTriggers result;
+  result.has_at = has_at != 0;
+  result.has_slash = has_slash != 0;
+  result.has_hash = has_hash != 0;
+  result.has_dollar = has_dollar != 0;
+  result.has_dot = has_dot != 0;
+  result.has_colon = has_colon != 0;
+  result.digit_count = digit_count;
+  return result;
+}
+
 vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool skip_media_timestamps) {
   vector<MessageEntity> entities;
 
+  // most texts contain no entities, so skip matchers, which can't find anything
+  auto triggers = get_entity_triggers(text);
+
   auto add_entities = [&entities, &text](MessageEntity::Type type, vector<Slice> (*find_entities_f)(Slice)) mutable {
     auto new_entities = find_entities_f(text);
     for (auto &entity : new_entities) {
@@ -1681,23 +1731,35 @@ vector<MessageEntity> find_entities(Slice text, bool skip_bot_commands, bool ski
       entities.emplace_back(type, offset, length);
     }
   };
-  add_entities(MessageEntity::Type::Mention, find_mentions);
-  if (!skip_bot_commands) {
+  if (triggers.has_at) {
+    add_entities(MessageEntity::Type::Mention, find_mentions);
+  }
+  if (!skip_bot_commands && triggers.has_slash) {
     add_entities(MessageEntity::Type::BotCommand, find_bot_commands);
   }
-  add_entities(MessageEntity::Type::Hashtag, find_hashtags);
-  add_entities(MessageEntity::Type::Cashtag, find_cashtags);
+  if (triggers.has_hash) {
+    add_entities(MessageEntity::Type::Hashtag, find_hashtags);
+  }
+  if (triggers.has_dollar) {
+    add_entities(MessageEntity::Type::Cashtag, find_cashtags);
+  }
   // TODO find_phone_numbers
-  add_entities(MessageEntity::Type::BankCardNumber, find_bank_card_numbers);
-  add_entities(MessageEntity::Type::Url, find_tg_urls);
-  auto urls = find_urls(text);
-  for (auto &url : urls) {
-    auto type = url.second ? MessageEntity::Type::EmailAddress : MessageEntity::Type::Url;
-    auto offset = narrow_cast<int32>(url.first.begin() - text.begin());
-    auto length = narrow_cast<int32>(url.first.size());
-    entities.emplace_back(type, offset, length);
-  }
-  if (!skip_media_timestamps) {
+  if (triggers.digit_count >= 13) {
+    add_entities(MessageEntity::Type::BankCardNumber, find_bank_card_numbers);
+  }
+  if (triggers.has_colon) {
+    add_entities(MessageEntity::Type::Url, find_tg_urls);
+  }
+  if (triggers.has_dot) {
+    auto urls = find_urls(text);
+    for (auto &url : urls) {
+      auto type = url.second ? MessageEntity::Type::EmailAddress : MessageEntity::Type::Url;
+      auto offset = narrow_cast<int32>(url.first.begin() - text.begin());
+      auto length = narrow_cast<int32>(url.first.size());
+      entities.emplace_back(type, offset, length);
+    }
+  }
+  if (!skip_media_timestamps && triggers.has_colon) {
     auto media_timestamps = find_media_timestamps(text);
     for (auto &entity : media_timestamps) {
       auto offset = narrow_cast<int32>(entity.first.begin() - text.begin());
@@ -4194,7 +4256,9 @@ static void split_entities(vector<MessageEntity> &entities, const vector<Message
     flush_entities(end_offset);
   };
 
-  vector<const MessageEntity *> nested_entities_stack;
+  auto &arena = get_event_arena();
+  Arena::Scope arena_scope(arena);
+  ArenaVector<const MessageEntity *> nested_entities_stack{ArenaAllocator<const MessageEntity *>(arena)};
   auto add_offset = [&](int32 offset) {
     while (!nested_entities_stack.empty() &&
            offset >= nested_entities_stack.back()->offset + nested_entities_stack.back()->length) {
@@ -4521,7 +4585,7 @@ Result<FormattedText> get_formatted_text(const Td *td, DialogId dialog_id,
   TRY_RESULT(entities, get_message_entities(td->user_manager_.get(), std::move(text->entities_)));
   auto need_skip_bot_commands = need_always_skip_bot_commands(td->user_manager_.get(), dialog_id, is_bot);
   bool parse_markdown = td->option_manager_->get_option_boolean("always_parse_markdown");
-  bool skip_new_entities = is_bot && td->option_manager_->get_option_integer("session_count") > 1;
+  bool skip_new_entities = is_bot && td->option_manager_->get_option_integer(CachedOption::SessionCount) > 1;
   TRY_STATUS(fix_formatted_text(text->text_, entities, allow_empty, skip_new_entities || parse_markdown,
                                 skip_new_entities || need_skip_bot_commands,
                                 is_bot || skip_media_timestamps || parse_markdown, skip_trim, ltrim_count));
@@ -11,6 +11,7 @@
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteStatement.h"
+#include "td/db/WriteBatchPolicy.h"
 
 #include "td/actor/actor.h"
 #include "td/actor/SchedulerLocalStorage.h"
@@ -124,6 +125,7 @@ class MessageThreadDbImpl final : public MessageThreadDbSyncInterface {
     if (!get_thread_stmt_.has_row()) {
       return BufferSlice();
     }
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Database);
     return BufferSlice(get_thread_stmt_.view_blob(0));
   }
 
@@ -280,31 +282,26 @@ class MessageThreadDbAsync final : public MessageThreadDbAsyncInterface {
 
     void force_flush() {
       do_flush();
-      LOG(INFO) << "MessageThreadDb flushed";
+      LOG(INFO) << "MessageThreadDb flushed with " << write_batch_policy_.get_stats();
     }
 
    private:
     std::shared_ptr<MessageThreadDbSyncSafeInterface> sync_db_safe_;
     MessageThreadDbSyncInterface *sync_db_ = nullptr;
 
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
-    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
-
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
     double wakeup_at_ = 0;
+    WriteBatchPolicy write_batch_policy_;
 
     template <class F>
     void add_write_query(F &&f) {
       pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
-      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
-        do_flush();
-        wakeup_at_ = 0;
+      if (write_batch_policy_.need_flush(pending_writes_.size())) {
+        do_flush(true);
       } else if (wakeup_at_ == 0) {
-        wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
-      }
-      if (wakeup_at_ != 0) {
+        wakeup_at_ = Time::now_cached() + write_batch_policy_.get_flush_delay();
         set_timeout_at(wakeup_at_);
       }
     }
@@ -313,15 +310,19 @@ class MessageThreadDbAsync final : public MessageThreadDbAsyncInterface {
       do_flush();
     }
 
-    void do_flush() {
+    void do_flush(bool is_full = false) {
       if (pending_writes_.empty()) {
         return;
       }
+      auto query_count = pending_writes_.size();
       sync_db_->begin_write_transaction().ensure();
       set_promises(pending_writes_);
+      auto commit_start_time = Time::now();
       sync_db_->commit_transaction().ensure();
+      write_batch_policy_.on_transaction_committed(query_count, Time::now() - commit_start_time, is_full);
       set_promises(finished_writes_);
       cancel_timeout();
+      wakeup_at_ = 0;
     }
 
     void timeout_expired() final {
@@ -96,6 +96,8 @@
 #include "td/db/SqliteKeyValue.h"
 #include "td/db/SqliteKeyValueAsync.h"
 
+#include "td/tl/TlObjectArena.h"
+
 #include "td/actor/SleepActor.h"
 
 #include "td/utils/algorithm.h"
@@ -111,6 +113,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <queue>
 #include <tuple>
 #include <type_traits>
 #include <unordered_set>
@@ -1464,7 +1467,10 @@ class GetHistoryQuery final : public Td::ResultHandler {
   }
 
   void on_result(BufferSlice packet) final {
-    auto result_ptr = fetch_result<telegram_api::messages_getHistory>(packet);
+    fetch_result_async<telegram_api::messages_getHistory>(std::move(packet), &GetHistoryQuery::on_fetched_result);
+  }
+
+  void on_fetched_result(Result<telegram_api::object_ptr<telegram_api::messages_Messages>> result_ptr) {
     if (result_ptr.is_error()) {
       return on_error(result_ptr.move_as_error());
     }
@@ -2730,7 +2736,7 @@ class SendMessageQuery final : public Td::ResultHandler {
             std::move(reply_markup), std::move(entities), schedule_date, std::move(as_input_peer), nullptr),
         {{dialog_id, MessageContentType::Text},
          {dialog_id, is_copy ? MessageContentType::Photo : MessageContentType::Text}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
           send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -2799,7 +2805,7 @@ class StartBotQuery final : public Td::ResultHandler {
     auto query = G()->net_query_creator().create(
         telegram_api::messages_startBot(std::move(bot_input_user), std::move(input_peer), random_id, parameter),
         {{dialog_id, MessageContentType::Text}, {dialog_id, MessageContentType::Photo}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
           send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -3054,7 +3060,7 @@ class SendMediaQuery final : public Td::ResultHandler {
             false /*ignored*/, std::move(input_peer), std::move(reply_to), std::move(input_media), text, random_id,
             std::move(reply_markup), std::move(entities), schedule_date, std::move(as_input_peer), nullptr),
         {{dialog_id, content_type}, {dialog_id, is_copy ? MessageContentType::Text : content_type}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack") && was_uploaded_) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::UseQuickAck) && was_uploaded_) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
           send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -3434,7 +3440,7 @@ class ForwardMessagesQuery final : public Td::ResultHandler {
             std::move(random_ids), std::move(to_input_peer), top_thread_message_id.get_server_message_id().get(),
             schedule_date, std::move(as_input_peer), nullptr),
         {{to_dialog_id, MessageContentType::Text}, {to_dialog_id, MessageContentType::Photo}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_ids = random_ids_](Result<Unit> result) {
         if (result.is_ok()) {
           for (auto random_id : random_ids) {
@@ -3542,7 +3548,7 @@ class SendQuickReplyMessagesQuery final : public Td::ResultHandler {
                                                       MessageId::get_server_message_ids(message_ids),
                                                       std::move(random_ids)),
         {{dialog_id, MessageContentType::Text}, {dialog_id, MessageContentType::Photo}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_ids = random_ids_](Result<Unit> result) {
         if (result.is_ok()) {
           for (auto random_id : random_ids) {
@@ -4018,7 +4024,11 @@ class GetChannelDifferenceQuery final : public Td::ResultHandler {
   }
 
   void on_result(BufferSlice packet) final {
-    auto result_ptr = fetch_result<telegram_api::updates_getChannelDifference>(packet);
+    fetch_result_async<telegram_api::updates_getChannelDifference>(std::move(packet),
+                                                                   &GetChannelDifferenceQuery::on_fetched_result);
+  }
+
+  void on_fetched_result(Result<telegram_api::object_ptr<telegram_api::updates_ChannelDifference>> result_ptr) {
     if (result_ptr.is_error()) {
       return on_error(result_ptr.move_as_error());
     }
@@ -5532,15 +5542,9 @@ void MessagesManager::on_send_update_chat_read_inbox_timeout_callback(void *mess
 
 BufferSlice MessagesManager::get_dialog_database_value(const Dialog *d) {
   // can't use log_event_store, because it tries to parse stored Dialog
-  LogEventStorerCalcLength storer_calc_length;
-  store(*d, storer_calc_length);
-
-  BufferSlice value_buffer{storer_calc_length.get_length()};
-  auto value = value_buffer.as_mutable_slice();
-
-  LogEventStorerUnsafe storer_unsafe(value.ubegin());
-  store(*d, storer_unsafe);
-  return value_buffer;
+  LogEventStorerBuffer storer;
+  store(*d, storer);
+  return storer.move_as_buffer_slice();
 }
 
 void MessagesManager::save_dialog_to_database(DialogId dialog_id) {
@@ -5719,7 +5723,7 @@ void MessagesManager::update_message_reply_count(Dialog *d, MessageId message_id
   if (m->interaction_info_update_date < update_date &&
       m->reply_info.add_reply(replier_dialog_id, reply_message_id, diff)) {
     on_message_reply_info_changed(d->dialog_id, m);
-    on_message_changed(d, m, true, "update_message_reply_count_by_message");
+    on_message_interaction_info_changed(d, m, "update_message_reply_count_by_message");
   }
 
   if (!is_recursive && is_discussion_message(d->dialog_id, m)) {
@@ -6015,7 +6019,7 @@ void MessagesManager::on_update_read_message_comments(DialogId dialog_id, Messag
   }
   if (m->reply_info.update_max_message_ids(max_message_id, last_read_inbox_message_id, last_read_outbox_message_id)) {
     on_message_reply_info_changed(dialog_id, m);
-    on_message_changed(d, m, true, "on_update_read_message_comments");
+    on_message_interaction_info_changed(d, m, "on_update_read_message_comments");
   }
 }
 
@@ -6229,7 +6233,7 @@ void MessagesManager::update_message_interaction_info(MessageFullId message_full
 
   if (update_message_interaction_info(d, m, view_count, forward_count, has_reply_info, std::move(new_reply_info),
                                       has_reactions, std::move(reactions), "update_message_interaction_info")) {
-    on_message_changed(d, m, true, "update_message_interaction_info");
+    on_message_interaction_info_changed(d, m, "update_message_interaction_info");
   }
 }
 
@@ -6424,7 +6428,7 @@ bool MessagesManager::update_message_interaction_info(Dialog *d, Message *m, int
       if (m->reply_info.update_max_message_ids(reply_info) && view_count <= m->view_count &&
           forward_count <= m->forward_count) {
         on_message_reply_info_changed(dialog_id, m);
-        on_message_changed(d, m, true, "update_message_interaction_info");
+        on_message_interaction_info_changed(d, m, "update_message_interaction_info");
       }
     }
   }
@@ -8548,13 +8552,35 @@ void MessagesManager::on_get_messages(vector<tl_object_ptr<telegram_api::Message
                                       bool is_scheduled, Promise<Unit> &&promise, const char *source) {
   TRY_STATUS_PROMISE(promise, G()->close_status());
 
+  start_message_batch();
   for (auto &message : messages) {
     LOG(INFO) << "Receive " << to_string(message);
     on_get_message(std::move(message), false, is_channel_message, is_scheduled, source);
   }
+  finish_message_batch();
   promise.set_value(Unit());
 }
 
+void MessagesManager::start_message_batch() {
+  message_batch_depth_++;
+}
+
+void MessagesManager::finish_message_batch() {
+  CHECK(message_batch_depth_ > 0);
+  message_batch_depth_--;
+  if (message_batch_depth_ > 0 || postponed_chat_last_message_updates_.empty()) {
+    return;
+  }
+
+  LOG(INFO) << "Send postponed updateChatLastMessage in " << postponed_chat_last_message_updates_.size() << " chats";
+  auto dialog_ids = std::move(postponed_chat_last_message_updates_);
+  postponed_chat_last_message_updates_.clear();
+  postponed_chat_last_message_update_dialog_ids_.clear();
+  for (auto dialog_id : dialog_ids) {
+    send_update_chat_last_message(get_dialog(dialog_id), "finish_message_batch");
+  }
+}
+
 bool MessagesManager::delete_newer_server_messages_at_the_end(Dialog *d, MessageId max_message_id) {
   CHECK(!td_->auth_manager_->is_bot());
   CHECK(!max_message_id.is_scheduled());
@@ -10603,9 +10629,23 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
   bool has_left_to_unload_messages = false;
   auto to_unload_message_ids = find_unloadable_messages(d, G()->unix_time() - delay, has_left_to_unload_messages);
 
+  unload_dialog_messages(d, to_unload_message_ids);
+
+  if (has_left_to_unload_messages) {
+    LOG(DEBUG) << "Need to unload more messages in " << dialog_id;
+    pending_unload_dialog_timeout_.add_timeout_in(
+        d->dialog_id.get(),
+        to_unload_message_ids.size() >= MAX_UNLOADED_MESSAGES ? 1.0 : get_next_unload_dialog_delay(d));
+  } else {
+    d->has_unload_timeout = false;
+  }
+}
+
+void MessagesManager::unload_dialog_messages(Dialog *d, const vector<MessageId> &message_ids) {
+  auto dialog_id = d->dialog_id;
   vector<int64> unloaded_message_ids;
   vector<unique_ptr<Message>> unloaded_messages;
-  for (auto message_id : to_unload_message_ids) {
+  for (auto message_id : message_ids) {
     auto message = unload_message(d, message_id);
     CHECK(message != nullptr);
     if (message->is_update_sent) {
@@ -10617,7 +10657,7 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
     Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), unloaded_messages);
   }
 
-  if (!to_unload_message_ids.empty() && !G()->use_message_database() && !d->is_empty) {
+  if (!message_ids.empty() && !G()->use_message_database() && !d->is_empty) {
     d->have_full_history = false;
     d->have_full_history_source = 0;
   }
@@ -10628,14 +10668,84 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
         td_api::make_object<td_api::updateDeleteMessages>(get_chat_id_object(dialog_id, "updateDeleteMessages"),
                                                           std::move(unloaded_message_ids), false, true));
   }
+}
 
-  if (has_left_to_unload_messages) {
-    LOG(DEBUG) << "Need to unload more messages in " << dialog_id;
-    pending_unload_dialog_timeout_.add_timeout_in(
-        d->dialog_id.get(),
-        to_unload_message_ids.size() >= MAX_UNLOADED_MESSAGES ? 1.0 : get_next_unload_dialog_delay(d));
-  } else {
-    d->has_unload_timeout = false;
+int64 MessagesManager::get_loaded_message_count_max() const {
+  return td_->option_manager_->get_option_integer("message_cache_count_max", DEFAULT_LOADED_MESSAGE_COUNT_MAX);
+}
+
+void MessagesManager::on_loaded_message_added() {
+  loaded_message_count_++;
+  if (is_lru_message_unload_pending_ || !is_message_unload_enabled()) {
+    return;
+  }
+  auto max_count = get_loaded_message_count_max();
+  if (max_count > 0 && loaded_message_count_ > max_count) {
+    is_lru_message_unload_pending_ = true;
+    send_closure_later(actor_id(this), &MessagesManager::unload_least_recently_used_messages);
+  }
+}
+
+void MessagesManager::unload_least_recently_used_messages() {
+  is_lru_message_unload_pending_ = false;
+  if (G()->close_flag() || !is_message_unload_enabled()) {
+    return;
+  }
+  auto max_count = get_loaded_message_count_max();
+  if (max_count <= 0 || loaded_message_count_ <= max_count) {
+    return;
+  }
+
+  // unload 10% more messages than needed to avoid unloading after each received message
+  auto need_unload_count = min(loaded_message_count_ - max_count + max_count / 10,
+                               static_cast<int64>(MAX_UNLOADED_MESSAGES));
+
+  // merge message LRU lists of all dialogs by last access date; opened dialogs are never unloaded
+  struct LruItem {
+    int32 last_access_date;
+    Dialog *d;
+    const ListNode *node;
+
+    bool operator<(const LruItem &other) const {
+      return last_access_date > other.last_access_date;
+    }
+  };
+  std::priority_queue<LruItem> lru_queue;
+  dialogs_.foreach([&](const DialogId &dialog_id, unique_ptr<Dialog> &dialog) {
+    Dialog *d = dialog.get();
+    auto node = d->message_lru_list.next;
+    if (d->open_count == 0 && node != &d->message_lru_list) {
+      lru_queue.push({static_cast<const Message *>(node)->last_access_date, d, node});
+    }
+  });
+
+  FlatHashMap<DialogId, vector<MessageId>, DialogIdHash> to_unload_message_ids;
+  int64 unload_count = 0;
+  while (unload_count < need_unload_count && !lru_queue.empty()) {
+    auto item = lru_queue.top();
+    lru_queue.pop();
+
+    const auto *m = static_cast<const Message *>(item.node);
+    if (can_unload_message(item.d, m)) {
+      to_unload_message_ids[item.d->dialog_id].push_back(m->message_id);
+      unload_count++;
+    }
+    auto next_node = item.node->next;
+    if (next_node != &item.d->message_lru_list) {
+      lru_queue.push({static_cast<const Message *>(next_node)->last_access_date, item.d, next_node});
+    }
+  }
+
+  LOG(INFO) << "Unload " << unload_count << " least recently used messages from " << to_unload_message_ids.size()
+            << " chats with " << loaded_message_count_ << " loaded messages";
+  for (auto &it : to_unload_message_ids) {
+    unload_dialog_messages(get_dialog(it.first), it.second);
+  }
+  lru_unloaded_message_count_ += unload_count;
+
+  if (unload_count > 0 && loaded_message_count_ > max_count) {
+    is_lru_message_unload_pending_ = true;
+    send_closure_later(actor_id(this), &MessagesManager::unload_least_recently_used_messages);
   }
 }
 
@@ -13066,7 +13176,7 @@ MessagesManager::MessageInfo MessagesManager::parse_telegram_api_message(
                                   << message_info.sender_dialog_id << " from " << source;
       message_info.content = get_message_content(
           td,
-          get_message_text(td->user_manager_.get(), std::move(message->message_), std::move(message->entities_), true,
+          get_message_text(td->user_manager_.get(), message->message_.as_slice().str(), std::move(message->entities_), true,
                            td->auth_manager_->is_bot(),
                            message_info.forward_header ? message_info.forward_header->date_ : message_info.date,
                            message_info.media_album_id != 0, new_source.c_str()),
@@ -15102,6 +15212,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::do_delete_message(Dialog *
   auto result = std::move(d->messages[message_id]);
   CHECK(m == result.get());
   d->messages.erase(message_id);
+  loaded_message_count_--;
 
   static_cast<ListNode *>(result.get())->remove();
 
@@ -15549,7 +15660,7 @@ vector<DialogId> MessagesManager::get_dialogs(DialogListId dialog_list_id, Dialo
   update_list_last_pinned_dialog_date(list);
 
   vector<const DialogFolder *> folders;
-  vector<std::set<DialogDate>::const_iterator> folder_iterators;
+  vector<SortedChunkedSet<DialogDate>::ConstIterator> folder_iterators;
   for (auto folder_id : get_dialog_list_folder_ids(list)) {
     folders.push_back(get_dialog_folder(folder_id));
     folder_iterators.push_back(folders.back()->ordered_dialogs_.upper_bound(offset));
@@ -16969,6 +17080,26 @@ bool MessagesManager::get_messages(DialogId dialog_id, const vector<MessageId> &
     return false;
   }
 
+  // load ordinary messages, which aren't in memory, from the database by a single query
+  bool are_messages_loaded = false;
+  if (G()->use_message_database()) {
+    vector<MessageId> db_message_ids;
+    for (auto message_id : message_ids) {
+      if (message_id.is_valid() && !message_id.is_yet_unsent() && get_message(d, message_id) == nullptr &&
+          !is_deleted_message(d, message_id)) {
+        db_message_ids.push_back(message_id);
+      }
+    }
+    if (db_message_ids.size() > 1) {
+      td::unique(db_message_ids);
+      auto messages = G()->td_db()->get_message_db_sync()->get_messages_by_ids(dialog_id, std::move(db_message_ids));
+      for (auto &message : messages) {
+        on_get_message_from_database(d, message, false, "get_messages");
+      }
+      are_messages_loaded = true;
+    }
+  }
+
   bool is_secret = dialog_id.get_type() == DialogType::SecretChat;
   vector<MessageFullId> missed_message_ids;
   for (auto message_id : message_ids) {
@@ -16977,7 +17108,8 @@ bool MessagesManager::get_messages(DialogId dialog_id, const vector<MessageId> &
       return false;
     }
 
-    auto *m = get_message_force(d, message_id, "get_messages");
+    auto *m = are_messages_loaded && !message_id.is_scheduled() ? get_message(d, message_id)
+                                                                : get_message_force(d, message_id, "get_messages");
     if (m == nullptr && message_id.is_any_server() && !is_secret) {
       missed_message_ids.emplace_back(dialog_id, message_id);
       continue;
@@ -17664,7 +17796,7 @@ int32 MessagesManager::get_pinned_dialogs_limit(DialogListId dialog_list_id) con
   }
   int32 limit = clamp(narrow_cast<int32>(td_->option_manager_->get_option_integer(key)), 0, 1000);
   if (limit <= 0) {
-    if (td_->option_manager_->get_option_boolean("is_premium")) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::IsPremium)) {
       default_limit *= 2;
     }
     return default_limit;
@@ -18668,7 +18800,7 @@ Status MessagesManager::view_messages(DialogId dialog_id, vector<MessageId> mess
       prev_last_read_inbox_message_id = top_m->reply_info.last_read_inbox_message_id_;
       if (top_m->reply_info.update_max_message_ids(MessageId(), max_message_id, MessageId())) {
         on_message_reply_info_changed(dialog_id, top_m);
-        on_message_changed(d, top_m, true, "view_messages 10");
+        on_message_interaction_info_changed(d, top_m, "view_messages 10");
       }
       max_thread_message_id = top_m->reply_info.max_message_id_;
 
@@ -18685,7 +18817,7 @@ Status MessagesManager::view_messages(DialogId dialog_id, vector<MessageId> mess
           }
           if (linked_m->reply_info.update_max_message_ids(MessageId(), max_message_id, MessageId())) {
             on_message_reply_info_changed(linked_dialog_id, linked_m);
-            on_message_changed(linked_d, linked_m, true, "view_messages 12");
+            on_message_interaction_info_changed(linked_d, linked_m, "view_messages 12");
           }
           if (linked_m->reply_info.max_message_id_ > max_thread_message_id) {
             max_thread_message_id = linked_m->reply_info.max_message_id_;
@@ -19196,7 +19328,7 @@ td_api::object_ptr<td_api::MessageSender> MessagesManager::get_default_message_s
 td_api::object_ptr<td_api::chat> MessagesManager::get_chat_object(const Dialog *d, const char *source) const {
   CHECK(d != nullptr);
 
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
   auto chat_source = is_dialog_sponsored(d) ? sponsored_dialog_source_.get_chat_source_object() : nullptr;
   auto can_delete = can_delete_dialog(d);
   // TODO hide/show draft message when need_hide_dialog_draft_message changes
@@ -20057,7 +20189,7 @@ td_api::object_ptr<td_api::messageCalendar> MessagesManager::get_dialog_message_
       db_query.dialog_id = dialog_id;
       db_query.filter = filter;
       db_query.from_message_id = fixed_from_message_id;
-      db_query.tz_offset = static_cast<int32>(td_->option_manager_->get_option_integer("utc_time_offset"));
+      db_query.tz_offset = static_cast<int32>(td_->option_manager_->get_option_integer(CachedOption::UtcTimeOffset));
       G()->td_db()->get_message_db_async()->get_dialog_message_calendar(db_query, std::move(new_promise));
       return {};
     }
@@ -20930,6 +21062,7 @@ td_api::object_ptr<td_api::foundChatMessages> MessagesManager::get_found_chat_me
 
 td_api::object_ptr<td_api::foundMessages> MessagesManager::get_found_messages_object(
     const FoundMessages &found_messages, const char *source) {
+  TlObjectArenaScope arena_scope;
   vector<tl_object_ptr<td_api::message>> result;
   result.reserve(found_messages.message_full_ids.size());
   for (const auto &message_full_id : found_messages.message_full_ids) {
@@ -21355,6 +21488,9 @@ void MessagesManager::on_get_dialog_sparse_message_positions(
     DialogId dialog_id, SavedMessagesTopicId saved_messages_topic_id, MessageSearchFilter filter,
     telegram_api::object_ptr<telegram_api::messages_searchResultsPositions> positions,
     Promise<td_api::object_ptr<td_api::messagePositions>> &&promise) {
+  // the total count is the same as returned by messages.getSearchCounters, so cache it for getChatMessageCount
+  on_get_dialog_message_count(dialog_id, saved_messages_topic_id, filter, positions->count_, Promise<int32>());
+
   auto message_positions = transform(
       positions->positions_, [](const telegram_api::object_ptr<telegram_api::searchResultPosition> &position) {
         return td_api::make_object<td_api::messagePosition>(
@@ -22225,7 +22361,7 @@ ChatReactions MessagesManager::get_message_available_reactions(const Dialog *d,
     if (can_add_message_tag(d->dialog_id, m->reactions.get())) {
       auto default_tag_reactions = td_->reaction_manager_->get_default_tag_reactions();
       active_reactions.reaction_types_ = default_tag_reactions;
-      if (td_->option_manager_->get_option_boolean("is_premium")) {
+      if (td_->option_manager_->get_option_boolean(CachedOption::IsPremium)) {
         for (auto &reaction_type : active_reaction_types_) {
           if (!td::contains(default_tag_reactions, reaction_type)) {
             active_reactions.reaction_types_.push_back(reaction_type);
@@ -22249,7 +22385,7 @@ ChatReactions MessagesManager::get_message_available_reactions(const Dialog *d,
       }
     }
   }
-  if (disallow_custom_for_non_premium && !td_->option_manager_->get_option_boolean("is_premium")) {
+  if (disallow_custom_for_non_premium && !td_->option_manager_->get_option_boolean(CachedOption::IsPremium)) {
     active_reactions.allow_all_custom_ = false;
   }
   return active_reactions;
@@ -22356,7 +22492,7 @@ void MessagesManager::set_message_reactions(Dialog *d, Message *m, bool is_big,
   pending_reactions_[message_full_id].query_count++;
 
   send_update_message_interaction_info(d->dialog_id, m);
-  on_message_changed(d, m, true, "set_message_reactions");
+  on_message_interaction_info_changed(d, m, "set_message_reactions");
 
   // TODO cancel previous queries, log event
   auto query_promise = PromiseCreator::lambda(
@@ -22704,6 +22840,7 @@ td_api::object_ptr<td_api::messages> MessagesManager::get_messages_object(int32
                                                                           bool skip_not_found, const char *source) {
   Dialog *d = get_dialog(dialog_id);
   CHECK(d != nullptr);
+  TlObjectArenaScope arena_scope;
   auto message_objects = transform(message_ids, [this, dialog_id, d, source](MessageId message_id) {
     return get_message_object(dialog_id, get_message_force(d, message_id, source), source);
   });
@@ -22713,6 +22850,7 @@ td_api::object_ptr<td_api::messages> MessagesManager::get_messages_object(int32
 td_api::object_ptr<td_api::messages> MessagesManager::get_messages_object(int32 total_count,
                                                                           const vector<MessageFullId> &message_full_ids,
                                                                           bool skip_not_found, const char *source) {
+  TlObjectArenaScope arena_scope;
   auto message_objects = transform(message_full_ids, [this, source](MessageFullId message_full_id) {
     return get_message_object(message_full_id, source);
   });
@@ -23301,7 +23439,7 @@ void MessagesManager::get_dialog_send_message_as_dialog_ids(
       };
       std::multimap<int64, Sender> sorted_senders;
 
-      bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+      bool is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
       auto linked_channel_id = td_->chat_manager_->get_channel_linked_channel_id(
           dialog_id.get_channel_id(), "get_dialog_send_message_as_dialog_ids");
       for (auto channel_id : created_public_broadcasts) {
@@ -23530,7 +23668,7 @@ Result<InputMessageContent> MessagesManager::process_input_message_content(
                                copied_message->send_emoji);
   }
 
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
   TRY_RESULT(content, get_input_message_content(dialog_id, std::move(input_message_content), td_, is_premium));
 
   if (dialog_id != DialogId()) {
@@ -28481,6 +28619,15 @@ void MessagesManager::send_update_last_message_if_needed(const Dialog *d, const
 }
 
 void MessagesManager::send_update_chat_last_message(Dialog *d, const char *source) {
+  if (message_batch_depth_ > 0) {
+    // the chat position and the last message will be updated once after the batch is finished
+    CHECK(d != nullptr);
+    if (postponed_chat_last_message_update_dialog_ids_.insert(d->dialog_id).second) {
+      postponed_chat_last_message_updates_.push_back(d->dialog_id);
+    }
+    return;
+  }
+
   update_dialog_pos(d, source, false);
   send_update_chat_last_message_impl(d, source);
 }
@@ -28631,6 +28778,9 @@ void MessagesManager::send_update_chat_read_inbox(const Dialog *d, bool force, c
     }
   } else {
     postponed_chat_read_inbox_updates_.erase(d->dialog_id);
+    if (td_->is_update_ignored(td_api::updateChatReadInbox::ID)) {
+      return;
+    }
     LOG(INFO) << "Send updateChatReadInbox in " << d->dialog_id << "("
               << td_->dialog_manager_->get_dialog_title(d->dialog_id) << ") to " << d->server_unread_count << " + "
               << d->local_unread_count << " from " << source;
@@ -29934,7 +30084,7 @@ void MessagesManager::set_dialog_is_translatable(Dialog *d, bool is_translatable
 
   LOG(INFO) << "Set " << d->dialog_id << " is translatable to " << is_translatable;
   LOG_CHECK(d->is_update_new_chat_sent) << "Wrong " << d->dialog_id << " in set_dialog_is_translatable";
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
   if (is_premium) {
     send_closure(G()->td(), &Td::send_update,
                  td_api::make_object<td_api::updateChatIsTranslatable>(
@@ -31083,7 +31233,7 @@ void MessagesManager::get_dialog_filter_dialog_count(td_api::object_ptr<td_api::
       }
 
       auto dialog_id = dialog_date.get_dialog_id();
-      if (dialog_filter->need_dialog(td_, get_dialog_info_for_dialog_filter(get_dialog(dialog_id)))) {
+      if (dialog_filter->need_dialog(get_dialog_info_for_dialog_filter(get_dialog(dialog_id)))) {
         total_count++;
       }
     }
@@ -31204,7 +31354,7 @@ void MessagesManager::edit_dialog_list_for_dialog_filter(unique_ptr<DialogFilter
       const DialogPositionInList old_position = get_dialog_position_in_list(old_list_ptr, d);
       // can't use get_dialog_position_in_list, because need_dialog_in_list calls get_dialog_filter
       DialogPositionInList new_position;
-      if (new_dialog_filter->need_dialog(td_, get_dialog_info_for_dialog_filter(d))) {
+      if (new_dialog_filter->need_dialog(get_dialog_info_for_dialog_filter(d))) {
         new_position.private_order = get_dialog_private_order(&new_list, d);
         if (new_position.private_order != 0) {
           new_position.public_order =
@@ -31862,18 +32012,28 @@ MessagesManager::Message *MessagesManager::on_get_message_from_database(Dialog *
     return nullptr;
   }
 
-  auto message = parse_message(d, expected_message_id, value, is_scheduled);
-  if (message == nullptr) {
-    return nullptr;
+  CHECK(d != nullptr);
+  unique_ptr<Message> message;
+  Message *old_message = nullptr;
+  if (!is_scheduled && expected_message_id.is_valid()) {
+    // the message from the memory will be returned, so there is no need to parse its content and register its files
+    old_message = get_message(d, expected_message_id);
+  }
+  if (old_message == nullptr) {
+    message = parse_message(d, expected_message_id, value, is_scheduled);
+    if (message == nullptr) {
+      return nullptr;
+    }
   }
 
-  CHECK(d != nullptr);
   auto dialog_id = d->dialog_id;
   if (!td_->dialog_manager_->have_input_peer(dialog_id, true, AccessRights::Read)) {
     return nullptr;
   }
 
-  auto old_message = get_message(d, message->message_id);
+  if (old_message == nullptr) {
+    old_message = get_message(d, message->message_id);
+  }
   if (old_message != nullptr) {
     // data in the database is always outdated, so return a message from the memory
     if (dialog_id.get_type() == DialogType::SecretChat) {
@@ -31923,27 +32083,33 @@ vector<MessageId> MessagesManager::on_get_messages_from_database(Dialog *d, vect
   auto next_message_id = MessageId::max();
   Dependencies dependencies;
   for (auto &message_slice : messages) {
-    auto message = parse_message(d, message_slice.message_id, message_slice.data, false);
-    if (message == nullptr) {
-      have_error = true;
-      break;
+    // messages, which are already in the memory, are kept as is, so their data doesn't need to be parsed
+    unique_ptr<Message> message;
+    auto message_id = message_slice.message_id;
+    if (!message_id.is_valid() || get_message(d, message_id) == nullptr) {
+      message = parse_message(d, message_id, message_slice.data, false);
+      if (message == nullptr) {
+        have_error = true;
+        break;
+      }
+      message_id = message->message_id;
     }
-    if (message->message_id >= next_message_id) {
-      LOG(ERROR) << "Receive " << message->message_id << " after " << next_message_id
-                 << " from database in the history of " << d->dialog_id;
+    if (message_id >= next_message_id) {
+      LOG(ERROR) << "Receive " << message_id << " after " << next_message_id << " from database in the history of "
+                 << d->dialog_id;
       have_error = true;
       break;
     }
-    next_message_id = message->message_id;
+    next_message_id = message_id;
 
-    if (message->message_id < first_message_id) {
+    if (message_id < first_message_id) {
       break;
     }
 
-    result.push_back(message->message_id);
-    auto *m = get_message(d, message->message_id);
-    if (m == nullptr) {
-      m = add_message_to_dialog(d, std::move(message), true, false, &need_update, &need_update_dialog_pos, source);
+    result.push_back(message_id);
+    if (message != nullptr) {
+      auto *m =
+          add_message_to_dialog(d, std::move(message), true, false, &need_update, &need_update_dialog_pos, source);
       if (m != nullptr) {
         add_message_dependencies(dependencies, m);
       }
@@ -32705,10 +32871,14 @@ MessagesManager::Message *MessagesManager::add_message_to_dialog(Dialog *d, uniq
 
   if (m->is_topic_message) {
     td_->forum_topic_manager_->on_topic_message_count_changed(dialog_id, m->top_thread_message_id, +1);
+    if (from_update) {
+      td_->forum_topic_manager_->on_topic_message_added(dialog_id, m->top_thread_message_id, m->message_id);
+    }
   }
 
   Message *result_message = message.get();
   d->messages.set(message_id, std::move(message));
+  on_loaded_message_added();
 
   d->message_lru_list.put_back(result_message);
 
@@ -32950,6 +33120,12 @@ void MessagesManager::on_message_changed(const Dialog *d, const Message *m, bool
   }
 }
 
+void MessagesManager::on_message_interaction_info_changed(const Dialog *d, const Message *m, const char *source) {
+  // the change was already sent in updateMessageInteractionInfo if the message is known to the app,
+  // so there is no need to rebuild the whole message for updateChatLastMessage
+  on_message_changed(d, m, !m->is_update_sent, source);
+}
+
 void MessagesManager::on_message_notification_changed(Dialog *d, const Message *m, const char *source) {
   CHECK(d != nullptr);
   CHECK(m != nullptr);
@@ -35081,12 +35257,18 @@ void MessagesManager::update_dialog_lists(
     }
   }
 
+  // features of the dialog are computed once and then are checked against all chat folders
+  DialogFilterDialogInfo dialog_info;
+  if (d->order != DEFAULT_ORDER) {
+    dialog_info = get_dialog_info_for_dialog_filter(d);
+  }
+
   for (auto &dialog_list : dialog_lists_) {
     auto dialog_list_id = dialog_list.first;
     auto &list = dialog_list.second;
 
     const DialogPositionInList &old_position = old_positions[dialog_list_id];
-    const DialogPositionInList new_position = get_dialog_position_in_list(&list, d, true);
+    const DialogPositionInList new_position = get_dialog_position_in_list(&list, d, true, &dialog_info);
 
     // sponsored chat is never "in list"
     bool was_in_list = old_position.order != DEFAULT_ORDER && old_position.private_order != 0;
@@ -35534,10 +35716,26 @@ DialogFilterDialogInfo MessagesManager::get_dialog_info_for_dialog_filter(const
   CHECK(d->order != DEFAULT_ORDER);
   DialogFilterDialogInfo dialog_info;
   dialog_info.dialog_id_ = d->dialog_id;
-  dialog_info.folder_id_ = d->folder_id;
-  dialog_info.has_unread_mentions_ = d->unread_mention_count != 0 && !is_dialog_mention_notifications_disabled(d);
-  dialog_info.is_muted_ = is_dialog_muted(d);
-  dialog_info.has_unread_messages_ = d->server_unread_count + d->local_unread_count != 0 || d->is_marked_as_unread;
+  if (d->dialog_id.get_type() == DialogType::SecretChat) {
+    auto user_id = td_->user_manager_->get_secret_chat_user_id(d->dialog_id.get_secret_chat_id());
+    if (user_id.is_valid()) {
+      dialog_info.user_dialog_id_ = DialogId(user_id);
+    }
+  }
+  int32 features = DialogFilter::get_dialog_type_feature(td_, d->dialog_id);
+  if (d->unread_mention_count != 0 && !is_dialog_mention_notifications_disabled(d)) {
+    features |= DialogFilterDialogInfo::HasUnreadMentions;
+  }
+  if (is_dialog_muted(d)) {
+    features |= DialogFilterDialogInfo::IsMuted;
+  }
+  if (d->server_unread_count + d->local_unread_count == 0 && !d->is_marked_as_unread) {
+    features |= DialogFilterDialogInfo::IsRead;
+  }
+  if (d->folder_id == FolderId::archive()) {
+    features |= DialogFilterDialogInfo::IsArchived;
+  }
+  dialog_info.features_ = features;
   return dialog_info;
 }
 
@@ -35547,7 +35745,8 @@ bool MessagesManager::is_dialog_in_dialog_list(DialogId dialog_id) const {
   return d != nullptr && d->order != DEFAULT_ORDER;
 }
 
-bool MessagesManager::need_dialog_in_list(const Dialog *d, const DialogList &list) const {
+bool MessagesManager::need_dialog_in_list(const Dialog *d, const DialogList &list,
+                                          const DialogFilterDialogInfo *dialog_info) const {
   CHECK(!td_->auth_manager_->is_bot());
   if (d->order == DEFAULT_ORDER) {
     return false;
@@ -35556,8 +35755,11 @@ bool MessagesManager::need_dialog_in_list(const Dialog *d, const DialogList &lis
     return d->folder_id == list.dialog_list_id.get_folder_id();
   }
   if (list.dialog_list_id.is_filter()) {
-    return td_->dialog_filter_manager_->need_dialog_in_filter(list.dialog_list_id.get_filter_id(),
-                                                              get_dialog_info_for_dialog_filter(d));
+    auto dialog_filter_id = list.dialog_list_id.get_filter_id();
+    if (dialog_info != nullptr) {
+      return td_->dialog_filter_manager_->need_dialog_in_filter(dialog_filter_id, *dialog_info);
+    }
+    return td_->dialog_filter_manager_->need_dialog_in_filter(dialog_filter_id, get_dialog_info_for_dialog_filter(d));
   }
   UNREACHABLE();
   return false;
@@ -35574,15 +35776,16 @@ bool MessagesManager::need_send_update_chat_position(const DialogPositionInList
   return old_position.is_pinned != new_position.is_pinned || old_position.is_sponsored != new_position.is_sponsored;
 }
 
-MessagesManager::DialogPositionInList MessagesManager::get_dialog_position_in_list(const DialogList *list,
-                                                                                   const Dialog *d, bool actual) const {
+MessagesManager::DialogPositionInList MessagesManager::get_dialog_position_in_list(
+    const DialogList *list, const Dialog *d, bool actual, const DialogFilterDialogInfo *dialog_info) const {
   CHECK(!td_->auth_manager_->is_bot());
   CHECK(list != nullptr);
   CHECK(d != nullptr);
 
   DialogPositionInList position;
   position.order = d->order;
-  if (is_dialog_sponsored(d) || (actual ? need_dialog_in_list(d, *list) : is_dialog_in_list(d, list->dialog_list_id))) {
+  if (is_dialog_sponsored(d) ||
+      (actual ? need_dialog_in_list(d, *list, dialog_info) : is_dialog_in_list(d, list->dialog_list_id))) {
     position.private_order = get_dialog_private_order(list, d);
   }
   if (position.private_order != 0) {
@@ -36793,7 +36996,7 @@ void MessagesManager::update_forward_count(MessageFullId message_full_id, int32
     if (m->forward_count == 0) {
       m->forward_count++;
       send_update_message_interaction_info(dialog_id, m);
-      on_message_changed(d, m, true, "update_forward_count");
+      on_message_interaction_info_changed(d, m, "update_forward_count");
     }
     if (pending_message_views_[dialog_id].message_ids_.insert(m->message_id).second) {
       pending_message_views_timeout_.add_timeout_in(dialog_id.get(), 0.0);
@@ -37829,6 +38032,11 @@ void MessagesManager::on_binlog_events(vector<BinlogEvent> &&events) {
         LOG(FATAL) << "Unsupported log event type " << event.type_;
     }
   }
+
+  if (G()->use_message_database() && td_->auth_manager_->was_authorized() && !td_->auth_manager_->is_bot()) {
+    // load the first chats of the main chat list from the database in advance to answer the first loadChats faster
+    load_folder_dialog_list(FolderId::main(), MAX_GET_DIALOGS, true);
+  }
 }
 
 Status MessagesManager::add_recently_found_dialog(DialogId dialog_id) {
@@ -38264,6 +38472,15 @@ void MessagesManager::get_current_state(vector<td_api::object_ptr<td_api::Update
   append(updates, std::move(last_message_updates));
 }
 
+void MessagesManager::memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const {
+  output.push_back(PSTRING() << "MessagesManager: " << dialogs_.calc_size() << " chats with " << loaded_message_count_
+                             << " loaded messages, " << lru_unloaded_message_count_
+                             << " messages unloaded because of the limit " << get_loaded_message_count_max());
+  auto dialogs_usage = dialogs_.memory_usage();
+  output.push_back(PSTRING() << "MessagesManager::dialogs_: " << dialogs_usage);
+  hash_table_usage += dialogs_usage;
+}
+
 void MessagesManager::add_message_file_to_downloads(MessageFullId message_full_id, FileId file_id, int32 priority,
                                                     Promise<td_api::object_ptr<td_api::file>> promise) {
   auto m = get_message_force(message_full_id, "add_message_file_to_downloads");
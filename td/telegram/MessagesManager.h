@@ -88,6 +88,7 @@
 #include "td/utils/List.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SortedChunkedSet.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/WaitFreeHashMap.h"
@@ -165,6 +166,11 @@ class MessagesManager final : public Actor {
   void on_get_messages(vector<tl_object_ptr<telegram_api::Message>> &&messages, bool is_channel_message,
                        bool is_scheduled, Promise<Unit> &&promise, const char *source);
 
+  // postpones updateChatLastMessage and chat position changes until the batch is finished; batches can be nested
+  void start_message_batch();
+
+  void finish_message_batch();
+
   void on_get_history(DialogId dialog_id, MessageId from_message_id, MessageId old_last_new_message_id, int32 offset,
                       int32 limit, bool from_the_end, vector<tl_object_ptr<telegram_api::Message>> &&messages,
                       Promise<Unit> &&promise);
@@ -760,7 +766,7 @@ class MessagesManager final : public Actor {
                                            MessageSearchFilter filter, MessageId from_message_id, int32 limit,
                                            Promise<td_api::object_ptr<td_api::messagePositions>> &&promise);
 
-  static void on_get_dialog_sparse_message_positions(
+  void on_get_dialog_sparse_message_positions(
       DialogId dialog_id, SavedMessagesTopicId saved_messages_topic_id, MessageSearchFilter filter,
       telegram_api::object_ptr<telegram_api::messages_searchResultsPositions> positions,
       Promise<td_api::object_ptr<td_api::messagePositions>> &&promise);
@@ -963,6 +969,8 @@ class MessagesManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const;
+
   void add_message_file_to_downloads(MessageFullId message_full_id, FileId file_id, int32 priority,
                                      Promise<td_api::object_ptr<td_api::file>> promise);
 
@@ -1390,7 +1398,7 @@ class MessagesManager final : public Actor {
     // date of the last loaded dialog in the folder
     DialogDate folder_last_dialog_date_{MAX_ORDINARY_DIALOG_ORDER, DialogId()};  // in memory
 
-    std::set<DialogDate> ordered_dialogs_;  // all known dialogs, including with default order
+    SortedChunkedSet<DialogDate> ordered_dialogs_;  // all known dialogs, including with default order
 
     // date of last known user/group/channel dialog in the right order
     DialogDate last_server_dialog_date_{MAX_ORDINARY_DIALOG_ORDER, DialogId()};
@@ -1587,6 +1595,7 @@ class MessagesManager final : public Actor {
   static constexpr int32 MAX_RECENT_DIALOGS = 50;              // some reasonable value
   static constexpr size_t MIN_DELETED_ASYNCHRONOUSLY_MESSAGES = 2;
   static constexpr size_t MAX_UNLOADED_MESSAGES = 5000;
+  static constexpr int64 DEFAULT_LOADED_MESSAGE_COUNT_MAX = 1000000;
 
   static constexpr int64 SPONSORED_DIALOG_ORDER = static_cast<int64>(2147483647) << 32;
   static constexpr int32 MIN_PINNED_DIALOG_DATE = 2147000000;  // some big date
@@ -1944,6 +1953,14 @@ class MessagesManager final : public Actor {
 
   void unload_dialog(DialogId dialog_id, int32 delay);
 
+  void unload_dialog_messages(Dialog *d, const vector<MessageId> &message_ids);
+
+  int64 get_loaded_message_count_max() const;
+
+  void on_loaded_message_added();
+
+  void unload_least_recently_used_messages();
+
   void clear_dialog_message_list(Dialog *d, bool remove_from_dialog_list, int32 last_message_date);
 
   void delete_all_dialog_messages(Dialog *d, bool remove_from_dialog_list, bool is_permanently_deleted);
@@ -2189,6 +2206,8 @@ class MessagesManager final : public Actor {
 
   void on_message_changed(const Dialog *d, const Message *m, bool need_send_update, const char *source);
 
+  void on_message_interaction_info_changed(const Dialog *d, const Message *m, const char *source);
+
   void on_message_notification_changed(Dialog *d, const Message *m, const char *source);
 
   bool need_delete_file(MessageFullId message_full_id, FileId file_id) const;
@@ -2672,12 +2691,14 @@ class MessagesManager final : public Actor {
 
   DialogFilterDialogInfo get_dialog_info_for_dialog_filter(const Dialog *d) const;
 
-  bool need_dialog_in_list(const Dialog *d, const DialogList &list) const;
+  bool need_dialog_in_list(const Dialog *d, const DialogList &list,
+                           const DialogFilterDialogInfo *dialog_info = nullptr) const;
 
   static bool need_send_update_chat_position(const DialogPositionInList &old_position,
                                              const DialogPositionInList &new_position);
 
-  DialogPositionInList get_dialog_position_in_list(const DialogList *list, const Dialog *d, bool actual = false) const;
+  DialogPositionInList get_dialog_position_in_list(const DialogList *list, const Dialog *d, bool actual = false,
+                                                   const DialogFilterDialogInfo *dialog_info = nullptr) const;
 
   std::unordered_map<DialogListId, DialogPositionInList, DialogListIdHash> get_dialog_positions(const Dialog *d) const;
 
@@ -3228,6 +3249,14 @@ class MessagesManager final : public Actor {
   WaitFreeHashMap<DialogId, unique_ptr<Dialog>, DialogIdHash> dialogs_;
   int64 added_message_count_ = 0;
 
+  int64 loaded_message_count_ = 0;  // number of non-scheduled messages in Dialog::messages of all dialogs
+  int64 lru_unloaded_message_count_ = 0;
+  bool is_lru_message_unload_pending_ = false;
+
+  int32 message_batch_depth_ = 0;
+  vector<DialogId> postponed_chat_last_message_updates_;
+  FlatHashSet<DialogId, DialogIdHash> postponed_chat_last_message_update_dialog_ids_;
+
   FlatHashSet<DialogId, DialogIdHash> loaded_dialogs_;  // dialogs loaded from database, but not added to dialogs_
   FlatHashSet<DialogId, DialogIdHash> failed_to_load_dialogs_;
 
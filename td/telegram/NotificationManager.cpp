@@ -61,6 +61,7 @@
 #include "td/utils/utf8.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <limits>
 
@@ -141,9 +142,13 @@ void NotificationManager::on_flush_pending_notifications_timeout_callback(void *
   auto notification_manager = static_cast<NotificationManager *>(notification_manager_ptr);
   VLOG(notifications) << "Ready to flush pending notifications for notification group " << group_id_int;
   if (group_id_int > 0) {
-    send_closure_later(notification_manager->actor_id(notification_manager),
-                       &NotificationManager::flush_pending_notifications,
-                       NotificationGroupId(narrow_cast<int32>(group_id_int)));
+    // all groups with expired timeouts are flushed in a single pass
+    auto &group_ids = notification_manager->ready_notification_group_ids_;
+    group_ids.push_back(NotificationGroupId(narrow_cast<int32>(group_id_int)));
+    if (group_ids.size() == 1) {
+      send_closure_later(notification_manager->actor_id(notification_manager),
+                         &NotificationManager::flush_ready_pending_notifications);
+    }
   } else if (group_id_int == 0) {
     send_closure_later(notification_manager->actor_id(notification_manager),
                        &NotificationManager::after_get_difference_impl);
@@ -161,8 +166,18 @@ void NotificationManager::on_flush_pending_updates_timeout_callback(void *notifi
   }
 
   auto notification_manager = static_cast<NotificationManager *>(notification_manager_ptr);
-  send_closure_later(notification_manager->actor_id(notification_manager), &NotificationManager::flush_pending_updates,
-                     narrow_cast<int32>(group_id_int), "timeout");
+  auto &group_ids = notification_manager->ready_update_group_ids_;
+  group_ids.push_back(narrow_cast<int32>(group_id_int));
+  if (group_ids.size() == 1) {
+    send_closure_later(notification_manager->actor_id(notification_manager),
+                       &NotificationManager::flush_ready_pending_updates);
+  }
+}
+
+double NotificationManager::get_aligned_flush_time(double flush_time) {
+  // round the time up to the end of a flush window, so timeouts of all groups in the window expire together
+  constexpr double WINDOW = FLUSH_WINDOW_MS * 1e-3;
+  return std::ceil(flush_time / WINDOW) * WINDOW;
 }
 
 bool NotificationManager::is_disabled() const {
@@ -935,7 +950,7 @@ void NotificationManager::add_notification(NotificationGroupId group_id, Notific
 
   auto delay_ms = get_notification_delay_ms(dialog_id, notification, min_delay_ms);
   VLOG(notifications) << "Delay " << notification_id << " for " << delay_ms << " milliseconds";
-  auto flush_time = delay_ms * 0.001 + Time::now();
+  auto flush_time = get_aligned_flush_time(delay_ms * 0.001 + Time::now());
 
   if (group.pending_notifications_flush_time == 0 || flush_time < group.pending_notifications_flush_time) {
     group.pending_notifications_flush_time = flush_time;
@@ -991,11 +1006,16 @@ void NotificationManager::add_update(int32 group_id, td_api::object_ptr<td_api::
   auto &updates = pending_updates_[group_id];
   if (updates.empty()) {
     on_delayed_notification_update_count_changed(1, group_id, "add_update");
+    if (!free_update_buffers_.empty()) {
+      updates = std::move(free_update_buffers_.back());
+      free_update_buffers_.pop_back();
+    }
   }
   updates.push_back(std::move(update));
   if (!G()->close_flag()) {
     if (!running_get_difference_ && running_get_chat_difference_.count(group_id) == 0) {
-      flush_pending_updates_timeout_.add_timeout_in(group_id, MIN_UPDATE_DELAY_MS * 1e-3);
+      flush_pending_updates_timeout_.add_timeout_at(group_id,
+                                                    get_aligned_flush_time(Time::now() + MIN_UPDATE_DELAY_MS * 1e-3));
     } else {
       flush_pending_updates_timeout_.set_timeout_in(group_id, MAX_UPDATE_DELAY_MS * 1e-3);
     }
@@ -1378,6 +1398,25 @@ void NotificationManager::flush_pending_updates(int32 group_id, const char *sour
   for (auto &notification : group.notifications) {
     on_notification_processed(notification.notification_id);
   }
+
+  if (free_update_buffers_.size() < MAX_FREE_UPDATE_BUFFERS && updates.capacity() <= MAX_FREE_UPDATE_BUFFER_SIZE) {
+    updates.clear();
+    free_update_buffers_.push_back(std::move(updates));
+  }
+}
+
+void NotificationManager::flush_ready_pending_updates() {
+  CHECK(flushed_update_group_ids_.empty());
+  std::swap(flushed_update_group_ids_, ready_update_group_ids_);
+  update_flush_pass_count_++;
+  flushed_update_group_count_ += flushed_update_group_ids_.size();
+  VLOG(notifications) << "Flush pending updates in " << flushed_update_group_ids_.size()
+                      << " notification groups; totally flushed " << flushed_update_group_count_ << " groups in "
+                      << update_flush_pass_count_ << " passes";
+  for (auto group_id : flushed_update_group_ids_) {
+    flush_pending_updates(group_id, "timeout");
+  }
+  flushed_update_group_ids_.clear();
 }
 
 void NotificationManager::force_flush_pending_updates(NotificationGroupId group_id, const char *source) {
@@ -1627,6 +1666,20 @@ void NotificationManager::flush_pending_notifications(NotificationGroupId group_
   }
 }
 
+void NotificationManager::flush_ready_pending_notifications() {
+  CHECK(flushed_notification_group_ids_.empty());
+  std::swap(flushed_notification_group_ids_, ready_notification_group_ids_);
+  notification_flush_pass_count_++;
+  flushed_notification_group_count_ += flushed_notification_group_ids_.size();
+  VLOG(notifications) << "Flush pending notifications in " << flushed_notification_group_ids_.size()
+                      << " ready notification groups; totally flushed " << flushed_notification_group_count_
+                      << " groups in " << notification_flush_pass_count_ << " passes";
+  for (auto group_id : flushed_notification_group_ids_) {
+    flush_pending_notifications(group_id);
+  }
+  flushed_notification_group_ids_.clear();
+}
+
 void NotificationManager::flush_all_pending_notifications() {
   std::multimap<int32, NotificationGroupId> group_ids;
   for (auto &group_it : groups_) {
@@ -2794,7 +2847,7 @@ void NotificationManager::process_push_notification(string payload, Promise<Unit
     send_closure(G()->state_manager(), &StateManager::on_online, false);
   }
 
-  if (receiver_id == 0 || receiver_id == td_->option_manager_->get_option_integer("my_id")) {
+  if (receiver_id == 0 || receiver_id == td_->option_manager_->get_option_integer(CachedOption::MyId)) {
     auto status = process_push_notification_payload(payload, was_encrypted, promise);
     if (status.is_error()) {
       if (status.code() == 406 || status.code() == 200) {
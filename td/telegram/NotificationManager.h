@@ -152,6 +152,11 @@ class NotificationManager final : public Actor {
   static constexpr int32 MIN_UPDATE_DELAY_MS = 50;
   static constexpr int32 MAX_UPDATE_DELAY_MS = 60000;
 
+  static constexpr int32 FLUSH_WINDOW_MS = 20;  // flush timeouts are rounded up to the end of a window of this size
+
+  static constexpr size_t MAX_FREE_UPDATE_BUFFERS = 100;
+  static constexpr size_t MAX_FREE_UPDATE_BUFFER_SIZE = 64;
+
   static constexpr int32 ANNOUNCEMENT_ID_CACHE_TIME = 7 * 86400;
 
   static constexpr int32 USER_FLAG_HAS_ACCESS_HASH = 1 << 0;
@@ -215,6 +220,8 @@ class NotificationManager final : public Actor {
 
   static void on_flush_pending_updates_timeout_callback(void *notification_manager_ptr, int64 group_id_int);
 
+  static double get_aligned_flush_time(double flush_time);
+
   bool is_disabled() const;
 
   void start_up() final;
@@ -286,6 +293,8 @@ class NotificationManager final : public Actor {
 
   void flush_pending_notifications(NotificationGroupId group_id);
 
+  void flush_ready_pending_notifications();
+
   void flush_all_pending_notifications();
 
   void on_notification_processed(NotificationId notification_id);
@@ -302,6 +311,8 @@ class NotificationManager final : public Actor {
 
   void flush_pending_updates(int32 group_id, const char *source);
 
+  void flush_ready_pending_updates();
+
   void force_flush_pending_updates(NotificationGroupId group_id, const char *source);
 
   void flush_all_pending_updates(bool include_delayed_chats, const char *source);
@@ -394,6 +405,17 @@ class NotificationManager final : public Actor {
   MultiTimeout flush_pending_notifications_timeout_{"FlushPendingNotificationsTimeout"};
   MultiTimeout flush_pending_updates_timeout_{"FlushPendingUpdatesTimeout"};
 
+  vector<NotificationGroupId> ready_notification_group_ids_;  // groups with expired pending notifications timeout
+  vector<NotificationGroupId> flushed_notification_group_ids_;
+  vector<int32> ready_update_group_ids_;                     // groups with expired pending updates timeout
+  vector<int32> flushed_update_group_ids_;
+  vector<vector<td_api::object_ptr<td_api::Update>>> free_update_buffers_;  // reused for pending_updates_
+
+  uint64 notification_flush_pass_count_ = 0;
+  uint64 flushed_notification_group_count_ = 0;
+  uint64 update_flush_pass_count_ = 0;
+  uint64 flushed_update_group_count_ = 0;
+
   vector<NotificationGroupId> call_notification_group_ids_;
   FlatHashSet<NotificationGroupId, NotificationGroupIdHash> available_call_notification_group_ids_;
   FlatHashMap<DialogId, NotificationGroupId, DialogIdHash> dialog_id_to_call_notification_group_id_;
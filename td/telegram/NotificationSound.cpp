@@ -100,6 +100,10 @@ static void parse(unique_ptr<NotificationSound> &notification_sound, ParserT &pa
   }
 }
 
+void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerBuffer &storer) {
+  store(notification_sound, storer);
+}
+
 void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerCalcLength &storer) {
   store(notification_sound, storer);
 }
@@ -32,6 +32,8 @@ class NotificationSound {
 
 StringBuilder &operator<<(StringBuilder &string_builder, const unique_ptr<NotificationSound> &notification_sound);
 
+void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerBuffer &storer);
+
 void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerCalcLength &storer);
 
 void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerUnsafe &storer);
@@ -18,11 +18,14 @@
 #include "td/telegram/Global.h"
 #include "td/telegram/JsonValue.h"
 #include "td/telegram/LanguagePackManager.h"
+#include "td/telegram/MessageDb.h"
+#include "td/telegram/net/ConnectionCreator.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/NotificationManager.h"
 #include "td/telegram/PeopleNearbyManager.h"
 #include "td/telegram/ReactionType.h"
+#include "td/telegram/SequenceDispatcher.h"
 #include "td/telegram/StateManager.h"
 #include "td/telegram/StickersManager.h"
 #include "td/telegram/StorageManager.h"
@@ -33,6 +36,9 @@
 #include "td/telegram/TopDialogManager.h"
 #include "td/telegram/UserManager.h"
 
+#include "td/mtproto/CryptoWorkerPool.h"
+#include "td/mtproto/SessionConnection.h"
+
 #include "td/db/KeyValueSyncInterface.h"
 #include "td/db/TsSeqKeyValue.h"
 
@@ -43,6 +49,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
+#include "td/utils/port/SocketFd.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 
@@ -55,7 +62,7 @@ namespace td {
 OptionManager::OptionManager(Td *td)
     : td_(td)
     , current_scheduler_id_(Scheduler::instance()->sched_id())
-    , options_(td::make_unique<TsSeqKeyValue>())
+    , options_(std::make_shared<TsSeqKeyValue>())
     , option_pmc_(G()->td_db()->get_config_pmc_shared()) {
   send_unix_time_update();
 
@@ -151,10 +158,27 @@ OptionManager::OptionManager(Td *td)
   set_default_integer_option("business_chat_link_count_max", is_test_dc ? 5 : 100);
   set_default_integer_option("pinned_story_count_max", 3);
 
+  for (int32 i = 0; i < static_cast<int32>(CachedOption::Count); i++) {
+    auto name = get_cached_option_name(static_cast<CachedOption>(i));
+    update_cached_option(name, options.get(name.str()));
+  }
+
   if (options.isset("my_phone_number") || !options.isset("my_id")) {
     update_premium_options();
   }
 
+  mtproto::CryptoWorkerPool::set_thread_count(narrow_cast<int32>(get_option_integer("crypto_thread_count")));
+  mtproto::SessionConnection::set_max_query_delay(
+      static_cast<double>(get_option_integer("query_coalescing_delay_ms",
+                                             mtproto::SessionConnection::DEFAULT_MAX_QUERY_DELAY_MS)) *
+      1e-3);
+  Scheduler::set_timer_slack(
+      static_cast<double>(get_option_integer("timer_slack_ms", Scheduler::DEFAULT_TIMER_SLACK_MS)) * 1e-3);
+  update_zero_copy_upload();
+  if (options.isset("message_fts_automerge") || options.isset("message_fts_crisismerge")) {
+    update_message_fts_merge_parameters();
+  }
+
   set_option_empty("archive_and_mute_new_chats_from_unknown_users");
   set_option_empty("business_intro_title_length_max");
   set_option_empty("business_intro_message_length_max");
@@ -168,8 +192,23 @@ OptionManager::OptionManager(Td *td)
 
 OptionManager::~OptionManager() = default;
 
+void OptionManager::update_zero_copy_upload() const {
+  // zero-copy sends are beneficial only for big writes, which happen mostly during file uploading
+  constexpr size_t ZERO_COPY_MIN_SIZE = 1 << 16;
+  SocketFd::set_zero_copy_min_size(get_option_boolean("use_zero_copy_upload") ? ZERO_COPY_MIN_SIZE : 0);
+}
+
+void OptionManager::update_message_fts_merge_parameters() const {
+  if (!G()->use_message_database()) {
+    return;
+  }
+  G()->td_db()->get_message_db_async()->set_fts_merge_parameters(
+      narrow_cast<int32>(get_option_integer("message_fts_automerge", 4)),
+      narrow_cast<int32>(get_option_integer("message_fts_crisismerge", 16)), Auto());
+}
+
 void OptionManager::update_premium_options() {
-  bool is_premium = get_option_boolean("is_premium");
+  bool is_premium = get_option_boolean(CachedOption::IsPremium);
   if (is_premium) {
     set_option_integer("saved_animations_limit", get_option_integer("saved_gifs_limit_premium", 400));
     set_option_integer("favorite_stickers_limit", get_option_integer("stickers_faved_limit_premium", 10));
@@ -290,6 +329,59 @@ string OptionManager::get_option_string(Slice name, string default_value) const
   return value.substr(1);
 }
 
+bool OptionManager::get_option_boolean(CachedOption option, bool default_value) const {
+  const auto &cached_option = cached_options_[static_cast<int32>(option)];
+  if (!cached_option.is_set.load(std::memory_order_acquire)) {
+    return default_value;
+  }
+  return cached_option.value.load(std::memory_order_relaxed) != 0;
+}
+
+int64 OptionManager::get_option_integer(CachedOption option, int64 default_value) const {
+  const auto &cached_option = cached_options_[static_cast<int32>(option)];
+  if (!cached_option.is_set.load(std::memory_order_acquire)) {
+    return default_value;
+  }
+  return cached_option.value.load(std::memory_order_relaxed);
+}
+
+Slice OptionManager::get_cached_option_name(CachedOption option) {
+  switch (option) {
+    case CachedOption::IsPremium:
+      return Slice("is_premium");
+    case CachedOption::MyId:
+      return Slice("my_id");
+    case CachedOption::PreferIpv6:
+      return Slice("prefer_ipv6");
+    case CachedOption::SessionCount:
+      return Slice("session_count");
+    case CachedOption::UseQuickAck:
+      return Slice("use_quick_ack");
+    case CachedOption::UtcTimeOffset:
+      return Slice("utc_time_offset");
+    default:
+      UNREACHABLE();
+      return Slice();
+  }
+}
+
+void OptionManager::update_cached_option(Slice name, Slice value) {
+  for (int32 i = 0; i < static_cast<int32>(CachedOption::Count); i++) {
+    if (get_cached_option_name(static_cast<CachedOption>(i)) != name) {
+      continue;
+    }
+    auto &cached_option = cached_options_[i];
+    if (value.empty() || (value[0] != 'B' && value[0] != 'I')) {
+      cached_option.is_set.store(false, std::memory_order_release);
+    } else {
+      auto cached_value = value[0] == 'B' ? static_cast<int64>(value == "Btrue") : to_integer<int64>(value.substr(1));
+      cached_option.value.store(cached_value, std::memory_order_relaxed);
+      cached_option.is_set.store(true, std::memory_order_release);
+    }
+    return;
+  }
+}
+
 void OptionManager::set_option(Slice name, Slice value) {
   CHECK(!name.empty());
   CHECK(Scheduler::instance()->sched_id() == current_scheduler_id_);
@@ -305,6 +397,8 @@ void OptionManager::set_option(Slice name, Slice value) {
     option_pmc_->set(name.str(), value.str());
   }
 
+  update_cached_option(name, value);
+
   if (!G()->close_flag() && is_td_inited_) {
     on_option_updated(name);
   }
@@ -502,6 +596,9 @@ void OptionManager::on_option_updated(Slice name) {
           G()->net_query_dispatcher().update_mtproto_header();
         }
       }
+      if (name == "crypto_thread_count") {
+        mtproto::CryptoWorkerPool::set_thread_count(narrow_cast<int32>(get_option_integer(name)));
+      }
       break;
     case 'd':
       if (name == "dice_emojis") {
@@ -570,6 +667,9 @@ void OptionManager::on_option_updated(Slice name) {
       }
       break;
     case 'm':
+      if (name == "message_fts_automerge" || name == "message_fts_crisismerge") {
+        update_message_fts_merge_parameters();
+      }
       if (name == "my_phone_number") {
         send_closure(G()->config_manager(), &ConfigManager::reget_config, Promise<Unit>());
       }
@@ -603,6 +703,13 @@ void OptionManager::on_option_updated(Slice name) {
         send_closure(td_->notification_manager_actor_, &NotificationManager::on_online_cloud_timeout_changed);
       }
       break;
+    case 'q':
+      if (name == "query_coalescing_delay_ms") {
+        mtproto::SessionConnection::set_max_query_delay(
+            static_cast<double>(get_option_integer(name, mtproto::SessionConnection::DEFAULT_MAX_QUERY_DELAY_MS)) *
+            1e-3);
+      }
+      break;
     case 'r':
       if (name == "rating_e_decay") {
         send_closure(td_->top_dialog_manager_actor_, &TopDialogManager::update_rating_e_decay);
@@ -615,14 +722,35 @@ void OptionManager::on_option_updated(Slice name) {
       if (name == "saved_animations_limit") {
         td_->animations_manager_->on_update_saved_animations_limit();
       }
-      if (name == "session_count") {
+      if (name == "sequence_dispatcher_window_size") {
+        G()->net_query_dispatcher().update_sequence_dispatcher_window_size();
+      }
+      if (name == "session_count" || name == "session_count_max") {
         G()->net_query_dispatcher().update_session_count();
       }
+      if (name == "spare_connection_count") {
+        send_closure(G()->connection_creator(), &ConnectionCreator::on_spare_connection_count_changed);
+      }
+      break;
+    case 't':
+      if (name == "timer_slack_ms") {
+        Scheduler::set_timer_slack(
+            static_cast<double>(get_option_integer(name, Scheduler::DEFAULT_TIMER_SLACK_MS)) * 1e-3);
+      }
       break;
     case 'u':
+      if (name == "update_coalescing_delay_ms") {
+        td_->on_update_coalescing_delay_changed();
+      }
+      if (name == "user_full_info_count_max") {
+        send_closure(td_->user_manager_actor_, &UserManager::on_user_full_info_count_max_changed);
+      }
       if (name == "use_pfs") {
         G()->net_query_dispatcher().update_use_pfs();
       }
+      if (name == "use_zero_copy_upload") {
+        update_zero_copy_upload();
+      }
       if (name == "use_storage_optimizer") {
         send_closure(td_->storage_manager_, &StorageManager::update_use_storage_optimizer);
       }
@@ -682,6 +810,14 @@ void OptionManager::get_option(const string &name, Promise<td_api::object_ptr<td
         return promise.set_value(td_api::make_object<td_api::optionValueBoolean>(td_->is_online()));
       }
       break;
+    case 's':
+      if (name == "shed_network_query_count") {
+        return promise.set_value(td_api::make_object<td_api::optionValueInteger>(G()->get_shed_network_query_count()));
+      }
+      if (name == "shed_request_count") {
+        return promise.set_value(td_api::make_object<td_api::optionValueInteger>(td_->get_shed_request_count()));
+      }
+      break;
     case 'u':
       if (name == "unix_time") {
         return promise.set_value(get_unix_time_option_value_object());
@@ -691,6 +827,34 @@ void OptionManager::get_option(const string &name, Promise<td_api::object_ptr<td
   wrap_promise().set_value(Unit());
 }
 
+// options, whose values are returned by get_option without looking in the option storage
+bool OptionManager::is_computed_option(Slice name) {
+  static const FlatHashSet<Slice, SliceHash> computed_options{"can_ignore_sensitive_content_restrictions",
+                                                              "disable_contact_registered_notifications",
+                                                              "ignore_sensitive_content_restrictions",
+                                                              "is_location_visible",
+                                                              "online",
+                                                              "shed_network_query_count",
+                                                              "shed_request_count",
+                                                              "unix_time"};
+  return computed_options.count(name) > 0;
+}
+
+std::shared_ptr<const TsSeqKeyValue> OptionManager::get_option_storage() const {
+  return options_;
+}
+
+td_api::object_ptr<td_api::OptionValue> OptionManager::get_stored_option_value_object(
+    const TsSeqKeyValue &option_storage, Slice name) {
+  if (name.empty() || is_computed_option(name)) {
+    return nullptr;
+  }
+  if (is_synchronous_option(name)) {
+    return get_option_synchronously(name);
+  }
+  return get_option_value_object(option_storage.get(name.str()));
+}
+
 td_api::object_ptr<td_api::OptionValue> OptionManager::get_option_synchronously(Slice name) {
   CHECK(!name.empty());
   switch (name[0]) {
@@ -809,6 +973,12 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
           })) {
         return;
       }
+      if (!is_bot && set_integer_option("chat_action_update_count_max", 0, 1000)) {
+        return;
+      }
+      if (set_integer_option("crypto_thread_count", 0, mtproto::CryptoWorkerPool::MAX_THREAD_COUNT)) {
+        return;
+      }
       break;
     case 'd':
       if (!is_bot && set_boolean_option("disable_animated_emoji")) {
@@ -823,6 +993,9 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       if (set_boolean_option("disable_persistent_network_statistics")) {
         return;
       }
+      if (set_boolean_option("disable_persistent_dns_cache")) {
+        return;
+      }
       if (!is_bot && set_boolean_option("disable_sent_scheduled_message_notifications")) {
         return;
       }
@@ -838,6 +1011,11 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
         return promise.set_value(Unit());
       }
       break;
+    case 'f':
+      if (set_integer_option("file_content_cache_size")) {
+        return;
+      }
+      break;
     case 'i':
       if (set_boolean_option("ignore_background_updates")) {
         return;
@@ -892,6 +1070,15 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'm':
+      if (set_integer_option("message_cache_count_max")) {
+        return;
+      }
+      if (set_integer_option("message_fts_automerge", 0, 16)) {
+        return;
+      }
+      if (set_integer_option("message_fts_crisismerge", 2, 64)) {
+        return;
+      }
       if (set_integer_option("message_unload_delay", 60, 86400)) {
         return;
       }
@@ -924,6 +1111,9 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'p':
+      if (set_integer_option("pending_update_count_max")) {
+        return;
+      }
       if (set_boolean_option("prefer_ipv6")) {
         send_closure(td_->state_manager_, &StateManager::on_network_updated);
         return;
@@ -932,7 +1122,15 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
         return;
       }
       break;
+    case 'q':
+      if (set_integer_option("query_coalescing_delay_ms", 0, 1000)) {
+        return;
+      }
+      break;
     case 'r':
+      if (set_integer_option("request_priority", 0, 2)) {
+        return;
+      }
       // temporary option
       if (set_boolean_option("reuse_uploaded_photos_by_hash")) {
         return;
@@ -951,6 +1149,15 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       if (set_integer_option("storage_immunity_delay")) {
         return;
       }
+      if (set_integer_option("spare_connection_count", 0, ConnectionCreator::MAX_SPARE_CONNECTION_COUNT)) {
+        return;
+      }
+      if (set_integer_option("session_count_max", 0, 50)) {
+        return;
+      }
+      if (set_integer_option("sequence_dispatcher_window_size", 1, MultiSequenceDispatcher::MAX_MAX_ACTIVE_QUERIES)) {
+        return;
+      }
       if (set_boolean_option("store_all_files_in_files_directory")) {
         return;
       }
@@ -959,17 +1166,32 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       if (set_boolean_option("test_flood_wait")) {
         return;
       }
+      if (set_integer_option("timer_slack_ms", 0, 60000)) {
+        return;
+      }
       break;
     case 'u':
+      if (set_integer_option("update_coalescing_delay_ms", 0, 1000)) {
+        return;
+      }
       if (set_boolean_option("use_pfs")) {
         return;
       }
       if (set_boolean_option("use_quick_ack")) {
         return;
       }
+      if (set_boolean_option("use_shared_file_store")) {
+        return;
+      }
       if (set_boolean_option("use_storage_optimizer")) {
         return;
       }
+      if (set_boolean_option("use_zero_copy_upload")) {
+        return;
+      }
+      if (set_integer_option("user_full_info_count_max", 0)) {
+        return;
+      }
       if (set_integer_option("utc_time_offset", -12 * 60 * 60, 14 * 60 * 60)) {
         return;
       }
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/telegram/Global.h"
 #include "td/telegram/td_api.h"
 
 #include "td/utils/common.h"
@@ -51,6 +52,11 @@ class OptionManager {
 
   string get_option_string(Slice name, string default_value = "") const;
 
+  // reads the cached value with a single atomic load; can be called from any thread
+  bool get_option_boolean(CachedOption option, bool default_value = false) const;
+
+  int64 get_option_integer(CachedOption option, int64 default_value = 0) const;
+
   void on_update_server_time_difference();
 
   void get_option(const string &name, Promise<td_api::object_ptr<td_api::OptionValue>> &&promise);
@@ -61,6 +67,13 @@ class OptionManager {
 
   static td_api::object_ptr<td_api::OptionValue> get_option_synchronously(Slice name);
 
+  // returns a thread-safe storage of option values, which can be read from any thread
+  std::shared_ptr<const TsSeqKeyValue> get_option_storage() const;
+
+  // returns nullptr if the option value can't be found in the storage and must be received through get_option
+  static td_api::object_ptr<td_api::OptionValue> get_stored_option_value_object(const TsSeqKeyValue &option_storage,
+                                                                                Slice name);
+
   static void get_common_state(vector<td_api::object_ptr<td_api::Update>> &updates);
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
@@ -74,6 +87,8 @@ class OptionManager {
 
   static bool is_internal_option(Slice name);
 
+  static bool is_computed_option(Slice name);
+
   td_api::object_ptr<td_api::Update> get_internal_option_update(Slice name) const;
 
   static const vector<Slice> &get_synchronous_options();
@@ -84,15 +99,29 @@ class OptionManager {
 
   void send_unix_time_update();
 
+  void update_zero_copy_upload() const;
+
+  void update_message_fts_merge_parameters() const;
+
+  static Slice get_cached_option_name(CachedOption option);
+
+  void update_cached_option(Slice name, Slice value);
+
   Td *td_;
   bool is_td_inited_ = false;
   vector<std::pair<string, Promise<td_api::object_ptr<td_api::OptionValue>>>> pending_get_options_;
 
   int32 current_scheduler_id_ = -1;
-  unique_ptr<TsSeqKeyValue> options_;
+  std::shared_ptr<TsSeqKeyValue> options_;
   std::shared_ptr<KeyValueSyncInterface> option_pmc_;
 
   std::atomic<double> last_sent_server_time_difference_{1e100};
+
+  struct CachedOptionValue {
+    std::atomic<bool> is_set{false};
+    std::atomic<int64> value{0};  // 0 or 1 for boolean options
+  };
+  CachedOptionValue cached_options_[static_cast<int32>(CachedOption::Count)];
 };
 
 }  // namespace td
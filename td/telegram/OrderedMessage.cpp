@@ -8,28 +8,63 @@
 
 #include "td/utils/logging.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace td {
 
-void OrderedMessages::insert(MessageId message_id, bool auto_attach, MessageId old_last_message_id,
-                             const char *source) {
-  auto random_y = static_cast<int32>(static_cast<uint32>(message_id.get() * 2101234567u));
-  unique_ptr<OrderedMessage> *v = &messages_;
-  while (*v != nullptr && (*v)->random_y_ >= random_y) {
-    if ((*v)->message_id_.get() < message_id.get()) {
-      v = &(*v)->right_;
-    } else if ((*v)->message_id_ == message_id) {
-      UNREACHABLE();
-    } else {
-      v = &(*v)->left_;
-    }
+constexpr size_t OrderedMessages::MAX_CHUNK_SIZE;
+
+bool OrderedMessages::find_message(const vector<Chunk> &chunks, MessageId message_id, size_t &chunk_pos,
+                                   size_t &pos) {
+  auto chunk_it = std::upper_bound(chunks.begin(), chunks.end(), message_id, [](MessageId lhs, const Chunk &rhs) {
+    return lhs < rhs[0].message_id_;
+  });
+  if (chunk_it == chunks.begin()) {
+    return false;
   }
+  --chunk_it;
+  auto it = std::upper_bound(chunk_it->begin(), chunk_it->end(), message_id,
+                             [](MessageId lhs, const OrderedMessage &rhs) { return lhs < rhs.message_id_; });
+  CHECK(it != chunk_it->begin());
+  chunk_pos = static_cast<size_t>(chunk_it - chunks.begin());
+  pos = static_cast<size_t>(it - chunk_it->begin()) - 1;
+  return true;
+}
 
-  auto message = make_unique<OrderedMessage>();
-  message->message_id_ = message_id;
-  message->random_y_ = random_y;
+bool OrderedMessages::get_next_position(const vector<Chunk> &chunks, size_t &chunk_pos, size_t &pos) {
+  if (pos + 1 < chunks[chunk_pos].size()) {
+    pos++;
+    return true;
+  }
+  if (chunk_pos + 1 < chunks.size()) {
+    chunk_pos++;
+    pos = 0;
+    return true;
+  }
+  return false;
+}
+
+bool OrderedMessages::get_previous_position(const vector<Chunk> &chunks, size_t &chunk_pos, size_t &pos) {
+  if (pos > 0) {
+    pos--;
+    return true;
+  }
+  if (chunk_pos > 0) {
+    chunk_pos--;
+    pos = chunks[chunk_pos].size() - 1;
+    return true;
+  }
+  return false;
+}
+
+void OrderedMessages::insert(MessageId message_id, bool auto_attach, MessageId old_last_message_id,
+                             const char *source) {
+  OrderedMessage message;
+  message.message_id_ = message_id;
 
   if (auto_attach) {
-    auto_attach_message(message.get(), old_last_message_id, source);
+    auto_attach_message(&message, old_last_message_id, source);
   } else {
     auto it = get_iterator(message_id);
     if (*it != nullptr && (*it)->have_next_) {
@@ -46,72 +81,79 @@ void OrderedMessages::insert(MessageId message_id, bool auto_attach, MessageId o
     }
   }
 
-  unique_ptr<OrderedMessage> *left = &message->left_;
-  unique_ptr<OrderedMessage> *right = &message->right_;
-
-  unique_ptr<OrderedMessage> cur = std::move(*v);
-  while (cur != nullptr) {
-    if (cur->message_id_.get() < message_id.get()) {
-      *left = std::move(cur);
-      left = &((*left)->right_);
-      cur = std::move(*left);
-    } else {
-      *right = std::move(cur);
-      right = &((*right)->left_);
-      cur = std::move(*right);
-    }
+  do_insert(std::move(message));
+}
+
+void OrderedMessages::do_insert(OrderedMessage &&message) {
+  auto message_id = message.message_id_;
+  size_t chunk_pos = 0;
+  size_t pos = 0;
+  if (find_message(chunks_, message_id, chunk_pos, pos)) {
+    CHECK(chunks_[chunk_pos][pos].message_id_ != message_id);
+    pos++;
+  } else if (chunks_.empty()) {
+    chunks_.emplace_back();
+  }
+
+  auto &chunk = chunks_[chunk_pos];
+  chunk.insert(chunk.begin() + pos, std::move(message));
+  if (chunk.size() <= MAX_CHUNK_SIZE) {
+    return;
+  }
+
+  // messages are usually added to the beginning or to the end of the history,
+  // so keep the outermost chunks full in these cases
+  size_t split_pos = chunk.size() / 2;
+  if (chunk_pos + 1 == chunks_.size() && pos + 1 == chunk.size()) {
+    split_pos = pos;
+  } else if (chunk_pos == 0 && pos == 0) {
+    split_pos = 1;
   }
-  CHECK(*left == nullptr);
-  CHECK(*right == nullptr);
-  *v = std::move(message);
+  Chunk new_chunk;
+  new_chunk.reserve(MAX_CHUNK_SIZE);
+  new_chunk.insert(new_chunk.end(), std::make_move_iterator(chunk.begin() + split_pos),
+                   std::make_move_iterator(chunk.end()));
+  chunk.erase(chunk.begin() + split_pos, chunk.end());
+  chunks_.insert(chunks_.begin() + chunk_pos + 1, std::move(new_chunk));
 }
 
 void OrderedMessages::erase(MessageId message_id, bool only_from_memory) {
-  unique_ptr<OrderedMessage> *v = &messages_;
-  while (*v != nullptr) {
-    if ((*v)->message_id_.get() < message_id.get()) {
-      v = &(*v)->right_;
-    } else if ((*v)->message_id_.get() > message_id.get()) {
-      v = &(*v)->left_;
-    } else {
-      break;
-    }
-  }
+  size_t chunk_pos = 0;
+  size_t pos = 0;
+  CHECK(find_message(chunks_, message_id, chunk_pos, pos));
+  auto *message = &chunks_[chunk_pos][pos];
+  CHECK(message->message_id_ == message_id);
 
-  CHECK(*v != nullptr);
-  if ((*v)->have_previous_ && (only_from_memory || !(*v)->have_next_)) {
+  if (message->have_previous_ && (only_from_memory || !message->have_next_)) {
     auto it = get_iterator(message_id);
-    CHECK(*it == v->get());
+    CHECK(*it == message);
     --it;
     OrderedMessage *prev_m = *it;
     CHECK(prev_m != nullptr);
     prev_m->have_next_ = false;
   }
-  if ((*v)->have_next_ && (only_from_memory || !(*v)->have_previous_)) {
+  if (message->have_next_ && (only_from_memory || !message->have_previous_)) {
     auto it = get_iterator(message_id);
-    CHECK(*it == v->get());
+    CHECK(*it == message);
     ++it;
     OrderedMessage *next_m = *it;
     CHECK(next_m != nullptr);
     next_m->have_previous_ = false;
   }
 
-  unique_ptr<OrderedMessage> result = std::move(*v);
-  unique_ptr<OrderedMessage> left = std::move(result->left_);
-  unique_ptr<OrderedMessage> right = std::move(result->right_);
-
-  while (left != nullptr || right != nullptr) {
-    if (left == nullptr || (right != nullptr && right->random_y_ > left->random_y_)) {
-      *v = std::move(right);
-      v = &((*v)->left_);
-      right = std::move(*v);
-    } else {
-      *v = std::move(left);
-      v = &((*v)->right_);
-      left = std::move(*v);
-    }
+  auto &chunk = chunks_[chunk_pos];
+  chunk.erase(chunk.begin() + pos);
+  if (chunk.empty()) {
+    chunks_.erase(chunks_.begin() + chunk_pos);
+    return;
+  }
+
+  // merge small neighbour chunks to keep the number of chunks proportional to the number of messages
+  if (chunk_pos + 1 < chunks_.size() && chunk.size() + chunks_[chunk_pos + 1].size() <= MAX_CHUNK_SIZE / 2) {
+    auto &next_chunk = chunks_[chunk_pos + 1];
+    chunk.insert(chunk.end(), std::make_move_iterator(next_chunk.begin()), std::make_move_iterator(next_chunk.end()));
+    chunks_.erase(chunks_.begin() + chunk_pos + 1);
   }
-  CHECK(*v == nullptr);
 }
 
 void OrderedMessages::attach_message_to_previous(MessageId message_id, const char *source) {
@@ -181,15 +223,15 @@ void OrderedMessages::auto_attach_message(OrderedMessage *message, MessageId las
   }
   if (!message_id.is_yet_unsent()) {
     // message may be attached to the next message if there is no previous message
-    OrderedMessage *cur = messages_.get();
     OrderedMessage *next_message = nullptr;
-    while (cur != nullptr) {
-      if (cur->message_id_ < message_id) {
-        cur = cur->right_.get();
-      } else {
-        next_message = cur;
-        cur = cur->left_.get();
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    if (!find_message(chunks_, message_id, chunk_pos, pos)) {
+      if (!chunks_.empty()) {
+        next_message = &chunks_[0][0];
       }
+    } else if (get_next_position(chunks_, chunk_pos, pos)) {
+      next_message = &chunks_[chunk_pos][pos];
     }
     if (next_message != nullptr) {
       CHECK(!next_message->have_previous_);
@@ -203,117 +245,76 @@ void OrderedMessages::auto_attach_message(OrderedMessage *message, MessageId las
   LOG(INFO) << "Can't auto-attach " << message_id << " from " << source;
 }
 
-void OrderedMessages::do_find_older_messages(const OrderedMessage *ordered_message, MessageId max_message_id,
-                                             vector<MessageId> &message_ids) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  do_find_older_messages(ordered_message->left_.get(), max_message_id, message_ids);
-
-  if (ordered_message->message_id_ <= max_message_id) {
-    message_ids.push_back(ordered_message->message_id_);
-
-    do_find_older_messages(ordered_message->right_.get(), max_message_id, message_ids);
-  }
-}
-
 vector<MessageId> OrderedMessages::find_older_messages(MessageId max_message_id) const {
   vector<MessageId> message_ids;
-  do_find_older_messages(messages_.get(), max_message_id, message_ids);
-  return message_ids;
-}
-
-void OrderedMessages::do_find_newer_messages(const OrderedMessage *ordered_message, MessageId min_message_id,
-                                             vector<MessageId> &message_ids) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  if (ordered_message->message_id_ > min_message_id) {
-    do_find_newer_messages(ordered_message->left_.get(), min_message_id, message_ids);
-
-    message_ids.push_back(ordered_message->message_id_);
+  for (auto &chunk : chunks_) {
+    for (auto &message : chunk) {
+      if (message.message_id_ > max_message_id) {
+        return message_ids;
+      }
+      message_ids.push_back(message.message_id_);
+    }
   }
-
-  do_find_newer_messages(ordered_message->right_.get(), min_message_id, message_ids);
+  return message_ids;
 }
 
 vector<MessageId> OrderedMessages::find_newer_messages(MessageId min_message_id) const {
   vector<MessageId> message_ids;
-  do_find_newer_messages(messages_.get(), min_message_id, message_ids);
-  return message_ids;
-}
-
-MessageId OrderedMessages::do_find_message_by_date(const OrderedMessage *ordered_message, int32 date,
-                                                   const std::function<int32(MessageId)> &get_message_date) {
-  if (ordered_message == nullptr) {
-    return MessageId();
-  }
-
-  auto message_date = get_message_date(ordered_message->message_id_);
-  if (message_date > date) {
-    return do_find_message_by_date(ordered_message->left_.get(), date, get_message_date);
+  size_t chunk_pos = 0;
+  size_t pos = 0;
+  if (find_message(chunks_, min_message_id, chunk_pos, pos)) {
+    if (!get_next_position(chunks_, chunk_pos, pos)) {
+      return message_ids;
+    }
+  } else if (chunks_.empty()) {
+    return message_ids;
   }
-
-  auto message_id = do_find_message_by_date(ordered_message->right_.get(), date, get_message_date);
-  if (message_id.is_valid()) {
-    return message_id;
+  for (; chunk_pos < chunks_.size(); chunk_pos++, pos = 0) {
+    auto &chunk = chunks_[chunk_pos];
+    for (; pos < chunk.size(); pos++) {
+      message_ids.push_back(chunk[pos].message_id_);
+    }
   }
-
-  return ordered_message->message_id_;
+  return message_ids;
 }
 
 MessageId OrderedMessages::find_message_by_date(int32 date,
                                                 const std::function<int32(MessageId)> &get_message_date) const {
-  return do_find_message_by_date(messages_.get(), date, get_message_date);
-}
-
-void OrderedMessages::do_find_messages_by_date(const OrderedMessage *ordered_message, int32 min_date, int32 max_date,
-                                               const std::function<int32(MessageId)> &get_message_date,
-                                               vector<MessageId> &message_ids) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  auto message_date = get_message_date(ordered_message->message_id_);
-  if (message_date >= min_date) {
-    do_find_messages_by_date(ordered_message->left_.get(), min_date, max_date, get_message_date, message_ids);
-    if (message_date <= max_date) {
-      message_ids.push_back(ordered_message->message_id_);
-    }
-  }
-  if (message_date <= max_date) {
-    do_find_messages_by_date(ordered_message->right_.get(), min_date, max_date, get_message_date, message_ids);
+  // find the last message with date not greater than the given date, assuming that dates increase with identifiers
+  auto chunk_it = std::upper_bound(chunks_.begin(), chunks_.end(), date, [&](int32 lhs, const Chunk &rhs) {
+    return lhs < get_message_date(rhs[0].message_id_);
+  });
+  if (chunk_it == chunks_.begin()) {
+    return MessageId();
   }
+  --chunk_it;
+  auto it = std::upper_bound(chunk_it->begin(), chunk_it->end(), date, [&](int32 lhs, const OrderedMessage &rhs) {
+    return lhs < get_message_date(rhs.message_id_);
+  });
+  CHECK(it != chunk_it->begin());
+  --it;
+  return it->message_id_;
 }
 
 vector<MessageId> OrderedMessages::find_messages_by_date(
     int32 min_date, int32 max_date, const std::function<int32(MessageId)> &get_message_date) const {
   vector<MessageId> message_ids;
-  do_find_messages_by_date(messages_.get(), min_date, max_date, get_message_date, message_ids);
-  return message_ids;
-}
-
-void OrderedMessages::do_traverse_messages(const OrderedMessage *ordered_message,
-                                           const std::function<bool(MessageId)> &need_scan_older,
-                                           const std::function<bool(MessageId)> &need_scan_newer) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  if (need_scan_older(ordered_message->message_id_)) {
-    do_traverse_messages(ordered_message->left_.get(), need_scan_older, need_scan_newer);
-  }
-
-  if (need_scan_newer(ordered_message->message_id_)) {
-    do_traverse_messages(ordered_message->right_.get(), need_scan_older, need_scan_newer);
+  // skip chunks with all messages older than min_date, assuming that dates increase with identifiers
+  auto chunk_it = std::lower_bound(chunks_.begin(), chunks_.end(), min_date, [&](const Chunk &lhs, int32 rhs) {
+    return get_message_date(lhs.back().message_id_) < rhs;
+  });
+  for (; chunk_it != chunks_.end(); ++chunk_it) {
+    for (auto &message : *chunk_it) {
+      auto message_date = get_message_date(message.message_id_);
+      if (message_date > max_date) {
+        return message_ids;
+      }
+      if (message_date >= min_date) {
+        message_ids.push_back(message.message_id_);
+      }
+    }
   }
-}
-
-void OrderedMessages::traverse_messages(const std::function<bool(MessageId)> &need_scan_older,
-                                        const std::function<bool(MessageId)> &need_scan_newer) const {
-  do_traverse_messages(messages_.get(), need_scan_older, need_scan_newer);
+  return message_ids;
 }
 
 vector<MessageId> OrderedMessages::get_history(MessageId last_message_id, MessageId &from_message_id, int32 &offset,
@@ -341,14 +342,8 @@ vector<MessageId> OrderedMessages::get_history(MessageId last_message_id, Messag
     bool have_a_gap = false;
     if (*it == nullptr) {
       // there is no gap if from_message_id is less than the first message
-      if (force && offset < 0 && messages_ != nullptr) {
-        MessageId min_message_id;
-        traverse_messages(
-            [&](MessageId message_id) {
-              min_message_id = message_id;
-              return true;
-            },
-            [](MessageId) { return false; });
+      if (force && offset < 0 && !chunks_.empty()) {
+        MessageId min_message_id = chunks_[0][0].message_id_;
         CHECK(min_message_id > from_message_id);
         from_message_id = min_message_id;
         it = get_const_iterator(from_message_id);
@@ -25,46 +25,39 @@ class OrderedMessage {
   }
 
  private:
-  int32 random_y_ = 0;
+  MessageId message_id_;
 
   bool have_previous_ = false;
   bool have_next_ = false;
 
-  MessageId message_id_;
-
-  unique_ptr<OrderedMessage> left_;
-  unique_ptr<OrderedMessage> right_;
-
   friend class OrderedMessages;
 };
 
+// sorted array of messages split into chunks of limited size
+// messages are stored contiguously, so traversal of history doesn't need to follow a pointer for each message
 class OrderedMessages {
+  using Chunk = vector<OrderedMessage>;
+
  public:
   class IteratorBase {
-    vector<const OrderedMessage *> stack_;
+    const vector<Chunk> *chunks_ = nullptr;
+    size_t chunk_pos_ = 0;
+    size_t pos_ = 0;
 
    protected:
     IteratorBase() = default;
 
     // points iterator to message with greatest identifier which is less or equal than message_id
-    IteratorBase(const OrderedMessage *root, MessageId message_id) {
+    IteratorBase(const vector<Chunk> *chunks, MessageId message_id) {
       CHECK(!message_id.is_scheduled());
 
-      size_t last_right_pos = 0;
-      while (root != nullptr) {
-        stack_.push_back(root);
-        if (root->message_id_ <= message_id) {
-          last_right_pos = stack_.size();
-          root = root->right_.get();
-        } else {
-          root = root->left_.get();
-        }
+      if (find_message(*chunks, message_id, chunk_pos_, pos_)) {
+        chunks_ = chunks;
       }
-      stack_.resize(last_right_pos);
     }
 
     const OrderedMessage *operator*() const {
-      return stack_.empty() ? nullptr : stack_.back();
+      return chunks_ == nullptr ? nullptr : &(*chunks_)[chunk_pos_][pos_];
     }
 
     ~IteratorBase() = default;
@@ -76,69 +69,27 @@ class OrderedMessages {
     IteratorBase &operator=(IteratorBase &&) = default;
 
     void operator++() {
-      if (stack_.empty()) {
+      if (chunks_ == nullptr) {
         return;
       }
 
-      const OrderedMessage *cur = stack_.back();
-      if (!cur->have_next_) {
-        stack_.clear();
-        return;
-      }
-      if (cur->right_ == nullptr) {
-        while (true) {
-          stack_.pop_back();
-          if (stack_.empty()) {
-            return;
-          }
-          const OrderedMessage *new_cur = stack_.back();
-          if (new_cur->left_.get() == cur) {
-            return;
-          }
-          cur = new_cur;
-        }
-      }
-
-      cur = cur->right_.get();
-      while (cur != nullptr) {
-        stack_.push_back(cur);
-        cur = cur->left_.get();
+      if (!(*chunks_)[chunk_pos_][pos_].have_next_ || !get_next_position(*chunks_, chunk_pos_, pos_)) {
+        clear();
       }
     }
 
     void operator--() {
-      if (stack_.empty()) {
-        return;
-      }
-
-      const OrderedMessage *cur = stack_.back();
-      if (!cur->have_previous_) {
-        stack_.clear();
+      if (chunks_ == nullptr) {
         return;
       }
-      if (cur->left_ == nullptr) {
-        while (true) {
-          stack_.pop_back();
-          if (stack_.empty()) {
-            return;
-          }
-          const OrderedMessage *new_cur = stack_.back();
-          if (new_cur->right_.get() == cur) {
-            return;
-          }
-          cur = new_cur;
-        }
-      }
 
-      cur = cur->left_.get();
-      while (cur != nullptr) {
-        stack_.push_back(cur);
-        cur = cur->right_.get();
+      if (!(*chunks_)[chunk_pos_][pos_].have_previous_ || !get_previous_position(*chunks_, chunk_pos_, pos_)) {
+        clear();
       }
     }
 
     void clear() {
-      stack_.clear();
+      chunks_ = nullptr;
     }
   };
 
@@ -146,7 +97,7 @@ class OrderedMessages {
    public:
     ConstIterator() = default;
 
-    ConstIterator(const OrderedMessage *root, MessageId message_id) : IteratorBase(root, message_id) {
+    ConstIterator(const vector<Chunk> *chunks, MessageId message_id) : IteratorBase(chunks, message_id) {
     }
 
     const OrderedMessage *operator*() const {
@@ -155,7 +106,7 @@ class OrderedMessages {
   };
 
   ConstIterator get_const_iterator(MessageId message_id) const {
-    return ConstIterator(messages_.get(), message_id);
+    return ConstIterator(&chunks_, message_id);
   }
 
   void insert(MessageId message_id, bool auto_attach, MessageId old_last_message_id, const char *source);
@@ -175,23 +126,22 @@ class OrderedMessages {
   vector<MessageId> find_messages_by_date(int32 min_date, int32 max_date,
                                           const std::function<int32(MessageId)> &get_message_date) const;
 
-  void traverse_messages(const std::function<bool(MessageId)> &need_scan_older,
-                         const std::function<bool(MessageId)> &need_scan_newer) const;
-
   // returns identifiers of the requested messages; adjust from_message_id, offset and limit accordingly
   vector<MessageId> get_history(MessageId last_message_id, MessageId &from_message_id, int32 &offset, int32 &limit,
                                 bool force) const;
 
   bool empty() const {
-    return messages_ == nullptr;
+    return chunks_.empty();
   }
 
  private:
+  static constexpr size_t MAX_CHUNK_SIZE = 256;
+
   class Iterator final : public IteratorBase {
    public:
     Iterator() = default;
 
-    Iterator(OrderedMessage *root, MessageId message_id) : IteratorBase(root, message_id) {
+    Iterator(const vector<Chunk> *chunks, MessageId message_id) : IteratorBase(chunks, message_id) {
     }
 
     OrderedMessage *operator*() const {
@@ -199,30 +149,22 @@ class OrderedMessages {
     }
   };
 
-  void auto_attach_message(OrderedMessage *message, MessageId last_message_id, const char *source);
+  // finds position of message with greatest identifier which is less or equal than message_id
+  static bool find_message(const vector<Chunk> &chunks, MessageId message_id, size_t &chunk_pos, size_t &pos);
 
-  Iterator get_iterator(MessageId message_id) {
-    return Iterator(messages_.get(), message_id);
-  }
-
-  static void do_find_older_messages(const OrderedMessage *ordered_message, MessageId max_message_id,
-                                     vector<MessageId> &message_ids);
+  static bool get_next_position(const vector<Chunk> &chunks, size_t &chunk_pos, size_t &pos);
 
-  static void do_find_newer_messages(const OrderedMessage *ordered_message, MessageId min_message_id,
-                                     vector<MessageId> &message_ids);
+  static bool get_previous_position(const vector<Chunk> &chunks, size_t &chunk_pos, size_t &pos);
 
-  static MessageId do_find_message_by_date(const OrderedMessage *ordered_message, int32 date,
-                                           const std::function<int32(MessageId)> &get_message_date);
+  void auto_attach_message(OrderedMessage *message, MessageId last_message_id, const char *source);
 
-  static void do_find_messages_by_date(const OrderedMessage *ordered_message, int32 min_date, int32 max_date,
-                                       const std::function<int32(MessageId)> &get_message_date,
-                                       vector<MessageId> &message_ids);
+  Iterator get_iterator(MessageId message_id) {
+    return Iterator(&chunks_, message_id);
+  }
 
-  static void do_traverse_messages(const OrderedMessage *ordered_message,
-                                   const std::function<bool(MessageId)> &need_scan_older,
-                                   const std::function<bool(MessageId)> &need_scan_newer);
+  void do_insert(OrderedMessage &&message);
 
-  unique_ptr<OrderedMessage> messages_;
+  vector<Chunk> chunks_;  // all chunks are non-empty
 };
 
 }  // namespace td
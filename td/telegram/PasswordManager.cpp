@@ -152,15 +152,47 @@ tl_object_ptr<telegram_api::InputCheckPasswordSRP> PasswordManager::get_input_ch
                                   state.current_srp_p, state.current_srp_B, state.current_srp_id);
 }
 
+void PasswordManager::get_input_check_password_async(
+    ActorRef owner, string password, string client_salt, string server_salt, int32 g, string p, string B, int64 id,
+    Promise<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> &&promise) {
+  if (password.empty()) {
+    return promise.set_value(make_tl_object<telegram_api::inputCheckPasswordEmpty>());
+  }
+
+  // PBKDF2 with 100000 iterations and 2048-bit modular exponentiations take tens of milliseconds
+  Scheduler::instance()->run_on_scheduler(
+      G()->get_gc_scheduler_id(),
+      PromiseCreator::lambda([actor_id = owner.get(), password = std::move(password),
+                              client_salt = std::move(client_salt), server_salt = std::move(server_salt), g,
+                              p = std::move(p), B = std::move(B), id, promise = std::move(promise)](Unit) mutable {
+        auto hash = get_input_check_password(password, client_salt, server_salt, g, p, B, id);
+        send_lambda(actor_id, [hash = std::move(hash), promise = std::move(promise)]() mutable {
+          promise.set_value(std::move(hash));
+        });
+      }));
+}
+
+void PasswordManager::get_input_check_password_async(
+    string password, const PasswordState &state,
+    Promise<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> &&promise) {
+  get_input_check_password_async(actor_id(this), std::move(password), state.current_client_salt,
+                                 state.current_server_salt, state.current_srp_g, state.current_srp_p,
+                                 state.current_srp_B, state.current_srp_id, std::move(promise));
+}
+
 void PasswordManager::get_input_check_password_srp(
     string password, Promise<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> &&promise) {
-  do_get_state(PromiseCreator::lambda(
-      [promise = std::move(promise), password = std::move(password)](Result<PasswordState> r_state) mutable {
-        if (r_state.is_error()) {
-          return promise.set_error(r_state.move_as_error());
-        }
-        promise.set_value(PasswordManager::get_input_check_password(password, r_state.move_as_ok()));
-      }));
+  do_get_state(PromiseCreator::lambda([actor_id = actor_id(this), promise = std::move(promise),
+                                       password = std::move(password)](Result<PasswordState> r_state) mutable {
+    if (r_state.is_error()) {
+      return promise.set_error(r_state.move_as_error());
+    }
+    auto state = r_state.move_as_ok();
+    get_input_check_password_async(actor_id, std::move(password), std::move(state.current_client_salt),
+                                   std::move(state.current_server_salt), state.current_srp_g,
+                                   std::move(state.current_srp_p), std::move(state.current_srp_B),
+                                   state.current_srp_id, std::move(promise));
+  }));
 }
 
 void PasswordManager::set_password(string current_password, string new_password, string new_hint,
@@ -320,7 +352,20 @@ void PasswordManager::drop_temp_password() {
 
 void PasswordManager::do_create_temp_password(string password, int32 timeout, PasswordState &&password_state,
                                               Promise<TempPasswordState> promise) {
-  auto hash = get_input_check_password(password, password_state);
+  get_input_check_password_async(
+      std::move(password), password_state,
+      PromiseCreator::lambda([actor_id = actor_id(this), timeout, promise = std::move(promise)](
+                                 Result<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> r_hash) mutable {
+        if (r_hash.is_error()) {
+          return promise.set_error(r_hash.move_as_error());
+        }
+        send_closure(actor_id, &PasswordManager::do_get_temp_password, r_hash.move_as_ok(), timeout,
+                     std::move(promise));
+      }));
+}
+
+void PasswordManager::do_get_temp_password(tl_object_ptr<telegram_api::InputCheckPasswordSRP> hash, int32 timeout,
+                                           Promise<TempPasswordState> promise) {
   send_with_promise(G()->net_query_creator().create(telegram_api::account_getTmpPassword(std::move(hash), timeout)),
                     PromiseCreator::lambda([promise = std::move(promise)](Result<NetQueryPtr> r_query) mutable {
                       auto r_result = fetch_result<telegram_api::account_getTmpPassword>(std::move(r_query));
@@ -399,7 +444,21 @@ void PasswordManager::do_get_full_state(string password, PasswordState state, Pr
     return promise.set_value(std::move(result));
   }
 
-  auto hash = get_input_check_password(password, state);
+  get_input_check_password_async(
+      password, state,
+      PromiseCreator::lambda([actor_id = actor_id(this), password, state, promise = std::move(promise)](
+                                 Result<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> r_hash) mutable {
+        if (r_hash.is_error()) {
+          return promise.set_error(r_hash.move_as_error());
+        }
+        send_closure(actor_id, &PasswordManager::do_get_password_settings, std::move(password), std::move(state),
+                     r_hash.move_as_ok(), std::move(promise));
+      }));
+}
+
+void PasswordManager::do_get_password_settings(string password, PasswordState state,
+                                               tl_object_ptr<telegram_api::InputCheckPasswordSRP> hash,
+                                               Promise<PasswordFullState> promise) {
   send_with_promise(G()->net_query_creator().create(telegram_api::account_getPasswordSettings(std::move(hash))),
                     PromiseCreator::lambda([promise = std::move(promise), state = std::move(state),
                                             password](Result<NetQueryPtr> r_query) mutable {
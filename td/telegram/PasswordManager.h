@@ -65,6 +65,11 @@ class PasswordManager final : public NetQueryCallback {
                                                                                      Slice server_salt, int32 g,
                                                                                      Slice p, Slice B, int64 id);
 
+  // calculates the hash on another scheduler to not block the caller; the promise is set on the actor owner
+  static void get_input_check_password_async(ActorRef owner, string password, string client_salt,
+                                             string server_salt, int32 g, string p, string B, int64 id,
+                                             Promise<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> &&promise);
+
   static Result<PasswordInputSettings> get_password_input_settings(string new_password, string new_hint,
                                                                    const NewPasswordState &state);
 
@@ -178,6 +183,9 @@ class PasswordManager final : public NetQueryCallback {
   static tl_object_ptr<telegram_api::InputCheckPasswordSRP> get_input_check_password(Slice password,
                                                                                      const PasswordState &state);
 
+  void get_input_check_password_async(string password, const PasswordState &state,
+                                      Promise<tl_object_ptr<telegram_api::InputCheckPasswordSRP>> &&promise);
+
   static Result<PasswordInputSettings> get_password_input_settings(const UpdateSettings &update_settings,
                                                                    bool has_password, const NewPasswordState &state,
                                                                    const PasswordPrivateState *private_state);
@@ -193,10 +201,15 @@ class PasswordManager final : public NetQueryCallback {
   void get_full_state(string password, Promise<PasswordFullState> promise);
   void do_get_secure_secret(bool allow_recursive, string password, Promise<secure_storage::Secret> promise);
   void do_get_full_state(string password, PasswordState state, Promise<PasswordFullState> promise);
+  void do_get_password_settings(string password, PasswordState state,
+                                tl_object_ptr<telegram_api::InputCheckPasswordSRP> hash,
+                                Promise<PasswordFullState> promise);
   void cache_secret(secure_storage::Secret secret);
 
   void do_create_temp_password(string password, int32 timeout, PasswordState &&password_state,
                                Promise<TempPasswordState> promise);
+  void do_get_temp_password(tl_object_ptr<telegram_api::InputCheckPasswordSRP> hash, int32 timeout,
+                            Promise<TempPasswordState> promise);
   void on_finish_create_temp_password(Result<TempPasswordState> result, bool dummy);
 
   void on_result(NetQueryPtr query) final;
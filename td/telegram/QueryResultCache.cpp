@@ -0,0 +1,91 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/QueryResultCache.h"
+
+#include "td/telegram/Global.h"
+#include "td/telegram/TdDb.h"
+
+#include "td/db/KeyValueSyncInterface.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/tl_helpers.h"
+
+namespace td {
+
+namespace {
+
+struct CachedQueryResult {
+  int64 hash_ = 0;
+  string packet_;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(hash_, storer);
+    td::store(packet_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(hash_, parser);
+    td::parse(packet_, parser);
+  }
+};
+
+Result<CachedQueryResult> load_cached_query_result(const string &key) {
+  auto value = G()->td_db()->get_binlog_pmc()->get(key);
+  if (value.empty()) {
+    return Status::Error("Result isn't cached");
+  }
+  CachedQueryResult result;
+  auto status = unserialize(result, value);
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to parse cached result for " << key << ": " << status;
+    QueryResultCache::drop_result(key);
+    return std::move(status);
+  }
+  return std::move(result);
+}
+
+}  // namespace
+
+string QueryResultCache::get_key(int32 function_id, Slice parameters) {
+  return PSTRING() << "query_result" << static_cast<uint32>(function_id) << '#' << parameters;
+}
+
+int64 QueryResultCache::get_hash(const string &key) {
+  auto r_result = load_cached_query_result(key);
+  if (r_result.is_error()) {
+    return 0;
+  }
+  return r_result.ok().hash_;
+}
+
+void QueryResultCache::save_result(const string &key, int64 hash, const BufferSlice &packet) {
+  if (hash == 0) {
+    return drop_result(key);
+  }
+  CachedQueryResult result;
+  result.hash_ = hash;
+  result.packet_ = packet.as_slice().str();
+  LOG(INFO) << "Save result of size " << result.packet_.size() << " with hash " << hash << " for " << key;
+  G()->td_db()->get_binlog_pmc()->set(key, serialize(result));
+}
+
+void QueryResultCache::drop_result(const string &key) {
+  G()->td_db()->get_binlog_pmc()->erase(key);
+}
+
+Result<BufferSlice> QueryResultCache::load_packet(const string &key, int64 hash) {
+  TRY_RESULT(result, load_cached_query_result(key));
+  if (result.hash_ != hash) {
+    return Status::Error(PSLICE() << "Cached result has hash " << result.hash_ << " instead of " << hash);
+  }
+  return BufferSlice(result.packet_);
+}
+
+}  // namespace td
@@ -0,0 +1,49 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/net/NetQuery.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// persistent cache of results of server queries, which can be revalidated by a hash
+// results are stored in the binlog key-value storage exactly as they were received from the server and are parsed
+// again if the server responds that the result hasn't changed, so the cache survives restarts of the client
+class QueryResultCache {
+ public:
+  // the key identifies the method and its parameters other than the hash
+  template <class FunctionT>
+  static string get_key(Slice parameters = Slice()) {
+    return get_key(FunctionT::ID, parameters);
+  }
+
+  static string get_key(int32 function_id, Slice parameters);
+
+  // returns the hash of the cached result or 0 if there is no cached result
+  static int64 get_hash(const string &key);
+
+  static void save_result(const string &key, int64 hash, const BufferSlice &packet);
+
+  static void drop_result(const string &key);
+
+  // returns the cached result with the given hash
+  template <class FunctionT>
+  static Result<typename FunctionT::ReturnType> load_result(const string &key, int64 hash) {
+    TRY_RESULT(packet, load_packet(key, hash));
+    return fetch_result<FunctionT>(packet);
+  }
+
+ private:
+  static Result<BufferSlice> load_packet(const string &key, int64 hash);
+};
+
+}  // namespace td
@@ -1068,7 +1068,7 @@ unique_ptr<QuickReplyManager::QuickReplyMessage> QuickReplyManager::create_messa
       bool disable_web_page_preview = false;
       auto content = get_message_content(
           td_,
-          get_message_text(td_->user_manager_.get(), std::move(message->message_), std::move(message->entities_), true,
+          get_message_text(td_->user_manager_.get(), message->message_.as_slice().str(), std::move(message->entities_), true,
                            td_->auth_manager_->is_bot(), 0, media_album_id != 0, source),
           std::move(message->media_), my_dialog_id, message->date_, true, via_bot_user_id, &ttl,
           &disable_web_page_preview, source);
@@ -0,0 +1,47 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/ReadOnlyRequestExecutor.h"
+
+#include "td/telegram/OptionManager.h"
+
+#include "td/db/TsSeqKeyValue.h"
+
+#include "td/utils/misc.h"
+
+#include <utility>
+
+namespace td {
+
+ReadOnlyRequestExecutor::ReadOnlyRequestExecutor(std::shared_ptr<const TsSeqKeyValue> option_storage)
+    : option_storage_(std::move(option_storage)) {
+}
+
+td_api::object_ptr<td_api::Object> ReadOnlyRequestExecutor::execute(const td_api::Function &function) const {
+  if (is_closed_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  switch (function.get_id()) {
+    case td_api::getOption::ID: {
+      const auto &name = static_cast<const td_api::getOption &>(function).name_;
+      for (auto c : name) {
+        // names needing cleaning must be processed by the Td instance
+        if (!is_alnum(c) && c != '_') {
+          return nullptr;
+        }
+      }
+      return OptionManager::get_stored_option_value_object(*option_storage_, name);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+void ReadOnlyRequestExecutor::close() {
+  is_closed_.store(true, std::memory_order_release);
+}
+
+}  // namespace td
@@ -0,0 +1,36 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+
+#include <atomic>
+#include <memory>
+
+namespace td {
+
+class TsSeqKeyValue;
+
+// executes requests, which only read thread-safe state of a Td instance, from any thread
+class ReadOnlyRequestExecutor {
+ public:
+  explicit ReadOnlyRequestExecutor(std::shared_ptr<const TsSeqKeyValue> option_storage);
+
+  // returns nullptr if the request can't be executed and must be sent to the Td instance
+  td_api::object_ptr<td_api::Object> execute(const td_api::Function &function) const;
+
+  // must be called when the Td instance starts closing
+  void close();
+
+ private:
+  std::shared_ptr<const TsSeqKeyValue> option_storage_;
+  std::atomic<bool> is_closed_{false};
+};
+
+}  // namespace td
@@ -43,9 +43,9 @@ string get_restriction_reason_description(const vector<RestrictionReason> &restr
   if (!platform.empty()) {
     // first find restriction for the current platform
     for (auto &restriction_reason : restriction_reasons) {
-      if (restriction_reason.platform_ == platform &&
-          !td::contains(ignored_restriction_reasons, restriction_reason.reason_)) {
-        return restriction_reason.description_;
+      if (restriction_reason.platform_.as_slice() == platform &&
+          !td::contains(ignored_restriction_reasons, restriction_reason.reason_.as_slice())) {
+        return restriction_reason.description_.as_slice().str();
       }
     }
   }
@@ -53,18 +53,18 @@ string get_restriction_reason_description(const vector<RestrictionReason> &restr
   if (!restriction_add_platforms.empty()) {
     // then find restriction for added platforms
     for (auto &restriction_reason : restriction_reasons) {
-      if (td::contains(restriction_add_platforms, restriction_reason.platform_) &&
-          !td::contains(ignored_restriction_reasons, restriction_reason.reason_)) {
-        return restriction_reason.description_;
+      if (td::contains(restriction_add_platforms, restriction_reason.platform_.as_slice()) &&
+          !td::contains(ignored_restriction_reasons, restriction_reason.reason_.as_slice())) {
+        return restriction_reason.description_.as_slice().str();
       }
     }
   }
 
   // then find restriction for all platforms
   for (auto &restriction_reason : restriction_reasons) {
-    if (restriction_reason.platform_ == "all" &&
-        !td::contains(ignored_restriction_reasons, restriction_reason.reason_)) {
-      return restriction_reason.description_;
+    if (restriction_reason.platform_.as_slice() == "all" &&
+        !td::contains(ignored_restriction_reasons, restriction_reason.reason_.as_slice())) {
+      return restriction_reason.description_.as_slice().str();
     }
   }
 
@@ -83,7 +83,7 @@ vector<RestrictionReason> get_restriction_reasons(Slice legacy_restriction_reaso
     return result;
   }
   for (size_t i = 1; i < parts.size(); i++) {
-    result.emplace_back(parts[i].str(), parts[0].str(), description.str());
+    result.emplace_back(parts[i], parts[0], description);
   }
   return result;
 }
@@ -92,9 +92,8 @@ vector<RestrictionReason> get_restriction_reasons(
     vector<telegram_api::object_ptr<telegram_api::restrictionReason>> &&restriction_reasons) {
   return transform(std::move(restriction_reasons),
                    [](telegram_api::object_ptr<telegram_api::restrictionReason> &&restriction_reason) {
-                     return RestrictionReason(std::move(restriction_reason->platform_),
-                                              std::move(restriction_reason->reason_),
-                                              std::move(restriction_reason->text_));
+                     return RestrictionReason(restriction_reason->platform_, restriction_reason->reason_,
+                                              restriction_reason->text_);
                    });
 }
 
@@ -6,9 +6,11 @@
 //
 #pragma once
 
+#include "td/telegram/misc.h"
 #include "td/telegram/telegram_api.h"
 
 #include "td/utils/common.h"
+#include "td/utils/SharedSlice.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tl_helpers.h"
@@ -16,17 +18,19 @@
 namespace td {
 
 class RestrictionReason {
-  string platform_;
-  string reason_;
-  string description_;
+  // the same restriction reasons are shared by many users and chats, so the strings are interned
+  SharedSlice platform_;
+  SharedSlice reason_;
+  SharedSlice description_;
 
   friend StringBuilder &operator<<(StringBuilder &string_builder, const RestrictionReason &reason) {
-    return string_builder << "RestrictionReason[" << reason.platform_ << ", " << reason.reason_ << ", "
-                          << reason.description_ << "]";
+    return string_builder << "RestrictionReason[" << reason.platform_.as_slice() << ", " << reason.reason_.as_slice()
+                          << ", " << reason.description_.as_slice() << "]";
   }
 
   friend bool operator==(const RestrictionReason &lhs, const RestrictionReason &rhs) {
-    return lhs.platform_ == rhs.platform_ && lhs.reason_ == rhs.reason_ && lhs.description_ == rhs.description_;
+    return lhs.platform_.as_slice() == rhs.platform_.as_slice() && lhs.reason_.as_slice() == rhs.reason_.as_slice() &&
+           lhs.description_.as_slice() == rhs.description_.as_slice();
   }
 
   friend string get_restriction_reason_description(const vector<RestrictionReason> &restriction_reasons);
@@ -34,25 +38,30 @@ class RestrictionReason {
  public:
   RestrictionReason() = default;
 
-  RestrictionReason(string &&platform, string &&reason, string &&description)
-      : platform_(std::move(platform)), reason_(std::move(reason)), description_(std::move(description)) {
-    if (description_.empty()) {
-      description_ = reason_;
-    }
+  RestrictionReason(Slice platform, Slice reason, Slice description)
+      : platform_(intern_string(platform))
+      , reason_(intern_string(reason))
+      , description_(intern_string(description.empty() ? reason : description)) {
   }
 
   template <class StorerT>
   void store(StorerT &storer) const {
-    td::store(platform_, storer);
-    td::store(reason_, storer);
-    td::store(description_, storer);
+    td::store(platform_.as_slice(), storer);
+    td::store(reason_.as_slice(), storer);
+    td::store(description_.as_slice(), storer);
   }
 
   template <class ParserT>
   void parse(ParserT &parser) {
-    td::parse(platform_, parser);
-    td::parse(reason_, parser);
-    td::parse(description_, parser);
+    string platform;
+    string reason;
+    string description;
+    td::parse(platform, parser);
+    td::parse(reason, parser);
+    td::parse(description, parser);
+    platform_ = intern_string(platform);
+    reason_ = intern_string(reason);
+    description_ = intern_string(description);
   }
 };
 
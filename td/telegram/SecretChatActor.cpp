@@ -37,7 +37,6 @@
 #include "td/utils/tl_parsers.h"
 
 #include <array>
-#include <tuple>
 #include <type_traits>
 
 //#define G GLOBAL_SHOULD_NOT_BE_USED_HERE
@@ -96,7 +95,7 @@ void SecretChatActor::create_chat(UserId user_id, int64 user_access_hash, int32
   event->user_id = user_id;
   event->user_access_hash = user_access_hash;
   event->random_id = random_id;
-  event->set_log_event_id(binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats, create_storer(*event)));
+  event->set_log_event_id(add_log_event(create_storer(*event)));
   do_create_chat_impl(std::move(event));
   promise.set_value(SecretChatId(random_id));
   loop();
@@ -165,6 +164,20 @@ void SecretChatActor::add_inbound_message(unique_ptr<log_event::InboundSecretMes
   loop();
 }
 
+void SecretChatActor::add_decrypted_inbound_message(unique_ptr<log_event::InboundSecretMessage> message,
+                                                    DecryptedInboundMessage decrypted_message) {
+  if (close_flag_ || auth_state_.state != State::Ready) {
+    return add_inbound_message(std::move(message));
+  }
+  auto auth_key_id = decrypted_message.auth_key_id;
+  if (auth_key_id != pfs_state_.auth_key.id() && auth_key_id != pfs_state_.other_auth_key.id()) {
+    // the keys were changed after the message was decrypted
+    return add_inbound_message(std::move(message));
+  }
+  check_status(do_inbound_message_encrypted_decrypted(std::move(message), std::move(decrypted_message)));
+  loop();
+}
+
 void SecretChatActor::replay_inbound_message(unique_ptr<log_event::InboundSecretMessage> message) {
   if (close_flag_) {
     return;
@@ -446,9 +459,11 @@ void SecretChatActor::binlog_replay_finish() {
 }
 
 void SecretChatActor::loop() {
+  flush_log_event_syncs();
   if (close_flag_) {
     return;
   }
+  update_inbound_decryption_keys();
   if (!binlog_replay_finish_flag_) {
     return;
   }
@@ -463,6 +478,54 @@ Status SecretChatActor::do_loop() {
   return Status::OK();
 }
 
+StringBuilder &operator<<(StringBuilder &string_builder, const SecretChatActor::LogEventStatistics &statistics) {
+  return string_builder << "log events: " << statistics.add_count << " added, " << statistics.rewrite_count
+                        << " rewritten, " << statistics.erase_count << " erased, " << statistics.requested_sync_count
+                        << " syncs requested, " << statistics.sync_count << " syncs done";
+}
+
+uint64 SecretChatActor::add_log_event(const Storer &storer, Promise<> promise) {
+  log_event_statistics_.add_count++;
+  return binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats, storer, std::move(promise));
+}
+
+void SecretChatActor::rewrite_log_event(uint64 log_event_id, const Storer &storer) {
+  log_event_statistics_.rewrite_count++;
+  binlog_rewrite(context_->binlog(), log_event_id, LogEvent::HandlerType::SecretChats, storer);
+}
+
+void SecretChatActor::erase_log_event(uint64 log_event_id) {
+  log_event_statistics_.erase_count++;
+  binlog_erase(context_->binlog(), log_event_id);
+}
+
+void SecretChatActor::sync_log_events(Promise<Unit> promise) {
+  log_event_statistics_.requested_sync_count++;
+  pending_sync_promises_.push_back(std::move(promise));
+  if (pending_sync_promises_.size() == 1) {
+    // all log events added while handling already received events are synced at once
+    yield();
+  }
+}
+
+void SecretChatActor::flush_log_event_syncs() {
+  if (pending_sync_promises_.empty()) {
+    return;
+  }
+  log_event_statistics_.sync_count++;
+  LOG(INFO) << "Sync log events for " << pending_sync_promises_.size() << " requests with " << log_event_statistics_;
+  context_->binlog()->force_sync(
+      PromiseCreator::lambda([promises = std::move(pending_sync_promises_)](Result<Unit> result) mutable {
+        if (result.is_error()) {
+          fail_promises(promises, result.move_as_error());
+        } else {
+          set_promises(promises);
+        }
+      }),
+      "flush_log_event_syncs");
+  pending_sync_promises_.clear();
+}
+
 void SecretChatActor::on_send_message_ack(int64 random_id) {
   context_->on_send_message_ack(random_id);
 }
@@ -655,16 +718,16 @@ void SecretChatActor::cancel_chat(bool delete_history, bool is_already_discarded
 
   // TODO: It must be a transaction
   for (auto id : to_delete) {
-    binlog_erase(context_->binlog(), id);
+    erase_log_event(id);
   }
   if (create_log_event_id_ != 0) {
-    binlog_erase(context_->binlog(), create_log_event_id_);
+    erase_log_event(create_log_event_id_);
     create_log_event_id_ = 0;
   }
 
   auto event = make_unique<log_event::CloseSecretChat>();
   event->chat_id = auth_state_.id;
-  auto log_event_id = binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats, create_storer(*event));
+  auto log_event_id = add_log_event(create_storer(*event));
 
   auto on_sync = PromiseCreator::lambda([actor_id = actor_id(this), delete_history, is_already_discarded, log_event_id,
                                          promise = std::move(promise)](Result<Unit> result) mutable {
@@ -727,7 +790,7 @@ void SecretChatActor::on_closed(uint64 log_event_id, Promise<Unit> &&promise) {
 
   LOG(INFO) << "Finish closing";
   context_->secret_chat_db()->erase_value(auth_state_);
-  binlog_erase(context_->binlog(), log_event_id);
+  erase_log_event(log_event_id);
   promise.set_value(Unit());
   // skip flush
   stop();
@@ -749,7 +812,7 @@ void SecretChatActor::do_create_chat_impl(unique_ptr<log_event::CreateSecretChat
   } else if (auth_state_.state == State::SendRequest) {
   } else if (auth_state_.state == State::WaitRequestResponse) {
   } else {
-    binlog_erase(context_->binlog(), create_log_event_id_);
+    erase_log_event(create_log_event_id_);
     create_log_event_id_ = 0;
   }
 }
@@ -761,19 +824,21 @@ telegram_api::object_ptr<telegram_api::inputEncryptedChat> SecretChatActor::get_
   return telegram_api::make_object<telegram_api::inputEncryptedChat>(auth_state_.id, auth_state_.access_hash);
 }
 void SecretChatActor::tear_down() {
-  LOG(INFO) << "SecretChatActor: tear_down";
+  LOG(INFO) << "SecretChatActor: tear_down with " << log_event_statistics_;
+  flush_log_event_syncs();
   // TODO notify send update that we are dead
 }
 
-Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSlice &encrypted_message) {
-  MutableSlice data = encrypted_message.as_mutable_slice();
+Result<SecretChatActor::DecryptedInboundMessage> SecretChatActor::decrypt_inbound_message(
+    const InboundDecryptionKeys &keys, const BufferSlice &encrypted_message) {
+  Slice data = encrypted_message.as_slice();
   CHECK(is_aligned_pointer<4>(data.data()));
   TRY_RESULT(auth_key_id, mtproto::Transport::read_auth_key_id(data));
-  mtproto::AuthKey *auth_key = nullptr;
-  if (auth_key_id == pfs_state_.auth_key.id()) {
-    auth_key = &pfs_state_.auth_key;
-  } else if (auth_key_id == pfs_state_.other_auth_key.id()) {
-    auth_key = &pfs_state_.other_auth_key;
+  const mtproto::AuthKey *auth_key = nullptr;
+  if (auth_key_id == keys.auth_key.id()) {
+    auth_key = &keys.auth_key;
+  } else if (auth_key_id == keys.other_auth_key.id()) {
+    auth_key = &keys.other_auth_key;
   } else {
     return Status::Error(1, PSLICE() << "Unknown " << tag("auth_key_id", format::as_hex(auth_key_id))
                                      << tag("crc", crc64(encrypted_message.as_slice())));
@@ -783,19 +848,20 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
   BufferSlice encrypted_message_copy;
   int32 mtproto_version = -1;
   Result<mtproto::Transport::ReadResult> r_read_result;
+  MutableSlice mutable_data;
   for (size_t i = 0; i < versions.size(); i++) {
     encrypted_message_copy = encrypted_message.copy();
-    data = encrypted_message_copy.as_mutable_slice();
-    CHECK(is_aligned_pointer<4>(data.data()));
+    mutable_data = encrypted_message_copy.as_mutable_slice();
+    CHECK(is_aligned_pointer<4>(mutable_data.data()));
 
     mtproto::PacketInfo packet_info;
     packet_info.type = mtproto::PacketInfo::EndToEnd;
     mtproto_version = versions[i];
     packet_info.version = mtproto_version;
-    packet_info.is_creator = auth_state_.x == 0;
-    r_read_result = mtproto::Transport::read(data, *auth_key, &packet_info);
+    packet_info.is_creator = keys.is_creator;
+    r_read_result = mtproto::Transport::read(mutable_data, *auth_key, &packet_info);
     if (i + 1 != versions.size() && r_read_result.is_error()) {
-      if (config_state_.his_layer >= static_cast<int32>(SecretChatLayer::Mtproto2)) {
+      if (keys.his_layer >= static_cast<int32>(SecretChatLayer::Mtproto2)) {
         LOG(WARNING) << tag("mtproto", mtproto_version) << " decryption failed " << r_read_result.error();
       }
       continue;
@@ -811,19 +877,63 @@ Result<std::tuple<uint64, BufferSlice, int32>> SecretChatActor::decrypt(BufferSl
     case mtproto::Transport::ReadResult::Nop:
       return Status::Error("Receive nop instead of a message");
     case mtproto::Transport::ReadResult::Packet:
-      data = read_result.packet();
+      mutable_data = read_result.packet();
       break;
     default:
       UNREACHABLE();
   }
 
-  int32 len = as<int32>(data.begin());
-  data = data.substr(4, len);
-  if (!is_aligned_pointer<4>(data.data())) {
-    return std::make_tuple(auth_key_id, BufferSlice(data), mtproto_version);
+  DecryptedInboundMessage result;
+  result.auth_key_id = auth_key_id;
+  result.mtproto_version = mtproto_version;
+
+  int32 len = as<int32>(mutable_data.begin());
+  mutable_data = mutable_data.substr(4, len);
+  if (!is_aligned_pointer<4>(mutable_data.data())) {
+    result.data = BufferSlice(mutable_data);
+  } else {
+    result.data = encrypted_message_copy.from_slice(mutable_data);
+  }
+
+  TlBufferParser parser(&result.data);
+  auto id = parser.fetch_int();
+  if (id == secret_api::decryptedMessageLayer::ID) {
+    auto message_with_layer = secret_api::decryptedMessageLayer::fetch(parser);
+    parser.fetch_end();
+    if (!parser.get_error()) {
+      result.message_with_layer = std::move(message_with_layer);
+    } else {
+      result.parse_error =
+          Status::Error(PSLICE() << parser.get_error() << format::as_hex_dump<4>(result.data.as_slice()));
+    }
   } else {
-    return std::make_tuple(auth_key_id, encrypted_message_copy.from_slice(data), mtproto_version);
+    result.parse_error = Status::Error(PSLICE() << "Unknown constructor " << format::as_hex(id));
   }
+  return std::move(result);
+}
+
+const SecretChatActor::InboundDecryptionKeys &SecretChatActor::get_inbound_decryption_keys() {
+  update_inbound_decryption_keys();
+  CHECK(inbound_decryption_keys_ != nullptr);
+  return *inbound_decryption_keys_;
+}
+
+void SecretChatActor::update_inbound_decryption_keys() {
+  bool is_creator = auth_state_.x == 0;
+  if (inbound_decryption_keys_ != nullptr && inbound_decryption_keys_->auth_key.id() == pfs_state_.auth_key.id() &&
+      inbound_decryption_keys_->other_auth_key.id() == pfs_state_.other_auth_key.id() &&
+      inbound_decryption_keys_->is_creator == is_creator &&
+      inbound_decryption_keys_->his_layer == config_state_.his_layer) {
+    return;
+  }
+
+  auto keys = std::make_shared<InboundDecryptionKeys>();
+  keys->auth_key = pfs_state_.auth_key;
+  keys->other_auth_key = pfs_state_.other_auth_key;
+  keys->is_creator = is_creator;
+  keys->his_layer = config_state_.his_layer;
+  inbound_decryption_keys_ = std::move(keys);
+  context_->on_inbound_decryption_keys_changed(inbound_decryption_keys_);
 }
 
 Status SecretChatActor::do_inbound_message_encrypted(unique_ptr<log_event::InboundSecretMessage> message) {
@@ -832,44 +942,43 @@ Status SecretChatActor::do_inbound_message_encrypted(unique_ptr<log_event::Inbou
       message->promise.set_value(Unit());
     }
   };
-  TRY_RESULT(decrypted, decrypt(message->encrypted_message));
-  auto auth_key_id = std::get<0>(decrypted);
-  auto data_buffer = std::move(std::get<1>(decrypted));
-  auto mtproto_version = std::get<2>(decrypted);
-  message->auth_key_id = auth_key_id;
+  TRY_RESULT(decrypted_message, decrypt_inbound_message(get_inbound_decryption_keys(), message->encrypted_message));
+  return do_inbound_message_encrypted_decrypted(std::move(message), std::move(decrypted_message));
+}
 
-  TlBufferParser parser(&data_buffer);
-  auto id = parser.fetch_int();
-  Status status;
-  if (id == secret_api::decryptedMessageLayer::ID) {
-    auto message_with_layer = secret_api::decryptedMessageLayer::fetch(parser);
-    parser.fetch_end();
-    if (!parser.get_error()) {
-      auto layer = message_with_layer->layer_;
-      if (layer < static_cast<int32>(SecretChatLayer::Default) &&
-          false /* old Android app could send such messages */) {
-        LOG(ERROR) << "Layer " << layer << " is not supported, drop message " << to_string(message_with_layer);
-        return Status::OK();
-      }
-      if (config_state_.his_layer < layer) {
-        config_state_.his_layer = layer;
-        context_->secret_chat_db()->set_value(config_state_);
-        send_update_secret_chat();
-      }
-      if (layer >= static_cast<int32>(SecretChatLayer::Mtproto2) && mtproto_version < 2) {
-        return Status::Error("MTProto 1.0 encryption is forbidden for this layer");
-      }
-      if (message_with_layer->in_seq_no_ < 0) {
-        return Status::Error(PSLICE() << "Invalid seq_no: " << to_string(message_with_layer));
-      }
-      message->decrypted_message_layer = std::move(message_with_layer);
-      return do_inbound_message_decrypted_unchecked(std::move(message), mtproto_version);
-    } else {
-      status = Status::Error(PSLICE() << parser.get_error() << format::as_hex_dump<4>(data_buffer.as_slice()));
+Status SecretChatActor::do_inbound_message_encrypted_decrypted(unique_ptr<log_event::InboundSecretMessage> message,
+                                                               DecryptedInboundMessage decrypted_message) {
+  SCOPE_EXIT {
+    if (message) {
+      message->promise.set_value(Unit());
     }
-  } else {
-    status = Status::Error(PSLICE() << "Unknown constructor " << format::as_hex(id));
+  };
+  auto mtproto_version = decrypted_message.mtproto_version;
+  message->auth_key_id = decrypted_message.auth_key_id;
+
+  if (decrypted_message.message_with_layer != nullptr) {
+    auto message_with_layer = std::move(decrypted_message.message_with_layer);
+    auto layer = message_with_layer->layer_;
+    if (layer < static_cast<int32>(SecretChatLayer::Default) && false /* old Android app could send such messages */) {
+      LOG(ERROR) << "Layer " << layer << " is not supported, drop message " << to_string(message_with_layer);
+      return Status::OK();
+    }
+    if (config_state_.his_layer < layer) {
+      config_state_.his_layer = layer;
+      context_->secret_chat_db()->set_value(config_state_);
+      send_update_secret_chat();
+    }
+    if (layer >= static_cast<int32>(SecretChatLayer::Mtproto2) && mtproto_version < 2) {
+      return Status::Error("MTProto 1.0 encryption is forbidden for this layer");
+    }
+    if (message_with_layer->in_seq_no_ < 0) {
+      return Status::Error(PSLICE() << "Invalid seq_no: " << to_string(message_with_layer));
+    }
+    message->decrypted_message_layer = std::move(message_with_layer);
+    return do_inbound_message_decrypted_unchecked(std::move(message), mtproto_version);
   }
+  auto status = std::move(decrypted_message.parse_error);
+  auto &data_buffer = decrypted_message.data;
 
   // support for older layer
   LOG(WARNING) << "Failed to fetch update: " << status;
@@ -880,7 +989,6 @@ Status SecretChatActor::do_inbound_message_encrypted(unique_ptr<log_event::Inbou
   if (config_state_.his_layer == 8) {
     TlBufferParser new_parser(&data_buffer);
     auto message_without_layer = secret_api::DecryptedMessage::fetch(new_parser);
-    parser.fetch_end();
     if (!new_parser.get_error()) {
       message->decrypted_message_layer = secret_api::make_object<secret_api::decryptedMessageLayer>(
           BufferSlice(), config_state_.his_layer, -1, -1, std::move(message_without_layer));
@@ -933,7 +1041,7 @@ Status SecretChatActor::do_inbound_message_decrypted_unchecked(unique_ptr<log_ev
     message->promise.set_value(Unit());
     if (message->log_event_id()) {
       LOG(INFO) << "Erase binlog event: " << tag("log_event_id", message->log_event_id());
-      binlog_erase(context_->binlog(), message->log_event_id());
+      erase_log_event(message->log_event_id());
     }
     auto warning_message = PSTRING() << status << tag("seq_no_state_.my_in_seq_no", seq_no_state_.my_in_seq_no)
                                      << tag("seq_no_state_.my_out_seq_no", seq_no_state_.my_out_seq_no)
@@ -1070,9 +1178,9 @@ void SecretChatActor::do_outbound_message_impl(unique_ptr<log_event::OutboundSec
 
   auto log_event_id = state->message->log_event_id();
   if (log_event_id == 0) {
-    log_event_id = binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats, create_storer(*state->message));
+    log_event_id = add_log_event(create_storer(*state->message));
     LOG(INFO) << "Outbound secret message [save_log_event] start " << tag("log_event_id", log_event_id);
-    context_->binlog()->force_sync(std::move(save_log_event_finish), "do_outbound_message_impl");
+    sync_log_events(std::move(save_log_event_finish));
     state->message->set_log_event_id(log_event_id);
   } else {
     LOG(INFO) << "Outbound secret message [save_log_event] skip " << tag("log_event_id", log_event_id);
@@ -1159,8 +1267,7 @@ void SecretChatActor::do_inbound_message_decrypted_pending(unique_ptr<log_event:
 
   if (log_event_id == 0) {
     message->is_pending = true;
-    message->set_log_event_id(binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats,
-                                         create_storer(*message), std::move(qts_promise)));
+    message->set_log_event_id(add_log_event(create_storer(*message), std::move(qts_promise)));
     LOG(INFO) << "Inbound PENDING secret message [save_log_event] start (do not expect finish) "
               << tag("log_event_id", message->log_event_id());
   } else {
@@ -1192,15 +1299,15 @@ Status SecretChatActor::do_inbound_message_decrypted(unique_ptr<log_event::Inbou
   auto log_event_id = message->log_event_id();
   bool need_sync = false;
   if (log_event_id == 0) {
-    log_event_id = binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats, create_storer(*message));
+    log_event_id = add_log_event(create_storer(*message));
     LOG(INFO) << "Inbound secret message [save_log_event] start " << tag("log_event_id", log_event_id);
     need_sync = true;
   } else {
     if (message->is_pending) {
       message->is_pending = false;
       auto old_log_event_id = log_event_id;
-      log_event_id = binlog_add(context_->binlog(), LogEvent::HandlerType::SecretChats, create_storer(*message));
-      binlog_erase(context_->binlog(), old_log_event_id);
+      log_event_id = add_log_event(create_storer(*message));
+      erase_log_event(old_log_event_id);
       LOG(INFO) << "Inbound secret message [save_log_event] rewrite (after pending state) "
                 << tag("log_event_id", log_event_id) << tag("old_log_event_id", old_log_event_id);
       need_sync = true;
@@ -1329,7 +1436,7 @@ Status SecretChatActor::do_inbound_message_decrypted(unique_ptr<log_event::Inbou
   auto save_log_event_finish = PromiseCreator::join(std::move(save_changes_start), std::move(qts_promise));
   if (need_sync) {
     // TODO: lazy sync is enough
-    context_->binlog()->force_sync(std::move(save_log_event_finish), "do_inbound_message_decrypted");
+    sync_log_events(std::move(save_log_event_finish));
   } else {
     save_log_event_finish.set_value(Unit());
   }
@@ -1397,7 +1504,7 @@ void SecretChatActor::inbound_loop(InboundMessageState *state, uint64 state_id)
     return;
   }
   LOG(INFO) << "Inbound message [remove_log_event] start " << tag("log_event_id", state->log_event_id);
-  binlog_erase(context_->binlog(), state->log_event_id);
+  erase_log_event(state->log_event_id);
 
   inbound_message_states_.erase(state_id);
 }
@@ -1477,8 +1584,7 @@ void SecretChatActor::outbound_resend(uint64 state_id) {
   LOG(INFO) << "Outbound message [resend] " << tag("log_event_id", state->message->log_event_id())
             << tag("state_id", state_id);
 
-  binlog_rewrite(context_->binlog(), state->message->log_event_id(), LogEvent::HandlerType::SecretChats,
-                 create_storer(*state->message));
+  rewrite_log_event(state->message->log_event_id(), create_storer(*state->message));
   auto send_message_start = PromiseCreator::lambda([actor_id = actor_id(this), state_id](Result<> result) {
     if (result.is_ok()) {
       send_closure(actor_id, &SecretChatActor::on_outbound_send_message_start, state_id);
@@ -1487,7 +1593,7 @@ void SecretChatActor::outbound_resend(uint64 state_id) {
                    "on_outbound_send_message_start");
     }
   });
-  context_->binlog()->force_sync(std::move(send_message_start), "outbound_resend");
+  sync_log_events(std::move(send_message_start));
 }
 
 Status SecretChatActor::outbound_rewrite_with_empty(uint64 state_id) {
@@ -1517,8 +1623,7 @@ Status SecretChatActor::outbound_rewrite_with_empty(uint64 state_id) {
   state->message->need_notify_user = false;
   state->message->is_silent = true;
   state->message->file = log_event::EncryptedInputFile();
-  binlog_rewrite(context_->binlog(), state->message->log_event_id(), LogEvent::HandlerType::SecretChats,
-                 create_storer(*state->message));
+  rewrite_log_event(state->message->log_event_id(), create_storer(*state->message));
   return Status::OK();
 }
 
@@ -1668,7 +1773,7 @@ void SecretChatActor::on_outbound_send_message_error(uint64 state_id, Status err
         }
       });
   if (need_sync) {
-    context_->binlog()->force_sync(std::move(send_message_start), "on_outbound_send_message_error");
+    sync_log_events(std::move(send_message_start));
   } else {
     send_message_start.set_value(Unit());
   }
@@ -1734,7 +1839,7 @@ void SecretChatActor::outbound_loop(OutboundMessageState *state, uint64 state_id
   }
   if (state->save_changes_finish_flag /*&& state->send_message_finish_flag*/ && state->ack_flag) {
     LOG(INFO) << "Outbound message [remove_log_event] start " << tag("log_event_id", state->message->log_event_id());
-    binlog_erase(context_->binlog(), state->message->log_event_id());
+    erase_log_event(state->message->log_event_id());
 
     random_id_to_outbound_message_state_token_.erase(state->message->random_id);
     LOG(INFO) << "Outbound message finish (lazy) " << tag("log_event_id", state->message->log_event_id());
@@ -1746,8 +1851,7 @@ void SecretChatActor::outbound_loop(OutboundMessageState *state, uint64 state_id
       !state->message->is_sent) {  // [rewrite_log_event]
     LOG(INFO) << "Outbound message [rewrite_log_event] start " << tag("log_event_id", state->message->log_event_id());
     state->message->is_sent = true;
-    binlog_rewrite(context_->binlog(), state->message->log_event_id(), LogEvent::HandlerType::SecretChats,
-                   create_storer(*state->message));
+    rewrite_log_event(state->message->log_event_id(), create_storer(*state->message));
   }
 }
 
@@ -1807,7 +1911,7 @@ Status SecretChatActor::on_update_chat(telegram_api::encryptedChat &update) {
   }
   auth_state_.state = State::Ready;
   if (create_log_event_id_ != 0) {
-    binlog_erase(context_->binlog(), create_log_event_id_);
+    erase_log_event(create_log_event_id_);
     create_log_event_id_ = 0;
   }
 
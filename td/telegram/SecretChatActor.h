@@ -34,6 +34,7 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/StorerBase.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
@@ -41,7 +42,6 @@
 #include <functional>
 #include <map>
 #include <memory>
-#include <tuple>
 #include <utility>
 
 namespace td {
@@ -51,6 +51,26 @@ class NetQueryCreator;
 
 class SecretChatActor final : public NetQueryCallback {
  public:
+  // immutable snapshot of the keys, which can be used to decrypt inbound messages in any thread
+  struct InboundDecryptionKeys {
+    mtproto::AuthKey auth_key;
+    mtproto::AuthKey other_auth_key;
+    bool is_creator = false;
+    int32 his_layer = 0;
+  };
+
+  struct DecryptedInboundMessage {
+    uint64 auth_key_id = 0;
+    int32 mtproto_version = -1;
+    BufferSlice data;
+    tl_object_ptr<secret_api::decryptedMessageLayer> message_with_layer;  // nullptr if parsing has failed
+    Status parse_error;
+  };
+
+  // decrypts the message and parses decryptedMessageLayer from it; doesn't access any actor state
+  static Result<DecryptedInboundMessage> decrypt_inbound_message(const InboundDecryptionKeys &keys,
+                                                                 const BufferSlice &encrypted_message);
+
   class Context {
    public:
     Context() = default;
@@ -100,6 +120,10 @@ class SecretChatActor final : public NetQueryCallback {
     virtual void on_send_message_ok(int64 random_id, MessageId message_id, int32 date, unique_ptr<EncryptedFile> file,
                                     Promise<> promise) = 0;
     virtual void on_send_message_error(int64 random_id, Status error, Promise<> promise) = 0;
+
+    // keys for decryption of inbound messages have changed
+    virtual void on_inbound_decryption_keys_changed(std::shared_ptr<const InboundDecryptionKeys> keys) {
+    }
   };
 
   SecretChatActor(int32 id, unique_ptr<Context> context, bool can_be_empty);
@@ -113,6 +137,9 @@ class SecretChatActor final : public NetQueryCallback {
   // Inbound messages
   // Logevent is created by SecretChatsManager, because it must contain QTS
   void add_inbound_message(unique_ptr<log_event::InboundSecretMessage> message);
+  // the message was already decrypted by SecretChatsManager using previously published keys
+  void add_decrypted_inbound_message(unique_ptr<log_event::InboundSecretMessage> message,
+                                     DecryptedInboundMessage decrypted_message);
 
   // Outbound messages
   // Promise will be set just after corresponding log event is SENT to binlog.
@@ -457,6 +484,25 @@ class SecretChatActor final : public NetQueryCallback {
   std::shared_ptr<SecretChatDb> db_;
   unique_ptr<Context> context_;
 
+  struct LogEventStatistics {
+    uint64 add_count = 0;
+    uint64 rewrite_count = 0;
+    uint64 erase_count = 0;
+    uint64 requested_sync_count = 0;
+    uint64 sync_count = 0;
+  };
+  friend StringBuilder &operator<<(StringBuilder &string_builder, const LogEventStatistics &statistics);
+  LogEventStatistics log_event_statistics_;
+  vector<Promise<Unit>> pending_sync_promises_;
+
+  uint64 add_log_event(const Storer &storer, Promise<> promise = Promise<>());
+  void rewrite_log_event(uint64 log_event_id, const Storer &storer);
+  void erase_log_event(uint64 log_event_id);
+
+  // syncs the binlog after all currently received events are handled
+  void sync_log_events(Promise<Unit> promise);
+  void flush_log_event_syncs();
+
   bool binlog_replay_finish_flag_ = false;
   bool close_flag_ = false;
   Promise<Unit> discard_encryption_promise_;
@@ -566,9 +612,15 @@ class SecretChatActor final : public NetQueryCallback {
 
   std::map<int32, unique_ptr<log_event::InboundSecretMessage>> pending_inbound_messages_;
 
-  Result<std::tuple<uint64, BufferSlice, int32>> decrypt(BufferSlice &encrypted_message);
+  std::shared_ptr<const InboundDecryptionKeys> inbound_decryption_keys_;
+
+  const InboundDecryptionKeys &get_inbound_decryption_keys();
+
+  void update_inbound_decryption_keys();
 
   Status do_inbound_message_encrypted(unique_ptr<log_event::InboundSecretMessage> message);
+  Status do_inbound_message_encrypted_decrypted(unique_ptr<log_event::InboundSecretMessage> message,
+                                                DecryptedInboundMessage decrypted_message);
   Status do_inbound_message_decrypted_unchecked(unique_ptr<log_event::InboundSecretMessage> message,
                                                 int32 mtproto_version);
   Status do_inbound_message_decrypted(unique_ptr<log_event::InboundSecretMessage> message);
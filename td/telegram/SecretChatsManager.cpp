@@ -21,6 +21,7 @@
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/UserManager.h"
 
+#include "td/mtproto/CryptoWorkerPool.h"
 #include "td/mtproto/DhCallback.h"
 
 #include "td/db/binlog/BinlogEvent.h"
@@ -207,6 +208,36 @@ void SecretChatsManager::on_new_message(tl_object_ptr<telegram_api::EncryptedMes
   if (!use_secret_chats_ || close_flag_) {
     return promise.set_value(Unit());
   }
+  add_inbound_message(create_inbound_message(std::move(message_ptr), std::move(promise)));
+}
+
+void SecretChatsManager::on_new_messages(vector<tl_object_ptr<telegram_api::EncryptedMessage>> &&messages) {
+  if (!use_secret_chats_ || close_flag_) {
+    return;
+  }
+
+  vector<unique_ptr<log_event::InboundSecretMessage>> events;
+  events.reserve(messages.size());
+  for (auto &message : messages) {
+    events.push_back(create_inbound_message(std::move(message), Promise<Unit>()));
+  }
+
+  auto decrypted_messages = decrypt_inbound_messages(events);
+  for (size_t i = 0; i < events.size(); i++) {
+    if (i < decrypted_messages.size() && decrypted_messages[i].is_ok()) {
+      LOG(INFO) << "Process decrypted inbound secret message in chat " << events[i]->chat_id;
+      auto actor = get_chat_actor(events[i]->chat_id);
+      send_closure(actor, &SecretChatActor::add_decrypted_inbound_message, std::move(events[i]),
+                   decrypted_messages[i].move_as_ok());
+    } else {
+      // the chat actor will decrypt the message itself and will handle the error if any
+      add_inbound_message(std::move(events[i]));
+    }
+  }
+}
+
+unique_ptr<log_event::InboundSecretMessage> SecretChatsManager::create_inbound_message(
+    tl_object_ptr<telegram_api::EncryptedMessage> &&message_ptr, Promise<Unit> &&promise) {
   CHECK(message_ptr != nullptr);
 
   auto event = make_unique<log_event::InboundSecretMessage>();
@@ -230,7 +261,35 @@ void SecretChatsManager::on_new_message(tl_object_ptr<telegram_api::EncryptedMes
     default:
       UNREACHABLE();
   }
-  add_inbound_message(std::move(event));
+  return event;
+}
+
+vector<Result<SecretChatActor::DecryptedInboundMessage>> SecretChatsManager::decrypt_inbound_messages(
+    const vector<unique_ptr<log_event::InboundSecretMessage>> &events) const {
+  // only messages from chats with known keys can be decrypted here; the chat actors check that the keys are still
+  // actual and decrypt the other messages themselves in the order of their receiving
+  vector<std::shared_ptr<const SecretChatActor::InboundDecryptionKeys>> keys(events.size());
+  size_t message_count = 0;
+  size_t total_size = 0;
+  for (size_t i = 0; i < events.size(); i++) {
+    auto it = inbound_decryption_keys_.find(events[i]->chat_id);
+    if (it != inbound_decryption_keys_.end()) {
+      keys[i] = it->second;
+      message_count++;
+      total_size += events[i]->encrypted_message.size();
+    }
+  }
+  if (!mtproto::CryptoWorkerPool::need_parallel_decryption(message_count, total_size)) {
+    return {};
+  }
+
+  vector<Result<SecretChatActor::DecryptedInboundMessage>> decrypted_messages(events.size());
+  mtproto::CryptoWorkerPool::run(events.size(), [&](size_t i) {
+    if (keys[i] != nullptr) {
+      decrypted_messages[i] = SecretChatActor::decrypt_inbound_message(*keys[i], events[i]->encrypted_message);
+    }
+  });
+  return decrypted_messages;
 }
 
 void SecretChatsManager::replay_binlog_event(BinlogEvent &&binlog_event) {
@@ -412,6 +471,11 @@ unique_ptr<SecretChatActor::Context> SecretChatsManager::make_secret_chat_contex
                          user_id, message_id, date, ttl, random_id, std::move(promise));
     }
 
+    void on_inbound_decryption_keys_changed(std::shared_ptr<const SecretChatActor::InboundDecryptionKeys> keys) final {
+      send_closure(parent_, &SecretChatsManager::on_inbound_decryption_keys_changed, secret_chat_id_.get(),
+                   std::move(keys));
+    }
+
    private:
     SecretChatId secret_chat_id_;
     ActorOwn<SequenceDispatcher> sequence_dispatcher_;
@@ -455,6 +519,7 @@ void SecretChatsManager::hangup_shared() {
   auto it = id_to_actor_.find(static_cast<int32>(token));
   CHECK(it != id_to_actor_.end());
   LOG(INFO) << "Close SecretChatActor " << tag("id", it->first);
+  inbound_decryption_keys_.erase(it->first);
   it->second.release();
   id_to_actor_.erase(it);
   if (close_flag_ && id_to_actor_.empty()) {
@@ -462,6 +527,14 @@ void SecretChatsManager::hangup_shared() {
   }
 }
 
+void SecretChatsManager::on_inbound_decryption_keys_changed(
+    int32 chat_id, std::shared_ptr<const SecretChatActor::InboundDecryptionKeys> keys) {
+  if (id_to_actor_.count(chat_id) == 0) {
+    return;
+  }
+  inbound_decryption_keys_[chat_id] = std::move(keys);
+}
+
 void SecretChatsManager::timeout_expired() {
   flush_pending_chat_updates();
 }
@@ -16,10 +16,13 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Status.h"
 #include "td/utils/Time.h"
 
 #include <map>
+#include <memory>
 
 namespace td {
 
@@ -32,6 +35,8 @@ class SecretChatsManager final : public Actor {
   // proxy query to corresponding SecretChatActor
   void on_update_chat(tl_object_ptr<telegram_api::updateEncryption> update);
   void on_new_message(tl_object_ptr<telegram_api::EncryptedMessage> &&message_ptr, Promise<Unit> &&promise);
+  // messages from getDifference; they are decrypted in parallel if possible
+  void on_new_messages(vector<tl_object_ptr<telegram_api::EncryptedMessage>> &&messages);
 
   void create_chat(UserId user_id, int64 user_access_hash, Promise<SecretChatId> promise);
   void cancel_chat(SecretChatId secret_chat_id, bool delete_history, Promise<> promise);
@@ -55,6 +60,7 @@ class SecretChatsManager final : public Actor {
   bool close_flag_ = false;
   ActorShared<> parent_;
   std::map<int32, ActorOwn<SecretChatActor>> id_to_actor_;
+  FlatHashMap<int32, std::shared_ptr<const SecretChatActor::InboundDecryptionKeys>> inbound_decryption_keys_;
 
   bool is_online_{false};
 
@@ -69,6 +75,12 @@ class SecretChatsManager final : public Actor {
 
   void replay_inbound_message(unique_ptr<log_event::InboundSecretMessage> message);
   void add_inbound_message(unique_ptr<log_event::InboundSecretMessage> message);
+  static unique_ptr<log_event::InboundSecretMessage> create_inbound_message(
+      tl_object_ptr<telegram_api::EncryptedMessage> &&message_ptr, Promise<Unit> &&promise);
+  vector<Result<SecretChatActor::DecryptedInboundMessage>> decrypt_inbound_messages(
+      const vector<unique_ptr<log_event::InboundSecretMessage>> &events) const;
+  void on_inbound_decryption_keys_changed(int32 chat_id,
+                                          std::shared_ptr<const SecretChatActor::InboundDecryptionKeys> keys);
   void replay_outbound_message(unique_ptr<log_event::OutboundSecretMessage> message);
   void replay_close_chat(unique_ptr<log_event::CloseSecretChat> message);
   void replay_create_chat(unique_ptr<log_event::CreateSecretChat> message);
@@ -20,6 +20,7 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 
 #include <limits>
 
@@ -56,7 +57,13 @@ void SequenceDispatcher::check_timeout(Data &data) {
   }
   data.query_->total_timeout_ += data.total_timeout_;
   data.total_timeout_ = 0;
-  if (data.query_->total_timeout_ > data.query_->total_timeout_limit_) {
+  if (data.query_->is_deadline_expired(Time::now())) {
+    LOG(INFO) << "Fail " << data.query_ << " to " << data.query_->source_ << " because request deadline expired";
+    G()->on_network_query_shed();
+    data.query_->set_error(Global::request_timeout_expired_error());
+    data.state_ = State::Dummy;
+    try_resend_query(data, std::move(data.query_));
+  } else if (data.query_->total_timeout_ > data.query_->total_timeout_limit_) {
     LOG(WARNING) << "Fail " << data.query_ << " to " << data.query_->source_ << " because total_timeout "
                  << data.query_->total_timeout_ << " is greater than total_timeout_limit "
                  << data.query_->total_timeout_limit_;
@@ -287,8 +294,15 @@ void MultiSequenceDispatcherOld::ready_to_close() {
   }
 }
 
+constexpr int32 MultiSequenceDispatcher::DEFAULT_MAX_ACTIVE_QUERIES;
+constexpr int32 MultiSequenceDispatcher::MAX_MAX_ACTIVE_QUERIES;
+
 class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
  public:
+  explicit MultiSequenceDispatcherImpl(int32 max_active_queries)
+      : scheduler_(static_cast<uint32>(clamp(max_active_queries, 1, MAX_MAX_ACTIVE_QUERIES))) {
+  }
+
   void send(NetQueryPtr query) final {
     auto callback = query->move_callback();
     auto chain_ids = query->get_chain_ids();
@@ -303,7 +317,17 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     loop();
   }
 
+  void set_max_active_queries(int32 max_active_queries) final {
+    max_active_queries = clamp(max_active_queries, 1, MAX_MAX_ACTIVE_QUERIES);
+    LOG(INFO) << "Set maximum number of active queries per chain to " << max_active_queries
+              << "; scheduler state: " << scheduler_.get_stats();
+    scheduler_.set_max_active_tasks(static_cast<uint32>(max_active_queries));
+    loop();
+  }
+
  private:
+  static constexpr uint64 STATS_LOG_PERIOD = 1000;  // number of sent queries between logging of scheduler stats
+
   struct Node {
     NetQueryRef net_query_ref;
     NetQueryPtr net_query;
@@ -315,6 +339,7 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     }
   };
   ChainScheduler<Node> scheduler_;
+  uint64 sent_query_count_ = 0;
 
   using TaskId = ChainScheduler<Node>::TaskId;
 
@@ -323,6 +348,12 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     if (net_query.empty() || net_query->is_ready()) {
       return false;
     }
+    if (net_query->is_deadline_expired(Time::now())) {
+      LOG(INFO) << "Fail " << net_query << " to " << net_query->source_ << " because request deadline expired";
+      G()->on_network_query_shed();
+      net_query->set_error(Global::request_timeout_expired_error());
+      return true;
+    }
     if (node.total_timeout > 0) {
       net_query->total_timeout_ += node.total_timeout;
       LOG(INFO) << "Set total_timeout to " << net_query->total_timeout_ << " for " << net_query->id();
@@ -438,6 +469,12 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
       auto task = o_task.unwrap();
       auto &node = *scheduler_.get_task_extra(task.task_id);
       CHECK(!node.net_query.empty());
+      if (check_timeout(node)) {
+        // the query has waited for its parents for too long
+        scheduler_.pause_task(task.task_id);
+        try_resend(task.task_id);
+        continue;
+      }
 
       auto query = std::move(node.net_query);
       vector<NetQueryRef> parents;
@@ -451,12 +488,16 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
       query->last_timeout_ = 0;
       query->debug("dispatch_with_callback");
       G()->net_query_dispatcher().dispatch_with_callback(std::move(query), actor_shared(this, task.task_id));
+
+      if (++sent_query_count_ % STATS_LOG_PERIOD == 0) {
+        VLOG(net_query) << "Sequence dispatcher stats: " << scheduler_.get_stats();
+      }
     }
   }
 };
 
-ActorOwn<MultiSequenceDispatcher> MultiSequenceDispatcher::create(Slice name) {
-  return ActorOwn<MultiSequenceDispatcher>(create_actor<MultiSequenceDispatcherImpl>(name));
+ActorOwn<MultiSequenceDispatcher> MultiSequenceDispatcher::create(Slice name, int32 max_active_queries) {
+  return ActorOwn<MultiSequenceDispatcher>(create_actor<MultiSequenceDispatcherImpl>(name, max_active_queries));
 }
 
 }  // namespace td
@@ -93,8 +93,15 @@ class MultiSequenceDispatcherOld final : public SequenceDispatcher::Parent {
 
 class MultiSequenceDispatcher : public NetQueryCallback {
  public:
+  static constexpr int32 DEFAULT_MAX_ACTIVE_QUERIES = 10;
+  static constexpr int32 MAX_MAX_ACTIVE_QUERIES = 1000;
+
   virtual void send(NetQueryPtr query) = 0;
-  static ActorOwn<MultiSequenceDispatcher> create(Slice name);
+
+  // sets maximum number of simultaneously sent queries in a chain
+  virtual void set_max_active_queries(int32 max_active_queries) = 0;
+
+  static ActorOwn<MultiSequenceDispatcher> create(Slice name, int32 max_active_queries = DEFAULT_MAX_ACTIVE_QUERIES);
 };
 
 }  // namespace td
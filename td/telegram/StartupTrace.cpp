@@ -0,0 +1,128 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/StartupTrace.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/format.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
+
+namespace td {
+
+int VERBOSITY_NAME(startup) = VERBOSITY_NAME(INFO);
+
+int64 StartupTrace::get_resident_memory() {
+  auto r_mem_stat = mem_stat();
+  if (r_mem_stat.is_error()) {
+    return 0;
+  }
+  return static_cast<int64>(r_mem_stat.ok().resident_size_);
+}
+
+void StartupTrace::begin_phase(Slice name) {
+  auto now = Time::now();
+  auto memory = get_resident_memory();
+  Step step;
+  step.name_ = name.str();
+  step.depth_ = open_phases_.size();
+  step.begin_time_ = now;
+  step.begin_memory_ = memory;
+  open_phases_.push_back(steps_.size());
+  steps_.push_back(std::move(step));
+  checkpoint_time_ = now;
+  checkpoint_memory_ = memory;
+}
+
+void StartupTrace::end_phase() {
+  CHECK(!open_phases_.empty());
+  auto now = Time::now();
+  auto memory = get_resident_memory();
+  auto &step = steps_[open_phases_.back()];
+  open_phases_.pop_back();
+  on_step_finished(step, now, memory);
+  checkpoint_time_ = now;
+  checkpoint_memory_ = memory;
+}
+
+void StartupTrace::add_step(Slice name) {
+  auto now = Time::now();
+  auto memory = get_resident_memory();
+  if (checkpoint_time_ == 0.0) {
+    checkpoint_time_ = now;
+    checkpoint_memory_ = memory;
+  }
+  Step step;
+  step.name_ = name.str();
+  step.depth_ = open_phases_.size();
+  step.begin_time_ = checkpoint_time_;
+  step.begin_memory_ = checkpoint_memory_;
+  on_step_finished(step, now, memory);
+  steps_.push_back(std::move(step));
+  checkpoint_time_ = now;
+  checkpoint_memory_ = memory;
+}
+
+void StartupTrace::add_note(string note) {
+  VLOG(startup) << note;
+  notes_.push_back(std::move(note));
+}
+
+void StartupTrace::append(StartupTrace &&other) {
+  CHECK(other.open_phases_.empty());
+  for (auto &step : other.steps_) {
+    step.depth_ += open_phases_.size();
+    steps_.push_back(std::move(step));
+  }
+  td::append(notes_, std::move(other.notes_));
+  checkpoint_time_ = Time::now();
+  checkpoint_memory_ = get_resident_memory();
+}
+
+void StartupTrace::finish(Slice name) {
+  while (!open_phases_.empty()) {
+    end_phase();
+  }
+  add_step(name);
+  is_finished_ = true;
+  if (!steps_.empty()) {
+    VLOG(startup) << "Finished startup in " << format::as_time(steps_.back().end_time_ - steps_[0].begin_time_);
+  }
+}
+
+void StartupTrace::on_step_finished(Step &step, double now, int64 memory) {
+  step.end_time_ = now;
+  step.memory_delta_ = memory - step.begin_memory_;
+  VLOG(startup) << "Finished " << step.name_ << " in " << format::as_time(step.end_time_ - step.begin_time_)
+                << " with resident memory change " << step.memory_delta_;
+}
+
+string StartupTrace::get_statistics() const {
+  auto sb = StringBuilder({}, true);
+  if (steps_.empty()) {
+    return string();
+  }
+  auto origin = steps_[0].begin_time_;
+  for (auto &step : steps_) {
+    sb << string(step.depth_ * 2, ' ') << step.name_ << ": started at "
+       << format::as_time(step.begin_time_ - origin);
+    if (step.end_time_ == 0.0) {
+      sb << ", in progress\n";
+      continue;
+    }
+    sb << ", took " << format::as_time(step.end_time_ - step.begin_time_) << ", resident memory "
+       << (step.memory_delta_ >= 0 ? '+' : '-')
+       << format::as_size(static_cast<uint64>(step.memory_delta_ >= 0 ? step.memory_delta_ : -step.memory_delta_))
+       << '\n';
+  }
+  for (auto &note : notes_) {
+    sb << note << '\n';
+  }
+  return sb.as_cslice().str();
+}
+
+}  // namespace td
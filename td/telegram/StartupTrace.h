@@ -0,0 +1,63 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+extern int VERBOSITY_NAME(startup);
+
+// records duration and resident memory change of initialization phases and their steps
+class StartupTrace {
+ public:
+  void begin_phase(Slice name);
+
+  void end_phase();
+
+  // adds a step of the current phase, which lasted since the end of the previous step
+  void add_step(Slice name);
+
+  // adds a textual note, for example, with sizes of loaded data
+  void add_note(string note);
+
+  // appends phases recorded by another trace as subphases of the current phase
+  void append(StartupTrace &&other);
+
+  void finish(Slice name);
+
+  bool is_finished() const {
+    return is_finished_;
+  }
+
+  string get_statistics() const;
+
+ private:
+  struct Step {
+    string name_;
+    size_t depth_ = 0;
+    double begin_time_ = 0.0;
+    double end_time_ = 0.0;
+    int64 begin_memory_ = 0;
+    int64 memory_delta_ = 0;
+  };
+
+  vector<Step> steps_;
+  vector<size_t> open_phases_;
+  vector<string> notes_;
+  double checkpoint_time_ = 0.0;
+  int64 checkpoint_memory_ = 0;
+  bool is_finished_ = false;
+
+  void on_step_finished(Step &step, double now, int64 memory);
+
+  static int64 get_resident_memory();
+};
+
+}  // namespace td
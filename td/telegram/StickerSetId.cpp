@@ -12,6 +12,10 @@
 
 namespace td {
 
+void StickerSetId::store(LogEventStorerBuffer &storer) const {
+  storer.context()->td().get_actor_unsafe()->stickers_manager_->store_sticker_set_id(*this, storer);
+}
+
 void StickerSetId::store(LogEventStorerCalcLength &storer) const {
   storer.context()->td().get_actor_unsafe()->stickers_manager_->store_sticker_set_id(*this, storer);
 }
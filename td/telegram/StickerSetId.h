@@ -43,6 +43,8 @@ class StickerSetId {
     return id != other.id;
   }
 
+  void store(LogEventStorerBuffer &storer) const;
+
   void store(LogEventStorerCalcLength &storer) const;
 
   void store(LogEventStorerUnsafe &storer) const;
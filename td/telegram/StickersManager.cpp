@@ -43,6 +43,8 @@
 #include "td/db/SqliteKeyValue.h"
 #include "td/db/SqliteKeyValueAsync.h"
 
+#include "td/tl/tl_object_memory_usage.h"
+
 #include "td/actor/SleepActor.h"
 
 #include "td/utils/algorithm.h"
@@ -1706,6 +1708,10 @@ StickersManager::~StickersManager() {
 }
 
 void StickersManager::start_up() {
+  {
+    std::lock_guard<std::mutex> lock(emoji_keywords_mutex_);
+    manager_count_++;
+  }
   init();
 }
 
@@ -2019,6 +2025,13 @@ void StickersManager::on_load_special_sticker_set(const SpecialStickerSetType &t
 
 void StickersManager::tear_down() {
   parent_.reset();
+
+  std::lock_guard<std::mutex> lock(emoji_keywords_mutex_);
+  manager_count_--;
+  if (manager_count_ == 0 && !shared_emoji_keywords_.empty()) {
+    LOG(INFO) << "Clear shared emoji keywords";
+    shared_emoji_keywords_.clear();
+  }
 }
 
 StickerType StickersManager::get_sticker_type(FileId file_id) const {
@@ -2542,6 +2555,7 @@ tl_object_ptr<td_api::stickerSet> StickersManager::get_sticker_set_object(Sticke
   CHECK(sticker_set != nullptr);
   CHECK(sticker_set->was_loaded_);
   sticker_set->was_update_sent_ = true;
+  sticker_set->last_used_time_ = Time::now();
 
   std::vector<tl_object_ptr<td_api::sticker>> stickers;
   std::vector<tl_object_ptr<td_api::emojis>> emojis;
@@ -2601,7 +2615,7 @@ tl_object_ptr<td_api::stickerSetInfo> StickersManager::get_sticker_set_info_obje
     vector<FileId> regular_sticker_ids;
     vector<FileId> premium_sticker_ids;
     std::tie(regular_sticker_ids, premium_sticker_ids) = split_stickers_by_premium(sticker_set);
-    auto is_premium = td_->option_manager_->get_option_boolean("is_premium");
+    auto is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
     size_t max_premium_stickers = is_premium ? covers_limit : 1;
     if (premium_sticker_ids.size() > max_premium_stickers) {
       premium_sticker_ids.resize(max_premium_stickers);
@@ -3868,6 +3882,7 @@ StickerSetId StickersManager::on_get_messages_sticker_set(StickerSetId sticker_s
       s->is_loaded_ = true;
       s->expires_at_ = G()->unix_time() +
                        (td_->auth_manager_->is_bot() ? Random::fast(10 * 60, 15 * 60) : Random::fast(30 * 60, 50 * 60));
+      on_sticker_set_loaded(s);
     }
     return sticker_set_id;
   }
@@ -3890,6 +3905,7 @@ StickerSetId StickersManager::on_get_messages_sticker_set(StickerSetId sticker_s
   s->expires_at_ = G()->unix_time() +
                    (td_->auth_manager_->is_bot() ? Random::fast(10 * 60, 15 * 60) : Random::fast(30 * 60, 50 * 60));
 
+  on_sticker_set_loaded(s);
   if (s->is_loaded_) {
     update_sticker_set(s, "on_get_messages_sticker_set");
     send_update_installed_sticker_sets();
@@ -4506,7 +4522,7 @@ vector<FileId> StickersManager::get_stickers(StickerType sticker_type, string qu
       vector<FileId> regular_sticker_ids;
       vector<FileId> premium_sticker_ids;
       std::tie(regular_sticker_ids, premium_sticker_ids) = split_stickers_by_premium(result);
-      if (td_->option_manager_->get_option_boolean("is_premium") || allow_premium) {
+      if (td_->option_manager_->get_option_boolean(CachedOption::IsPremium) || allow_premium) {
         auto normal_count = td_->option_manager_->get_option_integer("stickers_normal_by_emoji_per_premium_num", 2);
         if (normal_count < 0) {
           normal_count = 2;
@@ -5288,18 +5304,12 @@ string StickersManager::get_full_sticker_set_database_key(StickerSetId set_id) {
 }
 
 string StickersManager::get_sticker_set_database_value(const StickerSet *s, bool with_stickers, const char *source) {
-  LogEventStorerCalcLength storer_calc_length;
-  store_sticker_set(s, with_stickers, storer_calc_length, source);
+  LogEventStorerBuffer storer;
+  store_sticker_set(s, with_stickers, storer, source);
 
-  BufferSlice value_buffer{storer_calc_length.get_length()};
-  auto value = value_buffer.as_mutable_slice();
+  LOG(DEBUG) << "Serialized size of " << s->id_ << " is " << storer.get_length();
 
-  LOG(DEBUG) << "Serialized size of " << s->id_ << " is " << value.size();
-
-  LogEventStorerUnsafe storer_unsafe(value.ubegin());
-  store_sticker_set(s, with_stickers, storer_unsafe, source);
-
-  return value.str();
+  return storer.move_as_buffer_slice().as_slice().str();
 }
 
 void StickersManager::update_sticker_set(StickerSet *sticker_set, const char *source) {
@@ -5466,11 +5476,104 @@ void StickersManager::on_load_sticker_set_from_database(StickerSetId sticker_set
     sticker_set->need_save_to_database_ = true;
   }
 
+  if (sticker_set->was_loaded_) {
+    on_sticker_set_loaded(sticker_set);
+  }
+
   update_sticker_set(sticker_set, "on_load_sticker_set_from_database");
 
   update_load_requests(sticker_set, with_stickers, Status::OK());
 }
 
+void StickersManager::on_sticker_set_loaded(StickerSet *sticker_set) {
+  sticker_set->last_used_time_ = Time::now();
+  if (!sticker_set->is_installed_ && G()->use_sqlite_pmc() && !unload_sticker_sets_timeout_.has_timeout()) {
+    unload_sticker_sets_timeout_.set_callback(unload_sticker_sets);
+    unload_sticker_sets_timeout_.set_callback_data(static_cast<void *>(td_));
+    unload_sticker_sets_timeout_.set_timeout_in(STICKER_SET_UNLOAD_DELAY);
+  }
+}
+
+void StickersManager::unload_sticker_sets(void *td_void) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  CHECK(td_void != nullptr);
+  auto td = static_cast<Td *>(td_void);
+  td->stickers_manager_->unload_unused_sticker_sets();
+}
+
+void StickersManager::unload_unused_sticker_sets() {
+  if (!G()->use_sqlite_pmc()) {
+    return;
+  }
+
+  // stickers of these sticker sets are expected to be always available
+  FlatHashSet<StickerSetId, StickerSetIdHash> kept_sticker_set_ids;
+  for (const auto &it : special_sticker_sets_) {
+    if (it.second->id_.is_valid()) {
+      kept_sticker_set_ids.insert(it.second->id_);
+    }
+  }
+  for (int32 type = 0; type < MAX_STICKER_TYPE; type++) {
+    for (auto sticker_set_id : featured_sticker_set_ids_[type]) {
+      kept_sticker_set_ids.insert(sticker_set_id);
+    }
+    for (auto sticker_set_id : old_featured_sticker_set_ids_[type]) {
+      kept_sticker_set_ids.insert(sticker_set_id);
+    }
+  }
+
+  vector<StickerSet *> sticker_sets;
+  sticker_sets_.foreach([&](const StickerSetId &sticker_set_id, unique_ptr<StickerSet> &sticker_set) {
+    // the sticker set must be saved to the database in its current state and must have no pending requests
+    if (sticker_set->was_loaded_ && !sticker_set->is_installed_ && !sticker_set->is_changed_ &&
+        !sticker_set->need_save_to_database_ && sticker_set->load_requests_.empty() &&
+        sticker_set->load_without_stickers_requests_.empty() &&
+        sticker_set->sticker_ids_.size() > get_max_featured_sticker_count(sticker_set->sticker_type_) &&
+        sticker_set_reload_queries_.count(sticker_set_id) == 0 && kept_sticker_set_ids.count(sticker_set_id) == 0) {
+      sticker_sets.push_back(sticker_set.get());
+    }
+  });
+  if (sticker_sets.size() <= MAX_LOADED_UNINSTALLED_STICKER_SETS) {
+    return;
+  }
+
+  std::sort(sticker_sets.begin(), sticker_sets.end(), [](const StickerSet *lhs, const StickerSet *rhs) {
+    return lhs->last_used_time_ < rhs->last_used_time_;
+  });
+  auto max_last_used_time = Time::now() - STICKER_SET_UNLOAD_DELAY;
+  for (size_t i = 0; i + MAX_LOADED_UNINSTALLED_STICKER_SETS < sticker_sets.size(); i++) {
+    if (sticker_sets[i]->last_used_time_ > max_last_used_time) {
+      // the remaining sticker sets were used recently
+      unload_sticker_sets_timeout_.set_timeout_in(STICKER_SET_UNLOAD_DELAY);
+      break;
+    }
+    unload_sticker_set(sticker_sets[i]);
+  }
+}
+
+void StickersManager::unload_sticker_set(StickerSet *sticker_set) {
+  // leave the sticker set in the same state as if it was loaded from the database without stickers
+  // all its stickers can be loaded again from the database using load_sticker_sets
+  LOG(INFO) << "Unload stickers of " << sticker_set->id_;
+  auto max_sticker_count = get_max_featured_sticker_count(sticker_set->sticker_type_);
+  CHECK(sticker_set->sticker_ids_.size() > max_sticker_count);
+  for (size_t i = max_sticker_count; i < sticker_set->sticker_ids_.size(); i++) {
+    sticker_set->sticker_keywords_map_.erase(sticker_set->sticker_ids_[i]);
+  }
+  sticker_set->sticker_ids_.resize(max_sticker_count);
+  sticker_set->sticker_ids_.shrink_to_fit();
+  td::remove_if(sticker_set->premium_sticker_positions_,
+                [max_sticker_count](int32 position) { return static_cast<size_t>(position) >= max_sticker_count; });
+  reset_to_empty(sticker_set->emoji_stickers_map_);
+  reset_to_empty(sticker_set->sticker_emojis_map_);
+  reset_to_empty(sticker_set->keyword_stickers_map_);
+  sticker_set->was_loaded_ = false;
+  sticker_set->is_loaded_ = false;
+}
+
 void StickersManager::reload_sticker_set(StickerSetId sticker_set_id, int64 access_hash, Promise<Unit> &&promise) {
   do_reload_sticker_set(sticker_set_id,
                         make_tl_object<telegram_api::inputStickerSetID>(sticker_set_id.get(), access_hash), 0,
@@ -9614,25 +9717,84 @@ string StickersManager::get_language_emojis_database_key(const string &language_
   return PSTRING() << "emoji$" << language_code << '$' << text;
 }
 
-vector<std::pair<string, string>> StickersManager::search_language_emojis(const string &language_code,
-                                                                          const string &text) {
-  LOG(INFO) << "Search emoji for \"" << text << "\" in language " << language_code;
+vector<string> StickersManager::get_keyword_language_emojis(const string &language_code, const string &text) {
+  LOG(INFO) << "Get emoji for \"" << text << "\" in language " << language_code;
   auto key = get_language_emojis_database_key(language_code, text);
+  string emojis = G()->td_db()->get_sqlite_sync_pmc()->get(key);
+  return full_split(emojis, '$');
+}
+
+void StickersManager::sort_emoji_keywords(vector<std::pair<string, string>> &keywords) {
+  std::stable_sort(keywords.begin(), keywords.end(),
+                   [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+
+  // keep only the last emojis for each keyword like the database does, and skip keywords without emojis
+  size_t result_size = 0;
+  for (size_t i = 0; i < keywords.size(); i++) {
+    if (i + 1 < keywords.size() && keywords[i + 1].first == keywords[i].first) {
+      continue;
+    }
+    if (keywords[i].second.empty()) {
+      continue;
+    }
+    if (result_size != i) {
+      keywords[result_size] = std::move(keywords[i]);
+    }
+    result_size++;
+  }
+  keywords.resize(result_size);
+}
+
+vector<std::pair<string, string>> StickersManager::search_language_emojis(const EmojiKeywords &keywords,
+                                                                          const string &text) {
   vector<std::pair<string, string>> result;
-  G()->td_db()->get_sqlite_sync_pmc()->get_by_prefix(key, [&text, &result](Slice key, Slice value) {
-    for (const auto &emoji : full_split(value, '$')) {
-      result.emplace_back(emoji.str(), PSTRING() << text << key);
+  auto it = std::lower_bound(keywords.keywords_.begin(), keywords.keywords_.end(), text,
+                             [](const std::pair<string, string> &keyword, const string &text) {
+                               return keyword.first < text;
+                             });
+  for (; it != keywords.keywords_.end() && begins_with(it->first, text); ++it) {
+    for (const auto &emoji : full_split(Slice(it->second), '$')) {
+      result.emplace_back(emoji.str(), it->first);
     }
-    return true;
-  });
+  }
   return result;
 }
 
-vector<string> StickersManager::get_keyword_language_emojis(const string &language_code, const string &text) {
-  LOG(INFO) << "Get emoji for \"" << text << "\" in language " << language_code;
-  auto key = get_language_emojis_database_key(language_code, text);
-  string emojis = G()->td_db()->get_sqlite_sync_pmc()->get(key);
-  return full_split(emojis, '$');
+vector<string> StickersManager::get_keyword_language_emojis(const EmojiKeywords &keywords, const string &text) {
+  auto it = std::lower_bound(keywords.keywords_.begin(), keywords.keywords_.end(), text,
+                             [](const std::pair<string, string> &keyword, const string &text) {
+                               return keyword.first < text;
+                             });
+  if (it == keywords.keywords_.end() || it->first != text) {
+    return {};
+  }
+  return full_split(it->second, '$');
+}
+
+std::shared_ptr<const StickersManager::EmojiKeywords> StickersManager::get_emoji_keyword_index(
+    const string &language_code) {
+  auto version = get_emoji_language_code_version(language_code);
+  auto shared_keywords = get_shared_emoji_keywords(language_code);
+  if (shared_keywords != nullptr && shared_keywords->version_ >= version) {
+    return shared_keywords;
+  }
+
+  // the index is built from the database once per keywords version and is shared with other clients
+  LOG(INFO) << "Build emoji keyword index of version " << version << " for language " << language_code;
+  auto emoji_keywords = std::make_shared<EmojiKeywords>();
+  emoji_keywords->version_ = version;
+  G()->td_db()->get_sqlite_sync_pmc()->get_by_prefix(get_language_emojis_database_key(language_code, string()),
+                                                     [&emoji_keywords](Slice key, Slice value) {
+                                                       emoji_keywords->keywords_.emplace_back(key.str(), value.str());
+                                                       return true;
+                                                     });
+  sort_emoji_keywords(emoji_keywords->keywords_);
+
+  shared_keywords = std::move(emoji_keywords);
+  if (version > 0) {
+    add_shared_emoji_keywords(language_code, shared_keywords);
+  }
+  return shared_keywords;
 }
 
 string StickersManager::get_emoji_language_codes_database_key(const vector<string> &language_codes) {
@@ -9775,6 +9937,25 @@ vector<string> StickersManager::get_emoji_language_codes(const vector<string> &i
   return it->second;
 }
 
+std::shared_ptr<const StickersManager::EmojiKeywords> StickersManager::get_shared_emoji_keywords(
+    const string &language_code) {
+  std::lock_guard<std::mutex> lock(emoji_keywords_mutex_);
+  auto it = shared_emoji_keywords_.find(language_code);
+  if (it == shared_emoji_keywords_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void StickersManager::add_shared_emoji_keywords(const string &language_code,
+                                                std::shared_ptr<const EmojiKeywords> keywords) {
+  std::lock_guard<std::mutex> lock(emoji_keywords_mutex_);
+  auto &shared_keywords = shared_emoji_keywords_[language_code];
+  if (shared_keywords == nullptr || shared_keywords->version_ < keywords->version_) {
+    shared_keywords = std::move(keywords);
+  }
+}
+
 void StickersManager::load_emoji_keywords(const string &language_code, Promise<Unit> &&promise) {
   auto &promises = load_emoji_keywords_queries_[language_code];
   promises.push_back(std::move(promise));
@@ -9783,49 +9964,43 @@ void StickersManager::load_emoji_keywords(const string &language_code, Promise<U
     return;
   }
 
+  auto shared_keywords = get_shared_emoji_keywords(language_code);
+  if (shared_keywords != nullptr) {
+    LOG(INFO) << "Use shared emoji keywords of version " << shared_keywords->version_ << " for language "
+              << language_code;
+    send_closure_later(actor_id(this), &StickersManager::on_get_emoji_keywords, language_code,
+                       Result<std::shared_ptr<const EmojiKeywords>>(std::move(shared_keywords)));
+    return;
+  }
+
   auto query_promise = PromiseCreator::lambda(
       [actor_id = actor_id(this),
        language_code](Result<telegram_api::object_ptr<telegram_api::emojiKeywordsDifference>> &&result) mutable {
-        send_closure(actor_id, &StickersManager::on_get_emoji_keywords, language_code, std::move(result));
+        send_closure(actor_id, &StickersManager::on_load_emoji_keywords, language_code, std::move(result));
       });
   td_->create_handler<GetEmojiKeywordsQuery>(std::move(query_promise))->send(language_code);
 }
 
-void StickersManager::on_get_emoji_keywords(
+void StickersManager::on_load_emoji_keywords(
     const string &language_code, Result<telegram_api::object_ptr<telegram_api::emojiKeywordsDifference>> &&result) {
-  auto it = load_emoji_keywords_queries_.find(language_code);
-  CHECK(it != load_emoji_keywords_queries_.end());
-  auto promises = std::move(it->second);
-  CHECK(!promises.empty());
-  load_emoji_keywords_queries_.erase(it);
-
   if (result.is_error()) {
     if (!G()->is_expected_error(result.error())) {
       LOG(ERROR) << "Receive " << result.error() << " from GetEmojiKeywordsQuery";
     }
-    fail_promises(promises, result.move_as_error());
-    return;
-  }
-
-  auto version = get_emoji_language_code_version(language_code);
-  CHECK(version == 0);
-
-  MultiPromiseActorSafe mpas{"SaveEmojiKeywordsMultiPromiseActor"};
-  for (auto &promise : promises) {
-    mpas.add_promise(std::move(promise));
+    return on_get_emoji_keywords(language_code, result.move_as_error());
   }
 
-  auto lock = mpas.get_promise();
-
   auto keywords = result.move_as_ok();
   LOG(INFO) << "Receive " << keywords->keywords_.size() << " emoji keywords for language " << language_code;
   LOG_IF(ERROR, language_code != keywords->lang_code_)
       << "Receive keywords for " << keywords->lang_code_ << " instead of " << language_code;
   LOG_IF(ERROR, keywords->from_version_ != 0) << "Receive keywords from version " << keywords->from_version_;
-  version = keywords->version_;
-  if (version <= 0) {
-    LOG(ERROR) << "Receive keywords of version " << version;
-    version = 1;
+
+  auto emoji_keywords = std::make_shared<EmojiKeywords>();
+  emoji_keywords->version_ = keywords->version_;
+  if (emoji_keywords->version_ <= 0) {
+    LOG(ERROR) << "Receive keywords of version " << emoji_keywords->version_;
+    emoji_keywords->version_ = 1;
   }
   for (auto &keyword_ptr : keywords->keywords_) {
     switch (keyword_ptr->get_id()) {
@@ -9839,10 +10014,8 @@ void StickersManager::on_get_emoji_keywords(
             is_good = false;
           }
         }
-        if (is_good && !G()->close_flag()) {
-          CHECK(G()->use_sqlite_pmc());
-          G()->td_db()->get_sqlite_pmc()->set(get_language_emojis_database_key(language_code, text),
-                                              implode(keyword->emoticons_, '$'), mpas.get_promise());
+        if (is_good) {
+          emoji_keywords->keywords_.emplace_back(std::move(text), implode(keyword->emoticons_, '$'));
         }
         break;
       }
@@ -9853,8 +10026,45 @@ void StickersManager::on_get_emoji_keywords(
         UNREACHABLE();
     }
   }
+
+  sort_emoji_keywords(emoji_keywords->keywords_);
+
+  std::shared_ptr<const EmojiKeywords> shared_keywords = std::move(emoji_keywords);
+  add_shared_emoji_keywords(language_code, shared_keywords);
+  on_get_emoji_keywords(language_code, std::move(shared_keywords));
+}
+
+void StickersManager::on_get_emoji_keywords(const string &language_code,
+                                            Result<std::shared_ptr<const EmojiKeywords>> &&result) {
+  auto it = load_emoji_keywords_queries_.find(language_code);
+  CHECK(it != load_emoji_keywords_queries_.end());
+  auto promises = std::move(it->second);
+  CHECK(!promises.empty());
+  load_emoji_keywords_queries_.erase(it);
+
+  if (result.is_error()) {
+    fail_promises(promises, result.move_as_error());
+    return;
+  }
+
+  auto version = get_emoji_language_code_version(language_code);
+  CHECK(version == 0);
+
+  MultiPromiseActorSafe mpas{"SaveEmojiKeywordsMultiPromiseActor"};
+  for (auto &promise : promises) {
+    mpas.add_promise(std::move(promise));
+  }
+
+  auto lock = mpas.get_promise();
+
+  auto keywords = result.move_as_ok();
+  version = keywords->version_;
   if (!G()->close_flag()) {
     CHECK(G()->use_sqlite_pmc());
+    for (auto &keyword : keywords->keywords_) {
+      G()->td_db()->get_sqlite_pmc()->set(get_language_emojis_database_key(language_code, keyword.first),
+                                          keyword.second, mpas.get_promise());
+    }
     G()->td_db()->get_sqlite_pmc()->set(get_emoji_language_code_version_database_key(language_code), to_string(version),
                                         mpas.get_promise());
     G()->td_db()->get_sqlite_pmc()->set(get_emoji_language_code_last_difference_time_database_key(language_code),
@@ -10036,7 +10246,8 @@ vector<std::pair<string, string>> StickersManager::search_emojis(const string &t
 
   vector<std::pair<string, string>> result;
   for (auto &language_code : query.language_codes_) {
-    combine(result, search_language_emojis(language_code, query.text_));
+    LOG(INFO) << "Search emoji for \"" << query.text_ << "\" in language " << language_code;
+    combine(result, search_language_emojis(*get_emoji_keyword_index(language_code), query.text_));
   }
   td::unique(result);
 
@@ -10053,7 +10264,8 @@ vector<string> StickersManager::get_keyword_emojis(const string &text, const vec
 
   vector<string> result;
   for (auto &language_code : query.language_codes_) {
-    combine(result, get_keyword_language_emojis(language_code, query.text_));
+    LOG(INFO) << "Get emoji for \"" << query.text_ << "\" in language " << language_code;
+    combine(result, get_keyword_language_emojis(*get_emoji_keyword_index(language_code), query.text_));
   }
   td::unique(result);
 
@@ -10282,4 +10494,29 @@ void StickersManager::get_current_state(vector<td_api::object_ptr<td_api::Update
   }
 }
 
+void StickersManager::memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const {
+  size_t pending_memory_usage = 0;
+  for (auto &it : pending_new_sticker_sets_) {
+    pending_memory_usage += tl_extra_memory_usage(it.second->stickers_);
+  }
+  for (auto &it : pending_add_sticker_to_sets_) {
+    pending_memory_usage +=
+        tl_extra_memory_usage(it.second->sticker_) + tl_extra_memory_usage(it.second->input_document_);
+  }
+  output.push_back(PSTRING() << "StickersManager: " << stickers_.calc_size() << " stickers, "
+                             << sticker_sets_.calc_size() << " sticker sets, " << pending_new_sticker_sets_.size()
+                             << " pending new sticker sets and " << pending_add_sticker_to_sets_.size()
+                             << " pending added stickers with TL objects of size " << pending_memory_usage);
+  auto stickers_usage = stickers_.memory_usage();
+  output.push_back(PSTRING() << "StickersManager::stickers_: " << stickers_usage);
+  hash_table_usage += stickers_usage;
+  auto sticker_sets_usage = sticker_sets_.memory_usage();
+  output.push_back(PSTRING() << "StickersManager::sticker_sets_: " << sticker_sets_usage);
+  hash_table_usage += sticker_sets_usage;
+}
+
+std::mutex StickersManager::emoji_keywords_mutex_;
+int32 StickersManager::manager_count_ = 0;
+FlatHashMap<string, std::shared_ptr<const StickersManager::EmojiKeywords>> StickersManager::shared_emoji_keywords_;
+
 }  // namespace td
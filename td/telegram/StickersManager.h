@@ -45,6 +45,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
@@ -433,6 +434,8 @@ class StickersManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const;
+
   template <class StorerT>
   void store_sticker_set_id(StickerSetId sticker_set_id, StorerT &storer) const;
 
@@ -441,6 +444,8 @@ class StickersManager final : public Actor {
 
  private:
   static constexpr int32 MAX_FEATURED_STICKER_SET_VIEW_DELAY = 5;
+  static constexpr int32 STICKER_SET_UNLOAD_DELAY = 600;  // stickers of unused sticker sets can be unloaded after it
+  static constexpr size_t MAX_LOADED_UNINSTALLED_STICKER_SETS = 50;
   static constexpr int32 OLD_FEATURED_STICKER_SET_SLICE_SIZE = 20;
 
   static constexpr int32 MAX_FOUND_STICKERS = 100;                 // server side limit
@@ -511,6 +516,7 @@ class StickersManager final : public Actor {
     bool is_thumbnail_reloaded_ = false;                   // stored in telegram_api::stickerSet
     bool are_legacy_sticker_thumbnails_reloaded_ = false;  // stored in telegram_api::stickerSet
     mutable bool was_update_sent_ = false;                 // does the sticker set is known to the client
+    mutable double last_used_time_ = 0.0;                  // time of the last load or the last returned object
     bool is_changed_ = true;             // have new changes that need to be sent to the client and database
     bool need_save_to_database_ = true;  // have new changes that need only to be saved to the database
 
@@ -684,6 +690,14 @@ class StickersManager final : public Actor {
 
   void on_load_sticker_set_from_database(StickerSetId sticker_set_id, bool with_stickers, string value);
 
+  void on_sticker_set_loaded(StickerSet *sticker_set);
+
+  static void unload_sticker_sets(void *td_void);
+
+  void unload_unused_sticker_sets();
+
+  void unload_sticker_set(StickerSet *sticker_set);
+
   void update_load_requests(StickerSet *sticker_set, bool with_stickers, const Status &status);
 
   void update_load_request(uint32 load_request_id, const Status &status);
@@ -958,14 +972,34 @@ class StickersManager final : public Actor {
 
   void on_get_language_codes(const string &key, Result<vector<string>> &&result);
 
-  static vector<std::pair<string, string>> search_language_emojis(const string &language_code, const string &text);
-
   static vector<string> get_keyword_language_emojis(const string &language_code, const string &text);
 
   void load_emoji_keywords(const string &language_code, Promise<Unit> &&promise);
 
-  void on_get_emoji_keywords(const string &language_code,
-                             Result<telegram_api::object_ptr<telegram_api::emojiKeywordsDifference>> &&result);
+  // emoji keywords for a language are identical for all clients, so a full list received by one client
+  // is shared with all other clients in the same process
+  // the list is sorted by keyword and is used as an immutable index for emoji search
+  struct EmojiKeywords {
+    int32 version_ = 0;
+    vector<std::pair<string, string>> keywords_;  // keyword and '$'-separated emojis
+  };
+
+  static void sort_emoji_keywords(vector<std::pair<string, string>> &keywords);
+
+  static vector<std::pair<string, string>> search_language_emojis(const EmojiKeywords &keywords, const string &text);
+
+  static vector<string> get_keyword_language_emojis(const EmojiKeywords &keywords, const string &text);
+
+  std::shared_ptr<const EmojiKeywords> get_emoji_keyword_index(const string &language_code);
+
+  static std::shared_ptr<const EmojiKeywords> get_shared_emoji_keywords(const string &language_code);
+
+  static void add_shared_emoji_keywords(const string &language_code, std::shared_ptr<const EmojiKeywords> keywords);
+
+  void on_load_emoji_keywords(const string &language_code,
+                              Result<telegram_api::object_ptr<telegram_api::emojiKeywordsDifference>> &&result);
+
+  void on_get_emoji_keywords(const string &language_code, Result<std::shared_ptr<const EmojiKeywords>> &&result);
 
   void load_emoji_keywords_difference(const string &language_code);
 
@@ -1066,6 +1100,8 @@ class StickersManager final : public Actor {
   FlatHashSet<StickerSetId, StickerSetIdHash> pending_viewed_featured_sticker_set_ids_;
   Timeout pending_featured_sticker_set_views_timeout_;
 
+  Timeout unload_sticker_sets_timeout_;
+
   int32 recent_stickers_limit_ = 200;
   int32 favorite_stickers_limit_ = 5;
 
@@ -1123,6 +1159,10 @@ class StickersManager final : public Actor {
   FlatHashMap<string, vector<Promise<Unit>>> load_language_codes_queries_;
   FlatHashMap<int64, string> emoji_suggestions_urls_;
 
+  static std::mutex emoji_keywords_mutex_;
+  static int32 manager_count_;
+  static FlatHashMap<string, std::shared_ptr<const EmojiKeywords>> shared_emoji_keywords_;
+
   struct GiftPremiumMessages {
     FlatHashSet<MessageFullId, MessageFullIdHash> message_full_ids_;
     FileId sticker_id_;
@@ -15,6 +15,7 @@
 #include "td/telegram/TdDb.h"
 
 #include "td/db/SqliteDb.h"
+#include "td/db/SqliteKeyValueSafe.h"
 
 #include "td/utils/algorithm.h"
 #include "td/utils/logging.h"
@@ -28,7 +29,7 @@
 namespace td {
 
 tl_object_ptr<td_api::databaseStatistics> DatabaseStats::get_database_statistics_object() const {
-  return make_tl_object<td_api::databaseStatistics>(debug);
+  return make_tl_object<td_api::databaseStatistics>(debug, reclaimed_size);
 }
 
 StorageManager::StorageManager(ActorShared<> parent, int32 scheduler_id)
@@ -36,6 +37,10 @@ StorageManager::StorageManager(ActorShared<> parent, int32 scheduler_id)
 }
 
 void StorageManager::start_up() {
+  if (G()->use_file_database()) {
+    auto kv_safe = std::make_shared<SqliteKeyValueSafe>("file_gc", G()->td_db()->get_sqlite_connection_safe());
+    gc_index_ = std::make_shared<FileGcIndex>(std::move(kv_safe));
+  }
   load_last_gc_timestamp();
   schedule_next_gc();
 
@@ -52,6 +57,7 @@ void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt) {
   auto add_size = real_size;
 #endif
   fast_stat_.size += add_size;
+  drop_cached_stats();
 
   if (fast_stat_.cnt < 0 || fast_stat_.size < 0) {
     LOG(ERROR) << "Wrong fast stat after adding size " << add_size << " and cnt " << cnt;
@@ -60,10 +66,30 @@ void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt) {
   save_fast_stat();
 }
 
+void StorageManager::on_file_accessed(FullLocalFileLocation location, int64 size) {
+  if (gc_index_ == nullptr || is_closed_) {
+    return;
+  }
+  FullFileInfo info;
+  info.file_type = location.file_type_;
+  info.path = std::move(location.path_);
+  info.size = size;
+  info.mtime_nsec = location.mtime_nsec_;
+  info.atime_nsec = static_cast<uint64>(Clocks::system() * 1e9);
+  gc_index_->add_file(info);
+}
+
 void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit, Promise<FileStats> promise) {
   if (is_closed_) {
     return promise.set_error(Global::request_aborted_error());
   }
+  if (!need_all_files && cached_stats_time_ != 0 && Time::now() < cached_stats_time_ + STATS_CACHE_TIME &&
+      cached_stats_split_by_owner_dialog_id_ == (dialog_limit != 0)) {
+    LOG(INFO) << "Return cached storage statistics";
+    vector<Promise<FileStats>> promises;
+    promises.push_back(std::move(promise));
+    return send_stats(FileStats(cached_stats_), dialog_limit, std::move(promises));
+  }
   if (!pending_storage_stats_.empty()) {
     if (stats_dialog_limit_ == dialog_limit && need_all_files == stats_need_all_files_) {
       pending_storage_stats_.emplace_back(std::move(promise));
@@ -77,6 +103,7 @@ void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit,
   }
   stats_dialog_limit_ = dialog_limit;
   stats_need_all_files_ = need_all_files;
+  stats_file_change_generation_ = file_change_generation_;
   pending_storage_stats_.emplace_back(std::move(promise));
 
   create_stats_worker();
@@ -102,6 +129,46 @@ void StorageManager::get_database_stats(Promise<DatabaseStats> promise) {
   }
 }
 
+void StorageManager::optimize_database(bool allow_full_vacuum, Promise<DatabaseStats> promise) {
+  if (is_closed_) {
+    return promise.set_error(Global::request_aborted_error());
+  }
+  TRY_STATUS_PROMISE(promise, G()->td_db()->enable_incremental_vacuum(allow_full_vacuum));
+  pending_optimize_database_.push_back(std::move(promise));
+  if (pending_optimize_database_.size() == 1) {
+    reclaimed_database_size_ = 0;
+    run_database_vacuum_step();
+  }
+}
+
+void StorageManager::run_database_vacuum_step() {
+  if (is_closed_ || pending_optimize_database_.empty()) {
+    return;
+  }
+  auto r_reclaimed_size = G()->td_db()->run_incremental_vacuum(DATABASE_VACUUM_STEP_PAGE_COUNT);
+  if (r_reclaimed_size.is_error()) {
+    return fail_promises(pending_optimize_database_, r_reclaimed_size.move_as_error());
+  }
+  if (r_reclaimed_size.ok() > 0) {
+    reclaimed_database_size_ += r_reclaimed_size.ok();
+    // the database is locked only during a step, so other queries can be handled between steps
+    send_closure_later(actor_id(this), &StorageManager::run_database_vacuum_step);
+    return;
+  }
+
+  LOG(INFO) << "Reclaimed " << reclaimed_database_size_ << " bytes in the database";
+  auto promises = std::move(pending_optimize_database_);
+  pending_optimize_database_.clear();
+  auto r_stats = G()->td_db()->get_stats();
+  if (r_stats.is_error()) {
+    return fail_promises(promises, r_stats.move_as_error());
+  }
+  DatabaseStats stats(r_stats.move_as_ok(), reclaimed_database_size_);
+  for (auto &promise : promises) {
+    promise.set_value(DatabaseStats(stats));
+  }
+}
+
 void StorageManager::update_use_storage_optimizer() {
   schedule_next_gc();
 }
@@ -138,6 +205,11 @@ void StorageManager::on_file_stats(Result<FileStats> r_file_stats, uint32 genera
   }
 
   update_fast_stats(r_file_stats.ok());
+  if (!stats_need_all_files_ && stats_file_change_generation_ == file_change_generation_) {
+    cached_stats_ = r_file_stats.ok();
+    cached_stats_split_by_owner_dialog_id_ = stats_dialog_limit_ != 0;
+    cached_stats_time_ = Time::now();
+  }
   send_stats(r_file_stats.move_as_ok(), stats_dialog_limit_, std::move(pending_storage_stats_));
 }
 
@@ -159,9 +231,15 @@ void StorageManager::on_all_files(FileGcParameters gc_parameters, Result<FileSta
     return on_gc_finished(dialog_limit, r_file_stats.move_as_error());
   }
 
+  auto all_files = r_file_stats.ok_ref().get_all_files();
+  if (gc_index_ != nullptr) {
+    gc_index_->rebuild(all_files);
+    save_last_full_gc_timestamp();
+  }
+
   create_gc_worker();
 
-  send_closure(gc_worker_, &FileGcWorker::run_gc, std::move(gc_parameters), r_file_stats.ok_ref().get_all_files(),
+  send_closure(gc_worker_, &FileGcWorker::run_gc, std::move(gc_parameters), std::move(all_files), gc_index_,
                PromiseCreator::lambda([actor_id = actor_id(this), dialog_limit](Result<FileGcResult> r_file_gc_result) {
                  send_closure(actor_id, &StorageManager::on_gc_finished, dialog_limit, std::move(r_file_gc_result));
                }));
@@ -223,6 +301,7 @@ void StorageManager::on_gc_finished(int32 dialog_limit, Result<FileGcResult> r_f
   }
 
   update_fast_stats(r_file_gc_result.ok().kept_file_stats_);
+  drop_cached_stats();
 
   auto kept_file_promises = std::move(pending_run_gc_[0]);
   auto removed_file_promises = std::move(pending_run_gc_[1]);
@@ -230,6 +309,49 @@ void StorageManager::on_gc_finished(int32 dialog_limit, Result<FileGcResult> r_f
   send_stats(std::move(r_file_gc_result.ok_ref().removed_file_stats_), dialog_limit, std::move(removed_file_promises));
 }
 
+bool StorageManager::need_full_gc() const {
+  if (gc_index_ == nullptr || !gc_index_->is_complete()) {
+    return true;
+  }
+  // the index can miss files, which were added not through FileManager, so it is resynchronized from time to time
+  auto sys_time = static_cast<uint32>(Clocks::system());
+  return last_full_gc_timestamp_ + FULL_GC_EACH < sys_time || sys_time < last_full_gc_timestamp_;
+}
+
+void StorageManager::run_incremental_gc(Promise<FileStats> promise) {
+  CHECK(!is_closed_);
+  CHECK(gc_index_ != nullptr);
+  if (!pending_run_gc_[0].empty() || !pending_run_gc_[1].empty()) {
+    close_gc_worker();
+  }
+  pending_run_gc_[0].push_back(std::move(promise));
+
+  create_gc_worker();
+  send_closure(gc_worker_, &FileGcWorker::run_incremental_gc, FileGcParameters(), gc_index_,
+               PromiseCreator::lambda([actor_id = actor_id(this)](Result<FileGcResult> r_file_gc_result) {
+                 send_closure(actor_id, &StorageManager::on_incremental_gc_finished, std::move(r_file_gc_result));
+               }));
+}
+
+void StorageManager::on_incremental_gc_finished(Result<FileGcResult> r_file_gc_result) {
+  if (r_file_gc_result.is_error()) {
+    return on_gc_finished(0, std::move(r_file_gc_result));
+  }
+
+  // statistics of kept files aren't known, so the fast statistics are decreased by the size of removed files
+  auto removed_stat = r_file_gc_result.ok().removed_file_stats_.get_total_nontemp_stat();
+  if (removed_stat.cnt != 0) {
+    on_new_file(-removed_stat.size, -removed_stat.size, -removed_stat.cnt);
+  }
+
+  auto promises = std::move(pending_run_gc_[0]);
+  pending_run_gc_[0].clear();
+  CHECK(pending_run_gc_[1].empty());
+  for (auto &promise : promises) {
+    promise.set_value(FileStats(false, false));
+  }
+}
+
 void StorageManager::save_fast_stat() {
   G()->td_db()->get_binlog_pmc()->set("fast_file_stat", log_event_store(fast_stat_).as_slice().str());
 }
@@ -249,6 +371,12 @@ void StorageManager::update_fast_stats(const FileStats &stats) {
   save_fast_stat();
 }
 
+void StorageManager::drop_cached_stats() {
+  file_change_generation_++;
+  cached_stats_time_ = 0;
+  cached_stats_ = FileStats(false, false);
+}
+
 void StorageManager::send_stats(FileStats &&stats, int32 dialog_limit, std::vector<Promise<FileStats>> &&promises) {
   if (promises.empty()) {
     return;
@@ -306,11 +434,13 @@ void StorageManager::hangup() {
   is_closed_ = true;
   close_stats_worker();
   close_gc_worker();
+  fail_promises(pending_optimize_database_, Global::request_aborted_error());
   hangup_shared();
 }
 
 uint32 StorageManager::load_last_gc_timestamp() {
   last_gc_timestamp_ = to_integer<uint32>(G()->td_db()->get_binlog_pmc()->get("files_gc_ts"));
+  last_full_gc_timestamp_ = to_integer<uint32>(G()->td_db()->get_binlog_pmc()->get("files_full_gc_ts"));
   return last_gc_timestamp_;
 }
 
@@ -319,6 +449,11 @@ void StorageManager::save_last_gc_timestamp() {
   G()->td_db()->get_binlog_pmc()->set("files_gc_ts", to_string(last_gc_timestamp_));
 }
 
+void StorageManager::save_last_full_gc_timestamp() {
+  last_full_gc_timestamp_ = static_cast<uint32>(Clocks::system());
+  G()->td_db()->get_binlog_pmc()->set("files_full_gc_ts", to_string(last_full_gc_timestamp_));
+}
+
 void StorageManager::schedule_next_gc() {
   if (!G()->get_option_boolean("use_storage_optimizer")) {
     next_gc_at_ = 0;
@@ -341,7 +476,7 @@ void StorageManager::schedule_next_gc() {
 
   LOG(INFO) << "Schedule next file clean up in " << next_gc_in;
   next_gc_at_ = Time::now() + next_gc_in;
-  set_timeout_at(next_gc_at_);
+  set_lazy_timeout_at(next_gc_at_);
 }
 
 void StorageManager::timeout_expired() {
@@ -349,17 +484,24 @@ void StorageManager::timeout_expired() {
     return;
   }
   if (!pending_run_gc_[0].empty() || !pending_run_gc_[1].empty() || !pending_storage_stats_.empty()) {
-    set_timeout_in(60);
+    set_lazy_timeout_in(60);
     return;
   }
   next_gc_at_ = 0;
-  run_gc({}, false, PromiseCreator::lambda([actor_id = actor_id(this)](Result<FileStats> r_stats) {
-           if (!r_stats.is_error() || r_stats.error().code() != 500) {
-             // do not save garbage collection timestamp if request was canceled
-             send_closure(actor_id, &StorageManager::save_last_gc_timestamp);
-           }
-           send_closure(actor_id, &StorageManager::schedule_next_gc);
-         }));
+  auto promise = PromiseCreator::lambda([actor_id = actor_id(this)](Result<FileStats> r_stats) {
+    if (!r_stats.is_error() || r_stats.error().code() != 500) {
+      // do not save garbage collection timestamp if request was canceled
+      send_closure(actor_id, &StorageManager::save_last_gc_timestamp);
+    }
+    send_closure(actor_id, &StorageManager::schedule_next_gc);
+    // reclaim space in the database if it supports incremental vacuum
+    send_closure(actor_id, &StorageManager::optimize_database, false, Promise<DatabaseStats>());
+  });
+  if (need_full_gc()) {
+    run_gc({}, false, std::move(promise));
+  } else {
+    run_incremental_gc(std::move(promise));
+  }
 }
 
 }  // namespace td
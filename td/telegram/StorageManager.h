@@ -6,7 +6,9 @@
 //
 #pragma once
 
+#include "td/telegram/files/FileGcIndex.h"
 #include "td/telegram/files/FileGcWorker.h"
+#include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/FileStats.h"
 #include "td/telegram/files/FileStatsWorker.h"
 #include "td/telegram/td_api.h"
@@ -19,12 +21,16 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <memory>
+
 namespace td {
 
 struct DatabaseStats {
   string debug;
+  int64 reclaimed_size = 0;
   DatabaseStats() = default;
-  explicit DatabaseStats(string debug) : debug(std::move(debug)) {
+  explicit DatabaseStats(string debug, int64 reclaimed_size = 0)
+      : debug(std::move(debug)), reclaimed_size(reclaimed_size) {
   }
   tl_object_ptr<td_api::databaseStatistics> get_database_statistics_object() const;
 };
@@ -35,15 +41,21 @@ class StorageManager final : public Actor {
   void get_storage_stats(bool need_all_files, int32 dialog_limit, Promise<FileStats> promise);
   void get_storage_stats_fast(Promise<FileStatsFast> promise);
   void get_database_stats(Promise<DatabaseStats> promise);
+  void optimize_database(bool allow_full_vacuum, Promise<DatabaseStats> promise);
   void run_gc(FileGcParameters parameters, bool return_deleted_file_statistics, Promise<FileStats> promise);
   void update_use_storage_optimizer();
 
   void on_new_file(int64 size, int64 real_size, int32 cnt);
 
+  void on_file_accessed(FullLocalFileLocation location, int64 size);
+
  private:
   static constexpr int GC_EACH = 60 * 60 * 24;  // 1 day
   static constexpr int GC_DELAY = 60;
   static constexpr int GC_RAND_DELAY = 60 * 15;
+  static constexpr int FULL_GC_EACH = 60 * 60 * 24 * 7;  // 1 week
+  static constexpr int32 DATABASE_VACUUM_STEP_PAGE_COUNT = 256;
+  static constexpr int STATS_CACHE_TIME = 10 * 60;  // to take into account changes made not through FileManager
 
   ActorShared<> parent_;
 
@@ -58,12 +70,20 @@ class StorageManager final : public Actor {
 
   FileTypeStat fast_stat_;
 
+  // the last calculated statistics, which are dropped when a file is added or deleted
+  FileStats cached_stats_{false, false};
+  bool cached_stats_split_by_owner_dialog_id_{false};
+  double cached_stats_time_{0};
+  uint32 file_change_generation_{0};
+  uint32 stats_file_change_generation_{0};
+
   CancellationTokenSource stats_cancellation_token_source_;
   CancellationTokenSource gc_cancellation_token_source_;
 
   void on_file_stats(Result<FileStats> r_file_stats, uint32 generation);
   void create_stats_worker();
   void update_fast_stats(const FileStats &stats);
+  void drop_cached_stats();
   static void send_stats(FileStats &&stats, int32 dialog_limit, std::vector<Promise<FileStats>> &&promises);
 
   void save_fast_stat();
@@ -86,17 +106,31 @@ class StorageManager final : public Actor {
   std::vector<Promise<FileStats>> pending_run_gc_[2];
 
   uint32 last_gc_timestamp_ = 0;
+  uint32 last_full_gc_timestamp_ = 0;
   double next_gc_at_ = 0;
 
+  std::shared_ptr<FileGcIndex> gc_index_;
+
   void on_all_files(FileGcParameters gc_parameters, Result<FileStats> r_file_stats);
   void create_gc_worker();
   void on_gc_finished(int32 dialog_limit, Result<FileGcResult> r_file_gc_result);
 
+  bool need_full_gc() const;
+  void run_incremental_gc(Promise<FileStats> promise);
+  void on_incremental_gc_finished(Result<FileGcResult> r_file_gc_result);
+
   void close_stats_worker();
   void close_gc_worker();
 
+  // Database vacuum
+  vector<Promise<DatabaseStats>> pending_optimize_database_;
+  int64 reclaimed_database_size_ = 0;
+
+  void run_database_vacuum_step();
+
   uint32 load_last_gc_timestamp();
   void save_last_gc_timestamp();
+  void save_last_full_gc_timestamp();
   void schedule_next_gc();
 
   void timeout_expired() final;
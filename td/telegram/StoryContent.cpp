@@ -160,6 +160,10 @@ static void parse(unique_ptr<StoryContent> &content, ParserT &parser) {
   }
 }
 
+void store_story_content(const StoryContent *content, LogEventStorerBuffer &storer) {
+  store(content, storer);
+}
+
 void store_story_content(const StoryContent *content, LogEventStorerCalcLength &storer) {
   store(content, storer);
 }
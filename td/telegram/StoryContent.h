@@ -33,6 +33,8 @@ class StoryContent {
   virtual ~StoryContent() = default;
 };
 
+void store_story_content(const StoryContent *content, LogEventStorerBuffer &storer);
+
 void store_story_content(const StoryContent *content, LogEventStorerCalcLength &storer);
 
 void store_story_content(const StoryContent *content, LogEventStorerUnsafe &storer);
@@ -12,6 +12,7 @@
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteStatement.h"
+#include "td/db/WriteBatchPolicy.h"
 
 #include "td/actor/actor.h"
 #include "td/actor/SchedulerLocalStorage.h"
@@ -26,6 +27,11 @@
 
 namespace td {
 
+static Status get_not_found_error() {
+  static const Status error = Status::StaticError(0, "Not found");
+  return error.clone();
+}
+
 // NB: must happen inside a transaction
 Status init_story_db(SqliteDb &db, int32 version) {
   LOG(INFO) << "Init story database " << tag("version", version);
@@ -176,8 +182,9 @@ class StoryDbImpl final : public StoryDbSyncInterface {
     get_story_stmt_.bind_int32(2, story_id.get()).ensure();
     get_story_stmt_.step().ensure();
     if (!get_story_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Database);
     return BufferSlice(get_story_stmt_.view_blob(0));
   }
 
@@ -255,8 +262,9 @@ class StoryDbImpl final : public StoryDbSyncInterface {
     get_active_stories_stmt_.bind_int64(1, dialog_id.get()).ensure();
     get_active_stories_stmt_.step().ensure();
     if (!get_active_stories_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Database);
     return BufferSlice(get_active_stories_stmt_.view_blob(0));
   }
 
@@ -304,8 +312,9 @@ class StoryDbImpl final : public StoryDbSyncInterface {
     get_active_story_list_state_stmt_.bind_int64(1, story_list_id == StoryListId::archive() ? 1 : 0).ensure();
     get_active_story_list_state_stmt_.step().ensure();
     if (!get_active_story_list_state_stmt_.has_row()) {
-      return Status::Error("Not found");
+      return get_not_found_error();
     }
+    BufferOwnerGuard buffer_owner_guard(BufferOwner::Database);
     return BufferSlice(get_active_story_list_state_stmt_.view_blob(0));
   }
 
@@ -509,46 +518,45 @@ class StoryDbAsync final : public StoryDbAsyncInterface {
 
     void force_flush() {
       do_flush();
-      LOG(INFO) << "StoryDb flushed";
+      LOG(INFO) << "StoryDb flushed with " << write_batch_policy_.get_stats();
     }
 
    private:
     std::shared_ptr<StoryDbSyncSafeInterface> sync_db_safe_;
     StoryDbSyncInterface *sync_db_ = nullptr;
 
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
-    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
-
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
     double wakeup_at_ = 0;
+    WriteBatchPolicy write_batch_policy_;
 
     template <class F>
     void add_write_query(F &&f) {
       pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
-      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
-        do_flush();
-        wakeup_at_ = 0;
+      if (write_batch_policy_.need_flush(pending_writes_.size())) {
+        do_flush(true);
       } else if (wakeup_at_ == 0) {
-        wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
-      }
-      if (wakeup_at_ != 0) {
+        wakeup_at_ = Time::now_cached() + write_batch_policy_.get_flush_delay();
         set_timeout_at(wakeup_at_);
       }
     }
     void add_read_query() {
       do_flush();
     }
-    void do_flush() {
+    void do_flush(bool is_full = false) {
       if (pending_writes_.empty()) {
         return;
       }
+      auto query_count = pending_writes_.size();
       sync_db_->begin_write_transaction().ensure();
       set_promises(pending_writes_);
+      auto commit_start_time = Time::now();
       sync_db_->commit_transaction().ensure();
+      write_batch_policy_.on_transaction_committed(query_count, Time::now() - commit_start_time, is_full);
       set_promises(finished_writes_);
       cancel_timeout();
+      wakeup_at_ = 0;
     }
     void timeout_expired() final {
       do_flush();
@@ -58,6 +58,7 @@
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 
+#include <algorithm>
 #include <limits>
 
 namespace td {
@@ -1417,6 +1418,9 @@ StoryManager::StoryManager(Td *td, ActorShared<> parent) : td_(td), parent_(std:
   story_can_get_viewers_timeout_.set_callback(on_story_can_get_viewers_timeout_callback);
   story_can_get_viewers_timeout_.set_callback_data(static_cast<void *>(this));
 
+  unload_stories_timeout_.set_callback(unload_stories_static);
+  unload_stories_timeout_.set_callback_data(static_cast<void *>(this));
+
   if (G()->use_message_database() && td_->auth_manager_->is_authorized() && !td_->auth_manager_->is_bot()) {
     for (auto story_list_id : {StoryListId::main(), StoryListId::archive()}) {
       auto r_value = G()->td_db()->get_story_db_sync()->get_active_story_list_state(story_list_id);
@@ -1760,6 +1764,7 @@ StoryManager::Story *StoryManager::get_story_force(StoryFullId story_full_id, co
 
   auto story = get_story_editable(story_full_id);
   if (story != nullptr && story->content_ != nullptr) {
+    story->last_access_time_ = Time::now();
     return story;
   }
 
@@ -1855,6 +1860,9 @@ StoryManager::Story *StoryManager::on_get_story_from_database(StoryFullId story_
   auto result = story.get();
   stories_.set(story_full_id, std::move(story));
   register_story_global_id(story_full_id, result);
+  if (unloaded_sent_story_full_ids_.erase(story_full_id) > 0) {
+    result->is_update_sent_ = true;
+  }
 
   CHECK(!is_inaccessible_story(story_full_id));
   CHECK(being_edited_stories_.count(story_full_id) == 0);
@@ -2605,6 +2613,10 @@ void StoryManager::open_story(DialogId owner_dialog_id, StoryId story_id, Promis
   bool need_increment_story_views = story_id.is_server() && !is_active && story->is_pinned_;
   bool need_read_story = story_id.is_server() && is_active;
 
+  if (is_active) {
+    prefetch_next_active_stories(owner_dialog_id);
+  }
+
   if (need_increment_story_views) {
     auto &story_views = pending_story_views_[owner_dialog_id];
     story_views.story_ids_.insert(story_id);
@@ -2697,7 +2709,7 @@ bool StoryManager::can_use_story_reaction(const Story *story, const ReactionType
     return true;
   }
   if (reaction_type.is_custom_reaction()) {
-    if (td_->option_manager_->get_option_boolean("is_premium")) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::IsPremium)) {
       return true;
     }
     if (has_suggested_reaction(story, reaction_type)) {
@@ -3217,6 +3229,7 @@ td_api::object_ptr<td_api::story> StoryManager::get_story_object(StoryFullId sto
   if (story == nullptr || story->content_ == nullptr) {
     return nullptr;
   }
+  story->last_access_time_ = Time::now();
   auto owner_dialog_id = story_full_id.get_dialog_id();
   if (!can_access_expired_story(owner_dialog_id, story) && !is_active_story(story)) {
     return nullptr;
@@ -3737,6 +3750,12 @@ void StoryManager::on_delete_story(StoryFullId story_full_id) {
     edit_generations_.erase(story_full_id);
   } else {
     LOG(INFO) << "Delete not found " << story_full_id;
+    if (unloaded_sent_story_full_ids_.erase(story_full_id) > 0) {
+      send_closure(
+          G()->td(), &Td::send_update,
+          td_api::make_object<td_api::updateStoryDeleted>(
+              td_->dialog_manager_->get_chat_id_object(owner_dialog_id, "updateStoryDeleted"), story_id.get()));
+    }
   }
 
   auto active_stories = get_active_stories_force(owner_dialog_id, "on_get_deleted_story");
@@ -3782,6 +3801,7 @@ void StoryManager::on_story_changed(StoryFullId story_full_id, const Story *stor
   if (story->content_ == nullptr) {
     return;
   }
+  story->last_access_time_ = Time::now();
   if (is_changed || need_save_to_database) {
     if (G()->use_message_database() && !from_database) {
       LOG(INFO) << "Add " << story_full_id << " to database";
@@ -3820,7 +3840,11 @@ void StoryManager::register_story_global_id(StoryFullId story_full_id, Story *st
   CHECK(story_full_id.is_server());
   CHECK(story->global_id_ == 0);
   story->global_id_ = ++max_story_global_id_;
+  story->last_access_time_ = Time::now();
   stories_by_global_id_[story->global_id_] = story_full_id;
+  if (!unload_stories_timeout_.has_timeout()) {
+    unload_stories_timeout_.set_timeout_in(STORY_UNLOAD_DELAY);
+  }
 }
 
 void StoryManager::unregister_story_global_id(const Story *story) {
@@ -4615,11 +4639,132 @@ void StoryManager::reload_story(StoryFullId story_full_id, Promise<Unit> &&promi
     return;
   }
 
-  auto query_promise =
-      PromiseCreator::lambda([actor_id = actor_id(this), story_full_id](Result<Unit> &&result) mutable {
-        send_closure(actor_id, &StoryManager::on_reload_story, story_full_id, std::move(result));
-      });
-  td_->create_handler<GetStoriesByIDQuery>(std::move(query_promise))->send(dialog_id, {story_id});
+  // stories requested during the same event loop iteration are reloaded by one query per chat
+  if (pending_reload_story_ids_.empty()) {
+    send_closure_later(actor_id(this), &StoryManager::send_reload_stories_queries);
+  }
+  pending_reload_story_ids_[dialog_id].push_back(story_id);
+}
+
+void StoryManager::send_reload_stories_queries() {
+  auto pending_reload_story_ids = std::move(pending_reload_story_ids_);
+  reset_to_empty(pending_reload_story_ids_);
+  for (auto &it : pending_reload_story_ids) {
+    auto dialog_id = it.first;
+    const auto &story_ids = it.second;
+    for (size_t i = 0; i < story_ids.size(); i += MAX_RELOADED_STORY_IDS) {
+      auto end = story_ids.begin() + min(i + MAX_RELOADED_STORY_IDS, story_ids.size());
+      vector<StoryId> query_story_ids(story_ids.begin() + i, end);
+      LOG(INFO) << "Reload " << query_story_ids << " in " << dialog_id;
+      auto query_promise = PromiseCreator::lambda(
+          [actor_id = actor_id(this), dialog_id, query_story_ids](Result<Unit> &&result) mutable {
+            send_closure(actor_id, &StoryManager::on_reload_stories, dialog_id, std::move(query_story_ids),
+                         std::move(result));
+          });
+      td_->create_handler<GetStoriesByIDQuery>(std::move(query_promise))->send(dialog_id, std::move(query_story_ids));
+    }
+  }
+}
+
+void StoryManager::on_reload_stories(DialogId owner_dialog_id, vector<StoryId> story_ids, Result<Unit> &&result) {
+  for (auto story_id : story_ids) {
+    on_reload_story({owner_dialog_id, story_id},
+                    result.is_ok() ? Result<Unit>(Unit()) : Result<Unit>(result.error().clone()));
+  }
+}
+
+void StoryManager::prefetch_next_active_stories(DialogId owner_dialog_id) {
+  const ActiveStories *active_stories = get_active_stories(owner_dialog_id);
+  if (active_stories == nullptr || !active_stories->story_list_id_.is_valid()) {
+    return;
+  }
+  const auto &story_list = get_story_list(active_stories->story_list_id_);
+  auto it = story_list.ordered_stories_.find({active_stories->private_order_, owner_dialog_id});
+  if (it == story_list.ordered_stories_.end()) {
+    return;
+  }
+  ++it;
+  for (int32 i = 0; i < PREFETCHED_ACTIVE_STORY_DIALOGS && it != story_list.ordered_stories_.end(); i++, ++it) {
+    auto dialog_id = it->get_dialog_id();
+    const ActiveStories *next_active_stories = get_active_stories(dialog_id);
+    if (next_active_stories == nullptr) {
+      continue;
+    }
+    for (auto story_id : next_active_stories->story_ids_) {
+      StoryFullId story_full_id{dialog_id, story_id};
+      const Story *story = get_story_force(story_full_id, "prefetch_next_active_stories");
+      if (story_id.is_server() && (story == nullptr || story->content_ == nullptr)) {
+        reload_story(story_full_id, Promise<Unit>(), "prefetch_next_active_stories");
+      }
+    }
+  }
+}
+
+void StoryManager::unload_stories_static(void *story_manager) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  CHECK(story_manager != nullptr);
+  static_cast<StoryManager *>(story_manager)->unload_inactive_stories();
+}
+
+void StoryManager::unload_inactive_stories() {
+  if (!G()->use_message_database()) {
+    // unloaded stories can't be restored
+    return;
+  }
+
+  auto unload_before = Time::now() - STORY_UNLOAD_DELAY;
+  size_t inactive_story_count = 0;
+  vector<std::pair<double, StoryFullId>> unloadable_stories;
+  stories_.foreach([&](const StoryFullId &story_full_id, unique_ptr<Story> &story) {
+    if (is_active_story(story.get())) {
+      return;
+    }
+    inactive_story_count++;
+    if (story->last_access_time_ < unload_before && can_unload_story(story_full_id, story.get())) {
+      unloadable_stories.emplace_back(story->last_access_time_, story_full_id);
+    }
+  });
+
+  if (inactive_story_count > MAX_LOADED_INACTIVE_STORIES && !unloadable_stories.empty()) {
+    // unload the least recently used stories
+    auto unload_count = min(inactive_story_count - MAX_LOADED_INACTIVE_STORIES, unloadable_stories.size());
+    std::nth_element(unloadable_stories.begin(), unloadable_stories.begin() + (unload_count - 1),
+                     unloadable_stories.end(),
+                     [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+    LOG(INFO) << "Unload " << unload_count << " out of " << inactive_story_count << " inactive stories";
+    for (size_t i = 0; i < unload_count; i++) {
+      auto story_full_id = unloadable_stories[i].second;
+      unload_story(story_full_id, get_story(story_full_id));
+    }
+  }
+
+  if (!stories_.empty()) {
+    unload_stories_timeout_.set_timeout_in(STORY_UNLOAD_DELAY);
+  }
+}
+
+bool StoryManager::can_unload_story(StoryFullId story_full_id, const Story *story) const {
+  // the story must be saved in the database and must not be used by other objects
+  return story_full_id.get_story_id().is_server() && story->content_ != nullptr &&
+         !has_unexpired_viewers(story_full_id, story) && opened_stories_.count(story_full_id) == 0 &&
+         opened_stories_with_view_count_.count(story_full_id) == 0 &&
+         being_edited_stories_.count(story_full_id) == 0 && being_set_story_reactions_.count(story_full_id) == 0 &&
+         reload_story_queries_.count(story_full_id) == 0 && story_messages_.count(story_full_id) == 0;
+}
+
+void StoryManager::unload_story(StoryFullId story_full_id, const Story *story) {
+  CHECK(story != nullptr);
+  LOG(INFO) << "Unload " << story_full_id;
+  if (story->is_update_sent_) {
+    unloaded_sent_story_full_ids_.insert(story_full_id);
+  }
+  story_reload_timeout_.cancel_timeout(story->global_id_);
+  story_can_get_viewers_timeout_.cancel_timeout(story->global_id_);
+  unregister_story_global_id(story);
+  stories_.erase(story_full_id);
 }
 
 void StoryManager::on_reload_story(StoryFullId story_full_id, Result<Unit> &&result) {
@@ -4876,7 +5021,7 @@ void StoryManager::send_story(DialogId dialog_id, td_api::object_ptr<td_api::Inp
     forward_info->hide_sender_if_needed(td_);
   }
   if (active_period != 86400 && !(G()->is_test_dc() && (active_period == 60 || active_period == 300))) {
-    bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+    bool is_premium = td_->option_manager_->get_option_boolean(CachedOption::IsPremium);
     if (!is_premium || !td::contains(vector<int32>{6 * 3600, 12 * 3600, 2 * 86400}, active_period)) {
       return promise.set_error(Status::Error(400, "Invalid story active period specified"));
     }
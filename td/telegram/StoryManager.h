@@ -68,6 +68,7 @@ class StoryManager final : public Actor {
     bool is_outgoing_ = false;
     bool noforwards_ = false;
     mutable bool is_update_sent_ = false;  // whether the story is known to the app
+    mutable double last_access_time_ = 0.0;
     unique_ptr<StoryForwardInfo> forward_info_;
     StoryInteractionInfo interaction_info_;
     ReactionType chosen_reaction_type_;
@@ -371,6 +372,11 @@ class StoryManager final : public Actor {
 
   static constexpr int32 DEFAULT_LOADED_EXPIRED_STORIES = 50;
 
+  static constexpr size_t MAX_RELOADED_STORY_IDS = 100;        // maximum number of stories reloaded by one query
+  static constexpr int32 PREFETCHED_ACTIVE_STORY_DIALOGS = 3;  // number of next chats, which stories are preloaded
+  static constexpr size_t MAX_LOADED_INACTIVE_STORIES = 1000;  // soft limit for inactive stories kept in memory
+  static constexpr int32 STORY_UNLOAD_DELAY = 600;             // minimum time after last access to unload a story
+
   void start_up() final;
 
   void timeout_expired() final;
@@ -539,6 +545,20 @@ class StoryManager final : public Actor {
 
   void on_reload_story(StoryFullId story_full_id, Result<Unit> &&result);
 
+  void send_reload_stories_queries();
+
+  void on_reload_stories(DialogId owner_dialog_id, vector<StoryId> story_ids, Result<Unit> &&result);
+
+  void prefetch_next_active_stories(DialogId owner_dialog_id);
+
+  static void unload_stories_static(void *story_manager);
+
+  void unload_inactive_stories();
+
+  bool can_unload_story(StoryFullId story_full_id, const Story *story) const;
+
+  void unload_story(StoryFullId story_full_id, const Story *story);
+
   int64 save_send_story_log_event(const PendingStory *pending_story);
 
   void delete_pending_story(FileId file_id, unique_ptr<PendingStory> &&pending_story, Status status);
@@ -674,6 +694,10 @@ class StoryManager final : public Actor {
 
   FlatHashMap<StoryFullId, vector<Promise<Unit>>, StoryFullIdHash> reload_story_queries_;
 
+  FlatHashMap<DialogId, vector<StoryId>, DialogIdHash> pending_reload_story_ids_;
+
+  FlatHashSet<StoryFullId, StoryFullIdHash> unloaded_sent_story_full_ids_;  // unloaded stories known to the app
+
   FlatHashMap<FileId, unique_ptr<PendingStory>, FileIdHash> being_uploaded_files_;
 
   FlatHashMap<DialogId, std::set<uint32>, DialogIdHash> yet_unsent_stories_;
@@ -717,6 +741,8 @@ class StoryManager final : public Actor {
 
   Timeout interaction_info_update_timeout_;
 
+  Timeout unload_stories_timeout_;
+
   int32 load_expired_database_stories_next_limit_ = DEFAULT_LOADED_EXPIRED_STORIES;
 
   MultiTimeout story_reload_timeout_{"StoryReloadTimeout"};
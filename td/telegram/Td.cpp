@@ -131,6 +131,7 @@
 #include "td/telegram/ReactionManager.h"
 #include "td/telegram/ReactionNotificationSettings.h"
 #include "td/telegram/ReactionType.h"
+#include "td/telegram/ReadOnlyRequestExecutor.h"
 #include "td/telegram/ReportReason.h"
 #include "td/telegram/RequestActor.h"
 #include "td/telegram/SavedMessagesManager.h"
@@ -186,9 +187,13 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/AllocationTags.h"
 #include "td/utils/buffer.h"
 #include "td/utils/filesystem.h"
+#include "td/utils/FlatHashSet.h"
 #include "td/utils/format.h"
+#include "td/utils/HashTableUtils.h"
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/MimeType.h"
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
@@ -199,7 +204,9 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
 #include "td/utils/Timer.h"
+#include "td/utils/TraceSpans.h"
 #include "td/utils/utf8.h"
 
 #include <limits>
@@ -216,6 +223,10 @@ void Td::ResultHandler::set_td(Td *td) {
   td_ = td;
 }
 
+void Td::ResultHandler::run_on_fetch_scheduler(Promise<Unit> action) {
+  Scheduler::instance()->run_on_scheduler(G()->get_gc_scheduler_id(), std::move(action));
+}
+
 void Td::ResultHandler::send_query(NetQueryPtr query) {
   CHECK(!is_query_sent_);
   is_query_sent_ = true;
@@ -2440,7 +2451,12 @@ class SearchBackgroundRequest final : public RequestActor<> {
 };
 
 Td::Td(unique_ptr<TdCallback> callback, Options options)
-    : callback_(std::move(callback)), td_options_(std::move(options)) {
+    : channel_recommendation_manager_(this, "ChannelRecommendationManager")
+    , phone_number_manager_(this, "PhoneNumberManager")
+    , statistics_manager_(this, "StatisticsManager")
+    , translation_manager_(this, "TranslationManager")
+    , callback_(std::move(callback))
+    , td_options_(std::move(options)) {
   CHECK(callback_ != nullptr);
   LOG(INFO) << "Create Td with layer " << MTPROTO_LAYER << ", database version " << current_db_version()
             << " and version " << static_cast<int32>(Version::Next) - 1 << " on "
@@ -2476,6 +2492,10 @@ void Td::on_alarm_timeout(int64 alarm_id) {
     }
     return;
   }
+  if (alarm_id == FLUSH_UPDATES_ALARM_ID) {
+    flush_pending_updates();
+    return;
+  }
   if (alarm_id == PROMO_DATA_ALARM_ID) {
     if (!close_flag_ && !auth_manager_->is_bot()) {
       reloading_promo_data_ = true;
@@ -2643,7 +2663,7 @@ void Td::set_is_online(bool is_online) {
 void Td::set_is_bot_online(bool is_bot_online) {
   alarm_timeout_.set_timeout_in(PING_SERVER_ALARM_ID, PING_SERVER_TIMEOUT + Random::fast(0, PING_SERVER_TIMEOUT / 5));
 
-  if (G()->get_option_integer("session_count") > 1) {
+  if (G()->get_option_integer(CachedOption::SessionCount) > 1) {
     is_bot_online = false;
   }
 
@@ -2715,7 +2735,11 @@ bool Td::is_synchronous_request(const td_api::Function *function) {
     case td_api::getLogTags::ID:
     case td_api::setLogTagVerbosityLevel::ID:
     case td_api::getLogTagVerbosityLevel::ID:
+    case td_api::setLogTagRateLimit::ID:
+    case td_api::getLogTagRateLimit::ID:
     case td_api::addLogMessage::ID:
+    case td_api::toggleTraceSpans::ID:
+    case td_api::getTraceSpans::ID:
     case td_api::testReturnError::ID:
       return true;
     case td_api::getOption::ID:
@@ -2728,6 +2752,8 @@ bool Td::is_synchronous_request(const td_api::Function *function) {
 bool Td::is_preinitialization_request(int32 id) {
   switch (id) {
     case td_api::getCurrentState::ID:
+    case td_api::setUpdateFilter::ID:
+    case td_api::setDatabaseSettings::ID:
     case td_api::setAlarm::ID:
     case td_api::testUseUpdate::ID:
     case td_api::testCallEmpty::ID:
@@ -2764,10 +2790,14 @@ bool Td::is_preauthentication_request(int32 id) {
     case td_api::getStorageStatistics::ID:
     case td_api::getStorageStatisticsFast::ID:
     case td_api::getDatabaseStatistics::ID:
+    case td_api::optimizeDatabase::ID:
     case td_api::setNetworkType::ID:
     case td_api::getNetworkStatistics::ID:
     case td_api::addNetworkStatistics::ID:
     case td_api::resetNetworkStatistics::ID:
+    case td_api::getNetworkRequestLatencyStatistics::ID:
+    case td_api::getStorageLatencyStatistics::ID:
+    case td_api::getStartupStatistics::ID:
     case td_api::getCountries::ID:
     case td_api::getCountryCode::ID:
     case td_api::getPhoneNumberInfo::ID:
@@ -2827,7 +2857,7 @@ DbKey Td::as_db_key(string key) {
   return DbKey::raw_key(std::move(key));
 }
 
-void Td::request(uint64 id, tl_object_ptr<td_api::Function> function) {
+void Td::request(uint64 id, tl_object_ptr<td_api::Function> function, double deadline) {
   if (id == 0) {
     LOG(ERROR) << "Ignore request with ID == 0: " << to_string(function);
     return;
@@ -2837,6 +2867,12 @@ void Td::request(uint64 id, tl_object_ptr<td_api::Function> function) {
     return callback_->on_error(id, make_error(400, "Request is empty"));
   }
 
+  if (deadline > 0.0 && Time::now() > deadline) {
+    shed_request_count_++;
+    LOG(INFO) << "Drop request " << id << " of type " << function->get_id() << " with expired deadline";
+    return callback_->on_error(id, make_error(408, "Request timeout expired"));
+  }
+
   VLOG(td_requests) << "Receive request " << id << ": " << to_string(function);
   request_set_.emplace(id, function->get_id());
   if (is_synchronous_request(function.get())) {
@@ -2844,7 +2880,28 @@ void Td::request(uint64 id, tl_object_ptr<td_api::Function> function) {
     return send_result(id, static_request(std::move(function)));
   }
 
+  // network queries created while the request is run inherit its deadline and priority class
+  current_request_deadline_ = deadline;
+  current_request_priority_class_ = get_request_priority_class();
+  // actor events and network queries caused by the request inherit its trace
+  TraceSpan trace_span(TraceSpans::create_trace_id(), "Td::request");
   run_request(id, std::move(function));
+  current_request_deadline_ = 0.0;
+  current_request_priority_class_ = NetQuery::PriorityClass::Normal;
+}
+
+NetQuery::PriorityClass Td::get_request_priority_class() const {
+  if (option_manager_ == nullptr) {
+    return NetQuery::PriorityClass::Interactive;
+  }
+  switch (option_manager_->get_option_integer("request_priority", 2)) {
+    case 0:
+      return NetQuery::PriorityClass::Bulk;
+    case 1:
+      return NetQuery::PriorityClass::Normal;
+    default:
+      return NetQuery::PriorityClass::Interactive;
+  }
 }
 
 void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
@@ -2882,6 +2939,7 @@ void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
           auto parameters = r_parameters.move_as_ok();
 
           VLOG(td_init) << "Begin to open database";
+          startup_trace_.begin_phase("initialization");
           set_parameters_request_id_ = id;
           can_ignore_background_updates_ = !parameters.second.use_chat_info_database_ &&
                                            !parameters.second.use_message_database_ &&
@@ -3299,7 +3357,7 @@ void Td::clear() {
   reset_actor(ActorOwn<Actor>(std::move(bot_info_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(business_connection_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(business_manager_actor_)));
-  reset_actor(ActorOwn<Actor>(std::move(channel_recommendation_manager_actor_)));
+  reset_actor(channel_recommendation_manager_.release_actor());
   reset_actor(ActorOwn<Actor>(std::move(common_dialog_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(chat_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(country_info_manager_actor_)));
@@ -3321,21 +3379,21 @@ void Td::clear() {
   reset_actor(ActorOwn<Actor>(std::move(notification_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(notification_settings_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(people_nearby_manager_actor_)));
-  reset_actor(ActorOwn<Actor>(std::move(phone_number_manager_actor_)));
+  reset_actor(phone_number_manager_.release_actor());
   reset_actor(ActorOwn<Actor>(std::move(poll_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(privacy_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(quick_reply_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(reaction_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(saved_messages_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(sponsored_message_manager_actor_)));
-  reset_actor(ActorOwn<Actor>(std::move(statistics_manager_actor_)));
+  reset_actor(statistics_manager_.release_actor());
   reset_actor(ActorOwn<Actor>(std::move(stickers_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(story_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(theme_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(time_zone_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(top_dialog_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(transcription_manager_actor_)));
-  reset_actor(ActorOwn<Actor>(std::move(translation_manager_actor_)));
+  reset_actor(translation_manager_.release_actor());
   reset_actor(ActorOwn<Actor>(std::move(updates_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(user_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(video_notes_manager_actor_)));
@@ -3374,6 +3432,9 @@ void Td::close_impl(bool destroy_flag) {
   state_ = State::Close;
   close_flag_ = 1;
   G()->set_close_flag();
+  if (read_only_request_executor_ != nullptr) {
+    read_only_request_executor_->close();
+  }
   send_closure(auth_manager_actor_, &AuthManager::on_closing, destroy_flag);
   updates_manager_->timeout_expired();  // save PTS and QTS
 
@@ -3451,6 +3512,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   auto events = r_opened_database.move_as_ok();
 
   VLOG(td_init) << "Successfully inited database";
+  startup_trace_.append(std::move(events.trace));
 
   if (state_ == State::Close) {
     LOG(INFO) << "Close asynchronously opened database";
@@ -3465,8 +3527,10 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   }
 
   G()->init(actor_id(this), std::move(events.database)).ensure();
+  startup_trace_.add_step("init Global");
 
   init_options_and_network();
+  startup_trace_.add_step("init options and network");
 
   // we need to process td_api::getOption along with td_api::setOption for consistency
   // we need to process td_api::setOption before managers and MTProto header are created,
@@ -3490,6 +3554,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
     G()->connection_creator().get_actor_unsafe()->set_net_stats_callback(
         net_stats_manager_ptr->get_common_stats_callback(), net_stats_manager_ptr->get_media_stats_callback());
     G()->set_net_stats_file_callbacks(net_stats_manager_ptr->get_file_stats_callbacks());
+    startup_trace_.add_step("init NetStatsManager");
   }
 
   complete_pending_preauthentication_requests([](int32 id) {
@@ -3513,7 +3578,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   options_.language_pack = option_manager_->get_option_string("localization_target");
   options_.language_code = option_manager_->get_option_string("language_pack_id");
   options_.parameters = option_manager_->get_option_string("connection_parameters");
-  options_.tz_offset = static_cast<int32>(option_manager_->get_option_integer("utc_time_offset"));
+  options_.tz_offset = static_cast<int32>(option_manager_->get_option_integer(CachedOption::UtcTimeOffset));
   options_.is_emulator = option_manager_->get_option_boolean("is_emulator");
   // options_.proxy = Proxy();
   G()->set_mtproto_header(make_unique<MtprotoHeader>(options_));
@@ -3523,6 +3588,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   VLOG(td_init) << "Create NetQueryDispatcher";
   auto net_query_dispatcher = make_unique<NetQueryDispatcher>([&] { return create_reference(); });
   G()->set_net_query_dispatcher(std::move(net_query_dispatcher));
+  startup_trace_.add_step("create NetQueryDispatcher");
 
   complete_pending_preauthentication_requests([](int32 id) {
     // pingProxy uses NetQueryDispatcher to get main_dc_id, so must be called after NetQueryDispatcher is created
@@ -3531,16 +3597,19 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
 
   VLOG(td_init) << "Create AuthManager";
   auth_manager_ = td::make_unique<AuthManager>(parameters.api_id_, parameters.api_hash_, create_reference());
-  auth_manager_actor_ = register_actor("AuthManager", auth_manager_.get());
+  auth_manager_actor_ = register_manager("AuthManager", auth_manager_.get());
   G()->set_auth_manager(auth_manager_actor_.get());
 
   init_file_manager();
 
   init_non_actor_managers();
 
+  startup_trace_.begin_phase("init managers");
   init_managers();
+  startup_trace_.end_phase();
 
   init_pure_actor_managers();
+  startup_trace_.add_step("init pure actor managers");
 
   secret_chats_manager_ =
       create_actor<SecretChatsManager>("SecretChatsManager", create_reference(), parameters.use_secret_chats_);
@@ -3548,8 +3617,14 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
 
   storage_manager_ = create_actor<StorageManager>("StorageManager", create_reference(), G()->get_gc_scheduler_id());
   G()->set_storage_manager(storage_manager_.get());
+  startup_trace_.add_step("create SecretChatsManager and StorageManager");
 
   option_manager_->on_td_inited();
+  on_update_coalescing_delay_changed();
+  startup_trace_.add_step("finish options initialization");
+
+  read_only_request_executor_ = std::make_shared<ReadOnlyRequestExecutor>(option_manager_->get_option_storage());
+  callback_->on_read_only_request_executor(read_only_request_executor_);
 
   if (is_online_) {
     on_online_updated(true, true);
@@ -3558,7 +3633,9 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
     set_is_bot_online(true);
   }
 
+  startup_trace_.begin_phase("process binlog events");
   process_binlog_events(std::move(events));
+  startup_trace_.end_phase();
 
   VLOG(td_init) << "Ping datacenter";
   if (!auth_manager_->is_authorized()) {
@@ -3572,6 +3649,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   complete_pending_preauthentication_requests([](int32 id) { return true; });
 
   VLOG(td_init) << "Finish initialization";
+  startup_trace_.end_phase();
 
   state_ = State::Run;
 
@@ -3584,27 +3662,31 @@ void Td::process_binlog_events(TdDb::OpenedDatabase &&events) {
   for (auto &event : events.user_events) {
     user_manager_->on_binlog_user_event(std::move(event));
   }
+  startup_trace_.add_step(PSLICE() << "replay " << events.user_events.size() << " user events");
 
   for (auto &event : events.channel_events) {
     chat_manager_->on_binlog_channel_event(std::move(event));
   }
+  startup_trace_.add_step(PSLICE() << "replay " << events.channel_events.size() << " channel events");
 
   // chats may contain links to channels, so should be inited after
   for (auto &event : events.chat_events) {
     chat_manager_->on_binlog_chat_event(std::move(event));
   }
+  startup_trace_.add_step(PSLICE() << "replay " << events.chat_events.size() << " chat events");
 
   for (auto &event : events.secret_chat_events) {
     user_manager_->on_binlog_secret_chat_event(std::move(event));
   }
+  startup_trace_.add_step(PSLICE() << "replay " << events.secret_chat_events.size() << " secret chat events");
 
   for (auto &event : events.web_page_events) {
     web_pages_manager_->on_binlog_web_page_event(std::move(event));
   }
+  startup_trace_.add_step(PSLICE() << "replay " << events.web_page_events.size() << " web page events");
 
-  for (auto &event : events.save_app_log_events) {
-    on_save_app_log_binlog_event(this, std::move(event));
-  }
+  defer_binlog_events(std::move(events.save_app_log_events));
+  startup_trace_.add_step(PSLICE() << "defer " << deferred_binlog_events_.size() << " binlog events");
 
   // Send binlog events to managers
   //
@@ -3643,6 +3725,42 @@ void Td::process_binlog_events(TdDb::OpenedDatabase &&events) {
                      std::move(events.to_notification_settings_manager));
 
   send_closure(secret_chats_manager_, &SecretChatsManager::binlog_replay_finish);
+  startup_trace_.add_step("send other binlog events to managers");
+}
+
+void Td::defer_binlog_events(vector<BinlogEvent> &&events) {
+  append(deferred_binlog_events_, std::move(events));
+}
+
+void Td::replay_deferred_binlog_events() {
+  if (close_flag_ || deferred_binlog_event_pos_ == deferred_binlog_events_.size()) {
+    return;
+  }
+
+  for (size_t count = 0;
+       count < MAX_DEFERRED_BINLOG_EVENT_REPLAY_COUNT && deferred_binlog_event_pos_ < deferred_binlog_events_.size();
+       count++) {
+    replay_deferred_binlog_event(std::move(deferred_binlog_events_[deferred_binlog_event_pos_++]));
+  }
+  if (deferred_binlog_event_pos_ == deferred_binlog_events_.size()) {
+    VLOG(td_init) << "Finish replay of " << deferred_binlog_event_pos_ << " deferred binlog events";
+    reset_to_empty(deferred_binlog_events_);
+    deferred_binlog_event_pos_ = 0;
+    return;
+  }
+
+  // allow other queries to be processed between batches of events
+  send_closure_later(actor_id(this), &Td::replay_deferred_binlog_events);
+}
+
+void Td::replay_deferred_binlog_event(BinlogEvent &&event) {
+  switch (static_cast<LogEvent::HandlerType>(event.type_)) {
+    case LogEvent::HandlerType::SaveAppLog:
+      on_save_app_log_binlog_event(this, std::move(event));
+      break;
+    default:
+      LOG(FATAL) << "Unsupported deferred binlog event type " << event.type_;
+  }
 }
 
 void Td::init_options_and_network() {
@@ -3712,7 +3830,14 @@ void Td::init_file_manager() {
       send_closure(G()->storage_manager(), &StorageManager::on_new_file, size, real_size, cnt);
     }
 
+    void on_file_accessed(const FullLocalFileLocation &location, int64 size) final {
+      send_closure(G()->storage_manager(), &StorageManager::on_file_accessed, location, size);
+    }
+
     void on_file_updated(FileId file_id) final {
+      if (td_->is_update_ignored(td_api::updateFile::ID)) {
+        return;
+      }
       send_closure(G()->td(), &Td::send_update,
                    make_tl_object<td_api::updateFile>(td_->file_manager_->get_file_object(file_id)));
     }
@@ -3755,12 +3880,12 @@ void Td::init_file_manager() {
   };
 
   file_manager_ = make_unique<FileManager>(make_unique<FileManagerContext>(this));
-  file_manager_actor_ = register_actor("FileManager", file_manager_.get());
+  file_manager_actor_ = register_manager("FileManager", file_manager_.get());
   file_manager_->init_actor();
   G()->set_file_manager(file_manager_actor_.get());
 
   file_reference_manager_ = make_unique<FileReferenceManager>(create_reference());
-  file_reference_manager_actor_ = register_actor("FileReferenceManager", file_reference_manager_.get());
+  file_reference_manager_actor_ = register_manager("FileReferenceManager", file_reference_manager_.get());
   G()->set_file_reference_manager(file_reference_manager_actor_.get());
 }
 
@@ -3770,145 +3895,138 @@ void Td::init_non_actor_managers() {
   callback_queries_manager_ = make_unique<CallbackQueriesManager>(this);
   documents_manager_ = make_unique<DocumentsManager>(this);
   videos_manager_ = make_unique<VideosManager>(this);
+  startup_trace_.add_step("init non-actor managers");
 }
 
 void Td::init_managers() {
   account_manager_ = make_unique<AccountManager>(this, create_reference());
-  account_manager_actor_ = register_actor("AccountManager", account_manager_.get());
+  account_manager_actor_ = register_manager("AccountManager", account_manager_.get());
   G()->set_account_manager(account_manager_actor_.get());
   animations_manager_ = make_unique<AnimationsManager>(this, create_reference());
-  animations_manager_actor_ = register_actor("AnimationsManager", animations_manager_.get());
+  animations_manager_actor_ = register_manager("AnimationsManager", animations_manager_.get());
   G()->set_animations_manager(animations_manager_actor_.get());
   attach_menu_manager_ = make_unique<AttachMenuManager>(this, create_reference());
-  attach_menu_manager_actor_ = register_actor("AttachMenuManager", attach_menu_manager_.get());
+  attach_menu_manager_actor_ = register_manager("AttachMenuManager", attach_menu_manager_.get());
   G()->set_attach_menu_manager(attach_menu_manager_actor_.get());
   autosave_manager_ = make_unique<AutosaveManager>(this, create_reference());
-  autosave_manager_actor_ = register_actor("AutosaveManager", autosave_manager_.get());
+  autosave_manager_actor_ = register_manager("AutosaveManager", autosave_manager_.get());
   G()->set_autosave_manager(autosave_manager_actor_.get());
   background_manager_ = make_unique<BackgroundManager>(this, create_reference());
-  background_manager_actor_ = register_actor("BackgroundManager", background_manager_.get());
+  background_manager_actor_ = register_manager("BackgroundManager", background_manager_.get());
   G()->set_background_manager(background_manager_actor_.get());
   boost_manager_ = make_unique<BoostManager>(this, create_reference());
-  boost_manager_actor_ = register_actor("BoostManager", boost_manager_.get());
+  boost_manager_actor_ = register_manager("BoostManager", boost_manager_.get());
   G()->set_boost_manager(boost_manager_actor_.get());
   bot_info_manager_ = make_unique<BotInfoManager>(this, create_reference());
-  bot_info_manager_actor_ = register_actor("BotInfoManager", bot_info_manager_.get());
+  bot_info_manager_actor_ = register_manager("BotInfoManager", bot_info_manager_.get());
   business_connection_manager_ = make_unique<BusinessConnectionManager>(this, create_reference());
-  business_connection_manager_actor_ = register_actor("BusinessConnectionManager", business_connection_manager_.get());
+  business_connection_manager_actor_ =
+      register_manager("BusinessConnectionManager", business_connection_manager_.get());
   G()->set_business_connection_manager(business_connection_manager_actor_.get());
   business_manager_ = make_unique<BusinessManager>(this, create_reference());
-  business_manager_actor_ = register_actor("BusinessManager", business_manager_.get());
+  business_manager_actor_ = register_manager("BusinessManager", business_manager_.get());
   G()->set_business_manager(business_manager_actor_.get());
-  channel_recommendation_manager_ = make_unique<ChannelRecommendationManager>(this, create_reference());
-  channel_recommendation_manager_actor_ =
-      register_actor("ChannelRecommendationManager", channel_recommendation_manager_.get());
   common_dialog_manager_ = make_unique<CommonDialogManager>(this, create_reference());
-  common_dialog_manager_actor_ = register_actor("CommonDialogManager", common_dialog_manager_.get());
+  common_dialog_manager_actor_ = register_manager("CommonDialogManager", common_dialog_manager_.get());
   chat_manager_ = make_unique<ChatManager>(this, create_reference());
-  chat_manager_actor_ = register_actor("ChatManager", chat_manager_.get());
+  chat_manager_actor_ = register_manager("ChatManager", chat_manager_.get());
   G()->set_chat_manager(chat_manager_actor_.get());
   country_info_manager_ = make_unique<CountryInfoManager>(this, create_reference());
-  country_info_manager_actor_ = register_actor("CountryInfoManager", country_info_manager_.get());
+  country_info_manager_actor_ = register_manager("CountryInfoManager", country_info_manager_.get());
   dialog_action_manager_ = make_unique<DialogActionManager>(this, create_reference());
-  dialog_action_manager_actor_ = register_actor("DialogActionManager", dialog_action_manager_.get());
+  dialog_action_manager_actor_ = register_manager("DialogActionManager", dialog_action_manager_.get());
   G()->set_dialog_action_manager(dialog_action_manager_actor_.get());
   dialog_filter_manager_ = make_unique<DialogFilterManager>(this, create_reference());
-  dialog_filter_manager_actor_ = register_actor("DialogFilterManager", dialog_filter_manager_.get());
+  dialog_filter_manager_actor_ = register_manager("DialogFilterManager", dialog_filter_manager_.get());
   G()->set_dialog_filter_manager(dialog_filter_manager_actor_.get());
   dialog_invite_link_manager_ = make_unique<DialogInviteLinkManager>(this, create_reference());
-  dialog_invite_link_manager_actor_ = register_actor("DialogInviteLinkManager", dialog_invite_link_manager_.get());
+  dialog_invite_link_manager_actor_ = register_manager("DialogInviteLinkManager", dialog_invite_link_manager_.get());
   G()->set_dialog_invite_link_manager(dialog_invite_link_manager_actor_.get());
   dialog_manager_ = make_unique<DialogManager>(this, create_reference());
-  dialog_manager_actor_ = register_actor("DialogManager", dialog_manager_.get());
+  dialog_manager_actor_ = register_manager("DialogManager", dialog_manager_.get());
   G()->set_dialog_manager(dialog_manager_actor_.get());
   dialog_participant_manager_ = make_unique<DialogParticipantManager>(this, create_reference());
-  dialog_participant_manager_actor_ = register_actor("DialogParticipantManager", dialog_participant_manager_.get());
+  dialog_participant_manager_actor_ = register_manager("DialogParticipantManager", dialog_participant_manager_.get());
   G()->set_dialog_participant_manager(dialog_participant_manager_actor_.get());
   download_manager_ = DownloadManager::create(td::make_unique<DownloadManagerCallback>(this, create_reference()));
-  download_manager_actor_ = register_actor("DownloadManager", download_manager_.get());
+  download_manager_actor_ = register_manager("DownloadManager", download_manager_.get());
   G()->set_download_manager(download_manager_actor_.get());
   forum_topic_manager_ = make_unique<ForumTopicManager>(this, create_reference());
-  forum_topic_manager_actor_ = register_actor("ForumTopicManager", forum_topic_manager_.get());
+  forum_topic_manager_actor_ = register_manager("ForumTopicManager", forum_topic_manager_.get());
   G()->set_forum_topic_manager(forum_topic_manager_actor_.get());
   game_manager_ = make_unique<GameManager>(this, create_reference());
-  game_manager_actor_ = register_actor("GameManager", game_manager_.get());
+  game_manager_actor_ = register_manager("GameManager", game_manager_.get());
   G()->set_game_manager(game_manager_actor_.get());
   group_call_manager_ = make_unique<GroupCallManager>(this, create_reference());
-  group_call_manager_actor_ = register_actor("GroupCallManager", group_call_manager_.get());
+  group_call_manager_actor_ = register_manager("GroupCallManager", group_call_manager_.get());
   G()->set_group_call_manager(group_call_manager_actor_.get());
   inline_queries_manager_ = make_unique<InlineQueriesManager>(this, create_reference());
-  inline_queries_manager_actor_ = register_actor("InlineQueriesManager", inline_queries_manager_.get());
+  inline_queries_manager_actor_ = register_manager("InlineQueriesManager", inline_queries_manager_.get());
   link_manager_ = make_unique<LinkManager>(this, create_reference());
-  link_manager_actor_ = register_actor("LinkManager", link_manager_.get());
+  link_manager_actor_ = register_manager("LinkManager", link_manager_.get());
   G()->set_link_manager(link_manager_actor_.get());
   message_import_manager_ = make_unique<MessageImportManager>(this, create_reference());
-  message_import_manager_actor_ = register_actor("MessageImportManager", message_import_manager_.get());
+  message_import_manager_actor_ = register_manager("MessageImportManager", message_import_manager_.get());
   G()->set_message_import_manager(message_import_manager_actor_.get());
   messages_manager_ = make_unique<MessagesManager>(this, create_reference());
-  messages_manager_actor_ = register_actor("MessagesManager", messages_manager_.get());
+  messages_manager_actor_ = register_manager("MessagesManager", messages_manager_.get());
   G()->set_messages_manager(messages_manager_actor_.get());
   notification_manager_ = make_unique<NotificationManager>(this, create_reference());
-  notification_manager_actor_ = register_actor("NotificationManager", notification_manager_.get());
+  notification_manager_actor_ = register_manager("NotificationManager", notification_manager_.get());
   G()->set_notification_manager(notification_manager_actor_.get());
   notification_settings_manager_ = make_unique<NotificationSettingsManager>(this, create_reference());
   notification_settings_manager_actor_ =
-      register_actor("NotificationSettingsManager", notification_settings_manager_.get());
+      register_manager("NotificationSettingsManager", notification_settings_manager_.get());
   G()->set_notification_settings_manager(notification_settings_manager_actor_.get());
   people_nearby_manager_ = make_unique<PeopleNearbyManager>(this, create_reference());
-  people_nearby_manager_actor_ = register_actor("PeopleNearbyManager", people_nearby_manager_.get());
+  people_nearby_manager_actor_ = register_manager("PeopleNearbyManager", people_nearby_manager_.get());
   G()->set_people_nearby_manager(people_nearby_manager_actor_.get());
-  phone_number_manager_ = make_unique<PhoneNumberManager>(this, create_reference());
-  phone_number_manager_actor_ = register_actor("PhoneNumberManager", phone_number_manager_.get());
   poll_manager_ = make_unique<PollManager>(this, create_reference());
-  poll_manager_actor_ = register_actor("PollManager", poll_manager_.get());
+  poll_manager_actor_ = register_manager("PollManager", poll_manager_.get());
   privacy_manager_ = make_unique<PrivacyManager>(this, create_reference());
-  privacy_manager_actor_ = register_actor("PrivacyManager", privacy_manager_.get());
+  privacy_manager_actor_ = register_manager("PrivacyManager", privacy_manager_.get());
   quick_reply_manager_ = make_unique<QuickReplyManager>(this, create_reference());
-  quick_reply_manager_actor_ = register_actor("QuickReplyManager", quick_reply_manager_.get());
+  quick_reply_manager_actor_ = register_manager("QuickReplyManager", quick_reply_manager_.get());
   G()->set_quick_reply_manager(quick_reply_manager_actor_.get());
   reaction_manager_ = make_unique<ReactionManager>(this, create_reference());
-  reaction_manager_actor_ = register_actor("ReactionManager", reaction_manager_.get());
+  reaction_manager_actor_ = register_manager("ReactionManager", reaction_manager_.get());
   G()->set_reaction_manager(reaction_manager_actor_.get());
   saved_messages_manager_ = make_unique<SavedMessagesManager>(this, create_reference());
-  saved_messages_manager_actor_ = register_actor("SavedMessagesManager", saved_messages_manager_.get());
+  saved_messages_manager_actor_ = register_manager("SavedMessagesManager", saved_messages_manager_.get());
   G()->set_saved_messages_manager(saved_messages_manager_actor_.get());
   sponsored_message_manager_ = make_unique<SponsoredMessageManager>(this, create_reference());
-  sponsored_message_manager_actor_ = register_actor("SponsoredMessageManager", sponsored_message_manager_.get());
+  sponsored_message_manager_actor_ = register_manager("SponsoredMessageManager", sponsored_message_manager_.get());
   G()->set_sponsored_message_manager(sponsored_message_manager_actor_.get());
-  statistics_manager_ = make_unique<StatisticsManager>(this, create_reference());
-  statistics_manager_actor_ = register_actor("StatisticsManager", statistics_manager_.get());
   stickers_manager_ = make_unique<StickersManager>(this, create_reference());
-  stickers_manager_actor_ = register_actor("StickersManager", stickers_manager_.get());
+  stickers_manager_actor_ = register_manager("StickersManager", stickers_manager_.get());
   G()->set_stickers_manager(stickers_manager_actor_.get());
   story_manager_ = make_unique<StoryManager>(this, create_reference());
-  story_manager_actor_ = register_actor("StoryManager", story_manager_.get());
+  story_manager_actor_ = register_manager("StoryManager", story_manager_.get());
   G()->set_story_manager(story_manager_actor_.get());
   theme_manager_ = make_unique<ThemeManager>(this, create_reference());
-  theme_manager_actor_ = register_actor("ThemeManager", theme_manager_.get());
+  theme_manager_actor_ = register_manager("ThemeManager", theme_manager_.get());
   G()->set_theme_manager(theme_manager_actor_.get());
   time_zone_manager_ = make_unique<TimeZoneManager>(this, create_reference());
-  time_zone_manager_actor_ = register_actor("TimeZoneManager", time_zone_manager_.get());
+  time_zone_manager_actor_ = register_manager("TimeZoneManager", time_zone_manager_.get());
   G()->set_time_zone_manager(time_zone_manager_actor_.get());
   top_dialog_manager_ = make_unique<TopDialogManager>(this, create_reference());
-  top_dialog_manager_actor_ = register_actor("TopDialogManager", top_dialog_manager_.get());
+  top_dialog_manager_actor_ = register_manager("TopDialogManager", top_dialog_manager_.get());
   G()->set_top_dialog_manager(top_dialog_manager_actor_.get());
   transcription_manager_ = make_unique<TranscriptionManager>(this, create_reference());
-  transcription_manager_actor_ = register_actor("TranscriptionManager", transcription_manager_.get());
+  transcription_manager_actor_ = register_manager("TranscriptionManager", transcription_manager_.get());
   G()->set_transcription_manager(transcription_manager_actor_.get());
-  translation_manager_ = make_unique<TranslationManager>(this, create_reference());
-  translation_manager_actor_ = register_actor("TranslationManager", translation_manager_.get());
   updates_manager_ = make_unique<UpdatesManager>(this, create_reference());
-  updates_manager_actor_ = register_actor("UpdatesManager", updates_manager_.get());
+  updates_manager_actor_ = register_manager("UpdatesManager", updates_manager_.get());
   G()->set_updates_manager(updates_manager_actor_.get());
   user_manager_ = make_unique<UserManager>(this, create_reference());
-  user_manager_actor_ = register_actor("UserManager", user_manager_.get());
+  user_manager_actor_ = register_manager("UserManager", user_manager_.get());
   G()->set_user_manager(user_manager_actor_.get());
   video_notes_manager_ = make_unique<VideoNotesManager>(this, create_reference());
-  video_notes_manager_actor_ = register_actor("VideoNotesManager", video_notes_manager_.get());
+  video_notes_manager_actor_ = register_manager("VideoNotesManager", video_notes_manager_.get());
   voice_notes_manager_ = make_unique<VoiceNotesManager>(this, create_reference());
-  voice_notes_manager_actor_ = register_actor("VoiceNotesManager", voice_notes_manager_.get());
+  voice_notes_manager_actor_ = register_manager("VoiceNotesManager", voice_notes_manager_.get());
   web_pages_manager_ = make_unique<WebPagesManager>(this, create_reference());
-  web_pages_manager_actor_ = register_actor("WebPagesManager", web_pages_manager_.get());
+  web_pages_manager_actor_ = register_manager("WebPagesManager", web_pages_manager_.get());
   G()->set_web_pages_manager(web_pages_manager_actor_.get());
 }
 
@@ -3926,11 +4044,15 @@ void Td::init_pure_actor_managers() {
 
 void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
   CHECK(object != nullptr);
+  TraceSpan trace_span("Td::send_update");
   auto object_id = object->get_id();
   if (close_flag_ >= 5 && object_id != td_api::updateAuthorizationState::ID) {
     // just in case
     return;
   }
+  if (is_update_ignored(object_id)) {
+    return;
+  }
 
   switch (object_id) {
     case td_api::updateAccentColors::ID:
@@ -3965,9 +4087,104 @@ void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
       VLOG(td_requests) << "Sending update: " << to_string(object);
   }
 
+  if (object_id == td_api::updateAuthorizationState::ID &&
+      static_cast<const td_api::updateAuthorizationState *>(object.get())->authorization_state_->get_id() ==
+          td_api::authorizationStateReady::ID) {
+    if (!startup_trace_.is_finished()) {
+      startup_trace_.finish("authorizationStateReady");
+    }
+    if (!deferred_binlog_events_.empty()) {
+      send_closure_later(actor_id(this), &Td::replay_deferred_binlog_events);
+    }
+  }
+
+  if (update_coalescing_delay_ > 0 && object_id != td_api::updateAuthorizationState::ID) {
+    return add_pending_update(std::move(object));
+  }
+  flush_pending_updates();
   callback_->on_result(0, std::move(object));
 }
 
+size_t Td::get_pending_update_count() const {
+  return callback_ == nullptr ? 0 : callback_->get_pending_update_count();
+}
+
+void Td::on_update_coalescing_delay_changed() {
+  update_coalescing_delay_ =
+      static_cast<double>(option_manager_->get_option_integer("update_coalescing_delay_ms")) * 1e-3;
+  if (update_coalescing_delay_ <= 0) {
+    flush_pending_updates();
+  }
+}
+
+Td::PendingUpdateKey Td::get_pending_update_key(const td_api::Update &update) {
+  PendingUpdateKey key;
+  switch (update.get_id()) {
+    case td_api::updateChatLastMessage::ID:
+      key.object_id = static_cast<const td_api::updateChatLastMessage &>(update).chat_id_;
+      break;
+    case td_api::updateChatReadInbox::ID:
+      key.object_id = static_cast<const td_api::updateChatReadInbox &>(update).chat_id_;
+      break;
+    case td_api::updateChatReadOutbox::ID:
+      key.object_id = static_cast<const td_api::updateChatReadOutbox &>(update).chat_id_;
+      break;
+    case td_api::updateChatUnreadMentionCount::ID:
+      key.object_id = static_cast<const td_api::updateChatUnreadMentionCount &>(update).chat_id_;
+      break;
+    case td_api::updateChatUnreadReactionCount::ID:
+      key.object_id = static_cast<const td_api::updateChatUnreadReactionCount &>(update).chat_id_;
+      break;
+    case td_api::updateMessageInteractionInfo::ID: {
+      const auto &update_info = static_cast<const td_api::updateMessageInteractionInfo &>(update);
+      key.object_id = update_info.chat_id_;
+      key.sub_object_id = update_info.message_id_;
+      break;
+    }
+    case td_api::updateUserStatus::ID:
+      key.object_id = static_cast<const td_api::updateUserStatus &>(update).user_id_;
+      break;
+    case td_api::updateFile::ID:
+      key.object_id = static_cast<const td_api::updateFile &>(update).file_->id_;
+      break;
+    default:
+      return key;
+  }
+  key.update_id = update.get_id();
+  return key;
+}
+
+void Td::add_pending_update(tl_object_ptr<td_api::Update> &&object) {
+  auto key = get_pending_update_key(*object);
+  if (key.update_id != 0) {
+    // the previous update is superseded; the new update is sent in its own place to preserve order with other updates
+    auto &position = pending_update_positions_[key];
+    if (position != 0) {
+      pending_updates_[position - 1] = nullptr;
+    }
+    position = pending_updates_.size() + 1;
+  }
+  if (pending_updates_.empty()) {
+    alarm_timeout_.set_timeout_in(FLUSH_UPDATES_ALARM_ID, update_coalescing_delay_);
+  }
+  pending_updates_.push_back(std::move(object));
+}
+
+void Td::flush_pending_updates() {
+  if (pending_updates_.empty()) {
+    return;
+  }
+  alarm_timeout_.cancel_timeout(FLUSH_UPDATES_ALARM_ID);
+  auto updates = std::move(pending_updates_);
+  pending_updates_.clear();
+  pending_update_positions_.clear();
+  for (auto &update : updates) {
+    if (update != nullptr) {
+      callback_->on_result(0, std::move(update));
+    }
+  }
+}
+
 void Td::send_result(uint64 id, tl_object_ptr<td_api::Object> object) {
   if (id == 0) {
     LOG(ERROR) << "Sending " << to_string(object) << " through send_result";
@@ -3981,6 +4198,9 @@ void Td::send_result(uint64 id, tl_object_ptr<td_api::Object> object) {
     }
     VLOG(td_requests) << "Sending result for request " << id << ": " << to_string(object);
     request_set_.erase(it);
+    TraceSpan trace_span("Td::send_result");
+    // all updates must be sent before the result
+    flush_pending_updates();
     callback_->on_result(id, std::move(object));
   }
 }
@@ -3995,6 +4215,7 @@ void Td::send_error_impl(uint64 id, tl_object_ptr<td_api::error> error) {
     }
     VLOG(td_requests) << "Sending error for request " << id << ": " << oneline(to_string(error));
     request_set_.erase(it);
+    flush_pending_updates();
     callback_->on_error(id, std::move(error));
   }
 }
@@ -4081,6 +4302,8 @@ Result<std::pair<Td::Parameters, TdDb::Parameters>> Td::get_parameters(
   result.second.use_file_database_ = parameters->use_file_database_;
   result.second.use_chat_info_database_ = parameters->use_chat_info_database_;
   result.second.use_message_database_ = parameters->use_message_database_;
+  result.second.sqlite_settings_ = database_settings_;
+  result.second.compress_message_data_ = compress_message_data_;
 
   VLOG(td_init) << "Create MtprotoHeader::Options";
   options_.api_id = parameters->api_id_;
@@ -4218,6 +4441,11 @@ void Td::on_request(uint64 id, const td_api::destroy &request) {
   send_closure(actor_id(this), &Td::destroy);
 }
 
+void Td::on_request(uint64 id, const td_api::hibernate &request) {
+  // hibernation is implemented by the owner of the Td actor, which destroys and recreates it
+  send_error_raw(id, 400, "Hibernation isn't supported by the TDLib interface");
+}
+
 void Td::on_request(uint64 id, td_api::checkAuthenticationBotToken &request) {
   CLEAN_INPUT_STRING(request.token_);
   send_closure(auth_manager_actor_, &AuthManager::check_bot_token, id, std::move(request.token_));
@@ -4296,6 +4524,41 @@ void Td::on_request(uint64 id, const td_api::getCurrentState &request) {
   send_result(id, td_api::make_object<td_api::updates>(std::move(updates)));
 }
 
+void Td::on_request(uint64 id, const td_api::setUpdateFilter &request) {
+  FlatHashSet<int32> ignored_update_ids;
+  for (auto update_id : request.ignored_update_ids_) {
+    if (update_id == 0) {
+      return send_error_raw(id, 400, "Invalid update identifier specified");
+    }
+    if (update_id == td_api::updateAuthorizationState::ID) {
+      return send_error_raw(id, 400, "Update updateAuthorizationState can't be ignored");
+    }
+    ignored_update_ids.insert(update_id);
+  }
+  ignored_update_ids_ = std::move(ignored_update_ids);
+  send_result(id, td_api::make_object<td_api::ok>());
+}
+
+void Td::on_request(uint64 id, td_api::setDatabaseSettings &request) {
+  if (state_ != State::WaitParameters) {
+    return send_error_raw(id, 400, "Database settings can be changed only before setTdlibParameters");
+  }
+  SqliteDbSettings settings;
+  settings.cache_size_kb = request.cache_size_;
+  settings.mmap_size = request.mmap_size_;
+  settings.synchronous = std::move(request.synchronous_);
+  settings.temp_store = std::move(request.temp_store_);
+  settings.wal_autocheckpoint = request.wal_autocheckpoint_;
+  settings.page_size = request.page_size_;
+  auto status = settings.check();
+  if (status.is_error()) {
+    return send_error_raw(id, 400, status.message());
+  }
+  database_settings_ = std::move(settings);
+  compress_message_data_ = request.compress_message_data_;
+  send_result(id, td_api::make_object<td_api::ok>());
+}
+
 void Td::on_request(uint64 id, td_api::getPasswordState &request) {
   CHECK_IS_USER();
   CREATE_REQUEST_PROMISE();
@@ -4840,6 +5103,53 @@ void Td::on_request(uint64 id, td_api::getDatabaseStatistics &request) {
   send_closure(storage_manager_, &StorageManager::get_database_stats, std::move(query_promise));
 }
 
+void Td::on_request(uint64 id, const td_api::optimizeDatabase &request) {
+  CREATE_REQUEST_PROMISE();
+  auto query_promise = PromiseCreator::lambda([promise = std::move(promise)](Result<DatabaseStats> result) mutable {
+    if (result.is_error()) {
+      promise.set_error(result.move_as_error());
+    } else {
+      promise.set_value(result.ok().get_database_statistics_object());
+    }
+  });
+  send_closure(storage_manager_, &StorageManager::optimize_database, request.allow_full_vacuum_,
+               std::move(query_promise));
+}
+
+void Td::on_request(uint64 id, const td_api::getMemoryStatistics &request) {
+  vector<string> output;
+  HashTableMemoryUsage hash_table_usage;
+  user_manager_->memory_stats(output, hash_table_usage);
+  chat_manager_->memory_stats(output, hash_table_usage);
+  messages_manager_->memory_stats(output, hash_table_usage);
+  stickers_manager_->memory_stats(output, hash_table_usage);
+  web_pages_manager_->memory_stats(output, hash_table_usage);
+  output.push_back(PSTRING() << "Total hash tables: " << hash_table_usage);
+  output.push_back(PSTRING() << "Updates waiting to be received: " << get_pending_update_count());
+  output.push_back(get_interned_string_stats());
+  output.push_back(BufferAllocator::get_buffer_mem_stats());
+  if (AllocationTags::is_enabled()) {
+    output.push_back("Allocations by actor:\n" + AllocationTags::get_top_tags_string(50));
+  }
+  send_result(id, td_api::make_object<td_api::memoryStatistics>(implode(output, '\n')));
+}
+
+void Td::on_request(uint64 id, const td_api::getNetworkRequestLatencyStatistics &request) {
+  string statistics;
+  if (td_options_.net_query_stats != nullptr) {
+    statistics = td_options_.net_query_stats->get_latency_statistics();
+  }
+  send_result(id, td_api::make_object<td_api::networkRequestLatencyStatistics>(std::move(statistics)));
+}
+
+void Td::on_request(uint64 id, const td_api::getStorageLatencyStatistics &request) {
+  send_result(id, td_api::make_object<td_api::storageLatencyStatistics>(LatencyHistogram::get_statistics()));
+}
+
+void Td::on_request(uint64 id, const td_api::getStartupStatistics &request) {
+  send_result(id, td_api::make_object<td_api::startupStatistics>(startup_trace_.get_statistics()));
+}
+
 void Td::on_request(uint64 id, td_api::optimizeStorage &request) {
   std::vector<FileType> file_types;
   for (auto &file_type : request.file_types_) {
@@ -9650,10 +9960,26 @@ void Td::on_request(uint64 id, const td_api::getLogTagVerbosityLevel &request) {
   UNREACHABLE();
 }
 
+void Td::on_request(uint64 id, const td_api::setLogTagRateLimit &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getLogTagRateLimit &request) {
+  UNREACHABLE();
+}
+
 void Td::on_request(uint64 id, const td_api::addLogMessage &request) {
   UNREACHABLE();
 }
 
+void Td::on_request(uint64 id, const td_api::toggleTraceSpans &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getTraceSpans &request) {
+  UNREACHABLE();
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(td_api::searchQuote &request) {
   if (request.text_ == nullptr || request.quote_ == nullptr) {
     return make_error(400, "Text and quote must be non-empty");
@@ -9923,11 +10249,40 @@ td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getLogTag
   }
 }
 
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::setLogTagRateLimit &request) {
+  auto result =
+      Logging::set_tag_rate_limit(request.tag_, request.max_message_count_per_second_, request.sampling_rate_);
+  if (result.is_ok()) {
+    return td_api::make_object<td_api::ok>();
+  } else {
+    return make_error(400, result.message());
+  }
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getLogTagRateLimit &request) {
+  auto result = Logging::get_tag_rate_limit(request.tag_);
+  if (result.is_ok()) {
+    auto limit = result.ok();
+    return td_api::make_object<td_api::logRateLimit>(limit.max_count_per_second, limit.sampling_rate);
+  } else {
+    return make_error(400, result.error().message());
+  }
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::addLogMessage &request) {
   Logging::add_message(request.verbosity_level_, request.text_);
   return td_api::make_object<td_api::ok>();
 }
 
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::toggleTraceSpans &request) {
+  TraceSpans::set_enabled(request.is_enabled_);
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getTraceSpans &request) {
+  return td_api::make_object<td_api::text>(TraceSpans::get_chrome_trace());
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(td_api::testReturnError &request) {
   if (request.error_ == nullptr) {
     return td_api::make_object<td_api::error>(404, "Not Found");
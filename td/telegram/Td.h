@@ -11,6 +11,7 @@
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/NetQueryStats.h"
+#include "td/telegram/StartupTrace.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/TdCallback.h"
 #include "td/telegram/TdDb.h"
@@ -26,6 +27,8 @@
 #include "td/utils/common.h"
 #include "td/utils/Container.h"
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
@@ -85,6 +88,7 @@ class PollManager;
 class PrivacyManager;
 class QuickReplyManager;
 class ReactionManager;
+class ReadOnlyRequestExecutor;
 class SavedMessagesManager;
 class SecureManager;
 class SecretChatsManager;
@@ -132,7 +136,8 @@ class Td final : public Actor {
 
   Td(unique_ptr<TdCallback> callback, Options options);
 
-  void request(uint64 id, tl_object_ptr<td_api::Function> function);
+  // deadline is the time in the Time::now() scale, after which the request must not be executed, or 0 if none
+  void request(uint64 id, tl_object_ptr<td_api::Function> function, double deadline);
 
   void destroy();
 
@@ -160,6 +165,52 @@ class Td final : public Actor {
 
   bool ignore_background_updates() const;
 
+  ConnectionState get_connection_state() const {
+    return connection_state_;
+  }
+
+  // rarely used manager, which is created on first access
+  template <class ManagerT>
+  class LazyManager {
+   public:
+    LazyManager(Td *td, Slice name) : td_(td), name_(name) {
+    }
+
+    ManagerT *get() {
+      if (manager_ == nullptr) {
+        create();
+      }
+      return manager_.get();
+    }
+
+    ManagerT *operator->() {
+      return get();
+    }
+
+    ActorOwn<Actor> release_actor() {
+      return ActorOwn<Actor>(std::move(actor_));
+    }
+
+    void reset() {
+      manager_.reset();
+    }
+
+   private:
+    Td *td_;
+    Slice name_;
+    unique_ptr<ManagerT> manager_;
+    ActorOwn<ManagerT> actor_;
+
+    void create() {
+      manager_ = make_unique<ManagerT>(td_, td_->create_reference());
+      actor_ = register_actor(name_, manager_.get());
+      if (td_->close_flag_ >= 2) {
+        // all actors have already been closed
+        actor_.reset();
+      }
+    }
+  };
+
   unique_ptr<AudiosManager> audios_manager_;
   unique_ptr<CallbackQueriesManager> callback_queries_manager_;
   unique_ptr<DocumentsManager> documents_manager_;
@@ -186,8 +237,7 @@ class Td final : public Actor {
   ActorOwn<BusinessConnectionManager> business_connection_manager_actor_;
   unique_ptr<BusinessManager> business_manager_;
   ActorOwn<BusinessManager> business_manager_actor_;
-  unique_ptr<ChannelRecommendationManager> channel_recommendation_manager_;
-  ActorOwn<ChannelRecommendationManager> channel_recommendation_manager_actor_;
+  LazyManager<ChannelRecommendationManager> channel_recommendation_manager_;
   unique_ptr<ChatManager> chat_manager_;
   ActorOwn<ChatManager> chat_manager_actor_;
   unique_ptr<CommonDialogManager> common_dialog_manager_;
@@ -234,8 +284,7 @@ class Td final : public Actor {
   ActorOwn<PrivacyManager> privacy_manager_actor_;
   unique_ptr<PeopleNearbyManager> people_nearby_manager_;
   ActorOwn<PeopleNearbyManager> people_nearby_manager_actor_;
-  unique_ptr<PhoneNumberManager> phone_number_manager_;
-  ActorOwn<PhoneNumberManager> phone_number_manager_actor_;
+  LazyManager<PhoneNumberManager> phone_number_manager_;
   unique_ptr<QuickReplyManager> quick_reply_manager_;
   ActorOwn<QuickReplyManager> quick_reply_manager_actor_;
   unique_ptr<ReactionManager> reaction_manager_;
@@ -244,8 +293,7 @@ class Td final : public Actor {
   ActorOwn<SavedMessagesManager> saved_messages_manager_actor_;
   unique_ptr<SponsoredMessageManager> sponsored_message_manager_;
   ActorOwn<SponsoredMessageManager> sponsored_message_manager_actor_;
-  unique_ptr<StatisticsManager> statistics_manager_;
-  ActorOwn<StatisticsManager> statistics_manager_actor_;
+  LazyManager<StatisticsManager> statistics_manager_;
   unique_ptr<StickersManager> stickers_manager_;
   ActorOwn<StickersManager> stickers_manager_actor_;
   unique_ptr<StoryManager> story_manager_;
@@ -258,8 +306,7 @@ class Td final : public Actor {
   ActorOwn<TopDialogManager> top_dialog_manager_actor_;
   unique_ptr<TranscriptionManager> transcription_manager_;
   ActorOwn<TranscriptionManager> transcription_manager_actor_;
-  unique_ptr<TranslationManager> translation_manager_;
-  ActorOwn<TranslationManager> translation_manager_actor_;
+  LazyManager<TranslationManager> translation_manager_;
   unique_ptr<UpdatesManager> updates_manager_;
   ActorOwn<UpdatesManager> updates_manager_actor_;
   unique_ptr<UserManager> user_manager_;
@@ -303,11 +350,32 @@ class Td final : public Actor {
    protected:
     void send_query(NetQueryPtr query);
 
+    // fetches a big query result on another scheduler to keep the Td scheduler free for other work
+    // on_fetched is always called on the Td scheduler
+    template <class T, class HandlerT>
+    void fetch_result_async(BufferSlice packet, void (HandlerT::*on_fetched)(Result<typename T::ReturnType>)) {
+      if (packet.size() < MIN_ASYNC_FETCH_PACKET_SIZE) {
+        return (static_cast<HandlerT *>(this)->*on_fetched)(fetch_result<T>(packet));
+      }
+      run_on_fetch_scheduler(PromiseCreator::lambda(
+          [handler = std::static_pointer_cast<HandlerT>(shared_from_this()), td_actor_id = td_->actor_id(td_),
+           packet = std::move(packet), on_fetched](Unit) mutable {
+            auto result = fetch_result<T>(packet);
+            send_lambda(td_actor_id, [handler = std::move(handler), result = std::move(result), on_fetched]() mutable {
+              ((*handler).*on_fetched)(std::move(result));
+            });
+          }));
+    }
+
     Td *td_ = nullptr;
     bool is_query_sent_ = false;
 
    private:
+    static constexpr size_t MIN_ASYNC_FETCH_PACKET_SIZE = 1 << 16;
+
     void set_td(Td *td);
+
+    static void run_on_fetch_scheduler(Promise<Unit> action);
   };
 
   template <class HandlerT, class... Args>
@@ -324,6 +392,27 @@ class Td final : public Actor {
 
   void send_update(tl_object_ptr<td_api::Update> &&object);
 
+  // returns the number of updates and responses, which weren't received by the application yet
+  size_t get_pending_update_count() const;
+
+  bool is_update_ignored(int32 update_id) const {
+    return !ignored_update_ids_.empty() && ignored_update_ids_.count(update_id) != 0;
+  }
+
+  void on_update_coalescing_delay_changed();
+
+  double get_current_request_deadline() const {
+    return current_request_deadline_;
+  }
+
+  NetQuery::PriorityClass get_current_request_priority_class() const {
+    return current_request_priority_class_;
+  }
+
+  int64 get_shed_request_count() const {
+    return shed_request_count_;
+  }
+
   static td_api::object_ptr<td_api::Object> static_request(td_api::object_ptr<td_api::Function> function);
 
  private:
@@ -332,11 +421,15 @@ class Td final : public Actor {
   static constexpr int32 PING_SERVER_TIMEOUT = 300;
   static constexpr int64 TERMS_OF_SERVICE_ALARM_ID = -2;
   static constexpr int64 PROMO_DATA_ALARM_ID = -3;
+  static constexpr int64 FLUSH_UPDATES_ALARM_ID = -4;
+  static constexpr size_t MAX_DEFERRED_BINLOG_EVENT_REPLAY_COUNT = 100;
 
   void on_connection_state_changed(ConnectionState new_state);
 
   void run_request(uint64 id, tl_object_ptr<td_api::Function> function);
 
+  NetQuery::PriorityClass get_request_priority_class() const;
+
   void send_result(uint64 id, tl_object_ptr<td_api::Object> object);
   void send_error(uint64 id, Status error);
   void send_error_impl(uint64 id, tl_object_ptr<td_api::error> error);
@@ -379,6 +472,50 @@ class Td final : public Actor {
 
   bool can_ignore_background_updates_ = false;
 
+  FlatHashSet<int32> ignored_update_ids_;
+
+  SqliteDbSettings database_settings_;
+  bool compress_message_data_ = false;
+
+  std::shared_ptr<ReadOnlyRequestExecutor> read_only_request_executor_;
+
+  double current_request_deadline_ = 0.0;
+  NetQuery::PriorityClass current_request_priority_class_ = NetQuery::PriorityClass::Normal;
+  int64 shed_request_count_ = 0;
+
+  // the object identifiers, whose state is fully described by an update of the given type
+  struct PendingUpdateKey {
+    int32 update_id = 0;
+    int64 object_id = 0;
+    int64 sub_object_id = 0;
+
+    bool operator==(const PendingUpdateKey &other) const {
+      return update_id == other.update_id && object_id == other.object_id && sub_object_id == other.sub_object_id;
+    }
+  };
+  struct PendingUpdateKeyHash {
+    uint32 operator()(const PendingUpdateKey &key) const {
+      return combine_hashes(combine_hashes(Hash<int32>()(key.update_id), Hash<int64>()(key.object_id)),
+                            Hash<int64>()(key.sub_object_id));
+    }
+  };
+
+  StartupTrace startup_trace_;
+
+  // binlog events, which aren't needed for consistency of the state and are replayed after authorization
+  vector<BinlogEvent> deferred_binlog_events_;
+  size_t deferred_binlog_event_pos_ = 0;
+
+  double update_coalescing_delay_ = 0.0;
+  vector<tl_object_ptr<td_api::Update>> pending_updates_;
+  FlatHashMap<PendingUpdateKey, size_t, PendingUpdateKeyHash> pending_update_positions_;  // position + 1
+
+  static PendingUpdateKey get_pending_update_key(const td_api::Update &update);
+
+  void add_pending_update(tl_object_ptr<td_api::Update> &&object);
+
+  void flush_pending_updates();
+
   bool reloading_promo_data_ = false;
   bool need_reload_promo_data_ = false;
 
@@ -509,6 +646,8 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::destroy &request);
 
+  void on_request(uint64 id, const td_api::hibernate &request);
+
   void on_request(uint64 id, td_api::checkAuthenticationBotToken &request);
 
   void on_request(uint64 id, td_api::confirmQrCodeAuthentication &request);
@@ -517,6 +656,10 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::getCurrentState &request);
 
+  void on_request(uint64 id, const td_api::setUpdateFilter &request);
+
+  void on_request(uint64 id, td_api::setDatabaseSettings &request);
+
   void on_request(uint64 id, td_api::getPasswordState &request);
 
   void on_request(uint64 id, td_api::setPassword &request);
@@ -669,8 +812,18 @@ class Td final : public Actor {
 
   void on_request(uint64 id, td_api::getDatabaseStatistics &request);
 
+  void on_request(uint64 id, const td_api::getMemoryStatistics &request);
+
+  void on_request(uint64 id, const td_api::getNetworkRequestLatencyStatistics &request);
+
+  void on_request(uint64 id, const td_api::getStorageLatencyStatistics &request);
+
+  void on_request(uint64 id, const td_api::getStartupStatistics &request);
+
   void on_request(uint64 id, td_api::optimizeStorage &request);
 
+  void on_request(uint64 id, const td_api::optimizeDatabase &request);
+
   void on_request(uint64 id, td_api::getNetworkStatistics &request);
 
   void on_request(uint64 id, td_api::resetNetworkStatistics &request);
@@ -1925,8 +2078,16 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::getLogTagVerbosityLevel &request);
 
+  void on_request(uint64 id, const td_api::setLogTagRateLimit &request);
+
+  void on_request(uint64 id, const td_api::getLogTagRateLimit &request);
+
   void on_request(uint64 id, const td_api::addLogMessage &request);
 
+  void on_request(uint64 id, const td_api::toggleTraceSpans &request);
+
+  void on_request(uint64 id, const td_api::getTraceSpans &request);
+
   // test
   void on_request(uint64 id, const td_api::testNetwork &request);
   void on_request(uint64 id, td_api::testProxy &request);
@@ -1972,7 +2133,11 @@ class Td final : public Actor {
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTags &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogTagVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTagVerbosityLevel &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogTagRateLimit &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTagRateLimit &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::addLogMessage &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::toggleTraceSpans &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getTraceSpans &request);
   static td_api::object_ptr<td_api::Object> do_static_request(td_api::testReturnError &request);
 
   static DbKey as_db_key(string key);
@@ -1993,12 +2158,25 @@ class Td final : public Actor {
 
   void init_non_actor_managers();
 
+  template <class T>
+  ActorOwn<T> register_manager(Slice name, T *manager) {
+    auto actor = register_actor(name, manager);
+    startup_trace_.add_step(name);
+    return actor;
+  }
+
   void init_managers();
 
   void init_pure_actor_managers();
 
   void process_binlog_events(TdDb::OpenedDatabase &&events);
 
+  void defer_binlog_events(vector<BinlogEvent> &&events);
+
+  void replay_deferred_binlog_events();
+
+  void replay_deferred_binlog_event(BinlogEvent &&event);
+
   void clear();
 
   void close_impl(bool destroy_flag);
@@ -10,10 +10,14 @@
 
 #include "td/telegram/td_api.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 
 namespace td {
 
+class ReadOnlyRequestExecutor;
+
 /**
  * Interface of callback for low-level interaction with TDLib.
  */
@@ -33,6 +37,23 @@ class TdCallback {
    */
   virtual void on_error(std::uint64_t id, td_api::object_ptr<td_api::error> error) = 0;
 
+  /**
+   * This function is called at most once after TDLib initialization with an object, which can be used to execute
+   * some read-only requests from other threads without waiting for the TDLib instance.
+   * \param executor Executor of read-only requests.
+   */
+  virtual void on_read_only_request_executor(std::shared_ptr<ReadOnlyRequestExecutor> executor) {
+  }
+
+  /**
+   * Returns the number of answers and updates, which were passed to the callback, but weren't received by
+   * the application yet. TDLib delays getting of new updates from the server if the number is too big.
+   * \return Number of answers and updates waiting to be received by the application, or 0 if it is unknown.
+   */
+  virtual std::size_t get_pending_update_count() const {
+    return 0;
+  }
+
   /**
    * Destroys the TdCallback.
    */
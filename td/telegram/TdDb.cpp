@@ -20,6 +20,7 @@
 #include "td/db/binlog/Binlog.h"
 #include "td/db/binlog/ConcurrentBinlog.h"
 #include "td/db/BinlogKeyValue.h"
+#include "td/db/KeyValueSyncInterface.h"
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteKeyValue.h"
@@ -30,22 +31,31 @@
 #include "td/actor/MultiPromise.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
 
 #include <algorithm>
+#include <functional>
+#include <map>
+#include <unordered_map>
 
 namespace td {
 
 namespace {
 
+constexpr int32 INCREMENTAL_AUTO_VACUUM = 2;  // value of PRAGMA auto_vacuum for INCREMENTAL mode
+
 std::string get_binlog_path(const TdDb::Parameters &parameters) {
   return PSTRING() << parameters.database_directory_ << "td" << (parameters.is_test_dc_ ? "_test" : "") << ".binlog";
 }
@@ -55,6 +65,73 @@ std::string get_sqlite_path(const TdDb::Parameters &parameters) {
   return parameters.database_directory_ + db_name + ".sqlite";
 }
 
+// collects values, which are set by SQLite database migrations running in parallel with binlog loading
+class PendingBinlogPmc final : public KeyValueSyncInterface {
+ public:
+  SeqNo set(string key, string value) final {
+    values_[std::move(key)] = std::move(value);
+    return 0;
+  }
+
+  bool isset(const string &key) final {
+    return values_.count(key) > 0;
+  }
+
+  string get(const string &key) final {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return string();
+    }
+    return it->second;
+  }
+
+  void for_each(std::function<void(Slice, Slice)> func) final {
+    UNREACHABLE();
+  }
+
+  std::unordered_map<string, string, Hash<string>> prefix_get(Slice prefix) final {
+    UNREACHABLE();
+    return {};
+  }
+
+  FlatHashMap<string, string> get_all() final {
+    UNREACHABLE();
+    return {};
+  }
+
+  SeqNo erase(const string &key) final {
+    UNREACHABLE();
+    return 0;
+  }
+
+  SeqNo erase_batch(vector<string> keys) final {
+    UNREACHABLE();
+    return 0;
+  }
+
+  void erase_by_prefix(Slice prefix) final {
+    UNREACHABLE();
+  }
+
+  void force_sync(Promise<> &&promise, const char *source) final {
+    UNREACHABLE();
+  }
+
+  void close(Promise<> promise) final {
+    UNREACHABLE();
+  }
+
+  void apply(KeyValueSyncInterface &binlog_pmc) {
+    for (auto &it : values_) {
+      binlog_pmc.set(it.first, std::move(it.second));
+    }
+    values_.clear();
+  }
+
+ private:
+  std::map<string, string> values_;
+};
+
 Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc,
                    TdDb::OpenedDatabase &events, DbKey key) {
   auto r_binlog_stat = stat(path);
@@ -68,7 +145,11 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
     }
   }
 
+  std::map<int32, std::pair<size_t, size_t>> event_type_statistics;
   auto callback = [&](const BinlogEvent &event) {
+    auto &type_statistics = event_type_statistics[event.type_];
+    type_statistics.first++;
+    type_statistics.second += event.size_;
     switch (event.type_) {
       case LogEvent::HandlerType::SecretChats:
         events.to_secret_chats_manager.push_back(event.clone());
@@ -176,6 +257,11 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
     }
     return Status::Error(400, init_status.message());
   }
+  for (auto &it : event_type_statistics) {
+    events.trace.add_note(PSTRING() << "Have " << it.second.first << " binlog events of type "
+                                    << format::as_hex(it.first) << " with total size "
+                                    << format::as_size(it.second.second));
+  }
   return Status::OK();
 }
 
@@ -351,33 +437,36 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
   lock.set_value(Unit());
 }
 
-Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
-                         BinlogKeyValue<Binlog> &binlog_pmc) {
+Result<TdDb::MigratedSqliteDb> TdDb::migrate_sqlite(const Parameters &parameters, const DbKey &key,
+                                                     const DbKey &old_key, KeyValueSyncInterface &binlog_pmc,
+                                                     StartupTrace &trace) {
   CHECK(!parameters.use_message_database_ || parameters.use_chat_info_database_);
   CHECK(!parameters.use_chat_info_database_ || parameters.use_file_database_);
+  CHECK(parameters.use_file_database_);
 
   const string sql_database_path = get_sqlite_path(parameters);
 
-  bool use_sqlite = parameters.use_file_database_;
   bool use_file_database = parameters.use_file_database_;
   bool use_dialog_db = parameters.use_message_database_;
   bool use_message_thread_db = parameters.use_message_database_ && false;
   bool use_message_database = parameters.use_message_database_;
   bool use_story_database = parameters.use_message_database_;
 
-  was_dialog_db_created_ = false;
-
-  if (!use_sqlite) {
-    SqliteDb::destroy(sql_database_path).ignore();
-    return Status::OK();
-  }
-
-  TRY_RESULT(db_instance, SqliteDb::change_key(sql_database_path, true, key, old_key));
-  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version());
-  sql_connection_->set(std::move(db_instance));
-  auto &db = sql_connection_->get();
+  MigratedSqliteDb result;
+  TRY_RESULT_ASSIGN(result.db, SqliteDb::change_key(sql_database_path, true, key, old_key));
+  trace.add_step("open SQLite database");
+  const auto &settings = parameters.sqlite_settings_;
+  LOG(INFO) << "Open SQLite database with " << settings;
+  auto &db = result.db;
+  if (settings.page_size != 0 && key.is_empty()) {
+    // page size of an existing database in WAL mode can't be changed, so the pragma is silently ignored
+    TRY_STATUS(db.exec(PSLICE() << "PRAGMA page_size = " << settings.page_size));
+  }
+  // the pragma is applied only to new databases; existing databases must be vacuumed to apply it
+  TRY_STATUS(db.exec("PRAGMA auto_vacuum = INCREMENTAL"));
   TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
   TRY_STATUS(db.exec("PRAGMA secure_delete=1"));
+  TRY_STATUS(db.apply_settings(settings));
 
   // Init databases
   // Do initialization once and before everything else to avoid "database is locked" error.
@@ -389,13 +478,16 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   // Get 'PRAGMA user_version'
   TRY_RESULT(user_version, db.user_version());
   LOG(INFO) << "Have PRAGMA user_version = " << user_version;
+  result.user_version = user_version;
+  trace.add_step("apply SQLite settings");
 
   // init DialogDb
   if (use_dialog_db) {
-    TRY_STATUS(init_dialog_db(db, user_version, binlog_pmc, was_dialog_db_created_));
+    TRY_STATUS(init_dialog_db(db, user_version, binlog_pmc, result.was_dialog_db_created));
   } else {
     TRY_STATUS(drop_dialog_db(db, user_version));
   }
+  trace.add_step("init dialog database");
 
   // init MessageThreadDb
   if (use_message_thread_db) {
@@ -403,6 +495,7 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   } else {
     TRY_STATUS(drop_message_thread_db(db, user_version));
   }
+  trace.add_step("init message thread database");
 
   // init MessageDb
   if (use_message_database) {
@@ -410,6 +503,7 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   } else {
     TRY_STATUS(drop_message_db(db, user_version));
   }
+  trace.add_step("init message database");
 
   // init StoryDb
   if (use_story_database) {
@@ -417,6 +511,7 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   } else {
     TRY_STATUS(drop_story_db(db, user_version));
   }
+  trace.add_step("init story database");
 
   // init FileDb
   if (use_file_database) {
@@ -424,6 +519,7 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   } else {
     TRY_STATUS(drop_file_db(db, user_version));
   }
+  trace.add_step("init file database");
 
   // Update 'PRAGMA user_version'
   auto db_version = current_db_version();
@@ -432,6 +528,42 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
     TRY_STATUS(db.set_user_version(db_version));
   }
 
+  return std::move(result);
+}
+
+Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
+                         BinlogKeyValue<Binlog> &binlog_pmc, StartupTrace &trace) {
+  was_dialog_db_created_ = false;
+
+  if (!parameters.use_file_database_) {
+    SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
+    return Status::OK();
+  }
+
+  trace.begin_phase("init SQLite database");
+  SCOPE_EXIT {
+    trace.end_phase();
+  };
+
+  TRY_RESULT(migrated_db, migrate_sqlite(parameters, key, old_key, binlog_pmc, trace));
+  return init_sqlite_connection(parameters, key, std::move(migrated_db), binlog_pmc, trace);
+}
+
+Status TdDb::init_sqlite_connection(const Parameters &parameters, const DbKey &key, MigratedSqliteDb migrated_db,
+                                    BinlogKeyValue<Binlog> &binlog_pmc, StartupTrace &trace) {
+  bool use_dialog_db = parameters.use_message_database_;
+  bool use_message_thread_db = parameters.use_message_database_ && false;
+  bool use_message_database = parameters.use_message_database_;
+  bool use_story_database = parameters.use_message_database_;
+
+  was_dialog_db_created_ = migrated_db.was_dialog_db_created;
+  auto user_version = migrated_db.user_version;
+
+  sql_connection_ = std::make_shared<SqliteConnectionSafe>(
+      get_sqlite_path(parameters), key, migrated_db.db.get_cipher_version(), parameters.sqlite_settings_);
+  sql_connection_->set(std::move(migrated_db.db));
+  auto &db = sql_connection_->get();
+
   if (was_dialog_db_created_) {
     binlog_pmc.erase_by_prefix("pinned_dialog_ids");
     binlog_pmc.erase_by_prefix("last_server_dialog_date");
@@ -456,6 +588,7 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   binlog_pmc.force_sync(Auto(), "init_sqlite");
 
   TRY_STATUS(db.exec("COMMIT TRANSACTION"));
+  trace.add_step("commit database migration");
 
   file_db_ = create_file_db(sql_connection_);
 
@@ -480,8 +613,11 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   }
 
   if (use_message_database) {
-    message_db_sync_safe_ = create_message_db_sync(sql_connection_);
-    message_db_async_ = create_message_db_async(message_db_sync_safe_);
+    message_db_sync_safe_ = create_message_db_sync(sql_connection_, parameters.compress_message_data_);
+    // the message database is the biggest one, so its heavy queries are executed in parallel on other schedulers
+    message_db_async_ = create_message_db_async(
+        message_db_sync_safe_, -1,
+        {G()->get_database_scheduler_id(), G()->get_gc_scheduler_id(), G()->get_slow_net_scheduler_id()});
   }
 
   if (use_story_database) {
@@ -500,9 +636,11 @@ void TdDb::open(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabas
 }
 
 void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
-  TRY_STATUS_PROMISE(promise, check_parameters(parameters));
-
   OpenedDatabase result;
+  result.trace.begin_phase("open database");
+
+  TRY_STATUS_PROMISE(promise, check_parameters(parameters));
+  result.trace.add_step("check parameters");
 
   // Init pmc
   Binlog *binlog_ptr = nullptr;
@@ -514,15 +652,58 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   config_pmc->external_init_begin(static_cast<int32>(LogEvent::HandlerType::ConfigPmcMagic));
 
   bool encrypt_binlog = !parameters.encryption_key_.is_empty();
+
+  // the key of the SQLite database is stored in the binlog, so the database can be opened and migrated
+  // in parallel with binlog loading only if it isn't encrypted; the result is used only if the binlog confirms this
+  Result<MigratedSqliteDb> r_parallel_sqlite_db = Status::Error("SQLite database wasn't opened in parallel");
+  StartupTrace parallel_sqlite_trace;
+  PendingBinlogPmc parallel_sqlite_binlog_pmc;
+  bool is_sqlite_opened_in_parallel = false;
+#if !TD_THREAD_UNSUPPORTED
+  td::thread parallel_sqlite_thread;
+  if (parameters.use_file_database_ && !encrypt_binlog) {
+    VLOG(td_init) << "Start to init database in parallel";
+    is_sqlite_opened_in_parallel = true;
+    parallel_sqlite_thread = td::thread([&r_parallel_sqlite_db, &parallel_sqlite_trace, &parallel_sqlite_binlog_pmc,
+                                         sqlite_parameters = parameters]() mutable {
+      parallel_sqlite_trace.begin_phase("init SQLite database in parallel");
+      r_parallel_sqlite_db = migrate_sqlite(sqlite_parameters, DbKey::empty(), DbKey::empty(),
+                                            parallel_sqlite_binlog_pmc, parallel_sqlite_trace);
+      parallel_sqlite_trace.end_phase();
+    });
+  }
+  SCOPE_EXIT {
+    parallel_sqlite_thread.join();
+  };
+#endif
+
   VLOG(td_init) << "Start binlog loading";
   TRY_STATUS_PROMISE(promise, init_binlog(*binlog, get_binlog_path(parameters), *binlog_pmc, *config_pmc, result,
                                           std::move(parameters.encryption_key_)));
   VLOG(td_init) << "Finish binlog loading";
+  result.trace.add_step("read binlog");
 
   binlog_pmc->external_init_finish(binlog);
   VLOG(td_init) << "Finish initialization of binlog PMC";
   config_pmc->external_init_finish(binlog);
   VLOG(td_init) << "Finish initialization of config PMC";
+  result.trace.add_step("init binlog PMC");
+
+#if !TD_THREAD_UNSUPPORTED
+  parallel_sqlite_thread.join();
+#endif
+  if (is_sqlite_opened_in_parallel) {
+    VLOG(td_init) << "Finish to init database in parallel";
+    result.trace.append(std::move(parallel_sqlite_trace));
+    if (r_parallel_sqlite_db.is_ok() &&
+        (binlog_pmc->get("auth").empty() || !binlog_pmc->get("sqlite_key").empty())) {
+      LOG(INFO) << "Close SQLite database opened in parallel";
+      r_parallel_sqlite_db = Status::Error("SQLite database must be reopened");
+    }
+    if (r_parallel_sqlite_db.is_error()) {
+      LOG(INFO) << "Failed to init database in parallel: " << r_parallel_sqlite_db.error();
+    }
+  }
 
   if (parameters.use_file_database_ && binlog_pmc->get("auth").empty()) {
     LOG(INFO) << "Destroy SQLite database, because wasn't authorized yet";
@@ -552,7 +733,16 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   }
   VLOG(td_init) << "Start to init database";
   auto db = make_unique<TdDb>();
-  auto init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+  Status init_sqlite_status;
+  if (r_parallel_sqlite_db.is_ok()) {
+    CHECK(new_sqlite_key.is_empty());
+    CHECK(!drop_sqlite_key);
+    parallel_sqlite_binlog_pmc.apply(*binlog_pmc);
+    init_sqlite_status = db->init_sqlite_connection(parameters, new_sqlite_key, r_parallel_sqlite_db.move_as_ok(),
+                                                    *binlog_pmc, result.trace);
+  } else {
+    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc, result.trace);
+  }
   VLOG(td_init) << "Finish to init database";
   if (init_sqlite_status.is_error()) {
     LOG(ERROR) << "Destroy bad SQLite database because of " << init_sqlite_status;
@@ -560,7 +750,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
       db->sql_connection_->get().close();
     }
     SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
-    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc, result.trace);
     if (init_sqlite_status.is_error()) {
       return promise.set_error(Status::Error(400, init_sqlite_status.message()));
     }
@@ -586,12 +776,15 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
 
   CHECK(binlog_ptr != nullptr);
   VLOG(td_init) << "Create concurrent_binlog";
-  auto concurrent_binlog = std::make_shared<ConcurrentBinlog>(unique_ptr<Binlog>(binlog_ptr));
+  // the binlog is synced on another scheduler to allow adding of new events during sync
+  auto concurrent_binlog =
+      std::make_shared<ConcurrentBinlog>(unique_ptr<Binlog>(binlog_ptr), -1, G()->get_gc_scheduler_id());
 
   VLOG(td_init) << "Init concurrent_binlog_pmc";
   concurrent_binlog_pmc->external_init_finish(concurrent_binlog);
   VLOG(td_init) << "Init concurrent_config_pmc";
   concurrent_config_pmc->external_init_finish(concurrent_binlog);
+  result.trace.add_step("create concurrent binlog");
 
   LOG(INFO) << "Successfully inited database in directory " << parameters.database_directory_ << " and files directory "
             << parameters.files_directory_;
@@ -602,6 +795,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   db->binlog_ = std::move(concurrent_binlog);
 
   result.database = std::move(db);
+  result.trace.end_phase();
 
   promise.set_value(std::move(result));
 }
@@ -751,9 +945,42 @@ Result<string> TdDb::get_stats() {
   }
   sb << "Max file database depth out of " << prev.size() << '/' << count
      << " elements: " << *std::max_element(prev.begin(), prev.end()) << "\n";
-  sb << "Have " << bad_count << " forward references with maximum reference to " << max_bad_to;
+  sb << "Have " << bad_count << " forward references with maximum reference to " << max_bad_to << "\n";
+
+  TRY_RESULT(auto_vacuum, sql.get_pragma_string("auto_vacuum"));
+  TRY_RESULT(page_size, sql.get_pragma_string("page_size"));
+  TRY_RESULT(page_count, sql.get_pragma_string("page_count"));
+  TRY_RESULT(free_page_count, sql.get_pragma_string("freelist_count"));
+  sb << "Have " << free_page_count << " unused pages out of " << page_count << " pages of size " << page_size
+     << " with auto_vacuum = " << auto_vacuum;
 
   return sb.as_cslice().str();
 }
 
+Status TdDb::enable_incremental_vacuum(bool allow_full_vacuum) {
+  auto &sql = sql_connection_->get();
+  TRY_RESULT(auto_vacuum, sql.get_pragma_string("auto_vacuum"));
+  if (to_integer<int32>(auto_vacuum) == INCREMENTAL_AUTO_VACUUM) {
+    return Status::OK();
+  }
+  if (!allow_full_vacuum) {
+    return Status::Error(400, "Full vacuum of the database is required");
+  }
+  LOG(WARNING) << "Vacuum the database to enable incremental vacuum";
+  TRY_STATUS(sql.exec("PRAGMA auto_vacuum = INCREMENTAL"));
+  TRY_STATUS(sql.exec("VACUUM"));
+  return Status::OK();
+}
+
+Result<int64> TdDb::run_incremental_vacuum(int32 max_page_count) {
+  CHECK(max_page_count > 0);
+  auto &sql = sql_connection_->get();
+  TRY_RESULT(page_size, sql.get_pragma_string("page_size"));
+  TRY_RESULT(old_free_page_count, sql.get_pragma_string("freelist_count"));
+  TRY_STATUS(sql.exec(PSLICE() << "PRAGMA incremental_vacuum(" << max_page_count << ')'));
+  TRY_RESULT(new_free_page_count, sql.get_pragma_string("freelist_count"));
+  auto reclaimed_page_count = to_integer<int64>(old_free_page_count) - to_integer<int64>(new_free_page_count);
+  return max(reclaimed_page_count, static_cast<int64>(0)) * to_integer<int64>(page_size);
+}
+
 }  // namespace td
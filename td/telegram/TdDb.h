@@ -6,10 +6,13 @@
 //
 #pragma once
 
+#include "td/telegram/StartupTrace.h"
+
 #include "td/db/binlog/BinlogEvent.h"
 #include "td/db/binlog/BinlogInterface.h"
 #include "td/db/DbKey.h"
 #include "td/db/KeyValueSyncInterface.h"
+#include "td/db/SqliteDb.h"
 
 #include "td/utils/common.h"
 #include "td/utils/Promise.h"
@@ -60,6 +63,8 @@ class TdDb {
     bool use_file_database_ = false;
     bool use_chat_info_database_ = false;
     bool use_message_database_ = false;
+    SqliteDbSettings sqlite_settings_;
+    bool compress_message_data_ = false;
   };
 
   struct OpenedDatabase {
@@ -80,6 +85,8 @@ class TdDb {
     vector<BinlogEvent> to_story_manager;
 
     int64 since_last_open = 0;
+
+    StartupTrace trace;
   };
   static void open(int32 scheduler_id, Parameters parameters, Promise<OpenedDatabase> &&promise);
 
@@ -154,6 +161,13 @@ class TdDb {
 
   Result<string> get_stats();
 
+  // enables incremental vacuum of the database; a database created before it was supported needs a full vacuum,
+  // which can take a long time, so the full vacuum is done only if allow_full_vacuum is true
+  Status enable_incremental_vacuum(bool allow_full_vacuum);
+
+  // reclaims at most max_page_count unused pages; returns size of the reclaimed space
+  Result<int64> run_incremental_vacuum(int32 max_page_count);
+
  private:
   Parameters parameters_;
 
@@ -186,8 +200,21 @@ class TdDb {
 
   static Status check_parameters(Parameters &parameters);
 
+  // SQLite database with applied, but not committed yet migrations
+  struct MigratedSqliteDb {
+    SqliteDb db;
+    int32 user_version = 0;
+    bool was_dialog_db_created = false;
+  };
+
+  static Result<MigratedSqliteDb> migrate_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
+                                                 KeyValueSyncInterface &binlog_pmc, StartupTrace &trace);
+
   Status init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
-                     BinlogKeyValue<Binlog> &binlog_pmc);
+                     BinlogKeyValue<Binlog> &binlog_pmc, StartupTrace &trace);
+
+  Status init_sqlite_connection(const Parameters &parameters, const DbKey &key, MigratedSqliteDb migrated_db,
+                                BinlogKeyValue<Binlog> &binlog_pmc, StartupTrace &trace);
 
   void do_close(bool destroy_flag, Promise<Unit> on_finished);
 };
@@ -117,7 +117,7 @@ int32 TimeZoneManager::get_time_zone_offset(const string &time_zone_id) {
       return time_zone.utc_offset_;
     }
   }
-  return narrow_cast<int32>(G()->get_option_integer("utc_time_offset"));
+  return narrow_cast<int32>(G()->get_option_integer(CachedOption::UtcTimeOffset));
 }
 
 void TimeZoneManager::get_time_zones(Promise<td_api::object_ptr<td_api::timeZones>> &&promise) {
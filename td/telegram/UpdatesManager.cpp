@@ -320,6 +320,9 @@ void UpdatesManager::hangup() {
   pending_seq_updates_.clear();
   pending_qts_updates_.clear();
 
+  // PTS and QTS of already applied updates must not be lost
+  save_pending_pts_and_qts();
+
   hangup_shared();
 }
 
@@ -345,8 +348,8 @@ void UpdatesManager::repair_pts_gap() {
   if (pending_pts_updates_.empty()) {
     return;
   }
-  auto it = pending_pts_updates_.begin();
-  if (it->pts != pts + it->pts_count) {
+  const auto &first_update = pending_pts_updates_.front();
+  if (first_update.pts != pts + first_update.pts_count) {
     return;
   }
   if (last_fetched_pts_ == pts) {
@@ -378,13 +381,13 @@ void UpdatesManager::fill_pts_gap(void *td) {
   const telegram_api::Update *first_update = nullptr;
   auto max_pts = 0;
   if (!updates_manager->pending_pts_updates_.empty()) {
-    auto &min_update = *updates_manager->pending_pts_updates_.begin();
+    auto &min_update = updates_manager->pending_pts_updates_.front();
     if (min_update.pts < min_pts) {
       min_pts = min_update.pts;
       min_pts_count = min_update.pts_count;
       first_update = min_update.update.get();
     }
-    max_pts = max(max_pts, updates_manager->pending_pts_updates_.rbegin()->pts);
+    max_pts = max(max_pts, updates_manager->pending_pts_updates_.back_position());
   }
   if (!updates_manager->postponed_pts_updates_.empty()) {
     auto &min_update = *updates_manager->postponed_pts_updates_.begin();
@@ -427,8 +430,8 @@ void UpdatesManager::fill_qts_gap(void *td) {
   auto min_qts = std::numeric_limits<int32>::max();
   auto max_qts = 0;
   if (!updates_manager->pending_qts_updates_.empty()) {
-    min_qts = updates_manager->pending_qts_updates_.begin()->first;
-    max_qts = updates_manager->pending_qts_updates_.rbegin()->first;
+    min_qts = updates_manager->pending_qts_updates_.front_position();
+    max_qts = updates_manager->pending_qts_updates_.back_position();
   }
   updates_manager->qts_gap_++;
   fill_gap(td, PSTRING() << "QTS from " << updates_manager->get_qts() << " to " << min_qts << '-' << max_qts);
@@ -511,6 +514,58 @@ void UpdatesManager::run_get_difference(bool is_recursive, const char *source) {
     min_postponed_update_qts_ = 0;
   }
 
+  send_get_difference_query();
+}
+
+void UpdatesManager::on_pending_update_timeout(void *td) {
+  if (G()->close_flag()) {
+    return;
+  }
+  CHECK(td != nullptr);
+  auto updates_manager = static_cast<Td *>(td)->updates_manager_.get();
+  if (updates_manager->running_get_difference_) {
+    updates_manager->send_get_difference_query();
+  }
+}
+
+bool UpdatesManager::need_pause_get_difference() {
+  auto max_pending_update_count = td_->option_manager_->get_option_integer("pending_update_count_max");
+  if (max_pending_update_count <= 0) {
+    is_get_difference_paused_ = false;
+    return false;
+  }
+
+  auto pending_update_count = static_cast<int64>(td_->get_pending_update_count());
+  if (is_get_difference_paused_) {
+    // resume only after the application receives at least a half of the updates to avoid too frequent pauses
+    is_get_difference_paused_ = pending_update_count > max_pending_update_count / 2;
+  } else {
+    is_get_difference_paused_ = pending_update_count >= max_pending_update_count;
+  }
+  VLOG_IF(get_difference, is_get_difference_paused_)
+      << "Pause getDifference, because there are " << pending_update_count << " updates waiting to be received";
+  return is_get_difference_paused_;
+}
+
+void UpdatesManager::send_get_difference_query() {
+  CHECK(running_get_difference_);
+  if (!td_->auth_manager_->is_authorized()) {
+    running_get_difference_ = false;
+    return;
+  }
+  if (need_pause_get_difference()) {
+    // new updates would be added to the updates, which the application doesn't receive fast enough
+    if (!pending_update_timeout_.has_timeout()) {
+      pending_update_timeout_.set_callback(std::move(on_pending_update_timeout));
+      pending_update_timeout_.set_callback_data(static_cast<void *>(td_));
+      pending_update_timeout_.set_timeout_in(PENDING_UPDATE_CHECK_DELAY);
+    }
+    return;
+  }
+
+  int32 pts = max(get_pts(), 0);
+  int32 date = get_date();
+  int32 qts = get_qts();
   auto promise = PromiseCreator::lambda([](Result<tl_object_ptr<telegram_api::updates_Difference>> result) {
     if (result.is_ok()) {
       send_closure(G()->updates_manager(), &UpdatesManager::on_get_difference, result.move_as_ok());
@@ -529,14 +584,13 @@ void UpdatesManager::before_get_difference(bool is_initial) {
 
   vector<Promise<Unit>> promises;
   if (can_postpone_updates()) {
-    for (auto &update : pending_pts_updates_) {
+    pending_pts_updates_.foreach([&](int32 pts, PendingPtsUpdate &update) {
       postponed_pts_updates_.emplace(std::move(update.update), update.pts, update.pts_count, update.receive_time,
                                      std::move(update.promise));
-    }
+    });
   } else {
-    for (auto &update : pending_pts_updates_) {
-      promises.push_back(std::move(update.promise));
-    }
+    pending_pts_updates_.foreach(
+        [&](int32 pts, PendingPtsUpdate &update) { promises.push_back(std::move(update.promise)); });
   }
   set_promises(promises);
 
@@ -580,12 +634,15 @@ void UpdatesManager::save_pts(int32 pts) {
     G()->td_db()->get_binlog_pmc()->erase("updates.pts");
     last_pts_save_time_ -= 2 * MAX_PTS_SAVE_DELAY;
     pending_pts_ = 0;
+    delayed_pts_save_count_ = 0;
   } else if (!td_->ignore_background_updates()) {
+    // during update bursts save PTS at most once in MAX_PTS_SAVE_DELAY or after MAX_DELAYED_PTS_SAVE_COUNT changes
     auto now = Time::now();
     auto delay = last_pts_save_time_ + MAX_PTS_SAVE_DELAY - now;
-    if (delay <= 0 || !td_->auth_manager_->is_bot()) {
+    if (delay <= 0 || ++delayed_pts_save_count_ >= MAX_DELAYED_PTS_SAVE_COUNT) {
       last_pts_save_time_ = now;
       pending_pts_ = 0;
+      delayed_pts_save_count_ = 0;
       G()->td_db()->get_binlog_pmc()->set("updates.pts", to_string(pts));
     } else {
       pending_pts_ = pts;
@@ -600,9 +657,10 @@ void UpdatesManager::save_qts(int32 qts) {
   if (!td_->ignore_background_updates()) {
     auto now = Time::now();
     auto delay = last_qts_save_time_ + MAX_PTS_SAVE_DELAY - now;
-    if (delay <= 0 || !td_->auth_manager_->is_bot()) {
+    if (delay <= 0 || ++delayed_qts_save_count_ >= MAX_DELAYED_PTS_SAVE_COUNT) {
       last_qts_save_time_ = now;
       pending_qts_ = 0;
+      delayed_qts_save_count_ = 0;
       G()->td_db()->get_binlog_pmc()->set("updates.qts", to_string(qts));
     } else {
       pending_qts_ = qts;
@@ -614,6 +672,10 @@ void UpdatesManager::save_qts(int32 qts) {
 }
 
 void UpdatesManager::timeout_expired() {
+  save_pending_pts_and_qts();
+}
+
+void UpdatesManager::save_pending_pts_and_qts() {
   if (pending_pts_ != 0) {
     last_pts_save_time_ -= 2 * MAX_PTS_SAVE_DELAY;
     save_pts(pending_pts_);
@@ -658,7 +720,8 @@ Promise<> UpdatesManager::set_pts(int32 pts, const char *source) {
     if (last_confirmed_pts_ < get_pts() - FORCED_GET_DIFFERENCE_PTS_DIFF && last_confirmed_pts_ != 0) {
       confirm_pts_qts(get_qts());
     }
-  } else if (pts < get_pts() && (pts > 1 || td_->option_manager_->get_option_integer("session_count") <= 1)) {
+  } else if (pts < get_pts() &&
+             (pts > 1 || td_->option_manager_->get_option_integer(CachedOption::SessionCount) <= 1)) {
     LOG(ERROR) << "Receive wrong PTS = " << pts << " from " << source << ". Current PTS = " << get_pts();
   }
   return result;
@@ -1193,8 +1256,8 @@ void UpdatesManager::on_get_updates_impl(tl_object_ptr<telegram_api::Updates> up
           update->silent_, false, false, false, false, false, false, false, 0, false, update->id_,
           make_tl_object<telegram_api::peerUser>(from_id), 0, make_tl_object<telegram_api::peerUser>(update->user_id_),
           nullptr, std::move(update->fwd_from_), update->via_bot_id_, 0, std::move(update->reply_to_), update->date_,
-          update->message_, nullptr, nullptr, std::move(update->entities_), 0, 0, nullptr, 0, string(), 0, nullptr,
-          Auto(), update->ttl_period_, 0);
+          std::move(update->message_), nullptr, nullptr, std::move(update->entities_), 0, 0, nullptr, 0, string(), 0,
+          nullptr, Auto(), update->ttl_period_, 0);
       on_pending_update(
           make_tl_object<telegram_api::updateNewMessage>(std::move(message), update->pts_, update->pts_count_), 0,
           std::move(promise), "telegram_api::updateShortMessage");
@@ -1207,8 +1270,9 @@ void UpdatesManager::on_get_updates_impl(tl_object_ptr<telegram_api::Updates> up
           update->silent_, false, false, false, false, false, false, false, 0, false, update->id_,
           make_tl_object<telegram_api::peerUser>(update->from_id_), 0,
           make_tl_object<telegram_api::peerChat>(update->chat_id_), nullptr, std::move(update->fwd_from_),
-          update->via_bot_id_, 0, std::move(update->reply_to_), update->date_, update->message_, nullptr, nullptr,
-          std::move(update->entities_), 0, 0, nullptr, 0, string(), 0, nullptr, Auto(), update->ttl_period_, 0);
+          update->via_bot_id_, 0, std::move(update->reply_to_), update->date_, std::move(update->message_), nullptr,
+          nullptr, std::move(update->entities_), 0, 0, nullptr, 0, string(), 0, nullptr, Auto(), update->ttl_period_,
+          0);
       on_pending_update(
           make_tl_object<telegram_api::updateNewMessage>(std::move(message), update->pts_, update->pts_count_), 0,
           std::move(promise), "telegram_api::updateShortChatMessage");
@@ -1754,7 +1818,7 @@ void UpdatesManager::on_update_from_auth_key_id(uint64 auth_key_id) {
   if (info.update_count++ == 0) {
     info.first_update_time = now;
     while (session_infos_.size() >
-           static_cast<size_t>(max(narrow_cast<int32>(G()->get_option_integer("session_count")), 1))) {
+           static_cast<size_t>(max(narrow_cast<int32>(G()->get_option_integer(CachedOption::SessionCount)), 1))) {
       auto unused_auth_key_id = get_most_unused_auth_key_id();
       LOG(INFO) << "Delete statistics for auth key " << unused_auth_key_id;
       session_infos_.erase(unused_auth_key_id);
@@ -1793,7 +1857,7 @@ void UpdatesManager::notify_speed_limited(bool is_upload) {
 }
 
 void UpdatesManager::process_get_difference_updates(
-    vector<tl_object_ptr<telegram_api::Message>> &&new_messages,
+    TlLazyVector<tl_object_ptr<telegram_api::Message>> &&new_messages,
     vector<tl_object_ptr<telegram_api::EncryptedMessage>> &&new_encrypted_messages,
     vector<tl_object_ptr<telegram_api::Update>> &&other_updates) {
   VLOG(get_difference) << "In get difference receive " << new_messages.size() << " messages, "
@@ -1857,15 +1921,17 @@ void UpdatesManager::process_get_difference_updates(
     */
   }
 
-  for (auto &message : new_messages) {
+  // messages are parsed one by one to avoid keeping all of them in memory
+  td_->messages_manager_->start_message_batch();
+  for (auto message : new_messages) {
     // channel messages must not be received in this vector
     td_->messages_manager_->on_get_message(std::move(message), true, false, false, "get difference");
     CHECK(!running_get_difference_);
   }
+  td_->messages_manager_->finish_message_batch();
 
-  for (auto &encrypted_message : new_encrypted_messages) {
-    send_closure(td_->secret_chats_manager_, &SecretChatsManager::on_new_message, std::move(encrypted_message),
-                 Promise<Unit>());
+  if (!new_encrypted_messages.empty()) {
+    send_closure(td_->secret_chats_manager_, &SecretChatsManager::on_new_messages, std::move(new_encrypted_messages));
   }
 
   process_updates(std::move(other_updates), true, Promise<Unit>());
@@ -1894,9 +1960,8 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
         auto pending_qts_updates = std::move(pending_qts_updates_);
         pending_qts_updates_.clear();
 
-        for (auto &pending_update : pending_qts_updates) {
-          set_promises(pending_update.second.promises);
-        }
+        pending_qts_updates.foreach(
+            [](int32 qts, PendingQtsUpdate &pending_update) { set_promises(pending_update.promises); });
       }
 
       process_pending_seq_updates();
@@ -2000,7 +2065,7 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
       break;
     }
     case telegram_api::updates_differenceTooLong::ID: {
-      if (td_->option_manager_->get_option_integer("session_count") <= 1) {
+      if (td_->option_manager_->get_option_integer(CachedOption::SessionCount) <= 1) {
         LOG(ERROR) << "Receive differenceTooLong";
       }
       // TODO
@@ -2027,8 +2092,8 @@ void UpdatesManager::on_get_pts_update(int32 pts,
   }
   LOG(DEBUG) << "Receive update with PTS " << pts << ": " << to_string(difference_ptr);
   if (get_pts() != pts - 1 || running_get_difference_ || !postponed_pts_updates_.empty() ||
-      pending_pts_updates_.empty() || pending_pts_updates_.begin()->pts > pts + 1 ||
-      pending_pts_updates_.begin()->pts != pts + pending_pts_updates_.begin()->pts_count) {
+      pending_pts_updates_.empty() || pending_pts_updates_.front().pts > pts + 1 ||
+      pending_pts_updates_.front().pts != pts + pending_pts_updates_.front().pts_count) {
     return;
   }
 
@@ -2051,7 +2116,7 @@ void UpdatesManager::on_get_pts_update(int32 pts,
       td_->user_manager_->on_get_users(std::move(difference->users_), "on_get_pts_update");
       td_->chat_manager_->on_get_chats(std::move(difference->chats_), "on_get_pts_update");
 
-      for (auto &message : difference->new_messages_) {
+      for (auto message : difference->new_messages_) {
         difference->other_updates_.push_back(
             telegram_api::make_object<telegram_api::updateNewMessage>(std::move(message), pts, 1));
       }
@@ -2092,8 +2157,8 @@ void UpdatesManager::on_get_pts_update(int32 pts,
     case telegram_api::updates_differenceEmpty::ID:
     case telegram_api::updates_differenceTooLong::ID: {
       LOG(ERROR) << "Receive " << oneline(to_string(difference_ptr)) << " for request with PTS = " << pts - 1
-                 << ", but have pending " << oneline(to_string(pending_pts_updates_.begin()->update))
-                 << " with PTS = " << pending_pts_updates_.begin()->pts;
+                 << ", but have pending " << oneline(to_string(pending_pts_updates_.front().update))
+                 << " with PTS = " << pending_pts_updates_.front().pts;
       break;
       default:
         UNREACHABLE();
@@ -2644,7 +2709,7 @@ void UpdatesManager::add_pending_qts_update(tl_object_ptr<telegram_api::Update>
     if (!can_postpone_updates()) {
       return promise.set_value(Unit());
     }
-    auto &pending_update = pending_qts_updates_[qts];
+    auto &pending_update = pending_qts_updates_.get_or_create(qts);
     if (pending_update.update != nullptr) {
       LOG(WARNING) << "Receive duplicate update with QTS = " << qts;
     } else {
@@ -2827,7 +2892,7 @@ void UpdatesManager::add_pending_pts_update(tl_object_ptr<telegram_api::Update>
     bool need_restore_pts = new_pts < old_pts - 19999;
     auto now = Time::now();
     if (old_pts == 2100000000 && new_pts < 1100000000 && pts_count <= 10000 &&
-        td_->option_manager_->get_option_integer("session_count") > 1) {
+        td_->option_manager_->get_option_integer(CachedOption::SessionCount) > 1) {
       set_pts(1, "restore PTS").set_value(Unit());
       old_pts = get_pts();
       set_pts_gap_timeout(0.001);
@@ -2910,7 +2975,8 @@ void UpdatesManager::add_pending_pts_update(tl_object_ptr<telegram_api::Update>
     return;
   }
 
-  pending_pts_updates_.emplace(std::move(update), new_pts, pts_count, receive_time, std::move(promise));
+  pending_pts_updates_.insert(
+      new_pts, PendingPtsUpdate(std::move(update), new_pts, pts_count, receive_time, std::move(promise)));
 
   if (old_pts < accumulated_pts_ - accumulated_pts_count_) {
     if (old_pts == new_pts - pts_count) {
@@ -2931,7 +2997,8 @@ void UpdatesManager::add_pending_pts_update(tl_object_ptr<telegram_api::Update>
 
 void UpdatesManager::postpone_pts_update(tl_object_ptr<telegram_api::Update> &&update, int32 pts, int32 pts_count,
                                          double receive_time, Promise<Unit> &&promise) {
-  if (!can_postpone_updates() || (pts_count > 1 && td_->option_manager_->get_option_integer("session_count") <= 1)) {
+  if (!can_postpone_updates() ||
+      (pts_count > 1 && td_->option_manager_->get_option_integer(CachedOption::SessionCount) <= 1)) {
     return promise.set_value(Unit());
   }
   postponed_pts_updates_.emplace(std::move(update), pts, pts_count, receive_time, std::move(promise));
@@ -3114,10 +3181,11 @@ void UpdatesManager::process_qts_update(tl_object_ptr<telegram_api::Update> &&up
 
 void UpdatesManager::process_all_pending_pts_updates() {
   auto begin_time = Time::now();
-  for (auto &update : pending_pts_updates_) {
+  auto pending_pts_updates = std::move(pending_pts_updates_);
+  pending_pts_updates.foreach([&](int32 pts, PendingPtsUpdate &update) {
     td_->messages_manager_->process_pts_update(std::move(update.update));
     update.promise.set_value(Unit());
-  }
+  });
 
   if (last_pts_gap_time_ != 0) {
     auto begin_diff = begin_time - last_pts_gap_time_;
@@ -3236,12 +3304,13 @@ void UpdatesManager::process_pending_pts_updates() {
   auto initial_pts = get_pts();
   int32 applied_update_count = 0;
   while (!pending_pts_updates_.empty()) {
-    auto update_it = pending_pts_updates_.begin();
-    auto &update = *update_it;
-    if (get_pts() != update.pts - update.pts_count) {
+    auto &first_update = pending_pts_updates_.front();
+    if (get_pts() != first_update.pts - first_update.pts_count) {
       // the updates will be applied or skipped later
       break;
     }
+    auto update = std::move(first_update);
+    pending_pts_updates_.pop_front();
 
     applied_update_count++;
     if (update.pts_count > 0) {
@@ -3258,7 +3327,6 @@ void UpdatesManager::process_pending_pts_updates() {
       LOG(INFO) << "Skip because of pts_count == 0 " << to_string(update.update);
     }
     update.promise.set_value(Unit());
-    pending_pts_updates_.erase(update_it);
   }
   if (applied_update_count > 0) {
     min_pts_gap_timeout_.cancel_timeout();
@@ -3266,14 +3334,10 @@ void UpdatesManager::process_pending_pts_updates() {
   }
   if (!pending_pts_updates_.empty()) {
     // if still have a gap, reset timeout
-    auto update_it = pending_pts_updates_.begin();
-    double receive_time = update_it->receive_time;
-    for (size_t i = 0; i < GAP_TIMEOUT_UPDATE_COUNT; i++) {
-      if (++update_it == pending_pts_updates_.end()) {
-        break;
-      }
-      receive_time = min(receive_time, update_it->receive_time);
-    }
+    double receive_time = pending_pts_updates_.front().receive_time;
+    pending_pts_updates_.foreach_first(GAP_TIMEOUT_UPDATE_COUNT + 1, [&](int32 pts, const PendingPtsUpdate &update) {
+      receive_time = min(receive_time, update.receive_time);
+    });
     set_pts_gap_timeout(max(receive_time + MAX_UNFILLED_GAP_TIME - Time::now(), 0.001));
   }
 
@@ -3353,22 +3417,23 @@ void UpdatesManager::process_pending_qts_updates() {
   int32 applied_update_count = 0;
   while (!pending_qts_updates_.empty()) {
     CHECK(!running_get_difference_);
-    auto update_it = pending_qts_updates_.begin();
-    auto qts = update_it->first;
+    auto qts = pending_qts_updates_.front_position();
+    auto &pending_update = pending_qts_updates_.front();
     auto old_qts = get_qts();
     if (qts - 1 > old_qts && qts - (1 << 30) <= old_qts) {
       // the update will be applied later
       break;
     }
     auto promise = PromiseCreator::lambda(
-        [promises = std::move(update_it->second.promises)](Unit) mutable { set_promises(promises); });
+        [promises = std::move(pending_update.promises)](Unit) mutable { set_promises(promises); });
+    auto update = std::move(pending_update.update);
+    pending_qts_updates_.pop_front();
     applied_update_count++;
     if (qts == old_qts + 1) {
-      process_qts_update(std::move(update_it->second.update), qts, std::move(promise));
+      process_qts_update(std::move(update), qts, std::move(promise));
     } else {
       promise.set_value(Unit());
     }
-    pending_qts_updates_.erase(update_it);
   }
 
   if (applied_update_count > 0) {
@@ -3376,14 +3441,10 @@ void UpdatesManager::process_pending_qts_updates() {
   }
   if (!pending_qts_updates_.empty()) {
     // if still have a gap, reset timeout
-    auto update_it = pending_qts_updates_.begin();
-    double receive_time = update_it->second.receive_time;
-    for (size_t i = 0; i < GAP_TIMEOUT_UPDATE_COUNT; i++) {
-      if (++update_it == pending_qts_updates_.end()) {
-        break;
-      }
-      receive_time = min(receive_time, update_it->second.receive_time);
-    }
+    double receive_time = pending_qts_updates_.front().receive_time;
+    pending_qts_updates_.foreach_first(GAP_TIMEOUT_UPDATE_COUNT + 1, [&](int32 qts, const PendingQtsUpdate &update) {
+      receive_time = min(receive_time, update.receive_time);
+    });
     set_qts_gap_timeout(receive_time + MAX_UNFILLED_GAP_TIME - Time::now());
   }
   CHECK(!running_get_difference_);
@@ -4162,7 +4223,7 @@ void UpdatesManager::on_update(tl_object_ptr<telegram_api::updateConfig> update,
 }
 
 void UpdatesManager::on_update(tl_object_ptr<telegram_api::updatePtsChanged> update, Promise<Unit> &&promise) {
-  if (td_->option_manager_->get_option_integer("session_count") > 1) {
+  if (td_->option_manager_->get_option_integer(CachedOption::SessionCount) > 1) {
     auto old_pts = get_pts();
     auto new_pts = 1;
     if (old_pts != new_pts) {
@@ -16,6 +16,8 @@
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/UserId.h"
 
+#include "td/tl/TlLazyVector.h"
+
 #include "td/actor/actor.h"
 #include "td/actor/Timeout.h"
 
@@ -24,11 +26,11 @@
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
+#include "td/utils/SparseWindowQueue.h"
 #include "td/utils/Status.h"
 #include "td/utils/tl_storers.h"
 #include "td/utils/TlStorerToString.h"
 
-#include <map>
 #include <set>
 #include <utility>
 
@@ -53,6 +55,14 @@ class dummyUpdate final : public telegram_api::Update {
     UNREACHABLE();
   }
 
+  void store(TlStorerBuffer &s) const final {
+    UNREACHABLE();
+  }
+
+  std::size_t approximate_memory_usage() const final {
+    return sizeof(*this);
+  }
+
   void store(TlStorerToString &s, const char *field_name) const final {
     s.store_class_begin(field_name, "dummyUpdate");
     s.store_class_end();
@@ -83,6 +93,14 @@ class updateSentMessage final : public telegram_api::Update {
     UNREACHABLE();
   }
 
+  void store(TlStorerBuffer &s) const final {
+    UNREACHABLE();
+  }
+
+  std::size_t approximate_memory_usage() const final {
+    return sizeof(*this);
+  }
+
   void store(TlStorerToString &s, const char *field_name) const final {
     s.store_class_begin(field_name, "updateSentMessage");
     s.store_field("random_id", random_id_);
@@ -145,6 +163,8 @@ class UpdatesManager final : public Actor {
   static constexpr double MIN_UNFILLED_GAP_TIME = 0.05;
   static constexpr double MAX_UNFILLED_GAP_TIME = 0.7;
   static constexpr double MAX_PTS_SAVE_DELAY = 0.05;
+  static constexpr int32 MAX_DELAYED_PTS_SAVE_COUNT = 1000;
+  static constexpr double PENDING_UPDATE_CHECK_DELAY = 0.1;
   static constexpr double UPDATE_APPLY_WARNING_TIME = 0.1;
   static constexpr bool DROP_PTS_UPDATES = false;
   static constexpr const char *AFTER_GET_DIFFERENCE_SOURCE = "after get difference";
@@ -224,6 +244,8 @@ class UpdatesManager final : public Actor {
   double last_qts_save_time_ = 0;
   int32 pending_pts_ = 0;
   int32 pending_qts_ = 0;
+  int32 delayed_pts_save_count_ = 0;
+  int32 delayed_qts_save_count_ = 0;
 
   int32 pts_short_gap_ = 0;
   int32 pts_fixed_short_gap_ = 0;
@@ -243,13 +265,13 @@ class UpdatesManager final : public Actor {
   double last_pts_jump_warning_time_ = 0;
   double last_pts_gap_time_ = 0;
 
-  std::multiset<PendingPtsUpdate> pending_pts_updates_;
+  SparseWindowQueue<PendingPtsUpdate> pending_pts_updates_;  // updates with too big PTS, indexed by PTS
   std::multiset<PendingPtsUpdate> postponed_pts_updates_;
 
   std::multiset<PendingSeqUpdates> postponed_updates_;    // updates received during getDifference
   std::multiset<PendingSeqUpdates> pending_seq_updates_;  // updates with too big seq
 
-  std::map<int32, PendingQtsUpdate> pending_qts_updates_;  // updates with too big QTS
+  SparseWindowQueue<PendingQtsUpdate> pending_qts_updates_;  // updates with too big QTS, indexed by QTS
 
   Timeout min_pts_gap_timeout_;
   Timeout pts_gap_timeout_;
@@ -261,6 +283,9 @@ class UpdatesManager final : public Actor {
   int32 retry_time_ = 1;
   Timeout retry_timeout_;
 
+  bool is_get_difference_paused_ = false;  // the application doesn't receive updates fast enough
+  Timeout pending_update_timeout_;
+
   double next_data_reload_time_ = 0.0;
   Timeout data_reload_timeout_;
 
@@ -313,6 +338,8 @@ class UpdatesManager final : public Actor {
   void on_qts_ack(PtsManager::PtsId ack_token);
   void save_qts(int32 qts);
 
+  void save_pending_pts_and_qts();
+
   bool can_postpone_updates() {
     if (skipped_postponed_updates_after_start_ == 0) {
       return true;
@@ -335,7 +362,7 @@ class UpdatesManager final : public Actor {
 
   void on_get_difference(tl_object_ptr<telegram_api::updates_Difference> &&difference_ptr);
 
-  void process_get_difference_updates(vector<tl_object_ptr<telegram_api::Message>> &&new_messages,
+  void process_get_difference_updates(TlLazyVector<tl_object_ptr<telegram_api::Message>> &&new_messages,
                                       vector<tl_object_ptr<telegram_api::EncryptedMessage>> &&new_encrypted_messages,
                                       vector<tl_object_ptr<telegram_api::Update>> &&other_updates);
 
@@ -386,6 +413,12 @@ class UpdatesManager final : public Actor {
 
   static void fill_gap(void *td, const string &source);
 
+  static void on_pending_update_timeout(void *td);
+
+  bool need_pause_get_difference();
+
+  void send_get_difference_query();
+
   void repair_pts_gap();
 
   void on_get_pts_update(int32 pts, telegram_api::object_ptr<telegram_api::updates_Difference> difference_ptr);
@@ -1431,7 +1431,7 @@ void UserManager::User::store(StorerT &storer) const {
     store(bot_info_version, storer);
   }
   if (has_language_code) {
-    store(language_code, storer);
+    store(language_code.as_slice(), storer);
   }
   if (has_cache_version) {
     store(cache_version, storer);
@@ -1585,7 +1585,9 @@ void UserManager::User::parse(ParserT &parser) {
     parse(bot_info_version, parser);
   }
   if (has_language_code) {
-    parse(language_code, parser);
+    string parsed_language_code;
+    parse(parsed_language_code, parser);
+    language_code = intern_string(parsed_language_code);
   }
   if (has_cache_version) {
     parse(cache_version, parser);
@@ -2019,9 +2021,11 @@ UserManager::UserManager(Td *td, ActorShared<> parent) : td_(td), parent_(std::m
 
   user_online_timeout_.set_callback(on_user_online_timeout_callback);
   user_online_timeout_.set_callback_data(static_cast<void *>(this));
+  user_online_timeout_.set_lazy(true);
 
   user_emoji_status_timeout_.set_callback(on_user_emoji_status_timeout_callback);
   user_emoji_status_timeout_.set_callback_data(static_cast<void *>(this));
+  user_emoji_status_timeout_.set_lazy(true);
 
   get_user_queries_.set_merge_function([this](vector<int64> query_ids, Promise<Unit> &&promise) {
     TRY_STATUS_PROMISE(promise, G()->close_status());
@@ -2039,8 +2043,8 @@ UserManager::UserManager(Td *td, ActorShared<> parent) : td_(td), parent_(std::m
 }
 
 UserManager::~UserManager() {
-  Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), users_, users_full_, user_photos_,
-                                              unknown_users_, pending_user_photos_, user_profile_photo_file_source_ids_,
+  Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), users_, users_full_, user_full_lru_list_,
+                                              user_photos_, unknown_users_, pending_user_photos_, user_profile_photo_file_source_ids_,
                                               my_photo_file_id_, user_full_file_source_ids_, secret_chats_,
                                               unknown_secret_chats_, secret_chats_with_user_);
   Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), loaded_from_database_users_,
@@ -2074,9 +2078,11 @@ void UserManager::on_user_online_timeout(UserId user_id) {
   CHECK(u->is_update_user_sent);
 
   LOG(INFO) << "Update " << user_id << " online status to offline";
-  send_closure(G()->td(), &Td::send_update,
-               td_api::make_object<td_api::updateUserStatus>(user_id.get(),
-                                                             get_user_status_object(user_id, u, G()->unix_time())));
+  if (!td_->is_update_ignored(td_api::updateUserStatus::ID)) {
+    send_closure(G()->td(), &Td::send_update,
+                 td_api::make_object<td_api::updateUserStatus>(user_id.get(),
+                                                               get_user_status_object(user_id, u, G()->unix_time())));
+  }
 
   td_->dialog_participant_manager_->update_user_online_member_count(user_id);
 }
@@ -2481,10 +2487,10 @@ void UserManager::on_get_user(telegram_api::object_ptr<telegram_api::User> &&use
   bool has_language_code = (flags & USER_FLAG_HAS_LANGUAGE_CODE) != 0;
   LOG_IF(ERROR, has_language_code && !td_->auth_manager_->is_bot())
       << "Receive language code for " << user_id << " from " << source;
-  if (u->language_code != user->lang_code_ && !user->lang_code_.empty()) {
-    u->language_code = user->lang_code_;
+  if (u->language_code.as_slice() != user->lang_code_ && !user->lang_code_.empty()) {
+    u->language_code = intern_string(user->lang_code_);
 
-    LOG(DEBUG) << "Language code has changed for " << user_id << " to " << u->language_code;
+    LOG(DEBUG) << "Language code has changed for " << user_id << " to " << u->language_code.as_slice();
     u->is_changed = true;
   }
 
@@ -2546,6 +2552,13 @@ void UserManager::on_get_users(vector<telegram_api::object_ptr<telegram_api::Use
   }
 }
 
+void UserManager::on_get_users(TlLazyVector<telegram_api::object_ptr<telegram_api::User>> &&users,
+                               const char *source) {
+  for (auto user : users) {
+    on_get_user(std::move(user), source);
+  }
+}
+
 void UserManager::on_binlog_user_event(BinlogEvent &&event) {
   if (!G()->use_chat_info_database()) {
     binlog_erase(G()->td_db()->get_binlog(), event.id_);
@@ -5227,7 +5240,7 @@ void UserManager::on_set_personal_channel(ChannelId channel_id, Promise<Unit> &&
 }
 
 void UserManager::set_emoji_status(const EmojiStatus &emoji_status, Promise<Unit> &&promise) {
-  if (!td_->option_manager_->get_option_boolean("is_premium")) {
+  if (!td_->option_manager_->get_option_boolean(CachedOption::IsPremium)) {
     return promise.set_error(Status::Error(400, "The method is available only to Telegram Premium users"));
   }
   add_recent_emoji_status(td_, emoji_status);
@@ -5647,7 +5660,7 @@ void UserManager::can_send_message_to_user(UserId user_id, bool force,
   }
   CHECK(user_id.is_valid());
   if ((u != nullptr && (!u->contact_require_premium || u->is_mutual_contact)) ||
-      td_->option_manager_->get_option_boolean("is_premium")) {
+      td_->option_manager_->get_option_boolean(CachedOption::IsPremium)) {
     return promise.set_value(td_api::make_object<td_api::canSendMessageToUserResultOk>());
   }
 
@@ -6695,7 +6708,12 @@ const UserManager::UserFull *UserManager::get_user_full(UserId user_id) const {
 }
 
 UserManager::UserFull *UserManager::get_user_full(UserId user_id) {
-  return users_full_.get_pointer(user_id);
+  auto user_full = users_full_.get_pointer(user_id);
+  if (user_full != nullptr) {
+    user_full->remove();
+    user_full_lru_list_.put(user_full);
+  }
+  return user_full;
 }
 
 UserManager::UserFull *UserManager::add_user_full(UserId user_id) {
@@ -6703,11 +6721,74 @@ UserManager::UserFull *UserManager::add_user_full(UserId user_id) {
   auto &user_full_ptr = users_full_[user_id];
   if (user_full_ptr == nullptr) {
     user_full_ptr = make_unique<UserFull>();
+    user_full_ptr->user_id = user_id;
+    user_full_lru_list_.put(user_full_ptr.get());
     user_full_contact_require_premium_.erase(user_id);
+    on_user_full_added();
   }
   return user_full_ptr.get();
 }
 
+size_t UserManager::get_user_full_info_count_max() const {
+  auto count_max = td_->option_manager_->get_option_integer("user_full_info_count_max", 100000);
+  return static_cast<size_t>(max(count_max, static_cast<int64>(1000)));
+}
+
+void UserManager::on_user_full_info_count_max_changed() {
+  on_user_full_added();
+}
+
+void UserManager::on_user_full_added() {
+  if (is_user_full_unload_pending_ || !G()->use_chat_info_database() ||
+      users_full_.calc_size() <= get_user_full_info_count_max()) {
+    return;
+  }
+  is_user_full_unload_pending_ = true;
+  send_closure_later(actor_id(this), &UserManager::unload_least_recently_used_user_fulls);
+}
+
+bool UserManager::can_unload_user_full(const UserFull *user_full) const {
+  // the object can be unloaded only if it can be loaded back from the database without losing changes
+  return !user_full->is_changed && !user_full->need_send_update && !user_full->need_save_to_database &&
+         !user_full->is_being_updated && user_full->user_id != get_my_id();
+}
+
+void UserManager::unload_least_recently_used_user_fulls() {
+  is_user_full_unload_pending_ = false;
+  if (G()->close_flag() || !G()->use_chat_info_database()) {
+    return;
+  }
+
+  auto count_max = get_user_full_info_count_max();
+  auto count = users_full_.calc_size();
+  if (count <= count_max) {
+    return;
+  }
+
+  // unload more objects than needed to avoid unloading them after each addition
+  auto target_count = count_max - count_max / 10;
+  auto *node = user_full_lru_list_.prev;
+  while (count > target_count && node != &user_full_lru_list_) {
+    auto *user_full = static_cast<UserFull *>(node);
+    node = node->prev;
+    if (can_unload_user_full(user_full)) {
+      unload_user_full(user_full);
+      count--;
+    }
+  }
+}
+
+void UserManager::unload_user_full(UserFull *user_full) {
+  auto user_id = user_full->user_id;
+  LOG(INFO) << "Unload full " << user_id;
+  if (user_full->file_source_id.is_valid()) {
+    // keep the file source and the files in it; the source will be reused after the object is loaded again
+    user_full_file_source_ids_.set(user_id, user_full->file_source_id);
+  }
+  unloaded_user_full_count_++;
+  users_full_.erase(user_id);
+}
+
 UserManager::UserFull *UserManager::get_user_full_force(UserId user_id, const char *source) {
   if (!have_user_force(user_id, source)) {
     return nullptr;
@@ -7466,7 +7547,7 @@ void UserManager::update_user(User *u, UserId user_id, bool from_binlog, bool fr
   };
 
   if (user_id == get_my_id()) {
-    if (td_->option_manager_->get_option_boolean("is_premium") != u->is_premium) {
+    if (td_->option_manager_->get_option_boolean(CachedOption::IsPremium) != u->is_premium) {
       td_->option_manager_->set_option_boolean("is_premium", u->is_premium);
       send_closure(td_->config_manager_, &ConfigManager::request_config, true);
       if (!td_->auth_manager_->is_bot()) {
@@ -7624,9 +7705,11 @@ void UserManager::update_user(User *u, UserId user_id, bool from_binlog, bool fr
       u->is_status_saved = false;
     }
     CHECK(u->is_update_user_sent);
-    send_closure(
-        G()->td(), &Td::send_update,
-        td_api::make_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u, unix_time)));
+    if (!td_->is_update_ignored(td_api::updateUserStatus::ID)) {
+      send_closure(
+          G()->td(), &Td::send_update,
+          td_api::make_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u, unix_time)));
+    }
     u->is_status_changed = false;
   }
   if (u->is_online_status_changed) {
@@ -7877,7 +7960,7 @@ td_api::object_ptr<td_api::user> UserManager::get_user_object(UserId user_id, co
       u->is_close_friend, u->is_verified, u->is_premium, u->is_support,
       get_restriction_reason_description(u->restriction_reasons), u->is_scam, u->is_fake,
       u->max_active_story_id.is_valid(), get_user_has_unread_stories(u), restricts_new_chats, have_access,
-      std::move(type), u->language_code, u->attach_menu_enabled);
+      std::move(type), u->language_code.as_slice().str(), u->attach_menu_enabled);
 }
 
 vector<int64> UserManager::get_user_ids_object(const vector<UserId> &user_ids, const char *source) const {
@@ -8071,4 +8154,20 @@ void UserManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &
   }
 }
 
+void UserManager::memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const {
+  output.push_back(PSTRING() << "UserManager: " << users_.calc_size() << " users, " << users_full_.calc_size()
+                             << " full users with limit " << get_user_full_info_count_max() << ", "
+                             << unloaded_user_full_count_ << " unloaded full users and " << secret_chats_.calc_size()
+                             << " secret chats");
+  auto users_usage = users_.memory_usage();
+  output.push_back(PSTRING() << "UserManager::users_: " << users_usage);
+  hash_table_usage += users_usage;
+  auto users_full_usage = users_full_.memory_usage();
+  output.push_back(PSTRING() << "UserManager::users_full_: " << users_full_usage);
+  hash_table_usage += users_full_usage;
+  auto secret_chats_usage = secret_chats_.memory_usage();
+  output.push_back(PSTRING() << "UserManager::secret_chats_: " << secret_chats_usage);
+  hash_table_usage += secret_chats_usage;
+}
+
 }  // namespace td
@@ -34,6 +34,8 @@
 #include "td/telegram/UserId.h"
 #include "td/telegram/Usernames.h"
 
+#include "td/tl/TlLazyVector.h"
+
 #include "td/actor/actor.h"
 #include "td/actor/MultiPromise.h"
 #include "td/actor/MultiTimeout.h"
@@ -43,7 +45,9 @@
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/Hints.h"
+#include "td/utils/List.h"
 #include "td/utils/Promise.h"
+#include "td/utils/SharedSlice.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/Time.h"
@@ -109,6 +113,8 @@ class UserManager final : public Actor {
 
   void on_get_users(vector<telegram_api::object_ptr<telegram_api::User>> &&users, const char *source);
 
+  void on_get_users(TlLazyVector<telegram_api::object_ptr<telegram_api::User>> &&users, const char *source);
+
   void on_binlog_user_event(BinlogEvent &&event);
 
   void on_binlog_secret_chat_event(BinlogEvent &&event);
@@ -168,6 +174,8 @@ class UserManager final : public Actor {
 
   void on_ignored_restriction_reasons_changed();
 
+  void on_user_full_info_count_max_changed();
+
   void invalidate_user_full(UserId user_id);
 
   bool have_user(UserId user_id) const;
@@ -465,6 +473,8 @@ class UserManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const;
+
  private:
   struct User {
     string first_name;
@@ -493,7 +503,7 @@ class UserManager final : public Actor {
     StoryId max_active_story_id;
     StoryId max_read_story_id;
 
-    string language_code;
+    SharedSlice language_code;  // interned
 
     FlatHashSet<int64> photo_ids;
 
@@ -563,7 +573,9 @@ class UserManager final : public Actor {
   };
 
   // do not forget to update drop_user_full and on_get_user_full
-  struct UserFull {
+  struct UserFull final : public ListNode {
+    UserId user_id;  // isn't saved to the database
+
     Photo photo;
     Photo fallback_photo;
     Photo personal_photo;
@@ -916,6 +928,16 @@ class UserManager final : public Actor {
 
   UserFull *add_user_full(UserId user_id);
 
+  size_t get_user_full_info_count_max() const;
+
+  void on_user_full_added();
+
+  bool can_unload_user_full(const UserFull *user_full) const;
+
+  void unload_least_recently_used_user_fulls();
+
+  void unload_user_full(UserFull *user_full);
+
   UserFull *get_user_full_force(UserId user_id, const char *source);
 
   void send_get_user_full_query(UserId user_id, telegram_api::object_ptr<telegram_api::InputUser> &&input_user,
@@ -1008,6 +1030,9 @@ class UserManager final : public Actor {
 
   WaitFreeHashMap<UserId, unique_ptr<User>, UserIdHash> users_;
   WaitFreeHashMap<UserId, unique_ptr<UserFull>, UserIdHash> users_full_;
+  ListNode user_full_lru_list_;  // the most recently used full users are in the beginning
+  int64 unloaded_user_full_count_ = 0;
+  bool is_user_full_unload_pending_ = false;
   WaitFreeHashMap<UserId, unique_ptr<UserPhotos>, UserIdHash> user_photos_;
   mutable FlatHashSet<UserId, UserIdHash> unknown_users_;
   WaitFreeHashMap<UserId, telegram_api::object_ptr<telegram_api::UserProfilePhoto>, UserIdHash> pending_user_photos_;
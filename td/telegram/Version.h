@@ -83,6 +83,7 @@ enum class DbVersion : int32 {
   StorePinnedDialogsInBinlog,
   AddMessageThreadSupport,
   AddMessageThreadDatabase,
+  AddMessageDataDictionaries,
   Next
 };
 
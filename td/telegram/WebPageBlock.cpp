@@ -58,7 +58,7 @@ struct GetWebPageBlockObjectContext {
 
   bool is_first_pass_ = true;
   bool has_anchor_urls_ = false;
-  std::unordered_map<Slice, const RichText *, SliceHash> anchors_;  // anchor -> text
+  std::unordered_map<Slice, bool, SliceHash> anchors_;  // anchor -> has_text
 };
 
 static vector<td_api::object_ptr<td_api::PageBlock>> get_page_blocks_object(
@@ -144,7 +144,7 @@ class RichText {
               }
               auto it = context->anchors_.find(anchor);
               if (it != context->anchors_.end()) {
-                if (it->second == nullptr) {
+                if (!it->second) {
                   return make_tl_object<td_api::richTextAnchorLink>(texts[0].get_rich_text_object(context),
                                                                     anchor.str(), content);
                 } else {
@@ -187,7 +187,7 @@ class RichText {
       }
       case RichText::Type::Anchor: {
         if (context->is_first_pass_) {
-          context->anchors_.emplace(Slice(content), texts[0].empty() ? nullptr : &texts[0]);
+          context->anchors_.emplace(Slice(content), !texts[0].empty());
         }
         if (texts[0].empty()) {
           return make_tl_object<td_api::richTextAnchor>(content);
@@ -803,7 +803,7 @@ class WebPageBlockAnchor final : public WebPageBlock {
 
   td_api::object_ptr<td_api::PageBlock> get_page_block_object(Context *context) const final {
     if (context->is_first_pass_) {
-      context->anchors_.emplace(name, nullptr);
+      context->anchors_.emplace(name, false);
     }
     return make_tl_object<td_api::pageBlockAnchor>(name);
   }
@@ -2440,6 +2440,10 @@ void parse_web_page_block(unique_ptr<WebPageBlock> &block, ParserT &parser) {
   block = WebPageBlock::parse(parser);
 }
 
+void store(const unique_ptr<WebPageBlock> &block, LogEventStorerBuffer &storer) {
+  store_web_page_block(block, storer);
+}
+
 void store(const unique_ptr<WebPageBlock> &block, LogEventStorerCalcLength &storer) {
   store_web_page_block(block, storer);
 }
@@ -2470,7 +2474,12 @@ vector<unique_ptr<WebPageBlock>> get_web_page_blocks(
 }
 
 vector<td_api::object_ptr<td_api::PageBlock>> get_page_blocks_object(
-    const vector<unique_ptr<WebPageBlock>> &page_blocks, Td *td, Slice base_url, Slice real_url) {
+    const vector<unique_ptr<WebPageBlock>> &page_blocks, Td *td, Slice base_url, Slice real_url,
+    WebPageBlockAnchors &anchors) {
+  if (anchors.is_inited_ && (anchors.base_url_ != base_url || anchors.real_url_ != real_url)) {
+    anchors = WebPageBlockAnchors();
+  }
+
   GetWebPageBlockObjectContext context;
   context.td_ = td;
   context.base_url_ = base_url;
@@ -2481,14 +2490,29 @@ vector<td_api::object_ptr<td_api::PageBlock>> get_page_blocks_object(
       context.real_url_rhash_ = string();
     }
   }
+  if (anchors.is_inited_ && anchors.has_anchor_urls_) {
+    // anchors are already known, so the first pass can be skipped
+    context.is_first_pass_ = false;
+    context.anchors_ = std::move(anchors.anchors_);
+    auto blocks = get_page_blocks_object(page_blocks, &context);
+    anchors.anchors_ = std::move(context.anchors_);
+    return blocks;
+  }
+
   auto blocks = get_page_blocks_object(page_blocks, &context);
+  anchors.is_inited_ = true;
+  anchors.has_anchor_urls_ = context.has_anchor_urls_;
+  anchors.base_url_ = base_url.str();
+  anchors.real_url_ = real_url.str();
   if (!context.has_anchor_urls_) {
     return blocks;
   }
 
   context.is_first_pass_ = false;
-  context.anchors_.emplace(Slice(), nullptr);  // back to top
-  return get_page_blocks_object(page_blocks, &context);
+  context.anchors_.emplace(Slice(), false);  // back to top
+  blocks = get_page_blocks_object(page_blocks, &context);
+  anchors.anchors_ = std::move(context.anchors_);
+  return blocks;
 }
 
 }  // namespace td
@@ -16,6 +16,8 @@
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/Slice.h"
 
+#include <unordered_map>
+
 namespace td {
 
 struct GetWebPageBlockObjectContext;
@@ -89,6 +91,8 @@ class WebPageBlock {
   virtual td_api::object_ptr<td_api::PageBlock> get_page_block_object(Context *context) const = 0;
 };
 
+void store(const unique_ptr<WebPageBlock> &block, LogEventStorerBuffer &storer);
+
 void store(const unique_ptr<WebPageBlock> &block, LogEventStorerCalcLength &storer);
 
 void store(const unique_ptr<WebPageBlock> &block, LogEventStorerUnsafe &storer);
@@ -101,7 +105,18 @@ vector<unique_ptr<WebPageBlock>> get_web_page_blocks(
     const FlatHashMap<int64, FileId> &documents, const FlatHashMap<int64, unique_ptr<Photo>> &photos,
     const FlatHashMap<int64, FileId> &videos, const FlatHashMap<int64, FileId> &voice_notes);
 
+// anchors found in page blocks during their first conversion to td_api objects, which allow to convert the blocks
+// in a single pass next time; keys reference the blocks, so the anchors must be reset whenever the blocks change
+struct WebPageBlockAnchors {
+  bool is_inited_ = false;
+  bool has_anchor_urls_ = false;
+  string base_url_;
+  string real_url_;
+  std::unordered_map<Slice, bool, SliceHash> anchors_;  // anchor -> has_text
+};
+
 vector<td_api::object_ptr<td_api::PageBlock>> get_page_blocks_object(
-    const vector<unique_ptr<WebPageBlock>> &page_blocks, Td *td, Slice base_url, Slice real_url);
+    const vector<unique_ptr<WebPageBlock>> &page_blocks, Td *td, Slice base_url, Slice real_url,
+    WebPageBlockAnchors &anchors);
 
 }  // namespace td
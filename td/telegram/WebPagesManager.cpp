@@ -46,6 +46,8 @@
 #include "td/db/SqliteKeyValue.h"
 #include "td/db/SqliteKeyValueAsync.h"
 
+#include "td/tl/tl_object_memory_usage.h"
+
 #include "td/utils/algorithm.h"
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
@@ -56,6 +58,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/utf8.h"
 
@@ -64,17 +67,12 @@
 namespace td {
 
 class GetWebPagePreviewQuery final : public Td::ResultHandler {
-  Promise<td_api::object_ptr<td_api::webPage>> promise_;
-  unique_ptr<WebPagesManager::GetWebPagePreviewOptions> options_;
+  string first_url_;
 
  public:
-  explicit GetWebPagePreviewQuery(Promise<td_api::object_ptr<td_api::webPage>> &&promise)
-      : promise_(std::move(promise)) {
-  }
-
   void send(const string &text, vector<tl_object_ptr<telegram_api::MessageEntity>> &&entities,
-            unique_ptr<WebPagesManager::GetWebPagePreviewOptions> &&options) {
-    options_ = std::move(options);
+            const string &first_url) {
+    first_url_ = first_url;
 
     int32 flags = 0;
     if (!entities.empty()) {
@@ -93,11 +91,11 @@ class GetWebPagePreviewQuery final : public Td::ResultHandler {
 
     auto ptr = result_ptr.move_as_ok();
     LOG(INFO) << "Receive result for GetWebPagePreviewQuery: " << to_string(ptr);
-    td_->web_pages_manager_->on_get_web_page_preview(std::move(options_), std::move(ptr), std::move(promise_));
+    td_->web_pages_manager_->on_get_web_page_preview(first_url_, std::move(ptr));
   }
 
   void on_error(Status status) final {
-    promise_.set_error(std::move(status));
+    td_->web_pages_manager_->on_get_web_page_preview_error(first_url_, std::move(status));
   }
 };
 
@@ -164,6 +162,7 @@ class WebPagesManager::WebPageInstantView {
   bool is_full_ = false;
   bool is_loaded_ = false;
   bool was_loaded_from_database_ = false;
+  mutable WebPageBlockAnchors anchors_;
 
   template <class StorerT>
   void store(StorerT &storer) const {
@@ -832,6 +831,11 @@ void WebPagesManager::on_get_web_page_by_url(const string &url, WebPageId web_pa
     return;
   }
   auto &cached_web_page_id = it->second.first;
+  if (web_page_id.is_valid()) {
+    empty_web_page_urls_.erase(url);
+  } else if (!from_database) {
+    add_empty_web_page_url(url);
+  }
   if (!from_database && G()->use_message_database() && (cached_web_page_id != web_page_id || is_inserted)) {
     if (web_page_id.is_valid()) {
       G()->td_db()->get_sqlite_pmc()->set(get_web_page_url_database_key(url), to_string(web_page_id.get()), Auto());
@@ -885,31 +889,69 @@ void WebPagesManager::unregister_web_page(WebPageId web_page_id, MessageFullId m
   }
 }
 
-void WebPagesManager::on_get_web_page_preview(unique_ptr<GetWebPagePreviewOptions> &&options,
-                                              tl_object_ptr<telegram_api::MessageMedia> &&message_media_ptr,
-                                              Promise<td_api::object_ptr<td_api::webPage>> &&promise) {
+void WebPagesManager::on_get_web_page_preview(const string &first_url,
+                                              tl_object_ptr<telegram_api::MessageMedia> &&message_media_ptr) {
   CHECK(message_media_ptr != nullptr);
   int32 constructor_id = message_media_ptr->get_id();
   if (constructor_id != telegram_api::messageMediaWebPage::ID) {
     if (constructor_id == telegram_api::messageMediaEmpty::ID) {
-      on_get_web_page_preview_success(std::move(options), WebPageId(), std::move(promise));
+      add_empty_web_page_url(first_url);
+      for (auto &request : extract_get_web_page_preview_requests(first_url)) {
+        on_get_web_page_preview_success(std::move(request.first), WebPageId(), std::move(request.second));
+      }
       return;
     }
 
     LOG(ERROR) << "Receive " << to_string(message_media_ptr) << " instead of web page";
-    return promise.set_error(Status::Error(500, "Receive not web page in GetWebPagePreview"));
+    return on_get_web_page_preview_error(first_url, Status::Error(500, "Receive not web page in GetWebPagePreview"));
   }
 
   auto message_media_web_page = move_tl_object_as<telegram_api::messageMediaWebPage>(message_media_ptr);
   CHECK(message_media_web_page->webpage_ != nullptr);
 
   auto web_page_id = on_get_web_page(std::move(message_media_web_page->webpage_), DialogId());
+  auto requests = extract_get_web_page_preview_requests(first_url);
   if (web_page_id.is_valid() && !have_web_page(web_page_id)) {
-    pending_get_web_pages_[web_page_id].emplace_back(std::move(options), std::move(promise));
+    append(pending_get_web_pages_[web_page_id], std::move(requests));
     return;
   }
 
-  on_get_web_page_preview_success(std::move(options), web_page_id, std::move(promise));
+  for (auto &request : requests) {
+    on_get_web_page_preview_success(std::move(request.first), web_page_id, std::move(request.second));
+  }
+}
+
+void WebPagesManager::on_get_web_page_preview_error(const string &first_url, Status &&error) {
+  for (auto &request : extract_get_web_page_preview_requests(first_url)) {
+    request.second.set_error(error.clone());
+  }
+}
+
+vector<WebPagesManager::GetWebPagePreviewRequest>
+WebPagesManager::extract_get_web_page_preview_requests(const string &first_url) {
+  auto it = get_web_page_preview_queries_.find(first_url);
+  CHECK(it != get_web_page_preview_queries_.end());
+  auto requests = std::move(it->second);
+  get_web_page_preview_queries_.erase(it);
+  return requests;
+}
+
+void WebPagesManager::add_empty_web_page_url(const string &url) {
+  if (!url.empty()) {
+    empty_web_page_urls_[url] = Time::now() + EMPTY_WEB_PAGE_URL_CACHE_TIME;
+  }
+}
+
+bool WebPagesManager::is_empty_web_page_url(const string &url) {
+  auto it = empty_web_page_urls_.find(url);
+  if (it == empty_web_page_urls_.end()) {
+    return false;
+  }
+  if (it->second < Time::now()) {
+    empty_web_page_urls_.erase(it);
+    return false;
+  }
+  return true;
 }
 
 void WebPagesManager::on_get_web_page_preview_success(unique_ptr<GetWebPagePreviewOptions> &&options,
@@ -955,17 +997,28 @@ void WebPagesManager::get_web_page_preview(td_api::object_ptr<td_api::formattedT
                                                  link_preview_options->force_large_media_, skip_confirmation,
                                                  link_preview_options->show_above_text_));
   }
+  if (is_empty_web_page_url(url)) {
+    LOG(INFO) << "The URL \"" << url << "\" has no web page preview";
+    return promise.set_value(nullptr);
+  }
   if (!link_preview_options->url_.empty()) {
     formatted_text.text = link_preview_options->url_, formatted_text.entities.clear();
   }
   auto options = make_unique<GetWebPagePreviewOptions>();
-  options->first_url_ = std::move(url);
+  options->first_url_ = url;
   options->skip_confirmation_ = skip_confirmation;
   options->link_preview_options_ = std::move(link_preview_options);
-  td_->create_handler<GetWebPagePreviewQuery>(std::move(promise))
-      ->send(formatted_text.text,
-             get_input_message_entities(td_->user_manager_.get(), formatted_text.entities, "get_web_page_preview"),
-             std::move(options));
+
+  // requests for the same URL are merged, because the preview depends only on the URL
+  auto &requests = get_web_page_preview_queries_[url];
+  requests.emplace_back(std::move(options), std::move(promise));
+  if (requests.size() > 1) {
+    LOG(INFO) << "Wait for the preview of \"" << url << "\" requested before";
+    return;
+  }
+  td_->create_handler<GetWebPagePreviewQuery>()->send(
+      formatted_text.text,
+      get_input_message_entities(td_->user_manager_.get(), formatted_text.entities, "get_web_page_preview"), url);
 }
 
 void WebPagesManager::get_web_page_instant_view(const string &url, bool force_full, Promise<WebPageId> &&promise) {
@@ -977,7 +1030,10 @@ void WebPagesManager::get_web_page_instant_view(const string &url, bool force_fu
   if (it != url_to_web_page_id_.end()) {
     auto web_page_id = it->second.first;
     if (web_page_id == WebPageId()) {
-      // ignore negative caching
+      if (is_empty_web_page_url(url)) {
+        return promise.set_value(WebPageId());
+      }
+      // ignore outdated negative caching
       return reload_web_page_by_url(url, std::move(promise));
     }
     return get_web_page_instant_view_impl(web_page_id, force_full, std::move(promise));
@@ -1209,6 +1265,9 @@ void WebPagesManager::get_web_page_by_url(const string &url, Promise<WebPageId>
 
   auto it = url_to_web_page_id_.find(url);
   if (it != url_to_web_page_id_.end()) {
+    if (it->second.first == WebPageId() && !is_empty_web_page_url(url)) {
+      return reload_web_page_by_url(url, std::move(promise));
+    }
     return promise.set_value(WebPageId(it->second.first));
   }
 
@@ -1291,7 +1350,35 @@ void WebPagesManager::on_load_web_page_by_url_from_database(WebPageId web_page_i
 
 void WebPagesManager::reload_web_page_by_url(const string &url, Promise<WebPageId> &&promise) {
   TRY_STATUS_PROMISE(promise, G()->close_status());
-  td_->create_handler<GetWebPageQuery>(std::move(promise))->send(WebPageId(), url, 0);
+  if (url.empty()) {
+    return promise.set_value(WebPageId());
+  }
+
+  auto &promises = reload_web_page_by_url_queries_[url];
+  promises.push_back(std::move(promise));
+  if (promises.size() > 1) {
+    LOG(INFO) << "Wait for reload of \"" << url << "\" started before";
+    return;
+  }
+
+  auto query_promise = PromiseCreator::lambda([actor_id = actor_id(this), url](Result<WebPageId> r_web_page_id) {
+    send_closure(actor_id, &WebPagesManager::on_reload_web_page_by_url, url, std::move(r_web_page_id));
+  });
+  td_->create_handler<GetWebPageQuery>(std::move(query_promise))->send(WebPageId(), url, 0);
+}
+
+void WebPagesManager::on_reload_web_page_by_url(const string &url, Result<WebPageId> r_web_page_id) {
+  auto it = reload_web_page_by_url_queries_.find(url);
+  CHECK(it != reload_web_page_by_url_queries_.end());
+  auto promises = std::move(it->second);
+  reload_web_page_by_url_queries_.erase(it);
+  if (r_web_page_id.is_error()) {
+    fail_promises(promises, r_web_page_id.move_as_error());
+  } else {
+    for (auto &promise : promises) {
+      promise.set_value(WebPageId(r_web_page_id.ok()));
+    }
+  }
 }
 
 bool WebPagesManager::have_web_page(WebPageId web_page_id) const {
@@ -1490,7 +1577,8 @@ tl_object_ptr<td_api::webPageInstantView> WebPagesManager::get_web_page_instant_
   auto feedback_link = td_api::make_object<td_api::internalLinkTypeBotStart>(
       "previews", PSTRING() << "webpage" << web_page_id.get(), true);
   return td_api::make_object<td_api::webPageInstantView>(
-      get_page_blocks_object(web_page_instant_view->page_blocks_, td_, web_page_instant_view->url_, web_page_url),
+      get_page_blocks_object(web_page_instant_view->page_blocks_, td_, web_page_instant_view->url_, web_page_url,
+                             web_page_instant_view->anchors_),
       web_page_instant_view->view_count_, web_page_instant_view->is_v2_ ? 2 : 1, web_page_instant_view->is_rtl_,
       web_page_instant_view->is_full_, std::move(feedback_link));
 }
@@ -1688,6 +1776,7 @@ void WebPagesManager::on_get_web_page_instant_view(WebPage *web_page, tl_object_
             << " photos, " << videos.size() << " videos and " << voice_notes.size() << " voice notes";
   web_page->instant_view_.page_blocks_ =
       get_web_page_blocks(td_, std::move(page->blocks_), animations, audios, documents, photos, videos, voice_notes);
+  web_page->instant_view_.anchors_ = WebPageBlockAnchors();
   web_page->instant_view_.view_count_ = page->views_;
   web_page->instant_view_.is_v2_ = page->v2_;
   web_page->instant_view_.is_rtl_ = page->rtl_;
@@ -2010,4 +2099,30 @@ vector<FileId> WebPagesManager::get_web_page_file_ids(const WebPage *web_page) c
   return result;
 }
 
+void WebPagesManager::memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const {
+  size_t pending_count = 0;
+  size_t pending_memory_usage = 0;
+  for (auto &it : pending_get_web_pages_) {
+    for (auto &query : it.second) {
+      pending_count++;
+      pending_memory_usage += tl_extra_memory_usage(query.first->link_preview_options_);
+    }
+  }
+  for (auto &it : get_web_page_preview_queries_) {
+    for (auto &query : it.second) {
+      pending_count++;
+      pending_memory_usage += tl_extra_memory_usage(query.first->link_preview_options_);
+    }
+  }
+  output.push_back(PSTRING() << "WebPagesManager: " << web_pages_.calc_size() << " web pages, "
+                             << url_to_web_page_id_.size() << " cached URLs and " << pending_count
+                             << " pending link preview requests with TL objects of size " << pending_memory_usage);
+  auto web_pages_usage = web_pages_.memory_usage();
+  output.push_back(PSTRING() << "WebPagesManager::web_pages_: " << web_pages_usage);
+  hash_table_usage += web_pages_usage;
+  auto url_to_web_page_id_usage = url_to_web_page_id_.memory_usage();
+  output.push_back(PSTRING() << "WebPagesManager::url_to_web_page_id_: " << url_to_web_page_id_usage);
+  hash_table_usage += url_to_web_page_id_usage;
+}
+
 }  // namespace td
@@ -23,6 +23,7 @@
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashSet.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
@@ -88,9 +89,9 @@ class WebPagesManager final : public Actor {
 
   void reload_web_page_by_url(const string &url, Promise<WebPageId> &&promise);
 
-  void on_get_web_page_preview(unique_ptr<GetWebPagePreviewOptions> &&options,
-                               tl_object_ptr<telegram_api::MessageMedia> &&message_media_ptr,
-                               Promise<td_api::object_ptr<td_api::webPage>> &&promise);
+  void on_get_web_page_preview(const string &first_url, tl_object_ptr<telegram_api::MessageMedia> &&message_media_ptr);
+
+  void on_get_web_page_preview_error(const string &first_url, Status &&error);
 
   void on_binlog_web_page_event(BinlogEvent &&event);
 
@@ -108,6 +109,8 @@ class WebPagesManager final : public Actor {
 
   void on_story_changed(StoryFullId story_full_id);
 
+  void memory_stats(vector<string> &output, HashTableMemoryUsage &hash_table_usage) const;
+
  private:
   class WebPage;
 
@@ -134,6 +137,11 @@ class WebPagesManager final : public Actor {
   tl_object_ptr<td_api::webPageInstantView> get_web_page_instant_view_object(
       WebPageId web_page_id, const WebPageInstantView *web_page_instant_view, Slice web_page_url) const;
 
+  static constexpr double EMPTY_WEB_PAGE_URL_CACHE_TIME = 300.0;  // time during which an empty URL isn't rechecked
+
+  using GetWebPagePreviewRequest =
+      std::pair<unique_ptr<GetWebPagePreviewOptions>, Promise<td_api::object_ptr<td_api::webPage>>>;
+
   static void on_pending_web_page_timeout_callback(void *web_pages_manager_ptr, int64 web_page_id_int);
 
   void on_pending_web_page_timeout(WebPageId web_page_id);
@@ -141,6 +149,12 @@ class WebPagesManager final : public Actor {
   void on_get_web_page_preview_success(unique_ptr<GetWebPagePreviewOptions> &&options, WebPageId web_page_id,
                                        Promise<td_api::object_ptr<td_api::webPage>> &&promise);
 
+  vector<GetWebPagePreviewRequest> extract_get_web_page_preview_requests(const string &first_url);
+
+  void add_empty_web_page_url(const string &url);
+
+  bool is_empty_web_page_url(const string &url);
+
   void on_get_web_page_instant_view(WebPage *web_page, tl_object_ptr<telegram_api::page> &&page, int32 hash,
                                     DialogId owner_dialog_id);
 
@@ -176,6 +190,8 @@ class WebPagesManager final : public Actor {
   void on_load_web_page_by_url_from_database(WebPageId web_page_id, string url, Promise<WebPageId> &&promise,
                                              Result<Unit> &&result);
 
+  void on_reload_web_page_by_url(const string &url, Result<WebPageId> r_web_page_id);
+
   void tear_down() final;
 
   int32 get_web_page_media_duration(const WebPage *web_page) const;
@@ -199,15 +215,18 @@ class WebPagesManager final : public Actor {
 
   FlatHashMap<WebPageId, FlatHashSet<MessageFullId, MessageFullIdHash>, WebPageIdHash> web_page_messages_;
 
-  FlatHashMap<WebPageId,
-              vector<std::pair<unique_ptr<GetWebPagePreviewOptions>, Promise<td_api::object_ptr<td_api::webPage>>>>,
-              WebPageIdHash>
-      pending_get_web_pages_;
+  FlatHashMap<WebPageId, vector<GetWebPagePreviewRequest>, WebPageIdHash> pending_get_web_pages_;
+
+  FlatHashMap<string, vector<GetWebPagePreviewRequest>> get_web_page_preview_queries_;  // first URL -> requests
+
+  FlatHashMap<string, vector<Promise<WebPageId>>> reload_web_page_by_url_queries_;
 
   FlatHashMap<StoryFullId, FlatHashSet<WebPageId, WebPageIdHash>, StoryFullIdHash> story_web_pages_;
 
   FlatHashMap<string, std::pair<WebPageId, bool>> url_to_web_page_id_;  // URL -> [WebPageId, from_database]
 
+  FlatHashMap<string, double> empty_web_page_urls_;  // URL without web page -> time until which it isn't rechecked
+
   FlatHashMap<string, FileSourceId> url_to_file_source_id_;
 
   MultiTimeout pending_web_pages_timeout_{"PendingWebPagesTimeout"};
@@ -17,6 +17,7 @@
 #include "memprof/memprof.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/AllocationTags.h"
 #include "td/utils/base64.h"
 #include "td/utils/buffer.h"
 #include "td/utils/CombinedLog.h"
@@ -88,7 +89,8 @@ static void dump_memory_usage() {
     int cnt = 0;
     for (auto &info : alloc_info) {
       if (cnt++ < 50) {
-        LOG(WARNING) << format::as_size(info.size) << format::as_array(info.backtrace);
+        LOG(WARNING) << format::as_size(info.size) << ' ' << AllocationTags::get_tag_name(info.tag_id)
+                     << format::as_array(info.backtrace);
       } else {
         other_size += info.size;
       }
@@ -98,6 +100,9 @@ static void dump_memory_usage() {
     LOG(WARNING) << tag("total", format::as_size(total_size));
     LOG(WARNING) << tag("total traces", get_ht_size());
     LOG(WARNING) << tag("fast_backtrace_success_rate", get_fast_backtrace_success_rate());
+    if (AllocationTags::is_enabled()) {
+      LOG(WARNING) << "Allocations by actor:\n" << AllocationTags::get_top_tags_string(50);
+    }
   }
 }
 
@@ -2500,6 +2505,21 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::confirmQrCodeAuthentication>(args));
     } else if (op == "gcs") {
       send_request(td_api::make_object<td_api::getCurrentState>());
+    } else if (op == "suf") {
+      send_request(td_api::make_object<td_api::setUpdateFilter>(to_integers<int32>(args)));
+    } else if (op == "sdbs") {
+      int32 cache_size;
+      int64 mmap_size;
+      string synchronous;
+      string temp_store;
+      int32 wal_autocheckpoint;
+      int32 page_size;
+      bool compress_message_data;
+      get_args(args, cache_size, mmap_size, synchronous, temp_store, wal_autocheckpoint, page_size,
+               compress_message_data);
+      send_request(td_api::make_object<td_api::setDatabaseSettings>(cache_size, mmap_size, synchronous, temp_store,
+                                                                    wal_autocheckpoint, page_size,
+                                                                    compress_message_data));
     } else if (op == "raea") {
       send_request(td_api::make_object<td_api::resetAuthenticationEmailAddress>());
     } else if (op == "rapr") {
@@ -3471,6 +3491,22 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::getStorageStatisticsFast>());
     } else if (op == "database") {
       send_request(td_api::make_object<td_api::getDatabaseStatistics>());
+    } else if (op == "optimize_database" || op == "optimize_database_full") {
+      send_request(td_api::make_object<td_api::optimizeDatabase>(op == "optimize_database_full"));
+    } else if (op == "memory") {
+      send_request(td_api::make_object<td_api::getMemoryStatistics>());
+    } else if (op == "network_latency") {
+      send_request(td_api::make_object<td_api::getNetworkRequestLatencyStatistics>());
+    } else if (op == "storage_latency") {
+      send_request(td_api::make_object<td_api::getStorageLatencyStatistics>());
+    } else if (op == "startup_stats") {
+      send_request(td_api::make_object<td_api::getStartupStatistics>());
+    } else if (op == "tts") {
+      bool is_enabled;
+      get_args(args, is_enabled);
+      execute(td_api::make_object<td_api::toggleTraceSpans>(is_enabled));
+    } else if (op == "gts") {
+      execute(td_api::make_object<td_api::getTraceSpans>());
     } else if (op == "optimize_storage" || op == "optimize_storage_all") {
       string chat_ids;
       string exclude_chat_ids;
@@ -6839,6 +6875,15 @@ class CliClient final : public Actor {
       } else {
         execute(std::move(request));
       }
+    } else if (op == "sltrl") {
+      string tag;
+      int32 max_message_count_per_second;
+      int32 sampling_rate;
+      get_args(args, tag, max_message_count_per_second, sampling_rate);
+      execute(td_api::make_object<td_api::setLogTagRateLimit>(tag, max_message_count_per_second, sampling_rate));
+    } else if (op == "gltrl") {
+      const string &tag = args;
+      execute(td_api::make_object<td_api::getLogTagRateLimit>(tag));
     } else if (op == "alog" || op == "aloge") {
       int32 level;
       string text;
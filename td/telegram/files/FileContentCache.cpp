@@ -0,0 +1,75 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileContentCache.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+constexpr int64 FileContentCache::MAX_FILE_SIZE;
+
+void FileContentCache::set_max_size(int64 max_size) {
+  max_size_ = max(max_size, static_cast<int64>(0));
+  evict();
+}
+
+const string *FileContentCache::get(const FullLocalFileLocation &location) {
+  auto it = entries_.find(location.path_);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  auto *entry = it->second.get();
+  if (entry->mtime_nsec_ != location.mtime_nsec_) {
+    do_remove(location.path_);
+    return nullptr;
+  }
+  entry->remove();
+  lru_list_.put(entry);
+  return &entry->content_;
+}
+
+void FileContentCache::add(const FullLocalFileLocation &location, string content) {
+  if (location.path_.empty() || static_cast<int64>(content.size()) > MAX_FILE_SIZE ||
+      static_cast<int64>(content.size()) > max_size_) {
+    return;
+  }
+  do_remove(location.path_);
+
+  auto entry = make_unique<Entry>();
+  entry->path_ = location.path_;
+  entry->mtime_nsec_ = location.mtime_nsec_;
+  entry->content_ = std::move(content);
+  size_ += static_cast<int64>(entry->content_.size());
+  lru_list_.put(entry.get());
+  entries_[location.path_] = std::move(entry);
+  evict();
+}
+
+void FileContentCache::remove(const string &path) {
+  do_remove(path);
+}
+
+void FileContentCache::do_remove(const string &path) {
+  auto it = entries_.find(path);
+  if (it == entries_.end()) {
+    return;
+  }
+  size_ -= static_cast<int64>(it->second->content_.size());
+  entries_.erase(it);
+}
+
+void FileContentCache::evict() {
+  while (size_ > max_size_) {
+    auto *entry = static_cast<Entry *>(lru_list_.get());
+    CHECK(entry != nullptr);
+    auto path = entry->path_;
+    LOG(DEBUG) << "Evict content of file " << path << " from cache";
+    do_remove(path);
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,56 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/FileLocation.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/List.h"
+
+namespace td {
+
+// LRU cache of contents of small local files, for example thumbnails and stickers, limited by total size
+class FileContentCache {
+ public:
+  static constexpr int64 MAX_FILE_SIZE = 1 << 17;
+
+  void set_max_size(int64 max_size);
+
+  // returns nullptr if the file content isn't cached or the file has changed since caching
+  const string *get(const FullLocalFileLocation &location);
+
+  void add(const FullLocalFileLocation &location, string content);
+
+  void remove(const string &path);
+
+  int64 get_size() const {
+    return size_;
+  }
+
+  size_t get_file_count() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry final : public ListNode {
+    string path_;
+    uint64 mtime_nsec_ = 0;
+    string content_;
+  };
+
+  FlatHashMap<string, unique_ptr<Entry>> entries_;
+  ListNode lru_list_;  // the most recently used entries are in the beginning
+  int64 size_ = 0;
+  int64 max_size_ = 0;
+
+  void do_remove(const string &path);
+
+  void evict();
+};
+
+}  // namespace td
@@ -20,6 +20,8 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/BloomFilter.h"
+#include "td/utils/crypto.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
@@ -29,11 +31,14 @@
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 
+#include <mutex>
+
 namespace td {
 
 Status drop_file_db(SqliteDb &db, int32 version) {
   LOG(WARNING) << "Drop file_db " << tag("version", version) << tag("current_db_version", current_db_version());
   TRY_STATUS(SqliteKeyValue::drop(db, "files"));
+  TRY_STATUS(SqliteKeyValue::drop(db, "file_gc"));
   return Status::OK();
 }
 
@@ -53,6 +58,8 @@ Status init_file_db(SqliteDb &db, int32 version) {
   if (version == 0) {
     TRY_STATUS(SqliteKeyValue::init(db, "files"));
   }
+  // the index of files for garbage collection is rebuilt during the next full scan of files
+  TRY_STATUS(SqliteKeyValue::init(db, "file_gc"));
   return Status::OK();
 }
 
@@ -75,6 +82,33 @@ class FileDb final : public FileDbInterface {
       promise.set_result(load_file_data_impl(actor_id(this), file_pmc(), key, max_file_db_id_));
     }
 
+    void load_file_hash(const string &key, Promise<string> promise) {
+      auto hash = file_pmc().get(key);
+      if (hash.empty()) {
+        return promise.set_error(Status::Error("There is no such key in the database"));
+      }
+      promise.set_value(std::move(hash));
+    }
+
+    void store_file_hash(const string &key, const string &hash) {
+      file_pmc().set(key, hash);
+    }
+
+    void build_key_filter(Promise<BloomFilter> promise) {
+      vector<uint64> key_hashes;
+      file_pmc().get_by_prefix("", [&key_hashes](Slice key, Slice value) {
+        key_hashes.push_back(get_key_hash(key));
+        return true;
+      });
+      LOG(INFO) << "Build filter of " << key_hashes.size() << " keys in file database";
+
+      BloomFilter filter(key_hashes.size() * 2);
+      for (auto key_hash : key_hashes) {
+        filter.add(key_hash);
+      }
+      promise.set_value(std::move(filter));
+    }
+
     void clear_file_data(FileDbId file_db_id, const string &remote_key, const string &local_key,
                          const string &generate_key) {
       auto &pmc = file_pmc();
@@ -171,6 +205,7 @@ class FileDb final : public FileDbInterface {
     max_file_db_id_ = FileDbId(to_integer<uint64>(file_kv_safe_->get().get("file_id")));
     file_db_actor_ =
         create_actor_on_scheduler<FileDbActor>("FileDbActor", scheduler_id, max_file_db_id_, file_kv_safe_);
+    build_key_filter();
   }
 
   FileDbId get_next_file_db_id() final {
@@ -183,10 +218,16 @@ class FileDb final : public FileDbInterface {
   }
 
   void get_file_data_impl(string key, Promise<FileData> promise) final {
+    if (!may_have_key(key)) {
+      return promise.set_error(Status::Error("There is no such key in the database"));
+    }
     send_closure(file_db_actor_, &FileDbActor::load_file_data, std::move(key), std::move(promise));
   }
 
   Result<FileData> get_file_data_sync_impl(string key) final {
+    if (!may_have_key(key)) {
+      return Status::Error("There is no such key in the database");
+    }
     return load_file_data_impl(file_db_actor_.get(), file_kv_safe_->get(), key, max_file_db_id_);
   }
 
@@ -224,6 +265,11 @@ class FileDb final : public FileDbInterface {
     //            << tag("remote_key", format::as_hex_dump<4>(Slice(remote_key)))
     //            << tag("local_key", format::as_hex_dump<4>(Slice(local_key)))
     //            << tag("generate_key", format::as_hex_dump<4>(Slice(generate_key)));
+    for (auto *key : {&remote_key, &local_key, &generate_key}) {
+      if (!key->empty()) {
+        add_key(*key);
+      }
+    }
     send_closure(file_db_actor_, &FileDbActor::store_file_data, file_db_id, serialize(file_data), remote_key, local_key,
                  generate_key);
   }
@@ -231,6 +277,19 @@ class FileDb final : public FileDbInterface {
   void set_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) final {
     send_closure(file_db_actor_, &FileDbActor::store_file_data_ref, file_db_id, new_file_db_id);
   }
+
+  void get_file_hash(string key, Promise<string> promise) final {
+    if (!may_have_key(key)) {
+      return promise.set_error(Status::Error("There is no such key in the database"));
+    }
+    send_closure(file_db_actor_, &FileDbActor::load_file_hash, std::move(key), std::move(promise));
+  }
+
+  void set_file_hash(string key, string hash) final {
+    add_key(key);
+    send_closure(file_db_actor_, &FileDbActor::store_file_hash, std::move(key), std::move(hash));
+  }
+
   SqliteKeyValue &pmc() final {
     return file_kv_safe_->get();
   }
@@ -240,6 +299,71 @@ class FileDb final : public FileDbInterface {
   FileDbId max_file_db_id_;
   std::shared_ptr<SqliteKeyValueSafe> file_kv_safe_;
 
+  // filter of all keys in the database, which allows to answer most lookups of absent locations without queries;
+  // it is built in background and rebuilt when it becomes overfull, because keys can't be removed from it
+  struct KeyFilter {
+    std::mutex mutex_;
+    BloomFilter filter_;
+    bool is_ready_ = false;
+    bool is_building_ = false;
+    vector<uint64> added_key_hashes_;  // keys added after the build has begun
+  };
+  std::shared_ptr<KeyFilter> key_filter_ = std::make_shared<KeyFilter>();
+
+  static uint64 get_key_hash(Slice key) {
+    return crc64(key);
+  }
+
+  void build_key_filter() {
+    {
+      std::lock_guard<std::mutex> guard(key_filter_->mutex_);
+      if (key_filter_->is_building_) {
+        return;
+      }
+      key_filter_->is_building_ = true;
+    }
+    // all keys, which are added before the build begins, are already sent to the actor and will be found
+    send_closure(file_db_actor_, &FileDbActor::build_key_filter,
+                 PromiseCreator::lambda([key_filter = key_filter_](Result<BloomFilter> r_filter) {
+                   std::lock_guard<std::mutex> guard(key_filter->mutex_);
+                   key_filter->is_building_ = false;
+                   if (r_filter.is_error()) {
+                     key_filter->added_key_hashes_.clear();
+                     return;
+                   }
+                   auto filter = r_filter.move_as_ok();
+                   for (auto key_hash : key_filter->added_key_hashes_) {
+                     filter.add(key_hash);
+                   }
+                   key_filter->added_key_hashes_.clear();
+                   key_filter->filter_ = std::move(filter);
+                   key_filter->is_ready_ = true;
+                 }));
+  }
+
+  bool may_have_key(const string &key) {
+    std::lock_guard<std::mutex> guard(key_filter_->mutex_);
+    return !key_filter_->is_ready_ || key_filter_->filter_.may_contain(get_key_hash(key));
+  }
+
+  void add_key(const string &key) {
+    auto key_hash = get_key_hash(key);
+    bool need_rebuild = false;
+    {
+      std::lock_guard<std::mutex> guard(key_filter_->mutex_);
+      if (key_filter_->is_building_) {
+        key_filter_->added_key_hashes_.push_back(key_hash);
+      }
+      if (key_filter_->is_ready_) {
+        key_filter_->filter_.add(key_hash);
+        need_rebuild = key_filter_->filter_.size() > key_filter_->filter_.capacity();
+      }
+    }
+    if (need_rebuild) {
+      build_key_filter();
+    }
+  }
+
   static Result<FileData> load_file_data_impl(ActorId<FileDbActor> file_db_actor_id, SqliteKeyValue &pmc,
                                               const string &key, FileDbId max_file_db_id) {
     // LOG(DEBUG) << "Load by key " << format::as_hex_dump<4>(Slice(key));
@@ -294,6 +418,10 @@ class FileDb final : public FileDbInterface {
   }
 };
 
+string FileDbInterface::get_file_hash_key(Slice path, int64 size, uint64 mtime_nsec) {
+  return PSTRING() << "hash" << size << '#' << mtime_nsec << '#' << path;
+}
+
 std::shared_ptr<FileDbInterface> create_file_db(std::shared_ptr<SqliteConnectionSafe> connection, int scheduler_id) {
   auto kv = std::make_shared<SqliteKeyValueSafe>("files", std::move(connection));
   return std::make_shared<FileDb>(std::move(kv), scheduler_id);
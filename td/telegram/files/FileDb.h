@@ -13,6 +13,7 @@
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 #include "td/utils/tl_storers.h"
 
@@ -80,6 +81,11 @@ class FileDbInterface {
                              bool new_generate) = 0;
   virtual void set_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) = 0;
 
+  // SHA-256 hashes of local files, which are used for uploading of files by hash
+  static string get_file_hash_key(Slice path, int64 size, uint64 mtime_nsec);
+  virtual void get_file_hash(string key, Promise<string> promise) = 0;
+  virtual void set_file_hash(string key, string hash) = 0;
+
   // For FileStatsWorker. TODO: remove it
   virtual SqliteKeyValue &pmc() = 0;
 
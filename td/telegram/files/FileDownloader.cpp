@@ -9,6 +9,7 @@
 #include "td/telegram/FileReferenceManager.h"
 #include "td/telegram/files/FileLoaderUtils.h"
 #include "td/telegram/files/FileType.h"
+#include "td/telegram/files/SharedFileStore.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/SecureStorage.h"
@@ -20,11 +21,13 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/Promise.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/UInt.h"
@@ -81,6 +84,7 @@ Result<FileLoader::FileInfo> FileDownloader::init() {
         if (encryption_key_.is_secret()) {
           encryption_key_.mutable_iv() = as<UInt256>(partial.iv_.data());
           next_part_ = narrow_cast<int32>(bitmask.get_ready_parts(0));
+          next_decrypted_part_ = next_part_;
         }
         fd_ = result_fd.move_as_ok();
         part_size = static_cast<int32>(partial.part_size_);
@@ -104,6 +108,22 @@ Result<FileLoader::FileInfo> FileDownloader::init() {
       }
     }
   }
+  if (need_search_file_ && fd_.empty() && size_ > 0 && encryption_key_.empty() && !remote_.is_web() &&
+      G()->get_option_boolean("use_shared_file_store")) {
+    auto shared_path = SharedFileStore::get_file(remote_, size_);
+    if (!shared_path.empty()) {
+      auto status = copy_shared_file(shared_path);
+      if (status.is_ok()) {
+        need_check_ = true;
+        is_shared_copy_ = true;
+        part_size = 128 * (1 << 10);
+        bitmask = Bitmask{Bitmask::Ones{}, (size_ + part_size - 1) / part_size};
+        LOG(INFO) << "Copy file downloaded by another client from " << shared_path << " to " << path_;
+      } else {
+        LOG(WARNING) << "Failed to copy shared file " << shared_path << ": " << status;
+      }
+    }
+  }
 
   FileInfo res;
   res.size = size_;
@@ -111,7 +131,7 @@ Result<FileLoader::FileInfo> FileDownloader::init() {
   res.part_size = part_size;
   res.ready_parts = bitmask.as_vector();
   res.use_part_count_limit = false;
-  res.only_check = only_check_;
+  res.only_check = only_check_ || is_shared_copy_;
   auto file_type = get_main_file_type(remote_.file_type_);
   res.need_delay =
       !is_small_ &&
@@ -123,6 +143,22 @@ Result<FileLoader::FileInfo> FileDownloader::init() {
   return res;
 }
 
+Status FileDownloader::copy_shared_file(CSlice shared_path) {
+  TRY_RESULT(file_path, open_temp_file(remote_.file_type_));
+  FileFd fd;
+  string tmp_path;
+  std::tie(fd, tmp_path) = std::move(file_path);
+  fd.close();
+  auto status = copy_file(shared_path, tmp_path, size_);
+  if (status.is_error()) {
+    unlink(tmp_path).ignore();
+    return status;
+  }
+  TRY_RESULT_ASSIGN(fd_, FileFd::open(tmp_path, FileFd::Write | FileFd::Read));
+  path_ = std::move(tmp_path);
+  return Status::OK();
+}
+
 Status FileDownloader::on_ok(int64 size) {
   std::string path;
   fd_.close();
@@ -141,6 +177,9 @@ Status FileDownloader::on_ok(int64 size) {
   } else {
     TRY_RESULT_ASSIGN(path, create_from_temp(remote_.file_type_, path_, name_));
   }
+  if (encryption_key_.empty() && G()->get_option_boolean("use_shared_file_store")) {
+    SharedFileStore::add_file(remote_, size, path);
+  }
   callback_->on_ok(FullLocalFileLocation(remote_.file_type_, std::move(path), 0), size, !only_check_);
   return Status::OK();
 }
@@ -298,7 +337,7 @@ Status FileDownloader::check_net_query(NetQueryPtr &net_query) {
   return Status::OK();
 }
 
-Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
+Result<BufferSlice> FileDownloader::fetch_part_bytes(Part part, NetQueryPtr net_query) {
   TRY_STATUS(check_net_query(net_query));
 
   BufferSlice bytes;
@@ -339,10 +378,9 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
     return Status::Error("Part size is more than requested");
   }
   if (bytes.empty()) {
-    return 0;
+    return std::move(bytes);
   }
 
-  // Encryption
   if (need_cdn_decrypt) {
     CHECK(part.offset % 16 == 0);
     auto offset = narrow_cast<uint32>(part.offset / 16);
@@ -355,20 +393,113 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
     ctr_state.init(cdn_encryption_key_, iv);
     ctr_state.decrypt(bytes.as_slice(), bytes.as_mutable_slice());
   }
-  if (encryption_key_.is_secret()) {
-    LOG_CHECK(next_part_ == part.id) << tag("expected part.id", next_part_) << "!=" << tag("part.id", part.id);
+  return std::move(bytes);
+}
+
+Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
+  CHECK(!encryption_key_.is_secret());
+  TRY_RESULT(bytes, fetch_part_bytes(part, std::move(net_query)));
+  if (bytes.empty()) {
+    return 0;
+  }
+  return save_part(part, bytes.as_slice());
+}
+
+Result<bool> FileDownloader::process_part_async(Part part, NetQueryPtr &net_query) {
+  if (!encryption_key_.is_secret()) {
+    if (only_check_) {
+      return false;
+    }
+    // secret file parts are saved synchronously after decryption, because the IV must be updated together with
+    // the ready prefix of the file
+    TRY_RESULT(bytes, fetch_part_bytes(part, std::move(net_query)));
+    write_part(part, std::move(bytes));
+    return true;
+  }
+
+  // AES-IGE decryption is done on another scheduler to keep this one free for network I/O;
+  // parts are received in order, because ordered flag is set, and are decrypted in the same order
+  TRY_RESULT(bytes, fetch_part_bytes(part, std::move(net_query)));
+  if (!bytes.empty()) {
+    LOG_CHECK(next_decrypted_part_ == part.id)
+        << tag("expected part.id", next_decrypted_part_) << "!=" << tag("part.id", part.id);
     CHECK(!next_part_stop_);
-    next_part_++;
+    next_decrypted_part_++;
     if (part.size % 16 != 0) {
       next_part_stop_ = true;
     }
-    aes_ige_decrypt(as_slice(encryption_key_.key()), as_mutable_slice(encryption_key_.mutable_iv()), bytes.as_slice(),
-                    bytes.as_mutable_slice());
   }
+  if (decryptor_.empty()) {
+    decryptor_ = create_actor_on_scheduler<SecretFileDecryptor>(
+        "SecretFileDecryptor", G()->get_gc_scheduler_id(), encryption_key_.key(), encryption_key_.mutable_iv());
+  }
+  send_closure(decryptor_, &SecretFileDecryptor::decrypt, std::move(bytes),
+               PromiseCreator::lambda([actor_id = actor_id(this), part](
+                                          Result<std::pair<BufferSlice, UInt256>> r_decrypted) mutable {
+                 send_closure(actor_id, &FileDownloader::on_part_decrypted, part, std::move(r_decrypted));
+               }));
+  return true;
+}
+
+void FileDownloader::on_part_decrypted(Part part, Result<std::pair<BufferSlice, UInt256>> r_decrypted) {
+  auto r_size = [&]() -> Result<size_t> {
+    TRY_RESULT(decrypted, std::move(r_decrypted));
+    if (decrypted.first.empty()) {
+      return 0;
+    }
+    // the IV must be updated only after the part is decrypted, because it is saved in partial local location
+    CHECK(next_part_ == part.id);
+    next_part_++;
+    encryption_key_.mutable_iv() = decrypted.second;
+    return save_part(part, decrypted.first.as_slice());
+  }();
+  on_part_processed(part, std::move(r_size));
+}
 
-  auto slice = bytes.as_slice().substr(0, part.size);
+void FileDownloader::write_part(Part part, BufferSlice bytes) {
+  auto r_status = [&]() -> Status {
+    if (bytes.empty()) {
+      return Status::OK();
+    }
+    TRY_STATUS(acquire_fd());
+    if (writer_.empty()) {
+      // file writes are done on another scheduler to keep this one free for network I/O
+      writer_ = create_actor_on_scheduler<FilePartWriter>("FilePartWriter", G()->get_gc_scheduler_id(), path_,
+                                                          get_file_type_unique_name(remote_.file_type_));
+    }
+    return Status::OK();
+  }();
+  if (r_status.is_error() || bytes.empty()) {
+    // the result must be processed asynchronously, because the part is still being processed
+    Result<size_t> r_size = 0;
+    if (r_status.is_error()) {
+      r_size = std::move(r_status);
+    }
+    return send_closure_later(actor_id(this), &FileDownloader::on_part_written, part, 0, std::move(r_size));
+  }
+
+  // may write less than part.size, when size of downloadable file is unknown
+  bytes.truncate(part.size);
+  auto size = bytes.size();
+  LOG(INFO) << "Receive " << size << " bytes at offset " << part.offset << " for \"" << path_ << '"';
+  send_closure(writer_, &FilePartWriter::write, part.offset, std::move(bytes),
+               PromiseCreator::lambda([actor_id = actor_id(this), part, size](Result<size_t> r_written) {
+                 send_closure(actor_id, &FileDownloader::on_part_written, part, size, std::move(r_written));
+               }));
+}
+
+void FileDownloader::on_part_written(Part part, size_t expected_size, Result<size_t> r_written) {
+  if (r_written.is_ok() && r_written.ok() != expected_size) {
+    r_written = Status::Error("Failed to save file part to the file");
+  }
+  on_part_processed(part, std::move(r_written));
+}
+
+Result<size_t> FileDownloader::save_part(Part part, Slice bytes) {
+  auto slice = bytes.substr(0, part.size);
   TRY_STATUS(acquire_fd());
   LOG(INFO) << "Receive " << slice.size() << " bytes at offset " << part.offset << " for \"" << path_ << '"';
+  FileFd::IoCategoryGuard io_category_guard(get_file_type_unique_name(remote_.file_type_));
   TRY_RESULT(written, fd_.pwrite(slice, part.offset));
   LOG(INFO) << "Written " << written << " bytes";
   // may write less than part.size, when size of downloadable file is unknown
@@ -445,8 +576,10 @@ Result<FileLoader::CheckInfo> FileDownloader::check_loop(int64 checked_prefix_si
         end_offset = ready_prefix_size;
       }
       auto size = narrow_cast<size_t>(end_offset - begin_offset);
+      BufferOwnerGuard buffer_owner_guard(BufferOwner::FilePart);
       auto slice = BufferSlice(size);
       TRY_STATUS(acquire_fd());
+      FileFd::IoCategoryGuard io_category_guard(get_file_type_unique_name(remote_.file_type_));
       TRY_RESULT(read_size, fd_.pread(slice.as_mutable_slice(), begin_offset));
       if (size != read_size) {
         return Status::Error("Failed to read file to check hash");
@@ -455,7 +588,13 @@ Result<FileLoader::CheckInfo> FileDownloader::check_loop(int64 checked_prefix_si
       sha256(slice.as_slice(), hash);
 
       if (hash != it->hash) {
-        if (only_check_) {
+        if (is_shared_copy_) {
+          // the copy must not be reused as a partially downloaded file
+          SharedFileStore::remove_file(remote_);
+          fd_.close();
+          unlink(path_).ignore();
+        }
+        if (only_check_ || is_shared_copy_) {
           return Status::Error("FILE_DOWNLOAD_RESTART");
         }
         return Status::Error("Hash mismatch");
@@ -9,13 +9,20 @@
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileLoader.h"
 #include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FilePartWriter.h"
+#include "td/telegram/files/SecretFileDecryptor.h"
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/telegram_api.h"
 
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/UInt.h"
 
 #include <map>
 #include <set>
@@ -54,6 +61,9 @@ class FileDownloader final : public FileLoader {
 
   int32 next_part_ = 0;
   bool next_part_stop_ = false;
+  int32 next_decrypted_part_ = 0;  // the next part to be sent to decryptor_
+  ActorOwn<SecretFileDecryptor> decryptor_;
+  ActorOwn<FilePartWriter> writer_;
   bool is_small_;
   bool need_search_file_{false};
   int64 offset_;
@@ -69,6 +79,7 @@ class FileDownloader final : public FileLoader {
   std::map<int32, int32> cdn_part_file_token_generation_;
 
   bool need_check_{false};
+  bool is_shared_copy_{false};
   struct HashInfo {
     int64 offset;
     size_t size;
@@ -87,6 +98,12 @@ class FileDownloader final : public FileLoader {
   Result<std::pair<NetQueryPtr, bool>> start_part(Part part, int32 part_count,
                                                   int64 streaming_offset) final TD_WARN_UNUSED_RESULT;
   Result<size_t> process_part(Part part, NetQueryPtr net_query) final TD_WARN_UNUSED_RESULT;
+  Result<bool> process_part_async(Part part, NetQueryPtr &net_query) final TD_WARN_UNUSED_RESULT;
+  Result<BufferSlice> fetch_part_bytes(Part part, NetQueryPtr net_query) TD_WARN_UNUSED_RESULT;
+  Result<size_t> save_part(Part part, Slice bytes) TD_WARN_UNUSED_RESULT;
+  void on_part_decrypted(Part part, Result<std::pair<BufferSlice, UInt256>> r_decrypted);
+  void write_part(Part part, BufferSlice bytes);
+  void on_part_written(Part part, size_t expected_size, Result<size_t> r_written);
   void on_progress(Progress progress) final;
   FileLoader::Callback *get_callback() final;
   Status process_check_query(NetQueryPtr net_query) final;
@@ -97,6 +114,7 @@ class FileDownloader final : public FileLoader {
   void keep_fd_flag(bool keep_fd) final;
   void try_release_fd();
   Status acquire_fd() TD_WARN_UNUSED_RESULT;
+  Status copy_shared_file(CSlice shared_path) TD_WARN_UNUSED_RESULT;
 
   Status check_net_query(NetQueryPtr &net_query);
 };
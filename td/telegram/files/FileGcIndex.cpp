@@ -0,0 +1,150 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileGcIndex.h"
+
+#include "td/telegram/files/FileType.h"
+
+#include "td/db/SqliteKeyValue.h"
+#include "td/db/SqliteKeyValueSafe.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <tuple>
+
+namespace td {
+
+// keys of the index:
+// "a" + <16 hex digits of atime_nsec> + <path> -> "<size> <mtime_nsec> <file_type>"
+// "p" + <path> -> <16 hex digits of atime_nsec>
+FileGcIndex::FileGcIndex(std::shared_ptr<SqliteKeyValueSafe> kv_safe) : kv_safe_(std::move(kv_safe)) {
+  auto &kv = this->kv();
+  is_complete_ = kv.get("complete") == "1";
+  total_size_ = to_integer<int64>(kv.get("size"));
+  total_count_ = to_integer<int64>(kv.get("count"));
+  LOG(INFO) << "Load " << (is_complete_ ? "complete" : "incomplete") << " file GC index with " << total_count_
+            << " files of total size " << total_size_;
+}
+
+SqliteKeyValue &FileGcIndex::kv() {
+  return kv_safe_->get();
+}
+
+void FileGcIndex::rebuild(const vector<FullFileInfo> &files) {
+  auto &kv = this->kv();
+  kv.begin_write_transaction().ensure();
+  kv.erase_by_prefix("a");
+  kv.erase_by_prefix("p");
+  total_size_ = 0;
+  total_count_ = 0;
+  for (auto &info : files) {
+    do_add_file(kv, info);
+  }
+  is_complete_ = true;
+  kv.set("complete", "1");
+  save_totals(kv);
+  kv.commit_transaction().ensure();
+  LOG(INFO) << "Rebuild file GC index with " << total_count_ << " files of total size " << total_size_;
+}
+
+void FileGcIndex::add_file(const FullFileInfo &info) {
+  auto &kv = this->kv();
+  kv.begin_write_transaction().ensure();
+  do_remove_file(kv, info.path);
+  do_add_file(kv, info);
+  save_totals(kv);
+  kv.commit_transaction().ensure();
+}
+
+void FileGcIndex::remove_file(Slice path) {
+  auto &kv = this->kv();
+  kv.begin_write_transaction().ensure();
+  do_remove_file(kv, path);
+  save_totals(kv);
+  kv.commit_transaction().ensure();
+}
+
+vector<FullFileInfo> FileGcIndex::get_least_recently_used_files(size_t limit, string &last_key) {
+  vector<FullFileInfo> result;
+  string from = last_key.empty() ? string("a") : last_key + '\0';
+  kv().get_by_range(from, "b", [&](Slice key, Slice value) {
+    if (result.size() >= limit) {
+      return false;
+    }
+    last_key = key.str();
+    if (key.size() <= 17) {
+      LOG(ERROR) << "Receive invalid key in file GC index";
+      return true;
+    }
+
+    FullFileInfo info;
+    info.path = key.substr(17).str();
+    info.atime_nsec = hex_to_integer<uint64>(key.substr(1, 16));
+    Slice size;
+    Slice mtime_nsec;
+    Slice file_type;
+    std::tie(size, value) = split(value);
+    std::tie(mtime_nsec, file_type) = split(value);
+    info.size = to_integer<int64>(size);
+    info.mtime_nsec = to_integer<uint64>(mtime_nsec);
+    auto file_type_id = to_integer<int32>(file_type);
+    if (file_type_id < 0 || file_type_id >= MAX_FILE_TYPE) {
+      LOG(ERROR) << "Receive invalid file type " << file_type_id << " in file GC index";
+      return true;
+    }
+    info.file_type = static_cast<FileType>(file_type_id);
+    result.push_back(std::move(info));
+    return true;
+  });
+  return result;
+}
+
+void FileGcIndex::do_add_file(SqliteKeyValue &kv, const FullFileInfo &info) {
+  auto access_key = get_access_key(info.atime_nsec, info.path);
+  kv.set(access_key, PSLICE() << info.size << ' ' << info.mtime_nsec << ' ' << static_cast<int32>(info.file_type));
+  kv.set(PSLICE() << 'p' << info.path, Slice(access_key).substr(1, 16));
+  total_size_ += info.size;
+  total_count_++;
+}
+
+void FileGcIndex::do_remove_file(SqliteKeyValue &kv, Slice path) {
+  auto path_key = PSTRING() << 'p' << path;
+  auto atime = kv.get(path_key);
+  if (atime.empty()) {
+    return;
+  }
+  auto access_key = PSTRING() << 'a' << atime << path;
+  auto value = kv.get(access_key);
+  total_size_ -= to_integer<int64>(split(Slice(value)).first);
+  total_count_--;
+  if (total_size_ < 0 || total_count_ < 0) {
+    LOG(ERROR) << "Receive wrong total size " << total_size_ << " and count " << total_count_ << " in file GC index";
+    total_size_ = max(total_size_, static_cast<int64>(0));
+    total_count_ = max(total_count_, static_cast<int64>(0));
+  }
+  kv.erase(access_key);
+  kv.erase(path_key);
+}
+
+void FileGcIndex::save_totals(SqliteKeyValue &kv) {
+  kv.set("size", to_string(total_size_));
+  kv.set("count", to_string(total_count_));
+}
+
+string FileGcIndex::get_access_key(uint64 atime_nsec, Slice path) {
+  // fixed-width hexadecimal representation keeps keys ordered by atime_nsec
+  string result(17, 'a');
+  for (size_t i = 16; i > 0; i--) {
+    result[i] = "0123456789abcdef"[atime_nsec & 15];
+    atime_nsec >>= 4;
+  }
+  result.append(path.begin(), path.size());
+  return result;
+}
+
+}  // namespace td
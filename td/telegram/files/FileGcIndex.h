@@ -0,0 +1,67 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/FileStats.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <memory>
+
+namespace td {
+
+class SqliteKeyValue;
+class SqliteKeyValueSafe;
+
+// persistent index of locally stored files by the time of their last access,
+// which allows to remove least recently used files without scanning of all file directories
+// must be used only from the scheduler of StorageManager
+class FileGcIndex {
+ public:
+  explicit FileGcIndex(std::shared_ptr<SqliteKeyValueSafe> kv_safe);
+
+  // the index is complete if it was built from a full scan of files
+  bool is_complete() const {
+    return is_complete_;
+  }
+
+  int64 get_total_size() const {
+    return total_size_;
+  }
+
+  int64 get_total_count() const {
+    return total_count_;
+  }
+
+  void rebuild(const vector<FullFileInfo> &files);
+
+  void add_file(const FullFileInfo &info);
+
+  void remove_file(Slice path);
+
+  // returns at most limit least recently accessed files after the file with the given key and updates the key
+  vector<FullFileInfo> get_least_recently_used_files(size_t limit, string &last_key);
+
+ private:
+  std::shared_ptr<SqliteKeyValueSafe> kv_safe_;
+  bool is_complete_ = false;
+  int64 total_size_ = 0;
+  int64 total_count_ = 0;
+
+  SqliteKeyValue &kv();
+
+  void do_add_file(SqliteKeyValue &kv, const FullFileInfo &info);
+
+  void do_remove_file(SqliteKeyValue &kv, Slice path);
+
+  void save_totals(SqliteKeyValue &kv);
+
+  static string get_access_key(uint64 atime_nsec, Slice path);
+};
+
+}  // namespace td
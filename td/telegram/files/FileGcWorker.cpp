@@ -17,6 +17,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/Time.h"
 
 #include <algorithm>
@@ -26,15 +27,7 @@ namespace td {
 
 int VERBOSITY_NAME(file_gc) = VERBOSITY_NAME(INFO);
 
-void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files,
-                          Promise<FileGcResult> promise) {
-  auto begin_time = Time::now();
-  VLOG(file_gc) << "Start files GC with " << parameters;
-  // quite stupid implementations
-  // needs a lot of memory
-  // may write something more clever, but i will need at least 2 passes over the files
-  // TODO update atime for all files in android (?)
-
+static std::array<bool, MAX_FILE_TYPE> get_immune_types(const FileGcParameters &parameters) {
   std::array<bool, MAX_FILE_TYPE> immune_types{{false}};
 
   if (G()->use_file_database()) {
@@ -63,6 +56,19 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
   if (G()->use_file_database()) {
     immune_types[narrow_cast<size_t>(FileType::EncryptedThumbnail)] = true;
   }
+  return immune_types;
+}
+
+void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files,
+                          std::shared_ptr<FileGcIndex> index, Promise<FileGcResult> promise) {
+  auto begin_time = Time::now();
+  VLOG(file_gc) << "Start files GC with " << parameters;
+  // quite stupid implementations
+  // needs a lot of memory
+  // may write something more clever, but i will need at least 2 passes over the files
+  // TODO update atime for all files in android (?)
+
+  auto immune_types = get_immune_types(parameters);
 
   auto file_cnt = files.size();
   int32 type_immunity_ignored_cnt = 0;
@@ -84,8 +90,11 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
   FileStats new_stats(false, parameters.dialog_limit_ != 0);
   FileStats removed_stats(false, parameters.dialog_limit_ != 0);
 
-  auto do_remove_file = [&removed_stats](const FullFileInfo &info) {
+  auto do_remove_file = [&removed_stats, &index](const FullFileInfo &info) {
     removed_stats.add_copy(info);
+    if (index != nullptr) {
+      index->remove_file(info.path);
+    }
     auto status = unlink(info.path);
     LOG_IF(WARNING, status.is_error()) << "Failed to unlink file \"" << info.path << "\" during files GC: " << status;
     send_closure(G()->file_manager(), &FileManager::on_file_unlink,
@@ -194,4 +203,91 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
   promise.set_value({std::move(new_stats), std::move(removed_stats)});
 }
 
+void FileGcWorker::run_incremental_gc(const FileGcParameters &parameters, std::shared_ptr<FileGcIndex> index,
+                                      Promise<FileGcResult> promise) {
+  CHECK(index != nullptr);
+  auto begin_time = Time::now();
+  VLOG(file_gc) << "Start incremental files GC with " << parameters << " for " << index->get_total_count()
+                << " files of total size " << index->get_total_size();
+
+  auto immune_types = get_immune_types(parameters);
+  FileStats removed_stats(false, false);
+  int32 checked_cnt = 0;
+  int32 remove_by_atime_cnt = 0;
+  int32 remove_by_count_cnt = 0;
+  int32 remove_by_size_cnt = 0;
+  double now = Clocks::system();
+
+  // files are checked from the least recently used until both size and count limits are satisfied
+  // and the next file was accessed after max_time_from_last_access
+  string last_key;
+  bool is_finished = false;
+  while (!is_finished) {
+    if (token_) {
+      return promise.set_error(Global::request_aborted_error());
+    }
+    auto files = index->get_least_recently_used_files(INCREMENTAL_GC_BATCH_SIZE, last_key);
+    if (files.empty()) {
+      break;
+    }
+    for (auto &info : files) {
+      checked_cnt++;
+      bool need_remove_by_atime =
+          static_cast<double>(info.atime_nsec) * 1e-9 < now - parameters.max_time_from_last_access_;
+      bool need_remove_by_count = index->get_total_count() > static_cast<int64>(parameters.max_file_count_);
+      bool need_remove_by_size = index->get_total_size() > parameters.max_files_size_;
+      if (!need_remove_by_atime && !need_remove_by_count && !need_remove_by_size) {
+        is_finished = true;
+        break;
+      }
+      if (immune_types[narrow_cast<size_t>(info.file_type)]) {
+        continue;
+      }
+
+      auto r_stat = stat(info.path);
+      if (r_stat.is_error()) {
+        // the file was deleted by someone else
+        index->remove_file(info.path);
+        continue;
+      }
+      const auto &stat = r_stat.ok();
+      info.mtime_nsec = stat.mtime_nsec_;
+      if (static_cast<double>(info.mtime_nsec) * 1e-9 > now - parameters.immunity_delay_) {
+        // new files are immune to GC
+        continue;
+      }
+      auto atime_nsec = max(stat.atime_nsec_, stat.mtime_nsec_);
+      if (atime_nsec > info.atime_nsec + 1000000000) {
+        // the file was accessed directly; move it to the right place in the index
+        info.atime_nsec = atime_nsec;
+        index->add_file(info);
+        continue;
+      }
+
+      if (need_remove_by_atime) {
+        remove_by_atime_cnt++;
+      } else if (need_remove_by_count) {
+        remove_by_count_cnt++;
+      } else {
+        remove_by_size_cnt++;
+      }
+      removed_stats.add_copy(info);
+      index->remove_file(info.path);
+      auto status = unlink(info.path);
+      LOG_IF(WARNING, status.is_error()) << "Failed to unlink file \"" << info.path << "\" during files GC: " << status;
+      send_closure(G()->file_manager(), &FileManager::on_file_unlink,
+                   FullLocalFileLocation(info.file_type, info.path, info.mtime_nsec));
+    }
+  }
+
+  auto end_time = Time::now();
+  VLOG(file_gc) << "Finish incremental files GC: " << tag("time", end_time - begin_time) << tag("checked", checked_cnt)
+                << tag("removed", remove_by_atime_cnt + remove_by_count_cnt + remove_by_size_cnt)
+                << tag("total_size", format::as_size(index->get_total_size()))
+                << tag("total_count", index->get_total_count()) << tag("by_atime", remove_by_atime_cnt)
+                << tag("by_count", remove_by_count_cnt) << tag("by_size", remove_by_size_cnt);
+
+  promise.set_value({FileStats(false, false), std::move(removed_stats)});
+}
+
 }  // namespace td
@@ -6,15 +6,19 @@
 //
 #pragma once
 
+#include "td/telegram/files/FileGcIndex.h"
 #include "td/telegram/files/FileGcParameters.h"
 #include "td/telegram/files/FileStats.h"
 
 #include "td/actor/actor.h"
 
 #include "td/utils/CancellationToken.h"
+#include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 
+#include <memory>
+
 namespace td {
 
 extern int VERBOSITY_NAME(file_gc);
@@ -28,9 +32,16 @@ class FileGcWorker final : public Actor {
  public:
   FileGcWorker(ActorShared<> parent, CancellationToken token) : parent_(std::move(parent)), token_(std::move(token)) {
   }
-  void run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files, Promise<FileGcResult> promise);
+  void run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files, std::shared_ptr<FileGcIndex> index,
+              Promise<FileGcResult> promise);
+
+  // removes least recently used files using the index without scanning of all files
+  void run_incremental_gc(const FileGcParameters &parameters, std::shared_ptr<FileGcIndex> index,
+                          Promise<FileGcResult> promise);
 
  private:
+  static constexpr size_t INCREMENTAL_GC_BATCH_SIZE = 1000;
+
   ActorShared<> parent_;
   CancellationToken token_;
 };
@@ -6,10 +6,12 @@
 //
 #include "td/telegram/files/FileHashUploader.h"
 
+#include "td/telegram/files/FileDb.h"
 #include "td/telegram/files/FileType.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/TdDb.h"
 #include "td/telegram/telegram_api.h"
 
 #include "td/utils/buffer.h"
@@ -21,6 +23,8 @@
 #include "td/utils/PathView.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/PollFlags.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Promise.h"
 #include "td/utils/Status.h"
 
 namespace td {
@@ -40,14 +44,40 @@ Status FileHashUploader::init() {
   if (file_size != size_) {
     return Status::Error("Size mismatch");
   }
+  TRY_RESULT(stat, fd.stat());
   fd_ = BufferedFd<FileFd>(std::move(fd));
   sha256_state_.init();
 
   resource_state_.set_unit_size(1024);
   resource_state_.update_estimated_limit(size_);
+
+  if (G()->use_file_database()) {
+    // the same file is often uploaded many times, so its hash is saved to avoid reading of the whole file again
+    hash_key_ = FileDbInterface::get_file_hash_key(local_.path_, size_, stat.mtime_nsec_);
+    state_ = State::WaitHash;
+    G()->td_db()->get_file_db_shared()->get_file_hash(
+        hash_key_, PromiseCreator::lambda([actor_id = actor_id(this)](Result<string> r_hash) {
+          send_closure(actor_id, &FileHashUploader::on_load_hash, std::move(r_hash));
+        }));
+  }
   return Status::OK();
 }
 
+void FileHashUploader::on_load_hash(Result<string> r_hash) {
+  if (stop_flag_) {
+    return;
+  }
+  CHECK(state_ == State::WaitHash);
+  if (r_hash.is_ok() && r_hash.ok().size() == 32) {
+    LOG(INFO) << "Use saved hash of " << local_.path_;
+    hash_ = r_hash.move_as_ok();
+    state_ = State::NetRequest;
+  } else {
+    state_ = State::CalcSha;
+  }
+  loop();
+}
+
 void FileHashUploader::loop() {
   if (stop_flag_) {
     return;
@@ -67,8 +97,14 @@ Status FileHashUploader::loop_impl() {
   }
   if (state_ == State::NetRequest) {
     // messages.getDocumentByHash#338e2464 sha256:bytes size:long mime_type:string = Document;
-    auto hash = BufferSlice(32);
-    sha256_state_.extract(hash.as_mutable_slice(), true);
+    if (hash_.empty()) {
+      hash_ = string(32, '\0');
+      sha256_state_.extract(hash_, true);
+      if (!hash_key_.empty()) {
+        G()->td_db()->get_file_db_shared()->set_file_hash(hash_key_, hash_);
+      }
+    }
+    auto hash = BufferSlice(hash_);
     auto mime_type = MimeType::from_extension(PathView(local_.path_).extension(), "image/gif");
     auto query = telegram_api::messages_getDocumentByHash(std::move(hash), size_, std::move(mime_type));
     LOG(INFO) << "Send getDocumentByHash request: " << to_string(query);
@@ -63,13 +63,17 @@ class FileHashUploader final : public FileLoaderActor {
 
   ActorShared<ResourceManager> resource_manager_;
 
-  enum class State : int32 { CalcSha, NetRequest, WaitNetResult } state_ = State::CalcSha;
+  enum class State : int32 { WaitHash, CalcSha, NetRequest, WaitNetResult } state_ = State::CalcSha;
   bool stop_flag_ = false;
   Sha256State sha256_state_;
+  string hash_key_;
+  string hash_;
 
   void start_up() final;
   Status init();
 
+  void on_load_hash(Result<string> r_hash);
+
   void loop() final;
 
   Status loop_impl();
@@ -26,21 +26,68 @@ void FileLoadManager::start_up() {
   upload_resource_manager_ = create_actor<ResourceManager>(
       "UploadResourceManager", MAX_UPLOAD_RESOURCE_LIMIT,
       !G()->keep_media_order() ? ResourceManager::Mode::Greedy : ResourceManager::Mode::Baseline);
-  if (G()->get_option_boolean("is_premium")) {
+  if (G()->get_option_boolean(CachedOption::IsPremium)) {
     max_download_resource_limit_ *= 8;
   }
 }
 
-ActorOwn<ResourceManager> &FileLoadManager::get_download_resource_manager(bool is_small, DcId dc_id) {
-  auto &actor = is_small ? download_small_resource_manager_map_[dc_id] : download_resource_manager_map_[dc_id];
+ActorOwn<ResourceManager> &FileLoadManager::get_download_resource_manager(bool is_small, DownloadClass download_class,
+                                                                         DcId dc_id) {
+  CHECK(download_class != DownloadClass::None);
+  auto &actor = is_small ? download_small_resource_manager_map_[dc_id]
+                         : download_resource_manager_map_[static_cast<int32>(download_class)][dc_id];
   if (actor.empty()) {
+    auto max_resource_limit = max_download_resource_limit_;
+    if (!is_small && download_class == DownloadClass::Background) {
+      max_resource_limit = get_background_download_resource_limit();
+    }
     actor = create_actor<ResourceManager>(
-        PSLICE() << "DownloadResourceManager " << tag("is_small", is_small) << tag("dc_id", dc_id),
-        max_download_resource_limit_, ResourceManager::Mode::Baseline);
+        PSLICE() << "DownloadResourceManager " << tag("is_small", is_small)
+                 << tag("class", static_cast<int32>(download_class)) << tag("dc_id", dc_id),
+        max_resource_limit, ResourceManager::Mode::Baseline);
   }
   return actor;
 }
 
+FileLoadManager::DownloadClass FileLoadManager::get_download_class(bool is_small, int64 offset, int64 limit,
+                                                                   int8 priority) {
+  if (is_small) {
+    return DownloadClass::Interactive;
+  }
+  if (offset > 0 || limit > 0) {
+    return DownloadClass::Streaming;
+  }
+  if (priority <= MAX_BACKGROUND_DOWNLOAD_PRIORITY) {
+    return DownloadClass::Background;
+  }
+  return DownloadClass::Interactive;
+}
+
+int64 FileLoadManager::get_background_download_resource_limit() const {
+  if (active_download_count_[static_cast<int32>(DownloadClass::Interactive)] > 0 ||
+      active_download_count_[static_cast<int32>(DownloadClass::Streaming)] > 0) {
+    return MIN_BACKGROUND_DOWNLOAD_RESOURCE_LIMIT;
+  }
+  return max_download_resource_limit_ / 2;
+}
+
+void FileLoadManager::on_download_class_changed(DownloadClass download_class, int32 diff) {
+  if (download_class == DownloadClass::None) {
+    return;
+  }
+  auto old_limit = get_background_download_resource_limit();
+  active_download_count_[static_cast<int32>(download_class)] += diff;
+  CHECK(active_download_count_[static_cast<int32>(download_class)] >= 0);
+  auto new_limit = get_background_download_resource_limit();
+  if (old_limit != new_limit) {
+    // running background downloads will stop receiving new parts when already sent parts are downloaded
+    LOG(INFO) << "Change background download resource limit to " << new_limit;
+    for (auto &it : download_resource_manager_map_[static_cast<int32>(DownloadClass::Background)]) {
+      send_closure(it.second, &ResourceManager::set_max_resource_limit, new_limit);
+    }
+  }
+}
+
 void FileLoadManager::download(QueryId query_id, const FullRemoteFileLocation &remote_location,
                                const LocalFileLocation &local, int64 size, string name,
                                const FileEncryptionKey &encryption_key, bool search_file, int64 offset, int64 limit,
@@ -57,8 +104,10 @@ void FileLoadManager::download(QueryId query_id, const FullRemoteFileLocation &r
   node->loader_ =
       create_actor<FileDownloader>("Downloader", remote_location, local, size, std::move(name), encryption_key,
                                    is_small, search_file, offset, limit, std::move(callback));
+  node->download_class_ = get_download_class(is_small, offset, limit, priority);
+  on_download_class_changed(node->download_class_, 1);
   DcId dc_id = remote_location.is_web() ? G()->get_webfile_dc_id() : remote_location.get_dc_id();
-  auto &resource_manager = get_download_resource_manager(is_small, dc_id);
+  auto &resource_manager = get_download_resource_manager(is_small, node->download_class_, dc_id);
   send_closure(resource_manager, &ResourceManager::register_worker,
                ActorShared<FileLoaderActor>(node->loader_.get(), static_cast<uint64>(-1)), priority);
   bool is_inserted = query_id_to_node_id_.emplace(query_id, node_id).second;
@@ -322,6 +371,7 @@ void FileLoadManager::close_node(NodeId node_id) {
   auto node = nodes_container_.get(node_id);
   CHECK(node);
   query_id_to_node_id_.erase(node->query_id_);
+  on_download_class_changed(node->download_class_, -1);
   nodes_container_.erase(node_id);
 }
 
@@ -71,15 +71,24 @@ class FileLoadManager final : public Actor {
   void check_partial_local_location(PartialLocalFileLocation partial, Promise<Unit> promise);
 
  private:
+  // downloads of different classes don't share resources, and background downloads are slowed down
+  // to a single part in flight while there are active interactive or streaming downloads
+  enum class DownloadClass : int32 { Interactive, Streaming, Background, None };
+  static constexpr size_t DOWNLOAD_CLASS_COUNT = 3;
+  static constexpr int8 MAX_BACKGROUND_DOWNLOAD_PRIORITY = 8;
+  static constexpr int64 MIN_BACKGROUND_DOWNLOAD_RESOURCE_LIMIT = 1 << 19;
+
   struct Node {
     QueryId query_id_;
     ActorOwn<FileLoaderActor> loader_;
     ResourceState resource_state_;
+    DownloadClass download_class_ = DownloadClass::None;
   };
   using NodeId = uint64;
 
-  std::map<DcId, ActorOwn<ResourceManager>> download_resource_manager_map_;
+  std::map<DcId, ActorOwn<ResourceManager>> download_resource_manager_map_[DOWNLOAD_CLASS_COUNT];
   std::map<DcId, ActorOwn<ResourceManager>> download_small_resource_manager_map_;
+  int32 active_download_count_[DOWNLOAD_CLASS_COUNT] = {};
   ActorOwn<ResourceManager> upload_resource_manager_;
 
   Container<Node> nodes_container_;
@@ -95,7 +104,13 @@ class FileLoadManager final : public Actor {
   void hangup_shared() final;
 
   void close_node(NodeId node_id);
-  ActorOwn<ResourceManager> &get_download_resource_manager(bool is_small, DcId dc_id);
+  ActorOwn<ResourceManager> &get_download_resource_manager(bool is_small, DownloadClass download_class, DcId dc_id);
+
+  static DownloadClass get_download_class(bool is_small, int64 offset, int64 limit, int8 priority);
+
+  int64 get_background_download_resource_limit() const;
+
+  void on_download_class_changed(DownloadClass download_class, int32 diff);
 
   void on_start_download();
   void on_partial_download(PartialLocalFileLocation partial_local, int64 ready_size, int64 size);
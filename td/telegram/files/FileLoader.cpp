@@ -17,6 +17,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Time.h"
 
 #include <tuple>
 
@@ -137,10 +138,10 @@ void FileLoader::start_up() {
     ordered_parts_ = OrderedEventsProcessor<std::pair<Part, NetQueryPtr>>(parts_manager_.get_ready_prefix_count());
   }
   if (file_info.need_delay) {
-    delay_dispatcher_ = create_actor<DelayDispatcher>("DelayDispatcher", 0.003, actor_shared(this, 1));
-    next_delay_ = 0.05;
+    delay_dispatcher_ = create_actor<DelayDispatcher>("DelayDispatcher", 0.003, 0.05, 1.0, actor_shared(this, 1));
   }
   resource_state_.set_unit_size(parts_manager_.get_part_size());
+  load_window_.init(static_cast<int64>(parts_manager_.get_part_size()));
   update_estimated_limit();
   on_progress_impl();
   yield();
@@ -183,6 +184,8 @@ Status FileLoader::do_loop() {
     LOG(INFO) << "Bad download order rate: "
               << (debug_total_parts_ == 0 ? 0.0 : 100.0 * debug_bad_part_order_ / debug_total_parts_) << "% "
               << debug_bad_part_order_ << "/" << debug_total_parts_ << " " << format::as_array(debug_bad_parts_);
+    LOG(INFO) << "Achieved throughput " << static_cast<int64>(load_window_.get_average_throughput(Time::now()))
+              << " bytes per second with " << load_window_;
     stop_flag_ = true;
     return Status::OK();
   }
@@ -199,6 +202,10 @@ Status FileLoader::do_loop() {
       VLOG(file_loader) << "Receive only " << resource_state_.unused() << " resource";
       break;
     }
+    if (resource_state_.get_using() + narrow_cast<int64>(parts_manager_.get_part_size()) > load_window_.get_window()) {
+      VLOG(file_loader) << "Have " << resource_state_.get_using() << " bytes in flight with " << load_window_;
+      break;
+    }
     TRY_RESULT(part, parts_manager_.start_part());
     if (part.size == 0) {
       break;
@@ -216,6 +223,7 @@ Status FileLoader::do_loop() {
       blocking_id_ = unique_id;
     }
     part_map_[unique_id] = std::make_pair(part, query->cancel_slot_.get_signal_new());
+    load_window_.on_part_started(unique_id, Time::now());
     // part_map_[unique_id] = std::make_pair(part, query.get_weak());
 
     auto callback = actor_shared(this, unique_id);
@@ -223,9 +231,7 @@ Status FileLoader::do_loop() {
       G()->net_query_dispatcher().dispatch_with_callback(std::move(query), std::move(callback));
     } else {
       query->debug("sent to DelayDispatcher");
-      send_closure(delay_dispatcher_, &DelayDispatcher::send_with_callback_and_delay, std::move(query),
-                   std::move(callback), next_delay_);
-      next_delay_ = max(next_delay_ * 0.8, 0.003);
+      send_closure(delay_dispatcher_, &DelayDispatcher::send_with_callback, std::move(query), std::move(callback));
     }
   }
   return Status::OK();
@@ -245,7 +251,8 @@ void FileLoader::update_estimated_limit() {
   if (stop_flag_) {
     return;
   }
-  auto estimated_extra = parts_manager_.get_estimated_extra();
+  // don't request more resources than can be used in parallel
+  auto estimated_extra = min(parts_manager_.get_estimated_extra(), load_window_.get_window());
   resource_state_.update_estimated_limit(estimated_extra);
   VLOG(file_loader) << "Update estimated limit " << estimated_extra;
   if (!resource_manager_.empty()) {
@@ -284,10 +291,12 @@ void FileLoader::on_result(NetQueryPtr query) {
       should_restart = true;
     }
     if (should_restart) {
+      load_window_.on_part_failed(unique_id);
       VLOG(file_loader) << "Restart part " << tag("id", part.id) << tag("size", part.size);
       resource_state_.stop_use(static_cast<int64>(part.size));
       parts_manager_.on_part_failed(part.id);
     } else {
+      load_window_.on_part_finished(unique_id, static_cast<int64>(part.size), Time::now());
       next = true;
     }
     return Status::OK();
@@ -333,7 +342,33 @@ void FileLoader::on_common_query(NetQueryPtr query) {
 }
 
 Status FileLoader::try_on_part_query(Part part, NetQueryPtr query) {
+  TRY_RESULT(is_async, process_part_async(part, query));
+  if (is_async) {
+    VLOG(file_loader) << "Process part " << tag("id", part.id) << " asynchronously";
+    return Status::OK();
+  }
   TRY_RESULT(size, process_part(part, std::move(query)));
+  return on_part_ok(part, size);
+}
+
+void FileLoader::on_part_processed(Part part, Result<size_t> r_size) {
+  if (stop_flag_) {
+    return;
+  }
+  auto status = [&] {
+    TRY_RESULT(size, std::move(r_size));
+    return on_part_ok(part, size);
+  }();
+  if (status.is_error()) {
+    on_error(std::move(status));
+    stop_flag_ = true;
+    return;
+  }
+  update_estimated_limit();
+  loop();
+}
+
+Status FileLoader::on_part_ok(Part part, size_t size) {
   VLOG(file_loader) << "Ok part " << tag("id", part.id) << tag("size", part.size);
   resource_state_.stop_use(static_cast<int64>(part.size));
   auto old_ready_prefix_count = parts_manager_.get_unchecked_ready_prefix_count();
@@ -9,6 +9,7 @@
 #include "td/telegram/DelayDispatcher.h"
 #include "td/telegram/files/FileLoaderActor.h"
 #include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/LoadWindow.h"
 #include "td/telegram/files/PartsManager.h"
 #include "td/telegram/files/ResourceManager.h"
 #include "td/telegram/files/ResourceState.h"
@@ -73,6 +74,12 @@ class FileLoader : public FileLoaderActor {
   virtual void after_start_parts() {
   }
   virtual Result<size_t> process_part(Part part, NetQueryPtr net_query) TD_WARN_UNUSED_RESULT = 0;
+  // returns true if the part will be processed asynchronously and on_part_processed will be called later
+  // in this case net_query must be taken
+  virtual Result<bool> process_part_async(Part part, NetQueryPtr &net_query) TD_WARN_UNUSED_RESULT {
+    return false;
+  }
+  void on_part_processed(Part part, Result<size_t> r_size);
   struct Progress {
     int32 part_count{0};
     int32 part_size{0};
@@ -114,12 +121,12 @@ class FileLoader : public FileLoaderActor {
   ActorShared<ResourceManager> resource_manager_;
   ResourceState resource_state_;
   PartsManager parts_manager_;
+  LoadWindow load_window_;
   uint64 blocking_id_{0};
   std::map<uint64, std::pair<Part, ActorShared<>>> part_map_;
   bool ordered_flag_ = false;
   OrderedEventsProcessor<std::pair<Part, NetQueryPtr>> ordered_parts_;
   ActorOwn<DelayDispatcher> delay_dispatcher_;
-  double next_delay_ = 0;
 
   uint32 debug_total_parts_ = 0;
   uint32 debug_bad_part_order_ = 0;
@@ -139,6 +146,7 @@ class FileLoader : public FileLoaderActor {
   void on_part_query(Part part, NetQueryPtr query);
   void on_common_query(NetQueryPtr query);
   Status try_on_part_query(Part part, NetQueryPtr query);
+  Status on_part_ok(Part part, size_t size);
 };
 
 }  // namespace td
@@ -50,6 +50,8 @@
 namespace td {
 namespace {
 constexpr int64 MAX_FILE_SIZE = static_cast<int64>(4000) << 20;  // 4000MB
+constexpr int64 MIN_DOWNLOAD_READ_AHEAD = 512 << 10;
+constexpr int64 MAX_DOWNLOAD_READ_AHEAD = 16 << 20;
 }  // namespace
 
 int VERBOSITY_NAME(update_file) = VERBOSITY_NAME(INFO);
@@ -205,10 +207,10 @@ void FileNode::set_download_offset(int64 download_offset) {
 }
 
 int64 FileNode::get_download_limit() const {
-  if (ignore_download_limit_) {
+  if (ignore_download_limit_ || private_download_limit_ == 0) {
     return 0;
   }
-  return private_download_limit_;
+  return min(private_download_limit_ + download_read_ahead_, MAX_FILE_SIZE);
 }
 
 void FileNode::update_effective_download_limit(int64 old_download_limit) {
@@ -238,6 +240,27 @@ void FileNode::set_download_limit(int64 download_limit) {
   update_effective_download_limit(old_download_limit);
 }
 
+void FileNode::update_download_read_ahead(int64 download_offset, int64 download_limit) {
+  if (download_offset < 0 || download_limit < 0 || download_offset == download_offset_) {
+    // KEEP_DOWNLOAD_OFFSET, KEEP_DOWNLOAD_LIMIT or a repeated request
+    return;
+  }
+
+  // the read-ahead grows while the file is read sequentially and is dropped on seek to download the requested part first
+  auto old_download_limit = get_download_limit();
+  bool is_sequential = private_download_limit_ > 0 && download_limit > 0 && download_offset_ < download_offset &&
+                       download_offset <= download_offset_ + private_download_limit_;
+  if (!is_sequential) {
+    download_read_ahead_ = 0;
+  } else if (download_read_ahead_ == 0) {
+    download_read_ahead_ = max(download_limit, MIN_DOWNLOAD_READ_AHEAD);
+  } else {
+    download_read_ahead_ = min(download_read_ahead_ * 2, MAX_DOWNLOAD_READ_AHEAD);
+  }
+  VLOG(update_file) << "File " << main_file_id_ << " has changed download read-ahead to " << download_read_ahead_;
+  update_effective_download_limit(old_download_limit);
+}
+
 void FileNode::set_ignore_download_limit(bool ignore_download_limit) {
   auto old_download_limit = get_download_limit();
   ignore_download_limit_ = ignore_download_limit;
@@ -389,9 +412,9 @@ void FileNode::set_remote_name(string remote_name) {
 }
 
 void FileNode::set_url(string url) {
-  if (url_ != url) {
+  if (get_url() != url) {
     VLOG(update_file) << "File " << main_file_id_ << " has changed URL to " << url;
-    url_ = std::move(url);
+    get_extra().url_ = std::move(url);
     on_changed();
   }
 }
@@ -404,8 +427,8 @@ void FileNode::set_owner_dialog_id(DialogId owner_id) {
 }
 
 void FileNode::set_encryption_key(FileEncryptionKey key) {
-  if (encryption_key_ != key) {
-    encryption_key_ = std::move(key);
+  if (get_encryption_key() != key) {
+    get_extra().encryption_key_ = std::move(key);
     on_pmc_changed();
   }
 }
@@ -476,7 +499,7 @@ bool FileNode::need_pmc_flush() const {
   }
 
   // We must save encryption key
-  if (!encryption_key_.empty()) {
+  if (!get_encryption_key().empty()) {
     // && remote_.type() != RemoteFileLocation::Type::Empty
     return true;
   }
@@ -508,12 +531,35 @@ void FileNode::on_info_flushed() {
   info_changed_flag_ = false;
 }
 
+const string &FileNode::get_url() const {
+  if (extra_ == nullptr) {
+    static const string empty_url;
+    return empty_url;
+  }
+  return extra_->url_;
+}
+
+const FileEncryptionKey &FileNode::get_encryption_key() const {
+  if (extra_ == nullptr) {
+    static const FileEncryptionKey empty_encryption_key;
+    return empty_encryption_key;
+  }
+  return extra_->encryption_key_;
+}
+
+FileNode::Extra &FileNode::get_extra() {
+  if (extra_ == nullptr) {
+    extra_ = make_unique<Extra>();
+  }
+  return *extra_;
+}
+
 string FileNode::suggested_path() const {
   if (!remote_name_.empty()) {
     return remote_name_;
   }
-  if (!url_.empty()) {
-    auto file_name = get_url_file_name(url_);
+  if (!get_url().empty()) {
+    auto file_name = get_url_file_name(get_url());
     if (!file_name.empty()) {
       return file_name;
     }
@@ -750,11 +796,11 @@ string FileView::path() const {
 }
 
 bool FileView::has_url() const {
-  return !node_->url_.empty();
+  return !node_->get_url().empty();
 }
 
 const string &FileView::url() const {
-  return node_->url_;
+  return node_->get_url();
 }
 
 const string &FileView::remote_name() const {
@@ -844,8 +890,8 @@ string FileNode::get_persistent_id(const FullRemoteFileLocation &location) {
 string FileNode::get_persistent_file_id() const {
   if (remote_.is_full_alive) {
     return get_persistent_id(remote_.full.value());
-  } else if (!url_.empty()) {
-    return url_;
+  } else if (!get_url().empty()) {
+    return get_url();
   } else if (generate_ != nullptr && FileManager::is_remotely_generated_file(generate_->conversion_)) {
     return get_persistent_id(*generate_);
   }
@@ -1227,6 +1273,7 @@ FileId FileManager::register_empty(FileType type) {
 }
 
 void FileManager::on_file_unlink(const FullLocalFileLocation &location) {
+  content_cache_.remove(location.path_);
   auto it = local_location_to_file_id_.find(location);
   if (it == local_location_to_file_id_.end()) {
     return;
@@ -1695,9 +1742,9 @@ Status FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sync) {
   int size_i = merge_choose_size(x_node->size_, y_node->size_);
   int expected_size_i = merge_choose_expected_size(x_node->expected_size_, y_node->expected_size_);
   int remote_name_i = merge_choose_name(x_node->remote_name_, y_node->remote_name_);
-  int url_i = merge_choose_name(x_node->url_, y_node->url_);
+  int url_i = merge_choose_name(x_node->get_url(), y_node->get_url());
   int owner_i = merge_choose_owner(x_node->owner_dialog_id_, y_node->owner_dialog_id_);
-  int encryption_key_i = merge_choose_encryption_key(x_node->encryption_key_, y_node->encryption_key_);
+  int encryption_key_i = merge_choose_encryption_key(x_node->get_encryption_key(), y_node->get_encryption_key());
   int main_file_id_i = merge_choose_main_file_id(x_node->main_file_id_, x_node->main_file_id_priority_,
                                                  y_node->main_file_id_, y_node->main_file_id_priority_);
 
@@ -1817,7 +1864,7 @@ Status FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sync) {
   }
 
   if (url_i == other_node_i) {
-    node->set_url(other_node->url_);
+    node->set_url(other_node->get_url());
   }
 
   if (owner_i == other_node_i) {
@@ -1825,8 +1872,8 @@ Status FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sync) {
   }
 
   if (encryption_key_i == other_node_i) {
-    node->set_encryption_key(other_node->encryption_key_);
-    nodes[node_i]->set_encryption_key(nodes[encryption_key_i]->encryption_key_);
+    node->set_encryption_key(other_node->get_encryption_key());
+    nodes[node_i]->set_encryption_key(nodes[encryption_key_i]->get_encryption_key());
   }
   node->need_load_from_pmc_ |= other_node->need_load_from_pmc_;
   node->can_search_locally_ &= other_node->can_search_locally_;
@@ -1889,6 +1936,7 @@ Status FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sync) {
   }
 
   file_nodes_[node_ids[other_node_i]] = nullptr;
+  empty_file_node_ids_.push_back(node_ids[other_node_i]);
 
   run_generate(node);
   run_download(node, false);
@@ -2109,15 +2157,15 @@ void FileManager::flush_to_pmc(FileNodePtr node, bool new_remote, bool new_local
     data.local_ = LocalFileLocation();
     data.remote_ = RemoteFileLocation();
   }
-  if (data.remote_.type() != RemoteFileLocation::Type::Full && node->encryption_key_.is_secure()) {
+  if (data.remote_.type() != RemoteFileLocation::Type::Full && node->get_encryption_key().is_secure()) {
     data.remote_ = RemoteFileLocation();
   }
 
   data.size_ = node->size_;
   data.expected_size_ = node->expected_size_;
   data.remote_name_ = node->remote_name_;
-  data.encryption_key_ = node->encryption_key_;
-  data.url_ = node->url_;
+  data.encryption_key_ = node->get_encryption_key();
+  data.url_ = node->get_url();
   data.owner_dialog_id_ = node->owner_dialog_id_;
   data.file_source_ids_ = context_->get_some_file_sources(view.get_main_file_id());
   VLOG(file_references) << "Save file " << view.get_main_file_id() << " to database with " << data.file_source_ids_
@@ -2208,7 +2256,7 @@ bool FileManager::set_encryption_key(FileId file_id, FileEncryptionKey key) {
   if (view.has_local_location() && view.has_remote_location()) {
     return false;
   }
-  if (!node->encryption_key_.empty()) {
+  if (!node->get_encryption_key().empty()) {
     return false;
   }
   node->set_encryption_key(std::move(key));
@@ -2245,6 +2293,9 @@ bool FileManager::set_content(FileId file_id, BufferSlice bytes) {
   QueryId query_id = queries_container_.create(Query{file_id, Query::Type::SetContent});
   node->download_id_ = query_id;
   node->is_download_started_ = true;
+  if (can_cache_content(static_cast<int64>(bytes.size()))) {
+    set_content_bytes_[query_id] = bytes.as_slice().str();
+  }
   send_closure(file_load_manager_, &FileLoadManager::from_bytes, query_id, node->remote_.full.value().file_type_,
                std::move(bytes), node->suggested_path());
   return true;
@@ -2262,6 +2313,11 @@ void FileManager::get_content(FileId file_id, Promise<BufferSlice> promise) {
     return promise.set_error(Status::Error("No local location"));
   }
 
+  auto *content = content_cache_.get(node->local_.full());
+  if (content != nullptr) {
+    return promise.set_value(BufferSlice(*content));
+  }
+
   send_closure(file_load_manager_, &FileLoadManager::get_content, node->local_.full().path_, std::move(promise));
 }
 
@@ -2300,11 +2356,20 @@ void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int
 
   const string *path = nullptr;
   bool is_partial = false;
+  bool need_cache_content = false;
   if (file_view.has_local_location()) {
     path = &file_view.local_location().path_;
     if (!begins_with(*path, get_files_dir(file_view.get_type()))) {
       return promise.set_error(Status::Error(400, "File is not inside the cache"));
     }
+    auto *content = content_cache_.get(file_view.local_location());
+    if (content != nullptr && offset + count <= static_cast<int64>(content->size())) {
+      auto result = td_api::make_object<td_api::filePart>();
+      result->data_ = content->substr(static_cast<size_t>(offset), static_cast<size_t>(count));
+      return promise.set_value(std::move(result));
+    }
+    // small files are read completely to serve subsequent requests from the cache
+    need_cache_content = content == nullptr && can_cache_content(node->size_);
   } else {
     CHECK(node->local_.type() == LocalFileLocation::Type::Partial);
     path = &node->local_.partial().path_;
@@ -2313,6 +2378,7 @@ void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int
 
   auto read_file_part_promise =
       PromiseCreator::lambda([actor_id = actor_id(this), file_id, offset, count, left_tries, is_partial,
+                              location = need_cache_content ? file_view.local_location() : FullLocalFileLocation(),
                               promise = std::move(promise)](Result<string> r_bytes) mutable {
         if (r_bytes.is_error()) {
           LOG(INFO) << "Failed to read file bytes: " << r_bytes.error();
@@ -2329,14 +2395,41 @@ void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int
                                                   left_tries - 1, std::move(promise));
                                    }))
               .release();
+        } else if (!location.path_.empty()) {
+          auto content = r_bytes.move_as_ok();
+          if (offset + count > static_cast<int64>(content.size())) {
+            return promise.set_error(Status::Error(400, "Failed to read the file"));
+          }
+          auto result = td_api::make_object<td_api::filePart>();
+          result->data_ = content.substr(static_cast<size_t>(offset), static_cast<size_t>(count));
+          promise.set_value(std::move(result));
+          send_closure(actor_id, &FileManager::on_file_content_read, std::move(location), std::move(content));
         } else {
           auto result = td_api::make_object<td_api::filePart>();
           result->data_ = r_bytes.move_as_ok();
           promise.set_value(std::move(result));
         }
       });
-  send_closure(file_load_manager_, &FileLoadManager::read_file_part, *path, offset, count,
-               std::move(read_file_part_promise));
+  if (need_cache_content) {
+    send_closure(file_load_manager_, &FileLoadManager::read_file_part, *path, 0, -1,
+                 std::move(read_file_part_promise));
+  } else {
+    send_closure(file_load_manager_, &FileLoadManager::read_file_part, *path, offset, count,
+                 std::move(read_file_part_promise));
+  }
+}
+
+bool FileManager::can_cache_content(int64 size) const {
+  return 0 < size && size <= FileContentCache::MAX_FILE_SIZE &&
+         G()->get_option_integer("file_content_cache_size", DEFAULT_FILE_CONTENT_CACHE_SIZE) >= size;
+}
+
+void FileManager::on_file_content_read(FullLocalFileLocation location, string content) {
+  if (is_closed_) {
+    return;
+  }
+  content_cache_.set_max_size(G()->get_option_integer("file_content_cache_size", DEFAULT_FILE_CONTENT_CACHE_SIZE));
+  content_cache_.add(location, std::move(content));
 }
 
 void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char *source) {
@@ -2372,6 +2465,7 @@ void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char
   }
 
   LOG(INFO) << "Unlink file " << file_id << " at " << path;
+  content_cache_.remove(path);
   node->drop_local_location();
   try_flush_node(node, "delete_file");
   send_closure(file_load_manager_, &FileLoadManager::unlink_file, path, std::move(promise));
@@ -2424,6 +2518,7 @@ void FileManager::download_impl(FileId file_id, std::shared_ptr<DownloadCallback
   }
   if (node->local_.type() == LocalFileLocation::Type::Full) {
     LOG(INFO) << "File " << file_id << " is already downloaded";
+    context_->on_file_accessed(node->local_.full(), node->size_);
     if (callback) {
       callback->on_download_ok(file_id);
     }
@@ -2450,6 +2545,7 @@ void FileManager::download_impl(FileId file_id, std::shared_ptr<DownloadCallback
 
   LOG(INFO) << "Change download priority of file " << file_id << " to " << new_priority << " with callback "
             << callback.get();
+  node->update_download_read_ahead(offset, limit);
   node->set_download_offset(offset);
   node->set_download_limit(limit);
   auto *file_info = get_file_id_info(file_id);
@@ -2598,7 +2694,7 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
   node->is_download_started_ = false;
   LOG(INFO) << "Run download of file " << file_id << " of size " << node->size_ << " from "
             << node->remote_.full.value() << " with suggested name " << node->suggested_path() << " and encyption key "
-            << node->encryption_key_;
+            << node->get_encryption_key();
   auto download_offset = node->download_offset_;
   auto download_limit = node->get_download_limit();
   if (file_view.is_encrypted_any()) {
@@ -2608,8 +2704,8 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
     download_offset = 0;
   }
   send_closure(file_load_manager_, &FileLoadManager::download, query_id, node->remote_.full.value(), node->local_,
-               node->size_, node->suggested_path(), node->encryption_key_, node->can_search_locally_, download_offset,
-               download_limit, priority);
+               node->size_, node->suggested_path(), node->get_encryption_key(), node->can_search_locally_,
+               download_offset, download_limit, priority);
 }
 
 class FileManager::ForceUploadActor final : public Actor {
@@ -3124,7 +3220,7 @@ void FileManager::run_upload(FileNodePtr node, vector<int> bad_parts) {
   QueryId query_id = queries_container_.create(Query{file_id, Query::Type::Upload});
   node->upload_id_ = query_id;
   send_closure(file_load_manager_, &FileLoadManager::upload, query_id, node->local_, node->remote_.partial_or_empty(),
-               expected_size, node->encryption_key_, new_priority, std::move(bad_parts));
+               expected_size, node->get_encryption_key(), new_priority, std::move(bad_parts));
 
   LOG(INFO) << "File " << file_id << " upload request has sent to FileLoadManager";
 }
@@ -3672,6 +3768,13 @@ FileId FileManager::next_file_id() {
 }
 
 FileManager::FileNodeId FileManager::next_file_node_id() {
+  if (!empty_file_node_ids_.empty()) {
+    // reuse identifiers of nodes, which were merged into other nodes
+    auto res = empty_file_node_ids_.back();
+    empty_file_node_ids_.pop_back();
+    CHECK(file_nodes_[res] == nullptr);
+    return res;
+  }
   CHECK(file_nodes_.size() <= static_cast<size_t>(std::numeric_limits<FileNodeId>::max()));
   auto res = static_cast<FileNodeId>(file_nodes_.size());
   file_nodes_.emplace_back(nullptr);
@@ -3749,7 +3852,7 @@ void FileManager::on_hash(QueryId query_id, string hash) {
     return;
   }
 
-  file_node->encryption_key_.set_value_hash(secure_storage::ValueHash::create(hash).move_as_ok());
+  file_node->get_extra().encryption_key_.set_value_hash(secure_storage::ValueHash::create(hash).move_as_ok());
 }
 
 void FileManager::on_partial_upload(QueryId query_id, PartialRemoteFileLocation partial_remote, int64 ready_size) {
@@ -3783,11 +3886,22 @@ void FileManager::on_download_ok(QueryId query_id, FullLocalFileLocation local,
     return;
   }
 
+  string content;
+  auto content_it = set_content_bytes_.find(query_id);
+  if (content_it != set_content_bytes_.end()) {
+    content = std::move(content_it->second);
+    set_content_bytes_.erase(content_it);
+  }
+
   Query query;
   bool was_active;
   std::tie(query, was_active) = finish_query(query_id);
   auto file_id = query.file_id_;
   LOG(INFO) << "ON DOWNLOAD OK of " << (is_new ? "new" : "checked") << " file " << file_id << " of size " << size;
+  context_->on_file_accessed(local, size);
+  if (!content.empty() && static_cast<int64>(content.size()) == size) {
+    on_file_content_read(local, std::move(content));
+  }
   auto r_new_file_id = register_local(std::move(local), DialogId(), size, false, false, true, file_id);
   Status status = Status::OK();
   if (r_new_file_id.is_error()) {
@@ -4145,6 +4259,7 @@ std::pair<FileManager::Query, bool> FileManager::finish_query(QueryId query_id)
   SCOPE_EXIT {
     queries_container_.erase(query_id);
   };
+  set_content_bytes_.erase(query_id);
   auto query = queries_container_.get(query_id);
   CHECK(query != nullptr);
 
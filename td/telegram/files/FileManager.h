@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileContentCache.h"
 #include "td/telegram/files/FileDbId.h"
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileGenerateManager.h"
@@ -79,11 +80,14 @@ class FileNode {
       , size_(size)
       , expected_size_(expected_size)
       , remote_name_(std::move(remote_name))
-      , url_(std::move(url))
       , owner_dialog_id_(owner_dialog_id)
-      , encryption_key_(std::move(key))
       , main_file_id_(main_file_id)
       , main_file_id_priority_(main_file_id_priority) {
+    if (!url.empty() || !key.empty()) {
+      extra_ = make_unique<Extra>();
+      extra_->url_ = std::move(url);
+      extra_->encryption_key_ = std::move(key);
+    }
     init_ready_size();
   }
   void drop_local_location();
@@ -123,6 +127,10 @@ class FileNode {
 
   int64 get_download_limit() const;
 
+  const string &get_url() const;
+
+  const FileEncryptionKey &get_encryption_key() const;
+
   string suggested_path() const;
 
  private:
@@ -137,6 +145,7 @@ class FileNode {
   FileLoadManager::QueryId upload_id_ = 0;
   int64 download_offset_ = 0;
   int64 private_download_limit_ = 0;
+  int64 download_read_ahead_ = 0;
   int64 local_ready_size_ = 0;         // PartialLocal only
   int64 local_ready_prefix_size_ = 0;  // PartialLocal only
 
@@ -150,9 +159,7 @@ class FileNode {
   int64 size_ = 0;
   int64 expected_size_ = 0;
   string remote_name_;
-  string url_;
   DialogId owner_dialog_id_;
-  FileEncryptionKey encryption_key_;
   FileDbId pmc_id_;
   vector<FileId> file_ids_;
 
@@ -193,12 +200,23 @@ class FileNode {
 
   bool ignore_download_limit_{false};
 
+  // rarely used fields are stored separately to reduce memory usage for millions of files
+  struct Extra {
+    string url_;
+    FileEncryptionKey encryption_key_;
+  };
+  unique_ptr<Extra> extra_;
+
+  Extra &get_extra();
+
   void init_ready_size();
 
   void recalc_ready_prefix_size(int64 prefix_offset, int64 ready_prefix_size);
 
   void update_effective_download_limit(int64 old_download_limit);
 
+  void update_download_read_ahead(int64 download_offset, int64 download_limit);
+
   string get_persistent_file_id() const;
 
   string get_unique_file_id() const;
@@ -350,7 +368,7 @@ class FileView {
     return is_encrypted_secret() || is_secure();
   }
   const FileEncryptionKey &encryption_key() const {
-    return node_->encryption_key_;
+    return node_->get_encryption_key();
   }
 
   bool may_reload_photo() const {
@@ -416,6 +434,8 @@ class FileManager final : public FileLoadManager::Callback {
 
     virtual void on_new_file(int64 size, int64 real_size, int32 cnt) = 0;
 
+    virtual void on_file_accessed(const FullLocalFileLocation &location, int64 size) = 0;
+
     virtual void on_file_updated(FileId size) = 0;
 
     virtual bool add_file_source(FileId file_id, FileSourceId file_source_id) = 0;
@@ -566,6 +586,7 @@ class FileManager final : public FileLoadManager::Callback {
                                const char *source, bool force, bool skip_file_size_checks = false);
 
   static constexpr int8 FROM_BYTES_PRIORITY = 10;
+  static constexpr int64 DEFAULT_FILE_CONTENT_CACHE_SIZE = 4 << 20;
 
   using FileNodeId = int32;
 
@@ -634,11 +655,15 @@ class FileManager final : public FileLoadManager::Callback {
   WaitFreeVector<FileIdInfo> file_id_info_;
   WaitFreeVector<int32> empty_file_ids_;
   WaitFreeVector<unique_ptr<FileNode>> file_nodes_;
+  vector<FileNodeId> empty_file_node_ids_;
   ActorOwn<FileLoadManager> file_load_manager_;
   ActorOwn<FileGenerateManager> file_generate_manager_;
 
   Container<Query> queries_container_;
 
+  FileContentCache content_cache_;
+  std::map<QueryId, string> set_content_bytes_;
+
   bool is_closed_ = false;
 
   std::set<std::string> bad_paths_;
@@ -647,6 +672,9 @@ class FileManager final : public FileLoadManager::Callback {
 
   FileId next_file_id();
   FileNodeId next_file_node_id();
+
+  bool can_cache_content(int64 size) const;
+  void on_file_content_read(FullLocalFileLocation location, string content);
   int32 next_pmc_file_id();
   FileId create_file_id(int32 file_node_id, FileNode *file_node);
   void try_forget_file_id(FileId file_id);
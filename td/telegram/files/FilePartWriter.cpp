@@ -0,0 +1,32 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FilePartWriter.h"
+
+#include "td/utils/port/platform.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+void FilePartWriter::write(int64 offset, BufferSlice bytes, Promise<size_t> promise) {
+  if (fd_.empty()) {
+    auto r_fd = FileFd::open(path_, FileFd::Write);
+    if (r_fd.is_error()) {
+      return promise.set_error(r_fd.move_as_error());
+    }
+    fd_ = r_fd.move_as_ok();
+  }
+
+  FileFd::IoCategoryGuard io_category_guard(io_category_);
+  auto r_written = fd_.pwrite(bytes.as_slice(), offset);
+#if TD_PORT_WINDOWS
+  // the file can't be moved on Windows while it is open
+  fd_.close();
+#endif
+  promise.set_result(std::move(r_written));
+}
+
+}  // namespace td
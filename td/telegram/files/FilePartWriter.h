@@ -0,0 +1,38 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
+
+#include <utility>
+
+namespace td {
+
+// writes parts of a downloaded file on a separate scheduler, so slow file systems don't delay network I/O
+// parts are written in the order in which they were sent from the same actor
+class FilePartWriter final : public Actor {
+ public:
+  // the I/O category must be a static string
+  FilePartWriter(string path, Slice io_category) : path_(std::move(path)), io_category_(io_category) {
+  }
+
+  // returns the number of written bytes
+  void write(int64 offset, BufferSlice bytes, Promise<size_t> promise);
+
+ private:
+  string path_;
+  Slice io_category_;
+  FileFd fd_;
+};
+
+}  // namespace td
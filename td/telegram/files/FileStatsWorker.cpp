@@ -26,13 +26,16 @@
 #include "td/utils/PathView.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_parsers.h"
 
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 namespace td {
 namespace {
@@ -92,6 +95,8 @@ void scan_db(CancellationToken &token, CallbackT &&callback) {
   });
 }
 
+constexpr size_t MAX_SCAN_THREAD_COUNT = 4;
+
 struct FsFileInfo {
   FileType file_type;
   string path;
@@ -100,48 +105,91 @@ struct FsFileInfo {
   uint64 mtime_nsec;
 };
 
+vector<FsFileInfo> scan_dir(const CancellationToken &token, FileType file_type, const string &file_dir) {
+  vector<FsFileInfo> result;
+  LOG(INFO) << "Scanning directory " << file_dir;
+  walk_path(file_dir, [&](CSlice path, WalkPath::Type type) {
+    if (token) {
+      return WalkPath::Action::Abort;
+    }
+    if (type != WalkPath::Type::RegularFile) {
+      return WalkPath::Action::Continue;
+    }
+    auto r_stat = stat(path);
+    if (r_stat.is_error()) {
+      LOG(WARNING) << "Stat in files gc failed: " << r_stat.error();
+      return WalkPath::Action::Continue;
+    }
+    auto stat = r_stat.move_as_ok();
+    if (stat.size_ == 0 && ends_with(path, "/.nomedia")) {
+      // skip .nomedia file
+      return WalkPath::Action::Continue;
+    }
+
+    FsFileInfo info;
+    info.path = path.str();
+    info.size = stat.real_size_;
+    info.file_type = guess_file_type_by_path(path, file_type);
+    info.atime_nsec = stat.atime_nsec_;
+    info.mtime_nsec = stat.mtime_nsec_;
+    result.push_back(std::move(info));
+    return WalkPath::Action::Continue;
+  }).ignore();
+  return result;
+}
+
 template <class CallbackT>
 void scan_fs(CancellationToken &token, CallbackT &&callback) {
   std::unordered_set<string, Hash<string>> scanned_file_dirs;
-  auto scan_dir = [&](FileType file_type, const string &file_dir) {
-    if (!scanned_file_dirs.insert(file_dir).second) {
-      return;
+  vector<std::pair<FileType, string>> file_dirs;
+  auto add_dir = [&](FileType file_type, string file_dir) {
+    if (scanned_file_dirs.insert(file_dir).second) {
+      file_dirs.emplace_back(file_type, std::move(file_dir));
     }
-    LOG(INFO) << "Scanning directory " << file_dir;
-    walk_path(file_dir, [&](CSlice path, WalkPath::Type type) {
-      if (token) {
-        return WalkPath::Action::Abort;
-      }
-      if (type != WalkPath::Type::RegularFile) {
-        return WalkPath::Action::Continue;
-      }
-      auto r_stat = stat(path);
-      if (r_stat.is_error()) {
-        LOG(WARNING) << "Stat in files gc failed: " << r_stat.error();
-        return WalkPath::Action::Continue;
-      }
-      auto stat = r_stat.move_as_ok();
-      if (stat.size_ == 0 && ends_with(path, "/.nomedia")) {
-        // skip .nomedia file
-        return WalkPath::Action::Continue;
-      }
-
-      FsFileInfo info;
-      info.path = path.str();
-      info.size = stat.real_size_;
-      info.file_type = guess_file_type_by_path(path, file_type);
-      info.atime_nsec = stat.atime_nsec_;
-      info.mtime_nsec = stat.mtime_nsec_;
-      callback(info);
-      return WalkPath::Action::Continue;
-    }).ignore();
   };
   for (int32 i = 0; i < MAX_FILE_TYPE; i++) {
     auto file_type = static_cast<FileType>(i);
-    scan_dir(get_main_file_type(file_type), get_files_dir(file_type));
+    add_dir(get_main_file_type(file_type), get_files_dir(file_type));
+  }
+  add_dir(get_main_file_type(FileType::Temp), get_files_temp_dir(FileType::SecureDecrypted));
+  add_dir(get_main_file_type(FileType::Temp), get_files_temp_dir(FileType::Video));
+
+  // directories are scanned in parallel, because most of the time is spent waiting for the file system
+  vector<vector<FsFileInfo>> dir_files(file_dirs.size());
+  std::atomic<size_t> next_dir_pos{0};
+  auto scan_dirs = [&] {
+    while (true) {
+      auto pos = next_dir_pos.fetch_add(1, std::memory_order_relaxed);
+      if (pos >= file_dirs.size()) {
+        break;
+      }
+      dir_files[pos] = scan_dir(token, file_dirs[pos].first, file_dirs[pos].second);
+    }
+  };
+#if !TD_THREAD_UNSUPPORTED
+  auto thread_count = clamp(static_cast<size_t>(thread::hardware_concurrency()), static_cast<size_t>(1),
+                            static_cast<size_t>(MAX_SCAN_THREAD_COUNT));
+  thread_count = min(thread_count, file_dirs.size());
+  vector<thread> threads;
+  for (size_t i = 1; i < thread_count; i++) {
+    threads.emplace_back(scan_dirs);
+  }
+  scan_dirs();
+  for (auto &scan_thread : threads) {
+    scan_thread.join();
+  }
+#else
+  scan_dirs();
+#endif
+
+  for (auto &files : dir_files) {
+    for (auto &info : files) {
+      if (token) {
+        return;
+      }
+      callback(info);
+    }
   }
-  scan_dir(get_main_file_type(FileType::Temp), get_files_temp_dir(FileType::SecureDecrypted));
-  scan_dir(get_main_file_type(FileType::Temp), get_files_temp_dir(FileType::Video));
 }
 }  // namespace
 
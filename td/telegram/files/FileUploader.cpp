@@ -7,6 +7,7 @@
 #include "td/telegram/files/FileUploader.h"
 
 #include "td/telegram/files/FileLoaderUtils.h"
+#include "td/telegram/files/FileType.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
@@ -222,11 +223,13 @@ Status FileUploader::generate_iv_map() {
   LOG(INFO) << "Generate iv_map " << generate_offset_ << " " << local_size_;
   auto part_size = get_part_size();
   auto encryption_key = FileEncryptionKey(encryption_key_.key_slice(), generate_iv_);
+  BufferOwnerGuard buffer_owner_guard(BufferOwner::FilePart);
   BufferSlice bytes(part_size);
   if (iv_map_.empty()) {
     iv_map_.push_back(encryption_key.mutable_iv());
   }
   CHECK(!fd_.empty());
+  FileFd::IoCategoryGuard io_category_guard(get_file_type_unique_name(file_type_));
   for (; generate_offset_ + static_cast<int64>(part_size) < local_size_;
        generate_offset_ += static_cast<int64>(part_size)) {
     TRY_RESULT(read_size, fd_.pread(bytes.as_mutable_slice(), generate_offset_));
@@ -258,8 +261,12 @@ Result<std::pair<NetQueryPtr, bool>> FileUploader::start_part(Part part, int32 p
   if (encryption_key_.is_secret()) {
     padded_size = (padded_size + 15) & ~15;
   }
+  BufferOwnerGuard buffer_owner_guard(BufferOwner::FilePart);
   BufferSlice bytes(padded_size);
+  FileFd::IoCategoryGuard io_category_guard(get_file_type_unique_name(file_type_));
   TRY_RESULT(size, fd_.pread(bytes.as_mutable_slice().truncate(part.size), part.offset));
+  // read next parts from the disk while the current part is being sent
+  fd_.prefetch(part.offset + static_cast<int64>(part.size), static_cast<int64>(part.size) * PREFETCH_PART_COUNT);
   if (encryption_key_.is_secret()) {
     Random::secure_bytes(bytes.as_mutable_slice().substr(part.size));
     if (next_offset_ == part.offset) {
@@ -36,6 +36,8 @@ class FileUploader final : public FileLoader {
   // Should just implement all parent pure virtual methods.
   // Must not call any of them...
  private:
+  static constexpr int64 PREFETCH_PART_COUNT = 4;  // number of parts, which are read ahead from the disk
+
   ResourceState resource_state_;
   LocalFileLocation local_;
   RemoteFileLocation remote_;
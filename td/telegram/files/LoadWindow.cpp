@@ -0,0 +1,91 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/LoadWindow.h"
+
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+
+#include <algorithm>
+
+namespace td {
+
+void LoadWindow::init(int64 part_size) {
+  CHECK(part_size > 0);
+  part_size_ = part_size;
+  update_window();
+}
+
+void LoadWindow::on_part_started(uint64 query_id, double now) {
+  if (first_sent_at_ == 0) {
+    first_sent_at_ = now;
+    delivered_at_ = now;
+  }
+  auto &part = parts_[query_id];
+  part.sent_at = now;
+  part.delivered = delivered_;
+  part.delivered_at = delivered_at_;
+}
+
+void LoadWindow::on_part_finished(uint64 query_id, int64 size, double now) {
+  auto it = parts_.find(query_id);
+  if (it == parts_.end()) {
+    return;
+  }
+  auto part = it->second;
+  parts_.erase(it);
+
+  delivered_ += size;
+  delivered_at_ = now;
+
+  auto rtt = now - part.sent_at;
+  if (rtt > 0 && (min_rtt_ == 0 || rtt <= min_rtt_ || now > min_rtt_at_ + MIN_RTT_EXPIRE_TIME)) {
+    min_rtt_ = rtt;
+    min_rtt_at_ = now;
+  }
+
+  // the delivery rate is measured over the time of the part loading and can't be bigger than the rate of sending
+  auto interval = max(now - part.sent_at, now - part.delivered_at);
+  if (interval > 0) {
+    bandwidth_samples_[bandwidth_sample_pos_] = static_cast<double>(delivered_ - part.delivered) / interval;
+    bandwidth_sample_pos_ = (bandwidth_sample_pos_ + 1) % BANDWIDTH_SAMPLE_COUNT;
+  }
+  update_window();
+}
+
+void LoadWindow::on_part_failed(uint64 query_id) {
+  parts_.erase(query_id);
+}
+
+double LoadWindow::get_bandwidth() const {
+  return *std::max_element(bandwidth_samples_.begin(), bandwidth_samples_.end());
+}
+
+double LoadWindow::get_average_throughput(double now) const {
+  if (first_sent_at_ == 0 || now <= first_sent_at_) {
+    return 0.0;
+  }
+  return static_cast<double>(delivered_) / (now - first_sent_at_);
+}
+
+void LoadWindow::update_window() {
+  auto min_window = MIN_WINDOW_PART_COUNT * part_size_;
+  auto bandwidth = get_bandwidth();
+  if (bandwidth == 0 || min_rtt_ == 0) {
+    window_ = max(INITIAL_WINDOW, min_window);
+    return;
+  }
+  auto bdp = bandwidth * min_rtt_;
+  window_ = clamp(static_cast<int64>(CWND_GAIN * bdp), min_window, max(MAX_WINDOW, min_window));
+}
+
+StringBuilder &operator<<(StringBuilder &sb, const LoadWindow &window) {
+  return sb << tag("window", window.window_) << tag("bandwidth", static_cast<int64>(window.get_bandwidth()))
+            << tag("min_rtt", window.min_rtt_);
+}
+
+}  // namespace td
@@ -0,0 +1,74 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/StringBuilder.h"
+
+#include <array>
+#include <map>
+
+namespace td {
+
+// BBR-like estimation of the number of bytes, which can be loaded in parallel
+// the window is equal to CWND_GAIN * bandwidth * min_rtt, so it doubles each round trip until the bandwidth stops growing
+class LoadWindow {
+ public:
+  void init(int64 part_size);
+
+  void on_part_started(uint64 query_id, double now);
+
+  void on_part_finished(uint64 query_id, int64 size, double now);
+
+  void on_part_failed(uint64 query_id);
+
+  int64 get_window() const {
+    return window_;
+  }
+
+  double get_bandwidth() const;
+
+  double get_min_rtt() const {
+    return min_rtt_;
+  }
+
+  double get_average_throughput(double now) const;
+
+  friend StringBuilder &operator<<(StringBuilder &sb, const LoadWindow &window);
+
+ private:
+  static constexpr int64 MIN_WINDOW_PART_COUNT = 2;
+  static constexpr int64 INITIAL_WINDOW = 1 << 20;
+  static constexpr int64 MAX_WINDOW = 32 << 20;
+  static constexpr double CWND_GAIN = 2.0;
+  static constexpr double MIN_RTT_EXPIRE_TIME = 10.0;
+  static constexpr size_t BANDWIDTH_SAMPLE_COUNT = 10;
+
+  struct PartState {
+    double sent_at = 0;
+    int64 delivered = 0;
+    double delivered_at = 0;
+  };
+  std::map<uint64, PartState> parts_;
+
+  int64 part_size_ = 1;
+  int64 window_ = INITIAL_WINDOW;
+
+  int64 delivered_ = 0;
+  double delivered_at_ = 0;
+  double first_sent_at_ = 0;
+
+  double min_rtt_ = 0;
+  double min_rtt_at_ = 0;
+
+  std::array<double, BANDWIDTH_SAMPLE_COUNT> bandwidth_samples_{};
+  size_t bandwidth_sample_pos_ = 0;
+
+  void update_window();
+};
+
+}  // namespace td
@@ -31,6 +31,14 @@ void ResourceManager::register_worker(ActorShared<FileLoaderActor> callback, int
   send_closure(node->callback_, &FileLoaderActor::set_resource_manager, actor_shared(this, node_id));
 }
 
+void ResourceManager::set_max_resource_limit(int64 max_resource_limit) {
+  if (stop_flag_ || max_resource_limit_ == max_resource_limit) {
+    return;
+  }
+  max_resource_limit_ = max_resource_limit;
+  loop();
+}
+
 void ResourceManager::update_priority(int8 priority) {
   if (stop_flag_) {
     return;
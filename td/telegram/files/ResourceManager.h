@@ -30,6 +30,8 @@ class ResourceManager final : public Actor {
 
   void register_worker(ActorShared<FileLoaderActor> callback, int8 priority);
 
+  void set_max_resource_limit(int64 max_resource_limit);
+
  private:
   int64 max_resource_limit_ = 0;
   Mode mode_;
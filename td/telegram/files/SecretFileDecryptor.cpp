@@ -0,0 +1,20 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/SecretFileDecryptor.h"
+
+#include "td/utils/crypto.h"
+
+namespace td {
+
+void SecretFileDecryptor::decrypt(BufferSlice bytes, Promise<std::pair<BufferSlice, UInt256>> promise) {
+  if (!bytes.empty()) {
+    aes_ige_decrypt(as_slice(key_), as_mutable_slice(iv_), bytes.as_slice(), bytes.as_mutable_slice());
+  }
+  promise.set_value(std::make_pair(std::move(bytes), iv_));
+}
+
+}  // namespace td
@@ -0,0 +1,35 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+#include "td/utils/UInt.h"
+
+#include <utility>
+
+namespace td {
+
+// decrypts parts of a secret file on a separate scheduler
+// AES-IGE chaining requires parts to be decrypted in order, so parts must be sent in order from the same actor
+class SecretFileDecryptor final : public Actor {
+ public:
+  SecretFileDecryptor(const UInt256 &key, const UInt256 &iv) : key_(key), iv_(iv) {
+  }
+
+  // returns decrypted bytes and the IV to be used for the next part
+  void decrypt(BufferSlice bytes, Promise<std::pair<BufferSlice, UInt256>> promise);
+
+ private:
+  UInt256 key_;
+  UInt256 iv_;
+};
+
+}  // namespace td
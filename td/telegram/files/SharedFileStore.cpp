@@ -0,0 +1,96 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/SharedFileStore.h"
+
+#include "td/telegram/files/FileLocation.hpp"
+
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/tl_helpers.h"
+
+#include <mutex>
+
+namespace td {
+
+namespace {
+
+struct SharedFile {
+  int64 size = 0;
+  string path;
+};
+
+struct SharedFiles {
+  std::mutex mutex;
+  FlatHashMap<string, SharedFile> files;
+};
+
+SharedFiles &get_shared_files() {
+  static SharedFiles shared_files;
+  return shared_files;
+}
+
+string get_shared_file_key(const FullRemoteFileLocation &remote) {
+  CHECK(!remote.is_web());
+  return serialize(remote.as_unique());
+}
+
+}  // namespace
+
+void SharedFileStore::add_file(const FullRemoteFileLocation &remote, int64 size, string path) {
+  if (remote.is_web() || size <= 0 || path.empty()) {
+    return;
+  }
+  auto key = get_shared_file_key(remote);
+  auto &shared_files = get_shared_files();
+  std::lock_guard<std::mutex> guard(shared_files.mutex);
+  auto &file = shared_files.files[key];
+  file.size = size;
+  file.path = std::move(path);
+}
+
+string SharedFileStore::get_file(const FullRemoteFileLocation &remote, int64 size) {
+  if (remote.is_web() || size <= 0) {
+    return string();
+  }
+  auto key = get_shared_file_key(remote);
+  auto &shared_files = get_shared_files();
+  string path;
+  {
+    std::lock_guard<std::mutex> guard(shared_files.mutex);
+    auto it = shared_files.files.find(key);
+    if (it == shared_files.files.end() || it->second.size != size) {
+      return string();
+    }
+    path = it->second.path;
+  }
+
+  // the file could have been deleted by its owner
+  auto r_stat = stat(path);
+  if (r_stat.is_error() || r_stat.ok().size_ != size) {
+    LOG(INFO) << "Shared file " << path << " was changed";
+    std::lock_guard<std::mutex> guard(shared_files.mutex);
+    auto it = shared_files.files.find(key);
+    if (it != shared_files.files.end() && it->second.path == path) {
+      shared_files.files.erase(it);
+    }
+    return string();
+  }
+  return path;
+}
+
+void SharedFileStore::remove_file(const FullRemoteFileLocation &remote) {
+  if (remote.is_web()) {
+    return;
+  }
+  auto key = get_shared_file_key(remote);
+  auto &shared_files = get_shared_files();
+  std::lock_guard<std::mutex> guard(shared_files.mutex);
+  shared_files.files.erase(key);
+}
+
+}  // namespace td
@@ -0,0 +1,28 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/FileLocation.h"
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// process-wide registry of downloaded files, which allows clients in the same process
+// to copy files downloaded by other clients instead of downloading them again
+// the store is used only by clients with the option "use_shared_file_store" enabled
+class SharedFileStore {
+ public:
+  static void add_file(const FullRemoteFileLocation &remote, int64 size, string path);
+
+  // returns path to a downloaded file with the same unique identifier and size, or an empty string
+  static string get_file(const FullRemoteFileLocation &remote, int64 size);
+
+  static void remove_file(const FullRemoteFileLocation &remote);
+};
+
+}  // namespace td
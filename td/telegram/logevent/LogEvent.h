@@ -174,6 +174,14 @@ class LogEventStorerUnsafe final : public WithContext<TlStorerUnsafe, Global *>
   }
 };
 
+class LogEventStorerBuffer final : public WithContext<TlStorerBuffer, Global *> {
+ public:
+  LogEventStorerBuffer() : WithContext<TlStorerBuffer, Global *>() {
+    store_int(static_cast<int32>(Version::Next) - 1);
+    set_context(G());
+  }
+};
+
 template <class T>
 class LogEventStorerImpl final : public Storer {
  public:
@@ -203,6 +211,7 @@ class LogEventStorerImpl final : public Storer {
 
 using LogEvent = log_event::LogEvent;
 using LogEventParser = log_event::LogEventParser;
+using LogEventStorerBuffer = log_event::LogEventStorerBuffer;
 using LogEventStorerCalcLength = log_event::LogEventStorerCalcLength;
 using LogEventStorerUnsafe = log_event::LogEventStorerUnsafe;
 
@@ -224,16 +233,13 @@ inline int32 log_event_get_version(Slice slice) {
 
 template <class T>
 BufferSlice log_event_store_impl(const T &data, const char *file, int line) {
-  LogEventStorerCalcLength storer_calc_length;
-  store(data, storer_calc_length);
+  LogEventStorerBuffer storer;
+  store(data, storer);
 
-  BufferSlice value_buffer{storer_calc_length.get_length()};
-  auto ptr = value_buffer.as_mutable_slice().ubegin();
+  auto value_buffer = storer.move_as_buffer_slice();
+  auto ptr = value_buffer.as_slice().ubegin();
   LOG_CHECK(is_aligned_pointer<4>(ptr)) << ptr;
 
-  LogEventStorerUnsafe storer_unsafe(ptr);
-  store(data, storer_unsafe);
-
 #ifdef TD_DEBUG
   T check_result;
   auto status = log_event_parse(check_result, value_buffer.as_slice());
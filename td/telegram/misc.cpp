@@ -7,13 +7,23 @@
 #include "td/telegram/misc.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/bits.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/Hints.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/platform.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StringPool.h"
 #include "td/utils/utf8.h"
 
+#ifdef __aarch64__
+#include <arm_neon.h>
+#elif TD_SSE2
+#include <emmintrin.h>
+#endif
+
 #include <cstring>
 #include <limits>
 
@@ -71,6 +81,42 @@ void replace_offending_characters(string &str) {
   }
 }
 
+// returns a pointer to the first character, which can be changed by clean_input_string, or data_end
+static const char *skip_clean_input_characters(const char *data, const char *data_end) {
+#ifdef __aarch64__
+  while (data_end - data >= 16) {
+    auto input = vld1q_u8(reinterpret_cast<const uint8 *>(data));
+    auto is_special = vorrq_u8(vcltq_u8(input, vdupq_n_u8(0x20)),
+                               vorrq_u8(vceqq_u8(input, vdupq_n_u8(0xe2)), vceqq_u8(input, vdupq_n_u8(0xcc))));
+    if (vmaxvq_u8(is_special) != 0) {
+      break;
+    }
+    data += 16;
+  }
+#elif TD_SSE2
+  while (data_end - data >= 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    // bytes less than 0x20 are exactly the bytes, which don't change after min with 0x1f
+    auto is_special = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(input, _mm_set1_epi8(0x1f)), input),
+                                   _mm_or_si128(_mm_cmpeq_epi8(input, _mm_set1_epi8(static_cast<char>(0xe2))),
+                                                _mm_cmpeq_epi8(input, _mm_set1_epi8(static_cast<char>(0xcc)))));
+    auto mask = static_cast<uint32>(_mm_movemask_epi8(is_special));
+    if (mask != 0) {
+      return data + count_trailing_zeroes_non_zero32(mask);
+    }
+    data += 16;
+  }
+#endif
+  while (data != data_end) {
+    auto c = static_cast<unsigned char>(*data);
+    if (c < 0x20 || c == 0xe2 || c == 0xcc) {
+      break;
+    }
+    data++;
+  }
+  return data;
+}
+
 bool clean_input_string(string &str) {
   constexpr size_t LENGTH_LIMIT = 35000;  // server side limit
   if (!check_utf8(str)) {
@@ -80,6 +126,23 @@ bool clean_input_string(string &str) {
   size_t str_size = str.size();
   size_t new_size = 0;
   for (size_t pos = 0; pos < str_size; pos++) {
+    if (new_size + 4 < LENGTH_LIMIT) {
+      // fast path: move characters, which are kept as is, at once
+      auto max_run_size = min(str_size - pos, LENGTH_LIMIT - 4 - new_size);
+      auto run_begin = str.data() + pos;
+      auto run_size = static_cast<size_t>(skip_clean_input_characters(run_begin, run_begin + max_run_size) - run_begin);
+      if (run_size != 0) {
+        if (new_size != pos) {
+          std::memmove(&str[new_size], run_begin, run_size);
+        }
+        new_size += run_size;
+        pos += run_size;
+        if (pos == str_size) {
+          break;
+        }
+      }
+    }
+
     auto c = static_cast<unsigned char>(str[pos]);
     switch (c) {
       // remove control characters
@@ -390,6 +453,22 @@ Status validate_bot_language_code(const string &language_code) {
   return Status::Error(400, "Invalid language code specified");
 }
 
+static StringPool &get_string_pool() {
+  static StringPool string_pool;
+  return string_pool;
+}
+
+SharedSlice intern_string(Slice str) {
+  return get_string_pool().intern(str);
+}
+
+string get_interned_string_stats() {
+  auto stats = get_string_pool().get_stats();
+  return PSTRING() << "Interned strings: " << stats.string_count << " strings of total size " << stats.total_size
+                   << " with " << stats.reference_count << " references, saving at least " << stats.saved_size
+                   << " bytes";
+}
+
 vector<int32> search_strings_by_prefix(const vector<string> &strings, const string &query, int32 limit,
                                        bool return_all_for_empty_query, int32 &total_count) {
   Hints hints;
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/SharedSlice.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
@@ -54,6 +55,12 @@ bool check_currency_amount(int64 amount);
 // checks whether language code is valid for bot settings
 Status validate_bot_language_code(const string &language_code);
 
+// returns a copy of a frequently repeated string like a language code, sharing memory with other copies
+SharedSlice intern_string(Slice str);
+
+// returns memory statistics of interned strings
+string get_interned_string_stats();
+
 // returns 0-based indexes of strings matching the query by prefixes
 vector<int32> search_strings_by_prefix(const vector<string> &strings, const string &query, int32 limit,
                                        bool return_all_for_empty_query, int32 &total_count);
@@ -93,6 +93,28 @@ class StatsCallback final : public mtproto::RawConnection::StatsCallback {
   DcOptionsSet::Stat *option_stat_;
 };
 
+class DnsCacheStorage final : public GetHostByNameActor::Storage {
+ public:
+  DnsCacheStorage(ActorId<ConnectionCreator> connection_creator, string database_key, string data)
+      : connection_creator_(std::move(connection_creator))
+      , database_key_(std::move(database_key))
+      , data_(std::move(data)) {
+  }
+
+  string load() final {
+    return std::move(data_);
+  }
+
+  void save(string data) final {
+    send_closure(connection_creator_, &ConnectionCreator::save_dns_cache, database_key_, std::move(data));
+  }
+
+ private:
+  ActorId<ConnectionCreator> connection_creator_;
+  string database_key_;
+  string data_;
+};
+
 }  // namespace detail
 
 ConnectionCreator::ClientInfo::ClientInfo() {
@@ -253,6 +275,8 @@ ActorId<GetHostByNameActor> ConnectionCreator::get_dns_resolver() {
       options.resolver_types = {GetHostByNameActor::ResolverType::Google, GetHostByNameActor::ResolverType::Native};
       options.ok_timeout = 60;
       options.error_timeout = 0;
+      options.stale_timeout = DNS_CACHE_STALE_TIME;
+      options.storage = create_dns_cache_storage("dns_cache_block_bypass");
       block_get_host_by_name_actor_ = create_actor<GetHostByNameActor>("BlockDnsResolverActor", std::move(options));
     }
     return block_get_host_by_name_actor_.get();
@@ -263,17 +287,35 @@ ActorId<GetHostByNameActor> ConnectionCreator::get_dns_resolver() {
       options.scheduler_id = G()->get_gc_scheduler_id();
       options.ok_timeout = 5 * 60 - 1;
       options.error_timeout = 0;
+      options.stale_timeout = DNS_CACHE_STALE_TIME;
+      options.storage = create_dns_cache_storage("dns_cache");
       get_host_by_name_actor_ = create_actor<GetHostByNameActor>("DnsResolverActor", std::move(options));
     }
     return get_host_by_name_actor_.get();
   }
 }
 
+std::shared_ptr<GetHostByNameActor::Storage> ConnectionCreator::create_dns_cache_storage(string database_key) {
+  if (G()->get_option_boolean("disable_persistent_dns_cache")) {
+    G()->td_db()->get_binlog_pmc()->erase(database_key);
+    return nullptr;
+  }
+  auto data = G()->td_db()->get_binlog_pmc()->get(database_key);
+  return std::make_shared<detail::DnsCacheStorage>(actor_id(this), std::move(database_key), std::move(data));
+}
+
+void ConnectionCreator::save_dns_cache(string database_key, string data) {
+  if (G()->close_flag()) {
+    return;
+  }
+  G()->td_db()->get_binlog_pmc()->set(database_key, data);
+}
+
 void ConnectionCreator::ping_proxy(int32 proxy_id, Promise<double> promise) {
   CHECK(!close_flag_);
   if (proxy_id == 0) {
     auto main_dc_id = G()->net_query_dispatcher().get_main_dc_id();
-    bool prefer_ipv6 = G()->get_option_boolean("prefer_ipv6");
+    bool prefer_ipv6 = G()->get_option_boolean(CachedOption::PreferIpv6);
     auto infos = dc_options_set_.find_all_connections(main_dc_id, false, false, prefer_ipv6, false);
     if (infos.empty()) {
       return promise.set_error(Status::Error(400, "Can't find valid DC address"));
@@ -320,7 +362,7 @@ void ConnectionCreator::ping_proxy(int32 proxy_id, Promise<double> promise) {
     return promise.set_error(Status::Error(400, "Unknown proxy identifier"));
   }
   const Proxy &proxy = it->second;
-  bool prefer_ipv6 = G()->get_option_boolean("prefer_ipv6");
+  bool prefer_ipv6 = G()->get_option_boolean(CachedOption::PreferIpv6);
   send_closure(get_dns_resolver(), &GetHostByNameActor::run, proxy.server().str(), proxy.port(), prefer_ipv6,
                PromiseCreator::lambda([actor_id = actor_id(this), promise = std::move(promise),
                                        proxy_id](Result<IPAddress> result) mutable {
@@ -611,6 +653,7 @@ void ConnectionCreator::request_raw_connection(DcId dc_id, bool allow_media_only
   VLOG(connections) << "Request connection for " << tag("client", format::as_hex(client.hash)) << " to " << dc_id << " "
                     << tag("allow_media_only", allow_media_only);
   client.queries.push_back(std::move(promise));
+  client.last_query_time = Time::now();
 
   client_loop(client);
 }
@@ -674,16 +717,23 @@ Result<mtproto::TransportType> ConnectionCreator::get_transport_type(const Proxy
   }
 }
 
-Result<SocketFd> ConnectionCreator::find_connection(const Proxy &proxy, const IPAddress &proxy_ip_address, DcId dc_id,
-                                                    bool allow_media_only, FindConnectionExtra &extra) {
-  extra.debug_str = PSTRING() << "Failed to find valid IP address for " << dc_id;
-  bool prefer_ipv6 = G()->get_option_boolean("prefer_ipv6") || (proxy.use_proxy() && proxy_ip_address.is_ipv6());
+Result<DcOptionsSet::ConnectionInfo> ConnectionCreator::find_dc_option(const Proxy &proxy,
+                                                                      const IPAddress &proxy_ip_address, DcId dc_id,
+                                                                      bool allow_media_only) {
+  bool prefer_ipv6 =
+      G()->get_option_boolean(CachedOption::PreferIpv6) || (proxy.use_proxy() && proxy_ip_address.is_ipv6());
   bool only_http = proxy.use_http_caching_proxy();
 #if TD_DARWIN_WATCH_OS
   only_http = true;
 #endif
-  TRY_RESULT(info, dc_options_set_.find_connection(
-                       dc_id, allow_media_only, proxy.use_proxy() && proxy.use_socks5_proxy(), prefer_ipv6, only_http));
+  return dc_options_set_.find_connection(dc_id, allow_media_only, proxy.use_proxy() && proxy.use_socks5_proxy(),
+                                         prefer_ipv6, only_http);
+}
+
+Result<SocketFd> ConnectionCreator::find_connection(const Proxy &proxy, const IPAddress &proxy_ip_address, DcId dc_id,
+                                                    bool allow_media_only, FindConnectionExtra &extra) {
+  extra.debug_str = PSTRING() << "Failed to find valid IP address for " << dc_id;
+  TRY_RESULT(info, find_dc_option(proxy, proxy_ip_address, dc_id, allow_media_only));
   extra.stat = info.stat;
   TRY_RESULT_ASSIGN(extra.transport_type, get_transport_type(proxy, info));
 
@@ -702,8 +752,8 @@ Result<SocketFd> ConnectionCreator::find_connection(const Proxy &proxy, const IP
   if (proxy.use_proxy()) {
     extra.mtproto_ip_address = info.option->get_ip_address();
     extra.ip_address = proxy_ip_address;
-    extra.debug_str = PSTRING() << (proxy.use_socks5_proxy() ? "Socks5" : (only_http ? "HTTP_ONLY" : "HTTP_TCP")) << ' '
-                                << proxy_ip_address << " --> " << extra.mtproto_ip_address << extra.debug_str;
+    extra.debug_str = PSTRING() << (proxy.use_socks5_proxy() ? "Socks5" : (info.use_http ? "HTTP_ONLY" : "HTTP_TCP"))
+                                << ' ' << proxy_ip_address << " --> " << extra.mtproto_ip_address << extra.debug_str;
   } else {
     extra.ip_address = info.option->get_ip_address();
     extra.debug_str = PSTRING() << info.option->get_ip_address() << extra.debug_str;
@@ -819,13 +869,26 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
   VLOG(connections) << "In client_loop: " << tag("client", format::as_hex(client.hash));
 
-  // Remove expired ready connections
+  auto spare_connection_count = get_spare_connection_count(client);
+
+  // Remove expired ready connections; expired spare connections are pinged to be kept alive
+  vector<unique_ptr<mtproto::RawConnection>> refreshed_connections;
   td::remove_if(client.ready_connections,
                 [&, expires_at = Time::now_cached() - ClientInfo::READY_CONNECTIONS_TIMEOUT](auto &v) {
-                  bool drop = v.second < expires_at;
-                  VLOG_IF(connections, drop) << "Drop expired " << tag("connection", v.first.get());
-                  return drop;
+                  if (v.second >= expires_at) {
+                    return false;
+                  }
+                  if (client.queries.empty() && refreshed_connections.size() < spare_connection_count) {
+                    VLOG(connections) << "Refresh spare " << tag("connection", v.first.get());
+                    refreshed_connections.push_back(std::move(v.first));
+                  } else {
+                    VLOG(connections) << "Drop expired " << tag("connection", v.first.get());
+                  }
+                  return true;
                 });
+  for (auto &raw_connection : refreshed_connections) {
+    client_refresh_connection(client, std::move(raw_connection));
+  }
 
   // Send ready connections into promises
   {
@@ -846,36 +909,51 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
   bool check_mode = client.checking_connections != 0 && !proxy.use_proxy();
   while (true) {
     // Check if we need new connections
-    if (client.queries.empty()) {
+    auto connection_count = client.pending_connections + client.ready_connections.size();
+    if (client.queries.empty() && connection_count >= spare_connection_count) {
       if (!client.ready_connections.empty()) {
         client_set_timeout_at(client, Time::now() + ClientInfo::READY_CONNECTIONS_TIMEOUT);
       }
       return;
     }
     if (check_mode) {
-      if (client.checking_connections >= 3) {
+      if (client.checking_connections >= ClientInfo::MAX_CHECKING_CONNECTIONS) {
         return;
       }
     } else {
-      if (client.pending_connections >= client.queries.size()) {
+      if (connection_count >= client.queries.size() + spare_connection_count) {
         return;
       }
     }
 
     bool act_as_if_online = online_flag_ || is_logging_out_;
+    // while a connection is being checked, race it with connections to other DC options
+    bool is_racing = check_mode && client.checking_connections > 0;
     // Check flood
     auto &flood_control = act_as_if_online ? client.flood_control_online : client.flood_control;
-    auto wakeup_at = max(flood_control.get_wakeup_at(), client.mtproto_error_flood_control.get_wakeup_at());
-    wakeup_at = max(client.sanity_flood_control.get_wakeup_at(), wakeup_at);
-
-    if (!act_as_if_online) {
-      wakeup_at = max(wakeup_at, static_cast<double>(client.backoff.get_wakeup_at()));
+    double wakeup_at;
+    if (is_racing) {
+      wakeup_at = client.last_check_start_time + ClientInfo::RACING_CONNECTION_DELAY;
+    } else {
+      wakeup_at = max(flood_control.get_wakeup_at(), client.mtproto_error_flood_control.get_wakeup_at());
+      if (!act_as_if_online) {
+        wakeup_at = max(wakeup_at, static_cast<double>(client.backoff.get_wakeup_at()));
+      }
     }
+    wakeup_at = max(client.sanity_flood_control.get_wakeup_at(), wakeup_at);
     if (wakeup_at > Time::now()) {
       return client_set_timeout_at(client, wakeup_at);
     }
+    if (is_racing) {
+      // the next DC option must be chosen without creating a connection
+      auto r_info = find_dc_option(proxy, proxy_ip_address_, client.dc_id, client.allow_media_only);
+      if (r_info.is_error() || r_info.ok().stat->state() == DcOptionsSet::Stat::State::Checking) {
+        VLOG(connections) << "There is no DC option to race with";
+        return;
+      }
+    }
     client.sanity_flood_control.add_event(Time::now());
-    if (!act_as_if_online) {
+    if (!act_as_if_online && !is_racing) {
       client.backoff.add_event(static_cast<int32>(Time::now()));
     }
 
@@ -912,14 +990,16 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
         extra.stat->on_check();
       }
       client.checking_connections++;
+      client.last_check_start_time = Time::now();
     }
 
     auto promise = PromiseCreator::lambda(
         [actor_id = actor_id(this), check_mode, transport_type = extra.transport_type, hash = client.hash,
-         debug_str = extra.debug_str,
-         network_generation = network_generation_](Result<ConnectionData> r_connection_data) mutable {
+         debug_str = extra.debug_str, network_generation = network_generation_,
+         option_stat = extra.stat](Result<ConnectionData> r_connection_data) mutable {
           send_closure(actor_id, &ConnectionCreator::client_create_raw_connection, std::move(r_connection_data),
-                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation);
+                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation,
+                       option_stat);
         });
 
     auto stats_callback =
@@ -937,7 +1017,8 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
 void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                                      mtproto::TransportType transport_type, uint32 hash,
-                                                     string debug_str, uint32 network_generation) {
+                                                     string debug_str, uint32 network_generation,
+                                                     DcOptionsSet::Stat *option_stat) {
   unique_ptr<mtproto::AuthData> auth_data;
   uint64 auth_data_generation{0};
   uint64 session_id{0};
@@ -953,10 +1034,14 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
     }
   }
   auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash, check_mode, auth_data_generation, session_id,
-                                         debug_str](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+                                         debug_str,
+                                         option_stat](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
     if (result.is_ok()) {
       VLOG(connections) << "Ready connection (" << (check_mode ? "" : "un") << "checked) " << result.ok().get() << ' '
                         << tag("rtt", format::as_time(result.ok()->extra().rtt)) << ' ' << debug_str;
+      if (check_mode && option_stat != nullptr) {
+        send_lambda(actor_id, [option_stat, rtt = result.ok()->extra().rtt] { option_stat->on_rtt(rtt); });
+      }
     } else {
       VLOG(connections) << "Failed connection (" << (check_mode ? "" : "un") << "checked) " << result.error() << ' '
                         << debug_str;
@@ -988,6 +1073,34 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
   }
 }
 
+void ConnectionCreator::client_refresh_connection(ClientInfo &client,
+                                                  unique_ptr<mtproto::RawConnection> raw_connection) {
+  client.pending_connections++;
+  auto debug_str = raw_connection->extra().debug_str;
+  auto promise = PromiseCreator::lambda(
+      [actor_id = actor_id(this), hash = client.hash](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+        send_closure(actor_id, &ConnectionCreator::client_add_connection, hash, std::move(result), false, 0, 0);
+      });
+  auto token = next_token();
+  children_[token] = {true, create_ping_actor(debug_str, std::move(raw_connection), nullptr, std::move(promise),
+                                              create_reference(token))};
+}
+
+size_t ConnectionCreator::get_spare_connection_count(const ClientInfo &client) {
+  if (client.last_query_time < Time::now_cached() - ClientInfo::SPARE_CONNECTIONS_TIMEOUT) {
+    // the client isn't used anymore
+    return 0;
+  }
+  return static_cast<size_t>(clamp(G()->get_option_integer("spare_connection_count"), static_cast<int64>(0),
+                                   static_cast<int64>(MAX_SPARE_CONNECTION_COUNT)));
+}
+
+void ConnectionCreator::on_spare_connection_count_changed() {
+  for (auto &client : clients_) {
+    client_loop(client.second);
+  }
+}
+
 void ConnectionCreator::client_set_timeout_at(ClientInfo &client, double wakeup_at) {
   if (!client.slot.has_event()) {
     client.slot.set_event(self_closure(this, &ConnectionCreator::client_wakeup, client.hash));
@@ -1275,7 +1388,7 @@ void ConnectionCreator::loop() {
       if (resolve_proxy_query_token_ == 0) {
         resolve_proxy_query_token_ = next_token();
         const Proxy &proxy = proxies_[active_proxy_id_];
-        bool prefer_ipv6 = G()->get_option_boolean("prefer_ipv6");
+        bool prefer_ipv6 = G()->get_option_boolean(CachedOption::PreferIpv6);
         VLOG(connections) << "Resolve IP address " << resolve_proxy_query_token_ << " of " << proxy.server();
         send_closure(
             get_dns_resolver(), &GetHostByNameActor::run, proxy.server().str(), proxy.port(), prefer_ipv6,
@@ -18,6 +18,7 @@
 #include "td/mtproto/RawConnection.h"
 #include "td/mtproto/TransportType.h"
 
+#include "td/net/GetHostByNameActor.h"
 #include "td/net/NetStats.h"
 
 #include "td/actor/actor.h"
@@ -46,8 +47,6 @@ namespace detail {
 class StatsCallback;
 }  // namespace detail
 
-class GetHostByNameActor;
-
 extern int VERBOSITY_NAME(connections);
 
 class ConnectionCreator final : public NetQueryCallback {
@@ -79,6 +78,12 @@ class ConnectionCreator final : public NetQueryCallback {
   void get_proxy_link(int32 proxy_id, Promise<string> promise);
   void ping_proxy(int32 proxy_id, Promise<double> promise);
 
+  void on_spare_connection_count_changed();
+
+  void save_dns_cache(string database_key, string data);
+
+  static constexpr int32 MAX_SPARE_CONNECTION_COUNT = 4;
+
   struct ConnectionData {
     IPAddress ip_address;
     BufferedFd<SocketFd> buffered_socket_fd;
@@ -157,6 +162,11 @@ class ConnectionCreator final : public NetQueryCallback {
     std::vector<Promise<unique_ptr<mtproto::RawConnection>>> queries;
 
     static constexpr double READY_CONNECTIONS_TIMEOUT = 10;
+    static constexpr size_t MAX_CHECKING_CONNECTIONS = 3;
+    static constexpr double RACING_CONNECTION_DELAY = 0.25;
+    static constexpr double SPARE_CONNECTIONS_TIMEOUT = 15 * 60;
+    double last_query_time{0};
+    double last_check_start_time{0};
 
     bool inited{false};
     uint32 hash{0};
@@ -222,11 +232,14 @@ class ConnectionCreator final : public NetQueryCallback {
   void client_loop(ClientInfo &client);
   void client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                     mtproto::TransportType transport_type, uint32 hash, string debug_str,
-                                    uint32 network_generation);
+                                    uint32 network_generation, DcOptionsSet::Stat *option_stat);
   void client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag,
                              uint64 auth_data_generation, uint64 session_id);
+  void client_refresh_connection(ClientInfo &client, unique_ptr<mtproto::RawConnection> raw_connection);
   void client_set_timeout_at(ClientInfo &client, double wakeup_at);
 
+  static size_t get_spare_connection_count(const ClientInfo &client);
+
   void on_proxy_resolved(Result<IPAddress> ip_address, bool dummy);
 
   struct FindConnectionExtra {
@@ -241,11 +254,18 @@ class ConnectionCreator final : public NetQueryCallback {
   static Result<mtproto::TransportType> get_transport_type(const Proxy &proxy,
                                                            const DcOptionsSet::ConnectionInfo &info);
 
+  Result<DcOptionsSet::ConnectionInfo> find_dc_option(const Proxy &proxy, const IPAddress &proxy_ip_address,
+                                                      DcId dc_id, bool allow_media_only);
+
   Result<SocketFd> find_connection(const Proxy &proxy, const IPAddress &proxy_ip_address, DcId dc_id,
                                    bool allow_media_only, FindConnectionExtra &extra);
 
+  static constexpr int32 DNS_CACHE_STALE_TIME = 86400;
+
   ActorId<GetHostByNameActor> get_dns_resolver();
 
+  std::shared_ptr<GetHostByNameActor::Storage> create_dns_cache_storage(string database_key);
+
   void ping_proxy_resolved(int32 proxy_id, IPAddress ip_address, Promise<double> promise);
 
   void ping_proxy_buffered_socket_fd(IPAddress ip_address, BufferedFd<SocketFd> buffered_socket_fd,
@@ -160,6 +160,10 @@ Result<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_connection(DcId dc_id, b
       return a_state < b_state;
     }
     if (a_state == Stat::State::Ok) {
+      if (a.rtt > 0 && b.rtt > 0 && a.rtt != b.rtt) {
+        // prefer the fastest of checked options
+        return a.rtt < b.rtt;
+      }
       if (a_option.order == b_option.order) {
         return a_option.use_http < b_option.use_http;
       }
@@ -12,9 +12,11 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/as.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
+#include "td/utils/TraceSpans.h"
 
 #include <algorithm>
 
@@ -51,11 +53,13 @@ NetQuery::NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFl
   td::unique(chain_ids_);
 
   auto &data = get_data_unsafe();
-  data.my_id_ = G()->get_option_integer("my_id");
-  data.start_timestamp_ = data.state_timestamp_ = Time::now();
+  data.my_id_ = G()->get_option_integer(CachedOption::MyId);
+  data.start_timestamp_ = data.state_timestamp_ = created_at_ = Time::now();
+  trace_id_ = TraceSpans::get_current_trace_id();
   LOG(INFO) << *this;
   if (stats) {
     nq_counter_ = stats->register_query(this);
+    stats_ = stats;
   }
 }
 
@@ -63,12 +67,35 @@ void NetQuery::clear() {
   if (!is_ready()) {
     auto guard = lock();
     LOG(ERROR) << "Destroy not ready query " << *this << " " << tag("state", get_data_unsafe().state_);
+  } else if (state_ != State::Empty) {
+    on_finished();
   }
   // TODO: CHECK if net_query is lost here
   cancel_slot_.close();
   *this = NetQuery();
 }
 
+void NetQuery::compress_query() {
+  if (gzip_flag_ != GzipFlag::Pending) {
+    return;
+  }
+  gzip_flag_ = GzipFlag::Off;
+  if (query_.size() >= 16384) {
+    // test compression ratio for the middle part
+    // if it is less than 0.9, then try to compress the whole request
+    size_t TESTED_SIZE = 1024;
+    auto tested_part = query_.as_slice().substr((query_.size() - TESTED_SIZE) / 2, TESTED_SIZE);
+    if (gzencode(tested_part, 0.9).empty()) {
+      return;
+    }
+  }
+  BufferSlice compressed = gzencode(query_.as_slice(), 0.9);
+  if (!compressed.empty()) {
+    query_ = std::move(compressed);
+    gzip_flag_ = GzipFlag::On;
+  }
+}
+
 void NetQuery::resend(DcId new_dc_id) {
   VLOG(net_query) << "Resend " << *this;
   {
@@ -96,6 +123,35 @@ void NetQuery::set_ok(BufferSlice slice) {
   CHECK(state_ == State::Query);
   answer_ = std::move(slice);
   state_ = State::OK;
+  on_answer_received();
+}
+
+void NetQuery::on_answer_received() {
+  answered_at_ = Time::now();
+  if (sent_at_ != 0.0) {
+    TraceSpans::add_span(trace_id_, "server", sent_at_, answered_at_);
+    server_time_ += answered_at_ - sent_at_;
+    sent_at_ = 0.0;
+  }
+}
+
+void NetQuery::on_finished() {
+  if (trace_id_ != 0 && created_at_ != 0.0) {
+    TraceSpans::add_span(trace_id_, PSLICE() << "NetQuery " << format::as_hex(tl_constructor_), created_at_,
+                         Time::now());
+  }
+  if (stats_ == nullptr || created_at_ == 0.0) {
+    return;
+  }
+  auto now = Time::now();
+  NetQueryStats::QueryLatency latency;
+  latency.total_time = now - created_at_;
+  latency.delivery_time = answered_at_ == 0.0 ? 0.0 : now - answered_at_;
+  latency.server_time = server_time_;
+  latency.flood_wait_time = flood_wait_time_;
+  latency.queue_time =
+      max(latency.total_time - latency.delivery_time - latency.server_time - latency.flood_wait_time, 0.0);
+  stats_->on_query_finished(tl_constructor_, dc_id_.get_value(), latency);
 }
 
 void NetQuery::on_net_write(size_t size) {
@@ -145,6 +201,7 @@ void NetQuery::set_error_impl(Status status, string source) {
   status_ = std::move(status);
   state_ = State::Error;
   source_ = std::move(source);
+  on_answer_received();
 }
 
 StringBuilder &operator<<(StringBuilder &stream, const NetQuery &net_query) {
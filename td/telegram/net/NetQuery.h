@@ -53,7 +53,11 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
 
   enum class Type : int8 { Common, Upload, Download, DownloadSmall };
   enum class AuthFlag : int8 { Off, On };
-  enum class GzipFlag : int8 { Off, On };
+  // queries with GzipFlag::Pending are compressed by the Session just before sending, and then have GzipFlag::On
+  enum class GzipFlag : int8 { Off, On, Pending };
+  // queries of the same priority are sent using weighted fair queuing between the priority classes
+  enum class PriorityClass : int8 { Bulk, Normal, Interactive };
+  static constexpr size_t PRIORITY_CLASS_COUNT = 3;
   enum Error : int32 { Resend = 202, Canceled = 203, ResendInvokeAfter = 204 };
 
   uint64 id() const {
@@ -90,6 +94,9 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
     return query_;
   }
 
+  // compresses the query if its compression is pending and it can be compressed well enough
+  void compress_query();
+
   const BufferSlice &ok() const {
     CHECK(state_ == State::OK);
     return answer_;
@@ -227,6 +234,13 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
     priority_ = priority;
   }
 
+  PriorityClass priority_class() const {
+    return priority_class_;
+  }
+  void set_priority_class(PriorityClass priority_class) {
+    priority_class_ = priority_class;
+  }
+
   Span<uint64> get_chain_ids() const {
     return chain_ids_;
   }
@@ -238,6 +252,10 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
     return in_sequence_dispacher_;
   }
 
+  bool is_deadline_expired(double now) const {
+    return deadline_ > 0.0 && now > deadline_;
+  }
+
  private:
   State state_ = State::Empty;
   Type type_ = Type::Common;
@@ -258,6 +276,7 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   bool in_sequence_dispacher_ = false;
   bool may_be_lost_ = false;
   int8 priority_{0};
+  PriorityClass priority_class_ = PriorityClass::Normal;
 
   template <class T>
   struct movable_atomic final : public std::atomic<T> {
@@ -282,8 +301,14 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   movable_atomic<int32> cancellation_token_{-1};  // == 0 if query is canceled
   ActorShared<NetQueryCallback> callback_;
 
+  NetQueryStats *stats_ = nullptr;
+
   void set_error_impl(Status status, string source = string());
 
+  void on_answer_received();
+
+  void on_finished();
+
   static int32 tl_magic(const BufferSlice &buffer_slice);
 
  public:
@@ -297,6 +322,18 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   Slot cancel_slot_;                // for Session and to be set by caller
   Promise<> quick_ack_promise_;     // for Session and to be set by caller
   bool need_resend_on_503_ = true;  // for NetQueryDispatcher and to be set by caller
+  double deadline_ = 0.0;           // for NetQueryDelayer/SequenceDispatcher and to be set by caller
+  double paced_send_time_ = 0.0;    // for NetQueryDispatcher
+
+  // timestamps in the Time::now() scale and durations for latency statistics
+  double created_at_ = 0.0;
+  double sent_at_ = 0.0;          // for Session
+  double answered_at_ = 0.0;      // time when the last answer or error was received
+  double server_time_ = 0.0;      // total time between sending of the query and receiving of an answer
+  double delayed_at_ = 0.0;       // for NetQueryDelayer
+  double flood_wait_time_ = 0.0;  // for NetQueryDelayer
+
+  uint64 trace_id_ = 0;  // trace of the request, which created the query
 
   NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFlag auth_flag, GzipFlag gzip_flag,
            int32 tl_constructor, int32 total_timeout_limit, NetQueryStats *stats, vector<ChainId> chain_ids);
@@ -14,11 +14,9 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/buffer.h"
-#include "td/utils/format.h"
-#include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
 #include "td/utils/Slice.h"
-#include "td/utils/Storer.h"
+#include "td/utils/tl_storers.h"
 
 namespace td {
 
@@ -43,32 +41,25 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
                                     const telegram_api::Function &function, vector<ChainId> &&chain_ids, DcId dc_id,
                                     NetQuery::Type type, NetQuery::AuthFlag auth_flag) {
   LOG(INFO) << "Create query " << to_string(function);
-  string prefix_str;
+  TlStorerBuffer storer;
   if (prefix != nullptr) {
-    auto storer = DefaultStorer<telegram_api::Function>(*prefix);
-    prefix_str.resize(storer.size());
-    auto real_size = storer.store(MutableSlice(prefix_str).ubegin());
-    CHECK(real_size == prefix_str.size());
-  }
-
-  auto storer = DefaultStorer<telegram_api::Function>(function);
-  BufferSlice slice(prefix_str.size() + storer.size());
-  auto real_size = storer.store(slice.as_mutable_slice().ubegin() + prefix_str.size());
-  LOG_CHECK(prefix_str.size() + real_size == slice.size())
-      << prefix_str.size() << ' ' << real_size << ' ' << slice.size() << ' '
-      << format::as_hex_dump<4>(slice.as_slice());
-  if (prefix != nullptr) {
-    slice.as_mutable_slice().copy_from(prefix_str);
+    prefix->store(storer);
   }
+  function.store(storer);
+  auto slice = storer.move_as_buffer_slice();
 
   size_t min_gzipped_size = 128;
   int32 tl_constructor = function.get_id();
   int32 total_timeout_limit = 60;
+  double deadline = 0.0;
+  auto priority_class = NetQuery::PriorityClass::Normal;
 
   if (Scheduler::instance() != nullptr && current_scheduler_id_ == Scheduler::instance()->sched_id() &&
       !G()->close_flag()) {
     auto td = G()->td();
     if (!td.empty()) {
+      deadline = td.get_actor_unsafe()->get_current_request_deadline();
+      priority_class = td.get_actor_unsafe()->get_current_request_priority_class();
       auto auth_manager = td.get_actor_unsafe()->auth_manager_.get();
       if (auth_manager != nullptr && auth_manager->is_bot()) {
         total_timeout_limit = 8;
@@ -82,28 +73,14 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
     }
   }
 
-  auto gzip_flag = slice.size() < min_gzipped_size ? NetQuery::GzipFlag::Off : NetQuery::GzipFlag::On;
-  if (slice.size() >= 16384) {
-    // test compression ratio for the middle part
-    // if it is less than 0.9, then try to compress the whole request
-    size_t TESTED_SIZE = 1024;
-    BufferSlice compressed_part = gzencode(slice.as_slice().substr((slice.size() - TESTED_SIZE) / 2, TESTED_SIZE), 0.9);
-    if (compressed_part.empty()) {
-      gzip_flag = NetQuery::GzipFlag::Off;
-    }
-  }
-  if (gzip_flag == NetQuery::GzipFlag::On) {
-    BufferSlice compressed = gzencode(slice.as_slice(), 0.9);
-    if (compressed.empty()) {
-      gzip_flag = NetQuery::GzipFlag::Off;
-    } else {
-      slice = std::move(compressed);
-    }
-  }
+  // the query is compressed later by the Session to not block the current actor
+  auto gzip_flag = slice.size() < min_gzipped_size ? NetQuery::GzipFlag::Off : NetQuery::GzipFlag::Pending;
 
   auto query = object_pool_.create(id, std::move(slice), dc_id, type, auth_flag, gzip_flag, tl_constructor,
                                    total_timeout_limit, net_query_stats_.get(), std::move(chain_ids));
   query->set_cancellation_token(query.generation());
+  query->deadline_ = deadline;
+  query->set_priority_class(priority_class);
   return query;
 }
 
@@ -31,6 +31,10 @@ class NetQueryCreator {
     object_pool_.set_check_empty(false);
   }
 
+  NetQueryStats *get_net_query_stats() const {
+    return net_query_stats_.get();
+  }
+
   NetQueryPtr create(const telegram_api::Function &function, vector<ChainId> chain_ids = {}, DcId dc_id = DcId::main(),
                      NetQuery::Type type = NetQuery::Type::Common);
 
@@ -16,6 +16,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
@@ -85,6 +86,17 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
     return;
   }
 
+  if (query->is_deadline_expired(Time::now() + timeout)) {
+    // the query can't be resent before its deadline
+    LOG(INFO) << "Failed: " << query << " " << tag("timeout", timeout) << " because of " << error << " from "
+              << query->source_ << " after request deadline";
+    G()->on_network_query_shed();
+    query->set_error(Global::request_timeout_expired_error());
+    query->debug("DcManager: send to DcManager");
+    G()->net_query_dispatcher().dispatch(std::move(query));
+    return;
+  }
+
   if (query->total_timeout_ > query->total_timeout_limit_) {
     // TODO: support timeouts in DcAuth and GetConfig
     LOG(WARNING) << "Failed: " << query << " " << tag("timeout", timeout) << tag("total_timeout", query->total_timeout_)
@@ -99,6 +111,7 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
   LOG(WARNING) << "Delay: " << query << " " << tag("timeout", timeout) << tag("total_timeout", query->total_timeout_)
                << " because of " << error << " from " << query->source_;
   query->debug(PSTRING() << "delay for " << format::as_time(timeout));
+  query->delayed_at_ = Time::now();
   auto id = container_.create(QuerySlot());
   auto *query_slot = container_.get(id);
   query_slot->query_ = std::move(query);
@@ -106,6 +119,25 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
   query_slot->timeout_.set_timeout_in(timeout);
 }
 
+void NetQueryDelayer::pace(NetQueryPtr query, double send_time) {
+  if (query->is_deadline_expired(send_time)) {
+    LOG(INFO) << "Failed: " << query << " paced until " << send_time << " after request deadline";
+    G()->on_network_query_shed();
+    query->set_error(Global::request_timeout_expired_error());
+    query->debug("DcManager: send to DcManager");
+    G()->net_query_dispatcher().dispatch(std::move(query));
+    return;
+  }
+
+  query->debug(PSTRING() << "pace for " << format::as_time(send_time - Time::now()));
+  query->delayed_at_ = Time::now();
+  auto id = container_.create(QuerySlot());
+  auto *query_slot = container_.get(id);
+  query_slot->query_ = std::move(query);
+  query_slot->timeout_.set_event(EventCreator::yield(actor_shared(this, id)));
+  query_slot->timeout_.set_timeout_at(send_time);
+}
+
 void NetQueryDelayer::wakeup() {
   auto link_token = get_link_token();
   if (link_token) {
@@ -120,6 +152,7 @@ void NetQueryDelayer::on_slot_event(uint64 id) {
     return;
   }
   auto query = std::move(slot->query_);
+  query->flood_wait_time_ += Time::now() - query->delayed_at_;
   if (!query->invoke_after().empty()) {
     // Fail query after timeout expired if it is a part of an invokeAfter chain.
     // It is not necessary but helps to avoid server problems, when previous query was lost.
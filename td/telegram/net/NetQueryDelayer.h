@@ -21,6 +21,9 @@ class NetQueryDelayer final : public Actor {
   }
   void delay(NetQueryPtr query);
 
+  // resends the query at the given time without counting it as a delay
+  void pace(NetQueryPtr query, double send_time);
+
  private:
   struct QuerySlot {
     NetQueryPtr query_;
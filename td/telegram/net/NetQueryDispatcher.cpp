@@ -28,9 +28,17 @@
 #include "td/utils/port/sleep.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
+#include "td/utils/TraceSpans.h"
 
 namespace td {
 
+static const double INITIAL_FLOOD_CONTROL_SEND_INTERVAL = 1.0;
+static const double MIN_FLOOD_CONTROL_SEND_INTERVAL = 0.05;
+static const double MAX_FLOOD_CONTROL_SEND_INTERVAL = 30.0;
+static const double FLOOD_CONTROL_RECOVERY_TIME = 60.0;
+static const int32 FLOOD_CONTROL_BURST_SIZE = 3;
+
 void NetQueryDispatcher::complete_net_query(NetQueryPtr net_query) {
   auto callback = net_query->move_callback();
   if (callback.empty()) {
@@ -52,6 +60,7 @@ bool NetQueryDispatcher::check_stop_flag(NetQueryPtr &net_query) const {
 }
 
 void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
+  TraceSpan trace_span(net_query->trace_id_, "NetQueryDispatcher::dispatch");
   if (check_stop_flag(net_query)) {
     return;
   }
@@ -91,6 +100,10 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
       if (check_stop_flag(net_query)) {
         return;
       }
+      if (code == 420) {
+        on_flood_wait(net_query);
+      }
+      net_query->paced_send_time_ = 0.0;
       return send_closure_later(delayer_, &NetQueryDelayer::delay, std::move(net_query));
     }
   }
@@ -123,6 +136,17 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
   if (check_stop_flag(net_query)) {
     return;
   }
+  if (net_query->paced_send_time_ != 0.0) {
+    // the query has already reserved its sending time
+    net_query->paced_send_time_ = 0.0;
+  } else if (!flood_controls_.empty()) {
+    auto send_time = get_query_send_time(net_query, dest_dc_id);
+    if (send_time != 0.0) {
+      net_query->paced_send_time_ = send_time;
+      net_query->debug("sent to NetQueryDelayer for pacing");
+      return send_closure_later(delayer_, &NetQueryDelayer::pace, std::move(net_query), send_time);
+    }
+  }
   switch (net_query->type()) {
     case NetQuery::Type::Common:
       net_query->debug(PSTRING() << "sent to main session multi proxy " << dest_dc_id);
@@ -185,27 +209,28 @@ Status NetQueryDispatcher::wait_dc_init(DcId dc_id, bool force) {
     }
     auto auth_data = AuthDataShared::create(dc_id, std::move(public_rsa_key), td_guard_);
     int32 session_count = get_session_count();
+    int32 max_session_count = get_max_session_count();
     bool use_pfs = get_use_pfs();
 
     int32 slow_net_scheduler_id = G()->get_slow_net_scheduler_id();
 
     auto raw_dc_id = dc_id.get_raw_id();
-    bool is_premium = G()->get_option_boolean("is_premium");
+    bool is_premium = G()->get_option_boolean(CachedOption::IsPremium);
     int32 upload_session_count = (raw_dc_id != 2 && raw_dc_id != 4) || is_premium ? 8 : 4;
     int32 download_session_count = is_premium ? 8 : 2;
     int32 download_small_session_count = is_premium ? 8 : 2;
     dc.main_session_ = create_actor_on_scheduler<SessionMultiProxy>(
         PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":main", get_main_session_scheduler_id(), session_count,
-        auth_data, true, raw_dc_id == main_dc_id_, use_pfs, false, false, is_cdn);
+        max_session_count, auth_data, true, raw_dc_id == main_dc_id_, use_pfs, false, false, is_cdn);
     dc.upload_session_ = create_actor_on_scheduler<SessionMultiProxy>(
         PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":upload", slow_net_scheduler_id, upload_session_count,
-        auth_data, false, false, use_pfs, false, true, is_cdn);
+        max_session_count, auth_data, false, false, use_pfs, false, true, is_cdn);
     dc.download_session_ = create_actor_on_scheduler<SessionMultiProxy>(
         PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":download", slow_net_scheduler_id, download_session_count,
-        auth_data, false, false, use_pfs, true, true, is_cdn);
+        max_session_count, auth_data, false, false, use_pfs, true, true, is_cdn);
     dc.download_small_session_ = create_actor_on_scheduler<SessionMultiProxy>(
         PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":download_small", slow_net_scheduler_id,
-        download_small_session_count, auth_data, false, false, use_pfs, true, true, is_cdn);
+        download_small_session_count, max_session_count, auth_data, false, false, use_pfs, true, true, is_cdn);
     dc.is_inited_ = true;
     if (dc_id.is_internal()) {
       send_closure_later(dc_auth_manager_, &DcAuthManager::add_dc, std::move(auth_data));
@@ -247,6 +272,7 @@ void NetQueryDispatcher::stop() {
 void NetQueryDispatcher::update_session_count() {
   std::lock_guard<std::mutex> guard(mutex_);
   int32 session_count = get_session_count();
+  int32 max_session_count = get_max_session_count();
   bool use_pfs = get_use_pfs();
   for (int32 i = 1; i < DcId::MAX_RAW_DC_ID; i++) {
     if (is_dc_inited(i)) {
@@ -255,6 +281,12 @@ void NetQueryDispatcher::update_session_count() {
       send_closure_later(dcs_[i - 1].upload_session_, &SessionMultiProxy::update_use_pfs, use_pfs);
       send_closure_later(dcs_[i - 1].download_session_, &SessionMultiProxy::update_use_pfs, use_pfs);
       send_closure_later(dcs_[i - 1].download_small_session_, &SessionMultiProxy::update_use_pfs, use_pfs);
+      send_closure_later(dcs_[i - 1].main_session_, &SessionMultiProxy::update_max_session_count, max_session_count);
+      send_closure_later(dcs_[i - 1].upload_session_, &SessionMultiProxy::update_max_session_count, max_session_count);
+      send_closure_later(dcs_[i - 1].download_session_, &SessionMultiProxy::update_max_session_count,
+                         max_session_count);
+      send_closure_later(dcs_[i - 1].download_small_session_, &SessionMultiProxy::update_max_session_count,
+                         max_session_count);
     }
   }
 }
@@ -302,18 +334,35 @@ void NetQueryDispatcher::update_mtproto_header() {
   }
 }
 
+void NetQueryDispatcher::update_sequence_dispatcher_window_size() {
+  if (sequence_dispatcher_.empty()) {
+    return;
+  }
+  send_closure_later(sequence_dispatcher_, &MultiSequenceDispatcher::set_max_active_queries,
+                     get_sequence_dispatcher_window_size());
+}
+
 bool NetQueryDispatcher::is_dc_inited(int32 raw_dc_id) {
   return dcs_[raw_dc_id - 1].is_valid_.load(std::memory_order_relaxed);
 }
 
 int32 NetQueryDispatcher::get_session_count() {
-  return max(narrow_cast<int32>(G()->get_option_integer("session_count")), 1);
+  return max(narrow_cast<int32>(G()->get_option_integer(CachedOption::SessionCount)), 1);
+}
+
+int32 NetQueryDispatcher::get_max_session_count() {
+  return narrow_cast<int32>(G()->get_option_integer("session_count_max"));
 }
 
 bool NetQueryDispatcher::get_use_pfs() {
   return G()->get_option_boolean("use_pfs") || get_session_count() > 1;
 }
 
+int32 NetQueryDispatcher::get_sequence_dispatcher_window_size() {
+  return narrow_cast<int32>(G()->get_option_integer("sequence_dispatcher_window_size",
+                                                    MultiSequenceDispatcher::DEFAULT_MAX_ACTIVE_QUERIES));
+}
+
 int32 NetQueryDispatcher::get_main_session_scheduler_id() {
   return G()->use_sqlite_pmc() ? -1 : G()->get_database_scheduler_id();
 }
@@ -327,7 +376,8 @@ NetQueryDispatcher::NetQueryDispatcher(const std::function<ActorShared<>()> &cre
   dc_auth_manager_ =
       create_actor_on_scheduler<DcAuthManager>("DcAuthManager", get_main_session_scheduler_id(), create_reference());
   public_rsa_key_watchdog_ = create_actor<PublicRsaKeyWatchdog>("PublicRsaKeyWatchdog", create_reference());
-  sequence_dispatcher_ = MultiSequenceDispatcher::create("MultiSequenceDispatcher");
+  sequence_dispatcher_ =
+      MultiSequenceDispatcher::create("MultiSequenceDispatcher", get_sequence_dispatcher_window_size());
 
   td_guard_ = create_shared_lambda_guard([actor = create_reference()] {});
 }
@@ -388,4 +438,78 @@ void NetQueryDispatcher::check_authorization_is_ok() {
   send_closure(dc_auth_manager_, &DcAuthManager::check_authorization_is_ok);
 }
 
+void NetQueryDispatcher::on_flood_wait(const NetQueryPtr &net_query) {
+  auto dest_dc_id = net_query->dc_id();
+  if (dest_dc_id.is_main()) {
+    dest_dc_id = DcId::internal(main_dc_id_.load(std::memory_order_relaxed));
+  }
+
+  auto error_message = net_query->error().message();
+  if (begins_with(error_message, "FLOOD_WAIT_") && dest_dc_id.is_exact() && net_query->invoke_after().empty()) {
+    auto flood_wait = clamp(to_integer<int32>(error_message.substr(11)), 1, 14 * 24 * 60 * 60);
+    auto key = (static_cast<uint64>(static_cast<uint32>(net_query->tl_constructor())) << 32) |
+               static_cast<uint64>(dest_dc_id.get_raw_id());
+    auto &flood_control = flood_controls_[key];
+    auto now = Time::now();
+    // multiplicative decrease of the allowed rate on each flood wait
+    flood_control.send_interval_ = clamp(flood_control.send_interval_ * 2, INITIAL_FLOOD_CONTROL_SEND_INTERVAL,
+                                         MAX_FLOOD_CONTROL_SEND_INTERVAL);
+    flood_control.blocked_until_ = td::max(flood_control.blocked_until_, now + flood_wait);
+    flood_control.next_send_time_ = td::max(flood_control.next_send_time_, flood_control.blocked_until_);
+    flood_control.last_flood_wait_time_ = now;
+    LOG(INFO) << "Pace " << net_query << " to " << dest_dc_id << " with interval " << flood_control.send_interval_
+              << " after " << error_message;
+  }
+
+  if (!dest_dc_id.is_exact() || !is_dc_inited(dest_dc_id.get_raw_id())) {
+    return;
+  }
+  auto &dc = dcs_[dest_dc_id.get_raw_id() - 1];
+  switch (net_query->type()) {
+    case NetQuery::Type::Common:
+      return send_closure_later(dc.main_session_, &SessionMultiProxy::on_flood_wait);
+    case NetQuery::Type::Upload:
+      return send_closure_later(dc.upload_session_, &SessionMultiProxy::on_flood_wait);
+    case NetQuery::Type::Download:
+      return send_closure_later(dc.download_session_, &SessionMultiProxy::on_flood_wait);
+    case NetQuery::Type::DownloadSmall:
+      return send_closure_later(dc.download_small_session_, &SessionMultiProxy::on_flood_wait);
+    default:
+      UNREACHABLE();
+  }
+}
+
+double NetQueryDispatcher::get_query_send_time(const NetQueryPtr &net_query, DcId dc_id) {
+  if (!net_query->invoke_after().empty() || !dc_id.is_exact()) {
+    // queries in invokeAfter chains must not be reordered
+    return 0.0;
+  }
+  auto key = (static_cast<uint64>(static_cast<uint32>(net_query->tl_constructor())) << 32) |
+             static_cast<uint64>(dc_id.get_raw_id());
+  auto it = flood_controls_.find(key);
+  if (it == flood_controls_.end()) {
+    return 0.0;
+  }
+  auto &flood_control = it->second;
+  auto now = Time::now();
+  if (now > flood_control.last_flood_wait_time_ + FLOOD_CONTROL_RECOVERY_TIME) {
+    // additive increase of the allowed rate after some time without flood waits
+    flood_control.send_interval_ = td::max(flood_control.send_interval_ - MIN_FLOOD_CONTROL_SEND_INTERVAL, 0.0);
+    if (flood_control.send_interval_ < MIN_FLOOD_CONTROL_SEND_INTERVAL && flood_control.next_send_time_ <= now) {
+      flood_controls_.erase(it);
+      return 0.0;
+    }
+  }
+
+  // generic cell rate algorithm, allowing bursts of up to FLOOD_CONTROL_BURST_SIZE queries
+  auto next_send_time = td::max(flood_control.next_send_time_, now);
+  auto send_time = td::max(next_send_time - (FLOOD_CONTROL_BURST_SIZE - 1) * flood_control.send_interval_,
+                           flood_control.blocked_until_);
+  flood_control.next_send_time_ = next_send_time + flood_control.send_interval_;
+  if (send_time <= now) {
+    return 0.0;
+  }
+  return send_time;
+}
+
 }  // namespace td
@@ -12,6 +12,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Promise.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Status.h"
@@ -48,6 +49,7 @@ class NetQueryDispatcher {
   void destroy_auth_keys(Promise<> promise);
   void update_use_pfs();
   void update_mtproto_header();
+  void update_sequence_dispatcher_window_size();
 
   DcId get_main_dc_id() const {
     return DcId::internal(main_dc_id_.load(std::memory_order_relaxed));
@@ -82,17 +84,32 @@ class NetQueryDispatcher {
   std::mutex mutex_;
   std::shared_ptr<Guard> td_guard_;
 
+  // token bucket for queries of a method to a DC, learned from FLOOD_WAIT_X errors
+  struct FloodControl {
+    double send_interval_ = 0.0;
+    double next_send_time_ = 0.0;  // theoretical sending time of the next query
+    double blocked_until_ = 0.0;
+    double last_flood_wait_time_ = 0.0;
+  };
+  FlatHashMap<uint64, FloodControl> flood_controls_;  // (tl_constructor << 32) | raw_dc_id; guarded by mutex_
+
   Status wait_dc_init(DcId dc_id, bool force);
   bool is_dc_inited(int32 raw_dc_id);
 
   static int32 get_main_session_scheduler_id();
   static int32 get_session_count();
+  static int32 get_max_session_count();
+  static int32 get_sequence_dispatcher_window_size();
   static bool get_use_pfs();
 
   static void complete_net_query(NetQueryPtr net_query);
   bool check_stop_flag(NetQueryPtr &net_query) const;
 
   void try_fix_migrate(NetQueryPtr &net_query);
+
+  void on_flood_wait(const NetQueryPtr &net_query);
+
+  double get_query_send_time(const NetQueryPtr &net_query, DcId dc_id);
 };
 
 }  // namespace td
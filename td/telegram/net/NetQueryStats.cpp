@@ -12,18 +12,151 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Time.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace td {
 
 uint64 NetQueryStats::get_count() const {
   return count_.load(std::memory_order_relaxed);
 }
 
+void NetQueryStats::on_queries_sent(size_t query_count, size_t query_size, double fill_ratio) {
+  sent_packet_count_.fetch_add(1, std::memory_order_relaxed);
+  sent_query_count_.fetch_add(query_count, std::memory_order_relaxed);
+  sent_query_size_.fetch_add(query_size, std::memory_order_relaxed);
+  sent_packet_fill_ratio_sum_.fetch_add(static_cast<uint64>(fill_ratio * 1e6), std::memory_order_relaxed);
+}
+
+NetQueryStats::PacketStats NetQueryStats::get_packet_stats() const {
+  PacketStats result;
+  result.packet_count = sent_packet_count_.load(std::memory_order_relaxed);
+  result.query_count = sent_query_count_.load(std::memory_order_relaxed);
+  result.query_size = sent_query_size_.load(std::memory_order_relaxed);
+  if (result.packet_count != 0) {
+    result.average_fill_ratio = static_cast<double>(sent_packet_fill_ratio_sum_.load(std::memory_order_relaxed)) /
+                                1e6 / static_cast<double>(result.packet_count);
+  }
+  return result;
+}
+
+static_assert(NetQueryStats::PRIORITY_CLASS_COUNT == NetQuery::PRIORITY_CLASS_COUNT, "");
+
+void NetQueryStats::on_query_queued(size_t priority_class) {
+  CHECK(priority_class < PRIORITY_CLASS_COUNT);
+  priority_class_stats_[priority_class].queue_size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NetQueryStats::on_query_dequeued(size_t priority_class, double wait_time) {
+  CHECK(priority_class < PRIORITY_CLASS_COUNT);
+  auto &stats = priority_class_stats_[priority_class];
+  stats.queue_size_.fetch_sub(1, std::memory_order_relaxed);
+  stats.dequeued_count_.fetch_add(1, std::memory_order_relaxed);
+  stats.total_wait_time_.fetch_add(static_cast<uint64>(max(wait_time, 0.0) * 1e6), std::memory_order_relaxed);
+}
+
+NetQueryStats::QueueStats NetQueryStats::get_queue_stats(size_t priority_class) const {
+  CHECK(priority_class < PRIORITY_CLASS_COUNT);
+  const auto &stats = priority_class_stats_[priority_class];
+  QueueStats result;
+  result.queue_size = stats.queue_size_.load(std::memory_order_relaxed);
+  result.dequeued_count = stats.dequeued_count_.load(std::memory_order_relaxed);
+  if (result.dequeued_count != 0) {
+    result.average_wait_time = static_cast<double>(stats.total_wait_time_.load(std::memory_order_relaxed)) / 1e6 /
+                               static_cast<double>(result.dequeued_count);
+  }
+  return result;
+}
+
+void NetQueryStats::LatencyHistogram::add(double duration) {
+  size_t bucket = 0;
+  auto duration_ms = duration * 1000;
+  while (bucket + 1 < BUCKET_COUNT && duration_ms >= static_cast<double>(uint64(1) << bucket)) {
+    bucket++;
+  }
+  bucket_counts[bucket]++;
+  total_time += duration;
+}
+
+double NetQueryStats::LatencyHistogram::get_percentile(uint64 count, double percentile) const {
+  // returns the upper bound of the bucket containing the percentile
+  auto needed_count = static_cast<uint64>(static_cast<double>(count) * percentile);
+  uint64 current_count = 0;
+  for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+    current_count += bucket_counts[bucket];
+    if (current_count > needed_count) {
+      return static_cast<double>(uint64(1) << bucket) * 1e-3;
+    }
+  }
+  return static_cast<double>(uint64(1) << (BUCKET_COUNT - 1)) * 1e-3;
+}
+
+void NetQueryStats::on_query_finished(int32 tl_constructor, int32 dc_id, const QueryLatency &latency) {
+  auto key = (static_cast<uint64>(static_cast<uint32>(tl_constructor)) << 32) | static_cast<uint32>(dc_id);
+  std::lock_guard<std::mutex> guard(latency_mutex_);
+  auto &function_latency = latencies_[key];
+  function_latency.count++;
+  function_latency.queue.add(latency.queue_time);
+  function_latency.flood_wait.add(latency.flood_wait_time);
+  function_latency.server.add(latency.server_time);
+  function_latency.delivery.add(latency.delivery_time);
+  function_latency.total.add(latency.total_time);
+}
+
+string NetQueryStats::get_latency_statistics() const {
+  vector<std::pair<uint64, FunctionLatency>> latencies;
+  {
+    std::lock_guard<std::mutex> guard(latency_mutex_);
+    latencies.reserve(latencies_.size());
+    for (auto &it : latencies_) {
+      latencies.emplace_back(it.first, it.second);
+    }
+  }
+  std::sort(latencies.begin(), latencies.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.second.total.total_time > rhs.second.total.total_time;
+  });
+
+  auto get_stage_stats = [](Slice name, uint64 count, const LatencyHistogram &histogram) {
+    return PSTRING() << ' ' << name << " avg/p50/p90/p99 "
+                     << format::as_time(histogram.total_time / static_cast<double>(count)) << '/'
+                     << format::as_time(histogram.get_percentile(count, 0.5)) << '/'
+                     << format::as_time(histogram.get_percentile(count, 0.9)) << '/'
+                     << format::as_time(histogram.get_percentile(count, 0.99));
+  };
+
+  string result;
+  for (auto &it : latencies) {
+    auto tl_constructor = static_cast<int32>(it.first >> 32);
+    auto dc_id = static_cast<int32>(static_cast<uint32>(it.first));
+    const auto &latency = it.second;
+    result += PSTRING() << "function " << format::as_hex(tl_constructor) << " DC " << dc_id << ": " << latency.count
+                        << " queries," << get_stage_stats("total", latency.count, latency.total) << ','
+                        << get_stage_stats("queue", latency.count, latency.queue) << ','
+                        << get_stage_stats("flood wait", latency.count, latency.flood_wait) << ','
+                        << get_stage_stats("server", latency.count, latency.server) << ','
+                        << get_stage_stats("delivery", latency.count, latency.delivery) << '\n';
+  }
+  return result;
+}
+
 void NetQueryStats::dump_pending_network_queries() {
   auto n = get_count();
   LOG(WARNING) << tag("pending net queries", n);
 
+  auto packet_stats = get_packet_stats();
+  LOG(WARNING) << tag("sent packets", packet_stats.packet_count) << tag("sent queries", packet_stats.query_count)
+               << tag("sent query bytes", packet_stats.query_size)
+               << tag("average container fill ratio", packet_stats.average_fill_ratio);
+  for (size_t priority_class = 0; priority_class < PRIORITY_CLASS_COUNT; priority_class++) {
+    auto queue_stats = get_queue_stats(priority_class);
+    LOG(WARNING) << tag("priority class", priority_class) << tag("queued", queue_stats.queue_size)
+                 << tag("dequeued", queue_stats.dequeued_count)
+                 << tag("average wait time", format::as_time(queue_stats.average_wait_time));
+  }
+
   if (!use_list_) {
     return;
   }
@@ -12,6 +12,8 @@
 #include "td/utils/TsList.h"
 
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace td {
 
@@ -38,10 +40,79 @@ class NetQueryStats {
 
   uint64 get_count() const;
 
+  void on_queries_sent(size_t query_count, size_t query_size, double fill_ratio);
+
+  struct PacketStats {
+    uint64 packet_count = 0;
+    uint64 query_count = 0;
+    uint64 query_size = 0;
+    double average_fill_ratio = 0.0;
+  };
+  PacketStats get_packet_stats() const;
+
+  // priority_class is the value of NetQuery::PriorityClass
+  void on_query_queued(size_t priority_class);
+
+  void on_query_dequeued(size_t priority_class, double wait_time);
+
+  struct QueueStats {
+    int64 queue_size = 0;
+    uint64 dequeued_count = 0;
+    double average_wait_time = 0.0;
+  };
+  QueueStats get_queue_stats(size_t priority_class) const;
+
+  // durations of the stages of a finished query in seconds
+  struct QueryLatency {
+    double queue_time = 0.0;       // waiting in TDLib queues
+    double flood_wait_time = 0.0;  // waiting for the end of flood waits
+    double server_time = 0.0;      // waiting for answers from the server
+    double delivery_time = 0.0;    // delivering the result to the caller
+    double total_time = 0.0;
+  };
+  void on_query_finished(int32 tl_constructor, int32 dc_id, const QueryLatency &latency);
+
+  // returns latency histograms for all finished queries in a human-readable format
+  string get_latency_statistics() const;
+
   void dump_pending_network_queries();
 
+  static constexpr size_t PRIORITY_CLASS_COUNT = 3;
+
  private:
   NetQueryCounter::Counter count_{0};
+  std::atomic<uint64> sent_packet_count_{0};
+  std::atomic<uint64> sent_query_count_{0};
+  std::atomic<uint64> sent_query_size_{0};
+  std::atomic<uint64> sent_packet_fill_ratio_sum_{0};  // in 1/1000000 units
+
+  struct PriorityClassStats {
+    std::atomic<int64> queue_size_{0};
+    std::atomic<uint64> dequeued_count_{0};
+    std::atomic<uint64> total_wait_time_{0};  // in microseconds
+  };
+  PriorityClassStats priority_class_stats_[PRIORITY_CLASS_COUNT];
+
+  // bucket i contains durations in [2^(i-1), 2^i) milliseconds; the first bucket contains durations less than 1 ms
+  struct LatencyHistogram {
+    static constexpr size_t BUCKET_COUNT = 20;
+    uint64 bucket_counts[BUCKET_COUNT] = {};
+    double total_time = 0.0;
+
+    void add(double duration);
+
+    double get_percentile(uint64 count, double percentile) const;
+  };
+  struct FunctionLatency {
+    uint64 count = 0;
+    LatencyHistogram queue;
+    LatencyHistogram flood_wait;
+    LatencyHistogram server;
+    LatencyHistogram delivery;
+    LatencyHistogram total;
+  };
+  mutable std::mutex latency_mutex_;
+  std::unordered_map<uint64, FunctionLatency> latencies_;  // by tl_constructor and DC identifier
   std::atomic<bool> use_list_{true};
   TsList<NetQueryDebug> list_;
 };
@@ -12,7 +12,9 @@
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCreator.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/net/NetQueryStats.h"
 #include "td/telegram/net/NetType.h"
 #include "td/telegram/StateManager.h"
 #include "td/telegram/telegram_api.h"
@@ -41,6 +43,7 @@
 #include "td/utils/Time.h"
 #include "td/utils/Timer.h"
 #include "td/utils/tl_parsers.h"
+#include "td/utils/TraceSpans.h"
 #include "td/utils/utf8.h"
 #include "td/utils/VectorQueue.h"
 
@@ -212,19 +215,55 @@ TD_THREAD_LOCAL Semaphore *GenAuthKeyActor::semaphore_{};
 
 }  // namespace detail
 
+uint64 Session::PriorityQueue::get_stride(size_t priority_class) {
+  // interactive queries get 4 times more sending slots than normal queries, which get 4 times more than bulk queries
+  static constexpr uint64 STRIDES[NetQuery::PRIORITY_CLASS_COUNT] = {16, 4, 1};
+  CHECK(priority_class < NetQuery::PRIORITY_CLASS_COUNT);
+  return STRIDES[priority_class];
+}
+
 void Session::PriorityQueue::push(NetQueryPtr query) {
-  auto priority = query->priority();
-  queries_[priority].push(std::move(query));
+  auto priority_class = static_cast<size_t>(query->priority_class());
+  CHECK(priority_class < NetQuery::PRIORITY_CLASS_COUNT);
+  auto &queues = queries_[query->priority()];
+  auto &class_queue = queues.class_queues_[priority_class];
+  if (class_queue.queries_.empty()) {
+    // an idle class must not accumulate sending slots
+    class_queue.pass_ = max(class_queue.pass_, virtual_time_);
+  }
+  auto net_query_stats = G()->net_query_creator().get_net_query_stats();
+  if (net_query_stats != nullptr) {
+    net_query_stats->on_query_queued(priority_class);
+  }
+  class_queue.queries_.push(PendingQuery{std::move(query), Time::now()});
+  queues.size_++;
 }
 
 NetQueryPtr Session::PriorityQueue::pop() {
   CHECK(!empty());
   auto it = queries_.begin();
-  auto res = it->second.pop();
-  if (it->second.empty()) {
+  auto &queues = it->second;
+  size_t best_class = NetQuery::PRIORITY_CLASS_COUNT;
+  for (size_t priority_class = NetQuery::PRIORITY_CLASS_COUNT; priority_class-- > 0;) {
+    const auto &class_queue = queues.class_queues_[priority_class];
+    if (!class_queue.queries_.empty() &&
+        (best_class == NetQuery::PRIORITY_CLASS_COUNT || class_queue.pass_ < queues.class_queues_[best_class].pass_)) {
+      best_class = priority_class;
+    }
+  }
+  CHECK(best_class < NetQuery::PRIORITY_CLASS_COUNT);
+  auto &class_queue = queues.class_queues_[best_class];
+  virtual_time_ = class_queue.pass_;
+  class_queue.pass_ += get_stride(best_class);
+  auto pending_query = class_queue.queries_.pop();
+  auto net_query_stats = G()->net_query_creator().get_net_query_stats();
+  if (net_query_stats != nullptr) {
+    net_query_stats->on_query_dequeued(best_class, Time::now() - pending_query.queued_at_);
+  }
+  if (--queues.size_ == 0) {
     queries_.erase(it);
   }
-  return res;
+  return std::move(pending_query.query_);
 }
 
 bool Session::PriorityQueue::empty() const {
@@ -489,6 +528,7 @@ void Session::on_result(NetQueryPtr query) {
 
 void Session::return_query(NetQueryPtr &&query) {
   last_activity_timestamp_ = Time::now();
+  TraceSpan trace_span(query->trace_id_, "Session::return_query");
 
   query->set_session_id(0);
   callback_->on_result(std::move(query));
@@ -757,6 +797,13 @@ void Session::on_container_sent(mtproto::MessageId container_message_id, vector<
   sent_containers_.emplace(container_message_id, ContainerInfo{size, std::move(message_ids)});
 }
 
+void Session::on_queries_sent(size_t query_count, size_t query_size, double fill_ratio) {
+  auto net_query_stats = G()->net_query_creator().get_net_query_stats();
+  if (net_query_stats != nullptr) {
+    net_query_stats->on_queries_sent(query_count, query_size, fill_ratio);
+  }
+}
+
 void Session::on_message_ack(mtproto::MessageId message_id) {
   on_message_ack_impl(message_id, 1);
 }
@@ -1145,11 +1192,13 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
   bool immediately_fail_query = false;
   if (!immediately_fail_query) {
     net_query->debug(PSTRING() << get_name() << ": send to an MTProto connection");
+    net_query->compress_query();
     auto r_message_id = info->connection_->send_query(
         net_query->query().clone(), net_query->gzip_flag() == NetQuery::GzipFlag::On, message_id,
         invoke_after_message_ids, static_cast<bool>(net_query->quick_ack_promise_));
 
     net_query->on_net_write(net_query->query().size());
+    net_query->sent_at_ = now;
 
     if (r_message_id.is_error()) {
       LOG(FATAL) << "Failed to send query: " << r_message_id.error();
@@ -138,13 +138,30 @@ class Session final
 
   // Do not invalidate iterators of these two containers!
   // TODO: better data structures
+  // queries with bigger priority are sent first; queries with the same priority are sent using
+  // weighted fair queuing between their priority classes
   struct PriorityQueue {
     void push(NetQueryPtr query);
     NetQueryPtr pop();
     bool empty() const;
 
    private:
-    std::map<int8, VectorQueue<NetQueryPtr>, std::greater<>> queries_;
+    struct PendingQuery {
+      NetQueryPtr query_;
+      double queued_at_ = 0.0;
+    };
+    struct ClassQueue {
+      VectorQueue<PendingQuery> queries_;
+      uint64 pass_ = 0;
+    };
+    struct ClassQueues {
+      std::array<ClassQueue, NetQuery::PRIORITY_CLASS_COUNT> class_queues_;
+      size_t size_ = 0;
+    };
+    std::map<int8, ClassQueues, std::greater<>> queries_;
+    uint64 virtual_time_ = 0;
+
+    static uint64 get_stride(size_t priority_class);
   };
   PriorityQueue pending_queries_;
   std::map<mtproto::MessageId, Query> sent_queries_;
@@ -224,6 +241,7 @@ class Session final
   void on_session_failed(Status status) final;
 
   void on_container_sent(mtproto::MessageId container_message_id, vector<mtproto::MessageId> message_ids) final;
+  void on_queries_sent(size_t query_count, size_t query_size, double fill_ratio) final;
 
   Status on_update(BufferSlice packet) final;
 
@@ -15,15 +15,17 @@
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
 SessionMultiProxy::~SessionMultiProxy() = default;
 
-SessionMultiProxy::SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDataShared> shared_auth_data,
-                                     bool is_primary, bool is_main, bool use_pfs, bool allow_media_only, bool is_media,
-                                     bool is_cdn)
+SessionMultiProxy::SessionMultiProxy(int32 session_count, int32 max_session_count,
+                                     std::shared_ptr<AuthDataShared> shared_auth_data, bool is_primary, bool is_main,
+                                     bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn)
     : session_count_(session_count)
+    , max_session_count_(max_session_count)
     , auth_data_(std::move(shared_auth_data))
     , is_primary_(is_primary)
     , is_main_(is_main)
@@ -41,11 +43,13 @@ void SessionMultiProxy::send(NetQueryPtr query) {
   if (query->auth_flag() == NetQuery::AuthFlag::On) {
     size_t session_rand = query->session_rand();
     if (session_rand) {
-      pos = session_rand % sessions_.size();
+      // the session must not depend on the number of additional sessions
+      pos = session_rand % static_cast<size_t>(session_count_);
     } else {
       size_t equal_count = 1;
       int min_query_count = sessions_[pos].query_count;
-      for (size_t i = 1; i < sessions_.size(); i++) {
+      auto active_session_count = static_cast<size_t>(get_active_session_count());
+      for (size_t i = 1; i < active_session_count; i++) {
         if (sessions_[i].query_count < min_query_count) {
           pos = i;
           min_query_count = sessions_[pos].query_count;
@@ -60,7 +64,9 @@ void SessionMultiProxy::send(NetQueryPtr query) {
     }
   }
   // query->debug(PSTRING() << get_name() << ": send to proxy #" << pos);
+  update_query_count_integral();
   sessions_[pos].query_count++;
+  total_query_count_++;
   send_closure(sessions_[pos].proxy, &SessionProxy::send, std::move(query));
 }
 
@@ -80,6 +86,25 @@ void SessionMultiProxy::update_session_count(int32 session_count) {
   update_options(session_count, use_pfs_, need_destroy_auth_key_);
 }
 
+void SessionMultiProxy::update_max_session_count(int32 max_session_count) {
+  if (max_session_count == max_session_count_) {
+    return;
+  }
+  LOG(INFO) << "Update max_session_count to " << max_session_count;
+  max_session_count_ = max_session_count;
+  if (get_active_session_count() > get_max_session_count()) {
+    extra_session_count_ = get_max_session_count() - session_count_;
+    close_idle_sessions();
+  }
+  if (can_add_sessions() && !has_timeout()) {
+    set_timeout_in(ADAPT_SESSION_COUNT_PERIOD);
+  }
+}
+
+void SessionMultiProxy::on_flood_wait() {
+  last_flood_wait_time_ = Time::now();
+}
+
 void SessionMultiProxy::update_use_pfs(bool use_pfs) {
   update_options(session_count_, use_pfs, need_destroy_auth_key_);
 }
@@ -129,40 +154,120 @@ void SessionMultiProxy::start_up() {
   init();
 }
 
+void SessionMultiProxy::timeout_expired() {
+  update_query_count_integral();
+  auto active_session_count = get_active_session_count();
+  auto queries_per_session =
+      query_count_integral_ / ADAPT_SESSION_COUNT_PERIOD / static_cast<double>(active_session_count);
+  query_count_integral_ = 0.0;
+
+  auto new_extra_session_count = extra_session_count_;
+  if (last_flood_wait_time_ > Time::now() - FLOOD_WAIT_COOLDOWN) {
+    // more sessions will only cause more flood waits
+    if (new_extra_session_count > 0) {
+      new_extra_session_count--;
+    }
+  } else if (queries_per_session > MAX_QUERIES_PER_SESSION) {
+    if (session_count_ + new_extra_session_count < get_max_session_count() && can_add_sessions()) {
+      new_extra_session_count++;
+    }
+  } else if (queries_per_session < MIN_QUERIES_PER_SESSION) {
+    if (new_extra_session_count > 0) {
+      new_extra_session_count--;
+    }
+  }
+  if (new_extra_session_count != extra_session_count_) {
+    LOG(INFO) << "Change number of additional sessions from " << extra_session_count_ << " to "
+              << new_extra_session_count << " with " << queries_per_session << " queries per session";
+    extra_session_count_ = new_extra_session_count;
+    while (static_cast<int32>(sessions_.size()) < get_active_session_count()) {
+      sessions_.push_back(create_session(narrow_cast<int32>(sessions_.size())));
+    }
+    close_idle_sessions();
+  }
+
+  if (can_add_sessions() || extra_session_count_ > 0) {
+    set_timeout_in(ADAPT_SESSION_COUNT_PERIOD);
+  }
+}
+
 bool SessionMultiProxy::get_pfs_flag() const {
   return use_pfs_ && !is_cdn_;
 }
 
+bool SessionMultiProxy::can_add_sessions() const {
+  // updates are expected to be received through a single session, unless session_count is explicitly increased,
+  // and multiple primary sessions need their own temporary authorization keys
+  return session_count_ < get_max_session_count() && !need_destroy_auth_key_ &&
+         (!is_primary_ || (session_count_ > 1 && get_pfs_flag()));
+}
+
+int32 SessionMultiProxy::get_active_session_count() const {
+  return session_count_ + extra_session_count_;
+}
+
+int32 SessionMultiProxy::get_max_session_count() const {
+  return max(max_session_count_, session_count_);
+}
+
+void SessionMultiProxy::update_query_count_integral() {
+  auto now = Time::now();
+  if (last_query_count_change_time_ != 0.0) {
+    query_count_integral_ += total_query_count_ * (now - last_query_count_change_time_);
+  }
+  last_query_count_change_time_ = now;
+}
+
+void SessionMultiProxy::close_idle_sessions() {
+  // sessions are closed only from the end to keep session identifiers of the remaining sessions
+  while (static_cast<int32>(sessions_.size()) > get_active_session_count() && sessions_.back().query_count == 0) {
+    LOG(INFO) << "Close additional session " << sessions_.size() - 1;
+    sessions_.pop_back();
+  }
+}
+
+SessionMultiProxy::SessionInfo SessionMultiProxy::create_session(int32 session_id) {
+  bool has_many_sessions = session_count_ > 1 || session_id > 0;
+  string name = PSTRING() << "Session" << get_name().substr(Slice("SessionMulti").size())
+                          << format::cond(has_many_sessions, format::concat("#", session_id));
+
+  SessionInfo info;
+  class Callback final : public SessionProxy::Callback {
+   public:
+    Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
+        : parent_(parent), generation_(generation), session_id_(session_id) {
+    }
+    void on_query_finished() final {
+      send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_);
+    }
+
+   private:
+    ActorId<SessionMultiProxy> parent_;
+    uint32 generation_;
+    int32 session_id_;
+  };
+  info.proxy = create_actor<SessionProxy>(
+      name, make_unique<Callback>(actor_id(this), sessions_generation_, session_id), auth_data_, is_primary_, is_main_,
+      allow_media_only_, is_media_, get_pfs_flag(), has_many_sessions && is_primary_, is_cdn_,
+      need_destroy_auth_key_ && session_id == 0);
+  return info;
+}
+
 void SessionMultiProxy::init() {
   sessions_generation_++;
   sessions_.clear();
+  extra_session_count_ = 0;
+  update_query_count_integral();
+  total_query_count_ = 0;
+  query_count_integral_ = 0.0;
   if (is_main_ && session_count_ > 1) {
     LOG(WARNING) << tag("session_count", session_count_);
   }
   for (int32 i = 0; i < session_count_; i++) {
-    string name = PSTRING() << "Session" << get_name().substr(Slice("SessionMulti").size())
-                            << format::cond(session_count_ > 1, format::concat("#", i));
-
-    SessionInfo info;
-    class Callback final : public SessionProxy::Callback {
-     public:
-      Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
-          : parent_(parent), generation_(generation), session_id_(session_id) {
-      }
-      void on_query_finished() final {
-        send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_);
-      }
-
-     private:
-      ActorId<SessionMultiProxy> parent_;
-      uint32 generation_;
-      int32 session_id_;
-    };
-    info.proxy =
-        create_actor<SessionProxy>(name, make_unique<Callback>(actor_id(this), sessions_generation_, i), auth_data_,
-                                   is_primary_, is_main_, allow_media_only_, is_media_, get_pfs_flag(),
-                                   session_count_ > 1 && is_primary_, is_cdn_, need_destroy_auth_key_ && i == 0);
-    sessions_.push_back(std::move(info));
+    sessions_.push_back(create_session(i));
+  }
+  if (can_add_sessions()) {
+    set_timeout_in(ADAPT_SESSION_COUNT_PERIOD);
   }
 }
 
@@ -173,7 +278,12 @@ void SessionMultiProxy::on_query_finished(uint32 generation, int session_id) {
   CHECK(static_cast<size_t>(session_id) < sessions_.size());
   auto &query_count = sessions_[session_id].query_count;
   CHECK(query_count > 0);
+  update_query_count_integral();
   query_count--;
+  total_query_count_--;
+  if (query_count == 0 && session_id >= get_active_session_count()) {
+    close_idle_sessions();
+  }
 }
 
 }  // namespace td
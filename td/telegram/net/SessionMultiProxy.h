@@ -19,8 +19,10 @@ class SessionProxy;
 
 class SessionMultiProxy final : public Actor {
  public:
-  SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDataShared> shared_auth_data, bool is_primary,
-                    bool is_main, bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn);
+  // the number of sessions is adjusted between session_count and max(session_count, max_session_count)
+  // depending on the load
+  SessionMultiProxy(int32 session_count, int32 max_session_count, std::shared_ptr<AuthDataShared> shared_auth_data,
+                    bool is_primary, bool is_main, bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn);
   SessionMultiProxy(const SessionMultiProxy &) = delete;
   SessionMultiProxy &operator=(const SessionMultiProxy &) = delete;
   ~SessionMultiProxy() final;
@@ -29,14 +31,24 @@ class SessionMultiProxy final : public Actor {
   void update_main_flag(bool is_main);
 
   void update_session_count(int32 session_count);
+  void update_max_session_count(int32 max_session_count);
   void update_use_pfs(bool use_pfs);
   void update_options(int32 session_count, bool use_pfs, bool need_destroy_auth_key);
   void update_mtproto_header();
 
   void destroy_auth_key();
 
+  void on_flood_wait();
+
  private:
+  static constexpr double ADAPT_SESSION_COUNT_PERIOD = 5.0;
+  static constexpr double MIN_QUERIES_PER_SESSION = 0.5;
+  static constexpr double MAX_QUERIES_PER_SESSION = 4.0;
+  static constexpr double FLOOD_WAIT_COOLDOWN = 60.0;
+
   int32 session_count_ = 0;
+  int32 max_session_count_ = 0;
+  int32 extra_session_count_ = 0;  // sessions after session_count_ + extra_session_count_ are closed, when become idle
   std::shared_ptr<AuthDataShared> auth_data_;
   const bool is_primary_;
   bool is_main_ = false;
@@ -52,9 +64,27 @@ class SessionMultiProxy final : public Actor {
   uint32 sessions_generation_{0};
   std::vector<SessionInfo> sessions_;
 
+  int32 total_query_count_ = 0;
+  double query_count_integral_ = 0.0;
+  double last_query_count_change_time_ = 0.0;
+  double last_flood_wait_time_ = 0.0;
+
   void start_up() final;
+  void timeout_expired() final;
   void init();
 
+  SessionInfo create_session(int32 session_id);
+
+  int32 get_active_session_count() const;
+
+  int32 get_max_session_count() const;
+
+  bool can_add_sessions() const;
+
+  void update_query_count_integral();
+
+  void close_idle_sessions();
+
   bool get_pfs_flag() const;
 
   void on_query_finished(uint32 generation, int session_id);
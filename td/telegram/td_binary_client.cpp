@@ -0,0 +1,51 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_binary_client.h"
+
+#include "td/telegram/ClientBinary.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+static td::Slice to_slice(const char *data, int size) {
+  if (data == nullptr || size <= 0) {
+    return td::Slice();
+  }
+  return td::Slice(data, static_cast<size_t>(size));
+}
+
+static const char *from_slice(td::Slice slice, int *size) {
+  if (size != nullptr) {
+    *size = static_cast<int>(slice.size());
+  }
+  return slice.empty() ? nullptr : slice.data();
+}
+
+int td_binary_create_client_id() {
+  return td::binary_create_client_id();
+}
+
+void td_binary_send(int client_id, unsigned long long request_id, const char *request, int request_size) {
+  td::binary_send(client_id, static_cast<td::uint64>(request_id), to_slice(request, request_size));
+}
+
+const char *td_binary_receive(double timeout, int *client_id, unsigned long long *request_id, int *response_size) {
+  int response_client_id = 0;
+  td::uint64 response_request_id = 0;
+  auto response = td::binary_receive(timeout, response_client_id, response_request_id);
+  if (client_id != nullptr) {
+    *client_id = response_client_id;
+  }
+  if (request_id != nullptr) {
+    *request_id = static_cast<unsigned long long>(response_request_id);
+  }
+  return from_slice(response, response_size);
+}
+
+const char *td_binary_execute(const char *request, int request_size, int *response_size) {
+  return from_slice(td::binary_execute(to_slice(request, request_size)), response_size);
+}
@@ -0,0 +1,108 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+/**
+ * \file
+ * C interface for interaction with TDLib via TL-serialized objects.
+ * Can be used to integrate TDLib with any programming language which supports calling C functions
+ * without the overhead of JSON serialization.
+ *
+ * TDLib API objects are serialized in the TL binary format according to the TDLib API scheme, which is installed
+ * together with the library as td_api.tl and as its binary form td_api.tlo.
+ * All requests and objects are boxed, i.e., they start with a 4-byte identifier of their constructor, and
+ * the fields follow in the order of their declaration in the scheme.
+ * Fields of int32 type are stored as 4-byte little-endian integers, fields of int53 and int64 types are stored as
+ * 8-byte little-endian integers, fields of double type are stored as 8-byte IEEE 754 numbers.
+ * Fields of Bool type are stored as constructor identifiers boolFalse#bc799737 or boolTrue#997275b5.
+ * Fields of string and bytes types are stored as TL strings, fields of vector type are stored as a 4-byte
+ * number of elements followed by the serialized elements.
+ * Unlike the standard TL serialization, object fields, including vector elements, are always boxed, even if
+ * the scheme specifies the exact object type. A missing object is stored as the constructor identifier null#56730bcc.
+ *
+ * The interface is based on the same ClientManager as the JSON interface in td_json_client.h, so the two interfaces
+ * must not be used simultaneously in the same process.
+ *
+ * A TDLib client instance can be created through td_binary_create_client_id.
+ * Requests can be sent using td_binary_send and the received client identifier.
+ * New updates and responses to requests can be received through td_binary_receive from any thread after the first
+ * request has been sent to the client instance. This function must not be called simultaneously from two different
+ * threads. Also, note that all updates and responses to requests must be applied in the order they were received for
+ * consistency.
+ * Some TDLib requests can be executed synchronously from any thread using td_binary_execute.
+ * TDLib client instances are destroyed automatically after they are closed.
+ * All TDLib client instances must be closed before application termination to ensure data consistency.
+ *
+ * General pattern of usage:
+ * \code
+ * int client_id = td_binary_create_client_id();
+ * // share the client_id with other threads, which will be able to send requests via td_binary_send
+ *
+ * const double WAIT_TIMEOUT = 10.0; // seconds
+ * while (true) {
+ *   int response_client_id;
+ *   unsigned long long request_id;
+ *   int size;
+ *   const char *result = td_binary_receive(WAIT_TIMEOUT, &response_client_id, &request_id, &size);
+ *   if (result) {
+ *     // parse the result as a TL object and process it as an incoming update if request_id == 0 or
+ *     // as the answer to a previously sent request with the identifier request_id
+ *   }
+ * }
+ * \endcode
+ */
+
+#include "td/telegram/tdjson_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns an opaque identifier of a new TDLib instance.
+ * The TDLib instance will not send updates until the first request is sent to it.
+ * \return Opaque identifier of a new TDLib instance.
+ */
+TDJSON_EXPORT int td_binary_create_client_id();
+
+/**
+ * Sends request to the TDLib client. May be called from any thread.
+ * \param[in] client_id TDLib client identifier.
+ * \param[in] request_id Request identifier, which will be returned with the response to the request.
+ *                       Must be non-zero.
+ * \param[in] request TL-serialized request to TDLib.
+ * \param[in] request_size Size of the request in bytes.
+ */
+TDJSON_EXPORT void td_binary_send(int client_id, unsigned long long request_id, const char *request,
+                                  int request_size);
+
+/**
+ * Receives incoming updates and request responses. Must not be called simultaneously from two different threads.
+ * The returned pointer can be used until the next call to td_binary_receive or td_binary_execute, after which it will be deallocated by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] client_id Identifier of the client for which the update or the response was received.
+ * \param[out] request_id Identifier of the request to which the response corresponds, or 0 for incoming updates.
+ * \param[out] response_size Size of the returned object in bytes.
+ * \return TL-serialized incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_binary_receive(double timeout, int *client_id, unsigned long long *request_id,
+                                            int *response_size);
+
+/**
+ * Synchronously executes a TDLib request.
+ * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
+ * The returned pointer can be used until the next call to td_binary_receive or td_binary_execute, after which it will be deallocated by TDLib.
+ * \param[in] request TL-serialized request to TDLib.
+ * \param[in] request_size Size of the request in bytes.
+ * \param[out] response_size Size of the returned object in bytes.
+ * \return TL-serialized request response.
+ */
+TDJSON_EXPORT const char *td_binary_execute(const char *request, int request_size, int *response_size);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
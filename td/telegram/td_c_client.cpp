@@ -8,6 +8,7 @@
 
 #include "td/telegram/Client.h"
 #include "td/telegram/Log.h"
+#include "td/telegram/td_c_client_arena.h"
 #include "td/telegram/td_tdc_api_inner.h"
 
 #include <cstring>
@@ -40,6 +41,32 @@ TdObject *TdCClientExecute(TdFunction *function) {
   return TdConvertFromInternal(*result);
 }
 
+TdResponse TdCClientReceiveArena(double timeout, TdCArena **arena) {
+  auto response = GetClientManager()->receive(timeout);
+  TdResponse c_response;
+  c_response.client_id = response.client_id;
+  c_response.request_id = response.request_id;
+  if (response.object == nullptr) {
+    *arena = nullptr;
+    c_response.object = nullptr;
+  } else {
+    *arena = new TdCArena();
+    c_response.object = TdConvertFromInternal(*response.object, *arena);
+  }
+  return c_response;
+}
+
+TdObject *TdCClientExecuteArena(TdFunction *function, TdCArena **arena) {
+  auto result = td::ClientManager::execute(TdConvertToInternal(function));
+  TdDestroyObjectFunction(function);
+  *arena = new TdCArena();
+  return TdConvertFromInternal(*result, *arena);
+}
+
+void TdCClientDestroyArena(TdCArena *arena) {
+  delete arena;
+}
+
 TdVectorInt *TdCreateObjectVectorInt(int size, int *data) {
   auto res = new TdVectorInt();
   res->len = size;
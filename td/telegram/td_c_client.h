@@ -36,6 +36,24 @@ struct TdResponse TdCClientReceive(double timeout);
 
 struct TdObject *TdCClientExecute(struct TdFunction *function);
 
+/* Memory arena, in which all C objects of a response are allocated. */
+struct TdCArena;
+
+/*
+ * Receives a response like TdCClientReceive, but allocates the whole returned object in a new arena, which is returned
+ * in *arena. The object must not be destroyed with TdDestroyObject; it is freed by TdCClientDestroyArena instead.
+ */
+struct TdResponse TdCClientReceiveArena(double timeout, struct TdCArena **arena);
+
+/*
+ * Executes a function like TdCClientExecute, but allocates the whole returned object in a new arena, which is returned
+ * in *arena. The object must not be destroyed with TdDestroyObject; it is freed by TdCClientDestroyArena instead.
+ */
+struct TdObject *TdCClientExecuteArena(struct TdFunction *function, struct TdCArena **arena);
+
+/* Frees an arena and all objects allocated in it. The arena can be null. */
+void TdCClientDestroyArena(struct TdCArena *arena);
+
 #ifdef __cplusplus
 }
 #endif
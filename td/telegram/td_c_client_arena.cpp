@@ -0,0 +1,64 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_c_client_arena.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/Slice.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+TdCArena::~TdCArena() {
+  for (auto chunk : chunks_) {
+    std::free(chunk);
+  }
+}
+
+void *TdCArena::allocate(size_t size) {
+  constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  if (size > left_) {
+    if (size > CHUNK_SIZE / 4) {
+      // big allocations get their own chunk, so the rest of the current chunk isn't wasted
+      auto chunk = static_cast<char *>(std::calloc(1, size));
+      LOG_CHECK(chunk != nullptr) << "Failed to allocate " << size << " bytes";
+      chunks_.push_back(chunk);
+      return chunk;
+    }
+    current_ = static_cast<char *>(std::calloc(1, CHUNK_SIZE));
+    LOG_CHECK(current_ != nullptr) << "Failed to allocate " << CHUNK_SIZE << " bytes";
+    chunks_.push_back(current_);
+    left_ = CHUNK_SIZE;
+  }
+  auto result = current_;
+  current_ += size;
+  left_ -= size;
+  return result;
+}
+
+char *TdCArena::dup_string(TdCArena *arena, const td::string &str) {
+  if (str.empty()) {
+    return nullptr;
+  }
+  if (arena == nullptr) {
+    return td::str_dup(str);
+  }
+  auto result = static_cast<char *>(arena->allocate(str.size() + 1));
+  std::memcpy(result, str.data(), str.size());
+  return result;
+}
+
+unsigned char *TdCArena::dup_bytes(TdCArena *arena, const td::string &bytes) {
+  if (bytes.empty()) {
+    return nullptr;
+  }
+  auto result = create_array<unsigned char>(arena, static_cast<int>(bytes.size()));
+  std::memcpy(result, bytes.data(), bytes.size());
+  return result;
+}
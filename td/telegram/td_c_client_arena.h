@@ -0,0 +1,54 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+// Memory arena, in which all C objects of a response are allocated.
+// The objects are freed all at once together with the arena and must not be destroyed with TdDestroyObject.
+struct TdCArena {
+  TdCArena() = default;
+  TdCArena(const TdCArena &) = delete;
+  TdCArena &operator=(const TdCArena &) = delete;
+  TdCArena(TdCArena &&) = delete;
+  TdCArena &operator=(TdCArena &&) = delete;
+  ~TdCArena();
+
+  // returns zero-initialized memory, which is valid until destruction of the arena
+  void *allocate(size_t size);
+
+  // the following functions allocate memory in the arena if it is non-null and in the heap otherwise
+
+  template <class T>
+  static T *create_object(TdCArena *arena) {
+    if (arena == nullptr) {
+      return new T();
+    }
+    return static_cast<T *>(arena->allocate(sizeof(T)));
+  }
+
+  template <class T>
+  static T *create_array(TdCArena *arena, int size) {
+    if (arena == nullptr) {
+      return new T[size];
+    }
+    return static_cast<T *>(arena->allocate(sizeof(T) * static_cast<size_t>(size)));
+  }
+
+  // returns nullptr for an empty string
+  static char *dup_string(TdCArena *arena, const td::string &str);
+
+  // returns nullptr for empty bytes
+  static unsigned char *dup_bytes(TdCArena *arena, const td::string &bytes);
+
+ private:
+  static constexpr size_t CHUNK_SIZE = 1 << 14;
+
+  td::vector<char *> chunks_;
+  char *current_ = nullptr;
+  size_t left_ = 0;
+};
@@ -43,6 +43,10 @@ const char *td_receive(double timeout) {
   return td::json_receive(timeout);
 }
 
+const char *td_receive_batch(int max_count, double timeout) {
+  return td::json_receive_batch(max_count, timeout);
+}
+
 const char *td_execute(const char *request) {
   return td::json_execute(td::Slice(request == nullptr ? "" : request));
 }
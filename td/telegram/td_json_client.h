@@ -23,6 +23,10 @@
  * be added to the request object. The corresponding response will have an "@extra" field with exactly the same value.
  * Each returned object will have an "@client_id" field, containing the identifier of the client for which
  * a response or an update was received.
+ * Additionally, the field "@timeout" of type Number can be added to a request sent through td_send to specify
+ * the maximum number of seconds the request is allowed to wait in TDLib queues. If TDLib doesn't start to process
+ * the request or can't send network queries for it before the timeout expires, then the request fails with
+ * the error 408 "Request timeout expired".
  *
  * A TDLib client instance can be created through td_create_client_id.
  * Requests can be sent using td_send and the received client identifier.
@@ -70,16 +74,27 @@ TDJSON_EXPORT void td_send(int client_id, const char *request);
 
 /**
  * Receives incoming updates and request responses. Must not be called simultaneously from two different threads.
- * The returned pointer can be used until the next call to td_receive or td_execute, after which it will be deallocated by TDLib.
+ * The returned pointer can be used until the next call to td_receive, td_receive_batch or td_execute, after which it will be deallocated by TDLib.
  * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
  * \return JSON-serialized null-terminated incoming update or request response. May be NULL if the timeout expires.
  */
 TDJSON_EXPORT const char *td_receive(double timeout);
 
+/**
+ * Receives up to max_count incoming updates and request responses at once. Waits for new data only if there are no pending updates and responses.
+ * Must not be called simultaneously from two different threads, or simultaneously with td_receive.
+ * The returned pointer can be used until the next call to td_receive, td_receive_batch or td_execute, after which it will be deallocated by TDLib.
+ * \param[in] max_count The maximum number of returned updates and request responses. Must be positive.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \return JSON-serialized null-terminated array of incoming updates and request responses in the order they were received.
+ *         May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_receive_batch(int max_count, double timeout);
+
 /**
  * Synchronously executes a TDLib request.
  * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
- * The returned pointer can be used until the next call to td_receive or td_execute, after which it will be deallocated by TDLib.
+ * The returned pointer can be used until the next call to td_receive, td_receive_batch or td_execute, after which it will be deallocated by TDLib.
  * \param[in] request JSON-serialized null-terminated request to TDLib.
  * \return JSON-serialized null-terminated request response.
  */
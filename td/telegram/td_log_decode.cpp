@@ -0,0 +1,54 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/BinaryFileLog.h"
+#include "td/utils/common.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/Slice.h"
+#include "td/utils/TsCerr.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void usage() {
+  td::TsCerr() << "Converts TDLib log files written with logStreamBinaryFile to text and outputs them to stdout.\n";
+  td::TsCerr() << "Usage: td_log_decode log_file [log_file2 ...]\n";
+  td::TsCerr() << "To get messages in chronological order, pass the rotated file \"<path>.old\" first.\n";
+  std::exit(2);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    usage();
+  }
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0) {
+      usage();
+    }
+  }
+
+  int exit_code = 0;
+  for (int i = 1; i < argc; i++) {
+    td::CSlice path(argv[i]);
+    auto r_data = td::read_file_str(path);
+    if (r_data.is_error()) {
+      td::TsCerr() << "Error: failed to read \"" << path << "\": " << r_data.error().message() << "\n";
+      exit_code = 1;
+      continue;
+    }
+    auto status = td::BinaryFileLog::decode(r_data.ok(), [](td::CSlice message) {
+      std::fwrite(message.data(), 1, message.size(), stdout);
+    });
+    if (status.is_error()) {
+      // the last record can be incomplete if the log is still being written
+      td::TsCerr() << "Error: failed to decode \"" << path << "\": " << status.message() << "\n";
+      exit_code = 1;
+    }
+  }
+  std::fflush(stdout);
+  return exit_code;
+}
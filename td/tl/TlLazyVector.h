@@ -0,0 +1,167 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/tl_parsers.h"
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace td {
+
+// vector, which keeps serialized elements and parses them on each access
+template <class T>
+class TlLazyVector {
+ public:
+  using ParseFunc = T (*)(TlBufferParser &parser);
+
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T;
+
+    const_iterator(const TlLazyVector *vector, size_t pos) : vector_(vector), pos_(pos) {
+    }
+
+    T operator*() const {
+      return vector_->get(pos_);
+    }
+
+    const_iterator &operator++() {
+      pos_++;
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return pos_ == other.pos_;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return pos_ != other.pos_;
+    }
+
+   private:
+    const TlLazyVector *vector_;
+    size_t pos_;
+  };
+
+  TlLazyVector() = default;
+
+  TlLazyVector(BufferSlice data, vector<uint32> element_ends, ParseFunc parse_func)
+      : data_(std::move(data)), element_ends_(std::move(element_ends)), parse_func_(parse_func) {
+  }
+
+  size_t size() const {
+    return element_ends_.size();
+  }
+
+  bool empty() const {
+    return element_ends_.empty();
+  }
+
+  T get(size_t pos) const {
+    CHECK(pos < size());
+    size_t begin = pos == 0 ? 0 : element_ends_[pos - 1];
+    auto element = data_.from_slice(data_.as_slice().substr(begin, element_ends_[pos] - begin));
+    TlBufferParser parser(&element);
+    auto result = parse_func_(parser);
+    parser.fetch_end();
+    LOG_CHECK(parser.get_error() == nullptr) << parser.get_error();
+    return result;
+  }
+
+  T back() const {
+    return get(size() - 1);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, size());
+  }
+
+  vector<T> parse_all() const {
+    vector<T> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+      result.push_back(get(i));
+    }
+    return result;
+  }
+
+  size_t get_memory_usage() const {
+    return data_.size() + element_ends_.capacity() * sizeof(uint32);
+  }
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    storer.store_binary(narrow_cast<int32>(size()));
+    storer.store_slice(data_.as_slice());
+  }
+
+ private:
+  BufferSlice data_;
+  vector<uint32> element_ends_;
+  ParseFunc parse_func_ = nullptr;
+};
+
+template <class Func>
+class TlFetchLazyVector {
+  using ValueT = decltype(Func::parse(std::declval<TlBufferParser &>()));
+
+  static ValueT parse_element(TlBufferParser &parser) {
+    return Func::parse(parser);
+  }
+
+ public:
+  // checks the elements, but keeps only their serialized representation
+  static TlLazyVector<ValueT> parse(TlBufferParser &parser) {
+    const uint32 multiplicity = parser.fetch_int();
+    if (parser.get_left_len() < multiplicity) {
+      parser.set_error("Wrong vector length");
+      return TlLazyVector<ValueT>();
+    }
+
+    auto begin_left_len = parser.get_left_len();
+    vector<uint32> element_ends;
+    element_ends.reserve(multiplicity);
+    for (uint32 i = 0; i < multiplicity; i++) {
+      Func::parse(parser);
+      if (parser.get_error() != nullptr) {
+        return TlLazyVector<ValueT>();
+      }
+      element_ends.push_back(narrow_cast<uint32>(begin_left_len - parser.get_left_len()));
+    }
+    return TlLazyVector<ValueT>(parser.get_fetched_buffer_slice(begin_left_len), std::move(element_ends),
+                                &parse_element);
+  }
+};
+
+template <class T>
+size_t tl_extra_memory_usage(const TlLazyVector<T> &vec) {
+  return vec.get_memory_usage();
+}
+
+class TlStoreLazyVector {
+ public:
+  template <class T, class StorerT>
+  static void store(const TlLazyVector<T> &vec, StorerT &storer) {
+    vec.store(storer);
+  }
+};
+
+}  // namespace td
@@ -19,6 +19,8 @@
 
 namespace td {
 
+class TlStorerBuffer;
+
 class TlStorerCalcLength;
 
 class TlStorerUnsafe;
@@ -49,6 +51,13 @@ class TlObject {
   virtual void store(TlStorerCalcLength &s) const {
   }
 
+  /**
+   * Appends the object to the storer serializing object, a growable buffer.
+   * \param[in] s Storer to which the object will be appended.
+   */
+  virtual void store(TlStorerBuffer &s) const {
+  }
+
   /**
    * Helper function for the to_string method. Appends a string representation of the object to the storer.
    * \param[in] s Storer to which the object string representation will be appended.
@@ -56,6 +65,11 @@ class TlObject {
    */
   virtual void store(TlStorerToString &s, const char *field_name) const = 0;
 
+  /**
+   * Returns approximate size of the memory used by the object, including all its fields and owned subobjects.
+   */
+  virtual std::size_t approximate_memory_usage() const = 0;
+
   /**
    * Default constructor.
    */
@@ -85,6 +99,20 @@ class TlObject {
    * Virtual destructor.
    */
   virtual ~TlObject() = default;
+
+#if TD_TL_OBJECT_ARENA
+  /**
+   * Allocates memory for a TL-object, using the arena of the current TlObjectArenaScope if there is one.
+   * \param[in] size Size of the object.
+   */
+  static void *operator new(std::size_t size);
+
+  /**
+   * Deallocates memory of a TL-object, allocated by TlObject::operator new.
+   * \param[in] ptr Pointer to the object memory.
+   */
+  static void operator delete(void *ptr) noexcept;
+#endif
 };
 
 /// @cond UNDOCUMENTED
@@ -0,0 +1,135 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/tl/TlObjectArena.h"
+
+#include "td/tl/TlObject.h"
+
+#if TD_TL_OBJECT_ARENA
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace td {
+
+namespace {
+
+constexpr std::size_t TL_OBJECT_ALIGNMENT = alignof(std::max_align_t);
+
+constexpr std::size_t align_size(std::size_t size) {
+  return (size + TL_OBJECT_ALIGNMENT - 1) & ~(TL_OBJECT_ALIGNMENT - 1);
+}
+
+// memory of the arena is released when the scope and all objects allocated in it are destroyed
+class TlObjectArena {
+ public:
+  TlObjectArena() = default;
+  TlObjectArena(const TlObjectArena &) = delete;
+  TlObjectArena &operator=(const TlObjectArena &) = delete;
+  TlObjectArena(TlObjectArena &&) = delete;
+  TlObjectArena &operator=(TlObjectArena &&) = delete;
+
+  static constexpr std::size_t MAX_OBJECT_SIZE = 1 << 10;
+
+  // must be called only from the thread, which owns the arena scope
+  void *allocate(std::size_t size) {
+    if (static_cast<std::size_t>(end_ - begin_) < size) {
+      auto chunk = static_cast<Chunk *>(::operator new(CHUNK_SIZE));
+      chunk->next_ = last_chunk_;
+      last_chunk_ = chunk;
+      begin_ = reinterpret_cast<char *>(chunk) + CHUNK_HEADER_SIZE;
+      end_ = reinterpret_cast<char *>(chunk) + CHUNK_SIZE;
+    }
+    auto result = begin_;
+    begin_ += size;
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return result;
+  }
+
+  void release() noexcept {
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+ private:
+  struct Chunk {
+    Chunk *next_;
+  };
+  static constexpr std::size_t CHUNK_SIZE = 1 << 14;
+  static constexpr std::size_t CHUNK_HEADER_SIZE = align_size(sizeof(Chunk));
+
+  Chunk *last_chunk_ = nullptr;
+  char *begin_ = nullptr;
+  char *end_ = nullptr;
+  std::atomic<std::size_t> ref_count_{1};  // the scope holds a reference to the arena
+
+  ~TlObjectArena() {
+    while (last_chunk_ != nullptr) {
+      auto next = last_chunk_->next_;
+      ::operator delete(last_chunk_);
+      last_chunk_ = next;
+    }
+  }
+};
+
+struct alignas(std::max_align_t) TlObjectHeader {
+  TlObjectArena *arena_;  // nullptr for objects allocated from the heap
+};
+
+static_assert(sizeof(TlObjectHeader) == TL_OBJECT_ALIGNMENT, "Unexpected TlObjectHeader size");
+
+thread_local TlObjectArena *current_arena = nullptr;
+
+}  // namespace
+
+TlObjectArenaScope::TlObjectArenaScope() {
+  if (current_arena == nullptr) {
+    current_arena = new TlObjectArena();
+    is_active_ = true;
+  }
+}
+
+TlObjectArenaScope::~TlObjectArenaScope() {
+  if (is_active_) {
+    auto arena = current_arena;
+    current_arena = nullptr;
+    arena->release();
+  }
+}
+
+void *TlObject::operator new(std::size_t size) {
+  size = sizeof(TlObjectHeader) + align_size(size);
+  auto arena = current_arena;
+  void *ptr;
+  if (arena != nullptr && size <= TlObjectArena::MAX_OBJECT_SIZE) {
+    ptr = arena->allocate(size);
+  } else {
+    arena = nullptr;
+    ptr = ::operator new(size);
+  }
+  auto header = new (ptr) TlObjectHeader();
+  header->arena_ = arena;
+  return header + 1;
+}
+
+void TlObject::operator delete(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto header = static_cast<TlObjectHeader *>(ptr) - 1;
+  auto arena = header->arena_;
+  if (arena == nullptr) {
+    ::operator delete(header);
+  } else {
+    arena->release();
+  }
+}
+
+}  // namespace td
+
+#endif
@@ -0,0 +1,45 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+/**
+ * \file
+ * Contains the declaration of a scope, in which TL-objects are allocated from a common arena
+ */
+
+namespace td {
+
+/**
+ * While an instance of this class exists, all TL-objects created by the current thread are allocated from a common
+ * bump arena, whose memory is released at once after the scope and all objects allocated in it are destroyed.
+ * The objects can be destroyed from any thread. Nested scopes have no effect.
+ * The scope does nothing unless TDLib is built with TD_ENABLE_TL_OBJECT_ARENA.
+ */
+class TlObjectArenaScope {
+ public:
+#if TD_TL_OBJECT_ARENA
+  TlObjectArenaScope();
+  ~TlObjectArenaScope();
+#else
+  TlObjectArenaScope() {
+  }
+  ~TlObjectArenaScope() {
+  }
+#endif
+
+  TlObjectArenaScope(const TlObjectArenaScope &) = delete;
+  TlObjectArenaScope &operator=(const TlObjectArenaScope &) = delete;
+  TlObjectArenaScope(TlObjectArenaScope &&) = delete;
+  TlObjectArenaScope &operator=(TlObjectArenaScope &&) = delete;
+
+#if TD_TL_OBJECT_ARENA
+ private:
+  bool is_active_ = false;
+#endif
+};
+
+}  // namespace td
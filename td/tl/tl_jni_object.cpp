@@ -26,6 +26,8 @@ static jclass LongClass;
 static jclass DoubleClass;
 static jclass StringClass;
 static jclass ObjectClass;
+static jstring EmptyString;       // global reference to the shared empty string
+static jbyteArray EmptyByteArray;  // global reference to the shared empty byte array
 jclass ArrayKeyboardButtonClass;
 jclass ArrayInlineKeyboardButtonClass;
 jclass ArrayPageBlockTableCellClass;
@@ -112,6 +114,17 @@ void init_vars(JNIEnv *env, const char *td_api_java_package) {
   ArrayPageBlockTableCellClass =
       get_jclass(env, (PSLICE() << "[L" << td_api_java_package << "/TdApi$PageBlockTableCell;").c_str());
   GetConstructorID = get_method_id(env, ObjectClass, "getConstructor", "()I");
+
+  // empty strings and byte arrays are immutable, so a single instance of them can be shared by all objects
+  jstring empty_string = env->NewStringUTF("");
+  EmptyString = static_cast<jstring>(env->NewGlobalRef(empty_string));
+  env->DeleteLocalRef(empty_string);
+  jbyteArray empty_byte_array = env->NewByteArray(0);
+  EmptyByteArray = static_cast<jbyteArray>(env->NewGlobalRef(empty_byte_array));
+  env->DeleteLocalRef(empty_byte_array);
+  if (EmptyString == nullptr || EmptyByteArray == nullptr) {
+    fatal_error(env, "Can't create empty string and byte array");
+  }
   BooleanGetValueMethodID = get_method_id(env, BooleanClass, "booleanValue", "()Z");
   IntegerGetValueMethodID = get_method_id(env, IntegerClass, "intValue", "()I");
   LongGetValueMethodID = get_method_id(env, LongClass, "longValue", "()J");
@@ -231,6 +244,9 @@ std::string from_jstring(JNIEnv *env, jstring s) {
 }
 
 jstring to_jstring(JNIEnv *env, const std::string &s) {
+  if (s.empty()) {
+    return static_cast<jstring>(env->NewLocalRef(EmptyString));
+  }
   jsize surrogates = 0;
   jsize unicode_len = get_utf16_from_utf8_length(s.c_str(), s.size(), &surrogates);
   if (surrogates == 0) {
@@ -264,6 +280,9 @@ std::string from_bytes(JNIEnv *env, jbyteArray arr) {
 
 jbyteArray to_bytes(JNIEnv *env, const std::string &b) {
   static_assert(sizeof(char) == sizeof(jbyte), "Mismatched jbyte size");
+  if (b.empty()) {
+    return static_cast<jbyteArray>(env->NewLocalRef(EmptyByteArray));
+  }
   auto length = narrow_cast<jsize>(b.size());
   jbyteArray arr = env->NewByteArray(length);
   if (arr != nullptr && length != 0) {
@@ -272,6 +291,30 @@ jbyteArray to_bytes(JNIEnv *env, const std::string &b) {
   return arr;
 }
 
+void store_string(JNIEnv *env, jobject o, jfieldID id, const std::string &s) {
+  if (s.empty()) {
+    env->SetObjectField(o, id, EmptyString);
+    return;
+  }
+  jstring str = to_jstring(env, s);
+  if (str) {
+    env->SetObjectField(o, id, str);
+    env->DeleteLocalRef(str);
+  }
+}
+
+void store_bytes(JNIEnv *env, jobject o, jfieldID id, const std::string &b) {
+  if (b.empty()) {
+    env->SetObjectField(o, id, EmptyByteArray);
+    return;
+  }
+  jbyteArray bytes = to_bytes(env, b);
+  if (bytes) {
+    env->SetObjectField(o, id, bytes);
+    env->DeleteLocalRef(bytes);
+  }
+}
+
 jintArray store_vector(JNIEnv *env, const std::vector<std::int32_t> &v) {
   static_assert(sizeof(std::int32_t) == sizeof(jint), "Mismatched jint size");
   auto length = narrow_cast<jsize>(v.size());
@@ -307,6 +350,10 @@ jobjectArray store_vector(JNIEnv *env, const std::vector<std::string> &v) {
   jobjectArray arr = env->NewObjectArray(length, StringClass, 0);
   if (arr != nullptr) {
     for (jsize i = 0; i < length; i++) {
+      if (v[i].empty()) {
+        env->SetObjectArrayElement(arr, i, EmptyString);
+        continue;
+      }
       jstring str = to_jstring(env, v[i]);
       if (str) {
         env->SetObjectArrayElement(arr, i, str);
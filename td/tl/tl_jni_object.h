@@ -95,6 +95,12 @@ std::string from_bytes(JNIEnv *env, jbyteArray arr);
 
 jbyteArray to_bytes(JNIEnv *env, const std::string &b);
 
+// stores the string to the object field; empty strings are stored without creation of new Java objects
+void store_string(JNIEnv *env, jobject o, jfieldID id, const std::string &s);
+
+// stores the bytes to the object field; empty byte arrays are stored without creation of new Java objects
+void store_bytes(JNIEnv *env, jobject o, jfieldID id, const std::string &b);
+
 void init_vars(JNIEnv *env, const char *td_api_java_package);
 
 jintArray store_vector(JNIEnv *env, const std::vector<std::int32_t> &v);
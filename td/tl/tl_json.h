@@ -13,6 +13,7 @@
 #include "td/utils/format.h"
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/misc.h"
+#include "td/utils/Parser.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
@@ -199,4 +200,211 @@ std::enable_if_t<std::is_constructible<T>::value, Status> from_json(tl_object_pt
   return from_json(*to, from.get_object());
 }
 
+// parsing of JSON directly to TL objects without creation of an intermediate JsonValue tree
+// values of unexpected types are parsed through JsonValue to get the same results and errors
+
+inline Status from_json(int32 &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json(to, std::move(value));
+}
+
+inline Status from_json(bool &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json(to, std::move(value));
+}
+
+inline Status from_json(int64 &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json(to, std::move(value));
+}
+
+inline Status from_json(double &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json(to, std::move(value));
+}
+
+inline Status from_json(string &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json(to, std::move(value));
+}
+
+inline Status from_json_bytes(string &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json_bytes(to, std::move(value));
+}
+
+template <class T>
+Status from_json(std::vector<T> &to, Parser &parser, int32 max_depth) {
+  parser.skip_whitespaces();
+  if (max_depth < 0 || parser.peek_char() != '[') {
+    TRY_RESULT(value, do_json_decode(parser, max_depth));
+    return from_json(to, std::move(value));
+  }
+
+  parser.skip('[');
+  parser.skip_whitespaces();
+  to.clear();
+  if (parser.try_skip(']')) {
+    return Status::OK();
+  }
+  while (true) {
+    if (parser.empty()) {
+      return Status::Error("Unexpected string end");
+    }
+    to.emplace_back();
+    TRY_STATUS(from_json(to.back(), parser, max_depth - 1));
+
+    parser.skip_whitespaces();
+    if (parser.try_skip(']')) {
+      return Status::OK();
+    }
+    if (!parser.try_skip(',')) {
+      return Status::Error(parser.empty() ? Slice("Unexpected string end")
+                                          : Slice("Unexpected symbol while parsing JSON Array"));
+    }
+    parser.skip_whitespaces();
+  }
+}
+
+// parses the remaining fields of a JSON object, starting after the opening brace or after a field value
+template <class F>
+Status json_parse_object_fields(Parser &parser, bool is_after_value, const F &parse_field) {
+  parser.skip_whitespaces();
+  if (parser.try_skip('}')) {
+    return Status::OK();
+  }
+  if (is_after_value && !parser.try_skip(',')) {
+    return Status::Error(parser.empty() ? Slice("Unexpected string end")
+                                        : Slice("Unexpected symbol while parsing JSON Object"));
+  }
+  while (true) {
+    parser.skip_whitespaces();
+    if (parser.empty()) {
+      return Status::Error("Unexpected string end");
+    }
+    TRY_RESULT(field, json_string_decode(parser));
+    parser.skip_whitespaces();
+    if (!parser.try_skip(':')) {
+      return Status::Error("':' expected");
+    }
+    TRY_STATUS(parse_field(field));
+
+    parser.skip_whitespaces();
+    if (parser.try_skip('}')) {
+      return Status::OK();
+    }
+    if (!parser.try_skip(',')) {
+      return Status::Error(parser.empty() ? Slice("Unexpected string end")
+                                          : Slice("Unexpected symbol while parsing JSON Object"));
+    }
+  }
+}
+
+inline Result<double> get_json_request_timeout(const JsonValue &value) {
+  if (value.type() != JsonValue::Type::Number) {
+    return Status::Error(PSLICE() << "Expected Number as \"@timeout\", but receive " << value.type());
+  }
+  auto timeout = to_double(value.get_number());
+  if (!(timeout >= 0.0)) {
+    return Status::Error("Field \"@timeout\" must be non-negative");
+  }
+  return timeout;
+}
+
+template <class T>
+Status from_json_polymorphic(tl_object_ptr<T> &to, Parser &parser, int32 max_depth, string *extra, double *timeout) {
+  parser.skip_whitespaces();
+  if (max_depth >= 0 && parser.peek_char() == '{') {
+    // the object can be parsed directly only if its type is known before other fields
+    Parser lookahead(parser.data());
+    lookahead.skip('{');
+    lookahead.skip_whitespaces();
+    if (lookahead.try_skip(Slice("\"@type\""))) {
+      lookahead.skip_whitespaces();
+      if (lookahead.try_skip(':')) {
+        parser.advance(lookahead.ptr() - parser.ptr());
+        TRY_RESULT(constructor_value, do_json_decode(parser, max_depth - 1));
+        int32 constructor = 0;
+        if (constructor_value.type() == JsonValue::Type::Number) {
+          constructor = to_integer<int32>(constructor_value.get_number());
+        } else if (constructor_value.type() == JsonValue::Type::String) {
+          TRY_RESULT_ASSIGN(constructor, tl_constructor_from_string(to.get(), constructor_value.get_string().str()));
+        } else {
+          return Status::Error(PSLICE() << "Expected String or Integer, but receive " << constructor_value.type());
+        }
+
+        TlDowncastHelper<T> helper(constructor);
+        Status status;
+        bool ok = downcast_call(static_cast<T &>(helper), [&](auto &dummy) {
+          auto result = make_tl_object<std::decay_t<decltype(dummy)>>();
+          status = json_parse_object_fields(parser, true, [&](MutableSlice field) {
+            if (extra != nullptr && field == "@extra") {
+              TRY_RESULT(extra_value, do_json_decode(parser, max_depth - 1));
+              *extra = json_encode<string>(extra_value);
+              return Status::OK();
+            }
+            if (timeout != nullptr && field == "@timeout") {
+              TRY_RESULT(timeout_value, do_json_decode(parser, max_depth - 1));
+              TRY_RESULT_ASSIGN(*timeout, get_json_request_timeout(timeout_value));
+              return Status::OK();
+            }
+            return from_json_field(*result, field, parser, max_depth - 1);
+          });
+          to = std::move(result);
+        });
+        TRY_STATUS(std::move(status));
+        if (!ok) {
+          return Status::Error(PSLICE() << "Unknown constructor " << format::as_hex(constructor));
+        }
+        return Status::OK();
+      }
+    }
+  }
+
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  if (extra != nullptr && value.type() == JsonValue::Type::Object && value.get_object().has_field("@extra")) {
+    *extra = json_encode<string>(value.get_object().extract_field("@extra"));
+  }
+  if (timeout != nullptr && value.type() == JsonValue::Type::Object && value.get_object().has_field("@timeout")) {
+    TRY_RESULT_ASSIGN(*timeout, get_json_request_timeout(value.get_object().extract_field("@timeout")));
+  }
+  return from_json(to, std::move(value));
+}
+
+template <class T>
+std::enable_if_t<!std::is_constructible<T>::value, Status> from_json(tl_object_ptr<T> &to, Parser &parser,
+                                                                     int32 max_depth) {
+  return from_json_polymorphic(to, parser, max_depth, nullptr, nullptr);
+}
+
+template <class T>
+std::enable_if_t<std::is_constructible<T>::value, Status> from_json(tl_object_ptr<T> &to, Parser &parser,
+                                                                    int32 max_depth) {
+  parser.skip_whitespaces();
+  if (max_depth < 0 || parser.peek_char() != '{') {
+    TRY_RESULT(value, do_json_decode(parser, max_depth));
+    return from_json(to, std::move(value));
+  }
+
+  parser.skip('{');
+  to = make_tl_object<T>();
+  return json_parse_object_fields(
+      parser, false, [&](MutableSlice field) { return from_json_field(*to, field, parser, max_depth - 1); });
+}
+
+// parses a JSON-serialized object of a polymorphic type; the JSON is modified in place
+// the serialized value of the field "@extra" of the object is returned in extra, if it isn't nullptr
+// the value of the field "@timeout" of the object is returned in timeout, if it isn't nullptr
+template <class T>
+Status from_json(tl_object_ptr<T> &to, MutableSlice json, string *extra, double *timeout = nullptr) {
+  Parser parser(json);
+  const int32 DEFAULT_MAX_DEPTH = 100;
+  TRY_STATUS(from_json_polymorphic(to, parser, DEFAULT_MAX_DEPTH, extra, timeout));
+  parser.skip_whitespaces();
+  if (!parser.empty()) {
+    return Status::Error("Expected string end");
+  }
+  return Status::OK();
+}
+
 }  // namespace td
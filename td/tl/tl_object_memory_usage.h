@@ -0,0 +1,53 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/tl/TlObject.h"
+
+#include "td/utils/buffer.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace td {
+
+// returns approximate size of the memory owned by a field of a TL-object in addition to sizeof of the field itself
+
+template <class T>
+std::size_t tl_extra_memory_usage(const T &value) {
+  return 0;
+}
+
+inline std::size_t tl_extra_memory_usage(const std::string &value) {
+  auto begin = reinterpret_cast<const char *>(&value);
+  if (begin <= value.data() && value.data() < begin + sizeof(value)) {
+    // short string optimization
+    return 0;
+  }
+  return value.capacity() + 1;
+}
+
+inline std::size_t tl_extra_memory_usage(const BufferSlice &value) {
+  return value.size();
+}
+
+template <class T>
+std::size_t tl_extra_memory_usage(const tl_object_ptr<T> &value) {
+  return value == nullptr ? 0 : value->approximate_memory_usage();
+}
+
+template <class T>
+std::size_t tl_extra_memory_usage(const std::vector<T> &value) {
+  std::size_t result = value.capacity() * sizeof(T);
+  for (auto &element : value) {
+    result += tl_extra_memory_usage(element);
+  }
+  return result;
+}
+
+}  // namespace td
@@ -32,6 +32,21 @@ class TlFetchBoxed {
   }
 };
 
+template <class Func>
+class TlFetchNullable {
+ public:
+  template <class ParserT>
+  static auto parse(ParserT &parser) -> decltype(Func::parse(parser)) {
+    constexpr std::int32_t ID_NULL = 0x56730bcc;
+
+    if (parser.can_prefetch_int() && parser.prefetch_int_unsafe() == ID_NULL) {
+      parser.fetch_int_unsafe();
+      return decltype(Func::parse(parser))();
+    }
+    return Func::parse(parser);
+  }
+};
+
 class TlFetchBool {
  public:
   template <class ParserT>
@@ -108,6 +123,15 @@ class TlFetchBytes {
   }
 };
 
+template <class T>
+class TlFetchStringView {
+ public:
+  template <class ParserT>
+  static T parse(ParserT &parser) {
+    return parser.fetch_string_view();
+  }
+};
+
 template <class Func>
 class TlFetchVector {
  public:
@@ -7,7 +7,7 @@
 #include "td/actor/ConcurrentScheduler.h"
 
 #include "td/utils/ExitGuard.h"
-#include "td/utils/MpscPollableQueue.h"
+#include "td/utils/MpscPollableLinkQueue.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/ScopeGuard.h"
 
@@ -20,10 +20,10 @@ ConcurrentScheduler::ConcurrentScheduler(int32 additional_thread_count, uint64 t
   additional_thread_count = 0;
 #endif
   additional_thread_count++;
-  std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound(additional_thread_count);
+  std::vector<std::shared_ptr<MpscPollableLinkQueue<EventFull>>> outbound(additional_thread_count);
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   for (int32 i = 0; i < additional_thread_count; i++) {
-    auto queue = std::make_shared<MpscPollableQueue<EventFull>>();
+    auto queue = std::make_shared<MpscPollableLinkQueue<EventFull>>();
     queue->init();
     outbound[i] = queue;
   }
@@ -45,7 +45,7 @@ ConcurrentScheduler::ConcurrentScheduler(int32 additional_thread_count, uint64 t
 
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
     if (i >= additional_thread_count) {
-      auto queue = std::make_shared<MpscPollableQueue<EventFull>>();
+      auto queue = std::make_shared<MpscPollableLinkQueue<EventFull>>();
       queue->init();
       outbound.push_back(std::move(queue));
     }
@@ -62,6 +62,21 @@ ConcurrentScheduler::ConcurrentScheduler(int32 additional_thread_count, uint64 t
   state_ = State::Start;
 }
 
+void ConcurrentScheduler::enable_work_stealing() {
+  CHECK(state_ == State::Start);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  // the extra scheduler has no thread and can't execute stolen actors
+  auto worker_count = schedulers_.size() - extra_scheduler_;
+  if (worker_count <= 1) {
+    return;
+  }
+  auto states = std::make_shared<std::vector<Scheduler::WorkStealingState>>(worker_count);
+  for (size_t i = 0; i < worker_count; i++) {
+    schedulers_[i]->enable_work_stealing(states);
+  }
+#endif
+}
+
 void ConcurrentScheduler::test_one_thread_run() {
   do {
     for (auto &sched : schedulers_) {
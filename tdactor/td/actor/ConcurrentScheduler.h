@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/actor/actor.h"
+#include "td/actor/impl/ActorProfiler.h"
 
 #include "td/utils/common.h"
 #include "td/utils/port/thread.h"
@@ -44,6 +45,47 @@ class ConcurrentScheduler final : private Scheduler::Callback {
     return schedulers_.back()->get_const_guard();
   }
 
+  // allows idle schedulers to take migratable actors from busy ones
+  // must be called before start()
+  void enable_work_stealing();
+
+  Scheduler::OutboundEventStats get_outbound_event_stats(int32 sched_id) const {
+    CHECK(0 <= sched_id && sched_id < static_cast<int32>(schedulers_.size()));
+    return schedulers_[sched_id]->get_outbound_event_stats();
+  }
+
+  // makes all schedulers spin for up to max_busy_poll_time seconds before sleeping in poll
+  // must be called before start()
+  void set_busy_poll_time(double max_busy_poll_time) {
+    CHECK(state_ == State::Start);
+    for (auto &scheduler : schedulers_) {
+      scheduler->set_busy_poll_time(max_busy_poll_time);
+    }
+  }
+
+  Scheduler::BusyPollStats get_busy_poll_stats(int32 sched_id) const {
+    CHECK(0 <= sched_id && sched_id < static_cast<int32>(schedulers_.size()));
+    return schedulers_[sched_id]->get_busy_poll_stats();
+  }
+
+  // returns total busy time of all schedulers in seconds
+  double get_busy_time() const {
+    double result = 0.0;
+    for (auto &scheduler : schedulers_) {
+      result += scheduler->get_busy_time();
+    }
+    return result;
+  }
+
+  // enables accounting of run time and mailbox sizes of newly created actors
+  static void enable_actor_profiling(bool is_enabled) {
+    ActorProfiler::set_enabled(is_enabled);
+  }
+
+  static string get_hottest_actors_string(size_t max_count) {
+    return ActorProfiler::get_top_actors_string(max_count);
+  }
+
   void test_one_thread_run();
 
   bool is_finished() const {
@@ -11,86 +11,89 @@
 namespace td {
 
 bool MultiTimeout::has_timeout(int64 key) const {
-  return items_.count(Item(key)) > 0;
+  return items_.count(key) > 0;
 }
 
 void MultiTimeout::set_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Set " << get_name() << " for " << key << " in " << timeout - Time::now();
-  auto item = items_.emplace(key);
-  auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
+  if (timeout_queue_.empty()) {
+    timeout_queue_.advance(Time::now_cached());
+  }
+  auto item = items_.emplace(key, Item(key));
+  auto timer_node = static_cast<TimerWheelNode *>(&item.first->second);
+  if (timer_node->in_timer_wheel()) {
     CHECK(!item.second);
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.fix(timeout, heap_node);
-    if (need_update_timeout || heap_node->is_top()) {
-      update_timeout("set_timeout");
-    }
+    timeout_queue_.fix(timeout, timer_node);
   } else {
     CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("set_timeout 2");
-    }
+    timeout_queue_.insert(timeout, timer_node);
   }
+  on_timeout_added(timeout, "set_timeout");
 }
 
 void MultiTimeout::add_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Add " << get_name() << " for " << key << " in " << timeout - Time::now();
-  auto item = items_.emplace(key);
-  auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
+  if (timeout_queue_.empty()) {
+    timeout_queue_.advance(Time::now_cached());
+  }
+  auto item = items_.emplace(key, Item(key));
+  auto timer_node = static_cast<TimerWheelNode *>(&item.first->second);
+  if (timer_node->in_timer_wheel()) {
     CHECK(!item.second);
   } else {
     CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("add_timeout");
-    }
+    timeout_queue_.insert(timeout, timer_node);
+    on_timeout_added(timeout, "add_timeout");
   }
 }
 
 void MultiTimeout::cancel_timeout(int64 key, const char *source) {
   LOG(DEBUG) << "Cancel " << get_name() << " for " << key;
-  auto item = items_.find(Item(key));
+  auto item = items_.find(key);
   if (item != items_.end()) {
-    auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item));
-    CHECK(heap_node->in_heap());
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.erase(heap_node);
+    auto timer_node = static_cast<TimerWheelNode *>(&item->second);
+    CHECK(timer_node->in_timer_wheel());
+    timeout_queue_.erase(timer_node);
     items_.erase(item);
 
-    if (need_update_timeout) {
+    // the actor timeout isn't moved forward; a spurious wakeup just reschedules it
+    if (items_.empty()) {
       update_timeout(source);
     }
   }
 }
 
+void MultiTimeout::on_timeout_added(double timeout, const char *source) {
+  // the actor timeout needs to be changed only if the new timeout is earlier than the scheduled one
+  if (!Actor::has_timeout() || timeout - Time::now_cached() < Actor::get_timeout()) {
+    update_timeout(source);
+  }
+}
+
 void MultiTimeout::update_timeout(const char *source) {
   if (items_.empty()) {
     LOG(DEBUG) << "Cancel timeout of " << get_name();
     LOG_CHECK(timeout_queue_.empty()) << get_name() << ' ' << source;
-    if (!Actor::has_timeout()) {
-      bool has_pending_timeout = false;
-      for (auto &event : get_info()->mailbox_) {
-        if (event.type == Event::Type::Timeout) {
-          has_pending_timeout = true;
-        }
-      }
-      LOG_CHECK(has_pending_timeout) << get_name() << ' ' << get_info()->mailbox_.size() << ' ' << source;
-    } else {
+    if (Actor::has_timeout()) {
       Actor::cancel_timeout();
     }
   } else {
-    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << timeout_queue_.top_key() - Time::now_cached();
-    Actor::set_timeout_at(timeout_queue_.top_key());
+    auto wakeup_time = timeout_queue_.get_wakeup_time();
+    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << wakeup_time - Time::now_cached();
+    if (is_lazy_) {
+      Actor::set_lazy_timeout_at(wakeup_time);
+    } else {
+      Actor::set_timeout_at(wakeup_time);
+    }
   }
 }
 
 vector<int64> MultiTimeout::get_expired_keys(double now) {
   vector<int64> expired_keys;
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    int64 key = static_cast<Item *>(timeout_queue_.pop())->key;
-    items_.erase(Item(key));
+  timeout_queue_.advance(now);
+  while (auto timer_node = timeout_queue_.pop_expired()) {
+    int64 key = static_cast<Item *>(timer_node)->key;
+    items_.erase(key);
     expired_keys.push_back(key);
   }
   return expired_keys;
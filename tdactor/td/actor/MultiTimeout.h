@@ -9,25 +9,21 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
-#include "td/utils/Heap.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 
-#include <set>
+#include <unordered_map>
 
 namespace td {
 
-// TODO optimize
 class MultiTimeout final : public Actor {
-  struct Item final : public HeapNode {
+  struct Item final : public TimerWheelNode {
     int64 key;
 
     explicit Item(int64 key) : key(key) {
     }
-
-    bool operator<(const Item &other) const {
-      return key < other.key;
-    }
   };
 
  public:
@@ -44,6 +40,11 @@ class MultiTimeout final : public Actor {
     data_ = data;
   }
 
+  // allows the timeouts to be delayed by up to the scheduler timer slack
+  void set_lazy(bool is_lazy) {
+    is_lazy_ = is_lazy;
+  }
+
   bool has_timeout(int64 key) const;
 
   void set_timeout_in(int64 key, double timeout) {
@@ -67,12 +68,15 @@ class MultiTimeout final : public Actor {
 
   Callback callback_;
   Data data_;
+  bool is_lazy_ = false;
 
-  KHeap<double> timeout_queue_;
-  std::set<Item> items_;
+  TimerWheel timeout_queue_;
+  std::unordered_map<int64, Item, Hash<int64>> items_;
 
   void update_timeout(const char *source);
 
+  void on_timeout_added(double timeout, const char *source);
+
   void timeout_expired() final;
 
   vector<int64> get_expired_keys(double now);
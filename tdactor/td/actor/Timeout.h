@@ -39,6 +39,9 @@ class Timeout final : public Actor {
   void set_timeout_at(double timeout) {
     Actor::set_timeout_at(timeout);
   }
+  void set_lazy_timeout_in(double timeout) {
+    Actor::set_lazy_timeout_in(timeout);
+  }
   void cancel_timeout() {
     if (has_timeout()) {
       Actor::cancel_timeout();
@@ -71,10 +71,17 @@ class Actor : public ObserverBase {
   double get_timeout() const;
   void set_timeout_in(double timeout_in);
   void set_timeout_at(double timeout_at);
+  // the timeout can be delayed by up to the scheduler timer slack to expire together with timeouts of other actors
+  void set_lazy_timeout_in(double timeout_in);
+  void set_lazy_timeout_at(double timeout_at);
   void cancel_timeout();
   void migrate(int32 sched_id);
   void do_migrate(int32 sched_id);
 
+  // allows the actor to be moved to another scheduler by work stealing
+  // the actor must not depend on scheduler-local state, for example, must not own subscribed file descriptors
+  void set_migratable(bool is_migratable);
+
   uint64 get_link_token();
   std::weak_ptr<ActorContext> get_context_weak_ptr() const;
   std::shared_ptr<ActorContext> set_context(std::shared_ptr<ActorContext> context);
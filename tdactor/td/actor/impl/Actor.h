@@ -11,8 +11,10 @@
 #include "td/actor/impl/Scheduler-decl.h"
 
 #include "td/utils/common.h"
+#include "td/utils/misc.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Time.h"
 
 #include <memory>
 #include <type_traits>
@@ -52,7 +54,7 @@ inline void Actor::do_stop() {
   CHECK(empty());
 }
 inline bool Actor::has_timeout() const {
-  return get_info()->get_heap_node()->in_heap();
+  return get_info()->get_timer_wheel_node()->in_timer_wheel();
 }
 inline double Actor::get_timeout() const {
   return Scheduler::instance()->get_actor_timeout(this);
@@ -63,6 +65,12 @@ inline void Actor::set_timeout_in(double timeout_in) {
 inline void Actor::set_timeout_at(double timeout_at) {
   Scheduler::instance()->set_actor_timeout_at(this, timeout_at);
 }
+inline void Actor::set_lazy_timeout_in(double timeout_in) {
+  set_lazy_timeout_at(Time::now() + clamp(timeout_in, 0.0, 1e10));
+}
+inline void Actor::set_lazy_timeout_at(double timeout_at) {
+  Scheduler::instance()->set_actor_timeout_at(this, Scheduler::get_lazy_timeout_at(timeout_at));
+}
 inline void Actor::cancel_timeout() {
   Scheduler::instance()->cancel_actor_timeout(this);
 }
@@ -72,6 +80,9 @@ inline void Actor::migrate(int32 sched_id) {
 inline void Actor::do_migrate(int32 sched_id) {
   Scheduler::instance()->do_migrate_actor(this, sched_id);
 }
+inline void Actor::set_migratable(bool is_migratable) {
+  get_info()->set_migratable(is_migratable);
+}
 
 template <class ActorType>
 std::enable_if_t<std::is_base_of<Actor, ActorType>::value> start_migrate(ActorType &obj, int32 sched_id) {
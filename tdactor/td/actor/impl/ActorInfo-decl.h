@@ -7,14 +7,16 @@
 #pragma once
 
 #include "td/actor/impl/ActorId-decl.h"
+#include "td/actor/impl/ActorProfiler.h"
 #include "td/actor/impl/Event.h"
 
+#include "td/utils/AllocationTags.h"
 #include "td/utils/common.h"
-#include "td/utils/Heap.h"
 #include "td/utils/List.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/TimerWheel.h"
 
 #include <atomic>
 #include <memory>
@@ -49,7 +51,7 @@ class ActorContext {
 
 class ActorInfo final
     : private ListNode
-    , private HeapNode {
+    , private TimerWheelNode {
  public:
   enum class Deleter : uint8 { Destroy, None };
 
@@ -91,9 +93,9 @@ class ActorInfo final
   const ActorContext *get_context() const;
   CSlice get_name() const;
 
-  HeapNode *get_heap_node();
-  const HeapNode *get_heap_node() const;
-  static ActorInfo *from_heap_node(HeapNode *node);
+  TimerWheelNode *get_timer_wheel_node();
+  const TimerWheelNode *get_timer_wheel_node() const;
+  static ActorInfo *from_timer_wheel_node(TimerWheelNode *node);
 
   ListNode *get_list_node();
   const ListNode *get_list_node() const;
@@ -108,14 +110,25 @@ class ActorInfo final
   bool need_context() const;
   bool need_start_up() const;
 
+  void set_migratable(bool is_migratable);
+  bool is_migratable() const;
+
+  ActorProfiler::Counters *get_profiler_counters() const;
+  double mailbox_wait_start_ = 0.0;  // used only if profiler counters are non-null
+
+  int32 get_allocation_tag_id() const;
+
  private:
   Deleter deleter_ = Deleter::None;
   bool need_context_ = true;
   bool need_start_up_ = true;
   bool is_running_ = false;
+  bool is_migratable_ = false;
 
   std::atomic<int32> sched_id_{0};
   Actor *actor_ = nullptr;
+  ActorProfiler::Counters *profiler_counters_ = nullptr;
+  int32 allocation_tag_id_ = AllocationTags::UNTAGGED;
 
 #ifdef TD_DEBUG
   string name_;
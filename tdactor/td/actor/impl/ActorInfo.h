@@ -8,15 +8,17 @@
 
 #include "td/actor/impl/Actor-decl.h"
 #include "td/actor/impl/ActorInfo-decl.h"
+#include "td/actor/impl/ActorProfiler.h"
 #include "td/actor/impl/Scheduler-decl.h"
 
+#include "td/utils/AllocationTags.h"
 #include "td/utils/common.h"
-#include "td/utils/Heap.h"
 #include "td/utils/List.h"
 #include "td/utils/logging.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/TimerWheel.h"
 
 #include <atomic>
 #include <memory>
@@ -50,6 +52,10 @@ inline void ActorInfo::init(int32 sched_id, Slice name, ObjectPool<ActorInfo>::O
   need_context_ = need_context;
   need_start_up_ = need_start_up;
   is_running_ = false;
+  is_migratable_ = false;
+  profiler_counters_ = ActorProfiler::is_enabled() ? ActorProfiler::get_counters(name) : nullptr;
+  allocation_tag_id_ = AllocationTags::is_enabled() ? AllocationTags::get_tag_id(name) : AllocationTags::UNTAGGED;
+  mailbox_wait_start_ = 0.0;
 }
 
 inline bool ActorInfo::need_context() const {
@@ -60,6 +66,22 @@ inline bool ActorInfo::need_start_up() const {
   return need_start_up_;
 }
 
+inline void ActorInfo::set_migratable(bool is_migratable) {
+  is_migratable_ = is_migratable;
+}
+
+inline bool ActorInfo::is_migratable() const {
+  return is_migratable_;
+}
+
+inline ActorProfiler::Counters *ActorInfo::get_profiler_counters() const {
+  return profiler_counters_;
+}
+
+inline int32 ActorInfo::get_allocation_tag_id() const {
+  return allocation_tag_id_;
+}
+
 inline void ActorInfo::on_actor_moved(Actor *actor_new_ptr) {
   actor_ = actor_new_ptr;
 }
@@ -187,13 +209,13 @@ inline bool ActorInfo::is_running() const {
   return is_running_;
 }
 
-inline HeapNode *ActorInfo::get_heap_node() {
+inline TimerWheelNode *ActorInfo::get_timer_wheel_node() {
   return this;
 }
-inline const HeapNode *ActorInfo::get_heap_node() const {
+inline const TimerWheelNode *ActorInfo::get_timer_wheel_node() const {
   return this;
 }
-inline ActorInfo *ActorInfo::from_heap_node(HeapNode *node) {
+inline ActorInfo *ActorInfo::from_timer_wheel_node(TimerWheelNode *node) {
   return static_cast<ActorInfo *>(node);
 }
 inline ListNode *ActorInfo::get_list_node() {
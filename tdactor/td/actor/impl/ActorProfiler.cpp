@@ -0,0 +1,94 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/actor/impl/ActorProfiler.h"
+
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/Mutex.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <algorithm>
+
+namespace td {
+
+std::atomic<bool> ActorProfiler::is_enabled_{false};
+
+static Mutex actor_profiler_mutex;
+
+static FlatHashMap<string, unique_ptr<ActorProfiler::Counters>> &get_actor_profiler_counters() {
+  static FlatHashMap<string, unique_ptr<ActorProfiler::Counters>> counters;
+  return counters;
+}
+
+void ActorProfiler::set_enabled(bool is_enabled) {
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+ActorProfiler::Counters *ActorProfiler::get_counters(Slice name) {
+  auto lock = actor_profiler_mutex.lock();
+  auto &counters = get_actor_profiler_counters()[name.empty() ? string("<unnamed>") : name.str()];
+  if (counters == nullptr) {
+    // counters are never deleted, because they can be used by alive actors
+    counters = make_unique<Counters>();
+  }
+  counters->actor_count.fetch_add(1, std::memory_order_relaxed);
+  return counters.get();
+}
+
+vector<ActorProfiler::Stats> ActorProfiler::get_top_actors(size_t max_count) {
+  vector<Stats> result;
+  {
+    auto lock = actor_profiler_mutex.lock();
+    for (auto &it : get_actor_profiler_counters()) {
+      auto &counters = *it.second;
+      Stats stats;
+      stats.name = it.first;
+      stats.actor_count = counters.actor_count.load(std::memory_order_relaxed);
+      stats.event_count = counters.event_count.load(std::memory_order_relaxed);
+      stats.total_time = static_cast<double>(counters.total_time_ns.load(std::memory_order_relaxed)) * 1e-9;
+      stats.max_time = static_cast<double>(counters.max_time_ns.load(std::memory_order_relaxed)) * 1e-9;
+      stats.max_mailbox_size = counters.max_mailbox_size.load(std::memory_order_relaxed);
+      stats.max_queue_wait = static_cast<double>(counters.max_queue_wait_ns.load(std::memory_order_relaxed)) * 1e-9;
+      result.push_back(std::move(stats));
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Stats &lhs, const Stats &rhs) {
+    if (lhs.total_time != rhs.total_time) {
+      return lhs.total_time > rhs.total_time;
+    }
+    return lhs.name < rhs.name;
+  });
+  if (result.size() > max_count) {
+    result.resize(max_count);
+  }
+  return result;
+}
+
+string ActorProfiler::get_top_actors_string(size_t max_count) {
+  auto top_actors = get_top_actors(max_count);
+  string result;
+  for (auto &stats : top_actors) {
+    result += PSTRING() << stats.name << ": actors = " << stats.actor_count << ", events = " << stats.event_count
+                        << ", total time = " << stats.total_time << "s, max event time = " << stats.max_time * 1e3
+                        << "ms, max mailbox size = " << stats.max_mailbox_size
+                        << ", max queue wait = " << stats.max_queue_wait * 1e3 << "ms\n";
+  }
+  return result;
+}
+
+void ActorProfiler::clear() {
+  auto lock = actor_profiler_mutex.lock();
+  for (auto &it : get_actor_profiler_counters()) {
+    auto &counters = *it.second;
+    counters.event_count.store(0, std::memory_order_relaxed);
+    counters.total_time_ns.store(0, std::memory_order_relaxed);
+    counters.max_time_ns.store(0, std::memory_order_relaxed);
+    counters.max_mailbox_size.store(0, std::memory_order_relaxed);
+    counters.max_queue_wait_ns.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace td
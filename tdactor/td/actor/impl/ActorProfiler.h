@@ -0,0 +1,83 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+
+namespace td {
+
+// Optional runtime counters of actors, aggregated by actor name.
+// Only actors created while the profiler is enabled are accounted.
+class ActorProfiler {
+ public:
+  struct Counters {
+    std::atomic<uint64> actor_count{0};
+    std::atomic<uint64> event_count{0};
+    std::atomic<uint64> total_time_ns{0};
+    std::atomic<uint64> max_time_ns{0};
+    std::atomic<uint64> max_mailbox_size{0};
+    std::atomic<uint64> max_queue_wait_ns{0};
+  };
+
+  struct Stats {
+    string name;
+    uint64 actor_count = 0;
+    uint64 event_count = 0;
+    double total_time = 0.0;
+    double max_time = 0.0;
+    uint64 max_mailbox_size = 0;
+    double max_queue_wait = 0.0;
+  };
+
+  static void set_enabled(bool is_enabled);
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  static Counters *get_counters(Slice name);
+
+  static void on_event(Counters *counters, double time) {
+    counters->event_count.fetch_add(1, std::memory_order_relaxed);
+    auto time_ns = to_ns(time);
+    counters->total_time_ns.fetch_add(time_ns, std::memory_order_relaxed);
+    update_max(counters->max_time_ns, time_ns);
+  }
+
+  static void on_mailbox_size(Counters *counters, size_t mailbox_size) {
+    update_max(counters->max_mailbox_size, static_cast<uint64>(mailbox_size));
+  }
+
+  static void on_queue_wait(Counters *counters, double time) {
+    update_max(counters->max_queue_wait_ns, to_ns(time));
+  }
+
+  // returns statistics of at most max_count actors with the biggest total run time
+  static vector<Stats> get_top_actors(size_t max_count);
+
+  static string get_top_actors_string(size_t max_count);
+
+  static void clear();
+
+ private:
+  static std::atomic<bool> is_enabled_;
+
+  static uint64 to_ns(double time) {
+    return time <= 0 ? 0 : static_cast<uint64>(time * 1e9);
+  }
+
+  static void update_max(std::atomic<uint64> &value, uint64 new_value) {
+    auto old_value = value.load(std::memory_order_relaxed);
+    while (old_value < new_value && !value.compare_exchange_weak(old_value, new_value, std::memory_order_relaxed)) {
+    }
+  }
+};
+
+}  // namespace td
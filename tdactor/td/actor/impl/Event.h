@@ -8,8 +8,11 @@
 
 #include "td/utils/Closure.h"
 #include "td/utils/common.h"
+#include "td/utils/SlabAllocator.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/TraceSpans.h"
 
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
@@ -47,6 +50,14 @@ class CustomEvent {
   CustomEvent &operator=(CustomEvent &&) = delete;
   virtual ~CustomEvent() = default;
 
+  // custom events are created and destroyed on every send_closure, often on different threads
+  static void *operator new(std::size_t size) {
+    return SlabAllocator::allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    SlabAllocator::deallocate(ptr);
+  }
+
   virtual void run(Actor *actor) = 0;
   virtual void start_migrate(int32 sched_id) {
   }
@@ -101,6 +112,7 @@ class Event {
   enum class Type { NoType, Start, Stop, Yield, Timeout, Hangup, Raw, Custom };
   Type type;
   uint64 link_token = 0;
+  uint64 trace_id = TraceSpans::get_current_trace_id();  // the trace, which caused the event
   union Raw {
     void *ptr;
     CustomEvent *custom_event;
@@ -157,13 +169,15 @@ class Event {
   }
   Event(const Event &) = delete;
   Event &operator=(const Event &) = delete;
-  Event(Event &&other) noexcept : type(other.type), link_token(other.link_token), data(other.data) {
+  Event(Event &&other) noexcept
+      : type(other.type), link_token(other.link_token), trace_id(other.trace_id), data(other.data) {
     other.type = Type::NoType;
   }
   Event &operator=(Event &&other) noexcept {
     destroy();
     type = other.type;
     link_token = other.link_token;
+    trace_id = other.trace_id;
     data = other.data;
     other.type = Type::NoType;
     return *this;
@@ -13,11 +13,10 @@
 #include "td/utils/Closure.h"
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
-#include "td/utils/Heap.h"
 #include "td/utils/List.h"
 #include "td/utils/logging.h"
 #include "td/utils/MovableValue.h"
-#include "td/utils/MpscPollableQueue.h"
+#include "td/utils/MpscPollableLinkQueue.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/port/detail/PollableFd.h"
 #include "td/utils/port/Poll.h"
@@ -26,8 +25,10 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 #include "td/utils/type_traits.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -69,6 +70,12 @@ class Scheduler {
     virtual void on_finish() = 0;
     virtual void register_at_finish(std::function<void()>) = 0;
   };
+
+  // state shared between schedulers taking part in work stealing
+  struct WorkStealingState {
+    std::atomic<int32> load{0};
+    std::atomic<int32> thief_sched_id{-1};
+  };
   Scheduler() = default;
   Scheduler(const Scheduler &) = delete;
   Scheduler &operator=(const Scheduler &) = delete;
@@ -76,7 +83,37 @@ class Scheduler {
   Scheduler &operator=(Scheduler &&) = delete;
   ~Scheduler();
 
-  void init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound, Callback *callback);
+  void init(int32 id, std::vector<std::shared_ptr<MpscPollableLinkQueue<EventFull>>> outbound, Callback *callback);
+
+  void enable_work_stealing(std::shared_ptr<std::vector<WorkStealingState>> work_stealing_states);
+
+  // events sent to other schedulers during one iteration of run are delivered in batches
+  struct OutboundEventStats {
+    uint64 flush_count = 0;
+    uint64 event_count = 0;
+  };
+  OutboundEventStats get_outbound_event_stats() const;
+
+  // total time in seconds spent in run outside of waiting for new events
+  double get_busy_time() const;
+
+  // before waiting in poll, check for new events without sleeping for up to max_busy_poll_time seconds
+  // the spin time is halved after each unsuccessful spin and doubled after each successful one
+  void set_busy_poll_time(double max_busy_poll_time);
+
+  struct BusyPollStats {
+    uint64 hit_count = 0;
+    uint64 miss_count = 0;
+  };
+  BusyPollStats get_busy_poll_stats() const;
+
+  static constexpr int32 DEFAULT_TIMER_SLACK_MS = 1000;
+
+  // lazy timeouts of actors on all schedulers are delayed to the next multiple of timer_slack seconds,
+  // so idle schedulers are woken up once for all of them instead of once for each of them
+  static void set_timer_slack(double timer_slack);
+
+  static double get_lazy_timeout_at(double timeout_at);
 
   int32 sched_id() const;
   int32 sched_count() const;
@@ -166,10 +203,10 @@ class Scheduler {
 
   class ServiceActor final : public Actor {
    public:
-    void set_queue(std::shared_ptr<MpscPollableQueue<EventFull>> queues);
+    void set_queue(std::shared_ptr<MpscPollableLinkQueue<EventFull>> queues);
 
    private:
-    std::shared_ptr<MpscPollableQueue<EventFull>> inbound_;
+    std::shared_ptr<MpscPollableLinkQueue<EventFull>> inbound_;
     bool subscribed_{false};
 
     void start_up() final;
@@ -216,6 +253,12 @@ class Scheduler {
   void run_mailbox();
   Timestamp run_events(Timestamp timeout);
   void run_poll(Timestamp timeout);
+  bool run_busy_poll(Timestamp timeout);
+
+  void flush_outbound_events();
+
+  void request_actor_steal();
+  void process_actor_steal_request();
 
   template <class ActorT>
   ActorOwn<ActorT> register_actor_impl(Slice name, ActorT *actor_ptr, Actor::Deleter deleter, int32 sched_id);
@@ -224,13 +267,15 @@ class Scheduler {
   static TD_THREAD_LOCAL Scheduler *scheduler_;
   static TD_THREAD_LOCAL ActorContext *context_;
 
+  static std::atomic<double> timer_slack_;
+
   Callback *callback_ = nullptr;
   unique_ptr<ObjectPool<ActorInfo>> actor_info_pool_;
 
   int32 actor_count_ = 0;
   ListNode pending_actors_list_;
   ListNode ready_actors_list_;
-  KHeap<double> timeout_queue_;
+  TimerWheel timeout_queue_;
 
   FlatHashMap<ActorInfo *, std::vector<Event>> pending_events_;
 
@@ -243,8 +288,25 @@ class Scheduler {
 
   int32 sched_id_ = 0;
   int32 sched_n_ = 0;
-  std::shared_ptr<MpscPollableQueue<EventFull>> inbound_queue_;
-  std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound_queues_;
+  std::shared_ptr<MpscPollableLinkQueue<EventFull>> inbound_queue_;
+  std::vector<std::shared_ptr<MpscPollableLinkQueue<EventFull>>> outbound_queues_;
+
+  bool batch_outbound_events_ = false;
+  std::vector<std::vector<EventFull>> outbound_events_;
+  std::atomic<uint64> outbound_flush_count_{0};
+  std::atomic<uint64> outbound_event_count_{0};
+
+  static constexpr int32 MIN_WORK_STEALING_LOAD = 16;
+  std::shared_ptr<std::vector<WorkStealingState>> work_stealing_states_;
+  int32 processed_event_count_ = 0;
+
+  std::atomic<double> busy_time_{0.0};
+
+  static constexpr double MIN_BUSY_POLL_TIME_RATIO = 1.0 / 16;
+  double max_busy_poll_time_ = 0.0;
+  double busy_poll_time_ = 0.0;
+  std::atomic<uint64> busy_poll_hit_count_{0};
+  std::atomic<uint64> busy_poll_miss_count_{0};
 
   std::shared_ptr<ActorContext> save_context_;
 
@@ -9,24 +9,30 @@
 #include "td/actor/impl/Actor.h"
 #include "td/actor/impl/ActorId.h"
 #include "td/actor/impl/ActorInfo.h"
+#include "td/actor/impl/ActorProfiler.h"
 #include "td/actor/impl/Event.h"
 #include "td/actor/impl/EventFull.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/AllocationTags.h"
+#include "td/utils/Arena.h"
 #include "td/utils/common.h"
 #include "td/utils/ExitGuard.h"
 #include "td/utils/format.h"
 #include "td/utils/List.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
-#include "td/utils/MpscPollableQueue.h"
+#include "td/utils/MpscPollableLinkQueue.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Promise.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
+#include "td/utils/TraceSpans.h"
 
+#include <atomic>
+#include <cmath>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -38,6 +44,8 @@ int VERBOSITY_NAME(actor) = VERBOSITY_NAME(DEBUG) + 10;
 TD_THREAD_LOCAL Scheduler *Scheduler::scheduler_;   // static zero-initialized
 TD_THREAD_LOCAL ActorContext *Scheduler::context_;  // static zero-initialized
 
+std::atomic<double> Scheduler::timer_slack_{Scheduler::DEFAULT_TIMER_SLACK_MS * 1e-3};
+
 Scheduler::~Scheduler() {
   clear();
 }
@@ -58,7 +66,7 @@ void Scheduler::set_scheduler(Scheduler *scheduler) {
   scheduler_ = scheduler;
 }
 
-void Scheduler::ServiceActor::set_queue(std::shared_ptr<MpscPollableQueue<EventFull>> queues) {
+void Scheduler::ServiceActor::set_queue(std::shared_ptr<MpscPollableLinkQueue<EventFull>> queues) {
   inbound_ = std::move(queues);
 }
 
@@ -159,6 +167,9 @@ EventGuard::EventGuard(Scheduler *scheduler, ActorInfo *actor_info) : scheduler_
 #ifdef TD_DEBUG
   save_log_tag2_ = actor_info->get_name().c_str();
 #endif
+  save_allocation_tag_id_ = AllocationTags::get_current_tag_id();
+  AllocationTags::set_current_tag_id(actor_info->get_allocation_tag_id());
+  save_arena_checkpoint_ = get_event_arena().get_checkpoint();
   swap_context(actor_info);
 }
 
@@ -173,6 +184,8 @@ EventGuard::~EventGuard() {
   }
   info->finish_run();
   swap_context(info);
+  AllocationTags::set_current_tag_id(save_allocation_tag_id_);
+  get_event_arena().rollback(save_arena_checkpoint_);
   CHECK(!info->need_context() || save_context_ == info->get_context());
 #ifdef TD_DEBUG
   LOG_CHECK(!info->need_context() || save_log_tag2_ == info->get_name().c_str())
@@ -206,7 +219,7 @@ void EventGuard::swap_context(ActorInfo *info) {
   }
 }
 
-void Scheduler::init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound,
+void Scheduler::init(int32 id, std::vector<std::shared_ptr<MpscPollableLinkQueue<EventFull>>> outbound,
                      Callback *callback) {
   save_context_ = std::make_shared<ActorContext>();
   save_context_->this_ptr_ = save_context_;
@@ -229,10 +242,17 @@ void Scheduler::init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<Eve
   outbound_queues_ = std::move(outbound);
   sched_id_ = id;
   sched_n_ = static_cast<int32>(outbound_queues_.size());
+  outbound_events_.resize(outbound_queues_.size());
   service_actor_.set_queue(inbound_queue_);
   register_actor(PSLICE() << "ServiceActor" << id, &service_actor_).release();
 }
 
+void Scheduler::enable_work_stealing(std::shared_ptr<std::vector<WorkStealingState>> work_stealing_states) {
+  CHECK(work_stealing_states != nullptr);
+  CHECK(static_cast<size_t>(sched_id_) < work_stealing_states->size());
+  work_stealing_states_ = std::move(work_stealing_states);
+}
+
 void Scheduler::clear() {
   if (service_actor_.empty()) {
     return;
@@ -264,7 +284,12 @@ void Scheduler::clear() {
 }
 
 void Scheduler::do_event(ActorInfo *actor_info, Event &&event) {
+  processed_event_count_++;
+  Arena::Scope event_arena_scope(get_event_arena());
   event_context_ptr_->link_token = event.link_token;
+  TraceSpan trace_span(event.trace_id, actor_info->get_name());
+  auto profiler_counters = actor_info->get_profiler_counters();
+  double start_time = profiler_counters != nullptr ? Time::now() : 0.0;
   auto actor = actor_info->get_actor_unsafe();
   VLOG(actor) << *actor_info << ' ' << event;
   switch (event.type) {
@@ -298,6 +323,9 @@ void Scheduler::do_event(ActorInfo *actor_info, Event &&event) {
       UNREACHABLE();
       break;
   }
+  if (profiler_counters != nullptr) {
+    ActorProfiler::on_event(profiler_counters, Time::now() - start_time);
+  }
   // can't clear event here. It may be already destroyed during destroy_actor
 }
 
@@ -363,11 +391,54 @@ void Scheduler::send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_i
       VLOG(actor) << "Send to scheduler " << sched_id << ": " << event;
     }
     start_migrate(event, sched_id);
+    if (batch_outbound_events_) {
+      outbound_events_[sched_id].push_back(EventCreator::event_unsafe(actor_id, std::move(event)));
+      return;
+    }
     outbound_queues_[sched_id]->writer_put(EventCreator::event_unsafe(actor_id, std::move(event)));
     outbound_queues_[sched_id]->writer_flush();
+    outbound_flush_count_.fetch_add(1, std::memory_order_relaxed);
+    outbound_event_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Scheduler::flush_outbound_events() {
+  for (size_t sched_id = 0; sched_id < outbound_events_.size(); sched_id++) {
+    auto &events = outbound_events_[sched_id];
+    if (events.empty()) {
+      continue;
+    }
+    VLOG(actor) << "Send " << events.size() << " events to scheduler " << sched_id;
+    outbound_flush_count_.fetch_add(1, std::memory_order_relaxed);
+    outbound_event_count_.fetch_add(events.size(), std::memory_order_relaxed);
+    outbound_queues_[sched_id]->writer_put_batch(events);
+    outbound_queues_[sched_id]->writer_flush();
   }
 }
 
+Scheduler::OutboundEventStats Scheduler::get_outbound_event_stats() const {
+  OutboundEventStats result;
+  result.flush_count = outbound_flush_count_.load(std::memory_order_relaxed);
+  result.event_count = outbound_event_count_.load(std::memory_order_relaxed);
+  return result;
+}
+
+double Scheduler::get_busy_time() const {
+  return busy_time_.load(std::memory_order_relaxed);
+}
+
+void Scheduler::set_busy_poll_time(double max_busy_poll_time) {
+  max_busy_poll_time_ = max(max_busy_poll_time, 0.0);
+  busy_poll_time_ = max_busy_poll_time_;
+}
+
+Scheduler::BusyPollStats Scheduler::get_busy_poll_stats() const {
+  BusyPollStats result;
+  result.hit_count = busy_poll_hit_count_.load(std::memory_order_relaxed);
+  result.miss_count = busy_poll_miss_count_.load(std::memory_order_relaxed);
+  return result;
+}
+
 void Scheduler::run_on_scheduler(int32 sched_id, Promise<Unit> action) {
   if (sched_id >= 0 && sched_id_ != sched_id) {
     class Worker final : public Actor {
@@ -412,6 +483,13 @@ void Scheduler::add_to_mailbox(ActorInfo *actor_info, Event &&event) {
     ready_actors_list_.put(node);
   }
   VLOG(actor) << "Add to mailbox: " << *actor_info << " " << event;
+  auto profiler_counters = actor_info->get_profiler_counters();
+  if (profiler_counters != nullptr) {
+    if (actor_info->mailbox_.empty()) {
+      actor_info->mailbox_wait_start_ = Time::now();
+    }
+    ActorProfiler::on_mailbox_size(profiler_counters, actor_info->mailbox_.size() + 1);
+  }
   actor_info->mailbox_.push_back(std::move(event));
 }
 
@@ -484,8 +562,8 @@ void Scheduler::start_migrate_actor(ActorInfo *actor_info, int32 dest_sched_id)
 }
 
 double Scheduler::get_actor_timeout(const ActorInfo *actor_info) const {
-  const HeapNode *heap_node = actor_info->get_heap_node();
-  return heap_node->in_heap() ? timeout_queue_.get_key(heap_node) - Time::now() : 0.0;
+  const TimerWheelNode *timer_node = actor_info->get_timer_wheel_node();
+  return timer_node->in_timer_wheel() ? timeout_queue_.get_key(timer_node) - Time::now() : 0.0;
 }
 
 void Scheduler::set_actor_timeout_in(ActorInfo *actor_info, double timeout) {
@@ -499,17 +577,35 @@ void Scheduler::set_actor_timeout_in(ActorInfo *actor_info, double timeout) {
   set_actor_timeout_at(actor_info, expires_at);
 }
 
+void Scheduler::set_timer_slack(double timer_slack) {
+  timer_slack_.store(max(timer_slack, 0.0), std::memory_order_relaxed);
+}
+
+double Scheduler::get_lazy_timeout_at(double timeout_at) {
+  auto timer_slack = timer_slack_.load(std::memory_order_relaxed);
+  if (timer_slack <= 0.0) {
+    return timeout_at;
+  }
+  return std::ceil(timeout_at / timer_slack) * timer_slack;
+}
+
 void Scheduler::set_actor_timeout_at(ActorInfo *actor_info, double timeout_at) {
-  HeapNode *heap_node = actor_info->get_heap_node();
+  TimerWheelNode *timer_node = actor_info->get_timer_wheel_node();
   VLOG(actor) << "Set actor " << *actor_info << " timeout in " << timeout_at - Time::now_cached();
-  if (heap_node->in_heap()) {
-    timeout_queue_.fix(timeout_at, heap_node);
+  if (timer_node->in_timer_wheel()) {
+    timeout_queue_.fix(timeout_at, timer_node);
   } else {
-    timeout_queue_.insert(timeout_at, heap_node);
+    timeout_queue_.insert(timeout_at, timer_node);
   }
 }
 
 void Scheduler::run_poll(Timestamp timeout) {
+#if TD_PORT_POSIX
+  if (max_busy_poll_time_ > 0 && run_busy_poll(timeout)) {
+    return;
+  }
+#endif
+
   // we can't wait for less than 1ms
   auto timeout_ms = static_cast<int>(clamp(timeout.in(), 0.0, 1000000.0) * 1000 + 1);
 #if TD_PORT_WINDOWS
@@ -521,10 +617,87 @@ void Scheduler::run_poll(Timestamp timeout) {
 #endif
 }
 
+bool Scheduler::run_busy_poll(Timestamp timeout) {
+  auto now = Time::now();
+  auto end_time = min(now + busy_poll_time_, timeout.at());
+  if (end_time <= now) {
+    return false;
+  }
+  do {
+    poll_.run(0);
+    if (!ready_actors_list_.empty()) {
+      busy_poll_hit_count_.fetch_add(1, std::memory_order_relaxed);
+      busy_poll_time_ = min(busy_poll_time_ * 2, max_busy_poll_time_);
+      return true;
+    }
+  } while (Time::now() < end_time);
+  busy_poll_miss_count_.fetch_add(1, std::memory_order_relaxed);
+  busy_poll_time_ = max(busy_poll_time_ * 0.5, max_busy_poll_time_ * MIN_BUSY_POLL_TIME_RATIO);
+  return false;
+}
+
+void Scheduler::request_actor_steal() {
+  // ask the most loaded scheduler to give one of its actors
+  auto &states = *work_stealing_states_;
+  int32 victim_sched_id = -1;
+  int32 max_load = MIN_WORK_STEALING_LOAD - 1;
+  for (size_t i = 0; i < states.size(); i++) {
+    auto load = states[i].load.load(std::memory_order_relaxed);
+    if (static_cast<int32>(i) != sched_id_ && load > max_load) {
+      max_load = load;
+      victim_sched_id = static_cast<int32>(i);
+    }
+  }
+  if (victim_sched_id == -1) {
+    return;
+  }
+
+  int32 expected = -1;
+  if (states[victim_sched_id].thief_sched_id.compare_exchange_strong(expected, sched_id_,
+                                                                     std::memory_order_relaxed)) {
+    VLOG(actor) << "Request an actor from scheduler " << victim_sched_id << " with load " << max_load;
+  }
+}
+
+void Scheduler::process_actor_steal_request() {
+  auto &thief_sched_id_ref = (*work_stealing_states_)[sched_id_].thief_sched_id;
+  if (thief_sched_id_ref.load(std::memory_order_relaxed) == -1) {
+    return;
+  }
+  auto thief_sched_id = thief_sched_id_ref.exchange(-1, std::memory_order_relaxed);
+  if (thief_sched_id < 0 || thief_sched_id == sched_id_) {
+    return;
+  }
+
+  // actors with pending events are preferred; actors with a timeout are never migrated
+  // the last migratable actor isn't given away to avoid moving a single hot actor back and forth
+  ActorInfo *candidate = nullptr;
+  for (auto *list : {&ready_actors_list_, &pending_actors_list_}) {
+    for (ListNode *end = list, *it = list->next; it != end; it = it->next) {
+      auto actor_info = ActorInfo::from_list_node(it);
+      if (!actor_info->is_migratable() || actor_info->is_running() || actor_info->get_timer_wheel_node()->in_timer_wheel()) {
+        continue;
+      }
+      if (candidate == nullptr) {
+        candidate = actor_info;
+        continue;
+      }
+      VLOG(actor) << "Give actor " << *candidate << " to scheduler " << thief_sched_id;
+      do_migrate_actor(candidate, thief_sched_id);
+      return;
+    }
+  }
+}
+
 void Scheduler::flush_mailbox(ActorInfo *actor_info) {
   auto &mailbox = actor_info->mailbox_;
   size_t mailbox_size = mailbox.size();
   CHECK(mailbox_size != 0);
+  auto profiler_counters = actor_info->get_profiler_counters();
+  if (profiler_counters != nullptr && actor_info->mailbox_wait_start_ > 0) {
+    ActorProfiler::on_queue_wait(profiler_counters, Time::now() - actor_info->mailbox_wait_start_);
+    actor_info->mailbox_wait_start_ = 0.0;
+  }
   EventGuard guard(this, actor_info);
   size_t i = 0;
   for (; i < mailbox_size && guard.can_run(); i++) {
@@ -565,9 +738,9 @@ void Scheduler::run_mailbox() {
 Timestamp Scheduler::run_timeout() {
   double now = Time::now();
   //TODO: use Timestamp().is_in_past()
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    HeapNode *node = timeout_queue_.pop();
-    ActorInfo *actor_info = ActorInfo::from_heap_node(node);
+  timeout_queue_.advance(now);
+  while (TimerWheelNode *node = timeout_queue_.pop_expired()) {
+    ActorInfo *actor_info = ActorInfo::from_timer_wheel_node(node);
     send_immediately(actor_info->actor_id(), Event::timeout());
   }
   return get_timeout();
@@ -579,22 +752,44 @@ Timestamp Scheduler::run_events(Timestamp timeout) {
               << tag("actors", actor_count_);
   do {
     run_mailbox();
+    if (work_stealing_states_ != nullptr) {
+      process_actor_steal_request();
+    }
     res = run_timeout();
+    flush_outbound_events();
   } while (!ready_actors_list_.empty() && !timeout.is_in_past());
   return res;
 }
 
 void Scheduler::run_no_guard(Timestamp timeout) {
   CHECK(has_guard_);
+  batch_outbound_events_ = true;
+  auto start_time = Time::now();
+  double poll_time = 0.0;
   SCOPE_EXIT {
     yield_flag_ = false;
+    batch_outbound_events_ = false;
+    flush_outbound_events();
+    // only the owning thread updates the value
+    busy_time_.store(busy_time_.load(std::memory_order_relaxed) + (Time::now() - start_time - poll_time),
+                     std::memory_order_relaxed);
   };
 
+  processed_event_count_ = 0;
   timeout.relax(run_events(timeout));
   if (yield_flag_) {
     return;
   }
+  if (work_stealing_states_ != nullptr) {
+    // the number of events processed since the last poll is used as the scheduler load
+    (*work_stealing_states_)[sched_id_].load.store(processed_event_count_, std::memory_order_relaxed);
+    if (ready_actors_list_.empty()) {
+      request_actor_steal();
+    }
+  }
+  auto poll_start_time = Time::now();
   run_poll(timeout);
+  poll_time = Time::now() - poll_start_time;
   run_events(timeout);
 }
 
@@ -605,7 +800,7 @@ Timestamp Scheduler::get_timeout() {
   if (timeout_queue_.empty()) {
     return Timestamp::in(10000);
   }
-  return Timestamp::at(timeout_queue_.top_key());
+  return Timestamp::at(timeout_queue_.get_wakeup_time());
 }
 
 }  // namespace td
@@ -7,10 +7,11 @@
 #pragma once
 
 #include "td/actor/impl/ActorInfo-decl.h"
+#include "td/actor/impl/ActorProfiler.h"
 #include "td/actor/impl/Scheduler-decl.h"
 
+#include "td/utils/Arena.h"
 #include "td/utils/common.h"
-#include "td/utils/Heap.h"
 #include "td/utils/logging.h"
 #include "td/utils/ObjectPool.h"
 #include "td/utils/port/detail/PollableFd.h"
@@ -18,6 +19,7 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 
 #include <atomic>
 #include <tuple>
@@ -46,6 +48,8 @@ class EventGuard {
   Scheduler *scheduler_;
   ActorContext *save_context_;
   const char *save_log_tag2_;
+  int32 save_allocation_tag_id_;
+  Arena::Checkpoint save_arena_checkpoint_;
 
   void swap_context(ActorInfo *info);
 };
@@ -193,7 +197,15 @@ void Scheduler::send_immediately_impl(const ActorId<> &actor_id, const RunFuncT
 
   if (likely(can_send_immediately)) {  // run immediately
     EventGuard guard(this, actor_info);
-    run_func(actor_info);
+    processed_event_count_++;
+    auto profiler_counters = actor_info->get_profiler_counters();
+    if (unlikely(profiler_counters != nullptr)) {
+      double start_time = Time::now();
+      run_func(actor_info);
+      ActorProfiler::on_event(profiler_counters, Time::now() - start_time);
+    } else {
+      run_func(actor_info);
+    }
   } else {
     if (on_current_sched) {
       add_to_mailbox(actor_info, event_func());
@@ -312,9 +324,9 @@ inline void Scheduler::cancel_actor_timeout(Actor *actor) {
 }
 
 inline void Scheduler::cancel_actor_timeout(ActorInfo *actor_info) {
-  HeapNode *heap_node = actor_info->get_heap_node();
-  if (heap_node->in_heap()) {
-    timeout_queue_.erase(heap_node);
+  TimerWheelNode *timer_node = actor_info->get_timer_wheel_node();
+  if (timer_node->in_timer_wheel()) {
+    timeout_queue_.erase(timer_node);
   }
 }
 
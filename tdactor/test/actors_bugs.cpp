@@ -12,6 +12,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/Random.h"
 #include "td/utils/tests.h"
+#include "td/utils/Time.h"
 
 TEST(MultiTimeout, bug) {
   td::ConcurrentScheduler sched(0, 0);
@@ -110,3 +111,42 @@ TEST(MultiTimeout, Destroy) {
   }
   sched.finish();
 }
+
+TEST(MultiTimeout, lazy) {
+  td::Scheduler::set_timer_slack(0.05);
+  td::ConcurrentScheduler sched(0, 0);
+
+  sched.start();
+  td::unique_ptr<td::MultiTimeout> multi_timeout;
+  struct Data {
+    td::vector<double> expire_at;
+    int left_count = 0;
+  };
+  Data data;
+
+  {
+    auto guard = sched.get_main_guard();
+    multi_timeout = td::make_unique<td::MultiTimeout>("MultiTimeout");
+    multi_timeout->set_lazy(true);
+    multi_timeout->set_callback([](void *void_data, td::int64 key) {
+      auto &data = *static_cast<Data *>(void_data);
+      auto expire_at = data.expire_at[static_cast<size_t>(key)];
+      ASSERT_TRUE(td::Time::now() >= td::Scheduler::get_lazy_timeout_at(expire_at));
+      if (--data.left_count == 0) {
+        td::Scheduler::instance()->finish();
+      }
+    });
+    multi_timeout->set_callback_data(&data);
+    for (int i = 0; i < 20; i++) {
+      data.expire_at.push_back(td::Time::now() + td::Random::fast(1, 200) * 0.001);
+      multi_timeout->set_timeout_at(i, data.expire_at.back());
+      data.left_count++;
+    }
+  }
+
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+  td::Scheduler::set_timer_slack(td::Scheduler::DEFAULT_TIMER_SLACK_MS * 1e-3);
+}
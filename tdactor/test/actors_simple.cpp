@@ -10,9 +10,11 @@
 #include "td/actor/PromiseFuture.h"
 #include "td/actor/SleepActor.h"
 
+#include "td/utils/AllocationTags.h"
+#include "td/utils/Arena.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
-#include "td/utils/MpscPollableQueue.h"
+#include "td/utils/MpscPollableLinkQueue.h"
 #include "td/utils/Observer.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/path.h"
@@ -23,6 +25,7 @@
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
+#include "td/utils/TraceSpans.h"
 
 #include <memory>
 #include <tuple>
@@ -33,11 +36,11 @@ static char buf2[BUF_SIZE];
 static td::StringBuilder sb(td::MutableSlice(buf, BUF_SIZE - 1));
 static td::StringBuilder sb2(td::MutableSlice(buf2, BUF_SIZE - 1));
 
-static td::vector<std::shared_ptr<td::MpscPollableQueue<td::EventFull>>> create_queues() {
+static td::vector<std::shared_ptr<td::MpscPollableLinkQueue<td::EventFull>>> create_queues() {
 #if TD_THREAD_UNSUPPORTED || TD_EVENTFD_UNSUPPORTED
   return {};
 #else
-  auto res = std::make_shared<td::MpscPollableQueue<td::EventFull>>();
+  auto res = std::make_shared<td::MpscPollableLinkQueue<td::EventFull>>();
   res->init();
   return {res};
 #endif
@@ -680,3 +683,116 @@ TEST(Actors, MultiPromiseSendClosureLater) {
   }
   scheduler.finish();
 }
+
+class AllocationTagChild final : public td::Actor {
+ public:
+  void start_up() final {
+    CHECK(td::AllocationTags::get_current_tag_id() == td::AllocationTags::get_tag_id("AllocationTagChild"));
+    stop();
+  }
+};
+
+class AllocationTagParent final : public td::Actor {
+ public:
+  void start_up() final {
+    auto tag_id = td::AllocationTags::get_tag_id("AllocationTagParent");
+    CHECK(tag_id != td::AllocationTags::UNTAGGED);
+    CHECK(td::AllocationTags::get_current_tag_id() == tag_id);
+    td::create_actor<AllocationTagChild>("AllocationTagChild").release();
+    CHECK(td::AllocationTags::get_current_tag_id() == tag_id);
+    td::Scheduler::instance()->finish();
+  }
+};
+
+TEST(Actors, allocation_tags) {
+  td::AllocationTags::set_enabled(true);
+  td::ConcurrentScheduler scheduler(0, 0);
+  scheduler.create_actor_unsafe<AllocationTagParent>(0, "AllocationTagParent").release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+  td::AllocationTags::set_enabled(false);
+  ASSERT_EQ(td::AllocationTags::UNTAGGED, td::AllocationTags::get_current_tag_id());
+  auto tag_id = td::AllocationTags::get_tag_id("AllocationTagParent");
+  ASSERT_EQ("AllocationTagParent", td::AllocationTags::get_tag_name(tag_id));
+}
+
+class EventArenaUser final : public td::Actor {
+ public:
+  explicit EventArenaUser(size_t used_size) : used_size_(used_size) {
+  }
+
+ private:
+  size_t used_size_;
+
+  void start_up() final {
+    td::get_event_arena().allocate(1000);
+    CHECK(td::get_event_arena().get_used_size() > used_size_);
+    send_closure(actor_id(this), &EventArenaUser::check);
+  }
+
+  void check() {
+    CHECK(td::get_event_arena().get_used_size() == used_size_);
+    td::Scheduler::instance()->finish();
+  }
+};
+
+TEST(Actors, event_arena) {
+  td::ConcurrentScheduler scheduler(0, 0);
+  auto used_size = td::get_event_arena().get_used_size();
+  scheduler.create_actor_unsafe<EventArenaUser>(0, "EventArenaUser", used_size).release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+  ASSERT_EQ(used_size, td::get_event_arena().get_used_size());
+}
+
+class TraceSpansUser final : public td::Actor {
+ public:
+  explicit TraceSpansUser(td::ActorId<TraceSpansUser> other) : other_(other) {
+  }
+
+  void check(td::uint64 trace_id, td::ActorId<TraceSpansUser> sender) {
+    CHECK(td::TraceSpans::get_current_trace_id() == trace_id);
+    if (sender.empty()) {
+      td::Scheduler::instance()->finish();
+    } else {
+      send_closure(sender, &TraceSpansUser::check, trace_id, td::ActorId<TraceSpansUser>());
+    }
+  }
+
+ private:
+  td::ActorId<TraceSpansUser> other_;
+
+  void start_up() final {
+    if (other_.empty()) {
+      return;
+    }
+    td::TraceSpan trace_span(td::TraceSpans::create_trace_id(), "start_up");
+    CHECK(td::TraceSpans::get_current_trace_id() != 0);
+    send_closure(other_, &TraceSpansUser::check, td::TraceSpans::get_current_trace_id(), actor_id(this));
+  }
+};
+
+TEST(Actors, trace_spans) {
+  td::TraceSpans::clear();
+  td::TraceSpans::set_enabled(true);
+  td::ConcurrentScheduler scheduler(1, 0);
+  auto receiver = scheduler.create_actor_unsafe<TraceSpansUser>(1, "Receiver", td::ActorId<TraceSpansUser>()).release();
+  scheduler.create_actor_unsafe<TraceSpansUser>(0, "Sender", receiver).release();
+  scheduler.start();
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+  td::TraceSpans::set_enabled(false);
+
+  // "start_up", the event of the receiver and the event of the sender
+  auto spans = td::TraceSpans::get_spans();
+  ASSERT_EQ(3u, spans.size());
+  for (auto &span : spans) {
+    ASSERT_EQ(spans[0].trace_id, span.trace_id);
+  }
+  td::TraceSpans::clear();
+}
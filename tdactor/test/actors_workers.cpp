@@ -25,6 +25,8 @@ class PowerWorker final : public td::Actor {
     virtual void on_ready(int query, int res) = 0;
     virtual void on_closed() = 0;
   };
+  explicit PowerWorker(bool is_migratable = false) : is_migratable_(is_migratable) {
+  }
   void set_callback(td::unique_ptr<Callback> callback) {
     callback_ = std::move(callback);
   }
@@ -41,7 +43,12 @@ class PowerWorker final : public td::Actor {
   }
 
  private:
+  bool is_migratable_;
   td::unique_ptr<Callback> callback_;
+
+  void start_up() final {
+    set_migratable(is_migratable_);
+  }
 };
 
 class Manager final : public td::Actor {
@@ -106,13 +113,18 @@ class Manager final : public td::Actor {
   int query_size_;
 };
 
-static void test_workers(int threads_n, int workers_n, int queries_n, int query_size) {
+static void test_workers(int threads_n, int workers_n, int queries_n, int query_size, bool work_stealing = false) {
   td::ConcurrentScheduler sched(threads_n, 0);
+  if (work_stealing) {
+    sched.enable_work_stealing();
+  }
 
   td::vector<td::ActorId<PowerWorker>> workers;
   for (int i = 0; i < workers_n; i++) {
-    int thread_id = threads_n ? i % (threads_n - 1) + 2 : 0;
-    workers.push_back(sched.create_actor_unsafe<PowerWorker>(thread_id, PSLICE() << "worker" << i).release());
+    // with work stealing all workers are created on the same scheduler and must be spread by idle schedulers
+    int thread_id = threads_n ? (work_stealing ? 2 : i % (threads_n - 1) + 2) : 0;
+    workers.push_back(
+        sched.create_actor_unsafe<PowerWorker>(thread_id, PSLICE() << "worker" << i, work_stealing).release());
   }
   sched.create_actor_unsafe<Manager>(threads_n ? 1 : 0, "Manager", queries_n, query_size, std::move(workers)).release();
 
@@ -137,6 +149,10 @@ TEST(Actors, workers_big_query_nine_threads) {
   test_workers(9, 10, 1000, 300000);
 }
 
+TEST(Actors, workers_big_query_work_stealing) {
+  test_workers(4, 10, 1000, 300000, true);
+}
+
 TEST(Actors, workers_small_query_one_thread) {
   test_workers(0, 10, 100000, 1);
 }
@@ -149,6 +165,29 @@ TEST(Actors, workers_small_query_nine_threads) {
   test_workers(9, 10, 10000, 1);
 }
 
+TEST(Actors, workers_small_query_work_stealing) {
+  test_workers(4, 10, 100000, 1, true);
+}
+
+TEST(Actors, workers_profiling) {
+  td::ConcurrentScheduler::enable_actor_profiling(true);
+  test_workers(2, 10, 1000, 10);
+  td::ConcurrentScheduler::enable_actor_profiling(false);
+
+  bool has_manager = false;
+  for (auto &stats : td::ActorProfiler::get_top_actors(100)) {
+    if (stats.name == "Manager") {
+      has_manager = true;
+      ASSERT_EQ(1u, stats.actor_count);
+      ASSERT_TRUE(stats.event_count >= 1000u);
+      ASSERT_TRUE(stats.max_time <= stats.total_time);
+    }
+  }
+  ASSERT_TRUE(has_manager);
+  ASSERT_TRUE(!td::ConcurrentScheduler::get_hottest_actors_string(5).empty());
+  td::ActorProfiler::clear();
+}
+
 class SenderActor;
 
 class ReceiverActor final : public td::Actor {
@@ -186,3 +225,133 @@ TEST(Actors, send_closure_while_finish) {
   }
   sched.finish();
 }
+
+class BatchReceiverActor final : public td::Actor {
+ public:
+  explicit BatchReceiverActor(int events_n) : events_left_(events_n) {
+  }
+
+  void receive() {
+    if (--events_left_ == 0) {
+      td::Scheduler::instance()->finish();
+      stop();
+    }
+  }
+
+ private:
+  int events_left_;
+};
+
+class BatchSenderActor final : public td::Actor {
+ public:
+  BatchSenderActor(td::ActorId<BatchReceiverActor> actor_id, int events_n)
+      : actor_id_(std::move(actor_id)), events_n_(events_n) {
+  }
+
+ private:
+  td::ActorId<BatchReceiverActor> actor_id_;
+  int events_n_;
+
+  void start_up() final {
+    for (int i = 0; i < events_n_; i++) {
+      send_closure(actor_id_, &BatchReceiverActor::receive);
+    }
+    stop();
+  }
+};
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+TEST(Actors, batched_cross_scheduler_send) {
+  int events_n = 1000;
+  td::ConcurrentScheduler sched(2, 0);
+
+  auto receiver = sched.create_actor_unsafe<BatchReceiverActor>(2, "BatchReceiverActor", events_n).release();
+  sched.create_actor_unsafe<BatchSenderActor>(1, "BatchSenderActor", receiver, events_n).release();
+
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  auto stats = sched.get_outbound_event_stats(1);
+  ASSERT_TRUE(stats.event_count >= static_cast<td::uint64>(events_n));
+  ASSERT_TRUE(stats.flush_count < stats.event_count);
+  sched.finish();
+}
+#endif
+
+class BusyActor final : public td::Actor {
+ public:
+  explicit BusyActor(double busy_time) : busy_time_(busy_time) {
+  }
+
+ private:
+  double busy_time_;
+
+  void start_up() final {
+    auto end_time = td::Time::now() + busy_time_;
+    while (td::Time::now() < end_time) {
+      // busy wait
+    }
+    td::Scheduler::instance()->finish();
+    stop();
+  }
+};
+
+TEST(Actors, busy_time) {
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<BusyActor>(0, "BusyActor", 0.05).release();
+
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  ASSERT_TRUE(sched.get_busy_time() >= 0.05);
+  ASSERT_TRUE(sched.get_busy_time() < 10.0);
+  sched.finish();
+}
+
+class PingPongActor final : public td::Actor {
+ public:
+  explicit PingPongActor(int rounds_left) : rounds_left_(rounds_left) {
+  }
+
+  void set_peer(td::ActorId<PingPongActor> peer) {
+    peer_ = std::move(peer);
+  }
+
+  void ping() {
+    if (rounds_left_-- <= 0) {
+      td::Scheduler::instance()->finish();
+      return;
+    }
+    send_closure(peer_, &PingPongActor::ping);
+  }
+
+ private:
+  int rounds_left_;
+  td::ActorId<PingPongActor> peer_;
+};
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && TD_PORT_POSIX
+TEST(Actors, busy_poll) {
+  td::ConcurrentScheduler sched(1, 0);
+  sched.set_busy_poll_time(0.001);
+
+  auto a = sched.create_actor_unsafe<PingPongActor>(0, "PingPongActor", 100).release();
+  auto b = sched.create_actor_unsafe<PingPongActor>(1, "PingPongActor", 1000000).release();
+  sched.start();
+  {
+    auto guard = sched.get_send_guard();
+    td::send_closure(a, &PingPongActor::set_peer, b);
+    td::send_closure(b, &PingPongActor::set_peer, a);
+    td::send_closure(a, &PingPongActor::ping);
+  }
+  while (sched.run_main(10)) {
+    // empty
+  }
+  // whether spinning finds new events depends on the number of available CPUs
+  auto stats = sched.get_busy_poll_stats(1);
+  ASSERT_TRUE(stats.hit_count + stats.miss_count > 0);
+  sched.finish();
+}
+#endif
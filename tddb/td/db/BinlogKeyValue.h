@@ -9,9 +9,9 @@
 #include "td/db/binlog/Binlog.h"
 #include "td/db/binlog/BinlogEvent.h"
 #include "td/db/DbKey.h"
+#include "td/db/detail/BinlogKeyValueStorage.h"
 #include "td/db/KeyValueSyncInterface.h"
 
-#include "td/utils/algorithm.h"
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
@@ -26,6 +26,7 @@
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -81,17 +82,9 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
 
     binlog_ = std::make_shared<BinlogT>();
     TRY_STATUS(binlog_->init(
-        name,
-        [&](const BinlogEvent &binlog_event) {
-          Event event;
-          event.parse(TlParser(binlog_event.get_data()));
-          if (event.key.empty()) {
-            LOG(ERROR) << "Have event with empty key";
-            return;
-          }
-          map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
-        },
-        std::move(db_key), DbKey::empty(), scheduler_id));
+        name, [&](const BinlogEvent &binlog_event) { replay_event(binlog_event); }, std::move(db_key),
+        DbKey::empty(), scheduler_id));
+    update_event_count();
     return Status::OK();
   }
 
@@ -105,20 +98,18 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   template <class OtherBinlogT>
   void external_init_handle(BinlogKeyValue<OtherBinlogT> &&other) {
     map_ = std::move(other.map_);
+    snapshot_event_id_ = other.snapshot_event_id_;
+    obsolete_event_ids_ = std::move(other.obsolete_event_ids_);
+    event_count_ = other.event_count_;
   }
 
   void external_init_handle(const BinlogEvent &binlog_event) {
-    Event event;
-    event.parse(TlParser(binlog_event.get_data()));
-    if (event.key.empty()) {
-      LOG(ERROR) << "Have external event with empty key";
-      return;
-    }
-    map_.emplace(event.key.str(), std::make_pair(event.value.str(), binlog_event.id_));
+    replay_event(binlog_event);
   }
 
   void external_init_finish(std::shared_ptr<BinlogT> binlog) {
     binlog_ = std::move(binlog);
+    update_event_count();
   }
 
   void close() {
@@ -132,65 +123,92 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
     auto lock = rw_mutex_.lock_write().move_as_ok();
     uint64 old_event_id = 0;
     CHECK(!key.empty());
-    auto it_ok = map_.emplace(key, std::make_pair(value, 0));
-    if (!it_ok.second) {
-      if (it_ok.first->second.first == value) {
+    auto old_value = map_.find(key);
+    if (old_value != nullptr) {
+      if (old_value->value == value) {
         return 0;
       }
-      VLOG(binlog) << "Change value of key " << key << " from " << hex_encode(it_ok.first->second.first) << " to "
+      VLOG(binlog) << "Change value of key " << key << " from " << hex_encode(old_value->value) << " to "
                    << hex_encode(value);
-      old_event_id = it_ok.first->second.second;
-      it_ok.first->second.first = value;
+      old_event_id = old_value->event_id;
     } else {
       VLOG(binlog) << "Set value of key " << key << " to " << hex_encode(value);
     }
+    auto &new_value = map_.set(key, value);
     bool rewrite = false;
     uint64 event_id;
     auto seq_no = binlog_->next_event_id();
-    if (old_event_id != 0) {
+    if (old_event_id != 0 && old_event_id != snapshot_event_id_) {
       rewrite = true;
       event_id = old_event_id;
     } else {
+      // the value from the snapshot is overridden by the new event
       event_id = seq_no;
-      it_ok.first->second.second = event_id;
+      new_value.event_id = event_id;
+      event_count_++;
     }
+    bool need_snapshot = this->need_snapshot();
 
     lock.reset();
     add_event(seq_no,
               BinlogEvent::create_raw(event_id, magic_, rewrite ? BinlogEvent::Flags::Rewrite : 0, Event{key, value}));
+    if (need_snapshot) {
+      write_snapshot();
+    }
     return seq_no;
   }
 
   SeqNo erase(const string &key) final {
     auto lock = rw_mutex_.lock_write().move_as_ok();
-    auto it = map_.find(key);
-    if (it == map_.end()) {
+    auto value = map_.find(key);
+    if (value == nullptr) {
       return 0;
     }
-    VLOG(binlog) << "Remove value of key " << key << ", which is " << hex_encode(it->second.first);
-    uint64 event_id = it->second.second;
-    map_.erase(it);
+    VLOG(binlog) << "Remove value of key " << key << ", which is " << hex_encode(value->value);
+    uint64 event_id = value->event_id;
+    map_.erase(key);
     auto seq_no = binlog_->next_event_id();
+    auto raw_event = create_erase_event(key, event_id, seq_no);
+    bool need_snapshot = this->need_snapshot();
     lock.reset();
-    add_event(seq_no, BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite,
-                                              EmptyStorer()));
+    add_event(seq_no, std::move(raw_event));
+    if (need_snapshot) {
+      write_snapshot();
+    }
     return seq_no;
   }
 
   SeqNo erase_batch(vector<string> keys) final {
     auto lock = rw_mutex_.lock_write().move_as_ok();
+    if (snapshot_event_id_ != 0) {
+      vector<std::pair<string, uint64>> erased_keys;
+      for (auto &key : keys) {
+        auto value = map_.find(key);
+        if (value != nullptr) {
+          erased_keys.emplace_back(std::move(key), value->event_id);
+          map_.erase(erased_keys.back().first);
+        }
+      }
+      if (erased_keys.empty()) {
+        return 0;
+      }
+      VLOG(binlog) << "Remove value of " << erased_keys.size() << " keys";
+      return erase_keys(std::move(lock), std::move(erased_keys));
+    }
+
     vector<uint64> log_event_ids;
     for (auto &key : keys) {
-      auto it = map_.find(key);
-      if (it != map_.end()) {
-        log_event_ids.push_back(it->second.second);
-        map_.erase(it);
+      auto value = map_.find(key);
+      if (value != nullptr) {
+        log_event_ids.push_back(value->event_id);
+        map_.erase(key);
       }
     }
     if (log_event_ids.empty()) {
       return 0;
     }
     VLOG(binlog) << "Remove value of keys " << keys;
+    event_count_ -= log_event_ids.size();
     return binlog_->erase_batch(std::move(log_event_ids));
   }
 
@@ -200,17 +218,17 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
 
   bool isset(const string &key) final {
     auto lock = rw_mutex_.lock_read().move_as_ok();
-    return map_.count(key) > 0;
+    return map_.find(key) != nullptr;
   }
 
   string get(const string &key) final {
     auto lock = rw_mutex_.lock_read().move_as_ok();
-    auto it = map_.find(key);
-    if (it == map_.end()) {
+    auto value = map_.find(key);
+    if (value == nullptr) {
       return string();
     }
-    VLOG(binlog) << "Get value of key " << key << ", which is " << hex_encode(it->second.first);
-    return it->second.first;
+    VLOG(binlog) << "Get value of key " << key << ", which is " << hex_encode(value->value);
+    return value->value.str();
   }
 
   void force_sync(Promise<> &&promise, const char *source) final {
@@ -223,19 +241,15 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
 
   void for_each(std::function<void(Slice, Slice)> func) final {
     auto lock = rw_mutex_.lock_write().move_as_ok();
-    for (const auto &kv : map_) {
-      func(kv.first, kv.second.first);
-    }
+    map_.for_each([&](Slice key, const detail::BinlogKeyValueStorage::Value &value) { func(key, value.value); });
   }
 
   std::unordered_map<string, string, Hash<string>> prefix_get(Slice prefix) final {
     auto lock = rw_mutex_.lock_write().move_as_ok();
     std::unordered_map<string, string, Hash<string>> res;
-    for (const auto &kv : map_) {
-      if (begins_with(kv.first, prefix)) {
-        res.emplace(kv.first.substr(prefix.size()), kv.second.first);
-      }
-    }
+    map_.for_each_with_prefix(prefix, [&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+      res.emplace(key.substr(prefix.size()).str(), value.value.str());
+    });
     return res;
   }
 
@@ -243,29 +257,22 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
     auto lock = rw_mutex_.lock_write().move_as_ok();
     FlatHashMap<string, string> res;
     res.reserve(map_.size());
-    for (const auto &kv : map_) {
-      res.emplace(kv.first, kv.second.first);
-    }
+    map_.for_each([&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+      res.emplace(key.str(), value.value.str());
+    });
     return res;
   }
 
   void erase_by_prefix(Slice prefix) final {
     auto lock = rw_mutex_.lock_write().move_as_ok();
-    vector<uint64> event_ids;
-    table_remove_if(map_, [&](const auto &it) {
-      if (begins_with(it.first, prefix)) {
-        event_ids.push_back(it.second.second);
-        return true;
-      }
-      return false;
+    vector<std::pair<string, uint64>> erased_keys;
+    map_.for_each_with_prefix(prefix, [&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+      erased_keys.emplace_back(key.str(), value.event_id);
     });
-    auto seq_no = binlog_->next_event_id(narrow_cast<int32>(event_ids.size()));
-    lock.reset();
-    for (auto event_id : event_ids) {
-      add_event(seq_no, BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite,
-                                                EmptyStorer()));
-      seq_no++;
+    for (auto &erased_key : erased_keys) {
+      map_.erase(erased_key.first);
     }
+    erase_keys(std::move(lock), std::move(erased_keys));
   }
 
   template <class T>
@@ -276,10 +283,230 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
  private:
-  FlatHashMap<string, std::pair<string, uint64>> map_;
+  // events with an empty key are service events, containing either a snapshot of the whole storage
+  // or a key, which was removed after the last snapshot
+  enum class ServiceEventType : int32 { Snapshot = 1, Erase = 2 };
+
+  // a snapshot is written when there are enough other events to replay
+  static constexpr size_t MIN_SNAPSHOT_EVENT_COUNT = 1000;
+  static constexpr size_t MAX_SNAPSHOT_SIZE = 1 << 23;
+
+  struct Snapshot {
+    vector<std::pair<Slice, Slice>> entries;  // sorted by key
+
+    template <class StorerT>
+    void store(StorerT &storer) const {
+      storer.store_binary(static_cast<int32>(ServiceEventType::Snapshot));
+      storer.store_binary(narrow_cast<int32>(entries.size()));
+      for (auto &entry : entries) {
+        storer.store_string(entry.first);
+        storer.store_string(entry.second);
+      }
+    }
+  };
+
+  struct ErasedKey {
+    Slice key;
+
+    template <class StorerT>
+    void store(StorerT &storer) const {
+      storer.store_binary(static_cast<int32>(ServiceEventType::Erase));
+      storer.store_string(key);
+    }
+  };
+
+  detail::BinlogKeyValueStorage map_;
   std::shared_ptr<BinlogT> binlog_;
   RwMutex rw_mutex_;
   int32 magic_ = MAGIC;
+
+  // identifier of the event with the last snapshot; values of keys from the snapshot have this event identifier
+  uint64 snapshot_event_id_ = 0;
+  // events, which must be erased after the next snapshot is written
+  vector<uint64> obsolete_event_ids_;
+  // number of events, which must be replayed in addition to the snapshot
+  size_t event_count_ = 0;
+
+  template <class T>
+  static string serialize_service_event(const T &object) {
+    TlStorerCalcLength calc_length;
+    object.store(calc_length);
+    string result(calc_length.get_length(), '\0');
+    TlStorerUnsafe storer(MutableSlice(result).ubegin());
+    object.store(storer);
+    return result;
+  }
+
+  void replay_event(const BinlogEvent &binlog_event) {
+    Event event;
+    event.parse(TlParser(binlog_event.get_data()));
+    if (event.key.empty()) {
+      auto status = replay_service_event(event.value, binlog_event.id_);
+      if (status.is_error()) {
+        LOG(ERROR) << "Failed to replay " << binlog_event.public_to_string() << ": " << status;
+      }
+      return;
+    }
+    auto old_value = map_.find(event.key);
+    if (old_value != nullptr && old_value->event_id != snapshot_event_id_) {
+      obsolete_event_ids_.push_back(old_value->event_id);
+    }
+    map_.set(event.key, event.value).event_id = binlog_event.id_;
+  }
+
+  Status replay_service_event(Slice data, uint64 event_id) {
+    TlParser parser(data);
+    auto type = static_cast<ServiceEventType>(parser.fetch_int());
+    switch (type) {
+      case ServiceEventType::Snapshot: {
+        auto size = parser.fetch_int();
+        if (size < 0) {
+          return Status::Error("Invalid snapshot size");
+        }
+        vector<std::pair<Slice, Slice>> entries;
+        for (int32 i = 0; i < size && parser.get_error() == nullptr; i++) {
+          auto key = parser.template fetch_string<Slice>();
+          auto value = parser.template fetch_string<Slice>();
+          entries.emplace_back(key, value);
+        }
+        parser.fetch_end();
+        if (parser.get_error() != nullptr) {
+          return Status::Error(PSLICE() << "Failed to parse snapshot: " << parser.get_error());
+        }
+
+        // the snapshot contains the whole state, so all previous events are obsolete
+        map_.for_each([&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+          if (value.event_id != snapshot_event_id_) {
+            obsolete_event_ids_.push_back(value.event_id);
+          }
+        });
+        if (snapshot_event_id_ != 0) {
+          obsolete_event_ids_.push_back(snapshot_event_id_);
+        }
+        map_.clear();
+        map_.reserve(entries.size());
+        for (auto &entry : entries) {
+          map_.set(entry.first, entry.second).event_id = event_id;
+        }
+        snapshot_event_id_ = event_id;
+        return Status::OK();
+      }
+      case ServiceEventType::Erase: {
+        auto key = parser.template fetch_string<Slice>();
+        parser.fetch_end();
+        if (parser.get_error() != nullptr) {
+          return Status::Error(PSLICE() << "Failed to parse erased key: " << parser.get_error());
+        }
+        map_.erase(key);
+        obsolete_event_ids_.push_back(event_id);
+        return Status::OK();
+      }
+      default:
+        return Status::Error(PSLICE() << "Unknown service event type " << static_cast<int32>(type));
+    }
+  }
+
+  void update_event_count() {
+    event_count_ = obsolete_event_ids_.size();
+    map_.for_each([&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+      if (value.event_id != snapshot_event_id_) {
+        event_count_++;
+      }
+    });
+  }
+
+  // must be called under the write lock
+  BufferSlice create_erase_event(Slice key, uint64 event_id, uint64 seq_no) {
+    if (snapshot_event_id_ == 0) {
+      CHECK(event_count_ > 0);
+      event_count_--;
+      return BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite,
+                                     EmptyStorer());
+    }
+
+    // the key can be in the snapshot, so its removal must be logged until the next snapshot
+    auto erased_key = serialize_service_event(ErasedKey{key});
+    if (event_id == snapshot_event_id_) {
+      event_count_++;
+      obsolete_event_ids_.push_back(seq_no);
+      return BinlogEvent::create_raw(seq_no, magic_, 0, Event{Slice(), erased_key});
+    }
+    obsolete_event_ids_.push_back(event_id);
+    return BinlogEvent::create_raw(event_id, magic_, BinlogEvent::Flags::Rewrite, Event{Slice(), erased_key});
+  }
+
+  template <class LockT>
+  SeqNo erase_keys(LockT lock, vector<std::pair<string, uint64>> erased_keys) {
+    auto seq_no = binlog_->next_event_id(narrow_cast<int32>(erased_keys.size()));
+    vector<BufferSlice> raw_events;
+    raw_events.reserve(erased_keys.size());
+    for (size_t i = 0; i < erased_keys.size(); i++) {
+      raw_events.push_back(create_erase_event(erased_keys[i].first, erased_keys[i].second, seq_no + i));
+    }
+    bool need_snapshot = this->need_snapshot();
+    lock.reset();
+    for (size_t i = 0; i < raw_events.size(); i++) {
+      add_event(seq_no + i, std::move(raw_events[i]));
+    }
+    if (need_snapshot) {
+      write_snapshot();
+    }
+    return seq_no;
+  }
+
+  // must be called under the lock
+  bool need_snapshot() const {
+    return event_count_ >= td::max(MIN_SNAPSHOT_EVENT_COUNT, map_.size() / 2);
+  }
+
+  // writes a snapshot of the whole storage to avoid replay of individual events for each key
+  void write_snapshot() {
+    auto lock = rw_mutex_.lock_write().move_as_ok();
+    if (!need_snapshot()) {
+      return;
+    }
+
+    Snapshot snapshot;
+    snapshot.entries.reserve(map_.size());
+    size_t total_size = 0;
+    map_.for_each([&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+      snapshot.entries.emplace_back(key, value.value);
+      total_size += key.size() + value.value.size() + 8;
+    });
+    if (total_size > MAX_SNAPSHOT_SIZE) {
+      LOG(INFO) << "Skip snapshot of size " << total_size;
+      event_count_ = 0;
+      return;
+    }
+    std::sort(snapshot.entries.begin(), snapshot.entries.end(),
+              [](const std::pair<Slice, Slice> &lhs, const std::pair<Slice, Slice> &rhs) {
+                return lhs.first < rhs.first;
+              });
+    auto data = serialize_service_event(snapshot);
+    snapshot.entries.clear();
+
+    auto event_ids = std::move(obsolete_event_ids_);
+    obsolete_event_ids_.clear();
+    map_.for_each([&](Slice key, const detail::BinlogKeyValueStorage::Value &value) {
+      if (value.event_id != snapshot_event_id_) {
+        event_ids.push_back(value.event_id);
+      }
+    });
+    if (snapshot_event_id_ != 0) {
+      event_ids.push_back(snapshot_event_id_);
+    }
+
+    auto seq_no = binlog_->next_event_id();
+    snapshot_event_id_ = seq_no;
+    map_.for_each([&](Slice key, detail::BinlogKeyValueStorage::Value &value) { value.event_id = seq_no; });
+    event_count_ = 0;
+    VLOG(binlog) << "Write snapshot with " << map_.size() << " keys of size " << data.size() << " and erase "
+                 << event_ids.size() << " events";
+
+    lock.reset();
+    add_event(seq_no, BinlogEvent::create_raw(seq_no, magic_, 0, Event{Slice(), data}));
+    binlog_->erase_batch(std::move(event_ids));
+  }
 };
 
 template <>
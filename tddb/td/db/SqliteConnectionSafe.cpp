@@ -12,10 +12,11 @@
 
 namespace td {
 
-SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version)
+SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version,
+                                           SqliteDbSettings settings)
     : path_(std::move(path))
     , lsls_connection_([path = path_, close_state_ptr = &close_state_, key = std::move(key),
-                        cipher_version = std::move(cipher_version)] {
+                        cipher_version = std::move(cipher_version), settings = std::move(settings)] {
       auto r_db = SqliteDb::open_with_key(path, false, key, cipher_version.copy());
       if (r_db.is_error()) {
         LOG(FATAL) << "Can't open database in state " << close_state_ptr->load() << ": " << r_db.error().message();
@@ -23,6 +24,7 @@ SqliteConnectionSafe::SqliteConnectionSafe(string path, DbKey key, optional<int3
       auto db = r_db.move_as_ok();
       db.exec("PRAGMA journal_mode=WAL").ensure();
       db.exec("PRAGMA secure_delete=1").ensure();
+      db.apply_settings(settings).ensure();
       return db;
     }) {
 }
@@ -21,7 +21,7 @@ namespace td {
 class SqliteConnectionSafe {
  public:
   SqliteConnectionSafe() = default;
-  SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version = {});
+  SqliteConnectionSafe(string path, DbKey key, optional<int32> cipher_version = {}, SqliteDbSettings settings = {});
 
   SqliteDb &get();
   void set(SqliteDb &&db);
@@ -69,6 +69,38 @@ string db_key_to_sqlcipher_key(const DbKey &db_key) {
 }
 }  // namespace
 
+Status SqliteDbSettings::check() const {
+  if (cache_size_kb < 0) {
+    return Status::Error("Invalid cache size specified");
+  }
+  if (mmap_size < 0) {
+    return Status::Error("Invalid memory mapping size specified");
+  }
+  if (!synchronous.empty() && synchronous != "OFF" && synchronous != "NORMAL" && synchronous != "FULL" &&
+      synchronous != "EXTRA") {
+    return Status::Error("Invalid synchronous mode specified");
+  }
+  if (!temp_store.empty() && temp_store != "DEFAULT" && temp_store != "FILE" && temp_store != "MEMORY") {
+    return Status::Error("Invalid temporary storage mode specified");
+  }
+  if (wal_autocheckpoint < 0) {
+    return Status::Error("Invalid WAL autocheckpoint specified");
+  }
+  if (page_size != 0 && (page_size < 512 || page_size > 65536 || (page_size & (page_size - 1)) != 0)) {
+    return Status::Error("Invalid page size specified");
+  }
+  return Status::OK();
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const SqliteDbSettings &settings) {
+  auto cache_size = static_cast<uint64>(settings.cache_size_kb) << 10;
+  return string_builder << "SqliteDbSettings[" << tag("cache_size", format::as_size(cache_size))
+                        << tag("mmap_size", format::as_size(static_cast<uint64>(settings.mmap_size)))
+                        << tag("synchronous", settings.synchronous) << tag("temp_store", settings.temp_store)
+                        << tag("wal_autocheckpoint", settings.wal_autocheckpoint)
+                        << tag("page_size", settings.page_size) << ']';
+}
+
 SqliteDb::~SqliteDb() = default;
 
 Status SqliteDb::init(CSlice path, bool allow_creation) {
@@ -139,6 +171,10 @@ Status SqliteDb::exec(CSlice cmd) {
   return Status::OK();
 }
 
+int32 SqliteDb::get_total_changes() const {
+  return tdsqlite3_total_changes(raw_->db());
+}
+
 Result<bool> SqliteDb::has_table(Slice table) {
   TRY_RESULT(stmt, get_statement(PSLICE() << "SELECT count(*) FROM sqlite_master WHERE type='table' AND name='" << table
                                           << "'"));
@@ -181,6 +217,26 @@ Status SqliteDb::set_user_version(int32 version) {
   return exec(PSLICE() << "PRAGMA user_version = " << version);
 }
 
+Status SqliteDb::apply_settings(const SqliteDbSettings &settings) {
+  if (settings.cache_size_kb != 0) {
+    // negative value means size in KiB instead of number of pages
+    TRY_STATUS(exec(PSLICE() << "PRAGMA cache_size = " << -settings.cache_size_kb));
+  }
+  if (settings.mmap_size != 0) {
+    TRY_STATUS(exec(PSLICE() << "PRAGMA mmap_size = " << settings.mmap_size));
+  }
+  if (!settings.synchronous.empty()) {
+    TRY_STATUS(exec(PSLICE() << "PRAGMA synchronous = " << settings.synchronous));
+  }
+  if (!settings.temp_store.empty()) {
+    TRY_STATUS(exec(PSLICE() << "PRAGMA temp_store = " << settings.temp_store));
+  }
+  if (settings.wal_autocheckpoint != 0) {
+    TRY_STATUS(exec(PSLICE() << "PRAGMA wal_autocheckpoint = " << settings.wal_autocheckpoint));
+  }
+  return Status::OK();
+}
+
 Status SqliteDb::begin_read_transaction() {
   if (raw_->on_begin()) {
     return exec("BEGIN");
@@ -15,6 +15,7 @@
 #include "td/utils/optional.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
 
 #include <memory>
 
@@ -22,6 +23,20 @@ struct tdsqlite3;
 
 namespace td {
 
+// settings of SQLite connections; zero and empty values mean SQLite defaults
+struct SqliteDbSettings {
+  int64 cache_size_kb = 0;       // PRAGMA cache_size in KiB
+  int64 mmap_size = 0;           // PRAGMA mmap_size in bytes
+  string synchronous;            // PRAGMA synchronous: OFF, NORMAL, FULL or EXTRA
+  string temp_store;             // PRAGMA temp_store: DEFAULT, FILE or MEMORY
+  int32 wal_autocheckpoint = 0;  // PRAGMA wal_autocheckpoint in pages
+  int32 page_size = 0;           // PRAGMA page_size; can be changed only for newly created unencrypted databases
+
+  Status check() const TD_WARN_UNUSED_RESULT;
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const SqliteDbSettings &settings);
+
 class SqliteDb {
  public:
   SqliteDb() = default;
@@ -44,6 +59,9 @@ class SqliteDb {
   }
 
   Status exec(CSlice cmd) TD_WARN_UNUSED_RESULT;
+
+  // returns total number of rows changed through the connection since it was opened
+  int32 get_total_changes() const;
   Result<bool> has_table(Slice table);
   Result<string> get_pragma(Slice name);
   Result<string> get_pragma_string(Slice name);
@@ -54,6 +72,9 @@ class SqliteDb {
 
   Result<int32> user_version();
   Status set_user_version(int32 version) TD_WARN_UNUSED_RESULT;
+
+  // applies per-connection settings; page_size must be applied separately before the database is created
+  Status apply_settings(const SqliteDbSettings &settings) TD_WARN_UNUSED_RESULT;
   void trace(bool flag);
 
   static Status destroy(Slice path) TD_WARN_UNUSED_RESULT;
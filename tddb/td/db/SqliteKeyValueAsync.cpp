@@ -10,8 +10,11 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/algorithm.h"
 #include "td/utils/common.h"
+#include "td/utils/misc.h"
 #include "td/utils/optional.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Time.h"
 
 namespace td {
@@ -36,6 +39,12 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
   void get(string key, Promise<string> promise) final {
     send_closure_later(impl_, &Impl::get, std::move(key), std::move(promise));
   }
+  void get_many(vector<string> keys, Promise<vector<string>> promise) final {
+    send_closure_later(impl_, &Impl::get_many, std::move(keys), std::move(promise));
+  }
+  void get_by_prefix(string key_prefix, Promise<FlatHashMap<string, string>> promise) final {
+    send_closure_later(impl_, &Impl::get_by_prefix, std::move(key_prefix), std::move(promise));
+  }
   void close(Promise<Unit> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
@@ -47,43 +56,34 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
     }
 
     void set(string key, string value, Promise<Unit> promise) {
-      auto it = buffer_.find(key);
-      if (it != buffer_.end()) {
-        it->second = std::move(value);
-      } else {
-        CHECK(!key.empty());
-        buffer_.emplace(std::move(key), std::move(value));
-      }
+      add_to_buffer(std::move(key), std::move(value));
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
     void set_all(FlatHashMap<string, string> key_values, Promise<Unit> promise) {
-      do_flush(true /*force*/);
-      kv_->set_all(key_values);
-      promise.set_value(Unit());
+      for (auto &key_value : key_values) {
+        add_to_buffer(key_value.first, std::move(key_value.second));
+      }
+      if (promise) {
+        buffer_promises_.push_back(std::move(promise));
+      }
+      do_flush(false /*force*/);
     }
 
     void erase(string key, Promise<Unit> promise) {
-      auto it = buffer_.find(key);
-      if (it != buffer_.end()) {
-        it->second = optional<string>();
-      } else {
-        CHECK(!key.empty());
-        buffer_.emplace(std::move(key), optional<string>());
-      }
+      add_to_buffer(std::move(key), optional<string>());
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
     void erase_by_prefix(string key_prefix, Promise<Unit> promise) {
-      do_flush(true /*force*/);
+      // pending changes of other keys aren't affected, so only changes of the erased keys need to be dropped
+      table_remove_if(buffer_, [&key_prefix](const auto &it) { return begins_with(it.first, key_prefix); });
       kv_->erase_by_prefix(key_prefix);
       promise.set_value(Unit());
     }
@@ -96,6 +96,30 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       promise.set_value(kv_->get(key));
     }
 
+    void get_many(vector<string> keys, Promise<vector<string>> promise) {
+      vector<string> result;
+      result.reserve(keys.size());
+      for (auto &key : keys) {
+        auto it = buffer_.find(key);
+        if (it != buffer_.end()) {
+          result.push_back(it->second ? it->second.value() : string());
+        } else {
+          result.push_back(kv_->get(key));
+        }
+      }
+      promise.set_value(std::move(result));
+    }
+
+    void get_by_prefix(const string &key_prefix, Promise<FlatHashMap<string, string>> promise) {
+      do_flush(true /*force*/);
+      FlatHashMap<string, string> result;
+      kv_->get_by_prefix(key_prefix, [&result](Slice key, Slice value) {
+        result.emplace(key.str(), value.str());
+        return true;
+      });
+      promise.set_value(std::move(result));
+    }
+
     void close(Promise<Unit> promise) {
       do_flush(true /*force*/);
       kv_safe_.reset();
@@ -115,8 +139,24 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
     size_t cnt_ = 0;
 
     double wakeup_at_ = 0;
+
+    void add_to_buffer(string key, optional<string> value) {
+      auto it = buffer_.find(key);
+      if (it != buffer_.end()) {
+        it->second = std::move(value);
+      } else {
+        CHECK(!key.empty());
+        buffer_.emplace(std::move(key), std::move(value));
+      }
+      cnt_++;
+    }
+
     void do_flush(bool force) {
       if (buffer_.empty()) {
+        // all pending changes could have been dropped by erase_by_prefix
+        wakeup_at_ = 0;
+        cnt_ = 0;
+        set_promises(buffer_promises_);
         return;
       }
 
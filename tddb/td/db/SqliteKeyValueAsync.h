@@ -30,6 +30,12 @@ class SqliteKeyValueAsyncInterface {
 
   virtual void get(string key, Promise<string> promise) = 0;
 
+  // returns values in the order of the keys; absent keys have empty values
+  virtual void get_many(vector<string> keys, Promise<vector<string>> promise) = 0;
+
+  // returns all key-value pairs with the given prefix; the prefix is removed from the returned keys
+  virtual void get_by_prefix(string key_prefix, Promise<FlatHashMap<string, string>> promise) = 0;
+
   virtual void close(Promise<Unit> promise) = 0;
 };
 
@@ -7,6 +7,7 @@
 #include "td/db/SqliteStatement.h"
 
 #include "td/utils/format.h"
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/logging.h"
 #include "td/utils/StackAllocator.h"
 #include "td/utils/StringBuilder.h"
@@ -180,7 +181,11 @@ Status SqliteStatement::step() {
   }
   VLOG(sqlite) << "Start step " << tag("query", tdsqlite3_sql(stmt_.get())) << tag("statement", stmt_.get())
                << tag("database", db_.get());
-  auto rc = tdsqlite3_step(stmt_.get());
+  int rc;
+  {
+    LatencyHistogram::Timer timer(db_->get_step_latency_histogram());
+    rc = tdsqlite3_step(stmt_.get());
+  }
   VLOG(sqlite) << "Finish step with response " << (rc == SQLITE_ROW ? "ROW" : (rc == SQLITE_DONE ? "DONE" : "ERROR"));
   if (rc == SQLITE_ROW) {
     state_ = State::HaveRow;
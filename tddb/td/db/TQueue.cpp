@@ -11,17 +11,24 @@
 #include "td/db/binlog/BinlogHelper.h"
 #include "td/db/binlog/BinlogInterface.h"
 
+#include "td/utils/buffer.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/StorerBase.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
+#include "td/utils/VectorQueue.h"
 
-#include <set>
+#include <algorithm>
+#include <map>
 
 namespace td {
 
@@ -86,8 +93,22 @@ class TQueueImpl final : public TQueue {
   static constexpr size_t MAX_EVENT_LENGTH = 65536 * 8;
   static constexpr size_t MAX_QUEUE_EVENTS = 100000;
   static constexpr size_t MAX_TOTAL_EVENT_LENGTH = 1 << 27;
+  // number of first events of a queue, data of which is never moved to disk
+  static constexpr size_t MIN_IN_MEMORY_EVENT_COUNT = 100;
+  static constexpr size_t MAX_DISK_SEGMENT_SIZE = 1 << 26;
 
  public:
+  TQueueImpl() = default;
+  TQueueImpl(const TQueueImpl &) = delete;
+  TQueueImpl &operator=(const TQueueImpl &) = delete;
+  TQueueImpl(TQueueImpl &&) = delete;
+  TQueueImpl &operator=(TQueueImpl &&) = delete;
+  ~TQueueImpl() final {
+    for (auto &it : disk_segments_) {
+      delete_disk_segment_file(it.second);
+    }
+  }
+
   void set_callback(unique_ptr<StorageCallback> callback) final {
     callback_ = std::move(callback);
   }
@@ -102,7 +123,7 @@ class TQueueImpl final : public TQueue {
       return false;
     }
     auto &q = queues_[queue_id];
-    if (q.events.size() >= MAX_QUEUE_EVENTS || q.total_event_length > MAX_TOTAL_EVENT_LENGTH - raw_event.data.size() ||
+    if (q.event_count >= MAX_QUEUE_EVENTS || q.total_event_length > MAX_TOTAL_EVENT_LENGTH - raw_event.data.size() ||
         raw_event.expires_at <= 0) {
       return false;
     }
@@ -112,25 +133,43 @@ class TQueueImpl final : public TQueue {
     }
 
     if (!q.events.empty()) {
-      auto it = q.events.end();
-      --it;
-      if (it->second.data.empty()) {
-        if (callback_ != nullptr && it->second.log_event_id != 0) {
-          callback_->pop(it->second.log_event_id);
+      auto &last_event = q.events.back();
+      if (!has_data(last_event)) {
+        if (callback_ != nullptr && last_event.log_event_id != 0) {
+          callback_->pop(last_event.log_event_id);
         }
-        q.events.erase(it);
+        remove_event(q, last_event);
+        remove_deleted_events(q);
       }
     }
-    if (q.events.empty() && !raw_event.data.empty()) {
-      schedule_queue_gc(queue_id, q, raw_event.expires_at);
-    }
-
     if (raw_event.log_event_id == 0 && callback_ != nullptr) {
       raw_event.log_event_id = callback_->push(queue_id, raw_event);
     }
     q.tail_id = event_id.next().move_as_ok();
     q.total_event_length += raw_event.data.size();
-    q.events.emplace(event_id, std::move(raw_event));
+    q.event_count++;
+
+    StoredEvent event;
+    event.log_event_id = raw_event.log_event_id;
+    event.event_id = event_id;
+    event.expires_at = raw_event.expires_at;
+    event.extra = raw_event.extra;
+    if (!raw_event.data.empty()) {
+      if (need_store_on_disk(q, raw_event.data.size())) {
+        auto status = store_event_data_on_disk(event, raw_event.data);
+        if (status.is_error()) {
+          LOG(WARNING) << "Failed to store TQueue event data on disk: " << status;
+        }
+      }
+      if (event.disk_segment_id == 0) {
+        event.data = BufferSlice(raw_event.data);
+        in_memory_event_length_ += event.data.size();
+      }
+    }
+    q.events.push(std::move(event));
+    if (!raw_event.data.empty()) {
+      expiring_events_[raw_event.expires_at].push_back({queue_id, event_id});
+    }
     return true;
   }
 
@@ -146,7 +185,7 @@ class TQueueImpl final : public TQueue {
     }
 
     auto &q = queues_[queue_id];
-    if (q.events.size() >= MAX_QUEUE_EVENTS) {
+    if (q.event_count >= MAX_QUEUE_EVENTS) {
       return Status::Error("Queue is full");
     }
     if (q.total_event_length > MAX_TOTAL_EVENT_LENGTH - data.size()) {
@@ -171,9 +210,13 @@ class TQueueImpl final : public TQueue {
       if (event_id.next().is_ok()) {
         break;
       }
-      for (auto it = q.events.begin(); it != q.events.end();) {
-        pop(q, queue_id, it, {});
+      for (auto &event : q.events.as_mutable_span()) {
+        if (!is_deleted_event(event)) {
+          pop(q, queue_id, event, {});
+        }
       }
+      remove_deleted_events(q);
+      CHECK(q.events.empty());
       q.tail_id = EventId();
       CHECK(hint_new_id.next().is_ok());
     }
@@ -211,11 +254,13 @@ class TQueueImpl final : public TQueue {
       return;
     }
     auto &q = q_it->second;
-    auto it = q.events.find(event_id);
-    if (it == q.events.end()) {
+    auto events = q.events.as_mutable_span();
+    auto it = find_event(events, event_id);
+    if (it == events.end() || it->event_id != event_id || is_deleted_event(*it)) {
       return;
     }
-    pop(q, queue_id, it, q.tail_id);
+    pop(q, queue_id, *it, q.tail_id);
+    remove_deleted_events(q);
   }
 
   std::map<EventId, RawEvent> clear(QueueId queue_id, size_t keep_count) final {
@@ -232,29 +277,29 @@ class TQueueImpl final : public TQueue {
     auto start_time = Time::now();
     auto total_event_length = q.total_event_length;
 
-    auto end_it = q.events.end();
-    for (size_t i = 0; i < keep_count; i++) {
-      --end_it;
-    }
+    // after compaction events in the queue are exactly the non-deleted events
+    compact_events(q);
+    auto events = q.events.as_mutable_span();
+    CHECK(events.size() == q.event_count);
+    auto end_pos = events.size() - keep_count;
     if (keep_count == 0) {
-      --end_it;
-      auto &event = end_it->second;
-      if (callback_ == nullptr || event.log_event_id == 0) {
-        ++end_it;
-      } else if (!event.data.empty()) {
-        clear_event_data(q, event);
-        callback_->push(queue_id, event);
+      auto &event = events.back();
+      if (callback_ != nullptr && event.log_event_id != 0) {
+        end_pos--;
+        if (has_data(event)) {
+          clear_event_data(q, event);
+          callback_->push(queue_id, get_raw_event(event));
+        }
       }
     }
 
     auto collect_deleted_event_ids_time = 0.0;
     if (callback_ != nullptr) {
       vector<uint64> deleted_log_event_ids;
-      deleted_log_event_ids.reserve(size - keep_count);
-      for (auto it = q.events.begin(); it != end_it; ++it) {
-        auto &event = it->second;
-        if (event.log_event_id != 0) {
-          deleted_log_event_ids.push_back(event.log_event_id);
+      deleted_log_event_ids.reserve(end_pos);
+      for (size_t i = 0; i < end_pos; i++) {
+        if (events[i].log_event_id != 0) {
+          deleted_log_event_ids.push_back(events[i].log_event_id);
         }
       }
       collect_deleted_event_ids_time = Time::now() - start_time;
@@ -263,23 +308,13 @@ class TQueueImpl final : public TQueue {
     auto callback_clear_time = Time::now() - start_time;
 
     std::map<EventId, RawEvent> deleted_events;
-    if (keep_count > size / 2) {
-      for (auto it = q.events.begin(); it != end_it;) {
-        q.total_event_length -= it->second.data.size();
-        bool is_inserted = deleted_events.emplace(it->first, std::move(it->second)).second;
-        CHECK(is_inserted);
-        it = q.events.erase(it);
-      }
-    } else {
-      q.total_event_length = 0;
-      for (auto it = end_it; it != q.events.end();) {
-        q.total_event_length += it->second.data.size();
-        bool is_inserted = deleted_events.emplace(it->first, std::move(it->second)).second;
-        CHECK(is_inserted);
-        it = q.events.erase(it);
-      }
-      std::swap(deleted_events, q.events);
+    for (size_t i = 0; i < end_pos; i++) {
+      deleted_events.emplace_hint(deleted_events.end(), events[i].event_id, get_raw_event(events[i]));
+      clear_event_data(q, events[i]);
     }
+    CHECK(deleted_events.size() == end_pos);
+    q.event_count -= end_pos;
+    q.events.pop_n(end_pos);
 
     auto clear_time = Time::now() - start_time;
     if (clear_time > 0.02) {
@@ -316,44 +351,23 @@ class TQueueImpl final : public TQueue {
     int64 deleted_events = 0;
     auto max_finish_time = Time::now() + 0.05;
     int64 counter = 0;
-    while (!queue_gc_at_.empty()) {
-      auto it = queue_gc_at_.begin();
+    while (!expiring_events_.empty()) {
+      auto it = expiring_events_.begin();
       if (it->first >= unix_time_now) {
         break;
       }
-      auto queue_id = it->second;
-      auto &q = queues_[queue_id];
-      CHECK(q.gc_at == it->first);
-      int32 new_gc_at = 0;
-
-      if (!q.events.empty()) {
-        size_t size_before = get_size(q);
-        for (auto event_it = q.events.begin(); event_it != q.events.end();) {
-          auto &event = event_it->second;
-          if ((++counter & 128) == 0 && Time::now() >= max_finish_time) {
-            if (new_gc_at == 0) {
-              new_gc_at = event.expires_at;
-            }
-            break;
-          }
-          if (event.expires_at < unix_time_now || event.data.empty()) {
-            pop(q, queue_id, event_it, q.tail_id);
-          } else {
-            if (new_gc_at != 0) {
-              break;
-            }
-            new_gc_at = event.expires_at;
-            ++event_it;
-          }
+      auto &events = it->second;
+      while (!events.empty()) {
+        if ((++counter & 127) == 0 && Time::now() >= max_finish_time) {
+          return {deleted_events, false};
+        }
+        auto event = events.back();
+        events.pop_back();
+        if (delete_expired_event(event, unix_time_now)) {
+          deleted_events++;
         }
-        size_t size_after = get_size(q);
-        CHECK(size_after <= size_before);
-        deleted_events += size_before - size_after;
-      }
-      schedule_queue_gc(queue_id, q, new_gc_at);
-      if (Time::now() >= max_finish_time) {
-        return {deleted_events, false};
       }
+      expiring_events_.erase(it);
     }
     return {deleted_events, true};
   }
@@ -366,6 +380,26 @@ class TQueueImpl final : public TQueue {
     return get_size(it->second);
   }
 
+  Status enable_disk_storage(string directory, size_t max_memory_usage) final {
+    if (!disk_segments_.empty()) {
+      return Status::Error("Disk storage is already in use");
+    }
+    if (directory.empty()) {
+      return Status::Error("Directory must be non-empty");
+    }
+    TRY_RESULT(directory_stat, stat(directory));
+    if (!directory_stat.is_dir_) {
+      return Status::Error("Not a directory");
+    }
+    if (directory.back() != TD_DIR_SLASH) {
+      directory += TD_DIR_SLASH;
+    }
+    disk_directory_ = std::move(directory);
+    disk_file_prefix_ = PSTRING() << disk_directory_ << "tqueue_" << Random::secure_uint64() << '_';
+    max_memory_usage_ = max_memory_usage;
+    return Status::OK();
+  }
+
   void close(Promise<> promise) final {
     if (callback_ != nullptr) {
       callback_->close(std::move(promise));
@@ -374,22 +408,185 @@ class TQueueImpl final : public TQueue {
   }
 
  private:
+  // payloads shorter than 512 bytes are packed by BufferAllocator into shared chunks
+  struct StoredEvent {
+    uint64 log_event_id{0};
+    EventId event_id;
+    int32 expires_at{0};  // 0 for deleted events
+    int64 extra{0};
+    BufferSlice data;
+    // location of the data if it is stored on disk
+    uint32 disk_segment_id{0};
+    uint32 disk_data_offset{0};
+    uint32 disk_data_size{0};
+  };
+
   struct Queue {
     EventId tail_id;
-    std::map<EventId, RawEvent> events;
+    // events sorted by identifier; the first and the last events are never deleted
+    VectorQueue<StoredEvent> events;
+    size_t event_count = 0;  // number of non-deleted events
     size_t total_event_length = 0;
-    int32 gc_at = 0;
+  };
+
+  struct ExpiringEvent {
+    QueueId queue_id;
+    EventId event_id;
+  };
+
+  // append-only file with data of events; it is deleted after all its events are deleted
+  struct DiskSegment {
+    string path;
+    FileFd fd;
+    size_t size = 0;
+    size_t used_size = 0;
   };
 
   FlatHashMap<QueueId, Queue> queues_;
-  std::set<std::pair<int32, QueueId>> queue_gc_at_;
+  // events by expiration date; the events could have been already deleted
+  std::map<int32, vector<ExpiringEvent>> expiring_events_;
   unique_ptr<StorageCallback> callback_;
 
+  string disk_directory_;
+  string disk_file_prefix_;
+  size_t max_memory_usage_ = 0;
+  size_t in_memory_event_length_ = 0;
+  std::map<uint32, DiskSegment> disk_segments_;
+  uint32 current_disk_segment_id_ = 0;
+
+  static bool is_deleted_event(const StoredEvent &event) {
+    return event.expires_at == 0;
+  }
+
+  static size_t get_data_size(const StoredEvent &event) {
+    return event.disk_segment_id != 0 ? event.disk_data_size : event.data.size();
+  }
+
+  static bool has_data(const StoredEvent &event) {
+    return get_data_size(event) != 0;
+  }
+
+  RawEvent get_raw_event(const StoredEvent &event) const {
+    RawEvent raw_event;
+    raw_event.log_event_id = event.log_event_id;
+    raw_event.event_id = event.event_id;
+    raw_event.expires_at = event.expires_at;
+    if (event.disk_segment_id != 0) {
+      auto r_data = read_event_data_from_disk(event);
+      if (r_data.is_error()) {
+        LOG(ERROR) << "Failed to read TQueue event data: " << r_data.error();
+      } else {
+        raw_event.data = r_data.ok().as_slice().str();
+      }
+    } else {
+      raw_event.data = event.data.as_slice().str();
+    }
+    raw_event.extra = event.extra;
+    return raw_event;
+  }
+
+  bool need_store_on_disk(const Queue &q, size_t data_size) const {
+    return !disk_directory_.empty() && q.event_count > MIN_IN_MEMORY_EVENT_COUNT &&
+           in_memory_event_length_ + data_size > max_memory_usage_;
+  }
+
+  Status store_event_data_on_disk(StoredEvent &event, Slice data) {
+    auto segment_it = disk_segments_.find(current_disk_segment_id_);
+    if (segment_it == disk_segments_.end() || segment_it->second.size + data.size() > MAX_DISK_SEGMENT_SIZE) {
+      if (segment_it != disk_segments_.end() && segment_it->second.used_size == 0) {
+        delete_disk_segment_file(segment_it->second);
+        disk_segments_.erase(segment_it);
+      }
+      DiskSegment segment;
+      auto segment_id = current_disk_segment_id_ + 1;
+      segment.path = PSTRING() << disk_file_prefix_ << segment_id;
+      TRY_RESULT_ASSIGN(segment.fd,
+                        FileFd::open(segment.path, FileFd::Create | FileFd::Truncate | FileFd::Read | FileFd::Write));
+      current_disk_segment_id_ = segment_id;
+      segment_it = disk_segments_.emplace(segment_id, std::move(segment)).first;
+    }
+
+    auto &segment = segment_it->second;
+    size_t written_size = 0;
+    while (written_size < data.size()) {
+      TRY_RESULT(size, segment.fd.pwrite(data.substr(written_size), segment.size + written_size));
+      if (size == 0) {
+        return Status::Error("Failed to write to the file");
+      }
+      written_size += size;
+    }
+    event.disk_segment_id = segment_it->first;
+    event.disk_data_offset = narrow_cast<uint32>(segment.size);
+    event.disk_data_size = narrow_cast<uint32>(data.size());
+    segment.size += data.size();
+    segment.used_size += data.size();
+    return Status::OK();
+  }
+
+  Result<BufferSlice> read_event_data_from_disk(const StoredEvent &event) const {
+    auto segment_it = disk_segments_.find(event.disk_segment_id);
+    CHECK(segment_it != disk_segments_.end());
+    BufferSlice data(event.disk_data_size);
+    size_t read_size = 0;
+    while (read_size < data.size()) {
+      TRY_RESULT(size, segment_it->second.fd.pread(data.as_mutable_slice().substr(read_size),
+                                                   event.disk_data_offset + read_size));
+      if (size == 0) {
+        return Status::Error("Unexpected end of file");
+      }
+      read_size += size;
+    }
+    return std::move(data);
+  }
+
+  // moves event data from disk to memory; returns false if the data can't be read
+  bool load_event_data(StoredEvent &event) {
+    auto r_data = read_event_data_from_disk(event);
+    if (r_data.is_error()) {
+      LOG(ERROR) << "Failed to read TQueue event data: " << r_data.error();
+      return false;
+    }
+    delete_disk_data(event);
+    event.data = r_data.move_as_ok();
+    in_memory_event_length_ += event.data.size();
+    return true;
+  }
+
+  void delete_disk_data(StoredEvent &event) {
+    auto segment_it = disk_segments_.find(event.disk_segment_id);
+    CHECK(segment_it != disk_segments_.end());
+    auto &segment = segment_it->second;
+    CHECK(segment.used_size >= event.disk_data_size);
+    segment.used_size -= event.disk_data_size;
+    event.disk_segment_id = 0;
+    event.disk_data_offset = 0;
+    event.disk_data_size = 0;
+    if (segment.used_size == 0) {
+      if (segment_it->first == current_disk_segment_id_) {
+        // the file can be overwritten from the beginning
+        segment.size = 0;
+      } else {
+        delete_disk_segment_file(segment);
+        disk_segments_.erase(segment_it);
+      }
+    }
+  }
+
+  static void delete_disk_segment_file(DiskSegment &segment) {
+    segment.fd.close();
+    unlink(segment.path).ignore();
+  }
+
+  static StoredEvent *find_event(MutableSpan<StoredEvent> events, EventId event_id) {
+    return std::lower_bound(events.begin(), events.end(), event_id,
+                            [](const StoredEvent &event, EventId event_id) { return event.event_id < event_id; });
+  }
+
   static EventId get_queue_head(const Queue &q) {
     if (q.events.empty()) {
       return q.tail_id;
     }
-    return q.events.begin()->first;
+    return q.events.front().event_id;
   }
 
   static size_t get_size(const Queue &q) {
@@ -397,80 +594,133 @@ class TQueueImpl final : public TQueue {
       return 0;
     }
 
-    return q.events.size() - (q.events.rbegin()->second.data.empty() ? 1 : 0);
+    return q.event_count - (has_data(q.events.back()) ? 0 : 1);
   }
 
-  void pop(Queue &q, QueueId queue_id, std::map<EventId, RawEvent>::iterator &it, EventId tail_id) {
-    auto &event = it->second;
+  void pop(Queue &q, QueueId queue_id, StoredEvent &event, EventId tail_id) {
     if (callback_ == nullptr || event.log_event_id == 0) {
-      remove_event(q, it);
+      remove_event(q, event);
       return;
     }
 
     if (event.event_id.next().ok() == tail_id) {
-      if (!event.data.empty()) {
+      if (has_data(event)) {
         clear_event_data(q, event);
-        callback_->push(queue_id, event);
+        callback_->push(queue_id, get_raw_event(event));
       }
-      ++it;
     } else {
       callback_->pop(event.log_event_id);
-      remove_event(q, it);
+      remove_event(q, event);
     }
   }
 
-  static void remove_event(Queue &q, std::map<EventId, RawEvent>::iterator &it) {
-    q.total_event_length -= it->second.data.size();
-    it = q.events.erase(it);
+  // the event is only marked as deleted; remove_deleted_events must be called before the queue is used again
+  void remove_event(Queue &q, StoredEvent &event) {
+    CHECK(!is_deleted_event(event));
+    clear_event_data(q, event);
+    event.log_event_id = 0;
+    event.expires_at = 0;
+    q.event_count--;
   }
 
-  static void clear_event_data(Queue &q, RawEvent &event) {
-    q.total_event_length -= event.data.size();
-    event.data = {};
+  void clear_event_data(Queue &q, StoredEvent &event) {
+    q.total_event_length -= get_data_size(event);
+    if (event.disk_segment_id != 0) {
+      delete_disk_data(event);
+    } else {
+      in_memory_event_length_ -= event.data.size();
+      event.data = {};
+    }
+  }
+
+  static void remove_deleted_events(Queue &q) {
+    auto events = q.events.as_mutable_span();
+    size_t deleted_prefix_size = 0;
+    while (deleted_prefix_size < events.size() && is_deleted_event(events[deleted_prefix_size])) {
+      deleted_prefix_size++;
+    }
+    q.events.pop_n(deleted_prefix_size);
+    while (!q.events.empty() && is_deleted_event(q.events.back())) {
+      q.events.pop_back();
+    }
+    if (q.events.size() > 2 * q.event_count + 16) {
+      compact_events(q);
+    }
+  }
+
+  static void compact_events(Queue &q) {
+    if (q.events.size() == q.event_count) {
+      return;
+    }
+    VectorQueue<StoredEvent> events;
+    for (auto &event : q.events.as_mutable_span()) {
+      if (!is_deleted_event(event)) {
+        events.push(std::move(event));
+      }
+    }
+    q.events = std::move(events);
   }
 
   void do_get(QueueId queue_id, Queue &q, EventId from_id, bool forget_previous, int32 unix_time_now,
               MutableSpan<Event> &result_events) {
     if (forget_previous) {
-      for (auto it = q.events.begin(); it != q.events.end() && it->first < from_id;) {
-        pop(q, queue_id, it, q.tail_id);
+      for (auto &event : q.events.as_mutable_span()) {
+        if (!(event.event_id < from_id)) {
+          break;
+        }
+        if (!is_deleted_event(event)) {
+          pop(q, queue_id, event, q.tail_id);
+        }
       }
     }
 
     size_t ready_n = 0;
-    for (auto it = q.events.lower_bound(from_id); it != q.events.end();) {
-      auto &event = it->second;
-      if (event.expires_at < unix_time_now || event.data.empty()) {
-        pop(q, queue_id, it, q.tail_id);
+    auto events = q.events.as_mutable_span();
+    for (auto it = find_event(events, from_id); it != events.end(); ++it) {
+      auto &event = *it;
+      if (is_deleted_event(event)) {
+        continue;
+      }
+      if (event.expires_at < unix_time_now || !has_data(event)) {
+        pop(q, queue_id, event, q.tail_id);
       } else {
         CHECK(!(event.event_id < from_id));
         if (ready_n == result_events.size()) {
           break;
         }
+        if (event.disk_segment_id != 0 && !load_event_data(event)) {
+          pop(q, queue_id, event, q.tail_id);
+          continue;
+        }
 
         auto &to = result_events[ready_n];
-        to.data = event.data;
+        to.data = event.data.as_slice();
         to.id = event.event_id;
         to.expires_at = event.expires_at;
         to.extra = event.extra;
         ready_n++;
-        ++it;
       }
     }
+    remove_deleted_events(q);
 
     result_events.truncate(ready_n);
   }
 
-  void schedule_queue_gc(QueueId queue_id, Queue &q, int32 gc_at) {
-    if (q.gc_at != 0) {
-      bool is_deleted = queue_gc_at_.erase({q.gc_at, queue_id}) > 0;
-      CHECK(is_deleted);
+  bool delete_expired_event(const ExpiringEvent &expiring_event, int32 unix_time_now) {
+    auto queue_it = queues_.find(expiring_event.queue_id);
+    if (queue_it == queues_.end()) {
+      return false;
     }
-    q.gc_at = gc_at;
-    if (q.gc_at != 0) {
-      bool is_inserted = queue_gc_at_.emplace(gc_at, queue_id).second;
-      CHECK(is_inserted);
+    auto &q = queue_it->second;
+    auto events = q.events.as_mutable_span();
+    auto it = find_event(events, expiring_event.event_id);
+    if (it == events.end() || it->event_id != expiring_event.event_id || is_deleted_event(*it) || !has_data(*it) ||
+        it->expires_at >= unix_time_now) {
+      return false;
     }
+    pop(q, expiring_event.queue_id, *it, q.tail_id);
+    remove_deleted_events(q);
+    return true;
   }
 };
 
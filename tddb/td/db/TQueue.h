@@ -115,6 +115,11 @@ class TQueue {
 
   virtual size_t get_size(QueueId queue_id) const = 0;
 
+  // if total size of data of events kept in memory exceeds max_memory_usage, then data of new events,
+  // which aren't among the first events of their queue, is stored in temporary files in the specified directory
+  // the data is read back when the events are returned by get
+  virtual Status enable_disk_storage(string directory, size_t max_memory_usage) = 0;
+
   // returns number of deleted events and whether garbage collection was completed
   virtual std::pair<int64, bool> run_gc(int32 unix_time_now) = 0;
   virtual void close(Promise<> promise) = 0;
@@ -0,0 +1,49 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/db/WriteBatchPolicy.h"
+
+#include "td/utils/format.h"
+#include "td/utils/misc.h"
+
+namespace td {
+
+void WriteBatchPolicy::on_transaction_committed(size_t query_count, double commit_time, bool is_full) {
+  stats_.transaction_count++;
+  stats_.query_count += query_count;
+  stats_.max_transaction_size = max(stats_.max_transaction_size, query_count);
+  stats_.total_commit_time += commit_time;
+  stats_.max_commit_time = max(stats_.max_commit_time, commit_time);
+
+  if (average_commit_time_ == 0.0) {
+    average_commit_time_ = commit_time;
+  } else {
+    average_commit_time_ = 0.9 * average_commit_time_ + 0.1 * commit_time;
+  }
+
+  if (is_full) {
+    // the queue grows faster than transactions are committed, so commit it less often
+    max_pending_query_count_ = min(max_pending_query_count_ * 2, MAX_PENDING_QUERY_COUNT);
+  } else if (query_count * 4 < max_pending_query_count_) {
+    max_pending_query_count_ = max(max_pending_query_count_ / 2, MIN_PENDING_QUERY_COUNT);
+  }
+
+  // waiting for longer than a few commits gives almost nothing, but increases latency
+  flush_delay_ = clamp(2 * average_commit_time_, MIN_FLUSH_DELAY, MAX_FLUSH_DELAY);
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const WriteBatchPolicy::Stats &stats) {
+  auto average_transaction_size =
+      stats.transaction_count == 0 ? 0.0 : static_cast<double>(stats.query_count) / stats.transaction_count;
+  auto average_commit_time = stats.transaction_count == 0 ? 0.0 : stats.total_commit_time / stats.transaction_count;
+  return string_builder << tag("transactions", stats.transaction_count) << tag("queries", stats.query_count)
+                        << tag("average_transaction_size", average_transaction_size)
+                        << tag("max_transaction_size", stats.max_transaction_size)
+                        << tag("average_commit_time", format::as_time(average_commit_time))
+                        << tag("max_commit_time", format::as_time(stats.max_commit_time));
+}
+
+}  // namespace td
@@ -0,0 +1,60 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/StringBuilder.h"
+
+namespace td {
+
+// chooses size of write transactions of asynchronous databases
+// transactions become bigger while writes come faster than they are committed, for example, during catch up
+// after a long offline period, and smaller with a delay bound by commit latency, when writes are rare
+class WriteBatchPolicy {
+ public:
+  struct Stats {
+    uint64 transaction_count = 0;
+    uint64 query_count = 0;
+    size_t max_transaction_size = 0;
+    double total_commit_time = 0.0;
+    double max_commit_time = 0.0;
+  };
+
+  // returns true, if pending queries must be committed immediately
+  bool need_flush(size_t pending_query_count) const {
+    return pending_query_count >= max_pending_query_count_;
+  }
+
+  // returns maximum time, which a pending query can wait before being committed
+  double get_flush_delay() const {
+    return flush_delay_;
+  }
+
+  // must be called after a transaction with query_count queries was committed
+  // is_full must be true, if the transaction was committed, because need_flush returned true
+  void on_transaction_committed(size_t query_count, double commit_time, bool is_full);
+
+  const Stats &get_stats() const {
+    return stats_;
+  }
+
+ private:
+  static constexpr size_t MIN_PENDING_QUERY_COUNT = 50;
+  static constexpr size_t MAX_PENDING_QUERY_COUNT = 10000;
+  static constexpr double MIN_FLUSH_DELAY = 0.002;
+  static constexpr double MAX_FLUSH_DELAY = 0.05;
+
+  size_t max_pending_query_count_ = MIN_PENDING_QUERY_COUNT;
+  double flush_delay_ = 0.01;
+  double average_commit_time_ = 0.0;
+
+  Stats stats_;
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const WriteBatchPolicy::Stats &stats);
+
+}  // namespace td
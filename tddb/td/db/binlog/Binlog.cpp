@@ -11,13 +11,17 @@
 
 #include "td/utils/buffer.h"
 #include "td/utils/format.h"
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/misc.h"
+#include "td/utils/PathView.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/MemoryMapping.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
@@ -26,6 +30,9 @@
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 
+#include <map>
+#include <utility>
+
 namespace td {
 namespace detail {
 struct AesCtrEncryptionEvent {
@@ -102,6 +109,29 @@ class BinlogReader {
     expected_size_ = expected_size;
   }
 
+  // the events are read directly from the memory-mapped binlog, which must be kept alive while the reader is used
+  void set_mapped_input(Slice data) {
+    is_mapped_ = true;
+    mapped_data_ = data;
+    expected_size_ = static_cast<int64>(data.size());
+  }
+
+  // the rest of the memory-mapped binlog is decrypted while it is read
+  void set_mapped_aes_ctr_state(AesCtrState &&aes_ctr_state) {
+    CHECK(is_mapped_);
+    CHECK(state_ == State::ReadLength);
+    is_encrypted_ = true;
+    aes_ctr_state_ = std::move(aes_ctr_state);
+  }
+
+  AesCtrState move_mapped_aes_ctr_state() {
+    return std::move(aes_ctr_state_);
+  }
+
+  bool is_mapped() const {
+    return is_mapped_;
+  }
+
   ChainBufferReader *input() {
     return input_;
   }
@@ -110,6 +140,9 @@ class BinlogReader {
     return offset_;
   }
   Result<size_t> read_next(BinlogEvent *event) {
+    if (is_mapped_) {
+      return read_next_mapped(event);
+    }
     if (state_ == State::ReadLength) {
       if (input_->size() < 4) {
         return 4;
@@ -118,30 +151,17 @@ class BinlogReader {
 
       char buf[4];
       it.advance(4, MutableSlice(buf, 4));
-      size_ = static_cast<size_t>(TlParser(Slice(buf, 4)).fetch_int());
-
-      if (size_ > BinlogEvent::MAX_SIZE) {
-        return Status::Error(PSLICE() << "Too big event " << tag("size", size_));
-      }
-      if (size_ < BinlogEvent::MIN_SIZE) {
-        return Status::Error(PSLICE() << "Too small event " << tag("size", size_));
-      }
-      if (size_ % 4 != 0) {
-        return Status::Error(-2, PSLICE() << "Event of size " << size_ << " at offset " << offset() << " out of "
-                                          << expected_size_ << ' ' << tag("is_encrypted", is_encrypted_)
-                                          << format::as_hex_dump<4>(Slice(input_->prepare_read().truncate(28))));
-      }
-      state_ = State::ReadEvent;
+      TRY_STATUS(on_event_size(Slice(buf, 4), Slice(input_->prepare_read())));
     }
 
     if (input_->size() < size_) {
       return size_;
     }
 
+    // the event is validated later by BinlogEventsValidator
     event->debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
     auto buffer_slice = input_->cut_head(size_).move_as_buffer_slice();
     event->init(buffer_slice.as_slice().str());
-    TRY_STATUS(event->validate());
     offset_ += size_;
     event->offset_ = offset_;
     state_ = State::ReadLength;
@@ -156,6 +176,183 @@ class BinlogReader {
   int64 offset_{0};
   int64 expected_size_{0};
   bool is_encrypted_{false};
+
+  bool is_mapped_{false};
+  Slice mapped_data_;
+  AesCtrState aes_ctr_state_;
+  char size_buf_[4];
+
+  Status on_event_size(Slice size_slice, Slice next_data) {
+    size_ = static_cast<size_t>(TlParser(size_slice).fetch_int());
+
+    if (size_ > BinlogEvent::MAX_SIZE) {
+      return Status::Error(PSLICE() << "Too big event " << tag("size", size_));
+    }
+    if (size_ < BinlogEvent::MIN_SIZE) {
+      return Status::Error(PSLICE() << "Too small event " << tag("size", size_));
+    }
+    if (size_ % 4 != 0) {
+      return Status::Error(-2, PSLICE() << "Event of size " << size_ << " at offset " << offset() << " out of "
+                                        << expected_size_ << ' ' << tag("is_encrypted", is_encrypted_)
+                                        << format::as_hex_dump<4>(next_data.truncate(28)));
+    }
+    state_ = State::ReadEvent;
+    return Status::OK();
+  }
+
+  // the only copy of the event is made directly from the mapped file into the event itself
+  Result<size_t> read_next_mapped(BinlogEvent *event) {
+    auto data = mapped_data_.substr(narrow_cast<size_t>(offset_));
+    if (state_ == State::ReadLength) {
+      if (data.size() < 4) {
+        return 4;
+      }
+      if (is_encrypted_) {
+        aes_ctr_state_.decrypt(data.substr(0, 4), MutableSlice(size_buf_, 4));
+      } else {
+        MutableSlice(size_buf_, 4).copy_from(data.substr(0, 4));
+      }
+      TRY_STATUS(on_event_size(Slice(size_buf_, 4), is_encrypted_ ? Slice(size_buf_, 4) : data));
+    }
+
+    if (data.size() < size_) {
+      return size_;
+    }
+
+    string raw_event(size_, '\0');
+    MutableSlice raw_event_slice(raw_event);
+    raw_event_slice.copy_from(Slice(size_buf_, 4));
+    if (is_encrypted_) {
+      aes_ctr_state_.decrypt(data.substr(4, size_ - 4), raw_event_slice.substr(4));
+    } else {
+      raw_event_slice.substr(4).copy_from(data.substr(4, size_ - 4));
+    }
+
+    // the event is validated later by BinlogEventsValidator
+    event->debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
+    event->init(std::move(raw_event));
+    offset_ += size_;
+    event->offset_ = offset_;
+    state_ = State::ReadLength;
+    return 0;
+  }
+};
+
+// checks CRC of read events in other threads, while next events are read and decrypted
+class BinlogEventsValidator {
+ public:
+  BinlogEventsValidator() = default;
+  BinlogEventsValidator(const BinlogEventsValidator &) = delete;
+  BinlogEventsValidator &operator=(const BinlogEventsValidator &) = delete;
+  BinlogEventsValidator(BinlogEventsValidator &&) = delete;
+  BinlogEventsValidator &operator=(BinlogEventsValidator &&) = delete;
+  ~BinlogEventsValidator() {
+    join();
+  }
+
+  // returns whether events must be validated in other threads
+  static bool is_parallel_validation_useful(int64 file_size) {
+    // events are validated faster in the reading thread while they are still in the CPU cache
+    constexpr int64 MIN_FILE_SIZE = 1 << 23;
+#if TD_THREAD_UNSUPPORTED
+    return false;
+#else
+    return file_size >= MIN_FILE_SIZE && thread::hardware_concurrency() > 1;
+#endif
+  }
+
+  void start(vector<BinlogEvent> &&events, size_t total_size) {
+    CHECK(events_.empty());
+    events_ = std::move(events);
+    if (events_.empty()) {
+      return;
+    }
+
+    // a thread is worth creating only if it has enough data to check
+    constexpr size_t MIN_THREAD_DATA_SIZE = 1 << 19;
+    constexpr size_t MAX_THREAD_COUNT = 4;
+    size_t thread_count = 1;
+#if !TD_THREAD_UNSUPPORTED
+    thread_count = clamp(static_cast<size_t>(thread::hardware_concurrency()), static_cast<size_t>(1), MAX_THREAD_COUNT);
+    thread_count = min(thread_count, total_size / MIN_THREAD_DATA_SIZE);
+#endif
+    if (thread_count <= 1) {
+      results_.resize(1);
+      validate(0, 0, events_.size());
+      return;
+    }
+
+#if !TD_THREAD_UNSUPPORTED
+    // split the events into parts of almost equal total size
+    vector<size_t> part_ends;
+    size_t part_size = 0;
+    for (size_t i = 0; i < events_.size(); i++) {
+      part_size += events_[i].raw_event_.size();
+      if (part_size * thread_count >= total_size || part_ends.size() + 1 == thread_count) {
+        if (part_ends.size() + 1 == thread_count) {
+          i = events_.size() - 1;
+        }
+        part_ends.push_back(i + 1);
+        part_size = 0;
+      }
+    }
+    if (part_ends.empty() || part_ends.back() != events_.size()) {
+      part_ends.push_back(events_.size());
+    }
+
+    results_.resize(part_ends.size());
+    size_t begin = 0;
+    for (size_t part = 0; part < part_ends.size(); part++) {
+      auto end = part_ends[part];
+      threads_.push_back(thread([this, part, begin, end] { validate(part, begin, end); }));
+      begin = end;
+    }
+#endif
+  }
+
+  // returns the events before the first invalid event and the validation error
+  std::pair<vector<BinlogEvent>, Status> finish() {
+    join();
+    auto events = std::move(events_);
+    events_.clear();
+    Status status;
+    for (auto &result : results_) {
+      if (result.first != 0) {
+        events.resize(result.first - 1);
+        status = std::move(result.second);
+        break;
+      }
+    }
+    results_.clear();
+    return {std::move(events), std::move(status)};
+  }
+
+ private:
+  vector<BinlogEvent> events_;
+  // 1-based index of the first invalid event in a part and the error
+  vector<std::pair<size_t, Status>> results_;
+#if !TD_THREAD_UNSUPPORTED
+  vector<thread> threads_;
+#endif
+
+  void validate(size_t part, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      auto status = events_[i].validate();
+      if (status.is_error()) {
+        results_[part] = {i + 1, std::move(status)};
+        return;
+      }
+    }
+  }
+
+  void join() {
+#if !TD_THREAD_UNSUPPORTED
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+#endif
+  }
 };
 
 static int64 file_size(CSlice path) {
@@ -169,6 +366,52 @@ static int64 file_size(CSlice path) {
 
 int32 VERBOSITY_NAME(binlog) = VERBOSITY_NAME(DEBUG) + 8;
 
+// state of a regeneration of the binlog, which is done step by step in parallel with addition of new events
+struct Binlog::IncrementalReindex {
+  string path;
+  FileFd fd;
+  bool is_encrypted = false;
+  AesCtrState aes_ctr_state;
+  string buffer;
+
+  // events with identifiers up to last_snapshot_event_id are copied from the events processor in order
+  uint64 last_snapshot_event_id = 0;
+  uint64 next_event_id = 0;
+
+  // events, which were added after the reindex has started and must be written after the copied events
+  vector<string> new_events;
+
+  int64 size = 0;
+  uint64 event_count = 0;
+  double start_time = 0;
+  int64 start_size = 0;
+  uint64 start_events = 0;
+
+  void write_event(Slice raw_event) {
+    auto begin = buffer.size();
+    buffer.append(raw_event.begin(), raw_event.size());
+    if (is_encrypted) {
+      MutableSlice data(&buffer[begin], raw_event.size());
+      aes_ctr_state.encrypt(data, data);
+    }
+    size += static_cast<int64>(raw_event.size());
+    event_count++;
+  }
+
+  Status flush() {
+    Slice data = buffer;
+    while (!data.empty()) {
+      TRY_RESULT(written_size, fd.write(data));
+      if (written_size == 0) {
+        return Status::Error("Failed to write data");
+      }
+      data.remove_prefix(written_size);
+    }
+    buffer.clear();
+    return Status::OK();
+  }
+};
+
 Binlog::Binlog() = default;
 
 Binlog::~Binlog() {
@@ -204,6 +447,9 @@ Status Binlog::init(string path, const Callback &callback, DbKey db_key, DbKey o
   fd_ = BufferedFdBase<FileFd>(std::move(fd));
   fd_size_ = 0;
   path_ = std::move(path);
+  auto file_name = PathView(path_).file_name();
+  flush_latency_histogram_ = LatencyHistogram::get(PSLICE() << "binlog flush " << file_name);
+  sync_latency_histogram_ = LatencyHistogram::get(PSLICE() << "binlog sync " << file_name);
 
   auto status = load_binlog(callback, debug_callback);
   if (status.is_error()) {
@@ -238,7 +484,15 @@ void Binlog::add_event(BinlogEvent &&event) {
   }
   lazy_flush();
 
-  if (state_ == State::Run) {
+  if (is_async_sync_in_progress_) {
+    // the file must not be replaced while it is synced
+    return;
+  }
+  if (state_ == State::Run && incremental_reindex_ != nullptr) {
+    if (Time::now() >= next_reindex_step_time_) {
+      continue_reindex();
+    }
+  } else if (state_ == State::Run) {
     auto fd_size = fd_size_;
     if (events_buffer_) {
       fd_size += events_buffer_->size();
@@ -249,7 +503,7 @@ void Binlog::add_event(BinlogEvent &&event) {
     if (need_reindex(50000, 5) || need_reindex(100000, 4) || need_reindex(300000, 3) || need_reindex(500000, 2)) {
       LOG(INFO) << tag("fd_size", format::as_size(fd_size))
                 << tag("total events size", format::as_size(processor_->total_raw_events_size()));
-      do_reindex();
+      start_incremental_reindex();
     }
   }
 }
@@ -285,6 +539,8 @@ Status Binlog::close(bool need_sync) {
   if (fd_.empty()) {
     return Status::OK();
   }
+  CHECK(!is_async_sync_in_progress_);
+  cancel_incremental_reindex();
   if (need_sync) {
     sync("close");
   } else {
@@ -305,6 +561,7 @@ void Binlog::close(Promise<> promise) {
 }
 
 void Binlog::change_key(DbKey new_db_key) {
+  CHECK(!is_async_sync_in_progress_);
   db_key_ = std::move(new_db_key);
   aes_ctr_key_salt_ = string();
   do_reindex();
@@ -380,6 +637,10 @@ void Binlog::do_event(BinlogEvent &&event) {
     }
   }
 
+  if (state_ == State::Run && incremental_reindex_ != nullptr) {
+    on_incremental_reindex_event(event);
+  }
+
   if (state_ != State::Reindex) {
     auto status = processor_->add_event(std::move(event));
     if (status.is_error()) {
@@ -408,17 +669,42 @@ void Binlog::sync(const char *source) {
   flush(source);
   if (need_sync_) {
     LOG(INFO) << "Sync binlog from " << source;
+    FileFd::IoCategoryGuard io_category_guard("binlog");
+    LatencyHistogram::Timer timer(sync_latency_histogram_);
     auto status = fd_.sync();
     LOG_IF(FATAL, status.is_error()) << "Failed to sync binlog: " << status;
     need_sync_ = false;
   }
 }
 
+FileFd *Binlog::start_async_sync(const char *source) {
+  CHECK(!is_async_sync_in_progress_);
+  flush(source);
+  if (!need_sync_) {
+    return nullptr;
+  }
+  LOG(INFO) << "Start binlog sync from " << source;
+  need_sync_ = false;
+  is_async_sync_in_progress_ = true;
+  return &fd_;
+}
+
+void Binlog::finish_async_sync(Status status, double sync_time) {
+  CHECK(is_async_sync_in_progress_);
+  LOG_IF(FATAL, status.is_error()) << "Failed to sync binlog: " << status;
+  is_async_sync_in_progress_ = false;
+  if (sync_latency_histogram_ != nullptr) {
+    sync_latency_histogram_->add(sync_time);
+  }
+}
+
 void Binlog::flush(const char *source) {
   if (state_ == State::Load) {
     return;
   }
   LOG(DEBUG) << "Flush binlog from " << source;
+  FileFd::IoCategoryGuard io_category_guard("binlog");
+  LatencyHistogram::Timer timer(flush_latency_histogram_);
   flush_events_buffer(true);
   // NB: encryption happens during flush
   if (byte_flow_flag_) {
@@ -467,6 +753,11 @@ void Binlog::update_read_encryption() {
       break;
     }
     case EncryptionType::AesCtr: {
+      if (binlog_reader_ptr_->is_mapped()) {
+        binlog_reader_ptr_->set_mapped_aes_ctr_state(std::move(aes_ctr_state_));
+        byte_flow_flag_ = false;
+        break;
+      }
       byte_flow_source_ = ByteFlowSource(&buffer_reader_);
       aes_xcode_byte_flow_ = AesCtrByteFlow();
       aes_xcode_byte_flow_.init(std::move(aes_ctr_state_));
@@ -512,12 +803,67 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
   update_read_encryption();
 
+  // the binlog is read directly from the page cache if possible
+  TRY_RESULT(binlog_size, fd_.get_size());
+  Result<MemoryMapping> r_mapping = Status::Error("Binlog is empty");
+  if (binlog_size > 0) {
+    r_mapping = MemoryMapping::create_from_file(fd_, MemoryMapping::Options().with_size(binlog_size));
+  }
+  if (r_mapping.is_ok()) {
+    reader.set_mapped_input(r_mapping.ok().as_slice());
+    // next writes must be appended to the end of the file as if it was read
+    TRY_STATUS(fd_.seek(binlog_size));
+  } else if (binlog_size > 0) {
+    LOG(WARNING) << "Failed to map binlog \"" << path_ << "\" to memory: " << r_mapping.error();
+  }
+
   fd_.get_poll_info().add_flags(PollFlags::Read());
   info_.wrong_password = false;
+
+  // returns false if the loading must be stopped
+  auto add_event = [&](BinlogEvent &&event) {
+    if (debug_callback) {
+      debug_callback(event);
+    }
+    do_add_event(std::move(event));
+    return !info_.wrong_password;
+  };
+
+  // big binlogs are read and decrypted by batches; CRC of a batch is checked while the next batch is read
+  bool use_validator = detail::BinlogEventsValidator::is_parallel_validation_useful(binlog_size);
+  constexpr size_t MAX_BATCH_SIZE = 1 << 22;
+  detail::BinlogEventsValidator validator;
+  vector<BinlogEvent> batch;
+  size_t batch_size = 0;
+  // adds validated events and starts validation of the current batch
+  auto flush_batch = [&] {
+    auto result = validator.finish();
+    validator.start(std::move(batch), batch_size);
+    batch = vector<BinlogEvent>();
+    batch_size = 0;
+    for (auto &event : result.first) {
+      if (!add_event(std::move(event))) {
+        return false;
+      }
+    }
+    if (result.second.is_error()) {
+      LOG(ERROR) << result.second;
+      return false;
+    }
+    return true;
+  };
+  // adds all read events
+  auto flush_all = [&] {
+    return flush_batch() && flush_batch();
+  };
+
   while (true) {
     BinlogEvent event;
     auto r_need_size = reader.read_next(&event);
     if (r_need_size.is_error()) {
+      if (!flush_all()) {
+        break;
+      }
       if (r_need_size.error().code() == -2) {
         auto old_size = detail::file_size(path_);
         auto offset = reader.offset();
@@ -536,33 +882,87 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
     auto need_size = r_need_size.move_as_ok();
     // LOG(ERROR) << "Need size = " << need_size;
     if (need_size == 0) {
-      if (debug_callback) {
-        debug_callback(event);
+      if (!use_validator) {
+        auto status = event.validate();
+        if (status.is_error()) {
+          LOG(ERROR) << status;
+          break;
+        }
+        if (!add_event(std::move(event))) {
+          break;
+        }
+        continue;
       }
-      do_add_event(std::move(event));
-      if (info_.wrong_password) {
-        return Status::OK();
+
+      bool is_encryption_event = event.type_ == BinlogEvent::ServiceTypes::AesCtrEncryption;
+      batch_size += event.raw_event_.size();
+      batch.push_back(std::move(event));
+      if (is_encryption_event) {
+        // the event changes decryption of the next events, so it must be processed before they are read
+        if (!flush_all()) {
+          break;
+        }
+      } else if (batch_size >= MAX_BATCH_SIZE) {
+        if (!flush_batch()) {
+          break;
+        }
       }
+    } else if (reader.is_mapped()) {
+      // the whole binlog has already been read
+      flush_all();
+      break;
     } else {
+      BufferOwnerGuard buffer_owner_guard(BufferOwner::Binlog);
       TRY_STATUS(fd_.flush_read(max(need_size, static_cast<size_t>(4096))));
       buffer_reader_.sync_with_writer();
       if (byte_flow_flag_) {
         byte_flow_source_.wakeup();
       }
       if (reader.input()->size() < need_size) {
+        flush_all();
         break;
       }
     }
   }
+  if (info_.wrong_password) {
+    return Status::OK();
+  }
 
   auto offset = processor_->offset();
   CHECK(offset >= 0);
+  struct ReplayStatistics {
+    size_t count = 0;
+    size_t size = 0;
+    double time = 0;
+  };
+  std::map<int32, ReplayStatistics> replay_statistics;
+  auto replay_start_time = Time::now();
   processor_->for_each([&](BinlogEvent &event) {
     VLOG(binlog) << "Replay binlog event: " << event.public_to_string();
     if (callback) {
+      auto start_time = Time::now();
       callback(event);
+      auto &statistics = replay_statistics[event.type_];
+      statistics.count++;
+      statistics.size += event.raw_event_.size();
+      statistics.time += Time::now() - start_time;
     }
   });
+  if (!replay_statistics.empty()) {
+    auto replay_time = Time::now() - replay_start_time;
+    string statistics = PSTRING() << "Replay binlog " << tag("name", path_)
+                                  << tag("time", format::as_time(replay_time));
+    for (auto &it : replay_statistics) {
+      statistics += PSTRING() << "\n" << tag("type", format::as_hex(it.first)) << tag("count", it.second.count)
+                              << tag("size", format::as_size(it.second.size))
+                              << tag("time", format::as_time(it.second.time));
+    }
+    if (replay_time > 0.1) {
+      LOG(INFO) << statistics;
+    } else {
+      LOG(DEBUG) << statistics;
+    }
+  }
 
   TRY_RESULT(fd_size, fd_.get_size());
   if (offset != fd_size) {
@@ -580,7 +980,11 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
   // reuse aes_ctr_state_
   if (encryption_type_ == EncryptionType::AesCtr) {
-    aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+    if (reader.is_mapped()) {
+      aes_ctr_state_ = reader.move_mapped_aes_ctr_state();
+    } else {
+      aes_ctr_state_ = aes_xcode_byte_flow_.move_aes_ctr_state();
+    }
   }
   update_write_encryption();
 
@@ -627,6 +1031,8 @@ void Binlog::reset_encryption() {
 }
 
 void Binlog::do_reindex() {
+  CHECK(!is_async_sync_in_progress_);
+  cancel_incremental_reindex();
   flush_events_buffer(true);
   // start reindex
   CHECK(state_ == State::Run);
@@ -718,6 +1124,165 @@ void Binlog::do_reindex() {
   update_write_encryption();
 }
 
+void Binlog::start_incremental_reindex() {
+  flush_events_buffer(true);
+  CHECK(state_ == State::Run);
+  CHECK(incremental_reindex_ == nullptr);
+  if (db_key_.is_empty() != (encryption_type_ == EncryptionType::None) ||
+      (encryption_type_ == EncryptionType::AesCtr && aes_ctr_key_salt_.empty())) {
+    // the binlog must be re-encrypted, which can't be done incrementally
+    return do_reindex();
+  }
+
+  string new_path = path_ + ".new";
+  auto r_opened_file = open_binlog(new_path, FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
+  if (r_opened_file.is_error()) {
+    LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
+    return;
+  }
+
+  auto reindex = make_unique<IncrementalReindex>();
+  reindex->path = std::move(new_path);
+  reindex->fd = r_opened_file.move_as_ok();
+  reindex->last_snapshot_event_id = processor_->last_event_id();
+  reindex->start_time = Clocks::monotonic();
+  reindex->start_size = detail::file_size(path_);
+  reindex->start_events = fd_events_;
+
+  if (encryption_type_ == EncryptionType::AesCtr) {
+    // reuse the current key, but not the initialization vector
+    using EncryptionEvent = detail::AesCtrEncryptionEvent;
+    EncryptionEvent event;
+    event.key_salt_ = aes_ctr_key_salt_;
+    event.iv_.resize(EncryptionEvent::iv_size());
+    Random::secure_bytes(event.iv_);
+    event.key_hash_ = EncryptionEvent::generate_hash(as_slice(aes_ctr_key_));
+
+    reindex->write_event(
+        BinlogEvent::create_raw(0, BinlogEvent::ServiceTypes::AesCtrEncryption, 0, create_default_storer(event))
+            .as_slice());
+    reindex->aes_ctr_state.init(as_slice(aes_ctr_key_), event.iv_);
+    reindex->is_encrypted = true;
+  }
+
+  LOG(INFO) << "Start to regenerate index " << tag("name", path_) << tag("size", format::as_size(reindex->start_size));
+  incremental_reindex_ = std::move(reindex);
+  continue_reindex();
+}
+
+void Binlog::on_incremental_reindex_event(const BinlogEvent &event) {
+  auto &reindex = *incremental_reindex_;
+  if ((event.flags_ & BinlogEvent::Flags::Rewrite) != 0 && reindex.next_event_id <= event.id_ &&
+      event.id_ <= reindex.last_snapshot_event_id) {
+    // the event hasn't been copied yet, so its new version will be copied instead
+    return;
+  }
+  reindex.new_events.push_back(event.raw_event_);
+}
+
+void Binlog::continue_reindex() {
+  if (incremental_reindex_ == nullptr || is_async_sync_in_progress_) {
+    return;
+  }
+  // writing of 1 MB takes at most few milliseconds, so new events aren't delayed significantly
+  constexpr size_t MAX_STEP_SIZE = 1 << 20;
+  constexpr double STEP_DELAY = 0.01;
+
+  auto &reindex = *incremental_reindex_;
+  size_t step_size = 0;
+  bool is_finished = true;
+  processor_->for_each_from(reindex.next_event_id, [&](const BinlogEvent &event) {
+    if (event.id_ > reindex.last_snapshot_event_id) {
+      return false;
+    }
+    if (step_size >= MAX_STEP_SIZE) {
+      is_finished = false;
+      return false;
+    }
+    reindex.write_event(event.raw_event_);
+    step_size += event.raw_event_.size();
+    reindex.next_event_id = event.id_ + 1;
+    return true;
+  });
+
+  auto status = reindex.flush();
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to write regenerated binlog: " << status;
+    return cancel_incremental_reindex();
+  }
+  if (!is_finished) {
+    next_reindex_step_time_ = Time::now() + STEP_DELAY;
+    return;
+  }
+
+  finish_incremental_reindex();
+}
+
+void Binlog::finish_incremental_reindex() {
+  auto &reindex = *incremental_reindex_;
+  for (auto &raw_event : reindex.new_events) {
+    reindex.write_event(raw_event);
+  }
+  auto status = reindex.flush();
+  if (status.is_ok() && reindex.start_size != 0) {  // must sync creation of the file if it is non-empty
+    status = reindex.fd.sync_barrier();
+  }
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to write regenerated binlog: " << status;
+    return cancel_incremental_reindex();
+  }
+
+  // all events must be written to the old binlog before it is replaced
+  flush("finish_incremental_reindex");
+
+  auto new_path = reindex.path;
+  auto old_fd = std::move(fd_);  // can't close fd_ now, because it will release file lock
+  fd_ = BufferedFdBase<FileFd>(std::move(reindex.fd));
+  fd_size_ = reindex.size;
+  fd_events_ = reindex.event_count;
+
+  status = unlink(path_);
+  LOG_IF(FATAL, status.is_error()) << "Failed to unlink old binlog: " << status;
+  old_fd.close();  // now we can close old file and release the system lock
+  status = rename(new_path, path_);
+  FileFd::remove_local_lock(new_path);  // now we can release local lock for temporary file
+  LOG_IF(FATAL, status.is_error()) << "Failed to rename binlog: " << status;
+  need_sync_ = false;
+
+  auto finish_time = Clocks::monotonic();
+  auto ratio = static_cast<double>(reindex.start_size) / static_cast<double>(fd_size_ + 1);
+  LOG(INFO) << "Regenerate index incrementally " << tag("name", path_)
+            << tag("time", format::as_time(finish_time - reindex.start_time))
+            << tag("before_size", format::as_size(reindex.start_size))
+            << tag("after_size", format::as_size(fd_size_)) << tag("ratio", ratio)
+            << tag("before_events", reindex.start_events) << tag("after_events", fd_events_);
+
+  buffer_writer_ = ChainBufferWriter();
+  buffer_reader_ = buffer_writer_.extract_reader();
+  if (reindex.is_encrypted) {
+    aes_ctr_state_ = std::move(reindex.aes_ctr_state);
+  }
+  update_write_encryption();
+
+  incremental_reindex_ = nullptr;
+  next_reindex_step_time_ = 0;
+}
+
+void Binlog::cancel_incremental_reindex() {
+  if (incremental_reindex_ == nullptr) {
+    return;
+  }
+  auto path = std::move(incremental_reindex_->path);
+  auto &fd = incremental_reindex_->fd;
+  if (!fd.empty()) {
+    fd.lock(FileFd::LockFlags::Unlock, path, 1).ignore();
+    fd.close();
+  }
+  incremental_reindex_ = nullptr;
+  next_reindex_step_time_ = 0;
+  unlink(path).ignore();
+}
+
 string Binlog::debug_get_binlog_data(int64 begin_offset, int64 end_offset) {
   if (begin_offset > end_offset) {
     return "Begin offset is bigger than end_offset";
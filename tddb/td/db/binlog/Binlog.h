@@ -15,6 +15,7 @@
 #include "td/utils/ByteFlow.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/Promise.h"
@@ -111,6 +112,11 @@ class Binlog {
   void add_event(BinlogEvent &&event);
   void sync(const char *source);
   void flush(const char *source);
+
+  // flushes the binlog and returns the file, which must be synced in another thread, or nullptr if there is nothing
+  // to sync; the file isn't closed or replaced until finish_async_sync is called
+  FileFd *start_async_sync(const char *source);
+  void finish_async_sync(Status status, double sync_time = 0.0);
   void lazy_flush();
   double need_flush_since() const {
     return need_flush_since_;
@@ -130,6 +136,14 @@ class Binlog {
     return info_;
   }
 
+  // returns time, after which continue_reindex needs to be called, or 0 if there is no reindex in progress
+  double need_reindex_step_at() const {
+    return is_async_sync_in_progress_ ? 0.0 : next_reindex_step_time_;
+  }
+
+  // writes next part of the regenerated binlog and replaces the binlog with it if all events were written
+  void continue_reindex();
+
  private:
   BufferedFdBase<FileFd> fd_;
   ChainBufferWriter buffer_writer_;
@@ -163,14 +177,25 @@ class Binlog {
   double need_flush_since_ = 0;
   double next_buffer_flush_time_ = 0;
   bool need_sync_{false};
+  bool is_async_sync_in_progress_{false};
+  LatencyHistogram *flush_latency_histogram_ = nullptr;
+  LatencyHistogram *sync_latency_histogram_ = nullptr;
   enum class State { Empty, Load, Reindex, Run } state_{State::Empty};
 
+  struct IncrementalReindex;
+  unique_ptr<IncrementalReindex> incremental_reindex_;
+  double next_reindex_step_time_ = 0;
+
   static Result<FileFd> open_binlog(const string &path, int32 flags);
   size_t flush_events_buffer(bool force);
   void do_add_event(BinlogEvent &&event);
   void do_event(BinlogEvent &&event);
   Status load_binlog(const Callback &callback, const Callback &debug_callback = Callback()) TD_WARN_UNUSED_RESULT;
   void do_reindex();
+  void start_incremental_reindex();
+  void on_incremental_reindex_event(const BinlogEvent &event);
+  void finish_incremental_reindex();
+  void cancel_incremental_reindex();
 
   void update_encryption(Slice key, Slice iv);
   void reset_encryption();
@@ -54,6 +54,7 @@ Status BinlogEvent::validate() const {
 }
 
 BufferSlice BinlogEvent::create_raw(uint64 id, int32 type, int32 flags, const Storer &storer) {
+  BufferOwnerGuard buffer_owner_guard(BufferOwner::Binlog);
   auto raw_event = BufferSlice{storer.size() + MIN_SIZE};
 
   TlStorerUnsafe tl_storer(raw_event.as_mutable_slice().ubegin());
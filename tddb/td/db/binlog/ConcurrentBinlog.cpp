@@ -6,6 +6,7 @@
 //
 #include "td/db/binlog/ConcurrentBinlog.h"
 
+#include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/OrderedEventsProcessor.h"
@@ -16,11 +17,28 @@
 
 namespace td {
 namespace detail {
+// syncs the binlog file in its own thread, so the binlog actor can continue to write new events
+class BinlogSyncActor final : public Actor {
+ public:
+  // returns duration of the sync
+  void sync(FileFd *fd, Promise<double> promise) {
+    FileFd::IoCategoryGuard io_category_guard("binlog");
+    auto start_time = Time::now();
+    TRY_STATUS_PROMISE(promise, fd->sync_data());
+    promise.set_value(Time::now() - start_time);
+  }
+};
+
 class BinlogActor final : public Actor {
  public:
-  BinlogActor(unique_ptr<Binlog> binlog, uint64 seq_no) : binlog_(std::move(binlog)), processor_(seq_no) {
+  BinlogActor(unique_ptr<Binlog> binlog, uint64 seq_no, int32 sync_scheduler_id)
+      : binlog_(std::move(binlog)), processor_(seq_no), sync_scheduler_id_(sync_scheduler_id) {
   }
   void close(Promise<> promise) {
+    if (is_sync_in_progress_) {
+      return run_after_sync([this, promise = std::move(promise)]() mutable { close(std::move(promise)); });
+    }
+    log_sync_statistics();
     binlog_->close().ensure();
     LOG(INFO) << "Finished to close binlog";
     stop();
@@ -28,6 +46,9 @@ class BinlogActor final : public Actor {
     promise.set_value(Unit());  // setting promise can complete closing and destroy the current actor context
   }
   void close_and_destroy(Promise<> promise) {
+    if (is_sync_in_progress_) {
+      return run_after_sync([this, promise = std::move(promise)]() mutable { close_and_destroy(std::move(promise)); });
+    }
     binlog_->close_and_destroy().ensure();
     LOG(INFO) << "Finished to destroy binlog";
     stop();
@@ -59,10 +80,11 @@ class BinlogActor final : public Actor {
     });
     flush_immediate_sync();
     try_flush();
+    try_continue_reindex();
   }
 
   void force_sync(Promise<> &&promise, const char *source) {
-    LOG(INFO) << "Force binlog sync from " << source;
+    VLOG(binlog) << "Force binlog sync from " << source;
     auto seq_no = processor_.max_unfinished_seq_no();
     if (processor_.max_finished_seq_no() == seq_no) {
       do_immediate_sync(std::move(promise));
@@ -78,6 +100,11 @@ class BinlogActor final : public Actor {
   }
 
   void change_key(DbKey db_key, Promise<> promise) {
+    if (is_sync_in_progress_) {
+      return run_after_sync([this, db_key = std::move(db_key), promise = std::move(promise)]() mutable {
+        change_key(std::move(db_key), std::move(promise));
+      });
+    }
     binlog_->change_key(std::move(db_key));
     promise.set_value(Unit());
   }
@@ -94,8 +121,35 @@ class BinlogActor final : public Actor {
   bool flush_flag_ = false;
   double wakeup_at_ = 0;
 
+  // group commit: all promises, which are added while a sync is in progress, are completed by the next sync
+  int32 sync_scheduler_id_;
+  ActorOwn<BinlogSyncActor> sync_actor_;
+  bool is_sync_in_progress_ = false;
+  bool need_force_sync_ = false;
+  std::vector<Promise<>> in_progress_sync_promises_;
+  std::vector<Promise<Unit>> after_sync_actions_;
+
+  struct SyncStatistics {
+    int64 sync_count = 0;
+    int64 promise_count = 0;
+    size_t max_batch_size = 0;
+    double total_time = 0.0;
+    double max_time = 0.0;
+  };
+  SyncStatistics sync_statistics_;
+  double next_sync_statistics_log_time_ = 0.0;
+
+  static constexpr double SYNC_STATISTICS_LOG_PERIOD = 600.0;
+
   static constexpr double FLUSH_TIMEOUT = 0.001;  // 1ms
 
+  void start_up() final {
+    if (sync_scheduler_id_ >= 0 && sync_scheduler_id_ != Scheduler::instance()->sched_id()) {
+      sync_actor_ = create_actor_on_scheduler<BinlogSyncActor>("BinlogSyncActor", sync_scheduler_id_);
+    }
+    next_sync_statistics_log_time_ = Time::now() + SYNC_STATISTICS_LOG_PERIOD;
+  }
+
   void wakeup_after(double after) {
     auto now = Time::now_cached();
     wakeup_at(now + after);
@@ -125,6 +179,13 @@ class BinlogActor final : public Actor {
     }
   }
 
+  void try_continue_reindex() {
+    auto need_reindex_step_at = binlog_->need_reindex_step_at();
+    if (need_reindex_step_at != 0) {
+      wakeup_at(need_reindex_step_at);
+    }
+  }
+
   void flush_immediate_sync() {
     auto seq_no = processor_.max_finished_seq_no();
     for (auto it = immediate_sync_promises_.begin(), end = immediate_sync_promises_.end();
@@ -137,9 +198,15 @@ class BinlogActor final : public Actor {
     if (promise) {
       sync_promises_.emplace_back(std::move(promise));
     }
+    if (is_sync_in_progress_) {
+      // the sync will be started as soon as the current sync finishes
+      need_force_sync_ = true;
+      return;
+    }
     if (!force_sync_flag_) {
       force_sync_flag_ = true;
-      wakeup_after(0.003);
+      // the file is synced in another thread, so there is no need to wait for more promises
+      wakeup_after(sync_actor_.empty() ? 0.003 : 0.0);
     }
   }
 
@@ -162,37 +229,133 @@ class BinlogActor final : public Actor {
     flush_flag_ = false;
     wakeup_at_ = 0;
     if (need_sync) {
-      binlog_->sync("timeout_expired");
-      // LOG(ERROR) << "BINLOG SYNC";
-      set_promises(sync_promises_);
+      do_sync();
     } else if (need_flush) {
       try_flush();
       // LOG(ERROR) << "BINLOG FLUSH";
     }
+    if (binlog_->need_reindex_step_at() != 0 && Time::now() >= binlog_->need_reindex_step_at()) {
+      binlog_->continue_reindex();
+    }
+    try_continue_reindex();
+  }
+
+  // the file can't be closed or replaced while it is synced, so the action is postponed
+  template <class F>
+  void run_after_sync(F &&action) {
+    after_sync_actions_.push_back(
+        PromiseCreator::lambda([action = std::forward<F>(action)](Result<Unit> result) mutable {
+          if (result.is_ok()) {
+            action();
+          }
+        }));
+  }
+
+  void do_sync() {
+    if (is_sync_in_progress_) {
+      need_force_sync_ = true;
+      return;
+    }
+    if (sync_actor_.empty()) {
+      auto start_time = Time::now();
+      binlog_->sync("timeout_expired");
+      on_sync_finished(Time::now() - start_time, sync_promises_.size());
+      set_promises(sync_promises_);
+      return;
+    }
+
+    auto fd = binlog_->start_async_sync("timeout_expired");
+    if (fd == nullptr) {
+      set_promises(sync_promises_);
+      return;
+    }
+    is_sync_in_progress_ = true;
+    in_progress_sync_promises_ = std::move(sync_promises_);
+    sync_promises_.clear();
+    send_closure(sync_actor_, &BinlogSyncActor::sync, fd,
+                 PromiseCreator::lambda([actor_id = actor_id(this)](Result<double> r_sync_time) {
+                   send_closure(actor_id, &BinlogActor::on_async_sync_finished, std::move(r_sync_time));
+                 }));
+  }
+
+  void on_async_sync_finished(Result<double> r_sync_time) {
+    CHECK(is_sync_in_progress_);
+    is_sync_in_progress_ = false;
+    if (r_sync_time.is_error()) {
+      binlog_->finish_async_sync(r_sync_time.move_as_error());
+      UNREACHABLE();
+    }
+    binlog_->finish_async_sync(Status::OK(), r_sync_time.ok());
+    on_sync_finished(r_sync_time.ok(), in_progress_sync_promises_.size());
+    set_promises(in_progress_sync_promises_);
+
+    auto actions = std::move(after_sync_actions_);
+    after_sync_actions_.clear();
+    for (auto &action : actions) {
+      action.set_value(Unit());
+    }
+    if (binlog_->empty()) {
+      // the binlog was closed
+      return;
+    }
+
+    if (need_force_sync_) {
+      need_force_sync_ = false;
+      do_sync();
+    }
+    try_continue_reindex();
+  }
+
+  void on_sync_finished(double sync_time, size_t batch_size) {
+    VLOG(binlog) << "Synced binlog in " << format::as_time(sync_time) << " for " << batch_size << " promises";
+    auto &statistics = sync_statistics_;
+    statistics.sync_count++;
+    statistics.promise_count += static_cast<int64>(batch_size);
+    statistics.max_batch_size = td::max(statistics.max_batch_size, batch_size);
+    statistics.total_time += sync_time;
+    statistics.max_time = td::max(statistics.max_time, sync_time);
+    if (Time::now() >= next_sync_statistics_log_time_) {
+      log_sync_statistics();
+    }
+  }
+
+  void log_sync_statistics() {
+    auto &statistics = sync_statistics_;
+    if (statistics.sync_count > 0) {
+      auto average_time = statistics.total_time / static_cast<double>(statistics.sync_count);
+      LOG(INFO) << "Binlog sync statistics: " << tag("sync_count", statistics.sync_count)
+                << tag("promise_count", statistics.promise_count)
+                << tag("max_batch_size", statistics.max_batch_size)
+                << tag("average_time", format::as_time(average_time))
+                << tag("max_time", format::as_time(statistics.max_time))
+                << tag("is_async", !sync_actor_.empty());
+    }
+    statistics = SyncStatistics();
+    next_sync_statistics_log_time_ = Time::now() + SYNC_STATISTICS_LOG_PERIOD;
   }
 };
 }  // namespace detail
 
 ConcurrentBinlog::ConcurrentBinlog() = default;
 ConcurrentBinlog::~ConcurrentBinlog() = default;
-ConcurrentBinlog::ConcurrentBinlog(unique_ptr<Binlog> binlog, int scheduler_id) {
-  init_impl(std::move(binlog), scheduler_id);
+ConcurrentBinlog::ConcurrentBinlog(unique_ptr<Binlog> binlog, int scheduler_id, int32 sync_scheduler_id) {
+  init_impl(std::move(binlog), scheduler_id, sync_scheduler_id);
 }
 
 Result<BinlogInfo> ConcurrentBinlog::init(string path, const Callback &callback, DbKey db_key, DbKey old_db_key,
-                                          int scheduler_id) {
+                                          int scheduler_id, int32 sync_scheduler_id) {
   auto binlog = make_unique<Binlog>();
   TRY_STATUS(binlog->init(std::move(path), callback, std::move(db_key), std::move(old_db_key)));
   auto info = binlog->get_info();
-  init_impl(std::move(binlog), scheduler_id);
+  init_impl(std::move(binlog), scheduler_id, sync_scheduler_id);
   return info;
 }
 
-void ConcurrentBinlog::init_impl(unique_ptr<Binlog> binlog, int32 scheduler_id) {
+void ConcurrentBinlog::init_impl(unique_ptr<Binlog> binlog, int32 scheduler_id, int32 sync_scheduler_id) {
   path_ = binlog->get_path().str();
   last_event_id_ = binlog->peek_next_event_id();
-  binlog_actor_ = create_actor_on_scheduler<detail::BinlogActor>(PSLICE() << "Binlog " << path_, scheduler_id,
-                                                                 std::move(binlog), last_event_id_);
+  binlog_actor_ = create_actor_on_scheduler<detail::BinlogActor>(
+      PSLICE() << "Binlog " << path_, scheduler_id, std::move(binlog), last_event_id_, sync_scheduler_id);
 }
 
 void ConcurrentBinlog::close_impl(Promise<> promise) {
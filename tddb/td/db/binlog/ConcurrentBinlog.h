@@ -30,11 +30,13 @@ class BinlogActor;
 class ConcurrentBinlog final : public BinlogInterface {
  public:
   using Callback = std::function<void(const BinlogEvent &)>;
+  // if sync_scheduler_id is a valid identifier of another scheduler, then the binlog file is synced on that scheduler
   Result<BinlogInfo> init(string path, const Callback &callback, DbKey db_key = DbKey::empty(),
-                          DbKey old_db_key = DbKey::empty(), int scheduler_id = -1) TD_WARN_UNUSED_RESULT;
+                          DbKey old_db_key = DbKey::empty(), int scheduler_id = -1,
+                          int32 sync_scheduler_id = -1) TD_WARN_UNUSED_RESULT;
 
   ConcurrentBinlog();
-  explicit ConcurrentBinlog(unique_ptr<Binlog> binlog, int scheduler_id = -1);
+  explicit ConcurrentBinlog(unique_ptr<Binlog> binlog, int scheduler_id = -1, int32 sync_scheduler_id = -1);
   ConcurrentBinlog(const ConcurrentBinlog &) = delete;
   ConcurrentBinlog &operator=(const ConcurrentBinlog &) = delete;
   ConcurrentBinlog(ConcurrentBinlog &&) = delete;
@@ -59,7 +61,7 @@ class ConcurrentBinlog final : public BinlogInterface {
   uint64 erase_batch(vector<uint64> event_ids) final;
 
  private:
-  void init_impl(unique_ptr<Binlog> binlog, int scheduler_id);
+  void init_impl(unique_ptr<Binlog> binlog, int scheduler_id, int32 sync_scheduler_id);
   void close_impl(Promise<> promise) final;
   void close_and_destroy_impl(Promise<> promise) final;
   void add_raw_event_impl(uint64 event_id, BufferSlice &&raw_event, Promise<> promise, BinlogDebugInfo info) final;
@@ -5,6 +5,7 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/db/binlog/Binlog.h"
+#include "td/db/binlog/BinlogEvent.h"
 
 #include "td/db/DbKey.h"
 
@@ -16,9 +17,13 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/tl_parsers.h"
 
+#include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <utility>
 
 struct Trie {
   Trie() {
@@ -95,16 +100,118 @@ struct Trie {
 
 enum Magic { ConfigPmcMagic = 0x1f18, BinlogPmcMagic = 0x4327 };
 
+// statistics of log events of one type over the whole binlog file
+struct TypeStats {
+  td::uint64 added_count = 0;  // number of initial versions of log events
+  td::uint64 added_size = 0;
+  td::uint64 rewrite_count = 0;  // number of rewrites of existing log events
+  td::uint64 rewrite_size = 0;
+  td::uint64 erased_count = 0;  // number of log events erased by an empty rewrite
+  td::uint64 erase_size = 0;    // size of the empty rewrite log events
+  td::uint64 live_count = 0;    // number of log events, which will be passed to the handler on replay
+  td::uint64 live_size = 0;
+
+  td::uint64 file_size() const {
+    return added_size + rewrite_size + erase_size;
+  }
+
+  void add(const TypeStats &other) {
+    added_count += other.added_count;
+    added_size += other.added_size;
+    rewrite_count += other.rewrite_count;
+    rewrite_size += other.rewrite_size;
+    erased_count += other.erased_count;
+    erase_size += other.erase_size;
+    live_count += other.live_count;
+    live_size += other.live_size;
+  }
+};
+
+static void print_type_stats(td::Slice name, const TypeStats &stats, td::uint64 total_file_size) {
+  auto file_size = stats.file_size();
+  LOG(PLAIN) << td::tag("handler", name) << td::tag("file_size", td::format::as_size(file_size))
+             << td::tag("file_share",
+                        td::StringBuilder::FixedDouble(total_file_size == 0 ? 0.0 : file_size * 100.0 / total_file_size,
+                                                       2))
+             << td::tag("live", stats.live_count) << td::tag("live_size", td::format::as_size(stats.live_size))
+             << td::tag("erased", stats.erased_count) << td::tag("added", stats.added_count)
+             << td::tag("rewrites", stats.rewrite_count)
+             << td::tag("rewrite_size", td::format::as_size(stats.rewrite_size))
+             << td::tag("reclaimable_size", td::format::as_size(file_size - stats.live_size));
+}
+
+// reports, which handlers take space in the binlog, how much of it can be reclaimed by compaction
+// and how much data must be replayed by the handlers on the next start
+static void print_stats(const std::map<td::int32, TypeStats> &stats, const TypeStats &service_stats,
+                        td::uint64 binlog_size, double load_time) {
+  TypeStats total;
+  for (auto &it : stats) {
+    total.add(it.second);
+  }
+
+  std::vector<std::pair<td::uint64, td::int32>> order;
+  for (auto &it : stats) {
+    order.emplace_back(it.second.file_size(), it.first);
+  }
+  std::sort(order.rbegin(), order.rend());
+
+  for (auto &it : order) {
+    print_type_stats(PSLICE() << td::format::as_hex(it.second) << " (" << it.second << ")", stats.at(it.second),
+                     total.file_size());
+  }
+  LOG(PLAIN) << td::tag("service_events", service_stats.added_count)
+             << td::tag("service_size", td::format::as_size(service_stats.added_size));
+  print_type_stats("TOTAL", total, total.file_size());
+
+  auto reclaimable_size = binlog_size - td::min(binlog_size, total.live_size);
+  LOG(PLAIN) << td::tag("binlog_size", td::format::as_size(binlog_size))
+             << td::tag("compacted_size", td::format::as_size(total.live_size))
+             << td::tag("reclaimable_size", td::format::as_size(reclaimable_size))
+             << td::tag("reclaimable_share",
+                        td::StringBuilder::FixedDouble(binlog_size == 0 ? 0.0 : reclaimable_size * 100.0 / binlog_size,
+                                                       2));
+
+  // replay time is roughly proportional to the number of read bytes before compaction and to the number of
+  // live log events after it
+  auto read_speed = load_time > 0 ? static_cast<double>(binlog_size) / load_time : 0.0;
+  LOG(PLAIN) << td::tag("load_time", td::format::as_time(load_time))
+             << td::tag("read_speed", PSLICE() << td::format::as_size(static_cast<td::uint64>(read_speed)) << "/s")
+             << td::tag("replayed_events", total.live_count)
+             << td::tag("estimated_compacted_load_time",
+                        td::format::as_time(read_speed > 0 ? static_cast<double>(total.live_size) / read_speed : 0.0));
+}
+
+static void print_usage() {
+  LOG(PLAIN) << "Usage: binlog_dump [--stats] [--key <database_key>] <binlog_file_name>";
+  LOG(PLAIN) << "  --stats  print per handler statistics instead of the log events";
+  LOG(PLAIN) << "  --key    database encryption key";
+}
+
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name>";
+  bool need_stats = false;
+  td::string key = "cucumber";
+  td::string binlog_file_name;
+  for (int i = 1; i < argc; i++) {
+    td::Slice arg(argv[i]);
+    if (arg == "--stats") {
+      need_stats = true;
+    } else if (arg == "--key" && i + 1 < argc) {
+      key = argv[++i];
+    } else if (binlog_file_name.empty() && !td::begins_with(arg, "--")) {
+      binlog_file_name = arg.str();
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+  if (binlog_file_name.empty()) {
+    print_usage();
     return 1;
   }
-  td::string binlog_file_name = argv[1];
   auto r_stat = td::stat(binlog_file_name);
   if (r_stat.is_error() || r_stat.ok().size_ == 0 || !r_stat.ok().is_reg_) {
     LOG(PLAIN) << "Wrong binlog file name specified";
-    LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name>";
+    print_usage();
     return 1;
   }
 
@@ -116,12 +223,27 @@ int main(int argc, char *argv[]) {
   };
   std::map<td::uint64, Info> info;
 
+  struct EventInfo {
+    td::int32 type;
+    bool is_erased;
+  };
+  std::unordered_map<td::uint64, EventInfo> event_infos;
+  std::map<td::int32, TypeStats> stats;
+  TypeStats service_stats;
+
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  auto start_time = td::Time::now();
   td::Binlog binlog;
   binlog
       .init(
           binlog_file_name,
           [&](auto &event) {
+            if (need_stats) {
+              auto &type_stats = stats[event.type_];
+              type_stats.live_count++;
+              type_stats.live_size += event.raw_event_.size();
+              return;
+            }
             info[0].compressed_size += event.raw_event_.size();
             info[event.type_].compressed_size += event.raw_event_.size();
             if (event.type_ == ConfigPmcMagic || event.type_ == BinlogPmcMagic) {
@@ -129,8 +251,41 @@ int main(int argc, char *argv[]) {
               info[event.type_].compressed_trie.add(key);
             }
           },
-          td::DbKey::raw_key("cucumber"), td::DbKey::empty(), -1,
+          td::DbKey::raw_key(key), td::DbKey::empty(), -1,
           [&](auto &event) mutable {
+            if (need_stats) {
+              auto size = event.raw_event_.size();
+              if ((event.flags_ & td::BinlogEvent::Flags::Rewrite) == 0) {
+                if (event.type_ < 0) {
+                  service_stats.added_count++;
+                  service_stats.added_size += size;
+                  return;
+                }
+                event_infos[event.id_] = EventInfo{event.type_, false};
+                auto &type_stats = stats[event.type_];
+                type_stats.added_count++;
+                type_stats.added_size += size;
+                return;
+              }
+
+              // rewrites are accounted to the type of the initial log event
+              auto it = event_infos.find(event.id_);
+              if (it == event_infos.end() || it->second.is_erased) {
+                service_stats.added_count++;
+                service_stats.added_size += size;
+                return;
+              }
+              auto &type_stats = stats[it->second.type];
+              if (event.type_ == td::BinlogEvent::ServiceTypes::Empty) {
+                it->second.is_erased = true;
+                type_stats.erased_count++;
+                type_stats.erase_size += size;
+              } else {
+                type_stats.rewrite_count++;
+                type_stats.rewrite_size += size;
+              }
+              return;
+            }
             info[0].full_size += event.raw_event_.size();
             info[event.type_].full_size += event.raw_event_.size();
             if (event.type_ == ConfigPmcMagic || event.type_ == BinlogPmcMagic) {
@@ -144,6 +299,11 @@ int main(int argc, char *argv[]) {
           })
       .ensure();
 
+  if (need_stats) {
+    print_stats(stats, service_stats, static_cast<td::uint64>(r_stat.ok().size_), td::Time::now() - start_time);
+    return 0;
+  }
+
   for (auto &it : info) {
     LOG(PLAIN) << td::tag("handler", td::format::as_hex(it.first))
                << td::tag("full_size", td::format::as_size(it.second.full_size))
@@ -0,0 +1,219 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/Slice.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace td {
+namespace detail {
+
+// key-value storage, which keeps all keys and values in big memory chunks and supports search of keys by prefix
+// slices returned by the storage and references to values are valid only until the next modification
+// slices passed to the storage must not point to memory owned by the storage
+class BinlogKeyValueStorage {
+ public:
+  struct Value {
+    Slice value;
+    uint64 event_id = 0;
+  };
+
+  size_t size() const {
+    return map_.size();
+  }
+
+  void reserve(size_t size) {
+    map_.reserve(size);
+  }
+
+  const Value *find(Slice key) const {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
+  // sets value of the key; event identifier of a new key is 0
+  Value &set(Slice key, Slice value) {
+    CHECK(!key.empty());
+    if (garbage_size_ >= MIN_COMPACTION_GARBAGE_SIZE && garbage_size_ > used_size_) {
+      compact();
+    }
+
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+      auto &old_value = it->second.value;
+      garbage_size_ += old_value.size();
+      used_size_ -= old_value.size();
+      old_value = store(value);
+      used_size_ += value.size();
+      return it->second;
+    }
+
+    auto data = allocate(key.size() + value.size());
+    data.copy_from(key);
+    data.substr(key.size()).copy_from(value);
+    Slice new_key(data.begin(), key.size());
+    new_keys_.push_back(new_key);
+    used_size_ += data.size();
+    return map_.emplace(new_key, Value{Slice(data.substr(key.size())), 0}).first->second;
+  }
+
+  bool erase(Slice key) {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return false;
+    }
+    // the key is removed from the sorted index lazily
+    auto size = it->first.size() + it->second.value.size();
+    garbage_size_ += size;
+    used_size_ -= size;
+    map_.erase(it);
+    return true;
+  }
+
+  void clear() {
+    *this = BinlogKeyValueStorage();
+  }
+
+  // calls func(Slice key, Value &value) for all keys in unspecified order
+  template <class F>
+  void for_each(F &&func) {
+    for (auto &it : map_) {
+      func(it.first, it.second);
+    }
+  }
+
+  template <class F>
+  void for_each(F &&func) const {
+    for (const auto &it : map_) {
+      func(it.first, it.second);
+    }
+  }
+
+  // calls func(Slice key, Value &value) for all keys starting with the prefix in O(log(n) + k)
+  // func must not modify the storage
+  template <class F>
+  void for_each_with_prefix(Slice prefix, F &&func) {
+    if (new_keys_.size() > MAX_UNSORTED_KEY_COUNT) {
+      update_sorted_keys();
+    }
+    auto it = std::lower_bound(sorted_keys_.begin(), sorted_keys_.end(), prefix);
+    for (; it != sorted_keys_.end() && begins_with(*it, prefix); ++it) {
+      call_if_alive(*it, func);
+    }
+    for (auto &key : new_keys_) {
+      if (begins_with(key, prefix)) {
+        call_if_alive(key, func);
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t CHUNK_SIZE = 1 << 16;
+  static constexpr size_t MIN_COMPACTION_GARBAGE_SIZE = 1 << 20;
+  static constexpr size_t MAX_UNSORTED_KEY_COUNT = 64;
+
+  FlatHashMap<Slice, Value, SliceHash> map_;
+
+  // all keys in the storage are either in sorted_keys_ or in new_keys_; the vectors can also contain erased keys
+  vector<Slice> sorted_keys_;
+  vector<Slice> new_keys_;
+
+  vector<std::unique_ptr<char[]>> chunks_;
+  char *chunk_ptr_ = nullptr;
+  size_t chunk_left_size_ = 0;
+
+  size_t used_size_ = 0;
+  size_t garbage_size_ = 0;
+
+  MutableSlice allocate(size_t size) {
+    if (size == 0) {
+      return MutableSlice();
+    }
+    if (size > CHUNK_SIZE / 8) {
+      chunks_.push_back(std::unique_ptr<char[]>(new char[size]));
+      return MutableSlice(chunks_.back().get(), size);
+    }
+    if (size > chunk_left_size_) {
+      chunks_.push_back(std::unique_ptr<char[]>(new char[CHUNK_SIZE]));
+      chunk_ptr_ = chunks_.back().get();
+      chunk_left_size_ = CHUNK_SIZE;
+    }
+    MutableSlice result(chunk_ptr_, size);
+    chunk_ptr_ += size;
+    chunk_left_size_ -= size;
+    return result;
+  }
+
+  Slice store(Slice data) {
+    auto result = allocate(data.size());
+    result.copy_from(data);
+    return result;
+  }
+
+  // checks that the key from the sorted index isn't erased
+  template <class F>
+  void call_if_alive(Slice key, F &func) {
+    auto it = map_.find(key);
+    if (it != map_.end() && it->first.data() == key.data()) {
+      func(it->first, it->second);
+    }
+  }
+
+  bool is_alive(Slice key) const {
+    auto it = map_.find(key);
+    return it != map_.end() && it->first.data() == key.data();
+  }
+
+  void update_sorted_keys() {
+    std::sort(new_keys_.begin(), new_keys_.end());
+    vector<Slice> sorted_keys;
+    sorted_keys.reserve(map_.size());
+    auto is_alive_key = [this](Slice key) {
+      return is_alive(key);
+    };
+    std::copy_if(sorted_keys_.begin(), sorted_keys_.end(), std::back_inserter(sorted_keys), is_alive_key);
+    auto middle = sorted_keys.size();
+    std::copy_if(new_keys_.begin(), new_keys_.end(), std::back_inserter(sorted_keys), is_alive_key);
+    std::inplace_merge(sorted_keys.begin(), sorted_keys.begin() + middle, sorted_keys.end());
+    sorted_keys_ = std::move(sorted_keys);
+    new_keys_.clear();
+  }
+
+  // moves all keys and values to new memory chunks, freeing memory of erased keys and replaced values
+  void compact() {
+    BinlogKeyValueStorage new_storage;
+    new_storage.map_.reserve(map_.size());
+    new_storage.sorted_keys_.reserve(map_.size());
+    for (auto &it : map_) {
+      auto data = new_storage.allocate(it.first.size() + it.second.value.size());
+      data.copy_from(it.first);
+      data.substr(it.first.size()).copy_from(it.second.value);
+      Slice key(data.begin(), it.first.size());
+      new_storage.sorted_keys_.push_back(key);
+      new_storage.map_.emplace(key, Value{Slice(data.substr(key.size())), it.second.event_id});
+    }
+    std::sort(new_storage.sorted_keys_.begin(), new_storage.sorted_keys_.end());
+    new_storage.used_size_ = used_size_;
+    LOG(DEBUG) << "Compact key-value storage with " << map_.size() << " keys from " << used_size_ + garbage_size_
+               << " to " << used_size_ << " bytes";
+    *this = std::move(new_storage);
+  }
+};
+
+}  // namespace detail
+}  // namespace td
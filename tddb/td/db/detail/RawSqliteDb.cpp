@@ -11,6 +11,7 @@
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/PathView.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
 
@@ -21,6 +22,12 @@ namespace detail {
 
 static std::atomic<bool> was_database_destroyed{false};
 
+RawSqliteDb::RawSqliteDb(tdsqlite3 *db, std::string path)
+    : db_(db)
+    , path_(std::move(path))
+    , step_latency_histogram_(LatencyHistogram::get(PSLICE() << "sqlite step " << PathView(path_).file_name())) {
+}
+
 Status RawSqliteDb::last_error(tdsqlite3 *db, CSlice path) {
   return Status::Error(PSLICE() << Slice(tdsqlite3_errmsg(db)) << " for database \"" << path << '"');
 }
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/optional.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -18,8 +19,7 @@ namespace detail {
 
 class RawSqliteDb {
  public:
-  RawSqliteDb(tdsqlite3 *db, std::string path) : db_(db), path_(std::move(path)) {
-  }
+  RawSqliteDb(tdsqlite3 *db, std::string path);
   RawSqliteDb(const RawSqliteDb &) = delete;
   RawSqliteDb(RawSqliteDb &&) = delete;
   RawSqliteDb &operator=(const RawSqliteDb &) = delete;
@@ -67,11 +67,16 @@ class RawSqliteDb {
     return cipher_version_.copy();
   }
 
+  LatencyHistogram *get_step_latency_histogram() const {
+    return step_latency_histogram_;
+  }
+
  private:
   tdsqlite3 *db_;
   std::string path_;
   size_t begin_cnt_{0};
   optional<int32> cipher_version_;
+  LatencyHistogram *step_latency_histogram_;
 };
 
 }  // namespace detail
@@ -14,6 +14,7 @@
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
@@ -133,6 +134,65 @@ GetHostByNameActor::GetHostByNameActor(Options options) : options_(std::move(opt
   CHECK(!options_.resolver_types.empty());
 }
 
+void GetHostByNameActor::start_up() {
+  load_cache();
+}
+
+bool GetHostByNameActor::is_stale_usable(const Value &value, double now) const {
+  return value.ip.is_ok() && value.expires_at + options_.stale_timeout > now;
+}
+
+void GetHostByNameActor::load_cache() {
+  if (options_.storage == nullptr) {
+    return;
+  }
+
+  auto now = Time::now();
+  auto system_now = Clocks::system();
+  auto data = options_.storage->load();
+  size_t loaded_count = 0;
+  for (auto line : full_split(Slice(data), '\n')) {
+    auto parts = full_split(line, ' ');
+    if (parts.size() != 4 || (parts[1] != "0" && parts[1] != "1")) {
+      continue;
+    }
+    auto r_ip = IPAddress::get_ip_address(parts[2].str());
+    auto r_expires_at = to_integer_safe<int64>(parts[3]);
+    if (parts[0].empty() || r_ip.is_error() || r_expires_at.is_error()) {
+      continue;
+    }
+    Value value(r_ip.move_as_ok(), now + (static_cast<double>(r_expires_at.ok()) - system_now));
+    if (!is_stale_usable(value, now)) {
+      continue;
+    }
+    bool prefer_ipv6 = parts[1] == "1";
+    cache_[prefer_ipv6].emplace(parts[0].str(), std::move(value));
+    loaded_count++;
+  }
+  VLOG(dns_resolver) << "Load " << loaded_count << " cached host addresses";
+}
+
+void GetHostByNameActor::save_cache() {
+  if (options_.storage == nullptr) {
+    return;
+  }
+
+  auto now = Time::now();
+  auto system_now = Clocks::system();
+  string data;
+  for (int prefer_ipv6 = 0; prefer_ipv6 < 2; prefer_ipv6++) {
+    for (auto &it : cache_[prefer_ipv6]) {
+      auto &value = it.second;
+      if (!is_stale_usable(value, now)) {
+        continue;
+      }
+      data += PSTRING() << it.first << ' ' << prefer_ipv6 << ' ' << value.ip.ok().get_ip_str() << ' '
+                        << static_cast<int64>(system_now + (value.expires_at - now)) << '\n';
+    }
+  }
+  options_.storage->save(std::move(data));
+}
+
 void GetHostByNameActor::run(string host, int port, bool prefer_ipv6, Promise<IPAddress> promise) {
   auto r_ascii_host = idn_to_ascii(host);
   if (r_ascii_host.is_error()) {
@@ -154,9 +214,14 @@ void GetHostByNameActor::run(string host, int port, bool prefer_ipv6, Promise<IP
     query_ptr = make_unique<Query>();
   }
   auto &query = *query_ptr;
-  query.promises.emplace_back(port, std::move(promise));
+  if (is_stale_usable(value, begin_time)) {
+    // return the expired address immediately and refresh it in background
+    promise.set_result(value.get_ip_port(port));
+  } else {
+    query.promises.emplace_back(port, std::move(promise));
+  }
   if (query.query.empty()) {
-    CHECK(query.promises.size() == 1);
+    CHECK(query.promises.size() <= 1);
     query.real_host = std::move(host);
     query.begin_time = Time::now();
     run_query(std::move(ascii_host), prefer_ipv6, query);
@@ -190,7 +255,6 @@ void GetHostByNameActor::on_query_result(std::string host, bool prefer_ipv6, Res
   auto query_it = active_queries_[prefer_ipv6].find(host);
   CHECK(query_it != active_queries_[prefer_ipv6].end());
   auto &query = *query_it->second;
-  CHECK(!query.promises.empty());
   CHECK(!query.query.empty());
 
   if (result.is_error() && query.pos < options_.resolver_types.size()) {
@@ -205,8 +269,15 @@ void GetHostByNameActor::on_query_result(std::string host, bool prefer_ipv6, Res
   auto promises = std::move(query.promises);
   auto value_it = cache_[prefer_ipv6].find(host);
   CHECK(value_it != cache_[prefer_ipv6].end());
-  auto cache_timeout = result.is_ok() ? options_.ok_timeout : options_.error_timeout;
-  value_it->second = Value{std::move(result), end_time + cache_timeout};
+  // a failed refresh doesn't replace an address, which still can be used
+  if (result.is_ok() || !is_stale_usable(value_it->second, end_time)) {
+    bool is_ok = result.is_ok();
+    auto cache_timeout = is_ok ? options_.ok_timeout : options_.error_timeout;
+    value_it->second = Value{std::move(result), end_time + cache_timeout};
+    if (is_ok) {
+      save_cache();
+    }
+  }
   active_queries_[prefer_ipv6].erase(query_it);
 
   for (auto &promise : promises) {
@@ -15,6 +15,7 @@
 #include "td/utils/Promise.h"
 #include "td/utils/Status.h"
 
+#include <memory>
 #include <utility>
 
 namespace td {
@@ -25,6 +26,21 @@ class GetHostByNameActor final : public Actor {
  public:
   enum class ResolverType { Native, Google };
 
+  // persistent storage for successfully resolved addresses
+  class Storage {
+   public:
+    Storage() = default;
+    Storage(const Storage &) = delete;
+    Storage &operator=(const Storage &) = delete;
+    Storage(Storage &&) = delete;
+    Storage &operator=(Storage &&) = delete;
+    virtual ~Storage() = default;
+
+    virtual string load() = 0;
+
+    virtual void save(string data) = 0;
+  };
+
   struct Options {
     static constexpr int32 DEFAULT_CACHE_TIME = 60 * 29;       // 29 minutes
     static constexpr int32 DEFAULT_ERROR_CACHE_TIME = 60 * 5;  // 5 minutes
@@ -33,6 +49,8 @@ class GetHostByNameActor final : public Actor {
     int32 scheduler_id{-1};
     int32 ok_timeout{DEFAULT_CACHE_TIME};
     int32 error_timeout{DEFAULT_ERROR_CACHE_TIME};
+    int32 stale_timeout{0};  // time after expiration during which the address is returned and refreshed in background
+    std::shared_ptr<Storage> storage;
   };
 
   explicit GetHostByNameActor(Options options);
@@ -70,7 +88,15 @@ class GetHostByNameActor final : public Actor {
 
   Options options_;
 
+  void start_up() final;
+
   void run_query(std::string host, bool prefer_ipv6, Query &query);
+
+  bool is_stale_usable(const Value &value, double now) const;
+
+  void load_cache();
+
+  void save_cache();
 };
 
 }  // namespace td
@@ -16,6 +16,8 @@
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Status.h"
 
+#include <utility>
+
 namespace td {
 
 class HttpOutboundConnection final : public detail::HttpConnectionBase {
@@ -31,6 +33,10 @@ class HttpOutboundConnection final : public detail::HttpConnectionBase {
                            max_files, idle_timeout, slow_scheduler_id)
       , callback_(std::move(callback)) {
   }
+  void set_callback(ActorShared<Callback> callback) {
+    callback_ = std::move(callback);
+  }
+
   // Inherited interface
   // void write_next(BufferSlice buffer);
   // void write_ok();
@@ -0,0 +1,131 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/net/HttpOutboundConnectionPool.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/Time.h"
+
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+namespace td {
+
+namespace {
+
+class HttpOutboundConnectionPoolImpl {
+ public:
+  ActorOwn<HttpOutboundConnection> get_connection(Slice key) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    remove_expired_connections();
+    for (auto it = connections_.rbegin(); it != connections_.rend(); ++it) {
+      if (it->key_ == key) {
+        auto connection = std::move(it->connection_);
+        connections_.erase(std::next(it).base());
+        stats_.reused_connection_count++;
+        return connection;
+      }
+    }
+    return ActorOwn<HttpOutboundConnection>();
+  }
+
+  void put_connection(string key, ActorOwn<HttpOutboundConnection> connection) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    remove_expired_connections();
+    size_t key_connection_count = 0;
+    for (auto &idle_connection : connections_) {
+      if (idle_connection.key_ == key) {
+        key_connection_count++;
+      }
+    }
+    if (key_connection_count >= HttpOutboundConnectionPool::MAX_CONNECTIONS_PER_KEY) {
+      return;
+    }
+    if (connections_.size() >= HttpOutboundConnectionPool::MAX_CONNECTIONS) {
+      connections_.erase(connections_.begin());
+    }
+    LOG(DEBUG) << "Keep idle HTTP connection to " << key;
+    connections_.push_back(IdleConnection{std::move(key), std::move(connection), Time::now()});
+    stats_.pooled_connection_count++;
+  }
+
+  void on_connection_created() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stats_.created_connection_count++;
+  }
+
+  void on_connection_lost() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stats_.lost_connection_count++;
+  }
+
+  HttpOutboundConnectionPool::Stats get_stats() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return stats_;
+  }
+
+ private:
+  struct IdleConnection {
+    string key_;
+    ActorOwn<HttpOutboundConnection> connection_;
+    double idle_since_;
+  };
+
+  std::mutex mutex_;
+  vector<IdleConnection> connections_;  // sorted by idle_since_
+  HttpOutboundConnectionPool::Stats stats_;
+
+  void remove_expired_connections() {
+    auto min_idle_since = Time::now() - HttpOutboundConnectionPool::MAX_IDLE_TIME;
+    size_t expired_count = 0;
+    while (expired_count < connections_.size() && connections_[expired_count].idle_since_ < min_idle_since) {
+      expired_count++;
+    }
+    if (expired_count > 0) {
+      connections_.erase(connections_.begin(), connections_.begin() + expired_count);
+      stats_.expired_connection_count += expired_count;
+    }
+  }
+};
+
+HttpOutboundConnectionPoolImpl &get_pool() {
+  // the pool is never destroyed, because ActorOwn can't be destroyed after the actor framework is closed
+  static auto *pool = new HttpOutboundConnectionPoolImpl();
+  return *pool;
+}
+
+}  // namespace
+
+ActorOwn<HttpOutboundConnection> HttpOutboundConnectionPool::get_connection(Slice key) {
+  return get_pool().get_connection(key);
+}
+
+void HttpOutboundConnectionPool::put_connection(string key, ActorOwn<HttpOutboundConnection> connection) {
+  get_pool().put_connection(std::move(key), std::move(connection));
+}
+
+void HttpOutboundConnectionPool::on_connection_created() {
+  get_pool().on_connection_created();
+}
+
+void HttpOutboundConnectionPool::on_connection_lost() {
+  get_pool().on_connection_lost();
+}
+
+HttpOutboundConnectionPool::Stats HttpOutboundConnectionPool::get_stats() {
+  return get_pool().get_stats();
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const HttpOutboundConnectionPool::Stats &stats) {
+  return string_builder << "HttpConnections[created = " << stats.created_connection_count
+                        << ", reused = " << stats.reused_connection_count
+                        << ", pooled = " << stats.pooled_connection_count
+                        << ", expired = " << stats.expired_connection_count
+                        << ", lost = " << stats.lost_connection_count << ']';
+}
+
+}  // namespace td
@@ -0,0 +1,50 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/net/HttpOutboundConnection.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/StringBuilder.h"
+
+namespace td {
+
+// process-wide pool of idle keep-alive HTTP connections keyed by protocol, host, port and connection parameters
+class HttpOutboundConnectionPool {
+ public:
+  static constexpr double MAX_IDLE_TIME = 15.0;
+  static constexpr size_t MAX_CONNECTIONS_PER_KEY = 4;
+  static constexpr size_t MAX_CONNECTIONS = 32;
+
+  struct Stats {
+    uint64 created_connection_count = 0;
+    uint64 reused_connection_count = 0;
+    uint64 pooled_connection_count = 0;
+    uint64 expired_connection_count = 0;
+    uint64 lost_connection_count = 0;  // pooled connections, which were closed before they were used
+  };
+
+  // returns an idle connection or an empty ActorOwn if there is none
+  // the caller must replace callback of the connection
+  static ActorOwn<HttpOutboundConnection> get_connection(Slice key);
+
+  // the connection must have finished the previous query
+  static void put_connection(string key, ActorOwn<HttpOutboundConnection> connection);
+
+  static void on_connection_created();
+
+  static void on_connection_lost();
+
+  static Stats get_stats();
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const HttpOutboundConnectionPool::Stats &stats);
+
+}  // namespace td
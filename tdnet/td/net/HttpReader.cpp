@@ -276,7 +276,7 @@ Result<bool> HttpReader::parse_multipart_form_data(bool can_be_slow) {
         form_data_read_length_ = 0;
         return false;
       case FormDataParseState::ReadPartHeaders:
-        if (find_boundary(content_->clone(), "\r\n\r\n", form_data_read_length_)) {
+        if (find_http_headers_end(content_->clone(), form_data_read_length_)) {
           total_headers_length_ += form_data_read_length_;
           if (total_headers_length_ > MAX_TOTAL_HEADERS_LENGTH) {
             return Status::Error(431, "Request Header Fields Too Large: total headers size exceeded");
@@ -540,7 +540,7 @@ Result<bool> HttpReader::parse_multipart_form_data(bool can_be_slow) {
 }
 
 Result<size_t> HttpReader::split_header() {
-  if (find_boundary(input_->clone(), "\r\n\r\n", headers_read_length_)) {
+  if (find_http_headers_end(input_->clone(), headers_read_length_)) {
     query_->container_.clear();
     auto a = input_->cut_head(headers_read_length_ + 2);
     auto b = a.move_as_buffer_slice();
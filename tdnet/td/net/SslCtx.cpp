@@ -6,6 +6,8 @@
 //
 #include "td/net/SslCtx.h"
 
+#include "td/net/SslSessionCache.h"
+
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/FlatHashMap.h"
@@ -208,6 +210,11 @@ Result<SslCtxPtr> do_create_ssl_ctx(CSlice cert_file, SslCtx::VerifyPeer verify_
     SSL_CTX_set_verify(ssl_ctx, SSL_VERIFY_NONE, nullptr);
   }
 
+  if (cert_file.empty()) {
+    // default contexts are never destroyed, so sessions established with them can be safely reused
+    SslSessionCache::init_ssl_ctx(ssl_ctx);
+  }
+
   string cipher_list;
   if (SSL_CTX_set_cipher_list(ssl_ctx, cipher_list.empty() ? "DEFAULT" : cipher_list.c_str()) == 0) {
     return create_openssl_error(-9, PSLICE() << "Failed to set cipher list \"" << cipher_list << '"');
@@ -0,0 +1,108 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/net/SslSessionCache.h"
+
+#if !TD_EMSCRIPTEN
+#include "td/utils/logging.h"
+
+#include <openssl/ssl.h>
+
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#endif
+
+namespace td {
+namespace detail {
+
+#if !TD_EMSCRIPTEN && OPENSSL_VERSION_NUMBER >= 0x10101000L
+namespace {
+
+struct SslSessionDeleter {
+  void operator()(SSL_SESSION *session) {
+    SSL_SESSION_free(session);
+  }
+};
+
+using SslSessionPtr = std::unique_ptr<SSL_SESSION, SslSessionDeleter>;
+
+class SslSessionCacheImpl {
+ public:
+  void save(const SSL_CTX *ssl_ctx, string host, SslSessionPtr session) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto key = std::make_pair(ssl_ctx, std::move(host));
+    if (sessions_.size() >= SslSessionCache::MAX_SESSION_COUNT && sessions_.count(key) == 0) {
+      auto oldest_it = sessions_.begin();
+      for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+        if (SSL_SESSION_get_time(it->second.get()) < SSL_SESSION_get_time(oldest_it->second.get())) {
+          oldest_it = it;
+        }
+      }
+      sessions_.erase(oldest_it);
+    }
+    sessions_[std::move(key)] = std::move(session);
+  }
+
+  void resume(SSL *ssl, const string &host) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = sessions_.find(std::make_pair(static_cast<const SSL_CTX *>(SSL_get_SSL_CTX(ssl)), host));
+    if (it == sessions_.end()) {
+      return;
+    }
+    auto *session = it->second.get();
+    if (!SSL_SESSION_is_resumable(session) ||
+        SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <= static_cast<long>(std::time(nullptr))) {
+      sessions_.erase(it);
+      return;
+    }
+    if (SSL_set_session(ssl, session) == 1) {
+      LOG(DEBUG) << "Try to resume TLS session with " << host;
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<std::pair<const SSL_CTX *, string>, SslSessionPtr> sessions_;
+};
+
+SslSessionCacheImpl &get_ssl_session_cache() {
+  static auto *cache = new SslSessionCacheImpl();
+  return *cache;
+}
+
+int on_new_session(SSL *ssl, SSL_SESSION *session) {
+  const char *server_name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+  if (server_name == nullptr || !SSL_SESSION_is_resumable(session)) {
+    return 0;
+  }
+  get_ssl_session_cache().save(SSL_get_SSL_CTX(ssl), string(server_name), SslSessionPtr(session));
+  return 1;  // the reference to the session is owned by the cache now
+}
+
+}  // namespace
+
+void SslSessionCache::init_ssl_ctx(void *ssl_ctx) {
+  auto *ctx = static_cast<SSL_CTX *>(ssl_ctx);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, on_new_session);
+}
+
+void SslSessionCache::init_ssl(void *ssl, CSlice host) {
+  get_ssl_session_cache().resume(static_cast<SSL *>(ssl), host.str());
+}
+#else
+void SslSessionCache::init_ssl_ctx(void *ssl_ctx) {
+}
+
+void SslSessionCache::init_ssl(void *ssl, CSlice host) {
+}
+#endif
+
+}  // namespace detail
+}  // namespace td
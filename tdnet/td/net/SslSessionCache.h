@@ -0,0 +1,30 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+namespace detail {
+
+// process-wide cache of client TLS sessions and session tickets keyed by SSL context and server name,
+// which allows repeated connections to the same host to use abbreviated handshakes
+class SslSessionCache {
+ public:
+  static constexpr size_t MAX_SESSION_COUNT = 64;
+
+  // enables saving of sessions, established using the OpenSSL context
+  // the context must never be destroyed, because sessions are keyed by its address
+  static void init_ssl_ctx(void *ssl_ctx);
+
+  // tries to resume a saved session with the host; new sessions are saved only for hosts sent as SNI
+  static void init_ssl(void *ssl, CSlice host);
+};
+
+}  // namespace detail
+}  // namespace td
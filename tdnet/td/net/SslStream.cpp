@@ -7,6 +7,8 @@
 #include "td/net/SslStream.h"
 
 #if !TD_EMSCRIPTEN
+#include "td/net/SslSessionCache.h"
+
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/logging.h"
@@ -173,6 +175,7 @@ class SslStreamImpl {
       LOG(DEBUG) << "Set SNI host name to " << host;
       auto host_str = host.str();
       SSL_set_tlsext_host_name(ssl_handle.get(), MutableCSlice(host_str).begin());
+      SslSessionCache::init_ssl(ssl_handle.get(), host);
     }
 #endif
     SSL_set_connect_state(ssl_handle.get());
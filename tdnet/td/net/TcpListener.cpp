@@ -8,6 +8,9 @@
 
 #include "td/utils/logging.h"
 #include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <utility>
 
 namespace td {
 
@@ -61,4 +64,25 @@ void TcpListener::loop() {
   }
 }
 
+ShardedTcpListener::ShardedTcpListener(int port, vector<int32> scheduler_ids, CallbackFactory create_callback,
+                                       Slice server_address)
+    : port_(port)
+    , scheduler_ids_(std::move(scheduler_ids))
+    , create_callback_(std::move(create_callback))
+    , server_address_(server_address.str()) {
+}
+
+void ShardedTcpListener::hangup() {
+  stop();
+}
+
+void ShardedTcpListener::start_up() {
+  for (auto scheduler_id : scheduler_ids_) {
+    auto callback = create_callback_(scheduler_id);
+    listeners_.push_back(create_actor_on_scheduler<TcpListener>(
+        PSLICE() << "TcpListener" << scheduler_id, scheduler_id, port_,
+        ActorShared<TcpListener::Callback>(std::move(callback)), server_address_));
+  }
+}
+
 }  // namespace td
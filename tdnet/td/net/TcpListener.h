@@ -13,6 +13,8 @@
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Slice.h"
 
+#include <functional>
+
 namespace td {
 
 class TcpListener final : public Actor {
@@ -35,4 +37,26 @@ class TcpListener final : public Actor {
   void loop() final;
 };
 
+// listens to the same port on each of the given schedulers using a separate TcpListener with its own socket
+// the sockets are bound with SO_REUSEPORT, so the kernel distributes incoming connections between them and
+// connections are accepted and handled without passing them between threads
+// on systems without SO_REUSEPORT only the first listener will be able to open its socket
+class ShardedTcpListener final : public Actor {
+ public:
+  // must create a callback for connections accepted on the given scheduler, preferably on the same scheduler
+  using CallbackFactory = std::function<ActorOwn<TcpListener::Callback>(int32 scheduler_id)>;
+
+  ShardedTcpListener(int port, vector<int32> scheduler_ids, CallbackFactory create_callback,
+                     Slice server_address = Slice("0.0.0.0"));
+  void hangup() final;
+
+ private:
+  int port_;
+  vector<int32> scheduler_ids_;
+  CallbackFactory create_callback_;
+  const string server_address_;
+  vector<ActorOwn<TcpListener>> listeners_;
+  void start_up() final;
+};
+
 }  // namespace td
@@ -8,6 +8,7 @@
 
 #include "td/net/HttpHeaderCreator.h"
 #include "td/net/HttpOutboundConnection.h"
+#include "td/net/HttpOutboundConnectionPool.h"
 #include "td/net/SslStream.h"
 
 #include "td/utils/buffer.h"
@@ -72,6 +73,22 @@ Status Wget::try_init() {
   }
   TRY_RESULT(header, hc.finish(content_));
 
+  connection_key_ = PSTRING() << (url.protocol_ == HttpUrl::Protocol::Http ? "http" : "https") << "://" << url.host_
+                              << ':' << url.port_ << '/' << prefer_ipv6_ << '/'
+                              << (verify_peer_ == SslCtx::VerifyPeer::On);
+  connection_ = HttpOutboundConnectionPool::get_connection(connection_key_);
+  if (!connection_.empty()) {
+    // if the connection was closed while idle, then the callback is destroyed and the query is repeated
+    LOG(DEBUG) << "Reuse HTTP connection to " << connection_key_;
+    is_reused_connection_ = true;
+    send_closure(connection_, &HttpOutboundConnection::set_callback,
+                 ActorShared<HttpOutboundConnection::Callback>(actor_id(this), ++reused_connection_generation_));
+    send_closure(connection_, &HttpOutboundConnection::write_next, BufferSlice(header));
+    send_closure(connection_, &HttpOutboundConnection::write_ok);
+    return Status::OK();
+  }
+  is_reused_connection_ = false;
+
   IPAddress addr;
   TRY_STATUS(addr.init_host_port(url.host_, url.port_, prefer_ipv6_));
 
@@ -91,6 +108,8 @@ Status Wget::try_init() {
         0, 0, ActorOwn<HttpOutboundConnection::Callback>(actor_id(this)));
   }
 
+  HttpOutboundConnectionPool::on_connection_created();
+
   send_closure(connection_, &HttpOutboundConnection::write_next, BufferSlice(header));
   send_closure(connection_, &HttpOutboundConnection::write_ok);
   return Status::OK();
@@ -110,6 +129,11 @@ void Wget::handle(unique_ptr<HttpQuery> result) {
 }
 
 void Wget::on_connection_error(Status error) {
+  if (is_reused_connection_ && get_link_token() == reused_connection_generation_) {
+    // the server could have closed the idle connection
+    LOG(DEBUG) << "Receive error from reused HTTP connection: " << error;
+    return on_reused_connection_lost();
+  }
   on_error(std::move(error));
 }
 
@@ -126,6 +150,12 @@ void Wget::on_ok(unique_ptr<HttpQuery> http_query_ptr) {
     connection_.reset();
     yield();
   } else if (http_query_ptr->code_ >= 200 && http_query_ptr->code_ < 300) {
+    // the connection can be reused only if the end of the response didn't depend on connection closing
+    if (http_query_ptr->keep_alive_ &&
+        (!http_query_ptr->get_header("content-length").empty() ||
+         !http_query_ptr->get_header("transfer-encoding").empty())) {
+      HttpOutboundConnectionPool::put_connection(std::move(connection_key_), std::move(connection_));
+    }
     promise_.set_value(std::move(http_query_ptr));
     stop();
   } else {
@@ -149,6 +179,21 @@ void Wget::timeout_expired() {
   on_error(Status::Error("Response timeout expired"));
 }
 
+void Wget::hangup_shared() {
+  if (is_reused_connection_ && get_link_token() == reused_connection_generation_) {
+    on_reused_connection_lost();
+  }
+}
+
+void Wget::on_reused_connection_lost() {
+  CHECK(promise_);
+  LOG(DEBUG) << "Reused HTTP connection to " << connection_key_ << " was closed";
+  HttpOutboundConnectionPool::on_connection_lost();
+  is_reused_connection_ = false;
+  connection_.reset();
+  loop();
+}
+
 void Wget::tear_down() {
   if (promise_) {
     on_error(Status::Error("Canceled"));
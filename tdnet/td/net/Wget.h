@@ -33,13 +33,18 @@ class Wget final : public HttpOutboundConnection::Callback {
   void on_connection_error(Status error) final;
   void on_ok(unique_ptr<HttpQuery> http_query_ptr);
   void on_error(Status error);
+  void on_reused_connection_lost();
 
   void tear_down() final;
   void start_up() final;
   void timeout_expired() final;
+  void hangup_shared() final;
 
   Promise<unique_ptr<HttpQuery>> promise_;
   ActorOwn<HttpOutboundConnection> connection_;
+  string connection_key_;
+  bool is_reused_connection_ = false;
+  uint64 reused_connection_generation_ = 0;
   string input_url_;
   std::vector<std::pair<string, string>> headers_;
   int32 timeout_in_;
@@ -0,0 +1,228 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// the functions must be the same as in the generated code
+static std::uint64_t emoji_hash(const std::string &str) {
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (auto c : str) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static std::uint64_t emoji_slot_hash(std::uint64_t hash, std::uint64_t displacement) {
+  hash ^= displacement * 0x9E3779B97F4A7C15ULL;
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+static const char *const LOOKUP_FUNCTION_SOURCE = R"(
+static std::uint64_t emoji_hash(Slice str) {
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (auto c : str) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static std::uint64_t emoji_slot_hash(std::uint64_t hash, std::uint64_t displacement) {
+  hash ^= displacement * 0x9E3779B97F4A7C15ULL;
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+bool is_emoji_table_element(Slice str) {
+  if (str.size() < MIN_EMOJI_TABLE_ELEMENT_LENGTH || str.size() > MAX_EMOJI_TABLE_ELEMENT_LENGTH) {
+    return false;
+  }
+  auto hash = emoji_hash(str);
+  auto displacement = EMOJI_TABLE_DISPLACEMENTS[hash % EMOJI_TABLE_BUCKET_COUNT];
+  auto slot = emoji_slot_hash(hash, displacement) % EMOJI_TABLE_SLOT_COUNT;
+  return EMOJI_TABLE_LENGTHS[slot] == str.size() &&
+         std::memcmp(EMOJI_TABLE_DATA + EMOJI_TABLE_OFFSETS[slot], str.data(), str.size()) == 0;
+}
+)";
+
+template <class T>
+static void write_array(std::ostream &out, const char *type, const char *name, const std::vector<T> &values) {
+  out << "static const " << type << ' ' << name << "[" << values.size() << "] = {";
+  for (std::size_t i = 0; i < values.size(); i++) {
+    out << (i % 20 == 0 ? "\n    " : " ") << static_cast<unsigned>(values[i]) << ',';
+  }
+  out << "\n};\n\n";
+}
+
+static bool generate(const char *file_name, const std::vector<std::string> &emojis) {
+  // each bucket contains 4 emojis on average and the table has 25% of empty slots
+  const std::size_t bucket_count = emojis.size() / 4 + 1;
+  const std::size_t slot_count = emojis.size() + emojis.size() / 4 + 1;
+
+  std::vector<std::vector<std::size_t>> buckets(bucket_count);
+  std::set<std::uint64_t> hashes;
+  for (std::size_t i = 0; i < emojis.size(); i++) {
+    auto hash = emoji_hash(emojis[i]);
+    if (!hashes.insert(hash).second) {
+      std::cerr << "Hash collision for emoji " << emojis[i] << std::endl;
+      return false;
+    }
+    buckets[hash % bucket_count].push_back(i);
+  }
+
+  // place the biggest buckets first, choosing for each bucket the first displacement without collisions
+  std::vector<std::size_t> bucket_order(bucket_count);
+  for (std::size_t i = 0; i < bucket_count; i++) {
+    bucket_order[i] = i;
+  }
+  std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](std::size_t lhs, std::size_t rhs) {
+    return buckets[lhs].size() > buckets[rhs].size();
+  });
+
+  std::vector<std::uint16_t> displacements(bucket_count, 0);
+  std::vector<std::size_t> slot_emoji(slot_count, emojis.size());
+  for (auto bucket_id : bucket_order) {
+    const auto &bucket = buckets[bucket_id];
+    if (bucket.empty()) {
+      break;
+    }
+    bool is_found = false;
+    for (std::uint32_t displacement = 0; displacement <= 0xFFFF && !is_found; displacement++) {
+      std::vector<std::size_t> slots;
+      for (auto emoji_id : bucket) {
+        auto slot = emoji_slot_hash(emoji_hash(emojis[emoji_id]), displacement) % slot_count;
+        if (slot_emoji[slot] != emojis.size() || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (slots.size() == bucket.size()) {
+        for (std::size_t i = 0; i < slots.size(); i++) {
+          slot_emoji[slots[i]] = bucket[i];
+        }
+        displacements[bucket_id] = static_cast<std::uint16_t>(displacement);
+        is_found = true;
+      }
+    }
+    if (!is_found) {
+      std::cerr << "Can't find displacement for bucket " << bucket_id << std::endl;
+      return false;
+    }
+  }
+
+  std::string data;
+  std::vector<std::size_t> emoji_offsets;
+  std::size_t min_length = emojis[0].size();
+  std::size_t max_length = 0;
+  for (auto &emoji : emojis) {
+    emoji_offsets.push_back(data.size());
+    data += emoji;
+    min_length = std::min(min_length, emoji.size());
+    max_length = std::max(max_length, emoji.size());
+  }
+  if (data.size() > 0xFFFF || max_length > 0xFF) {
+    std::cerr << "Too much data for the emoji table" << std::endl;
+    return false;
+  }
+
+  std::vector<std::uint16_t> offsets(slot_count, 0);
+  std::vector<std::uint8_t> lengths(slot_count, 0);
+  for (std::size_t slot = 0; slot < slot_count; slot++) {
+    auto emoji_id = slot_emoji[slot];
+    if (emoji_id != emojis.size()) {
+      offsets[slot] = static_cast<std::uint16_t>(emoji_offsets[emoji_id]);
+      lengths[slot] = static_cast<std::uint8_t>(emojis[emoji_id].size());
+    }
+  }
+
+  // binary mode is needed to keep line endings the same on all platforms
+  std::ofstream out(file_name, std::ios_base::trunc | std::ios_base::binary);
+  if (!out) {
+    std::cerr << "Can't open output file \"" << file_name << '"' << std::endl;
+    return false;
+  }
+
+  out << "// This file is auto-generated by generate_emoji_table. Don't edit it manually.\n";
+  out << "#include \"td/utils/common.h\"\n";
+  out << "#include \"td/utils/Slice.h\"\n\n";
+  out << "#include <cstdint>\n";
+  out << "#include <cstring>\n\n";
+  out << "namespace td {\n\n";
+  out << "static constexpr std::size_t MIN_EMOJI_TABLE_ELEMENT_LENGTH = " << min_length << ";\n";
+  out << "static constexpr std::size_t MAX_EMOJI_TABLE_ELEMENT_LENGTH = " << max_length << ";\n";
+  out << "static constexpr std::size_t EMOJI_TABLE_BUCKET_COUNT = " << bucket_count << ";\n";
+  out << "static constexpr std::size_t EMOJI_TABLE_SLOT_COUNT = " << slot_count << ";\n\n";
+
+  // octal escape sequences can't consume the next character unlike hexadecimal ones
+  out << "static const char EMOJI_TABLE_DATA[] =";
+  for (std::size_t i = 0; i < data.size(); i++) {
+    if (i % 32 == 0) {
+      out << (i == 0 ? "\n    \"" : "\"\n    \"");
+    }
+    auto c = static_cast<unsigned char>(data[i]);
+    out << '\\' << static_cast<char>('0' + (c >> 6)) << static_cast<char>('0' + ((c >> 3) & 7))
+        << static_cast<char>('0' + (c & 7));
+  }
+  out << "\";\n\n";
+
+  write_array(out, "std::uint16_t", "EMOJI_TABLE_DISPLACEMENTS", displacements);
+  write_array(out, "std::uint16_t", "EMOJI_TABLE_OFFSETS", offsets);
+  write_array(out, "std::uint8_t", "EMOJI_TABLE_LENGTHS", lengths);
+
+  out << "bool is_emoji_table_element(Slice str);\n";
+  out << LOOKUP_FUNCTION_SOURCE;
+  out << "\n}  // namespace td\n";
+  return static_cast<bool>(out);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Wrong number of arguments supplied. Expected 'generate_emoji_table <emoji.txt> <emoji_table.cpp>'"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ifstream in(argv[1], std::ios_base::in | std::ios_base::binary);
+  if (!in) {
+    std::cerr << "Can't open input file \"" << argv[1] << '"' << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> emojis;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      emojis.push_back(line);
+    }
+  }
+  if (emojis.empty()) {
+    std::cerr << "Emoji list is empty" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!generate(argv[2], emojis)) {
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,113 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/AllocationTags.h"
+
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/format.h"
+#include "td/utils/port/Mutex.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <algorithm>
+
+namespace td {
+
+constexpr int32 AllocationTags::MAX_TAG_COUNT;
+constexpr int32 AllocationTags::UNTAGGED;
+
+std::atomic<bool> AllocationTags::is_enabled_{false};
+std::atomic<uint32> AllocationTags::backtrace_sample_rate_{0};
+TD_THREAD_LOCAL int32 AllocationTags::current_tag_id_;
+AllocationTags::Counters AllocationTags::counters_[MAX_TAG_COUNT];
+
+static Mutex allocation_tags_mutex;
+
+namespace {
+struct AllocationTagNames {
+  FlatHashMap<string, int32> name_to_tag_id;
+  vector<string> names{"<untagged>"};
+};
+}  // namespace
+
+static AllocationTagNames &get_allocation_tag_names() {
+  static AllocationTagNames names;
+  return names;
+}
+
+void AllocationTags::set_enabled(bool is_enabled) {
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+void AllocationTags::set_backtrace_sample_rate(uint32 sample_rate) {
+  backtrace_sample_rate_.store(sample_rate, std::memory_order_relaxed);
+}
+
+int32 AllocationTags::get_tag_id(Slice name) {
+  if (name.empty()) {
+    return UNTAGGED;
+  }
+  auto lock = allocation_tags_mutex.lock();
+  auto &names = get_allocation_tag_names();
+  auto it = names.name_to_tag_id.find(name.str());
+  if (it != names.name_to_tag_id.end()) {
+    return it->second;
+  }
+  if (names.names.size() >= static_cast<size_t>(MAX_TAG_COUNT)) {
+    return UNTAGGED;
+  }
+  auto tag_id = static_cast<int32>(names.names.size());
+  names.names.push_back(name.str());
+  names.name_to_tag_id.emplace(name.str(), tag_id);
+  return tag_id;
+}
+
+string AllocationTags::get_tag_name(int32 tag_id) {
+  auto lock = allocation_tags_mutex.lock();
+  auto &names = get_allocation_tag_names().names;
+  if (tag_id < 0 || static_cast<size_t>(tag_id) >= names.size()) {
+    return names[UNTAGGED];
+  }
+  return names[tag_id];
+}
+
+vector<AllocationTags::Stats> AllocationTags::get_top_tags(size_t max_count) {
+  vector<Stats> result;
+  {
+    auto lock = allocation_tags_mutex.lock();
+    auto &names = get_allocation_tag_names().names;
+    for (size_t tag_id = 0; tag_id < names.size(); tag_id++) {
+      auto &counters = counters_[tag_id];
+      Stats stats;
+      stats.name = names[tag_id];
+      stats.size = counters.size.load(std::memory_order_relaxed);
+      stats.count = counters.count.load(std::memory_order_relaxed);
+      stats.total_count = counters.total_count.load(std::memory_order_relaxed);
+      result.push_back(std::move(stats));
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Stats &lhs, const Stats &rhs) {
+    if (lhs.size != rhs.size) {
+      return lhs.size > rhs.size;
+    }
+    return lhs.name < rhs.name;
+  });
+  if (result.size() > max_count) {
+    result.resize(max_count);
+  }
+  return result;
+}
+
+string AllocationTags::get_top_tags_string(size_t max_count) {
+  auto top_tags = get_top_tags(max_count);
+  string result;
+  for (auto &stats : top_tags) {
+    result += PSTRING() << stats.name << ": size = " << format::as_size(static_cast<uint64>(max(stats.size, int64())))
+                        << ", allocations = " << stats.count << ", total allocations = " << stats.total_count << '\n';
+  }
+  return result;
+}
+
+}  // namespace td
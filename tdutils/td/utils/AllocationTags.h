@@ -0,0 +1,111 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+
+namespace td {
+
+// Attribution of allocated memory to subsystems, for example, to actors.
+// The current thread-local tag is set by the code, which owns the thread, and the counters are updated by a malloc hook,
+// for example, by memprof built with MEMPROF=TAGS. Without a hook all counters remain zero.
+class AllocationTags {
+ public:
+  static constexpr int32 MAX_TAG_COUNT = 1024;
+  static constexpr int32 UNTAGGED = 0;
+
+  struct Stats {
+    string name;
+    int64 size = 0;
+    int64 count = 0;
+    uint64 total_count = 0;
+  };
+
+  static void set_enabled(bool is_enabled);
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // returns UNTAGGED if there are too many different tags
+  static int32 get_tag_id(Slice name);
+
+  static int32 get_current_tag_id() {
+    return current_tag_id_;
+  }
+
+  static void set_current_tag_id(int32 tag_id) {
+    current_tag_id_ = tag_id;
+  }
+
+  // a backtrace must be sampled for one of sample_rate allocations; 0 disables sampling
+  static void set_backtrace_sample_rate(uint32 sample_rate);
+
+  static uint32 get_backtrace_sample_rate() {
+    return backtrace_sample_rate_.load(std::memory_order_relaxed);
+  }
+
+  // must be called from a malloc hook, so must not allocate memory
+  static void on_allocation(int32 tag_id, size_t size) {
+    auto &counters = get_counters(tag_id);
+    counters.size.fetch_add(static_cast<int64>(size), std::memory_order_relaxed);
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+    counters.total_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static void on_deallocation(int32 tag_id, size_t size) {
+    auto &counters = get_counters(tag_id);
+    counters.size.fetch_sub(static_cast<int64>(size), std::memory_order_relaxed);
+    counters.count.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  static string get_tag_name(int32 tag_id);
+
+  // returns statistics of at most max_count tags with the biggest size of alive allocations
+  static vector<Stats> get_top_tags(size_t max_count);
+
+  static string get_top_tags_string(size_t max_count);
+
+ private:
+  struct Counters {
+    std::atomic<int64> size{0};
+    std::atomic<int64> count{0};
+    std::atomic<uint64> total_count{0};
+  };
+
+  static std::atomic<bool> is_enabled_;
+  static std::atomic<uint32> backtrace_sample_rate_;
+  static TD_THREAD_LOCAL int32 current_tag_id_;  // static zero-initialized
+  static Counters counters_[MAX_TAG_COUNT];
+
+  static Counters &get_counters(int32 tag_id) {
+    return counters_[static_cast<uint32>(tag_id) < static_cast<uint32>(MAX_TAG_COUNT) ? tag_id : UNTAGGED];
+  }
+};
+
+class AllocationTagGuard {
+ public:
+  explicit AllocationTagGuard(int32 tag_id) : old_tag_id_(AllocationTags::get_current_tag_id()) {
+    AllocationTags::set_current_tag_id(tag_id);
+  }
+  AllocationTagGuard(const AllocationTagGuard &) = delete;
+  AllocationTagGuard &operator=(const AllocationTagGuard &) = delete;
+  AllocationTagGuard(AllocationTagGuard &&) = delete;
+  AllocationTagGuard &operator=(AllocationTagGuard &&) = delete;
+  ~AllocationTagGuard() {
+    AllocationTags::set_current_tag_id(old_tag_id_);
+  }
+
+ private:
+  int32 old_tag_id_;
+};
+
+}  // namespace td
@@ -0,0 +1,69 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/Arena.h"
+
+#include "td/utils/port/thread_local.h"
+
+namespace td {
+
+constexpr size_t Arena::DEFAULT_CHUNK_SIZE;
+
+void *Arena::allocate_slow(size_t size, size_t alignment) {
+  // the current chunk is full; try the next one, which could be left after a rollback
+  if (chunk_index_ + 1 < chunks_.size()) {
+    auto &chunk = chunks_[chunk_index_ + 1];
+    auto pos = get_aligned_pos(chunk, 0, alignment);
+    if (pos + size <= chunk.size) {
+      chunk_index_++;
+      chunk_pos_ = pos + size;
+      return chunk.data.get() + pos;
+    }
+  }
+
+  Chunk chunk;
+  chunk.size = max(chunk_size_, size + alignment);
+  chunk.data = std::make_unique<char[]>(chunk.size);
+  capacity_ += chunk.size;
+
+  // the chunks after the current one are unused, so the new chunk can be inserted before them
+  auto new_chunk_index = chunks_.empty() ? 0 : chunk_index_ + 1;
+  chunks_.insert(chunks_.begin() + new_chunk_index, std::move(chunk));
+  chunk_index_ = new_chunk_index;
+
+  auto &new_chunk = chunks_[chunk_index_];
+  auto pos = get_aligned_pos(new_chunk, 0, alignment);
+  chunk_pos_ = pos + size;
+  return new_chunk.data.get() + pos;
+}
+
+void Arena::reset(size_t max_kept_chunk_count) {
+  chunk_index_ = 0;
+  chunk_pos_ = 0;
+  while (chunks_.size() > max_kept_chunk_count) {
+    capacity_ -= chunks_.back().size;
+    chunks_.pop_back();
+  }
+}
+
+size_t Arena::get_used_size() const {
+  if (chunks_.empty()) {
+    return 0;
+  }
+  size_t result = chunk_pos_;
+  for (size_t i = 0; i < chunk_index_; i++) {
+    result += chunks_[i].size;
+  }
+  return result;
+}
+
+Arena &get_event_arena() {
+  static TD_THREAD_LOCAL Arena *arena;  // static zero-initialized
+  init_thread_local<Arena>(arena);
+  return *arena;
+}
+
+}  // namespace td
@@ -0,0 +1,157 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace td {
+
+// Growable bump allocator for short-lived objects. Memory is never freed individually;
+// it is released all at once by rollback to a previously saved checkpoint or by reset.
+class Arena {
+ public:
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 14;
+
+  struct Checkpoint {
+    size_t chunk_index = 0;
+    size_t chunk_pos = 0;
+  };
+
+  class Scope {
+   public:
+    explicit Scope(Arena &arena) : arena_(arena), checkpoint_(arena.get_checkpoint()) {
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    Scope(Scope &&) = delete;
+    Scope &operator=(Scope &&) = delete;
+    ~Scope() {
+      arena_.rollback(checkpoint_);
+    }
+
+   private:
+    Arena &arena_;
+    Checkpoint checkpoint_;
+  };
+
+  explicit Arena(size_t chunk_size = DEFAULT_CHUNK_SIZE) : chunk_size_(chunk_size) {
+  }
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  Arena(Arena &&) = delete;
+  Arena &operator=(Arena &&) = delete;
+  ~Arena() = default;
+
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    DCHECK(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    if (chunk_index_ < chunks_.size()) {
+      auto &chunk = chunks_[chunk_index_];
+      auto pos = get_aligned_pos(chunk, chunk_pos_, alignment);
+      if (pos + size <= chunk.size) {
+        chunk_pos_ = pos + size;
+        return chunk.data.get() + pos;
+      }
+    }
+    return allocate_slow(size, alignment);
+  }
+
+  Checkpoint get_checkpoint() const {
+    Checkpoint result;
+    result.chunk_index = chunk_index_;
+    result.chunk_pos = chunk_pos_;
+    return result;
+  }
+
+  // frees all memory allocated after the checkpoint was taken; allocated chunks are kept for reuse
+  void rollback(Checkpoint checkpoint) {
+    DCHECK(checkpoint.chunk_index < chunk_index_ ||
+           (checkpoint.chunk_index == chunk_index_ && checkpoint.chunk_pos <= chunk_pos_));
+    chunk_index_ = checkpoint.chunk_index;
+    chunk_pos_ = checkpoint.chunk_pos;
+  }
+
+  // frees all allocated memory and returns to the system all chunks except the first max_kept_chunk_count
+  void reset(size_t max_kept_chunk_count = 1);
+
+  // returns total size of the chunks
+  size_t get_capacity() const {
+    return capacity_;
+  }
+
+  // returns total size of the chunks before the current position
+  size_t get_used_size() const;
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+  };
+  std::vector<Chunk> chunks_;
+  size_t chunk_index_ = 0;
+  size_t chunk_pos_ = 0;
+  size_t chunk_size_ = 0;
+  size_t capacity_ = 0;
+
+  static size_t get_aligned_pos(const Chunk &chunk, size_t pos, size_t alignment) {
+    auto begin = reinterpret_cast<std::uintptr_t>(chunk.data.get());
+    return static_cast<size_t>(((begin + pos + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1)) - begin);
+  }
+
+  void *allocate_slow(size_t size, size_t alignment);
+};
+
+// arena of the current thread, which is reset by the Scheduler after each event of an actor
+// outside of actors it is never reset, so it can be used there only under Arena::Scope
+Arena &get_event_arena();
+
+// allocator, which can be used in standard containers to allocate memory from an Arena
+template <class T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena &arena) noexcept : arena_(&arena) {
+  }
+
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.get_arena()) {
+  }
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *, size_t) noexcept {
+  }
+
+  Arena *get_arena() const noexcept {
+    return arena_;
+  }
+
+ private:
+  Arena *arena_;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs) noexcept {
+  return lhs.get_arena() == rhs.get_arena();
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs) noexcept {
+  return !(lhs == rhs);
+}
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}  // namespace td
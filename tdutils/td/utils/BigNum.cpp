@@ -10,8 +10,10 @@ char disable_linker_warning_about_empty_file_bignum_cpp TD_UNUSED;
 
 #if TD_HAVE_OPENSSL
 
+#include "td/utils/Destructor.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
 
 #include <openssl/bn.h>
@@ -313,6 +315,70 @@ int BigNum::compare(const BigNum &a, const BigNum &b) {
   return BN_cmp(a.impl_->big_num, b.impl_->big_num);
 }
 
+static BN_CTX *get_thread_local_big_num_context() {
+  static TD_THREAD_LOCAL BN_CTX *big_num_context;  // static zero-initialized
+  if (unlikely(big_num_context == nullptr)) {
+    big_num_context = BN_CTX_new();
+    LOG_IF(FATAL, big_num_context == nullptr);
+    detail::add_thread_local_destructor(create_destructor([] {
+      BN_CTX_free(big_num_context);
+      big_num_context = nullptr;
+    }));
+  }
+  return big_num_context;
+}
+
+class BigNumModContext::Impl {
+ public:
+  BigNum modulus;
+  BN_MONT_CTX *mont_context = nullptr;  // nullptr for even modulus, for which Montgomery multiplication is unusable
+
+  explicit Impl(const BigNum &modulus) : modulus(modulus) {
+    if (BN_is_odd(modulus.impl_->big_num)) {
+      mont_context = BN_MONT_CTX_new();
+      LOG_IF(FATAL, mont_context == nullptr);
+      auto result = BN_MONT_CTX_set(mont_context, modulus.impl_->big_num, get_thread_local_big_num_context());
+      LOG_IF(FATAL, result != 1);
+    }
+  }
+  Impl(const Impl &) = delete;
+  Impl &operator=(const Impl &) = delete;
+  Impl(Impl &&) = delete;
+  Impl &operator=(Impl &&) = delete;
+  ~Impl() {
+    BN_MONT_CTX_free(mont_context);
+  }
+};
+
+BigNumModContext::BigNumModContext(const BigNum &modulus) : impl_(make_unique<Impl>(modulus)) {
+}
+
+BigNumModContext::BigNumModContext(BigNumModContext &&) noexcept = default;
+BigNumModContext &BigNumModContext::operator=(BigNumModContext &&) noexcept = default;
+BigNumModContext::~BigNumModContext() = default;
+
+const BigNum &BigNumModContext::get_modulus() const {
+  return impl_->modulus;
+}
+
+void BigNumModContext::mod_exp(BigNum &r, const BigNum &a, const BigNum &p) const {
+  auto *big_num_context = get_thread_local_big_num_context();
+  const BIGNUM *m = impl_->modulus.impl_->big_num;
+  int result;
+  if (impl_->mont_context == nullptr) {
+    result = BN_mod_exp(r.impl_->big_num, a.impl_->big_num, p.impl_->big_num, m, big_num_context);
+  } else if (!BN_is_negative(a.impl_->big_num) && a.get_num_bits() <= 32 &&
+             BN_get_flags(p.impl_->big_num, BN_FLG_CONSTTIME) == 0) {
+    // the same shortcut as in BN_mod_exp for small bases like DH generators
+    result = BN_mod_exp_mont_word(r.impl_->big_num, static_cast<BN_ULONG>(BN_get_word(a.impl_->big_num)),
+                                  p.impl_->big_num, m, big_num_context, impl_->mont_context);
+  } else {
+    result = BN_mod_exp_mont(r.impl_->big_num, a.impl_->big_num, p.impl_->big_num, m, big_num_context,
+                             impl_->mont_context);
+  }
+  LOG_IF(FATAL, result != 1);
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const BigNum &bn) {
   return sb << bn.to_decimal();
 }
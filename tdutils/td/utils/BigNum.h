@@ -113,6 +113,29 @@ class BigNum {
   unique_ptr<Impl> impl_;
 
   explicit BigNum(unique_ptr<Impl> &&impl);
+
+  friend class BigNumModContext;
+};
+
+// Context for repeated operations modulo the same number with precomputed Montgomery multiplication data.
+// Can be used simultaneously from different threads; temporary values are allocated in a thread-local BN_CTX.
+class BigNumModContext {
+ public:
+  explicit BigNumModContext(const BigNum &modulus);
+  BigNumModContext(const BigNumModContext &) = delete;
+  BigNumModContext &operator=(const BigNumModContext &) = delete;
+  BigNumModContext(BigNumModContext &&other) noexcept;
+  BigNumModContext &operator=(BigNumModContext &&other) noexcept;
+  ~BigNumModContext();
+
+  const BigNum &get_modulus() const;
+
+  // r = a^p mod modulus
+  void mod_exp(BigNum &r, const BigNum &a, const BigNum &p) const;
+
+ private:
+  class Impl;
+  unique_ptr<Impl> impl_;
 };
 
 StringBuilder &operator<<(StringBuilder &sb, const BigNum &bn);
@@ -0,0 +1,564 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/BinaryFileLog.h"
+
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace td {
+
+#if !TD_THREAD_UNSUPPORTED
+
+// The file consists of the header followed by records. Each record is stored as its size and its content.
+// The first byte of the content is the record type:
+//  'F' - name of a source file: uint64 file identifier, string name
+//  'M' - message: double time, int32 log level, int32 thread identifier, uint64 file identifier,
+//        uint32 file name length, int32 line, string tag, string tag2, string comment, arguments
+//  'T' - already formatted message
+//  'D' - uint64 number of dropped messages
+// Strings are stored as uint32 length followed by the string. All values are stored in the native byte order.
+static constexpr Slice BINARY_LOG_HEADER("TDLOGBIN");
+
+namespace {
+
+template <class T>
+void append_value(string &output, const T &value) {
+  output.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void append_record(string &output, Slice record) {
+  append_value(output, static_cast<uint32>(record.size()));
+  output.append(record.begin(), record.size());
+}
+
+class BinaryLogParser {
+ public:
+  explicit BinaryLogParser(Slice data) : data_(data) {
+  }
+
+  template <class T>
+  T fetch_value() {
+    T result{};
+    if (data_.size() < sizeof(T)) {
+      set_error();
+      return result;
+    }
+    std::memcpy(&result, data_.begin(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return result;
+  }
+
+  Slice fetch_string() {
+    auto size = fetch_value<uint32>();
+    if (data_.size() < size) {
+      set_error();
+      return Slice();
+    }
+    auto result = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return result;
+  }
+
+  bool empty() const {
+    return data_.empty();
+  }
+
+  bool has_error() const {
+    return has_error_;
+  }
+
+ private:
+  Slice data_;
+  bool has_error_ = false;
+
+  void set_error() {
+    has_error_ = true;
+    data_ = Slice();
+  }
+};
+
+}  // namespace
+
+struct BinaryFileLog::Ring {
+  explicit Ring(size_t size) : data(new char[size]), mask(size - 1) {
+  }
+
+  std::unique_ptr<char[]> data;
+  size_t mask;
+  std::atomic<uint64> write_pos{0};
+  std::atomic<uint64> read_pos{0};
+  std::atomic<uint64> dropped_count{0};
+  std::atomic<bool> is_used{true};
+  uint64 reported_dropped_count = 0;  // accessed only by the writer thread
+
+  // must be called only by the owner thread
+  bool push(char type, Slice record) {
+    auto record_size = static_cast<uint32>(record.size() + 1);
+    auto write = write_pos.load(std::memory_order_relaxed);
+    auto read = read_pos.load(std::memory_order_acquire);
+    if (static_cast<uint64>(mask + 1) - (write - read) < sizeof(record_size) + static_cast<uint64>(record_size)) {
+      dropped_count.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    write = copy_in(write, &record_size, sizeof(record_size));
+    write = copy_in(write, &type, 1);
+    write = copy_in(write, record.begin(), record.size());
+    write_pos.store(write, std::memory_order_release);
+    return true;
+  }
+
+  // must be called only by the writer thread
+  bool pop(string &record) {
+    auto read = read_pos.load(std::memory_order_relaxed);
+    auto write = write_pos.load(std::memory_order_acquire);
+    if (read == write) {
+      return false;
+    }
+    uint32 record_size;
+    read = copy_out(read, &record_size, sizeof(record_size));
+    record.resize(record_size);
+    read = copy_out(read, &record[0], record_size);
+    read_pos.store(read, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return read_pos.load(std::memory_order_acquire) == write_pos.load(std::memory_order_acquire);
+  }
+
+ private:
+  uint64 copy_in(uint64 pos, const void *source, size_t size) {
+    auto offset = static_cast<size_t>(pos) & mask;
+    auto first_size = min(size, mask + 1 - offset);
+    std::memcpy(data.get() + offset, source, first_size);
+    std::memcpy(data.get(), static_cast<const char *>(source) + first_size, size - first_size);
+    return pos + size;
+  }
+
+  uint64 copy_out(uint64 pos, void *destination, size_t size) const {
+    auto offset = static_cast<size_t>(pos) & mask;
+    auto first_size = min(size, mask + 1 - offset);
+    std::memcpy(destination, data.get() + offset, first_size);
+    std::memcpy(static_cast<char *>(destination) + first_size, data.get(), size - first_size);
+    return pos + size;
+  }
+};
+
+// the ring is released on thread exit for reuse by another thread
+struct BinaryFileLog::ThreadRing {
+  std::shared_ptr<Ring> ring;
+  uint64 log_id = 0;
+
+  ThreadRing() = default;
+  ThreadRing(const ThreadRing &) = delete;
+  ThreadRing &operator=(const ThreadRing &) = delete;
+  ThreadRing(ThreadRing &&) = delete;
+  ThreadRing &operator=(ThreadRing &&) = delete;
+  ~ThreadRing() {
+    if (ring != nullptr) {
+      ring->is_used.store(false, std::memory_order_release);
+    }
+    // the thread can log from destructors of other thread local objects, but mustn't recreate ThreadRing
+    is_thread_ring_destroyed_ = true;
+  }
+};
+
+constexpr size_t BinaryFileLog::DEFAULT_RING_SIZE;
+constexpr size_t BinaryFileLog::MAX_RING_COUNT;
+
+TD_THREAD_LOCAL BinaryFileLog::ThreadRing *BinaryFileLog::thread_ring_;  // static zero-initialized
+TD_THREAD_LOCAL bool BinaryFileLog::is_thread_ring_destroyed_;
+
+static std::atomic<uint64> next_binary_file_log_id{1};
+
+BinaryFileLog::BinaryFileLog() : log_id_(next_binary_file_log_id.fetch_add(1, std::memory_order_relaxed)) {
+}
+
+BinaryFileLog::~BinaryFileLog() {
+  stop_writer();
+  fd_.close();
+}
+
+Status BinaryFileLog::init(string path, int64 rotate_threshold, size_t ring_size) {
+  CHECK(!path.empty());
+  if (rotate_threshold <= 0) {
+    return Status::Error("Invalid log rotation threshold");
+  }
+  size_t rounded_ring_size = 1024;
+  while (rounded_ring_size < ring_size) {
+    rounded_ring_size *= 2;
+  }
+
+  {
+    TRY_RESULT(fd, FileFd::open(path, FileFd::Create | FileFd::Write | FileFd::Append));
+    fd.close();
+  }
+
+  stop_writer();
+
+  auto r_path = realpath(path, true);
+  if (r_path.is_error()) {
+    path_ = std::move(path);
+  } else {
+    path_ = r_path.move_as_ok();
+  }
+  rotate_threshold_ = rotate_threshold;
+  TRY_STATUS(open_file());
+
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    ring_size_ = rounded_ring_size;
+    if (rings_.empty()) {
+      rings_.push_back(std::make_shared<Ring>(ring_size_));
+    }
+  }
+
+  writer_thread_ = thread([this] { run_writer(); });
+  is_writer_started_ = true;
+  return Status::OK();
+}
+
+uint64 BinaryFileLog::get_dropped_count() const {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  uint64 result = 0;
+  for (auto &ring : rings_) {
+    result += ring->dropped_count.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void BinaryFileLog::stop_writer() {
+  if (!is_writer_started_) {
+    return;
+  }
+  is_closing_.store(true, std::memory_order_release);
+  writer_thread_.join();
+  is_writer_started_ = false;
+  is_closing_.store(false, std::memory_order_relaxed);
+}
+
+BinaryFileLog::Ring *BinaryFileLog::get_current_ring() {
+  if (is_thread_ring_destroyed_) {
+    return nullptr;
+  }
+  init_thread_local<ThreadRing>(thread_ring_);
+  auto *thread_ring = thread_ring_;
+  if (thread_ring->log_id == log_id_) {
+    return thread_ring->ring.get();
+  }
+
+  if (thread_ring->ring != nullptr) {
+    thread_ring->ring->is_used.store(false, std::memory_order_release);
+    thread_ring->ring = nullptr;
+  }
+  thread_ring->log_id = log_id_;
+
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  if (rings_.empty()) {
+    process_fatal_error("BinaryFileLog is not inited");
+  }
+  for (size_t i = 1; i < rings_.size(); i++) {
+    if (!rings_[i]->is_used.load(std::memory_order_acquire)) {
+      rings_[i]->is_used.store(true, std::memory_order_relaxed);
+      thread_ring->ring = rings_[i];
+      return thread_ring->ring.get();
+    }
+  }
+  if (rings_.size() < MAX_RING_COUNT) {
+    rings_.push_back(std::make_shared<Ring>(ring_size_));
+    thread_ring->ring = rings_.back();
+  }
+  return thread_ring->ring.get();
+}
+
+void BinaryFileLog::push_record(char type, Slice record) {
+  auto *ring = get_current_ring();
+  if (ring != nullptr) {
+    ring->push(type, record);
+    return;
+  }
+
+  Ring *shared_ring;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    shared_ring = rings_[0].get();
+  }
+  std::lock_guard<std::mutex> lock(shared_ring_mutex_);
+  shared_ring->push(type, record);
+}
+
+bool BinaryFileLog::is_empty() const {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (auto &ring : rings_) {
+    if (!ring->empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BinaryFileLog::run_writer() {
+  string record;
+  string output;
+  vector<Ring *> rings;
+  while (true) {
+    auto is_closing = is_closing_.load(std::memory_order_acquire);
+    if (need_reopen_.exchange(false, std::memory_order_acq_rel)) {
+      auto status = open_file();
+      if (status.is_error()) {
+        process_fatal_error(PSLICE() << status << " in " << __FILE__ << " at " << __LINE__ << '\n');
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(rings_mutex_);
+      rings.clear();
+      for (auto &ring : rings_) {
+        rings.push_back(ring.get());
+      }
+    }
+    bool has_records = false;
+    for (auto *ring : rings) {
+      while (ring->pop(record)) {
+        has_records = true;
+        process_record(record, output);
+        if (output.size() >= (1 << 16)) {
+          write_output(output);
+        }
+      }
+      auto dropped_count = ring->dropped_count.load(std::memory_order_relaxed);
+      if (dropped_count != ring->reported_dropped_count) {
+        string dropped_record(1, 'D');
+        append_value(dropped_record, dropped_count - ring->reported_dropped_count);
+        append_record(output, dropped_record);
+        ring->reported_dropped_count = dropped_count;
+      }
+    }
+    write_output(output);
+
+    if (is_closing) {
+      break;
+    }
+    if (!has_records) {
+      usleep_for(10000);
+    }
+  }
+}
+
+void BinaryFileLog::process_record(Slice record, string &output) {
+  if (size_ + static_cast<int64>(output.size()) > rotate_threshold_) {
+    write_output(output);
+    rotate();
+  }
+
+  static constexpr size_t FILE_ID_OFFSET = 1 + sizeof(double) + 2 * sizeof(int32);
+  if (record[0] != 'M') {
+    append_record(output, record);
+    return;
+  }
+  if (record.size() < FILE_ID_OFFSET + sizeof(uint64) + sizeof(uint32)) {
+    return;
+  }
+
+  uint64 file_address;
+  uint32 file_name_size;
+  std::memcpy(&file_address, record.begin() + FILE_ID_OFFSET, sizeof(file_address));
+  std::memcpy(&file_name_size, record.begin() + FILE_ID_OFFSET + sizeof(uint64), sizeof(file_name_size));
+  uint64 file_id = 0;
+  if (file_address != 0) {
+    auto &id = file_ids_[file_address];
+    if (id == 0) {
+      id = file_ids_.size();
+      string file_record(1, 'F');
+      append_value(file_record, id);
+      append_value(file_record, file_name_size);
+      file_record.append(reinterpret_cast<const char *>(static_cast<std::uintptr_t>(file_address)), file_name_size);
+      append_record(output, file_record);
+    }
+    file_id = id;
+  }
+
+  auto record_pos = output.size() + sizeof(uint32);
+  append_record(output, record);
+  std::memcpy(&output[record_pos + FILE_ID_OFFSET], &file_id, sizeof(file_id));
+}
+
+void BinaryFileLog::write_output(string &output) {
+  Slice slice = output;
+  while (!slice.empty()) {
+    auto r_size = fd_.write(slice);
+    if (r_size.is_error()) {
+      process_fatal_error(PSLICE() << r_size.error() << " in " << __FILE__ << " at " << __LINE__ << '\n');
+    }
+    auto written = r_size.ok();
+    size_ += static_cast<int64>(written);
+    slice.remove_prefix(written);
+  }
+  output.clear();
+}
+
+Status BinaryFileLog::open_file() {
+  TRY_RESULT(fd, FileFd::open(path_, FileFd::Create | FileFd::Write | FileFd::Append));
+  TRY_RESULT(size, fd.get_size());
+  fd_.close();
+  fd_ = std::move(fd);
+  size_ = size;
+  file_ids_.clear();
+  if (size_ == 0) {
+    string header = BINARY_LOG_HEADER.str();
+    write_output(header);
+  }
+  return Status::OK();
+}
+
+void BinaryFileLog::rotate() {
+  auto status = rename(path_, PSLICE() << path_ << ".old");
+  if (status.is_error()) {
+    process_fatal_error(PSLICE() << status << " in " << __FILE__ << " at " << __LINE__ << '\n');
+  }
+  status = open_file();
+  if (status.is_error()) {
+    process_fatal_error(PSLICE() << status << " in " << __FILE__ << " at " << __LINE__ << '\n');
+  }
+}
+
+vector<string> BinaryFileLog::get_file_paths() {
+  vector<string> result;
+  if (!path_.empty()) {
+    result.push_back(path_);
+    result.push_back(PSTRING() << path_ << ".old");
+  }
+  return result;
+}
+
+void BinaryFileLog::after_rotation() {
+  need_reopen_.store(true, std::memory_order_release);
+}
+
+void BinaryFileLog::do_append(int log_level, CSlice slice) {
+  push_record('T', slice);
+  if (log_level == VERBOSITY_NAME(FATAL)) {
+    // it is not thread-safe to join writer_thread_ there, so just wait for the log line to be written
+    auto end_time = Time::now() + 1.0;
+    while (!is_empty() && Time::now() < end_time) {
+      usleep_for(1000);
+    }
+    usleep_for(5000);  // allow some time for the log line to be actually written
+  }
+}
+
+void BinaryFileLog::do_append_binary(int log_level, Slice record) {
+  push_record('M', record);
+}
+
+Status BinaryFileLog::decode(Slice data, const std::function<void(CSlice)> &on_message) {
+  if (!begins_with(data, BINARY_LOG_HEADER)) {
+    return Status::Error("Not a binary log file");
+  }
+  data.remove_prefix(BINARY_LOG_HEADER.size());
+
+  FlatHashMap<uint64, string> file_names;
+  StringBuilder sb;
+  while (!data.empty()) {
+    BinaryLogParser record_parser(data);
+    auto record = record_parser.fetch_string();
+    if (record_parser.has_error() || record.empty()) {
+      return Status::Error("Binary log file is truncated");
+    }
+    data.remove_prefix(sizeof(uint32) + record.size());
+
+    auto type = record[0];
+    BinaryLogParser parser(record.substr(1));
+    switch (type) {
+      case 'F': {
+        auto file_id = parser.fetch_value<uint64>();
+        auto file_name = parser.fetch_string();
+        if (parser.has_error() || file_id == 0) {
+          return Status::Error("Invalid file name record");
+        }
+        file_names[file_id] = file_name.str();
+        break;
+      }
+      case 'M': {
+        auto time = parser.fetch_value<double>();
+        auto log_level = parser.fetch_value<int32>();
+        auto thread_id = parser.fetch_value<int32>();
+        auto file_id = parser.fetch_value<uint64>();
+        parser.fetch_value<uint32>();
+        auto line = parser.fetch_value<int32>();
+        auto tag = parser.fetch_string();
+        auto tag2 = parser.fetch_string();
+        auto comment = parser.fetch_string();
+        if (parser.has_error()) {
+          return Status::Error("Invalid message record");
+        }
+        Slice file_name;
+        if (file_id != 0) {
+          auto it = file_names.find(file_id);
+          file_name = it == file_names.end() ? Slice("<unknown>") : Slice(it->second);
+        }
+
+        sb.clear();
+        detail::format_log_header(sb, log_level, thread_id, time, file_name, line, tag, tag2, comment);
+        while (!parser.empty()) {
+          using detail::BinaryLogArgumentType;
+          switch (static_cast<BinaryLogArgumentType>(parser.fetch_value<char>())) {
+            case BinaryLogArgumentType::Int:
+              sb << parser.fetch_value<int64>();
+              break;
+            case BinaryLogArgumentType::UInt:
+              sb << parser.fetch_value<uint64>();
+              break;
+            case BinaryLogArgumentType::Double:
+              sb << parser.fetch_value<double>();
+              break;
+            case BinaryLogArgumentType::Char:
+              sb << parser.fetch_value<char>();
+              break;
+            case BinaryLogArgumentType::Bool:
+              sb << (parser.fetch_value<char>() != 0);
+              break;
+            case BinaryLogArgumentType::String:
+              sb << parser.fetch_string();
+              break;
+            default:
+              return Status::Error("Invalid message argument");
+          }
+        }
+        while (sb.size() > 0 && sb.as_cslice().back() == '\n') {
+          sb.pop_back();
+        }
+        sb << '\n';
+        on_message(sb.as_cslice());
+        break;
+      }
+      case 'T':
+        on_message(PSLICE() << record.substr(1));
+        break;
+      case 'D': {
+        auto dropped_count = parser.fetch_value<uint64>();
+        on_message(PSLICE() << "<" << dropped_count << " log messages were dropped>\n");
+        break;
+      }
+      default:
+        return Status::Error("Invalid record type");
+    }
+  }
+  return Status::OK();
+}
+
+#endif
+
+}  // namespace td
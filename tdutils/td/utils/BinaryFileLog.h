@@ -0,0 +1,121 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace td {
+
+#if !TD_THREAD_UNSUPPORTED
+
+// Log, which doesn't format messages on the calling thread. Logged arguments are stored in a binary form
+// to a lock-free per-thread ring buffer and are written to the file by a background thread.
+// Source files are identified by the address of their name, which is written to the file only once.
+// Fatal messages and messages, which are passed to the log message callback, are formatted as usual.
+// Messages are dropped if the ring buffer of the thread is full. Use decode or td_log_decode to convert the file to text.
+class BinaryFileLog final : public LogInterface {
+ public:
+  static constexpr size_t DEFAULT_RING_SIZE = 1 << 20;
+
+  BinaryFileLog();
+  BinaryFileLog(const BinaryFileLog &) = delete;
+  BinaryFileLog &operator=(const BinaryFileLog &) = delete;
+  BinaryFileLog(BinaryFileLog &&) = delete;
+  BinaryFileLog &operator=(BinaryFileLog &&) = delete;
+  ~BinaryFileLog() final;
+
+  // can be called multiple times; messages logged concurrently with reinitialization aren't lost
+  Status init(string path, int64 rotate_threshold, size_t ring_size = DEFAULT_RING_SIZE);
+
+  Slice get_path() const {
+    return path_;
+  }
+
+  int64 get_rotate_threshold() const {
+    return rotate_threshold_;
+  }
+
+  // returns number of messages, which were dropped because of a full ring buffer
+  uint64 get_dropped_count() const;
+
+  // converts binary log file content to text, calling the callback for each message
+  static Status decode(Slice data, const std::function<void(CSlice)> &on_message);
+
+ private:
+  struct Ring;
+  struct ThreadRing;
+
+  static constexpr size_t MAX_RING_COUNT = 256;
+
+  const uint64 log_id_;
+  string path_;
+  int64 rotate_threshold_ = 0;
+
+  mutable std::mutex rings_mutex_;
+  vector<std::shared_ptr<Ring>> rings_;  // rings_[0] is shared by all threads, which failed to get their own ring
+  size_t ring_size_ = 0;
+  std::mutex shared_ring_mutex_;
+
+  thread writer_thread_;
+  bool is_writer_started_ = false;
+  std::atomic<bool> is_closing_{false};
+  std::atomic<bool> need_reopen_{false};
+
+  // accessed only by the writer thread
+  FileFd fd_;
+  int64 size_ = 0;
+  FlatHashMap<uint64, uint64> file_ids_;
+
+  static TD_THREAD_LOCAL ThreadRing *thread_ring_;
+  static TD_THREAD_LOCAL bool is_thread_ring_destroyed_;
+
+  void stop_writer();
+
+  Ring *get_current_ring();
+
+  void push_record(char type, Slice record);
+
+  bool is_empty() const;
+
+  void run_writer();
+
+  void process_record(Slice record, string &output);
+
+  void write_output(string &output);
+
+  Status open_file();
+
+  void rotate();
+
+  vector<string> get_file_paths() final;
+
+  void after_rotation() final;
+
+  bool is_binary() const final {
+    return true;
+  }
+
+  void do_append(int log_level, CSlice slice) final;
+
+  void do_append_binary(int log_level, Slice record) final;
+};
+
+#endif
+
+}  // namespace td
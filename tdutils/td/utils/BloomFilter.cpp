@@ -0,0 +1,41 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/BloomFilter.h"
+
+namespace td {
+
+BloomFilter::BloomFilter(size_t capacity) : capacity_(max(capacity, static_cast<size_t>(64))) {
+  bits_.resize((capacity_ * BITS_PER_ELEMENT + 63) / 64);
+  bit_count_ = bits_.size() * 64;
+}
+
+size_t BloomFilter::get_bit(uint64 hash, int i) const {
+  // double hashing; the second hash is odd, so all positions differ while i is small
+  auto first_hash = hash & 0xFFFFFFFF;
+  auto second_hash = (hash >> 32) | 1;
+  return static_cast<size_t>((first_hash + static_cast<uint64>(i) * second_hash) % bit_count_);
+}
+
+void BloomFilter::add(uint64 hash) {
+  for (int i = 0; i < HASH_COUNT; i++) {
+    auto bit = get_bit(hash, i);
+    bits_[bit / 64] |= static_cast<uint64>(1) << (bit % 64);
+  }
+  size_++;
+}
+
+bool BloomFilter::may_contain(uint64 hash) const {
+  for (int i = 0; i < HASH_COUNT; i++) {
+    auto bit = get_bit(hash, i);
+    if ((bits_[bit / 64] & (static_cast<uint64>(1) << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace td
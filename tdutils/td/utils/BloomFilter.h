@@ -0,0 +1,46 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// set of 64-bit hashes, which can have false positives, but never has false negatives
+// the false positive rate is about 1% while the number of added hashes doesn't exceed the capacity
+class BloomFilter {
+ public:
+  BloomFilter() : BloomFilter(0) {
+  }
+
+  explicit BloomFilter(size_t capacity);
+
+  void add(uint64 hash);
+
+  bool may_contain(uint64 hash) const;
+
+  size_t size() const {
+    return size_;
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+ private:
+  static constexpr size_t BITS_PER_ELEMENT = 10;
+  static constexpr int HASH_COUNT = 7;
+
+  vector<uint64> bits_;
+  size_t bit_count_ = 0;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+
+  size_t get_bit(uint64 hash, int i) const;
+};
+
+}  // namespace td
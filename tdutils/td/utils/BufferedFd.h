@@ -19,6 +19,35 @@
 #include <limits>
 
 namespace td {
+
+namespace detail {
+// file descriptors can provide their own way to write a buffer, for example, without copying
+template <class FdT>
+auto write_buffer(FdT &fd, ChainBufferReader &reader, int) -> decltype(fd.write_buffer(reader)) {
+  return fd.write_buffer(reader);
+}
+
+template <class FdT>
+Result<size_t> write_buffer(FdT &fd, ChainBufferReader &reader, long) {
+  constexpr size_t BUF_SIZE = 20;
+  IoSlice buf[BUF_SIZE];
+
+  auto it = reader.clone();
+  size_t buf_i;
+  for (buf_i = 0; buf_i < BUF_SIZE; buf_i++) {
+    Slice slice = it.prepare_read();
+    if (slice.empty()) {
+      break;
+    }
+    buf[buf_i] = as_io_slice(slice);
+    it.confirm_read(slice.size());
+  }
+  TRY_RESULT(x, fd.writev(Span<IoSlice>(buf, buf_i)));
+  reader.advance(x);
+  return x;
+}
+}  // namespace detail
+
 // just reads from given reader and writes to given writer
 template <class FdT>
 class BufferedFdBase : public FdT {
@@ -118,21 +147,7 @@ Result<size_t> BufferedFdBase<FdT>::flush_write() {
   write_->sync_with_writer();
   size_t result = 0;
   while (!write_->empty() && ::td::can_write_local(*this)) {
-    constexpr size_t BUF_SIZE = 20;
-    IoSlice buf[BUF_SIZE];
-
-    auto it = write_->clone();
-    size_t buf_i;
-    for (buf_i = 0; buf_i < BUF_SIZE; buf_i++) {
-      Slice slice = it.prepare_read();
-      if (slice.empty()) {
-        break;
-      }
-      buf[buf_i] = as_io_slice(slice);
-      it.confirm_read(slice.size());
-    }
-    TRY_RESULT(x, FdT::writev(Span<IoSlice>(buf, buf_i)));
-    write_->advance(x);
+    TRY_RESULT(x, detail::write_buffer(static_cast<FdT &>(*this), *write_, 0));
     result += x;
   }
   if (result == 0) {
@@ -26,7 +26,7 @@ namespace detail {
 class UdpWriter {
  public:
   static Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
-    std::array<UdpSocketFd::OutboundMessage, 16> messages;
+    std::array<UdpSocketFd::OutboundMessage, UdpSocketFd::MAX_BATCH_SIZE> messages;
     auto to_send = queue.as_span();
     size_t to_send_n = td::min(messages.size(), to_send.size());
     to_send.truncate(to_send_n);
@@ -78,11 +78,11 @@ class UdpReader {
       helpers_[i].init_inbound_message(messages_[i]);
     }
   }
-  Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
+  Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue, size_t &cnt) TD_WARN_UNUSED_RESULT {
     for (auto &message : messages_) {
       CHECK(message.data.size() == 2048);
     }
-    size_t cnt = 0;
+    cnt = 0;
     auto status = fd.receive_messages(messages_, cnt);
     for (size_t i = 0; i < cnt; i++) {
       queue.push(helpers_[i].extract_udp_message(messages_[i]));
@@ -100,7 +100,7 @@ class UdpReader {
   }
 
  private:
-  static constexpr size_t BUFFER_SIZE = 16;
+  static constexpr size_t BUFFER_SIZE = UdpSocketFd::MAX_BATCH_SIZE;
   std::array<UdpSocketFd::InboundMessage, BUFFER_SIZE> messages_;
   std::array<UdpReaderHelper, BUFFER_SIZE> helpers_;
 };
@@ -149,10 +149,23 @@ class BufferedUdp final : public UdpSocketFd {
     return *static_cast<UdpSocketFd *>(this);
   }
 
+#if TD_PORT_POSIX
+  // returns the number of receive system calls; each of them can receive up to UdpSocketFd::MAX_BATCH_SIZE messages
+  uint64 get_receive_call_count() const {
+    return receive_call_count_;
+  }
+
+  uint64 get_received_message_count() const {
+    return received_message_count_;
+  }
+#endif
+
  private:
 #if TD_PORT_POSIX
   VectorQueue<UdpMessage> input_;
   VectorQueue<UdpMessage> output_;
+  uint64 receive_call_count_ = 0;
+  uint64 received_message_count_ = 0;
 
   VectorQueue<UdpMessage> &input() {
     return input_;
@@ -167,7 +180,11 @@ class BufferedUdp final : public UdpSocketFd {
 
   Status flush_read_once() TD_WARN_UNUSED_RESULT {
     init_thread_local<detail::UdpReader>(udp_reader_);
-    return udp_reader_->read_once(as_fd(), input_);
+    size_t cnt = 0;
+    auto status = udp_reader_->read_once(as_fd(), input_, cnt);
+    receive_call_count_++;
+    received_message_count_ += cnt;
+    return status;
   }
 
   static TD_THREAD_LOCAL detail::UdpReader *udp_reader_;
@@ -16,25 +16,67 @@
 #include "td/utils/optional.h"
 #include "td/utils/Span.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/VectorQueue.h"
 
 #include <functional>
 
 namespace td {
 
+struct ChainSchedulerStats {
+  size_t chain_count = 0;
+  size_t task_count = 0;
+  size_t active_task_count = 0;   // total number of active tasks in all chains
+  size_t max_chain_length = 0;    // number of tasks in the longest chain
+  size_t total_chain_length = 0;  // total number of tasks in all chains
+  uint64 started_task_count = 0;
+  uint64 reset_task_count = 0;
+  uint64 paused_task_count = 0;
+  uint64 limited_task_count = 0;  // number of times a task wasn't started because a chain had too many active tasks
+  double total_wait_time = 0.0;   // total time from task creation or reset to its start
+  double max_wait_time = 0.0;
+};
+
+inline StringBuilder &operator<<(StringBuilder &string_builder, const ChainSchedulerStats &stats) {
+  return string_builder << stats.task_count << " tasks in " << stats.chain_count << " chains with "
+                        << stats.active_task_count << " active chain tasks, max chain length "
+                        << stats.max_chain_length << ", total chain length " << stats.total_chain_length << ", "
+                        << stats.started_task_count << " started, " << stats.reset_task_count << " reset, "
+                        << stats.paused_task_count << " paused, " << stats.limited_task_count
+                        << " limited tasks, average wait time "
+                        << (stats.started_task_count == 0
+                                ? 0.0
+                                : stats.total_wait_time / static_cast<double>(stats.started_task_count))
+                        << ", max wait time " << stats.max_wait_time;
+}
+
 struct ChainSchedulerBase {
+  static constexpr uint32 DEFAULT_MAX_ACTIVE_TASKS = 10;
+
   struct TaskWithParents {
     uint64 task_id{};
     vector<uint64> parents;
   };
 };
 
+// Starts tasks in order of their creation within each chain. A task can be started before its parents are finished,
+// but at most max_active_tasks tasks can be active in a chain simultaneously.
+// After a reset of an active task, tasks following it in its chains are started only after all previously started
+// tasks of the chains are finished or reset too, so the order is preserved.
 template <class ExtraT = Unit>
 class ChainScheduler final : public ChainSchedulerBase {
  public:
   using TaskId = uint64;
   using ChainId = uint64;
 
+  explicit ChainScheduler(uint32 max_active_tasks = DEFAULT_MAX_ACTIVE_TASKS) : max_active_tasks_(max_active_tasks) {
+    CHECK(max_active_tasks_ > 0);
+  }
+
+  void set_max_active_tasks(uint32 max_active_tasks);
+
+  ChainSchedulerStats get_stats() const;
+
   TaskId create_task(Span<ChainId> chains, ExtraT extra = {});
 
   ExtraT *get_task_extra(TaskId task_id);
@@ -127,6 +169,7 @@ class ChainScheduler final : public ChainSchedulerBase {
   };
   struct ChainInfo {
     Chain chain;
+    size_t task_count{};
     uint32 active_tasks{};
     uint64 generation{1};
   };
@@ -138,12 +181,15 @@ class ChainScheduler final : public ChainSchedulerBase {
   struct Task {
     enum class State { Pending, Active, Paused } state{State::Pending};
     vector<TaskChainInfo> chains;
+    double pending_since{};
     ExtraT extra;
   };
   FlatHashMap<ChainId, unique_ptr<ChainInfo>> chains_;
   FlatHashMap<ChainId, TaskId> limited_tasks_;
   Container<Task> tasks_;
   VectorQueue<TaskId> pending_tasks_;
+  uint32 max_active_tasks_;
+  ChainSchedulerStats stats_;
 
   ChainInfo &get_chain_info(ChainId chain_id) {
     auto &chain = chains_[chain_id];
@@ -168,7 +214,8 @@ class ChainScheduler final : public ChainSchedulerBase {
         }
       }
 
-      if (task_chain_info.chain_info->active_tasks >= 10) {
+      if (task_chain_info.chain_info->active_tasks >= max_active_tasks_) {
+        stats_.limited_task_count++;
         limited_tasks_[task_chain_info.chain_id] = task_id;
         return;
       }
@@ -185,6 +232,11 @@ class ChainScheduler final : public ChainSchedulerBase {
     }
     task->state = Task::State::Active;
 
+    auto wait_time = Time::now() - task->pending_since;
+    stats_.started_task_count++;
+    stats_.total_wait_time += wait_time;
+    stats_.max_wait_time = td::max(stats_.max_wait_time, wait_time);
+
     pending_tasks_.push(task_id);
     for_each_child(task, [&](TaskId task_id) { try_start_task(task_id); });
   }
@@ -237,6 +289,7 @@ class ChainScheduler final : public ChainSchedulerBase {
   void finish_chain_task(TaskChainInfo &task_chain_info) {
     auto &chain = task_chain_info.chain_info->chain;
     chain.finish_task(&task_chain_info.chain_node);
+    task_chain_info.chain_info->task_count--;
     if (chain.empty()) {
       chains_.erase(task_chain_info.chain_id);
     }
@@ -261,10 +314,40 @@ class ChainScheduler final : public ChainSchedulerBase {
   friend StringBuilder &operator<<(StringBuilder &sb, ChainScheduler<ExtraTT> &scheduler);
 };
 
+template <class ExtraT>
+void ChainScheduler<ExtraT>::set_max_active_tasks(uint32 max_active_tasks) {
+  CHECK(max_active_tasks > 0);
+  CHECK(to_start_.empty());
+  bool is_increased = max_active_tasks > max_active_tasks_;
+  max_active_tasks_ = max_active_tasks;
+  if (is_increased) {
+    for (auto &it : limited_tasks_) {
+      try_start_task_later(it.second);
+    }
+    limited_tasks_.clear();
+    flush_try_start_task();
+  }
+}
+
+template <class ExtraT>
+ChainSchedulerStats ChainScheduler<ExtraT>::get_stats() const {
+  auto stats = stats_;
+  stats.chain_count = chains_.size();
+  stats.task_count = tasks_.size();
+  for (auto &it : chains_) {
+    auto &chain_info = *it.second;
+    stats.active_task_count += chain_info.active_tasks;
+    stats.max_chain_length = td::max(stats.max_chain_length, chain_info.task_count);
+    stats.total_chain_length += chain_info.task_count;
+  }
+  return stats;
+}
+
 template <class ExtraT>
 typename ChainScheduler<ExtraT>::TaskId ChainScheduler<ExtraT>::create_task(Span<ChainId> chains, ExtraT extra) {
   auto task_id = tasks_.create();
   Task &task = *tasks_.get(task_id);
+  task.pending_since = Time::now();
   task.extra = std::move(extra);
   task.chains = transform(chains, [&](ChainId chain_id) {
     CHECK(chain_id != 0);
@@ -280,6 +363,7 @@ typename ChainScheduler<ExtraT>::TaskId ChainScheduler<ExtraT>::create_task(Span
   for (TaskChainInfo &task_chain_info : task.chains) {
     ChainInfo &chain_info = *task_chain_info.chain_info;
     chain_info.chain.add_task(&task_chain_info.chain_node);
+    chain_info.task_count++;
   }
 
   try_start_task(task_id);
@@ -339,7 +423,9 @@ void ChainScheduler<ExtraT>::reset_task(TaskId task_id) {
   CHECK(to_start_.empty());
   auto *task = tasks_.get(task_id);
   CHECK(task != nullptr);
+  stats_.reset_task_count++;
   inactivate_task(task_id, true);
+  task->pending_since = Time::now();
   try_start_task_later(task_id);
   flush_try_start_task();
 }
@@ -348,6 +434,7 @@ template <class ExtraT>
 void ChainScheduler<ExtraT>::pause_task(TaskId task_id) {
   auto *task = tasks_.get(task_id);
   CHECK(task != nullptr);
+  stats_.paused_task_count++;
   inactivate_task(task_id, true);
   task->state = Task::State::Paused;
   flush_try_start_task();
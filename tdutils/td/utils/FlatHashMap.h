@@ -7,6 +7,7 @@
 #pragma once
 
 //#include "td/utils/FlatHashMapChunks.h"
+#include "td/utils/config.h"
 #include "td/utils/FlatHashTable.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/MapNode.h"
@@ -14,10 +15,18 @@
 #include <functional>
 //#include <unordered_map>
 
+#if TD_USE_SWISS_HASH_TABLE
+#include "td/utils/FlatHashMapSwiss.h"
+#endif
+
 namespace td {
 
 template <class KeyT, class ValueT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+#if TD_USE_SWISS_HASH_TABLE
+using FlatHashMap = FlatHashTableSwiss<MapNode<KeyT, ValueT, EqT>, HashT, EqT>;
+#else
 using FlatHashMap = FlatHashTable<MapNode<KeyT, ValueT, EqT>, HashT, EqT>;
+#endif
 //using FlatHashMap = FlatHashMapChunks<KeyT, ValueT, HashT, EqT>;
 //using FlatHashMap = std::unordered_map<KeyT, ValueT, HashT, EqT>;
 
@@ -20,10 +20,6 @@
 #include <limits>
 #include <utility>
 
-#if defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)))
-#define TD_SSE2 1
-#endif
-
 #ifdef __aarch64__
 #include <arm_neon.h>
 #endif
@@ -256,6 +252,14 @@ class FlatHashTableChunks {
     return nodes_.size();
   }
 
+  HashTableMemoryUsage memory_usage() const {
+    HashTableMemoryUsage result;
+    result.size = used_nodes_;
+    result.bucket_count = nodes_.size();
+    result.memory = nodes_.size() * sizeof(Node) + chunks_.size() * sizeof(Chunk);
+    return result;
+  }
+
   Iterator find(const KeyT &key) {
     if (empty() || is_hash_table_key_empty<EqT>(key)) {
       return end();
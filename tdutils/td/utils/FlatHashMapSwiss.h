@@ -0,0 +1,695 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashTable.h"
+#include "td/utils/HashTableUtils.h"
+#include "td/utils/MapNode.h"
+#include "td/utils/SetNode.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+#ifdef __aarch64__
+#include <arm_neon.h>
+#elif TD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace td {
+
+namespace detail {
+
+// bit mask of matching control bytes in a group; every control byte is represented by shift bits
+template <int shift>
+struct SwissGroupMask {
+  uint64 mask;
+
+  explicit operator bool() const noexcept {
+    return mask != 0;
+  }
+  int pos() const {
+    return count_trailing_zeroes64(mask) / shift;
+  }
+
+  bool operator!=(const SwissGroupMask &other) const {
+    return mask != other.mask;
+  }
+  int operator*() const {
+    return pos();
+  }
+  void operator++() {
+    mask &= mask - 1;
+  }
+  SwissGroupMask begin() const {
+    return *this;
+  }
+  SwissGroupMask end() const {
+    return SwissGroupMask{0};
+  }
+};
+
+// a group of 16 consecutive control bytes; a control byte contains 7 lower bits of the hash of a used node,
+// or EMPTY for never used nodes, or DELETED for erased nodes, after which probing must continue
+struct SwissGroup {
+  static constexpr uint32 SIZE = 16;
+  static constexpr uint8 EMPTY = 0x80;
+  static constexpr uint8 DELETED = 0xFE;
+
+#ifdef __aarch64__
+  using Mask = SwissGroupMask<4>;
+
+  static Mask to_mask(uint8x16_t eq_mask) {
+    // get info from every byte into the bottom half of every uint16 and narrow them to a 64-bit vector
+    uint8x8_t shifted_eq_mask = vshrn_n_u16(vreinterpretq_u16_u8(eq_mask), 4);
+    return {vget_lane_u64(vreinterpret_u64_u8(shifted_eq_mask), 0) & 0x1111111111111111ull};
+  }
+
+  static Mask match(const uint8 *ctrl, uint8 needle) {
+    return to_mask(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(needle)));
+  }
+
+  static Mask match_empty_or_deleted(const uint8 *ctrl) {
+    return to_mask(vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(vld1q_u8(ctrl)), 7)));
+  }
+#elif TD_SSE2
+  using Mask = SwissGroupMask<1>;
+
+  static Mask match(const uint8 *ctrl, uint8 needle) {
+    auto group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+    auto match_mask = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(needle)), group);
+    return {static_cast<uint32>(_mm_movemask_epi8(match_mask))};
+  }
+
+  static Mask match_empty_or_deleted(const uint8 *ctrl) {
+    auto group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+    return {static_cast<uint32>(_mm_movemask_epi8(group))};
+  }
+#else
+  using Mask = SwissGroupMask<1>;
+
+  static Mask match(const uint8 *ctrl, uint8 needle) {
+    uint64 result = 0;
+    for (uint32 i = 0; i < SIZE; i++) {
+      result |= static_cast<uint64>(ctrl[i] == needle) << i;
+    }
+    return {result};
+  }
+
+  static Mask match_empty_or_deleted(const uint8 *ctrl) {
+    uint64 result = 0;
+    for (uint32 i = 0; i < SIZE; i++) {
+      result |= static_cast<uint64>(ctrl[i] >> 7) << i;
+    }
+    return {result};
+  }
+#endif
+
+  static Mask match_empty(const uint8 *ctrl) {
+    return match(ctrl, EMPTY);
+  }
+};
+
+}  // namespace detail
+
+// Swiss table with the same interface as FlatHashTable
+// control bytes are stored separately from nodes and are probed by groups of 16 using SSE2 or NEON if available
+template <class NodeT, class HashT, class EqT>
+class FlatHashTableSwiss {
+  using Group = detail::SwissGroup;
+
+  static constexpr uint32 INVALID_BUCKET = 0xFFFFFFFF;
+  static constexpr uint32 MIN_BUCKET_COUNT = Group::SIZE;
+
+  void allocate_nodes(uint32 size) {
+    DCHECK(size >= MIN_BUCKET_COUNT);
+    DCHECK((size & (size - 1)) == 0);
+    CHECK(size <= min(static_cast<uint32>(1) << 29, static_cast<uint32>(0x7FFFFFFF / sizeof(NodeT))));
+    nodes_ = new NodeT[size];
+    ctrl_ = new uint8[size];
+    std::memset(ctrl_, Group::EMPTY, size);
+    // used_node_count_ = 0;
+    deleted_node_count_ = 0;
+    bucket_count_mask_ = size - 1;
+    bucket_count_ = size;
+    begin_bucket_ = INVALID_BUCKET;
+  }
+
+  static void clear_nodes(NodeT *nodes, uint8 *ctrl) {
+    delete[] nodes;
+    delete[] ctrl;
+  }
+
+ public:
+  using KeyT = typename NodeT::public_key_type;
+  using key_type = typename NodeT::public_key_type;
+  using value_type = typename NodeT::public_type;
+
+  struct Iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = typename NodeT::public_type;
+    using pointer = value_type *;
+    using reference = value_type &;
+
+    Iterator &operator++() {
+      DCHECK(it_ != nullptr);
+      do {
+        if (unlikely(++it_ == end_)) {
+          it_ = begin_;
+        }
+        if (unlikely(it_ == start_)) {
+          it_ = nullptr;
+          break;
+        }
+      } while (it_->empty());
+      return *this;
+    }
+    reference operator*() {
+      return it_->get_public();
+    }
+    const value_type &operator*() const {
+      return it_->get_public();
+    }
+    pointer operator->() {
+      return &it_->get_public();
+    }
+    const value_type *operator->() const {
+      return &it_->get_public();
+    }
+
+    NodeT *get() {
+      return it_;
+    }
+
+    bool operator==(const Iterator &other) const {
+      DCHECK(other.it_ == nullptr);
+      return it_ == nullptr;
+    }
+    bool operator!=(const Iterator &other) const {
+      DCHECK(other.it_ == nullptr);
+      return it_ != nullptr;
+    }
+
+    Iterator() = default;
+    Iterator(NodeT *it, NodeT *begin, NodeT *end) : it_(it), begin_(begin), start_(it), end_(end) {
+    }
+
+   private:
+    NodeT *it_ = nullptr;
+    NodeT *begin_ = nullptr;
+    NodeT *start_ = nullptr;
+    NodeT *end_ = nullptr;
+  };
+
+  struct ConstIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = typename NodeT::public_type;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    ConstIterator &operator++() {
+      ++it_;
+      return *this;
+    }
+    reference operator*() const {
+      return *it_;
+    }
+    pointer operator->() const {
+      return &*it_;
+    }
+    bool operator==(const ConstIterator &other) const {
+      return it_ == other.it_;
+    }
+    bool operator!=(const ConstIterator &other) const {
+      return it_ != other.it_;
+    }
+
+    ConstIterator() = default;
+    ConstIterator(Iterator it) : it_(std::move(it)) {
+    }
+
+   private:
+    Iterator it_;
+  };
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  struct NodePointer {
+    value_type &operator*() {
+      return it_->get_public();
+    }
+    const value_type &operator*() const {
+      return it_->get_public();
+    }
+    value_type *operator->() {
+      return &it_->get_public();
+    }
+    const value_type *operator->() const {
+      return &it_->get_public();
+    }
+
+    NodeT *get() {
+      return it_;
+    }
+
+    bool operator==(const Iterator &) const {
+      return it_ == nullptr;
+    }
+    bool operator!=(const Iterator &) const {
+      return it_ != nullptr;
+    }
+
+    explicit NodePointer(NodeT *it) : it_(it) {
+    }
+
+   private:
+    NodeT *it_ = nullptr;
+  };
+
+  struct ConstNodePointer {
+    const value_type &operator*() const {
+      return it_->get_public();
+    }
+    const value_type *operator->() const {
+      return &it_->get_public();
+    }
+
+    bool operator==(const ConstIterator &) const {
+      return it_ == nullptr;
+    }
+    bool operator!=(const ConstIterator &) const {
+      return it_ != nullptr;
+    }
+
+    const NodeT *get() const {
+      return it_;
+    }
+
+    explicit ConstNodePointer(const NodeT *it) : it_(it) {
+    }
+
+   private:
+    const NodeT *it_ = nullptr;
+  };
+
+  FlatHashTableSwiss() = default;
+  FlatHashTableSwiss(const FlatHashTableSwiss &) = delete;
+  FlatHashTableSwiss &operator=(const FlatHashTableSwiss &) = delete;
+
+  FlatHashTableSwiss(std::initializer_list<NodeT> nodes) {
+    if (nodes.size() == 0) {
+      return;
+    }
+    reserve(nodes.size());
+    for (auto &new_node : nodes) {
+      CHECK(!new_node.empty());
+      if (find_impl(new_node.key()) != nullptr) {
+        continue;
+      }
+      auto hash = HashT()(new_node.key());
+      auto bucket = find_free_bucket(hash);
+      DCHECK(ctrl_[bucket] == Group::EMPTY);
+      ctrl_[bucket] = get_control_byte(hash);
+      nodes_[bucket].copy_from(new_node);
+      used_node_count_++;
+    }
+  }
+
+  template <class T>
+  FlatHashTableSwiss(std::initializer_list<T> keys) {
+    for (auto &key : keys) {
+      emplace(KeyT(key));
+    }
+  }
+
+  FlatHashTableSwiss(FlatHashTableSwiss &&other) noexcept
+      : nodes_(other.nodes_)
+      , ctrl_(other.ctrl_)
+      , used_node_count_(other.used_node_count_)
+      , deleted_node_count_(other.deleted_node_count_)
+      , bucket_count_mask_(other.bucket_count_mask_)
+      , bucket_count_(other.bucket_count_)
+      , begin_bucket_(other.begin_bucket_) {
+    other.drop();
+  }
+  void operator=(FlatHashTableSwiss &&other) noexcept {
+    clear();
+    nodes_ = other.nodes_;
+    ctrl_ = other.ctrl_;
+    used_node_count_ = other.used_node_count_;
+    deleted_node_count_ = other.deleted_node_count_;
+    bucket_count_mask_ = other.bucket_count_mask_;
+    bucket_count_ = other.bucket_count_;
+    begin_bucket_ = other.begin_bucket_;
+    other.drop();
+  }
+  ~FlatHashTableSwiss() {
+    clear_nodes(nodes_, ctrl_);
+  }
+
+  void swap(FlatHashTableSwiss &other) noexcept {
+    std::swap(nodes_, other.nodes_);
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(used_node_count_, other.used_node_count_);
+    std::swap(deleted_node_count_, other.deleted_node_count_);
+    std::swap(bucket_count_mask_, other.bucket_count_mask_);
+    std::swap(bucket_count_, other.bucket_count_);
+    std::swap(begin_bucket_, other.begin_bucket_);
+  }
+
+  uint32 bucket_count() const {
+    return bucket_count_;
+  }
+
+  HashTableMemoryUsage memory_usage() const {
+    HashTableMemoryUsage result;
+    result.size = used_node_count_;
+    result.bucket_count = bucket_count_;
+    result.memory = static_cast<size_t>(bucket_count_) * (sizeof(NodeT) + sizeof(uint8));
+    return result;
+  }
+
+  NodePointer find(const KeyT &key) {
+    return NodePointer(find_impl(key));
+  }
+
+  ConstNodePointer find(const KeyT &key) const {
+    return ConstNodePointer(const_cast<FlatHashTableSwiss *>(this)->find_impl(key));
+  }
+
+  size_t size() const {
+    return used_node_count_;
+  }
+
+  bool empty() const {
+    return used_node_count_ == 0;
+  }
+
+  Iterator begin() {
+    return create_iterator(begin_impl());
+  }
+  Iterator end() {
+    return Iterator();
+  }
+  ConstIterator begin() const {
+    return ConstIterator(const_cast<FlatHashTableSwiss *>(this)->begin());
+  }
+  ConstIterator end() const {
+    return ConstIterator();
+  }
+
+  void reserve(size_t size) {
+    if (size == 0) {
+      return;
+    }
+    CHECK(size <= (1u << 29));
+    uint32 want_size = normalize_size(static_cast<uint32>(size) / 7 * 8 + 8);
+    if (want_size > bucket_count()) {
+      resize(want_size);
+    }
+  }
+
+  template <class... ArgsT>
+  std::pair<NodePointer, bool> emplace(KeyT key, ArgsT &&...args) {
+    CHECK(!is_hash_table_key_empty<EqT>(key));
+    if (unlikely(bucket_count_mask_ == 0)) {
+      CHECK(used_node_count_ == 0);
+      resize(MIN_BUCKET_COUNT);
+    }
+    auto hash = HashT()(key);
+    auto control_byte = get_control_byte(hash);
+    auto group = get_first_group(hash);
+    auto insert_bucket = INVALID_BUCKET;
+    for (uint32 step = 1;; step++) {
+      auto group_bucket = group * Group::SIZE;
+      const auto *ctrl = ctrl_ + group_bucket;
+      for (auto pos : Group::match(ctrl, control_byte)) {
+        auto &node = nodes_[group_bucket + pos];
+        if (likely(EqT()(node.key(), key))) {
+          return {NodePointer(&node), false};
+        }
+      }
+      if (insert_bucket == INVALID_BUCKET) {
+        auto free_mask = Group::match_empty_or_deleted(ctrl);
+        if (free_mask) {
+          insert_bucket = group_bucket + free_mask.pos();
+        }
+      }
+      if (Group::match_empty(ctrl)) {
+        break;
+      }
+      next_group(group, step);
+    }
+    DCHECK(insert_bucket != INVALID_BUCKET);
+
+    if (ctrl_[insert_bucket] == Group::EMPTY) {
+      if (unlikely((used_node_count_ + deleted_node_count_ + 1) * 8 > bucket_count_ * 7)) {
+        // double the size only if there are few deleted nodes, which would be dropped by a rehash
+        resize(used_node_count_ * 16 >= bucket_count_ * 7 ? 2 * bucket_count_ : bucket_count_);
+        return emplace(std::move(key), std::forward<ArgsT>(args)...);
+      }
+    } else {
+      DCHECK(ctrl_[insert_bucket] == Group::DELETED);
+      deleted_node_count_--;
+    }
+    invalidate_iterators();
+
+    auto &node = nodes_[insert_bucket];
+    ctrl_[insert_bucket] = control_byte;
+    node.emplace(std::move(key), std::forward<ArgsT>(args)...);
+    used_node_count_++;
+    return {NodePointer(&node), true};
+  }
+
+  std::pair<NodePointer, bool> insert(KeyT key) {
+    return emplace(std::move(key));
+  }
+
+  template <class ItT>
+  void insert(ItT begin, ItT end) {
+    for (; begin != end; ++begin) {
+      emplace(*begin);
+    }
+  }
+
+  template <class T = typename NodeT::second_type>
+  T &operator[](const KeyT &key) {
+    return emplace(key).first->second;
+  }
+
+  size_t erase(const KeyT &key) {
+    auto *node = find_impl(key);
+    if (node == nullptr) {
+      return 0;
+    }
+    erase_node(node);
+    try_shrink();
+    return 1;
+  }
+
+  size_t count(const KeyT &key) const {
+    return const_cast<FlatHashTableSwiss *>(this)->find_impl(key) != nullptr;
+  }
+
+  void clear() {
+    if (nodes_ != nullptr) {
+      clear_nodes(nodes_, ctrl_);
+      drop();
+    }
+  }
+
+  void erase(Iterator it) {
+    DCHECK(it != end());
+    erase_node(it.get());
+    try_shrink();
+  }
+
+  void erase(NodePointer it) {
+    DCHECK(it != end());
+    erase_node(it.get());
+    try_shrink();
+  }
+
+  template <class F>
+  void remove_if(F &&f) {
+    if (empty()) {
+      return;
+    }
+
+    // nodes are never moved by erase_node, so each node is checked exactly once
+    auto end = nodes_ + bucket_count();
+    for (auto it = nodes_; it != end; ++it) {
+      if (!it->empty() && f(it->get_public())) {
+        erase_node(it);
+      }
+    }
+    try_shrink();
+  }
+
+ private:
+  NodeT *nodes_ = nullptr;
+  uint8 *ctrl_ = nullptr;
+  uint32 used_node_count_ = 0;
+  uint32 deleted_node_count_ = 0;
+  uint32 bucket_count_mask_ = 0;
+  uint32 bucket_count_ = 0;
+  uint32 begin_bucket_ = 0;
+
+  void drop() {
+    nodes_ = nullptr;
+    ctrl_ = nullptr;
+    used_node_count_ = 0;
+    deleted_node_count_ = 0;
+    bucket_count_mask_ = 0;
+    bucket_count_ = 0;
+    begin_bucket_ = 0;
+  }
+
+  static uint32 normalize_size(uint32 size) {
+    auto result = detail::normalize_flat_hash_table_size(size);
+    return result < MIN_BUCKET_COUNT ? MIN_BUCKET_COUNT : result;
+  }
+
+  static uint8 get_control_byte(uint32 hash) {
+    return static_cast<uint8>(hash & 0x7F);
+  }
+
+  uint32 get_first_group(uint32 hash) const {
+    return (hash >> 7) & (bucket_count_mask_ / Group::SIZE);
+  }
+
+  // triangular probing visits all groups, because the number of groups is a power of two
+  void next_group(uint32 &group, uint32 step) const {
+    group = (group + step) & (bucket_count_mask_ / Group::SIZE);
+  }
+
+  uint32 find_free_bucket(uint32 hash) const {
+    auto group = get_first_group(hash);
+    for (uint32 step = 1;; step++) {
+      auto free_mask = Group::match_empty_or_deleted(ctrl_ + group * Group::SIZE);
+      if (free_mask) {
+        return group * Group::SIZE + free_mask.pos();
+      }
+      next_group(group, step);
+    }
+  }
+
+  NodeT *begin_impl() {
+    if (empty()) {
+      return nullptr;
+    }
+    if (begin_bucket_ == INVALID_BUCKET) {
+      begin_bucket_ = detail::get_random_flat_hash_table_bucket(bucket_count_mask_);
+      while (nodes_[begin_bucket_].empty()) {
+        begin_bucket_ = (begin_bucket_ + 1) & bucket_count_mask_;
+      }
+    }
+    return nodes_ + begin_bucket_;
+  }
+
+  NodeT *find_impl(const KeyT &key) {
+    if (unlikely(nodes_ == nullptr) || is_hash_table_key_empty<EqT>(key)) {
+      return nullptr;
+    }
+    auto hash = HashT()(key);
+    auto control_byte = get_control_byte(hash);
+    auto group = get_first_group(hash);
+    for (uint32 step = 1;; step++) {
+      auto group_bucket = group * Group::SIZE;
+      const auto *ctrl = ctrl_ + group_bucket;
+      for (auto pos : Group::match(ctrl, control_byte)) {
+        auto &node = nodes_[group_bucket + pos];
+        if (likely(EqT()(node.key(), key))) {
+          return &node;
+        }
+      }
+      if (Group::match_empty(ctrl)) {
+        return nullptr;
+      }
+      next_group(group, step);
+    }
+  }
+
+  void try_shrink() {
+    DCHECK(nodes_ != nullptr);
+    if (unlikely(used_node_count_ * 10 < bucket_count_mask_ && bucket_count_mask_ >= 2 * MIN_BUCKET_COUNT)) {
+      resize(normalize_size((used_node_count_ + 1) * 5 / 3 + 1));
+    }
+    invalidate_iterators();
+  }
+
+  void resize(uint32 new_size) {
+    if (unlikely(nodes_ == nullptr)) {
+      allocate_nodes(new_size);
+      used_node_count_ = 0;
+      return;
+    }
+
+    auto old_nodes = nodes_;
+    auto old_ctrl = ctrl_;
+    uint32 old_size = used_node_count_;
+    uint32 old_bucket_count = bucket_count_;
+    allocate_nodes(new_size);
+    used_node_count_ = old_size;
+
+    auto old_nodes_end = old_nodes + old_bucket_count;
+    for (NodeT *old_node = old_nodes; old_node != old_nodes_end; ++old_node) {
+      if (old_node->empty()) {
+        continue;
+      }
+      auto hash = HashT()(old_node->key());
+      auto bucket = find_free_bucket(hash);
+      ctrl_[bucket] = get_control_byte(hash);
+      nodes_[bucket] = std::move(*old_node);
+    }
+    clear_nodes(old_nodes, old_ctrl);
+  }
+
+  void erase_node(NodeT *it) {
+    DCHECK(nodes_ <= it && static_cast<size_t>(it - nodes_) < bucket_count());
+    it->clear();
+    used_node_count_--;
+
+    // if the group has an empty node, then no probe sequence has continued past the group
+    auto bucket = static_cast<uint32>(it - nodes_);
+    if (Group::match_empty(ctrl_ + (bucket & ~(Group::SIZE - 1)))) {
+      ctrl_[bucket] = Group::EMPTY;
+    } else {
+      ctrl_[bucket] = Group::DELETED;
+      deleted_node_count_++;
+    }
+  }
+
+  Iterator create_iterator(NodeT *node) {
+    return Iterator(node, nodes_, nodes_ + bucket_count());
+  }
+
+  void invalidate_iterators() {
+    begin_bucket_ = INVALID_BUCKET;
+  }
+};
+
+template <class KeyT, class ValueT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+using FlatHashMapSwiss = FlatHashTableSwiss<MapNode<KeyT, ValueT, EqT>, HashT, EqT>;
+
+template <class KeyT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+using FlatHashSetSwiss = FlatHashTableSwiss<SetNode<KeyT, EqT>, HashT, EqT>;
+
+template <class NodeT, class HashT, class EqT, class FuncT>
+void table_remove_if(FlatHashTableSwiss<NodeT, HashT, EqT> &table, FuncT &&func) {
+  table.remove_if(func);
+}
+
+}  // namespace td
@@ -7,6 +7,7 @@
 #pragma once
 
 //#include "td/utils/FlatHashMapChunks.h"
+#include "td/utils/config.h"
 #include "td/utils/FlatHashTable.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/SetNode.h"
@@ -14,10 +15,18 @@
 #include <functional>
 //#include <unordered_set>
 
+#if TD_USE_SWISS_HASH_TABLE
+#include "td/utils/FlatHashMapSwiss.h"
+#endif
+
 namespace td {
 
 template <class KeyT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+#if TD_USE_SWISS_HASH_TABLE
+using FlatHashSet = FlatHashTableSwiss<SetNode<KeyT, EqT>, HashT, EqT>;
+#else
 using FlatHashSet = FlatHashTable<SetNode<KeyT, EqT>, HashT, EqT>;
+#endif
 //using FlatHashSet = FlatHashSetChunks<KeyT, HashT, EqT>;
 //using FlatHashSet = std::unordered_set<KeyT, HashT, EqT>;
 
@@ -7,11 +7,24 @@
 #include "td/utils/FlatHashTable.h"
 
 #include "td/utils/bits.h"
+#include "td/utils/format.h"
 #include "td/utils/Random.h"
+#include "td/utils/StringBuilder.h"
+
+#include <random>
 
 namespace td {
 namespace detail {
 
+uint64 generate_hash_seed() {
+  // std::random_device can be deterministic on some platforms, so the seed also depends on the address space layout
+  static const char address_seed = 0;
+  std::random_device random_device;
+  auto seed = static_cast<uint64>(reinterpret_cast<std::uintptr_t>(&address_seed)) ^ random_device();
+  seed = hash_mix(seed, (static_cast<uint64>(random_device()) << 32) ^ 0x9E3779B97F4A7C15ULL);
+  return seed ^ hash_mix(seed ^ 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL);
+}
+
 uint32 normalize_flat_hash_table_size(uint32 size) {
   return td::max(static_cast<uint32>(1) << (32 - count_leading_zeroes32(size)), static_cast<uint32>(8));
 }
@@ -21,4 +34,15 @@ uint32 get_random_flat_hash_table_bucket(uint32 bucket_count_mask) {
 }
 
 }  // namespace detail
+
+StringBuilder &operator<<(StringBuilder &string_builder, const HashTableMemoryUsage &memory_usage) {
+  string_builder << memory_usage.size << " elements in " << memory_usage.bucket_count << " buckets with load factor "
+                 << StringBuilder::FixedDouble(memory_usage.get_load_factor(), 2) << " using "
+                 << format::as_size(memory_usage.memory);
+  if (memory_usage.level_count > 0) {
+    string_builder << " in " << memory_usage.level_count << " wait-free levels";
+  }
+  return string_builder;
+}
+
 }  // namespace td
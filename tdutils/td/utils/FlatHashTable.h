@@ -266,6 +266,14 @@ class FlatHashTable {
     return bucket_count_;
   }
 
+  HashTableMemoryUsage memory_usage() const {
+    HashTableMemoryUsage result;
+    result.size = used_node_count_;
+    result.bucket_count = bucket_count_;
+    result.memory = static_cast<size_t>(bucket_count_) * sizeof(NodeT);
+    return result;
+  }
+
   NodePointer find(const KeyT &key) {
     return NodePointer(find_impl(key));
   }
@@ -9,6 +9,8 @@
 char disable_linker_warning_about_empty_file_gzip_cpp TD_UNUSED;
 
 #if TD_HAVE_ZLIB
+#include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
 
 #include <cstring>
@@ -32,7 +34,7 @@ class Gzip::Impl {
   ~Impl() = default;
 };
 
-Status Gzip::init_encode() {
+Status Gzip::init_encode(Slice dictionary) {
   CHECK(mode_ == Mode::Empty);
   init_common();
   mode_ = Mode::Encode;
@@ -40,10 +42,18 @@ Status Gzip::init_encode() {
   if (ret != Z_OK) {
     return Status::Error(PSLICE() << "zlib deflate init failed: " << ret);
   }
+  if (!dictionary.empty()) {
+    CHECK(dictionary.size() <= std::numeric_limits<uInt>::max());
+    ret = deflateSetDictionary(&impl_->stream_, dictionary.ubegin(), static_cast<uInt>(dictionary.size()));
+    if (ret != Z_OK) {
+      clear();
+      return Status::Error(PSLICE() << "zlib deflate set dictionary failed: " << ret);
+    }
+  }
   return Status::OK();
 }
 
-Status Gzip::init_decode() {
+Status Gzip::init_decode(Slice dictionary) {
   CHECK(mode_ == Mode::Empty);
   init_common();
   mode_ = Mode::Decode;
@@ -51,6 +61,8 @@ Status Gzip::init_decode() {
   if (ret != Z_OK) {
     return Status::Error(PSLICE() << "zlib inflate init failed: " << ret);
   }
+  // the dictionary can be set only after inflate requests it
+  dictionary_ = dictionary;
   return Status::OK();
 }
 
@@ -85,6 +97,14 @@ Result<Gzip::State> Gzip::run() {
     if (ret == Z_OK) {
       return State::Running;
     }
+    if (ret == Z_NEED_DICT && mode_ == Mode::Decode && !dictionary_.empty()) {
+      CHECK(dictionary_.size() <= std::numeric_limits<uInt>::max());
+      ret = inflateSetDictionary(&impl_->stream_, dictionary_.ubegin(), static_cast<uInt>(dictionary_.size()));
+      dictionary_ = Slice();
+      if (ret == Z_OK) {
+        continue;
+      }
+    }
     if (ret == Z_STREAM_END) {
       // TODO(now): fail if input is not empty;
       clear();
@@ -116,6 +136,7 @@ void Gzip::init_common() {
   output_size_ = 0;
 
   close_input_flag_ = false;
+  dictionary_ = Slice();
 }
 
 void Gzip::clear() {
@@ -148,59 +169,155 @@ void Gzip::swap(Gzip &other) {
   swap(output_size_, other.output_size_);
   swap(close_input_flag_, other.close_input_flag_);
   swap(mode_, other.mode_);
+  swap(dictionary_, other.dictionary_);
 }
 
 Gzip::~Gzip() {
   clear();
 }
 
-BufferSlice gzdecode(Slice s) {
-  Gzip gzip;
-  gzip.init_decode().ensure();
+namespace {
+
+// z_stream for one-shot encoding or decoding, which is initialized once per thread and is only reset between uses,
+// because initialization allocates several hundred kilobytes for deflate and tens of kilobytes for inflate
+class CachedZStream {
+ public:
+  explicit CachedZStream(bool is_encode) : is_encode_(is_encode) {
+  }
+  CachedZStream(const CachedZStream &) = delete;
+  CachedZStream &operator=(const CachedZStream &) = delete;
+  CachedZStream(CachedZStream &&) = delete;
+  CachedZStream &operator=(CachedZStream &&) = delete;
+  ~CachedZStream() {
+    end();
+  }
+
+  // returns nullptr on failure
+  z_stream *acquire() {
+    if (is_inited_) {
+      int ret = is_encode_ ? deflateReset(&stream_) : inflateReset(&stream_);
+      if (ret == Z_OK) {
+        return &stream_;
+      }
+      end();
+    }
+
+    std::memset(&stream_, 0, sizeof(stream_));
+    stream_.zalloc = Z_NULL;
+    stream_.zfree = Z_NULL;
+    stream_.opaque = Z_NULL;
+    int ret = is_encode_ ? deflateInit2(&stream_, 6, Z_DEFLATED, 15, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY)
+                         : inflateInit2(&stream_, MAX_WBITS + 32);
+    if (ret != Z_OK) {
+      LOG(ERROR) << "zlib " << (is_encode_ ? "deflate" : "inflate") << " init failed: " << ret;
+      return nullptr;
+    }
+    is_inited_ = true;
+    return &stream_;
+  }
+
+ private:
+  z_stream stream_;
+  bool is_encode_;
+  bool is_inited_ = false;
+
+  void end() {
+    if (!is_inited_) {
+      return;
+    }
+    if (is_encode_) {
+      deflateEnd(&stream_);
+    } else {
+      inflateEnd(&stream_);
+    }
+    is_inited_ = false;
+  }
+};
+
+struct CachedZStreams {
+  CachedZStream encode_stream{true};
+  CachedZStream decode_stream{false};
+};
+
+static TD_THREAD_LOCAL CachedZStreams *cached_z_streams;  // static zero-initialized
+
+CachedZStreams &get_cached_z_streams() {
+  init_thread_local<CachedZStreams>(cached_z_streams);
+  return *cached_z_streams;
+}
+
+void set_z_stream_input(z_stream *stream, Slice input) {
+  CHECK(input.size() <= std::numeric_limits<uInt>::max());
+  stream->avail_in = static_cast<uInt>(input.size());
+  stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+}
+
+void set_z_stream_output(z_stream *stream, MutableSlice output) {
+  CHECK(output.size() <= std::numeric_limits<uInt>::max());
+  stream->avail_out = static_cast<uInt>(output.size());
+  stream->next_out = reinterpret_cast<Bytef *>(output.data());
+}
+
+}  // namespace
+
+BufferSlice gzdecode(Slice s, Slice dictionary) {
+  auto *stream = get_cached_z_streams().decode_stream.acquire();
+  if (stream == nullptr) {
+    return BufferSlice();
+  }
   ChainBufferWriter message;
-  gzip.set_input(s);
-  gzip.close_input();
+  set_z_stream_input(stream, s);
   double k = 2;
-  gzip.set_output(message.prepare_append(static_cast<size_t>(static_cast<double>(s.size()) * k)));
+  auto output = message.prepare_append(static_cast<size_t>(static_cast<double>(s.size()) * k));
+  set_z_stream_output(stream, output);
   while (true) {
-    auto r_state = gzip.run();
-    if (r_state.is_error()) {
-      return BufferSlice();
+    int ret = inflate(stream, Z_NO_FLUSH);
+    if (ret == Z_NEED_DICT && !dictionary.empty()) {
+      // the dictionary can be set only after inflate requests it
+      CHECK(dictionary.size() <= std::numeric_limits<uInt>::max());
+      ret = inflateSetDictionary(stream, dictionary.ubegin(), static_cast<uInt>(dictionary.size()));
+      dictionary = Slice();
+      if (ret == Z_OK) {
+        continue;
+      }
     }
-    auto state = r_state.ok();
-    if (state == Gzip::State::Done) {
-      message.confirm_append(gzip.flush_output());
+    if (ret == Z_STREAM_END) {
+      message.confirm_append(output.size() - stream->avail_out);
       break;
     }
-    if (gzip.need_input()) {
+    if (ret != Z_OK || stream->avail_in == 0) {
       return BufferSlice();
     }
-    if (gzip.need_output()) {
-      message.confirm_append(gzip.flush_output());
+    if (stream->avail_out == 0) {
+      message.confirm_append(output.size());
       k *= 1.5;
-      gzip.set_output(message.prepare_append(static_cast<size_t>(static_cast<double>(gzip.left_input()) * k)));
+      output = message.prepare_append(static_cast<size_t>(static_cast<double>(stream->avail_in) * k));
+      set_z_stream_output(stream, output);
     }
   }
   return message.extract_reader().move_as_buffer_slice();
 }
 
-BufferSlice gzencode(Slice s, double max_compression_ratio) {
-  Gzip gzip;
-  gzip.init_encode().ensure();
-  gzip.set_input(s);
-  gzip.close_input();
-  auto max_size = static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio);
-  BufferWriter message{max_size};
-  gzip.set_output(message.prepare_append());
-  auto r_state = gzip.run();
-  if (r_state.is_error()) {
+BufferSlice gzencode(Slice s, double max_compression_ratio, Slice dictionary) {
+  auto *stream = get_cached_z_streams().encode_stream.acquire();
+  if (stream == nullptr) {
     return BufferSlice();
   }
-  auto state = r_state.ok();
-  if (state != Gzip::State::Done) {
+  if (!dictionary.empty()) {
+    CHECK(dictionary.size() <= std::numeric_limits<uInt>::max());
+    if (deflateSetDictionary(stream, dictionary.ubegin(), static_cast<uInt>(dictionary.size())) != Z_OK) {
+      return BufferSlice();
+    }
+  }
+  set_z_stream_input(stream, s);
+  auto max_size = static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio);
+  BufferWriter message{max_size};
+  auto output = message.prepare_append();
+  set_z_stream_output(stream, output);
+  if (deflate(stream, Z_FINISH) != Z_STREAM_END) {
     return BufferSlice();
   }
-  message.confirm_append(gzip.flush_output());
+  message.confirm_append(output.size() - stream->avail_out);
   return message.as_buffer_slice();
 }
 
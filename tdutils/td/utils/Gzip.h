@@ -35,9 +35,10 @@ class Gzip {
     return Status::OK();
   }
 
-  Status init_encode() TD_WARN_UNUSED_RESULT;
+  // the dictionary must be kept alive until the end of encoding or decoding
+  Status init_encode(Slice dictionary = Slice()) TD_WARN_UNUSED_RESULT;
 
-  Status init_decode() TD_WARN_UNUSED_RESULT;
+  Status init_decode(Slice dictionary = Slice()) TD_WARN_UNUSED_RESULT;
 
   void set_input(Slice input);
 
@@ -90,6 +91,7 @@ class Gzip {
   size_t output_size_ = 0;
   bool close_input_flag_ = false;
   Mode mode_ = Mode::Empty;
+  Slice dictionary_;
 
   void init_common();
   void clear();
@@ -97,9 +99,11 @@ class Gzip {
   void swap(Gzip &other);
 };
 
-BufferSlice gzdecode(Slice s);
+// gzdecode and gzencode reuse zlib streams cached per thread
+BufferSlice gzdecode(Slice s, Slice dictionary = Slice());
 
-BufferSlice gzencode(Slice s, double max_compression_ratio);
+// data compressed with a dictionary can be decompressed only with the same dictionary
+BufferSlice gzencode(Slice s, double max_compression_ratio, Slice dictionary = Slice());
 
 }  // namespace td
 
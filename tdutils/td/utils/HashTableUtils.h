@@ -8,8 +8,12 @@
 
 #include "td/utils/common.h"
 
+#if TD_MSVC && defined(_M_X64)
+#include <intrin.h>
+#endif
+
 #include <cstdint>
-#include <functional>
+#include <cstring>
 
 namespace td {
 
@@ -27,6 +31,111 @@ inline uint32 randomize_hash(uint32 h) {
   return h;
 }
 
+namespace detail {
+// returns a random premixed seed for hash_bytes, which is the same during the whole process lifetime
+uint64 generate_hash_seed();
+
+inline uint64 get_hash_seed() {
+  static const uint64 seed = generate_hash_seed();
+  return seed;
+}
+
+// computes 128-bit product of a and b, storing the lower half in a and the upper half in b
+inline void hash_multiply(uint64 &a, uint64 &b) {
+#if TD_HAVE_INT128
+  auto product = static_cast<unsigned __int128>(a) * b;
+  a = static_cast<uint64>(product);
+  b = static_cast<uint64>(product >> 64);
+#elif TD_MSVC && defined(_M_X64)
+  a = _umul128(a, b, &b);
+#else
+  uint64 a_high = a >> 32;
+  uint64 a_low = static_cast<uint32>(a);
+  uint64 b_high = b >> 32;
+  uint64 b_low = static_cast<uint32>(b);
+  uint64 high = a_high * b_high;
+  uint64 middle1 = a_high * b_low;
+  uint64 middle2 = a_low * b_high;
+  uint64 low = a_low * b_low;
+  uint64 carry = ((low >> 32) + static_cast<uint32>(middle1) + static_cast<uint32>(middle2)) >> 32;
+  a = low + (middle1 << 32) + (middle2 << 32);
+  b = high + (middle1 >> 32) + (middle2 >> 32) + carry;
+#endif
+}
+
+inline uint64 hash_mix(uint64 a, uint64 b) {
+  hash_multiply(a, b);
+  return a ^ b;
+}
+
+inline uint64 hash_read64(const unsigned char *ptr) {
+  uint64 result;
+  std::memcpy(&result, ptr, sizeof(result));
+  return result;
+}
+
+inline uint64 hash_read32(const unsigned char *ptr) {
+  uint32 result;
+  std::memcpy(&result, ptr, sizeof(result));
+  return result;
+}
+}  // namespace detail
+
+// fast non-cryptographic 64-bit hash of a byte sequence, which reads input 8 bytes at a time
+// it is based on rapidhash by Nicolas De Carli, which is derived from wyhash by Wang Yi
+// the result is randomized per process, so it must not be stored or sent anywhere
+inline uint64 hash_bytes(const void *data, size_t size) {
+  constexpr uint64 SECRET0 = 0x2d358dccaa6c78a5ULL;
+  constexpr uint64 SECRET1 = 0x8bb84b93962eacc9ULL;
+  constexpr uint64 SECRET2 = 0x4b33a62ed433d4a3ULL;
+
+  auto ptr = static_cast<const unsigned char *>(data);
+  auto seed = detail::get_hash_seed() ^ size;
+  uint64 a;
+  uint64 b;
+  if (size <= 16) {
+    if (size >= 4) {
+      auto last = ptr + size - 4;
+      auto delta = (size & 24) >> (size >> 3);
+      a = (detail::hash_read32(ptr) << 32) | detail::hash_read32(last);
+      b = (detail::hash_read32(ptr + delta) << 32) | detail::hash_read32(last - delta);
+    } else if (size > 0) {
+      a = (static_cast<uint64>(ptr[0]) << 56) | (static_cast<uint64>(ptr[size >> 1]) << 32) | ptr[size - 1];
+      b = 0;
+    } else {
+      a = 0;
+      b = 0;
+    }
+  } else {
+    auto left = size;
+    if (left > 48) {
+      auto seed1 = seed;
+      auto seed2 = seed;
+      do {
+        seed = detail::hash_mix(detail::hash_read64(ptr) ^ SECRET0, detail::hash_read64(ptr + 8) ^ seed);
+        seed1 = detail::hash_mix(detail::hash_read64(ptr + 16) ^ SECRET1, detail::hash_read64(ptr + 24) ^ seed1);
+        seed2 = detail::hash_mix(detail::hash_read64(ptr + 32) ^ SECRET2, detail::hash_read64(ptr + 40) ^ seed2);
+        ptr += 48;
+        left -= 48;
+      } while (left > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    if (left > 16) {
+      seed = detail::hash_mix(detail::hash_read64(ptr) ^ SECRET2, detail::hash_read64(ptr + 8) ^ seed ^ SECRET1);
+      if (left > 32) {
+        seed = detail::hash_mix(detail::hash_read64(ptr + 16) ^ SECRET2, detail::hash_read64(ptr + 24) ^ seed);
+      }
+    }
+    // the last 16 bytes are read even if some of them were already processed
+    a = detail::hash_read64(ptr + left - 16);
+    b = detail::hash_read64(ptr + left - 8);
+  }
+  a ^= SECRET1;
+  b ^= seed;
+  detail::hash_multiply(a, b);
+  return detail::hash_mix(a ^ SECRET0 ^ size, b ^ SECRET1);
+}
+
 template <class Type>
 struct Hash {
   uint32 operator()(const Type &value) const;
@@ -66,11 +175,35 @@ inline uint32 Hash<uint64>::operator()(const uint64 &value) const {
 
 template <>
 inline uint32 Hash<string>::operator()(const string &value) const {
-  return static_cast<uint32>(std::hash<string>()(value));
+  return static_cast<uint32>(hash_bytes(value.data(), value.size()));
 }
 
 inline uint32 combine_hashes(uint32 first_hash, uint32 second_hash) {
   return first_hash * 2023654985u + second_hash;
 }
 
+// memory used by hash table nodes; memory owned by the stored keys and values isn't included
+struct HashTableMemoryUsage {
+  size_t size = 0;          // number of stored elements
+  size_t bucket_count = 0;  // number of allocated nodes
+  size_t memory = 0;        // size of allocated nodes and control data in bytes
+  int32 level_count = 0;    // number of WaitFreeHashMap levels, which were split into sub-maps
+
+  double get_load_factor() const {
+    return bucket_count == 0 ? 0.0 : static_cast<double>(size) / static_cast<double>(bucket_count);
+  }
+
+  HashTableMemoryUsage &operator+=(const HashTableMemoryUsage &other) {
+    size += other.size;
+    bucket_count += other.bucket_count;
+    memory += other.memory;
+    level_count = max(level_count, other.level_count);
+    return *this;
+  }
+};
+
+class StringBuilder;
+
+StringBuilder &operator<<(StringBuilder &string_builder, const HashTableMemoryUsage &memory_usage);
+
 }  // namespace td
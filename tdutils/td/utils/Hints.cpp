@@ -14,6 +14,8 @@
 #include "td/utils/utf8.h"
 
 #include <algorithm>
+#include <limits>
+#include <utility>
 
 namespace td {
 
@@ -40,23 +42,14 @@ vector<string> Hints::get_words(Slice name) {
   return fix_words(utf8_get_search_words(name));
 }
 
-void Hints::add_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
-  vector<KeyT> &keys = word_to_keys[word];
-  CHECK(!td::contains(keys, key));
-  keys.push_back(key);
+void Hints::add_word(const string &word, KeyT key, WordIndex &word_to_keys) {
+  auto is_inserted = word_to_keys.insert(std::make_pair(word, key)).second;
+  CHECK(is_inserted);
 }
 
-void Hints::delete_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
-  vector<KeyT> &keys = word_to_keys[word];
-  auto key_it = std::find(keys.begin(), keys.end(), key);
-  CHECK(key_it != keys.end());
-  if (keys.size() == 1) {
-    word_to_keys.erase(word);
-  } else {
-    CHECK(keys.size() > 1);
-    *key_it = keys.back();
-    keys.pop_back();
-  }
+void Hints::delete_word(const string &word, KeyT key, WordIndex &word_to_keys) {
+  auto erased_count = word_to_keys.erase(std::make_pair(word, key));
+  CHECK(erased_count == 1);
 }
 
 void Hints::add(KeyT key, Slice name) {
@@ -110,14 +103,16 @@ void Hints::set_rating(KeyT key, RatingT rating) {
   key_to_rating_[key] = rating;
 }
 
-void Hints::add_search_results(vector<KeyT> &results, const string &word,
-                               const std::map<string, vector<KeyT>> &word_to_keys) {
+void Hints::add_search_results(vector<KeyT> &results, const string &word, const WordIndex &word_to_keys) {
   LOG(DEBUG) << "Search for word " << word;
-  auto it = word_to_keys.lower_bound(word);
-  while (it != word_to_keys.end() && begins_with(it->first, word)) {
-    append(results, it->second);
-    ++it;
-  }
+  word_to_keys.foreach_from(std::make_pair(word, std::numeric_limits<KeyT>::min()),
+                            [&](const std::pair<string, KeyT> &word_key) {
+                              if (!begins_with(word_key.first, word)) {
+                                return false;
+                              }
+                              results.push_back(word_key.second);
+                              return true;
+                            });
 }
 
 vector<Hints::KeyT> Hints::search_word(const string &word) const {
@@ -9,8 +9,8 @@
 #include "td/utils/common.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SortedChunkedSet.h"
 
-#include <map>
 #include <unordered_map>
 #include <utility>
 
@@ -45,18 +45,20 @@ class Hints {
   static vector<string> fix_words(vector<string> words);
 
  private:
-  std::map<string, vector<KeyT>> word_to_keys_;
-  std::map<string, vector<KeyT>> translit_word_to_keys_;
+  // sorted pairs (word, key) stored contiguously, so prefix search scans adjacent memory
+  using WordIndex = SortedChunkedSet<std::pair<string, KeyT>>;
+
+  WordIndex word_to_keys_;
+  WordIndex translit_word_to_keys_;
   std::unordered_map<KeyT, string, Hash<KeyT>> key_to_name_;
   std::unordered_map<KeyT, RatingT, Hash<KeyT>> key_to_rating_;
 
-  static void add_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys);
-  static void delete_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys);
+  static void add_word(const string &word, KeyT key, WordIndex &word_to_keys);
+  static void delete_word(const string &word, KeyT key, WordIndex &word_to_keys);
 
   static vector<string> get_words(Slice name);
 
-  static void add_search_results(vector<KeyT> &results, const string &word,
-                                 const std::map<string, vector<KeyT>> &word_to_keys);
+  static void add_search_results(vector<KeyT> &results, const string &word, const WordIndex &word_to_keys);
 
   vector<KeyT> search_word(const string &word) const;
 
@@ -43,16 +43,16 @@ string HttpUrl::get_url() const {
   return result;
 }
 
-Result<HttpUrl> parse_url(Slice url, HttpUrl::Protocol default_protocol) {
+Result<HttpUrlParts> parse_url_parts(Slice url, HttpUrl::Protocol default_protocol) {
   // url == [https?://][userinfo@]host[:port]
   ConstParser parser(url);
-  string protocol_str = to_lower(parser.read_till_nofail(":/?#@[]"));
+  Slice protocol_str = parser.read_till_nofail(":/?#@[]");
 
   HttpUrl::Protocol protocol;
   if (parser.try_skip("://")) {
-    if (protocol_str == "http") {
+    if (tolower_equals(protocol_str, "http")) {
       protocol = HttpUrl::Protocol::Http;
-    } else if (protocol_str == "https") {
+    } else if (tolower_equals(protocol_str, "https")) {
       protocol = HttpUrl::Protocol::Https;
     } else {
       return Status::Error("Unsupported URL protocol");
@@ -122,22 +122,6 @@ Result<HttpUrl> parse_url(Slice url, HttpUrl::Protocol default_protocol) {
   while (!query.empty() && is_space(query.back())) {
     query.remove_suffix(1);
   }
-  if (query.empty()) {
-    query = Slice("/");
-  }
-  string query_str;
-  if (query[0] != '/') {
-    query_str = '/';
-  }
-  for (auto c : query) {
-    if (static_cast<unsigned char>(c) <= 0x20) {
-      query_str += '%';
-      query_str += "0123456789ABCDEF"[c / 16];
-      query_str += "0123456789ABCDEF"[c % 16];
-    } else {
-      query_str += c;
-    }
-  }
 
   auto check_url_part = [](Slice part, Slice name, bool allow_colon) {
     for (size_t i = 0; i < part.size(); i++) {
@@ -171,21 +155,54 @@ Result<HttpUrl> parse_url(Slice url, HttpUrl::Protocol default_protocol) {
     return Status::OK();
   };
 
-  string host_str = to_lower(host);
   if (is_ipv6) {
-    for (size_t i = 1; i + 1 < host_str.size(); i++) {
-      char c = host_str[i];
+    for (size_t i = 1; i + 1 < host.size(); i++) {
+      char c = to_lower(host[i]);
       if (c == ':' || ('0' <= c && c <= '9') || ('a' <= c && c <= 'f') || c == '.') {
         continue;
       }
       return Status::Error("Wrong IPv6 URL host");
     }
   } else {
-    TRY_STATUS(check_url_part(host_str, "host", false));
+    TRY_STATUS(check_url_part(host, "host", false));
     TRY_STATUS(check_url_part(userinfo, "userinfo", true));
   }
 
-  return HttpUrl{protocol, userinfo.str(), std::move(host_str), is_ipv6, specified_port, port, std::move(query_str)};
+  HttpUrlParts result;
+  result.protocol_ = protocol;
+  result.userinfo_ = userinfo;
+  result.host_ = host;
+  result.is_ipv6_ = is_ipv6;
+  result.specified_port_ = specified_port;
+  result.port_ = port;
+  result.query_ = query;
+  return result;
+}
+
+string HttpUrlParts::get_normalized_query() const {
+  if (query_.empty()) {
+    return "/";
+  }
+  string query_str;
+  if (query_[0] != '/') {
+    query_str = '/';
+  }
+  for (auto c : query_) {
+    if (static_cast<unsigned char>(c) <= 0x20) {
+      query_str += '%';
+      query_str += "0123456789ABCDEF"[c / 16];
+      query_str += "0123456789ABCDEF"[c % 16];
+    } else {
+      query_str += c;
+    }
+  }
+  return query_str;
+}
+
+Result<HttpUrl> parse_url(Slice url, HttpUrl::Protocol default_protocol) {
+  TRY_RESULT(parts, parse_url_parts(url, default_protocol));
+  return HttpUrl(parts.protocol_, parts.userinfo_.str(), to_lower(parts.host_), parts.is_ipv6_, parts.specified_port_,
+                 parts.port_, parts.get_normalized_query());
 }
 
 StringBuilder &operator<<(StringBuilder &sb, const HttpUrl &url) {
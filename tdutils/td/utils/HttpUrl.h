@@ -41,6 +41,24 @@ class HttpUrl {
 Result<HttpUrl> parse_url(Slice url,
                           HttpUrl::Protocol default_protocol = HttpUrl::Protocol::Http) TD_WARN_UNUSED_RESULT;
 
+// parts of a URL, which point to the parsed string; the host isn't lowercased and the query isn't normalized
+struct HttpUrlParts {
+  HttpUrl::Protocol protocol_ = HttpUrl::Protocol::Http;
+  Slice userinfo_;
+  Slice host_;
+  bool is_ipv6_ = false;
+  int specified_port_ = 0;
+  int port_ = 0;
+  Slice query_;  // can be empty or begin with a symbol other than '/'; trailing whitespaces are removed
+
+  // returns the query as in HttpUrl::query_
+  string get_normalized_query() const;
+};
+
+// the same as parse_url, but doesn't allocate memory for valid URLs without IPv6 hosts
+Result<HttpUrlParts> parse_url_parts(Slice url, HttpUrl::Protocol default_protocol = HttpUrl::Protocol::Http)
+    TD_WARN_UNUSED_RESULT;
+
 StringBuilder &operator<<(StringBuilder &sb, const HttpUrl &url);
 
 class HttpUrlQuery {
@@ -6,13 +6,70 @@
 //
 #include "td/utils/JsonBuilder.h"
 
+#include "td/utils/base64.h"
+#include "td/utils/bits.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/utf8.h"
 
+#ifdef __aarch64__
+#include <arm_neon.h>
+#elif TD_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace td {
 
+// returns length of the longest prefix of the string, which can be added to JSON string as is
+// non-ASCII characters are added as is only if !is_ascii_only
+template <bool is_ascii_only>
+static size_t get_json_string_plain_prefix_length(const char *s, size_t len) {
+  size_t pos = 0;
+#ifdef __aarch64__
+  const auto quote = vdupq_n_u8('"');
+  const auto backslash = vdupq_n_u8('\\');
+  const auto space = vdupq_n_u8(' ');
+  const auto non_ascii = vdupq_n_u8(0x80);
+  for (; pos + 16 <= len; pos += 16) {
+    auto input = vld1q_u8(reinterpret_cast<const uint8 *>(s + pos));
+    auto special = vorrq_u8(vorrq_u8(vceqq_u8(input, quote), vceqq_u8(input, backslash)), vcltq_u8(input, space));
+    if (is_ascii_only) {
+      special = vorrq_u8(special, vcgeq_u8(input, non_ascii));
+    }
+    if (vmaxvq_u8(special) != 0) {
+      break;
+    }
+  }
+#elif TD_SSE2
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  for (; pos + 16 <= len; pos += 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + pos));
+    auto special = _mm_or_si128(_mm_cmpeq_epi8(input, quote), _mm_cmpeq_epi8(input, backslash));
+    if (is_ascii_only) {
+      // non-ASCII characters are negative if treated as signed
+      special = _mm_or_si128(special, _mm_cmplt_epi8(input, _mm_set1_epi8(' ')));
+    } else {
+      const auto max_control = _mm_set1_epi8(31);
+      special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(input, max_control), max_control));
+    }
+    auto mask = static_cast<uint32>(_mm_movemask_epi8(special));
+    if (mask != 0) {
+      return pos + count_trailing_zeroes_non_zero32(mask);
+    }
+  }
+#endif
+  while (pos < len) {
+    auto ch = static_cast<unsigned char>(s[pos]);
+    if (ch == '"' || ch == '\\' || ch <= 31 || (is_ascii_only && ch >= 128)) {
+      break;
+    }
+    pos++;
+  }
+  return pos;
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   sb << '"';
   SCOPE_EXIT {
@@ -22,6 +79,14 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   auto len = val.value_.size();
 
   for (size_t pos = 0; pos < len; pos++) {
+    auto plain_length = get_json_string_plain_prefix_length<false>(s + pos, len - pos);
+    if (plain_length != 0) {
+      sb << Slice(s + pos, plain_length);
+      pos += plain_length;
+      if (pos == len) {
+        break;
+      }
+    }
     auto ch = static_cast<unsigned char>(s[pos]);
     switch (ch) {
       case '"':
@@ -57,6 +122,17 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   return sb;
 }
 
+StringBuilder &operator<<(StringBuilder &sb, const JsonBase64 &val) {
+  sb << '"';
+  // the chunk size is divisible by 3, so there is no padding between chunks
+  constexpr size_t CHUNK_SIZE = 3 << 12;
+  for (size_t pos = 0; pos < val.bytes_.size(); pos += CHUNK_SIZE) {
+    sb << base64_encode(val.bytes_.substr(pos, CHUNK_SIZE));
+  }
+  sb << '"';
+  return sb;
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const JsonString &val) {
   sb << '"';
   SCOPE_EXIT {
@@ -66,6 +142,14 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonString &val) {
   auto len = val.str_.size();
 
   for (size_t pos = 0; pos < len; pos++) {
+    auto plain_length = get_json_string_plain_prefix_length<true>(s + pos, len - pos);
+    if (plain_length != 0) {
+      sb << Slice(s + pos, plain_length);
+      pos += plain_length;
+      if (pos == len) {
+        break;
+      }
+    }
     auto ch = static_cast<unsigned char>(s[pos]);
     switch (ch) {
       case '"':
@@ -155,6 +155,18 @@ class JsonRawString {
   Slice value_;
 };
 
+// base64-encodes bytes directly into the JSON string without creating an intermediate string
+class JsonBase64 {
+ public:
+  explicit JsonBase64(Slice bytes) : bytes_(bytes) {
+  }
+
+  friend StringBuilder &operator<<(StringBuilder &sb, const JsonBase64 &val);
+
+ private:
+  Slice bytes_;
+};
+
 class JsonString {
  public:
   explicit JsonString(Slice str) : str_(str) {
@@ -290,6 +302,10 @@ class JsonScope {
     *sb_ << x;
     return *this;
   }
+  JsonScope &operator<<(const JsonBase64 &x) {
+    *sb_ << x;
+    return *this;
+  }
   JsonScope &operator<<(bool x) = delete;
   JsonScope &operator<<(int32 x) {
     return *this << JsonInt(x);
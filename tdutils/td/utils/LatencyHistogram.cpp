@@ -0,0 +1,126 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/LatencyHistogram.h"
+
+#include "td/utils/bits.h"
+#include "td/utils/format.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <map>
+#include <mutex>
+
+namespace td {
+
+constexpr size_t LatencyHistogram::BUCKET_COUNT;
+
+size_t LatencyHistogram::get_bucket(double duration) {
+  if (!(duration >= 2e-6)) {
+    return duration >= 1e-6 ? 1 : 0;
+  }
+  if (duration >= 1.0e9) {
+    return BUCKET_COUNT - 1;
+  }
+  auto microseconds = static_cast<uint64>(duration * 1e6);
+  auto power = static_cast<size_t>(63 - count_leading_zeroes64(microseconds));
+  auto bucket = 2 * power + static_cast<size_t>((microseconds >> (power - 1)) & 1);
+  return td::min(bucket, BUCKET_COUNT - 1);
+}
+
+double LatencyHistogram::get_bucket_upper_bound(size_t bucket) {
+  CHECK(bucket < BUCKET_COUNT);
+  if (bucket < 2) {
+    return static_cast<double>(bucket + 1) * 1e-6;
+  }
+  auto power = bucket / 2;
+  auto upper_bound = (static_cast<uint64>(1) << power) + (static_cast<uint64>(bucket % 2 + 1) << (power - 1));
+  return static_cast<double>(upper_bound) * 1e-6;
+}
+
+double LatencyHistogram::Snapshot::get_percentile(double percentile) const {
+  auto needed_count = static_cast<uint64>(static_cast<double>(count) * percentile);
+  uint64 current_count = 0;
+  for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+    current_count += bucket_counts[bucket];
+    if (current_count > needed_count) {
+      return get_bucket_upper_bound(bucket);
+    }
+  }
+  return get_bucket_upper_bound(BUCKET_COUNT - 1);
+}
+
+void LatencyHistogram::add(double duration) {
+  if (duration < 0) {
+    duration = 0;
+  }
+  auto &buckets = tls_.get();
+  buckets.counts[get_bucket(duration)].fetch_add(1, std::memory_order_relaxed);
+  buckets.total_time_ns.fetch_add(static_cast<uint64>(duration * 1e9), std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::get_snapshot() const {
+  Snapshot result;
+  uint64 total_time_ns = 0;
+  tls_.for_each([&](const Buckets &buckets) {
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+      auto count = buckets.counts[bucket].load(std::memory_order_relaxed);
+      result.bucket_counts[bucket] += count;
+      result.count += count;
+    }
+    total_time_ns += buckets.total_time_ns.load(std::memory_order_relaxed);
+  });
+  result.total_time = static_cast<double>(total_time_ns) * 1e-9;
+  return result;
+}
+
+void LatencyHistogram::clear() {
+  tls_.for_each([](Buckets &buckets) {
+    for (auto &count : buckets.counts) {
+      count.store(0, std::memory_order_relaxed);
+    }
+    buckets.total_time_ns.store(0, std::memory_order_relaxed);
+  });
+}
+
+static std::mutex latency_histograms_mutex;
+
+static std::map<string, unique_ptr<LatencyHistogram>> &get_latency_histograms() {
+  static std::map<string, unique_ptr<LatencyHistogram>> histograms;
+  return histograms;
+}
+
+LatencyHistogram *LatencyHistogram::get(Slice name) {
+  std::lock_guard<std::mutex> lock(latency_histograms_mutex);
+  auto &histogram = get_latency_histograms()[name.str()];
+  if (histogram == nullptr) {
+    histogram = make_unique<LatencyHistogram>();
+  }
+  return histogram.get();
+}
+
+string LatencyHistogram::get_statistics() {
+  string result;
+  std::lock_guard<std::mutex> lock(latency_histograms_mutex);
+  for (auto &it : get_latency_histograms()) {
+    auto snapshot = it.second->get_snapshot();
+    if (snapshot.count == 0) {
+      continue;
+    }
+    size_t max_bucket = BUCKET_COUNT - 1;
+    while (snapshot.bucket_counts[max_bucket] == 0) {
+      max_bucket--;
+    }
+    result += PSTRING() << it.first << ": " << snapshot.count << " calls, total " << format::as_time(snapshot.total_time)
+                        << ", avg/p50/p90/p99/max " << format::as_time(snapshot.get_average()) << '/'
+                        << format::as_time(snapshot.get_percentile(0.5)) << '/'
+                        << format::as_time(snapshot.get_percentile(0.9)) << '/'
+                        << format::as_time(snapshot.get_percentile(0.99)) << '/'
+                        << format::as_time(get_bucket_upper_bound(max_bucket)) << '\n';
+  }
+  return result;
+}
+
+}  // namespace td
@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/ThreadLocalStorage.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+
+namespace td {
+
+// Histogram of durations with logarithmic buckets. Each interval between powers of 2 microseconds is split into
+// 2 buckets, so returned percentiles are at most 1.5 times bigger than the real values.
+// Durations longer than about 12.6 seconds fall into the last bucket.
+// Durations are recorded without locks to a copy of the histogram of the current thread; copies are merged on read.
+class LatencyHistogram {
+ public:
+  static constexpr size_t BUCKET_COUNT = 48;
+
+  struct Snapshot {
+    uint64 count = 0;
+    double total_time = 0.0;
+    uint64 bucket_counts[BUCKET_COUNT] = {};
+
+    double get_average() const {
+      return count == 0 ? 0.0 : total_time / static_cast<double>(count);
+    }
+
+    // returns the upper bound of the bucket containing the percentile
+    double get_percentile(double percentile) const;
+  };
+
+  // records duration to the histogram after the end of the scope
+  class Timer {
+   public:
+    explicit Timer(LatencyHistogram *histogram) : histogram_(histogram) {
+      if (histogram_ != nullptr) {
+        start_time_ = Time::now();
+      }
+    }
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+    Timer(Timer &&) = delete;
+    Timer &operator=(Timer &&) = delete;
+    ~Timer() {
+      if (histogram_ != nullptr) {
+        histogram_->add(Time::now() - start_time_);
+      }
+    }
+
+   private:
+    LatencyHistogram *histogram_;
+    double start_time_ = 0.0;
+  };
+
+  // duration in seconds
+  void add(double duration);
+
+  Snapshot get_snapshot() const;
+
+  void clear();
+
+  static size_t get_bucket(double duration);
+
+  static double get_bucket_upper_bound(size_t bucket);
+
+  // returns a histogram with the given name, which is created on the first call and is never destroyed
+  static LatencyHistogram *get(Slice name);
+
+  // returns all non-empty named histograms in a human-readable format
+  static string get_statistics();
+
+ private:
+  struct Buckets {
+    std::atomic<uint64> counts[BUCKET_COUNT] = {};
+    std::atomic<uint64> total_time_ns{0};
+  };
+  ThreadLocalStorage<Buckets> tls_;
+};
+
+}  // namespace td
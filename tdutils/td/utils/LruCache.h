@@ -0,0 +1,333 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/HashTableUtils.h"
+#include "td/utils/List.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
+
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace td {
+
+struct LruCacheStats {
+  size_t size = 0;        // number of cached values
+  size_t cost = 0;        // total cost of cached values
+  size_t max_cost = 0;    // maximum total cost of cached values
+  uint64 hit_count = 0;   // number of successful lookups
+  uint64 miss_count = 0;  // number of lookups of missing or expired values
+  uint64 eviction_count = 0;
+  uint64 expiration_count = 0;
+  uint64 load_count = 0;         // number of started loads
+  uint64 merged_load_count = 0;  // number of get_or_load calls merged with an already started load
+  uint64 failed_load_count = 0;
+};
+
+inline StringBuilder &operator<<(StringBuilder &string_builder, const LruCacheStats &stats) {
+  return string_builder << stats.size << " values with cost " << stats.cost << " out of " << stats.max_cost << ", "
+                        << stats.hit_count << " hits, " << stats.miss_count << " misses, " << stats.eviction_count
+                        << " evictions, " << stats.expiration_count << " expirations, " << stats.load_count
+                        << " loads, " << stats.merged_load_count << " merged loads, " << stats.failed_load_count
+                        << " failed loads";
+}
+
+// Cache with least recently used eviction policy, which is bounded by the total cost of the stored values.
+// The cost of a value is computed by the cost function; by default each value costs 1, so the cache is bounded by
+// the number of values. If ttl is positive, then values expire in ttl seconds after they were added.
+// Concurrent get_or_load requests for the same key are merged into a single load.
+// The cache isn't thread-safe; use TsLruCache to access the cache from different threads.
+template <class KeyT, class ValueT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+class LruCache {
+ public:
+  // the loader must eventually set the promise; it is allowed to set it immediately
+  using Loader = std::function<void(const KeyT &key, Promise<ValueT> promise)>;
+  using CostFunction = std::function<size_t(const KeyT &key, const ValueT &value)>;
+
+  explicit LruCache(size_t max_cost, double ttl = 0.0) : max_cost_(max_cost), ttl_(ttl) {
+  }
+  LruCache(const LruCache &) = delete;
+  LruCache &operator=(const LruCache &) = delete;
+  LruCache(LruCache &&) = delete;
+  LruCache &operator=(LruCache &&) = delete;
+  ~LruCache() = default;
+
+  void set_loader(Loader loader) {
+    loader_ = std::move(loader);
+  }
+
+  void set_cost_function(CostFunction cost_function) {
+    cost_function_ = std::move(cost_function);
+  }
+
+  // returns nullptr if there is no value for the key or it has expired
+  ValueT *get(const KeyT &key) {
+    auto node = get_node(key);
+    if (node == nullptr) {
+      stats_.miss_count++;
+      return nullptr;
+    }
+    stats_.hit_count++;
+    return &node->value;
+  }
+
+  void put(KeyT key, ValueT value) {
+    auto cost = cost_function_ ? cost_function_(key, value) : 1;
+    put(std::move(key), std::move(value), cost);
+  }
+
+  void put(KeyT key, ValueT value, size_t cost) {
+    erase(key);
+    if (cost > max_cost_) {
+      return;
+    }
+
+    auto node = make_unique<Node>();
+    node->key = key;
+    node->value = std::move(value);
+    node->cost = cost;
+    node->expires_at = ttl_ > 0 ? Time::now() + ttl_ : 0.0;
+    lru_list_.put(node.get());
+    stats_.cost += cost;
+    nodes_.emplace(std::move(key), std::move(node));
+
+    while (stats_.cost > max_cost_) {
+      auto *lru_node = static_cast<Node *>(lru_list_.get());
+      CHECK(lru_node != nullptr);
+      stats_.eviction_count++;
+      remove_node(lru_node);
+    }
+  }
+
+  bool erase(const KeyT &key) {
+    auto it = nodes_.find(key);
+    if (it == nodes_.end()) {
+      return false;
+    }
+    remove_node(it->second.get());
+    return true;
+  }
+
+  void clear() {
+    while (!lru_list_.empty()) {
+      remove_node(static_cast<Node *>(lru_list_.get()));
+    }
+  }
+
+  // returns a copy of the cached value or loads it using the loader; the cache must outlive all started loads
+  void get_or_load(const KeyT &key, Promise<ValueT> promise) {
+    auto value = get(key);
+    if (value != nullptr) {
+      return promise.set_value(ValueT(*value));
+    }
+    if (add_load_waiter(key, std::move(promise))) {
+      CHECK(loader_);
+      loader_(key, [this, key](Result<ValueT> r_value) {
+        auto promises = finish_load(key, r_value);
+        set_load_result(std::move(promises), r_value);
+      });
+    }
+  }
+
+  // lower-level interface to get_or_load, which allows to load values without a loader
+  // registers the promise, which will be set after the load of the key, and returns true if the load must be started
+  bool add_load_waiter(const KeyT &key, Promise<ValueT> &&promise) {
+    auto &promises = pending_loads_[key];
+    promises.push_back(std::move(promise));
+    if (promises.size() == 1) {
+      stats_.load_count++;
+      return true;
+    }
+    stats_.merged_load_count++;
+    return false;
+  }
+
+  // stores the loaded value and returns promises waiting for it, which must be passed to set_load_result
+  vector<Promise<ValueT>> finish_load(const KeyT &key, const Result<ValueT> &r_value) {
+    if (r_value.is_ok()) {
+      put(key, ValueT(r_value.ok()));
+    } else {
+      stats_.failed_load_count++;
+    }
+    auto it = pending_loads_.find(key);
+    if (it == pending_loads_.end()) {
+      return {};
+    }
+    auto promises = std::move(it->second);
+    pending_loads_.erase(it);
+    return promises;
+  }
+
+  static void set_load_result(vector<Promise<ValueT>> &&promises, const Result<ValueT> &r_value) {
+    for (auto &promise : promises) {
+      if (r_value.is_ok()) {
+        promise.set_value(ValueT(r_value.ok()));
+      } else {
+        promise.set_error(r_value.error().clone());
+      }
+    }
+  }
+
+  size_t size() const {
+    return nodes_.size();
+  }
+
+  LruCacheStats get_stats() const {
+    auto stats = stats_;
+    stats.size = nodes_.size();
+    stats.max_cost = max_cost_;
+    return stats;
+  }
+
+ private:
+  struct Node final : public ListNode {
+    KeyT key;
+    ValueT value;
+    size_t cost = 0;
+    double expires_at = 0.0;
+  };
+
+  FlatHashMap<KeyT, unique_ptr<Node>, HashT, EqT> nodes_;
+  ListNode lru_list_;  // the most recently used nodes are in the beginning of the list
+  FlatHashMap<KeyT, vector<Promise<ValueT>>, HashT, EqT> pending_loads_;
+  Loader loader_;
+  CostFunction cost_function_;
+  size_t max_cost_;
+  double ttl_;
+  LruCacheStats stats_;
+
+  Node *get_node(const KeyT &key) {
+    auto it = nodes_.find(key);
+    if (it == nodes_.end()) {
+      return nullptr;
+    }
+    auto *node = it->second.get();
+    if (node->expires_at != 0.0 && node->expires_at <= Time::now()) {
+      stats_.expiration_count++;
+      remove_node(node);
+      return nullptr;
+    }
+    node->remove();
+    lru_list_.put(node);
+    return node;
+  }
+
+  void remove_node(Node *node) {
+    node->remove();
+    stats_.cost -= node->cost;
+    auto it = nodes_.find(node->key);
+    CHECK(it != nodes_.end());
+    nodes_.erase(it);
+  }
+};
+
+// thread-safe wrapper around LruCache; values are returned by copy
+// the loader is called and promises are set without holding the lock; the cache must outlive all started loads
+template <class KeyT, class ValueT, class HashT = Hash<KeyT>, class EqT = std::equal_to<KeyT>>
+class TsLruCache {
+  using Cache = LruCache<KeyT, ValueT, HashT, EqT>;
+
+ public:
+  using Loader = typename Cache::Loader;
+  using CostFunction = typename Cache::CostFunction;
+
+  explicit TsLruCache(size_t max_cost, double ttl = 0.0) : cache_(max_cost, ttl) {
+  }
+
+  // must be called before the cache is used from other threads
+  void set_loader(Loader loader) {
+    loader_ = std::move(loader);
+  }
+
+  void set_cost_function(CostFunction cost_function) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_.set_cost_function(std::move(cost_function));
+  }
+
+  bool get(const KeyT &key, ValueT &value) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto cached_value = cache_.get(key);
+    if (cached_value == nullptr) {
+      return false;
+    }
+    value = *cached_value;
+    return true;
+  }
+
+  void put(KeyT key, ValueT value) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_.put(std::move(key), std::move(value));
+  }
+
+  void put(KeyT key, ValueT value, size_t cost) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_.put(std::move(key), std::move(value), cost);
+  }
+
+  bool erase(const KeyT &key) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return cache_.erase(key);
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_.clear();
+  }
+
+  void get_or_load(const KeyT &key, Promise<ValueT> promise) {
+    ValueT value;
+    bool is_found = false;
+    bool need_load = false;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto cached_value = cache_.get(key);
+      if (cached_value != nullptr) {
+        value = *cached_value;
+        is_found = true;
+      } else {
+        need_load = cache_.add_load_waiter(key, std::move(promise));
+      }
+    }
+    if (is_found) {
+      return promise.set_value(std::move(value));
+    }
+    if (need_load) {
+      CHECK(loader_);
+      loader_(key, [this, key](Result<ValueT> r_value) {
+        vector<Promise<ValueT>> promises;
+        {
+          std::lock_guard<std::mutex> guard(mutex_);
+          promises = cache_.finish_load(key, r_value);
+        }
+        Cache::set_load_result(std::move(promises), r_value);
+      });
+    }
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return cache_.size();
+  }
+
+  LruCacheStats get_stats() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return cache_.get_stats();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  Cache cache_;
+  Loader loader_;
+};
+
+}  // namespace td
@@ -17,10 +17,26 @@ class MpscLinkQueueImpl {
   class Node;
   class Reader;
 
-  void push(Node *node) {
+  // returns true, if the queue was empty before the push
+  bool push(Node *node) {
     node->next_ = head_.load(std::memory_order_relaxed);
     while (!head_.compare_exchange_strong(node->next_, node, std::memory_order_release, std::memory_order_relaxed)) {
     }
+    return node->next_ == nullptr;
+  }
+
+  // pushes the list first..last, previously linked with link(), by a single atomic operation
+  // returns true, if the queue was empty before the push
+  bool push_list(Node *first, Node *last) {
+    first->next_ = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_strong(first->next_, last, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    return first->next_ == nullptr;
+  }
+
+  // makes next to be pushed right after prev by push_list
+  static void link(Node *prev, Node *next) {
+    next->next_ = prev;
   }
 
   void push_unsafe(Node *node) {
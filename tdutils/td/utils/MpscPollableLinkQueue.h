@@ -0,0 +1,199 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/misc.h"
+#include "td/utils/MpscLinkQueue.h"
+#include "td/utils/port/EventFd.h"
+#include "td/utils/SlabAllocator.h"
+
+#if !TD_EVENTFD_UNSUPPORTED
+
+#include <cstddef>
+#include <utility>
+
+namespace td {
+
+// lock-free version of MpscPollableQueue with the same interface
+// writers never take a lock and wake up the reader only when the queue becomes non-empty
+template <class T>
+class MpscPollableLinkQueue {
+ public:
+  using ValueType = T;
+
+  MpscPollableLinkQueue() = default;
+  MpscPollableLinkQueue(const MpscPollableLinkQueue &) = delete;
+  MpscPollableLinkQueue &operator=(const MpscPollableLinkQueue &) = delete;
+  MpscPollableLinkQueue(MpscPollableLinkQueue &&) = delete;
+  MpscPollableLinkQueue &operator=(MpscPollableLinkQueue &&) = delete;
+  ~MpscPollableLinkQueue() {
+    clear_nodes();
+  }
+
+  int reader_wait_nonblock() {
+    if (reader_ready_ != 0) {
+      return reader_ready_;
+    }
+
+    reader_pop_all();
+    if (reader_ready_ == 0) {
+      // all wakeups, which happened before the acquire, are guaranteed to be consumed by the next pop_all
+      event_fd_.acquire();
+      reader_pop_all();
+    }
+    return reader_ready_;
+  }
+  ValueType reader_get_unsafe() {
+    auto node = static_cast<Node *>(reader_.read());
+    CHECK(node != nullptr);
+    reader_ready_--;
+    ValueType result = std::move(node->value_);
+    delete node;
+    return result;
+  }
+  void reader_flush() {
+    //nop
+  }
+  void writer_put(ValueType value) {
+    if (impl_.push(new Node(std::move(value)))) {
+      event_fd_.release();
+    }
+  }
+  // moves all values from the vector to the queue with a single atomic operation and at most one wakeup
+  void writer_put_batch(vector<ValueType> &values) {
+    if (values.empty()) {
+      return;
+    }
+    Node *first = new Node(std::move(values[0]));
+    Node *last = first;
+    for (size_t i = 1; i < values.size(); i++) {
+      auto node = new Node(std::move(values[i]));
+      MpscLinkQueueImpl::link(last, node);
+      last = node;
+    }
+    values.clear();
+    if (impl_.push_list(first, last)) {
+      event_fd_.release();
+    }
+  }
+  EventFd &reader_get_event_fd() {
+    return event_fd_;
+  }
+  void writer_flush() {
+    //nop
+  }
+
+  void init() {
+    event_fd_.init();
+  }
+  void destroy() {
+    if (!event_fd_.empty()) {
+      event_fd_.close();
+      clear_nodes();
+    }
+  }
+
+  // Just an example of usage
+  int reader_wait() {
+    int res;
+    while ((res = reader_wait_nonblock()) == 0) {
+      reader_get_event_fd().wait(1000);
+    }
+    return res;
+  }
+
+ private:
+  class Node final : public MpscLinkQueueImpl::Node {
+   public:
+    explicit Node(ValueType value) : value_(std::move(value)) {
+    }
+
+    static void *operator new(std::size_t size) {
+      return SlabAllocator::allocate(size);
+    }
+    static void operator delete(void *ptr) {
+      SlabAllocator::deallocate(ptr);
+    }
+
+    ValueType value_;
+  };
+
+  MpscLinkQueueImpl impl_;
+  EventFd event_fd_;
+  MpscLinkQueueImpl::Reader reader_;
+  int reader_ready_{0};
+
+  void reader_pop_all() {
+    impl_.pop_all(reader_);
+    reader_ready_ = narrow_cast<int>(reader_.calc_size());
+  }
+
+  void clear_nodes() {
+    impl_.pop_all(reader_);
+    while (auto node = reader_.read()) {
+      delete static_cast<Node *>(node);
+    }
+    reader_ready_ = 0;
+  }
+};
+
+}  // namespace td
+
+#else
+
+namespace td {
+
+// dummy implementation which shouldn't be used
+
+template <class T>
+class MpscPollableLinkQueue {
+ public:
+  using ValueType = T;
+
+  void init() {
+    UNREACHABLE();
+  }
+
+  template <class PutValueType>
+  void writer_put(PutValueType &&value) {
+    UNREACHABLE();
+  }
+
+  void writer_put_batch(vector<ValueType> &values) {
+    UNREACHABLE();
+  }
+
+  void writer_flush() {
+    UNREACHABLE();
+  }
+
+  int reader_wait_nonblock() {
+    UNREACHABLE();
+    return 0;
+  }
+
+  ValueType reader_get_unsafe() {
+    UNREACHABLE();
+    return ValueType();
+  }
+
+  void reader_flush() {
+    UNREACHABLE();
+  }
+
+  MpscPollableLinkQueue() = default;
+  MpscPollableLinkQueue(const MpscPollableLinkQueue &) = delete;
+  MpscPollableLinkQueue &operator=(const MpscPollableLinkQueue &) = delete;
+  MpscPollableLinkQueue(MpscPollableLinkQueue &&) = delete;
+  MpscPollableLinkQueue &operator=(MpscPollableLinkQueue &&) = delete;
+  ~MpscPollableLinkQueue() = default;
+};
+
+}  // namespace td
+
+#endif
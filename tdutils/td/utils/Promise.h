@@ -10,8 +10,11 @@
 #include "td/utils/common.h"
 #include "td/utils/invoke.h"
 #include "td/utils/MovableValue.h"
+#include "td/utils/SlabAllocator.h"
 #include "td/utils/Status.h"
 
+#include <cstddef>
+#include <new>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -119,6 +122,14 @@ class LambdaPromise : public PromiseInterface<ValueT> {
   LambdaPromise(FromT &&func) : func_(std::forward<FromT>(func)), state_(State::Ready) {
   }
 
+  // a promise is created for each asynchronous step, so it is allocated from the per-thread pool
+  static void *operator new(std::size_t size) {
+    return SlabAllocator::allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    SlabAllocator::deallocate(ptr);
+  }
+
  private:
   FunctionT func_;
   MovableValue<State> state_{State::Empty};
@@ -186,8 +197,7 @@ auto promise_interface_ptr(F &&f) {
 template <class T, class F,
           std::enable_if_t<!is_promise_interface_ptr<std::decay_t<F>>::value, bool> from_promise_interface = false>
 auto promise_interface_ptr(F &&f) {
-  return td::make_unique<std::decay_t<decltype(promise_interface<T>(std::forward<F>(f)))>>(
-      promise_interface<T>(std::forward<F>(f)));
+  return std::decay_t<decltype(promise_interface<T>(std::forward<F>(f)))>(promise_interface<T>(std::forward<F>(f)));
 }
 }  // namespace detail
 
@@ -199,24 +209,33 @@ class Promise {
       return;
     }
     promise_->set_value(std::move(value));
-    promise_.reset();
+    reset();
   }
   void set_error(Status &&error) {
     if (!promise_) {
       return;
     }
     promise_->set_error(std::move(error));
-    promise_.reset();
+    reset();
   }
   void set_result(Result<T> &&result) {
     if (!promise_) {
       return;
     }
     promise_->set_result(std::move(result));
-    promise_.reset();
+    reset();
   }
   void reset() {
-    promise_.reset();
+    if (promise_ == nullptr) {
+      return;
+    }
+    if (move_inline_ != nullptr) {
+      promise_->~PromiseInterface<T>();
+      move_inline_ = nullptr;
+    } else {
+      delete promise_;
+    }
+    promise_ = nullptr;
   }
   bool is_cancellable() const {
     if (!promise_) {
@@ -231,26 +250,110 @@ class Promise {
     return promise_->is_canceled();
   }
   unique_ptr<PromiseInterface<T>> release() {
-    return std::move(promise_);
+    auto promise = promise_;
+    if (move_inline_ != nullptr) {
+      promise = move_inline_(promise_, nullptr);
+      move_inline_ = nullptr;
+    }
+    promise_ = nullptr;
+    return unique_ptr<PromiseInterface<T>>(promise);
   }
 
   Promise() = default;
-  explicit Promise(unique_ptr<PromiseInterface<T>> promise) : promise_(std::move(promise)) {
+  explicit Promise(unique_ptr<PromiseInterface<T>> promise) : promise_(promise.release()) {
   }
   Promise(Auto) {
   }
   Promise(SafePromise<T> &&other);
   Promise &operator=(SafePromise<T> &&other);
   template <class F, std::enable_if_t<!std::is_same<std::decay_t<F>, Promise>::value, int> = 0>
-  Promise(F &&f) : promise_(detail::promise_interface_ptr<T>(std::forward<F>(f))) {
+  Promise(F &&f) {
+    init(detail::promise_interface_ptr<T>(std::forward<F>(f)));
+  }
+  Promise(const Promise &) = delete;
+  Promise &operator=(const Promise &) = delete;
+  Promise(Promise &&other) noexcept {
+    move_from(other);
+  }
+  Promise &operator=(Promise &&other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+  ~Promise() {
+    reset();
+  }
+
+  // creates a promise with an implementation of PromiseInterface constructed from the arguments
+  // small implementations are stored inside the promise without memory allocation
+  template <class ImplT, class... ArgsT>
+  static Promise create(ArgsT &&...args) {
+    Promise result;
+    result.template emplace<ImplT>(is_inline_storable<ImplT>(), std::forward<ArgsT>(args)...);
+    return result;
   }
 
   explicit operator bool() const noexcept {
-    return static_cast<bool>(promise_);
+    return promise_ != nullptr;
   }
 
  private:
-  unique_ptr<PromiseInterface<T>> promise_;
+  // moves the promise stored inline to the buffer or to the heap if the buffer is nullptr
+  using MoveInlineFunction = PromiseInterface<T> *(*)(PromiseInterface<T> *promise, void *buffer);
+
+  static constexpr size_t INLINE_STORAGE_SIZE = 4 * sizeof(void *);
+
+  PromiseInterface<T> *promise_ = nullptr;
+  MoveInlineFunction move_inline_ = nullptr;  // non-null if the promise is stored inline
+  std::aligned_storage_t<INLINE_STORAGE_SIZE, alignof(void *)> storage_;
+
+  template <class ImplT>
+  using is_inline_storable =
+      std::integral_constant<bool, sizeof(ImplT) <= INLINE_STORAGE_SIZE && alignof(ImplT) <= alignof(void *) &&
+                                       std::is_nothrow_move_constructible<ImplT>::value>;
+
+  template <class ImplT>
+  static PromiseInterface<T> *move_inline(PromiseInterface<T> *promise, void *buffer) {
+    auto *impl = static_cast<ImplT *>(promise);
+    PromiseInterface<T> *result =
+        buffer == nullptr ? new ImplT(std::move(*impl)) : ::new (buffer) ImplT(std::move(*impl));
+    impl->~ImplT();
+    return result;
+  }
+
+  template <class ImplT, class... ArgsT>
+  void emplace(std::true_type, ArgsT &&...args) {
+    promise_ = ::new (static_cast<void *>(&storage_)) ImplT(std::forward<ArgsT>(args)...);
+    move_inline_ = &move_inline<ImplT>;
+  }
+
+  template <class ImplT, class... ArgsT>
+  void emplace(std::false_type, ArgsT &&...args) {
+    promise_ = new ImplT(std::forward<ArgsT>(args)...);
+  }
+
+  template <class ImplT>
+  void init(unique_ptr<ImplT> &&promise) {
+    promise_ = promise.release();
+  }
+
+  template <class ImplT>
+  void init(ImplT &&promise) {
+    emplace<ImplT>(is_inline_storable<ImplT>(), std::move(promise));
+  }
+
+  void move_from(Promise &other) noexcept {
+    if (other.move_inline_ != nullptr) {
+      promise_ = other.move_inline_(other.promise_, &storage_);
+      move_inline_ = other.move_inline_;
+      other.move_inline_ = nullptr;
+    } else {
+      promise_ = other.promise_;
+    }
+    other.promise_ = nullptr;
+  }
 };
 
 template <class T = Unit>
@@ -326,13 +429,13 @@ class PromiseCreator {
  public:
   template <class OkT, class ArgT = detail::drop_result_t<detail::get_arg_t<OkT>>>
   static Promise<ArgT> lambda(OkT &&ok) {
-    return Promise<ArgT>(td::make_unique<detail::LambdaPromise<ArgT, std::decay_t<OkT>>>(std::forward<OkT>(ok)));
+    return Promise<ArgT>::template create<detail::LambdaPromise<ArgT, std::decay_t<OkT>>>(std::forward<OkT>(ok));
   }
 
   template <class OkT, class ArgT = detail::drop_result_t<detail::get_arg_t<OkT>>>
   static auto cancellable_lambda(CancellationToken cancellation_token, OkT &&ok) {
-    return Promise<ArgT>(td::make_unique<detail::CancellablePromise<detail::LambdaPromise<ArgT, std::decay_t<OkT>>>>(
-        std::move(cancellation_token), std::forward<OkT>(ok)));
+    return Promise<ArgT>::template create<detail::CancellablePromise<detail::LambdaPromise<ArgT, std::decay_t<OkT>>>>(
+        std::move(cancellation_token), std::forward<OkT>(ok));
   }
 
   template <class... ArgsT>
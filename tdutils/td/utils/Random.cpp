@@ -10,9 +10,15 @@
 #include "td/utils/port/thread_local.h"
 
 #if TD_HAVE_OPENSSL
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
 #include <openssl/rand.h>
 #endif
 
+#if TD_PORT_POSIX
+#include <pthread.h>
+#endif
+
 #include <atomic>
 #include <cstring>
 #include <limits>
@@ -22,8 +28,123 @@ namespace td {
 
 #if TD_HAVE_OPENSSL
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+#define TD_HAVE_CHACHA20_RANDOM 1
+#endif
+
 namespace {
 std::atomic<int64> random_seed_generation{0};
+
+// Generates random bytes using ChaCha20 keystream with "fast key erasure": the first 32 bytes of each generated block
+// become the key for the next block, so the state never allows to restore already returned bytes.
+// The key is taken from RAND_bytes after each MAX_SEED_USE_COUNT blocks, after add_seed and after fork.
+// Old OpenSSL versions without ChaCha20 fill the blocks directly with RAND_bytes.
+class SecureRandomGenerator {
+ public:
+  SecureRandomGenerator() {
+#if TD_HAVE_CHACHA20_RANDOM
+    ctx_ = EVP_CIPHER_CTX_new();
+    LOG_IF(FATAL, ctx_ == nullptr);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+    cipher_ = EVP_CIPHER_fetch(nullptr, "ChaCha20", nullptr);
+#else
+    cipher_ = EVP_chacha20();
+#endif
+    LOG_IF(FATAL, cipher_ == nullptr);
+#endif
+#if TD_PORT_POSIX
+    static bool is_fork_handler_registered = [] {
+      pthread_atfork(nullptr, nullptr, [] { random_seed_generation++; });
+      return true;
+    }();
+    CHECK(is_fork_handler_registered);
+#endif
+  }
+  SecureRandomGenerator(const SecureRandomGenerator &) = delete;
+  SecureRandomGenerator &operator=(const SecureRandomGenerator &) = delete;
+  SecureRandomGenerator(SecureRandomGenerator &&) = delete;
+  SecureRandomGenerator &operator=(SecureRandomGenerator &&) = delete;
+  ~SecureRandomGenerator() {
+    clear();
+#if TD_HAVE_CHACHA20_RANDOM
+    EVP_CIPHER_CTX_free(ctx_);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+    EVP_CIPHER_free(cipher_);
+#endif
+#endif
+  }
+
+  void get_bytes(unsigned char *ptr, size_t size) {
+    if (generation_ != random_seed_generation.load(std::memory_order_relaxed)) {
+      clear();
+    }
+    while (size > 0) {
+      if (buf_pos_ == sizeof(buf_)) {
+        refill();
+      }
+      auto ready = min(size, sizeof(buf_) - buf_pos_);
+      std::memcpy(ptr, buf_ + buf_pos_, ready);
+      std::memset(buf_ + buf_pos_, 0, ready);
+      buf_pos_ += ready;
+      ptr += ready;
+      size -= ready;
+    }
+  }
+
+  void clear() {
+    MutableSlice(buf_, sizeof(buf_)).fill_zero_secure();
+    MutableSlice(key_, sizeof(key_)).fill_zero_secure();
+    buf_pos_ = sizeof(buf_);
+    seed_use_count_ = MAX_SEED_USE_COUNT;
+  }
+
+ private:
+  static constexpr size_t KEY_SIZE = 32;
+  static constexpr size_t BLOCK_SIZE = 4096;
+  static constexpr int32 MAX_SEED_USE_COUNT = 256;
+
+#if TD_HAVE_CHACHA20_RANDOM
+  EVP_CIPHER_CTX *ctx_ = nullptr;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+  EVP_CIPHER *cipher_ = nullptr;
+#else
+  const EVP_CIPHER *cipher_ = nullptr;
+#endif
+#endif
+  unsigned char key_[KEY_SIZE];
+  unsigned char buf_[BLOCK_SIZE];
+  size_t buf_pos_ = BLOCK_SIZE;
+  int32 seed_use_count_ = MAX_SEED_USE_COUNT;
+  int64 generation_ = 0;
+
+  void refill() {
+    if (seed_use_count_ >= MAX_SEED_USE_COUNT) {
+      generation_ = random_seed_generation.load(std::memory_order_acquire);
+      int err = RAND_bytes(key_, static_cast<int>(KEY_SIZE));
+      // TODO: it CAN fail
+      LOG_IF(FATAL, err != 1);
+      seed_use_count_ = 0;
+    }
+    seed_use_count_++;
+
+#if TD_HAVE_CHACHA20_RANDOM
+    unsigned char iv[16] = {};
+    int err = EVP_EncryptInit_ex(ctx_, cipher_, nullptr, key_, iv);
+    LOG_IF(FATAL, err != 1);
+    int len = 0;
+    std::memset(key_, 0, KEY_SIZE);
+    err = EVP_EncryptUpdate(ctx_, key_, &len, key_, static_cast<int>(KEY_SIZE));
+    LOG_IF(FATAL, err != 1 || len != static_cast<int>(KEY_SIZE));
+    std::memset(buf_, 0, BLOCK_SIZE);
+    err = EVP_EncryptUpdate(ctx_, buf_, &len, buf_, static_cast<int>(BLOCK_SIZE));
+    LOG_IF(FATAL, err != 1 || len != static_cast<int>(BLOCK_SIZE));
+#else
+    int err = RAND_bytes(buf_, static_cast<int>(BLOCK_SIZE));
+    LOG_IF(FATAL, err != 1);
+#endif
+    buf_pos_ = 0;
+  }
+};
 }  // namespace
 
 void Random::secure_bytes(MutableSlice dest) {
@@ -31,47 +152,13 @@ void Random::secure_bytes(MutableSlice dest) {
 }
 
 void Random::secure_bytes(unsigned char *ptr, size_t size) {
-  constexpr size_t BUF_SIZE = 512;
-  static TD_THREAD_LOCAL unsigned char *buf;  // static zero-initialized
-  static TD_THREAD_LOCAL size_t buf_pos;
-  static TD_THREAD_LOCAL int64 generation;
-  if (init_thread_local<unsigned char[]>(buf, BUF_SIZE)) {
-    buf_pos = BUF_SIZE;
-    generation = 0;
-  }
+  static TD_THREAD_LOCAL SecureRandomGenerator *generator;  // static zero-initialized
+  init_thread_local<SecureRandomGenerator>(generator);
   if (ptr == nullptr) {
-    MutableSlice(buf, BUF_SIZE).fill_zero_secure();
-    buf_pos = BUF_SIZE;
+    generator->clear();
     return;
   }
-  if (generation != random_seed_generation.load(std::memory_order_relaxed)) {
-    generation = random_seed_generation.load(std::memory_order_acquire);
-    buf_pos = BUF_SIZE;
-  }
-
-  auto ready = min(size, BUF_SIZE - buf_pos);
-  if (ready != 0) {
-    std::memcpy(ptr, buf + buf_pos, ready);
-    buf_pos += ready;
-    ptr += ready;
-    size -= ready;
-    if (size == 0) {
-      return;
-    }
-  }
-  if (size < BUF_SIZE) {
-    int err = RAND_bytes(buf, static_cast<int>(BUF_SIZE));
-    // TODO: it CAN fail
-    LOG_IF(FATAL, err != 1);
-    buf_pos = size;
-    std::memcpy(ptr, buf, size);
-    return;
-  }
-
-  CHECK(size <= static_cast<size_t>(std::numeric_limits<int>::max()));
-  int err = RAND_bytes(ptr, static_cast<int>(size));
-  // TODO: it CAN fail
-  LOG_IF(FATAL, err != 1);
+  generator->get_bytes(ptr, size);
 }
 
 int32 Random::secure_int32() {
@@ -35,6 +35,10 @@ struct SharedSliceHeader {
     return refcnt_.load(std::memory_order_acquire) == 1;
   }
 
+  uint64 use_count() const {
+    return refcnt_.load(std::memory_order_acquire);
+  }
+
   size_t size() const {
     return size_;
   }
@@ -59,6 +63,10 @@ struct UniqueSliceHeader {
     return true;
   }
 
+  uint64 use_count() const {
+    return 1;
+  }
+
   size_t size() const {
     return size_;
   }
@@ -90,6 +98,13 @@ class UnsafeSharedSlice {
     return header()->is_unique();
   }
 
+  uint64 use_count() const {
+    if (is_null()) {
+      return 0;
+    }
+    return header()->use_count();
+  }
+
   MutableSlice as_mutable_slice() {
     if (is_null()) {
       return MutableSlice();
@@ -210,6 +225,11 @@ class SharedSlice {
     return size();
   }
 
+  // returns number of SharedSlice objects, referencing the same data
+  uint64 use_count() const {
+    return impl_.use_count();
+  }
+
   void clear() {
     impl_.clear();
   }
@@ -0,0 +1,195 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/SlabAllocator.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/MpscLinkQueue.h"
+#include "td/utils/port/Mutex.h"
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <atomic>
+#include <new>
+
+namespace td {
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t SIZE_CLASS_STEP = 16;
+constexpr size_t SIZE_CLASS_COUNT = (SlabAllocator::MAX_SIZE + HEADER_SIZE) / SIZE_CLASS_STEP;
+constexpr size_t CHUNK_SIZE = 64 << 10;
+
+static_assert((SlabAllocator::MAX_SIZE + HEADER_SIZE) % SIZE_CLASS_STEP == 0, "");
+
+class SlabPool;
+
+struct BlockHeader {
+  SlabPool *pool;
+  size_t size_class;
+};
+static_assert(sizeof(BlockHeader) <= HEADER_SIZE, "");
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+std::atomic<uint64> allocated_chunk_count{0};
+std::atomic<uint64> pool_count{0};
+
+// pools are never destroyed, because blocks allocated from them can be freed at any moment;
+// pools of finished threads are reused by new threads
+class SlabPool {
+ public:
+  char *allocate(size_t size_class) {
+    auto &free_list = free_lists_[size_class];
+    if (free_list == nullptr) {
+      MpscLinkQueueImpl::Reader reader;
+      remote_free_lists_[size_class].pop_all(reader);
+      while (auto node = reader.read()) {
+        auto block = reinterpret_cast<FreeBlock *>(node);
+        block->next = free_list;
+        free_list = block;
+      }
+    }
+    if (free_list != nullptr) {
+      auto block = free_list;
+      free_list = block->next;
+      return reinterpret_cast<char *>(block);
+    }
+
+    auto block_size = (size_class + 1) * SIZE_CLASS_STEP;
+    if (static_cast<size_t>(chunk_end_ - chunk_pos_) < block_size) {
+      chunk_pos_ = new char[CHUNK_SIZE];
+      chunk_end_ = chunk_pos_ + CHUNK_SIZE;
+      allocated_chunk_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto result = chunk_pos_;
+    chunk_pos_ += block_size;
+    return result;
+  }
+
+  void free_local(char *ptr, size_t size_class) {
+    auto block = reinterpret_cast<FreeBlock *>(ptr);
+    block->next = free_lists_[size_class];
+    free_lists_[size_class] = block;
+  }
+
+  void free_remote(char *ptr, size_t size_class) {
+    remote_free_lists_[size_class].push(new (ptr) MpscLinkQueueImpl::Node());
+  }
+
+ private:
+  std::array<FreeBlock *, SIZE_CLASS_COUNT> free_lists_{};
+  std::array<MpscLinkQueueImpl, SIZE_CLASS_COUNT> remote_free_lists_;
+  char *chunk_pos_ = nullptr;
+  char *chunk_end_ = nullptr;
+};
+
+Mutex free_pools_mutex;
+vector<SlabPool *> free_pools;
+
+SlabPool *acquire_pool() {
+  {
+    auto guard = free_pools_mutex.lock();
+    if (!free_pools.empty()) {
+      auto pool = free_pools.back();
+      free_pools.pop_back();
+      return pool;
+    }
+  }
+  pool_count.fetch_add(1, std::memory_order_relaxed);
+  return new SlabPool();
+}
+
+void release_pool(SlabPool *pool) {
+  auto guard = free_pools_mutex.lock();
+  free_pools.push_back(pool);
+}
+
+class SlabPoolOwner {
+ public:
+  SlabPoolOwner() : pool_(acquire_pool()) {
+  }
+  SlabPoolOwner(const SlabPoolOwner &) = delete;
+  SlabPoolOwner &operator=(const SlabPoolOwner &) = delete;
+  SlabPoolOwner(SlabPoolOwner &&) = delete;
+  SlabPoolOwner &operator=(SlabPoolOwner &&) = delete;
+  ~SlabPoolOwner();
+
+  SlabPool *get() const {
+    return pool_;
+  }
+
+ private:
+  SlabPool *pool_;
+};
+
+TD_THREAD_LOCAL SlabPoolOwner *current_pool_owner;  // static zero-initialized
+TD_THREAD_LOCAL bool is_pool_released;              // static zero-initialized
+
+SlabPoolOwner::~SlabPoolOwner() {
+  // the thread is finishing; new thread local destructors can't be added anymore
+  is_pool_released = true;
+  release_pool(pool_);
+}
+
+SlabPool *get_current_pool() {
+  if (current_pool_owner == nullptr) {
+    if (is_pool_released) {
+      return nullptr;
+    }
+    init_thread_local<SlabPoolOwner>(current_pool_owner);
+  }
+  return current_pool_owner->get();
+}
+
+}  // namespace
+
+void *SlabAllocator::allocate(size_t size) {
+  SlabPool *pool = size <= MAX_SIZE ? get_current_pool() : nullptr;
+  char *ptr;
+  size_t size_class = 0;
+  if (pool == nullptr) {
+    ptr = static_cast<char *>(::operator new(size + HEADER_SIZE));
+  } else {
+    size_class = (size + HEADER_SIZE - 1) / SIZE_CLASS_STEP;
+    ptr = pool->allocate(size_class);
+  }
+  auto header = reinterpret_cast<BlockHeader *>(ptr);
+  header->pool = pool;
+  header->size_class = size_class;
+  return ptr + HEADER_SIZE;
+}
+
+void SlabAllocator::deallocate(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto block = static_cast<char *>(ptr) - HEADER_SIZE;
+  auto header = reinterpret_cast<BlockHeader *>(block);
+  auto pool = header->pool;
+  if (pool == nullptr) {
+    ::operator delete(block);
+    return;
+  }
+  auto size_class = header->size_class;
+  if (current_pool_owner != nullptr && current_pool_owner->get() == pool) {
+    pool->free_local(block, size_class);
+  } else {
+    pool->free_remote(block, size_class);
+  }
+}
+
+SlabAllocator::Stats SlabAllocator::get_stats() {
+  Stats stats;
+  stats.allocated_chunk_count = allocated_chunk_count.load(std::memory_order_relaxed);
+  stats.pool_count = pool_count.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace td
@@ -0,0 +1,31 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// Allocator of small objects, which are often destroyed by another thread than they were created.
+// Each thread allocates from its own size-class pools; memory freed by other threads is returned to the pool
+// of the allocating thread through a lock-free list, so steady-state traffic needs no global allocation.
+class SlabAllocator {
+ public:
+  static constexpr size_t MAX_SIZE = 240;
+
+  static void *allocate(size_t size);
+
+  static void deallocate(void *ptr) noexcept;
+
+  struct Stats {
+    uint64 allocated_chunk_count = 0;
+    uint64 pool_count = 0;
+  };
+  static Stats get_stats();
+};
+
+}  // namespace td
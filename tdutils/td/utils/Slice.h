@@ -7,6 +7,7 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/HashTableUtils.h"
 #include "td/utils/Slice-decl.h"
 
 #include <cstring>
@@ -291,13 +292,7 @@ inline CSlice::CSlice(const char *s, const char *t) : Slice(s, t) {
 }
 
 inline uint32 SliceHash::operator()(Slice slice) const {
-  // simple string hash
-  uint32 result = 0;
-  constexpr uint32 MUL = 123456789;
-  for (auto c : slice) {
-    result = result * MUL + c;
-  }
-  return result;
+  return static_cast<uint32>(hash_bytes(slice.data(), slice.size()));
 }
 
 inline Slice as_slice(Slice slice) {
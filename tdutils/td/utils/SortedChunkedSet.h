@@ -0,0 +1,246 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/optional.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace td {
+
+// ordered set, which stores values in sorted chunks of limited size
+// insertion and deletion move at most MAX_CHUNK_SIZE values and don't allocate memory in most cases
+// unlike std::set, iterators stay usable after the set is changed: they continue from the next greater value
+template <class T, size_t MAX_CHUNK_SIZE = 128>
+class SortedChunkedSet {
+  using Chunk = vector<T>;
+
+ public:
+  class ConstIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    ConstIterator() = default;
+
+    const T &operator*() const {
+      return value_.value();
+    }
+
+    const T *operator->() const {
+      return &value_.value();
+    }
+
+    ConstIterator &operator++() {
+      CHECK(value_);
+      if (generation_ != set_->generation_) {
+        // the set was changed; find the new position of the next value
+        set_->find_upper_bound(value_.value(), chunk_pos_, pos_);
+        generation_ = set_->generation_;
+      } else {
+        pos_++;
+        if (pos_ == set_->chunks_[chunk_pos_].size()) {
+          chunk_pos_++;
+          pos_ = 0;
+        }
+      }
+      update_value();
+      return *this;
+    }
+
+    bool operator==(const ConstIterator &other) const {
+      if (!value_ || !other.value_) {
+        return !value_ && !other.value_;
+      }
+      return !(value_.value() < other.value_.value()) && !(other.value_.value() < value_.value());
+    }
+
+    bool operator!=(const ConstIterator &other) const {
+      return !(*this == other);
+    }
+
+   private:
+    friend class SortedChunkedSet;
+
+    const SortedChunkedSet *set_ = nullptr;
+    size_t chunk_pos_ = 0;
+    size_t pos_ = 0;
+    uint64 generation_ = 0;
+    optional<T> value_;  // empty for the end iterator
+
+    ConstIterator(const SortedChunkedSet *set, size_t chunk_pos, size_t pos)
+        : set_(set), chunk_pos_(chunk_pos), pos_(pos), generation_(set->generation_) {
+      update_value();
+    }
+
+    void update_value() {
+      if (chunk_pos_ < set_->chunks_.size()) {
+        value_ = set_->chunks_[chunk_pos_][pos_];
+      } else {
+        value_ = optional<T>();
+      }
+    }
+  };
+
+  ConstIterator begin() const {
+    return ConstIterator(this, 0, 0);
+  }
+
+  ConstIterator end() const {
+    return ConstIterator();
+  }
+
+  ConstIterator upper_bound(const T &value) const {
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    find_upper_bound(value, chunk_pos, pos);
+    return ConstIterator(this, chunk_pos, pos);
+  }
+
+  ConstIterator lower_bound(const T &value) const {
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    find_lower_bound(value, chunk_pos, pos);
+    return ConstIterator(this, chunk_pos, pos);
+  }
+
+  std::pair<ConstIterator, bool> insert(T value) {
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    find_lower_bound(value, chunk_pos, pos);
+    if (chunk_pos < chunks_.size() && !(value < chunks_[chunk_pos][pos])) {
+      return {ConstIterator(this, chunk_pos, pos), false};
+    }
+
+    generation_++;
+    size_++;
+    if (chunks_.empty()) {
+      chunks_.emplace_back();
+      chunks_[0].reserve(MAX_CHUNK_SIZE + 1);
+    } else if (chunk_pos == chunks_.size() || (pos == 0 && chunk_pos > 0)) {
+      // append the value to the end of the previous chunk instead of the beginning of the next chunk
+      chunk_pos--;
+      pos = chunks_[chunk_pos].size();
+    }
+
+    auto &chunk = chunks_[chunk_pos];
+    chunk.insert(chunk.begin() + pos, std::move(value));
+    if (chunk.size() > MAX_CHUNK_SIZE) {
+      split_chunk(chunk_pos);
+      if (pos >= chunks_[chunk_pos].size()) {
+        pos -= chunks_[chunk_pos].size();
+        chunk_pos++;
+      }
+    }
+    return {ConstIterator(this, chunk_pos, pos), true};
+  }
+
+  size_t erase(const T &value) {
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    find_lower_bound(value, chunk_pos, pos);
+    if (chunk_pos == chunks_.size() || value < chunks_[chunk_pos][pos]) {
+      return 0;
+    }
+
+    generation_++;
+    size_--;
+    auto &chunk = chunks_[chunk_pos];
+    chunk.erase(chunk.begin() + pos);
+    if (chunk.empty()) {
+      chunks_.erase(chunks_.begin() + chunk_pos);
+    } else if (chunk_pos + 1 < chunks_.size() && chunk.size() + chunks_[chunk_pos + 1].size() <= MAX_CHUNK_SIZE / 2) {
+      // merge small neighbour chunks to keep the number of chunks proportional to the number of values
+      auto &next_chunk = chunks_[chunk_pos + 1];
+      chunk.insert(chunk.end(), std::make_move_iterator(next_chunk.begin()), std::make_move_iterator(next_chunk.end()));
+      chunks_.erase(chunks_.begin() + chunk_pos + 1);
+    }
+    return 1;
+  }
+
+  // calls func for all values not less than the given value in order, while func returns true
+  // the set must not be changed by func
+  template <class F>
+  void foreach_from(const T &value, F &&func) const {
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    find_lower_bound(value, chunk_pos, pos);
+    for (; chunk_pos < chunks_.size(); chunk_pos++, pos = 0) {
+      const auto &chunk = chunks_[chunk_pos];
+      for (; pos < chunk.size(); pos++) {
+        if (!func(chunk[pos])) {
+          return;
+        }
+      }
+    }
+  }
+
+  size_t count(const T &value) const {
+    size_t chunk_pos = 0;
+    size_t pos = 0;
+    find_lower_bound(value, chunk_pos, pos);
+    return chunk_pos < chunks_.size() && !(value < chunks_[chunk_pos][pos]) ? 1 : 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    generation_++;
+    size_ = 0;
+    chunks_.clear();
+  }
+
+ private:
+  vector<Chunk> chunks_;  // all chunks are non-empty
+  size_t size_ = 0;
+  uint64 generation_ = 0;  // changed on each modification of the set
+
+  // finds position of the first value, which is not less than the given value
+  void find_lower_bound(const T &value, size_t &chunk_pos, size_t &pos) const {
+    auto chunk_it = std::lower_bound(chunks_.begin(), chunks_.end(), value,
+                                     [](const Chunk &lhs, const T &rhs) { return lhs.back() < rhs; });
+    chunk_pos = static_cast<size_t>(chunk_it - chunks_.begin());
+    pos = chunk_it == chunks_.end()
+              ? 0
+              : static_cast<size_t>(std::lower_bound(chunk_it->begin(), chunk_it->end(), value) - chunk_it->begin());
+  }
+
+  // finds position of the first value, which is greater than the given value
+  void find_upper_bound(const T &value, size_t &chunk_pos, size_t &pos) const {
+    auto chunk_it = std::upper_bound(chunks_.begin(), chunks_.end(), value,
+                                     [](const T &lhs, const Chunk &rhs) { return lhs < rhs.back(); });
+    chunk_pos = static_cast<size_t>(chunk_it - chunks_.begin());
+    pos = chunk_it == chunks_.end()
+              ? 0
+              : static_cast<size_t>(std::upper_bound(chunk_it->begin(), chunk_it->end(), value) - chunk_it->begin());
+  }
+
+  void split_chunk(size_t chunk_pos) {
+    auto &chunk = chunks_[chunk_pos];
+    Chunk new_chunk;
+    new_chunk.reserve(MAX_CHUNK_SIZE + 1);
+    auto split_pos = chunk.size() / 2;
+    new_chunk.insert(new_chunk.end(), std::make_move_iterator(chunk.begin() + split_pos),
+                     std::make_move_iterator(chunk.end()));
+    chunk.erase(chunk.begin() + split_pos, chunk.end());
+    chunks_.insert(chunks_.begin() + chunk_pos + 1, std::move(new_chunk));
+  }
+};
+
+}  // namespace td
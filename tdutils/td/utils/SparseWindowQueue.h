@@ -0,0 +1,325 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/algorithm.h"
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <utility>
+
+namespace td {
+
+// queue of values ordered by their int32 positions, which is optimized for mostly contiguous positions
+// values with positions close to the smallest one are stored in a ring buffer indexed by position and non-empty slots
+// are found using a bitmap, so insertion and removal of the first value don't allocate memory in most cases
+// values with positions too far from the smallest one are kept in a std::map until the window reaches them
+// values with the same position are ordered using LessT
+template <class ValueT, class LessT = std::less<ValueT>>
+class SparseWindowQueue {
+ public:
+  static constexpr size_t MIN_WINDOW_SIZE = 64;
+  static constexpr size_t MAX_WINDOW_SIZE = 1 << 14;
+
+  SparseWindowQueue() = default;
+  SparseWindowQueue(const SparseWindowQueue &) = delete;
+  SparseWindowQueue &operator=(const SparseWindowQueue &) = delete;
+  SparseWindowQueue(SparseWindowQueue &&other) noexcept {
+    *this = std::move(other);
+  }
+  SparseWindowQueue &operator=(SparseWindowQueue &&other) noexcept {
+    slots_ = std::move(other.slots_);
+    is_slot_used_ = std::move(other.is_slot_used_);
+    far_values_ = std::move(other.far_values_);
+    first_slot_ = other.first_slot_;
+    used_slot_count_ = other.used_slot_count_;
+    window_begin_ = other.window_begin_;
+    window_last_ = other.window_last_;
+    size_ = other.size_;
+    other.clear();
+    return *this;
+  }
+  ~SparseWindowQueue() = default;
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  // adds the value after all values with the same position, which aren't greater than it
+  ValueT &insert(int32 position, ValueT value) {
+    auto &values = prepare_insert(position);
+    auto it = std::upper_bound(values.begin(), values.end(), value, LessT());
+    return *values.insert(it, std::move(value));
+  }
+
+  // returns the first value with the position, adding a default-constructed value if there are none
+  ValueT &get_or_create(int32 position) {
+    auto value = find(position);
+    if (value != nullptr) {
+      return *value;
+    }
+    auto &values = prepare_insert(position);
+    values.emplace_back();
+    return values.back();
+  }
+
+  // returns the first value with the position or nullptr
+  ValueT *find(int32 position) {
+    if (size_ == 0) {
+      return nullptr;
+    }
+    if (is_in_window(position)) {
+      auto &values = slots_[get_slot(position)];
+      return values.empty() ? nullptr : &values[0];
+    }
+    auto it = far_values_.find(position);
+    return it == far_values_.end() ? nullptr : &it->second[0];
+  }
+
+  // the queue must be non-empty
+  int32 front_position() const {
+    CHECK(size_ != 0);
+    return window_begin_;
+  }
+
+  // the queue must be non-empty
+  ValueT &front() {
+    CHECK(size_ != 0);
+    return slots_[first_slot_][0];
+  }
+
+  // the queue must be non-empty
+  int32 back_position() const {
+    CHECK(size_ != 0);
+    return far_values_.empty() ? window_last_ : far_values_.rbegin()->first;
+  }
+
+  // the queue must be non-empty
+  void pop_front() {
+    CHECK(size_ != 0);
+    auto &values = slots_[first_slot_];
+    values.erase(values.begin());
+    size_--;
+    if (!values.empty()) {
+      return;
+    }
+
+    set_slot_used(first_slot_, false);
+    used_slot_count_--;
+    if (used_slot_count_ != 0) {
+      auto slot = find_next_used_slot(first_slot_);
+      window_begin_ += static_cast<int32>((slot - first_slot_) & get_slot_mask());
+      first_slot_ = slot;
+    } else if (!far_values_.empty()) {
+      window_begin_ = far_values_.begin()->first;
+      window_last_ = window_begin_;
+    } else {
+      CHECK(size_ == 0);
+      return;
+    }
+    move_far_values_to_window();
+  }
+
+  // calls f(position, value) for at most max_count first values in order
+  template <class F>
+  void foreach_first(size_t max_count, F &&f) {
+    size_t slot = first_slot_;
+    for (size_t i = 0; i < used_slot_count_; i++) {
+      slot = find_next_used_slot(slot);
+      auto position = window_begin_ + static_cast<int32>((slot - first_slot_) & get_slot_mask());
+      for (auto &value : slots_[slot]) {
+        if (max_count-- == 0) {
+          return;
+        }
+        f(position, value);
+      }
+      slot = (slot + 1) & get_slot_mask();
+    }
+    for (auto &it : far_values_) {
+      for (auto &value : it.second) {
+        if (max_count-- == 0) {
+          return;
+        }
+        f(it.first, value);
+      }
+    }
+  }
+
+  // calls f(position, value) for all values in order
+  template <class F>
+  void foreach(F &&f) {
+    foreach_first(size_, std::forward<F>(f));
+  }
+
+  void clear() {
+    if (slots_.size() > 16 * MIN_WINDOW_SIZE) {
+      reset_to_empty(slots_);
+      reset_to_empty(is_slot_used_);
+    } else {
+      for (size_t i = 0; i < is_slot_used_.size(); i++) {
+        for (auto bits = is_slot_used_[i]; bits != 0; bits &= bits - 1) {
+          slots_[i * 64 + count_trailing_zeroes_non_zero64(bits)].clear();
+        }
+        is_slot_used_[i] = 0;
+      }
+    }
+    far_values_.clear();
+    first_slot_ = 0;
+    used_slot_count_ = 0;
+    size_ = 0;
+  }
+
+ private:
+  vector<vector<ValueT>> slots_;  // ring buffer with values for positions starting from window_begin_
+  vector<uint64> is_slot_used_;
+  std::map<int32, vector<ValueT>> far_values_;  // values with positions after the end of the window
+  size_t first_slot_ = 0;                       // slot of window_begin_
+  size_t used_slot_count_ = 0;
+  int32 window_begin_ = 0;  // position of the first value, if the queue isn't empty
+  int32 window_last_ = 0;   // position of the last value in the window, if there are values in the window
+  size_t size_ = 0;
+
+  size_t get_slot_mask() const {
+    return slots_.size() - 1;
+  }
+
+  bool is_in_window(int32 position) const {
+    auto offset = static_cast<int64>(position) - window_begin_;
+    return 0 <= offset && offset < static_cast<int64>(slots_.size());
+  }
+
+  size_t get_slot(int32 position) const {
+    return (first_slot_ + static_cast<size_t>(static_cast<int64>(position) - window_begin_)) & get_slot_mask();
+  }
+
+  void set_slot_used(size_t slot, bool is_used) {
+    if (is_used) {
+      is_slot_used_[slot / 64] |= static_cast<uint64>(1) << (slot % 64);
+    } else {
+      is_slot_used_[slot / 64] &= ~(static_cast<uint64>(1) << (slot % 64));
+    }
+  }
+
+  bool is_slot_used(size_t slot) const {
+    return ((is_slot_used_[slot / 64] >> (slot % 64)) & 1) != 0;
+  }
+
+  // returns the first used slot starting from the given one in the ring order; there must be a used slot
+  size_t find_next_used_slot(size_t slot) const {
+    while (true) {
+      auto bits = is_slot_used_[slot / 64] >> (slot % 64);
+      if (bits != 0) {
+        return slot + count_trailing_zeroes_non_zero64(bits);
+      }
+      slot = ((slot | 63) + 1) & get_slot_mask();
+    }
+  }
+
+  static size_t get_window_size(int64 span) {
+    size_t size = MIN_WINDOW_SIZE;
+    while (static_cast<int64>(size) < span && size < MAX_WINDOW_SIZE) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // moves values to a window of the given size starting from new_window_begin
+  void relayout(int32 new_window_begin, size_t new_size) {
+    vector<vector<ValueT>> new_slots(new_size);
+    vector<uint64> new_is_slot_used(new_size / 64);
+    int32 new_window_last = new_window_begin;
+    size_t new_used_slot_count = 0;
+    for (size_t i = 0; i < is_slot_used_.size(); i++) {
+      for (auto bits = is_slot_used_[i]; bits != 0; bits &= bits - 1) {
+        auto slot = i * 64 + count_trailing_zeroes_non_zero64(bits);
+        auto position = window_begin_ + static_cast<int32>((slot - first_slot_) & get_slot_mask());
+        auto offset = static_cast<int64>(position) - new_window_begin;
+        CHECK(offset >= 0);
+        if (offset < static_cast<int64>(new_size)) {
+          auto new_slot = static_cast<size_t>(offset);
+          new_slots[new_slot] = std::move(slots_[slot]);
+          new_is_slot_used[new_slot / 64] |= static_cast<uint64>(1) << (new_slot % 64);
+          new_used_slot_count++;
+          new_window_last = max(new_window_last, position);
+        } else {
+          far_values_.emplace(position, std::move(slots_[slot]));
+        }
+      }
+    }
+    slots_ = std::move(new_slots);
+    is_slot_used_ = std::move(new_is_slot_used);
+    first_slot_ = 0;
+    used_slot_count_ = new_used_slot_count;
+    window_begin_ = new_window_begin;
+    window_last_ = new_window_last;
+    move_far_values_to_window();
+  }
+
+  void move_far_values_to_window() {
+    while (!far_values_.empty()) {
+      auto it = far_values_.begin();
+      if (!is_in_window(it->first)) {
+        break;
+      }
+      auto slot = get_slot(it->first);
+      CHECK(!is_slot_used(slot));
+      slots_[slot] = std::move(it->second);
+      set_slot_used(slot, true);
+      used_slot_count_++;
+      window_last_ = max(window_last_, it->first);
+      far_values_.erase(it);
+    }
+  }
+
+  // returns values with the position, to which a new value must be added
+  vector<ValueT> &prepare_insert(int32 position) {
+    if (slots_.empty()) {
+      slots_.resize(MIN_WINDOW_SIZE);
+      is_slot_used_.resize(MIN_WINDOW_SIZE / 64);
+    }
+    if (size_ == 0) {
+      window_begin_ = position;
+      window_last_ = position;
+    } else if (position < window_begin_) {
+      auto span = static_cast<int64>(window_last_) - position + 1;
+      if (span <= static_cast<int64>(slots_.size())) {
+        first_slot_ = (first_slot_ - static_cast<size_t>(static_cast<int64>(window_begin_) - position)) &
+                      get_slot_mask();
+        window_begin_ = position;
+      } else {
+        relayout(position, get_window_size(span));
+      }
+    } else if (!is_in_window(position)) {
+      auto span = static_cast<int64>(position) - window_begin_ + 1;
+      if (span <= static_cast<int64>(MAX_WINDOW_SIZE)) {
+        relayout(window_begin_, get_window_size(span));
+      }
+    }
+
+    size_++;
+    if (!is_in_window(position)) {
+      return far_values_[position];
+    }
+    auto slot = get_slot(position);
+    if (!is_slot_used(slot)) {
+      set_slot_used(slot, true);
+      used_slot_count_++;
+      window_last_ = max(window_last_, position);
+    }
+    return slots_[slot];
+  }
+};
+
+}  // namespace td
@@ -193,6 +193,13 @@ class Status {
   }
 #endif
 
+  // creates an error, which is never destroyed and whose copies created by clone() share the same memory
+  // the error is expected to be created once and stored in a static variable, so that returning its clone
+  // doesn't allocate memory
+  static Status StaticError(int err, Slice message) TD_WARN_UNUSED_RESULT {
+    return Status(true, ErrorType::General, err, message);
+  }
+
   template <int Code>
   static Status Error() {
     static Status status(true, ErrorType::General, Code, "");
@@ -0,0 +1,57 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/StringPool.h"
+
+#include "td/utils/algorithm.h"
+
+namespace td {
+
+constexpr size_t StringPool::MIN_CLEAN_SIZE;
+
+SharedSlice StringPool::intern(Slice str) {
+  if (str.empty()) {
+    return SharedSlice();
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = strings_.find(str);
+  if (it != strings_.end()) {
+    return it->second.clone();
+  }
+
+  if (strings_.size() >= clean_size_) {
+    remove_unused_strings();
+  }
+
+  SharedSlice result(str);
+  strings_.emplace(result.as_slice(), result.clone());
+  return result;
+}
+
+void StringPool::remove_unused_strings() {
+  // the strings are referenced only by the pool; nobody else can clone them without holding the mutex
+  table_remove_if(strings_, [](const auto &it) { return it.second.use_count() == 1; });
+  clean_size_ = max(strings_.size() * 2, MIN_CLEAN_SIZE);
+}
+
+StringPool::Stats StringPool::get_stats() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  Stats stats;
+  for (auto &it : strings_) {
+    auto use_count = it.second.use_count() - 1;
+    if (use_count == 0) {
+      continue;
+    }
+    stats.string_count++;
+    stats.total_size += it.second.size();
+    stats.reference_count += use_count;
+    stats.saved_size += (use_count - 1) * it.second.size();
+  }
+  return stats;
+}
+
+}  // namespace td
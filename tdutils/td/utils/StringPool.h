@@ -0,0 +1,44 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/SharedSlice.h"
+#include "td/utils/Slice.h"
+
+#include <mutex>
+
+namespace td {
+
+// thread-safe pool of immutable strings, which allows to keep a single copy of frequently repeated strings
+// a string is freed after the last SharedSlice referencing it outside of the pool is destroyed
+class StringPool {
+ public:
+  struct Stats {
+    size_t string_count = 0;
+    size_t total_size = 0;
+    uint64 reference_count = 0;
+    uint64 saved_size = 0;  // total size of the strings, which would be duplicated without the pool
+  };
+
+  // returns a shared copy of the string
+  SharedSlice intern(Slice str);
+
+  Stats get_stats() const;
+
+ private:
+  static constexpr size_t MIN_CLEAN_SIZE = 64;
+
+  mutable std::mutex mutex_;
+  FlatHashMap<Slice, SharedSlice, SliceHash> strings_;  // keys point to the data of the values
+  size_t clean_size_ = MIN_CLEAN_SIZE;
+
+  void remove_unused_strings();
+};
+
+}  // namespace td
@@ -0,0 +1,236 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/TimerWheel.h"
+
+#include "td/utils/bits.h"
+
+#include <limits>
+
+namespace td {
+
+int64 TimerWheel::get_tick(double key) {
+  if (!(key > 0)) {
+    return 0;
+  }
+  if (key > 1e15) {
+    key = 1e15;
+  }
+  return static_cast<int64>(key * TICKS_PER_SECOND);
+}
+
+int32 TimerWheel::get_slot(int64 tick) const {
+  if (tick < current_tick_) {
+    tick = current_tick_;
+  }
+  auto delta = static_cast<uint64>(tick - current_tick_);
+  for (int32 level = 0; level + 1 < LEVEL_COUNT; level++) {
+    if (delta < (static_cast<uint64>(1) << (SLOT_BITS * (level + 1)))) {
+      return level * SLOT_COUNT + static_cast<int32>((tick >> (SLOT_BITS * level)) & SLOT_MASK);
+    }
+  }
+
+  // too distant timers are put to the farthest slot and will be cascaded to it again
+  auto max_delta = (static_cast<uint64>(1) << (SLOT_BITS * LEVEL_COUNT)) - 1;
+  if (delta > max_delta) {
+    tick = current_tick_ + static_cast<int64>(max_delta);
+  }
+  return (LEVEL_COUNT - 1) * SLOT_COUNT +
+         static_cast<int32>((tick >> (SLOT_BITS * (LEVEL_COUNT - 1))) & SLOT_MASK);
+}
+
+void TimerWheel::link(TimerWheelNode *node, int32 slot) {
+  auto &head = slots_[slot];
+  node->prev_ = nullptr;
+  node->next_ = head;
+  if (head != nullptr) {
+    head->prev_ = node;
+  } else if (slot != EXPIRED_SLOT) {
+    non_empty_slots_[slot / SLOT_COUNT][(slot & SLOT_MASK) / 64] |= static_cast<uint64>(1) << (slot & 63);
+  }
+  head = node;
+  node->slot_ = slot;
+}
+
+void TimerWheel::unlink(TimerWheelNode *node) {
+  auto slot = node->slot_;
+  if (node->prev_ != nullptr) {
+    node->prev_->next_ = node->next_;
+  } else {
+    slots_[slot] = node->next_;
+    if (node->next_ == nullptr && slot != EXPIRED_SLOT) {
+      non_empty_slots_[slot / SLOT_COUNT][(slot & SLOT_MASK) / 64] &= ~(static_cast<uint64>(1) << (slot & 63));
+    }
+  }
+  if (node->next_ != nullptr) {
+    node->next_->prev_ = node->prev_;
+  }
+  node->prev_ = nullptr;
+  node->next_ = nullptr;
+  node->slot_ = -1;
+}
+
+TimerWheelNode *TimerWheel::detach_slot(int32 slot) {
+  auto head = slots_[slot];
+  if (head != nullptr) {
+    slots_[slot] = nullptr;
+    non_empty_slots_[slot / SLOT_COUNT][(slot & SLOT_MASK) / 64] &= ~(static_cast<uint64>(1) << (slot & 63));
+  }
+  return head;
+}
+
+void TimerWheel::insert(double key, TimerWheelNode *node) {
+  CHECK(!node->in_timer_wheel());
+  if (slots_.empty()) {
+    slots_.resize(EXPIRED_SLOT + 1, nullptr);
+  }
+  auto tick = get_tick(key);
+  node->key_ = key;
+  node->tick_ = tick;
+  link(node, get_slot(tick));
+  size_++;
+}
+
+void TimerWheel::fix(double key, TimerWheelNode *node) {
+  CHECK(node->in_timer_wheel());
+  auto tick = get_tick(key);
+  auto slot = get_slot(tick);
+  node->key_ = key;
+  node->tick_ = tick;
+  if (slot != node->slot_) {
+    unlink(node);
+    link(node, slot);
+  }
+}
+
+void TimerWheel::erase(TimerWheelNode *node) {
+  CHECK(node->in_timer_wheel());
+  unlink(node);
+  size_--;
+}
+
+TimerWheelNode *TimerWheel::pop_expired() {
+  if (slots_.empty()) {
+    return nullptr;
+  }
+  auto node = slots_[EXPIRED_SLOT];
+  if (node != nullptr) {
+    unlink(node);
+    size_--;
+  }
+  return node;
+}
+
+// returns the minimum distance d such that the slot (start + d) % SLOT_COUNT isn't empty, or -1 if all slots are empty
+int32 TimerWheel::find_next_slot(int32 level, int32 start) const {
+  const uint64 *bitmap = non_empty_slots_[level];
+  for (int32 i = 0; i <= BITMAP_SIZE; i++) {
+    auto word = ((start / 64) + i) % BITMAP_SIZE;
+    auto bits = bitmap[word];
+    if (i == 0) {
+      bits &= ~static_cast<uint64>(0) << (start & 63);
+    } else if (i == BITMAP_SIZE) {
+      bits &= (static_cast<uint64>(1) << (start & 63)) - 1;
+    }
+    if (bits != 0) {
+      auto slot = word * 64 + count_trailing_zeroes64(bits);
+      return (slot - start) & SLOT_MASK;
+    }
+  }
+  return -1;
+}
+
+// returns the first tick after current_tick_ at which a level 0 slot must be expired or a higher level slot must be cascaded
+int64 TimerWheel::get_next_event_tick() const {
+  auto result = std::numeric_limits<int64>::max();
+  auto distance = find_next_slot(0, static_cast<int32>(current_tick_ & SLOT_MASK));
+  if (distance != -1) {
+    result = current_tick_ + distance;
+  }
+  for (int32 level = 1; level < LEVEL_COUNT; level++) {
+    auto shift = SLOT_BITS * level;
+    auto block = current_tick_ >> shift;
+    // the current slot of the level has already been cascaded, so it contains timers for the next round
+    distance = find_next_slot(level, static_cast<int32>((block + 1) & SLOT_MASK));
+    if (distance != -1) {
+      result = min(result, (block + distance + 1) << shift);
+    }
+  }
+  return result;
+}
+
+void TimerWheel::cascade() {
+  for (int32 level = LEVEL_COUNT - 1; level > 0; level--) {
+    auto shift = SLOT_BITS * level;
+    if ((current_tick_ & ((static_cast<int64>(1) << shift) - 1)) != 0) {
+      continue;
+    }
+    auto node = detach_slot(level * SLOT_COUNT + static_cast<int32>((current_tick_ >> shift) & SLOT_MASK));
+    while (node != nullptr) {
+      auto next = node->next_;
+      link(node, get_slot(node->tick_));
+      node = next;
+    }
+  }
+}
+
+void TimerWheel::advance(double now) {
+  auto now_tick = get_tick(now);
+  if (size_ == 0) {
+    current_tick_ = max(current_tick_, now_tick);
+    return;
+  }
+
+  while (current_tick_ < now_tick) {
+    auto node = detach_slot(static_cast<int32>(current_tick_ & SLOT_MASK));
+    while (node != nullptr) {
+      auto next = node->next_;
+      link(node, EXPIRED_SLOT);
+      node = next;
+    }
+
+    // empty ticks are skipped
+    current_tick_ = min(get_next_event_tick(), now_tick);
+    cascade();
+  }
+
+  // the current tick has only partially passed
+  auto node = slots_[current_tick_ & SLOT_MASK];
+  while (node != nullptr) {
+    auto next = node->next_;
+    if (node->key_ < now) {
+      unlink(node);
+      link(node, EXPIRED_SLOT);
+    }
+    node = next;
+  }
+}
+
+double TimerWheel::get_wakeup_time() const {
+  CHECK(!empty());
+  if (slots_[EXPIRED_SLOT] != nullptr) {
+    return 0.0;
+  }
+
+  auto result = std::numeric_limits<double>::max();
+  auto distance = find_next_slot(0, static_cast<int32>(current_tick_ & SLOT_MASK));
+  if (distance != -1) {
+    for (auto node = slots_[(current_tick_ + distance) & SLOT_MASK]; node != nullptr; node = node->next_) {
+      result = min(result, node->key_);
+    }
+  }
+  for (int32 level = 1; level < LEVEL_COUNT; level++) {
+    auto shift = SLOT_BITS * level;
+    auto block = current_tick_ >> shift;
+    distance = find_next_slot(level, static_cast<int32>((block + 1) & SLOT_MASK));
+    if (distance != -1) {
+      result = min(result, static_cast<double>((block + distance + 1) << shift) / TICKS_PER_SECOND);
+    }
+  }
+  return result;
+}
+
+}  // namespace td
@@ -0,0 +1,95 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+class TimerWheelNode {
+ public:
+  bool in_timer_wheel() const {
+    return slot_ != -1;
+  }
+
+ private:
+  friend class TimerWheel;
+
+  TimerWheelNode *prev_ = nullptr;
+  TimerWheelNode *next_ = nullptr;
+  double key_ = 0.0;
+  int64 tick_ = 0;
+  int32 slot_ = -1;
+};
+
+// hierarchical timing wheel with O(1) insert, change and erase of a timer
+// timers are grouped into 1 millisecond ticks, but are never returned before their key has passed
+// advance must be called regularly with the current time, because timers are placed relative to the last call
+class TimerWheel {
+ public:
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+  double get_key(const TimerWheelNode *node) const {
+    CHECK(node->in_timer_wheel());
+    return node->key_;
+  }
+
+  void insert(double key, TimerWheelNode *node);
+
+  void fix(double key, TimerWheelNode *node);
+
+  void erase(TimerWheelNode *node);
+
+  // returns a time not later than the smallest key in the wheel
+  // the time is exact if the first timer expires in less than 256 ticks
+  double get_wakeup_time() const;
+
+  // makes all timers with key less than now expired
+  void advance(double now);
+
+  // removes and returns the next expired timer, or returns nullptr if there are none
+  TimerWheelNode *pop_expired();
+
+ private:
+  static constexpr int32 SLOT_BITS = 8;
+  static constexpr int32 SLOT_COUNT = 1 << SLOT_BITS;
+  static constexpr int32 SLOT_MASK = SLOT_COUNT - 1;
+  static constexpr int32 LEVEL_COUNT = 4;
+  static constexpr int32 EXPIRED_SLOT = SLOT_COUNT * LEVEL_COUNT;
+  static constexpr int32 BITMAP_SIZE = SLOT_COUNT / 64;
+  static constexpr double TICKS_PER_SECOND = 1000.0;
+
+  // list heads for all slots of all levels and for the expired timers; allocated on the first insert
+  vector<TimerWheelNode *> slots_;
+  uint64 non_empty_slots_[LEVEL_COUNT][BITMAP_SIZE] = {};
+  // all timers in the wheel have tick_ >= current_tick_
+  int64 current_tick_ = 0;
+  size_t size_ = 0;
+
+  static int64 get_tick(double key);
+
+  int32 get_slot(int64 tick) const;
+
+  void link(TimerWheelNode *node, int32 slot);
+
+  void unlink(TimerWheelNode *node);
+
+  TimerWheelNode *detach_slot(int32 slot);
+
+  int32 find_next_slot(int32 level, int32 start) const;
+
+  int64 get_next_event_tick() const;
+
+  void cascade();
+};
+
+}  // namespace td
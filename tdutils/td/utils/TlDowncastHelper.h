@@ -21,6 +21,9 @@ class TlDowncastHelper final : public T {
   }
   void store(TlStorerToString &s, const char *field_name) const final {
   }
+  std::size_t approximate_memory_usage() const final {
+    return sizeof(*this);
+  }
 
  private:
   int32 constructor_{0};
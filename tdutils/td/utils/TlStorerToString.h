@@ -52,6 +52,10 @@ class TlStorerToString {
   TlStorerToString &operator=(TlStorerToString &&) = delete;
 
   void store_field(Slice name, const string &value) {
+    store_string_field(name, value);
+  }
+
+  void store_string_field(Slice name, Slice value) {
     store_field_begin(name);
     sb_.push_back('"');
     sb_ << value;
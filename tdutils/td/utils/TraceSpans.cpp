@@ -0,0 +1,174 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/TraceSpans.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/port/Mutex.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace td {
+
+std::atomic<bool> TraceSpans::is_enabled_{false};
+TD_THREAD_LOCAL uint64 TraceSpans::current_trace_id_;
+
+namespace {
+
+struct ThreadTraceSpans {
+  Mutex mutex;
+  vector<TraceSpans::Span> spans;
+  size_t next_pos = 0;
+};
+
+}  // namespace
+
+static Mutex trace_spans_mutex;
+
+static std::atomic<uint64> next_trace_id{0};
+
+static vector<unique_ptr<ThreadTraceSpans>> &get_all_thread_trace_spans() {
+  static vector<unique_ptr<ThreadTraceSpans>> all_thread_spans;
+  return all_thread_spans;
+}
+
+static TD_THREAD_LOCAL ThreadTraceSpans *thread_trace_spans;
+
+static ThreadTraceSpans *get_thread_trace_spans() {
+  if (unlikely(thread_trace_spans == nullptr)) {
+    auto lock = trace_spans_mutex.lock();
+    // ring buffers are never deleted to keep spans of finished threads, and the number of threads is small
+    auto &all_thread_spans = get_all_thread_trace_spans();
+    all_thread_spans.push_back(make_unique<ThreadTraceSpans>());
+    thread_trace_spans = all_thread_spans.back().get();
+  }
+  return thread_trace_spans;
+}
+
+void TraceSpans::set_enabled(bool is_enabled) {
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+uint64 TraceSpans::create_trace_id() {
+  if (!is_enabled()) {
+    return 0;
+  }
+  return next_trace_id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void TraceSpans::set_span_name(Span &span, Slice name) {
+  auto size = min(name.size(), sizeof(span.name) - 1);
+  std::memcpy(span.name, name.data(), size);
+  span.name[size] = '\0';
+}
+
+void TraceSpans::add_span(uint64 trace_id, Slice name, double begin_time, double end_time) {
+  if (trace_id == 0) {
+    return;
+  }
+  Span span;
+  span.trace_id = trace_id;
+  set_span_name(span, name);
+  span.begin_time = begin_time;
+  span.end_time = end_time;
+  add_span(span);
+}
+
+void TraceSpans::add_span(Span span) {
+  span.thread_id = get_thread_id();
+  auto thread_spans = get_thread_trace_spans();
+  auto lock = thread_spans->mutex.lock();
+  if (thread_spans->spans.size() < MAX_THREAD_SPAN_COUNT) {
+    thread_spans->spans.push_back(span);
+  } else {
+    thread_spans->spans[thread_spans->next_pos] = span;
+    thread_spans->next_pos = (thread_spans->next_pos + 1) % MAX_THREAD_SPAN_COUNT;
+  }
+}
+
+vector<TraceSpans::Span> TraceSpans::get_spans() {
+  vector<Span> result;
+  {
+    auto lock = trace_spans_mutex.lock();
+    for (auto &thread_spans : get_all_thread_trace_spans()) {
+      auto thread_lock = thread_spans->mutex.lock();
+      append(result, thread_spans->spans);
+    }
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](const Span &lhs, const Span &rhs) { return lhs.begin_time < rhs.begin_time; });
+  return result;
+}
+
+string TraceSpans::get_chrome_trace() {
+  auto spans = get_spans();
+
+  // spans of the same trace are connected with flow events to show causality between threads
+  FlatHashMap<uint64, size_t> last_span_pos;
+  for (size_t i = 0; i < spans.size(); i++) {
+    last_span_pos[spans[i].trace_id] = i;
+  }
+  FlatHashMap<uint64, bool> is_trace_started;
+
+  auto to_us = [](double time) {
+    return static_cast<int64>(time * 1e6);
+  };
+  return json_encode<string>(json_object([&](auto &o) {
+    o("displayTimeUnit", "ms");
+    o("traceEvents", json_array([&](auto &events) {
+        for (size_t i = 0; i < spans.size(); i++) {
+          const auto &span = spans[i];
+          auto begin_time = to_us(span.begin_time);
+          auto trace_id = static_cast<int64>(span.trace_id);
+          events(json_object([&](auto &event) {
+            event("name", Slice(span.name, std::strlen(span.name)));
+            event("cat", "td");
+            event("ph", "X");
+            event("ts", begin_time);
+            event("dur", max(to_us(span.end_time) - begin_time, static_cast<int64>(0)));
+            event("pid", 1);
+            event("tid", span.thread_id);
+            event("args", json_object([&](auto &args) { args("trace_id", trace_id); }));
+          }));
+
+          auto &is_started = is_trace_started[span.trace_id];
+          bool is_first = !is_started;
+          bool is_last = last_span_pos[span.trace_id] == i;
+          is_started = true;
+          if (is_first && is_last) {
+            // the trace has only one span
+            continue;
+          }
+          events(json_object([&](auto &event) {
+            event("name", "request");
+            event("cat", "td");
+            event("ph", is_first ? "s" : (is_last ? "f" : "t"));
+            if (is_last) {
+              event("bp", "e");
+            }
+            event("id", trace_id);
+            event("ts", begin_time);
+            event("pid", 1);
+            event("tid", span.thread_id);
+          }));
+        }
+      }));
+  }));
+}
+
+void TraceSpans::clear() {
+  auto lock = trace_spans_mutex.lock();
+  for (auto &thread_spans : get_all_thread_trace_spans()) {
+    auto thread_lock = thread_spans->mutex.lock();
+    thread_spans->spans.clear();
+    thread_spans->next_pos = 0;
+  }
+}
+
+}  // namespace td
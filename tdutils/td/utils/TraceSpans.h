@@ -0,0 +1,105 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+
+namespace td {
+
+// Optional tracing of request processing. Spans are grouped by a trace identifier, which is propagated
+// through the current thread state and must be forwarded explicitly between threads.
+// Spans are stored in a per-thread ring buffer, so only the last spans of each thread are kept.
+class TraceSpans {
+ public:
+  struct Span {
+    uint64 trace_id = 0;
+    double begin_time = 0.0;
+    double end_time = 0.0;
+    int32 thread_id = 0;
+    char name[44] = {};
+  };
+
+  static constexpr size_t MAX_THREAD_SPAN_COUNT = 1 << 14;
+
+  static void set_enabled(bool is_enabled);
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // returns 0 if tracing is disabled
+  static uint64 create_trace_id();
+
+  static uint64 get_current_trace_id() {
+    return current_trace_id_;
+  }
+
+  static void set_current_trace_id(uint64 trace_id) {
+    current_trace_id_ = trace_id;
+  }
+
+  static void add_span(uint64 trace_id, Slice name, double begin_time, double end_time);
+
+  static void add_span(Span span);
+
+  // the name is truncated if it is too long
+  static void set_span_name(Span &span, Slice name);
+
+  // returns recorded spans of all threads ordered by begin time
+  static vector<Span> get_spans();
+
+  // returns recorded spans in Chrome trace event format, which can be opened in chrome://tracing or Perfetto
+  static string get_chrome_trace();
+
+  static void clear();
+
+ private:
+  static std::atomic<bool> is_enabled_;
+  static TD_THREAD_LOCAL uint64 current_trace_id_;
+};
+
+// makes the trace current for the lifetime of the object and records it as a span if the trace is non-empty
+class TraceSpan {
+ public:
+  TraceSpan(uint64 trace_id, Slice name) : old_trace_id_(TraceSpans::get_current_trace_id()) {
+    TraceSpans::set_current_trace_id(trace_id);
+    if (trace_id != 0) {
+      // the name is copied, because it can be destroyed before the span ends
+      span_.trace_id = trace_id;
+      TraceSpans::set_span_name(span_, name);
+      span_.begin_time = Time::now();
+    }
+  }
+
+  // continues the current trace
+  explicit TraceSpan(Slice name) : TraceSpan(TraceSpans::get_current_trace_id(), name) {
+  }
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+  TraceSpan(TraceSpan &&) = delete;
+  TraceSpan &operator=(TraceSpan &&) = delete;
+
+  ~TraceSpan() {
+    if (span_.trace_id != 0) {
+      span_.end_time = Time::now();
+      TraceSpans::add_span(span_);
+    }
+    TraceSpans::set_current_trace_id(old_trace_id_);
+  }
+
+ private:
+  uint64 old_trace_id_ = 0;
+  TraceSpans::Span span_;
+};
+
+}  // namespace td
@@ -43,6 +43,10 @@ class VectorQueue {
     try_shrink();
   }
 
+  void pop_back() {
+    vector_.pop_back();
+  }
+
   const T &front() const {
     return vector_[read_pos_];
   }
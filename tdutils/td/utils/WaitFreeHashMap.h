@@ -173,6 +173,22 @@ class WaitFreeHashMap {
     return result;
   }
 
+  HashTableMemoryUsage memory_usage() const {
+    auto result = default_map_.memory_usage();
+    if (wait_free_storage_ == nullptr) {
+      return result;
+    }
+
+    HashTableMemoryUsage storage_usage;
+    for (size_t i = 0; i < MAX_STORAGE_COUNT; i++) {
+      storage_usage += wait_free_storage_->maps_[i].memory_usage();
+    }
+    storage_usage.memory += sizeof(WaitFreeStorage);
+    storage_usage.level_count++;
+    result += storage_usage;
+    return result;
+  }
+
   bool empty() const {
     if (wait_free_storage_ == nullptr) {
       return default_map_.empty();
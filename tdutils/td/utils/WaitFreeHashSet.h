@@ -125,6 +125,22 @@ class WaitFreeHashSet {
     return result;
   }
 
+  HashTableMemoryUsage memory_usage() const {
+    auto result = default_set_.memory_usage();
+    if (wait_free_storage_ == nullptr) {
+      return result;
+    }
+
+    HashTableMemoryUsage storage_usage;
+    for (size_t i = 0; i < MAX_STORAGE_COUNT; i++) {
+      storage_usage += wait_free_storage_->sets_[i].memory_usage();
+    }
+    storage_usage.memory += sizeof(WaitFreeStorage);
+    storage_usage.level_count++;
+    result += storage_usage;
+    return result;
+  }
+
   bool empty() const {
     if (wait_free_storage_ == nullptr) {
       return default_set_.empty();
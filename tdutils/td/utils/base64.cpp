@@ -11,8 +11,14 @@
 #include "td/utils/Status.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 
+#if (TD_GCC || TD_CLANG) && (defined(__x86_64__) || defined(__i386__))
+#define TD_HAVE_BASE64_SIMD 1
+#include <immintrin.h>
+#endif
+
 namespace td {
 
 template <bool is_url>
@@ -36,12 +42,204 @@ static const unsigned char *get_character_table() {
   return char_to_value;
 }
 
+#if TD_HAVE_BASE64_SIMD
+// the SIMD code converts 12 bytes to 16 characters and back in each 128-bit lane, using the algorithms by Wojciech Mula
+// all input is processed by the scalar code after the first invalid character, so errors are the same
+
+static bool have_base64_ssse3() {
+  static const bool result = __builtin_cpu_supports("ssse3");
+  return result;
+}
+
+static bool have_base64_avx2() {
+  static const bool result = __builtin_cpu_supports("avx2");
+  return result;
+}
+
+template <bool is_url>
+__attribute__((target("ssse3"))) static __m128i base64_encode_lane_ssse3(__m128i input) {
+  // split 3 bytes of each 32-bit word to 4 6-bit indices
+  input = _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  auto t0 = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+  auto t1 = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+  auto indices = _mm_or_si128(t0, t1);
+
+  // convert indices to characters by adding an offset chosen by the range of the index
+  auto ranges = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  auto is_upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  ranges = _mm_or_si128(ranges, _mm_and_si128(is_upper, _mm_set1_epi8(13)));
+  auto offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                               '0' - 52, '0' - 52, static_cast<char>((is_url ? '-' : '+') - 62),
+                               static_cast<char>((is_url ? '_' : '/') - 63), 'A', 0, 0);
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, ranges));
+}
+
+template <bool is_url>
+__attribute__((target("avx2"))) static __m256i base64_encode_lanes_avx2(__m256i input) {
+  auto shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  input = _mm256_shuffle_epi8(input, _mm256_broadcastsi128_si256(shuffle));
+  auto t0 = _mm256_mulhi_epu16(_mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+  auto t1 = _mm256_mullo_epi16(_mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+  auto indices = _mm256_or_si256(t0, t1);
+
+  auto ranges = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+  auto is_upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+  ranges = _mm256_or_si256(ranges, _mm256_and_si256(is_upper, _mm256_set1_epi8(13)));
+  auto offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                               '0' - 52, '0' - 52, static_cast<char>((is_url ? '-' : '+') - 62),
+                               static_cast<char>((is_url ? '_' : '/') - 63), 'A', 0, 0);
+  return _mm256_add_epi8(indices, _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(offsets), ranges));
+}
+
+template <bool is_url>
+__attribute__((target("ssse3"))) static void base64_encode_block_ssse3(const unsigned char *input, char *output) {
+  auto result = base64_encode_lane_ssse3<is_url>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(output), result);
+}
+
+template <bool is_url>
+__attribute__((target("avx2"))) static void base64_encode_blocks_avx2(const unsigned char *input, char *output) {
+  auto low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+  auto high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + 12));
+  auto result = base64_encode_lanes_avx2<is_url>(_mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1));
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), result);
+}
+
+// appends encoded prefix of the input to base64 and returns length of the encoded prefix
+template <bool is_url>
+static size_t base64_encode_simd(Slice input, string &base64) {
+  // each block reads 16 bytes and encodes the first 12 of them
+  if (input.size() < 16 || !have_base64_ssse3()) {
+    return 0;
+  }
+  size_t block_count = (input.size() - 4) / 12;
+  base64.resize(block_count * 16);
+  auto *in = input.ubegin();
+  auto *out = &base64[0];
+  size_t block = 0;
+  if (have_base64_avx2()) {
+    for (; block + 2 <= block_count; block += 2) {
+      base64_encode_blocks_avx2<is_url>(in + block * 12, out + block * 16);
+    }
+  }
+  for (; block < block_count; block++) {
+    base64_encode_block_ssse3<is_url>(in + block * 12, out + block * 16);
+  }
+  return block_count * 12;
+}
+
+__attribute__((target("ssse3"))) static __m128i base64_in_range_ssse3(__m128i c, char from, char to) {
+  // characters with the high bit set are negative, so they never belong to a range
+  return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(static_cast<char>(from - 1))),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(to + 1)), c));
+}
+
+__attribute__((target("avx2"))) static __m256i base64_in_range_avx2(__m256i c, char from, char to) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(static_cast<char>(from - 1))),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(to + 1)), c));
+}
+
+template <bool is_url>
+__attribute__((target("ssse3"))) static bool base64_decode_block_ssse3(const unsigned char *input, char *output) {
+  const char char62 = is_url ? '-' : '+';
+  const char char63 = is_url ? '_' : '/';
+  auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+  auto is_upper = base64_in_range_ssse3(c, 'A', 'Z');
+  auto is_lower = base64_in_range_ssse3(c, 'a', 'z');
+  auto is_digit = base64_in_range_ssse3(c, '0', '9');
+  auto is_62 = _mm_cmpeq_epi8(c, _mm_set1_epi8(char62));
+  auto is_63 = _mm_cmpeq_epi8(c, _mm_set1_epi8(char63));
+  auto is_valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(is_upper, is_lower), _mm_or_si128(is_digit, is_62)), is_63);
+  if (_mm_movemask_epi8(is_valid) != 0xFFFF) {
+    return false;
+  }
+
+  auto offsets = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(is_upper, _mm_set1_epi8(-'A')), _mm_and_si128(is_lower, _mm_set1_epi8(26 - 'a'))),
+      _mm_or_si128(_mm_and_si128(is_digit, _mm_set1_epi8(52 - '0')),
+                   _mm_or_si128(_mm_and_si128(is_62, _mm_set1_epi8(static_cast<char>(62 - char62))),
+                                _mm_and_si128(is_63, _mm_set1_epi8(static_cast<char>(63 - char63))))));
+  auto values = _mm_add_epi8(c, offsets);
+
+  // merge 4 6-bit values to 3 bytes in each 32-bit word
+  auto merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+  auto result = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  alignas(16) char buf[16];
+  _mm_store_si128(reinterpret_cast<__m128i *>(buf), result);
+  std::memcpy(output, buf, 12);
+  return true;
+}
+
+template <bool is_url>
+__attribute__((target("avx2"))) static bool base64_decode_blocks_avx2(const unsigned char *input, char *output) {
+  const char char62 = is_url ? '-' : '+';
+  const char char63 = is_url ? '_' : '/';
+  auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input));
+  auto is_upper = base64_in_range_avx2(c, 'A', 'Z');
+  auto is_lower = base64_in_range_avx2(c, 'a', 'z');
+  auto is_digit = base64_in_range_avx2(c, '0', '9');
+  auto is_62 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(char62));
+  auto is_63 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(char63));
+  auto is_valid =
+      _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(is_upper, is_lower), _mm256_or_si256(is_digit, is_62)), is_63);
+  if (_mm256_movemask_epi8(is_valid) != -1) {
+    return false;
+  }
+
+  auto offsets = _mm256_or_si256(
+      _mm256_or_si256(_mm256_and_si256(is_upper, _mm256_set1_epi8(-'A')),
+                      _mm256_and_si256(is_lower, _mm256_set1_epi8(26 - 'a'))),
+      _mm256_or_si256(_mm256_and_si256(is_digit, _mm256_set1_epi8(52 - '0')),
+                      _mm256_or_si256(_mm256_and_si256(is_62, _mm256_set1_epi8(static_cast<char>(62 - char62))),
+                                      _mm256_and_si256(is_63, _mm256_set1_epi8(static_cast<char>(63 - char63))))));
+  auto values = _mm256_add_epi8(c, offsets);
+
+  auto merged = _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+                                  _mm256_set1_epi32(0x00011000));
+  auto shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  auto result = _mm256_shuffle_epi8(merged, _mm256_broadcastsi128_si256(shuffle));
+  alignas(32) char buf[32];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(buf), result);
+  std::memcpy(output, buf, 12);
+  std::memcpy(output + 12, buf + 16, 12);
+  return true;
+}
+
+// decodes a prefix of the string without padding and returns length of the decoded prefix
+template <bool is_url>
+static size_t base64_decode_simd(Slice base64, char *ptr) {
+  if (base64.size() < 16 || !have_base64_ssse3()) {
+    return 0;
+  }
+  size_t block_count = base64.size() / 16;
+  auto *in = base64.ubegin();
+  size_t block = 0;
+  if (have_base64_avx2()) {
+    for (; block + 2 <= block_count; block += 2) {
+      if (!base64_decode_blocks_avx2<is_url>(in + block * 16, ptr + block * 12)) {
+        break;
+      }
+    }
+  }
+  for (; block < block_count; block++) {
+    if (!base64_decode_block_ssse3<is_url>(in + block * 16, ptr + block * 12)) {
+      break;
+    }
+  }
+  return block * 16;
+}
+#endif
+
 template <bool is_url>
 string base64_encode_impl(Slice input) {
   auto characters = get_characters<is_url>();
   string base64;
   base64.reserve((input.size() + 2) / 3 * 4);
-  for (size_t i = 0; i < input.size();) {
+  size_t i = 0;
+#if TD_HAVE_BASE64_SIMD
+  i = base64_encode_simd<is_url>(input, base64);
+#endif
+  while (i < input.size()) {
     size_t left = min(input.size() - i, static_cast<size_t>(3));
     int c = input.ubegin()[i++] << 16;
     base64 += characters[c >> 18];
@@ -93,8 +291,15 @@ Result<Slice> base64_drop_padding(Slice base64) {
   return base64;
 }
 
-static Status do_base64_decode_impl(Slice base64, const unsigned char *table, char *ptr) {
-  for (size_t i = 0; i < base64.size();) {
+template <bool is_url>
+static Status do_base64_decode_impl(Slice base64, char *ptr) {
+  auto table = get_character_table<is_url>();
+  size_t i = 0;
+#if TD_HAVE_BASE64_SIMD
+  i = base64_decode_simd<is_url>(base64, ptr);
+  ptr += i / 4 * 3;
+#endif
+  while (i < base64.size()) {
     size_t left = min(base64.size() - i, static_cast<size_t>(4));
     int c = 0;
     for (size_t t = 0; t < left; t++) {
@@ -141,7 +346,7 @@ static Result<T> base64_decode_impl(Slice base64) {
   TRY_RESULT_ASSIGN(base64, base64_drop_padding<is_url>(base64));
 
   T result = create_empty<T>(base64.size() / 4 * 3 + ((base64.size() & 3) + 1) / 2);
-  TRY_STATUS(do_base64_decode_impl(base64, get_character_table<is_url>(), as_mutable_slice(result).begin()));
+  TRY_STATUS(do_base64_decode_impl<is_url>(base64, as_mutable_slice(result).begin()));
   return std::move(result);
 }
 
@@ -0,0 +1,187 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/benchmark.h"
+
+#include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/OptionParser.h"
+#include "td/utils/PathView.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+#include "td/utils/StringBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <tuple>
+
+namespace td {
+
+BenchmarkOptions &get_benchmark_options() {
+  static BenchmarkOptions options;
+  return options;
+}
+
+bool init_benchmarks(int argc, char *argv[]) {
+  auto &options = get_benchmark_options();
+  if (argc > 0) {
+    options.target = PathView(Slice(argv[0])).file_name().str();
+  }
+
+  OptionParser option_parser;
+  option_parser.set_usage(Slice(argc > 0 ? argv[0] : "bench"), "[options]");
+  option_parser.set_description("Run benchmarks");
+  option_parser.add_option('f', "filter", "Run only benchmarks, which names contain the given substring",
+                           OptionParser::parse_string(options.filter));
+  option_parser.add_option('l', "list", "List names of benchmarks instead of running them",
+                           [&] { options.list_only = true; });
+  option_parser.add_checked_option('r', "repetitions", "Set number of measured runs of each benchmark (default: 2)",
+                                   OptionParser::parse_integer(options.repetition_count));
+  option_parser.add_checked_option('w', "warm-up", "Set number of additional runs before measurements (default: 0)",
+                                   OptionParser::parse_integer(options.warm_up_count));
+  option_parser.add_checked_option('t', "time", "Set minimum duration of a measured run in seconds",
+                                   [&](Slice time) {
+                                     options.min_time = to_double(time);
+                                     if (options.min_time <= 0) {
+                                       return Status::Error("Duration of a run must be positive");
+                                     }
+                                     return Status::OK();
+                                   });
+  option_parser.add_checked_option('c', "cpu", "Pin the benchmark thread to the CPU with the given number",
+                                   OptionParser::parse_integer(options.cpu_id));
+  option_parser.add_option('j', "json", "Print results as JSON objects, one per line", [&] { options.use_json = true; });
+  option_parser.add_check([&] {
+    if (options.repetition_count <= 0 || options.warm_up_count < 0) {
+      return Status::Error("Invalid number of benchmark runs");
+    }
+    if (options.cpu_id >= 64) {
+      return Status::Error("Invalid CPU number");
+    }
+    return Status::OK();
+  });
+  auto r_non_options = option_parser.run(argc, argv, 0);
+  if (r_non_options.is_error()) {
+    LOG(PLAIN) << options.target << ": " << r_non_options.error().message();
+    LOG(PLAIN) << option_parser;
+    return false;
+  }
+
+  if (options.cpu_id >= 0) {
+#if TD_HAVE_THREAD_AFFINITY
+    auto status = thread::set_affinity_mask(this_thread::get_id(), static_cast<uint64>(1) << options.cpu_id);
+    if (status.is_error()) {
+      LOG(PLAIN) << options.target << ": " << status;
+      return false;
+    }
+#else
+    LOG(PLAIN) << options.target << ": CPU pinning isn't supported";
+    return false;
+#endif
+  }
+  return true;
+}
+
+void bench(Benchmark &b, double max_time) {
+  const auto &options = get_benchmark_options();
+  auto description = b.get_description();
+  if (!options.filter.empty() && description.find(options.filter) == string::npos) {
+    return;
+  }
+  if (options.list_only) {
+    if (options.use_json) {
+      auto result = json_encode<string>(json_object([&](auto &o) {
+        o("target", options.target);
+        o("benchmark", description);
+      }));
+      std::printf("%s\n", result.c_str());
+    } else {
+      std::printf("%s\n", description.c_str());
+    }
+    std::fflush(stdout);
+    return;
+  }
+  if (options.min_time > 0) {
+    max_time = options.min_time;
+  }
+
+  // the pass used to choose number of iterations is always a warm-up pass
+  int n = 1;
+  double pass_time = 0;
+  double total_pass_time = 0;
+  while (pass_time < max_time && total_pass_time < max_time * 3 && n < (1 << 30)) {
+    n *= 2;
+    std::tie(pass_time, total_pass_time) = bench_n(b, n);
+  }
+  for (int i = 0; i < options.warm_up_count; i++) {
+    bench_n(b, n);
+  }
+
+  vector<double> pass_times;
+  pass_times.reserve(options.repetition_count);
+  for (int i = 0; i < options.repetition_count; i++) {
+    pass_times.push_back(bench_n(b, n).first);
+  }
+  std::sort(pass_times.begin(), pass_times.end());
+
+  auto get_speed = [n](double time) {
+    return time > 0 ? n / time : 0.0;
+  };
+  double sum = 0;
+  double square_sum = 0;
+  for (auto time : pass_times) {
+    auto speed = get_speed(time);
+    sum += speed;
+    square_sum += speed * speed;
+  }
+  auto pass_count = static_cast<double>(pass_times.size());
+  double average = sum / pass_count;
+  double d = std::sqrt(max(square_sum / pass_count - average * average, 0.0));
+  double min_speed = get_speed(pass_times.back());
+  double max_speed = get_speed(pass_times[0]);
+  double median_time = pass_times.size() % 2 == 1
+                           ? pass_times[pass_times.size() / 2]
+                           : (pass_times[pass_times.size() / 2 - 1] + pass_times[pass_times.size() / 2]) * 0.5;
+  double median = get_speed(median_time);
+  // the nearest-rank 95th percentile of a single iteration duration
+  auto p95_index = static_cast<size_t>(std::ceil(0.95 * pass_count)) - 1;
+  double p95_time = pass_times[p95_index] / n;
+
+  if (options.use_json) {
+    auto result = json_encode<string>(json_object([&](auto &o) {
+      o("target", options.target);
+      o("benchmark", description);
+      o("iterations", n);
+      o("repetitions", options.repetition_count);
+      o("ops_per_sec", JsonFloat(average));
+      o("ops_per_sec_median", JsonFloat(median));
+      o("ops_per_sec_min", JsonFloat(min_speed));
+      o("ops_per_sec_max", JsonFloat(max_speed));
+      o("ops_per_sec_stddev", JsonFloat(d));
+      o("ns_per_op_median", JsonFloat(median_time * 1e9 / n));
+      o("ns_per_op_p95", JsonFloat(p95_time * 1e9));
+    }));
+    std::printf("%s\n", result.c_str());
+    std::fflush(stdout);
+    return;
+  }
+
+  string pad;
+  if (description.size() < 40) {
+    pad = string(40 - description.size(), ' ');
+  }
+
+  LOG(ERROR) << "Bench [" << pad << description << "]: " << StringBuilder::FixedDouble(average, 3) << '['
+             << StringBuilder::FixedDouble(min_speed, 3) << '-' << StringBuilder::FixedDouble(max_speed, 3)
+             << "] ops/sec,\t" << format::as_time(1 / average) << " [d = " << StringBuilder::FixedDouble(d, 6)
+             << ", median = " << StringBuilder::FixedDouble(median, 3) << ", p95 = " << format::as_time(p95_time)
+             << ']';
+}
+
+}  // namespace td
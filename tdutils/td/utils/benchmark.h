@@ -6,13 +6,12 @@
 //
 #pragma once
 
+#include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/StringBuilder.h"
 
-#include <cmath>
-#include <tuple>
 #include <utility>
 
 #define BENCH(name, desc)                            \
@@ -84,46 +83,25 @@ inline std::pair<double, double> bench_n(Benchmark &&b, int n) {
   return bench_n(b, n);
 }
 
-inline void bench(Benchmark &b, double max_time = 1.0) {
-  int n = 1;
-  double pass_time = 0;
-  double total_pass_time = 0;
-  while (pass_time < max_time && total_pass_time < max_time * 3 && n < (1 << 30)) {
-    n *= 2;
-    std::tie(pass_time, total_pass_time) = bench_n(b, n);
-  }
-  pass_time = n / pass_time;
-
-  int pass_cnt = 2;
-  double sum = pass_time;
-  double square_sum = pass_time * pass_time;
-  double min_pass_time = pass_time;
-  double max_pass_time = pass_time;
-
-  for (int i = 1; i < pass_cnt; i++) {
-    pass_time = n / bench_n(b, n).first;
-    sum += pass_time;
-    square_sum += pass_time * pass_time;
-    if (pass_time < min_pass_time) {
-      min_pass_time = pass_time;
-    }
-    if (pass_time > max_pass_time) {
-      max_pass_time = pass_time;
-    }
-  }
-  double average = sum / pass_cnt;
-  double d = sqrt(square_sum / pass_cnt - average * average);
+struct BenchmarkOptions {
+  string target;
+  string filter;
+  double min_time = 0.0;  // overrides duration of a measured run if positive
+  int repetition_count = 2;
+  int warm_up_count = 0;
+  int cpu_id = -1;
+  bool use_json = false;
+  bool list_only = false;
+};
 
-  auto description = b.get_description();
-  std::string pad;
-  if (description.size() < 40) {
-    pad = std::string(40 - description.size(), ' ');
-  }
+BenchmarkOptions &get_benchmark_options();
 
-  LOG(ERROR) << "Bench [" << pad << description << "]: " << StringBuilder::FixedDouble(average, 3) << '['
-             << StringBuilder::FixedDouble(min_pass_time, 3) << '-' << StringBuilder::FixedDouble(max_pass_time, 3)
-             << "] ops/sec,\t" << format::as_time(1 / average) << " [d = " << StringBuilder::FixedDouble(d, 6) << ']';
-}
+// parses options common for all benchmarks, which allow to filter benchmarks by name, control number of runs,
+// pin the benchmark thread to a CPU and print results as JSON; returns false if the program must exit
+bool init_benchmarks(int argc, char *argv[]);
+
+// runs the benchmark if it isn't filtered out and reports mean, median, p95 and standard deviation of its runs
+void bench(Benchmark &b, double max_time = 1.0);
 
 inline void bench(Benchmark &&b, double max_time = 1.0) {
   bench(b, max_time);
@@ -6,8 +6,10 @@
 //
 #include "td/utils/buffer.h"
 
+#include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/thread_local.h"
+#include "td/utils/SliceBuilder.h"
 
 #include <cstddef>
 #include <new>
@@ -21,10 +23,87 @@
 
 namespace td {
 
+constexpr size_t BufferAllocator::BUFFER_OWNER_COUNT;
+constexpr size_t BufferAllocator::MIN_POOLED_SIZE_LOG;
+constexpr size_t BufferAllocator::MAX_POOLED_SIZE_LOG;
+constexpr size_t BufferAllocator::MAX_POOLED_SIZE_PER_CLASS;
+
+struct BufferAllocator::BufferRawPool {
+  static constexpr size_t SIZE_CLASS_COUNT = MAX_POOLED_SIZE_LOG - MIN_POOLED_SIZE_LOG + 1;
+
+  vector<char *> free_buffers[SIZE_CLASS_COUNT];
+
+  BufferRawPool() = default;
+  BufferRawPool(const BufferRawPool &) = delete;
+  BufferRawPool &operator=(const BufferRawPool &) = delete;
+  BufferRawPool(BufferRawPool &&) = delete;
+  BufferRawPool &operator=(BufferRawPool &&) = delete;
+  ~BufferRawPool() {
+    for (size_t size_class = 0; size_class < SIZE_CLASS_COUNT; size_class++) {
+      for (auto *memory : free_buffers[size_class]) {
+        pooled_buffer_mem_ -= get_memory_size(get_data_size(size_class));
+        delete[] memory;
+      }
+    }
+  }
+
+  // returns SIZE_CLASS_COUNT if buffers of the size must not be pooled
+  static size_t get_size_class(size_t data_size) {
+    if (data_size < (static_cast<size_t>(1) << MIN_POOLED_SIZE_LOG) ||
+        data_size > (static_cast<size_t>(1) << MAX_POOLED_SIZE_LOG) || (data_size & (data_size - 1)) != 0) {
+      return SIZE_CLASS_COUNT;
+    }
+    size_t size_class = 0;
+    while ((static_cast<size_t>(1) << (MIN_POOLED_SIZE_LOG + size_class)) != data_size) {
+      size_class++;
+    }
+    return size_class;
+  }
+
+  static size_t get_data_size(size_t size_class) {
+    return static_cast<size_t>(1) << (MIN_POOLED_SIZE_LOG + size_class);
+  }
+
+  static size_t get_max_pooled_count(size_t size_class) {
+    return max(MAX_POOLED_SIZE_PER_CLASS / get_data_size(size_class), static_cast<size_t>(1));
+  }
+
+  static size_t get_memory_size(size_t data_size) {
+    return max(sizeof(BufferRaw), TD_OFFSETOF(BufferRaw, data_) + data_size);
+  }
+
+  char *get(size_t size_class) {
+    auto &buffers = free_buffers[size_class];
+    if (buffers.empty()) {
+      return nullptr;
+    }
+    auto *memory = buffers.back();
+    buffers.pop_back();
+    return memory;
+  }
+
+  bool put(size_t size_class, char *memory) {
+    auto &buffers = free_buffers[size_class];
+    if (buffers.size() >= get_max_pooled_count(size_class)) {
+      return false;
+    }
+    buffers.push_back(memory);
+    return true;
+  }
+};
+
 TD_THREAD_LOCAL BufferAllocator::BufferRawTls *BufferAllocator::buffer_raw_tls;  // static zero-initialized
 
+TD_THREAD_LOCAL BufferAllocator::BufferRawPool *BufferAllocator::buffer_raw_pool_tls;  // static zero-initialized
+
+TD_THREAD_LOCAL BufferOwner BufferAllocator::current_owner_;
+
 std::atomic<size_t> BufferAllocator::buffer_mem;
 
+std::atomic<size_t> BufferAllocator::owner_buffer_mem_[BUFFER_OWNER_COUNT];
+
+std::atomic<size_t> BufferAllocator::pooled_buffer_mem_;
+
 int64 BufferAllocator::get_buffer_slice_size() {
   return 0;
 }
@@ -33,6 +112,44 @@ size_t BufferAllocator::get_buffer_mem() {
   return buffer_mem;
 }
 
+size_t BufferAllocator::get_buffer_mem(BufferOwner owner) {
+  auto owner_id = static_cast<size_t>(owner);
+  CHECK(owner_id < BUFFER_OWNER_COUNT);
+  return owner_buffer_mem_[owner_id];
+}
+
+size_t BufferAllocator::get_pooled_buffer_mem() {
+  return pooled_buffer_mem_;
+}
+
+Slice BufferAllocator::get_buffer_owner_name(BufferOwner owner) {
+  switch (owner) {
+    case BufferOwner::Other:
+      return Slice("other");
+    case BufferOwner::Transport:
+      return Slice("transport");
+    case BufferOwner::FilePart:
+      return Slice("file parts");
+    case BufferOwner::Binlog:
+      return Slice("binlog");
+    case BufferOwner::Database:
+      return Slice("database");
+    default:
+      UNREACHABLE();
+      return Slice();
+  }
+}
+
+string BufferAllocator::get_buffer_mem_stats() {
+  string result = PSTRING() << "Buffers: total = " << format::as_size(get_buffer_mem());
+  for (size_t owner_id = 0; owner_id < BUFFER_OWNER_COUNT; owner_id++) {
+    auto owner = static_cast<BufferOwner>(owner_id);
+    result += PSTRING() << ", " << get_buffer_owner_name(owner) << " = " << format::as_size(get_buffer_mem(owner));
+  }
+  result += PSTRING() << ", pooled = " << format::as_size(get_pooled_buffer_mem());
+  return result;
+}
+
 BufferAllocator::WriterPtr BufferAllocator::create_writer(size_t size) {
   if (size < 512) {
     size = 512;
@@ -89,10 +206,21 @@ BufferAllocator::ReaderPtr BufferAllocator::create_reader(const ReaderPtr &raw)
 void BufferAllocator::dec_ref_cnt(BufferRaw *ptr) {
   int left = ptr->ref_cnt_.fetch_sub(1, std::memory_order_acq_rel);
   if (left == 1) {
-    auto buf_size = max(sizeof(BufferRaw), TD_OFFSETOF(BufferRaw, data_) + ptr->data_size_);
+    auto data_size = ptr->data_size_;
+    auto buf_size = BufferRawPool::get_memory_size(data_size);
     buffer_mem -= buf_size;
+    owner_buffer_mem_[static_cast<size_t>(ptr->owner_)] -= buf_size;
     ptr->~BufferRaw();
-    delete[] ptr;
+
+    auto *memory = reinterpret_cast<char *>(ptr);
+    // the pool isn't created here, because the function can be called during destruction of thread locals
+    auto size_class = BufferRawPool::get_size_class(data_size);
+    if (size_class != BufferRawPool::SIZE_CLASS_COUNT && buffer_raw_pool_tls != nullptr &&
+        buffer_raw_pool_tls->put(size_class, memory)) {
+      pooled_buffer_mem_ += buf_size;
+      return;
+    }
+    delete[] memory;
   }
 }
 
@@ -105,13 +233,26 @@ size_t ChainBufferReader::advance(size_t offset, MutableSlice dest) {
 BufferRaw *BufferAllocator::create_buffer_raw(size_t size) {
   size = (size + 7) & -8;
 
-  auto buf_size = TD_OFFSETOF(BufferRaw, data_) + size;
-  if (buf_size < sizeof(BufferRaw)) {
-    buf_size = sizeof(BufferRaw);
-  }
+  auto buf_size = BufferRawPool::get_memory_size(size);
+  auto owner = current_owner_;
   buffer_mem += buf_size;
-  auto *buffer_raw = reinterpret_cast<BufferRaw *>(new char[buf_size]);
-  return new (buffer_raw) BufferRaw(size);
+  owner_buffer_mem_[static_cast<size_t>(owner)] += buf_size;
+
+  char *memory = nullptr;
+  auto size_class = BufferRawPool::get_size_class(size);
+  if (size_class != BufferRawPool::SIZE_CLASS_COUNT) {
+    init_thread_local<BufferRawPool>(buffer_raw_pool_tls);
+    memory = buffer_raw_pool_tls->get(size_class);
+    if (memory != nullptr) {
+      pooled_buffer_mem_ -= buf_size;
+    }
+  }
+  if (memory == nullptr) {
+    memory = new char[buf_size];
+  }
+  auto *buffer_raw = new (memory) BufferRaw(size);
+  buffer_raw->owner_ = owner;
+  return buffer_raw;
 }
 
 void BufferBuilder::append(BufferSlice slice) {
@@ -16,6 +16,9 @@
 
 namespace td {
 
+// subsystem, which allocated a buffer; used only for memory accounting
+enum class BufferOwner : uint8 { Other, Transport, FilePart, Binlog, Database };
+
 struct BufferRaw {
   explicit BufferRaw(size_t size) : data_size_(size) {
   }
@@ -33,6 +36,7 @@ struct BufferRaw {
   mutable std::atomic<int32> ref_cnt_{1};
   std::atomic<bool> has_writer_{true};
   bool was_reader_{false};
+  BufferOwner owner_{BufferOwner::Other};
 
   alignas(4) unsigned char data_[1];
 };
@@ -66,9 +70,32 @@ class BufferAllocator {
 
   static ReaderPtr create_reader(const ReaderPtr &raw);
 
+  static constexpr size_t BUFFER_OWNER_COUNT = 5;
+
+  // returns total size of alive buffers
   static size_t get_buffer_mem();
+
+  // returns total size of alive buffers allocated by the owner
+  static size_t get_buffer_mem(BufferOwner owner);
+
+  // returns total size of freed buffers kept in per-thread pools for reuse
+  static size_t get_pooled_buffer_mem();
+
   static int64 get_buffer_slice_size();
 
+  static Slice get_buffer_owner_name(BufferOwner owner);
+
+  static string get_buffer_mem_stats();
+
+  // buffers are attributed to the current owner of the thread at the time of their creation
+  static BufferOwner get_current_owner() {
+    return current_owner_;
+  }
+
+  static void set_current_owner(BufferOwner owner) {
+    current_owner_ = owner;
+  }
+
   static void clear_thread_local();
 
  private:
@@ -92,11 +119,40 @@ class BufferAllocator {
 
   static TD_THREAD_LOCAL BufferRawTls *buffer_raw_tls;
 
+  // free lists of buffers with data size equal to a power of two between 4 KB and 512 KB
+  static constexpr size_t MIN_POOLED_SIZE_LOG = 12;
+  static constexpr size_t MAX_POOLED_SIZE_LOG = 19;
+  static constexpr size_t MAX_POOLED_SIZE_PER_CLASS = 1 << 19;
+  struct BufferRawPool;
+
+  static TD_THREAD_LOCAL BufferRawPool *buffer_raw_pool_tls;
+
+  static TD_THREAD_LOCAL BufferOwner current_owner_;  // static zero-initialized
+
   static void dec_ref_cnt(BufferRaw *ptr);
 
   static BufferRaw *create_buffer_raw(size_t size);
 
   static std::atomic<size_t> buffer_mem;
+  static std::atomic<size_t> owner_buffer_mem_[BUFFER_OWNER_COUNT];
+  static std::atomic<size_t> pooled_buffer_mem_;
+};
+
+class BufferOwnerGuard {
+ public:
+  explicit BufferOwnerGuard(BufferOwner owner) : old_owner_(BufferAllocator::get_current_owner()) {
+    BufferAllocator::set_current_owner(owner);
+  }
+  BufferOwnerGuard(const BufferOwnerGuard &) = delete;
+  BufferOwnerGuard &operator=(const BufferOwnerGuard &) = delete;
+  BufferOwnerGuard(BufferOwnerGuard &&) = delete;
+  BufferOwnerGuard &operator=(BufferOwnerGuard &&) = delete;
+  ~BufferOwnerGuard() {
+    BufferAllocator::set_current_owner(old_owner_);
+  }
+
+ private:
+  BufferOwner old_owner_;
 };
 
 using BufferWriterPtr = BufferAllocator::WriterPtr;
@@ -739,6 +795,12 @@ class ChainBufferWriter {
       return append(slice.as_slice());
     }
 
+    append_without_copy(std::move(slice));
+  }
+
+  // links the slice to the chain regardless of its size; the rest of the current tail can't be used anymore
+  void append_without_copy(BufferSlice slice) {
+    CHECK(!empty());
     auto new_tail = ChainBufferNodeAllocator::create(std::move(slice), false);
     tail_->next_ = ChainBufferNodeAllocator::clone(new_tail);
     writer_ = BufferWriter();
@@ -42,6 +42,16 @@
 
 #if TD_HAVE_ZLIB
 #include <zlib.h>
+
+#if (TD_GCC || TD_CLANG) && (defined(__x86_64__) || defined(__i386__))
+#define TD_HAVE_CRC32_PCLMUL 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && !defined(__ARM_BIG_ENDIAN)
+#define TD_HAVE_CRC32_ARM 1
+#include <arm_acle.h>
+#endif
 #endif
 
 #if TD_HAVE_CRC32C
@@ -576,17 +586,20 @@ void AesIgeState::decrypt(Slice from, MutableSlice to) {
 }
 
 void aes_ige_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
-  AesIgeStateImpl state;
-  state.init(aes_key, aes_iv, true);
-  state.encrypt(from, to);
-  state.get_iv(aes_iv);
+  // the key is different for each MTProto packet, so only the cipher context can be reused between calls
+  static TD_THREAD_LOCAL AesIgeStateImpl *state;  // static zero-initialized
+  init_thread_local<AesIgeStateImpl>(state);
+  state->init(aes_key, aes_iv, true);
+  state->encrypt(from, to);
+  state->get_iv(aes_iv);
 }
 
 void aes_ige_decrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
-  AesIgeStateImpl state;
-  state.init(aes_key, aes_iv, false);
-  state.decrypt(from, to);
-  state.get_iv(aes_iv);
+  static TD_THREAD_LOCAL AesIgeStateImpl *state;  // static zero-initialized
+  init_thread_local<AesIgeStateImpl>(state);
+  state->init(aes_key, aes_iv, false);
+  state->decrypt(from, to);
+  state->get_iv(aes_iv);
 }
 
 void aes_cbc_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
@@ -1208,8 +1221,118 @@ void clear_openssl_errors(Slice source) {
 #endif
 
 #if TD_HAVE_ZLIB
+#if TD_HAVE_CRC32_PCLMUL
+__attribute__((target("pclmul,sse4.1"))) static __m128i crc32_pclmul_fold(__m128i x, __m128i next, __m128i k) {
+  __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), next), low);
+}
+
+// folding with carry-less multiplication from Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+// Instruction"; the length must be at least 64 and must be divisible by 16; crc is passed and returned not inverted
+__attribute__((target("pclmul,sse4.1"))) static uint32 crc32_pclmul(const unsigned char *buf, size_t len, uint32 crc) {
+  alignas(16) static const uint64 K1K2[] = {0x0154442bd4, 0x01c6e41596};
+  alignas(16) static const uint64 K3K4[] = {0x01751997d0, 0x00ccaa009e};
+  alignas(16) static const uint64 K5K0[] = {0x0163cd6124, 0x0000000000};
+  alignas(16) static const uint64 POLY[] = {0x01db710641, 0x01f7011641};
+
+  __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x00));
+  __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x10));
+  __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x20));
+  __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+  buf += 64;
+  len -= 64;
+
+  // fold 4 blocks of 16 bytes in parallel
+  __m128i k = _mm_load_si128(reinterpret_cast<const __m128i *>(K1K2));
+  while (len >= 64) {
+    __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+    __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+    __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+    __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+
+    x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + 0x30)));
+
+    buf += 64;
+    len -= 64;
+  }
+
+  // fold the blocks into one, and then fold the remaining blocks of 16 bytes into it
+  k = _mm_load_si128(reinterpret_cast<const __m128i *>(K3K4));
+  x1 = crc32_pclmul_fold(x1, x2, k);
+  x1 = crc32_pclmul_fold(x1, x3, k);
+  x1 = crc32_pclmul_fold(x1, x4, k);
+  while (len >= 16) {
+    x1 = crc32_pclmul_fold(x1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf)), k);
+    buf += 16;
+    len -= 16;
+  }
+
+  // fold 128 bits to 64 bits
+  const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+  x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  k = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(K5K0));
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00), x2);
+
+  // Barrett reduction to 32 bits
+  k = _mm_load_si128(reinterpret_cast<const __m128i *>(POLY));
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return static_cast<uint32>(_mm_extract_epi32(x1, 1));
+}
+
+static bool have_crc32_pclmul() {
+  static const bool result = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+  return result;
+}
+#endif
+
+#if TD_HAVE_CRC32_ARM
+static uint32 crc32_arm(const unsigned char *buf, size_t len) {
+  uint32 crc = 0xFFFFFFFF;
+  while (len >= 8) {
+    uint64 value;
+    std::memcpy(&value, buf, sizeof(value));
+    crc = __crc32d(crc, value);
+    buf += 8;
+    len -= 8;
+  }
+  while (len > 0) {
+    crc = __crc32b(crc, *buf++);
+    len--;
+  }
+  return ~crc;
+}
+#endif
+
 uint32 crc32(Slice data) {
-  return static_cast<uint32>(::crc32(0, data.ubegin(), static_cast<uint32>(data.size())));
+  auto buf = data.ubegin();
+  auto len = data.size();
+#if TD_HAVE_CRC32_ARM
+  return crc32_arm(buf, len);
+#else
+  uLong crc = 0;
+#if TD_HAVE_CRC32_PCLMUL
+  if (len >= 64 && have_crc32_pclmul()) {
+    auto chunk_size = len & ~static_cast<size_t>(15);
+    crc = ~crc32_pclmul(buf, chunk_size, 0xFFFFFFFF);
+    buf += chunk_size;
+    len -= chunk_size;
+  }
+#endif
+  return static_cast<uint32>(::crc32(crc, buf, static_cast<uint32>(len)));
+#endif
 }
 #endif
 
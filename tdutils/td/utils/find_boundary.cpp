@@ -6,8 +6,14 @@
 //
 #include "td/utils/find_boundary.h"
 
+#include "td/utils/bits.h"
+
 #include <cstring>
 
+#if TD_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace td {
 
 bool find_boundary(ChainBufferReader range, Slice boundary, size_t &already_read) {
@@ -48,4 +54,85 @@ bool find_boundary(ChainBufferReader range, Slice boundary, size_t &already_read
   return false;
 }
 
+// checks whether "\r\n\r\n" ends at s[pos]; history contains the last 3 bytes before s, the last byte in lowest bits
+static bool is_http_headers_end(const char *s, size_t pos, uint32 history) {
+  auto get_char = [&](size_t offset) {
+    return pos >= offset ? s[pos - offset] : static_cast<char>(history >> (8 * (offset - pos - 1)));
+  };
+  return get_char(0) == '\n' && get_char(1) == '\r' && get_char(2) == '\n' && get_char(3) == '\r';
+}
+
+// returns position of the last byte of the first "\r\n\r\n" in s or len if there is none
+static size_t find_http_headers_end_in_chunk(const char *s, size_t len, uint32 history) {
+  size_t pos = 0;
+  for (; pos < 3 && pos < len; pos++) {
+    if (is_http_headers_end(s, pos, history)) {
+      return pos;
+    }
+  }
+#if TD_SSE2
+  // bit i of the masks corresponds to byte pos - 16 + i; the bytes before pos have already been checked
+  const auto carriage_return = _mm_set1_epi8('\r');
+  const auto line_feed = _mm_set1_epi8('\n');
+  uint32 prev_cr_mask = 0;
+  uint32 prev_lf_mask = 0;
+  if (len >= 16) {
+    for (size_t i = 0; i < 3; i++) {
+      prev_cr_mask |= static_cast<uint32>(s[i] == '\r') << (16 - pos + i);
+      prev_lf_mask |= static_cast<uint32>(s[i] == '\n') << (16 - pos + i);
+    }
+  }
+  for (; pos + 16 <= len; pos += 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + pos));
+    auto cr_mask = prev_cr_mask | (static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(input, carriage_return)))
+                                   << 16);
+    auto lf_mask = prev_lf_mask | (static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(input, line_feed))) << 16);
+    auto end_mask = (lf_mask & (cr_mask << 1) & (lf_mask << 2) & (cr_mask << 3)) >> 16;
+    if (end_mask != 0) {
+      return pos + count_trailing_zeroes_non_zero32(end_mask);
+    }
+    prev_cr_mask = cr_mask >> 16;
+    prev_lf_mask = lf_mask >> 16;
+  }
+#endif
+  while (pos < len) {
+    const auto *ptr = static_cast<const char *>(std::memchr(s + pos, '\n', len - pos));
+    if (ptr == nullptr) {
+      break;
+    }
+    pos = static_cast<size_t>(ptr - s);
+    if (is_http_headers_end(s, pos, history)) {
+      return pos;
+    }
+    pos++;
+  }
+  return len;
+}
+
+bool find_http_headers_end(ChainBufferReader range, size_t &already_read) {
+  range.advance(already_read);
+
+  size_t chunk_begin = already_read;
+  uint32 history = 0;
+  while (!range.empty()) {
+    Slice ready = range.prepare_read();
+    auto end_pos = find_http_headers_end_in_chunk(ready.data(), ready.size(), history);
+    if (end_pos < ready.size()) {
+      already_read = chunk_begin + end_pos - 3;
+      return true;
+    }
+    for (size_t i = ready.size() > 3 ? ready.size() - 3 : 0; i < ready.size(); i++) {
+      history = ((history << 8) | static_cast<unsigned char>(ready[i])) & 0xFFFFFF;
+    }
+    chunk_begin += ready.size();
+    range.confirm_read(ready.size());
+  }
+
+  // the end of headers can start in the last 3 bytes
+  if (chunk_begin >= already_read + 3) {
+    already_read = chunk_begin - 3;
+  }
+  return false;
+}
+
 }  // namespace td
@@ -14,4 +14,7 @@ namespace td {
 
 bool find_boundary(ChainBufferReader range, Slice boundary, size_t &already_read);
 
+// equivalent to find_boundary(range, "\r\n\r\n", already_read), but uses vectorized search when possible
+bool find_http_headers_end(ChainBufferReader range, size_t &already_read);
+
 }  // namespace td
@@ -10,11 +10,14 @@
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SpinLock.h"
 #include "td/utils/TsCerr.h"
 
 #include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <limits>
+#include <map>
 #include <mutex>
 
 #if TD_ANDROID
@@ -43,6 +46,135 @@ void set_log_message_callback(int max_verbosity_level, OnLogMessageCallback call
   on_log_message_callback = callback;
 }
 
+std::atomic<bool> LogRateLimiter::is_enabled_{false};
+std::atomic<uint64> LogRateLimiter::suppressed_count_{0};
+
+namespace {
+struct LogRateLimits {
+  std::mutex mutex;
+  LogRateLimiter::Limit default_limit;
+  std::map<string, LogRateLimiter::Limit, std::less<>> tag_limits;
+  std::atomic<uint32> generation{1};  // changed after each limit change
+
+  LogRateLimiter::Limit get_limit(Slice tag) const {
+    if (!tag.empty()) {
+      auto it = tag_limits.find(tag);
+      if (it != tag_limits.end()) {
+        return it->second;
+      }
+    }
+    return default_limit;
+  }
+};
+
+// call sites are hashed to a fixed number of slots; the rare collisions only reset the slot
+struct LogCallSite {
+  SpinLock lock;
+  const char *file_name = nullptr;
+  int line_num = 0;
+  uint32 generation = 0;
+  LogRateLimiter::Limit limit;
+  double period_start = 0.0;
+  int32 count = 0;
+  uint64 suppressed_count = 0;
+};
+
+constexpr size_t LOG_CALL_SITE_COUNT = 1024;
+}  // namespace
+
+static LogRateLimits &get_log_rate_limits() {
+  static LogRateLimits limits;
+  return limits;
+}
+
+static LogCallSite log_call_sites[LOG_CALL_SITE_COUNT];
+
+void LogRateLimiter::set_limit(Slice tag, Limit limit) {
+  auto &limits = get_log_rate_limits();
+  std::lock_guard<std::mutex> lock(limits.mutex);
+  if (tag.empty()) {
+    limits.default_limit = limit;
+  } else {
+    limits.tag_limits[tag.str()] = limit;
+  }
+
+  bool is_enabled = limits.default_limit.max_count_per_second > 0;
+  for (auto &tag_limit : limits.tag_limits) {
+    if (tag_limit.second.max_count_per_second > 0) {
+      is_enabled = true;
+    }
+  }
+  limits.generation.fetch_add(1, std::memory_order_release);
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+LogRateLimiter::Limit LogRateLimiter::get_limit(Slice tag) {
+  auto &limits = get_log_rate_limits();
+  std::lock_guard<std::mutex> lock(limits.mutex);
+  return limits.get_limit(tag);
+}
+
+bool LogRateLimiter::check(LogInterface &log, const LogOptions &options, int log_level, const char *tag,
+                           const char *file_name, int line_num) {
+  if (log_level <= VERBOSITY_NAME(FATAL)) {
+    return true;
+  }
+
+  auto &limits = get_log_rate_limits();
+  auto generation = limits.generation.load(std::memory_order_acquire);
+  auto hash = static_cast<uint64>(reinterpret_cast<std::uintptr_t>(file_name)) * 0x9E3779B97F4A7C15ULL +
+              static_cast<uint32>(line_num);
+  auto &site = log_call_sites[(hash >> 32) % LOG_CALL_SITE_COUNT];
+
+  auto now = Clocks::monotonic();
+  bool is_allowed = true;
+  uint64 reported_suppressed_count = 0;
+  {
+    auto guard = site.lock.lock();
+    if (site.file_name != file_name || site.line_num != line_num) {
+      site.file_name = file_name;
+      site.line_num = line_num;
+      site.generation = 0;
+      site.period_start = now;
+      site.count = 0;
+      site.suppressed_count = 0;
+    }
+    if (site.generation != generation) {
+      std::lock_guard<std::mutex> lock(limits.mutex);
+      site.limit = limits.get_limit(tag == nullptr ? Slice() : Slice(tag));
+      site.generation = generation;
+    }
+
+    if (now >= site.period_start + 1.0) {
+      reported_suppressed_count = site.suppressed_count;
+      site.period_start = now;
+      site.count = 0;
+      site.suppressed_count = 0;
+    }
+
+    auto max_count = site.limit.max_count_per_second;
+    if (max_count > 0) {
+      site.count++;
+      if (site.count > max_count) {
+        auto sampling_rate = site.limit.sampling_rate;
+        if (sampling_rate <= 0 || (site.count - max_count) % sampling_rate != 0) {
+          site.suppressed_count++;
+          is_allowed = false;
+        }
+      }
+    }
+  }
+
+  if (!is_allowed) {
+    suppressed_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (reported_suppressed_count > 0) {
+    Logger(log, options, log_level, Slice(file_name), line_num, Slice())
+        << "Suppressed " << reported_suppressed_count << " previous messages logged from the same place";
+  }
+  return is_allowed;
+}
+
 void LogInterface::append(int log_level, CSlice slice) {
   do_append(log_level, slice);
   if (log_level == VERBOSITY_NAME(FATAL)) {
@@ -71,36 +203,58 @@ Logger::Logger(LogInterface &log, const LogOptions &options, int log_level, Slic
     return;
   }
 
+  if (log.is_binary() && log_level > VERBOSITY_NAME(FATAL) &&
+      log_level > max_callback_verbosity_level.load(std::memory_order_relaxed)) {
+    // file_name is always a string literal, so only its address is stored
+    is_binary_ = true;
+    detail::store_binary_log_value(sb_, Clocks::system());
+    detail::store_binary_log_value(sb_, static_cast<int32>(log_level));
+    detail::store_binary_log_value(sb_, get_thread_id());
+    detail::store_binary_log_value(sb_, static_cast<uint64>(reinterpret_cast<std::uintptr_t>(file_name.begin())));
+    detail::store_binary_log_value(sb_, static_cast<uint32>(file_name.size()));
+    detail::store_binary_log_value(sb_, static_cast<int32>(line_num));
+    detail::store_binary_log_string(sb_, tag_ != nullptr ? Slice(tag_) : Slice());
+    detail::store_binary_log_string(sb_, tag2_ != nullptr ? Slice(tag2_) : Slice());
+    detail::store_binary_log_string(sb_, comment);
+    return;
+  }
+
+  detail::format_log_header(sb_, log_level, get_thread_id(), Clocks::system(), file_name, line_num,
+                            tag_ != nullptr ? Slice(tag_) : Slice(), tag2_ != nullptr ? Slice(tag2_) : Slice(),
+                            comment);
+}
+
+namespace detail {
+void format_log_header(StringBuilder &sb, int log_level, int32 thread_id, double time, Slice file_name, int line_num,
+                       Slice tag, Slice tag2, Slice comment) {
   // log level
-  sb_ << '[';
+  sb << '[';
   if (static_cast<uint32>(log_level) < 10) {
-    sb_ << ' ' << static_cast<char>('0' + log_level);
+    sb << ' ' << static_cast<char>('0' + log_level);
   } else {
-    sb_ << log_level;
+    sb << log_level;
   }
-  sb_ << ']';
+  sb << ']';
 
   // thread identifier
-  auto thread_id = get_thread_id();
-  sb_ << "[t";
+  sb << "[t";
   if (static_cast<uint32>(thread_id) < 10) {
-    sb_ << ' ' << static_cast<char>('0' + thread_id);
+    sb << ' ' << static_cast<char>('0' + thread_id);
   } else {
-    sb_ << thread_id;
+    sb << thread_id;
   }
-  sb_ << ']';
+  sb << ']';
 
   // timestamp
-  auto time = Clocks::system();
   auto unix_time = static_cast<uint32>(time);
   auto nanoseconds = static_cast<uint32>((time - unix_time) * 1e9);
-  sb_ << '[' << unix_time << '.';
+  sb << '[' << unix_time << '.';
   uint32 limit = 100000000;
   while (nanoseconds < limit && limit > 1) {
-    sb_ << '0';
+    sb << '0';
     limit /= 10;
   }
-  sb_ << nanoseconds << ']';
+  sb << nanoseconds << ']';
 
   // file : line
   if (!file_name.empty()) {
@@ -109,31 +263,36 @@ Logger::Logger(LogInterface &log, const LogOptions &options, int log_level, Slic
       last_slash_--;
     }
     file_name = file_name.substr(last_slash_ + 1);
-    sb_ << '[' << file_name << ':' << static_cast<uint32>(line_num) << ']';
+    sb << '[' << file_name << ':' << static_cast<uint32>(line_num) << ']';
   }
 
   // context from tag_
-  if (tag_ != nullptr && *tag_) {
-    sb_ << "[#" << Slice(tag_) << ']';
+  if (!tag.empty()) {
+    sb << "[#" << tag << ']';
   }
 
   // context from tag2_
-  if (tag2_ != nullptr && *tag2_) {
-    sb_ << "[!" << Slice(tag2_) << ']';
+  if (!tag2.empty()) {
+    sb << "[!" << tag2 << ']';
   }
 
   // comment (e.g. condition in LOG_IF)
   if (!comment.empty()) {
-    sb_ << "[&" << comment << ']';
+    sb << "[&" << comment << ']';
   }
 
-  sb_ << '\t';
+  sb << '\t';
 }
+}  // namespace detail
 
 Logger::~Logger() {
   if (ExitGuard::is_exited()) {
     return;
   }
+  if (is_binary_) {
+    log_.do_append_binary(log_level_, as_cslice());
+    return;
+  }
   if (options_.fix_newlines) {
     sb_ << '\n';
     auto slice = as_cslice();
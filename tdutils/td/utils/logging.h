@@ -21,6 +21,8 @@
  *
  * LOG(FATAL) << "Power is off";
  * CHECK(condition) <===> LOG_IF(FATAL, !(condition))
+ *
+ * Number of messages logged from the same place per second can be limited using LogRateLimiter
  */
 
 #include "td/utils/common.h"
@@ -30,6 +32,7 @@
 #include "td/utils/StringBuilder.h"
 
 #include <atomic>
+#include <cstring>
 #include <type_traits>
 
 #define VERBOSITY_NAME(x) verbosity_##x
@@ -45,19 +48,25 @@
 
 #define LOGGER(interface, options, level, comment) ::td::Logger(interface, options, level, __FILE__, __LINE__, comment)
 
-#define LOG_IMPL_FULL(interface, options, strip_level, runtime_level, condition, comment) \
-  LOG_IS_STRIPPED(strip_level) || runtime_level > options.get_level() || !(condition)     \
-      ? (void)0                                                                           \
+#define LOG_IS_RATE_LIMITED(interface, options, runtime_level, tag) \
+  (::td::LogRateLimiter::is_enabled() &&                               \
+   !::td::LogRateLimiter::check(interface, options, runtime_level, tag, __FILE__, __LINE__))
+
+#define LOG_IMPL_FULL(interface, options, strip_level, runtime_level, condition, comment, tag)                \
+  LOG_IS_STRIPPED(strip_level) || runtime_level > options.get_level() || !(condition) ||                     \
+          LOG_IS_RATE_LIMITED(interface, options, runtime_level, tag)                                         \
+      ? (void)0                                                                                               \
       : ::td::detail::Voidify() & LOGGER(interface, options, runtime_level, comment)
 
-#define LOG_IMPL(strip_level, level, condition, comment) \
-  LOG_IMPL_FULL(*::td::log_interface, ::td::log_options, strip_level, VERBOSITY_NAME(level), condition, comment)
+#define LOG_IMPL(strip_level, level, condition, comment, tag) \
+  LOG_IMPL_FULL(*::td::log_interface, ::td::log_options, strip_level, VERBOSITY_NAME(level), condition, comment, tag)
 
-#define LOG(level) LOG_IMPL(level, level, true, ::td::Slice())
-#define LOG_IF(level, condition) LOG_IMPL(level, level, condition, #condition)
+#define LOG(level) LOG_IMPL(level, level, true, ::td::Slice(), nullptr)
+#define LOG_IF(level, condition) LOG_IMPL(level, level, condition, #condition, nullptr)
 
-#define VLOG(level) LOG_IMPL(DEBUG, level, true, TD_DEFINE_STR(level))
-#define VLOG_IF(level, condition) LOG_IMPL(DEBUG, level, condition, TD_DEFINE_STR(level) " " #condition)
+#define VLOG(level) LOG_IMPL(DEBUG, level, true, TD_DEFINE_STR(level), TD_DEFINE_STR(level))
+#define VLOG_IF(level, condition) \
+  LOG_IMPL(DEBUG, level, condition, TD_DEFINE_STR(level) " " #condition, TD_DEFINE_STR(level))
 
 #define LOG_TAG ::td::Logger::tag_
 #define LOG_TAG2 ::td::Logger::tag2_
@@ -77,9 +86,9 @@ inline bool no_return_func() {
   #if TD_MSVC
     #define LOG_CHECK(condition)        \
       __analysis_assume(!!(condition)); \
-      LOG_IMPL(FATAL, FATAL, !(condition), #condition)
+      LOG_IMPL(FATAL, FATAL, !(condition), #condition, nullptr)
   #else
-    #define LOG_CHECK(condition) LOG_IMPL(FATAL, FATAL, !(condition) && no_return_func(), #condition)
+    #define LOG_CHECK(condition) LOG_IMPL(FATAL, FATAL, !(condition) && no_return_func(), #condition, nullptr)
   #endif
 #else
   #define LOG_CHECK DUMMY_LOG_CHECK
@@ -168,6 +177,14 @@ class LogInterface {
   }
 
   virtual void do_append(int log_level, CSlice slice) = 0;
+
+  // if true, non-fatal messages are passed to do_append_binary as unformatted binary records
+  virtual bool is_binary() const {
+    return false;
+  }
+
+  virtual void do_append_binary(int log_level, Slice record) {
+  }
 };
 
 extern LogInterface *const default_log_interface;
@@ -178,6 +195,116 @@ extern LogInterface *log_interface;
 using OnLogMessageCallback = void (*)(int verbosity_level, CSlice message);
 void set_log_message_callback(int max_verbosity_level, OnLogMessageCallback callback);
 
+// Limits the number of non-fatal messages logged per second from the same place in the code.
+// Limits can be set for messages logged with VLOG(tag); the default limit is used for all other messages.
+// After the limit is exceeded, only every sampling_rate-th message is logged during the rest of the second.
+// The number of suppressed messages is logged with the first message from the same place in the next second.
+class LogRateLimiter {
+ public:
+  struct Limit {
+    int32 max_count_per_second = 0;  // 0 if unlimited
+    int32 sampling_rate = 0;         // 0 if all messages over the limit are suppressed
+  };
+
+  // sets limit for the tag or the default limit if the tag is empty
+  static void set_limit(Slice tag, Limit limit);
+
+  // returns limit used for messages with the tag
+  static Limit get_limit(Slice tag);
+
+  static uint64 get_suppressed_count() {
+    return suppressed_count_.load(std::memory_order_relaxed);
+  }
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // returns false if the message must be suppressed; tag is a string literal or nullptr
+  static bool check(LogInterface &log, const LogOptions &options, int log_level, const char *tag,
+                    const char *file_name, int line_num);
+
+ private:
+  static std::atomic<bool> is_enabled_;
+  static std::atomic<uint64> suppressed_count_;
+};
+
+namespace detail {
+void format_log_header(StringBuilder &sb, int log_level, int32 thread_id, double time, Slice file_name, int line_num,
+                       Slice tag, Slice tag2, Slice comment);
+
+// an argument of a binary log record is stored as its type followed by its value
+enum class BinaryLogArgumentType : char { Int = 'i', UInt = 'u', Double = 'd', Char = 'c', Bool = 'b', String = 's' };
+
+template <class T>
+void store_binary_log_value(StringBuilder &sb, const T &value) {
+  sb << Slice(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+inline void store_binary_log_type(StringBuilder &sb, BinaryLogArgumentType type) {
+  sb.push_back(static_cast<char>(type));
+}
+
+inline void store_binary_log_string(StringBuilder &sb, Slice str) {
+  store_binary_log_value(sb, static_cast<uint32>(str.size()));
+  sb << str;
+}
+
+inline void store_binary_log_argument(StringBuilder &sb, int x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::Int);
+  store_binary_log_value(sb, static_cast<int64>(x));
+}
+inline void store_binary_log_argument(StringBuilder &sb, long int x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::Int);
+  store_binary_log_value(sb, static_cast<int64>(x));
+}
+inline void store_binary_log_argument(StringBuilder &sb, long long int x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::Int);
+  store_binary_log_value(sb, static_cast<int64>(x));
+}
+inline void store_binary_log_argument(StringBuilder &sb, unsigned int x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::UInt);
+  store_binary_log_value(sb, static_cast<uint64>(x));
+}
+inline void store_binary_log_argument(StringBuilder &sb, long unsigned int x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::UInt);
+  store_binary_log_value(sb, static_cast<uint64>(x));
+}
+inline void store_binary_log_argument(StringBuilder &sb, long long unsigned int x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::UInt);
+  store_binary_log_value(sb, static_cast<uint64>(x));
+}
+inline void store_binary_log_argument(StringBuilder &sb, double x) {
+  store_binary_log_type(sb, BinaryLogArgumentType::Double);
+  store_binary_log_value(sb, x);
+}
+inline void store_binary_log_argument(StringBuilder &sb, char c) {
+  store_binary_log_type(sb, BinaryLogArgumentType::Char);
+  sb.push_back(c);
+}
+inline void store_binary_log_argument(StringBuilder &sb, bool b) {
+  store_binary_log_type(sb, BinaryLogArgumentType::Bool);
+  sb.push_back(b ? '\1' : '\0');
+}
+inline void store_binary_log_argument(StringBuilder &sb, Slice slice) {
+  store_binary_log_type(sb, BinaryLogArgumentType::String);
+  store_binary_log_string(sb, slice);
+}
+
+// all other arguments are formatted as text in place
+template <class T>
+void store_binary_log_argument(StringBuilder &sb, T &&value) {
+  store_binary_log_type(sb, BinaryLogArgumentType::String);
+  auto length_pos = sb.size();
+  store_binary_log_value(sb, static_cast<uint32>(0));
+  sb << value;
+  if (sb.size() >= length_pos + sizeof(uint32)) {
+    auto length = static_cast<uint32>(sb.size() - length_pos - sizeof(uint32));
+    std::memcpy(sb.as_cslice().begin() + length_pos, &length, sizeof(length));
+  }
+}
+}  // namespace detail
+
 class Logger {
   static const size_t BUFFER_SIZE = 128 * 1024;
 
@@ -194,7 +321,11 @@ class Logger {
 
   template <class T>
   Logger &operator<<(T &&other) {
-    sb_ << other;
+    if (is_binary_) {
+      detail::store_binary_log_argument(sb_, other);
+    } else {
+      sb_ << other;
+    }
     return *this;
   }
 
@@ -219,6 +350,7 @@ class Logger {
   StringBuilder sb_;
   const LogOptions &options_;
   int log_level_;
+  bool is_binary_ = false;
 };
 
 class LogGuard {
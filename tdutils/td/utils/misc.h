@@ -82,6 +82,29 @@ inline string to_lower(Slice slice) {
   return result;
 }
 
+// checks whether the string is equal to the lowercase string after conversion of ASCII letters to lowercase
+inline bool tolower_equals(Slice str, Slice lowercase_str) {
+  if (str.size() != lowercase_str.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < str.size(); i++) {
+    if (to_lower(str[i]) != lowercase_str[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline bool tolower_begins_with(Slice str, Slice lowercase_prefix) {
+  return lowercase_prefix.size() <= str.size() &&
+         tolower_equals(str.substr(0, lowercase_prefix.size()), lowercase_prefix);
+}
+
+inline bool tolower_ends_with(Slice str, Slice lowercase_suffix) {
+  return lowercase_suffix.size() <= str.size() &&
+         tolower_equals(str.substr(str.size() - lowercase_suffix.size()), lowercase_suffix);
+}
+
 inline char to_upper(char c) {
   if ('a' <= c && c <= 'z') {
     return static_cast<char>(c - 'a' + 'A');
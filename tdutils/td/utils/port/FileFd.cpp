@@ -15,12 +15,14 @@
 #include "td/utils/common.h"
 #include "td/utils/ExitGuard.h"
 #include "td/utils/FlatHashSet.h"
+#include "td/utils/LatencyHistogram.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/detail/PollableFd.h"
 #include "td/utils/port/detail/skip_eintr.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/sleep.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
@@ -107,6 +109,33 @@ class FileFdImpl {
 };
 }  // namespace detail
 
+static TD_THREAD_LOCAL FileFd::IoCategoryGuard *current_io_category_guard;
+
+FileFd::IoCategoryGuard::IoCategoryGuard(Slice category)
+    : category_(category), old_guard_(current_io_category_guard) {
+  current_io_category_guard = this;
+}
+
+FileFd::IoCategoryGuard::~IoCategoryGuard() {
+  CHECK(current_io_category_guard == this);
+  current_io_category_guard = old_guard_;
+}
+
+LatencyHistogram *FileFd::IoCategoryGuard::get_latency_histogram(IoType type) {
+  auto *guard = current_io_category_guard;
+  if (guard == nullptr) {
+    return nullptr;
+  }
+  auto &histogram = guard->histograms_[static_cast<int32>(type)];
+  if (histogram == nullptr) {
+    // histograms are created only when needed, because each of them has a copy in every thread
+    static const char *const type_names[] = {"read", "write", "sync"};
+    histogram =
+        LatencyHistogram::get(PSLICE() << "file " << type_names[static_cast<int32>(type)] << ' ' << guard->category_);
+  }
+  return histogram;
+}
+
 FileFd::FileFd() = default;
 FileFd::FileFd(FileFd &&) noexcept = default;
 FileFd &FileFd::operator=(FileFd &&) noexcept = default;
@@ -266,6 +295,7 @@ FileFd FileFd::from_native_fd(NativeFd native_fd) {
 }
 
 Result<size_t> FileFd::write(Slice slice) {
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Write));
   auto native_fd = get_native_fd().fd();
 #if TD_PORT_POSIX
   auto bytes_written = detail::skip_eintr([&] { return ::write(native_fd, slice.begin(), slice.size()); });
@@ -284,6 +314,7 @@ Result<size_t> FileFd::write(Slice slice) {
 
 Result<size_t> FileFd::writev(Span<IoSlice> slices) {
 #if TD_PORT_POSIX
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Write));
   auto native_fd = get_native_fd().fd();
   TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
   auto bytes_written = detail::skip_eintr([&] { return ::writev(native_fd, slices.begin(), slices_size); });
@@ -318,6 +349,7 @@ Result<size_t> FileFd::writev(Span<IoSlice> slices) {
 }
 
 Result<size_t> FileFd::read(MutableSlice slice) {
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Read));
   auto native_fd = get_native_fd().fd();
 #if TD_PORT_POSIX
   auto bytes_read = detail::skip_eintr([&] { return ::read(native_fd, slice.begin(), slice.size()); });
@@ -354,6 +386,7 @@ Result<size_t> FileFd::pwrite(Slice slice, int64 offset) {
   if (offset < 0) {
     return Status::Error("Offset must be non-negative");
   }
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Write));
   auto native_fd = get_native_fd().fd();
 #if TD_PORT_POSIX
   TRY_RESULT(offset_off_t, narrow_cast_safe<off_t>(offset));
@@ -380,6 +413,7 @@ Result<size_t> FileFd::pread(MutableSlice slice, int64 offset) const {
   if (offset < 0) {
     return Status::Error("Offset must be non-negative");
   }
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Read));
   auto native_fd = get_native_fd().fd();
 #if TD_PORT_POSIX
   TRY_RESULT(offset_off_t, narrow_cast_safe<off_t>(offset));
@@ -635,6 +669,7 @@ Result<Stat> FileFd::stat() const {
 
 Status FileFd::sync() {
   CHECK(!empty());
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Sync));
 #if TD_PORT_POSIX
 #if TD_DARWIN
   if (detail::skip_eintr([&] { return fcntl(get_native_fd().fd(), F_FULLFSYNC); }) == -1) {
@@ -659,6 +694,34 @@ Status FileFd::sync_barrier() {
   return sync();
 }
 
+Status FileFd::sync_data() {
+  CHECK(!empty());
+#if TD_LINUX || TD_ANDROID
+  LatencyHistogram::Timer timer(IoCategoryGuard::get_latency_histogram(IoCategoryGuard::IoType::Sync));
+  if (detail::skip_eintr([&] { return fdatasync(get_native_fd().fd()); }) != 0) {
+    return OS_ERROR("Sync failed");
+  }
+  return Status::OK();
+#else
+  return sync();
+#endif
+}
+
+void FileFd::prefetch(int64 offset, int64 size) const {
+  CHECK(!empty());
+  if (offset < 0 || size <= 0) {
+    return;
+  }
+#if TD_LINUX || TD_ANDROID
+  posix_fadvise(get_native_fd().fd(), static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#elif TD_DARWIN && defined(F_RDADVISE)
+  struct radvisory advice;
+  advice.ra_offset = static_cast<off_t>(offset);
+  advice.ra_count = static_cast<int>(min(size, static_cast<int64>(1) << 30));
+  fcntl(get_native_fd().fd(), F_RDADVISE, &advice);
+#endif
+}
+
 Status FileFd::seek(int64 position) {
   CHECK(!empty());
 #if TD_PORT_POSIX
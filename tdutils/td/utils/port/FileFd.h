@@ -22,6 +22,8 @@ namespace detail {
 class FileFdImpl;
 }  // namespace detail
 
+class LatencyHistogram;
+
 class FileFd {
  public:
   FileFd();
@@ -31,6 +33,30 @@ class FileFd {
   FileFd(const FileFd &) = delete;
   FileFd &operator=(const FileFd &) = delete;
 
+  // while the guard exists, durations of file reads, writes and syncs in the current thread are recorded to
+  // latency histograms "file read <category>", "file write <category>" and "file sync <category>"
+  // the category must outlive the guard; guards must be destroyed in the reverse order of creation
+  class IoCategoryGuard {
+   public:
+    explicit IoCategoryGuard(Slice category);
+    IoCategoryGuard(const IoCategoryGuard &) = delete;
+    IoCategoryGuard &operator=(const IoCategoryGuard &) = delete;
+    IoCategoryGuard(IoCategoryGuard &&) = delete;
+    IoCategoryGuard &operator=(IoCategoryGuard &&) = delete;
+    ~IoCategoryGuard();
+
+   private:
+    friend class FileFd;
+
+    enum class IoType : int32 { Read, Write, Sync };
+
+    Slice category_;
+    IoCategoryGuard *old_guard_;
+    LatencyHistogram *histograms_[3] = {};
+
+    static LatencyHistogram *get_latency_histogram(IoType type);
+  };
+
   enum Flags : int32 { Write = 1, Read = 2, Truncate = 4, Create = 8, Append = 16, CreateNew = 32, Direct = 64 };
   enum PrivateFlags : int32 { WinStat = 128 };
 
@@ -63,6 +89,10 @@ class FileFd {
 
   Status sync() TD_WARN_UNUSED_RESULT;
   Status sync_barrier() TD_WARN_UNUSED_RESULT;
+  Status sync_data() TD_WARN_UNUSED_RESULT;  // doesn't sync metadata, which isn't needed to read the file
+
+  // asks the OS to start reading of the given range of the file in background, so subsequent reads are faster
+  void prefetch(int64 offset, int64 size) const;
 
   Status seek(int64 position) TD_WARN_UNUSED_RESULT;
 
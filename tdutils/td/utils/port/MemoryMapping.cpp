@@ -25,6 +25,15 @@ namespace td {
 class MemoryMapping::Impl {
  public:
   Impl(MutableSlice data, int64 offset) : data_(data), offset_(offset) {
+  }
+  Impl(const Impl &) = delete;
+  Impl &operator=(const Impl &) = delete;
+  Impl(Impl &&) = delete;
+  Impl &operator=(Impl &&) = delete;
+  ~Impl() {
+#if !TD_WINDOWS
+    munmap(data_.data(), data_.size());
+#endif
   }
   Slice as_slice() const {
     return data_.substr(narrow_cast<size_t>(offset_));
@@ -73,7 +82,10 @@ Result<MemoryMapping> MemoryMapping::create_from_file(const FileFd &file_fd, con
   if (options.size < 0) {
     end = stat.size_;
   } else {
-    end = begin + stat.size_;
+    end = begin + options.size;
+  }
+  if (end <= begin) {
+    return Status::Error("Can't create memory mapping: mapping is empty");
   }
 
   TRY_RESULT(page_size, get_page_size());
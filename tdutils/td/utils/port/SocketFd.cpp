@@ -6,6 +6,7 @@
 //
 #include "td/utils/port/SocketFd.h"
 
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -13,12 +14,11 @@
 #include "td/utils/port/detail/skip_eintr.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/VectorQueue.h"
 
 #if TD_PORT_WINDOWS
-#include "td/utils/buffer.h"
 #include "td/utils/port/detail/Iocp.h"
 #include "td/utils/port/Mutex.h"
-#include "td/utils/VectorQueue.h"
 
 #include <limits>
 #endif
@@ -35,11 +35,36 @@
 #include <unistd.h>
 #endif
 
+#if TD_LINUX
+#include <linux/errqueue.h>
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY) && \
+    defined(SO_EE_CODE_ZEROCOPY_COPIED)
+#define TD_SOCKET_ZERO_COPY 1
+#endif
+#endif
+
 #include <atomic>
 #include <cstring>
 
 namespace td {
 namespace detail {
+
+static std::atomic<size_t> zero_copy_min_size{0};
+
+static Span<IoSlice> prepare_io_slices(ChainBufferReader &reader, MutableSpan<IoSlice> buf) {
+  auto it = reader.clone();
+  size_t buf_i;
+  for (buf_i = 0; buf_i < buf.size(); buf_i++) {
+    Slice slice = it.prepare_read();
+    if (slice.empty()) {
+      break;
+    }
+    buf[buf_i] = as_io_slice(slice);
+    it.confirm_read(slice.size());
+  }
+  return Span<IoSlice>(buf.data(), buf_i);
+}
+
 #if TD_PORT_WINDOWS
 class SocketFdImpl final : private Iocp::Callback {
  public:
@@ -437,6 +462,40 @@ class SocketFdImpl {
     return write_finish();
   }
 
+  Result<size_t> write_buffer(ChainBufferReader &reader) {
+    constexpr size_t BUF_SIZE = 64;
+    IoSlice buf[BUF_SIZE];
+    auto slices = prepare_io_slices(reader, buf);
+#if TD_SOCKET_ZERO_COPY
+    process_zero_copy_completions();
+    if (need_zero_copy(reader.size())) {
+      TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
+      int native_fd = get_native_fd().socket();
+      auto write_res = detail::skip_eintr([&] {
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = const_cast<iovec *>(slices.begin());
+        msg.msg_iovlen = slices_size;
+        return sendmsg(native_fd, &msg, MSG_NOSIGNAL | MSG_ZEROCOPY);
+      });
+      if (write_res >= 0) {
+        auto result = narrow_cast<size_t>(write_res);
+        CHECK(result <= reader.size());
+        // the sent data must not be changed or freed until the kernel reports that it doesn't need them anymore
+        pending_zero_copy_sends_.push(PendingZeroCopySend{next_zero_copy_send_id_++, reader.cut_head(result)});
+        return result;
+      }
+      if (errno != ENOBUFS) {
+        return write_finish();
+      }
+      // the socket option memory limit is exceeded; send the data as usual
+    }
+#endif
+    TRY_RESULT(result, writev(slices));
+    reader.advance(result);
+    return result;
+  }
+
   Result<size_t> write(Slice slice) {
     int native_fd = get_native_fd().socket();
     auto write_res = detail::skip_eintr([&] {
@@ -544,10 +603,105 @@ class SocketFdImpl {
     if (!get_poll_info().get_flags_local().has_pending_error()) {
       return Status::OK();
     }
+#if TD_SOCKET_ZERO_COPY
+    // completion notifications of zero-copy sends are reported as socket errors
+    process_zero_copy_completions();
+#endif
     TRY_STATUS(detail::get_socket_pending_error(get_native_fd()));
     get_poll_info().clear_flags(PollFlags::Error());
     return Status::OK();
   }
+
+#if TD_SOCKET_ZERO_COPY
+ private:
+  struct PendingZeroCopySend {
+    uint32 id = 0;
+    bool is_completed = false;
+    ChainBufferReader reader;
+
+    PendingZeroCopySend(uint32 id, ChainBufferReader reader) : id(id), reader(std::move(reader)) {
+    }
+  };
+
+  enum class ZeroCopyState : int32 { Unknown, Enabled, Disabled };
+  ZeroCopyState zero_copy_state_ = ZeroCopyState::Unknown;
+  uint32 next_zero_copy_send_id_ = 0;
+  VectorQueue<PendingZeroCopySend> pending_zero_copy_sends_;
+
+  bool need_zero_copy(size_t size) {
+    auto min_size = zero_copy_min_size.load(std::memory_order_relaxed);
+    if (min_size == 0 || size < min_size || zero_copy_state_ == ZeroCopyState::Disabled) {
+      return false;
+    }
+    if (zero_copy_state_ == ZeroCopyState::Unknown) {
+      int flags = 1;
+      if (setsockopt(get_native_fd().socket(), SOL_SOCKET, SO_ZEROCOPY, &flags, sizeof(flags)) != 0) {
+        VLOG(fd) << get_native_fd() << " doesn't support zero-copy sends: " << OS_SOCKET_ERROR("setsockopt");
+        zero_copy_state_ = ZeroCopyState::Disabled;
+        return false;
+      }
+      zero_copy_state_ = ZeroCopyState::Enabled;
+    }
+    return true;
+  }
+
+  void on_zero_copy_completed(uint32 first_id, uint32 last_id, bool is_copied) {
+    if (is_copied && zero_copy_state_ == ZeroCopyState::Enabled) {
+      // the kernel had to copy the data anyway, so page pinning is only an overhead
+      VLOG(fd) << get_native_fd() << " falls back to ordinary sends";
+      zero_copy_state_ = ZeroCopyState::Disabled;
+    }
+    auto pending_count = pending_zero_copy_sends_.size();
+    if (pending_count == 0) {
+      return;
+    }
+    auto *pending_sends = pending_zero_copy_sends_.data();
+    auto front_id = pending_sends[0].id;
+    for (uint32 id = first_id;; id++) {
+      auto pos = static_cast<size_t>(id - front_id);
+      if (pos < pending_count) {
+        CHECK(pending_sends[pos].id == id);
+        pending_sends[pos].is_completed = true;
+      }
+      if (id == last_id) {
+        break;
+      }
+    }
+    while (!pending_zero_copy_sends_.empty() && pending_zero_copy_sends_.front().is_completed) {
+      pending_zero_copy_sends_.pop();
+    }
+  }
+
+  void process_zero_copy_completions() {
+    if (pending_zero_copy_sends_.empty()) {
+      return;
+    }
+    int native_fd = get_native_fd().socket();
+    while (true) {
+      char control[128];
+      msghdr msg;
+      std::memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      auto recv_res = detail::skip_eintr([&] { return recvmsg(native_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT); });
+      if (recv_res < 0) {
+        return;
+      }
+      for (auto *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (!((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) ||
+              (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+          continue;
+        }
+        sock_extended_err error;
+        std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+        if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY || error.ee_errno != 0) {
+          continue;
+        }
+        on_zero_copy_completed(error.ee_info, error.ee_data, (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+      }
+    }
+  }
+#endif
 };
 
 void SocketFdImplDeleter::operator()(SocketFdImpl *impl) {
@@ -712,6 +866,23 @@ Result<size_t> SocketFd::writev(Span<IoSlice> slices) {
   return impl_->writev(slices);
 }
 
+Result<size_t> SocketFd::write_buffer(ChainBufferReader &reader) {
+  CHECK(!empty());
+#if TD_PORT_POSIX
+  return impl_->write_buffer(reader);
+#else
+  constexpr size_t BUF_SIZE = 64;
+  IoSlice buf[BUF_SIZE];
+  TRY_RESULT(result, impl_->writev(detail::prepare_io_slices(reader, buf)));
+  reader.advance(result);
+  return result;
+#endif
+}
+
+void SocketFd::set_zero_copy_min_size(size_t min_size) {
+  detail::zero_copy_min_size.store(min_size, std::memory_order_relaxed);
+}
+
 Result<size_t> SocketFd::read(MutableSlice slice) {
   CHECK(!empty());
   return impl_->read(slice);
@@ -20,6 +20,8 @@
 
 namespace td {
 
+class ChainBufferReader;
+
 namespace detail {
 class SocketFdImpl;
 class SocketFdImplDeleter {
@@ -49,11 +51,18 @@ class SocketFd {
 
   Result<size_t> write(Slice slice) TD_WARN_UNUSED_RESULT;
   Result<size_t> writev(Span<IoSlice> slices) TD_WARN_UNUSED_RESULT;
+
+  // writes a prefix of the buffer and advances the reader past it
+  Result<size_t> write_buffer(ChainBufferReader &reader) TD_WARN_UNUSED_RESULT;
+
   Result<size_t> read(MutableSlice slice) TD_WARN_UNUSED_RESULT;
 
   const NativeFd &get_native_fd() const;
   static Result<SocketFd> from_native_fd(NativeFd fd);
 
+  // writes of at least min_size bytes are done with MSG_ZEROCOPY if supported; 0 disables zero-copy writes
+  static void set_zero_copy_min_size(size_t min_size);
+
   void close();
   bool empty() const;
 
@@ -13,6 +13,7 @@
 #include "td/utils/port/detail/skip_eintr.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/SocketFd.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/VectorQueue.h"
 
@@ -654,8 +655,8 @@ class UdpSocketFdImpl {
     //  msghdr msg_hdr;        [> Message header <]
     //  unsigned int msg_len;  [> Number of bytes transmitted <]
     //};
-    std::array<detail::UdpSocketSendHelper, 16> helpers;
-    std::array<mmsghdr, 16> headers;
+    std::array<detail::UdpSocketSendHelper, UdpSocketFd::MAX_BATCH_SIZE> helpers;
+    std::array<mmsghdr, UdpSocketFd::MAX_BATCH_SIZE> headers;
     size_t to_send = min(messages.size(), headers.size());
     for (size_t i = 0; i < to_send; i++) {
       helpers[i].to_native(messages[i], headers[i].msg_hdr);
@@ -691,6 +692,12 @@ class UdpSocketFdImpl {
   }
 
 #if TD_HAS_MMSG
+  struct ReceiveBatch {
+    std::array<detail::UdpSocketReceiveHelper, UdpSocketFd::MAX_BATCH_SIZE> helpers;
+    std::array<mmsghdr, UdpSocketFd::MAX_BATCH_SIZE> headers;
+  };
+  static TD_THREAD_LOCAL ReceiveBatch *receive_batch_;
+
   Status receive_messages_fast(MutableSpan<UdpSocketFd::InboundMessage> messages, size_t &cnt) {
     int flags = 0;
     cnt = 0;
@@ -705,8 +712,10 @@ class UdpSocketFdImpl {
     //  msghdr msg_hdr;        [> Message header <]
     //  unsigned int msg_len;  [> Number of bytes transmitted <]
     //};
-    std::array<detail::UdpSocketReceiveHelper, 16> helpers;
-    std::array<mmsghdr, 16> headers;
+    // receive helpers contain buffers for control messages, so they are too big to be allocated on the stack
+    init_thread_local<ReceiveBatch>(receive_batch_);
+    auto &helpers = receive_batch_->helpers;
+    auto &headers = receive_batch_->headers;
     size_t to_receive = min(messages.size(), headers.size());
     for (size_t i = 0; i < to_receive; i++) {
       helpers[i].to_native(messages[i], headers[i].msg_hdr);
@@ -732,6 +741,11 @@ class UdpSocketFdImpl {
   }
 #endif
 };
+
+#if TD_HAS_MMSG
+TD_THREAD_LOCAL UdpSocketFdImpl::ReceiveBatch *UdpSocketFdImpl::receive_batch_;
+#endif
+
 void UdpSocketFdImplDeleter::operator()(UdpSocketFdImpl *impl) {
   delete impl;
 }
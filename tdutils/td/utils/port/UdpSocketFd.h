@@ -59,6 +59,9 @@ class UdpSocketFd {
   static bool is_critical_read_error(const Status &status);
 
 #if TD_PORT_POSIX
+  // maximum number of messages, which are sent or received by one call to send_messages or receive_messages
+  static constexpr size_t MAX_BATCH_SIZE = 64;
+
   struct OutboundMessage {
     const IPAddress *to;
     Slice data;
@@ -0,0 +1,380 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/detail/IoUring.h"
+
+char disable_linker_warning_about_empty_file_io_uring_cpp TD_UNUSED;
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Status.h"
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include <endian.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace td {
+namespace detail {
+
+namespace {
+
+constexpr uint32 SUBMISSION_QUEUE_SIZE = 1024;
+constexpr uint32 COMPLETION_QUEUE_SIZE = 16384;
+constexpr uint64 POLL_REMOVE_USER_DATA = static_cast<uint64>(-1);
+
+int io_uring_setup(uint32 entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, uint32 to_submit, uint32 min_complete, uint32 flags, const void *arg, size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+constexpr uint32 REQUIRED_FEATURES = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+
+uint64 get_user_data(int native_fd, uint32 generation) {
+  return (static_cast<uint64>(generation) << 32) | static_cast<uint32>(native_fd);
+}
+
+uint32 get_poll32_events(uint32 events) {
+#if __BYTE_ORDER == __BIG_ENDIAN
+  // the value must be word-swapped on big-endian platforms
+  events = (events << 16) | (events >> 16);
+#endif
+  return events;
+}
+
+void *mmap_ring(int ring_fd, size_t size, off_t offset) {
+  auto result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+  auto mmap_errno = errno;
+  LOG_IF(FATAL, result == MAP_FAILED) << Status::PosixError(mmap_errno, "io_uring mmap failed");
+  return result;
+}
+
+std::atomic<bool> use_io_uring_flag{false};
+
+}  // namespace
+
+IoUring::~IoUring() {
+  clear();
+}
+
+bool IoUring::is_supported() {
+  static const bool is_supported = [] {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    NativeFd ring_fd(io_uring_setup(2, &params));
+    if (!ring_fd) {
+      auto io_uring_setup_errno = errno;
+      LOG(INFO) << Status::PosixError(io_uring_setup_errno, "io_uring_setup failed");
+      return false;
+    }
+    if ((params.features & REQUIRED_FEATURES) != REQUIRED_FEATURES) {
+      LOG(INFO) << "Kernel io_uring is too old: features = " << params.features;
+      return false;
+    }
+    return true;
+  }();
+  return is_supported;
+}
+
+void IoUring::init() {
+  CHECK(!ring_fd_);
+  struct io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = COMPLETION_QUEUE_SIZE;
+  ring_fd_ = NativeFd(io_uring_setup(SUBMISSION_QUEUE_SIZE, &params));
+  auto io_uring_setup_errno = errno;
+  LOG_IF(FATAL, !ring_fd_) << Status::PosixError(io_uring_setup_errno, "io_uring_setup failed");
+  LOG_IF(FATAL, (params.features & REQUIRED_FEATURES) != REQUIRED_FEATURES)
+      << "Unsupported io_uring features " << params.features;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32);
+  sq_ring_ = mmap_ring(ring_fd_.fd(), sq_ring_size_, IORING_OFF_SQ_RING);
+  auto *sq_ring = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.tail);
+  sq_array_ = reinterpret_cast<uint32 *>(sq_ring + params.sq_off.array);
+  sq_mask_ = *reinterpret_cast<uint32 *>(sq_ring + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = static_cast<struct io_uring_sqe *>(mmap_ring(ring_fd_.fd(), sqes_size_, IORING_OFF_SQES));
+
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  cq_ring_ = mmap_ring(ring_fd_.fd(), cq_ring_size_, IORING_OFF_CQ_RING);
+  auto *cq_ring = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32 *>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32 *>(cq_ring + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32 *>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+}
+
+void IoUring::clear() {
+  if (!ring_fd_) {
+    return;
+  }
+  subscriptions_.clear();
+  pending_submit_count_ = 0;
+
+  munmap(sqes_, sqes_size_);
+  munmap(cq_ring_, cq_ring_size_);
+  munmap(sq_ring_, sq_ring_size_);
+  sqes_ = nullptr;
+  sq_ring_ = nullptr;
+  cq_ring_ = nullptr;
+
+  ring_fd_.close();
+
+  for (auto *list_node = list_root_.next; list_node != &list_root_;) {
+    auto pollable_fd = PollableFd::from_list_node(list_node);
+    list_node = list_node->next;
+  }
+}
+
+struct io_uring_sqe *IoUring::get_sqe() {
+  auto tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_) {
+    // the submission queue is full; submit the requests without waiting
+    enter(0, 0);
+    LOG_CHECK(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) < sq_entries_) << "Failed to submit io_uring requests";
+  }
+  auto index = tail & sq_mask_;
+  auto *sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  return sqe;
+}
+
+void IoUring::add_poll_request(int native_fd) {
+  auto &subscription = subscriptions_[native_fd];
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = native_fd;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->poll32_events = get_poll32_events(subscription.events);
+  sqe->user_data = get_user_data(native_fd, subscription.generation);
+  __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+  pending_submit_count_++;
+}
+
+void IoUring::subscribe(PollableFd fd, PollFlags flags) {
+  uint32 events = EPOLLHUP | EPOLLERR | EPOLLET | EPOLLRDHUP;
+  if (flags.can_read()) {
+    events |= EPOLLIN;
+  }
+  if (flags.can_write()) {
+    events |= EPOLLOUT;
+  }
+  auto native_fd = fd.native_fd().fd();
+  CHECK(native_fd >= 0);
+  auto *list_node = fd.release_as_list_node();
+  list_root_.put(list_node);
+
+  if (static_cast<size_t>(native_fd) >= subscriptions_.size()) {
+    subscriptions_.resize(static_cast<size_t>(native_fd) + 1);
+  }
+  auto &subscription = subscriptions_[native_fd];
+  CHECK(subscription.list_node == nullptr);
+  subscription.list_node = list_node;
+  subscription.events = events;
+  add_poll_request(native_fd);
+}
+
+void IoUring::unsubscribe(PollableFdRef fd_ref) {
+  auto fd = fd_ref.lock();
+  auto native_fd = fd.native_fd().fd();
+  LOG_CHECK(native_fd >= 0 && static_cast<size_t>(native_fd) < subscriptions_.size() &&
+            subscriptions_[native_fd].list_node != nullptr)
+      << "Unsubscribe not subscribed fd = " << native_fd << ", status = " << fd.native_fd().validate();
+
+  auto &subscription = subscriptions_[native_fd];
+  auto user_data = get_user_data(native_fd, subscription.generation);
+  subscription.list_node = nullptr;
+  subscription.generation++;
+
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = user_data;
+  sqe->user_data = POLL_REMOVE_USER_DATA;
+  __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+  pending_submit_count_++;
+}
+
+void IoUring::unsubscribe_before_close(PollableFdRef fd) {
+  unsubscribe(fd);
+}
+
+int IoUring::enter(uint32 min_complete, int timeout_ms) {
+  uint32 flags = 0;
+  const void *arg = nullptr;
+  size_t arg_size = 0;
+  struct __kernel_timespec timeout;
+  struct io_uring_getevents_arg getevents_arg;
+  if (min_complete > 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+    if (timeout_ms >= 0) {
+      timeout.tv_sec = timeout_ms / 1000;
+      timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+      std::memset(&getevents_arg, 0, sizeof(getevents_arg));
+      getevents_arg.sigmask_sz = _NSIG / 8;
+      getevents_arg.ts = reinterpret_cast<uint64>(&timeout);
+      flags |= IORING_ENTER_EXT_ARG;
+      arg = &getevents_arg;
+      arg_size = sizeof(getevents_arg);
+    }
+  }
+
+  int result = io_uring_enter(ring_fd_.fd(), pending_submit_count_, min_complete, flags, arg, arg_size);
+  auto io_uring_enter_errno = errno;
+  if (result >= 0) {
+    CHECK(static_cast<uint32>(result) <= pending_submit_count_);
+    pending_submit_count_ -= result;
+    return result;
+  }
+  // ETIME is returned on timeout; EBUSY and EAGAIN mean that completions must be reaped first
+  LOG_IF(FATAL, io_uring_enter_errno != EINTR && io_uring_enter_errno != ETIME && io_uring_enter_errno != EBUSY &&
+                    io_uring_enter_errno != EAGAIN)
+      << Status::PosixError(io_uring_enter_errno, "io_uring_enter failed");
+  return result;
+}
+
+void IoUring::run(int timeout_ms) {
+  // submit all queued subscription changes with the same system call, which waits for events
+  if (timeout_ms != 0 && __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) == *cq_head_) {
+    enter(1, timeout_ms);
+  } else if (pending_submit_count_ != 0) {
+    enter(0, 0);
+  }
+  process_completions();
+}
+
+void IoUring::process_completions() {
+  auto head = *cq_head_;
+  auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; head++) {
+    auto cqe = cqes_[head & cq_mask_];
+    if (cqe.user_data == POLL_REMOVE_USER_DATA) {
+      continue;
+    }
+    auto native_fd = static_cast<int>(static_cast<uint32>(cqe.user_data));
+    auto generation = static_cast<uint32>(cqe.user_data >> 32);
+    if (static_cast<size_t>(native_fd) >= subscriptions_.size()) {
+      continue;
+    }
+    auto &subscription = subscriptions_[native_fd];
+    if (subscription.list_node == nullptr || subscription.generation != generation) {
+      // completion of an already removed poll request
+      continue;
+    }
+
+    PollFlags flags;
+    if (cqe.res < 0) {
+      if (cqe.res != -ECANCELED) {
+        LOG(WARNING) << Status::PosixError(-cqe.res, PSLICE() << "io_uring poll failed for fd = " << native_fd);
+        flags = flags | PollFlags::Error();
+      }
+    } else {
+      auto events = static_cast<uint32>(cqe.res);
+      if (events & EPOLLIN) {
+        events &= ~EPOLLIN;
+        flags = flags | PollFlags::Read();
+      }
+      if (events & EPOLLOUT) {
+        events &= ~EPOLLOUT;
+        flags = flags | PollFlags::Write();
+      }
+      if (events & EPOLLRDHUP) {
+        events &= ~EPOLLRDHUP;
+        flags = flags | PollFlags::Close();
+      }
+      if (events & EPOLLHUP) {
+        events &= ~EPOLLHUP;
+        flags = flags | PollFlags::Close();
+      }
+      if (events & EPOLLERR) {
+        events &= ~EPOLLERR;
+        flags = flags | PollFlags::Error();
+      }
+      if (events & POLLNVAL) {
+        events &= ~POLLNVAL;
+        flags = flags | PollFlags::Error();
+      }
+      if (events) {
+        LOG(FATAL) << "Unsupported io_uring poll events: " << static_cast<int32>(events);
+      }
+    }
+
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+      // the multishot request was terminated by the kernel and must be rearmed
+      add_poll_request(native_fd);
+    }
+
+    auto pollable_fd = PollableFd::from_list_node(subscription.list_node);
+    pollable_fd.add_flags(flags);
+    pollable_fd.release_as_list_node();
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+void IoUringOrEpoll::set_use_io_uring(bool use_io_uring) {
+  use_io_uring_flag.store(use_io_uring, std::memory_order_relaxed);
+}
+
+bool IoUringOrEpoll::get_use_io_uring() {
+  return use_io_uring_flag.load(std::memory_order_relaxed);
+}
+
+void IoUringOrEpoll::init() {
+  CHECK(poll_ == nullptr);
+  if (get_use_io_uring() && IoUring::is_supported()) {
+    poll_ = &io_uring_;
+  } else {
+    poll_ = &epoll_;
+  }
+  poll_->init();
+}
+
+void IoUringOrEpoll::clear() {
+  if (poll_ == nullptr) {
+    return;
+  }
+  poll_->clear();
+  poll_ = nullptr;
+}
+
+void IoUringOrEpoll::subscribe(PollableFd fd, PollFlags flags) {
+  poll_->subscribe(std::move(fd), flags);
+}
+
+void IoUringOrEpoll::unsubscribe(PollableFdRef fd) {
+  poll_->unsubscribe(fd);
+}
+
+void IoUringOrEpoll::unsubscribe_before_close(PollableFdRef fd) {
+  poll_->unsubscribe_before_close(fd);
+}
+
+void IoUringOrEpoll::run(int timeout_ms) {
+  poll_->run(timeout_ms);
+}
+
+}  // namespace detail
+}  // namespace td
+
+#endif
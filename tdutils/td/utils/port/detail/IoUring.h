@@ -0,0 +1,146 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/port/config.h"
+
+#if TD_POLL_EPOLL && TD_LINUX && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+// multishot poll requests and extended io_uring_enter arguments are needed
+#if defined(IORING_POLL_ADD_MULTI) && defined(IORING_FEAT_EXT_ARG) && defined(IORING_FEAT_RSRC_TAGS) && \
+    defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define TD_POLL_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+#include "td/utils/port/detail/Epoll.h"
+#include "td/utils/port/detail/NativeFd.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/PollBase.h"
+#include "td/utils/port/PollFlags.h"
+
+namespace td {
+namespace detail {
+
+// edge-triggered poll based on multishot io_uring poll requests
+// subscription changes are queued in the submission ring and are submitted together with the next wait
+class IoUring final : public PollBase {
+ public:
+  IoUring() = default;
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+  IoUring(IoUring &&) = delete;
+  IoUring &operator=(IoUring &&) = delete;
+  ~IoUring() final;
+
+  // returns whether the running kernel supports all the needed io_uring features
+  static bool is_supported();
+
+  void init() final;
+
+  void clear() final;
+
+  void subscribe(PollableFd fd, PollFlags flags) final;
+
+  void unsubscribe(PollableFdRef fd) final;
+
+  void unsubscribe_before_close(PollableFdRef fd) final;
+
+  void run(int timeout_ms) final;
+
+  static bool is_edge_triggered() {
+    return true;
+  }
+
+ private:
+  struct Subscription {
+    ListNode *list_node = nullptr;
+    uint32 events = 0;
+    uint32 generation = 0;
+  };
+
+  NativeFd ring_fd_;
+
+  void *sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  uint32 *sq_head_ = nullptr;
+  uint32 *sq_tail_ = nullptr;
+  uint32 *sq_array_ = nullptr;
+  uint32 sq_mask_ = 0;
+  uint32 sq_entries_ = 0;
+  struct io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  uint32 pending_submit_count_ = 0;
+
+  void *cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  uint32 *cq_head_ = nullptr;
+  uint32 *cq_tail_ = nullptr;
+  uint32 cq_mask_ = 0;
+  struct io_uring_cqe *cqes_ = nullptr;
+
+  // indexed by native file descriptor; the generation allows to ignore completions of removed poll requests
+  vector<Subscription> subscriptions_;
+  ListNode list_root_;
+
+  struct io_uring_sqe *get_sqe();
+
+  void add_poll_request(int native_fd);
+
+  int enter(uint32 min_complete, int timeout_ms);
+
+  void process_completions();
+};
+
+// uses io_uring if it was enabled and is supported by the kernel, and epoll otherwise
+class IoUringOrEpoll final : public PollBase {
+ public:
+  IoUringOrEpoll() = default;
+  IoUringOrEpoll(const IoUringOrEpoll &) = delete;
+  IoUringOrEpoll &operator=(const IoUringOrEpoll &) = delete;
+  IoUringOrEpoll(IoUringOrEpoll &&) = delete;
+  IoUringOrEpoll &operator=(IoUringOrEpoll &&) = delete;
+  ~IoUringOrEpoll() final = default;
+
+  // affects only polls, which are initialized after the call
+  static void set_use_io_uring(bool use_io_uring);
+
+  static bool get_use_io_uring();
+
+  void init() final;
+
+  void clear() final;
+
+  void subscribe(PollableFd fd, PollFlags flags) final;
+
+  void unsubscribe(PollableFdRef fd) final;
+
+  void unsubscribe_before_close(PollableFdRef fd) final;
+
+  void run(int timeout_ms) final;
+
+  static bool is_edge_triggered() {
+    return true;
+  }
+
+ private:
+  Epoll epoll_;
+  IoUring io_uring_;
+  PollBase *poll_ = nullptr;
+};
+
+}  // namespace detail
+}  // namespace td
+
+#endif
@@ -118,4 +118,8 @@
 #define TD_HAVE_INT128 1
 #endif
 
+#if defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)))
+#define TD_SSE2 1
+#endif
+
 // clang-format on
@@ -58,6 +58,25 @@ BufferSlice TlBufferParser::as_buffer_slice(Slice slice) {
   return BufferSlice(slice);
 }
 
+BufferSlice TlBufferParser::fetch_string_view() {
+  auto result = TlParser::fetch_string<Slice>();
+  if (result.empty()) {
+    return BufferSlice();
+  }
+  auto buffer = parent_->as_slice();
+  if (buffer.begin() <= result.begin() && result.end() <= buffer.end() && result.find('\0') == Slice::npos &&
+      check_utf8_unterminated(result)) {
+    return parent_->from_slice(result);
+  }
+  return BufferSlice(fix_string(result.str()));
+}
+
+BufferSlice TlBufferParser::get_fetched_buffer_slice(size_t old_left_len) const {
+  auto buffer = parent_->as_slice();
+  CHECK(get_left_len() <= old_left_len && old_left_len <= buffer.size());
+  return parent_->from_slice(buffer.substr(buffer.size() - old_left_len, old_left_len - get_left_len()));
+}
+
 bool TlBufferParser::is_valid_utf8(CSlice str) const {
   if (check_utf8(str)) {
     return true;
@@ -198,7 +198,25 @@ class TlBufferParser : public TlParser {
 
   template <class T>
   T fetch_string() {
-    auto result = TlParser::fetch_string<T>();
+    return fix_string(TlParser::fetch_string<T>());
+  }
+
+  // returns a string sharing memory with the parsed buffer whenever possible
+  BufferSlice fetch_string_view();
+
+  // returns the part of the parsed buffer, which was fetched since get_left_len() returned old_left_len
+  BufferSlice get_fetched_buffer_slice(size_t old_left_len) const;
+
+  template <class T>
+  T fetch_string_raw(const size_t size) {
+    return TlParser::fetch_string_raw<T>(size);
+  }
+
+ private:
+  const BufferSlice *parent_;
+
+  template <class T>
+  T fix_string(T result) {
     for (auto &c : result) {
       if (c == '\0') {
         c = ' ';
@@ -215,14 +233,6 @@ class TlBufferParser : public TlParser {
     return T();
   }
 
-  template <class T>
-  T fetch_string_raw(const size_t size) {
-    return TlParser::fetch_string_raw<T>(size);
-  }
-
- private:
-  const BufferSlice *parent_;
-
   BufferSlice as_buffer_slice(Slice slice);
 
   bool is_valid_utf8(CSlice str) const;
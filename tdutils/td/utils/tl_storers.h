@@ -6,12 +6,14 @@
 //
 #pragma once
 
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StorerBase.h"
 
 #include <cstring>
+#include <utility>
 
 namespace td {
 
@@ -140,6 +142,98 @@ class TlStorerCalcLength {
   }
 };
 
+class TlStorerBuffer {
+  BufferWriter buffer_;
+  unsigned char *begin_ = nullptr;
+  unsigned char *buf_ = nullptr;
+  unsigned char *end_ = nullptr;
+  size_t prepend_size_ = 0;
+
+  void reserve(size_t size) {
+    if (static_cast<size_t>(end_ - buf_) < size) {
+      grow(size);
+    }
+  }
+
+  void grow(size_t size) {
+    auto length = get_length();
+    auto capacity = td::max(2 * static_cast<size_t>(end_ - begin_), length + size);
+    BufferWriter new_buffer(0, prepend_size_, capacity);
+    auto new_data = new_buffer.prepare_append();
+    if (length != 0) {
+      std::memcpy(new_data.ubegin(), begin_, length);
+    }
+    buffer_ = std::move(new_buffer);
+    begin_ = new_data.ubegin();
+    buf_ = begin_ + length;
+    end_ = new_data.uend();
+  }
+
+ public:
+  // the buffer is allocated on the first store; prepend_size must be a multiple of 4 to keep the data aligned
+  explicit TlStorerBuffer(size_t capacity = 0, size_t prepend_size = 0) : prepend_size_(prepend_size) {
+    if (capacity != 0) {
+      grow(capacity);
+    }
+  }
+
+  TlStorerBuffer(const TlStorerBuffer &) = delete;
+  TlStorerBuffer &operator=(const TlStorerBuffer &) = delete;
+
+  template <class T>
+  void store_binary(const T &x) {
+    reserve(sizeof(T));
+    std::memcpy(buf_, &x, sizeof(T));
+    buf_ += sizeof(T);
+  }
+
+  void store_int(int32 x) {
+    store_binary<int32>(x);
+  }
+
+  void store_long(int64 x) {
+    store_binary<int64>(x);
+  }
+
+  void store_slice(Slice slice) {
+    reserve(slice.size());
+    std::memcpy(buf_, slice.begin(), slice.size());
+    buf_ += slice.size();
+  }
+
+  void store_storer(const Storer &storer) {
+    reserve(storer.size());
+    size_t size = storer.store(buf_);
+    buf_ += size;
+  }
+
+  template <class T>
+  void store_string(const T &str) {
+    reserve(str.size() + 11);
+    TlStorerUnsafe storer(buf_);
+    storer.store_string(str);
+    buf_ = storer.get_buf();
+  }
+
+  size_t get_length() const {
+    return static_cast<size_t>(buf_ - begin_);
+  }
+
+  // returns the stored data with prepend_size bytes available for prepending
+  BufferWriter move_as_buffer_writer() {
+    if (buffer_.is_null()) {
+      grow(0);
+    }
+    buffer_.confirm_append(get_length());
+    begin_ = buf_ = end_ = nullptr;
+    return std::move(buffer_);
+  }
+
+  BufferSlice move_as_buffer_slice() {
+    return move_as_buffer_writer().as_buffer_slice();
+  }
+};
+
 template <class T>
 size_t tl_calc_length(const T &data) {
   TlStorerCalcLength storer_calc_length;
@@ -6,21 +6,58 @@
 //
 #include "td/utils/utf8.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/unicode.h"
 
+#ifdef __aarch64__
+#include <arm_neon.h>
+#elif TD_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace td {
 
-bool check_utf8(CSlice str) {
-  const char *data = str.data();
-  const char *data_end = data + str.size();
+// returns a pointer to the first non-ASCII character or data_end
+static const char *skip_ascii(const char *data, const char *data_end) {
+#ifdef __aarch64__
+  while (data_end - data >= 16) {
+    auto input = vld1q_u8(reinterpret_cast<const uint8 *>(data));
+    if (vmaxvq_u8(input) >= 0x80) {
+      break;
+    }
+    data += 16;
+  }
+#elif TD_SSE2
+  while (data_end - data >= 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    auto mask = static_cast<uint32>(_mm_movemask_epi8(input));
+    if (mask != 0) {
+      return data + count_trailing_zeroes_non_zero32(mask);
+    }
+    data += 16;
+  }
+#endif
+  while (data != data_end && (static_cast<unsigned char>(*data) & 0x80) == 0) {
+    data++;
+  }
+  return data;
+}
+
+// if is_null_terminated, then *data_end must be '\0' and is used as a sentinel
+template <bool is_null_terminated>
+static bool check_utf8_impl(const char *data, const char *data_end) {
   do {
+    if (!is_null_terminated && data == data_end) {
+      return true;
+    }
     uint32 a = static_cast<unsigned char>(*data++);
     if ((a & 0x80) == 0) {
-      if (data == data_end + 1) {
+      if (is_null_terminated && data == data_end + 1) {
         return true;
       }
+      data = skip_ascii(data, data_end);
       continue;
     }
 
@@ -31,6 +68,7 @@ bool check_utf8(CSlice str) {
 
     ENSURE((a & 0x40) != 0);
 
+    ENSURE(is_null_terminated || data != data_end);
     uint32 b = static_cast<unsigned char>(*data++);
     ENSURE((b & 0xc0) == 0x80);
     if ((a & 0x20) == 0) {
@@ -38,6 +76,7 @@ bool check_utf8(CSlice str) {
       continue;
     }
 
+    ENSURE(is_null_terminated || data != data_end);
     uint32 c = static_cast<unsigned char>(*data++);
     ENSURE((c & 0xc0) == 0x80);
     if ((a & 0x10) == 0) {
@@ -46,6 +85,7 @@ bool check_utf8(CSlice str) {
       continue;
     }
 
+    ENSURE(is_null_terminated || data != data_end);
     uint32 d = static_cast<unsigned char>(*data++);
     ENSURE((d & 0xc0) == 0x80);
     if ((a & 0x08) == 0) {
@@ -62,6 +102,14 @@ bool check_utf8(CSlice str) {
   return false;
 }
 
+bool check_utf8(CSlice str) {
+  return check_utf8_impl<true>(str.data(), str.data() + str.size());
+}
+
+bool check_utf8_unterminated(Slice str) {
+  return check_utf8_impl<false>(str.data(), str.data() + str.size());
+}
+
 const unsigned char *next_utf8_unsafe(const unsigned char *ptr, uint32 *code) {
   uint32 a = ptr[0];
   if ((a & 0x80) == 0) {
@@ -156,14 +204,122 @@ string utf8_encode(CSlice data) {
   return PSTRING() << "url_decode(" << url_encode(data) << ')';
 }
 
+#if defined(__aarch64__) || TD_SSE2
+// skips all whole 16-byte blocks starting at data and adds to the counters the number of continuation code units
+// and the number of first code units of 4-byte characters in them
+static void count_utf8_code_units(const char *&data, const char *data_end, size_t &continuation_count,
+                                  size_t &four_byte_count) {
+  while (data_end - data >= 16) {
+    // byte counters can't overflow in 255 iterations
+    auto block_count = min(static_cast<size_t>(data_end - data) / 16, static_cast<size_t>(255));
+    auto blocks_end = data + block_count * 16;
+#ifdef __aarch64__
+    auto continuations = vdupq_n_u8(0);
+    auto four_bytes = vdupq_n_u8(0);
+    for (; data != blocks_end; data += 16) {
+      auto input = vld1q_u8(reinterpret_cast<const uint8 *>(data));
+      continuations = vsubq_u8(continuations, vceqq_u8(vandq_u8(input, vdupq_n_u8(0xC0)), vdupq_n_u8(0x80)));
+      four_bytes =
+          vsubq_u8(four_bytes, vandq_u8(vcgeq_u8(input, vdupq_n_u8(0xF0)), vcleq_u8(input, vdupq_n_u8(0xF7))));
+    }
+    continuation_count += vaddlvq_u8(continuations);
+    four_byte_count += vaddlvq_u8(four_bytes);
+#else
+    auto continuations = _mm_setzero_si128();
+    auto four_bytes = _mm_setzero_si128();
+    for (; data != blocks_end; data += 16) {
+      auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+      // continuation code units are exactly the bytes less than -64 if treated as signed
+      continuations = _mm_sub_epi8(continuations, _mm_cmplt_epi8(input, _mm_set1_epi8(-64)));
+      // first code units of 4-byte characters are the bytes between 0xF0 and 0xF7
+      auto is_four_byte =
+          _mm_cmpeq_epi8(_mm_max_epu8(_mm_min_epu8(input, _mm_set1_epi8(static_cast<char>(0xF7))),
+                                      _mm_set1_epi8(static_cast<char>(0xF0))),
+                         input);
+      four_bytes = _mm_sub_epi8(four_bytes, is_four_byte);
+    }
+    auto continuation_sums = _mm_sad_epu8(continuations, _mm_setzero_si128());
+    auto four_byte_sums = _mm_sad_epu8(four_bytes, _mm_setzero_si128());
+    continuation_count += static_cast<size_t>(_mm_cvtsi128_si32(continuation_sums) +
+                                              _mm_cvtsi128_si32(_mm_srli_si128(continuation_sums, 8)));
+    four_byte_count += static_cast<size_t>(_mm_cvtsi128_si32(four_byte_sums) +
+                                           _mm_cvtsi128_si32(_mm_srli_si128(four_byte_sums, 8)));
+#endif
+  }
+}
+
+// returns number of first code units of UTF-8 characters among 16 bytes starting at data
+static size_t count_utf8_first_code_units16(const char *data) {
+#ifdef __aarch64__
+  auto input = vld1q_u8(reinterpret_cast<const uint8 *>(data));
+  auto is_continuation = vceqq_u8(vandq_u8(input, vdupq_n_u8(0xC0)), vdupq_n_u8(0x80));
+  return 16 - vaddvq_u8(vshrq_n_u8(is_continuation, 7));
+#else
+  auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  auto is_continuation = _mm_and_si128(_mm_cmplt_epi8(input, _mm_set1_epi8(-64)), _mm_set1_epi8(1));
+  auto sums = _mm_sad_epu8(is_continuation, _mm_setzero_si128());
+  return 16 - static_cast<size_t>(_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+#endif
+}
+#endif
+
+size_t utf8_length(Slice str) {
+  size_t result = 0;
+  const char *data = str.begin();
+  const char *data_end = str.end();
+#if defined(__aarch64__) || TD_SSE2
+  size_t continuation_count = 0;
+  size_t four_byte_count = 0;
+  count_utf8_code_units(data, data_end, continuation_count, four_byte_count);
+  result = static_cast<size_t>(data - str.begin()) - continuation_count;
+#endif
+  while (data != data_end) {
+    result += is_utf8_character_first_code_unit(*data++);
+  }
+  return result;
+}
+
 size_t utf8_utf16_length(Slice str) {
   size_t result = 0;
-  for (auto c : str) {
+  const char *data = str.begin();
+  const char *data_end = str.end();
+#if defined(__aarch64__) || TD_SSE2
+  size_t continuation_count = 0;
+  size_t four_byte_count = 0;
+  count_utf8_code_units(data, data_end, continuation_count, four_byte_count);
+  result = static_cast<size_t>(data - str.begin()) - continuation_count + four_byte_count;
+#endif
+  while (data != data_end) {
+    auto c = *data++;
     result += is_utf8_character_first_code_unit(c) + ((c & 0xf8) == 0xf0);
   }
   return result;
 }
 
+size_t utf8_truncate_size(Slice str, size_t length) {
+  const char *data = str.begin();
+  const char *data_end = str.end();
+#if defined(__aarch64__) || TD_SSE2
+  while (data_end - data >= 16) {
+    auto count = count_utf8_first_code_units16(data);
+    if (count > length) {
+      break;
+    }
+    length -= count;
+    data += 16;
+  }
+#endif
+  for (; data != data_end; data++) {
+    if (is_utf8_character_first_code_unit(static_cast<unsigned char>(*data))) {
+      if (length == 0) {
+        break;
+      }
+      length--;
+    }
+  }
+  return static_cast<size_t>(data - str.begin());
+}
+
 Slice utf8_utf16_truncate(Slice str, size_t length) {
   for (size_t i = 0; i < str.size(); i++) {
     auto c = static_cast<unsigned char>(str[i]);
@@ -14,19 +14,16 @@ namespace td {
 /// checks UTF-8 string for correctness
 bool check_utf8(CSlice str);
 
+/// checks UTF-8 string for correctness, the string doesn't need to be null-terminated
+bool check_utf8_unterminated(Slice str);
+
 /// checks if a code unit is a first code unit of a UTF-8 character
 inline bool is_utf8_character_first_code_unit(unsigned char c) {
   return (c & 0xC0) != 0x80;
 }
 
 /// returns length of UTF-8 string in characters
-inline size_t utf8_length(Slice str) {
-  size_t result = 0;
-  for (auto c : str) {
-    result += is_utf8_character_first_code_unit(c);
-  }
-  return result;
-}
+size_t utf8_length(Slice str);
 
 /// returns length of UTF-8 string in UTF-16 code units
 size_t utf8_utf16_length(Slice str);
@@ -65,18 +62,16 @@ const unsigned char *next_utf8_unsafe(const unsigned char *ptr, uint32 *code);
 /// appends a Unicode character using UTF-8 encoding and returns updated pointer
 unsigned char *append_utf8_character_unsafe(unsigned char *ptr, uint32 code);
 
+/// returns size of the longest prefix of UTF-8 string, containing at most length characters
+size_t utf8_truncate_size(Slice str, size_t length);
+
 /// truncates UTF-8 string to the given length in Unicode characters
 template <class T>
 T utf8_truncate(T str, size_t length) {
   if (str.size() > length) {
-    for (size_t i = 0; i < str.size(); i++) {
-      if (is_utf8_character_first_code_unit(static_cast<unsigned char>(str[i]))) {
-        if (length == 0) {
-          return str.substr(0, i);
-        } else {
-          length--;
-        }
-      }
+    auto size = utf8_truncate_size(str, length);
+    if (size < str.size()) {
+      return str.substr(0, size);
     }
   }
   return str;
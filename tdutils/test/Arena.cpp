@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/Arena.h"
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+TEST(Arena, allocate) {
+  td::Arena arena(1024);
+  ASSERT_EQ(0u, arena.get_capacity());
+  ASSERT_EQ(0u, arena.get_used_size());
+
+  td::vector<std::pair<char *, size_t>> ptrs;
+  for (int i = 0; i < 10000; i++) {
+    auto size = static_cast<size_t>(td::Random::fast(1, 3000));
+    size_t alignment = static_cast<size_t>(1) << td::Random::fast(0, 6);
+    auto ptr = static_cast<char *>(arena.allocate(size, alignment));
+    ASSERT_EQ(0u, reinterpret_cast<std::uintptr_t>(ptr) % alignment);
+    std::memset(ptr, static_cast<int>(size & 255), size);
+    ptrs.emplace_back(ptr, size);
+  }
+  for (auto &it : ptrs) {
+    for (size_t i = 0; i < it.second; i++) {
+      ASSERT_EQ(static_cast<char>(it.second & 255), it.first[i]);
+    }
+  }
+  ASSERT_TRUE(arena.get_used_size() <= arena.get_capacity());
+
+  arena.reset();
+  ASSERT_EQ(0u, arena.get_used_size());
+  ASSERT_TRUE(arena.get_capacity() <= 3000 + 64);
+}
+
+TEST(Arena, rollback) {
+  td::Arena arena(256);
+  arena.allocate(100);
+  auto checkpoint = arena.get_checkpoint();
+  auto used_size = arena.get_used_size();
+  auto first = arena.allocate(10);
+  auto first_used_size = arena.get_used_size();
+  {
+    td::Arena::Scope scope(arena);
+    for (int i = 0; i < 100; i++) {
+      arena.allocate(100);
+    }
+  }
+  ASSERT_EQ(first_used_size, arena.get_used_size());
+  auto capacity = arena.get_capacity();
+
+  arena.rollback(checkpoint);
+  ASSERT_EQ(used_size, arena.get_used_size());
+  ASSERT_EQ(first, arena.allocate(10));
+
+  // chunks are reused after rollback
+  for (int i = 0; i < 100; i++) {
+    arena.allocate(100);
+  }
+  ASSERT_EQ(capacity, arena.get_capacity());
+}
+
+TEST(Arena, containers) {
+  td::Arena arena;
+  td::Arena::Scope scope(arena);
+  td::ArenaVector<int> v{td::ArenaAllocator<int>(arena)};
+  for (int i = 0; i < 1000; i++) {
+    v.push_back(i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i, v[i]);
+  }
+
+  using ArenaString = std::basic_string<char, std::char_traits<char>, td::ArenaAllocator<char>>;
+  ArenaString s{td::ArenaAllocator<char>(arena)};
+  for (int i = 0; i < 100; i++) {
+    s += "abacaba";
+  }
+  ASSERT_EQ(700u, s.size());
+  ASSERT_TRUE(arena.get_used_size() > 700u);
+}
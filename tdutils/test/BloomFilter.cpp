@@ -0,0 +1,38 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/BloomFilter.h"
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+TEST(BloomFilter, no_false_negatives) {
+  td::BloomFilter filter(10000);
+  td::vector<td::uint64> hashes;
+  for (int i = 0; i < 20000; i++) {
+    hashes.push_back(td::Random::fast_uint64());
+    filter.add(hashes.back());
+    ASSERT_EQ(hashes.size(), filter.size());
+  }
+  for (auto hash : hashes) {
+    ASSERT_TRUE(filter.may_contain(hash));
+  }
+}
+
+TEST(BloomFilter, false_positive_rate) {
+  td::BloomFilter filter(10000);
+  ASSERT_EQ(10000u, filter.capacity());
+  for (int i = 0; i < 10000; i++) {
+    filter.add(td::Random::fast_uint64());
+  }
+  int false_positive_count = 0;
+  for (int i = 0; i < 100000; i++) {
+    if (filter.may_contain(td::Random::fast_uint64())) {
+      false_positive_count++;
+    }
+  }
+  ASSERT_TRUE(false_positive_count < 2000);
+}
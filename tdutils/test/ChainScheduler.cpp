@@ -60,6 +60,46 @@ TEST(ChainScheduler, SendAfterRestart) {
   ASSERT_TRUE(!scheduler.start_next_task());
 }
 
+TEST(ChainScheduler, MaxActiveTasks) {
+  td::ChainScheduler<int> scheduler(3);
+  std::vector<td::ChainScheduler<int>::ChainId> chains{1};
+
+  td::vector<td::ChainScheduler<int>::TaskId> task_ids;
+  for (int i = 0; i < 10; i++) {
+    task_ids.push_back(scheduler.create_task(chains, i));
+  }
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(task_ids[i], scheduler.start_next_task().unwrap().task_id);
+  }
+  ASSERT_TRUE(!scheduler.start_next_task());
+
+  auto stats = scheduler.get_stats();
+  ASSERT_EQ(1u, stats.chain_count);
+  ASSERT_EQ(10u, stats.task_count);
+  ASSERT_EQ(3u, stats.active_task_count);
+  ASSERT_EQ(10u, stats.max_chain_length);
+  ASSERT_EQ(3u, stats.started_task_count);
+  ASSERT_TRUE(stats.limited_task_count > 0);
+
+  scheduler.finish_task(task_ids[0]);
+  ASSERT_EQ(task_ids[3], scheduler.start_next_task().unwrap().task_id);
+  ASSERT_TRUE(!scheduler.start_next_task());
+
+  scheduler.set_max_active_tasks(5);
+  ASSERT_EQ(task_ids[4], scheduler.start_next_task().unwrap().task_id);
+  ASSERT_EQ(task_ids[5], scheduler.start_next_task().unwrap().task_id);
+  ASSERT_TRUE(!scheduler.start_next_task());
+
+  scheduler.reset_task(task_ids[1]);
+  ASSERT_EQ(task_ids[1], scheduler.start_next_task().unwrap().task_id);
+  ASSERT_TRUE(!scheduler.start_next_task());
+
+  stats = scheduler.get_stats();
+  ASSERT_EQ(9u, stats.max_chain_length);
+  ASSERT_EQ(1u, stats.reset_task_count);
+  ASSERT_EQ(7u, stats.started_task_count);
+}
+
 TEST(ChainScheduler, Basic) {
   td::ChainScheduler<int> scheduler;
   for (int i = 0; i < 100; i++) {
@@ -5,18 +5,22 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/utils/algorithm.h"
+#include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashMapChunks.h"
+#include "td/utils/FlatHashMapSwiss.h"
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/tests.h"
 
 #include <algorithm>
 #include <array>
+#include <functional>
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
@@ -450,3 +454,144 @@ TEST(FlatHashSet, stress_test) {
     runner.step(rnd);
   }
 }
+
+TEST(FlatHashMapSwiss, basic) {
+  td::FlatHashMapSwiss<td::int32, td::string> map = {{1, "hello"}, {2, "world"}, {1, "again"}};
+  ASSERT_EQ(2u, map.size());
+  ASSERT_EQ("hello", map[1]);
+  ASSERT_EQ("world", map.find(2)->second);
+  ASSERT_TRUE(map.find(3) == map.end());
+  map.erase(map.find(1));
+  ASSERT_EQ(0u, map.count(1));
+  ASSERT_EQ("", map[3]);
+  ASSERT_EQ(2u, map.size());
+
+  td::FlatHashSetSwiss<td::Slice, td::SliceHash> set{"1", "22", "333"};
+  ASSERT_EQ(3u, set.size());
+  ASSERT_EQ(1u, set.count("22"));
+  ASSERT_EQ(0u, set.count("4444"));
+}
+
+TEST(FlatHashMapSwiss, stress_test) {
+  td::Random::Xorshift128plus rnd(123);
+  std::unordered_map<td::uint64, td::uint64, td::Hash<td::uint64>> ref;
+  td::FlatHashMapSwiss<td::uint64, td::uint64> tbl;
+
+  auto validate = [&] {
+    ASSERT_EQ(ref.size(), tbl.size());
+    ASSERT_EQ(extract_kv(ref), extract_kv(tbl));
+    for (auto &kv : ref) {
+      auto tbl_it = tbl.find(kv.first);
+      ASSERT_TRUE(tbl_it != tbl.end());
+      ASSERT_EQ(kv.second, tbl_it->second);
+    }
+  };
+
+  for (int test_i = 0; test_i < 100; test_i++) {
+    auto max_key = static_cast<td::uint64>(rnd.fast(1, 4000));
+    for (int i = 0; i < 20000; i++) {
+      auto key = rnd() % max_key + 1;
+      switch (rnd.fast(0, 3)) {
+        case 0:
+        case 1: {
+          auto value = rnd();
+          ref[key] = value;
+          tbl[key] = value;
+          break;
+        }
+        case 2:
+          ASSERT_EQ(ref.erase(key), tbl.erase(key));
+          break;
+        case 3:
+          ASSERT_EQ(ref.count(key), tbl.count(key));
+          break;
+      }
+    }
+    validate();
+
+    auto mul = rnd();
+    auto condition = [&](auto &it) {
+      return ((it.second * mul) >> 63) == 0;
+    };
+    td::table_remove_if(tbl, condition);
+    td::table_remove_if(ref, condition);
+    validate();
+
+    if (rnd.fast(0, 9) == 0) {
+      td::reset_to_empty(ref);
+      td::reset_to_empty(tbl);
+    }
+  }
+}
+
+TEST(HashTableUtils, hash_bytes) {
+  td::string data(300, '\0');
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 7 + 1);
+  }
+
+  td::FlatHashSet<td::uint64> hashes;
+  for (size_t length = 0; length <= data.size(); length++) {
+    auto hash = td::hash_bytes(data.data(), length);
+    hashes.insert(hash);
+
+    td::string copy(data.substr(0, length));
+    ASSERT_EQ(hash, td::hash_bytes(copy.data(), copy.size()));
+    ASSERT_EQ(static_cast<td::uint32>(hash), td::Hash<td::string>()(copy));
+    ASSERT_EQ(static_cast<td::uint32>(hash), td::SliceHash()(copy));
+
+    // changes of any bit must change the hash
+    for (size_t i = 0; i < length; i++) {
+      for (int bit = 0; bit < 8; bit += 3) {
+        copy[i] = static_cast<char>(copy[i] ^ (1 << bit));
+        hashes.insert(td::hash_bytes(copy.data(), copy.size()));
+        copy[i] = static_cast<char>(copy[i] ^ (1 << bit));
+      }
+    }
+  }
+  ASSERT_EQ(data.size() + 1 + 3 * data.size() * (data.size() + 1) / 2, hashes.size());
+}
+
+template <class HashT>
+class StringHashBenchmark final : public td::Benchmark {
+ public:
+  StringHashBenchmark(td::Slice name, size_t length) : name_(name.str()), length_(length) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << name_ << " of strings with length " << length_;
+  }
+
+  void start_up() final {
+    for (auto &str : strings_) {
+      str = td::rand_string('a', 'z', length_);
+    }
+  }
+
+  void run(int n) final {
+    td::uint32 result = 0;
+    for (int i = 0; i < n; i++) {
+      result += HashT()(strings_[i & (STRING_COUNT - 1)]);
+    }
+    td::do_not_optimize_away(result);
+  }
+
+ private:
+  static constexpr int STRING_COUNT = 1024;
+  td::string name_;
+  size_t length_;
+  td::string strings_[STRING_COUNT];
+};
+
+struct StdStringHash {
+  td::uint32 operator()(const td::string &value) const {
+    return static_cast<td::uint32>(std::hash<td::string>()(value));
+  }
+};
+
+TEST(HashTableUtils, string_hash_benchmark) {
+  for (size_t length : {8, 64, 1000}) {
+    td::bench(StringHashBenchmark<StdStringHash>("std::hash", length));
+    td::bench(StringHashBenchmark<td::Hash<td::string>>("td::Hash", length));
+  }
+}
@@ -0,0 +1,89 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/algorithm.h"
+#include "td/utils/common.h"
+#include "td/utils/Hints.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <map>
+
+TEST(Hints, search) {
+  td::Hints hints;
+  hints.add(1, "Alice Smith");
+  hints.add(2, "Bob Smithson");
+  hints.add(3, "Alice Cooper");
+  hints.set_rating(1, 3);
+  hints.set_rating(2, 2);
+  hints.set_rating(3, 1);
+
+  ASSERT_EQ(3u, hints.size());
+  ASSERT_TRUE(hints.search("smi", 10).second == td::vector<td::int64>({2, 1}));
+  ASSERT_TRUE(hints.search("alice", 10).second == td::vector<td::int64>({3, 1}));
+  ASSERT_TRUE(hints.search("alice smi", 10).second == td::vector<td::int64>({1}));
+  ASSERT_EQ(2u, hints.search("alice", 1).first);
+  ASSERT_TRUE(hints.search("alice", 1).second == td::vector<td::int64>({3}));
+  ASSERT_TRUE(hints.search("carol", 10).second.empty());
+
+  hints.add(1, "Carol");
+  ASSERT_TRUE(hints.search("alice", 10).second == td::vector<td::int64>({3}));
+  ASSERT_TRUE(hints.search("carol", 10).second == td::vector<td::int64>({1}));
+  ASSERT_EQ("Carol", hints.key_to_string(1));
+
+  hints.remove(1);
+  ASSERT_TRUE(!hints.has_key(1));
+  ASSERT_TRUE(hints.search("carol", 10).second.empty());
+  ASSERT_EQ(2u, hints.size());
+}
+
+TEST(Hints, stress_test) {
+  td::Hints hints;
+  std::map<td::int64, td::vector<td::string>> key_words;
+  auto get_word = [] {
+    td::string word;
+    auto length = td::Random::fast(1, 3);
+    for (int i = 0; i < length; i++) {
+      word += static_cast<char>('a' + td::Random::fast(0, 2));
+    }
+    return word;
+  };
+
+  for (int i = 0; i < 10000; i++) {
+    auto key = static_cast<td::int64>(td::Random::fast(1, 100));
+    if (td::Random::fast(0, 3) == 0) {
+      hints.remove(key);
+      key_words.erase(key);
+    } else {
+      td::vector<td::string> words;
+      td::string name;
+      auto word_count = td::Random::fast(1, 3);
+      for (int j = 0; j < word_count; j++) {
+        auto word = get_word();
+        if (!name.empty()) {
+          name += ' ';
+        }
+        name += word;
+        words.push_back(std::move(word));
+      }
+      hints.add(key, name);
+      hints.set_rating(key, key);
+      key_words[key] = std::move(words);
+    }
+
+    auto query = get_word();
+    td::vector<td::int64> expected;
+    for (auto &it : key_words) {
+      if (td::any_of(it.second, [&](const td::string &word) { return td::begins_with(word, query); })) {
+        expected.push_back(it.first);
+      }
+    }
+    auto result = hints.search(query, 1000);
+    ASSERT_EQ(expected.size(), result.first);
+    ASSERT_TRUE(expected == result.second);
+  }
+}
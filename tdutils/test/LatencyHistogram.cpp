@@ -0,0 +1,116 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/LatencyHistogram.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/tests.h"
+
+#include <cmath>
+
+TEST(LatencyHistogram, buckets) {
+  using td::LatencyHistogram;
+  ASSERT_EQ(0u, LatencyHistogram::get_bucket(0.0));
+  ASSERT_EQ(0u, LatencyHistogram::get_bucket(-1.0));
+  ASSERT_EQ(0u, LatencyHistogram::get_bucket(0.5e-6));
+  ASSERT_EQ(1u, LatencyHistogram::get_bucket(1.5e-6));
+  ASSERT_EQ(2u, LatencyHistogram::get_bucket(2e-6));
+  ASSERT_EQ(3u, LatencyHistogram::get_bucket(3e-6));
+  ASSERT_EQ(4u, LatencyHistogram::get_bucket(4e-6));
+  ASSERT_EQ(5u, LatencyHistogram::get_bucket(7e-6));
+  ASSERT_EQ(LatencyHistogram::BUCKET_COUNT - 1, LatencyHistogram::get_bucket(100.0));
+  ASSERT_EQ(LatencyHistogram::BUCKET_COUNT - 1, LatencyHistogram::get_bucket(1e100));
+
+  double last_upper_bound = 0.0;
+  for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; bucket++) {
+    auto upper_bound = LatencyHistogram::get_bucket_upper_bound(bucket);
+    ASSERT_TRUE(upper_bound > last_upper_bound);
+    if (bucket + 1 < LatencyHistogram::BUCKET_COUNT) {
+      ASSERT_EQ(bucket, LatencyHistogram::get_bucket(upper_bound * 0.999));
+      ASSERT_EQ(bucket + 1, LatencyHistogram::get_bucket(upper_bound * 1.001));
+    }
+    last_upper_bound = upper_bound;
+  }
+}
+
+TEST(LatencyHistogram, percentiles) {
+  td::LatencyHistogram histogram;
+  auto snapshot = histogram.get_snapshot();
+  ASSERT_EQ(0u, snapshot.count);
+  ASSERT_EQ(0.0, snapshot.get_average());
+
+  for (int i = 0; i < 90; i++) {
+    histogram.add(100e-6);
+  }
+  for (int i = 0; i < 10; i++) {
+    histogram.add(0.1);
+  }
+  snapshot = histogram.get_snapshot();
+  ASSERT_EQ(100u, snapshot.count);
+  ASSERT_TRUE(std::abs(snapshot.total_time - 1.009) < 1e-6);
+  auto p50 = snapshot.get_percentile(0.5);
+  ASSERT_TRUE(p50 >= 100e-6 && p50 <= 150e-6);
+  auto p99 = snapshot.get_percentile(0.99);
+  ASSERT_TRUE(p99 >= 0.1 && p99 <= 0.15);
+
+  histogram.clear();
+  ASSERT_EQ(0u, histogram.get_snapshot().count);
+}
+
+TEST(LatencyHistogram, threads) {
+  td::LatencyHistogram histogram;
+  td::vector<td::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&histogram, i] {
+      for (int j = 0; j < 1000; j++) {
+        histogram.add(1e-3 * (i + 1));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto snapshot = histogram.get_snapshot();
+  ASSERT_EQ(4000u, snapshot.count);
+  ASSERT_TRUE(std::abs(snapshot.total_time - 10.0) < 1e-3);
+}
+
+TEST(LatencyHistogram, named) {
+  auto histogram = td::LatencyHistogram::get("test histogram");
+  ASSERT_TRUE(histogram == td::LatencyHistogram::get("test histogram"));
+  ASSERT_TRUE(histogram != td::LatencyHistogram::get("other test histogram"));
+  ASSERT_TRUE(td::LatencyHistogram::get_statistics().find("test histogram") == td::string::npos);
+  {
+    td::LatencyHistogram::Timer timer(histogram);
+  }
+  ASSERT_EQ(1u, histogram->get_snapshot().count);
+  auto statistics = td::LatencyHistogram::get_statistics();
+  ASSERT_TRUE(statistics.find("test histogram: 1 calls") != td::string::npos);
+  ASSERT_TRUE(statistics.find("other test histogram") == td::string::npos);
+}
+
+TEST(LatencyHistogram, file_io) {
+  td::CSlice path = "latency_histogram_test.txt";
+  td::unlink(path).ignore();
+  auto fd = td::FileFd::open(path, td::FileFd::Write | td::FileFd::Read | td::FileFd::Create).move_as_ok();
+  fd.pwrite("abc", 0).ensure();
+  {
+    td::FileFd::IoCategoryGuard guard("test");
+    fd.pwrite("abc", 0).ensure();
+    fd.pwrite("abc", 3).ensure();
+    fd.sync().ensure();
+  }
+  fd.sync().ensure();
+  fd.close();
+  td::unlink(path).ignore();
+
+  ASSERT_EQ(2u, td::LatencyHistogram::get("file write test")->get_snapshot().count);
+  ASSERT_EQ(1u, td::LatencyHistogram::get("file sync test")->get_snapshot().count);
+  ASSERT_EQ(0u, td::LatencyHistogram::get("file read test")->get_snapshot().count);
+}
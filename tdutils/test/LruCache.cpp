@@ -0,0 +1,139 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/LruCache.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Random.h"
+#include "td/utils/Status.h"
+#include "td/utils/tests.h"
+
+#include <atomic>
+#include <map>
+
+TEST(LruCache, eviction) {
+  td::LruCache<int, td::string> cache(3);
+  cache.put(1, "a");
+  cache.put(2, "b");
+  cache.put(3, "c");
+  ASSERT_EQ("a", *cache.get(1));
+  cache.put(4, "d");
+  ASSERT_TRUE(cache.get(2) == nullptr);
+  ASSERT_EQ("a", *cache.get(1));
+  ASSERT_EQ("c", *cache.get(3));
+  ASSERT_EQ("d", *cache.get(4));
+  ASSERT_EQ(3u, cache.size());
+
+  cache.put(3, "cc");
+  ASSERT_EQ("cc", *cache.get(3));
+  ASSERT_TRUE(cache.erase(3));
+  ASSERT_TRUE(!cache.erase(3));
+  ASSERT_EQ(2u, cache.size());
+
+  auto stats = cache.get_stats();
+  ASSERT_EQ(1u, stats.eviction_count);
+  ASSERT_EQ(5u, stats.hit_count);
+  ASSERT_EQ(1u, stats.miss_count);
+  ASSERT_EQ(2u, stats.cost);
+
+  cache.clear();
+  ASSERT_EQ(0u, cache.size());
+  ASSERT_EQ(0u, cache.get_stats().cost);
+}
+
+TEST(LruCache, cost) {
+  td::LruCache<int, td::string> cache(10);
+  cache.set_cost_function([](int key, const td::string &value) { return value.size(); });
+  cache.put(1, "aaaa");
+  cache.put(2, "bbbb");
+  cache.put(3, td::string(11, 'c'));
+  ASSERT_TRUE(cache.get(3) == nullptr);
+  ASSERT_EQ(8u, cache.get_stats().cost);
+  cache.put(4, "dddd");
+  ASSERT_TRUE(cache.get(1) == nullptr);
+  ASSERT_EQ(8u, cache.get_stats().cost);
+  cache.put(5, "e", 2);
+  ASSERT_EQ(10u, cache.get_stats().cost);
+  ASSERT_EQ(3u, cache.size());
+}
+
+TEST(LruCache, ttl) {
+  td::LruCache<int, int> cache(10, 0.05);
+  cache.put(1, 1);
+  ASSERT_EQ(1, *cache.get(1));
+  td::usleep_for(100000);
+  ASSERT_TRUE(cache.get(1) == nullptr);
+  ASSERT_EQ(1u, cache.get_stats().expiration_count);
+  ASSERT_EQ(0u, cache.size());
+}
+
+TEST(LruCache, get_or_load) {
+  td::LruCache<int, int> cache(10);
+  std::map<int, td::vector<td::Promise<int>>> loads;
+  cache.set_loader([&](int key, td::Promise<int> promise) { loads[key].push_back(std::move(promise)); });
+
+  td::vector<int> results;
+  auto get = [&](int key) {
+    cache.get_or_load(key, [&](td::Result<int> r_value) { results.push_back(r_value.is_ok() ? r_value.ok() : -1); });
+  };
+  get(1);
+  get(1);
+  get(2);
+  get(1);
+  ASSERT_EQ(2u, loads.size());
+  ASSERT_EQ(1u, loads[1].size());
+  ASSERT_TRUE(results.empty());
+
+  loads[1][0].set_value(10);
+  ASSERT_EQ(td::vector<int>({10, 10, 10}), results);
+  loads[2][0].set_error(td::Status::Error("Failed"));
+  ASSERT_EQ(td::vector<int>({10, 10, 10, -1}), results);
+
+  get(1);
+  ASSERT_EQ(td::vector<int>({10, 10, 10, -1, 10}), results);
+  ASSERT_TRUE(cache.get(2) == nullptr);
+
+  auto stats = cache.get_stats();
+  ASSERT_EQ(2u, stats.load_count);
+  ASSERT_EQ(2u, stats.merged_load_count);
+  ASSERT_EQ(1u, stats.failed_load_count);
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(LruCache, thread_safe) {
+  td::TsLruCache<int, int> cache(100);
+  std::atomic<int> load_count{0};
+  cache.set_loader([&](int key, td::Promise<int> promise) {
+    load_count++;
+    promise.set_value(key * 2);
+  });
+
+  std::atomic<int> error_count{0};
+  td::vector<td::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 100000; j++) {
+        auto key = td::Random::fast(1, 200);
+        cache.get_or_load(key, [&, key](td::Result<int> r_value) {
+          if (r_value.is_error() || r_value.ok() != key * 2) {
+            error_count++;
+          }
+        });
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(0, error_count.load());
+  ASSERT_TRUE(cache.size() <= 100u);
+  auto stats = cache.get_stats();
+  ASSERT_EQ(static_cast<td::uint64>(load_count.load()), stats.load_count);
+  ASSERT_EQ(400000u, stats.hit_count + stats.miss_count);
+}
+#endif
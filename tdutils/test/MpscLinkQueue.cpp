@@ -8,6 +8,7 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/MpscLinkQueue.h"
+#include "td/utils/MpscPollableLinkQueue.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/tests.h"
 
@@ -113,4 +114,46 @@ TEST(MpscLinkQueue, multi_thread) {
     thread.join();
   }
 }
+
+#if !TD_EVENTFD_UNSUPPORTED
+TEST(MpscPollableLinkQueue, multi_thread) {
+  td::MpscPollableLinkQueue<int> queue;
+  queue.init();
+  int threads_n = 10;
+  int queries_n = 100000;
+  std::vector<int> next_value(threads_n);
+  std::vector<td::thread> threads(threads_n);
+  int thread_i = 0;
+  for (auto &thread : threads) {
+    thread = td::thread([&, id = thread_i] {
+      for (int i = 0; i < queries_n; i++) {
+        queue.writer_put(i * threads_n + id);
+      }
+    });
+    thread_i++;
+  }
+
+  int active_threads = threads_n;
+  while (active_threads) {
+    int ready_n = queue.reader_wait();
+    while (ready_n-- > 0) {
+      auto x = queue.reader_get_unsafe();
+      auto thread_id = x % threads_n;
+      x /= threads_n;
+      CHECK(next_value[thread_id] == x);
+      next_value[thread_id]++;
+      if (x + 1 == queries_n) {
+        active_threads--;
+      }
+    }
+    queue.reader_flush();
+  }
+  ASSERT_EQ(0, queue.reader_wait_nonblock());
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  queue.destroy();
+}
+#endif
 #endif
@@ -0,0 +1,67 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Random.h"
+#include "td/utils/SlabAllocator.h"
+#include "td/utils/tests.h"
+
+#include <cstring>
+
+TEST(SlabAllocator, simple) {
+  td::vector<std::pair<char *, size_t>> ptrs;
+  for (int i = 0; i < 10000; i++) {
+    auto size = static_cast<size_t>(td::Random::fast(1, 300));
+    auto ptr = static_cast<char *>(td::SlabAllocator::allocate(size));
+    std::memset(ptr, static_cast<int>(size & 255), size);
+    ptrs.emplace_back(ptr, size);
+    if (td::Random::fast_bool()) {
+      auto pos = static_cast<size_t>(td::Random::fast(0, static_cast<int>(ptrs.size()) - 1));
+      std::swap(ptrs[pos], ptrs.back());
+      auto p = ptrs.back();
+      ptrs.pop_back();
+      for (size_t j = 0; j < p.second; j++) {
+        ASSERT_EQ(static_cast<char>(p.second & 255), p.first[j]);
+      }
+      td::SlabAllocator::deallocate(p.first);
+    }
+  }
+  for (auto &p : ptrs) {
+    td::SlabAllocator::deallocate(p.first);
+  }
+  td::SlabAllocator::deallocate(nullptr);
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(SlabAllocator, cross_thread_free) {
+  td::vector<void *> ptrs;
+  auto allocate_all = [&] {
+    for (int i = 0; i < 10000; i++) {
+      ptrs.push_back(td::SlabAllocator::allocate(64));
+    }
+  };
+  auto free_all_on_other_thread = [&] {
+    td::thread([&] {
+      for (auto ptr : ptrs) {
+        td::SlabAllocator::deallocate(ptr);
+      }
+    }).join();
+    ptrs.clear();
+  };
+
+  allocate_all();
+  free_all_on_other_thread();
+  auto chunk_count = td::SlabAllocator::get_stats().allocated_chunk_count;
+
+  // the memory must be returned to the pool of this thread and reused
+  for (int i = 0; i < 10; i++) {
+    allocate_all();
+    free_all_on_other_thread();
+  }
+  ASSERT_EQ(chunk_count, td::SlabAllocator::get_stats().allocated_chunk_count);
+}
+#endif
@@ -0,0 +1,88 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/SortedChunkedSet.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+TEST(SortedChunkedSet, stress_test) {
+  td::SortedChunkedSet<int, 8> set;
+  std::set<int> std_set;
+  auto check = [&] {
+    ASSERT_EQ(std_set.size(), set.size());
+    ASSERT_EQ(std_set.empty(), set.empty());
+    td::vector<int> values(set.begin(), set.end());
+    ASSERT_TRUE(td::vector<int>(std_set.begin(), std_set.end()) == values);
+  };
+
+  for (int i = 0; i < 100000; i++) {
+    auto value = td::Random::fast(0, 1000);
+    switch (td::Random::fast(0, 4)) {
+      case 0:
+      case 1: {
+        auto result = set.insert(value);
+        ASSERT_EQ(std_set.insert(value).second, result.second);
+        ASSERT_EQ(value, *result.first);
+        break;
+      }
+      case 2:
+        ASSERT_EQ(std_set.erase(value), set.erase(value));
+        break;
+      case 3: {
+        ASSERT_EQ(std_set.count(value), set.count(value));
+        auto it = set.upper_bound(value);
+        auto std_it = std_set.upper_bound(value);
+        ASSERT_EQ(std_it == std_set.end(), it == set.end());
+        if (std_it != std_set.end()) {
+          ASSERT_EQ(*std_it, *it);
+        }
+        it = set.lower_bound(value);
+        std_it = std_set.lower_bound(value);
+        ASSERT_EQ(std_it == std_set.end(), it == set.end());
+        if (std_it != std_set.end()) {
+          ASSERT_EQ(*std_it, *it);
+        }
+        break;
+      }
+      case 4:
+        if (td::Random::fast(0, 1000) == 0) {
+          check();
+        }
+        break;
+    }
+  }
+  check();
+  set.clear();
+  std_set.clear();
+  check();
+}
+
+TEST(SortedChunkedSet, change_while_iterating) {
+  td::SortedChunkedSet<int, 4> set;
+  for (int i = 0; i < 100; i += 2) {
+    set.insert(i);
+  }
+
+  // iterators continue from the next greater value after the set is changed
+  td::vector<int> values;
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    auto value = *it;
+    values.push_back(value);
+    if (value % 2 == 0) {
+      set.erase(value);
+      set.insert(value + 1);
+      set.insert(-1);
+    }
+  }
+  ASSERT_EQ(100u, values.size());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i, values[i]);
+  }
+  ASSERT_EQ(51u, set.size());
+}
@@ -0,0 +1,130 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/SparseWindowQueue.h"
+#include "td/utils/tests.h"
+
+#include <map>
+#include <utility>
+
+namespace {
+
+struct Value {
+  int priority;  // values with the same position are ordered by decreasing priority
+  int id;
+
+  bool operator<(const Value &other) const {
+    return other.priority < priority;
+  }
+};
+
+}  // namespace
+
+TEST(SparseWindowQueue, stress_test) {
+  for (int max_jump : {3, 100, 100000, 1000000000}) {
+    td::SparseWindowQueue<Value> queue;
+    std::multimap<td::int32, Value> std_queue;
+    auto check = [&] {
+      ASSERT_EQ(std_queue.size(), queue.size());
+      ASSERT_EQ(std_queue.empty(), queue.empty());
+      if (std_queue.empty()) {
+        return;
+      }
+      ASSERT_EQ(std_queue.begin()->first, queue.front_position());
+      ASSERT_EQ(std_queue.begin()->second.id, queue.front().id);
+      ASSERT_EQ(std_queue.rbegin()->first, queue.back_position());
+    };
+    auto check_all = [&] {
+      td::vector<std::pair<td::int32, int>> values;
+      queue.foreach([&](td::int32 position, Value &value) { values.emplace_back(position, value.id); });
+      td::vector<std::pair<td::int32, int>> std_values;
+      for (auto &it : std_queue) {
+        std_values.emplace_back(it.first, it.second.id);
+      }
+      ASSERT_TRUE(std_values == values);
+
+      size_t max_count = td::Random::fast(0, 10);
+      values.clear();
+      queue.foreach_first(max_count,
+                          [&](td::int32 position, Value &value) { values.emplace_back(position, value.id); });
+      std_values.resize(td::min(max_count, std_values.size()));
+      ASSERT_TRUE(std_values == values);
+    };
+
+    td::int32 base = td::Random::fast(-1000000, 1000000);
+    int next_id = 0;
+    for (int i = 0; i < 100000; i++) {
+      switch (td::Random::fast(0, 9)) {
+        case 0:
+        case 1:
+        case 2:
+        case 3: {
+          auto position = base + td::Random::fast(-max_jump, max_jump);
+          Value value{td::Random::fast(0, 2), next_id++};
+          // std::multimap inserts values with the same key to the end, so insert the value before the first smaller
+          auto it = std_queue.lower_bound(position);
+          while (it != std_queue.end() && it->first == position && !(value < it->second)) {
+            ++it;
+          }
+          std_queue.emplace_hint(it, position, value);
+          ASSERT_EQ(value.id, queue.insert(position, value).id);
+          break;
+        }
+        case 4: {
+          auto position = base + td::Random::fast(-max_jump, max_jump);
+          auto value = queue.find(position);
+          auto it = std_queue.find(position);
+          if (it == std_queue.end()) {
+            ASSERT_TRUE(value == nullptr);
+          } else {
+            ASSERT_TRUE(value != nullptr);
+            ASSERT_EQ(it->second.id, value->id);
+          }
+          break;
+        }
+        case 5: {
+          auto position = base + td::Random::fast(-max_jump, max_jump);
+          auto &value = queue.get_or_create(position);
+          auto it = std_queue.find(position);
+          if (it == std_queue.end()) {
+            value.priority = 0;
+            value.id = next_id++;
+            std_queue.emplace(position, value);
+          } else {
+            ASSERT_EQ(it->second.id, value.id);
+          }
+          break;
+        }
+        case 6:
+        case 7:
+        case 8:
+          if (!std_queue.empty()) {
+            base = td::clamp(std_queue.begin()->first + td::Random::fast(0, 3), -1000000000, 1000000000);
+            queue.pop_front();
+            std_queue.erase(std_queue.begin());
+          }
+          break;
+        case 9:
+          if (td::Random::fast(0, 100) == 0) {
+            queue.clear();
+            std_queue.clear();
+          } else {
+            check_all();
+          }
+          break;
+      }
+      check();
+    }
+    check_all();
+
+    auto moved_queue = std::move(queue);
+    ASSERT_TRUE(queue.empty());
+    ASSERT_EQ(std_queue.size(), moved_queue.size());
+  }
+}
@@ -0,0 +1,53 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/SharedSlice.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StringPool.h"
+#include "td/utils/tests.h"
+
+TEST(StringPool, intern) {
+  td::StringPool pool;
+  ASSERT_TRUE(pool.intern(td::Slice()).empty());
+
+  auto a = pool.intern("en");
+  auto b = pool.intern(td::string("en"));
+  auto c = pool.intern("ru");
+  ASSERT_EQ("en", a.as_slice());
+  ASSERT_EQ("ru", c.as_slice());
+  ASSERT_TRUE(a.data() == b.data());
+  ASSERT_TRUE(a.data() != c.data());
+
+  auto stats = pool.get_stats();
+  ASSERT_EQ(2u, stats.string_count);
+  ASSERT_EQ(4u, stats.total_size);
+  ASSERT_EQ(3u, stats.reference_count);
+  ASSERT_EQ(2u, stats.saved_size);
+
+  b.clear();
+  c.clear();
+  stats = pool.get_stats();
+  ASSERT_EQ(1u, stats.string_count);
+  ASSERT_EQ(0u, stats.saved_size);
+}
+
+TEST(StringPool, remove_unused) {
+  td::StringPool pool;
+  td::vector<td::SharedSlice> kept;
+  for (int i = 0; i < 10000; i++) {
+    auto str = pool.intern(PSLICE() << "string " << i);
+    if (i % 100 == 0) {
+      kept.push_back(std::move(str));
+    }
+  }
+  for (int i = 0; i < 10000; i += 100) {
+    auto str = pool.intern(PSLICE() << "string " << i);
+    ASSERT_TRUE(str.data() == kept[i / 100].data());
+  }
+  ASSERT_EQ(100u, pool.get_stats().string_count);
+}
@@ -0,0 +1,101 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+#include "td/utils/TimerWheel.h"
+
+#include <set>
+#include <utility>
+
+namespace {
+
+struct Timer final : public td::TimerWheelNode {
+  int id = 0;
+};
+
+}  // namespace
+
+TEST(TimerWheel, simple) {
+  td::TimerWheel wheel;
+  Timer a;
+  Timer b;
+  Timer c;
+  a.id = 1;
+  b.id = 2;
+  c.id = 3;
+  wheel.insert(100.0105, &a);
+  wheel.insert(100.5, &b);
+  wheel.insert(1e10, &c);
+  ASSERT_EQ(3u, wheel.size());
+  ASSERT_TRUE(wheel.get_wakeup_time() <= 100.0105);
+
+  wheel.advance(100.0105);
+  ASSERT_TRUE(wheel.pop_expired() == nullptr);
+  wheel.advance(100.0106);
+  ASSERT_EQ(&a, static_cast<Timer *>(wheel.pop_expired()));
+  ASSERT_TRUE(!a.in_timer_wheel());
+  ASSERT_TRUE(wheel.pop_expired() == nullptr);
+
+  wheel.fix(200.0, &b);
+  ASSERT_EQ(200.0, wheel.get_key(&b));
+  wheel.advance(150.0);
+  ASSERT_TRUE(wheel.pop_expired() == nullptr);
+  wheel.erase(&b);
+  ASSERT_TRUE(!b.in_timer_wheel());
+
+  wheel.advance(2e10);
+  ASSERT_EQ(&c, static_cast<Timer *>(wheel.pop_expired()));
+  ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheel, random_events) {
+  const int N = 1000;
+  td::vector<Timer> timers(N);
+  for (int i = 0; i < N; i++) {
+    timers[i].id = i;
+  }
+  std::set<std::pair<double, int>> set;
+  td::vector<double> keys(N);
+  td::TimerWheel wheel;
+  double now = 1000.0;
+  for (int i = 0; i < 300000; i++) {
+    auto id = td::Random::fast(0, N - 1);
+    auto &timer = timers[id];
+    auto x = td::Random::fast(0, 9);
+    if (x < 5) {
+      // timeouts from a fraction of a millisecond to several days
+      double key = now + td::Random::fast(0, 1000000) * 1e-6 * (1 << td::Random::fast(0, 20)) - 1.0;
+      if (timer.in_timer_wheel()) {
+        set.erase(std::make_pair(keys[id], id));
+        wheel.fix(key, &timer);
+      } else {
+        wheel.insert(key, &timer);
+      }
+      keys[id] = key;
+      set.emplace(key, id);
+    } else if (x < 7) {
+      if (timer.in_timer_wheel()) {
+        set.erase(std::make_pair(keys[id], id));
+        wheel.erase(&timer);
+      }
+    } else {
+      now += td::Random::fast(0, 1000) * 1e-5 * (1 << td::Random::fast(0, 12));
+      wheel.advance(now);
+      while (auto node = wheel.pop_expired()) {
+        auto expired_id = static_cast<Timer *>(node)->id;
+        ASSERT_TRUE(keys[expired_id] < now);
+        ASSERT_EQ(1u, set.erase(std::make_pair(keys[expired_id], expired_id)));
+      }
+      ASSERT_TRUE(set.empty() || set.begin()->first >= now);
+    }
+    ASSERT_EQ(set.size(), wheel.size());
+    if (!set.empty()) {
+      ASSERT_TRUE(wheel.get_wakeup_time() <= set.begin()->first);
+    }
+  }
+}
@@ -0,0 +1,66 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/common.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tests.h"
+#include "td/utils/TraceSpans.h"
+
+#include <set>
+
+TEST(TraceSpans, propagation) {
+  td::TraceSpans::clear();
+  ASSERT_EQ(0u, td::TraceSpans::create_trace_id());
+  td::TraceSpans::set_enabled(true);
+
+  auto trace_id = td::TraceSpans::create_trace_id();
+  ASSERT_TRUE(trace_id != 0);
+  {
+    td::TraceSpan span(trace_id, "request");
+    ASSERT_EQ(trace_id, td::TraceSpans::get_current_trace_id());
+    {
+      td::TraceSpan nested_span("nested span with a name, which is too long to be stored completely");
+    }
+    // the trace identifier is passed to another thread explicitly
+    td::thread thread([trace_id] {
+      ASSERT_EQ(0u, td::TraceSpans::get_current_trace_id());
+      td::TraceSpan thread_span(trace_id, "thread");
+    });
+    thread.join();
+  }
+  ASSERT_EQ(0u, td::TraceSpans::get_current_trace_id());
+  {
+    td::TraceSpan empty_span("empty");
+  }
+  td::TraceSpans::add_span(td::TraceSpans::create_trace_id(), "other", 1.0, 2.0);
+  td::TraceSpans::set_enabled(false);
+
+  auto spans = td::TraceSpans::get_spans();
+  ASSERT_EQ(4u, spans.size());
+  ASSERT_EQ(td::Slice("other"), td::Slice(spans[0].name, 5));
+  std::set<td::int32> thread_ids;
+  for (size_t i = 1; i < spans.size(); i++) {
+    ASSERT_EQ(trace_id, spans[i].trace_id);
+    ASSERT_TRUE(spans[i].begin_time <= spans[i].end_time);
+    thread_ids.insert(spans[i].thread_id);
+  }
+  ASSERT_EQ(2u, thread_ids.size());
+
+  auto trace = td::TraceSpans::get_chrome_trace();
+  auto r_value = td::json_decode(trace);
+  ASSERT_TRUE(r_value.is_ok());
+  auto value = r_value.move_as_ok();
+  ASSERT_TRUE(value.type() == td::JsonValue::Type::Object);
+  auto r_events = value.get_object().extract_required_field("traceEvents", td::JsonValue::Type::Array);
+  ASSERT_TRUE(r_events.is_ok());
+  // 4 spans and 3 flow events connecting spans of the request
+  ASSERT_EQ(7u, r_events.ok().get_array().size());
+
+  td::TraceSpans::clear();
+  ASSERT_TRUE(td::TraceSpans::get_spans().empty());
+}
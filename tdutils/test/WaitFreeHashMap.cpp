@@ -93,3 +93,29 @@ TEST(WaitFreeHashMap, stress_test) {
     }
   }
 }
+
+TEST(WaitFreeHashMap, memory_usage) {
+  td::WaitFreeHashMap<td::uint64, td::uint64> map;
+  auto usage = map.memory_usage();
+  ASSERT_EQ(0u, usage.size);
+  ASSERT_EQ(0u, usage.memory);
+  ASSERT_EQ(0, usage.level_count);
+
+  for (td::uint64 i = 1; i <= 1000; i++) {
+    map.set(i, i);
+  }
+  usage = map.memory_usage();
+  ASSERT_EQ(1000u, usage.size);
+  ASSERT_TRUE(usage.bucket_count >= usage.size);
+  ASSERT_TRUE(usage.memory >= usage.bucket_count * 2 * sizeof(td::uint64));
+  ASSERT_EQ(0, usage.level_count);
+
+  for (td::uint64 i = 1001; i <= 100000; i++) {
+    map.set(i, i);
+  }
+  usage = map.memory_usage();
+  ASSERT_EQ(100000u, usage.size);
+  ASSERT_TRUE(usage.get_load_factor() > 0.1);
+  ASSERT_TRUE(usage.get_load_factor() < 1.0);
+  ASSERT_TRUE(usage.level_count >= 1);
+}
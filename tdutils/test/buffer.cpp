@@ -7,7 +7,10 @@
 #include "td/utils/tests.h"
 
 #include "td/utils/buffer.h"
+#include "td/utils/find_boundary.h"
 #include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tl_storers.h"
 
 TEST(Buffer, buffer_builder) {
   {
@@ -54,3 +57,99 @@ TEST(Buffer, buffer_builder) {
     ASSERT_EQ(builder.extract().as_slice(), str);
   }
 }
+
+TEST(Buffer, tl_storer_buffer) {
+  for (int test = 0; test < 100; test++) {
+    td::vector<td::string> strings;
+    auto n = td::Random::fast(0, 100);
+    for (int i = 0; i < n; i++) {
+      strings.push_back(td::rand_string('a', 'z', td::Random::fast(0, td::Random::fast_bool() ? 300 : 3)));
+    }
+    auto store = [&](auto &storer) {
+      for (auto &str : strings) {
+        storer.store_int(static_cast<td::int32>(str.size()));
+        storer.store_string(str);
+        storer.store_long(-1);
+      }
+    };
+
+    td::TlStorerCalcLength storer_calc_length;
+    store(storer_calc_length);
+    td::string expected(storer_calc_length.get_length(), '\0');
+    td::TlStorerUnsafe storer_unsafe(td::MutableSlice(expected).ubegin());
+    store(storer_unsafe);
+
+    auto prepend_size = static_cast<size_t>(td::Random::fast(0, 4) * 4);
+    td::TlStorerBuffer storer(static_cast<size_t>(td::Random::fast(0, 1000)), prepend_size);
+    store(storer);
+    ASSERT_EQ(expected.size(), storer.get_length());
+    auto writer = storer.move_as_buffer_writer();
+    ASSERT_EQ(expected, writer.as_slice());
+    ASSERT_TRUE(writer.prepare_prepend().size() >= prepend_size);
+  }
+}
+
+TEST(Buffer, find_http_headers_end) {
+  for (int i = 0; i < 10000; i++) {
+    td::string str;
+    auto length = td::Random::fast(0, 200);
+    for (int j = 0; j < length; j++) {
+      str += "\r\na"[td::Random::fast(0, 2)];
+    }
+    auto expected_pos = str.find("\r\n\r\n");
+
+    td::ChainBufferWriter writer;
+    auto reader = writer.extract_reader();
+    size_t already_read = 0;
+    td::string received;
+    for (auto &part : td::rand_split(str)) {
+      writer.append(part);
+      reader.sync_with_writer();
+      received += part;
+      bool is_found = td::find_http_headers_end(reader.clone(), already_read);
+      ASSERT_EQ(received.find("\r\n\r\n") != td::string::npos, is_found);
+      if (is_found) {
+        ASSERT_EQ(expected_pos, already_read);
+        break;
+      }
+    }
+  }
+}
+
+TEST(Buffer, pooling) {
+  auto start_mem = td::BufferAllocator::get_buffer_mem();
+  const td::uint8 *data = nullptr;
+  {
+    td::BufferSlice slice(1 << 19);
+    data = slice.as_slice().ubegin();
+    ASSERT_TRUE(td::BufferAllocator::get_buffer_mem() >= start_mem + (1 << 19));
+  }
+  ASSERT_EQ(start_mem, td::BufferAllocator::get_buffer_mem());
+  auto pooled_mem = td::BufferAllocator::get_pooled_buffer_mem();
+  ASSERT_TRUE(pooled_mem >= (1 << 19));
+  {
+    td::BufferSlice slice(1 << 19);
+    ASSERT_TRUE(slice.as_slice().ubegin() == data);
+    ASSERT_TRUE(td::BufferAllocator::get_pooled_buffer_mem() < pooled_mem);
+  }
+  ASSERT_EQ(start_mem, td::BufferAllocator::get_buffer_mem());
+}
+
+TEST(Buffer, owner_stats) {
+  auto start_mem = td::BufferAllocator::get_buffer_mem(td::BufferOwner::FilePart);
+  auto start_binlog_mem = td::BufferAllocator::get_buffer_mem(td::BufferOwner::Binlog);
+  td::BufferSlice other_slice(10000);
+  {
+    td::BufferOwnerGuard guard(td::BufferOwner::FilePart);
+    td::BufferSlice slice(10000);
+    ASSERT_TRUE(td::BufferAllocator::get_buffer_mem(td::BufferOwner::FilePart) >= start_mem + 10000);
+    {
+      td::BufferOwnerGuard binlog_guard(td::BufferOwner::Binlog);
+      td::BufferSlice binlog_slice(5000);
+      ASSERT_TRUE(td::BufferAllocator::get_buffer_mem(td::BufferOwner::Binlog) >= start_binlog_mem + 5000);
+    }
+    ASSERT_EQ(start_binlog_mem, td::BufferAllocator::get_buffer_mem(td::BufferOwner::Binlog));
+  }
+  ASSERT_TRUE(td::BufferAllocator::get_current_owner() == td::BufferOwner::Other);
+  ASSERT_EQ(start_mem, td::BufferAllocator::get_buffer_mem(td::BufferOwner::FilePart));
+}
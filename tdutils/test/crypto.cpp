@@ -339,6 +339,34 @@ TEST(Crypto, crc32) {
     ASSERT_EQ(answers[i], td::crc32(strings[i]));
   }
 }
+
+static td::uint32 crc32_bitwise(td::Slice data) {
+  td::uint32 crc = 0xFFFFFFFF;
+  for (auto c : data) {
+    crc ^= static_cast<unsigned char>(c);
+    for (int i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+TEST(Crypto, crc32_lengths) {
+  td::string data(4100, '\0');
+  for (auto &c : data) {
+    c = static_cast<char>(td::Random::fast(0, 255));
+  }
+  for (std::size_t offset = 0; offset < 16; offset++) {
+    for (std::size_t length = 0; offset + length <= 300; length++) {
+      auto slice = td::Slice(data).substr(offset, length);
+      ASSERT_EQ(crc32_bitwise(slice), td::crc32(slice));
+    }
+  }
+  for (std::size_t length = 4000; length <= 4084; length++) {
+    auto slice = td::Slice(data).substr(data.size() - length);
+    ASSERT_EQ(crc32_bitwise(slice), td::crc32(slice));
+  }
+}
 #endif
 
 #if TD_HAVE_CRC32C
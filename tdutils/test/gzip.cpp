@@ -29,6 +29,35 @@ TEST(Gzip, gzencode_gzdecode) {
   encode_decode(td::string(1000000, 'a'));
 }
 
+TEST(Gzip, dictionary) {
+  auto dictionary = td::rand_string('a', 'z', 1000);
+  auto s = dictionary.substr(100, 300) + dictionary.substr(500, 400);
+  auto r = td::gzencode(s, 2, dictionary);
+  ASSERT_TRUE(!r.empty());
+  ASSERT_TRUE(r.size() < td::gzencode(s, 2).size());
+  ASSERT_EQ(s, td::gzdecode(r.as_slice(), dictionary));
+  ASSERT_TRUE(td::gzdecode(r.as_slice()).empty());
+  ASSERT_TRUE(td::gzdecode(r.as_slice(), td::rand_string('a', 'z', 1000)).empty());
+
+  // a dictionary is ignored for data compressed without it
+  ASSERT_EQ(s, td::gzdecode(td::gzencode(s, 2).as_slice(), dictionary));
+}
+
+TEST(Gzip, stream_reuse) {
+  auto dictionary = td::rand_string('a', 'z', 1000);
+  auto s = dictionary.substr(200, 500);
+  for (int i = 0; i < 10; i++) {
+    auto r = td::gzencode(s, 2, i % 2 == 0 ? dictionary : td::Slice());
+    ASSERT_TRUE(!r.empty());
+    ASSERT_EQ(s, td::gzdecode(r.as_slice(), dictionary));
+
+    // failed calls must not affect subsequent ones
+    ASSERT_TRUE(td::gzencode(td::rand_string(0, 255, 1000), 0.5).empty());
+    ASSERT_TRUE(td::gzdecode(r.as_slice().substr(0, r.size() / 2), dictionary).empty());
+    ASSERT_TRUE(td::gzdecode("garbage").empty());
+  }
+}
+
 static void test_gzencode(const td::string &s) {
   auto begin_time = td::Time::now();
   auto r = td::gzencode(s, td::max(2, static_cast<int>(100 / s.size())));
@@ -4,15 +4,18 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/base64.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/Parser.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 
+#include <limits>
 #include <utility>
 
 static void decode_encode(const td::string &str, td::string result = td::string()) {
@@ -298,3 +301,39 @@ TEST(JSON, string_decode) {
   test_string_decode_error("\"\\uD800\\ug123\"");
   test_string_decode_error("\"\\uD800\\u123\"");
 }
+
+TEST(JSON, string_encode) {
+  const td::vector<td::string> parts{"a", "b", " ", "\"", "\\", "\n", "\t", "\x01", "\x1f", "\x7f", "/",
+                                     "\xd1\x8f", "\xe2\x80\xa8", "\xf0\x9f\x8f\x9f"};
+  for (int i = 0; i < 10000; i++) {
+    td::string str;
+    auto part_count = td::Random::fast(0, 50);
+    auto plain_part = td::Random::fast(0, 2);
+    for (int j = 0; j < part_count; j++) {
+      str += parts[td::Random::fast_bool() ? plain_part : td::Random::fast(0, static_cast<int>(parts.size()) - 1)];
+    }
+
+    for (auto is_raw : {false, true}) {
+      auto encoded = is_raw ? td::json_encode<td::string>(td::JsonRawString(str))
+                            : td::json_encode<td::string>(td::JsonString(str));
+      if (!is_raw) {
+        for (auto c : encoded) {
+          ASSERT_TRUE(static_cast<unsigned char>(c) < 128);
+        }
+      }
+      td::Parser parser(encoded);
+      auto r_value = td::json_string_decode(parser);
+      ASSERT_TRUE(r_value.is_ok());
+      ASSERT_TRUE(parser.empty());
+      ASSERT_EQ(str, r_value.ok());
+    }
+  }
+}
+
+TEST(JSON, base64_encode) {
+  for (size_t length : {0, 1, 2, 3, 4, 12287, 12288, 12289, 12290, 100000}) {
+    auto bytes = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), length);
+    auto encoded = td::json_encode<td::string>(td::JsonBase64(bytes));
+    ASSERT_EQ(td::json_encode<td::string>(td::JsonString(td::base64_encode(bytes))), encoded);
+  }
+}
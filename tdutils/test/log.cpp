@@ -6,11 +6,14 @@
 //
 #include "td/utils/AsyncFileLog.h"
 #include "td/utils/benchmark.h"
+#include "td/utils/BinaryFileLog.h"
 #include "td/utils/CombinedLog.h"
 #include "td/utils/FileLog.h"
+#include "td/utils/filesystem.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/MemoryLog.h"
+#include "td/utils/misc.h"
 #include "td/utils/NullLog.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/thread.h"
@@ -163,6 +166,12 @@ TEST(Log, Bench) {
     return td::make_unique<FileLog>();
   });
 
+  bench_log("BinaryFileLog", [] {
+    auto result = td::make_unique<td::BinaryFileLog>();
+    result->init("tmplog", std::numeric_limits<td::int64>::max()).ensure();
+    return result;
+  });
+
 #if !TD_EVENTFD_UNSUPPORTED
   bench_log("AsyncFileLog", [] {
     class AsyncFileLog final : public td::LogInterface {
@@ -184,4 +193,93 @@ TEST(Log, Bench) {
   });
 #endif
 }
+
+TEST(Log, binary_file_log) {
+  td::string path = "tmp_binary_log";
+  td::unlink(path).ignore();
+  td::unlink(path + ".old").ignore();
+
+  auto old_log_interface = td::log_interface;
+  auto old_verbosity_level = td::get_verbosity_level();
+  {
+    td::BinaryFileLog binary_file_log;
+    binary_file_log.init(path, 1000000).ensure();
+    td::log_interface = &binary_file_log;
+    td::set_verbosity_level(VERBOSITY_NAME(INFO));
+    LOG(INFO) << "Integers: " << 12 << ' ' << -34 << ' ' << static_cast<td::uint64>(56) << ' ' << td::int64{-78};
+    LOG(WARNING) << "Other: " << 1.5 << ' ' << true << ' ' << td::Slice("slice") << ' ' << td::string("string") << ' '
+                 << td::tag("tag", 9);
+    LOG_IF(INFO, path.size() > 1) << "Condition\n\n";
+    td::thread([] { LOG(INFO) << "Thread"; }).join();
+    LOG(DEBUG) << "Skipped";
+    td::set_verbosity_level(old_verbosity_level);
+    td::log_interface = old_log_interface;
+  }
+
+  auto data = td::read_file_str(path).move_as_ok();
+  td::vector<td::string> messages;
+  td::BinaryFileLog::decode(data, [&](td::CSlice message) { messages.push_back(message.str()); }).ensure();
+  ASSERT_EQ(4u, messages.size());
+  for (auto &message : messages) {
+    ASSERT_TRUE(message.find("[log.cpp:") != td::string::npos);
+  }
+  ASSERT_TRUE(td::ends_with(messages[0], "\tIntegers: 12 -34 56 -78\n"));
+  ASSERT_TRUE(td::begins_with(messages[0], "[ 3]"));
+  ASSERT_TRUE(td::ends_with(messages[1], "\tOther: 1.500000 true slice string [tag:9]\n"));
+  ASSERT_TRUE(td::begins_with(messages[1], "[ 2]"));
+  ASSERT_TRUE(td::ends_with(messages[2], "][&path.size() > 1]\tCondition\n"));
+  ASSERT_TRUE(td::ends_with(messages[3], "\tThread\n"));
+
+  ASSERT_TRUE(td::BinaryFileLog::decode("not a log", [](td::CSlice) {}).is_error());
+  ASSERT_TRUE(td::BinaryFileLog::decode(td::Slice(data).substr(0, data.size() - 1), [](td::CSlice) {}).is_error());
+  td::unlink(path).ignore();
+}
 #endif
+
+TEST(Log, rate_limit) {
+  class CollectingLog final : public td::LogInterface {
+   public:
+    void do_append(int log_level, td::CSlice slice) final {
+      messages.push_back(slice.str());
+    }
+
+    td::vector<td::string> messages;
+  };
+
+  CollectingLog collecting_log;
+  auto old_log_interface = td::log_interface;
+  auto old_verbosity_level = td::get_verbosity_level();
+  td::log_interface = &collecting_log;
+  td::set_verbosity_level(VERBOSITY_NAME(INFO));
+  int VERBOSITY_NAME(rate_limit_test) = VERBOSITY_NAME(INFO);
+
+  td::LogRateLimiter::set_limit(td::Slice(), {3, 0});
+  td::LogRateLimiter::set_limit("rate_limit_test", {2, 4});
+  ASSERT_EQ(3, td::LogRateLimiter::get_limit("unknown").max_count_per_second);
+  ASSERT_EQ(4, td::LogRateLimiter::get_limit("rate_limit_test").sampling_rate);
+  ASSERT_TRUE(td::LogRateLimiter::is_enabled());
+
+  auto old_suppressed_count = td::LogRateLimiter::get_suppressed_count();
+  for (int i = 0; i < 10; i++) {
+    LOG(INFO) << "Default " << i;
+  }
+  for (int i = 0; i < 10; i++) {
+    VLOG(rate_limit_test) << "Tagged " << i;
+  }
+  LOG(ERROR) << "Other place";
+
+  td::LogRateLimiter::set_limit(td::Slice(), {});
+  td::LogRateLimiter::set_limit("rate_limit_test", {});
+  ASSERT_TRUE(!td::LogRateLimiter::is_enabled());
+  td::set_verbosity_level(old_verbosity_level);
+  td::log_interface = old_log_interface;
+
+  // 3 default messages, 2 tagged messages, tagged messages number 6 and 10 and the last message
+  ASSERT_EQ(8u, collecting_log.messages.size());
+  ASSERT_TRUE(td::ends_with(collecting_log.messages[2], "\tDefault 2\n"));
+  ASSERT_TRUE(td::ends_with(collecting_log.messages[4], "\tTagged 1\n"));
+  ASSERT_TRUE(td::ends_with(collecting_log.messages[5], "\tTagged 5\n"));
+  ASSERT_TRUE(td::ends_with(collecting_log.messages[6], "\tTagged 9\n"));
+  ASSERT_TRUE(td::ends_with(collecting_log.messages[7], "\tOther place\n"));
+  ASSERT_EQ(7u + 6u, td::LogRateLimiter::get_suppressed_count() - old_suppressed_count);
+}
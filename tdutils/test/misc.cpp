@@ -263,6 +263,63 @@ TEST(Misc, base64) {
   ASSERT_TRUE(td::base64url_encode("ab><cd") == "YWI-PGNk");
 }
 
+template <bool is_url>
+static td::string naive_base64_encode(td::Slice input) {
+  td::Slice characters = is_url ? td::Slice("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_")
+                                : td::Slice("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+  td::string result;
+  td::uint32 bits = 0;
+  int bit_count = 0;
+  for (auto c : input) {
+    bits = (bits << 8) | static_cast<unsigned char>(c);
+    bit_count += 8;
+    while (bit_count >= 6) {
+      bit_count -= 6;
+      result += characters[(bits >> bit_count) & 63];
+    }
+  }
+  if (bit_count > 0) {
+    result += characters[(bits << (6 - bit_count)) & 63];
+  }
+  while (!is_url && result.size() % 4 != 0) {
+    result += '=';
+  }
+  return result;
+}
+
+TEST(Misc, base64_fuzz) {
+  // long strings are encoded and decoded by SIMD code if available, so compare them with the naive implementation
+  for (int i = 0; i < 5000; i++) {
+    auto length = td::Random::fast(0, 300);
+    auto s = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), length);
+    auto encoded = td::base64_encode(s);
+    auto encoded_url = td::base64url_encode(s);
+    ASSERT_EQ(naive_base64_encode<false>(s), encoded);
+    ASSERT_EQ(naive_base64_encode<true>(s), encoded_url);
+    ASSERT_EQ(s, td::base64_decode(encoded).ok());
+    ASSERT_EQ(s, td::base64url_decode(encoded_url).ok());
+
+    // is_base64 is always implemented without SIMD
+    if (!encoded.empty()) {
+      auto pos = td::Random::fast(0, static_cast<int>(encoded.size()) - 1);
+      encoded[pos] = static_cast<char>(td::Random::fast(0, 255));
+      auto decoded = td::base64_decode(encoded);
+      ASSERT_EQ(td::is_base64(encoded), decoded.is_ok());
+      if (decoded.is_ok()) {
+        ASSERT_EQ(naive_base64_encode<false>(decoded.ok()), encoded);
+      }
+
+      pos = td::Random::fast(0, static_cast<int>(encoded_url.size()) - 1);
+      encoded_url[pos] = static_cast<char>(td::Random::fast(0, 255));
+      auto decoded_url = td::base64url_decode(encoded_url);
+      ASSERT_EQ(td::is_base64url(encoded_url), decoded_url.is_ok());
+      if (decoded_url.is_ok()) {
+        ASSERT_EQ(naive_base64_encode<true>(decoded_url.ok()), encoded_url);
+      }
+    }
+  }
+}
+
 static void test_zero_encode(td::Slice str, td::Slice expected_zero = td::Slice(),
                              td::Slice expected_zero_one = td::Slice()) {
   auto encoded = td::zero_encode(str);
@@ -689,6 +746,42 @@ TEST(Misc, to_wstring) {
 }
 #endif
 
+TEST(Misc, utf8) {
+  const td::vector<td::string> characters{"a", "\x7f", "\xd1\x8f", "\xe2\x80\xa8", "\xf0\x9f\x8f\x9f"};
+  for (int i = 0; i < 10000; i++) {
+    td::string str;
+    size_t length = 0;
+    size_t utf16_length = 0;
+    td::vector<size_t> prefix_sizes{0};
+    auto character_count = td::Random::fast(0, 100);
+    auto max_character = td::Random::fast(0, static_cast<int>(characters.size()) - 1);
+    for (int j = 0; j < character_count; j++) {
+      const auto &character = characters[td::Random::fast(0, max_character)];
+      str += character;
+      length++;
+      utf16_length += character.size() == 4 ? 2 : 1;
+      prefix_sizes.push_back(str.size());
+    }
+    ASSERT_TRUE(td::check_utf8(str));
+    ASSERT_EQ(length, td::utf8_length(str));
+    ASSERT_EQ(utf16_length, td::utf8_utf16_length(str));
+    auto truncated_length = static_cast<size_t>(td::Random::fast(0, character_count + 1));
+    ASSERT_EQ(prefix_sizes[td::min(truncated_length, length)], td::utf8_truncate(str, truncated_length).size());
+    ASSERT_EQ(prefix_sizes[td::min(truncated_length, length)],
+              td::utf8_truncate(td::Slice(str), truncated_length).size());
+    if (!str.empty()) {
+      td::Slice truncated_str(str.data(), str.size() - 1);
+      ASSERT_EQ(td::check_utf8(truncated_str.str()), td::check_utf8_unterminated(truncated_str));
+      ASSERT_TRUE(td::check_utf8_unterminated(str));
+      auto pos = td::Random::fast(0, static_cast<int>(str.size()) - 1);
+      auto is_first_code_unit = td::is_utf8_character_first_code_unit(static_cast<unsigned char>(str[pos]));
+      str[pos] = static_cast<char>(is_first_code_unit && td::Random::fast_bool() ? 0x80 : 0xFF);
+      ASSERT_TRUE(!td::check_utf8(str));
+      ASSERT_TRUE(!td::check_utf8_unterminated(str));
+    }
+  }
+}
+
 static void test_translit(const td::string &word, const td::vector<td::string> &result, bool allow_partial = true) {
   ASSERT_EQ(result, td::get_word_transliterations(word, allow_partial));
 }
@@ -784,6 +877,33 @@ TEST(BigNum, from_binary) {
   ASSERT_STREQ(td::BigNum::from_decimal("65536").move_as_ok().to_le_binary(4), "\x00\x00\x01\x00");
 }
 
+TEST(BigNum, mod_context) {
+  td::BigNumContext context;
+  for (int modulus_bits : {64, 512, 2048}) {
+    for (int bottom : {0, -1}) {  // odd and arbitrary modulus
+      td::BigNum modulus;
+      td::BigNum::random(modulus, modulus_bits, 0, bottom);
+      td::BigNumModContext mod_context(modulus);
+      ASSERT_EQ(0, td::BigNum::compare(modulus, mod_context.get_modulus()));
+      for (int i = 0; i < 10; i++) {
+        td::BigNum a;
+        if (i % 2 == 0) {
+          a.set_value(td::Random::fast(0, 5));
+        } else {
+          td::BigNum::random(a, modulus_bits + 8, -1, 0);
+        }
+        td::BigNum p;
+        td::BigNum::random(p, modulus_bits, -1, 0);
+        td::BigNum expected;
+        td::BigNum::mod_exp(expected, a, p, modulus, context);
+        td::BigNum result;
+        mod_context.mod_exp(result, a, p);
+        ASSERT_EQ(0, td::BigNum::compare(expected, result));
+      }
+    }
+  }
+}
+
 static void test_get_ipv4(td::uint32 ip) {
   td::IPAddress ip_address;
   ip_address.init_ipv4_port(td::IPAddress::ipv4_to_str(ip), 80).ensure();
@@ -8,10 +8,12 @@
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/detail/IoUring.h"
 #include "td/utils/port/EventFd.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/PollFlags.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
@@ -33,6 +35,12 @@
 #include <signal.h>
 #endif
 
+#if TD_PORT_POSIX
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 TEST(Port, files) {
   td::CSlice main_dir = "test_dir";
   td::rmrf(main_dir).ignore();
@@ -295,6 +303,39 @@ TEST(Port, EventFdAndSignals) {
 #endif
 #endif
 
+#if TD_POLL_IO_URING
+TEST(Port, IoUringPoll) {
+  if (!td::detail::IoUring::is_supported()) {
+    return;
+  }
+  td::detail::IoUring poll;
+  poll.init();
+  // file descriptors are reused, so completions of removed requests must be ignored
+  for (int i = 0; i < 10; i++) {
+    td::EventFd event_fd;
+    event_fd.init();
+    auto &poll_info = event_fd.get_poll_info();
+    poll.subscribe(poll_info.extract_pollable_fd(nullptr), td::PollFlags::Read());
+    poll.run(0);
+    ASSERT_TRUE(!poll_info.sync_with_poll().can_read());
+
+    for (int j = 0; j < 3; j++) {
+      event_fd.release();
+      poll.run(1000);
+      ASSERT_TRUE(poll_info.sync_with_poll().can_read());
+      event_fd.acquire();
+      poll_info.clear_flags(td::PollFlags::Read());
+    }
+
+    event_fd.release();
+    poll.unsubscribe_before_close(poll_info.get_pollable_fd_ref());
+    event_fd.close();
+  }
+  poll.run(0);
+  poll.clear();
+}
+#endif
+
 #if TD_HAVE_THREAD_AFFINITY
 TEST(Port, ThreadAffinityMask) {
   auto thread_id = td::this_thread::get_id();
@@ -324,3 +365,31 @@ TEST(Port, ThreadAffinityMask) {
   LOG(INFO) << old_mask;
 }
 #endif
+
+#if TD_PORT_POSIX
+TEST(Port, SecureRandomAfterFork) {
+  unsigned char buf[16];
+  td::Random::secure_bytes(buf, sizeof(buf));  // fill the buffer of generated bytes
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  auto pid = fork();
+  ASSERT_TRUE(pid >= 0);
+  if (pid == 0) {
+    td::Random::secure_bytes(buf, sizeof(buf));
+    auto written = write(fds[1], buf, sizeof(buf));
+    _exit(written == static_cast<ssize_t>(sizeof(buf)) ? 0 : 1);
+  }
+
+  unsigned char child_buf[16];
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(child_buf)), read(fds[0], child_buf, sizeof(child_buf)));
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  close(fds[0]);
+  close(fds[1]);
+
+  // the parent and the child must not return the same bytes
+  td::Random::secure_bytes(buf, sizeof(buf));
+  ASSERT_TRUE(td::Slice(buf, sizeof(buf)) != td::Slice(child_buf, sizeof(child_buf)));
+}
+#endif
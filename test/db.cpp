@@ -14,8 +14,10 @@
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
 #include "td/db/SqliteKeyValue.h"
+#include "td/db/SqliteKeyValueAsync.h"
 #include "td/db/SqliteKeyValueSafe.h"
 #include "td/db/TsSeqKeyValue.h"
+#include "td/db/WriteBatchPolicy.h"
 
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
@@ -25,6 +27,7 @@
 #include "td/utils/filesystem.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
@@ -138,6 +141,53 @@ TEST(DB, binlog_encryption) {
   td::Binlog::destroy(binlog_name).ignore();
 }
 
+TEST(DB, binlog_incremental_reindex) {
+  td::CSlice binlog_name = "test_binlog";
+  for (auto db_key : {td::DbKey::empty(), td::DbKey::password("cucumber")}) {
+    td::Binlog::destroy(binlog_name).ignore();
+
+    std::map<td::uint64, td::string> events;
+    {
+      td::Binlog binlog;
+      binlog.init(binlog_name.str(), [](const td::BinlogEvent &x) {}, db_key).ensure();
+      td::vector<td::uint64> event_ids;
+      for (int i = 0; i < 3000; i++) {
+        auto data = td::rand_string('a', 'z', 4000);
+        auto event_id = binlog.add(1, td::create_storer(data));
+        event_ids.push_back(event_id);
+        events[event_id] = data;
+        if (i % 3 != 0) {
+          binlog.erase(event_id);
+          events.erase(event_id);
+        }
+        auto old_event_id = rand_elem(event_ids);
+        if (td::Random::fast_bool() && events.count(old_event_id) != 0) {
+          if (td::Random::fast_bool()) {
+            binlog.erase(old_event_id);
+            events.erase(old_event_id);
+          } else {
+            data = td::rand_string('a', 'z', 1000);
+            binlog.rewrite(old_event_id, 1, td::create_storer(data));
+            events[old_event_id] = data;
+          }
+        }
+        binlog.continue_reindex();
+      }
+      binlog.close().ensure();
+    }
+
+    std::map<td::uint64, td::string> loaded_events;
+    td::Binlog binlog;
+    binlog
+        .init(
+            binlog_name.str(), [&](const td::BinlogEvent &x) { loaded_events[x.id_] = x.get_data().str(); }, db_key)
+        .ensure();
+    ASSERT_TRUE(loaded_events == events);
+    binlog.close().ensure();
+  }
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
 TEST(DB, sqlite_lfs) {
   td::string path = "test_sqlite_db";
   td::SqliteDb::destroy(path).ignore();
@@ -524,6 +574,66 @@ TEST(DB, key_value_set_all) {
   td::SqliteDb::destroy(sqlite_kv_name).ignore();
 }
 
+TEST(DB, binlog_key_value_snapshot) {
+  td::vector<td::string> keys;
+  for (int i = 0; i < 3000; i++) {
+    keys.push_back(td::rand_string('a', 'z', td::Random::fast(1, 10)));
+  }
+
+  td::CSlice kv_name = "test_binlog_kv";
+  td::Binlog::destroy(kv_name).ignore();
+  std::map<td::string, td::string> values;
+  for (int iter = 0; iter < 5; iter++) {
+    td::BinlogKeyValue<td::Binlog> kv;
+    kv.init(kv_name.str()).ensure();
+    for (auto &key : keys) {
+      auto it = values.find(key);
+      ASSERT_EQ(it == values.end() ? td::string() : it->second, kv.get(key));
+    }
+    ASSERT_EQ(values.size(), kv.get_all().size());
+
+    for (int i = 0; i < 5000; i++) {
+      const auto &key = rand_elem(keys);
+      int op = td::Random::fast(0, 10);
+      if (op == 0) {
+        kv.erase(key);
+        values.erase(key);
+      } else if (op == 1) {
+        td::vector<td::string> erased_keys{key, rand_elem(keys)};
+        for (auto &erased_key : erased_keys) {
+          values.erase(erased_key);
+        }
+        kv.erase_batch(std::move(erased_keys));
+      } else if (op == 2 && i % 10 == 0) {
+        auto prefix = key.substr(0, 2);
+        auto prefix_values = kv.prefix_get(prefix);
+        size_t prefix_value_count = 0;
+        for (auto it = values.lower_bound(prefix); it != values.end() && td::begins_with(it->first, prefix); ++it) {
+          ASSERT_EQ(it->second, prefix_values[it->first.substr(prefix.size())]);
+          prefix_value_count++;
+        }
+        ASSERT_EQ(prefix_value_count, prefix_values.size());
+      } else if (op == 3 && i % 100 == 0) {
+        auto prefix = key.substr(0, 1);
+        kv.erase_by_prefix(prefix);
+        for (auto it = values.begin(); it != values.end();) {
+          if (td::begins_with(it->first, prefix)) {
+            it = values.erase(it);
+          } else {
+            ++it;
+          }
+        }
+      } else {
+        auto value = td::rand_string('a', 'z', td::Random::fast(1, 100));
+        kv.set(key, value);
+        values[key] = value;
+      }
+    }
+    kv.close();
+  }
+  td::Binlog::destroy(kv_name).ignore();
+}
+
 #if !TD_THREAD_UNSUPPORTED
 TEST(DB, thread_key_value) {
   td::vector<td::string> keys;
@@ -807,3 +917,108 @@ TEST(DB, persistent_key_value) {
   }
   td::SqliteDb::destroy(path).ignore();
 }
+
+TEST(DB, sqlite_key_value_async) {
+  td::CSlice path = "test_sqlite_kv_async";
+  td::SqliteDb::destroy(path).ignore();
+  td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).ensure();
+
+  class Main final : public td::Actor {
+   public:
+    explicit Main(td::string path) : path_(std::move(path)) {
+    }
+
+    void start_up() final {
+      auto sql_connection = std::make_shared<td::SqliteConnectionSafe>(path_, td::DbKey::empty());
+      kv_async_ = td::create_sqlite_key_value_async(std::make_shared<td::SqliteKeyValueSafe>("kv", sql_connection), 0);
+
+      td::FlatHashMap<td::string, td::string> key_values;
+      key_values["a1"] = "1";
+      key_values["a2"] = "2";
+      key_values["b1"] = "3";
+      kv_async_->set_all(std::move(key_values), td::Auto());
+      kv_async_->set("a3", "4", td::Auto());
+      kv_async_->erase("a2", td::Auto());
+      kv_async_->get_many({"a1", "a2", "a3", "b1", "c"},
+                          td::PromiseCreator::lambda([](td::Result<td::vector<td::string>> r_values) {
+                            ASSERT_TRUE(r_values.is_ok());
+                            td::vector<td::string> expected{"1", "", "4", "3", ""};
+                            ASSERT_EQ(expected, r_values.ok());
+                          }));
+      kv_async_->get_by_prefix(
+          "a", td::PromiseCreator::lambda([](td::Result<td::FlatHashMap<td::string, td::string>> r_key_values) {
+            ASSERT_TRUE(r_key_values.is_ok());
+            auto key_values = r_key_values.move_as_ok();
+            ASSERT_EQ(2u, key_values.size());
+            ASSERT_EQ("1", key_values["1"]);
+            ASSERT_EQ("4", key_values["3"]);
+          }));
+      kv_async_->set("a4", "5", td::Auto());
+      kv_async_->erase_by_prefix("a", td::Auto());
+      kv_async_->get_by_prefix(
+          "", td::PromiseCreator::lambda([](td::Result<td::FlatHashMap<td::string, td::string>> r_key_values) {
+            ASSERT_TRUE(r_key_values.is_ok());
+            auto key_values = r_key_values.move_as_ok();
+            ASSERT_EQ(1u, key_values.size());
+            ASSERT_EQ("3", key_values["b1"]);
+          }));
+      kv_async_->close(td::PromiseCreator::lambda([actor_id = actor_id(this)](td::Unit) {
+        td::send_closure(actor_id, &Main::on_closed);
+      }));
+    }
+
+    void on_closed() {
+      td::Scheduler::instance()->finish();
+      stop();
+    }
+
+   private:
+    td::string path_;
+    td::unique_ptr<td::SqliteKeyValueAsyncInterface> kv_async_;
+  };
+
+  {
+    td::ConcurrentScheduler sched(0, 0);
+    sched.create_actor_unsafe<Main>(0, "Main", path.str()).release();
+    sched.start();
+    while (sched.run_main(10)) {
+      // empty
+    }
+    sched.finish();
+  }
+  td::SqliteDb::destroy(path).ignore();
+}
+
+TEST(DB, write_batch_policy) {
+  td::WriteBatchPolicy policy;
+  size_t pending_query_count = 0;
+  while (!policy.need_flush(pending_query_count)) {
+    pending_query_count++;
+  }
+  auto initial_max_count = pending_query_count;
+
+  // bursts of writes make transactions bigger
+  for (int i = 0; i < 3; i++) {
+    policy.on_transaction_committed(pending_query_count, 0.001, true);
+  }
+  ASSERT_TRUE(!policy.need_flush(initial_max_count * 2));
+  ASSERT_TRUE(policy.need_flush(initial_max_count * 8));
+
+  // rare writes make them smaller again
+  for (int i = 0; i < 10; i++) {
+    policy.on_transaction_committed(1, 0.001, false);
+  }
+  ASSERT_TRUE(policy.need_flush(initial_max_count));
+  ASSERT_TRUE(policy.get_flush_delay() <= 0.01);
+
+  // slow commits increase the delay
+  for (int i = 0; i < 50; i++) {
+    policy.on_transaction_committed(1, 0.02, false);
+  }
+  ASSERT_TRUE(policy.get_flush_delay() > 0.01);
+
+  auto &stats = policy.get_stats();
+  ASSERT_EQ(63u, stats.transaction_count);
+  ASSERT_EQ(initial_max_count * 3 + 60, stats.query_count);
+  ASSERT_EQ(initial_max_count, stats.max_transaction_size);
+}
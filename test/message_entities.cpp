@@ -721,6 +721,33 @@ TEST(MessageEntities, url) {
   check_url("_.test.com", {"_.test.com"});
 }
 
+TEST(MessageEntities, find_entities) {
+  td::string text;
+  for (int i = 0; i < 1000; i++) {
+    text += "plain text without entities ";
+  }
+  ASSERT_TRUE(td::find_entities(text, false, false).empty());
+
+  text += "@mention /command #hashtag $USD 4111 1111 1111 1111 tg://resolve example.com 1:23";
+  auto get_offset = [&](td::Slice substr) {
+    return td::narrow_cast<td::int32>(text.find(substr.str()));
+  };
+  td::vector<td::MessageEntity> expected;
+  expected.emplace_back(td::MessageEntity::Type::Mention, get_offset("@mention"), 8);
+  expected.emplace_back(td::MessageEntity::Type::BotCommand, get_offset("/command"), 8);
+  expected.emplace_back(td::MessageEntity::Type::Hashtag, get_offset("#hashtag"), 8);
+  expected.emplace_back(td::MessageEntity::Type::Cashtag, get_offset("$USD"), 4);
+  expected.emplace_back(td::MessageEntity::Type::BankCardNumber, get_offset("4111"), 19);
+  expected.emplace_back(td::MessageEntity::Type::Url, get_offset("tg://"), 12);
+  expected.emplace_back(td::MessageEntity::Type::Url, get_offset("example.com"), 11);
+  expected.emplace_back(td::MessageEntity::Type::MediaTimestamp, get_offset("1:23"), 4, 83);
+  ASSERT_TRUE(td::find_entities(text, false, false) == expected);
+
+  expected.erase(expected.begin() + 1);
+  expected.pop_back();
+  ASSERT_TRUE(td::find_entities(text, true, true) == expected);
+}
+
 static void check_fix_formatted_text(td::string str, td::vector<td::MessageEntity> entities,
                                      const td::string &expected_str,
                                      const td::vector<td::MessageEntity> &expected_entities, bool allow_empty = true,
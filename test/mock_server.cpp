@@ -0,0 +1,413 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "mock_server.h"
+
+#include "td/telegram/telegram_api.h"
+
+#include "td/mtproto/CryptoStorer.h"
+#include "td/mtproto/mtproto_api.h"
+#include "td/mtproto/PacketInfo.h"
+#include "td/mtproto/TcpTransport.h"
+#include "td/mtproto/Transport.h"
+#include "td/mtproto/utils.h"
+
+#include "td/utils/BufferedFd.h"
+#include "td/utils/Gzip.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/Random.h"
+#include "td/utils/Storer.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+
+namespace td {
+
+namespace {
+
+// wrappers, which are stripped before a query is passed to a handler
+constexpr int32 INVOKE_AFTER_MSG_ID = static_cast<int32>(0xcb9f372d);
+constexpr int32 INVOKE_AFTER_MSGS_ID = static_cast<int32>(0x3dc4b4f0);
+constexpr int32 INVOKE_WITH_LAYER_ID = static_cast<int32>(0xda9b0d0d);
+constexpr int32 INVOKE_WITHOUT_UPDATES_ID = static_cast<int32>(0xbf9459b7);
+constexpr int32 INIT_CONNECTION_ID = static_cast<int32>(0xc1cd5ea9);
+constexpr int32 RPC_RESULT_ID = static_cast<int32>(0xf35c6d01);
+
+Result<BufferSlice> unwrap_query(Slice query) {
+  BufferSlice buffer(query);
+  while (true) {
+    TlBufferParser parser(&buffer);
+    switch (parser.fetch_int()) {
+      case INVOKE_AFTER_MSG_ID:
+        parser.fetch_long();
+        break;
+      case INVOKE_AFTER_MSGS_ID: {
+        parser.fetch_int();
+        auto message_id_count = parser.fetch_int();
+        if (message_id_count < 0) {
+          return Status::Error("Invalid invokeAfterMsgs");
+        }
+        for (int32 i = 0; i < message_id_count && parser.get_error() == nullptr; i++) {
+          parser.fetch_long();
+        }
+        break;
+      }
+      case INVOKE_WITH_LAYER_ID:
+        parser.fetch_int();
+        break;
+      case INVOKE_WITHOUT_UPDATES_ID:
+        break;
+      case INIT_CONNECTION_ID: {
+        auto flags = parser.fetch_int();
+        parser.fetch_int();
+        for (int i = 0; i < 6; i++) {
+          parser.fetch_string<string>();
+        }
+        if ((flags & 1) != 0) {
+          parser.fetch_int();
+          parser.fetch_string<string>();
+          parser.fetch_int();
+        }
+        if ((flags & 2) != 0) {
+          telegram_api::JSONValue::fetch(parser);
+        }
+        break;
+      }
+      default:
+        return std::move(buffer);
+    }
+    if (parser.get_error() != nullptr) {
+      return parser.get_status();
+    }
+    auto inner_query = BufferSlice(parser.fetch_string_raw<Slice>(parser.get_left_len()));
+    buffer = std::move(inner_query);
+  }
+}
+
+template <class T>
+BufferSlice serialize_object(const T &object) {
+  TLObjectStorer<T> storer(object);
+  BufferSlice result(storer.size());
+  auto real_size = storer.store(result.as_mutable_slice().ubegin());
+  CHECK(real_size == result.size());
+  return result;
+}
+
+}  // namespace
+
+class MockMtprotoServer::Connection final : public Actor {
+ public:
+  Connection(SocketFd socket_fd, std::shared_ptr<State> state, ActorShared<MockMtprotoServer> parent)
+      : fd_(std::move(socket_fd)), state_(std::move(state)), parent_(std::move(parent)) {
+  }
+
+ private:
+  BufferedFd<SocketFd> fd_;
+  std::shared_ptr<State> state_;
+  ActorShared<MockMtprotoServer> parent_;
+  mtproto::tcp::IntermediateTransport transport_{false};
+  bool was_transport_tag_read_ = false;
+  uint64 session_id_ = 0;
+  uint64 last_message_id_ = 0;
+  int32 seq_no_ = 0;
+  vector<BufferSlice> answers_;
+
+  void start_up() final {
+    state_->stats_.connection_count++;
+    Scheduler::subscribe(fd_.get_poll_info().extract_pollable_fd(this));
+  }
+
+  void tear_down() final {
+    Scheduler::unsubscribe_before_close(fd_.get_poll_info().get_pollable_fd_ref());
+    fd_.close();
+  }
+
+  void hangup() final {
+    stop();
+  }
+
+  void loop() final {
+    sync_with_poll(fd_);
+    auto status = [&] {
+      TRY_RESULT(read_size, fd_.flush_read());
+      state_->stats_.received_bytes += read_size;
+      TRY_STATUS(read_packets());
+      TRY_RESULT(written_size, fd_.flush_write());
+      state_->stats_.sent_bytes += written_size;
+      return Status::OK();
+    }();
+    if (status.is_error()) {
+      LOG(INFO) << "Close connection: " << status;
+      return stop();
+    }
+    if (can_close_local(fd_)) {
+      stop();
+    }
+  }
+
+  Status read_packets() {
+    auto &input = fd_.input_buffer();
+    if (!was_transport_tag_read_) {
+      if (input.size() < 4) {
+        return Status::OK();
+      }
+      uint32 tag = 0;
+      input.advance(4, MutableSlice(reinterpret_cast<char *>(&tag), sizeof(tag)));
+      if (tag != 0xeeeeeeee) {
+        return Status::Error("Unsupported transport");
+      }
+      was_transport_tag_read_ = true;
+    }
+    while (input.size() >= 4) {
+      uint32 header = 0;
+      auto it = input.clone();
+      it.advance(4, MutableSlice(reinterpret_cast<char *>(&header), sizeof(header)));
+      // the highest bit of packet length is set if the client requests quick acknowledgement
+      bool need_quick_ack = (header & (1u << 31)) != 0;
+      size_t size = header & ~(1u << 31);
+      if (input.size() < 4 + size) {
+        break;
+      }
+      input.advance(4);
+      auto packet = input.cut_head(size).move_as_buffer_slice();
+      TRY_STATUS(on_packet(std::move(packet), need_quick_ack));
+    }
+    return Status::OK();
+  }
+
+  Status on_packet(BufferSlice packet, bool need_quick_ack) {
+    state_->stats_.packet_count++;
+
+    mtproto::PacketInfo packet_info;
+    packet_info.version = 2;
+    packet_info.is_server = true;
+    TRY_RESULT(read_result, mtproto::Transport::read(packet.as_mutable_slice(), state_->auth_key_, &packet_info));
+    if (read_result.type() != mtproto::Transport::ReadResult::Packet) {
+      return Status::Error("Receive unexpected packet");
+    }
+    if (packet_info.no_crypto_flag) {
+      return Status::Error("Auth key exchange isn't supported");
+    }
+    if (need_quick_ack) {
+      fd_.output_buffer().append(Slice(reinterpret_cast<const char *>(&packet_info.message_ack), 4));
+    }
+    if (packet_info.session_id != session_id_) {
+      session_id_ = packet_info.session_id;
+      add_answer(serialize_object(mtproto_api::new_session_created(
+                     static_cast<int64>(packet_info.message_id.get()), Random::secure_int64(), state_->server_salt_)),
+                 true);
+    }
+
+    TlParser parser(read_result.packet());
+    TRY_STATUS(on_message(parser));
+    parser.fetch_end();
+    TRY_STATUS(parser.get_status());
+
+    send_answers();
+    return Status::OK();
+  }
+
+  Status on_message(TlParser &parser) {
+    // msg_id:long seqno:int bytes:int
+    auto message_id = parser.fetch_long();
+    parser.fetch_int();
+    auto size = parser.fetch_int();
+    if (size < 0 || size % 4 != 0) {
+      return Status::Error("Invalid message size");
+    }
+    auto body = parser.fetch_string_raw<Slice>(static_cast<size_t>(size));
+    TRY_STATUS(parser.get_status());
+    return on_message_body(message_id, body);
+  }
+
+  Status on_message_body(int64 message_id, Slice body) {
+    TlParser parser(body);
+    switch (parser.fetch_int()) {
+      case mtproto_api::msg_container::ID: {
+        auto message_count = parser.fetch_int();
+        for (int32 i = 0; i < message_count && parser.get_error() == nullptr; i++) {
+          TRY_STATUS(on_message(parser));
+        }
+        parser.fetch_end();
+        return parser.get_status();
+      }
+      case mtproto_api::gzip_packed::ID: {
+        mtproto_api::gzip_packed gzip_packed(parser);
+        TRY_STATUS(parser.get_status());
+        auto unpacked = gzdecode(gzip_packed.packed_data_);
+        if (unpacked.empty()) {
+          return Status::Error("Failed to unpack gzip_packed");
+        }
+        return on_message_body(message_id, unpacked.as_slice());
+      }
+      case mtproto_api::ping_delay_disconnect::ID: {
+        mtproto_api::ping_delay_disconnect ping(parser);
+        TRY_STATUS(parser.get_status());
+        add_answer(serialize_object(mtproto_api::pong(message_id, ping.ping_id_)), true);
+        return Status::OK();
+      }
+      case mtproto_api::get_future_salts::ID: {
+        auto now = static_cast<int32>(Clocks::system());
+        vector<mtproto_api::object_ptr<mtproto_api::future_salt>> salts;
+        salts.push_back(
+            mtproto_api::make_object<mtproto_api::future_salt>(now - 60, now + 86400, state_->server_salt_));
+        add_answer(serialize_object(mtproto_api::future_salts(message_id, now, std::move(salts))), true);
+        return Status::OK();
+      }
+      case mtproto_api::msgs_ack::ID:
+      case mtproto_api::msgs_state_req::ID:
+      case mtproto_api::msg_resend_req::ID:
+      case mtproto_api::rpc_drop_answer::ID:
+      case mtproto_api::destroy_auth_key::ID:
+        // service messages are ignored
+        return Status::OK();
+      default:
+        on_query(message_id, body);
+        return Status::OK();
+    }
+  }
+
+  void on_query(int64 message_id, Slice query) {
+    state_->stats_.query_count++;
+    auto r_result = [&]() -> Result<BufferSlice> {
+      TRY_RESULT(unwrapped_query, unwrap_query(query));
+      if (unwrapped_query.size() < 4) {
+        return Status::Error(400, "INPUT_METHOD_INVALID");
+      }
+      TlParser parser(unwrapped_query.as_slice());
+      auto function_id = parser.fetch_int();
+      auto it = state_->handlers_.find(function_id);
+      if (it == state_->handlers_.end()) {
+        state_->stats_.unscripted_query_count++;
+        return Status::Error(400, PSLICE() << "INPUT_METHOD_INVALID_" << static_cast<uint32>(function_id));
+      }
+      return it->second(unwrapped_query.as_slice());
+    }();
+
+    BufferSlice result;
+    if (r_result.is_ok()) {
+      result = r_result.move_as_ok();
+    } else {
+      auto error = r_result.move_as_error();
+      result = serialize_object(mtproto_api::rpc_error(error.code() == 0 ? 400 : error.code(), error.message().str()));
+    }
+
+    BufferSlice answer(sizeof(int32) + sizeof(int64) + result.size());
+    TlStorerUnsafe storer(answer.as_mutable_slice().ubegin());
+    storer.store_int(RPC_RESULT_ID);
+    storer.store_long(message_id);
+    storer.store_slice(result.as_slice());
+    add_answer(std::move(answer), true);
+  }
+
+  uint64 next_message_id() {
+    // messages sent by the server in response to client messages must have message identifiers equal to 1 modulo 4
+    auto message_id = max(static_cast<uint64>(Clocks::system() * 4294967296.0), last_message_id_ + 1);
+    message_id = ((message_id + 3) & ~static_cast<uint64>(3)) | 1;
+    last_message_id_ = message_id;
+    return message_id;
+  }
+
+  int32 next_seq_no(bool is_content_related) {
+    int32 result = seq_no_ * 2;
+    if (is_content_related) {
+      seq_no_++;
+      result++;
+    }
+    return result;
+  }
+
+  void add_answer(BufferSlice body, bool is_content_related) {
+    BufferSlice message(sizeof(int64) + 2 * sizeof(int32) + body.size());
+    TlStorerUnsafe storer(message.as_mutable_slice().ubegin());
+    storer.store_long(static_cast<int64>(next_message_id()));
+    storer.store_int(next_seq_no(is_content_related));
+    storer.store_int(narrow_cast<int32>(body.size()));
+    storer.store_slice(body.as_slice());
+    answers_.push_back(std::move(message));
+  }
+
+  void send_answers() {
+    if (answers_.empty()) {
+      return;
+    }
+
+    BufferSlice data;
+    if (answers_.size() == 1) {
+      data = std::move(answers_[0]);
+    } else {
+      size_t container_size = 2 * sizeof(int32);
+      for (auto &answer : answers_) {
+        container_size += answer.size();
+      }
+      BufferSlice container(container_size);
+      TlStorerUnsafe storer(container.as_mutable_slice().ubegin());
+      storer.store_int(mtproto_api::msg_container::ID);
+      storer.store_int(narrow_cast<int32>(answers_.size()));
+      for (auto &answer : answers_) {
+        storer.store_slice(answer.as_slice());
+      }
+      data = BufferSlice(sizeof(int64) + 2 * sizeof(int32) + container.size());
+      TlStorerUnsafe data_storer(data.as_mutable_slice().ubegin());
+      data_storer.store_long(static_cast<int64>(next_message_id()));
+      data_storer.store_int(next_seq_no(false));
+      data_storer.store_int(narrow_cast<int32>(container.size()));
+      data_storer.store_slice(container.as_slice());
+    }
+    answers_.clear();
+
+    mtproto::PacketInfo packet_info;
+    packet_info.version = 2;
+    packet_info.is_server = true;
+    packet_info.salt = state_->server_salt_;
+    packet_info.session_id = session_id_;
+    auto packet = mtproto::Transport::write(create_storer(data.as_slice()), state_->auth_key_, &packet_info, 4, 0);
+    transport_.write_prepare_inplace(&packet, false);
+    fd_.output_buffer().append(packet.as_buffer_slice());
+  }
+};
+
+MockMtprotoServer::MockMtprotoServer(int port, mtproto::AuthKey auth_key, int64 server_salt)
+    : port_(port), state_(std::make_shared<State>()) {
+  state_->auth_key_ = std::move(auth_key);
+  state_->server_salt_ = server_salt;
+}
+
+void MockMtprotoServer::set_handler(int32 function_id, Handler handler) {
+  state_->handlers_[function_id] = std::move(handler);
+}
+
+void MockMtprotoServer::set_result(int32 function_id, BufferSlice result) {
+  set_handler(function_id, [result = result.as_slice().str()](Slice query) -> Result<BufferSlice> {
+    return BufferSlice(result);
+  });
+}
+
+void MockMtprotoServer::set_error(int32 function_id, int32 error_code, string error_message) {
+  set_handler(function_id,
+              [error_code, error_message = std::move(error_message)](Slice query) -> Result<BufferSlice> {
+                return Status::Error(error_code, error_message);
+              });
+}
+
+void MockMtprotoServer::get_stats(Promise<Stats> promise) {
+  promise.set_value(Stats(state_->stats_));
+}
+
+void MockMtprotoServer::start_up() {
+  listener_ = create_actor<TcpListener>("MockMtprotoListener", port_, actor_shared(this), "127.0.0.1");
+}
+
+void MockMtprotoServer::accept(SocketFd fd) {
+  create_actor<Connection>("MockMtprotoConnection", std::move(fd), state_, actor_shared(this)).release();
+}
+
+void MockMtprotoServer::hangup() {
+  stop();
+}
+
+}  // namespace td
@@ -0,0 +1,77 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/mtproto/AuthKey.h"
+
+#include "td/net/TcpListener.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/SocketFd.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include <functional>
+#include <memory>
+
+namespace td {
+
+// In-process MTProto server, which answers scripted queries received over the intermediate TCP transport.
+// There is no key exchange: clients must use the auth key and the server salt, with which the server was created.
+// All connections are handled on the scheduler of the server.
+class MockMtprotoServer final : public TcpListener::Callback {
+ public:
+  // receives a query without invokeWithLayer, initConnection, invokeAfterMsgs and invokeWithoutUpdates wrappers
+  // and returns the serialized result or an error with RPC error code and message
+  using Handler = std::function<Result<BufferSlice>(Slice query)>;
+
+  struct Stats {
+    uint64 connection_count = 0;
+    uint64 packet_count = 0;
+    uint64 query_count = 0;
+    uint64 unscripted_query_count = 0;
+    uint64 received_bytes = 0;
+    uint64 sent_bytes = 0;
+  };
+
+  MockMtprotoServer(int port, mtproto::AuthKey auth_key, int64 server_salt);
+
+  void set_handler(int32 function_id, Handler handler);
+
+  void set_result(int32 function_id, BufferSlice result);
+
+  void set_error(int32 function_id, int32 error_code, string error_message);
+
+  void get_stats(Promise<Stats> promise);
+
+ private:
+  class Connection;
+
+  struct State {
+    mtproto::AuthKey auth_key_;
+    int64 server_salt_ = 0;
+    FlatHashMap<int32, Handler> handlers_;
+    Stats stats_;
+  };
+
+  int port_;
+  std::shared_ptr<State> state_;
+  ActorOwn<TcpListener> listener_;
+
+  void start_up() final;
+
+  void accept(SocketFd fd) final;
+
+  void hangup() final;
+};
+
+}  // namespace td
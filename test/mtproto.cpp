@@ -4,22 +4,28 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "mock_server.h"
+
 #include "td/telegram/ConfigManager.h"
 #include "td/telegram/net/PublicRsaKeySharedMain.h"
 #include "td/telegram/net/Session.h"
 #include "td/telegram/NotificationManager.h"
 #include "td/telegram/telegram_api.h"
+#include "td/telegram/Version.h"
 
 #include "td/mtproto/AuthData.h"
+#include "td/mtproto/AuthKey.h"
 #include "td/mtproto/DhCallback.h"
 #include "td/mtproto/DhHandshake.h"
 #include "td/mtproto/Handshake.h"
 #include "td/mtproto/HandshakeActor.h"
+#include "td/mtproto/MessageId.h"
 #include "td/mtproto/Ping.h"
 #include "td/mtproto/PingConnection.h"
 #include "td/mtproto/ProxySecret.h"
 #include "td/mtproto/RawConnection.h"
 #include "td/mtproto/RSA.h"
+#include "td/mtproto/SessionConnection.h"
 #include "td/mtproto/TlsInit.h"
 #include "td/mtproto/TransportType.h"
 
@@ -31,6 +37,7 @@
 #include "td/actor/ConcurrentScheduler.h"
 
 #include "td/utils/base64.h"
+#include "td/utils/buffer.h"
 #include "td/utils/BufferedFd.h"
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
@@ -43,8 +50,11 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Storer.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 
 #include <memory>
 
@@ -740,3 +750,260 @@ TEST(Mtproto, RSA) {
   rsa.encrypt(pem.substr(0, 256), to);
   ASSERT_EQ("U2nJEtB2AgpHrm3HB0yhpTQgb0wbesi9Pv/W1v/vULU=", td::base64_encode(td::sha256(to)));
 }
+
+class MockServerTestActor final
+    : public td::Actor
+    , private td::mtproto::SessionConnection::Callback {
+ public:
+  static constexpr int QUERY_COUNT = 100;
+
+  MockServerTestActor(int port, td::mtproto::AuthKey auth_key, td::int64 server_salt, td::Status *result)
+      : port_(port), auth_key_(std::move(auth_key)), server_salt_(server_salt), result_(result) {
+  }
+
+ private:
+  int port_;
+  td::mtproto::AuthKey auth_key_;
+  td::int64 server_salt_;
+  td::Status *result_;
+  td::ActorOwn<td::MockMtprotoServer> server_;
+  td::mtproto::AuthData auth_data_;
+  td::unique_ptr<td::mtproto::SessionConnection> connection_;
+  td::mtproto::MessageId unscripted_message_id_;
+  int result_count_ = 0;
+  bool was_error_ = false;
+  double finish_at_ = 0.0;
+
+  static td::string get_header() {
+    auto store = [](auto &storer) {
+      // invokeWithLayer
+      storer.store_int(static_cast<td::int32>(0xda9b0d0d));
+      storer.store_int(td::MTPROTO_LAYER);
+      // initConnection with empty parameters
+      storer.store_int(static_cast<td::int32>(0xc1cd5ea9));
+      storer.store_int(2);
+      storer.store_int(1);
+      for (auto str : {"device", "system", "1.0", "en", "", ""}) {
+        storer.store_string(td::Slice(str));
+      }
+      storer.store_int(td::telegram_api::jsonObject::ID);
+      storer.store_int(static_cast<td::int32>(0x1cb5c415));
+      storer.store_int(0);
+    };
+    td::TlStorerCalcLength calc_length;
+    store(calc_length);
+    td::string header(calc_length.get_length(), '\0');
+    td::TlStorerUnsafe storer(td::MutableSlice(header).ubegin());
+    store(storer);
+    return header;
+  }
+
+  template <class T>
+  static td::BufferSlice serialize_function(const T &function) {
+    auto storer = td::create_default_storer(function);
+    td::BufferSlice result(storer.size());
+    storer.store(result.as_mutable_slice().ubegin());
+    return result;
+  }
+
+  void start_up() final {
+    server_ = td::create_actor<td::MockMtprotoServer>("MockMtprotoServer", port_, auth_key_, server_salt_);
+
+    td::BufferSlice state(6 * sizeof(td::int32));
+    td::TlStorerUnsafe storer(state.as_mutable_slice().ubegin());
+    storer.store_int(td::telegram_api::updates_state::ID);
+    for (td::int32 value : {100, 0, 1700000000, 1, 0}) {
+      storer.store_int(value);
+    }
+    td::send_closure(server_, &td::MockMtprotoServer::set_result, td::telegram_api::updates_getState::ID,
+                     std::move(state));
+
+    // the listener is created by the server during start up and must start listening before connection
+    td::send_closure(server_, &td::MockMtprotoServer::get_stats,
+                     td::PromiseCreator::lambda([actor_id = actor_id(this)](td::MockMtprotoServer::Stats stats) {
+                       td::send_closure_later(actor_id, &MockServerTestActor::connect);
+                     }));
+    finish_at_ = td::Time::now() + 10;
+    set_timeout_at(finish_at_);
+  }
+
+  void connect() {
+    td::IPAddress ip_address;
+    ip_address.init_ipv4_port("127.0.0.1", port_).ensure();
+    auto r_socket = td::SocketFd::open(ip_address);
+    if (r_socket.is_error()) {
+      return finish(td::Status::Error(PSLICE() << "Failed to open socket: " << r_socket.error()));
+    }
+    auto raw_connection = td::mtproto::RawConnection::create(
+        ip_address, td::BufferedFd<td::SocketFd>(r_socket.move_as_ok()),
+        td::mtproto::TransportType{td::mtproto::TransportType::Tcp, 0, td::mtproto::ProxySecret()}, nullptr);
+
+    auth_data_.set_main_auth_key(auth_key_);
+    auth_data_.set_use_pfs(false);
+    auth_data_.set_server_salt(server_salt_, td::Time::now());
+    auth_data_.set_future_salts({td::mtproto::ServerSalt{server_salt_, 1e20, 1e30}}, td::Time::now());
+    auth_data_.set_session_id(static_cast<td::uint64>(td::Random::secure_int64()) | 1);
+    auth_data_.set_header(get_header());
+    connection_ = td::make_unique<td::mtproto::SessionConnection>(td::mtproto::SessionConnection::Mode::Tcp,
+                                                                  std::move(raw_connection), &auth_data_);
+    td::Scheduler::subscribe(connection_->get_poll_info().extract_pollable_fd(this));
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+      connection_->send_query(serialize_function(td::telegram_api::updates_getState()), false).ensure();
+    }
+    unscripted_message_id_ =
+        connection_->send_query(serialize_function(td::telegram_api::help_getNearestDc()), false).move_as_ok();
+    loop();
+  }
+
+  void loop() final {
+    if (connection_ == nullptr || result_ == nullptr) {
+      return;
+    }
+    auto wakeup_at = connection_->flush(this);
+    if (result_ == nullptr) {
+      return;
+    }
+    if (wakeup_at != 0 && wakeup_at < finish_at_) {
+      set_timeout_at(wakeup_at);
+    } else {
+      set_timeout_at(finish_at_);
+    }
+  }
+
+  void timeout_expired() final {
+    if (td::Time::now() >= finish_at_) {
+      return finish(td::Status::Error("Timeout expired"));
+    }
+    loop();
+  }
+
+  void tear_down() final {
+    if (connection_ != nullptr) {
+      auto raw_connection = connection_->move_as_raw_connection();
+      if (raw_connection != nullptr) {
+        td::Scheduler::unsubscribe_before_close(raw_connection->get_poll_info().get_pollable_fd_ref());
+        raw_connection->close();
+      }
+    }
+    td::Scheduler::instance()->finish();
+  }
+
+  void check_finished() {
+    if (result_count_ != QUERY_COUNT || !was_error_) {
+      return;
+    }
+    td::send_closure(server_, &td::MockMtprotoServer::get_stats,
+                     td::PromiseCreator::lambda([actor_id = actor_id(this)](td::MockMtprotoServer::Stats stats) {
+                       td::send_closure(actor_id, &MockServerTestActor::on_stats, stats);
+                     }));
+  }
+
+  void on_stats(td::MockMtprotoServer::Stats stats) {
+    if (stats.connection_count != 1 || stats.query_count != QUERY_COUNT + 1 || stats.unscripted_query_count != 1) {
+      return finish(td::Status::Error(PSLICE() << "Receive wrong statistics: " << stats.connection_count << ' '
+                                               << stats.query_count << ' ' << stats.unscripted_query_count));
+    }
+    finish(td::Status::OK());
+  }
+
+  void finish(td::Status status) {
+    if (result_ == nullptr) {
+      return;
+    }
+    *result_ = std::move(status);
+    result_ = nullptr;
+    stop();
+  }
+
+  void on_connected() final {
+  }
+
+  void on_closed(td::Status status) final {
+    finish(std::move(status));
+  }
+
+  void on_server_salt_updated() final {
+  }
+
+  void on_server_time_difference_updated(bool force) final {
+  }
+
+  void on_new_session_created(td::uint64 unique_id, td::mtproto::MessageId first_message_id) final {
+  }
+
+  void on_session_failed(td::Status status) final {
+    finish(std::move(status));
+  }
+
+  void on_container_sent(td::mtproto::MessageId container_message_id,
+                         td::vector<td::mtproto::MessageId> message_ids) final {
+  }
+
+  void on_queries_sent(size_t query_count, size_t query_size, double fill_ratio) final {
+  }
+
+  td::Status on_pong() final {
+    return td::Status::OK();
+  }
+
+  td::Status on_update(td::BufferSlice packet) final {
+    return td::Status::OK();
+  }
+
+  void on_message_ack(td::mtproto::MessageId message_id) final {
+  }
+
+  td::Status on_message_result_ok(td::mtproto::MessageId message_id, td::BufferSlice packet,
+                                  size_t original_size) final {
+    td::TlBufferParser parser(&packet);
+    auto state = td::telegram_api::updates_getState::fetch_result(parser);
+    parser.fetch_end();
+    if (parser.get_error() != nullptr || state->pts_ != 100) {
+      finish(td::Status::Error("Receive wrong result"));
+      return td::Status::OK();
+    }
+    result_count_++;
+    check_finished();
+    return td::Status::OK();
+  }
+
+  void on_message_result_error(td::mtproto::MessageId message_id, int code, td::string message) final {
+    if (message_id != unscripted_message_id_ || code != 400) {
+      return finish(td::Status::Error(code, message));
+    }
+    was_error_ = true;
+    check_finished();
+  }
+
+  void on_message_failed(td::mtproto::MessageId message_id, td::Status status) final {
+    finish(std::move(status));
+  }
+
+  void on_message_info(td::mtproto::MessageId message_id, td::int32 state, td::mtproto::MessageId answer_message_id,
+                       td::int32 answer_size, td::int32 source) final {
+  }
+
+  td::Status on_destroy_auth_key() final {
+    return td::Status::OK();
+  }
+};
+
+TEST(Mtproto, mock_server) {
+  td::string key(256, '\0');
+  td::Random::secure_bytes(key);
+  auto key_id = td::mtproto::DhHandshake::calc_key_id(key);
+  td::mtproto::AuthKey auth_key(key_id, std::move(key));
+
+  td::Status result;
+  td::ConcurrentScheduler sched(0, 0);
+  sched.create_actor_unsafe<MockServerTestActor>(0, "MockServerTestActor", td::Random::fast(40000, 49999),
+                                                 std::move(auth_key), td::Random::secure_int64(), &result)
+      .release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+  ASSERT_TRUE(result.is_ok());
+}
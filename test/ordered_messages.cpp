@@ -0,0 +1,122 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MessageId.h"
+#include "td/telegram/OrderedMessage.h"
+#include "td/telegram/ServerMessageId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+static td::MessageId get_message_id(td::int32 server_message_id) {
+  return td::MessageId(td::ServerMessageId(server_message_id));
+}
+
+static td::vector<td::MessageId> get_message_ids(const std::set<td::int32> &server_message_ids) {
+  td::vector<td::MessageId> result;
+  for (auto server_message_id : server_message_ids) {
+    result.push_back(get_message_id(server_message_id));
+  }
+  return result;
+}
+
+static void check_ordered_messages(const td::OrderedMessages &ordered_messages, const std::set<td::int32> &ids) {
+  ASSERT_EQ(ids.empty(), ordered_messages.empty());
+  ASSERT_TRUE(get_message_ids(ids) == ordered_messages.find_older_messages(td::MessageId::max()));
+  ASSERT_TRUE(get_message_ids(ids) == ordered_messages.find_newer_messages(td::MessageId()));
+
+  for (int i = 0; i < 100; i++) {
+    auto server_message_id = td::Random::fast(1, 100000);
+    std::set<td::int32> older_ids(ids.begin(), ids.upper_bound(server_message_id));
+    std::set<td::int32> newer_ids(ids.upper_bound(server_message_id), ids.end());
+    ASSERT_TRUE(get_message_ids(older_ids) ==
+                ordered_messages.find_older_messages(get_message_id(server_message_id)));
+    ASSERT_TRUE(get_message_ids(newer_ids) ==
+                ordered_messages.find_newer_messages(get_message_id(server_message_id)));
+
+    auto it = ordered_messages.get_const_iterator(get_message_id(server_message_id));
+    if (older_ids.empty()) {
+      ASSERT_TRUE(*it == nullptr);
+    } else {
+      ASSERT_TRUE(*it != nullptr);
+      ASSERT_EQ(get_message_id(*older_ids.rbegin()), (*it)->get_message_id());
+    }
+  }
+}
+
+TEST(OrderedMessages, stress_test) {
+  td::OrderedMessages ordered_messages;
+  std::set<td::int32> ids;
+  for (int i = 0; i < 10000; i++) {
+    auto server_message_id = td::Random::fast(1, 100000);
+    if (ids.insert(server_message_id).second) {
+      ordered_messages.insert(get_message_id(server_message_id), false, td::MessageId(), "stress_test");
+    }
+  }
+  check_ordered_messages(ordered_messages, ids);
+
+  for (auto server_message_id : ids) {
+    if (server_message_id != *ids.rbegin()) {
+      ordered_messages.attach_message_to_next(get_message_id(server_message_id), "stress_test");
+    }
+  }
+
+  // all messages are attached to each other, so they can be traversed with the iterator
+  size_t message_count = 0;
+  for (auto it = ordered_messages.get_const_iterator(td::MessageId::max()); *it != nullptr; --it) {
+    message_count++;
+  }
+  ASSERT_EQ(ids.size(), message_count);
+
+  message_count = 0;
+  for (auto it = ordered_messages.get_const_iterator(get_message_id(*ids.begin())); *it != nullptr; ++it) {
+    message_count++;
+  }
+  ASSERT_EQ(ids.size(), message_count);
+
+  for (int i = 0; i < 10000; i++) {
+    auto server_message_id = td::Random::fast(1, 100000);
+    if (ids.erase(server_message_id) != 0) {
+      ordered_messages.erase(get_message_id(server_message_id), true);
+    }
+  }
+  check_ordered_messages(ordered_messages, ids);
+
+  while (!ids.empty()) {
+    auto server_message_id = *ids.begin();
+    ids.erase(ids.begin());
+    ordered_messages.erase(get_message_id(server_message_id), false);
+  }
+  check_ordered_messages(ordered_messages, ids);
+}
+
+TEST(OrderedMessages, get_history) {
+  td::OrderedMessages ordered_messages;
+  td::MessageId last_message_id;
+  for (td::int32 i = 1; i <= 1000; i++) {
+    last_message_id = get_message_id(i);
+    ordered_messages.insert(last_message_id, true, get_message_id(i - 1), "get_history");
+  }
+
+  auto from_message_id = td::MessageId::max();
+  td::int32 offset = 0;
+  td::int32 limit = 100;
+  auto message_ids = ordered_messages.get_history(last_message_id, from_message_id, offset, limit, false);
+  ASSERT_EQ(100u, message_ids.size());
+  ASSERT_EQ(last_message_id, message_ids[0]);
+  ASSERT_EQ(get_message_id(901), message_ids.back());
+
+  from_message_id = get_message_id(500);
+  offset = -10;
+  limit = 20;
+  message_ids = ordered_messages.get_history(last_message_id, from_message_id, offset, limit, false);
+  ASSERT_EQ(20u, message_ids.size());
+  ASSERT_EQ(get_message_id(509), message_ids[0]);
+  ASSERT_EQ(get_message_id(490), message_ids.back());
+}
@@ -71,6 +71,19 @@ TEST(StringCleaning, clean_input_string) {
       "\xe2\x80\x8f",
       true);
   check_clean_input_string("\xcc\xb3\xcc\xbf\xcc\x8a", "", true);
+
+  td::string long_str;
+  td::string long_str_expected;
+  for (int i = 0; i < 4; i++) {
+    long_str += "abcdefghijklmnop\x01\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\r\n";
+    long_str_expected += "abcdefghijklmnop \xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\xd1\x8f\n";
+  }
+  check_clean_input_string(long_str, long_str_expected, true);
+  long_str = td::string(34990, 'a');
+  for (int i = 0; i < 10; i++) {
+    long_str += "\xd1\x8f";
+  }
+  check_clean_input_string(long_str, td::string(34990, 'a') + "\xd1\x8f\xd1\x8f\xd1\x8f", true);
 }
 
 static void check_strip_empty_characters(td::string str, std::size_t max_length, const td::string &expected,
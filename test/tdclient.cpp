@@ -8,9 +8,19 @@
 
 #include "td/telegram/Client.h"
 #include "td/telegram/ClientActor.h"
+#include "td/telegram/files/FileContentCache.h"
+#include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FileType.h"
+#include "td/telegram/files/LoadWindow.h"
 #include "td/telegram/files/PartsManager.h"
+#include "td/telegram/files/SharedFileStore.h"
+#include "td/telegram/net/DcId.h"
 #include "td/telegram/td_api.h"
 
+#include "td/tl/tl_object_parse.h"
+#include "td/tl/tl_object_store.h"
+#include "td/tl/TlLazyVector.h"
+
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
 #include "td/actor/PromiseFuture.h"
@@ -32,6 +42,8 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/tests.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
 
 #include <atomic>
 #include <cstdio>
@@ -1179,6 +1191,325 @@ TEST(Client, ManagerCloseOneThread) {
   ASSERT_TRUE(sent_requests.empty());
 }
 
+TEST(Client, ManagerReceiveMany) {
+  td::ClientManager client_manager;
+  auto client_id = client_manager.create_client_id();
+  const size_t request_count = 100;
+  for (size_t i = 1; i <= request_count; i++) {
+    client_manager.send(client_id, i, td::make_tl_object<td::td_api::testSquareInt>(static_cast<td::int32>(i)));
+  }
+  ASSERT_TRUE(client_manager.receive_many(0, 0.0).empty());
+
+  std::set<td::uint64> request_ids;
+  while (request_ids.size() != request_count) {
+    auto responses = client_manager.receive_many(7, 10.0);
+    ASSERT_TRUE(responses.size() <= 7u);
+    for (auto &response : responses) {
+      ASSERT_TRUE(response.object != nullptr);
+      if (response.request_id == 0) {
+        continue;
+      }
+      ASSERT_EQ(client_id, response.client_id);
+      ASSERT_EQ(td::td_api::testInt::ID, response.object->get_id());
+      auto value = static_cast<td::uint64>(static_cast<td::td_api::testInt &>(*response.object).value_);
+      ASSERT_EQ(response.request_id * response.request_id, value);
+      ASSERT_TRUE(request_ids.insert(response.request_id).second);
+    }
+  }
+
+  client_manager.send(client_id, request_count + 1, td::make_tl_object<td::td_api::close>());
+  bool is_closed = false;
+  while (!is_closed) {
+    for (auto &response : client_manager.receive_many(100, 10.0)) {
+      if (response.request_id == 0 && response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+          static_cast<td::td_api::updateAuthorizationState &>(*response.object).authorization_state_->get_id() ==
+              td::td_api::authorizationStateClosed::ID) {
+        is_closed = true;
+      }
+    }
+  }
+}
+
+TEST(Client, UpdateFilter) {
+  td::ClientManager client_manager;
+  auto client_id = client_manager.create_client_id();
+  client_manager.send(client_id, 1,
+                      td::make_tl_object<td::td_api::setUpdateFilter>(td::vector<td::int32>{
+                          td::td_api::updateOption::ID, td::td_api::updateConnectionState::ID}));
+  client_manager.send(client_id, 2,
+                      td::make_tl_object<td::td_api::setUpdateFilter>(
+                          td::vector<td::int32>{td::td_api::updateAuthorizationState::ID}));
+  client_manager.send(client_id, 3, td::make_tl_object<td::td_api::close>());
+
+  bool is_filter_set = false;
+  bool is_closed = false;
+  while (!is_closed) {
+    auto response = client_manager.receive(10.0);
+    ASSERT_TRUE(response.object != nullptr);
+    auto object_id = response.object->get_id();
+    if (response.request_id == 1) {
+      ASSERT_EQ(td::td_api::ok::ID, object_id);
+      is_filter_set = true;
+    } else if (response.request_id == 2) {
+      ASSERT_EQ(td::td_api::error::ID, object_id);
+    } else if (response.request_id == 0) {
+      if (is_filter_set) {
+        ASSERT_TRUE(object_id != td::td_api::updateOption::ID && object_id != td::td_api::updateConnectionState::ID);
+      }
+      if (object_id == td::td_api::updateAuthorizationState::ID &&
+          static_cast<td::td_api::updateAuthorizationState &>(*response.object).authorization_state_->get_id() ==
+              td::td_api::authorizationStateClosed::ID) {
+        is_closed = true;
+      }
+    }
+  }
+  ASSERT_TRUE(is_filter_set);
+}
+
+TEST(Client, RequestTimeout) {
+  td::ClientManager client_manager;
+  auto client_id = client_manager.create_client_id();
+  client_manager.send(client_id, 1, td::make_tl_object<td::td_api::testSquareInt>(3), 1e-9);
+  client_manager.send(client_id, 2, td::make_tl_object<td::td_api::testSquareInt>(4), 100.0);
+  client_manager.send(client_id, 3, td::make_tl_object<td::td_api::close>());
+
+  int response_count = 0;
+  bool is_closed = false;
+  while (!is_closed) {
+    auto response = client_manager.receive(10.0);
+    ASSERT_TRUE(response.object != nullptr);
+    if (response.request_id == 1) {
+      ASSERT_EQ(td::td_api::error::ID, response.object->get_id());
+      ASSERT_EQ(408, static_cast<const td::td_api::error &>(*response.object).code_);
+      response_count++;
+    } else if (response.request_id == 2) {
+      ASSERT_EQ(td::td_api::testInt::ID, response.object->get_id());
+      ASSERT_EQ(16, static_cast<const td::td_api::testInt &>(*response.object).value_);
+      response_count++;
+    } else if (response.request_id == 0 && response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+               static_cast<td::td_api::updateAuthorizationState &>(*response.object).authorization_state_->get_id() ==
+                   td::td_api::authorizationStateClosed::ID) {
+      is_closed = true;
+    }
+  }
+  ASSERT_EQ(2, response_count);
+}
+
+TEST(Client, HibernateUnauthorized) {
+  td::ClientManager client_manager;
+  auto client_id = client_manager.create_client_id();
+  client_manager.send(client_id, 1, td::make_tl_object<td::td_api::hibernate>());
+  client_manager.send(client_id, 2, td::make_tl_object<td::td_api::testSquareInt>(5));
+  client_manager.send(client_id, 3, td::make_tl_object<td::td_api::close>());
+
+  int response_count = 0;
+  bool is_closed = false;
+  while (!is_closed) {
+    auto response = client_manager.receive(10.0);
+    ASSERT_TRUE(response.object != nullptr);
+    if (response.request_id == 1) {
+      ASSERT_EQ(td::td_api::error::ID, response.object->get_id());
+      ASSERT_EQ(400, static_cast<const td::td_api::error &>(*response.object).code_);
+      response_count++;
+    } else if (response.request_id == 2) {
+      ASSERT_EQ(td::td_api::testInt::ID, response.object->get_id());
+      ASSERT_EQ(25, static_cast<const td::td_api::testInt &>(*response.object).value_);
+      response_count++;
+    } else if (response.request_id == 0 && response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+               static_cast<td::td_api::updateAuthorizationState &>(*response.object).authorization_state_->get_id() ==
+                   td::td_api::authorizationStateClosed::ID) {
+      is_closed = true;
+    }
+  }
+  ASSERT_EQ(2, response_count);
+}
+
+TEST(Client, ExecuteCached) {
+  td::ClientManager client_manager;
+  auto client_id = client_manager.create_client_id();
+  ASSERT_TRUE(client_manager.execute_cached(client_id, td::make_tl_object<td::td_api::getOption>("version")) ==
+              nullptr);
+  ASSERT_TRUE(client_manager.execute_cached(client_id + 1, td::make_tl_object<td::td_api::getOption>("version")) ==
+              nullptr);
+  client_manager.send(client_id, 1, td::make_tl_object<td::td_api::close>());
+  while (true) {
+    auto response = client_manager.receive(10.0);
+    ASSERT_TRUE(response.object != nullptr);
+    if (response.request_id == 0 && response.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+        static_cast<td::td_api::updateAuthorizationState &>(*response.object).authorization_state_->get_id() ==
+            td::td_api::authorizationStateClosed::ID) {
+      break;
+    }
+  }
+  ASSERT_TRUE(client_manager.execute_cached(client_id, td::make_tl_object<td::td_api::getOption>("version")) ==
+              nullptr);
+}
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+TEST(Client, ManagerClientGroups) {
+  td::ClientManager client_manager;
+  const int group_count = 3;
+  const int clients_per_group = 4;
+  const td::uint64 request_count = 50;
+  td::vector<td::ClientManager::ClientId> client_ids;
+  std::map<td::ClientManager::ClientId, td::int32> client_groups;
+  for (int i = 0; i < group_count * clients_per_group; i++) {
+    auto client_id = client_manager.create_client_id();
+    ASSERT_TRUE(client_manager.set_client_group(client_id, i % group_count + 1));
+    client_ids.push_back(client_id);
+    client_groups[client_id] = i % group_count + 1;
+  }
+  ASSERT_TRUE(!client_manager.set_client_group(0, 1));
+
+  td::vector<td::thread> threads;
+  std::atomic<int> error_count{0};
+  for (int group_id = 1; group_id <= group_count; group_id++) {
+    threads.emplace_back([&, group_id] {
+      std::set<std::pair<td::int32, td::uint64>> responses;
+      while (responses.size() != static_cast<size_t>(clients_per_group) * request_count) {
+        auto response = client_manager.receive(group_id, 10.0);
+        if (response.object == nullptr) {
+          error_count++;
+          return;
+        }
+        if (response.request_id == 0) {
+          continue;
+        }
+        if (client_groups.at(response.client_id) != group_id ||
+            response.object->get_id() != td::td_api::testInt::ID ||
+            !responses.emplace(response.client_id, response.request_id).second) {
+          error_count++;
+        }
+      }
+    });
+  }
+  for (td::uint64 request_id = 1; request_id <= request_count; request_id++) {
+    for (auto client_id : client_ids) {
+      client_manager.send(client_id, request_id, td::make_tl_object<td::td_api::testSquareInt>(3));
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(0, error_count.load());
+  ASSERT_TRUE(!client_manager.set_client_group(client_ids[0], 2));
+  ASSERT_TRUE(client_manager.receive(0, 0.0).object == nullptr);
+}
+#endif
+
+template <class F>
+static td::string tl_serialize(const F &store) {
+  td::TlStorerCalcLength storer_calc_length;
+  store(storer_calc_length);
+  td::string result(storer_calc_length.get_length(), '\0');
+  td::TlStorerUnsafe storer_unsafe(td::MutableSlice(result).ubegin());
+  store(storer_unsafe);
+  CHECK(storer_unsafe.get_buf() == td::MutableSlice(result).uend());
+  return result;
+}
+
+TEST(Client, TlSerialization) {
+  auto request = tl_serialize([](auto &storer) {
+    storer.store_binary(td::td_api::parseTextEntities::ID);
+    storer.store_string(td::Slice("*bold* _italic_"));
+    storer.store_binary(td::td_api::textParseModeMarkdown::ID);
+    storer.store_binary(static_cast<td::int32>(1));
+  });
+  td::TlParser parser(request);
+  auto function = td::td_api::Function::fetch(parser);
+  parser.fetch_end();
+  ASSERT_TRUE(parser.get_status().is_ok());
+  ASSERT_EQ(td::td_api::parseTextEntities::ID, function->get_id());
+
+  auto result = td::ClientManager::execute(std::move(function));
+  ASSERT_EQ(td::td_api::formattedText::ID, result->get_id());
+  ASSERT_EQ(2u, static_cast<const td::td_api::formattedText &>(*result).entities_.size());
+  auto response = tl_serialize([&result](auto &storer) {
+    storer.store_binary(result->get_id());
+    result->store(storer);
+  });
+
+  td::TlParser response_parser(response);
+  auto formatted_text = td::TlFetchNullable<
+      td::TlFetchBoxed<td::TlFetchObject<td::td_api::formattedText>, td::td_api::formattedText::ID>>::parse(response_parser);
+  response_parser.fetch_end();
+  ASSERT_TRUE(response_parser.get_status().is_ok());
+  ASSERT_EQ(to_string(result), to_string(formatted_text));
+
+  // missing objects are serialized as null
+  request = tl_serialize([](auto &storer) {
+    storer.store_binary(td::td_api::setOption::ID);
+    storer.store_string(td::Slice("online"));
+    storer.store_binary(static_cast<td::int32>(0x56730bcc));
+  });
+  td::TlParser null_parser(request);
+  function = td::td_api::Function::fetch(null_parser);
+  null_parser.fetch_end();
+  ASSERT_TRUE(null_parser.get_status().is_ok());
+  ASSERT_TRUE(static_cast<const td::td_api::setOption &>(*function).value_ == nullptr);
+
+  td::TlStorerCalcLength storer_calc_length;
+  td::TlStoreNullable<td::TlStoreBoxedUnknown<td::TlStoreObject>>::store(
+      td::td_api::object_ptr<td::td_api::OptionValue>(), storer_calc_length);
+  ASSERT_EQ(4u, storer_calc_length.get_length());
+
+  request = tl_serialize([](auto &storer) { storer.store_binary(static_cast<td::int32>(0x12345678)); });
+  td::TlParser wrong_parser(request);
+  td::td_api::Function::fetch(wrong_parser);
+  ASSERT_TRUE(wrong_parser.get_status().is_error());
+}
+
+TEST(Client, TlLazyVector) {
+  td::vector<td::string> strings{"a", td::string(300, 'b'), "", "cd"};
+  auto serialized = tl_serialize([&strings](auto &storer) {
+    td::TlStoreVector<td::TlStoreString>::store(strings, storer);
+    storer.store_binary(static_cast<td::int32>(12345));
+  });
+  td::BufferSlice buffer(serialized);
+  td::TlBufferParser parser(&buffer);
+  auto lazy_vector = td::TlFetchLazyVector<td::TlFetchString<td::string>>::parse(parser);
+  ASSERT_EQ(12345, parser.fetch_int());
+  parser.fetch_end();
+  ASSERT_TRUE(parser.get_status().is_ok());
+
+  ASSERT_EQ(strings.size(), lazy_vector.size());
+  for (size_t i = 0; i < strings.size(); i++) {
+    ASSERT_EQ(strings[i], lazy_vector.get(i));
+  }
+  ASSERT_TRUE(strings == lazy_vector.parse_all());
+  size_t pos = 0;
+  for (const auto &str : lazy_vector) {
+    ASSERT_EQ(strings[pos++], str);
+  }
+  ASSERT_EQ(strings.size(), pos);
+  auto stored = tl_serialize([&lazy_vector](auto &storer) {
+    lazy_vector.store(storer);
+    storer.store_binary(static_cast<td::int32>(12345));
+  });
+  ASSERT_EQ(serialized, stored);
+
+  td::BufferSlice truncated_buffer(td::Slice(serialized).substr(0, 12));
+  td::TlBufferParser truncated_parser(&truncated_buffer);
+  lazy_vector = td::TlFetchLazyVector<td::TlFetchString<td::string>>::parse(truncated_parser);
+  ASSERT_TRUE(truncated_parser.get_status().is_error());
+  ASSERT_TRUE(lazy_vector.empty());
+}
+
+TEST(Client, TlApproximateMemoryUsage) {
+  auto empty_text = td::td_api::make_object<td::td_api::formattedText>();
+  auto empty_size = empty_text->approximate_memory_usage();
+  ASSERT_TRUE(empty_size >= sizeof(td::td_api::formattedText));
+
+  auto text = td::td_api::make_object<td::td_api::formattedText>(
+      td::string(1000, 'a'), td::vector<td::td_api::object_ptr<td::td_api::textEntity>>());
+  ASSERT_TRUE(text->approximate_memory_usage() >= empty_size + 1000);
+
+  auto text_size = text->approximate_memory_usage();
+  text->entities_.push_back(td::td_api::make_object<td::td_api::textEntity>(
+      0, 1000, td::td_api::make_object<td::td_api::textEntityTypeTextUrl>(td::string(500, 'b'))));
+  ASSERT_TRUE(text->approximate_memory_usage() >= text_size + sizeof(td::td_api::textEntity) + 500);
+}
+
 TEST(PartsManager, hands) {
   {
     td::PartsManager pm;
@@ -1190,3 +1521,81 @@ TEST(PartsManager, hands) {
     pm.init(1, 100000, true, 10, {0, 1, 2}, false, true).ensure_error();
   }
 }
+
+TEST(LoadWindow, grows_to_bandwidth_delay_product) {
+  td::LoadWindow window;
+  td::int64 part_size = 1 << 19;
+  window.init(part_size);
+  ASSERT_EQ(1 << 20, window.get_window());
+
+  // 100 MB/s link with 0.1 seconds RTT
+  double now = 1.0;
+  double rtt = 0.1;
+  double bandwidth = 100e6;
+  td::uint64 query_id = 0;
+  for (int round = 0; round < 20; round++) {
+    auto part_count = window.get_window() / part_size;
+    for (td::int64 i = 0; i < part_count; i++) {
+      window.on_part_started(query_id + i, now);
+    }
+    for (td::int64 i = 0; i < part_count; i++) {
+      window.on_part_finished(query_id + i, part_size, now + rtt + static_cast<double>((i + 1) * part_size) / bandwidth);
+    }
+    query_id += part_count;
+    now += rtt + static_cast<double>(part_count * part_size) / bandwidth;
+  }
+  ASSERT_TRUE(window.get_window() >= static_cast<td::int64>(bandwidth * rtt));
+  ASSERT_TRUE(window.get_window() <= static_cast<td::int64>(3 * bandwidth * rtt));
+  ASSERT_TRUE(window.get_average_throughput(now) > bandwidth / 4);
+
+  window.on_part_started(query_id, now);
+  window.on_part_failed(query_id);
+}
+
+TEST(FileContentCache, evicts_least_recently_used) {
+  td::FileContentCache cache;
+  cache.set_max_size(10);
+  td::FullLocalFileLocation a(td::FileType::Thumbnail, "a", 1);
+  td::FullLocalFileLocation b(td::FileType::Thumbnail, "b", 1);
+  td::FullLocalFileLocation c(td::FileType::Thumbnail, "c", 1);
+  cache.add(a, "aaaa");
+  cache.add(b, "bbbb");
+  ASSERT_EQ("aaaa", *cache.get(a));
+  cache.add(c, "cccc");
+  ASSERT_EQ(8, cache.get_size());
+  ASSERT_TRUE(cache.get(b) == nullptr);
+  ASSERT_EQ("aaaa", *cache.get(a));
+  ASSERT_EQ("cccc", *cache.get(c));
+
+  // the file was changed after caching
+  ASSERT_TRUE(cache.get(td::FullLocalFileLocation(td::FileType::Thumbnail, "a", 2)) == nullptr);
+  ASSERT_EQ(1u, cache.get_file_count());
+
+  cache.add(b, "too big content");
+  ASSERT_TRUE(cache.get(b) == nullptr);
+  cache.remove("c");
+  ASSERT_EQ(0, cache.get_size());
+}
+
+TEST(SharedFileStore, returns_existing_files_only) {
+  td::string path = "shared_file_store_test";
+  td::unlink(path).ignore();
+  td::FullRemoteFileLocation remote(td::FileType::Document, 123, 456, td::DcId::internal(2), "");
+  td::FullRemoteFileLocation other_remote(td::FileType::Document, 124, 456, td::DcId::internal(2), "");
+  ASSERT_EQ("", td::SharedFileStore::get_file(remote, 5));
+
+  td::write_file(path, "12345").ensure();
+  td::SharedFileStore::add_file(remote, 5, path);
+  ASSERT_EQ(path, td::SharedFileStore::get_file(remote, 5));
+  ASSERT_EQ("", td::SharedFileStore::get_file(remote, 6));
+  ASSERT_EQ("", td::SharedFileStore::get_file(other_remote, 5));
+
+  td::unlink(path).ensure();
+  ASSERT_EQ("", td::SharedFileStore::get_file(remote, 5));
+
+  td::write_file(path, "12345").ensure();
+  td::SharedFileStore::add_file(remote, 5, path);
+  td::SharedFileStore::remove_file(remote);
+  ASSERT_EQ("", td::SharedFileStore::get_file(remote, 5));
+  td::unlink(path).ignore();
+}
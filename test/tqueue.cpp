@@ -13,6 +13,7 @@
 #include "td/utils/common.h"
 #include "td/utils/int_types.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/path.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -258,3 +259,84 @@ TEST(TQueue, clear) {
   CHECK(tqueue->get_tail(1) == tail_id);
   CHECK(deleted_events.size() == 100000 - keep_count);
 }
+
+TEST(TQueue, disk_storage) {
+  td::string directory = "tqueue_disk_storage";
+  td::rmrf(directory).ignore();
+  td::mkdir(directory).ensure();
+
+  auto tqueue = td::TQueue::create();
+  tqueue->enable_disk_storage(directory, 10000).ensure();
+  td::vector<td::string> datas;
+  for (int i = 0; i < 3000; i++) {
+    datas.push_back(PSTRING() << "event " << i << td::string(td::Random::fast(0, 1000), 'a'));
+    tqueue->push(1, datas.back(), 1000, 0, {}).ensure();
+  }
+
+  size_t pos = 0;
+  auto from_id = tqueue->get_head(1);
+  while (true) {
+    td::TQueue::Event events[50];
+    auto events_span = td::MutableSpan<td::TQueue::Event>(events, 50);
+    tqueue->get(1, from_id, true, 0, events_span).ensure();
+    if (events_span.empty()) {
+      break;
+    }
+    for (auto &event : events_span) {
+      ASSERT_EQ(datas[pos], event.data);
+      pos++;
+    }
+    from_id = events_span.back().id.next().move_as_ok();
+  }
+  ASSERT_EQ(datas.size(), pos);
+
+  tqueue.reset();
+  td::rmrf(directory).ensure();
+}
+
+TEST(TQueue, gc) {
+  auto tqueue = td::TQueue::create();
+
+  const td::int32 queue_count = 10000;
+  const td::int32 max_expires_at = 1000;
+  auto start_time = td::Time::now();
+  size_t total_event_count = 0;
+  for (td::int32 i = 0; i < 500000; i++) {
+    auto queue_id = td::Random::fast(1, queue_count);
+    tqueue->push(queue_id, "data", td::Random::fast(1, max_expires_at), 0, {}).ensure();
+    total_event_count++;
+  }
+
+  auto gc_start_time = td::Time::now();
+  double max_gc_time = 0.0;
+  size_t deleted_event_count = 0;
+  for (td::int32 now = 10; now <= max_expires_at + 10; now += 10) {
+    while (true) {
+      auto run_gc_start_time = td::Time::now();
+      auto result = tqueue->run_gc(now);
+      max_gc_time = td::max(max_gc_time, td::Time::now() - run_gc_start_time);
+      deleted_event_count += static_cast<size_t>(result.first);
+      if (result.second) {
+        break;
+      }
+    }
+
+    for (int i = 0; i < 10; i++) {
+      auto queue_id = td::Random::fast(1, queue_count);
+      td::TQueue::Event events[100];
+      auto events_span = td::MutableSpan<td::TQueue::Event>(events, 100);
+      tqueue->get(queue_id, tqueue->get_head(queue_id), false, 0, events_span).ensure();
+      for (auto &event : events_span) {
+        ASSERT_TRUE(event.expires_at >= now);
+      }
+    }
+  }
+  auto finish_time = td::Time::now();
+  LOG(INFO) << "Added " << total_event_count << " TQueue events in " << gc_start_time - start_time
+            << " seconds and deleted them by garbage collection in " << finish_time - gc_start_time
+            << " seconds with maximum run_gc duration " << max_gc_time << " seconds";
+  ASSERT_EQ(total_event_count, deleted_event_count);
+  for (td::int32 queue_id = 1; queue_id <= queue_count; queue_id++) {
+    ASSERT_EQ(0u, tqueue->get_size(queue_id));
+  }
+}